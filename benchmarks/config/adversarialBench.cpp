@@ -0,0 +1,91 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <string>
+#include <vector>
+
+#include "fourdst/config/config.h"
+#include "bench_schema.h"
+
+/*
+ * Inputs a generated or hostile deck can throw at the parser and the validator: very long
+ * keys, huge arrays, deep nesting and reports of very many missing fields. Each case runs over a
+ * range of sizes and reports its fitted complexity, which should stay O(N) (O(N log N) for the
+ * sorted missing-field report); a deck rejected by the parse limits costs the same at any depth.
+ * adversarialTest.cpp (the "adversarial" meson suite) fails if one of them turns quadratic.
+ */
+namespace {
+    using fourdst::config::Config;
+    namespace validate = fourdst::config::validate;
+
+    void BM_ValidateLongKey(benchmark::State& state) {
+        const auto length = static_cast<std::size_t>(state.range(0));
+        toml::table main;
+        main.insert(std::string(length, 'k'), 1);
+        for (auto _ : state) {
+            std::vector<validate::ValidationIssue> issues;
+            validate::ConfigValidator<DeckSchema>::validate(&main, "main", issues);
+            benchmark::DoNotOptimize(issues.data());
+        }
+        state.SetComplexityN(state.range(0));
+    }
+
+    void BM_LoadHugeArray(benchmark::State& state) {
+        std::string deck = "[main]\nname = \"adversarial\"\nvalues = [";
+        for (std::int64_t i = 0; i < state.range(0); ++i) deck += "1.5, ";
+        deck += "]\n";
+        for (auto _ : state) {
+            Config<ArraySchema> cfg;
+            cfg.load_from(deck);
+            benchmark::DoNotOptimize(cfg.main());
+        }
+        state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(deck.size()));
+        state.SetComplexityN(state.range(0));
+    }
+
+    void BM_RejectDeepNesting(benchmark::State& state) {
+        const auto depth = static_cast<std::size_t>(state.range(0));
+        const std::string deck = "[main]\nname = \"adversarial\"\nvalues = " + std::string(depth, '[') + std::string(depth, ']') + "\n";
+        for (auto _ : state) {
+            Config<ArraySchema> cfg;
+            cfg.set_parse_limits({.max_depth = 64});
+            try {
+                cfg.load_from(deck);
+            } catch (const fourdst::config::exceptions::ConfigParseError&) {
+            }
+        }
+        state.SetComplexityN(state.range(0));
+    }
+
+    void BM_ScanParseLimits(benchmark::State& state) {
+        std::string deck = "[main]\nname = \"adversarial\"\nvalues = [";
+        for (std::int64_t i = 0; i < state.range(0); ++i) deck += "[1.5], ";
+        deck += "]\n";
+        const fourdst::config::ParseLimits limits{.max_array_length = 1 << 30, .max_depth = 64};
+        for (auto _ : state) {
+            fourdst::config::io::check_parse_limits(deck, limits, "<deck>");
+        }
+        state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(deck.size()));
+        state.SetComplexityN(state.range(0));
+    }
+
+    void BM_ReportMissingFields(benchmark::State& state) {
+        std::vector<std::string> missing;
+        missing.reserve(static_cast<std::size_t>(state.range(0)));
+        for (std::int64_t i = 0; i < state.range(0); ++i) missing.push_back(std::format("main.table{}.field{}", i % 1000, i));
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(validate::report_all_missing_fields(missing));
+        }
+        state.SetComplexityN(state.range(0));
+    }
+}
+
+BENCHMARK(BM_ValidateLongKey)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)->Complexity(benchmark::oN);
+BENCHMARK(BM_LoadHugeArray)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)->Complexity(benchmark::oN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RejectDeepNesting)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)->Complexity(benchmark::o1);
+BENCHMARK(BM_ScanParseLimits)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)->Complexity(benchmark::oN)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ReportMissingFields)->RangeMultiplier(8)->Range(1 << 10, 1 << 20)->Complexity(benchmark::oNLogN)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,164 @@
+/*
+ * Compares two Google Benchmark JSON result files and fails on regressions.
+ *
+ *   configBench --benchmark_repetitions=10 --benchmark_out=current.json --benchmark_out_format=json
+ *   benchCompare baseline.json current.json --tolerance 0.05 --filter BM_Load
+ *
+ * For every case present in both files the median real time is compared (the `median`
+ * aggregate when the run had repetitions, otherwise the median of the iteration rows), and so
+ * are the allocations per iteration reported by the memory manager. A case regresses when either
+ * grows by more than the tolerance. Cases found in only one file are listed but never fail the
+ * comparison. Exit status: 0 without regressions, 1 with regressions, 2 on bad input.
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <format>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <print>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "rfl.hpp"
+#include "rfl/json.hpp"
+
+namespace {
+    struct BenchmarkRow {
+        std::string name;
+        std::optional<std::string> run_name;
+        std::optional<std::string> run_type;
+        std::optional<std::string> aggregate_name;
+        std::optional<double> real_time;
+        std::optional<std::string> time_unit;
+        std::optional<double> allocs_per_iter;
+    };
+
+    struct BenchmarkFile {
+        std::vector<BenchmarkRow> benchmarks;
+    };
+
+    struct Case {
+        /// Median real time in nanoseconds.
+        double time_ns = 0.0;
+        std::optional<double> allocs_per_iter;
+    };
+
+    double to_nanoseconds(const double value, const std::string_view unit) {
+        if (unit == "us") return value * 1e3;
+        if (unit == "ms") return value * 1e6;
+        if (unit == "s") return value * 1e9;
+        return value;
+    }
+
+    double median(std::vector<double> values) {
+        std::ranges::sort(values);
+        const std::size_t mid = values.size() / 2;
+        return values.size() % 2 == 1 ? values[mid] : (values[mid - 1] + values[mid]) / 2.0;
+    }
+
+    std::map<std::string, Case> read_cases(const std::string& path, const std::string_view filter) {
+        std::ifstream in(path);
+        if (!in) throw std::runtime_error(std::format("cannot open {}", path));
+        std::stringstream text;
+        text << in.rdbuf();
+        auto parsed = rfl::json::read<BenchmarkFile>(text.str());
+        if (!parsed) throw std::runtime_error(std::format("{} is not a benchmark result file: {}", path, parsed.error().what()));
+
+        std::map<std::string, std::vector<double>> iteration_times;
+        std::map<std::string, Case> cases;
+        for (const BenchmarkRow& row : parsed.value().benchmarks) {
+            const std::string name = row.run_name.value_or(row.name);
+            if (!name.contains(filter) || !row.real_time) continue;
+            const double time_ns = to_nanoseconds(*row.real_time, row.time_unit.value_or("ns"));
+            Case& entry = cases[name];
+            if (row.run_type.value_or("iteration") == "aggregate") {
+                if (row.aggregate_name == "median") entry.time_ns = time_ns;
+                continue;
+            }
+            iteration_times[name].push_back(time_ns);
+            if (row.allocs_per_iter) entry.allocs_per_iter = row.allocs_per_iter;
+        }
+        for (auto& [name, entry] : cases) {
+            if (entry.time_ns == 0.0 && iteration_times.contains(name)) entry.time_ns = median(iteration_times[name]);
+        }
+        return cases;
+    }
+
+    std::string describe_time(const double ns) {
+        if (ns < 1e3) return std::format("{:.1f} ns", ns);
+        if (ns < 1e6) return std::format("{:.2f} us", ns / 1e3);
+        if (ns < 1e9) return std::format("{:.2f} ms", ns / 1e6);
+        return std::format("{:.2f} s", ns / 1e9);
+    }
+
+    int usage() {
+        std::println(stderr, "usage: benchCompare <baseline.json> <current.json> [--tolerance FRACTION] [--filter SUBSTRING]");
+        return 2;
+    }
+}
+
+int main(const int argc, char** argv) {
+    std::vector<std::string> files;
+    double tolerance = 0.05;
+    std::string filter;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if ((arg == "--tolerance" || arg == "--filter") && i + 1 < argc) {
+            if (arg == "--tolerance") {
+                tolerance = std::strtod(argv[++i], nullptr);
+            } else {
+                filter = argv[++i];
+            }
+        } else if (arg.starts_with("--")) {
+            return usage();
+        } else {
+            files.emplace_back(arg);
+        }
+    }
+    if (files.size() != 2 || tolerance < 0.0) return usage();
+
+    std::map<std::string, Case> baseline;
+    std::map<std::string, Case> current;
+    try {
+        baseline = read_cases(files[0], filter);
+        current = read_cases(files[1], filter);
+    } catch (const std::exception& e) {
+        std::println(stderr, "benchCompare: {}", e.what());
+        return 2;
+    }
+
+    std::size_t regressions = 0;
+    std::println("{:<48} {:>12} {:>12} {:>9} {:>12}  {}", "case", "baseline", "current", "time", "allocs", "verdict");
+    for (const auto& [name, before] : baseline) {
+        const auto found = current.find(name);
+        if (found == current.end()) {
+            std::println("{:<48} {:>12} {:>12} {:>9} {:>12}  missing", name, describe_time(before.time_ns), "-", "-", "-");
+            continue;
+        }
+        const Case& after = found->second;
+        const double time_change = before.time_ns > 0.0 ? after.time_ns / before.time_ns - 1.0 : 0.0;
+        std::optional<double> alloc_change;
+        if (before.allocs_per_iter && after.allocs_per_iter) {
+            alloc_change = *before.allocs_per_iter > 0.0 ? *after.allocs_per_iter / *before.allocs_per_iter - 1.0
+                                                         : (*after.allocs_per_iter > 0.0 ? 1.0 : 0.0);
+        }
+        const bool regressed = time_change > tolerance || (alloc_change && *alloc_change > tolerance);
+        if (regressed) ++regressions;
+        std::println("{:<48} {:>12} {:>12} {:>+8.1f}% {:>12}  {}", name, describe_time(before.time_ns), describe_time(after.time_ns),
+                     time_change * 100.0, alloc_change ? std::format("{:+.1f}%", *alloc_change * 100.0) : std::string("-"),
+                     regressed ? "REGRESSION" : "ok");
+    }
+    for (const auto& [name, after] : current) {
+        if (!baseline.contains(name)) {
+            std::println("{:<48} {:>12} {:>12} {:>9} {:>12}  new", name, "-", describe_time(after.time_ns), "-", "-");
+        }
+    }
+
+    std::println("\n{} regression(s) beyond {:.1f}% across {} baseline case(s)", regressions, tolerance * 100.0, baseline.size());
+    return regressions == 0 ? 0 : 1;
+}
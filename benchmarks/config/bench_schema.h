@@ -0,0 +1,60 @@
+#pragma once
+#include <array>
+#include <optional>
+#include <string>
+#include <vector>
+
+/*
+ * Schemas of increasing size used by the benchmarks.
+ *
+ * TreeSchema<D> nests four copies of TreeSchema<D - 1> per level, so the number of leaf
+ * fields grows roughly as 4^D while only D + 1 distinct types are instantiated:
+ *   D = 0 ->     3 fields
+ *   D = 2 ->    58 fields
+ *   D = 4 ->   938 fields
+ *   D = 6 -> 15018 fields
+ */
+struct TinySchema {
+    bool enabled = true;
+    int threads = 4;
+    double tolerance = 1e-8;
+};
+
+template <int D>
+struct TreeSchema {
+    TreeSchema<D - 1> a;
+    TreeSchema<D - 1> b;
+    TreeSchema<D - 1> c;
+    TreeSchema<D - 1> d;
+    double weight = 0.5;
+    int level = D;
+};
+
+template <>
+struct TreeSchema<0> {
+    double value = 1.0;
+    int count = 1;
+    std::string label = "leaf";
+};
+
+struct ArraySchema {
+    std::string name = "table";
+    std::vector<double> values;
+};
+
+struct DeckRow {
+    std::string name;
+    double mass = 1.0;
+    int charge = 0;
+    std::vector<double> abundances;
+};
+
+/*
+ * A deck whose size is set by the generator knobs rather than by its type; see generate.h.
+ */
+struct DeckSchema {
+    std::string description = "deck";
+    std::optional<double> tolerance;
+    std::vector<DeckRow> rows;
+    std::vector<int> checkpoints;
+};
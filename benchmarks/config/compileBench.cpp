@@ -0,0 +1,292 @@
+/*
+ * Measures what the config headers cost to compile, per feature, over generated schemas.
+ *
+ *   compileBench --widths 8,64 --depths 1,3 --repetitions 3 --out compile.json -- c++ -std=c++23 -O2 -Isrc/config/include ...
+ *   benchCompare baseline.json compile.json --tolerance 0.10 --filter BM_Compile/load
+ *
+ * For every width W and depth D a schema is generated with a binary tree of 2^(D+1) - 1
+ * distinct structs, each holding W fields of mixed types (numbers, strings, vectors, optionals),
+ * so the reflected fields grow with both knobs. For each schema one translation unit per
+ * feature is compiled with the command after `--`:
+ *
+ *   header    includes config.h and constructs a `Config<Schema>`
+ *   load      calls `load()`
+ *   save      calls `save()`
+ *   schema    calls `save_schema()`
+ *   cli       calls `register_as_cli()` on a stub application, so CLI11 itself is not counted
+ *   declared  calls `load()` and `save()` after `FOURDST_CONFIG_DECLARE` (see instantiate.h)
+ *
+ * Each unit is compiled `--repetitions` times; the wall time of each compile and the size of the
+ * object are written as Google Benchmark rows (`BM_Compile/<feature>/w<W>/d<D>`, in ms), so two
+ * runs can be diffed with benchCompare. With `--trace DIR`, Clang writes its `-ftime-trace`
+ * profile of each unit into DIR, and GCC its `-ftime-report` text. A leading `ccache` or
+ * `sccache` in the compile command is dropped, since a cache hit would time nothing.
+ */
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <print>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "rfl.hpp"
+#include "rfl/json.hpp"
+
+namespace {
+    namespace fs = std::filesystem;
+
+    struct CompileRow {
+        std::string name;
+        std::string run_name;
+        std::string run_type = "iteration";
+        std::size_t repetition_index = 0;
+        std::size_t iterations = 1;
+        double real_time = 0.0;
+        std::string time_unit = "ms";
+        std::size_t object_bytes = 0;
+        std::size_t schema_fields = 0;
+    };
+
+    struct CompileContext {
+        std::string compiler;
+        std::size_t repetitions = 0;
+    };
+
+    struct CompileFile {
+        CompileContext context;
+        std::vector<CompileRow> benchmarks;
+    };
+
+    struct Options {
+        std::vector<std::size_t> widths{8, 64};
+        std::vector<std::size_t> depths{1, 3};
+        std::vector<std::string> features{"header", "load", "save", "schema", "cli", "declared"};
+        std::size_t repetitions = 3;
+        std::string out = "compileBench.json";
+        fs::path work = "compileBench.work";
+        std::optional<fs::path> trace;
+        std::vector<std::string> command;
+    };
+
+    /// The field types of generated structs, in rotation, with their default initializers.
+    constexpr std::array<std::pair<std::string_view, std::string_view>, 6> field_types{{
+        {"double", " = 1.0"},
+        {"int", " = 1"},
+        {"std::string", " = \"x\""},
+        {"bool", " = true"},
+        {"std::vector<double>", ""},
+        {"std::optional<int>", ""},
+    }};
+
+    /**
+     * @brief Writes a schema header whose root `Schema` sits on a binary tree of distinct structs.
+     * @return The number of fields, leaves and nested structs alike.
+     */
+    std::size_t write_schema(const fs::path& path, const std::size_t width, const std::size_t depth) {
+        std::string text = "#pragma once\n#include <optional>\n#include <string>\n#include <vector>\n"
+                           "#include \"fourdst/config/config.h\"\n\n";
+        std::size_t fields = 0;
+        for (std::size_t level = 0; level <= depth; ++level) {
+            const std::size_t count = std::size_t{1} << (depth - level);
+            for (std::size_t index = 0; index < count; ++index) {
+                const std::string name = level == depth ? "Schema" : std::format("L{}N{}", level, index);
+                text += std::format("struct {} {{\n", name);
+                for (std::size_t field = 0; field < width; ++field) {
+                    const auto& [type, initializer] = field_types[(field + index) % field_types.size()];
+                    text += std::format("    {} f{}{};\n", type, field, initializer);
+                }
+                if (level > 0) {
+                    text += std::format("    L{}N{} c0;\n    L{}N{} c1;\n", level - 1, 2 * index, level - 1, 2 * index + 1);
+                    fields += 2;
+                }
+                text += "};\n\n";
+                fields += width;
+            }
+        }
+        std::ofstream(path) << text;
+        return fields;
+    }
+
+    /**
+     * @brief Returns the source of the unit that exercises `feature`.
+     */
+    std::string unit_source(const std::string_view feature) {
+        std::string text = "#include \"schema.h\"\n\nusing fourdst::config::Config;\n\n";
+        if (feature == "header") {
+            text += "Config<Schema>* make() { return new Config<Schema>(); }\n";
+        } else if (feature == "load") {
+            text += "void run(Config<Schema>& cfg, std::string_view path) { cfg.load(path); }\n";
+        } else if (feature == "save") {
+            text += "void run(const Config<Schema>& cfg, std::string_view path) { cfg.save(path); }\n";
+        } else if (feature == "schema") {
+            text += "void run(const std::string& path) { Config<Schema>::save_schema(path); }\n";
+        } else if (feature == "cli") {
+            text += "struct App {\n"
+                    "    template <typename V>\n"
+                    "    App* add_option_function(std::string, std::function<void(const V&)>, std::string) { return this; }\n"
+                    "    void footer(std::string) {}\n"
+                    "};\n"
+                    "void run(Config<Schema>& cfg, App& app) { fourdst::config::register_as_cli(cfg, app); }\n";
+        } else if (feature == "declared") {
+            text += "FOURDST_CONFIG_DECLARE(Schema);\n\n"
+                    "void run(Config<Schema>& cfg, std::string_view path) { cfg.load(path); cfg.save(path); }\n";
+        } else {
+            throw std::invalid_argument(std::format("unknown feature '{}'", feature));
+        }
+        return text;
+    }
+
+    std::string quote(const std::string_view arg) {
+        std::string quoted = "'";
+        for (const char c : arg) {
+            if (c == '\'') quoted += "'\\''";
+            else quoted += c;
+        }
+        return quoted + "'";
+    }
+
+    std::string shell_command(const std::vector<std::string>& args) {
+        std::string command;
+        for (const auto& arg : args) command += (command.empty() ? "" : " ") + quote(arg);
+        return command;
+    }
+
+    /**
+     * @brief Returns the first line `--version` prints for the compiler, e.g. to tell Clang from GCC.
+     */
+    std::string compiler_version(const Options& options) {
+        const fs::path out = options.work / "version.txt";
+        std::system(std::format("{} --version > {} 2>&1", quote(options.command.front()), quote(out.string())).c_str());
+        std::ifstream in(out);
+        std::string line;
+        std::getline(in, line);
+        return line;
+    }
+
+    std::vector<std::size_t> parse_sizes(const std::string_view list) {
+        std::vector<std::size_t> sizes;
+        std::istringstream in{std::string(list)};
+        for (std::string item; std::getline(in, item, ',');) sizes.push_back(std::stoul(item));
+        return sizes;
+    }
+
+    std::vector<std::string> parse_names(const std::string_view list) {
+        std::vector<std::string> names;
+        std::istringstream in{std::string(list)};
+        for (std::string item; std::getline(in, item, ',');) names.push_back(item);
+        return names;
+    }
+
+    int usage() {
+        std::println(stderr, "usage: compileBench [--widths N,..] [--depths N,..] [--features NAME,..] [--repetitions N]\n"
+                             "                    [--out FILE] [--work DIR] [--trace DIR] -- <compiler> <flags...>");
+        return 2;
+    }
+}
+
+int main(const int argc, char** argv) {
+    Options options;
+    try {
+        int i = 1;
+        for (; i < argc; ++i) {
+            const std::string_view arg = argv[i];
+            if (arg == "--") break;
+            if (i + 1 >= argc) return usage();
+            const std::string_view value = argv[++i];
+            if (arg == "--widths") options.widths = parse_sizes(value);
+            else if (arg == "--depths") options.depths = parse_sizes(value);
+            else if (arg == "--features") options.features = parse_names(value);
+            else if (arg == "--repetitions") options.repetitions = std::stoul(std::string(value));
+            else if (arg == "--out") options.out = value;
+            else if (arg == "--work") options.work = value;
+            else if (arg == "--trace") options.trace = value;
+            else return usage();
+        }
+        options.command.assign(argv + std::min(i + 1, argc), argv + argc);
+    } catch (const std::exception&) {
+        return usage();
+    }
+    if (!options.command.empty()) {
+        const std::string launcher = fs::path(options.command.front()).filename().string();
+        if (launcher == "ccache" || launcher == "sccache") options.command.erase(options.command.begin());
+    }
+    if (options.command.empty() || options.repetitions == 0) return usage();
+
+    fs::create_directories(options.work);
+    if (options.trace) fs::create_directories(*options.trace);
+    CompileFile results;
+    results.context = {compiler_version(options), options.repetitions};
+    const bool clang = results.context.compiler.contains("clang");
+
+    std::println("{:<36} {:>8} {:>12} {:>12}", "case", "fields", "median", "object");
+    std::size_t failures = 0;
+    for (const std::size_t width : options.widths) {
+        for (const std::size_t depth : options.depths) {
+            const fs::path dir = options.work / std::format("w{}_d{}", width, depth);
+            fs::create_directories(dir);
+            const std::size_t fields = write_schema(dir / "schema.h", width, depth);
+            for (const std::string& feature : options.features) {
+                const std::string name = std::format("BM_Compile/{}/w{}/d{}", feature, width, depth);
+                const fs::path source = dir / (feature + ".cpp");
+                const fs::path object = dir / (feature + ".o");
+                try {
+                    std::ofstream(source) << unit_source(feature);
+                } catch (const std::exception& e) {
+                    std::println(stderr, "compileBench: {}", e.what());
+                    return 2;
+                }
+
+                std::vector<std::string> args = options.command;
+                args.insert(args.end(), {"-I" + dir.string(), "-c", source.string(), "-o", object.string()});
+                std::string redirect;
+                if (options.trace) {
+                    args.emplace_back(clang ? "-ftime-trace" : "-ftime-report");
+                    if (!clang) redirect = " 2> " + quote((*options.trace / (feature + std::format("_w{}_d{}.txt", width, depth))).string());
+                }
+                const std::string command = shell_command(args) + redirect;
+
+                std::vector<double> times;
+                bool failed = false;
+                for (std::size_t repetition = 0; repetition < options.repetitions && !failed; ++repetition) {
+                    const auto start = std::chrono::steady_clock::now();
+                    failed = std::system(command.c_str()) != 0;
+                    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+                    if (failed) break;
+                    times.push_back(elapsed.count());
+                    results.benchmarks.push_back({.name = name,
+                                                  .run_name = name,
+                                                  .repetition_index = repetition,
+                                                  .real_time = elapsed.count(),
+                                                  .object_bytes = fs::file_size(object),
+                                                  .schema_fields = fields});
+                }
+                if (failed) {
+                    std::println(stderr, "compileBench: {} failed to compile:\n  {}", name, command);
+                    ++failures;
+                    continue;
+                }
+                if (options.trace && clang) {
+                    fs::copy_file(fs::path(object).replace_extension(".json"),
+                                  *options.trace / std::format("{}_w{}_d{}.json", feature, width, depth),
+                                  fs::copy_options::overwrite_existing);
+                }
+                std::ranges::sort(times);
+                std::println("{:<36} {:>8} {:>9.0f} ms {:>9} KiB", name, fields, times[times.size() / 2], fs::file_size(object) / 1024);
+            }
+        }
+    }
+
+    std::ofstream(options.out) << rfl::json::write(results, rfl::json::pretty);
+    return failures == 0 ? 0 : 1;
+}
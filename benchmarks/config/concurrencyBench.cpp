@@ -0,0 +1,142 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "fourdst/config/config.h"
+#include "bench_schema.h"
+
+/*
+ * Readers on 1..N threads read a field of one shared config in a tight loop while a writer
+ * thread calls mutate() at a fixed rate (the benchmark argument, in mutations per second; 0
+ * runs without a writer). Reported per case:
+ *   items_per_second       reads per second over all reader threads
+ *   read_p50_ns, read_p99_ns, read_p999_ns
+ *                          latency of single reads, sampled every 64th read, averaged over threads
+ *   mutations              mutate() calls completed during the run
+ *   write_p50_us, write_p99_us, write_max_us
+ *                          latency of those calls, including waiting for the content lock
+ *
+ * The read paths compared are Config::snapshot(), a per-thread ConfigReader and Config::get().
+ * Unsynchronized operator-> is not benchmarked: reading through it while another thread mutates
+ * is a data race.
+ */
+namespace {
+    using fourdst::config::Config;
+    using Schema = TreeSchema<2>;
+    using Clock = std::chrono::steady_clock;
+
+    constexpr std::int64_t sample_every = 64;
+
+    Config<Schema>& shared_config() {
+        static Config<Schema> cfg;
+        return cfg;
+    }
+
+    double percentile(std::vector<double>& values, const double fraction) {
+        if (values.empty()) return 0.0;
+        const auto nth = values.begin() + static_cast<std::ptrdiff_t>(fraction * static_cast<double>(values.size() - 1));
+        std::nth_element(values.begin(), nth, values.end());
+        return *nth;
+    }
+
+    /*
+     * Calls mutate() on the shared config `rate` times per second on its own thread until stopped.
+     */
+    class Writer {
+    public:
+        explicit Writer(const std::int64_t rate) {
+            if (rate <= 0) return;
+            m_thread = std::thread([this, period = std::chrono::nanoseconds(1'000'000'000 / rate)] {
+                auto next = Clock::now();
+                while (!m_stop.load(std::memory_order_relaxed)) {
+                    const auto start = Clock::now();
+                    shared_config().mutate([](auto& data) { data.weight += 1.0; data.a.b.value += 1.0; });
+                    m_latencies_us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+                    next += period;
+                    std::this_thread::sleep_until(next);
+                }
+            });
+        }
+
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        ~Writer() { stop(); }
+
+        void stop() {
+            m_stop.store(true, std::memory_order_relaxed);
+            if (m_thread.joinable()) m_thread.join();
+        }
+
+        void report(benchmark::State& state) {
+            stop();
+            state.counters["mutations"] = static_cast<double>(m_latencies_us.size());
+            state.counters["write_p50_us"] = percentile(m_latencies_us, 0.50);
+            state.counters["write_p99_us"] = percentile(m_latencies_us, 0.99);
+            state.counters["write_max_us"] = m_latencies_us.empty() ? 0.0 : *std::ranges::max_element(m_latencies_us);
+        }
+
+    private:
+        std::atomic<bool> m_stop{false};
+        std::vector<double> m_latencies_us;
+        std::thread m_thread;
+    };
+
+    struct SnapshotRead {
+        double operator()() const { return shared_config().snapshot()->a.b.value; }
+    };
+
+    struct ReaderRead {
+        fourdst::config::ConfigReader<Schema> reader = shared_config().reader();
+        double operator()() { return reader->a.b.value; }
+    };
+
+    struct GetRead {
+        double operator()() const { return shared_config().get<double>("a.b.value"); }
+    };
+
+    template <typename Read>
+    void BM_ConcurrentRead(benchmark::State& state) {
+        std::optional<Writer> writer;
+        if (state.thread_index() == 0) writer.emplace(state.range(0));
+
+        Read read;
+        std::vector<double> latencies_ns;
+        latencies_ns.reserve(1 << 16);
+        std::int64_t count = 0;
+        for (auto _ : state) {
+            if (++count % sample_every == 0) {
+                const auto start = Clock::now();
+                benchmark::DoNotOptimize(read());
+                latencies_ns.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+            } else {
+                benchmark::DoNotOptimize(read());
+            }
+        }
+
+        state.SetItemsProcessed(state.iterations());
+        state.counters["read_p50_ns"] = benchmark::Counter(percentile(latencies_ns, 0.50), benchmark::Counter::kAvgThreads);
+        state.counters["read_p99_ns"] = benchmark::Counter(percentile(latencies_ns, 0.99), benchmark::Counter::kAvgThreads);
+        state.counters["read_p999_ns"] = benchmark::Counter(percentile(latencies_ns, 0.999), benchmark::Counter::kAvgThreads);
+        if (writer) writer->report(state);
+    }
+
+    void concurrency_args(benchmark::internal::Benchmark* bench) {
+        bench->ArgName("writes_per_s")->Args({0})->Args({100})->Args({10'000});
+        bench->ThreadRange(1, static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+        bench->UseRealTime();
+    }
+}
+
+BENCHMARK(BM_ConcurrentRead<SnapshotRead>)->Apply(concurrency_args);
+BENCHMARK(BM_ConcurrentRead<ReaderRead>)->Apply(concurrency_args);
+BENCHMARK(BM_ConcurrentRead<GetRead>)->Apply(concurrency_args);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,248 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "fourdst/config/config.h"
+#include "bench_schema.h"
+
+// Every allocation of the benchmark binary is counted so the memory manager below can report it.
+FOURDST_CONFIG_COUNT_ALLOCATIONS()
+
+namespace {
+    using fourdst::config::Config;
+
+    /*
+     * Reports the allocations made by each benchmark as `allocs_per_iter` and
+     * `total_allocated_bytes` in the results. Google Benchmark runs the case once more with the
+     * manager active, so the timings are unaffected.
+     */
+    class AllocationManager final : public benchmark::MemoryManager {
+    public:
+        void Start() override { m_start = fourdst::config::io::detail::allocation_counter(); }
+
+        void Stop(Result& result) override {
+            const auto& counter = fourdst::config::io::detail::allocation_counter();
+            result.num_allocs = static_cast<std::int64_t>(counter.count - m_start.count);
+            result.total_allocated_bytes = static_cast<std::int64_t>(counter.bytes - m_start.bytes);
+        }
+
+    private:
+        fourdst::config::io::detail::AllocationCounter m_start;
+    };
+
+    double percentile(std::vector<double> values, const double fraction) {
+        if (values.empty()) return 0.0;
+        std::ranges::sort(values);
+        const double rank = fraction * static_cast<double>(values.size() - 1);
+        const auto lower = static_cast<std::size_t>(std::floor(rank));
+        const std::size_t upper = std::min(lower + 1, values.size() - 1);
+        return values[lower] + (values[upper] - values[lower]) * (rank - static_cast<double>(lower));
+    }
+
+    // Added next to the built-in mean, median and stddev when run with --benchmark_repetitions.
+    void add_percentiles(benchmark::internal::Benchmark* bench) {
+        bench->ComputeStatistics("p10", [](const std::vector<double>& v) { return percentile(v, 0.10); });
+        bench->ComputeStatistics("p90", [](const std::vector<double>& v) { return percentile(v, 0.90); });
+        bench->ComputeStatistics("p99", [](const std::vector<double>& v) { return percentile(v, 0.99); });
+    }
+
+    std::int64_t file_bytes(const std::string& path) {
+        return static_cast<std::int64_t>(std::filesystem::file_size(path));
+    }
+
+    std::string bench_file(const std::string_view name) {
+        return (std::filesystem::temp_directory_path() / std::format("fourdst_config_bench.{}.toml", name)).string();
+    }
+
+    template <typename T>
+    std::string write_default_file(const std::string_view name) {
+        const std::string path = bench_file(name);
+        Config<T> cfg;
+        cfg.save(path);
+        return path;
+    }
+
+    std::string write_array_file(const std::int64_t size) {
+        const std::string path = bench_file(std::format("array.{}", size));
+        Config<ArraySchema> cfg;
+        cfg.mutate([size](auto& data) { data.values.assign(static_cast<std::size_t>(size), 1.5); });
+        cfg.save(path);
+        return path;
+    }
+
+    std::string write_generated_file(const std::int64_t rows) {
+        const std::string path = bench_file(std::format("deck.{}", rows));
+        fourdst::config::GenerateOptions options;
+        options.table_array_count = static_cast<std::size_t>(rows);
+        std::ofstream(path) << fourdst::config::generate_toml<DeckSchema>(options);
+        return path;
+    }
+
+    void set_array_size(Config<ArraySchema>& cfg, const std::int64_t size) {
+        cfg.mutate([size](auto& data) { data.values.assign(static_cast<std::size_t>(size), 1.5); });
+    }
+
+    // ---------- load ----------
+
+    template <typename T>
+    void BM_Load(benchmark::State& state) {
+        const std::string path = write_default_file<T>(typeid(T).name());
+        for (auto _ : state) {
+            Config<T> cfg;
+            cfg.load(path);
+            benchmark::DoNotOptimize(cfg.main());
+        }
+        state.SetBytesProcessed(state.iterations() * file_bytes(path));
+        std::filesystem::remove(path);
+    }
+
+    void BM_LoadArray(benchmark::State& state) {
+        const std::string path = write_array_file(state.range(0));
+        for (auto _ : state) {
+            Config<ArraySchema> cfg;
+            cfg.load(path);
+            benchmark::DoNotOptimize(cfg.main());
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+        state.SetBytesProcessed(state.iterations() * file_bytes(path));
+        std::filesystem::remove(path);
+    }
+
+    void BM_LoadGenerated(benchmark::State& state) {
+        const std::string path = write_generated_file(state.range(0));
+        for (auto _ : state) {
+            Config<DeckSchema> cfg;
+            cfg.load(path);
+            benchmark::DoNotOptimize(cfg.main());
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+        state.SetBytesProcessed(state.iterations() * file_bytes(path));
+        std::filesystem::remove(path);
+    }
+
+    // ---------- save ----------
+
+    template <typename T>
+    void BM_Save(benchmark::State& state) {
+        const std::string path = bench_file("save");
+        const Config<T> cfg;
+        for (auto _ : state) {
+            cfg.save(path);
+        }
+        state.SetBytesProcessed(state.iterations() * file_bytes(path));
+        std::filesystem::remove(path);
+    }
+
+    void BM_SaveArray(benchmark::State& state) {
+        const std::string path = bench_file("save");
+        Config<ArraySchema> cfg;
+        set_array_size(cfg, state.range(0));
+        for (auto _ : state) {
+            cfg.save(path);
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+        state.SetBytesProcessed(state.iterations() * file_bytes(path));
+        std::filesystem::remove(path);
+    }
+
+    template <typename T>
+    void BM_SaveSchema(benchmark::State& state) {
+        const std::string path = bench_file("schema");
+        for (auto _ : state) {
+            Config<T>::save_schema(path);
+        }
+        std::filesystem::remove(path);
+    }
+
+    // ---------- format ----------
+
+    template <typename T>
+    void BM_Format(benchmark::State& state) {
+        const Config<T> cfg;
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(std::format("{}", cfg));
+        }
+    }
+
+    void BM_FormatArray(benchmark::State& state) {
+        Config<ArraySchema> cfg;
+        set_array_size(cfg, state.range(0));
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(std::format("{}", cfg));
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    // ---------- mutate ----------
+
+    template <typename T>
+    void BM_Mutate(benchmark::State& state) {
+        Config<T> cfg;
+        int counter = 0;
+        for (auto _ : state) {
+            cfg.mutate([&counter](auto& data) { benchmark::DoNotOptimize(data); ++counter; });
+        }
+    }
+
+    void BM_MutateArray(benchmark::State& state) {
+        Config<ArraySchema> cfg;
+        set_array_size(cfg, state.range(0));
+        for (auto _ : state) {
+            cfg.mutate([](auto& data) { data.values[0] += 1.0; });
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    // ---------- validate ----------
+
+    template <typename T>
+    void BM_Validate(benchmark::State& state) {
+        const std::string path = write_default_file<T>(typeid(T).name());
+        const toml::table root_tbl = toml::parse_file(path);
+        const toml::table* main_tbl = root_tbl["main"].as_table();
+        for (auto _ : state) {
+            std::vector<std::string> missing;
+            fourdst::config::validate::ConfigValidator<T>::check(main_tbl, "main", missing);
+            benchmark::DoNotOptimize(missing);
+        }
+        state.SetBytesProcessed(state.iterations() * file_bytes(path));
+        std::filesystem::remove(path);
+    }
+}
+
+#define FOURDST_CONFIG_SCHEMA_BENCH(NAME)                    \
+    BENCHMARK(NAME<TinySchema>)->Apply(add_percentiles);     \
+    BENCHMARK(NAME<TreeSchema<2>>)->Apply(add_percentiles);  \
+    BENCHMARK(NAME<TreeSchema<4>>)->Apply(add_percentiles);  \
+    BENCHMARK(NAME<TreeSchema<6>>)->Apply(add_percentiles)->Unit(benchmark::kMillisecond)
+
+FOURDST_CONFIG_SCHEMA_BENCH(BM_Load);
+FOURDST_CONFIG_SCHEMA_BENCH(BM_Save);
+FOURDST_CONFIG_SCHEMA_BENCH(BM_SaveSchema);
+FOURDST_CONFIG_SCHEMA_BENCH(BM_Format);
+FOURDST_CONFIG_SCHEMA_BENCH(BM_Mutate);
+FOURDST_CONFIG_SCHEMA_BENCH(BM_Validate);
+
+BENCHMARK(BM_LoadArray)->Apply(add_percentiles)->RangeMultiplier(32)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LoadGenerated)->Apply(add_percentiles)->RangeMultiplier(32)->Range(1 << 5, 1 << 15)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SaveArray)->Apply(add_percentiles)->RangeMultiplier(32)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_FormatArray)->Apply(add_percentiles)->RangeMultiplier(32)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MutateArray)->Apply(add_percentiles)->RangeMultiplier(32)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMicrosecond);
+
+int main(int argc, char** argv) {
+    AllocationManager allocations;
+    benchmark::RegisterMemoryManager(&allocations);
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::RegisterMemoryManager(nullptr);
+    benchmark::Shutdown();
+    return 0;
+}
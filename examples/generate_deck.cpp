@@ -0,0 +1,50 @@
+#include "CLI/CLI.hpp"
+#include "fourdst/config/config.h"
+
+#include <fstream>
+#include <map>
+#include <optional>
+#include <print>
+#include <string>
+#include <vector>
+
+struct Species {
+    std::string name;
+    double mass = 1.0;
+    int charge = 0;
+    std::vector<double> abundances;
+};
+
+struct Network {
+    std::string solver = "implicit";
+    double tolerance = 1e-8;
+    std::vector<Species> species;
+    std::map<std::string, double> rates;
+};
+
+struct Deck {
+    std::string description = "synthetic deck";
+    std::optional<std::string> author;
+    Network network;
+    std::vector<int> checkpoints;
+};
+
+int main(const int argc, char** argv) {
+    fourdst::config::Config<fourdst::config::GenerateOptions> options;
+    CLI::App app("Writes a random, schema-valid TOML deck for benchmarking");
+
+    std::string output;
+    app.add_option("-o,--output", output, "File to write; standard output if not given");
+    fourdst::config::register_as_cli(options, app, "gen");
+
+    CLI11_PARSE(app, argc, argv);
+
+    const std::string deck = fourdst::config::generate_toml<Deck>(*options);
+    if (output.empty()) {
+        std::print("{}", deck);
+    } else {
+        std::ofstream(output) << deck;
+    }
+
+    return 0;
+}
@@ -0,0 +1,27 @@
+// Python extension module, built with -Duse_nanobind=enabled.
+//
+//   import fourdst_config_example as fce
+//   cfg = fce.Config()
+//   cfg.load("run.toml")
+//   run = cfg.snapshot()     # a RunConfig
+//   run.grid.radius.mean()   # NumPy view of the C++ vector, no copy
+#include "fourdst/config/python.h"
+
+#include <string>
+#include <vector>
+
+struct GridConfig {
+    std::vector<double> radius{0.0, 0.5, 1.0};
+    fourdst::config::Tensor<double, 2> opacity;
+};
+
+struct RunConfig {
+    std::string name = "run";
+    int steps = 100;
+    GridConfig grid{};
+};
+
+NB_MODULE(fourdst_config_example, m) {
+    fourdst::config::python::bind_exceptions(m);
+    fourdst::config::python::bind_config<RunConfig>(m, "Config");
+}
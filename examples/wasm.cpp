@@ -1,7 +1,22 @@
+// Browser module for the deck editor, built with -Dwasm_profile=true (see cross/wasm.ini).
+//
+// The editor places the deck in the module's heap and hands over a view of it; the deck is parsed
+// where it lies, without the virtual filesystem:
+//
+//   const bytes = new TextEncoder().encode(text);   // or the Uint8Array of a dropped file
+//   const ptr = Module._malloc(bytes.length);
+//   Module.HEAPU8.set(bytes, ptr);
+//   const error = Module._load_deck(ptr, bytes.length);
+//   Module._free(ptr);
+//   if (error) console.error(Module.UTF8ToString(error));
 #include "fourdst/config/config.h"
+
+#include <emscripten/emscripten.h>
+
+#include <cstddef>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <iostream>
 
 struct AppConfig {
     double x;
@@ -9,15 +24,25 @@ struct AppConfig {
     std::vector<std::string> men;
 };
 
-int main(int argc, char* argv[]) {
+namespace {
     fourdst::config::Config<AppConfig> config;
-    config.load("/input.toml");
-
-    auto x = config->x;
-    const auto& men = config->men;
+    std::string last_error;
+}
 
-    for (const auto& name : men) {
-        std::cout << "men are " << name << std::endl;
-    }
+/**
+ * @brief Loads the deck in `data[0, size)`.
+ * @return Null if the deck is valid, otherwise the error message (valid until the next call).
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE const char* load_deck(const char* data, const std::size_t size) {
+    const auto loaded = config.try_load_from(std::string_view(data, size));
+    if (loaded) return nullptr;
+    last_error = loaded.error().message;
+    return last_error.c_str();
+}
 
+/**
+ * @brief Returns the number of names in the last deck loaded.
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE std::size_t deck_men_count() {
+    return config->men.size();
 }
@@ -0,0 +1,214 @@
+! Fortran interface to the C ABI of fourdst/config/c_api.h.
+!
+! The C++ driver makes the view with fourdst::config::c_api::wrap() and passes it down as a
+! type(c_ptr). Look handles up once, then read by handle in hot loops:
+!
+!   use fdc
+!   integer(c_int32_t) :: h_dt
+!   real(c_double) :: dt
+!   real(c_double), pointer :: radius(:)
+!
+!   h_dt = fdc_handle(cfg, "physics.time_step")
+!   status = fdc_get_double_h(cfg, h_dt, dt)
+!   status = fdc_double_array(cfg, fdc_handle(cfg, "grid.radius"), radius)
+!
+! Array pointers view the snapshot the view has pinned, and stay valid until fdc_refresh or
+! fdc_load is called on it.
+module fdc
+    use, intrinsic :: iso_c_binding
+    implicit none
+    private
+
+    integer(c_int), parameter, public :: FDC_OK = 0
+    integer(c_int), parameter, public :: FDC_UNKNOWN_PATH = 1
+    integer(c_int), parameter, public :: FDC_TYPE_MISMATCH = 2
+    integer(c_int), parameter, public :: FDC_TRUNCATED = 3
+    integer(c_int), parameter, public :: FDC_ERROR = 4
+
+    integer(c_int), parameter, public :: FDC_KIND_OTHER = 0
+    integer(c_int), parameter, public :: FDC_KIND_DOUBLE = 1
+    integer(c_int), parameter, public :: FDC_KIND_INT = 2
+    integer(c_int), parameter, public :: FDC_KIND_BOOL = 3
+    integer(c_int), parameter, public :: FDC_KIND_STRING = 4
+    integer(c_int), parameter, public :: FDC_KIND_DOUBLE_ARRAY = 5
+    integer(c_int), parameter, public :: FDC_KIND_INT32_ARRAY = 6
+    integer(c_int), parameter, public :: FDC_KIND_INT64_ARRAY = 7
+
+    public :: fdc_handle, fdc_kind, fdc_refresh, fdc_load
+    public :: fdc_get_double_h, fdc_get_int_h, fdc_get_logical_h, fdc_get_string_h
+    public :: fdc_double_array, fdc_int32_array, fdc_int64_array
+
+    interface
+        function fdc_handle_of(cfg, path) bind(C, name="fdc_handle_of") result(handle)
+            import :: c_ptr, c_char, c_int32_t
+            type(c_ptr), value :: cfg
+            character(kind=c_char), dimension(*), intent(in) :: path
+            integer(c_int32_t) :: handle
+        end function
+
+        function fdc_kind(cfg, handle) bind(C, name="fdc_kind") result(kind)
+            import :: c_ptr, c_int, c_int32_t
+            type(c_ptr), value :: cfg
+            integer(c_int32_t), value :: handle
+            integer(c_int) :: kind
+        end function
+
+        subroutine fdc_refresh(cfg) bind(C, name="fdc_refresh")
+            import :: c_ptr
+            type(c_ptr), value :: cfg
+        end subroutine
+
+        function fdc_load_c(cfg, path) bind(C, name="fdc_load") result(status)
+            import :: c_ptr, c_char, c_int
+            type(c_ptr), value :: cfg
+            character(kind=c_char), dimension(*), intent(in) :: path
+            integer(c_int) :: status
+        end function
+
+        function fdc_get_double_h(cfg, handle, out) bind(C, name="fdc_get_double_h") result(status)
+            import :: c_ptr, c_int, c_int32_t, c_double
+            type(c_ptr), value :: cfg
+            integer(c_int32_t), value :: handle
+            real(c_double), intent(out) :: out
+            integer(c_int) :: status
+        end function
+
+        function fdc_get_int_h(cfg, handle, out) bind(C, name="fdc_get_int_h") result(status)
+            import :: c_ptr, c_int, c_int32_t, c_int64_t
+            type(c_ptr), value :: cfg
+            integer(c_int32_t), value :: handle
+            integer(c_int64_t), intent(out) :: out
+            integer(c_int) :: status
+        end function
+
+        function fdc_get_bool_h(cfg, handle, out) bind(C, name="fdc_get_bool_h") result(status)
+            import :: c_ptr, c_int, c_int32_t
+            type(c_ptr), value :: cfg
+            integer(c_int32_t), value :: handle
+            integer(c_int32_t), intent(out) :: out
+            integer(c_int) :: status
+        end function
+
+        function fdc_get_string_c(cfg, handle, buffer, capacity, length) bind(C, name="fdc_get_string_h") result(status)
+            import :: c_ptr, c_int, c_int32_t, c_char, c_size_t
+            type(c_ptr), value :: cfg
+            integer(c_int32_t), value :: handle
+            character(kind=c_char), dimension(*), intent(out) :: buffer
+            integer(c_size_t), value :: capacity
+            integer(c_size_t), intent(out) :: length
+            integer(c_int) :: status
+        end function
+
+        function fdc_get_double_array_h(cfg, handle, data, length) bind(C, name="fdc_get_double_array_h") result(status)
+            import :: c_ptr, c_int, c_int32_t, c_size_t
+            type(c_ptr), value :: cfg
+            integer(c_int32_t), value :: handle
+            type(c_ptr), intent(out) :: data
+            integer(c_size_t), intent(out) :: length
+            integer(c_int) :: status
+        end function
+
+        function fdc_get_int32_array_h(cfg, handle, data, length) bind(C, name="fdc_get_int32_array_h") result(status)
+            import :: c_ptr, c_int, c_int32_t, c_size_t
+            type(c_ptr), value :: cfg
+            integer(c_int32_t), value :: handle
+            type(c_ptr), intent(out) :: data
+            integer(c_size_t), intent(out) :: length
+            integer(c_int) :: status
+        end function
+
+        function fdc_get_int64_array_h(cfg, handle, data, length) bind(C, name="fdc_get_int64_array_h") result(status)
+            import :: c_ptr, c_int, c_int32_t, c_size_t
+            type(c_ptr), value :: cfg
+            integer(c_int32_t), value :: handle
+            type(c_ptr), intent(out) :: data
+            integer(c_size_t), intent(out) :: length
+            integer(c_int) :: status
+        end function
+    end interface
+
+contains
+
+    !> Returns the handle of a dotted path, or a negative value if it does not name a field.
+    function fdc_handle(cfg, path) result(handle)
+        type(c_ptr), intent(in) :: cfg
+        character(len=*), intent(in) :: path
+        integer(c_int32_t) :: handle
+        handle = fdc_handle_of(cfg, trim(path) // c_null_char)
+    end function
+
+    !> Loads a file into the config and pins the result.
+    function fdc_load(cfg, path) result(status)
+        type(c_ptr), intent(in) :: cfg
+        character(len=*), intent(in) :: path
+        integer(c_int) :: status
+        status = fdc_load_c(cfg, trim(path) // c_null_char)
+    end function
+
+    function fdc_get_logical_h(cfg, handle, out) result(status)
+        type(c_ptr), intent(in) :: cfg
+        integer(c_int32_t), intent(in) :: handle
+        logical, intent(out) :: out
+        integer(c_int) :: status
+        integer(c_int32_t) :: value
+        value = 0
+        status = fdc_get_bool_h(cfg, handle, value)
+        out = value /= 0
+    end function
+
+    !> Copies a string or enum name into out, blank-padded; FDC_TRUNCATED if it did not fit.
+    function fdc_get_string_h(cfg, handle, out) result(status)
+        type(c_ptr), intent(in) :: cfg
+        integer(c_int32_t), intent(in) :: handle
+        character(len=*), intent(out) :: out
+        integer(c_int) :: status
+        character(kind=c_char) :: buffer(len(out))
+        integer(c_size_t) :: length
+        integer :: i
+        status = fdc_get_string_c(cfg, handle, buffer, int(len(out), c_size_t), length)
+        out = ''
+        if (status /= FDC_OK .and. status /= FDC_TRUNCATED) return
+        do i = 1, int(min(length, int(len(out), c_size_t)))
+            out(i:i) = buffer(i)
+        end do
+    end function
+
+    !> Points values at a double array field, without copying.
+    function fdc_double_array(cfg, handle, values) result(status)
+        type(c_ptr), intent(in) :: cfg
+        integer(c_int32_t), intent(in) :: handle
+        real(c_double), pointer, intent(out) :: values(:)
+        integer(c_int) :: status
+        type(c_ptr) :: data
+        integer(c_size_t) :: length
+        nullify(values)
+        status = fdc_get_double_array_h(cfg, handle, data, length)
+        if (status == FDC_OK) call c_f_pointer(data, values, [length])
+    end function
+
+    !> Points values at an int32 array field, without copying.
+    function fdc_int32_array(cfg, handle, values) result(status)
+        type(c_ptr), intent(in) :: cfg
+        integer(c_int32_t), intent(in) :: handle
+        integer(c_int32_t), pointer, intent(out) :: values(:)
+        integer(c_int) :: status
+        type(c_ptr) :: data
+        integer(c_size_t) :: length
+        nullify(values)
+        status = fdc_get_int32_array_h(cfg, handle, data, length)
+        if (status == FDC_OK) call c_f_pointer(data, values, [length])
+    end function
+
+    !> Points values at an int64 array field, without copying.
+    function fdc_int64_array(cfg, handle, values) result(status)
+        type(c_ptr), intent(in) :: cfg
+        integer(c_int32_t), intent(in) :: handle
+        integer(c_int64_t), pointer, intent(out) :: values(:)
+        integer(c_int) :: status
+        type(c_ptr) :: data
+        integer(c_size_t) :: length
+        nullify(values)
+        status = fdc_get_int64_array_h(cfg, handle, data, length)
+        if (status == FDC_OK) call c_f_pointer(data, values, [length])
+    end function
+end module fdc
@@ -0,0 +1,87 @@
+/**
+ * @file access.h
+ * @brief Per-field read counters for finding config keys a program never reads.
+ *
+ * When built with `FOURDST_CONFIG_USE_ACCESS_COUNTERS` (the `access_counters` meson option),
+ * every `Config<T>` counts the reads made through `Config::get()` per entry of the schema's
+ * compile-time path table, and `Config::get_unread_fields()` lists the leaf fields that were
+ * never read. Reading a struct counts as reading every field nested in it. Direct member access
+ * (`cfg->simulation.time_step`, snapshots, `ConfigReader`) is not counted, so the report is only
+ * meaningful for code that reads its parameters by path.
+ *
+ * Counters are relaxed atomics, so concurrent readers do not serialize on them, but each count
+ * is still a contended cache line write; the instrumentation is meant for debug runs.
+ */
+#pragma once
+
+#if FOURDST_CONFIG_USE_ACCESS_COUNTERS
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "fourdst/config/path_table.h"
+
+namespace fourdst::config::detail {
+
+    /**
+     * @brief One read counter per entry of `PathTable<T>`.
+     * @tparam T The configuration schema type.
+     */
+    template <typename T>
+    class AccessCounters {
+        using Table = PathTable<T>;
+
+    public:
+        /**
+         * @brief Counts a read of the entry at `index` and of every entry nested below it.
+         */
+        void count(const std::size_t index) noexcept {
+            m_counts[index].fetch_add(1, std::memory_order_relaxed);
+            // Entries are in pre-order, so the fields nested in a struct directly follow it.
+            for (std::size_t i = index + 1; i < Table::size() && is_nested(i, index); ++i) {
+                m_counts[i].fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * @brief Returns the number of reads counted for the entry at `index`.
+         */
+        [[nodiscard]] std::uint64_t operator[](const std::size_t index) const noexcept {
+            return m_counts[index].load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Returns the paths of the leaf fields that were never read, in schema order.
+         */
+        [[nodiscard]] std::vector<std::string_view> unread() const {
+            std::vector<std::string_view> paths;
+            for (std::size_t i = 0; i < Table::size(); ++i) {
+                const bool leaf = i + 1 == Table::size() || !is_nested(i + 1, i);
+                if (leaf && (*this)[i] == 0) paths.push_back(Table::path(i));
+            }
+            return paths;
+        }
+
+        /**
+         * @brief Sets every counter to zero.
+         */
+        void reset() noexcept {
+            for (auto& counter : m_counts) counter.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        static constexpr bool is_nested(const std::size_t entry, const std::size_t parent) {
+            const std::string_view path = Table::path(entry);
+            const std::string_view prefix = Table::path(parent);
+            return path.size() > prefix.size() && path.starts_with(prefix) && path[prefix.size()] == '.';
+        }
+
+        std::array<std::atomic<std::uint64_t>, Table::size()> m_counts{};
+    };
+}
+
+#endif
@@ -0,0 +1,423 @@
+/**
+ * @file admin.h
+ * @brief An embedded HTTP endpoint for inspecting and patching a live config.
+ *
+ * Long runs often need a value tweaked while they run. Writing a new deck to a shared filesystem
+ * and reloading it on every node costs a file write and a full parse per node; `AdminEndpoint`
+ * instead accepts one small patch over HTTP, on a loopback TCP port or a Unix socket:
+ *
+ * @code
+ * fourdst::config::AdminEndpoint<RunConfig> admin(cfg, {.unix_socket = "/tmp/run-1234.sock"});
+ * @endcode
+ *
+ * @code{.sh}
+ * curl --unix-socket /tmp/run-1234.sock http://localhost/config
+ * curl --unix-socket /tmp/run-1234.sock -X PATCH --data 'solver.tolerance = 1e-9' http://localhost/config
+ * @endcode
+ *
+ * | Request          | Response                                                                  |
+ * |------------------|---------------------------------------------------------------------------|
+ * | `GET /config`    | `200`, the published snapshot as JSON; its version in `ETag`             |
+ * | `PATCH /config`  | the body goes to `Config::apply_patch()` (TOML, or JSON if it starts with `{`); `204` with the new version in `ETag`, or `400` with the error |
+ *
+ * The version is the generation, followed by `.` and `Config::tunable_stores()` once a `Tunable`
+ * field has been stored to. The JSON of a snapshot is written once per version and shared by
+ * the requests that read it. Requests are served one at a time on one background thread, one request per connection.
+ * With a `token`, requests must carry `Authorization: Bearer <token>` and get `401` otherwise; the
+ * token is compared in constant time. A request that fails for another reason than a bad patch
+ * gets `500`.
+ *
+ * The endpoint is off by default: it is compiled only with `FOURDST_CONFIG_USE_ADMIN_ENDPOINT`
+ * (the `admin_endpoint` meson option) on POSIX systems. A TCP endpoint listens on the loopback
+ * interface only and requires a token, since any local user can reach it; a Unix socket is
+ * created with mode `0600`, so only its owner can connect.
+ */
+#pragma once
+
+#if FOURDST_CONFIG_USE_ADMIN_ENDPOINT && (defined(__unix__) || defined(__APPLE__))
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include "fourdst/config/base.h"
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/json_writer.h"
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace fourdst::config {
+
+    /**
+     * @brief Where an `AdminEndpoint` listens and what it accepts.
+     */
+    struct AdminOptions {
+        /// Listen on this Unix socket path instead of TCP; an existing socket file is replaced.
+        std::string unix_socket;
+        /// The loopback TCP port when `unix_socket` is empty; 0 picks a free port (see `AdminEndpoint::port()`).
+        std::uint16_t port = 0;
+        /// If not empty, the bearer token every request must carry; required over TCP.
+        std::string token;
+        /// The largest patch accepted, in bytes.
+        std::size_t max_body = 1 << 20;
+        /// How long a client may take to send its request before it is dropped.
+        std::chrono::milliseconds timeout{5000};
+    };
+
+    /**
+     * @brief Serves the snapshot of a config as JSON and applies patches to it, over HTTP.
+     *
+     * `config` must outlive the endpoint. Destroying the endpoint stops it; a request being
+     * served is finished first.
+     *
+     * @tparam T The configuration schema type.
+     */
+    template <IsConfigSchema T>
+    class AdminEndpoint {
+    public:
+        /**
+         * @brief Starts listening.
+         * @throws exceptions::ConfigError If the socket cannot be opened, or TCP is asked for without a token.
+         */
+        explicit AdminEndpoint(Config<T>& config, AdminOptions options = {}) : m_config(config), m_options(std::move(options)) {
+            if (m_options.unix_socket.empty()) {
+                if (m_options.token.empty()) {
+                    throw exceptions::ConfigError(
+                        "Refusing to start the config admin endpoint on TCP without a token; set AdminOptions::token or unix_socket.");
+                }
+                listen_tcp();
+            } else {
+                listen_unix();
+            }
+            if (::pipe(m_wake_fds) != 0) {
+                const std::string reason = std::strerror(errno);
+                close_listener();
+                throw exceptions::ConfigError(std::format("Cannot create the wake pipe of the config admin endpoint: {}", reason));
+            }
+            for (const int fd : {m_listener, m_wake_fds[0], m_wake_fds[1]}) {
+                ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+                ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+            }
+            m_server = std::thread([this] { serve(); });
+        }
+
+        AdminEndpoint(const AdminEndpoint&) = delete;
+        AdminEndpoint& operator=(const AdminEndpoint&) = delete;
+
+        ~AdminEndpoint() {
+            // shutdown() does not wake accept() on macOS/BSD, so the server thread polls a pipe too.
+            const char byte = 1;
+            [[maybe_unused]] const auto written = ::write(m_wake_fds[1], &byte, 1);
+            m_server.join();
+            ::close(m_wake_fds[0]);
+            ::close(m_wake_fds[1]);
+            close_listener();
+        }
+
+        /**
+         * @brief Returns the TCP port the endpoint listens on, or 0 for a Unix socket.
+         */
+        [[nodiscard]] std::uint16_t port() const { return m_port; }
+
+        /**
+         * @brief Returns the number of requests served.
+         */
+        [[nodiscard]] std::size_t requests() const {
+            const std::lock_guard lock(m_mutex);
+            return m_requests;
+        }
+
+    private:
+        struct Request {
+            std::string method;
+            std::string target;
+            std::string authorization;
+            std::string body;
+        };
+
+        void listen_tcp() {
+            m_listener = ::socket(AF_INET, SOCK_STREAM, 0);
+            if (m_listener < 0) {
+                throw exceptions::ConfigError(std::format("Cannot open a socket for the config admin endpoint: {}", std::strerror(errno)));
+            }
+            const int on = 1;
+            ::setsockopt(m_listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            address.sin_port = htons(m_options.port);
+            socklen_t length = sizeof(address);
+            if (::bind(m_listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(m_listener, 16) != 0 ||
+                ::getsockname(m_listener, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+                const std::string reason = std::strerror(errno);
+                ::close(m_listener);
+                throw exceptions::ConfigError(
+                    std::format("Cannot listen for config admin requests on port {}: {}", m_options.port, reason));
+            }
+            m_port = ntohs(address.sin_port);
+        }
+
+        void listen_unix() {
+            sockaddr_un address{};
+            if (m_options.unix_socket.size() >= sizeof(address.sun_path)) {
+                throw exceptions::ConfigError(std::format("Config admin socket path is too long: {}", m_options.unix_socket));
+            }
+            m_listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (m_listener < 0) {
+                throw exceptions::ConfigError(std::format("Cannot open a socket for the config admin endpoint: {}", std::strerror(errno)));
+            }
+            address.sun_family = AF_UNIX;
+            std::memcpy(address.sun_path, m_options.unix_socket.c_str(), m_options.unix_socket.size() + 1);
+            ::unlink(m_options.unix_socket.c_str());
+            // Restricted before listen(), so no other user can connect in between.
+            if (::bind(m_listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+                ::chmod(m_options.unix_socket.c_str(), S_IRUSR | S_IWUSR) != 0 || ::listen(m_listener, 16) != 0) {
+                const std::string reason = std::strerror(errno);
+                ::close(m_listener);
+                throw exceptions::ConfigError(
+                    std::format("Cannot listen for config admin requests on {}: {}", m_options.unix_socket, reason));
+            }
+        }
+
+        void close_listener() {
+            ::close(m_listener);
+            if (!m_options.unix_socket.empty()) ::unlink(m_options.unix_socket.c_str());
+        }
+
+        void serve() {
+            while (true) {
+                pollfd fds[2] = {{m_listener, POLLIN, 0}, {m_wake_fds[0], POLLIN, 0}};
+                if (::poll(fds, 2, -1) < 0) {
+                    if (errno == EINTR) continue;
+                    return;
+                }
+                if (fds[1].revents != 0) return;
+                const int client = ::accept(m_listener, nullptr, nullptr);
+                if (client < 0) {
+                    if (errno == EINTR || errno == ECONNABORTED || errno == EAGAIN || errno == EWOULDBLOCK) continue;
+                    return;
+                }
+                // Only the listener is non-blocking; requests are read with the timeouts below.
+                ::fcntl(client, F_SETFL, ::fcntl(client, F_GETFL) & ~O_NONBLOCK);
+                timeval timeout{};
+                timeout.tv_sec = static_cast<time_t>(m_options.timeout.count() / 1000);
+                timeout.tv_usec = static_cast<suseconds_t>(m_options.timeout.count() % 1000 * 1000);
+                ::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+                ::setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+                try {
+                    Request request;
+                    if (const int status = read_request(client, request); status != 0) {
+                        respond(client, status, "text/plain", std::format("{}\n", reason(status)));
+                    } else {
+                        handle(client, request);
+                    }
+                } catch (const std::exception& e) {
+                    // Running out of memory while reading a request must not end the server thread either.
+                    respond(client, 500, "text/plain", std::format("{}\n", e.what()));
+                }
+                ::close(client);
+                const std::lock_guard lock(m_mutex);
+                ++m_requests;
+            }
+        }
+
+        /**
+         * @brief Reads one request; returns 0, or the status to reject it with.
+         */
+        int read_request(const int client, Request& request) const {
+            constexpr std::size_t max_head = 16 * 1024;
+            std::string data;
+            std::size_t head_end = std::string::npos;
+            char buffer[4096];
+            while (head_end == std::string::npos) {
+                if (data.size() > max_head) return 431;
+                const ssize_t received = ::recv(client, buffer, sizeof(buffer), 0);
+                if (received < 0 && errno == EINTR) continue;
+                if (received <= 0) return 400;
+                data.append(buffer, static_cast<std::size_t>(received));
+                head_end = data.find("\r\n\r\n");
+            }
+
+            const std::string_view head = std::string_view(data).substr(0, head_end);
+            const std::size_t line_end = head.find("\r\n");
+            const std::string_view line = head.substr(0, line_end);
+            const std::size_t method_end = line.find(' ');
+            const std::size_t target_end = line.find(' ', method_end + 1);
+            if (method_end == std::string_view::npos || target_end == std::string_view::npos) return 400;
+            request.method = line.substr(0, method_end);
+            request.target = line.substr(method_end + 1, target_end - method_end - 1);
+
+            std::size_t content_length = 0;
+            for (std::size_t at = line_end; at != std::string_view::npos && at < head.size();) {
+                const std::size_t next = head.find("\r\n", at + 2);
+                const std::string_view header = head.substr(at + 2, next == std::string_view::npos ? std::string_view::npos : next - at - 2);
+                at = next;
+                const std::size_t colon = header.find(':');
+                if (colon == std::string_view::npos) continue;
+                const std::string_view name = header.substr(0, colon);
+                std::string_view value = header.substr(colon + 1);
+                value.remove_prefix(std::min(value.find_first_not_of(' '), value.size()));
+                if (equal_ignoring_case(name, "content-length")) {
+                    const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), content_length);
+                    if (error != std::errc{} || end != value.data() + value.size()) return 400;
+                } else if (equal_ignoring_case(name, "authorization")) {
+                    request.authorization = value;
+                }
+            }
+            if (content_length > m_options.max_body) return 413;
+
+            request.body = data.substr(head_end + 4);
+            while (request.body.size() < content_length) {
+                const ssize_t received = ::recv(client, buffer, std::min(sizeof(buffer), content_length - request.body.size()), 0);
+                if (received < 0 && errno == EINTR) continue;
+                if (received <= 0) return 400;
+                request.body.append(buffer, static_cast<std::size_t>(received));
+            }
+            request.body.resize(content_length);
+            return 0;
+        }
+
+        void handle(const int client, const Request& request) {
+            if (!m_options.token.empty() && !equal_constant_time(request.authorization, "Bearer " + m_options.token)) {
+                respond(client, 401, "text/plain", "Unauthorized\n");
+                return;
+            }
+            if (request.target != "/config") {
+                respond(client, 404, "text/plain", "Not Found\n");
+                return;
+            }
+            try {
+                if (request.method == "GET") {
+                    const auto [text, version] = snapshot_json();
+                    respond(client, 200, "application/json", *text, version);
+                } else if (request.method == "PATCH") {
+                    try {
+                        m_config.apply_patch(request.body);
+                    } catch (const exceptions::ConfigError& e) {
+                        respond(client, 400, "text/plain", std::format("{}\n", e.what()));
+                        return;
+                    }
+                    respond(client, 204, "", "", version_tag(m_config.generation(), m_config.tunable_stores()));
+                } else {
+                    respond(client, 405, "text/plain", "Method Not Allowed\n");
+                }
+            } catch (const std::exception& e) {
+                // Anything else (a validator or listener that throws, running out of memory) must not end the server thread.
+                respond(client, 500, "text/plain", std::format("{}\n", e.what()));
+            }
+        }
+
+        /**
+         * @brief Returns the JSON of the published snapshot and its version, written once per version.
+         */
+        std::pair<std::shared_ptr<const std::string>, std::string> snapshot_json() {
+            // Counted before the content is written, so a racing store is at worst written again.
+            const std::uint64_t stores = m_config.tunable_stores();
+            const auto [content, generation] = m_config.versioned_snapshot();
+            {
+                const std::lock_guard lock(m_mutex);
+                if (m_json && m_json_generation == generation && m_json_stores == stores) {
+                    return {m_json, version_tag(generation, stores)};
+                }
+            }
+            auto text = std::make_shared<const std::string>(io::write_json(*content));
+            const std::lock_guard lock(m_mutex);
+            m_json = text;
+            m_json_generation = generation;
+            m_json_stores = stores;
+            return {std::move(text), version_tag(generation, stores)};
+        }
+
+        static std::string version_tag(const std::uint64_t generation, const std::uint64_t stores) {
+            return stores == 0 ? std::to_string(generation) : std::format("{}.{}", generation, stores);
+        }
+
+        static void respond(const int client, const int status, const std::string_view type, const std::string_view body,
+                            const std::string_view version = {}) {
+            std::string response = std::format("HTTP/1.1 {} {}\r\nConnection: close\r\nContent-Length: {}\r\n", status, reason(status),
+                                               body.size());
+            if (!type.empty()) response += std::format("Content-Type: {}\r\n", type);
+            if (!version.empty()) response += std::format("ETag: \"{}\"\r\n", version);
+            response += "\r\n";
+            response += body;
+#ifdef MSG_NOSIGNAL
+            constexpr int flags = MSG_NOSIGNAL;
+#else
+            constexpr int flags = 0;
+#endif
+            for (std::string_view rest = response; !rest.empty();) {
+                const ssize_t sent = ::send(client, rest.data(), rest.size(), flags);
+                if (sent < 0 && errno == EINTR) continue;
+                if (sent <= 0) return;
+                rest.remove_prefix(static_cast<std::size_t>(sent));
+            }
+        }
+
+        static std::string_view reason(const int status) {
+            switch (status) {
+                case 200: return "OK";
+                case 204: return "No Content";
+                case 400: return "Bad Request";
+                case 401: return "Unauthorized";
+                case 404: return "Not Found";
+                case 405: return "Method Not Allowed";
+                case 413: return "Content Too Large";
+                case 431: return "Request Header Fields Too Large";
+                case 500: return "Internal Server Error";
+                default: return "Error";
+            }
+        }
+
+        /**
+         * @brief Compares in a time that depends only on the length of `expected`, so a token cannot be guessed byte by byte.
+         */
+        static bool equal_constant_time(const std::string_view given, const std::string_view expected) {
+            unsigned char difference = given.size() == expected.size() ? 0 : 1;
+            for (std::size_t i = 0; i < expected.size(); ++i) {
+                difference |= static_cast<unsigned char>(expected[i] ^ (i < given.size() ? given[i] : '\0'));
+            }
+            return difference == 0;
+        }
+
+        static bool equal_ignoring_case(const std::string_view a, const std::string_view b) {
+            return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const char x, const char y) {
+                       return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+                   });
+        }
+
+        Config<T>& m_config;
+        AdminOptions m_options;
+        int m_listener = -1;
+        int m_wake_fds[2] = {-1, -1};
+        std::uint16_t m_port = 0;
+        mutable std::mutex m_mutex;
+        std::size_t m_requests = 0;
+        std::shared_ptr<const std::string> m_json;
+        std::uint64_t m_json_generation = 0;
+        std::uint64_t m_json_stores = 0;
+        std::thread m_server;
+    };
+}
+
+#endif
@@ -0,0 +1,227 @@
+/**
+ * @file aliases.h
+ * @brief Old names of renamed fields, matched while a TOML table is read and validated.
+ *
+ * Renaming a field breaks every deck that still uses the old key. Instead of a migration that
+ * rewrites the document, specializing `field_aliases<S>` lists the old names of fields of `S`:
+ *
+ * @code
+ * template <>
+ * struct fourdst::config::field_aliases<PhysicsOptions> {
+ *     static constexpr std::array aliases = {
+ *         fourdst::config::FieldAlias{"time_step", "dt"},
+ *         // diffusion used to live in a [physics.transport] subtable
+ *         fourdst::config::FieldAlias{"diffusion", "transport.diffusion"},
+ *     };
+ * };
+ * @endcode
+ *
+ * An alias is a key of the struct's own table, or a dotted path from it for a value that moved
+ * out of a subtable. The reader of `S` looks up each alias once in the table it is reading and
+ * reads the value it finds into the field. The rest of the keys are then matched by name as
+ * usual. So old decks load in the same pass as new ones, and structs without aliases are read
+ * exactly as before. The validator resolves fields the same way and treats alias keys as known.
+ * `ConfigValidator::check_aliases()` lists the old names a deck still uses (see
+ * `Config::set_deprecated_key_policy()`).
+ *
+ * An old name takes precedence over the new one when a table holds both, so defaults merged in
+ * under `MissingFieldPolicy::USE_DEFAULTS` never shadow it. Aliases are checked at compile time:
+ * each must name a field of `S`, and a plain old key must not itself be a field. JSON documents
+ * are matched by field name only. Readers generated by codegen.h look up aliases the same way.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "rfl.hpp"
+#include "rfl/toml.hpp"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config {
+
+    /**
+     * @brief One old name of a field.
+     */
+    struct FieldAlias {
+        /// The field, as the struct names it now.
+        std::string_view field;
+        /// The old key, or a dotted path such as `transport.diffusion` relative to the struct's table.
+        std::string_view name;
+    };
+
+    /**
+     * @brief Lists the old names of the fields of struct `S`; specialize it with an `aliases` array of `FieldAlias`.
+     *
+     * The primary template lists none, and such structs are read by reflect-cpp's generic reader.
+     */
+    template <typename S>
+    struct field_aliases {
+        static constexpr std::array<FieldAlias, 0> aliases{};
+    };
+
+    namespace detail {
+        /// Whether struct `S` declares old field names.
+        template <typename S>
+        constexpr bool has_field_aliases_v = field_aliases<S>::aliases.size() != 0;
+
+        /// The key an alias starts at in the struct's table.
+        constexpr std::string_view alias_head(const std::string_view name) {
+            return name.substr(0, name.find('.'));
+        }
+
+        /// Whether `name` is a field of struct `S`.
+        template <typename S>
+        constexpr bool is_field_name(const std::string_view name) {
+            using Fields = typename rfl::named_tuple_t<S>::Fields;
+            return [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                return ((rfl::tuple_element_t<Is, Fields>::name() == name) || ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        }
+
+        /// Whether every alias of `S` names a field and no plain alias is itself a field.
+        template <typename S>
+        constexpr bool aliases_are_valid() {
+            for (const FieldAlias& alias : field_aliases<S>::aliases) {
+                if (!is_field_name<S>(alias.field) || alias.name.empty() || alias.name.front() == '.' || alias.name.back() == '.' ||
+                    alias.name.find("..") != std::string_view::npos) {
+                    return false;
+                }
+                if (alias.name.find('.') == std::string_view::npos && is_field_name<S>(alias.name)) return false;
+            }
+            return true;
+        }
+
+        /// Whether `key` of a table of `S` is where some alias starts, and so is not an unknown key.
+        template <typename S>
+        bool is_alias_head(const std::string_view key) {
+            for (const FieldAlias& alias : field_aliases<S>::aliases) {
+                if (alias_head(alias.name) == key) return true;
+            }
+            return false;
+        }
+
+        /// Returns the value `alias` names in `table`, or null.
+        template <typename Table>
+        auto* find_alias_node(Table& table, const FieldAlias& alias) {
+            std::string_view rest = alias.name;
+            Table* current = &table;
+            while (true) {
+                const std::size_t dot = rest.find('.');
+                auto* node = current->get(rest.substr(0, dot));
+                if (node == nullptr || dot == std::string_view::npos) return node;
+                current = node->as_table();
+                if (current == nullptr) return static_cast<decltype(node)>(nullptr);
+                rest.remove_prefix(dot + 1);
+            }
+        }
+
+        /**
+         * @brief Returns the value of `field` in a table of `S`: under its first alias present, else under its name.
+         */
+        template <typename S, typename Table>
+        auto* find_field_node(Table& table, const std::string_view field) {
+            if constexpr (has_field_aliases_v<S>) {
+                for (const FieldAlias& alias : field_aliases<S>::aliases) {
+                    if (alias.field != field) continue;
+                    if (auto* node = find_alias_node(table, alias)) return node;
+                }
+            }
+            return table.get(field);
+        }
+    }
+}
+
+namespace rfl::parsing {
+
+    /**
+     * @brief Reads a struct with old field names from a TOML table, reading each alias present before matching the keys.
+     */
+    template <class T, class ProcessorsType>
+        requires(fourdst::config::detail::has_field_aliases_v<T> && std::is_class_v<T> && std::is_aggregate_v<T> &&
+                 !ProcessorsType::default_if_missing_ && !ProcessorsType::no_field_names_)
+    struct Parser<rfl::toml::Reader, rfl::toml::Writer, T, ProcessorsType> {
+        using R = rfl::toml::Reader;
+        using W = rfl::toml::Writer;
+        using InputVarType = typename R::InputVarType;
+
+        static_assert(fourdst::config::detail::aliases_are_valid<T>(),
+                      "field_aliases must name fields of the struct, and a plain alias must not itself be a field.");
+
+        static Result<T> read(const R& _r, const InputVarType& _var) noexcept {
+            ::toml::table* table = _var->as_table();
+            if (table == nullptr) return error("Could not cast to a table!");
+
+            alignas(T) unsigned char buf[sizeof(T)]{};
+            auto ptr = internal::ptr_cast<T*>(&buf);
+            auto view = ProcessorsType::template process<T>(to_view(*ptr));
+            using ViewType = std::remove_cvref_t<decltype(view)>;
+            std::array<bool, ViewType::size()> found{};
+            std::array<bool, ViewType::size()> set{};
+            std::vector<Error> errors;
+            const ViewReader<R, W, ViewType, ProcessorsType> reader(&_r, &view, &found, &set, &errors);
+
+            // Old names first: a field that was read already is skipped when its new name comes up.
+            for (const fourdst::config::FieldAlias& alias : fourdst::config::field_aliases<T>::aliases) {
+                if (::toml::node* node = fourdst::config::detail::find_alias_node(*table, alias)) reader.read(alias.field, node);
+            }
+            _r.read_object(KeyFilter<decltype(reader)>{&reader}, table);
+            read_missing<ViewType>(found, view, set, errors, std::make_integer_sequence<int, static_cast<int>(ViewType::size())>());
+
+            if (!errors.empty()) {
+                call_destructors_where_necessary(set, &view);
+                return error(to_single_error_message(errors));
+            }
+            auto res = Result<T>(std::move(*ptr));
+            call_destructors_where_necessary(set, &view);
+            return res;
+        }
+
+        template <class P>
+        static void write(const W& _w, const T& _var, const P& _parent) {
+            const auto ptr_named_tuple = ProcessorsType::template process<T>(internal::to_ptr_named_tuple(_var));
+            Parser<R, W, std::remove_cvref_t<decltype(ptr_named_tuple)>, ProcessorsType>::write(_w, ptr_named_tuple, _parent);
+        }
+
+        static schema::Type to_schema(std::map<std::string, schema::Type>* _definitions) {
+            return Parser<R, W, internal::processed_t<T, ProcessorsType>, ProcessorsType>::to_schema(_definitions);
+        }
+
+    private:
+        /// Passes on the keys of the table, except those that only hold old names.
+        template <class Reader>
+        struct KeyFilter {
+            const Reader* reader;
+
+            void read(const std::string_view& _name, const InputVarType& _var) const {
+                if (fourdst::config::detail::is_alias_head<T>(_name) && !fourdst::config::detail::is_field_name<T>(_name)) return;
+                reader->read(_name, _var);
+            }
+        };
+
+        /// Reports missing required fields and default-constructs missing optional ones, as the generic reader does.
+        template <class ViewType, int... Is>
+        static void read_missing(const std::array<bool, ViewType::size()>& _found, ViewType& _view, std::array<bool, ViewType::size()>& _set,
+                                 std::vector<Error>& _errors, std::integer_sequence<int, Is...>) {
+            ([&] {
+                using FieldType = tuple_element_t<Is, typename ViewType::Fields>;
+                using ValueType = std::remove_reference_t<std::remove_pointer_t<typename FieldType::Type>>;
+                if (std::get<Is>(_found)) return;
+                if constexpr (!internal::is_default_val_v<ValueType> && !internal::is_extra_fields_v<ValueType> &&
+                              (ProcessorsType::all_required_ || is_required<ValueType, false>())) {
+                    _errors.emplace_back(Error("Field named '" + std::string(FieldType::name()) + "' not found."));
+                } else if constexpr (!internal::has_default_val_v<ViewType>) {
+                    ::new (const_cast<std::remove_const_t<ValueType>*>(rfl::get<Is>(_view))) std::remove_const_t<ValueType>();
+                    std::get<Is>(_set) = true;
+                }
+            }(), ...);
+        }
+    };
+}
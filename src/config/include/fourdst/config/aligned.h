@@ -0,0 +1,176 @@
+/**
+ * @file aligned.h
+ * @brief Cache-line-aligned, huge-page-backed storage for large numeric arrays.
+ *
+ * `std::allocator` hands out 16-byte aligned blocks on ordinary pages, so a kernel streaming a
+ * multi-megabyte table peels its first iterations to reach vector alignment and takes a TLB miss
+ * every 4 KiB. Two ways to get better storage from a load:
+ *
+ * - per field: declare the member as `AlignedVector<double>` (a `std::vector` with
+ *   `AlignedAllocator`). It reads, writes and validates as a plain array of `V`.
+ * - for every `std::pmr` member of a schema: pass an `AlignedResource` to
+ *   `Config::set_memory_resource()`.
+ *
+ * Either way, blocks of at least `simd_alignment` bytes start on a 64-byte boundary, and blocks
+ * of at least `huge_page_min_bytes` are rounded up to whole huge pages, aligned to one, and
+ * advised with `madvise(MADV_HUGEPAGE)` so transparent huge pages back them (Linux; elsewhere
+ * they are only aligned). The rounding costs up to one huge page per block, so keep the
+ * threshold well above the page size.
+ *
+ * @code
+ * struct OpacityTables {
+ *     fourdst::config::AlignedVector<double> kappa;   // 64-byte aligned, THP above 2 MiB
+ *     std::vector<double> small_table;                 // unchanged
+ * };
+ * @endcode
+ */
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+#include "rfl.hpp"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace fourdst::config {
+
+    /// The alignment of blocks of at least this size: one cache line, and the width of an AVX-512 register.
+    inline constexpr std::size_t simd_alignment = 64;
+
+    /// The size of a transparent huge page on x86-64 and most aarch64 kernels.
+    inline constexpr std::size_t huge_page_bytes = std::size_t{2} << 20;
+
+    /// Blocks of at least this size are placed on huge pages by default.
+    inline constexpr std::size_t huge_page_min_bytes = huge_page_bytes;
+
+    namespace detail {
+        /**
+         * @brief The size and alignment a block of `bytes` is allocated with.
+         *
+         * Depends only on its arguments, so deallocation recomputes what allocation used.
+         */
+        struct AlignedBlock {
+            std::size_t bytes;
+            std::size_t alignment;
+            bool huge;
+        };
+
+        constexpr AlignedBlock aligned_block(const std::size_t bytes, const std::size_t alignment, const std::size_t huge_min) {
+            if (huge_min != 0 && bytes >= huge_min) {
+                const std::size_t rounded = (bytes + huge_page_bytes - 1) / huge_page_bytes * huge_page_bytes;
+                return {rounded, alignment > huge_page_bytes ? alignment : huge_page_bytes, true};
+            }
+            if (bytes >= simd_alignment && alignment < simd_alignment) return {bytes, simd_alignment, false};
+            return {bytes, alignment, false};
+        }
+
+        inline void* allocate_aligned(const std::size_t bytes, const std::size_t alignment, const std::size_t huge_min) {
+            const AlignedBlock block = aligned_block(bytes, alignment, huge_min);
+            void* pointer = ::operator new(block.bytes, std::align_val_t{block.alignment});
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+            // Advisory only: a kernel without THP, or with it disabled, keeps ordinary pages.
+            if (block.huge) ::madvise(pointer, block.bytes, MADV_HUGEPAGE);
+#endif
+            return pointer;
+        }
+
+        inline void deallocate_aligned(void* pointer, const std::size_t bytes, const std::size_t alignment, const std::size_t huge_min) {
+            const AlignedBlock block = aligned_block(bytes, alignment, huge_min);
+            ::operator delete(pointer, block.bytes, std::align_val_t{block.alignment});
+        }
+    }
+
+    /**
+     * @brief An allocator placing blocks on 64-byte boundaries, and large ones on transparent huge pages.
+     *
+     * @tparam V The element type.
+     * @tparam HugeMin Blocks of at least this many bytes go on huge pages; 0 never uses them.
+     */
+    template <typename V, std::size_t HugeMin = huge_page_min_bytes>
+    class AlignedAllocator {
+    public:
+        using value_type = V;
+
+        template <typename U>
+        struct rebind {
+            using other = AlignedAllocator<U, HugeMin>;
+        };
+
+        AlignedAllocator() noexcept = default;
+
+        template <typename U>
+        AlignedAllocator(const AlignedAllocator<U, HugeMin>&) noexcept {}  // NOLINT(google-explicit-constructor)
+
+        [[nodiscard]] V* allocate(const std::size_t count) {
+            if (count > static_cast<std::size_t>(-1) / sizeof(V)) throw std::bad_array_new_length();
+            return static_cast<V*>(detail::allocate_aligned(count * sizeof(V), alignof(V), HugeMin));
+        }
+
+        void deallocate(V* pointer, const std::size_t count) noexcept {
+            detail::deallocate_aligned(pointer, count * sizeof(V), alignof(V), HugeMin);
+        }
+
+        template <typename U>
+        bool operator==(const AlignedAllocator<U, HugeMin>&) const noexcept {
+            return true;
+        }
+    };
+
+    /// A vector whose storage is 64-byte aligned, and on transparent huge pages above `HugeMin` bytes.
+    template <typename V, std::size_t HugeMin = huge_page_min_bytes>
+    using AlignedVector = std::vector<V, AlignedAllocator<V, HugeMin>>;
+
+    /**
+     * @brief A memory resource with the placement of `AlignedAllocator`, for `Config::set_memory_resource()`.
+     *
+     * Allocates from the global aligned `operator new`; it holds no state but the threshold, so
+     * one instance can serve any number of configs and threads.
+     */
+    class AlignedResource final : public std::pmr::memory_resource {
+    public:
+        /**
+         * @param huge_min Blocks of at least this many bytes go on huge pages; 0 never uses them.
+         */
+        explicit AlignedResource(const std::size_t huge_min = huge_page_min_bytes) noexcept : m_huge_min(huge_min) {}
+
+        [[nodiscard]] std::size_t huge_page_threshold() const noexcept { return m_huge_min; }
+
+    private:
+        void* do_allocate(const std::size_t bytes, const std::size_t alignment) override {
+            return detail::allocate_aligned(bytes, alignment, m_huge_min);
+        }
+
+        void do_deallocate(void* pointer, const std::size_t bytes, const std::size_t alignment) override {
+            detail::deallocate_aligned(pointer, bytes, alignment, m_huge_min);
+        }
+
+        [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            const auto* aligned = dynamic_cast<const AlignedResource*>(&other);
+            return aligned != nullptr && aligned->m_huge_min == m_huge_min;
+        }
+
+        std::size_t m_huge_min;
+    };
+}
+
+namespace rfl {
+
+    /**
+     * @brief Reads and writes `AlignedVector` as an array.
+     */
+    template <typename E, std::size_t HugeMin>
+    struct Reflector<fourdst::config::AlignedVector<E, HugeMin>> {
+        using ReflType = std::vector<E>;
+
+        static fourdst::config::AlignedVector<E, HugeMin> to(const ReflType& value) {
+            return fourdst::config::AlignedVector<E, HugeMin>(value.begin(), value.end());
+        }
+
+        static ReflType from(const fourdst::config::AlignedVector<E, HugeMin>& value) { return ReflType(value.begin(), value.end()); }
+    };
+}
@@ -0,0 +1,206 @@
+/**
+ * @file audit.h
+ * @brief A bounded, lock-free log of the mutations applied to a configuration.
+ *
+ * Once a `Config` is given an `AuditLog` with `Config::set_audit_log()`, every `mutate()`,
+ * `transaction()` and `set()` that publishes new content pushes a `MutationRecord`: the
+ * generation it published, when and on which thread, and the dotted paths of the fields it
+ * changed. The record is built after the content lock is released, by walking the old and new
+ * snapshots as `ProvenanceRecord::mark_changes()` does, so the lock is held no longer than before.
+ *
+ * The log is a fixed-size multi-producer, multi-consumer ring: each slot carries a sequence
+ * number that tells producers and consumers whose turn it is, so pushing and popping take one
+ * compare-and-swap on a shared position and never wait for a lock. A push into a full log is
+ * dropped and counted rather than blocking the mutating thread; size the log for the rate at
+ * which it is drained.
+ *
+ * @code
+ * auto log = std::make_shared<fourdst::config::AuditLog>(4096);
+ * cfg.set_audit_log(log);
+ * ...
+ * // on a background thread, or at the end of a run:
+ * log->drain([](const fourdst::config::MutationRecord& record) {
+ *     for (const auto path : record.paths) std::println("{} {}", record.generation, path);
+ * });
+ * @endcode
+ */
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/compare.h"
+#include "fourdst/config/path_table.h"
+#include "fourdst/config/provenance.h"
+
+#include "rfl.hpp"
+
+namespace fourdst::config {
+
+    /**
+     * @brief One published mutation of a configuration.
+     */
+    struct MutationRecord {
+        /// The generation the mutation published (see `Config::generation()`).
+        std::uint64_t generation = 0;
+        /// When the mutation was published.
+        std::chrono::system_clock::time_point time;
+        /// The thread that made the mutation.
+        std::thread::id thread;
+        /// Dotted paths of the leaf fields that changed, in schema order; they point into static storage.
+        std::vector<std::string_view> paths;
+    };
+
+    /**
+     * @brief A bounded multi-producer, multi-consumer ring of `MutationRecord`s.
+     *
+     * All member functions are thread-safe and lock-free. The log may be shared by several configs.
+     */
+    class AuditLog {
+    public:
+        /**
+         * @brief Creates a log holding up to `capacity` records, rounded up to a power of two.
+         */
+        explicit AuditLog(const std::size_t capacity)
+            : m_mask(std::bit_ceil(capacity < 2 ? std::size_t{2} : capacity) - 1),
+              m_slots(std::make_unique<Slot[]>(m_mask + 1)) {
+            for (std::size_t i = 0; i <= m_mask; ++i) {
+                m_slots[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        AuditLog(const AuditLog&) = delete;
+        AuditLog& operator=(const AuditLog&) = delete;
+
+        /**
+         * @brief Appends `record`, or drops it if the log is full.
+         * @return False if the record was dropped.
+         */
+        bool push(MutationRecord record) {
+            std::size_t position = m_tail.load(std::memory_order_relaxed);
+            while (true) {
+                Slot& slot = m_slots[position & m_mask];
+                const std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                if (sequence == position) {
+                    if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        slot.record = std::move(record);
+                        slot.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (sequence < position) {
+                    // The slot still holds the record of the previous lap: the log is full.
+                    m_dropped.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                } else {
+                    position = m_tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /**
+         * @brief Removes and returns the oldest record, or nothing if the log is empty.
+         */
+        std::optional<MutationRecord> pop() {
+            std::size_t position = m_head.load(std::memory_order_relaxed);
+            while (true) {
+                Slot& slot = m_slots[position & m_mask];
+                const std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                if (sequence == position + 1) {
+                    if (m_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        MutationRecord record = std::move(slot.record);
+                        slot.sequence.store(position + m_mask + 1, std::memory_order_release);
+                        return record;
+                    }
+                } else if (sequence < position + 1) {
+                    return std::nullopt;
+                } else {
+                    position = m_head.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /**
+         * @brief Pops every record currently in the log, oldest first, passing each to `consumer`.
+         * @return The number of records consumed.
+         */
+        template <typename Consumer>
+        std::size_t drain(Consumer&& consumer) {
+            std::size_t count = 0;
+            while (std::optional<MutationRecord> record = pop()) {
+                consumer(*record);
+                ++count;
+            }
+            return count;
+        }
+
+        /**
+         * @brief Pops every record currently in the log and returns them, oldest first.
+         */
+        [[nodiscard]] std::vector<MutationRecord> dump() {
+            std::vector<MutationRecord> records;
+            drain([&records](MutationRecord& record) { records.push_back(std::move(record)); });
+            return records;
+        }
+
+        /**
+         * @brief The number of records the log holds when full.
+         */
+        [[nodiscard]] std::size_t capacity() const noexcept { return m_mask + 1; }
+
+        /**
+         * @brief The number of records dropped because the log was full.
+         */
+        [[nodiscard]] std::uint64_t dropped() const noexcept { return m_dropped.load(std::memory_order_relaxed); }
+
+    private:
+        struct Slot {
+            std::atomic<std::size_t> sequence{0};
+            MutationRecord record;
+        };
+
+        const std::size_t m_mask;
+        std::unique_ptr<Slot[]> m_slots;
+        // Producers and consumers advance separate positions, kept on separate cache lines.
+        alignas(64) std::atomic<std::size_t> m_tail{0};
+        alignas(64) std::atomic<std::size_t> m_head{0};
+        alignas(64) std::atomic<std::uint64_t> m_dropped{0};
+    };
+
+    namespace detail {
+        /**
+         * @brief Appends the paths of the leaf fields that differ between `before` and `after`.
+         * @param base The ordinal of the first field of `V` (see `provenance.h`).
+         */
+        template <typename T, typename V>
+        void changed_paths(const V& before, const V& after, const std::size_t base, std::vector<std::string_view>& paths) {
+            using Fields = typename rfl::named_tuple_t<V>::Fields;
+            const auto before_view = rfl::to_view(before).values();
+            const auto after_view = rfl::to_view(after).values();
+            std::size_t ordinal = base;
+            [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                ([&] {
+                    using Type = typename rfl::tuple_element_t<Is, Fields>::Type;
+                    const auto& lhs = *rfl::get<Is>(before_view);
+                    const auto& rhs = *rfl::get<Is>(after_view);
+                    if (!equal(lhs, rhs)) {
+                        if constexpr (is_path_struct_v<Type>) {
+                            changed_paths<T, Type>(lhs, rhs, ordinal + 1, paths);
+                        } else {
+                            paths.push_back(PathTable<T>::path(ordinal));
+                        }
+                    }
+                    ordinal += 1 + nested_count<Type>();
+                }(), ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        }
+    }
+}
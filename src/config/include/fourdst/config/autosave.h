@@ -0,0 +1,218 @@
+/**
+ * @file autosave.h
+ * @brief Coalesced background saving for configs that are mutated many times per second.
+ *
+ * This file defines `ConfigAutosaver`, which keeps a file in step with a `Config<T>` without a
+ * `save()` after every `mutate()`. Each published change only marks the config dirty; a single
+ * background thread writes the file at most once per interval, and `flush()` or destroying the
+ * autosaver writes any pending change at once. Files are replaced atomically by default, so
+ * readers (including a `ConfigWatcher` elsewhere) never see a partial file.
+ *
+ * @code
+ * fourdst::config::ConfigAutosaver autosave(cfg, "controller_state.toml", std::chrono::seconds(1));
+ * for (int step = 0; step < steps; ++step) {
+ *     cfg.mutate([&](auto& data) { data.controller.gain = adapt(data.controller.gain); });
+ * }
+ * autosave.flush();
+ * @endcode
+ */
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <format>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "fourdst/config/base.h"
+#include "fourdst/config/exceptions/exceptions.h"
+
+namespace fourdst::config {
+
+    /**
+     * @brief Saves a `Config<T>` to a file on a background thread, at most once per interval.
+     *
+     * The autosaver subscribes to the whole config, so every `mutate()`, `set()`, `reset()`,
+     * `undo()` or reload that changes the content marks it dirty. The first change after a quiet
+     * period is written right away; later ones are coalesced until the interval since the last
+     * write has passed. Each write serializes the snapshot published at that moment, so the
+     * mutating threads never wait for serialization or I/O.
+     *
+     * A background write that fails leaves the config dirty, passes the error to the error
+     * callback and is retried after the next interval. The config must outlive the autosaver.
+     *
+     * @tparam T The configuration schema type.
+     */
+    template <IsConfigSchema T>
+    class ConfigAutosaver {
+    public:
+        /**
+         * @brief Callback invoked on the autosave thread when a write fails; exceptions other than
+         *        `ConfigError`s arrive wrapped in a `ConfigSaveError`.
+         */
+        using ErrorCallback = std::function<void(const exceptions::ConfigError& error)>;
+
+        /**
+         * @brief Starts saving `config` to `path` whenever it changes.
+         *
+         * Nothing is written until the config changes; call `flush()` after construction to write
+         * the current content unconditionally.
+         *
+         * @param config The config to save.
+         * @param path The file to write.
+         * @param interval Minimum time between two writes.
+         * @param policy How the file is written; `ATOMIC` by default.
+         */
+        ConfigAutosaver(Config<T>& config, std::string path, const std::chrono::milliseconds interval = std::chrono::seconds(1),
+                        const SavePolicy policy = SavePolicy::ATOMIC)
+            : m_config(config), m_path(std::move(path)), m_interval(interval), m_policy(policy) {
+            m_subscription = m_config.subscribe("", [this](const auto&) { mark_dirty(); });
+            m_thread = std::thread([this] { run(); });
+        }
+
+        ConfigAutosaver(const ConfigAutosaver&) = delete;
+        ConfigAutosaver& operator=(const ConfigAutosaver&) = delete;
+
+        /**
+         * @brief Stops the background thread and writes any pending change.
+         *
+         * A failure of that last write is passed to the error callback, not thrown.
+         */
+        ~ConfigAutosaver() {
+            m_config.unsubscribe(m_subscription);
+            {
+                std::lock_guard lock(m_mutex);
+                m_stopping = true;
+            }
+            m_wake.notify_all();
+            if (m_thread.joinable()) {
+                m_thread.join();
+            }
+            try {
+                flush();
+            } catch (const std::exception& error) {
+                report(error);
+            }
+        }
+
+        /**
+         * @brief Sets the callback run when a background write fails.
+         * @param callback The callback.
+         */
+        void on_error(ErrorCallback callback) {
+            std::lock_guard lock(m_callback_mutex);
+            m_on_error = std::move(callback);
+        }
+
+        /**
+         * @brief Writes the current content now if it changed since the last write.
+         *
+         * Runs on the calling thread and does not wait for the interval.
+         *
+         * @return True if the file was written.
+         * @throws exceptions::ConfigSaveError If the file cannot be written; the config stays dirty.
+         */
+        bool flush() {
+            std::lock_guard write_lock(m_write_mutex);
+            {
+                std::lock_guard lock(m_mutex);
+                if (!m_dirty) return false;
+                // Cleared before writing, so changes published during the write mark it dirty again.
+                m_dirty = false;
+            }
+            try {
+                m_config.save(m_path, m_policy);
+            } catch (...) {
+                mark_dirty();
+                throw;
+            }
+            std::lock_guard lock(m_mutex);
+            m_last_write = std::chrono::steady_clock::now();
+            ++m_writes;
+            return true;
+        }
+
+        /**
+         * @brief Returns whether a change has not been written yet.
+         */
+        [[nodiscard]] bool dirty() const {
+            std::lock_guard lock(m_mutex);
+            return m_dirty;
+        }
+
+        /**
+         * @brief Returns the number of writes made so far, by the background thread and `flush()`.
+         */
+        [[nodiscard]] std::size_t writes() const {
+            std::lock_guard lock(m_mutex);
+            return m_writes;
+        }
+
+        /**
+         * @brief Returns the path being written.
+         */
+        [[nodiscard]] const std::string& path() const noexcept { return m_path; }
+
+    private:
+        void mark_dirty() {
+            {
+                std::lock_guard lock(m_mutex);
+                m_dirty = true;
+            }
+            m_wake.notify_all();
+        }
+
+        void report(const std::exception& error) {
+            std::lock_guard lock(m_callback_mutex);
+            if (!m_on_error) return;
+            if (const auto* config_error = dynamic_cast<const exceptions::ConfigError*>(&error)) {
+                m_on_error(*config_error);
+            } else {
+                m_on_error(exceptions::ConfigSaveError(std::format("Autosaving config to {} failed: {}", m_path, error.what())));
+            }
+        }
+
+        void run() {
+            std::unique_lock lock(m_mutex);
+            while (!m_stopping) {
+                m_wake.wait(lock, [this] { return m_stopping || m_dirty; });
+                if (m_stopping) break;
+                // Changes arriving until the interval has passed are folded into this write.
+                if (m_wake.wait_until(lock, m_last_write + m_interval, [this] { return m_stopping; })) break;
+                if (!m_dirty) continue;
+                lock.unlock();
+                try {
+                    flush();
+                } catch (const std::exception& error) {
+                    // Whatever the write throws (std::bad_alloc while serializing, a failing sink) must not end the thread.
+                    report(error);
+                    // Retried after a full interval instead of spinning on a persistent failure.
+                    const std::lock_guard retry_lock(m_mutex);
+                    m_last_write = std::chrono::steady_clock::now();
+                }
+                lock.lock();
+            }
+        }
+
+        Config<T>& m_config;
+        std::string m_path;
+        std::chrono::milliseconds m_interval;
+        SavePolicy m_policy;
+        std::size_t m_subscription = 0;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_wake;
+        bool m_dirty = false;
+        bool m_stopping = false;
+        std::chrono::steady_clock::time_point m_last_write{};
+        std::size_t m_writes = 0;
+        std::mutex m_write_mutex;
+        std::mutex m_callback_mutex;
+        ErrorCallback m_on_error;
+        std::thread m_thread;
+    };
+}
@@ -7,7 +7,9 @@
  * and schema generation using the `reflect-cpp` library.
  */
 #pragma once
+#include <algorithm>
 #include <filesystem>
+#include <fstream>
 #include <string>
 #include <map>
 #include <format>
@@ -15,65 +17,115 @@
 #include <string_view>
 #include <type_traits>
 #include <mutex>
+#include <shared_mutex>
+#include <memory>
+#include <atomic>
+#include <deque>
+#include <expected>
+#include <functional>
+#include <future>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <memory_resource>
+#include <istream>
+#include <iterator>
+#include <sstream>
+#include <cctype>
+#include <cstdlib>
+#include <cerrno>
+#include <cstring>
+#include <initializer_list>
+#include <typeindex>
+#include <unordered_map>
+#include <chrono>
+#include <thread>
 
 #include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/access.h"
+#include "fourdst/config/aliases.h"
+#include "fourdst/config/aligned.h"
+#include "fourdst/config/audit.h"
+#include "fourdst/config/binary.h"
+#include "fourdst/config/cache.h"
+#include "fourdst/config/changes.h"
+#include "fourdst/config/codegen.h"
+#if FOURDST_CONFIG_USE_ARROW
+#include "fourdst/config/columnar.h"
+#endif
+#include "fourdst/config/compact.h"
+#include "fourdst/config/compare.h"
+#include "fourdst/config/compress.h"
+#include "fourdst/config/constraints.h"
+#include "fourdst/config/daemon.h"
+#include "fourdst/config/deadline.h"
+#include "fourdst/config/device.h"
+#include "fourdst/config/env.h"
+#include "fourdst/config/executor.h"
+#include "fourdst/config/expression.h"
+#include "fourdst/config/field_index.h"
+#include "fourdst/config/fingerprint.h"
+#include "fourdst/config/fixed_array.h"
+#include "fourdst/config/flat_map.h"
+#include "fourdst/config/fragments.h"
+#include "fourdst/config/frozen.h"
+#include "fourdst/config/fwd.h"
+#if FOURDST_CONFIG_USE_HDF5
+#include "fourdst/config/hdf5_io.h"
+#endif
+#include "fourdst/config/hot.h"
+#include "fourdst/config/io.h"
+#include "fourdst/config/json_writer.h"
+#include "fourdst/config/lazy.h"
+#include "fourdst/config/limits.h"
+#include "fourdst/config/mapped_view.h"
+#include "fourdst/config/memory.h"
+#include "fourdst/config/metrics.h"
+#include "fourdst/config/migrate.h"
+#include "fourdst/config/namelist.h"
+#include "fourdst/config/numa.h"
+#include "fourdst/config/numeric_array.h"
+#include "fourdst/config/parallel_read.h"
+#include "fourdst/config/patch.h"
+#include "fourdst/config/path_table.h"
+#include "fourdst/config/quantity.h"
+#include "fourdst/config/pmr.h"
+#include "fourdst/config/prefetch.h"
+#include "fourdst/config/provenance.h"
+#include "fourdst/config/reader.h"
+#include "fourdst/config/resident.h"
+#include "fourdst/config/save_queue.h"
+#include "fourdst/config/section.h"
+#include "fourdst/config/seqlock.h"
+#include "fourdst/config/shard.h"
+#include "fourdst/config/sink.h"
+#include "fourdst/config/source.h"
+#include "fourdst/config/sidecar.h"
+#include "fourdst/config/stats.h"
+#include "fourdst/config/stored.h"
+#include "fourdst/config/soa.h"
+#include "fourdst/config/sparse.h"
+#include "fourdst/config/splice.h"
+#include "fourdst/config/string_store.h"
+#include "fourdst/config/tagged_union.h"
+#include "fourdst/config/tensor.h"
+#include "fourdst/config/tunable.h"
+#include "fourdst/config/trace.h"
+#include "fourdst/config/toml_stream.h"
+#include "fourdst/config/toml_template.h"
+#include "fourdst/config/toml_writer.h"
 #include "fourdst/config/validate.h"
 
 #include "rfl.hpp"
 #include "rfl/toml.hpp"
 #include "rfl/json.hpp"
+#include "yyjson.h"
 
 
 namespace fourdst::config {
 
-    /**
-     * @brief Concept ensuring a type is suitable for configuration schema.
-     *
-     * A valid configuration schema must be:
-     * - A class or struct (`std::is_class_v`)
-     * - An aggregate type (`std::is_aggregate_v`), i.e., strict POD-like structure without user-declared constructors.
-     * - Not a `std::string`.
-     *
-     * @tparam T The type to check.
-     */
-    template <typename T>
-    concept IsConfigSchema =
-        std::is_class_v<std::decay_t<T>> &&          // Must be a class/struct
-        std::is_aggregate_v<std::decay_t<T>> &&      // Must be an aggregate (POD-like)
-        !std::same_as<std::decay_t<T>, std::string>; // Explicitly exclude strings
-
-    /**
-     * @brief Policies for handling the root name during configuration loading.
-     */
-    enum class RootNameLoadPolicy {
-        /**
-         * @brief Updates the internal root name to match what is found in the file.
-         */
-        FROM_FILE,
-        /**
-         * @brief Enforces the current internal root name; loading fails if the file's root name differs.
-         */
-        KEEP_CURRENT
-    };
-
-    /**
-     * @brief Represents the current state of a Config object.
-     */
-    enum class ConfigState {
-        /**
-         * @brief Configuration contains default values and has not been loaded from a file.
-         */
-        DEFAULT,
-        /**
-         * @brief Configuration has been successfully populated from a file.
-         */
-        LOADED_FROM_FILE,
-
-        MODIFIED
-    };
-
-
-
     /**
      * @brief Wrapper class for managing strongly-typed configuration structures.
      *
@@ -82,6 +134,21 @@ namespace fourdst::config {
      *
      * It uses `reflect-cpp` to automatically inspect the fields of `T`.
      *
+     * @par Thread safety
+     * `operator->`, `operator*` and `main()` return references to the live content and must not be
+     * used while another thread calls `mutate()`, `transaction()`, `undo()`, `reset()` or `load()`.
+     * Concurrent readers should use `snapshot()`, which returns an immutable, reference-counted copy
+     * of the most recently published content with a single atomic load and never blocks on writers,
+     * or `read()`, which reads the live content under a shared lock that writers wait for.
+     * Consumers that only depend on part of the config can `subscribe()` to a field path instead of
+     * polling and comparing snapshots themselves.
+     *
+     * @par String views
+     * `std::string_view` fields are read without a `std::string` per value: they point into a
+     * `io::StringStore` created for each load (see `string_store.h`), which the config and every
+     * snapshot taken from it keep alive. Views assigned through `mutate()` or `set()` must outlive
+     * the config themselves.
+     *
      * @tparam T The configuration structure type. Must satisfy `IsConfigSchema`.
      *
      * @par Examples
@@ -121,6 +188,36 @@ namespace fourdst::config {
          */
         Config() = default;
 
+        /**
+         * @brief Constructs a config holding `content` as its defaults, without parsing anything.
+         *
+         * `content` becomes the baseline `reset()` returns to; the state is `ConfigState::DEFAULT`.
+         * Used with initializers generated at build time (see `embed.h`).
+         *
+         * @param content The initial configuration content.
+         */
+        explicit Config(T content)
+            : m_content(std::move(content)), m_origin(std::make_shared<const T>(m_content)),
+              m_sync(std::make_unique<Sync>(m_origin)) {}
+
+        /**
+         * @brief Move constructor. Takes over the content, snapshots, history and subscriptions of `other`.
+         *
+         * The snapshot pointer and the locks live in one heap block that moves with the config, so
+         * moving is a handful of pointer moves plus a move of `T`, and `ConfigReader` handles stay
+         * valid. A moved-from config may only be assigned to or destroyed. No other thread may use
+         * `other` during the move, and a `ConfigWatcher` must not be watching it.
+         */
+        Config(Config&& other) = default;
+
+        /**
+         * @brief Move assignment; see the move constructor.
+         */
+        Config& operator=(Config&& other) = default;
+
+        Config(const Config&) = delete;
+        Config& operator=(const Config&) = delete;
+
         /**
          * @brief Access member of the underlying configuration struct.
          * @return Pointer to the constant configuration content.
@@ -152,270 +249,5845 @@ namespace fourdst::config {
         const T& main() const { return m_content; }
 
         /**
-         * @brief Saves the current configuration to a TOML file.
+         * @brief Returns the most recently published immutable snapshot of the configuration.
          *
-         * Wraps the configuration content under the current root name (default "main")
-         * and writes it to the specified path.
+         * Snapshots are published by `load()`, `mutate()` and `reset()`, each advancing `generation()`.
+         * A held snapshot is never modified; later changes publish a new one, and the old one is
+         * released when its last reader drops it. Acquiring a snapshot is a single atomic load and
+         * takes no lock.
          *
-         * @param path The file path to write to.
-         * @throws exceptions::ConfigSaveError If the file cannot be opened.
+         * @return Shared pointer to the constant configuration content.
          *
          * @par Examples
          * @code
-         * cfg.save("config.toml");
+         * #pragma omp parallel
+         * {
+         *     const auto cfg_snapshot = cfg.snapshot();
+         *     solve(cfg_snapshot->simulation.time_step);
+         * }
          * @endcode
          */
-        void save(std::string_view path) const {
-            [[maybe_unused]] T default_instance{};
-            std::unordered_map<std::string, T> wrapper;
-            wrapper[m_root_name] = m_content;
-            const std::string toml_string = rfl::toml::write(wrapper);
+        [[nodiscard]] std::shared_ptr<const T> snapshot() const noexcept {
+            return m_sync->snapshot.load(std::memory_order_acquire);
+        }
 
-            std::ofstream ofs{std::string(path)};
-            if (!ofs.is_open()) {
-                throw exceptions::ConfigSaveError(
-                    std::format("Failed to open file for writing config: {}", path)
-                );
-            }
+        /**
+         * @brief A published snapshot and the generation it was published at.
+         */
+        struct VersionedSnapshot {
+            std::shared_ptr<const T> content;
+            std::uint64_t generation = 0;
+        };
 
-            ofs << toml_string;
-            ofs.close();
+        /**
+         * @brief Returns the number of snapshots published since the config was constructed.
+         *
+         * Every publication, by `load()`, `reload()`, `mutate()`, `set()`, `apply_patch()`, `undo()`,
+         * `reset()` and the others, advances it by one; stores into `Tunable` fields do not (see
+         * `tunable_stores()`). Code that caches values computed from the config can record the
+         * generation it read and compare it with this one to know whether the cache is stale.
+         */
+        [[nodiscard]] std::uint64_t generation() const noexcept {
+            return m_sync->generation.load(std::memory_order_acquire);
         }
 
         /**
-         * @brief Sets the root name/key used in the TOML file.
-         *
-         * The default root name is "main". This name appears as the top-level table in the TOML file (e.g., `[main]`).
+         * @brief Returns the number of values `set()` has stored into `Tunable` fields in place.
          *
-         * @param name The new root name.
+         * Such stores change the content without publishing a snapshot, so caches of data that
+         * depends on tunables key on this count together with `generation()`.
          */
-        void set_root_name(const std::string_view name) {
-            m_root_name = name;
+        [[nodiscard]] std::uint64_t tunable_stores() const noexcept {
+            return m_sync->tunable_stores.load(std::memory_order_acquire);
         }
 
         /**
-         * @brief Gets the current root name.
-         * @return The root name string view.
+         * @brief Returns the published snapshot together with its generation.
+         *
+         * The generation is read before the snapshot, so a publication racing with the call can
+         * only pair a newer snapshot with an older generation: a cache keyed on it is recomputed
+         * once more than needed, never kept past a change.
+         *
+         * @par Examples
+         * @code
+         * if (cached_generation != cfg.generation()) {
+         *     const auto [content, generation] = cfg.versioned_snapshot();
+         *     table = build_table(*content);
+         *     cached_generation = generation;
+         * }
+         * @endcode
          */
-        [[nodiscard]] std::string_view get_root_name() const {
-            return m_root_name;
+        [[nodiscard]] VersionedSnapshot versioned_snapshot() const noexcept {
+            const std::uint64_t current = generation();
+            return {snapshot(), current};
         }
 
         /**
-         * @brief Sets the policy for handling root name mismatches during load.
-         * @param policy The policy (FROM_FILE or KEEP_CURRENT).
+         * @brief Keeps the last `count` published snapshots, so `at_generation()` can return them.
+         *
+         * Consumers that lag behind the config, such as asynchronous output of timestep N written
+         * while step N+1 already runs under changed parameters, record `generation()` when their
+         * data is produced and read exactly that config later, without copying it into every job.
+         * Memory is bounded by `count` snapshots: each publication beyond it releases the oldest.
+         * A retained snapshot is held like any other, so it is not recycled (see
+         * `set_reload_recycling()`) until it drops out. The default of 0 retains none; lowering the
+         * count releases the oldest snapshots at once.
+         *
+         * @param count The number of snapshots to keep, the published one included.
          */
-        void set_root_name_load_policy(const RootNameLoadPolicy policy) {
-            m_root_name_load_policy = policy;
+        void set_retention(const std::size_t count) {
+            std::deque<VersionedSnapshot> dropped;
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            m_retention = count;
+            const std::lock_guard retention_lock(m_sync->retention_mutex);
+            auto& retained = m_sync->retained;
+            if (count > 0 && retained.empty()) {
+                retained.push_back({snapshot(), generation()});
+            }
+            while (retained.size() > count) {
+                dropped.push_back(std::move(retained.front()));
+                retained.pop_front();
+            }
         }
 
         /**
-         * @brief Gets the current root name load policy.
-         * @return The current policy.
+         * @brief Gets the number of snapshots kept for `at_generation()`.
          */
-        [[nodiscard]] RootNameLoadPolicy get_root_name_load_policy() const {
-            return m_root_name_load_policy;
+        [[nodiscard]] std::size_t get_retention() const {
+            return m_retention;
         }
 
         /**
-         * @brief Returns a string description of the current root name load policy.
-         * @return "FROM_FILE", "KEEP_CURRENT", or "UNKNOWN".
+         * @brief Returns the snapshot that was published as generation `generation`.
+         *
+         * Every generation `generation()` or `versioned_snapshot()` has reported is found here
+         * until `set_retention()` more snapshots have been published after it.
+         *
+         * @par Examples
+         * @code
+         * cfg.set_retention(8);
+         * // Compute thread, each step:
+         * output_queue.push({step, cfg.generation(), fields});
+         * // Output thread, possibly steps later:
+         * const auto job = output_queue.pop();
+         * write_step(job, *cfg.at_generation(job.generation));
+         * @endcode
+         *
+         * @return The snapshot, or null if it is no longer retained (or not yet published).
          */
-        [[nodiscard]] std::string describe_root_name_load_policy() const {
-            switch (m_root_name_load_policy) {
-                case RootNameLoadPolicy::FROM_FILE:
-                    return "FROM_FILE";
-                case RootNameLoadPolicy::KEEP_CURRENT:
-                    return "KEEP_CURRENT";
-                default:
-                    return "UNKNOWN";
+        [[nodiscard]] std::shared_ptr<const T> at_generation(const std::uint64_t generation) const {
+            const std::lock_guard lock(m_sync->retention_mutex);
+            const auto& retained = m_sync->retained;
+            if (retained.empty() || generation < retained.front().generation || generation > retained.back().generation) {
+                return nullptr;
             }
+            return retained[generation - retained.front().generation].content;
         }
 
         /**
-         * @brief Loads configuration from a TOML file.
-         *
-         * Reads the file, parses it, and updates the internal configuration state.
+         * @brief Returns an awaitable stream of the snapshots published from now on (see `changes.h`).
          *
-         * @param path The file path to read from.
-         * @throws exceptions::ConfigLoadError If the config is already loaded, file doesn't exist, or root name mismatch (under KEEP_CURRENT policy).
-         * @throws exceptions::ConfigParseError If the file content is invalid TOML or doesn't match the schema.
+         * `co_await` on the stream suspends the coroutine until a snapshot newer than the last one
+         * it returned is published, and resumes it with that snapshot. The coroutine is resumed on
+         * the default executor if one is installed, otherwise on the thread that published.
          *
          * @par Examples
          * @code
-         * try {
-         *     cfg.load("config.toml");
-         * } catch (const fourdst::config::exceptions::ConfigError& e) {
-         *     std::cerr << "Error loading config: " << e.what() << std::endl;
+         * auto changes = cfg.changes();
+         * while (true) {
+         *     const auto [content, generation] = co_await changes;
+         *     if (!content) break;
+         *     rebuild(*content);
          * }
          * @endcode
          */
-        void load(const std::string_view path, const bool verbose = false) {
-            if (m_state == ConfigState::LOADED_FROM_FILE) {
-                throw exceptions::ConfigLoadError(
-                    "Config has already been loaded from file. Reloading is not supported.");
-            }
-
-            if (!std::filesystem::exists(path)) {
-                throw exceptions::ConfigLoadError(
-                    std::format("Config file does not exist: {}", path));
-            }
-
-            using wrapper = std::unordered_map<std::string, T>;
-            const rfl::Result<wrapper> result = rfl::toml::load<wrapper>(std::string(path));
-
-            if (!result) {
-                std::vector<std::string> missing_fields;
-
-                try {
-                    toml::table root_tbl = toml::parse_file(std::string(path));
-
-                    if (!root_tbl.empty()) {
-                        const auto loaded_root_name = std::string(root_tbl.begin()->first);
-                        const toml::table* t_tbl = root_tbl[loaded_root_name].as_table();
-
-                        if (t_tbl) {
-                            validate::ConfigValidator<T>::check(t_tbl, loaded_root_name, missing_fields);
-                        }
-                    }
-                } catch (const toml::parse_error&) {
-                    throw exceptions::ConfigParseError("Unable to parse TOML file for an unknown reason. This normally means the toml file is empty or completely malformed. Please check the file content and ensure it is valid TOML. If the file is empty, consider adding at least an empty table (e.g., [main]) to it.");
-                }
+        [[nodiscard]] ChangeStream<VersionedSnapshot> changes() const {
+            return changes(default_executor());
+        }
 
-                if (!missing_fields.empty() && verbose) {
-                    std::cerr << validate::report_all_missing_fields(missing_fields) << std::endl;
-                }
+        /**
+         * @brief Like `changes()`, but resumes the awaiting coroutines on `executor`; an empty one resumes them inline.
+         */
+        [[nodiscard]] ChangeStream<VersionedSnapshot> changes(AnyExecutor executor) const {
+            return ChangeStream<VersionedSnapshot>(m_sync->changes, generation(), std::move(executor));
+        }
 
-                throw exceptions::ConfigParseError(
-                    std::format("Failed to load config from file: {}. Reason: {}",
-                                path,
-                                result.error().what())
-                );
+        /**
+         * @brief Returns a copy of the most recently published content.
+         *
+         * For trivially copyable schemas of up to `detail::seqlock_max_bytes` (numbers, bools,
+         * enums and fixed-size arrays), the copy is read from a seqlock-protected inline copy (see
+         * `seqlock.h`): no allocation, no reference count and no lock, only a retry if a publish
+         * overlaps the read. Other schemas copy `*snapshot()`.
+         *
+         * @return The content.
+         *
+         * @par Examples
+         * @code
+         * const SimulationOptions options = cfg.copy();
+         * @endcode
+         */
+        [[nodiscard]] T copy() const noexcept(detail::is_seqlock_eligible_v<T>) {
+            if constexpr (detail::is_seqlock_eligible_v<T>) {
+                return m_sync->inline_copy.load();
+            } else {
+                return *snapshot();
             }
+        }
 
+        /**
+         * @brief Returns the most recently published content as an immutable `FrozenConfig`.
+         *
+         * The frozen config holds its own copy, without any synchronization; reads from it are
+         * plain member accesses (see `frozen.h`). This config is unaffected.
+         *
+         * @par Examples
+         * @code
+         * const auto frozen = cfg.freeze();
+         * const double dt = frozen->simulation.time_step;
+         * // frozen.mutate(...) does not compile.
+         * @endcode
+         */
+        [[nodiscard]] FrozenConfig<T> freeze() const& {
+            const auto [content, generation] = versioned_snapshot();
+            return FrozenConfig<T>(*content, m_root_name, generation);
+        }
 
-            std::string loaded_root_name = result.value().begin()->first;
+        /**
+         * @brief Freezes an expiring config, moving its content instead of copying it; see `freeze() const&`.
+         */
+        [[nodiscard]] FrozenConfig<T> freeze() && {
+            const std::uint64_t current = generation();
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            return FrozenConfig<T>(std::move(m_content), std::move(m_root_name), current);
+        }
 
-            if (m_root_name_load_policy == RootNameLoadPolicy::KEEP_CURRENT && m_root_name != loaded_root_name) {
-                throw exceptions::ConfigLoadError(
-                    std::format(
-                        "Root name mismatch when loading config from file. Current root name is '{}', but file root name is '{}'. If you want to use the root name from the file, set the root name load policy to FROM_FILE using set_root_name_load_policy().",
-                        m_root_name,
-                        loaded_root_name
-                    )
-                );
-            }
-            m_root_name = loaded_root_name;
+        /**
+         * @brief A device mirror and the generation of the snapshot it was filled from.
+         */
+        struct VersionedDeviceMirror {
+            DeviceMirror<T> mirror{};
+            /// The generation of `mirror`; the maximum value marks a mirror that was never filled.
+            std::uint64_t generation = std::numeric_limits<std::uint64_t>::max();
+        };
 
-            m_content = result.value().at(loaded_root_name);
+        /**
+         * @brief Returns the numeric, boolean, enum and fixed-size array fields of the published snapshot as a flat mirror.
+         *
+         * The mirror is trivially copyable and has no padding between fields, so it can be copied
+         * as it is into GPU constant memory; see `device.h`. `Tunable` fields are not mirrored.
+         *
+         * @return The mirror, tagged with the generation of the snapshot it was filled from.
+         */
+        [[nodiscard]] VersionedDeviceMirror to_device_mirror() const {
+            VersionedDeviceMirror result;
+            refresh_device_mirror(result);
+            return result;
+        }
 
-            m_state = ConfigState::LOADED_FROM_FILE;
+        /**
+         * @brief Refills `mirror` if a snapshot newer than the one it holds was published.
+         *
+         * @param mirror A mirror from `to_device_mirror()` or a default-constructed one.
+         * @return True if `mirror` was refilled and has to be uploaded again.
+         *
+         * @par Examples
+         * @code
+         * if (cfg.refresh_device_mirror(mirror)) {
+         *     cudaMemcpyToSymbolAsync(c_config, &mirror.mirror, sizeof(mirror.mirror), 0, cudaMemcpyHostToDevice, stream);
+         * }
+         * @endcode
+         */
+        bool refresh_device_mirror(VersionedDeviceMirror& mirror) const {
+            if (mirror.generation == generation()) return false;
+            const auto [content, current] = versioned_snapshot();
+            detail::fill_device_mirror<T>(*content, mirror.mirror);
+            mirror.generation = current;
+            return true;
         }
 
         /**
-         * @brief Generates and saves a JSON schema for the configuration structure.
+         * @brief Returns a copy of the hot block of the most recently published snapshot.
          *
-         * Useful for enabling autocompletion and validation in editors (e.g., VS Code).
+         * Available for schemas that name hot fields with `hot_fields<T>` (see `hot.h`). The block
+         * is read from a seqlock kept next to the snapshot: no allocation, no reference count and
+         * no lock, only a retry if a publish overlaps the read.
          *
-         * @param path The path to save the schema file to.
-         * @throws exceptions::SchemaSaveError If the file cannot be opened.
+         * @return The hot fields, packed into a cache-line-aligned block.
          *
          * @par Examples
          * @code
-         * Config<MyConfig>::save_schema("MyConfig.schema.json");
+         * using Hot = fourdst::config::HotBlock<SimulationOptions>;
+         * const Hot hot = cfg.hot();
+         * const double dt = hot.get<Hot::index("simulation.time_step")>();
          * @endcode
          */
-        static void save_schema(const std::string& path) {
-            using wrapper = std::unordered_map<std::string, T>;
-            const std::string json_schema = rfl::json::to_schema<wrapper>(rfl::json::pretty);
-
-            std::ofstream ofs{std::string(path)};
-            if (!ofs.is_open()) {
-                throw exceptions::SchemaSaveError(
-                    std::format("Failed to open file for writing schema: {}", path)
-                );
-            }
+        [[nodiscard]] HotBlock<T> hot() const noexcept requires detail::has_hot_fields_v<T> {
+            return m_sync->hot.load();
+        }
 
-            ofs << json_schema;
-            ofs.close();
+        /**
+         * @brief Returns a read-only handle to the published snapshots of this config.
+         *
+         * The handle reads `snapshot()` without the parser headers `base.h` pulls in, so code that
+         * only consumes values can include `reader.h` alone. Each thread should keep its own copy:
+         * `current()` caches the snapshot in the handle and re-acquires it only when the config
+         * publishes a new one, so hot loops read values without touching the shared reference
+         * count. It must not outlive the config.
+         *
+         * @return The reader.
+         */
+        [[nodiscard]] ConfigReader<T> reader() const noexcept {
+            return ConfigReader<T>(m_sync->snapshot, m_sync->version, m_sync->generation, m_sync->replicas, m_sync->inline_copy);
         }
 
         /**
-         * @brief Gets the current state of the configuration object.
-         * @return The current state (DEFAULT or LOADED_FROM_FILE).
+         * @brief Returns a handle to one member of the published snapshots, such as a section.
+         *
+         * The `ConfigRef` reads the member inside this config's snapshots: nothing is copied, and
+         * reloads and mutations are seen on its next read. Hand it to modules that should only see
+         * their own section. It must not outlive the config.
+         *
+         * @tparam Member A pointer to a data member of `T`, e.g. `&MyConfig::physics`.
+         * @return The handle.
+         *
+         * @par Examples
+         * @code
+         * fourdst::config::ConfigRef<PhysicsOptions> physics = cfg.view<&MyConfig::physics>();
+         * const bool diffusion = physics->diffusion;
+         * @endcode
          */
-        [[nodiscard]] ConfigState get_state() const { return m_state; }
+        template <auto Member>
+            requires detail::MemberOf<Member, T>
+        [[nodiscard]] ConfigRef<detail::member_value_t<Member>> view() const noexcept {
+            return ConfigRef<detail::member_value_t<Member>>(&m_sync->snapshot, &detail::load_member<T, Member>, m_sync->version,
+                                                             m_sync->generation);
+        }
 
         /**
-         * @brief Returns a string description of the current configuration state.
-         * @return "DEFAULT", "LOADED_FROM_FILE", or "UNKNOWN".
+         * @brief Pins the most recently published snapshot for the caller's scope.
+         *
+         * Reads through the returned `ConfigPin` all see that one snapshot, even while other threads
+         * load, mutate or reset the config, and cost a plain load each; the pin is released at the end
+         * of its scope. Use one pin per timestep (or other unit of work) instead of locking around it.
+         *
+         * @return The pin, which owns its snapshot.
+         *
+         * @par Examples
+         * @code
+         * const auto step = cfg.pin();
+         * const double dt = step->simulation.time_step;
+         * const int every = step->simulation.output_frequency;   // from the same snapshot as dt
+         * @endcode
          */
-        [[nodiscard]] std::string describe_state() const {
-            switch (m_state) {
-                case ConfigState::DEFAULT:
-                    return "DEFAULT";
-                case ConfigState::LOADED_FROM_FILE:
-                    return "LOADED_FROM_FILE";
-                case ConfigState::MODIFIED:
-                    return "MODIFIED";
-                default:
-                    return "UNKNOWN";
-            }
+        [[nodiscard]] ConfigPin<T> pin() const noexcept {
+            const auto [content, generation] = versioned_snapshot();
+            return ConfigPin<T>(content, generation);
         }
 
-        template <typename MutatorFunc>
-        void mutate(MutatorFunc&& mutator) {
-            m_content_mutex.lock();
-            m_content_orig = m_content;
-            mutator(m_content);
-            m_state = ConfigState::MODIFIED;
-            m_content_mutex.unlock();
+        /**
+         * @brief Locks the content for reading in place until the returned guard is destroyed.
+         *
+         * Unlike `operator->`, reads through the guard are synchronized with writers: the guard holds
+         * the content lock shared, which every writer takes exclusively, so readers on many threads
+         * proceed together and writers wait for them. No snapshot is acquired or copied. Writers
+         * are delayed while a guard is held; `pin()` gives a consistent view without that.
+         *
+         * @return The guard; see `ConfigReadGuard`.
+         *
+         * @par Examples
+         * @code
+         * const auto guard = cfg.read();
+         * const double dt = guard->simulation.time_step;
+         * @endcode
+         */
+        [[nodiscard]] ConfigReadGuard<T> read() const {
+            return ConfigReadGuard<T>(m_sync->content_mutex, m_content);
         }
 
-        void reset() {
-            m_content_mutex.lock();
-            if (m_state == ConfigState::MODIFIED) {
-                m_content = m_content_orig;
-                m_state = ConfigState::LOADED_FROM_FILE;
-            }
-            m_content_mutex.unlock();
+        /**
+         * @brief Reports the memory held by the content, per field path.
+         *
+         * Each field is charged its `sizeof` plus the heap it owns (string and vector capacity,
+         * map nodes, and the heap of their elements); capacity reserved beyond the size is listed
+         * as unused. See `memory.h` for what is estimated. The writer-side content is measured,
+         * since that is where containers grown while loading or mutating keep their capacity;
+         * the published snapshot is a copy without unused capacity, so the config holds about
+         * twice the used amount.
+         *
+         * @return The report; `str()` renders it as a tree.
+         *
+         * @par Examples
+         * @code
+         * std::cerr << cfg.memory_report().str();
+         * @endcode
+         */
+        [[nodiscard]] MemoryReport memory_report() const {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            return fourdst::config::memory_report(m_content, m_root_name);
         }
 
-    private:
-        T m_content;
-        T m_content_orig;
-        std::mutex m_content_mutex;
-        std::string m_root_name = "main";
-        ConfigState m_state = ConfigState::DEFAULT;
-        RootNameLoadPolicy m_root_name_load_policy = RootNameLoadPolicy::KEEP_CURRENT;
-    };
-}
+        /**
+         * @brief Saves the current configuration to a TOML file.
+         *
+         * Wraps the configuration content under the current root name (default "main")
+         * and writes it to the specified path.
+         *
+         * Schemas made of plain structs, scalars, strings, enums, optionals, vectors, arrays and
+         * string-keyed maps are streamed to the file by `io::TomlWriter` without building an
+         * intermediate TOML document. Other schemas are serialized with `rfl::toml::write`.
+         * Either way the output is deterministic, with unordered maps written in key order, so
+         * saving equal configs gives byte-identical files that can be deduplicated by hash.
+         *
+         * With `SavePolicy::ATOMIC` the content is written to a temporary file in the same
+         * directory and renamed over `path`, so a crash or a concurrent `load()` (or a
+         * `ConfigWatcher`) never sees a truncated file. `SavePolicy::DURABLE` additionally syncs
+         * the data to storage, which can cost milliseconds on network filesystems.
+         *
+         * The format follows `set_file_format()`; with the default `FileFormat::AUTO` a `.json`
+         * path is written as compact JSON and everything else as TOML.
+         *
+         * A path ending in `.zst` or `.gz` is compressed as it is written, at the level set with
+         * `set_compression_level()`, and the extension before it picks the format (see `compress.h`).
+         *
+         * The published snapshot is written, so `save()` may run on one thread while another calls
+         * `mutate()`. To keep a frequently mutated config on disk without saving after every
+         * change, see `ConfigAutosaver` in `autosave.h`.
+         *
+         * @param path The file path to write to.
+         * @param policy How the file is written (IN_PLACE, ATOMIC or DURABLE).
+         * @throws exceptions::ConfigSaveError If the file cannot be opened, written, synced or renamed,
+         *         or names a compression libconfig was built without.
+         *
+         * @par Examples
+         * @code
+         * cfg.save("config.toml");
+         * cfg.save("checkpoint.toml", fourdst::config::SavePolicy::DURABLE);
+         * @endcode
+         */
+        void save(std::string_view path, const SavePolicy policy = SavePolicy::IN_PLACE) const;
 
-/**
- * @brief Formatter specialization for Config<T> to allow easy printing.
- *
- * This allows a Config object to be directly formatted/printed (e.g., via std::print or std::format).
- * It outputs the configuration in its TOML representation.
- *
- * @par Example
+        /**
+         * @brief Saves the fields selected by `mode`.
+         *
+         * With `SaveMode::NON_DEFAULT_ONLY` the TOML document omits every field equal to its
+         * default, so a deck that changes a few values is written (and re-read) in a fraction of
+         * the time. Tables are compared field by field; arrays are written whole if any element
+         * changed, and inline, without sidecar or columnar files. Load the file with
+         * `set_missing_field_policy(MissingFieldPolicy::USE_DEFAULTS)` to restore the omitted fields.
+         *
+         * Content that lacks a field the defaults have (an optional or map entry that was cleared)
+         * cannot be expressed that way and is written in full, as are JSON files.
+         * `SaveMode::FULL` is the same as `save(path, policy)`; `SaveMode::CHANGES_SINCE_LOAD`
+         * writes the patch described at `save_patch()`.
+         *
+         * @param path The file path to write to.
+         * @param mode Which fields to write.
+         * @param policy How the file is written (IN_PLACE, ATOMIC or DURABLE).
+         * @throws exceptions::ConfigSaveError If the file cannot be written; see `save(path, policy)`.
+         *
+         * @par Examples
+         * @code
+         * cfg.save("run.toml", fourdst::config::SaveMode::NON_DEFAULT_ONLY);
+         *
+         * fourdst::config::Config<Schema> restored;
+         * restored.set_missing_field_policy(fourdst::config::MissingFieldPolicy::USE_DEFAULTS);
+         * restored.load("run.toml");
+         * @endcode
+         */
+        void save(std::string_view path, const SaveMode mode, const SavePolicy policy = SavePolicy::IN_PLACE) const;
+
+        /**
+         * @brief Saves a merge patch of the fields changed since the configuration was loaded.
+         *
+         * The published snapshot is compared field by field with the content of the last `load()`
+         * or `reload()` (or the defaults, if nothing was loaded); unchanged subtrees are skipped
+         * without visiting their leaves. Changed fields inside nested structs are written one by
+         * one; any other changed field (a vector, a map, an optional) is written whole. The patch
+         * is nested under the root table, so restarting costs loading the base file and passing
+         * the patch to `apply_patch()`. A `.json` path writes the patch as JSON.
+         *
+         * Same as `save(path, SaveMode::CHANGES_SINCE_LOAD, policy)`.
+         *
+         * @param path The file path to write to.
+         * @param policy How the file is written (IN_PLACE, ATOMIC or DURABLE).
+         * @throws exceptions::ConfigSaveError If the file cannot be written, or an optional field
+         *         was cleared since the load (a merge patch cannot remove a field).
+         *
+         * @par Examples
+         * @code
+         * cfg.load("base.toml");
+         * run_until_checkpoint(cfg);
+         * cfg.save_patch("restart.patch.toml", fourdst::config::SavePolicy::ATOMIC);
+         *
+         * // On restart:
+         * fourdst::config::Config<Schema> resumed;
+         * resumed.load("base.toml");
+         * std::ifstream in("restart.patch.toml");
+         * resumed.apply_patch(std::string(std::istreambuf_iterator<char>(in), {}));
+         * @endcode
+         */
+        void save_patch(const std::string_view path, const SavePolicy policy = SavePolicy::IN_PLACE) const {
+            save(path, SaveMode::CHANGES_SINCE_LOAD, policy);
+        }
+
+        /**
+         * @brief Starts `save(path, policy)` on the background writer thread and returns at once.
+         *
+         * The published snapshot and the save settings are captured before returning; the snapshot
+         * is shared, not copied. Serialization and the file write then run on the single thread of
+         * `io::SaveQueue`, so a compute thread checkpointing the config is not stalled by them.
+         * Later `mutate()` calls, setting changes, or destroying the config do not affect the write.
+         *
+         * Saves run one at a time in the order they were started. A save to a path that still has
+         * another save to it waiting is merged into it: only the newer snapshot is written, and
+         * both futures become ready when it is.
+         *
+         * @param path The file path to write to.
+         * @param policy How the file is written; `ATOMIC` by default, so readers never see a partial file.
+         * @return A future that becomes ready when the file is written; `get()` rethrows the errors `save()` throws.
+         * @throws exceptions::ConfigSaveError If `path` names a compression libconfig was built without.
+         *
+         * @par Examples
+         * @code
+         * auto checkpoint = cfg.save_async(std::format("checkpoint_{:06}.toml", step));
+         * advance_timestep();
+         * checkpoint.get();
+         * @endcode
+         */
+        /**
+         * @brief Saves like `save(path, policy)`, but returns errors instead of throwing them; see `try_load()`.
+         * @param path The file path to write to.
+         * @param policy How the file is written (IN_PLACE, ATOMIC or DURABLE).
+         * @return Nothing on success; otherwise what `save()` would have thrown.
+         */
+        [[nodiscard]] std::expected<void, exceptions::ConfigErrorInfo> try_save(std::string_view path,
+                                                                                SavePolicy policy = SavePolicy::IN_PLACE) const noexcept;
+
+        [[nodiscard]] std::future<void> save_async(std::string path, const SavePolicy policy = SavePolicy::ATOMIC) const;
+
+        /**
+         * @brief Appends to `out` the bytes `save(path, policy)` would write to `path`, without writing `path`.
+         *
+         * Format and compression follow `path` as they do for `save()`. Sidecar, shard and
+         * columnar files that belong beside `path` are written by this call. Writing `out` to
+         * `path` afterwards gives the file `save()` writes. `save_many()` serializes its configs
+         * this way, in parallel, before it writes them.
+         *
+         * @param path The file the bytes are meant for.
+         * @param out The string to append to; its capacity is reused.
+         * @param policy How side files are written; only `DURABLE` matters here.
+         * @throws exceptions::ConfigSaveError If a side file cannot be written, or `path` names a compression libconfig was built without.
+         */
+        void serialize_for(std::string_view path, std::string& out, SavePolicy policy = SavePolicy::ATOMIC) const;
+
+        /**
+         * @brief Serializes the configuration into a string instead of a file.
+         *
+         * The output is the same document `save()` writes, appended to `out`. The format follows
+         * `set_file_format()`; with `FileFormat::AUTO` it is TOML. Sidecars are never written.
+         *
+         * @param out The string to append to.
+         *
+         * @par Examples
+         * @code
+         * std::string blob;
+         * cfg.save_to(blob);
+         * socket.send(blob);
+         * @endcode
+         */
+        void save_to(std::string& out) const;
+
+        /**
+         * @brief Serializes the configuration into an output stream; see `save_to(std::string&)`.
+         * @param out The stream to write to.
+         * @throws exceptions::ConfigSaveError If the stream fails.
+         */
+        void save_to(std::ostream& out) const;
+
+        /**
+         * @brief Appends a compact binary message holding the configuration to `buffer`, e.g. for a socket.
+         *
+         * The message holds the root name, `io::content_fingerprint<T>()` and the content as
+         * `io::encode_content()` writes it: flat and native-endian for binary-encodable schemas,
+         * compact JSON otherwise. Reading it back with `deserialize_from()` involves no TOML, and
+         * for binary-encodable schemas no text at all. Both sides must share the byte order.
+         *
+         * @param buffer The string to append to.
+         *
+         * @par Examples
+         * @code
+         * std::string message;
+         * cfg.serialize_to(message);
+         * socket.send(message);
+         * @endcode
+         */
+        void serialize_to(std::string& buffer) const {
+            const std::shared_ptr<const T> content = snapshot();
+            io::BinaryWriter writer(buffer);
+            writer.write(wire_magic);
+            writer.write(std::string_view(m_root_name));
+            writer.write(io::content_fingerprint<T>());
+            io::encode_content(buffer, *content);
+        }
+
+        /**
+         * @brief Loads configuration from a message written by `serialize_to()`, like `load_from()` does from text.
+         *
+         * @param bytes The message, with nothing following it.
+         * @return True if the content changed.
+         * @throws exceptions::ConfigLoadError If `bytes` is not such a message, is truncated, or was written by a
+         *         binary with a different layout of `T`.
+         */
+        bool deserialize_from(const std::string_view bytes) {
+            io::BinaryReader reader(bytes);
+            std::uint32_t magic = 0;
+            std::string loaded_root_name;
+            std::uint64_t fingerprint = 0;
+            if (!reader.read(magic) || magic != wire_magic || !reader.read(loaded_root_name) || !reader.read(fingerprint)) {
+                throw exceptions::ConfigLoadError("Not a serialized config message.");
+            }
+            // Checked before decoding, since the encoding carries no field names.
+            if (fingerprint != io::content_fingerprint<T>()) {
+                throw exceptions::ConfigLoadError("The serialized config was written with a different layout of the schema.");
+            }
+            T loaded{};
+            if (!io::decode_content(bytes.substr(bytes.size() - reader.remaining()), loaded)) {
+                throw exceptions::ConfigLoadError("The serialized config is truncated or corrupt.");
+            }
+            auto provenance = fresh_provenance();
+            if (provenance) {
+                provenance->mark_all({FieldSource::FILE, 0});
+            }
+            const bool changed = install_reloaded(std::move(loaded), std::move(loaded_root_name), std::string(memory_source),
+                                                  std::move(provenance), true);
+            forget_source();
+            return changed;
+        }
+
+        /**
+         * @brief Loads configuration from a message in a byte buffer; see `deserialize_from(std::string_view)`.
+         */
+        bool deserialize_from(const std::span<const std::byte> bytes) {
+            return deserialize_from(std::string_view(reinterpret_cast<const char*>(bytes.data()), bytes.size()));
+        }
+
+        /**
+         * @brief Appends a checkpoint of the complete config state to `buffer`, for `restore()` after a restart.
+         *
+         * Besides the current content, a checkpoint holds the baseline that `reset()` and
+         * `SaveMode::CHANGES_SINCE_LOAD` compare against, the undo history and its limit, the
+         * state, root name, source path and layer files, and the root name, missing field and
+         * unknown key policies, under `io::content_fingerprint<T>()`. Snapshots shared between
+         * them, such as an unmodified baseline and the current content, are written once.
+         * Provenance, subscriptions, overrides and the other settings are not included. Like
+         * `serialize_to()`, the encoding is native-endian.
+         *
+         * @param buffer The string to append to.
+         *
+         * @par Examples
+         * @code
+         * cfg.save_checkpoint("run.ckpt", fourdst::config::SavePolicy::DURABLE);
+         * // after the restart, instead of loading the deck and replaying mutations:
+         * cfg.restore_checkpoint("run.ckpt");
+         * @endcode
+         */
+        void checkpoint(std::string& buffer) const {
+            std::vector<std::shared_ptr<const T>> snapshots;
+            std::vector<std::uint64_t> history;
+            std::uint64_t origin = 0;
+            std::uint64_t current = 0;
+            std::string root_name;
+            std::string source_path;
+            std::vector<std::string> layer_paths;
+            ConfigState state;
+            std::uint64_t history_limit;
+            {
+                const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+                // Snapshots are immutable, so they are indexed here and encoded after the lock is released.
+                const auto index_of = [&snapshots](std::shared_ptr<const T> snapshot) -> std::uint64_t {
+                    const auto it = std::ranges::find(snapshots, snapshot);
+                    if (it != snapshots.end()) return static_cast<std::uint64_t>(it - snapshots.begin());
+                    snapshots.push_back(std::move(snapshot));
+                    return snapshots.size() - 1;
+                };
+                origin = index_of(m_origin);
+                current = index_of(snapshot());
+                for (const auto& step : m_history) history.push_back(index_of(step));
+                root_name = m_root_name;
+                source_path = m_source_path;
+                layer_paths = m_layer_paths;
+                state = m_state;
+                history_limit = m_history_limit;
+            }
+
+            io::BinaryWriter writer(buffer);
+            writer.write(checkpoint_magic);
+            writer.write(io::content_fingerprint<T>());
+            writer.write(std::string_view(root_name));
+            writer.write(std::string_view(source_path));
+            writer.write(layer_paths);
+            writer.write(static_cast<std::uint8_t>(state));
+            writer.write(static_cast<std::uint8_t>(m_root_name_load_policy));
+            writer.write(static_cast<std::uint8_t>(m_missing_field_policy));
+            writer.write(static_cast<std::uint8_t>(m_unknown_key_policy));
+            writer.write(history_limit);
+            writer.write(static_cast<std::uint64_t>(snapshots.size()));
+            std::string encoded;
+            for (const auto& snapshot : snapshots) {
+                encoded.clear();
+                io::encode_content(encoded, *snapshot);
+                writer.write(std::string_view(encoded));
+            }
+            writer.write(origin);
+            writer.write(current);
+            writer.write(history);
+        }
+
+        /**
+         * @brief Replaces the complete config state with a checkpoint written by `checkpoint()`.
+         *
+         * Subscribers are notified if the current content changes. Provenance, when tracked,
+         * restarts with every field marked as read from a file.
+         *
+         * @param bytes The checkpoint, with nothing following it.
+         * @throws exceptions::ConfigLoadError If `bytes` is not a checkpoint, is truncated, or was written by a
+         *         binary with a different layout of `T`; the config is left unchanged.
+         */
+        void restore(const std::string_view bytes) {
+            io::BinaryReader reader(bytes);
+            std::uint32_t magic = 0;
+            std::uint64_t fingerprint = 0;
+            if (!reader.read(magic) || magic != checkpoint_magic || !reader.read(fingerprint)) {
+                throw exceptions::ConfigLoadError("Not a config checkpoint.");
+            }
+            if (fingerprint != io::content_fingerprint<T>()) {
+                throw exceptions::ConfigLoadError("The config checkpoint was written with a different layout of the schema.");
+            }
+            std::string root_name;
+            std::string source_path;
+            std::vector<std::string> layer_paths;
+            std::uint8_t state = 0;
+            std::uint8_t root_name_load_policy = 0;
+            std::uint8_t missing_field_policy = 0;
+            std::uint8_t unknown_key_policy = 0;
+            std::uint64_t history_limit = 0;
+            std::uint64_t count = 0;
+            const bool header = reader.read(root_name) && reader.read(source_path) && reader.read(layer_paths) &&
+                                reader.read(state) && reader.read(root_name_load_policy) && reader.read(missing_field_policy) &&
+                                reader.read(unknown_key_policy) && reader.read(history_limit) && reader.read(count);
+            // Every snapshot takes at least its length prefix, which bounds the count by the input size.
+            if (!header || state > static_cast<std::uint8_t>(ConfigState::MODIFIED) ||
+                root_name_load_policy > static_cast<std::uint8_t>(RootNameLoadPolicy::KEEP_CURRENT) ||
+                missing_field_policy > static_cast<std::uint8_t>(MissingFieldPolicy::USE_DEFAULTS) ||
+                unknown_key_policy > static_cast<std::uint8_t>(UnknownKeyPolicy::REJECT) || count == 0 ||
+                count > reader.remaining()) {
+                throw exceptions::ConfigLoadError("The config checkpoint is truncated or corrupt.");
+            }
+            std::vector<std::shared_ptr<const T>> snapshots;
+            snapshots.reserve(count);
+            std::string encoded;
+            for (std::uint64_t i = 0; i < count; ++i) {
+                T content{};
+                if (!reader.read(encoded) || !io::decode_content(encoded, content)) {
+                    throw exceptions::ConfigLoadError("The config checkpoint is truncated or corrupt.");
+                }
+                snapshots.push_back(std::make_shared<const T>(std::move(content)));
+            }
+            std::uint64_t origin = 0;
+            std::uint64_t current = 0;
+            std::vector<std::uint64_t> history;
+            if (!reader.read(origin) || !reader.read(current) || !reader.read(history) || reader.remaining() != 0 ||
+                origin >= count || current >= count ||
+                std::ranges::any_of(history, [count](const std::uint64_t index) { return index >= count; })) {
+                throw exceptions::ConfigLoadError("The config checkpoint is truncated or corrupt.");
+            }
+
+            auto provenance = fresh_provenance();
+            if (provenance) {
+                provenance->mark_all({FieldSource::FILE, 0});
+            }
+            std::shared_ptr<const T> previous;
+            bool changed;
+            {
+                const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+                changed = !detail::equal(*snapshots[current], m_content);
+                m_content = *snapshots[current];
+                m_origin = snapshots[origin];
+                m_root_name = std::move(root_name);
+                m_source_path = std::move(source_path);
+                m_layer_paths = std::move(layer_paths);
+                m_layer_directory.clear();
+                m_parsed_layers.clear();
+                m_state = static_cast<ConfigState>(state);
+                m_root_name_load_policy = static_cast<RootNameLoadPolicy>(root_name_load_policy);
+                m_missing_field_policy = static_cast<MissingFieldPolicy>(missing_field_policy);
+                m_unknown_key_policy = static_cast<UnknownKeyPolicy>(unknown_key_policy);
+                m_source_stamps.clear();
+                m_last_document.reset();
+                m_strings.reset();
+                install_provenance(std::move(provenance));
+                clear_history();
+                m_history_limit = history_limit;
+                for (const std::uint64_t index : history) {
+                    m_history.push_back(snapshots[index]);
+                    m_provenance_history.push_back(nullptr);
+                }
+                previous = swap_snapshot(snapshots[current]);
+            }
+            forget_source();
+            if (changed) {
+                notify(previous);
+            }
+        }
+
+        /**
+         * @brief Writes a checkpoint (see `checkpoint()`) to `path`.
+         * @param path The file to write.
+         * @param policy How the file is written (IN_PLACE, ATOMIC or DURABLE).
+         * @throws exceptions::ConfigSaveError If the file cannot be written.
+         */
+        void save_checkpoint(const std::string_view path, const SavePolicy policy = SavePolicy::ATOMIC) const {
+            std::string buffer;
+            checkpoint(buffer);
+            if (policy == SavePolicy::IN_PLACE) {
+                io::FileSink sink{std::string(path)};
+                sink.write(buffer);
+                sink.close();
+            } else {
+                io::AtomicFileSink sink{std::string(path), policy == SavePolicy::DURABLE};
+                sink.write(buffer);
+                sink.commit();
+            }
+        }
+
+        /**
+         * @brief Restores the checkpoint in the file `path` with one read; see `restore()`.
+         * @throws exceptions::ConfigLoadError If the file cannot be read or is not a valid checkpoint.
+         */
+        void restore_checkpoint(const std::string_view path) {
+            const io::MappedFile mapped = map_source(path, FileReadPolicy::SINGLE_READ);
+            restore(mapped.view());
+        }
+
+        /**
+         * @brief Sets the root name/key used in the TOML file.
+         *
+         * The default root name is "main". This name appears as the top-level table in the TOML file (e.g., `[main]`).
+         *
+         * @param name The new root name.
+         */
+        void set_root_name(const std::string_view name) {
+            m_root_name = name;
+        }
+
+        /**
+         * @brief Gets the current root name.
+         * @return The root name string view.
+         */
+        [[nodiscard]] std::string_view get_root_name() const {
+            return m_root_name;
+        }
+
+        /**
+         * @brief Sets the policy for handling root name mismatches during load.
+         * @param policy The policy (FROM_FILE or KEEP_CURRENT).
+         */
+        void set_root_name_load_policy(const RootNameLoadPolicy policy) {
+            m_root_name_load_policy = policy;
+        }
+
+        /**
+         * @brief Gets the current root name load policy.
+         * @return The current policy.
+         */
+        [[nodiscard]] RootNameLoadPolicy get_root_name_load_policy() const {
+            return m_root_name_load_policy;
+        }
+
+        /**
+         * @brief Returns a string description of the current root name load policy.
+         * @return "FROM_FILE", "KEEP_CURRENT", or "UNKNOWN".
+         */
+        [[nodiscard]] std::string describe_root_name_load_policy() const {
+            switch (m_root_name_load_policy) {
+                case RootNameLoadPolicy::FROM_FILE:
+                    return "FROM_FILE";
+                case RootNameLoadPolicy::KEEP_CURRENT:
+                    return "KEEP_CURRENT";
+                default:
+                    return "UNKNOWN";
+            }
+        }
+
+        /**
+         * @brief Sets how configuration files are read during load.
+         *
+         * `SINGLE_READ` and `DIRECT` suit large decks on parallel file systems, where many small
+         * buffered reads turn into many small RPCs; `DIRECT` also keeps a deck read once from
+         * evicting other data from the page cache.
+         *
+         * `STREAMING` bounds the memory of a load by the content itself, for decks of several
+         * gigabytes: the TOML is read in chunks and each value is written straight into its field.
+         * It applies to uncompressed TOML files loaded with caching, provenance, expressions and a
+         * memory resource off, into schemas without versioning whose fields `io::is_event_readable_v`
+         * accepts; other loads read the file as under `MEMORY_MAP`. Fragment includes and sidecar
+         * references are not resolved, and fail the load.
+         *
+         * @param policy The policy (BUFFERED, MEMORY_MAP, SINGLE_READ, DIRECT or STREAMING).
+         */
+        void set_file_read_policy(const FileReadPolicy policy) {
+            m_file_read_policy = policy;
+        }
+
+        /**
+         * @brief Gets the current file read policy.
+         * @return The current policy.
+         */
+        [[nodiscard]] FileReadPolicy get_file_read_policy() const {
+            return m_file_read_policy;
+        }
+
+        /**
+         * @brief Sets bounds on the size and shape of the documents loads accept (see `limits.h`).
+         *
+         * Every load, reload and `load_from()` then checks the file size before reading it and the
+         * array lengths, nesting depth and estimated parse tree size in one pass over the text
+         * before toml++ or yyjson builds the tree, so a runaway generated deck fails with a
+         * `ConfigParseError` naming the offending line instead of exhausting memory. Decompressed
+         * documents are bounded by `max_file_bytes` as well. Namelist files, files under
+         * `FileReadPolicy::STREAMING` (which builds no tree) and files read from the binary cache
+         * are checked for size only; fragments pulled in with `__include` are not checked. Nothing
+         * is checked while all bounds are 0, the default.
+         *
+         * @param limits The bounds; 0 leaves one off.
+         */
+        void set_parse_limits(const ParseLimits& limits) {
+            m_parse_limits = limits;
+        }
+
+        /**
+         * @brief Gets the bounds loads enforce.
+         * @return The bounds; all 0 when none are set.
+         */
+        [[nodiscard]] ParseLimits get_parse_limits() const {
+            return m_parse_limits;
+        }
+
+        /**
+         * @brief Returns a string description of the current file read policy.
+         * @return "BUFFERED", "MEMORY_MAP", or "UNKNOWN".
+         */
+        [[nodiscard]] std::string describe_file_read_policy() const {
+            switch (m_file_read_policy) {
+                case FileReadPolicy::BUFFERED:
+                    return "BUFFERED";
+                case FileReadPolicy::MEMORY_MAP:
+                    return "MEMORY_MAP";
+                case FileReadPolicy::SINGLE_READ:
+                    return "SINGLE_READ";
+                case FileReadPolicy::DIRECT:
+                    return "DIRECT";
+                case FileReadPolicy::STREAMING:
+                    return "STREAMING";
+                default:
+                    return "UNKNOWN";
+            }
+        }
+
+        /**
+         * @brief Sets the compression level `save()` uses for `.zst` and `.gz` paths.
+         *
+         * zstd accepts 1 to 22 (and negative levels for faster, weaker compression), gzip 1 to 9.
+         * Higher levels trade save time for smaller files; decompression speed barely changes.
+         *
+         * @param level The level, or 0 for the library default (zstd 3, gzip 6).
+         */
+        void set_compression_level(const int level) {
+            m_compression_level = level;
+        }
+
+        /**
+         * @brief Gets the compression level used when saving compressed files.
+         * @return The level; 0 means the library default.
+         */
+        [[nodiscard]] int get_compression_level() const {
+            return m_compression_level;
+        }
+
+        /**
+         * @brief Sets whether `save()` skips writing a file that already holds what it would write.
+         *
+         * When enabled, each `save()` hashes the published content together with the root name,
+         * the save mode and the format settings, and compares that with the last save to the same
+         * path by this config. If they match and the file still has the size and modification
+         * time that save left, nothing is serialized or written, so checkpoints of a config that
+         * has not changed since do not touch the file or wake watchers of it. A file written or
+         * removed by anything else is rewritten. `save_async()` always writes.
+         *
+         * @param enabled True to skip unchanged saves; false (the default) to always write.
+         */
+        void set_skip_unchanged_saves(const bool enabled) {
+            m_skip_unchanged_saves = enabled;
+            if (!enabled) {
+                std::lock_guard lock(m_sync->saved_mutex);
+                m_sync->saved.clear();
+            }
+        }
+
+        /**
+         * @brief Gets whether `save()` skips writing unchanged files.
+         */
+        [[nodiscard]] bool get_skip_unchanged_saves() const {
+            return m_skip_unchanged_saves;
+        }
+
+        /**
+         * @brief Sets whether `reload()` re-reads only the tables of the file that changed.
+         *
+         * When enabled, loads of a TOML file keep its parsed document. A later `reload()` of the
+         * same file compares the new document against it and deserializes only the values that
+         * differ, patching them into the current content; unchanged members are kept as they are.
+         * Files that cannot be patched (a field was removed, or a changed value does not match its
+         * field) are read in full as usual.
+         *
+         * The kept document costs memory, and the file cache and the fast path for large numeric
+         * arrays are not used, so this pays off for large files edited a few values at a time. It
+         * has no effect on layered loads, compressed or JSON files, files with sidecar references,
+         * or while provenance tracking, a memory resource or string interning is in use.
+         *
+         * @param enabled True to patch changed tables in place on reload.
+         */
+        void set_incremental_reload(const bool enabled) {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            m_incremental_reload = enabled;
+            if (!enabled) m_last_document.reset();
+        }
+
+        /**
+         * @brief Gets whether `reload()` re-reads only the tables that changed.
+         * @return True if incremental reload is enabled.
+         */
+        [[nodiscard]] bool get_incremental_reload() const {
+            return m_incremental_reload;
+        }
+
+        /**
+         * @brief Sets whether `save()` back to the loaded TOML file rewrites only the values that changed.
+         *
+         * When enabled, a load of an uncompressed TOML file also records where the text of each
+         * value lies in it (see `splice.h`). A later `save(path, policy)` to that same file compares
+         * the content with what the file holds and replaces only the text of the changed values, so
+         * comments, key order and number formatting survive and a one-value edit of a large deck
+         * costs one small write. Under `SavePolicy::IN_PLACE` values whose new text has the same
+         * length are overwritten where they are; otherwise the file is copied once with the new text
+         * spliced in, through a temporary file under `ATOMIC` and `DURABLE`.
+         *
+         * The save is written in full, as usual, when the file changed since it was loaded or last
+         * saved, when a change cannot be expressed as new text for an existing value (an optional
+         * was set or cleared, a map or an array of tables changed, or the value came from an
+         * included file), or when the content differs from the file text by more than edits:
+         * environment variables, overrides, expressions and versioned schemas. A full save to the
+         * file ends format-preserving saves to it until it is loaded again. A save with no changes
+         * leaves the file untouched. Loads have the same restrictions as `set_incremental_reload()`.
+         *
+         * @param enabled True to splice changed values into the loaded file on save.
+         */
+        void set_format_preserving_saves(const bool enabled) {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            m_format_preserving_saves = enabled;
+            if (!enabled) forget_edits();
+        }
+
+        /**
+         * @brief Gets whether `save()` rewrites only the changed values of the loaded file.
+         * @return True if format-preserving saves are enabled.
+         */
+        [[nodiscard]] bool get_format_preserving_saves() const {
+            return m_format_preserving_saves;
+        }
+
+        /**
+         * @brief Sets whether `reload()` reuses the storage of the content and snapshot it replaces.
+         *
+         * A reload normally deserializes into a new `T`, frees the old content and copies the new
+         * one into a new snapshot, so every large vector is freed and allocated again even when
+         * the deck keeps its shape. When enabled, the content a reload replaces is kept and the
+         * next reload reads into it in place, and the snapshot it retires is kept and, once no
+         * reader holds it any more, the next publication copies into it by assignment. Vectors
+         * and strings keep their capacity throughout, so steady-state reloads of a deck of
+         * unchanged shape allocate next to nothing.
+         *
+         * Reading in place needs the streaming reader: combine with `FileReadPolicy::STREAMING`
+         * (whose conditions apply; see `set_file_read_policy()`). Otherwise only the snapshot
+         * storage is recycled. Snapshots held by `pin()`, `ConfigReader` caches, subscribers or
+         * NUMA replicas are never recycled while held. Schemas with string views are not recycled.
+         *
+         * @param enabled True to recycle content and snapshot storage across reloads.
+         */
+        void set_reload_recycling(const bool enabled) {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            m_reload_recycling = enabled;
+            if (!enabled) {
+                m_spare.reset();
+                m_retired.reset();
+            }
+        }
+
+        /**
+         * @brief Gets whether `reload()` reuses the storage of the content and snapshot it replaces.
+         * @return True if reload recycling is enabled.
+         */
+        [[nodiscard]] bool get_reload_recycling() const {
+            return m_reload_recycling;
+        }
+
+        /**
+         * @brief Sets whether loaded content is compacted and snapshots keep their `std::pmr` members in one arena.
+         *
+         * When enabled, every load and reload trims the slack capacity of the strings and vectors
+         * of the content, and every published snapshot moves its `std::pmr::string` and
+         * `std::pmr::vector` members into a single arena it owns (see `compact.h`). This lowers
+         * the resident size and improves locality of read-mostly configs at the cost of one more
+         * walk over the content per publication. Published snapshots are then never recycled
+         * (see `set_reload_recycling()`). Schemas with string views are not compacted into an arena.
+         *
+         * @param enabled True to compact loaded content and snapshots.
+         */
+        void set_compaction(const bool enabled) {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            m_compaction = enabled;
+        }
+
+        /**
+         * @brief Gets whether loaded content and snapshots are compacted.
+         * @return True if compaction is enabled.
+         */
+        [[nodiscard]] bool get_compaction() const {
+            return m_compaction;
+        }
+
+        /**
+         * @brief Sets what happens to fields a loaded TOML file does not contain.
+         *
+         * With `MissingFieldPolicy::USE_DEFAULTS` the root table of the file is merged over the
+         * fields of a default-constructed `T` before it is deserialized, so a file written with
+         * `SaveMode::NON_DEFAULT_ONLY` (or any hand-written partial deck) loads with every field
+         * it leaves out at its default. Provenance still reports those fields as defaults. JSON
+         * files are always read in full.
+         *
+         * @param policy `REJECT` (the default) to fail on missing required fields, or `USE_DEFAULTS`.
+         */
+        void set_missing_field_policy(const MissingFieldPolicy policy) {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            m_missing_field_policy = policy;
+        }
+
+        /**
+         * @brief Gets what happens to fields a loaded TOML file does not contain.
+         * @return The current missing field policy.
+         */
+        [[nodiscard]] MissingFieldPolicy get_missing_field_policy() const {
+            return m_missing_field_policy;
+        }
+
+        /**
+         * @brief Sets whether keys that name no field of the schema fail a TOML load.
+         *
+         * Unknown keys already fail a load that fails for another reason, but a file that is
+         * otherwise valid (for instance a misspelled key of a field filled from the defaults)
+         * loads with the key ignored. Under `UnknownKeyPolicy::REJECT` every table of the file is
+         * also checked against the sorted field names of its struct, after deserialization, and
+         * the load fails listing every unknown key with the nearest field name. The check reads
+         * keys only and allocates nothing when all keys are known.
+         *
+         * @param policy `ALLOW` (the default) or `REJECT`.
+         */
+        void set_unknown_key_policy(const UnknownKeyPolicy policy) {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            m_unknown_key_policy = policy;
+        }
+
+        /**
+         * @brief Gets whether keys that name no field of the schema fail a TOML load.
+         * @return The current unknown key policy.
+         */
+        [[nodiscard]] UnknownKeyPolicy get_unknown_key_policy() const {
+            return m_unknown_key_policy;
+        }
+
+        /**
+         * @brief Sets how a TOML load treats keys that are old names of renamed fields.
+         *
+         * Old names declared with `field_aliases` (see aliases.h) are always read. Under `WARN` and
+         * `REJECT` the keys of every loaded file are also walked once after deserialization, and
+         * each old name still in use is listed with the path it was renamed to: on stderr, or in
+         * the error that fails the load. Under `ALLOW` (the default) no walk is done.
+         *
+         * @param policy `ALLOW`, `WARN` or `REJECT`.
+         */
+        void set_deprecated_key_policy(const DeprecatedKeyPolicy policy) {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            m_deprecated_key_policy = policy;
+        }
+
+        /**
+         * @brief Gets how a TOML load treats keys that are old names of renamed fields.
+         * @return The current deprecated key policy.
+         */
+        [[nodiscard]] DeprecatedKeyPolicy get_deprecated_key_policy() const {
+            return m_deprecated_key_policy;
+        }
+
+        /**
+         * @brief Sets how a failed load validates the file to report its problems.
+         *
+         * Arrays of tables with at least `options.parallel_threshold` elements are validated on
+         * up to `options.max_threads` threads, which keeps failure reports on decks with tens of
+         * thousands of tables fast. Successful loads never run the validator.
+         *
+         * @param options The validation options.
+         */
+        void set_validation_options(const validate::ValidationOptions& options) {
+            m_validation_options = options;
+        }
+
+        /**
+         * @brief Gets the current validation options.
+         * @return The current options.
+         */
+        [[nodiscard]] const validate::ValidationOptions& get_validation_options() const {
+            return m_validation_options;
+        }
+
+        /**
+         * @brief Enables or disables parallel deserialization of large arrays of tables.
+         *
+         * With options set, a TOML load reads each `std::vector` of structs with at least
+         * `options->parallel_threshold` elements on up to `options->max_threads` threads, into a
+         * pre-sized vector; errors are reported as for a serial read. Parallel reading is off by
+         * default, and is never used for schemas with `std::string_view` fields or while a memory
+         * resource is set (see `set_memory_resource()`).
+         *
+         * @param options The options, or `std::nullopt` (the default) to read serially.
+         */
+        void set_parallel_read(const std::optional<io::ParallelReadOptions>& options) {
+            m_parallel_read = options;
+        }
+
+        /**
+         * @brief Gets the parallel read options, or `std::nullopt` if loads read serially.
+         * @return The current options.
+         */
+        [[nodiscard]] const std::optional<io::ParallelReadOptions>& get_parallel_read() const {
+            return m_parallel_read;
+        }
+
+        /**
+         * @brief Sets the shards that loads keep of every `Sharded` field.
+         *
+         * With a selector set, a load deserializes only the entries of `Sharded` fields whose keys
+         * it lists (typically the local rank), and from shard files written by `save()` reads only
+         * the byte ranges of those entries. Such fields report `is_partial()`, and saving them
+         * throws. Loads with a selector never use the binary cache or incremental reload.
+         *
+         * @param keys The keys to keep, or `std::nullopt` (the default) to keep every shard.
+         */
+        void set_shard_selector(std::optional<io::ShardSelector> keys) {
+            m_shard_selector = std::move(keys);
+        }
+
+        /**
+         * @brief Gets the shard selector, or `std::nullopt` if loads keep every shard.
+         * @return The current selector.
+         */
+        [[nodiscard]] const std::optional<io::ShardSelector>& get_shard_selector() const {
+            return m_shard_selector;
+        }
+
+        /**
+         * @brief Registers the target that loads stream the elements of the `Sink<V>` field at `path` to.
+         *
+         * Every later load, reload and `load_from()` binds the field to `target`: its array is parsed
+         * into the memory the target hands out, or passed to it in chunks (see sink.h). Loads with
+         * sinks registered never use the binary cache, the load daemon or incremental reload.
+         *
+         * @param path Dotted path of a `Sink<V>` field.
+         * @param target Where the elements go, e.g. `sink_into(buffer)` or `sink_chunks(callback)`.
+         * @throws exceptions::ConfigPathError If `path` does not name a `Sink<V>` field.
+         *
+         * @par Examples
+         * @code
+         * std::vector<double, PinnedAllocator<double>> kappa(n);
+         * cfg.set_sink<double>("opacity.kappa", fourdst::config::sink_into(std::span<double>(kappa)));
+         * cfg.load("opacity.toml");
+         * @endcode
+         */
+        template <typename V>
+        void set_sink(const std::string_view path, SinkTarget<V> target) {
+            using Table = detail::PathTable<T>;
+            const std::size_t index = Table::find(path);
+            if (index == Table::npos || Table::entry(index).type != detail::path_type_id<Sink<V>>()) {
+                throw exceptions::ConfigPathError(std::format("Cannot register a sink at '{}': not a Sink field of this element type.", path));
+            }
+            auto shared = std::make_shared<const SinkTarget<V>>(std::move(target));
+            m_sinks.insert_or_assign(std::string(path), [shared, field = std::string(path)](T& content) {
+                detail::visit_at(content, field, [&](auto& value) {
+                    if constexpr (std::is_same_v<std::remove_cvref_t<decltype(value)>, Sink<V>>) value.bind(shared);
+                });
+            });
+        }
+
+        /**
+         * @brief Unregisters every sink target; later loads keep the elements of `Sink` fields in the fields.
+         */
+        void clear_sinks() {
+            m_sinks.clear();
+        }
+
+        /**
+         * @brief Sets the subtrees that loads read from the file; every other field keeps its default.
+         *
+         * Tools that need a few tables of a large run deck (post-processing reading `output`) can
+         * leave the rest unread. The file is still parsed, but numeric arrays outside the projection
+         * are skipped by the scanner instead of parsed, and the values outside it are neither
+         * deserialized, validated nor checked for unknown keys, and their sidecar, columnar and
+         * shard files are not opened. Each projected subtree is read as a whole under the missing
+         * field policy. Expressions in it see the defaults of fields outside it.
+         *
+         * The content of a projected load is not the deck, so saving it writes defaults for the
+         * unread fields. Projected loads never use the binary cache, the load daemon or
+         * incremental reload, and are for TOML and namelist files; a JSON file is rejected.
+         *
+         * @param paths Dotted field paths (e.g. `"output"`, `"simulation.time_step"`), or empty (the default) to read every field.
+         * @throws exceptions::ConfigPathError If a path does not name a field of the schema.
+         *
+         * @par Examples
+         * @code
+         * cfg.set_projection({"output", "simulation.time_step"});
+         * cfg.load("run.toml");
+         * @endcode
+         */
+        void set_projection(std::vector<std::string> paths) {
+            for (const std::string& path : paths) {
+                if (detail::PathTable<T>::find(path) == detail::PathTable<T>::npos) {
+                    throw exceptions::ConfigPathError(std::format("Cannot project load onto '{}': not a field path of the configuration schema.", path));
+                }
+            }
+            // A path inside another projected subtree is read with it.
+            std::ranges::sort(paths);
+            std::vector<std::string> outermost;
+            for (std::string& path : paths) {
+                if (!outermost.empty() && (path == outermost.back() || path.starts_with(outermost.back() + '.'))) continue;
+                outermost.push_back(std::move(path));
+            }
+            m_projection = std::move(outermost);
+        }
+
+        /**
+         * @brief Gets the projected subtrees of loads, or an empty list if loads read every field.
+         * @return The outermost projected paths, sorted.
+         */
+        [[nodiscard]] const std::vector<std::string>& get_projection() const {
+            return m_projection;
+        }
+
+        /**
+         * @brief Sets whether loading uses a binary cache file next to the TOML source.
+         *
+         * The cache lives at `<path>.cache` and stores the parsed content together with a hash of
+         * the source file and a fingerprint of the schema. A warm load hashes the source and
+         * decodes the cache instead of parsing TOML; if the source or schema has changed, the file
+         * is parsed as usual (and, under `READ_WRITE`, the cache is refreshed). Failing to write
+         * the cache is not an error.
+         *
+         * @param policy The policy (DISABLED, READ_WRITE or READ_ONLY).
+         */
+        void set_cache_policy(const CachePolicy policy) {
+            m_cache_policy = policy;
+        }
+
+        /**
+         * @brief Gets the current cache policy.
+         * @return The current policy.
+         */
+        [[nodiscard]] CachePolicy get_cache_policy() const {
+            return m_cache_policy;
+        }
+
+        /**
+         * @brief Returns a string description of the current cache policy.
+         * @return "DISABLED", "READ_WRITE", "READ_ONLY", or "UNKNOWN".
+         */
+        [[nodiscard]] std::string describe_cache_policy() const {
+            switch (m_cache_policy) {
+                case CachePolicy::DISABLED:
+                    return "DISABLED";
+                case CachePolicy::READ_WRITE:
+                    return "READ_WRITE";
+                case CachePolicy::READ_ONLY:
+                    return "READ_ONLY";
+                default:
+                    return "UNKNOWN";
+            }
+        }
+
+        /**
+         * @brief Sets the socket of the node-local `ConfigDaemon` that loads ask before parsing.
+         *
+         * A load of a self-contained deck first asks the daemon for the content parsed from the
+         * same bytes under the same schema, by any job on the node; on a miss it parses the deck
+         * and hands the content to the daemon. A daemon that is not running is a miss, never an
+         * error. Used alongside `set_cache_policy()`: the daemon is asked before the cache file.
+         *
+         * @param socket The daemon's Unix socket; empty turns the daemon off. Defaults to the
+         *        `FOURDST_CONFIG_DAEMON` environment variable (see daemon.h).
+         */
+        void set_load_daemon(std::string socket) {
+            m_load_daemon = std::move(socket);
+        }
+
+        /**
+         * @brief Gets the socket of the load daemon, or an empty string if loads do not use one.
+         */
+        [[nodiscard]] const std::string& get_load_daemon() const {
+            return m_load_daemon;
+        }
+
+        /**
+         * @brief Sets the memory resource that `std::pmr` fields of loaded content are allocated from.
+         *
+         * Schemas may use `std::pmr::string` and `std::pmr::vector` members (see `pmr.h`). While
+         * `load()`, `reload()`, `load_layers()` or `load_from()` deserializes a file, those members
+         * allocate from `resource`, so the loaded content can live in a caller-provided arena such
+         * as a `std::pmr::monotonic_buffer_resource`. The resource must outlive the content. Copies,
+         * including the snapshots returned by `snapshot()`, follow the usual `std::pmr` rules and
+         * use the default resource. The binary cache is not read while a resource is set, since it
+         * decodes into default-allocated fields.
+         *
+         * @param resource The resource, or null (the default) for `std::pmr::get_default_resource()`.
+         */
+        void set_memory_resource(std::pmr::memory_resource* resource) {
+            m_memory_resource = resource;
+        }
+
+        /**
+         * @brief Gets the memory resource set with `set_memory_resource()`, or null if none is set.
+         * @return The resource.
+         */
+        [[nodiscard]] std::pmr::memory_resource* get_memory_resource() const {
+            return m_memory_resource;
+        }
+
+        /**
+         * @brief Sets whether loads intern the values of `std::string_view` fields.
+         *
+         * With interning, every distinct string read into a `std::string_view` field is stored
+         * once, and equal values (the same unit or species name repeated across an array of
+         * tables, for example) share one view. Interned values can be compared by `data()` pointer
+         * within one load. Takes effect from the next load; fields of other string types are not affected.
+         *
+         * @param interning Whether to intern string views (off by default).
+         */
+        void set_string_interning(const bool interning) {
+            m_string_interning = interning;
+        }
+
+        /**
+         * @brief Gets whether loads intern the values of `std::string_view` fields.
+         * @return True if interning is enabled.
+         */
+        [[nodiscard]] bool get_string_interning() const {
+            return m_string_interning;
+        }
+
+        /**
+         * @brief Sets whether loads evaluate expressions given for numeric fields.
+         *
+         * When enabled, a numeric field of a TOML document may hold a string such as
+         * `"100 * ${simulation.time_step}"`; it is evaluated once, before the document is
+         * deserialized, and the field receives the result (see `expression.h`). Expressions that
+         * cannot be evaluated are reported with the other problems of the failed load. Takes effect
+         * from the next load; incremental reloads read the whole file while enabled, since a changed
+         * field may be referenced from unchanged ones.
+         *
+         * @param enabled Whether to evaluate expressions (off by default).
+         */
+        void set_expressions(const bool enabled) {
+            m_expressions = enabled;
+        }
+
+        /**
+         * @brief Gets whether loads evaluate expressions given for numeric fields.
+         * @return True if expressions are enabled.
+         */
+        [[nodiscard]] bool get_expressions() const {
+            return m_expressions;
+        }
+
+        /**
+         * @brief Sets whether `mutate()` and `transaction()` re-check the constraints of the fields they change.
+         *
+         * The mutated content is compared with the published snapshot along the `rfl::Validator`
+         * fields of `T` only, and the constraints of those that changed are checked before
+         * publishing; a violation rolls the mutation back and throws `ConfigValidationError`.
+         * The cost is proportional to the number of constrained fields and changes, and is zero
+         * for schemas without constraints (see `constraints.h`).
+         *
+         * @param enabled Whether to check mutations (on by default).
+         */
+        void set_mutation_validation(const bool enabled) {
+            m_mutation_validation = enabled;
+        }
+
+        /**
+         * @brief Gets whether mutations re-check the constraints of the fields they change.
+         * @return True if mutation validation is enabled.
+         */
+        [[nodiscard]] bool get_mutation_validation() const {
+            return m_mutation_validation;
+        }
+
+        /**
+         * @brief Sets whether published snapshots are replicated on every NUMA node.
+         *
+         * When enabled, every snapshot published by `load()`, `mutate()`, `undo()` or `reset()` is
+         * also copied once per NUMA node, by a thread pinned to that node so the copy's memory is
+         * allocated there, and `ConfigReader` handles read the copy local to the calling thread.
+         * This trades one copy of `T` per node and slower publishing for reads that never cross
+         * the socket interconnect. `Config::snapshot()` still returns the primary snapshot.
+         *
+         * Enabling replicates the current snapshot immediately. On a machine with a single node
+         * (or where the topology cannot be read; see `numa.h`) no replicas are made.
+         *
+         * @param replicate Whether to replicate snapshots (off by default).
+         */
+        void set_numa_replication(const bool replicate) {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            m_numa_replication = replicate;
+            if (replicate) {
+                replicate_snapshot(m_sync->snapshot.load(std::memory_order_acquire));
+            } else {
+                m_sync->replicas.store(nullptr, std::memory_order_release);
+            }
+            m_sync->version.fetch_add(1, std::memory_order_release);
+        }
+
+        /**
+         * @brief Gets whether published snapshots are replicated on every NUMA node.
+         * @return True if replication is enabled.
+         */
+        [[nodiscard]] bool get_numa_replication() const {
+            return m_numa_replication;
+        }
+
+        /**
+         * @brief Sets whether published snapshots are prefaulted, or locked in memory, before readers see them.
+         *
+         * From the next publication on, every snapshot (and every NUMA replica) has its pages
+         * touched, or `mlock`ed, on the publishing thread before it is published, so the first
+         * reads of a new snapshot cost what later ones do. Set it before `load()` to cover the
+         * first snapshot too. See `resident.h`.
+         *
+         * @param residency `PREFAULT` or `LOCKED`; `DEFAULT` (the default) turns it off.
+         * @throws exceptions::ConfigError If `LOCKED` is asked for and the current snapshot cannot be locked, e.g. because of `RLIMIT_MEMLOCK`.
+         */
+        void set_residency(const Residency residency) {
+            if (residency == Residency::LOCKED) {
+                const detail::PageRanges pages = detail::snapshot_pages(*snapshot());
+                if (!pages.lock()) {
+                    const int error = errno;
+                    throw exceptions::ConfigError(std::format(
+                        "Cannot lock config snapshots in memory ({} bytes): {}. Raise RLIMIT_MEMLOCK or use Residency::PREFAULT.",
+                        pages.bytes(), std::strerror(error)));
+                }
+                pages.unlock();
+            }
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            m_residency = residency;
+        }
+
+        /**
+         * @brief Gets what is done to the memory of snapshots before they are published.
+         * @return The residency set with `set_residency()`.
+         */
+        [[nodiscard]] Residency get_residency() const {
+            return m_residency;
+        }
+
+        /**
+         * @brief Enables or disables counting acquisitions, waits and hold times of the content lock.
+         *
+         * Every writer (`mutate()`, `reset()`, `undo()`, `load()`, the setters) takes the content
+         * lock; readers of snapshots never do. While enabled, each acquisition costs two clock
+         * reads; while disabled, one relaxed load. Counts survive disabling and are cleared with
+         * `reset_lock_stats()`.
+         *
+         * @param enabled Whether to record lock statistics (off by default).
+         */
+        void set_lock_stats(const bool enabled) {
+            m_sync->lock_counters.enable(enabled);
+        }
+
+        /**
+         * @brief Records every later `mutate()`, `transaction()` and `set()` in `log`; see `audit.h`.
+         *
+         * The changed fields are found after the content lock is released, so auditing adds no time
+         * under the lock; the record is pushed without locking. Loads, reloads, `undo()` and
+         * `reset()` are not recorded.
+         *
+         * @param log The log to push to, or null (the default) to stop auditing.
+         */
+        void set_audit_log(std::shared_ptr<AuditLog> log) {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            m_audit_log = std::move(log);
+        }
+
+        /**
+         * @brief Returns the audit log set with `set_audit_log()`, or null.
+         */
+        [[nodiscard]] std::shared_ptr<AuditLog> get_audit_log() const {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            return m_audit_log;
+        }
+
+        /**
+         * @brief Returns the content lock statistics recorded so far; see `LockStats`.
+         */
+        [[nodiscard]] LockStats get_lock_stats() const {
+            return m_sync->lock_counters.get();
+        }
+
+        /**
+         * @brief Clears the content lock statistics.
+         */
+        void reset_lock_stats() {
+            m_sync->lock_counters.reset();
+        }
+
+        /**
+         * @brief Records load, reload and save durations, lock waits and snapshot gauges into `metrics`; see `metrics.h`.
+         *
+         * Attaching metrics enables lock statistics (`set_lock_stats(true)`), whose waits feed the
+         * lock wait histogram, and publishes the current snapshot to them.
+         *
+         * @param metrics The metrics to record into, or null (the default) to stop recording.
+         *
+         * @par Examples
+         * @code
+         * auto metrics = std::make_shared<fourdst::config::ConfigMetrics>("physics");
+         * cfg.set_metrics(metrics);
+         * cfg.load("physics.toml");
+         * std::array<char, 16 * 1024> buffer;
+         * const auto size = metrics->render(buffer);
+         * @endcode
+         */
+        void set_metrics(std::shared_ptr<ConfigMetrics> metrics) {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            m_sync->lock_counters.set_wait_histogram(metrics ? &metrics->lock_waits() : nullptr);
+            if (metrics) {
+                m_sync->lock_counters.enable(true);
+                metrics->publish(m_sync->snapshot.load(std::memory_order_acquire), m_sync->generation.load(std::memory_order_relaxed),
+                                 &snapshot_bytes);
+            }
+            m_sync->metrics.store(std::move(metrics), std::memory_order_release);
+        }
+
+        /**
+         * @brief Returns the metrics set with `set_metrics()`, or null.
+         */
+        [[nodiscard]] std::shared_ptr<ConfigMetrics> get_metrics() const {
+            return m_sync->metrics.load(std::memory_order_acquire);
+        }
+
+        /**
+         * @brief Sets the array length from which `save()` moves numeric arrays to sidecar files.
+         *
+         * A `std::vector` of integers or floating-point values with at least `threshold` elements
+         * is written to `<file>.<field path>.npy` next to the TOML file, in the NumPy `.npy`
+         * format, and the TOML holds a reference instead:
+         * `samples = { __sidecar = "run.toml.grid.samples.npy", length = 100000, checksum = "..." }`.
+         * Loading reads referenced sidecars with a single `memcpy` and checks their length and
+         * checksum. Only arrays reached through nested structs (not optionals, maps or arrays of
+         * tables) are moved, and only TOML saves of schemas `io::TomlWriter` can stream use sidecars.
+         *
+         * @param threshold The minimum length, or 0 (the default) to write every array inline.
+         */
+        void set_sidecar_threshold(const std::size_t threshold) {
+            m_sidecar_threshold = threshold;
+        }
+
+        /**
+         * @brief Gets the sidecar threshold; 0 means sidecars are disabled.
+         * @return The minimum array length written to a sidecar.
+         */
+        [[nodiscard]] std::size_t get_sidecar_threshold() const {
+            return m_sidecar_threshold;
+        }
+
+#if FOURDST_CONFIG_USE_ARROW
+        /**
+         * @brief Sets the row count from which `save()` moves arrays of tables to Arrow IPC files.
+         *
+         * A `std::vector` of flat structs (see `columnar.h`) with at least `threshold` rows is
+         * written to `<file>.<field path>.arrow` next to the TOML file, one column per field, and
+         * the TOML holds a reference instead:
+         * `reactions = { __columnar = "run.toml.reactions.arrow", rows = 40000, checksum = "..." }`.
+         * Loading maps the file and reads it column by column. As with sidecars, only arrays
+         * reached through nested structs are moved, and only TOML saves of streamable schemas
+         * use columnar files. Only available when built with Arrow support (the `use_arrow`
+         * meson option).
+         *
+         * @param threshold The minimum row count, or 0 (the default) to write every array of tables as sections.
+         */
+        void set_columnar_threshold(const std::size_t threshold) {
+            m_columnar_threshold = threshold;
+        }
+
+        /**
+         * @brief Gets the columnar threshold; 0 means columnar files are disabled.
+         * @return The minimum row count written to a columnar file.
+         */
+        [[nodiscard]] std::size_t get_columnar_threshold() const {
+            return m_columnar_threshold;
+        }
+#endif
+
+        /**
+         * @brief Sets the file format used by `load()`, `reload()` and `save()`.
+         *
+         * JSON files use the same layout as TOML ones: a top-level object whose members are root
+         * tables, e.g. `{"main": {"physics": {...}}}`. JSON is parsed with the yyjson parser that
+         * ships with reflect-cpp, which is considerably faster than TOML parsing for large,
+         * machine-generated decks. The binary cache (see `set_cache_policy()`) works for both.
+         *
+         * NAMELIST reads Fortran namelist files such as MESA inlists (see namelist.h): each group
+         * fills the top-level field of the same name, under the current root name. Namelists are
+         * read-only; saving in that format throws.
+         *
+         * @param format The format (AUTO, TOML, JSON or NAMELIST).
+         */
+        void set_file_format(const FileFormat format) {
+            m_file_format = format;
+        }
+
+        /**
+         * @brief Gets the current file format.
+         * @return The current format.
+         */
+        [[nodiscard]] FileFormat get_file_format() const {
+            return m_file_format;
+        }
+
+        /**
+         * @brief Returns a string description of the current file format.
+         * @return "AUTO", "TOML", "JSON", "NAMELIST", or "UNKNOWN".
+         */
+        [[nodiscard]] std::string describe_file_format() const {
+            switch (m_file_format) {
+                case FileFormat::AUTO:
+                    return "AUTO";
+                case FileFormat::TOML:
+                    return "TOML";
+                case FileFormat::JSON:
+                    return "JSON";
+                case FileFormat::NAMELIST:
+                    return "NAMELIST";
+                default:
+                    return "UNKNOWN";
+            }
+        }
+
+        /**
+         * @brief Loads configuration from a TOML or JSON file.
+         *
+         * Reads the file, parses it, and updates the internal configuration state.
+         * The format follows `set_file_format()` (by default, `.json` files are read as JSON).
+         * The file is read according to the current `FileReadPolicy` (see `set_file_read_policy()`),
+         * or decoded from its binary cache when the `CachePolicy` allows it (see `set_cache_policy()`).
+         * A config can only be loaded once; use `reload()` to pick up later changes to the file.
+         *
+         * The path `"-"` reads the deck from standard input instead (`generate | simulate --config -`),
+         * in large blocks into memory and without a temporary file; the format is chosen as in
+         * `load_from()`. `get_source_path()` then returns `"-"`, and only `reload("-")` reads again.
+         *
+         * A file staged by `prefetch()` is read from its node-local copy, which `get_source_path()`
+         * then returns (see prefetch.h).
+         *
+         * @param path The file path to read from, or `"-"` for standard input.
+         * @param verbose If true, a tree of missing fields is printed to stderr when the file does not match the schema.
+         * @throws exceptions::ConfigLoadError If the config is already loaded, file doesn't exist, or root name mismatch (under KEEP_CURRENT policy).
+         * @throws exceptions::ConfigParseError If the file content is invalid TOML/JSON or doesn't match the schema.
+         *
+         * @par Examples
+         * @code
+         * try {
+         *     cfg.load("config.toml");
+         * } catch (const fourdst::config::exceptions::ConfigError& e) {
+         *     std::cerr << "Error loading config: " << e.what() << std::endl;
+         * }
+         * @endcode
+         */
+        void load(const std::string_view path, const bool verbose = false);
+
+        /**
+         * @brief Loads configuration as `load(path, verbose)` does, recording where the time and memory went.
+         *
+         * `stats` is reset and then filled with the bytes read and the time spent reading, parsing,
+         * deserializing and validating (see `LoadStats`), and with allocation counts if a counting
+         * allocator is installed (see `stats.h`). It is filled as far as the load got if it throws.
+         *
+         * @param path The file path to read from.
+         * @param stats Receives the statistics of this load.
+         * @param verbose If true, a tree of missing fields is printed to stderr when the file does not match the schema.
+         * @throws exceptions::ConfigLoadError See `load()`.
+         * @throws exceptions::ConfigParseError See `load()`.
+         *
+         * @par Examples
+         * @code
+         * fourdst::config::LoadStats stats;
+         * cfg.load("config.toml", stats);
+         * std::cerr << "parsing took " << stats.parse_time << '\n';
+         * @endcode
+         */
+        void load(const std::string_view path, LoadStats& stats, const bool verbose = false) {
+            const io::ScopedLoadStats scope(stats);
+            load(path, verbose);
+        }
+
+        /**
+         * @brief Loads only the subtrees at `only` from a file; see `set_projection()`.
+         *
+         * The projection is kept for later reloads.
+         *
+         * @param path The file path to read from.
+         * @param only Dotted field paths to read; every other field keeps its default.
+         * @param verbose If true, a tree of missing fields is printed to stderr when the file does not match the schema.
+         * @throws exceptions::ConfigPathError If a path of `only` does not name a field of the schema.
+         * @throws exceptions::ConfigLoadError See `load()`.
+         * @throws exceptions::ConfigParseError See `load()`.
+         *
+         * @par Examples
+         * @code
+         * cfg.load("run.toml", {"output", "simulation"});
+         * @endcode
+         */
+        void load(const std::string_view path, std::vector<std::string> only, const bool verbose = false) {
+            set_projection(std::move(only));
+            load(path, verbose);
+        }
+
+        /**
+         * @brief Loads a file like `load()`, giving up when `deadline` passes or its stop token is stopped.
+         *
+         * The file is read on a helper thread (see deadline.h) and parsed once all of it arrived;
+         * the binary cache, the load daemon and the incremental reload document are not used.
+         * On a timeout nothing is loaded, so the caller can fall back to another copy, such as a
+         * message kept from `serialize_to()` and read with `deserialize_from()`.
+         *
+         * @param path The file path to read from.
+         * @param deadline A time point, a timeout, a `std::stop_token`, or a timeout and a token.
+         * @param verbose If true, a tree of missing fields is printed to stderr when the file does not match the schema.
+         * @throws exceptions::ConfigLoadTimeout If the file was not read before the deadline or the stop.
+         * @throws exceptions::ConfigLoadError See `load()`.
+         * @throws exceptions::ConfigParseError See `load()`.
+         *
+         * @par Examples
+         * @code
+         * std::stop_source shutdown;
+         * cfg.load("/lustre/run/physics.toml", {std::chrono::seconds(30), shutdown.get_token()});
+         * @endcode
+         */
+        void load(const std::string_view path, const LoadDeadline& deadline, const bool verbose = false);
+
+        /**
+         * @brief Loads configuration from a `ConfigSource`, such as an HTTP server or a local cache of one.
+         *
+         * The document is fetched and then read as `load()` reads a file: a source that returns a
+         * local file is read with the current `FileReadPolicy`, compression and `CachePolicy`; a
+         * document returned in memory is parsed as `load_from()` does, in the format its name's
+         * extension selects. The source is kept, and `reload()` without a path fetches from it
+         * again, revalidating the loaded version (see `source.h`).
+         *
+         * @param source The source; `get_source_path()` returns its name afterwards.
+         * @param verbose If true, a tree of missing fields is printed to stderr when the document does not match the schema.
+         * @throws exceptions::ConfigLoadError If the config is already loaded, the source fails, or the root name mismatches.
+         * @throws exceptions::ConfigParseError If the document is invalid TOML/JSON or doesn't match the schema.
+         *
+         * @par Examples
+         * @code
+         * cfg.load(std::make_shared<fourdst::config::CachedSource>(
+         *     std::make_shared<fourdst::config::HttpSource>(url), cache_directory));
+         * @endcode
+         */
+        void load(std::shared_ptr<ConfigSource> source, const bool verbose = false);
+
+        /**
+         * @brief Loads a file like `load()`, but returns errors instead of throwing them.
+         *
+         * For callers built without exception handlers (GPU host code, WASM modules without
+         * exception support): the exceptions `load()` raises are caught inside libconfig and
+         * returned as a `ConfigErrorInfo`, so no exception crosses this call. Declare the schema with
+         * `FOURDST_CONFIG_DECLARE` and instantiate it in a unit built with exceptions (see
+         * `instantiate.h`) to keep exception handling out of the calling units entirely.
+         *
+         * @param path The file to read.
+         * @param verbose If true, a tree of missing fields is printed to stderr when the file does not match the schema.
+         * @return Nothing on success; otherwise what `load()` would have thrown.
+         *
+         * @par Examples
+         * @code
+         * if (const auto loaded = cfg.try_load("run.toml"); !loaded) {
+         *     std::fprintf(stderr, "%s\n", loaded.error().message.c_str());
+         *     return 1;
+         * }
+         * @endcode
+         */
+        [[nodiscard]] std::expected<void, exceptions::ConfigErrorInfo> try_load(std::string_view path, bool verbose = false) noexcept;
+
+        /**
+         * @brief Loads from a document in memory like `load_from()`, but returns errors instead of throwing them; see `try_load()`.
+         *
+         * The document is parsed where it lies, so a WASM module can hand over a view of its own
+         * heap (filled from a JS `Uint8Array`) without an intermediate copy or the virtual filesystem.
+         *
+         * @param content The document.
+         * @param verbose If true, a tree of missing fields is printed to stderr when the document does not match the schema.
+         * @return Nothing on success; otherwise what `load_from()` would have thrown.
+         */
+        [[nodiscard]] std::expected<void, exceptions::ConfigErrorInfo> try_load_from(std::string_view content,
+                                                                                     bool verbose = false) noexcept;
+
+        /**
+         * @brief Starts `load(path, verbose)` in the background, so parsing overlaps with other startup work.
+         *
+         * Until the load completes, `get_state()` returns `ConfigState::LOADING` and snapshots,
+         * `ConfigReader` handles and `get()` keep returning the previous (default) content; the
+         * loaded content is published in one step at the end, like a synchronous `load()`. Threads
+         * that need the loaded values can wait on the future or call `wait_loaded()`. No other
+         * member may be called, and the config must not be moved or destroyed, until the future is ready.
+         *
+         * The load runs as a task on the default executor (see `set_default_executor()`), or on a
+         * new thread through `std::async` if none is installed. In the latter case the returned
+         * future blocks in its destructor until the load has finished, as every `std::async`
+         * future does; keep it for as long as the load should run in the background.
+         *
+         * @param path The file path to read from.
+         * @param verbose If true, a tree of missing fields is printed to stderr when the file does not match the schema.
+         * @return A future that becomes ready when the load finishes; `get()` rethrows the errors `load()` throws.
+         * @throws exceptions::ConfigLoadError If the config is already loaded or another `load_async()` is in progress.
+         *
+         * @par Examples
+         * @code
+         * auto loading = cfg.load_async("physics.toml");
+         * build_mesh();
+         * loading.get();
+         * @endcode
+         */
+        [[nodiscard]] std::future<void> load_async(std::string path, const bool verbose = false) {
+            // Claiming the flag first also orders the source path check after any earlier asynchronous load.
+            if (m_sync->loading.exchange(true, std::memory_order_acq_rel)) {
+                throw exceptions::ConfigLoadError("Config is already being loaded by load_async().");
+            }
+            const auto finish = [sync = m_sync.get()] {
+                sync->loading.store(false, std::memory_order_release);
+                sync->loading.notify_all();
+            };
+            if (!m_source_path.empty()) {
+                finish();
+                throw exceptions::ConfigLoadError(
+                    "Config has already been loaded from file. Use reload() to pick up changes to the file.");
+            }
+            try {
+                auto run = [this, path = std::move(path), verbose, finish] {
+                    try {
+                        load(path, verbose);
+                    } catch (...) {
+                        finish();
+                        throw;
+                    }
+                    finish();
+                };
+                if (const AnyExecutor executor = default_executor()) {
+                    auto task = std::make_shared<std::packaged_task<void()>>(std::move(run));
+                    std::future<void> loaded = task->get_future();
+                    executor([task] { (*task)(); });
+                    return loaded;
+                }
+                return std::async(std::launch::async, std::move(run));
+            } catch (...) {
+                finish();
+                throw;
+            }
+        }
+
+        /**
+         * @brief Blocks until no `load_async()` is in progress; returns at once otherwise.
+         *
+         * Safe to call from any thread. Errors of the load are only reported through its future.
+         */
+        void wait_loaded() const {
+            m_sync->loading.wait(true, std::memory_order_acquire);
+        }
+
+        /**
+         * @brief Loads configuration from several TOML files layered on top of each other.
+         *
+         * The files are parsed in order and deep-merged into one table: tables are merged key by
+         * key, and any other value (including arrays) in a later file replaces the earlier one.
+         * The merged table is deserialized into `T` once; then, as after any load, the environment
+         * layer (see `set_env_prefix()`) and the overrides registered with `set_override()` (such
+         * as bound CLI options) are applied on top.
+         *
+         * `reload()` without a path re-reads all layers, parsing again only the files that changed
+         * since the last read. The binary cache is not used for layered loads.
+         *
+         * @param paths The files to merge, lowest precedence first (e.g. base, site, run).
+         * @param verbose If true, a tree of missing fields is printed to stderr when the merged table does not match the schema.
+         * @throws exceptions::ConfigLoadError If the config is already loaded, no path is given, a file doesn't exist, or the root name mismatches.
+         * @throws exceptions::ConfigParseError If a file is invalid TOML or the merged table doesn't match the schema.
+         *
+         * @par Examples
+         * @code
+         * cfg.set_env_prefix("FOURDST_");
+         * cfg.load_layers({"/etc/fourdst/base.toml", "site.toml", "run.toml"});
+         * @endcode
+         */
+        void load_layers(const std::vector<std::string>& paths, const bool verbose = false);
+
+        /**
+         * @brief Loads configuration from the fragments of a drop-in directory, merged in file name order.
+         *
+         * Every regular `.toml` file of `directory` (compressed `.toml.zst` and `.toml.gz` too, but
+         * not hidden files or subdirectories) is a layer of `load_layers()`, in lexical order of
+         * the file names, so `90-local.toml` overrides `10-defaults.toml`. The fragments are parsed
+         * in parallel on the default executor (see executor.h), merged as tables and deserialized
+         * once.
+         *
+         * `reload()` lists the directory again, so added and removed fragments are picked up, and
+         * parses only the fragments whose bytes changed; the others are merged from the tables
+         * kept since the last read.
+         *
+         * @param directory The drop-in directory, e.g. `/etc/fourdst/conf.d`.
+         * @param verbose If true, a tree of missing fields is printed to stderr when the merged table does not match the schema.
+         * @throws exceptions::ConfigLoadError If the config is already loaded, or the directory cannot be listed or holds no fragment.
+         * @throws exceptions::ConfigParseError If a fragment is invalid TOML or the merged table doesn't match the schema.
+         *
+         * @par Examples
+         * @code
+         * cfg.load_directory("/etc/fourdst/conf.d");
+         * // ... an administrator drops in conf.d/50-site.toml ...
+         * cfg.reload();
+         * @endcode
+         */
+        void load_directory(const std::string& directory, const bool verbose = false);
+
+        /**
+         * @brief Loads configuration from a TOML document that has already been parsed.
+         *
+         * The root table is selected and deserialized exactly as `load()` does after parsing a
+         * file, so callers that parse a file once for several consumers (see `DynamicConfig`) do
+         * not parse it again. Includes must already be resolved (see `io::resolve_includes()`).
+         * Sidecar references in the selected root table are replaced by empty arrays while reading.
+         * Afterwards `get_source_path()` returns `path`, and `reload()` re-reads that file.
+         *
+         * @param document The parsed document; its top-level keys are root tables.
+         * @param path The file the document was parsed from, for error messages and sidecar lookup.
+         * @param verbose If true, a tree of missing fields is printed to stderr when the root table does not match the schema.
+         * @throws exceptions::ConfigLoadError If the config is already loaded, or root name mismatch (under KEEP_CURRENT policy).
+         * @throws exceptions::ConfigParseError If the document has no root table or it doesn't match the schema.
+         */
+        void load_table(toml::table& document, const std::string_view path, const bool verbose = false);
+
+        /**
+         * @brief Sets the prefix of environment variables applied on top of every load.
+         *
+         * For every field path of `T`, the variable `<prefix><PATH>` sets the field, where `PATH` is
+         * the dotted path upper-cased with `.` replaced by `__` (e.g. `FOURDST_SIMULATION__TIME_STEP`).
+         * After each `load()`, `load_layers()` or `reload()` reads its content, the environment is
+         * walked once and matching variables are converted straight into their fields (see
+         * `env.h`): string and enum fields take the text verbatim, numbers and booleans are read
+         * as in TOML, and other values are parsed as TOML values (`[1, 2, 3]`). The layer sits
+         * below the overrides of `set_override()`. It sets fields of loaded content and cannot
+         * supply fields a file is missing. An empty prefix (the default) disables the layer.
+         *
+         * @param prefix The variable name prefix.
+         */
+        void set_env_prefix(std::string prefix) {
+            m_env_prefix = std::move(prefix);
+        }
+
+        /**
+         * @brief Gets the environment variable prefix.
+         * @return The prefix, or an empty view if the environment layer is disabled.
+         */
+        [[nodiscard]] std::string_view get_env_prefix() const {
+            return m_env_prefix;
+        }
+
+        /**
+         * @brief Sets a field now and keeps it set across later loads and reloads.
+         *
+         * The value is applied like `set()`, and re-applied on top of the content read by every
+         * subsequent `load()`, `load_layers()` or `reload()`, so it acts as the highest-precedence
+         * layer regardless of whether it was given before or after loading. `register_as_cli()`
+         * applies parsed options this way.
+         *
+         * @param path Dotted field path.
+         * @param value The value; a later override of the same path replaces it.
+         * @throws exceptions::ConfigPathError If `path` does not name a field, or the field is of another type.
+         */
+        template <typename V>
+        void set_override(const std::string_view path, V&& value) {
+            using Field = std::conditional_t<std::is_convertible_v<V, std::string_view> && !std::is_same_v<std::remove_cvref_t<V>, std::string_view>,
+                                             std::string, std::remove_cvref_t<V>>;
+            const auto& entry = path_entry<Field>(path);
+            Field stored(std::forward<V>(value));
+            {
+                const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+                std::erase_if(m_overrides, [&](const auto& existing) { return existing.path == path; });
+                m_overrides.push_back({std::string(path), [&entry, stored](T& content) {
+                    *static_cast<Field*>(const_cast<void*>(entry.address(content))) = stored;
+                }});
+            }
+            assign(path, std::move(stored), FieldSource::OVERRIDE);
+        }
+
+        /**
+         * @brief Drops all overrides registered with `set_override()`; current values are kept.
+         */
+        void clear_overrides() {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            m_overrides.clear();
+            // The next reload has to read the files again to drop the overridden values.
+            m_source_stamps.clear();
+        }
+
+        /**
+         * @brief Enables or disables recording where each field value came from.
+         *
+         * While enabled, every field carries a `FieldProvenance`: the default, the file (and layer
+         * index) it was read from, the environment, an override, or a mutation. The record is a
+         * fixed array of two bytes per field, indexed by the compile-time field ordinal of `T`;
+         * it is published with the content, restored by `undo()` and `reset()`, and replaced on
+         * every load. Enable it before loading: fields already set are reported as defaults.
+         * Tracking bypasses the binary cache on load, since the cache does not know which keys a
+         * file contained. Disabled by default.
+         *
+         * @param enabled Whether to track provenance.
+         */
+        void set_provenance_tracking(const bool enabled) {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            if (enabled == static_cast<bool>(m_provenance)) return;
+            m_provenance = enabled ? std::make_shared<const ProvenanceRecord<T>>() : nullptr;
+            m_origin_provenance = m_provenance;
+            std::ranges::fill(m_provenance_history, nullptr);
+        }
+
+        /**
+         * @brief Gets whether provenance is being tracked.
+         * @return True if `set_provenance_tracking(true)` is in effect.
+         */
+        [[nodiscard]] bool get_provenance_tracking() const {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            return static_cast<bool>(m_provenance);
+        }
+
+        /**
+         * @brief Returns where the value of a leaf field came from.
+         * @param path Dotted path of a leaf field (not a nested table).
+         * @return The provenance of the field.
+         * @throws exceptions::ConfigPathError If tracking is disabled, or `path` does not name a leaf field.
+         *
+         * @par Examples
+         * @code
+         * cfg.set_provenance_tracking(true);
+         * cfg.load_layers({"base.toml", "run.toml"});
+         * if (cfg.get_provenance("simulation.time_step").source == FieldSource::ENVIRONMENT) { ... }
+         * @endcode
+         */
+        [[nodiscard]] FieldProvenance get_provenance(const std::string_view path) const {
+            const detail::FieldRange range = detail::find_field<T>(path);
+            if (range.count == 0 || range.is_table) {
+                throw exceptions::ConfigPathError(
+                    std::format("No leaf field at path '{}' in the configuration schema.", path));
+            }
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            if (!m_provenance) {
+                throw exceptions::ConfigPathError(
+                    "Provenance tracking is disabled. Enable it with set_provenance_tracking() before loading.");
+            }
+            return (*m_provenance)[range.ordinal];
+        }
+
+        /**
+         * @brief Lists the provenance of every leaf field, one `path = source` line each.
+         *
+         * Files are named by path; environment values by variable name. This is also what the
+         * `{:p}` format specifier appends, as TOML comments, to the formatted config.
+         *
+         * @return The listing, or an empty string if tracking is disabled.
+         */
+        [[nodiscard]] std::string describe_provenance() const {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            std::string out;
+            if (!m_provenance) return out;
+            auto describe = [&](const std::string_view path, const std::size_t ordinal) {
+                const FieldProvenance provenance = (*m_provenance)[ordinal];
+                out += path;
+                out += " = ";
+                switch (provenance.source) {
+                    case FieldSource::DEFAULT:
+                        out += "default";
+                        break;
+                    case FieldSource::FILE:
+                        out += std::format("file {}", provenance.layer < m_layer_paths.size()
+                                                          ? m_layer_paths[provenance.layer]
+                                                          : m_source_path);
+                        break;
+                    case FieldSource::ENVIRONMENT:
+                        out += std::format("env {}", env_name(path));
+                        break;
+                    case FieldSource::OVERRIDE:
+                        out += "override";
+                        break;
+                    case FieldSource::MUTATE:
+                        out += "mutate";
+                        break;
+                }
+                out += '\n';
+            };
+            detail::for_each_leaf<T>(std::string{}, 0, describe);
+            return out;
+        }
+
+#if FOURDST_CONFIG_USE_MPI
+        /**
+         * @brief Loads configuration collectively: one rank reads the file and broadcasts the result.
+         *
+         * Rank `root` reads, parses and validates the file exactly as `load()` does, encodes the
+         * content compactly (see `io::encode_content()`), and broadcasts it; the other ranks decode
+         * it without touching the filesystem. Startup therefore costs one file open and one parse
+         * regardless of the number of ranks.
+         *
+         * This is a collective call: every rank of `comm` must make it with the same `root`. If
+         * loading fails on `root`, every rank throws the same exception type and message; failures
+         * other than `ConfigError`s (e.g. `std::bad_alloc`) surface as `ConfigLoadError`. The
+         * broadcast carries the schema fingerprint of `root`, so a rank whose binary lays out `T`
+         * differently (MPMD runs, mixed builds) fails with `ConfigLoadError` instead of decoding it.
+         * The `FileReadPolicy`, `CachePolicy` and root name policy of `root` apply. Only available
+         * when built with MPI support (the `use_mpi` meson option).
+         *
+         * @param comm The communicator.
+         * @param path The file path to read on `root`.
+         * @param verbose If true, `root` prints a tree of missing fields when the file does not match the schema.
+         * @param root The rank that reads the file.
+         * @throws exceptions::ConfigLoadError If the config is already loaded, the file doesn't exist, the root name mismatches, or the broadcast fails.
+         * @throws exceptions::ConfigParseError If the file content is invalid TOML or doesn't match the schema.
+         *
+         * @par Examples
+         * @code
+         * fourdst::config::Config<RunConfig> cfg;
+         * cfg.load_collective(MPI_COMM_WORLD, "run.toml");
+         * @endcode
+         */
+        void load_collective(MPI_Comm comm, const std::string_view path, const bool verbose = false, const int root = 0) {
+            if (!m_source_path.empty()) {
+                throw exceptions::ConfigLoadError(
+                    "Config has already been loaded from file. Use reload() to pick up changes to the file.");
+            }
+
+            enum : std::uint8_t { OK, LOAD_ERROR, PARSE_ERROR };
+
+            int rank = 0;
+            MPI_Comm_rank(comm, &rank);
+
+            std::string buffer;
+            std::optional<T> loaded;
+            std::string loaded_root_name;
+            if (rank == root) {
+                io::BinaryWriter writer(buffer);
+                try {
+                    loaded.emplace(read_file(path, verbose, loaded_root_name));
+                    writer.write(std::uint8_t{OK});
+                    writer.write(loaded_root_name);
+                    writer.write(io::content_fingerprint<T>());
+                    io::encode_content(buffer, *loaded);
+                } catch (const exceptions::ConfigParseError& e) {
+                    buffer.clear();
+                    writer.write(std::uint8_t{PARSE_ERROR});
+                    writer.write(std::string_view(e.what()));
+                } catch (const std::exception& e) {
+                    // Whatever fails, root must still join the broadcast or the other ranks hang.
+                    buffer.clear();
+                    writer.write(std::uint8_t{LOAD_ERROR});
+                    writer.write(std::string_view(e.what()));
+                } catch (...) {
+                    buffer.clear();
+                    writer.write(std::uint8_t{LOAD_ERROR});
+                    writer.write(std::string_view("Loading the config failed with an unknown exception."));
+                }
+            }
+
+            io::broadcast_bytes(comm, root, buffer);
+
+            io::BinaryReader reader(buffer);
+            std::uint8_t status = LOAD_ERROR;
+            std::string text;
+            if (!reader.read(status) || !reader.read(text)) {
+                throw exceptions::ConfigLoadError("Received a corrupt config broadcast.");
+            }
+            if (status == PARSE_ERROR) {
+                throw exceptions::ConfigParseError(text);
+            }
+            if (status != OK) {
+                throw exceptions::ConfigLoadError(text);
+            }
+
+            if (rank != root) {
+                // Ranks built from different sources may disagree on T; checked before decoding.
+                std::uint64_t fingerprint = 0;
+                if (!reader.read(fingerprint)) {
+                    throw exceptions::ConfigLoadError("Received a corrupt config broadcast.");
+                }
+                if (fingerprint != io::content_fingerprint<T>()) {
+                    throw exceptions::ConfigLoadError(std::format(
+                        "Received a config broadcast from rank {} built with a different layout of the schema.", root));
+                }
+                loaded.emplace();
+                if (!io::decode_content(std::string_view(buffer).substr(buffer.size() - reader.remaining()), *loaded)) {
+                    throw exceptions::ConfigLoadError("Received a corrupt config broadcast.");
+                }
+                loaded_root_name = std::move(text);
+            }
+            auto provenance = fresh_provenance();
+            if (provenance) {
+                // Only the decoded content is broadcast, so every field is attributed to the file.
+                provenance->mark_all({FieldSource::FILE, 0});
+            }
+            install_loaded(std::move(*loaded), std::move(loaded_root_name), path, std::move(provenance));
+        }
+#endif
+
+#if FOURDST_CONFIG_USE_HDF5
+        /**
+         * @brief Writes the configuration as a native HDF5 group, e.g. into a simulation output file.
+         *
+         * The group mirrors the schema: nested structs become subgroups, scalars and strings become
+         * attributes, and numeric vectors become chunked, compressed datasets, so large arrays stay
+         * binary (see `io::write_hdf5_group()` for the full mapping). Only available when built
+         * with HDF5 support (the `use_hdf5` meson option).
+         *
+         * @param location An open HDF5 file or group.
+         * @param name The group to create; defaults to the root name. An existing object of that name is replaced.
+         * @param options Chunking and compression of array datasets.
+         * @throws exceptions::ConfigSaveError If the group or one of its members cannot be written.
+         *
+         * @par Examples
+         * @code
+         * hid_t file = H5Fcreate("run.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+         * cfg.save_hdf5(file);
+         * H5Fclose(file);
+         * @endcode
+         */
+        void save_hdf5(const hid_t location, const std::string_view name = {}, const io::Hdf5WriteOptions& options = {}) const {
+            const auto content = snapshot();
+            io::write_hdf5_group(location, name.empty() ? std::string_view(m_root_name) : name, *content, options);
+        }
+
+        /**
+         * @brief Loads configuration from an HDF5 group written by `save_hdf5()`, without any TOML.
+         *
+         * The group name becomes the root name. Every field of the schema must be present, except
+         * optionals, which are empty when absent. The source path reported by `get_source_path()`
+         * is `<file>:<group>`; `reload()` only reads TOML and JSON files.
+         *
+         * @param location An open HDF5 file or group.
+         * @param name The group to read; defaults to the current root name.
+         * @throws exceptions::ConfigLoadError If the config is already loaded or the group does not exist.
+         * @throws exceptions::ConfigParseError If a field is missing or does not match the schema.
+         */
+        void load_hdf5(const hid_t location, const std::string_view name = {}) {
+            if (!m_source_path.empty()) {
+                throw exceptions::ConfigLoadError(
+                    "Config has already been loaded from file. Use reload() to pick up changes to the file.");
+            }
+
+            std::string group_name(name.empty() ? std::string_view(m_root_name) : name);
+            T loaded = io::read_hdf5_group<T>(location, group_name);
+
+            std::string file_name(static_cast<std::size_t>(std::max<ssize_t>(H5Fget_name(location, nullptr, 0), 0)), '\0');
+            H5Fget_name(location, file_name.data(), file_name.size() + 1);
+            auto provenance = fresh_provenance();
+            if (provenance) {
+                provenance->mark_all({FieldSource::FILE, 0});
+            }
+            const std::string source = std::format("{}:{}", file_name, group_name);
+            install_loaded(std::move(loaded), std::move(group_name), source, std::move(provenance));
+        }
+#endif
+
+        /**
+         * @brief Re-reads the configuration file and swaps in the new content.
+         *
+         * The file is parsed and validated into a fresh `T` off to the side, while readers keep using
+         * the current snapshot. Only once that succeeds is the new content swapped in and published.
+         * If parsing or validation fails, the current content is left untouched and the error is thrown.
+         *
+         * Any outstanding modifications made through `mutate()` are discarded, and the reloaded content
+         * becomes the new baseline for `reset()`.
+         *
+         * Files are stamped (size, modification time and a hash of their bytes) when they are read.
+         * If a reload finds every file with the same size and time, or with the same size and the
+         * same hash, it returns `false` at once without parsing, so frequent polling and spurious
+         * watcher events cost a `stat` (or one hash pass) instead of a load. The check is skipped
+         * while there are unsaved `mutate()` changes, after a setting that affects loading changed,
+         * and while an environment prefix is set.
+         *
+         * With `set_incremental_reload()` enabled, a changed file is compared with the document of
+         * the previous load and only the values that differ are deserialized into the current
+         * content; subscribers of untouched paths are not notified, as with a full reload.
+         *
+         * After `load(std::shared_ptr<ConfigSource>)`, a reload without a path fetches from the source
+         * again, passing the validator of the loaded version; if the source reports it unchanged,
+         * nothing is parsed and `false` is returned. Reloading from an explicit path drops the source.
+         * `reload("-")` reads a new deck from standard input; standard input is never re-read implicitly.
+         *
+         * @param path The file to read. If empty, the path passed to the last successful `load()` or `reload()` is used,
+         *             all layers of the last `load_layers()`, or the source of the last `load()` from a `ConfigSource`.
+         * @param verbose If true, a tree of missing fields is printed to stderr when the file does not match the schema.
+         * @return True if the reloaded content differs from the previous content, false if it is identical.
+         * @throws exceptions::ConfigLoadError If no path is given and nothing was loaded before, the file doesn't exist, or the root name mismatches.
+         * @throws exceptions::ConfigParseError If the file content is invalid TOML or doesn't match the schema.
+         *
+         * @par Examples
+         * @code
+         * if (cfg.reload()) {
+         *     rebuild_interpolation_tables(*cfg.snapshot());
+         * }
+         * @endcode
+         */
+        bool reload(const std::string_view path = {}, const bool verbose = false);
+
+        /**
+         * @brief Reloads a single file like `reload()`, giving up when `deadline` passes or its stop token is stopped.
+         *
+         * The file is read as `load(path, deadline)` reads it, even if its stamps show it unchanged,
+         * and on a timeout the current content is kept. Configs loaded with `load_layers()` or from
+         * a `ConfigSource` are reloaded from an explicit `path` only.
+         *
+         * @param path The file to read. If empty, the file of the last successful `load()` or `reload()` is used.
+         * @param deadline A time point, a timeout, a `std::stop_token`, or a timeout and a token.
+         * @param verbose If true, a tree of missing fields is printed to stderr when the file does not match the schema.
+         * @return True if the reloaded content differs from the previous content, false if it is identical.
+         * @throws exceptions::ConfigLoadTimeout If the file was not read before the deadline or the stop.
+         * @throws exceptions::ConfigLoadError If there is no single file to reload, the file doesn't exist, or the root name mismatches.
+         * @throws exceptions::ConfigParseError See `reload()`.
+         */
+        bool reload(const std::string_view path, const LoadDeadline& deadline, const bool verbose = false);
+
+        /**
+         * @brief Content read and validated by `stage_reload()`, published by `commit_reload()`.
+         */
+        class StagedReload {
+        public:
+            StagedReload(StagedReload&&) noexcept = default;
+            StagedReload& operator=(StagedReload&&) noexcept = default;
+
+            /// The content `commit_reload()` publishes, before the overrides of `set_override()` are applied.
+            [[nodiscard]] const T& content() const { return m_content; }
+
+        private:
+            friend class Config;
+            StagedReload() = default;
+
+            const void* m_owner = nullptr;
+            T m_content{};
+            std::string m_root_name;
+            std::string m_source;
+            std::vector<std::string> m_layers;
+            std::unique_ptr<ProvenanceRecord<T>> m_provenance;
+            std::shared_ptr<io::StringStore> m_strings;
+        };
+
+        /**
+         * @brief The first half of `reload()`: reads and validates the files again without publishing anything.
+         *
+         * Everything that can fail happens here: parsing, deserializing, schema and constraint
+         * checks and the environment layer. `commit_reload()` then publishes the result, so
+         * several configs can be staged first and committed only if all of them staged (see
+         * `ConfigRegistry`). The config keeps serving its current snapshot in between.
+         *
+         * Layered configs re-read their layers (and re-list their directory). Others re-read the
+         * file of the last load; `document`, if given, returns that file already parsed, and only
+         * the root table of this config is copied out of it.
+         *
+         * @param verbose If true, a tree of missing fields is printed to stderr when the file does not match the schema.
+         * @param document Returns the parsed (and include-resolved) document of a path.
+         * @return The staged content; commit it to this config only.
+         * @throws exceptions::ConfigLoadError If the config was not loaded from files, a file doesn't exist, or the root name mismatches.
+         * @throws exceptions::ConfigParseError If a file is invalid TOML or doesn't match the schema.
+         */
+        [[nodiscard]] StagedReload stage_reload(const bool verbose = false,
+                                                const std::function<const toml::table&(const std::string&)>& document = {}) const;
+
+        /**
+         * @brief The second half of `reload()`: publishes content staged by `stage_reload()`.
+         * @return True if the staged content differs from the current content.
+         * @throws exceptions::ConfigLoadError If `staged` was staged by another config.
+         */
+        bool commit_reload(StagedReload staged);
+
+        /**
+         * @brief Loads configuration from a TOML or JSON document held in memory.
+         *
+         * Parses `content` exactly as `load()` parses a file, without touching the filesystem, and
+         * swaps the result in as `reload()` does: it can be called again with every new version of
+         * the document, and if parsing or validation fails the current content is left untouched.
+         * The format follows `set_file_format()`; with `FileFormat::AUTO` a document whose first
+         * character is `{` is read as JSON, and one whose first character is `&` as a namelist. Includes and sidecars are resolved relative to the
+         * working directory. Afterwards `get_source_path()` returns `"<memory>"`.
+         *
+         * @param content The document.
+         * @param verbose If true, a tree of missing fields is printed to stderr when the document does not match the schema.
+         * @return True if the loaded content differs from the previous content, false if it is identical.
+         * @throws exceptions::ConfigLoadError If the root name mismatches (under KEEP_CURRENT policy).
+         * @throws exceptions::ConfigParseError If the content is invalid TOML/JSON or doesn't match the schema.
+         *
+         * @par Examples
+         * @code
+         * cfg.load_from(message.payload());
+         * @endcode
+         */
+        bool load_from(const std::string_view content, const bool verbose = false);
+
+        /**
+         * @brief Loads configuration from everything remaining in an input stream; see `load_from(std::string_view)`.
+         * @param in The stream to read.
+         * @param verbose If true, a tree of missing fields is printed to stderr when the document does not match the schema.
+         * @return True if the loaded content differs from the previous content, false if it is identical.
+         * @throws exceptions::ConfigLoadError If the stream cannot be read, or the root name mismatches.
+         * @throws exceptions::ConfigParseError If the content is invalid TOML/JSON or doesn't match the schema.
+         */
+        bool load_from(std::istream& in, const bool verbose = false) {
+            const std::string content{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+            if (in.bad()) {
+                throw exceptions::ConfigLoadError("Failed to read config from input stream.");
+            }
+            return load_from(std::string_view(content), verbose);
+        }
+
+        /**
+         * @brief Gets the path of the file this config was last loaded or reloaded from.
+         * @return The source path, or an empty view if nothing has been loaded.
+         */
+        [[nodiscard]] std::string_view get_source_path() const {
+            return m_source_path;
+        }
+
+#if !FOURDST_CONFIG_WASM_PROFILE
+        /**
+         * @brief Returns the JSON schema for the configuration structure.
+         *
+         * The schema describes a file with string-keyed root tables of type `T` and is generated
+         * once per `T` on first use (thread-safely); later calls return the same text. Builds
+         * configured with `-Dwasm_profile=true` leave out the schema generator and this member.
+         *
+         * @return A view of the pretty-printed schema, valid for the lifetime of the program.
+         *
+         * @par Examples
+         * @code
+         * std::cout << Config<MyConfig>::schema() << "\n";
+         * @endcode
+         */
+        [[nodiscard]] static std::string_view schema();
+
+        /**
+         * @brief Saves the JSON schema for the configuration structure to a file.
+         *
+         * Useful for enabling autocompletion and validation in editors (e.g., VS Code).
+         * The schema text is the cached one returned by `schema()`. A path ending in `.zst` or
+         * `.gz` is written compressed, as `save()` does.
+         *
+         * @param path The path to save the schema file to.
+         * @param compression_level The level for a compressed path, or 0 for the library default.
+         * @throws exceptions::SchemaSaveError If the file cannot be opened or written.
+         *
+         * @par Examples
+         * @code
+         * Config<MyConfig>::save_schema("MyConfig.schema.json");
+         * Config<MyConfig>::save_schema("MyConfig.schema.json.gz", 9);
+         * @endcode
+         */
+        static void save_schema(const std::string& path, int compression_level = 0);
+
+        /**
+         * @brief Saves the JSON schema like `save_schema()`, but returns errors instead of throwing them; see `try_load()`.
+         * @param path The path to save the schema file to.
+         * @param compression_level The level for a compressed path, or 0 for the library default.
+         * @return Nothing on success; otherwise what `save_schema()` would have thrown.
+         */
+        [[nodiscard]] static std::expected<void, exceptions::ConfigErrorInfo> try_save_schema(const std::string& path,
+                                                                                              int compression_level = 0) noexcept;
+#endif
+
+        /**
+         * @brief Returns a commented TOML template listing every field of `T` with its default.
+         *
+         * Each field is preceded by a comment naming its type and whether it is optional; optional
+         * fields without a default are commented out (see `toml_template.h`). The template uses the
+         * default root name `main`, is generated once per `T` on first use and loads back as `T{}`.
+         *
+         * @return A view of the template, valid for the lifetime of the program.
+         */
+        [[nodiscard]] static std::string_view deck_template();
+
+        /**
+         * @brief Saves the template returned by `deck_template()` to a file.
+         *
+         * A deck started from the template can be cut down to the fields it changes and loaded
+         * with `set_missing_field_policy(MissingFieldPolicy::USE_DEFAULTS)`.
+         *
+         * @param path The path to write to.
+         * @throws exceptions::ConfigSaveError If the file cannot be opened or written.
+         *
+         * @par Examples
+         * @code
+         * Config<MyConfig>::save_template("MyConfig.template.toml");
+         * @endcode
+         */
+        static void save_template(const std::string& path);
+
+        /**
+         * @brief Returns a 64-bit hash of the current content, for keying caches of derived data.
+         *
+         * Field values are streamed through a hash in declaration order (see `fingerprint.h`);
+         * nothing is serialized. The value is computed from the current snapshot and cached
+         * until a newer snapshot is published or a `Tunable` field is stored to, so repeated calls
+         * between changes are free.
+         * Fields named by `set_fingerprint_exclusions()` do not contribute.
+         *
+         * @return The fingerprint; equal content gives equal fingerprints.
+         *
+         * @par Examples
+         * @code
+         * const auto key = cfg.fingerprint();
+         * if (!rate_tables.contains(key)) rate_tables[key] = build_rate_tables(*cfg.snapshot());
+         * @endcode
+         */
+        [[nodiscard]] std::uint64_t fingerprint() const {
+            const std::shared_ptr<const T> current = snapshot();
+            std::lock_guard lock(m_sync->fingerprint_mutex);
+            if (m_fingerprint_snapshot.lock() != current) {
+                m_fingerprint = io::fingerprint_content(*current, std::span<const detail::FieldRange>(m_fingerprint_excluded));
+                m_fingerprint_snapshot = current;
+            }
+            return m_fingerprint;
+        }
+
+        /**
+         * @brief Sets the fields left out of `fingerprint()`, replacing any earlier list.
+         *
+         * Excluding a nested table excludes all of its fields. Use this for fields that do not
+         * affect derived data, such as output locations.
+         *
+         * @param paths Dotted field paths.
+         * @throws exceptions::ConfigPathError If a path does not name a field; the list is then unchanged.
+         *
+         * @par Examples
+         * @code
+         * cfg.set_fingerprint_exclusions({"output.directory", "description"});
+         * @endcode
+         */
+        void set_fingerprint_exclusions(const std::vector<std::string>& paths) {
+            std::vector<detail::FieldRange> excluded;
+            for (const auto& path : paths) {
+                const detail::FieldRange range = detail::find_field<T>(path);
+                if (range.count == 0) {
+                    throw exceptions::ConfigPathError(
+                        std::format("Cannot exclude '{}' from the fingerprint: it is not a field path of the config schema.", path));
+                }
+                excluded.push_back(range);
+            }
+            std::lock_guard lock(m_sync->fingerprint_mutex);
+            m_fingerprint_excluded = std::move(excluded);
+            m_fingerprint_snapshot.reset();
+        }
+
+        /**
+         * @brief Gets the current state of the configuration object.
+         *
+         * Safe to call from any thread while a `load_async()` is in progress, during which it returns `LOADING`.
+         *
+         * @return The current state (DEFAULT, LOADED_FROM_FILE, MODIFIED or LOADING).
+         */
+        [[nodiscard]] ConfigState get_state() const {
+            // The acquire pairs with the release that ends an asynchronous load, after which m_state is settled.
+            if (m_sync->loading.load(std::memory_order_acquire)) return ConfigState::LOADING;
+            return m_state;
+        }
+
+        /**
+         * @brief Returns a string description of the current configuration state.
+         * @return "DEFAULT", "LOADED_FROM_FILE", "MODIFIED", "LOADING", or "UNKNOWN".
+         */
+        [[nodiscard]] std::string describe_state() const {
+            switch (get_state()) {
+                case ConfigState::DEFAULT:
+                    return "DEFAULT";
+                case ConfigState::LOADED_FROM_FILE:
+                    return "LOADED_FROM_FILE";
+                case ConfigState::MODIFIED:
+                    return "MODIFIED";
+                case ConfigState::LOADING:
+                    return "LOADING";
+                default:
+                    return "UNKNOWN";
+            }
+        }
+
+        /**
+         * @brief Modifies the configuration content in place.
+         *
+         * The mutator receives a mutable reference to the content under the content lock. Afterwards
+         * the result is published as a new snapshot. The content as of the last `load()`, `reload()`
+         * or `reset()` stays available to `reset()` as a shared, immutable snapshot, so mutating
+         * does not copy the struct a second time to keep undo state.
+         *
+         * If undo history is enabled (see `set_history_limit()`), the replaced snapshot is recorded
+         * so the mutation can be reverted with `undo()`.
+         *
+         * With mutation validation on (the default), the constrained fields the mutator changed are
+         * re-checked before publishing (see `constraints.h`).
+         *
+         * @param mutator Callable invoked as `mutator(T&)`.
+         * @throws Whatever `mutator` throws; the content is then restored from the published snapshot and nothing is published.
+         * @throws exceptions::ConfigValidationError If a changed `rfl::Validator` field fails its constraint; the content is restored likewise.
+         *
+         * @par Examples
+         * @code
+         * cfg.mutate([](auto& data) { data.simulation.time_step = 0.5; });
+         * @endcode
+         */
+        template <typename MutatorFunc>
+        void mutate(MutatorFunc&& mutator) {
+            FOURDST_CONFIG_TRACE_ZONE(zone, "config.mutate", m_root_name);
+            std::shared_ptr<const T> previous;
+            PendingAudit audited;
+            {
+                const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+                try {
+                    mutator(m_content);
+                } catch (...) {
+                    m_content = *snapshot();
+                    throw;
+                }
+                check_mutation();
+                m_state = ConfigState::MODIFIED;
+                previous = publish();
+                record_history(previous);
+                mark_changes(*previous, FieldSource::MUTATE);
+                audited = pending_audit(previous);
+            }
+            notify(previous);
+            audit(std::move(audited));
+        }
+
+        /**
+         * @brief Reads a field by its dotted path.
+         *
+         * Paths name fields relative to `T`, with nested structs separated by dots
+         * (e.g. `"simulation.time_step"`). Lookups use a perfect hash built at compile time
+         * (see `detail::PathTable`), so no serialization is involved. The value is read from
+         * the current snapshot.
+         *
+         * @tparam V The field type; must match the declared type exactly.
+         * @param path Dotted field path.
+         * @return A copy of the field value.
+         * @throws exceptions::ConfigPathError If `path` does not name a field, or the field is not a `V`.
+         *
+         * @par Examples
+         * @code
+         * const double dt = cfg.get<double>("simulation.time_step");
+         * @endcode
+         */
+        template <typename V>
+        [[nodiscard]] V get(const std::string_view path) const {
+            const auto& entry = path_entry<V>(path);
+#if FOURDST_CONFIG_USE_ACCESS_COUNTERS
+            m_sync->accesses.count(detail::PathTable<T>::find(path));
+#endif
+            const std::shared_ptr<const T> current = snapshot();
+            return *static_cast<const V*>(entry.address(*current));
+        }
+
+        /**
+         * @brief Reads a field by a dotted path fixed at compile time.
+         *
+         * The path is resolved while compiling, through the field names `reflect-cpp` reports, and
+         * the call compiles down to a member access; a path that names no field is a compile error.
+         * Like `operator->`, it reads the live content rather than a snapshot.
+         *
+         * @tparam Path Dotted field path, e.g. `"simulation.time_step"`; nested structs may be named as a whole.
+         * @return A reference to the field, typed as in the schema.
+         *
+         * @par Examples
+         * @code
+         * const double dt = cfg.get<"simulation.time_step">();
+         * const auto& physics = cfg.get<"physics">();
+         * @endcode
+         */
+        template <rfl::internal::StringLiteral Path>
+        [[nodiscard]] const auto& get() const noexcept {
+            constexpr detail::FieldRange field = detail::find_field<T>(Path.string_view());
+            static_assert(field.count != 0, "No field at this path in the configuration schema.");
+#if FOURDST_CONFIG_USE_ACCESS_COUNTERS
+            m_sync->accesses.count(field.ordinal);
+#endif
+            return detail::field_at<field.ordinal>(m_content);
+        }
+
+#if FOURDST_CONFIG_USE_ACCESS_COUNTERS
+        /**
+         * @brief Returns how often a field was read through `get()`, directly or as part of an enclosing struct.
+         *
+         * Only available when built with `FOURDST_CONFIG_USE_ACCESS_COUNTERS` (see `access.h`).
+         *
+         * @param path Dotted field path.
+         * @return The number of reads since construction or the last `reset_access_counts()`.
+         * @throws exceptions::ConfigPathError If `path` does not name a field.
+         */
+        [[nodiscard]] std::uint64_t get_access_count(const std::string_view path) const {
+            const std::size_t index = detail::PathTable<T>::find(path);
+            if (index == detail::PathTable<T>::npos) {
+                throw exceptions::ConfigPathError(
+                    std::format("No field at path '{}' in the configuration schema.", path));
+            }
+            return m_sync->accesses[index];
+        }
+
+        /**
+         * @brief Lists the leaf fields never read through `get()`, in schema order.
+         *
+         * Only available when built with `FOURDST_CONFIG_USE_ACCESS_COUNTERS` (see `access.h`).
+         * Call at the end of a run to find keys that can be pruned from the schema and the decks.
+         *
+         * @return The dotted paths of the unread fields.
+         *
+         * @par Examples
+         * @code
+         * for (const auto path : cfg.get_unread_fields()) {
+         *     std::cerr << "never read: " << path << '\n';
+         * }
+         * @endcode
+         */
+        [[nodiscard]] std::vector<std::string_view> get_unread_fields() const {
+            return m_sync->accesses.unread();
+        }
+
+        /**
+         * @brief Sets every access counter back to zero.
+         */
+        void reset_access_counts() {
+            m_sync->accesses.reset();
+        }
+#endif
+
+        /**
+         * @brief Assigns a field by its dotted path.
+         *
+         * Equivalent to a `mutate()` that assigns the single field: the result is published,
+         * recorded for `undo()` and reported to subscribers. String literals are accepted for
+         * `std::string` fields; other values must match the declared type exactly.
+         *
+         * A `V` assigned to a `Tunable<V>` field is instead stored into the field in place, without
+         * taking the writer lock or copying the content: every snapshot sees it at once, and it is
+         * not recorded for `undo()` or reported to subscribers (see `tunable.h`). It advances
+         * `tunable_stores()` instead of `generation()`.
+         *
+         * @param path Dotted field path.
+         * @param value The new value.
+         * @throws exceptions::ConfigPathError If `path` does not name a field, or the field is of another type.
+         *
+         * @par Examples
+         * @code
+         * cfg.set("simulation.time_step", 0.5);
+         * cfg.set("output.directory", "/scratch/run");
+         * @endcode
+         */
+        template <typename V>
+        void set(const std::string_view path, V&& value) {
+            using Value = std::remove_cvref_t<V>;
+            if constexpr ((std::is_arithmetic_v<Value> || std::is_enum_v<Value>) && std::atomic<Value>::is_always_lock_free) {
+                if (store_tunable<Value>(path, value)) return;
+            }
+            assign(path, std::forward<V>(value), FieldSource::MUTATE);
+        }
+
+        /**
+         * @brief Applies a TOML or JSON merge patch to the live configuration.
+         *
+         * Only the patch is parsed, and only the fields it names are deserialized (see `patch.h`),
+         * so pushing a few keys costs the same regardless of the size of `T`. Patch keys are
+         * relative to `T`; a patch may also be wrapped in the current root table
+         * (`[main.simulation]`). A document whose first character is `{` is read as JSON.
+         *
+         * The patch is applied as one `transaction()`: it is published as a single snapshot and
+         * undo step, and if any key or value is rejected the content is left untouched.
+         *
+         * @param patch The patch document.
+         * @throws exceptions::ConfigParseError If the patch is not valid TOML/JSON or a value does not match its field.
+         * @throws exceptions::ConfigPathError If a key does not name a field of `T`.
+         *
+         * @par Examples
+         * @code
+         * cfg.apply_patch("simulation.time_step = 0.25\noutput.format = \"csv\"");
+         * cfg.apply_patch(R"({"physics": {"diffusion": true}})");
+         * @endcode
+         */
+        void apply_patch(const std::string_view patch) {
+            const std::size_t first = patch.find_first_not_of(" \t\r\n");
+            if (first != std::string_view::npos && patch[first] == '{') {
+                yyjson_read_err err;
+                yyjson_doc* doc = yyjson_read_opts(const_cast<char*>(patch.data()), patch.size(), 0, nullptr, &err);
+                if (doc == nullptr || !yyjson_is_obj(yyjson_doc_get_root(doc))) {
+                    yyjson_doc_free(doc);
+                    throw exceptions::ConfigParseError(
+                        std::format("Unable to parse JSON config patch. Reason: {} at byte {}",
+                                    doc == nullptr ? err.msg : "the patch is not an object", doc == nullptr ? err.pos : 0));
+                }
+                const std::unique_ptr<yyjson_doc, decltype(&yyjson_doc_free)> guard(doc, &yyjson_doc_free);
+                yyjson_val* root = yyjson_doc_get_root(doc);
+                if (yyjson_obj_size(root) == 1 && !detail::has_path<T>(m_root_name)) {
+                    if (yyjson_val* wrapped = yyjson_obj_getn(root, m_root_name.data(), m_root_name.size()); yyjson_is_obj(wrapped)) {
+                        root = wrapped;
+                    }
+                }
+                transaction([&](T& content) {
+                    const io::ScopedStringStore string_scope(patch_strings());
+                    io::apply_json_patch(content, root);
+                });
+                return;
+            }
+
+            toml::table parsed;
+            try {
+                parsed = toml::parse(patch, std::string_view("<patch>"));
+            } catch (const toml::parse_error& e) {
+                throw exceptions::ConfigParseError(
+                    std::format("Unable to parse TOML config patch. Reason: {}", e.description()));
+            }
+            toml::table* root = &parsed;
+            if (parsed.size() == 1 && !detail::has_path<T>(m_root_name)) {
+                if (toml::table* wrapped = parsed[m_root_name].as_table()) {
+                    root = wrapped;
+                }
+            }
+            transaction([&](T& content) {
+                const io::ScopedStringStore string_scope(patch_strings());
+                io::apply_toml_patch(content, *root);
+            });
+        }
+
+        /**
+         * @brief Applies a group of modifications that commit or roll back together.
+         *
+         * The body receives a mutable reference to the content under the content lock and may
+         * change any number of fields. If it returns normally (or returns `true`), the result is
+         * published as a single new snapshot and recorded as one undo step. If it throws (or
+         * returns `false`), the content is restored from the current snapshot, nothing is
+         * published, no subscribers are notified, and any exception is rethrown.
+         *
+         * Rolling back costs one copy of `T` from the shared snapshot; committing costs the same
+         * as a single `mutate()`, including its check of the changed constrained fields.
+         *
+         * @param body Callable invoked as `body(T&)`, returning `void` or `bool`.
+         * @return True if the transaction was committed, false if the body asked to roll back.
+         * @throws exceptions::ConfigValidationError If a changed `rfl::Validator` field fails its constraint; the transaction is rolled back.
+         *
+         * @par Examples
+         * @code
+         * const bool kept = cfg.transaction([&](auto& data) {
+         *     data.simulation.time_step *= 0.5;
+         *     data.simulation.output_frequency *= 2;
+         *     return objective(data) < best;
+         * });
+         * @endcode
+         */
+        template <typename TransactionFunc>
+        bool transaction(TransactionFunc&& body) {
+            std::shared_ptr<const T> previous;
+            PendingAudit audited;
+            {
+                const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+                bool commit = true;
+                try {
+                    if constexpr (std::is_same_v<std::invoke_result_t<TransactionFunc&, T&>, void>) {
+                        body(m_content);
+                    } else {
+                        commit = static_cast<bool>(body(m_content));
+                    }
+                } catch (...) {
+                    m_content = *snapshot();
+                    throw;
+                }
+                if (!commit) {
+                    m_content = *snapshot();
+                    return false;
+                }
+                check_mutation();
+                m_state = ConfigState::MODIFIED;
+                previous = publish();
+                record_history(previous);
+                mark_changes(*previous, FieldSource::MUTATE);
+                audited = pending_audit(previous);
+            }
+            notify(previous);
+            audit(std::move(audited));
+            return true;
+        }
+
+        /**
+         * @brief Reverts the most recent `mutate()` or `transaction()` recorded in the undo history.
+         *
+         * The recorded snapshot is republished as-is, so no copy is made for readers.
+         *
+         * @return True if a step was undone, false if the history is empty.
+         */
+        bool undo() {
+            std::shared_ptr<const T> previous;
+            {
+                const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+                if (m_history.empty()) return false;
+                std::shared_ptr<const T> restored = std::move(m_history.back());
+                m_history.pop_back();
+                if (m_provenance && m_provenance_history.back()) {
+                    m_provenance = std::move(m_provenance_history.back());
+                }
+                m_provenance_history.pop_back();
+                m_content = *restored;
+                m_state = restored == m_origin ? baseline_state() : ConfigState::MODIFIED;
+                previous = swap_snapshot(std::move(restored));
+            }
+            notify(previous);
+            return true;
+        }
+
+        /**
+         * @brief Sets how many undo steps are kept for `undo()`.
+         *
+         * Each step holds a reference to an earlier snapshot, so memory use grows with the limit
+         * times the size of `T`. The default of 0 keeps no history. Lowering the limit drops the
+         * oldest steps.
+         *
+         * @param limit The maximum number of recorded steps.
+         */
+        void set_history_limit(const std::size_t limit) {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            m_history_limit = limit;
+            while (m_history.size() > m_history_limit) {
+                m_history.pop_front();
+                m_provenance_history.pop_front();
+            }
+        }
+
+        /**
+         * @brief Gets the maximum number of undo steps kept.
+         * @return The history limit.
+         */
+        [[nodiscard]] std::size_t get_history_limit() const {
+            return m_history_limit;
+        }
+
+        /**
+         * @brief Gets the number of undo steps currently recorded.
+         * @return The history depth.
+         */
+        [[nodiscard]] std::size_t history_size() const {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            return m_history.size();
+        }
+
+        /**
+         * @brief Discards all modifications made since the last `load()`, `reload()` or `reset()`.
+         *
+         * The baseline snapshot is republished as-is, so readers that still hold it share it with
+         * the config; only the writer-side content is copied back from it. The state returns to
+         * `LOADED_FROM_FILE`, or to `DEFAULT` if the config was never loaded, and the undo history
+         * is cleared.
+         */
+        void reset() {
+            FOURDST_CONFIG_TRACE_ZONE(zone, "config.reset", m_root_name);
+            std::shared_ptr<const T> previous;
+            {
+                const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+                if (m_state == ConfigState::MODIFIED) {
+                    m_content = *m_origin;
+                    m_state = baseline_state();
+                    previous = swap_snapshot(m_origin);
+                    m_provenance = m_origin_provenance;
+                    clear_history();
+                }
+            }
+            if (previous) {
+                notify(previous);
+            }
+        }
+
+        /**
+         * @brief Callback invoked with the newly published snapshot when a watched subtree changes.
+         */
+        using ChangeCallback = std::function<void(const std::shared_ptr<const T>& snapshot)>;
+
+        /**
+         * @brief Registers a callback that fires when the subtree at `path` changes.
+         *
+         * After every `load()`, `reload()`, `mutate()` or `reset()` that publishes new content, the
+         * subtree addressed by `path` is compared between the previous and the new snapshot, and the
+         * callback runs only if it differs. Callbacks run on the thread that made the change, after
+         * the content lock has been released, so they may call `snapshot()` or `mutate()` freely.
+         *
+         * @param path Dotted field path such as `"physics.diffusion"`; empty to watch the whole config.
+         * @param callback The callback, receiving the newly published snapshot.
+         * @return A subscription id that can be passed to `unsubscribe()`.
+         * @throws exceptions::ConfigPathError If `path` does not name a field of `T`.
+         *
+         * @par Examples
+         * @code
+         * cfg.subscribe("simulation", [&](const auto& snapshot) {
+         *     grid = build_interpolation_grid(snapshot->simulation);
+         * });
+         * @endcode
+         */
+        std::size_t subscribe(std::string path, ChangeCallback callback) {
+            if (!path.empty() && detail::PathTable<T>::find(path) == detail::PathTable<T>::npos) {
+                throw exceptions::ConfigPathError(
+                    std::format("Cannot subscribe to config changes: '{}' is not a field path of the config schema.", path));
+            }
+            const std::size_t ordinal = path.empty() ? detail::PathTable<T>::npos : detail::PathTable<T>::find(path);
+            std::lock_guard lock(m_sync->subscription_mutex);
+            const std::size_t id = ++m_last_subscription_id;
+            m_subscriptions.push_back(std::make_shared<const Subscription>(id, std::move(path), ordinal, std::move(callback)));
+            return id;
+        }
+
+        /**
+         * @brief Removes a subscription registered with `subscribe()`.
+         * @param id The subscription id.
+         * @return True if a subscription with that id existed.
+         */
+        bool unsubscribe(const std::size_t id) {
+            std::lock_guard lock(m_sync->subscription_mutex);
+            return std::erase_if(m_subscriptions, [id](const auto& sub) { return sub->id == id; }) > 0;
+        }
+
+        /**
+         * @brief Returns `fn(*snapshot())`, computed once per published snapshot and shared until then.
+         *
+         * The result is memoized under `Key`, a tag type naming the derived value, and reused until
+         * `load()`, `reload()`, `mutate()`, `undo()` or `reset()` publishes a new snapshot; the next
+         * call after that computes it again from the new content. A returned value stays valid after
+         * it has been discarded. `fn` runs without any lock held, so two threads missing the cache at
+         * once may both run it, and `fn` may itself call `derived()`. Stores into `Tunable` fields
+         * do not publish a snapshot and do not discard derived values.
+         *
+         * @tparam Key Names the value; every call with the same `Key` must pass an `fn` of the same result type.
+         * @param fn Computes the value from a `const T&`.
+         *
+         * @par Examples
+         * @code
+         * struct OpacityGrid;
+         * const auto grid = cfg.derived<OpacityGrid>([](const AppConfig& c) { return build_grid(c.physics); });
+         * @endcode
+         */
+        template <typename Key, typename Fn>
+        std::shared_ptr<const std::remove_cvref_t<std::invoke_result_t<Fn&, const T&>>> derived(Fn&& fn) const {
+            return memoize<Key>({}, false, fn);
+        }
+
+        /**
+         * @brief Like `derived(fn)`, but discards the value only when one of the subtrees at `inputs` changes.
+         *
+         * When a new snapshot has been published since the value was computed, the subtrees at
+         * `inputs` are compared between the two snapshots (as `subscribe()` does), and the value is
+         * kept if none differ.
+         *
+         * @param inputs Dotted field paths `fn` reads; an empty path stands for the whole config.
+         * @param fn Computes the value from a `const T&`.
+         * @throws exceptions::ConfigPathError If a path in `inputs` does not name a field of `T`.
+         *
+         * @par Examples
+         * @code
+         * const auto grid = cfg.derived<OpacityGrid>({"physics.opacity", "physics.composition"},
+         *                                            [](const AppConfig& c) { return build_grid(c.physics); });
+         * @endcode
+         */
+        template <typename Key, typename Fn>
+        std::shared_ptr<const std::remove_cvref_t<std::invoke_result_t<Fn&, const T&>>> derived(
+            const std::initializer_list<std::string_view> inputs, Fn&& fn) const {
+            return memoize<Key>(inputs, true, fn);
+        }
+
+        /**
+         * @brief Discards every value memoized by `derived()`.
+         */
+        void clear_derived() const {
+            std::lock_guard lock(m_sync->derived_mutex);
+            m_sync->derived.clear();
+        }
+
+    private:
+        /**
+         * @brief Looks up the path table entry for `path` and checks that it holds a `V`.
+         */
+        template <typename V>
+        static const detail::PathEntry<T>& path_entry(const std::string_view path) {
+            using Table = detail::PathTable<T>;
+            const std::size_t index = Table::find(path);
+            if (index == Table::npos) {
+                throw exceptions::ConfigPathError(
+                    std::format("No field at path '{}' in the configuration schema.", path));
+            }
+            const auto& entry = Table::entry(index);
+            if (entry.type != detail::path_type_id<V>()) {
+                throw exceptions::ConfigPathError(
+                    std::format("Field at path '{}' is not of the requested type.", path));
+            }
+            return entry;
+        }
+
+        /**
+         * @brief Stores `value` into the `Tunable<V>` field at `path` of the published snapshot,
+         *        which shares it with `m_content` and every earlier snapshot.
+         * @return False if `path` names no field or a field of another type.
+         */
+        template <typename V>
+        bool store_tunable(const std::string_view path, const V value) const {
+            using Table = detail::PathTable<T>;
+            const std::size_t index = Table::find(path);
+            if (index == Table::npos) return false;
+            const auto& entry = Table::entry(index);
+            if (entry.type != detail::path_type_id<Tunable<V>>()) return false;
+            const std::shared_ptr<const T> current = snapshot();
+            static_cast<const Tunable<V>*>(entry.address(*current))->store(value);
+            m_sync->tunable_stores.fetch_add(1, std::memory_order_release);
+            // The snapshot is the same, so the fingerprint cached for it no longer matches its content.
+            std::lock_guard lock(m_sync->fingerprint_mutex);
+            m_fingerprint_snapshot.reset();
+            return true;
+        }
+
+        /// Distinguishes values memoized under the same key with different result types.
+        template <typename Key, typename Value>
+        struct DerivedKey {};
+
+        /**
+         * @brief A value memoized by `derived()` and the snapshot it was computed from.
+         */
+        struct DerivedValue {
+            std::shared_ptr<const T> source;
+            std::shared_ptr<const void> value;
+            /// Whether the value is kept while the subtrees at `inputs` are unchanged.
+            bool tracks_inputs = false;
+            std::vector<std::string> inputs;
+        };
+
+        /**
+         * @brief Returns the value memoized under `Key` if it is still current, computing it with `fn` otherwise.
+         */
+        template <typename Key, typename Fn>
+        std::shared_ptr<const std::remove_cvref_t<std::invoke_result_t<Fn&, const T&>>> memoize(
+            const std::initializer_list<std::string_view> inputs, const bool tracks_inputs, Fn& fn) const {
+            using Value = std::remove_cvref_t<std::invoke_result_t<Fn&, const T&>>;
+            for (const std::string_view path : inputs) {
+                if (!detail::has_path<T>(path)) {
+                    throw exceptions::ConfigPathError(
+                        std::format("Cannot track derived value inputs: '{}' is not a field path of the config schema.", path));
+                }
+            }
+            const std::type_index key(typeid(DerivedKey<Key, Value>));
+            const std::shared_ptr<const T> current = snapshot();
+            {
+                std::lock_guard lock(m_sync->derived_mutex);
+                if (const auto it = m_sync->derived.find(key); it != m_sync->derived.end()) {
+                    DerivedValue& entry = it->second;
+                    if (entry.source != current && entry.tracks_inputs &&
+                        std::ranges::all_of(entry.inputs, [&](const std::string& path) {
+                            return detail::equal_at(*entry.source, *current, path).value_or(false);
+                        })) {
+                        entry.source = current;
+                    }
+                    if (entry.source == current) return std::static_pointer_cast<const Value>(entry.value);
+                }
+            }
+
+            DerivedValue entry{current, nullptr, tracks_inputs, std::vector<std::string>(inputs.begin(), inputs.end())};
+            auto value = std::make_shared<const Value>(std::invoke(fn, *current));
+            entry.value = value;
+            {
+                std::lock_guard lock(m_sync->derived_mutex);
+                m_sync->derived.insert_or_assign(key, std::move(entry));
+            }
+            return value;
+        }
+
+        /**
+         * @brief Assigns a field by path like `set()`, attributing the field and its subfields to `source`.
+         */
+        template <typename V>
+        void assign(const std::string_view path, V&& value, const FieldSource source) {
+            using Field = std::conditional_t<std::is_convertible_v<V, std::string_view> && !std::is_same_v<std::remove_cvref_t<V>, std::string_view>,
+                                             std::string, std::remove_cvref_t<V>>;
+            const auto& entry = path_entry<Field>(path);
+            std::shared_ptr<const T> previous;
+            PendingAudit audited;
+            {
+                const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+                *static_cast<Field*>(const_cast<void*>(entry.address(m_content))) = std::forward<V>(value);
+                m_state = ConfigState::MODIFIED;
+                previous = publish();
+                record_history(previous);
+                if (m_provenance) {
+                    const detail::FieldRange range = detail::find_field<T>(path);
+                    auto provenance = std::make_shared<ProvenanceRecord<T>>(*m_provenance);
+                    provenance->mark(range.ordinal, range.count, {source, 0});
+                    m_provenance = std::move(provenance);
+                }
+                audited = pending_audit(previous);
+            }
+            notify(previous);
+            audit(std::move(audited));
+        }
+
+        /**
+         * @brief Rolls back and rejects the pending mutation if a constrained field it changed fails its constraint. Requires the content lock.
+         * @throws exceptions::ConfigValidationError Listing every violated constraint.
+         */
+        void check_mutation() {
+            if constexpr (detail::has_constraints_v<T>) {
+                if (!m_mutation_validation) return;
+                std::vector<validate::ValidationIssue> issues;
+                std::string path;
+                const std::shared_ptr<const T> published = snapshot();
+                detail::check_changed_constraints(*published, m_content, path, issues);
+                if (issues.empty()) return;
+                m_content = *published;
+                throw exceptions::ConfigValidationError(
+                    std::format("Mutation rejected. Found {} constraint violation(s):{}", issues.size(), validate::summarize_issues(issues)));
+            }
+        }
+
+        /**
+         * @brief Runs `operation`, returning what it throws as a value instead.
+         */
+        template <typename Operation>
+        static std::expected<void, exceptions::ConfigErrorInfo> capture_errors(Operation&& operation) noexcept {
+            try {
+                std::forward<Operation>(operation)();
+                return {};
+            } catch (const std::exception& error) {
+                return std::unexpected(exceptions::ConfigErrorInfo::from(error));
+            } catch (...) {
+                return std::unexpected(exceptions::ConfigErrorInfo{exceptions::ConfigErrorKind::OTHER, "unknown error", std::nullopt});
+            }
+        }
+
+        /**
+         * @brief Everything a save writes, captured so the file can be written while the config changes.
+         */
+        struct SaveRequest {
+            std::string path;
+            SavePolicy policy = SavePolicy::IN_PLACE;
+            FileFormat format = FileFormat::TOML;
+            io::Compression compression = io::Compression::NONE;
+            int compression_level = 0;
+            std::size_t sidecar_threshold = 0;
+            std::size_t columnar_threshold = 0;
+            std::shared_ptr<const T> content;
+            std::string root_name;
+            SaveMode mode = SaveMode::FULL;
+            std::shared_ptr<const T> baseline;
+        };
+
+        /**
+         * @brief Captures the published snapshot and the save settings for writing `path`.
+         * @throws exceptions::ConfigSaveError If `path` names a compression libconfig was built without.
+         */
+        [[nodiscard]] SaveRequest save_request(const std::string_view path, const SavePolicy policy,
+                                               const SaveMode mode = SaveMode::FULL) const {
+            SaveRequest request{std::string(path), policy, resolve_file_format(path), io::compression_for(path), m_compression_level,
+                                m_sidecar_threshold};
+            // The file is about to be rewritten in full, so the recorded spans no longer describe it.
+            forget_edits(path);
+            if (!io::compression_supported(request.compression)) {
+                // Checked before the file is opened, so the target is left untouched.
+                throw exceptions::ConfigSaveError(std::format(
+                    "Cannot write compressed config file {}: libconfig was built without -D{}=enabled",
+                    path, io::detail::compression_option(request.compression)));
+            }
+            if (request.format == FileFormat::NAMELIST) {
+                throw exceptions::ConfigSaveError(std::format("Cannot write config file {}: namelist files are read-only, save as TOML or JSON", path));
+            }
+#if FOURDST_CONFIG_USE_ARROW
+            request.columnar_threshold = m_columnar_threshold;
+#endif
+            // Written from the published snapshot, so a save may run while another thread mutates.
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            request.content = snapshot();
+            request.root_name = m_root_name;
+            request.mode = mode;
+            if (mode == SaveMode::CHANGES_SINCE_LOAD) request.baseline = m_origin;
+            return request;
+        }
+
+        /**
+         * @brief Splices the changed values into the loaded file, as `set_format_preserving_saves()` describes.
+         * @return False if the save has to be written in full.
+         * @throws exceptions::ConfigSaveError If the file cannot be written.
+         */
+        bool save_edits(const std::string_view path, const SavePolicy policy) const {
+            if constexpr (!io::is_streamable_v<T>) {
+                return false;
+            } else {
+                std::shared_ptr<const T> current;
+                std::string root;
+                {
+                    const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+                    if (!content_matches_text()) return false;
+                    current = snapshot();
+                    root = m_root_name;
+                }
+                std::lock_guard lock(m_sync->saved_mutex);
+                std::optional<EditState>& edit = m_sync->edit;
+                if (!edit || edit->path != path || resolve_file_format(path) != FileFormat::TOML) return false;
+                std::error_code size_ec;
+                std::error_code time_ec;
+                const std::uintmax_t size = std::filesystem::file_size(edit->path, size_ec);
+                const std::filesystem::file_time_type mtime = std::filesystem::last_write_time(edit->path, time_ec);
+                if (size_ec || time_ec || size != edit->size || mtime != edit->mtime) return false;
+
+                std::vector<io::ValueEdit> edits;
+                std::string value_path = root;
+                if (!io::collect_value_edits(*edit->baseline, *current, value_path, edits)) return false;
+                std::vector<io::SpanEdit> span_edits;
+                span_edits.reserve(edits.size());
+                for (const io::ValueEdit& value_edit : edits) {
+                    const auto it = edit->spans.find(value_edit.path);
+                    if (it == edit->spans.end()) return false;
+                    span_edits.push_back({it->second, value_edit.text});
+                }
+                std::ranges::sort(span_edits, {}, [](const io::SpanEdit& span_edit) { return span_edit.span.offset; });
+
+                const std::string file = edit->path;
+                try {
+                    if (!span_edits.empty()) {
+                        io::splice_file(file, span_edits, policy);
+                        io::shift_spans(edit->spans, span_edits);
+                    }
+                    std::error_code written_size_ec;
+                    std::error_code written_time_ec;
+                    edit->size = std::filesystem::file_size(file, written_size_ec);
+                    edit->mtime = std::filesystem::last_write_time(file, written_time_ec);
+                    edit->baseline = std::move(current);
+                    if (written_size_ec || written_time_ec) edit.reset();
+                } catch (...) {
+                    // The file may hold part of the edits; only a full save or load describes it again.
+                    edit.reset();
+                    m_sync->saved.erase(file);
+                    throw;
+                }
+                m_sync->saved.erase(file);
+                return true;
+            }
+        }
+
+        /**
+         * @brief Hashes everything that decides the bytes `write_file()` produces for `request`.
+         */
+        static std::uint64_t save_stamp(const SaveRequest& request) {
+            io::ContentHasher hasher;
+            hasher.add_word(io::fingerprint_content(*request.content));
+            if (request.baseline) hasher.add_word(io::fingerprint_content(*request.baseline));
+            hasher.add_bytes(request.root_name);
+            hasher.add_word(static_cast<std::uint64_t>(request.mode));
+            hasher.add_word(static_cast<std::uint64_t>(request.format));
+            hasher.add_word(static_cast<std::uint64_t>(request.compression));
+            hasher.add_word(static_cast<std::uint64_t>(request.compression_level));
+            hasher.add_word(request.sidecar_threshold);
+            hasher.add_word(request.columnar_threshold);
+            return hasher.value();
+        }
+
+        /**
+         * @brief Writes a captured save, unless unchanged saves are skipped and the file already holds it.
+         */
+        void save_file(const SaveRequest& request) const {
+            if (!m_skip_unchanged_saves) {
+                write_file(request);
+                return;
+            }
+            const std::uint64_t stamp = save_stamp(request);
+            const auto file_state = [&request] {
+                std::error_code size_ec;
+                std::error_code time_ec;
+                SavedFile file{0, std::filesystem::file_size(request.path, size_ec),
+                               std::filesystem::last_write_time(request.path, time_ec)};
+                return size_ec || time_ec ? std::optional<SavedFile>{} : std::optional<SavedFile>{file};
+            };
+            {
+                std::lock_guard lock(m_sync->saved_mutex);
+                const auto it = m_sync->saved.find(request.path);
+                if (it != m_sync->saved.end() && it->second.stamp == stamp) {
+                    const std::optional<SavedFile> current = file_state();
+                    if (current && current->size == it->second.size && current->mtime == it->second.mtime) return;
+                }
+            }
+            write_file(request);
+            std::optional<SavedFile> written = file_state();
+            std::lock_guard lock(m_sync->saved_mutex);
+            if (written) {
+                written->stamp = stamp;
+                m_sync->saved.insert_or_assign(request.path, *written);
+            } else {
+                m_sync->saved.erase(request.path);
+            }
+        }
+
+        /**
+         * @brief Writes a captured save; touches no member, so it may run on any thread.
+         */
+        static void write_file(const SaveRequest& request) {
+            FOURDST_CONFIG_TRACE_ZONE(zone, "config.save", request.root_name);
+            const std::string& path = request.path;
+            if (request.policy == SavePolicy::IN_PLACE) {
+                io::FileSink sink{path};
+                write_request(sink, request);
+                sink.close();
+            } else {
+                io::AtomicFileSink sink{path, request.policy == SavePolicy::DURABLE};
+                write_request(sink, request);
+                sink.commit();
+            }
+            FOURDST_CONFIG_TRACE_BYTES(zone, trace::file_bytes(path));
+        }
+
+        /**
+         * @brief Writes the document of a captured save into `sink`, compressed as its path asks, along with its side files.
+         */
+        template <typename Sink>
+        static void write_request(Sink& sink, const SaveRequest& request) {
+            const std::string& path = request.path;
+            // Sparse documents and patches are built as a table, so their arrays are written inline.
+            std::optional<toml::table> sparse;
+            if (request.mode == SaveMode::NON_DEFAULT_ONLY && request.format == FileFormat::TOML) {
+                sparse = io::non_default_table(*request.content);
+            } else if (request.mode == SaveMode::CHANGES_SINCE_LOAD) {
+                sparse = io::content_patch(*request.baseline, *request.content);
+                if (!sparse) {
+                    throw exceptions::ConfigSaveError(std::format(
+                        "Cannot write config patch {}: an optional field was cleared since the config was loaded, which a merge patch cannot express.",
+                        path));
+                }
+            }
+            const bool durable = request.policy == SavePolicy::DURABLE;
+            std::optional<io::SidecarWriter> sidecars;
+            if (request.sidecar_threshold != 0 && request.format == FileFormat::TOML) {
+                sidecars.emplace(path, request.sidecar_threshold, durable);
+            }
+            io::SidecarWriter* sidecar_writer = sidecars ? &*sidecars : nullptr;
+            std::optional<io::ShardWriter> shards;
+            if (request.format == FileFormat::TOML) shards.emplace(path, durable);
+            io::ShardWriter* shard_writer = shards ? &*shards : nullptr;
+            io::ColumnarWriter* columnar_writer = nullptr;
+#if FOURDST_CONFIG_USE_ARROW
+            std::optional<io::ColumnarWriter> columnar;
+            if (request.columnar_threshold != 0 && request.format == FileFormat::TOML) {
+                columnar_writer = &columnar.emplace(path, request.columnar_threshold, durable);
+            }
+#endif
+            const auto write_document = [&](auto& sink) {
+                if (sparse) {
+                    const toml::table document{{request.root_name, std::move(*sparse)}};
+                    std::ostringstream text;
+                    if (request.format == FileFormat::JSON) {
+                        text << toml::json_formatter{document} << '\n';
+                    } else {
+                        text << document << '\n';
+                    }
+                    sink.write(text.view());
+                } else {
+                    write_content(sink, request.format, *request.content, request.root_name, sidecar_writer, columnar_writer, shard_writer);
+                }
+            };
+            if (request.compression == io::Compression::NONE) {
+                write_document(sink);
+                return;
+            }
+            io::CompressingSink compressed{sink, request.compression, request.compression_level};
+            write_document(compressed);
+            compressed.finish();
+        }
+
+        /**
+         * @brief Serializes `content` in `format` under `root_name` into `sink`.
+         * @param sink A sink with a `write(std::string_view)` member.
+         * @param format The resolved output format (TOML or JSON).
+         * @param content The content to write: `m_content` under the content lock, or a snapshot.
+         * @param root_name The root table name.
+         * @param sidecars If not null, large numeric arrays are written to sidecars (TOML only).
+         * @param columnar If not null, large arrays of flat tables are written to columnar files (TOML only).
+         * @param shards If not null, `Sharded` fields are written to shard files (TOML only).
+         */
+        template <typename Sink>
+        static void write_content(Sink& sink, const FileFormat format, const T& content, const std::string_view root_name,
+                                  io::SidecarWriter* sidecars = nullptr, io::ColumnarWriter* columnar = nullptr,
+                                  io::ShardWriter* shards = nullptr) {
+            if (format == FileFormat::JSON) {
+                sink.write("{");
+                sink.write(rfl::json::write(std::string(root_name)));
+                sink.write(":");
+                sink.write(io::write_json(content));
+                sink.write("}\n");
+            } else {
+                io::write_toml_document(sink, root_name, content, sidecars, columnar, shards);
+            }
+        }
+
+        /**
+         * @brief Reads, parses and deserializes a config file without touching the current state.
+         *
+         * The file is parsed exactly once; the same table feeds both the deserializer and,
+         * on failure, the validator, which lists every problem in the error message. With a cache policy other than `DISABLED`,
+         * a matching binary cache is used instead of parsing, and under `READ_WRITE` a fresh
+         * cache is written after a successful parse. A load daemon (`set_load_daemon()`) is asked
+         * before the cache and given the content after a parse.
+         *
+         * @param path The file to read.
+         * @param verbose Whether to print the missing-field report on failure.
+         * @param loaded_root_name Receives the name of the root table the content was read from.
+         * @param provenance If not null, the fields present in the file are marked as read from it; the cache is not read.
+         * @param storage If not null, content to overwrite when the streaming reader reads the file, reusing its capacity.
+         * @return The deserialized content.
+         */
+        T read_file(const std::string_view path, const bool verbose, std::string& loaded_root_name,
+                    ProvenanceRecord<T>* provenance = nullptr, T* storage = nullptr) const {
+            if (!std::filesystem::exists(path)) {
+                throw exceptions::ConfigLoadError(
+                    std::format("Config file does not exist: {}", path));
+            }
+            check_file_size(path);
+
+            const FileFormat format = resolve_file_format(path);
+            const io::Compression compression = io::compression_for(path);
+            bool root_was_first = false;
+
+            if (m_cache_policy == CachePolicy::DISABLED && m_load_daemon.empty()) {
+                if (compression != io::Compression::NONE) {
+                    const std::string text = decompress_source(path, compression);
+                    check_parse_limits(text, path, format);
+                    return parse_content(text, path, format, verbose, loaded_root_name, root_was_first, provenance);
+                }
+                if constexpr (io::is_event_readable_v<T> && !IsVersionedSchema<T>) {
+                    if (format == FileFormat::TOML && m_file_read_policy == FileReadPolicy::STREAMING && provenance == nullptr &&
+                        !m_expressions && m_memory_resource == nullptr && m_projection.empty()) {
+                        return read_streaming(path, loaded_root_name, storage);
+                    }
+                }
+                if (format == FileFormat::TOML && m_file_read_policy == FileReadPolicy::BUFFERED) {
+                    toml::table root_tbl;
+                    if (io::current_load_stats() != nullptr || m_parse_limits.scans()) {
+                        // Read the file before parsing it, so the two phases are timed apart and the text can be checked.
+                        std::string text;
+                        {
+                            const io::LoadPhase phase(&LoadStats::read_time);
+                            std::ifstream in(std::string(path), std::ios::binary);
+                            text.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+                        }
+                        io::note_bytes_read(text.size());
+                        check_parse_limits(text, path, format);
+                        const io::LoadPhase phase(&LoadStats::parse_time);
+                        try {
+                            root_tbl = toml::parse(text, path);
+                        } catch (const toml::parse_error& e) {
+                            throw_unparseable(e, path);
+                        }
+                        io::resolve_includes(root_tbl, path);
+                    } else {
+                        try {
+                            root_tbl = toml::parse_file(std::string(path));
+                        } catch (const toml::parse_error& e) {
+                            throw_unparseable(e, path);
+                        }
+                        io::resolve_includes(root_tbl, path);
+                    }
+                    return read_table(root_tbl, path, verbose, loaded_root_name, root_was_first, provenance);
+                }
+                const io::MappedFile mapped = map_source(path, m_file_read_policy);
+                check_parse_limits(mapped.view(), path, format);
+                return parse_content(mapped.view(), path, format, verbose, loaded_root_name, root_was_first, provenance);
+            }
+
+            // The source bytes are needed for the hash anyway, so map them once and parse from
+            // the mapping on a cache miss. A compressed file is keyed by its decompressed bytes.
+            std::optional<io::MappedFile> mapped;
+            std::string decompressed;
+            if (compression == io::Compression::NONE) {
+                mapped.emplace(map_source(path, m_file_read_policy));
+            } else {
+                decompressed = decompress_source(path, compression);
+            }
+            const std::string_view source = mapped ? mapped->view() : std::string_view(decompressed);
+            if (compression != io::Compression::NONE) io::check_document_size(source.size(), m_parse_limits, path);
+            std::uint64_t source_hash;
+            {
+                const io::LoadPhase phase(&LoadStats::read_time);
+                // Content read under non-default key policies may differ, so those policies seed the key.
+                source_hash = io::hash_bytes(source, static_cast<std::uint64_t>(m_missing_field_policy) |
+                                                         static_cast<std::uint64_t>(m_unknown_key_policy) << 1);
+            }
+            const std::string cache_path = io::cache_path_for(path);
+
+            // A cached load skips the walk that reports renamed keys.
+            const bool use_cache = provenance == nullptr && m_memory_resource == nullptr && !m_shard_selector && m_projection.empty() && m_sinks.empty() &&
+                                   m_deprecated_key_policy == DeprecatedKeyPolicy::ALLOW;
+            std::optional<io::CacheEntry<T>> entry;
+            std::string daemon_key;
+            if (use_cache && !m_load_daemon.empty()) {
+                daemon_key = io::daemon_key(path, io::content_fingerprint<T>(), source_hash);
+                const io::LoadPhase phase(&LoadStats::deserialize_time);
+                io::DaemonClient(m_load_daemon).fetch(daemon_key, [&](const std::string_view bytes) {
+                    entry = io::decode_cache_entry<T>(bytes, source_hash);
+                    return entry.has_value();
+                });
+            }
+            if (use_cache && !entry && m_cache_policy != CachePolicy::DISABLED) {
+                const io::LoadPhase phase(&LoadStats::deserialize_time);
+                entry = io::read_cache<T>(cache_path, source_hash);
+            }
+            if (entry) {
+                const bool root_matches = m_root_name_load_policy == RootNameLoadPolicy::KEEP_CURRENT
+                                              ? entry->root_name == m_root_name
+                                              : entry->root_was_first;
+                if (root_matches) {
+                    loaded_root_name = std::move(entry->root_name);
+                    return std::move(entry->content);
+                }
+            }
+
+            check_parse_limits(source, path, format);
+            T content = parse_content(source, path, format, verbose, loaded_root_name, root_was_first, provenance);
+
+            // The cache is keyed by the source bytes only, so files that pull in fragments,
+            // sidecars, shard or columnar files are not cached.
+            bool self_contained = source.find(io::include_key) == std::string_view::npos &&
+                                  source.find(io::sidecar_key) == std::string_view::npos &&
+                                  source.find(io::shards_key) == std::string_view::npos;
+#if FOURDST_CONFIG_USE_ARROW
+            self_contained = self_contained && source.find(io::columnar_key) == std::string_view::npos;
+#endif
+            if (!daemon_key.empty() && self_contained) {
+                // Like the cache file, the daemon only saves the next job a parse.
+                io::DaemonClient(m_load_daemon).store(daemon_key, io::encode_cache_entry(source_hash, loaded_root_name, root_was_first, content));
+            }
+            if (m_cache_policy == CachePolicy::READ_WRITE && self_contained) {
+                try {
+                    io::write_cache(cache_path, source_hash, loaded_root_name, root_was_first, content);
+                } catch (const exceptions::ConfigSaveError&) {
+                    // The cache is an optimization; an unwritable location only costs the next startup.
+                }
+            }
+            return content;
+        }
+
+        /**
+         * @brief Reads `path` with the streaming TOML reader, under the current root name and key policies.
+         *
+         * With `storage`, the content is reset to its defaults by assignment and read into it in
+         * place, so its strings and vectors keep their capacity, then moved out.
+         */
+        T read_streaming(const std::string_view path, std::string& loaded_root_name, T* storage = nullptr) const {
+            std::ifstream in(std::string(path), std::ios::binary);
+            if (!in) {
+                throw exceptions::ConfigLoadError(std::format("Failed to open config file: {}", path));
+            }
+            io::StreamReadOptions options;
+            options.root_name = m_root_name;
+            options.keep_root_name = m_root_name_load_policy == RootNameLoadPolicy::KEEP_CURRENT;
+            options.reject_missing = m_missing_field_policy == MissingFieldPolicy::REJECT;
+            options.reject_unknown = m_unknown_key_policy == UnknownKeyPolicy::REJECT;
+            io::note_bytes_read(std::filesystem::file_size(path));
+            const io::LoadPhase phase(&LoadStats::parse_time);
+            if (storage != nullptr) {
+                const T defaults{};
+                *storage = defaults;
+                io::read_toml_stream_into(in, *storage, loaded_root_name, options, path);
+                return std::move(*storage);
+            }
+            return io::read_toml_stream<T>(in, loaded_root_name, options, path);
+        }
+
+        /**
+         * @brief Maps or reads the source file as `policy` asks, counting it as read for the installed `LoadStats`.
+         */
+        static io::MappedFile map_source(const std::string_view path, const FileReadPolicy policy) {
+            const io::LoadPhase phase(&LoadStats::read_time);
+            const io::ReadMode mode = policy == FileReadPolicy::DIRECT        ? io::ReadMode::DIRECT
+                                      : policy == FileReadPolicy::SINGLE_READ ? io::ReadMode::READ
+                                                                              : io::ReadMode::MAP;
+            io::MappedFile mapped{std::string(path), mode};
+            io::note_bytes_read(mapped.view().size());
+            return mapped;
+        }
+
+        /**
+         * @brief Decompresses the source file into memory, counting its decompressed size as read for the installed `LoadStats`.
+         */
+        static std::string decompress_source(const std::string_view path, const io::Compression compression) {
+            const io::LoadPhase phase(&LoadStats::read_time);
+            std::string text = io::read_compressed(std::string(path), compression);
+            io::note_bytes_read(text.size());
+            return text;
+        }
+
+        /**
+         * @brief Returns the format to use for `path`, resolving `FileFormat::AUTO` by extension.
+         *
+         * A compression extension is skipped, so `run.json.gz` resolves to JSON. MESA names its
+         * namelists `inlist`, `inlist_project` and so on, so those resolve to NAMELIST without an extension.
+         */
+        [[nodiscard]] FileFormat resolve_file_format(const std::string_view path) const {
+            if (m_file_format != FileFormat::AUTO) {
+                return m_file_format;
+            }
+            std::string extension = std::filesystem::path(io::strip_compression_extension(path)).extension().string();
+            std::ranges::transform(extension, extension.begin(), [](const unsigned char c) { return std::tolower(c); });
+            if (extension == ".json") return FileFormat::JSON;
+            if (extension == ".nml" || (extension.empty() && std::filesystem::path(path).filename().string().starts_with("inlist"))) {
+                return FileFormat::NAMELIST;
+            }
+            return FileFormat::TOML;
+        }
+
+        /**
+         * @brief Parses file contents in the given format and deserializes the root table into `T`.
+         */
+        T parse_content(const std::string_view bytes, const std::string_view path, const FileFormat format,
+                        const bool verbose, std::string& loaded_root_name, bool& root_was_first,
+                        ProvenanceRecord<T>* provenance) const {
+            if (format == FileFormat::JSON) {
+                return read_json(bytes, path, loaded_root_name, root_was_first, provenance);
+            }
+            if (format == FileFormat::NAMELIST) {
+                return read_namelist(bytes, path, verbose, loaded_root_name, root_was_first, provenance);
+            }
+            // Large numeric arrays are elided from the text toml++ sees and read with from_chars afterwards.
+            std::vector<io::NumericArraySpan> arrays;
+            std::string elided;
+            toml::table root_tbl;
+            {
+                const io::LoadPhase phase(&LoadStats::parse_time);
+                if constexpr (io::has_numeric_array_fields_v<T>) {
+                    arrays = io::scan_numeric_arrays<T>(bytes);
+                    if (!arrays.empty()) elided = io::elide_numeric_arrays(bytes, arrays);
+                }
+                try {
+                    root_tbl = toml::parse(arrays.empty() ? bytes : std::string_view(elided), path);
+                } catch (const toml::parse_error& e) {
+                    throw_unparseable(e, path);
+                }
+                io::resolve_includes(root_tbl, path);
+            }
+            T content = read_table(root_tbl, path, verbose, loaded_root_name, root_was_first, provenance);
+            if (!m_projection.empty()) {
+                // Arrays outside the projection were elided unparsed and stay at their defaults.
+                std::erase_if(arrays, [&](const io::NumericArraySpan& array) { return !projected(array.path, loaded_root_name); });
+            }
+            bool filled = arrays.empty();
+            if (!filled) {
+                const io::LoadPhase phase(&LoadStats::deserialize_time);
+                filled = io::fill_numeric_arrays(content, bytes, arrays, loaded_root_name);
+            }
+            if (filled) {
+                return content;
+            }
+
+            // An element the fast path does not read; let toml++ read the document as written.
+            {
+                const io::LoadPhase phase(&LoadStats::parse_time);
+                try {
+                    root_tbl = toml::parse(bytes, path);
+                } catch (const toml::parse_error& e) {
+                    throw_unparseable(e, path);
+                }
+                io::resolve_includes(root_tbl, path);
+            }
+            return read_table(root_tbl, path, verbose, loaded_root_name, root_was_first, provenance);
+        }
+
+        /**
+         * @brief Parses a JSON document with yyjson and deserializes its root object into `T`.
+         *
+         * The document must be an object whose members are root objects, mirroring the TOML
+         * layout (`{"main": {...}}`). Root selection follows the root name load policy.
+         */
+        /**
+         * @brief Parses a namelist file and deserializes its groups as the fields of the root table.
+         */
+        T read_namelist(const std::string_view bytes, const std::string_view path, const bool verbose, std::string& loaded_root_name,
+                        bool& root_was_first, ProvenanceRecord<T>* provenance) const {
+            toml::table root_tbl;
+            {
+                const io::LoadPhase phase(&LoadStats::parse_time);
+                toml::table groups = io::parse_namelist(bytes, path);
+                io::conform_namelist<T>(groups);
+                root_tbl.insert(m_root_name, std::move(groups));
+            }
+            return read_table(root_tbl, path, verbose, loaded_root_name, root_was_first, provenance);
+        }
+
+        T read_json(const std::string_view bytes, const std::string_view path, std::string& loaded_root_name, bool& root_was_first,
+                    ProvenanceRecord<T>* provenance) const {
+            if (!m_projection.empty()) {
+                throw exceptions::ConfigLoadError(
+                    std::format("Cannot read {} under a projection. Only TOML and namelist documents are projected on load.", path));
+            }
+            yyjson_read_err err;
+            // The document is built in an arena and released in one step once T is deserialized.
+            // yyjson does not modify the input unless YYJSON_READ_INSITU is set.
+            // String views of T point into the store's copy of the source, which yyjson parses in place.
+            const io::ParseArena arena;
+            io::StringStore* strings = io::contains_string_view_v<T> ? io::current_string_store() : nullptr;
+            char* input = strings != nullptr ? strings->retain_source(bytes) : const_cast<char*>(bytes.data());
+            yyjson_doc* doc;
+            {
+                const io::LoadPhase phase(&LoadStats::parse_time);
+                doc = yyjson_read_opts(input, bytes.size(), strings != nullptr ? YYJSON_READ_INSITU : 0, arena.allocator(), &err);
+            }
+            if (doc == nullptr) {
+                // yyjson reports a byte offset; count lines up to it for the location.
+                const std::string_view before = bytes.substr(0, std::min(err.pos, bytes.size()));
+                const std::size_t line_start = before.rfind('\n') + 1;
+                exceptions::ConfigParseError::Location location{std::string(path), static_cast<std::size_t>(std::ranges::count(before, '\n')) + 1,
+                                                                before.size() - line_start + 1, {}};
+                throw exceptions::ConfigParseError(
+                    std::format("Unable to parse JSON file: {}:{}:{}. Reason: {} at byte {}", path, location.line, location.column, err.msg, err.pos),
+                    std::move(location));
+            }
+            const std::unique_ptr<yyjson_doc, decltype(&yyjson_doc_free)> guard(doc, &yyjson_doc_free);
+
+            yyjson_val* root = yyjson_doc_get_root(doc);
+            if (!yyjson_is_obj(root) || yyjson_obj_size(root) == 0) {
+                throw exceptions::ConfigParseError(
+                    std::format("Config file contains no root object: {}. Add at least an empty object (e.g., {{\"{}\": {{}}}}) to it.", path, m_root_name));
+            }
+
+            yyjson_obj_iter iter = yyjson_obj_iter_with(root);
+            yyjson_val* first_key = yyjson_obj_iter_next(&iter);
+            const std::string first_name(yyjson_get_str(first_key), yyjson_get_len(first_key));
+
+            yyjson_val* root_val = nullptr;
+            if (m_root_name_load_policy == RootNameLoadPolicy::KEEP_CURRENT) {
+                root_val = yyjson_obj_getn(root, m_root_name.data(), m_root_name.size());
+                if (root_val == nullptr) {
+                    throw exceptions::ConfigLoadError(
+                        std::format(
+                            "Root name mismatch when loading config from file. Current root name is '{}', but file root name is '{}'. If you want to use the root name from the file, set the root name load policy to FROM_FILE using set_root_name_load_policy().",
+                            m_root_name,
+                            first_name
+                        )
+                    );
+                }
+                loaded_root_name = m_root_name;
+            } else {
+                root_val = yyjson_obj_iter_get_val(first_key);
+                loaded_root_name = first_name;
+            }
+            root_was_first = loaded_root_name == first_name;
+
+            if (!yyjson_is_obj(root_val)) {
+                throw exceptions::ConfigParseError(
+                    std::format("Failed to load config from file: {}. Reason: root key '{}' is not an object.", path, loaded_root_name));
+            }
+            if constexpr (IsVersionedSchema<T>) {
+                yyjson_val* version = yyjson_obj_getn(root_val, io::version_key.data(), io::version_key.size());
+                if (!yyjson_is_int(version) || static_cast<std::int64_t>(yyjson_get_num(version)) != io::current_version<T>()) {
+                    throw exceptions::ConfigLoadError(
+                        std::format("Config file {} does not have schema version {}. Only TOML documents are migrated on load.",
+                                    path, io::current_version<T>()));
+                }
+            }
+
+            const io::ScopedFieldResource field_resource(m_memory_resource);
+            const io::LoadPhase phase(&LoadStats::deserialize_time);
+            rfl::Result<T> result = rfl::json::read<T>(rfl::json::InputVarType(root_val));
+            if (!result) {
+                throw exceptions::ConfigParseError(
+                    std::format("Failed to load config from file: {}. Reason: {}", path, result.error().what()));
+            }
+            if (provenance != nullptr) {
+                provenance->mark_object(root_val, {FieldSource::FILE, 0});
+            }
+            T content = std::move(result).value();
+            bind_sinks(content);
+            return content;
+        }
+
+        /**
+         * @brief Binds the `Sink` fields of freshly read content to their registered targets, streaming the elements they hold.
+         */
+        void bind_sinks(T& content) const {
+            for (const auto& [path, bind] : m_sinks) bind(content);
+        }
+
+        /**
+         * @brief Whether the field at `path`, a dotted path starting with `root_name`, lies in a projected subtree.
+         */
+        bool projected(const std::string_view path, const std::string_view root_name) const {
+            if (!path.starts_with(root_name) || path.size() <= root_name.size() || path[root_name.size()] != '.') return false;
+            const std::string_view field = path.substr(root_name.size() + 1);
+            return std::ranges::any_of(m_projection, [&](const std::string& subtree) {
+                return field.starts_with(subtree) && (field.size() == subtree.size() || field[subtree.size()] == '.');
+            });
+        }
+
+        /**
+         * @brief Throws if the file at `path` is larger than `set_parse_limits()` allows, before it is read.
+         */
+        void check_file_size(const std::string_view path) const {
+            if (m_parse_limits.max_file_bytes == 0) return;
+            std::error_code ec;
+            const std::uintmax_t size = std::filesystem::file_size(path, ec);
+            // A file that cannot be inspected fails when it is opened.
+            if (!ec) io::check_document_size(static_cast<std::size_t>(size), m_parse_limits, path);
+        }
+
+        /**
+         * @brief Throws if a document about to be parsed is past the limits of `set_parse_limits()`.
+         */
+        void check_parse_limits(const std::string_view bytes, const std::string_view path, const FileFormat format) const {
+            if (!m_parse_limits.any()) return;
+            if (format == FileFormat::NAMELIST) {
+                io::check_document_size(bytes.size(), m_parse_limits, path);
+                return;
+            }
+            io::check_parse_limits(bytes, m_parse_limits, path, format == FileFormat::JSON);
+        }
+
+        /**
+         * @brief Rethrows a toml++ syntax error as a `ConfigParseError` carrying its file, line and column.
+         */
+        [[noreturn]] static void throw_unparseable(const toml::parse_error& error, const std::string_view path) {
+            throw io::syntax_error(error, "TOML file", path);
+        }
+
+        /**
+         * @brief Returns the location of the first issue, for `ConfigParseError::location()`.
+         */
+        static exceptions::ConfigParseError::Location issue_location(const validate::ValidationIssue& issue, const std::string_view path) {
+            return {issue.file.empty() ? std::string(path) : issue.file, issue.line, issue.column, issue.path};
+        }
+
+        /**
+         * @brief Deserializes the root table into `T`, with the generated reader of `codegen.h` if this unit has one.
+         */
+        static rfl::Result<T> deserialize(toml::node* root_node) {
+            if constexpr (io::has_generated_reader_v<T>) {
+                rfl::Result<T> result = T{};
+                std::string error;
+                if (!io::GeneratedReader<T>::read(*root_node->as_table(), result.value(), error)) return rfl::error(error);
+                return result;
+            } else {
+                return rfl::toml::read<T>(root_node);
+            }
+        }
+
+        /**
+         * @brief Selects the root table of a parsed file and deserializes it into `T`.
+         *
+         * @param root_tbl The parsed file.
+         * @param path The file the table was parsed from, for error messages.
+         * @param verbose Whether to print the missing-field report on failure.
+         * @param loaded_root_name Receives the name of the root table the content was read from.
+         * @param root_was_first Receives whether that table is the first root table of the file.
+         * @param provenance If not null, the fields present in the root table are marked as read from the file.
+         * @return The deserialized content.
+         */
+        T read_table(toml::table& root_tbl, const std::string_view path, const bool verbose, std::string& loaded_root_name, bool& root_was_first,
+                     ProvenanceRecord<T>* provenance = nullptr) const {
+            if (root_tbl.empty()) {
+                throw exceptions::ConfigParseError(
+                    std::format("Config file contains no root table: {}. Add at least an empty table (e.g., [{}]) to it.", path, m_root_name));
+            }
+
+            // Select the root table without deserializing anything. Under KEEP_CURRENT the
+            // current root name is looked up directly; under FROM_FILE the first root is used.
+            loaded_root_name = std::string(root_tbl.begin()->first);
+            if (m_root_name_load_policy == RootNameLoadPolicy::KEEP_CURRENT) {
+                if (!root_tbl.contains(m_root_name)) {
+                    throw exceptions::ConfigLoadError(
+                        std::format(
+                            "Root name mismatch when loading config from file. Current root name is '{}', but file root name is '{}'. If you want to use the root name from the file, set the root name load policy to FROM_FILE using set_root_name_load_policy().",
+                            m_root_name,
+                            loaded_root_name
+                        )
+                    );
+                }
+                loaded_root_name = m_root_name;
+            }
+            root_was_first = root_tbl.begin()->first == loaded_root_name;
+
+            toml::node* root_node = root_tbl.get(loaded_root_name);
+            if (!root_node->is_table()) {
+                throw exceptions::ConfigParseError(
+                    std::format("Failed to load config from file: {}. Reason: root key '{}' is not a table.", path, loaded_root_name));
+            }
+
+            if constexpr (IsVersionedSchema<T>) {
+                io::migrate<T>(*root_node->as_table(), path);
+            }
+
+            // Fields the file leaves out are filled from the defaults; provenance is marked from
+            // the fields the file does contain.
+            std::optional<toml::table> file_fields;
+            if (!m_projection.empty()) {
+                // The projected subtrees replace theirs in the defaults; the rest of the file is dropped unread.
+                toml::table kept;
+                for (const std::string& projected_path : m_projection) io::move_subtree(*root_node->as_table(), kept, projected_path);
+                if (provenance != nullptr) file_fields = kept;
+                toml::table projected_table = io::default_table<T>();
+                for (const std::string& projected_path : m_projection) io::erase_subtree(projected_table, projected_path);
+                io::merge_tables(projected_table, kept);
+                *root_node->as_table() = std::move(projected_table);
+            }
+            if (m_missing_field_policy == MissingFieldPolicy::USE_DEFAULTS) {
+                toml::table filled = io::default_table<T>();
+                if (provenance != nullptr && !file_fields) file_fields = *root_node->as_table();
+                io::merge_tables(filled, *root_node->as_table());
+                *root_node->as_table() = std::move(filled);
+            }
+
+            std::vector<validate::ValidationIssue> expression_issues;
+            if (m_expressions) {
+                io::resolve_expressions<T>(*root_node->as_table(), loaded_root_name, expression_issues);
+            }
+
+            // Sidecar references are swapped for empty arrays so the table deserializes as usual;
+            // the arrays are filled from their files afterwards.
+            std::vector<io::SidecarReference> sidecars;
+            io::collect_sidecars(*root_node->as_table(), std::filesystem::path(path).parent_path(), sidecars);
+#if FOURDST_CONFIG_USE_ARROW
+            std::vector<io::ColumnarReference> columnar;
+            io::collect_columnar(*root_node->as_table(), std::filesystem::path(path).parent_path(), columnar);
+#endif
+
+            // Deserialize straight into T from the root table; no intermediate container.
+            const io::ScopedFieldResource field_resource(m_memory_resource);
+            const bool parallel = m_parallel_read.has_value() && m_memory_resource == nullptr && !io::contains_string_view_v<T>;
+            const io::ScopedParallelRead parallel_read(parallel ? &*m_parallel_read : nullptr);
+            const io::ScopedSectionDirectory section_directory(std::filesystem::path(path).parent_path());
+            const io::ScopedShardRead shard_read(m_shard_selector ? &*m_shard_selector : nullptr, std::filesystem::path(path).parent_path());
+            io::last_array_size_mismatch().reset();
+            std::optional<io::LoadPhase> phase(std::in_place, &LoadStats::deserialize_time);
+            rfl::Result<T> result = deserialize(root_node);
+            phase.reset();
+
+            if (!result) {
+                // A fixed-size array of the wrong length is caught while reading, so it is
+                // reported from that pass instead of running the validator over the document.
+                if (const auto& mismatch = io::last_array_size_mismatch()) {
+                    if (const auto where = io::find_node_path(*root_node->as_table(), loaded_root_name, mismatch->node)) {
+                        const validate::ValidationIssue issue =
+                            validate::located(*mismatch->node, {validate::IssueKind::ARRAY_SIZE_MISMATCH, *where, mismatch->message()});
+                        throw exceptions::ConfigParseError(
+                            std::format("Failed to load config from file: {}. Found 1 problem(s):{}",
+                                        path,
+                                        validate::summarize_issues({issue})),
+                            issue_location(issue, path)
+                        );
+                    }
+                }
+
+                // Collect every problem in one pass so a single failed launch reports all of them.
+                std::vector<validate::ValidationIssue> issues = std::move(expression_issues);
+                const std::size_t expression_count = issues.size();
+                phase.emplace(&LoadStats::validate_time);
+                if (const auto metrics = m_sync->metrics.load(std::memory_order_relaxed)) metrics->record_validation_failure();
+                {
+                    FOURDST_CONFIG_TRACE_ZONE(zone, "config.validate", loaded_root_name);
+                    validate::ConfigValidator<T>::validate(root_node->as_table(), loaded_root_name, issues, m_validation_options);
+                }
+                phase.reset();
+                // A bad expression is left in place as a string, which the validator reports again as a type mismatch.
+                issues.erase(std::remove_if(issues.begin() + static_cast<std::ptrdiff_t>(expression_count), issues.end(),
+                                            [&](const validate::ValidationIssue& issue) {
+                                                return std::any_of(issues.begin(), issues.begin() + static_cast<std::ptrdiff_t>(expression_count),
+                                                                   [&](const validate::ValidationIssue& bad) { return bad.path == issue.path; });
+                                            }),
+                             issues.end());
+
+                if (verbose) {
+                    std::vector<std::string> missing_fields;
+                    for (const auto& issue : issues) {
+                        if (issue.kind == validate::IssueKind::MISSING_FIELD) missing_fields.push_back(issue.path);
+                    }
+                    if (!missing_fields.empty()) {
+                        std::cerr << validate::report_all_missing_fields(missing_fields) << std::endl;
+                    }
+                }
+
+                if (issues.empty()) {
+                    throw exceptions::ConfigParseError(
+                        std::format("Failed to load config from file: {}. Reason: {}",
+                                    path,
+                                    result.error().what())
+                    );
+                }
+                throw exceptions::ConfigParseError(
+                    std::format("Failed to load config from file: {}. Found {} problem(s):{}",
+                                path,
+                                issues.size(),
+                                validate::summarize_issues(issues)),
+                    issue_location(issues.front(), path)
+                );
+            }
+
+            if (m_unknown_key_policy == UnknownKeyPolicy::REJECT) {
+                std::vector<validate::ValidationIssue> issues;
+                std::string key_path = loaded_root_name;
+                validate::ConfigValidator<T>::check_keys(*root_node->as_table(), key_path, issues);
+                if (!issues.empty()) {
+                    throw exceptions::ConfigParseError(
+                        std::format("Failed to load config from file: {}. Found {} unknown key(s):{}",
+                                    path,
+                                    issues.size(),
+                                    validate::summarize_issues(issues)),
+                        issue_location(issues.front(), path)
+                    );
+                }
+            }
+
+            if (m_deprecated_key_policy != DeprecatedKeyPolicy::ALLOW) {
+                std::vector<validate::ValidationIssue> issues;
+                std::string key_path = loaded_root_name;
+                validate::ConfigValidator<T>::check_aliases(*root_node->as_table(), key_path, issues);
+                if (!issues.empty() && m_deprecated_key_policy == DeprecatedKeyPolicy::REJECT) {
+                    throw exceptions::ConfigParseError(
+                        std::format("Failed to load config from file: {}. Found {} renamed key(s):{}",
+                                    path,
+                                    issues.size(),
+                                    validate::summarize_issues(issues)),
+                        issue_location(issues.front(), path)
+                    );
+                }
+                if (!issues.empty()) {
+                    std::cerr << std::format("Config file {} uses {} renamed key(s):{}", path, issues.size(), validate::summarize_issues(issues))
+                              << std::endl;
+                }
+            }
+
+            if (provenance != nullptr) {
+                provenance->mark_table(file_fields ? *file_fields : *root_node->as_table(), {FieldSource::FILE, 0});
+            }
+            T content = std::move(result).value();
+            phase.emplace(&LoadStats::deserialize_time);
+            io::load_sidecars(content, sidecars);
+#if FOURDST_CONFIG_USE_ARROW
+            io::load_columnar(content, columnar);
+#endif
+            bind_sinks(content);
+            return content;
+        }
+
+        /**
+         * @brief Replaces the content by move-constructing it from `loaded`.
+         *
+         * Move assignment would copy `std::pmr` members whose allocator differs from the current
+         * one; move construction keeps the allocator `loaded` was deserialized with.
+         * Must be called while holding the content lock.
+         */
+        void replace_content(T&& loaded) {
+            if constexpr (std::is_nothrow_move_constructible_v<T>) {
+                std::destroy_at(&m_content);
+                std::construct_at(&m_content, std::move(loaded));
+            } else {
+                m_content = std::move(loaded);
+            }
+        }
+
+        /**
+         * @brief Makes freshly loaded content current, as the new baseline for `reset()`.
+         */
+        void install_loaded(T loaded, std::string loaded_root_name, const std::string_view path,
+                            std::unique_ptr<ProvenanceRecord<T>> provenance, std::shared_ptr<io::StringStore> strings = nullptr) {
+            apply_environment(loaded, provenance.get());
+            std::shared_ptr<const T> previous;
+            {
+                const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+                apply_overrides(loaded, provenance.get());
+                if (m_compaction) detail::compact(loaded);
+                m_root_name = std::move(loaded_root_name);
+                replace_content(std::move(loaded));
+                m_strings = std::move(strings);
+                m_source_path = path;
+                m_source_stamps.clear();
+                m_last_document.reset();
+                forget_edits();
+                m_state = ConfigState::LOADED_FROM_FILE;
+                previous = publish();
+                m_origin = snapshot();
+                install_provenance(std::move(provenance));
+                clear_history();
+            }
+            notify(previous);
+        }
+
+        /// The source path recorded by `load_from()`.
+        static constexpr std::string_view memory_source = "<memory>";
+
+        /// The path that names standard input (see `load()`).
+        static constexpr std::string_view stdin_source = "-";
+
+        /**
+         * @brief Returns the format of an in-memory document: the configured one, or under `AUTO`, JSON if it starts with `{` and a namelist if it starts with `&`.
+         */
+        [[nodiscard]] FileFormat content_format(const std::string_view content) const {
+            if (m_file_format != FileFormat::AUTO) return m_file_format;
+            const std::size_t first = content.find_first_not_of(" \t\r\n");
+            if (first == std::string_view::npos) return FileFormat::TOML;
+            if (content[first] == '{') return FileFormat::JSON;
+            return content[first] == '&' ? FileFormat::NAMELIST : FileFormat::TOML;
+        }
+
+        /**
+         * @brief Reads and parses the deck piped to standard input.
+         */
+        T read_stdin(const bool verbose, std::string& loaded_root_name, ProvenanceRecord<T>* provenance) const {
+            const std::string content = io::read_stdin();
+            bool root_was_first = false;
+            const FileFormat format = content_format(content);
+            check_parse_limits(content, stdin_source, format);
+            return parse_content(content, stdin_source, format, verbose, loaded_root_name, root_was_first, provenance);
+        }
+
+        /**
+         * @brief Reads a file on a helper thread within `deadline` (see deadline.h), then parses it.
+         * @param stamps Receives the stamp of the file, taken before it was read.
+         */
+        T read_file_within(const std::string_view path, const LoadDeadline& deadline, const bool verbose, std::string& loaded_root_name,
+                           ProvenanceRecord<T>* provenance, std::vector<io::FileStamp>& stamps) const {
+            io::DeadlineRead read;
+            {
+                const io::LoadPhase phase(&LoadStats::read_time);
+                read = io::read_within(std::string(path), deadline);
+            }
+            io::note_bytes_read(read.text.size());
+            stamps = std::move(read.stamps);
+            bool root_was_first = false;
+            const FileFormat format = resolve_file_format(path);
+            check_parse_limits(read.text, path, format);
+            return parse_content(read.text, path, format, verbose, loaded_root_name, root_was_first, provenance);
+        }
+
+        /// Leads every `serialize_to()` message ("FDCW" in little-endian order).
+        static constexpr std::uint32_t wire_magic = 0x57434446;
+
+        /// Leads every `checkpoint()` ("FDCK" in little-endian order).
+        static constexpr std::uint32_t checkpoint_magic = 0x4B434446;
+
+        /**
+         * @brief Swaps in freshly read content, as the new baseline for `reset()`, if it differs from the current one.
+         */
+        bool install_reloaded(T loaded, std::string loaded_root_name, const std::string& source,
+                              std::unique_ptr<ProvenanceRecord<T>> provenance, const bool clear_layers,
+                              std::shared_ptr<io::StringStore> strings = nullptr, const bool with_environment = true) {
+            if (with_environment) apply_environment(loaded, provenance.get());
+            std::shared_ptr<const T> previous;
+            bool changed;
+            {
+                const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+                apply_overrides(loaded, provenance.get());
+                if (m_compaction) detail::compact(loaded);
+                if (clear_layers) {
+                    forget_layers();
+                }
+                changed = !detail::equal(loaded, m_content);
+                if (changed) {
+                    if (m_reload_recycling) {
+                        // The replaced content becomes the storage the next reload reads into.
+                        std::swap(m_content, loaded);
+                    } else {
+                        replace_content(std::move(loaded));
+                    }
+                    m_strings = std::move(strings);
+                }
+                if (m_reload_recycling) {
+                    m_spare = std::move(loaded);
+                }
+                m_root_name = std::move(loaded_root_name);
+                m_source_path = source;
+                m_source_stamps.clear();
+                m_last_document.reset();
+                forget_edits();
+                m_state = ConfigState::LOADED_FROM_FILE;
+                if (changed) {
+                    previous = publish();
+                }
+                m_origin = snapshot();
+                install_provenance(std::move(provenance));
+                clear_history();
+            }
+            if (changed) {
+                notify(previous);
+                if (m_reload_recycling) {
+                    const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+                    m_retired = std::move(previous);
+                }
+            }
+            return changed;
+        }
+
+        /**
+         * @brief Reads a fetched source document, from its local file or from memory.
+         */
+        T read_source(const SourceData& data, const std::string& name, const bool verbose, std::string& loaded_root_name,
+                      ProvenanceRecord<T>* provenance) const {
+            if (!data.local_path.empty()) {
+                return read_file(data.local_path, verbose, loaded_root_name, provenance);
+            }
+            bool root_was_first = false;
+            const FileFormat format = resolve_file_format(detail::strip_query(name));
+            check_parse_limits(data.content, name, format);
+            return parse_content(data.content, name, format, verbose, loaded_root_name, root_was_first, provenance);
+        }
+
+        /**
+         * @brief Fetches from `source` again and swaps in the document unless the source reports `known` current.
+         */
+        bool reload_source(const std::shared_ptr<ConfigSource>& source, const SourceValidator& known, const bool verbose) {
+            SourceData data = source->fetch(known);
+            if (data.not_modified) {
+                return false;
+            }
+            const std::string name = source->name();
+            std::string loaded_root_name;
+            auto provenance = fresh_provenance();
+            auto strings = fresh_strings();
+            const io::ScopedStringStore string_scope(strings.get());
+            T loaded = read_source(data, name, verbose, loaded_root_name, provenance.get());
+            const bool changed = install_reloaded(std::move(loaded), std::move(loaded_root_name), name, std::move(provenance), true,
+                                                  std::move(strings));
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            m_source_validator = std::move(data.validator);
+            return changed;
+        }
+
+        /**
+         * @brief Records the stamps of the files the content was just read from; call after installing it.
+         * @param stamps The stamps taken before reading.
+         * @param document The parsed document, if it is kept for `set_incremental_reload()`.
+         * @param spans Where the values lie in the file, if they were recorded for `set_format_preserving_saves()`.
+         */
+        void remember_stamps(std::vector<io::FileStamp> stamps, std::shared_ptr<const toml::table> document = nullptr,
+                             std::optional<io::ValueSpans> spans = std::nullopt) {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            if (spans && stamps.size() == 1 && m_source_path == stamps.front().path) {
+                std::lock_guard edit_lock(m_sync->saved_mutex);
+                m_sync->edit = EditState{m_source_path, std::move(*spans), m_origin, stamps.front().size, stamps.front().mtime};
+            }
+            m_source_stamps = std::move(stamps);
+            m_stamped_settings = load_settings_key();
+            m_last_document = m_incremental_reload ? std::move(document) : nullptr;
+        }
+
+        /**
+         * @brief Drops the loaded file format-preserving saves edit, or only if it is `path`.
+         */
+        void forget_edits(const std::optional<std::string_view> path = std::nullopt) const {
+            std::lock_guard lock(m_sync->saved_mutex);
+            if (!path || (m_sync->edit && m_sync->edit->path == *path)) m_sync->edit.reset();
+        }
+
+        /**
+         * @brief Whether the content read from a file is exactly what its text says, so changes can be spliced into it.
+         */
+        [[nodiscard]] bool content_matches_text() const {
+            return !IsVersionedSchema<T> && m_env_prefix.empty() && m_overrides.empty() && !m_expressions;
+        }
+
+        /**
+         * @brief Parses `path` for `set_incremental_reload()` or `set_format_preserving_saves()`, or returns null if the file is read as usual.
+         * @param spans Set to where the values lie in the file when they are recorded for `set_format_preserving_saves()`.
+         */
+        std::shared_ptr<toml::table> parse_for_incremental(const std::string_view path, const ProvenanceRecord<T>* provenance,
+                                                           std::optional<io::ValueSpans>* spans = nullptr) const {
+            if ((!m_incremental_reload && !m_format_preserving_saves) || m_file_read_policy == FileReadPolicy::STREAMING || provenance != nullptr || m_shard_selector ||
+                !m_projection.empty() || !m_sinks.empty() || m_memory_resource != nullptr || io::contains_string_view_v<T> || resolve_file_format(path) != FileFormat::TOML || !std::filesystem::exists(path)) {
+                return nullptr;
+            }
+            const io::Compression compression = io::compression_for(path);
+            std::optional<io::MappedFile> mapped;
+            std::string decompressed;
+            if (compression == io::Compression::NONE) {
+                mapped.emplace(map_source(path, m_file_read_policy));
+            } else {
+                decompressed = decompress_source(path, compression);
+            }
+            const std::string_view bytes = mapped ? mapped->view() : std::string_view(decompressed);
+            // Sidecar and columnar references are replaced while reading, so the document would not match the file;
+            // shard files can change while the document does not.
+            bool references = bytes.find(io::sidecar_key) != std::string_view::npos ||
+                              bytes.find(io::shards_key) != std::string_view::npos;
+#if FOURDST_CONFIG_USE_ARROW
+            references = references || bytes.find(io::columnar_key) != std::string_view::npos;
+#endif
+            if (references) {
+                return nullptr;
+            }
+            check_parse_limits(bytes, path, FileFormat::TOML);
+            auto document = std::make_shared<toml::table>();
+            const io::LoadPhase phase(&LoadStats::parse_time);
+            try {
+                *document = toml::parse(bytes, path);
+            } catch (const toml::parse_error& e) {
+                throw_unparseable(e, path);
+            }
+            if constexpr (io::is_streamable_v<T>) {
+                if (spans != nullptr && m_format_preserving_saves && compression == io::Compression::NONE && content_matches_text()) {
+                    *spans = io::value_spans(*document, bytes, path);
+                }
+            }
+            io::resolve_includes(*document, path);
+            return document;
+        }
+
+        /**
+         * @brief Patches the values that differ between the kept document and `document` into the content.
+         *
+         * Only the changed values are deserialized; the rest of the content is kept.
+         *
+         * @return Whether the content changed, or nothing if `document` has to be read in full.
+         */
+        std::optional<bool> reload_changed_tables(toml::table& document, const std::string& source) {
+            std::shared_ptr<const toml::table> before;
+            std::string root;
+            {
+                const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+                // A patched field keeps its environment value, but a variable that was unset has to be dropped.
+                if (!m_last_document || m_state != ConfigState::LOADED_FROM_FILE || m_stamped_settings != load_settings_key() ||
+                    m_expressions || !m_env_prefix.empty()) {
+                    return std::nullopt;
+                }
+                before = m_last_document;
+                root = m_root_name;
+            }
+            if (document.empty() ||
+                (m_root_name_load_policy == RootNameLoadPolicy::FROM_FILE && document.begin()->first.str() != root)) {
+                return std::nullopt;
+            }
+            const toml::table* old_root = before->get_as<toml::table>(root);
+            toml::table* new_root = document.get_as<toml::table>(root);
+            if (old_root == nullptr || new_root == nullptr) {
+                return std::nullopt;
+            }
+            if constexpr (IsVersionedSchema<T>) {
+                // The kept document was migrated when it was read.
+                io::migrate<T>(*new_root, source);
+            }
+            std::optional<toml::table> patch = io::diff_toml_tables(*old_root, *new_root);
+            if (!patch) {
+                return std::nullopt;
+            }
+
+            if (patch->empty()) {
+                const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+                if (m_state != ConfigState::LOADED_FROM_FILE) return std::nullopt;
+                forget_layers();
+                m_source_path = source;
+                return false;
+            }
+            std::optional<T> patched;
+            {
+                const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+                if (m_state != ConfigState::LOADED_FROM_FILE) return std::nullopt;
+                patched.emplace(m_content);
+            }
+            try {
+                const io::LoadPhase phase(&LoadStats::deserialize_time);
+                io::apply_toml_patch(*patched, *patch);
+            } catch (const exceptions::ConfigPathError&) {
+                return std::nullopt;
+            } catch (const exceptions::ConfigParseError&) {
+                return std::nullopt;
+            }
+            return install_reloaded(std::move(*patched), std::move(root), source, nullptr, true);
+        }
+
+        /**
+         * @brief Hashes the settings that decide what a load makes of unchanged files.
+         *
+         * Changing one of them (e.g. `set_root_name()`) makes the next `reload()` read the files
+         * even if they did not change.
+         */
+        [[nodiscard]] std::uint64_t load_settings_key() const {
+            return io::hash_bytes(std::format("{}\n{}\n{}\n{}\n{}\n{}\n{}\n{}\n{}\n{}\n{}", m_root_name, static_cast<int>(m_root_name_load_policy),
+                                              static_cast<int>(m_file_format), static_cast<const void*>(m_memory_resource),
+                                              m_string_interning, static_cast<bool>(m_provenance), m_env_prefix,
+                                              static_cast<int>(m_missing_field_policy), static_cast<int>(m_unknown_key_policy),
+                                              static_cast<int>(m_deprecated_key_policy), m_expressions));
+        }
+
+        /**
+         * @brief Forgets the layers of the last `load_layers()` or `load_directory()`; call under the content lock.
+         */
+        void forget_layers() {
+            m_layer_paths.clear();
+            m_layer_directory.clear();
+            m_parsed_layers.clear();
+        }
+
+        /**
+         * @brief Drops the `ConfigSource` of the last load, once content was read from elsewhere.
+         */
+        void forget_source() {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            m_source.reset();
+            m_source_validator = {};
+        }
+
+        /**
+         * @brief Parses a layer file after checking it against the limits of `set_parse_limits()`.
+         */
+        toml::table parse_checked_layer(const std::string& path) const {
+            check_file_size(path);
+            const io::Compression compression = io::compression_for(path);
+            std::optional<io::MappedFile> mapped;
+            std::string decompressed;
+            if (compression == io::Compression::NONE) {
+                mapped.emplace(path, io::ReadMode::READ);
+            } else {
+                decompressed = io::read_compressed(path, compression);
+            }
+            const std::string_view bytes = mapped ? mapped->view() : std::string_view(decompressed);
+            check_parse_limits(bytes, path, FileFormat::TOML);
+            return toml::parse(bytes, path);
+        }
+
+        /**
+         * @brief A parsed layer file, kept so a reload parses only the layers that changed.
+         */
+        struct ParsedLayer {
+            std::string path;
+            std::uint64_t hash = 0;
+            std::uintmax_t size = 0;
+            std::shared_ptr<const toml::table> table;
+        };
+
+        /**
+         * @brief Parses one layer file, resolving its includes and anchoring its sidecar paths.
+         */
+        std::shared_ptr<toml::table> parse_layer(const std::string& path) const {
+            if (!std::filesystem::exists(path)) {
+                throw exceptions::ConfigLoadError(
+                    std::format("Config file does not exist: {}", path));
+            }
+            auto layer = std::make_shared<toml::table>();
+            try {
+                *layer = m_parse_limits.any() ? parse_checked_layer(path) : io::parse_toml_file(path);
+            } catch (const toml::parse_error& e) {
+                throw_unparseable(e, path);
+            }
+            io::resolve_includes(*layer, path);
+            // Sidecar file names are relative to the layer that names them, not to the last layer.
+            io::anchor_sidecars(*layer, std::filesystem::path(path).parent_path());
+#if FOURDST_CONFIG_USE_ARROW
+            io::anchor_columnar(*layer, std::filesystem::path(path).parent_path());
+#endif
+            return layer;
+        }
+
+        /**
+         * @brief Parses and deep-merges layer files and deserializes the result once.
+         *
+         * The files are parsed in parallel and merged in order.
+         *
+         * @param stamps The stamps of `paths`, taken before reading; needed to use or refill `cache`.
+         * @param cache The layers parsed by the last read. A layer whose stamp still matches is not
+         *              parsed again; on return the cache holds the layers of this read.
+         */
+        T read_layers(const std::vector<std::string>& paths, const bool verbose, std::string& loaded_root_name,
+                      ProvenanceRecord<T>* provenance, const std::vector<io::FileStamp>* stamps = nullptr,
+                      std::vector<ParsedLayer>* cache = nullptr) const {
+            if (paths.empty()) {
+                throw exceptions::ConfigLoadError("Cannot load config layers: no files were given.");
+            }
+            const bool stamped = stamps != nullptr && stamps->size() == paths.size();
+
+            std::vector<std::shared_ptr<const toml::table>> layers(paths.size());
+            std::vector<std::size_t> unparsed;
+            for (std::size_t i = 0; i < paths.size(); ++i) {
+                if (stamped && cache != nullptr) {
+                    const io::FileStamp& stamp = (*stamps)[i];
+                    const auto cached = std::ranges::find_if(*cache, [&](const ParsedLayer& layer) {
+                        return layer.path == stamp.path && layer.hash == stamp.hash && layer.size == stamp.size;
+                    });
+                    if (cached != cache->end()) {
+                        layers[i] = cached->table;
+                        continue;
+                    }
+                }
+                unparsed.push_back(i);
+            }
+
+            std::vector<std::exception_ptr> errors(paths.size());
+            std::atomic<std::size_t> next{0};
+            const std::size_t workers = std::min<std::size_t>(unparsed.size(), std::max(1u, std::thread::hardware_concurrency()));
+            bulk_execute(workers, [&](std::size_t) {
+                for (std::size_t u = next.fetch_add(1, std::memory_order_relaxed); u < unparsed.size();
+                     u = next.fetch_add(1, std::memory_order_relaxed)) {
+                    const std::size_t i = unparsed[u];
+                    try {
+                        layers[i] = parse_layer(paths[i]);
+                    } catch (...) {
+                        errors[i] = std::current_exception();
+                    }
+                }
+            });
+            // The error reported is the one a sequential read would have met first.
+            for (const std::exception_ptr& error : errors) {
+                if (error) std::rethrow_exception(error);
+            }
+
+            // Tables keep their keys sorted, so the first root of the merged table is the smallest
+            // first root among the layers.
+            std::string root = m_root_name;
+            if (m_root_name_load_policy == RootNameLoadPolicy::FROM_FILE) {
+                root.clear();
+                for (const auto& layer : layers) {
+                    if (!layer->empty() && (root.empty() || layer->begin()->first.str() < root)) {
+                        root = std::string(layer->begin()->first.str());
+                    }
+                }
+            }
+
+            toml::table merged;
+            for (std::size_t i = 0; i < layers.size(); ++i) {
+                if (provenance != nullptr) {
+                    if (const toml::table* layer_root = (*layers[i])[root].as_table()) {
+                        provenance->mark_table(*layer_root, {FieldSource::FILE, static_cast<std::uint8_t>(i)});
+                    }
+                }
+                if (cache == nullptr) {
+                    // Nothing keeps the parsed layers, so their values can be moved into the merge.
+                    io::merge_tables(merged, const_cast<toml::table&>(*layers[i]));
+                } else {
+                    io::merge_tables(merged, *layers[i]);
+                }
+            }
+
+            if (cache != nullptr) {
+                cache->clear();
+                if (stamped) {
+                    for (std::size_t i = 0; i < paths.size(); ++i) {
+                        cache->push_back({paths[i], (*stamps)[i].hash, (*stamps)[i].size, std::move(layers[i])});
+                    }
+                }
+            }
+
+            bool root_was_first = false;
+            return read_table(merged, paths.back(), verbose, loaded_root_name, root_was_first);
+        }
+
+        /**
+         * @brief Sets the fields named by environment variables with the prefix, in freshly read content.
+         */
+        void apply_environment(T& content, ProvenanceRecord<T>* provenance) const {
+            if (m_env_prefix.empty()) return;
+            detail::apply_environment(content, m_env_prefix, [provenance](const std::size_t index, const std::size_t count) {
+                // Name table entries are numbered in the same pre-order as provenance ordinals.
+                if (provenance != nullptr) {
+                    provenance->mark(index, count, {FieldSource::ENVIRONMENT, 0});
+                }
+            });
+        }
+
+        /**
+         * @brief Returns the environment variable consulted for a field path.
+         */
+        [[nodiscard]] std::string env_name(const std::string_view path) const {
+            std::string name = m_env_prefix;
+            for (const char c : path) {
+                if (c == '.') {
+                    name += "__";
+                } else {
+                    name += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+                }
+            }
+            return name;
+        }
+
+        /**
+         * @brief Applies the registered overrides to freshly read content. Requires the content lock.
+         */
+        void apply_overrides(T& content, ProvenanceRecord<T>* provenance) const {
+            for (const auto& override_entry : m_overrides) {
+                override_entry.apply(content);
+                if (provenance != nullptr) {
+                    const detail::FieldRange range = detail::find_field<T>(override_entry.path);
+                    provenance->mark(range.ordinal, range.count, {FieldSource::OVERRIDE, 0});
+                }
+            }
+        }
+
+        /**
+         * @brief Returns an empty provenance record if tracking is enabled, null otherwise.
+         */
+        [[nodiscard]] std::unique_ptr<ProvenanceRecord<T>> fresh_provenance() const {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            return m_provenance ? std::make_unique<ProvenanceRecord<T>>() : nullptr;
+        }
+
+        /**
+         * @brief Makes the provenance of freshly loaded content current. Requires the content lock.
+         *
+         * A null record (tracking was off when the load started) leaves the current state alone.
+         */
+        void install_provenance(std::unique_ptr<ProvenanceRecord<T>> provenance) {
+            if (provenance && m_provenance) {
+                m_provenance = std::move(provenance);
+                m_origin_provenance = m_provenance;
+            }
+        }
+
+        /**
+         * @brief Attributes the leaf fields that differ from `previous` to `source`. Requires the content lock.
+         */
+        void mark_changes(const T& previous, const FieldSource source) {
+            if (!m_provenance) return;
+            auto provenance = std::make_shared<ProvenanceRecord<T>>(*m_provenance);
+            provenance->mark_changes(previous, m_content, {source, 0});
+            m_provenance = std::move(provenance);
+        }
+
+        /**
+         * @brief A published mutation waiting to be pushed to the audit log once the content lock is released.
+         */
+        struct PendingAudit {
+            std::shared_ptr<AuditLog> log;
+            std::shared_ptr<const T> before;
+            std::shared_ptr<const T> after;
+            std::uint64_t generation = 0;
+            std::chrono::system_clock::time_point time;
+        };
+
+        /**
+         * @brief Captures the mutation that just replaced `previous`, if an audit log is set. Requires the content lock.
+         */
+        [[nodiscard]] PendingAudit pending_audit(std::shared_ptr<const T> previous) const {
+            if (!m_audit_log) return {};
+            return {m_audit_log, std::move(previous), snapshot(), m_sync->generation.load(std::memory_order_relaxed),
+                    std::chrono::system_clock::now()};
+        }
+
+        /**
+         * @brief Lists the fields a captured mutation changed and pushes its record to the audit log.
+         */
+        static void audit(PendingAudit pending) {
+            if (!pending.log) return;
+            MutationRecord record{pending.generation, pending.time, std::this_thread::get_id(), {}};
+            detail::changed_paths<T>(*pending.before, *pending.after, 0, record.paths);
+            pending.log->push(std::move(record));
+        }
+
+        /**
+         * @brief Drops the undo history. Requires the content lock.
+         */
+        void clear_history() {
+            m_history.clear();
+            m_provenance_history.clear();
+        }
+
+        struct Override {
+            std::string path;
+            std::function<void(T&)> apply;
+        };
+
+        struct Subscription {
+            std::size_t id;
+            std::string path;
+            /// Entry of `PathTable<T>` for `path`, or `npos` for the whole config.
+            std::size_t ordinal;
+            ChangeCallback callback;
+        };
+
+        /**
+         * @brief A file written by `save()`: the hash of what was written and the file's size and time after writing.
+         */
+        struct SavedFile {
+            std::uint64_t stamp = 0;
+            std::uintmax_t size = 0;
+            std::filesystem::file_time_type mtime{};
+        };
+
+        /**
+         * @brief The loaded file `save()` can splice changed values into: where its values lie and what it holds.
+         */
+        struct EditState {
+            std::string path;
+            io::ValueSpans spans;
+            std::shared_ptr<const T> baseline;
+            std::uintmax_t size = 0;
+            std::filesystem::file_time_type mtime{};
+        };
+
+        /**
+         * @brief The published snapshot and the locks, kept out of line so the config can be moved.
+         */
+        struct Sync {
+            explicit Sync(std::shared_ptr<const T> initial) : snapshot(initial) {
+                inline_copy.store(*initial);
+                store_hot(*initial);
+            }
+
+            Sync(const Sync&) = delete;
+            Sync& operator=(const Sync&) = delete;
+
+            /// Resumes the coroutines still awaiting `changes()` with an empty snapshot.
+            ~Sync() { changes->close(); }
+
+            /// Stores the hot fields of `content` into `hot`; does nothing for schemas without hot fields.
+            void store_hot(const T& content) noexcept {
+                if constexpr (detail::has_hot_fields_v<T>) {
+                    HotBlock<T> block{};
+                    detail::fill_hot_block(content, block);
+                    hot.store(block);
+                }
+            }
+
+            std::atomic<std::shared_ptr<const T>> snapshot;
+            /// A copy of `snapshot` for `copy()`, kept only for small trivially copyable schemas.
+            detail::Seqlock<T> inline_copy;
+            /// The hot fields of `snapshot` for `hot()`, on a cache line of their own; empty without `hot_fields<T>`.
+            alignas(detail::cache_line_bytes) detail::Seqlock<HotBlock<T>, detail::has_hot_fields_v<T>> hot;
+            /// Incremented after every change of `snapshot` or `replicas`.
+            std::atomic<std::uint64_t> version{0};
+            /// Incremented after every change of `snapshot`, and only then; see `generation()`.
+            std::atomic<std::uint64_t> generation{0};
+            std::mutex retention_mutex;
+            /// The last published snapshots by consecutive generation, kept for `at_generation()`.
+            std::deque<VersionedSnapshot> retained;
+            /// One copy of `snapshot` per NUMA node while replication is enabled, null otherwise.
+            std::atomic<std::shared_ptr<const std::vector<std::shared_ptr<const T>>>> replicas;
+            /// Held exclusively by writers and shared by `read()` guards.
+            std::shared_mutex content_mutex;
+            /// Set while a `load_async()` runs.
+            std::atomic<bool> loading{false};
+            /// Contention on `content_mutex`, recorded while enabled with `set_lock_stats()`.
+            detail::LockCounters lock_counters;
+            /// The metrics set with `set_metrics()`; here rather than in `Config` so loads read it without the lock.
+            std::atomic<std::shared_ptr<ConfigMetrics>> metrics;
+            /// Counts stores into `Tunable` fields, which change the content in place; see `tunable_stores()`.
+            std::atomic<std::uint64_t> tunable_stores{0};
+            std::mutex fingerprint_mutex;
+            std::mutex saved_mutex;
+            /// What `save()` last wrote to each path, kept while `set_skip_unchanged_saves()` is enabled.
+            std::unordered_map<std::string, SavedFile> saved;
+            /// The file format-preserving saves edit, guarded by `saved_mutex`; see `set_format_preserving_saves()`.
+            std::optional<EditState> edit;
+            std::mutex subscription_mutex;
+            std::mutex derived_mutex;
+            /// Values memoized by `derived()`, keyed by `DerivedKey`.
+            std::unordered_map<std::type_index, DerivedValue> derived;
+            /// The coroutines awaiting `changes()`; shared with the streams, which may outlive the config.
+            std::shared_ptr<detail::ChangeChannel<VersionedSnapshot>> changes =
+                std::make_shared<detail::ChangeChannel<VersionedSnapshot>>([this] {
+                    const std::uint64_t current = generation.load(std::memory_order_acquire);
+                    return VersionedSnapshot{snapshot.load(std::memory_order_acquire), current};
+                });
+#if FOURDST_CONFIG_USE_ACCESS_COUNTERS
+            /// Reads through `get()`, per path table entry.
+            detail::AccessCounters<T> accesses;
+#endif
+        };
+
+        /**
+         * @brief Makes `next` the published snapshot and advances the version `ConfigReader` caches check.
+         * @return The snapshot that was replaced.
+         */
+        std::shared_ptr<const T> swap_snapshot(std::shared_ptr<const T> next) {
+            next = detail::make_resident(std::move(next), m_residency);
+            // Replicas go first: a reader that sees them before the new version only refreshes again.
+            if (m_numa_replication) replicate_snapshot(next);
+            m_sync->inline_copy.store(*next);
+            m_sync->store_hot(*next);
+            std::shared_ptr<const T> dropped;
+            if (m_retention > 0) {
+                // Retained before the generation advances, so any generation a reader sees is found by at_generation().
+                const std::lock_guard lock(m_sync->retention_mutex);
+                m_sync->retained.push_back({next, m_sync->generation.load(std::memory_order_relaxed) + 1});
+                if (m_sync->retained.size() > m_retention) {
+                    dropped = std::move(m_sync->retained.front().content);
+                    m_sync->retained.pop_front();
+                }
+            }
+            if (const auto metrics = m_sync->metrics.load(std::memory_order_acquire)) {
+                metrics->publish(next, m_sync->generation.load(std::memory_order_relaxed) + 1, &snapshot_bytes);
+            }
+            std::shared_ptr<const T> previous = m_sync->snapshot.exchange(std::move(next), std::memory_order_acq_rel);
+            m_sync->version.fetch_add(1, std::memory_order_release);
+            m_sync->generation.fetch_add(1, std::memory_order_release);
+            return previous;
+        }
+
+        /**
+         * @brief Returns the inline and heap bytes of a snapshot, for the gauge of `ConfigMetrics`.
+         */
+        static std::size_t snapshot_bytes(const void* content) {
+            return sizeof(T) + detail::heap_usage(*static_cast<const T*>(content)).heap_bytes;
+        }
+
+        /**
+         * @brief Times one operation into the metrics set with `set_metrics()`, if any, while the result lives.
+         */
+        [[nodiscard]] detail::MetricsScope measure(const ConfigMetrics::Operation operation) const {
+            return {m_sync->metrics.load(std::memory_order_acquire), operation};
+        }
+
+        /**
+         * @brief Stores one copy of `source` per NUMA node, each made on that node. Requires the content lock.
+         *
+         * A replica also holds `source`, which keeps alive whatever the snapshot's string views point into.
+         */
+        void replicate_snapshot(const std::shared_ptr<const T>& source) {
+            const std::size_t nodes = numa::node_count();
+            if (nodes <= 1) return;
+            struct Replica {
+                std::shared_ptr<const T> source;
+                T content;
+            };
+            auto replicas = std::make_shared<std::vector<std::shared_ptr<const T>>>(nodes);
+            for (std::size_t node = 0; node < nodes; ++node) {
+                numa::run_on_node(node, [&] {
+                    auto replica = std::make_shared<const Replica>(Replica{source, *source});
+                    (*replicas)[node] = detail::make_resident(std::shared_ptr<const T>(replica, &replica->content), m_residency);
+                });
+            }
+            m_sync->replicas.store(std::move(replicas), std::memory_order_release);
+        }
+
+        /**
+         * @brief Publishes a copy of the current content as the new reader snapshot.
+         * @return The snapshot that was replaced.
+         */
+        std::shared_ptr<const T> publish() {
+            if constexpr (io::contains_string_view_v<T>) {
+                // The snapshot shares ownership of the store its string views point into.
+                struct Retained {
+                    std::shared_ptr<io::StringStore> strings;
+                    T content;
+                };
+                auto retained = std::make_shared<const Retained>(Retained{m_strings, m_content});
+                return swap_snapshot(std::shared_ptr<const T>(retained, &retained->content));
+            } else {
+                if (m_compaction) {
+                    auto compacted = std::make_shared<const detail::CompactedContent<T>>(m_content);
+                    return swap_snapshot(std::shared_ptr<const T>(compacted, &compacted->content));
+                }
+                // A locked snapshot unlocks its pages on release, so it is not reused.
+                if (m_retired && m_retired.use_count() == 1 && m_residency != Residency::LOCKED) {
+                    // Nobody else holds the retired snapshot and nobody can acquire it again, so its
+                    // storage takes the new content by assignment. The fence pairs with the release
+                    // of the last reader's reference.
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    {
+                        // The fingerprint cache compares snapshot addresses, which are about to repeat.
+                        std::lock_guard lock(m_sync->fingerprint_mutex);
+                        m_fingerprint_snapshot.reset();
+                    }
+                    std::shared_ptr<const T> recycled = std::move(m_retired);
+                    const_cast<T&>(*recycled) = m_content;
+                    return swap_snapshot(std::move(recycled));
+                }
+                m_retired.reset();
+                // Created non-const, so that a retired snapshot can be recycled as above.
+                return swap_snapshot(std::make_shared<T>(m_content));
+            }
+        }
+
+        /**
+         * @brief Returns the store patched string views are kept in, creating it if needed. Requires the content lock.
+         */
+        io::StringStore* patch_strings() {
+            if constexpr (io::contains_string_view_v<T>) {
+                if (!m_strings) m_strings = std::make_shared<io::StringStore>(m_string_interning);
+            }
+            return m_strings.get();
+        }
+
+        /**
+         * @brief Returns a new string store if `T` has `std::string_view` fields, null otherwise.
+         */
+        [[nodiscard]] std::shared_ptr<io::StringStore> fresh_strings() const {
+            if constexpr (io::contains_string_view_v<T>) {
+                return std::make_shared<io::StringStore>(m_string_interning);
+            } else {
+                return nullptr;
+            }
+        }
+
+        /**
+         * @brief Records a replaced snapshot as an undo step, dropping the oldest beyond the limit.
+         *
+         * Must be called while holding the content lock.
+         */
+        void record_history(std::shared_ptr<const T> previous) {
+            if (m_history_limit == 0) return;
+            m_history.push_back(std::move(previous));
+            m_provenance_history.push_back(m_provenance);
+            if (m_history.size() > m_history_limit) {
+                m_history.pop_front();
+                m_provenance_history.pop_front();
+            }
+        }
+
+        /**
+         * @brief The state the config returns to when its baseline content is restored.
+         */
+        [[nodiscard]] ConfigState baseline_state() const {
+            return m_source_path.empty() ? ConfigState::DEFAULT : ConfigState::LOADED_FROM_FILE;
+        }
+
+        /**
+         * @brief Resumes the coroutines awaiting `changes()` and runs the callbacks whose subtree
+         * differs between `previous` and the current snapshot.
+         *
+         * Must be called without holding the content lock. The subscriber list is copied first, so
+         * callbacks may subscribe or unsubscribe without deadlocking.
+         */
+        void notify(const std::shared_ptr<const T>& previous) {
+            m_sync->changes->publish(versioned_snapshot());
+            std::vector<std::shared_ptr<const Subscription>> subscriptions;
+            {
+                std::lock_guard lock(m_sync->subscription_mutex);
+                if (m_subscriptions.empty()) return;
+                subscriptions = m_subscriptions;
+            }
+            using Table = detail::PathTable<T>;
+            const auto& same = Table::template functions<bool(const void*, const void*), detail::FieldEqual>();
+            const auto current = snapshot();
+            for (const auto& sub : subscriptions) {
+                const bool changed = sub->ordinal == Table::npos
+                                         ? !detail::equal(*previous, *current)
+                                         : !same[sub->ordinal](Table::entry(sub->ordinal).address(*previous),
+                                                               Table::entry(sub->ordinal).address(*current));
+                if (changed) sub->callback(current);
+            }
+        }
+
+        T m_content{};
+        std::shared_ptr<const T> m_origin = std::make_shared<const T>();
+        std::unique_ptr<Sync> m_sync = std::make_unique<Sync>(m_origin);
+        std::string m_root_name = "main";
+        std::string m_source_path;
+        std::deque<std::shared_ptr<const T>> m_history;
+        std::size_t m_history_limit = 0;
+        std::size_t m_retention = 0;
+        ConfigState m_state = ConfigState::DEFAULT;
+        RootNameLoadPolicy m_root_name_load_policy = RootNameLoadPolicy::KEEP_CURRENT;
+        FileReadPolicy m_file_read_policy = FileReadPolicy::BUFFERED;
+        ParseLimits m_parse_limits;
+        int m_compression_level = 0;
+        bool m_skip_unchanged_saves = false;
+        std::shared_ptr<AuditLog> m_audit_log;
+        CachePolicy m_cache_policy = CachePolicy::DISABLED;
+        std::string m_load_daemon = io::default_daemon_socket();
+        std::size_t m_sidecar_threshold = 0;
+#if FOURDST_CONFIG_USE_ARROW
+        std::size_t m_columnar_threshold = 0;
+#endif
+        std::pmr::memory_resource* m_memory_resource = nullptr;
+        std::shared_ptr<io::StringStore> m_strings;
+        bool m_string_interning = false;
+        bool m_expressions = false;
+        bool m_mutation_validation = true;
+        bool m_numa_replication = false;
+        Residency m_residency = Residency::DEFAULT;
+        FileFormat m_file_format = FileFormat::AUTO;
+        validate::ValidationOptions m_validation_options{};
+        std::optional<io::ParallelReadOptions> m_parallel_read;
+        std::optional<io::ShardSelector> m_shard_selector;
+        std::vector<std::string> m_projection;
+        /// Binds each registered `Sink` field of loaded content to its target; see `set_sink()`.
+        std::map<std::string, std::function<void(T&)>, std::less<>> m_sinks;
+        std::vector<std::string> m_layer_paths;
+        /// The drop-in directory of the last `load_directory()`, re-listed by each `reload()`.
+        std::string m_layer_directory;
+        std::vector<ParsedLayer> m_parsed_layers;
+        std::shared_ptr<ConfigSource> m_source;
+        SourceValidator m_source_validator;
+        std::vector<io::FileStamp> m_source_stamps;
+        std::uint64_t m_stamped_settings = 0;
+        bool m_incremental_reload = false;
+        bool m_format_preserving_saves = false;
+        bool m_reload_recycling = false;
+        bool m_compaction = false;
+        /// The content replaced by the last reload, read into by the next one; see `set_reload_recycling()`.
+        std::optional<T> m_spare;
+        /// The snapshot replaced by the last reload, recycled by the next publish if no reader holds it.
+        std::shared_ptr<const T> m_retired;
+        MissingFieldPolicy m_missing_field_policy = MissingFieldPolicy::REJECT;
+        UnknownKeyPolicy m_unknown_key_policy = UnknownKeyPolicy::ALLOW;
+        DeprecatedKeyPolicy m_deprecated_key_policy = DeprecatedKeyPolicy::ALLOW;
+        std::shared_ptr<const toml::table> m_last_document;
+        std::string m_env_prefix;
+        std::vector<Override> m_overrides;
+        std::shared_ptr<const ProvenanceRecord<T>> m_provenance;
+        std::shared_ptr<const ProvenanceRecord<T>> m_origin_provenance;
+        std::deque<std::shared_ptr<const ProvenanceRecord<T>>> m_provenance_history;
+        std::vector<detail::FieldRange> m_fingerprint_excluded;
+        mutable std::weak_ptr<const T> m_fingerprint_snapshot;
+        mutable std::uint64_t m_fingerprint = 0;
+        std::vector<std::shared_ptr<const Subscription>> m_subscriptions;
+        std::size_t m_last_subscription_id = 0;
+    };
+
+    // The file I/O members are defined out of line so that they are not inline, which lets
+    // FOURDST_CONFIG_DECLARE (see instantiate.h) keep them from being instantiated in every TU.
+
+    template <IsConfigSchema T>
+    void Config<T>::save(const std::string_view path, const SavePolicy policy) const {
+        const auto measured = measure(ConfigMetrics::Operation::SAVE);
+        if (m_format_preserving_saves && save_edits(path, policy)) return;
+        save_file(save_request(path, policy));
+    }
+
+    template <IsConfigSchema T>
+    void Config<T>::save(const std::string_view path, const SaveMode mode, const SavePolicy policy) const {
+        const auto measured = measure(ConfigMetrics::Operation::SAVE);
+        save_file(save_request(path, policy, mode));
+    }
+
+    template <IsConfigSchema T>
+    std::expected<void, exceptions::ConfigErrorInfo> Config<T>::try_load(const std::string_view path, const bool verbose) noexcept {
+        return capture_errors([&] { load(path, verbose); });
+    }
+
+    template <IsConfigSchema T>
+    std::expected<void, exceptions::ConfigErrorInfo> Config<T>::try_load_from(const std::string_view content, const bool verbose) noexcept {
+        return capture_errors([&] { load_from(content, verbose); });
+    }
+
+    template <IsConfigSchema T>
+    std::expected<void, exceptions::ConfigErrorInfo> Config<T>::try_save(const std::string_view path, const SavePolicy policy) const noexcept {
+        return capture_errors([&] { save(path, policy); });
+    }
+
+#if !FOURDST_CONFIG_WASM_PROFILE
+    template <IsConfigSchema T>
+    std::expected<void, exceptions::ConfigErrorInfo> Config<T>::try_save_schema(const std::string& path, const int compression_level) noexcept {
+        return capture_errors([&] { save_schema(path, compression_level); });
+    }
+#endif
+
+    template <IsConfigSchema T>
+    std::future<void> Config<T>::save_async(std::string path, const SavePolicy policy) const {
+        auto request = std::make_shared<const SaveRequest>(save_request(path, policy));
+        return io::SaveQueue::instance().submit(std::move(path), [request] { write_file(*request); });
+    }
+
+    template <IsConfigSchema T>
+    void Config<T>::serialize_for(const std::string_view path, std::string& out, const SavePolicy policy) const {
+        const SaveRequest request = save_request(path, policy);
+        io::StringSink sink{out};
+        write_request(sink, request);
+    }
+
+    template <IsConfigSchema T>
+    void Config<T>::save_to(std::string& out) const {
+        io::StringSink sink{out};
+        write_content(sink, m_file_format == FileFormat::JSON ? FileFormat::JSON : FileFormat::TOML, m_content, m_root_name);
+    }
+
+    template <IsConfigSchema T>
+    void Config<T>::save_to(std::ostream& out) const {
+        io::StreamSink sink{out};
+        write_content(sink, m_file_format == FileFormat::JSON ? FileFormat::JSON : FileFormat::TOML, m_content, m_root_name);
+    }
+
+    template <IsConfigSchema T>
+    void Config<T>::load(const std::string_view requested, const bool verbose) {
+        const std::string path = io::staged_path(requested);
+        FOURDST_CONFIG_TRACE_ZONE(zone, "config.load", m_root_name);
+        const auto measured = measure(ConfigMetrics::Operation::LOAD);
+        FOURDST_CONFIG_TRACE_BYTES(zone, trace::file_bytes(path));
+        if (!m_source_path.empty()) {
+            throw exceptions::ConfigLoadError(
+                "Config has already been loaded from file. Use reload() to pick up changes to the file.");
+        }
+
+        if (path == stdin_source) {
+            // A pipe has no stamps, binary cache or kept document; it is read once, as load_from() reads memory.
+            std::string loaded_root_name;
+            auto provenance = fresh_provenance();
+            auto strings = fresh_strings();
+            const io::ScopedStringStore string_scope(strings.get());
+            T loaded = read_stdin(verbose, loaded_root_name, provenance.get());
+            install_loaded(std::move(loaded), std::move(loaded_root_name), path, std::move(provenance), std::move(strings));
+            return;
+        }
+
+        // Stamped before reading, so a write racing the load shows up as a change on the next reload.
+        std::vector<io::FileStamp> stamps = io::stamp_files({std::string(path)});
+        std::string loaded_root_name;
+        auto provenance = fresh_provenance();
+        auto strings = fresh_strings();
+        const io::ScopedStringStore string_scope(strings.get());
+        std::optional<io::ValueSpans> spans;
+        std::shared_ptr<toml::table> document = parse_for_incremental(path, provenance.get(), &spans);
+        bool root_was_first = false;
+        T loaded = document ? read_table(*document, path, verbose, loaded_root_name, root_was_first)
+                            : read_file(path, verbose, loaded_root_name, provenance.get());
+        install_loaded(std::move(loaded), std::move(loaded_root_name), path, std::move(provenance), std::move(strings));
+        remember_stamps(std::move(stamps), std::move(document), std::move(spans));
+    }
+
+    template <IsConfigSchema T>
+    void Config<T>::load(std::shared_ptr<ConfigSource> source, const bool verbose) {
+        FOURDST_CONFIG_TRACE_ZONE(zone, "config.load", m_root_name);
+        const auto measured = measure(ConfigMetrics::Operation::LOAD);
+        if (!m_source_path.empty()) {
+            throw exceptions::ConfigLoadError(
+                "Config has already been loaded from file. Use reload() to pick up changes to the file.");
+        }
+        if (!source) {
+            throw exceptions::ConfigLoadError("Cannot load config from a null source.");
+        }
+
+        SourceData data = source->fetch({});
+        const std::string name = source->name();
+        if (data.not_modified) {
+            throw exceptions::ConfigLoadError(
+                std::format("Config source {} reported an unchanged document on its first fetch", name));
+        }
+        FOURDST_CONFIG_TRACE_BYTES(zone, data.local_path.empty() ? data.content.size() : trace::file_bytes(data.local_path));
+        std::string loaded_root_name;
+        auto provenance = fresh_provenance();
+        auto strings = fresh_strings();
+        const io::ScopedStringStore string_scope(strings.get());
+        T loaded = read_source(data, name, verbose, loaded_root_name, provenance.get());
+        install_loaded(std::move(loaded), std::move(loaded_root_name), name, std::move(provenance), std::move(strings));
+        const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+        m_source = std::move(source);
+        m_source_validator = std::move(data.validator);
+    }
+
+    template <IsConfigSchema T>
+    void Config<T>::load_layers(const std::vector<std::string>& requested, const bool verbose) {
+        const auto measured = measure(ConfigMetrics::Operation::LOAD);
+        std::vector<std::string> paths;
+        paths.reserve(requested.size());
+        for (const std::string& path : requested) paths.push_back(io::staged_path(path));
+        if (!m_source_path.empty()) {
+            throw exceptions::ConfigLoadError(
+                "Config has already been loaded from file. Use reload() to pick up changes to the file.");
+        }
+
+        std::vector<io::FileStamp> stamps = io::stamp_files(paths);
+        std::string loaded_root_name;
+        auto provenance = fresh_provenance();
+        auto strings = fresh_strings();
+        const io::ScopedStringStore string_scope(strings.get());
+        std::vector<ParsedLayer> parsed;
+        T loaded = read_layers(paths, verbose, loaded_root_name, provenance.get(), &stamps, &parsed);
+        install_loaded(std::move(loaded), std::move(loaded_root_name), paths.back(), std::move(provenance), std::move(strings));
+        remember_stamps(std::move(stamps));
+        const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+        m_layer_paths = paths;
+        m_parsed_layers = std::move(parsed);
+    }
+
+    template <IsConfigSchema T>
+    void Config<T>::load_directory(const std::string& requested, const bool verbose) {
+        const std::string directory = io::staged_path(requested);
+        if (!m_source_path.empty()) {
+            throw exceptions::ConfigLoadError(
+                "Config has already been loaded from file. Use reload() to pick up changes to the file.");
+        }
+
+        std::vector<std::string> paths = io::list_fragments(directory);
+        if (paths.empty()) {
+            throw exceptions::ConfigLoadError(std::format("Config directory {} holds no .toml fragment.", directory));
+        }
+        load_layers(paths, verbose);
+        const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+        m_layer_directory = directory;
+    }
+
+    template <IsConfigSchema T>
+    void Config<T>::load_table(toml::table& document, const std::string_view path, const bool verbose) {
+        if (!m_source_path.empty()) {
+            throw exceptions::ConfigLoadError(
+                "Config has already been loaded from file. Use reload() to pick up changes to the file.");
+        }
+
+        std::string loaded_root_name;
+        bool root_was_first = false;
+        auto provenance = fresh_provenance();
+        auto strings = fresh_strings();
+        const io::ScopedStringStore string_scope(strings.get());
+        T loaded = read_table(document, path, verbose, loaded_root_name, root_was_first, provenance.get());
+        install_loaded(std::move(loaded), std::move(loaded_root_name), path, std::move(provenance), std::move(strings));
+    }
+
+    template <IsConfigSchema T>
+    bool Config<T>::reload(const std::string_view path, const bool verbose) {
+        const auto measured = measure(ConfigMetrics::Operation::RELOAD);
+        if (path.empty()) {
+            std::shared_ptr<ConfigSource> remote;
+            SourceValidator known;
+            {
+                const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+                remote = m_source;
+                known = m_source_validator;
+            }
+            if (remote) {
+                return reload_source(remote, known, verbose);
+            }
+        }
+
+        const std::string source = path.empty() ? m_source_path : io::staged_path(path);
+        if (source.empty()) {
+            throw exceptions::ConfigLoadError(
+                "Cannot reload config: no file has been loaded and no path was given.");
+        }
+        if (path.empty() && source == memory_source) {
+            throw exceptions::ConfigLoadError(
+                "Cannot reload config: it was loaded from memory. Pass a path, or call load_from() with the new content.");
+        }
+        if (source == stdin_source) {
+            if (path.empty()) {
+                throw exceptions::ConfigLoadError(
+                    "Cannot reload config: it was read from standard input. Pass \"-\" to read standard input again.");
+            }
+            std::string loaded_root_name;
+            auto provenance = fresh_provenance();
+            auto strings = fresh_strings();
+            const io::ScopedStringStore string_scope(strings.get());
+            T loaded = read_stdin(verbose, loaded_root_name, provenance.get());
+            const bool changed = install_reloaded(std::move(loaded), std::move(loaded_root_name), source, std::move(provenance), true,
+                                                  std::move(strings));
+            forget_source();
+            return changed;
+        }
+
+        std::vector<std::string> layers;
+        std::string directory;
+        std::vector<ParsedLayer> parsed;
+        if (path.empty()) {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            layers = m_layer_paths;
+            directory = m_layer_directory;
+            // Layers parsed under other parse limits may not be reused.
+            if (m_stamped_settings == load_settings_key()) parsed = m_parsed_layers;
+        }
+        if (!directory.empty()) {
+            // A fragment added or removed since the last read changes the list, so the stamps below no longer apply.
+            layers = io::list_fragments(directory);
+            if (layers.empty()) {
+                throw exceptions::ConfigLoadError(std::format("Config directory {} holds no .toml fragment.", directory));
+            }
+        }
+
+        // Spurious triggers (a touch, a metadata-only rsync) end here without reading or parsing.
+        const std::vector<std::string> files = layers.empty() ? std::vector<std::string>{source} : layers;
+        std::vector<io::FileStamp> stamps;
+        bool stamps_apply = false;
+        {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            stamps = m_source_stamps;
+            // Unsaved mutate() changes must be discarded, and the environment layer can change at any time.
+            stamps_apply = m_state == ConfigState::LOADED_FROM_FILE && m_stamped_settings == load_settings_key() &&
+                           m_env_prefix.empty();
+        }
+        if (stamps_apply && io::unchanged_since(stamps, files)) {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            m_source_stamps = std::move(stamps);
+            return false;
+        }
+
+        stamps = io::stamp_files(files);
+        std::string loaded_root_name;
+        auto provenance = fresh_provenance();
+        std::optional<io::ValueSpans> spans;
+        std::shared_ptr<toml::table> document = layers.empty() ? parse_for_incremental(source, provenance.get(), &spans) : nullptr;
+        if (document) {
+            if (const std::optional<bool> patched = reload_changed_tables(*document, source)) {
+                forget_source();
+                remember_stamps(std::move(stamps), std::move(document), std::move(spans));
+                return *patched;
+            }
+        }
+        auto strings = fresh_strings();
+        const io::ScopedStringStore string_scope(strings.get());
+        bool root_was_first = false;
+        std::optional<T> spare;
+        if (!document && layers.empty()) {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            spare = std::exchange(m_spare, std::nullopt);
+        }
+        T loaded = document         ? read_table(*document, source, verbose, loaded_root_name, root_was_first)
+                   : layers.empty() ? read_file(source, verbose, loaded_root_name, provenance.get(), spare ? &*spare : nullptr)
+                                    : read_layers(layers, verbose, loaded_root_name, provenance.get(), &stamps, &parsed);
+        const bool changed = install_reloaded(std::move(loaded), std::move(loaded_root_name), layers.empty() ? source : layers.back(),
+                                              std::move(provenance), layers.empty(), std::move(strings));
+        forget_source();
+        remember_stamps(std::move(stamps), std::move(document), std::move(spans));
+        if (!layers.empty()) {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            m_layer_paths = std::move(layers);
+            m_parsed_layers = std::move(parsed);
+        }
+        return changed;
+    }
+
+    template <IsConfigSchema T>
+    void Config<T>::load(const std::string_view requested, const LoadDeadline& deadline, const bool verbose) {
+        const std::string path = io::staged_path(requested);
+        FOURDST_CONFIG_TRACE_ZONE(zone, "config.load", m_root_name);
+        const auto measured = measure(ConfigMetrics::Operation::LOAD);
+        if (!m_source_path.empty()) {
+            throw exceptions::ConfigLoadError(
+                "Config has already been loaded from file. Use reload() to pick up changes to the file.");
+        }
+        if (path == stdin_source) {
+            throw exceptions::ConfigLoadError("Cannot load config from standard input within a deadline.");
+        }
+
+        std::vector<io::FileStamp> stamps;
+        std::string loaded_root_name;
+        auto provenance = fresh_provenance();
+        auto strings = fresh_strings();
+        const io::ScopedStringStore string_scope(strings.get());
+        T loaded = read_file_within(path, deadline, verbose, loaded_root_name, provenance.get(), stamps);
+        FOURDST_CONFIG_TRACE_BYTES(zone, stamps.empty() ? 0 : stamps.front().size);
+        install_loaded(std::move(loaded), std::move(loaded_root_name), path, std::move(provenance), std::move(strings));
+        remember_stamps(std::move(stamps));
+    }
+
+    template <IsConfigSchema T>
+    bool Config<T>::reload(const std::string_view path, const LoadDeadline& deadline, const bool verbose) {
+        const auto measured = measure(ConfigMetrics::Operation::RELOAD);
+        std::string source = io::staged_path(path);
+        if (path.empty()) {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            if (m_source || !m_layer_paths.empty()) {
+                throw exceptions::ConfigLoadError(std::format(
+                    "Cannot reload config '{}' within a deadline: it was not loaded from a single file. Pass a path.", m_root_name));
+            }
+            source = m_source_path;
+        }
+        if (source.empty()) {
+            throw exceptions::ConfigLoadError(
+                "Cannot reload config: no file has been loaded and no path was given.");
+        }
+        if ((path.empty() && source == memory_source) || source == stdin_source) {
+            throw exceptions::ConfigLoadError(
+                std::format("Cannot reload config '{}' within a deadline: it was not loaded from a file.", m_root_name));
+        }
+
+        std::vector<io::FileStamp> stamps;
+        std::string loaded_root_name;
+        auto provenance = fresh_provenance();
+        auto strings = fresh_strings();
+        const io::ScopedStringStore string_scope(strings.get());
+        T loaded = read_file_within(source, deadline, verbose, loaded_root_name, provenance.get(), stamps);
+        const bool changed = install_reloaded(std::move(loaded), std::move(loaded_root_name), source, std::move(provenance), true,
+                                              std::move(strings));
+        forget_source();
+        remember_stamps(std::move(stamps));
+        return changed;
+    }
+
+    template <IsConfigSchema T>
+    typename Config<T>::StagedReload Config<T>::stage_reload(const bool verbose,
+                                                             const std::function<const toml::table&(const std::string&)>& document) const {
+        StagedReload staged;
+        std::string directory;
+        {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            staged.m_source = m_source_path;
+            staged.m_layers = m_layer_paths;
+            directory = m_layer_directory;
+            if (m_source) {
+                throw exceptions::ConfigLoadError(
+                    std::format("Cannot stage a reload of config '{}': it was loaded from a ConfigSource, not from files.", m_root_name));
+            }
+        }
+        if (staged.m_source.empty() || staged.m_source == memory_source || staged.m_source == stdin_source) {
+            throw exceptions::ConfigLoadError(
+                std::format("Cannot stage a reload of config '{}': it was not loaded from a file.", m_root_name));
+        }
+        if (!directory.empty()) {
+            staged.m_layers = io::list_fragments(directory);
+            if (staged.m_layers.empty()) {
+                throw exceptions::ConfigLoadError(std::format("Config directory {} holds no .toml fragment.", directory));
+            }
+            staged.m_source = staged.m_layers.back();
+        }
+
+        staged.m_owner = m_sync.get();
+        staged.m_provenance = fresh_provenance();
+        staged.m_strings = fresh_strings();
+        const io::ScopedStringStore string_scope(staged.m_strings.get());
+        if (!staged.m_layers.empty()) {
+            staged.m_content = read_layers(staged.m_layers, verbose, staged.m_root_name, staged.m_provenance.get());
+        } else if (document) {
+            const toml::table& shared = document(staged.m_source);
+            // Only this config's root is read, and reading may migrate it in place, so it is copied out.
+            const bool keep = m_root_name_load_policy == RootNameLoadPolicy::KEEP_CURRENT;
+            const std::string root = keep || shared.empty() ? m_root_name : std::string(shared.begin()->first.str());
+            toml::table own;
+            if (const toml::node* node = shared.get(root)) {
+                node->visit([&](const auto& concrete) { own.insert(root, concrete); });
+            } else if (!shared.empty()) {
+                // Let read_table() report the mismatch with the usual message.
+                own.insert(shared.begin()->first.str(), toml::table{});
+            }
+            bool root_was_first = false;
+            staged.m_content = read_table(own, staged.m_source, verbose, staged.m_root_name, root_was_first, staged.m_provenance.get());
+        } else {
+            staged.m_content = read_file(staged.m_source, verbose, staged.m_root_name, staged.m_provenance.get());
+        }
+        apply_environment(staged.m_content, staged.m_provenance.get());
+        return staged;
+    }
+
+    template <IsConfigSchema T>
+    bool Config<T>::commit_reload(StagedReload staged) {
+        if (staged.m_owner != m_sync.get()) {
+            throw exceptions::ConfigLoadError(
+                std::format("Cannot commit a reload of config '{}': it was staged by another config.", m_root_name));
+        }
+        const bool layered = !staged.m_layers.empty();
+        const bool changed = install_reloaded(std::move(staged.m_content), std::move(staged.m_root_name), staged.m_source,
+                                              std::move(staged.m_provenance), !layered, std::move(staged.m_strings), false);
+        forget_source();
+        if (layered) {
+            const detail::CountedLock lock(m_sync->content_mutex, m_sync->lock_counters);
+            m_layer_paths = std::move(staged.m_layers);
+        }
+        return changed;
+    }
+
+    template <IsConfigSchema T>
+    bool Config<T>::load_from(const std::string_view content, const bool verbose) {
+        const auto measured = measure(ConfigMetrics::Operation::LOAD);
+        const FileFormat format = content_format(content);
+        std::string loaded_root_name;
+        bool root_was_first = false;
+        auto provenance = fresh_provenance();
+        auto strings = fresh_strings();
+        const io::ScopedStringStore string_scope(strings.get());
+        check_parse_limits(content, memory_source, format);
+        T loaded = parse_content(content, memory_source, format, verbose, loaded_root_name, root_was_first, provenance.get());
+        const bool changed = install_reloaded(std::move(loaded), std::move(loaded_root_name), std::string(memory_source),
+                                              std::move(provenance), true, std::move(strings));
+        forget_source();
+        return changed;
+    }
+
+#if !FOURDST_CONFIG_WASM_PROFILE
+    template <IsConfigSchema T>
+    std::string_view Config<T>::schema() {
+        using wrapper = std::unordered_map<std::string, T>;
+        static const std::string json_schema = rfl::json::to_schema<wrapper>(rfl::json::pretty);
+        return json_schema;
+    }
+#endif
+
+    template <IsConfigSchema T>
+    std::string_view Config<T>::deck_template() {
+        static const std::string text = io::toml_template<T>("main");
+        return text;
+    }
+
+    template <IsConfigSchema T>
+    void Config<T>::save_template(const std::string& path) {
+        const std::string_view text = deck_template();
+        io::FileSink sink{path};
+        sink.write(text);
+        sink.close();
+    }
+
+#if !FOURDST_CONFIG_WASM_PROFILE
+    template <IsConfigSchema T>
+    void Config<T>::save_schema(const std::string& path, const int compression_level) {
+        FOURDST_CONFIG_TRACE_ZONE(zone, "config.save_schema", "");
+        const std::string_view json_schema = schema();
+        FOURDST_CONFIG_TRACE_BYTES(zone, json_schema.size());
+
+        const io::Compression compression = io::compression_for(path);
+        if (!io::compression_supported(compression)) {
+            throw exceptions::SchemaSaveError(std::format(
+                "Cannot write compressed schema file {}: libconfig was built without -D{}=enabled",
+                path, io::detail::compression_option(compression)));
+        }
+        std::ofstream ofs{std::string(path), std::ios::binary};
+        if (!ofs.is_open()) {
+            throw exceptions::SchemaSaveError(
+                std::format("Failed to open file for writing schema: {}", path)
+            );
+        }
+
+        if (compression == io::Compression::NONE) {
+            ofs.write(json_schema.data(), static_cast<std::streamsize>(json_schema.size()));
+        } else {
+            try {
+                io::StreamSink sink{ofs};
+                io::CompressingSink compressed{sink, compression, compression_level};
+                compressed.write(json_schema);
+                compressed.finish();
+            } catch (const exceptions::ConfigSaveError& e) {
+                throw exceptions::SchemaSaveError(std::format("Failed to write schema {}: {}", path, e.what()));
+            }
+        }
+        ofs.close();
+    }
+#endif
+}
+
+/**
+ * @brief Formatter specialization for Config<T> to allow easy printing.
+ *
+ * This allows a Config object to be directly formatted/printed (e.g., via std::print or std::format).
+ * By default it outputs the configuration in its TOML representation, written straight into the
+ * format output. The format spec takes comma-separated options:
+ * - `json`: compact JSON (`{"main": {...}}`) through reflect-cpp's yyjson writer.
+ * - `compact`: TOML on a single line, as an inline table (`main = { ... }`).
+ * - `p`: append the provenance of every field (see `Config::describe_provenance()`) as TOML comments.
+ * - any other word: a dotted field path; only that subtree is serialized, still nested under the
+ *   root table (and any parent tables), so the output is a valid patch for `Config::apply_patch()`.
+ *
+ * Unknown field paths and conflicting options are rejected when the format string is checked.
+ *
+ * @par Example
  * @code
  * std::println("Current Setup:\n{}", config);
+ * std::println("Where it came from:\n{:p}", config);
+ * std::println("{:json,physics}", config);   // {"main":{"physics":{...}}}
+ * std::println("{:compact,simulation}", config);
  * @endcode
  */
 template <typename T, typename CharT>
 struct std::formatter<fourdst::config::Config<T>, CharT> {
+    bool with_provenance = false;
+    bool as_json = false;
+    bool compact = false;
+    std::string_view subtree;
 
-    static constexpr auto parse(auto& ctx) { return ctx.begin(); }
+    constexpr auto parse(auto& ctx) {
+        auto it = ctx.begin();
+        while (it != ctx.end() && *it != '}') {
+            auto end = it;
+            while (end != ctx.end() && *end != '}' && *end != ',') ++end;
+            const std::string_view option(std::to_address(it), static_cast<std::size_t>(end - it));
+            if (option == "p") {
+                with_provenance = true;
+            } else if (option == "json") {
+                as_json = true;
+            } else if (option == "compact") {
+                compact = true;
+            } else if (!option.empty() && subtree.empty() && fourdst::config::detail::has_path<T>(option)) {
+                subtree = option;
+            } else {
+                throw std::format_error("Invalid format spec for Config: expected json, compact, p or a field path of the schema.");
+            }
+            it = end;
+            if (it != ctx.end() && *it == ',') ++it;
+        }
+        if (as_json && (compact || with_provenance)) {
+            throw std::format_error("Invalid format spec for Config: json cannot be combined with compact or p.");
+        }
+        if (!as_json && (compact || !subtree.empty()) && !fourdst::config::io::is_streamable_v<T>) {
+            throw std::format_error("Invalid format spec for Config: compact and subtree TOML output need a schema io::TomlWriter can stream; use json.");
+        }
+        return it;
+    }
 
     auto format(const fourdst::config::Config<T>& config, auto& ctx) const {
-        // Create a wrapper map to preserve the root name in the output
-        std::map<std::string, T> wrapper;
-        wrapper[std::string(config.get_root_name())] = config.main();
+        return write_config(config, ctx.out());
+    }
+
+private:
+    template <typename Out>
+    struct OutputSink {
+        Out out;
+        void write(const std::string_view data) { out = std::copy(data.begin(), data.end(), out); }
+    };
 
-        // Serialize to TOML using reflect-cpp
-        const std::string toml_string = rfl::toml::write(wrapper);
+    /**
+     * @brief Writes `config` to `out` as selected by the parsed format spec.
+     *
+     * Defined out of line so `FOURDST_CONFIG_DECLARE` can suppress its instantiation.
+     */
+    template <typename Out>
+    Out write_config(const fourdst::config::Config<T>& config, Out out) const;
 
-        // Write to the formatter output
-        return std::format_to(ctx.out(), "{}", toml_string);
+    template <typename Sink>
+    void write_json(Sink& sink, const fourdst::config::Config<T>& config) const {
+        std::size_t depth = 1;
+        sink.write("{");
+        sink.write(rfl::json::write(std::string(config.get_root_name())));
+        sink.write(":");
+        for (std::string_view rest = subtree; !rest.empty(); ++depth) {
+            const auto [head, tail] = fourdst::config::detail::split_path(rest);
+            sink.write("{");
+            sink.write(rfl::json::write(std::string(head)));
+            sink.write(":");
+            rest = tail;
+        }
+        fourdst::config::detail::visit_at(config.main(), subtree, [&](const auto& value) {
+            sink.write(fourdst::config::io::write_json(value));
+        });
+        for (; depth > 0; --depth) sink.write("}");
     }
 };
+
+template <typename T, typename CharT>
+template <typename Out>
+Out std::formatter<fourdst::config::Config<T>, CharT>::write_config(const fourdst::config::Config<T>& config, Out out) const {
+    FOURDST_CONFIG_TRACE_ZONE(zone, "config.format", config.get_root_name());
+    // Emit straight into the format output; the content is neither copied nor buffered
+    // (schemas that TomlWriter cannot stream are serialized by reflect-cpp first).
+    OutputSink<Out> sink{out};
+    if (as_json) {
+        write_json(sink, config);
+    } else if (compact || !subtree.empty()) {
+        if constexpr (fourdst::config::io::is_streamable_v<T>) {
+            fourdst::config::io::TomlWriter writer(sink);
+            fourdst::config::detail::visit_at(config.main(), subtree, [&](const auto& value) {
+                using Value = std::remove_cvref_t<decltype(value)>;
+                if constexpr (fourdst::config::io::detail::is_plain_struct_v<Value> || fourdst::config::validate::is_map_v<Value>) {
+                    if (!compact) {
+                        writer.write_section(config.get_root_name(), subtree, value);
+                        return;
+                    }
+                }
+                writer.write_assignment(config.get_root_name(), subtree, value);
+            });
+        }
+    } else {
+        fourdst::config::io::write_toml_document(sink, config.get_root_name(), config.main());
+    }
+    if (with_provenance) {
+        const std::string provenance = config.describe_provenance();
+        std::string_view rest = provenance;
+        while (!rest.empty()) {
+            const std::size_t end = rest.find('\n');
+            sink.write("# ");
+            sink.write(rest.substr(0, end));
+            sink.write("\n");
+            rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+        }
+    }
+    return sink.out;
+}
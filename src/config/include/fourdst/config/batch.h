@@ -0,0 +1,396 @@
+/**
+ * @file batch.h
+ * @brief Loading and saving many config files of one schema concurrently, e.g. the members of an ensemble.
+ *
+ * `load_many<T>()` loads each file into its own `Config<T>` on a pool of worker threads, so
+ * reading and parsing thousands of member decks proceeds in parallel instead of one after the
+ * other. A file that fails to load does not stop the batch; its error is collected with its
+ * index and its config is left in the `DEFAULT` state.
+ *
+ * @code
+ * const auto ensemble = fourdst::config::load_many<MemberSchema>(member_paths);
+ * for (const auto& failure : ensemble.failures) std::cerr << failure.path << ": " << failure.message << '\n';
+ * run(ensemble.configs);
+ * @endcode
+ *
+ * Members that only override a common base file can name it in `LoadManyOptions::base`: the base
+ * is then parsed once and each member table is merged on top of a copy of it, as `load_layers()`
+ * would do with the two files, instead of parsing the base again for every member.
+ *
+ * `save_many()` writes a batch back: each config is serialized on a worker into a buffer the
+ * worker reuses, and at most `SaveManyOptions::max_writers` files are written at the same time,
+ * so serialization keeps every core busy without flooding a shared filesystem with writes.
+ * With `SaveManyOptions::all_or_nothing` no target is replaced unless every config was written:
+ *
+ * @code
+ * fourdst::config::SaveManyOptions options;
+ * options.max_writers = 4;
+ * options.all_or_nothing = true;
+ * const auto saved = fourdst::config::save_many(ensemble.configs,
+ *     [](std::size_t i) { return std::format("members/member_{:04}.toml", i); }, options);
+ * @endcode
+ *
+ * Work runs on the default executor (see executor.h), or on new `std::thread`s if none is
+ * installed; pass an executor to run one batch on a particular pool instead. An executor is any
+ * callable that accepts a `std::function<void()>` and runs it eventually, on any thread (e.g. a
+ * wrapper around `boost::asio::post` or `tbb::task_arena::enqueue`).
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "fourdst/config/base.h"
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/executor.h"
+#include "fourdst/config/fragments.h"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config {
+
+    /**
+     * @brief Tuning knobs for `load_many()`.
+     */
+    struct LoadManyOptions {
+        /// Number of files loaded at the same time; 0 uses `std::thread::hardware_concurrency()`.
+        unsigned max_threads = 0;
+        /// A TOML file every member is layered on top of, parsed once; empty for none.
+        std::string base;
+        /// Print the missing-field report of members that do not match the schema.
+        bool verbose = false;
+    };
+
+    /**
+     * @brief One file of a `load_many()` batch that could not be loaded.
+     */
+    struct LoadFailure {
+        /// Position of the file in the list passed to `load_many()`.
+        std::size_t index = 0;
+        /// The file.
+        std::string path;
+        /// The error message.
+        std::string message;
+        /// The exception the load threw, for rethrowing or inspecting its type.
+        std::exception_ptr error;
+    };
+
+    /**
+     * @brief The configs loaded by `load_many()`, in the order of the paths, and the files that failed.
+     */
+    template <IsConfigSchema T>
+    struct LoadManyResult {
+        /// One config per path; the configs of failed files hold default values.
+        std::vector<Config<T>> configs;
+        /// The failed files, by increasing index.
+        std::vector<LoadFailure> failures;
+
+        /// True if every file was loaded.
+        [[nodiscard]] bool ok() const { return failures.empty(); }
+    };
+
+    /**
+     * @brief Tuning knobs for `save_many()`.
+     */
+    struct SaveManyOptions {
+        /// Number of configs serialized at the same time; 0 uses `std::thread::hardware_concurrency()`.
+        unsigned max_threads = 0;
+        /// Number of files written at the same time; 0 lets every thread write at once.
+        unsigned max_writers = 0;
+        /// How each file is written.
+        SavePolicy policy = SavePolicy::ATOMIC;
+        /// Replace the targets only once every config has been written; needs `ATOMIC` or `DURABLE`.
+        bool all_or_nothing = false;
+    };
+
+    /**
+     * @brief One config of a `save_many()` batch that could not be saved.
+     */
+    struct SaveFailure {
+        /// Position of the config in the list passed to `save_many()`.
+        std::size_t index = 0;
+        /// The file it was meant for.
+        std::string path;
+        /// The error message.
+        std::string message;
+        /// The exception the save threw, for rethrowing or inspecting its type.
+        std::exception_ptr error;
+    };
+
+    /**
+     * @brief The configs `save_many()` could not save.
+     */
+    struct SaveManyResult {
+        /// The failed configs, by increasing index.
+        std::vector<SaveFailure> failures;
+
+        /// True if every config was saved.
+        [[nodiscard]] bool ok() const { return failures.empty(); }
+    };
+
+    namespace detail {
+        /**
+         * @brief Calls `work(i)` for every `i` below `count` from at most `max_threads` workers run on `executor`.
+         *
+         * The workers are the units of one `bulk_execute()` call, so the calling thread is one of
+         * them. Each takes the next index until none are left; the call returns when every worker
+         * has finished. `work` must not throw. With a `State` other than `std::monostate`, each
+         * worker default-constructs one and calls `work(i, state)` instead, e.g. to reuse a buffer.
+         */
+        template <typename State = std::monostate, Executor E, typename Work>
+        void run_indexed(const std::size_t count, E& executor, const unsigned max_threads, const Work& work) {
+            if (count == 0) return;
+            std::atomic<std::size_t> next{0};
+            const unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+            const std::size_t workers = std::min<std::size_t>(count, max_threads == 0 ? hardware : max_threads);
+            bulk_execute(executor, workers, [&](std::size_t) {
+                [[maybe_unused]] State state{};
+                for (std::size_t i = next.fetch_add(1, std::memory_order_relaxed); i < count;
+                     i = next.fetch_add(1, std::memory_order_relaxed)) {
+                    if constexpr (std::is_same_v<State, std::monostate>) {
+                        work(i);
+                    } else {
+                        work(i, state);
+                    }
+                }
+            });
+        }
+
+        /**
+         * @brief Lets at most `limit` callers hold a slot at the same time; a limit of 0 admits everyone.
+         */
+        class SlotLimiter {
+        public:
+            explicit SlotLimiter(const unsigned limit) : m_free(limit), m_limited(limit != 0) {}
+
+            /**
+             * @brief A held slot, given back when it is destroyed.
+             */
+            class Slot {
+            public:
+                explicit Slot(SlotLimiter* owner) : m_owner(owner) {}
+                Slot(const Slot&) = delete;
+                Slot& operator=(const Slot&) = delete;
+                ~Slot() {
+                    if (m_owner != nullptr) m_owner->release();
+                }
+
+            private:
+                SlotLimiter* m_owner;
+            };
+
+            /// Waits for a free slot and takes it.
+            [[nodiscard]] Slot acquire() {
+                if (!m_limited) return Slot(nullptr);
+                std::unique_lock lock(m_mutex);
+                m_freed.wait(lock, [&] { return m_free != 0; });
+                --m_free;
+                return Slot(this);
+            }
+
+        private:
+            void release() {
+                {
+                    const std::lock_guard lock(m_mutex);
+                    ++m_free;
+                }
+                m_freed.notify_one();
+            }
+
+            std::mutex m_mutex;
+            std::condition_variable m_freed;
+            unsigned m_free;
+            bool m_limited;
+        };
+    }
+
+    /**
+     * @brief Loads every file in `paths` into its own `Config<T>`, running the loads as tasks on `executor`.
+     *
+     * At most `options.max_threads` workers run, the calling thread among them; each loads files
+     * until none are left, and the call returns when all of them have finished.
+     *
+     * @param paths The files to load.
+     * @param executor Callable invoked as `executor(std::function<void()>)` to run a task.
+     * @param options Concurrency, shared base file and verbosity.
+     * @return The configs and the failures.
+     * @throws exceptions::ConfigLoadError, exceptions::ConfigParseError If `options.base` cannot be loaded.
+     */
+    template <IsConfigSchema T, Executor E>
+    LoadManyResult<T> load_many(const std::vector<std::string>& paths, E&& executor, const LoadManyOptions& options = {}) {
+        LoadManyResult<T> result;
+        result.configs.resize(paths.size());
+        if (paths.empty()) return result;
+
+        toml::table base;
+        if (!options.base.empty()) base = io::parse_document(options.base);
+
+        std::mutex failures_mutex;
+        const auto load_one = [&](const std::size_t i) {
+            try {
+                if (options.base.empty()) {
+                    result.configs[i].load(paths[i], options.verbose);
+                } else {
+                    toml::table document = base;
+                    toml::table member = io::parse_document(paths[i]);
+                    io::merge_tables(document, member);
+                    result.configs[i].load_table(document, paths[i], options.verbose);
+                }
+            } catch (const std::exception& e) {
+                const std::lock_guard lock(failures_mutex);
+                result.failures.push_back({i, paths[i], e.what(), std::current_exception()});
+            }
+        };
+
+        detail::run_indexed(paths.size(), executor, options.max_threads, load_one);
+
+        std::ranges::sort(result.failures, {}, &LoadFailure::index);
+        return result;
+    }
+
+    /**
+     * @brief Loads every file in `paths` into its own `Config<T>` on the default executor.
+     *
+     * @param paths The files to load.
+     * @param options Concurrency, shared base file and verbosity.
+     * @return The configs and the failures.
+     * @throws exceptions::ConfigLoadError, exceptions::ConfigParseError If `options.base` cannot be loaded.
+     */
+    template <IsConfigSchema T>
+    LoadManyResult<T> load_many(const std::vector<std::string>& paths, const LoadManyOptions& options = {}) {
+        return load_many<T>(paths, default_executor(), options);
+    }
+
+    /**
+     * @brief Saves every config in `configs` to the file `path_fn(i)` names, running the saves as tasks on `executor`.
+     *
+     * Each task serializes a config into a buffer it reuses for the next one, as `save()` would
+     * write it (format and compression follow the path), then waits for one of
+     * `options.max_writers` write slots and writes the buffer out. A config that fails does not
+     * stop the batch; its error is collected with its index.
+     *
+     * With `options.all_or_nothing`, each buffer is written to a temporary file beside its target,
+     * and the temporary files are renamed over the targets in index order only once every config
+     * has been written; otherwise they are removed and no target changes. A rename that fails
+     * stops the commit and is reported as a failure; the targets renamed before it stay replaced.
+     * Side files (sidecars, shards) are written while serializing and are not held back.
+     *
+     * @param configs The configs to save.
+     * @param path_fn Callable invoked as `path_fn(i)` on the calling thread, returning the path of config `i`.
+     * @param executor Callable invoked as `executor(std::function<void()>)` to run a task.
+     * @param options Concurrency, write policy and whether the batch is committed as a whole.
+     * @return The failures.
+     * @throws exceptions::ConfigSaveError If `options.all_or_nothing` is combined with `SavePolicy::IN_PLACE`.
+     */
+    template <IsConfigSchema T, typename PathFn, Executor E>
+        requires std::invocable<PathFn&, std::size_t>
+    SaveManyResult save_many(const std::vector<Config<T>>& configs, PathFn&& path_fn, E&& executor, const SaveManyOptions& options = {}) {
+        if (options.all_or_nothing && options.policy == SavePolicy::IN_PLACE) {
+            throw exceptions::ConfigSaveError(
+                "save_many() with all_or_nothing needs SavePolicy::ATOMIC or DURABLE: IN_PLACE replaces each target as it is written.");
+        }
+        SaveManyResult result;
+        std::vector<std::string> paths;
+        paths.reserve(configs.size());
+        for (std::size_t i = 0; i < configs.size(); ++i) paths.emplace_back(std::invoke(path_fn, i));
+
+        const bool durable = options.policy == SavePolicy::DURABLE;
+        // Under all_or_nothing, the temporary file each config was written to, renamed over its
+        // target (the path with symlinks followed) once all succeeded.
+        std::vector<std::string> staged(options.all_or_nothing ? configs.size() : 0);
+        std::vector<std::string> targets(staged.size());
+        detail::SlotLimiter writers(options.max_writers);
+        std::mutex failures_mutex;
+        const auto save_one = [&](const std::size_t i, std::string& buffer) {
+            try {
+                buffer.clear();
+                configs[i].serialize_for(paths[i], buffer, options.policy);
+                const auto slot = writers.acquire();
+                if (options.all_or_nothing) {
+                    targets[i] = io::AtomicFileSink::resolve_symlinks(paths[i]);
+                    staged[i] = io::AtomicFileSink::temp_path_for(targets[i]);
+                    io::FileSink sink{staged[i]};
+                    io::AtomicFileSink::copy_permissions(targets[i], staged[i]);
+                    sink.write(buffer);
+                    if (durable) sink.sync();
+                    sink.close();
+                } else if (options.policy == SavePolicy::IN_PLACE) {
+                    io::FileSink sink{paths[i]};
+                    sink.write(buffer);
+                    sink.close();
+                } else {
+                    io::AtomicFileSink sink{paths[i], durable};
+                    sink.write(buffer);
+                    sink.commit();
+                }
+            } catch (const std::exception& e) {
+                const std::lock_guard lock(failures_mutex);
+                result.failures.push_back({i, paths[i], e.what(), std::current_exception()});
+            }
+        };
+
+        detail::run_indexed<std::string>(configs.size(), executor, options.max_threads, save_one);
+
+        if (options.all_or_nothing) {
+            std::size_t renamed = 0;
+            if (result.failures.empty()) {
+                for (; renamed < staged.size(); ++renamed) {
+                    std::error_code ec;
+                    std::filesystem::rename(staged[renamed], targets[renamed], ec);
+                    if (ec) {
+                        const exceptions::ConfigSaveError error(
+                            std::format("Failed to replace config file {}: {}", paths[renamed], ec.message()));
+                        result.failures.push_back({renamed, paths[renamed], error.what(), std::make_exception_ptr(error)});
+                        break;
+                    }
+                }
+                if (durable) {
+                    std::set<std::filesystem::path> directories;
+                    for (std::size_t i = 0; i < renamed; ++i) {
+                        if (directories.insert(std::filesystem::path(targets[i]).parent_path()).second) {
+                            io::AtomicFileSink::sync_directory_of(targets[i]);
+                        }
+                    }
+                }
+            }
+            for (std::size_t i = renamed; i < staged.size(); ++i) {
+                std::error_code ec;
+                if (!staged[i].empty()) std::filesystem::remove(staged[i], ec);
+            }
+        }
+
+        std::ranges::sort(result.failures, {}, &SaveFailure::index);
+        return result;
+    }
+
+    /**
+     * @brief Saves every config in `configs` to the file `path_fn(i)` names, on the default executor.
+     *
+     * @param configs The configs to save.
+     * @param path_fn Callable invoked as `path_fn(i)`, returning the path of config `i`.
+     * @param options Concurrency, write policy and whether the batch is committed as a whole.
+     * @return The failures.
+     * @throws exceptions::ConfigSaveError If `options.all_or_nothing` is combined with `SavePolicy::IN_PLACE`.
+     */
+    template <IsConfigSchema T, typename PathFn>
+        requires std::invocable<PathFn&, std::size_t>
+    SaveManyResult save_many(const std::vector<Config<T>>& configs, PathFn&& path_fn, const SaveManyOptions& options = {}) {
+        return save_many(configs, path_fn, default_executor(), options);
+    }
+}
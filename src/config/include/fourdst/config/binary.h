@@ -0,0 +1,461 @@
+/**
+ * @file binary.h
+ * @brief Compact binary encoding of configuration structures.
+ *
+ * This file defines a flat, native-endian binary encoding for configuration structs, used for
+ * the startup cache and for shipping a parsed config between processes. Fields are written in
+ * declaration order with no names or tags; strings, vectors and maps are length-prefixed, and
+ * vectors of arithmetic values are copied as one block.
+ *
+ * Because the encoding carries no field names, the reader and writer must agree on the schema.
+ * `schema_fingerprint_v<T>` is a compile-time hash of the field names and types of `T`; store it
+ * next to encoded data and compare it before decoding.
+ *
+ * Schemas that use types the codec does not model (such as `rfl::Rename`, `rfl::Validator` or
+ * variants) are reported by `is_binary_encodable_v` as not encodable; callers fall back to
+ * `rfl::json` for those.
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "fourdst/config/compare.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+#include "rfl/json.hpp"
+
+namespace fourdst::config::io {
+
+    /**
+     * @brief 64-bit non-cryptographic hash of a byte range.
+     *
+     * Processes eight bytes per step, so hashing a large config file costs far less than parsing it.
+     *
+     * @param data The bytes to hash.
+     * @param seed Optional seed, e.g. to chain hashes.
+     * @return The hash value.
+     */
+    inline std::uint64_t hash_bytes(const std::string_view data, std::uint64_t seed = 0) {
+        constexpr std::uint64_t prime = 0x9E3779B97F4A7C15ULL;
+        std::uint64_t h = seed ^ (data.size() * prime);
+        const char* ptr = data.data();
+        std::size_t remaining = data.size();
+        while (remaining >= 8) {
+            std::uint64_t word;
+            std::memcpy(&word, ptr, 8);
+            h = (h ^ (word * prime)) * 0xBF58476D1CE4E5B9ULL;
+            h ^= h >> 31;
+            ptr += 8;
+            remaining -= 8;
+        }
+        std::uint64_t tail = 0;
+        // An empty view may have a null data(), which memcpy must not be given even for zero bytes.
+        if (remaining != 0) std::memcpy(&tail, ptr, remaining);
+        h = (h ^ (tail * prime)) * 0x94D049BB133111EBULL;
+        h ^= h >> 29;
+        return h;
+    }
+
+    namespace detail {
+        template <typename Type>
+        constexpr bool is_codec_struct_v = validate::is_reflectable_struct_v<Type> &&
+                                           !config::detail::is_std_array_v<Type> &&
+                                           std::is_aggregate_v<std::remove_cvref_t<Type>>;
+
+        template <typename Type>
+        struct binary_encodable;
+
+        template <typename Type>
+        constexpr bool is_binary_encodable_v = binary_encodable<std::remove_cvref_t<Type>>::value;
+
+        template <typename Fields>
+        struct binary_encodable_fields;
+
+        template <typename... Fields>
+        struct binary_encodable_fields<rfl::Tuple<Fields...>>
+            : std::bool_constant<(is_binary_encodable_v<typename Fields::Type> && ...)> {};
+
+        template <typename Type>
+        struct binary_encodable {
+            static constexpr bool compute() {
+                if constexpr (std::is_arithmetic_v<Type> || std::is_enum_v<Type> || validate::is_std_string_v<Type>) {
+                    return true;
+                } else if constexpr (validate::is_optional_v<Type> || validate::is_vector_v<Type> ||
+                                     config::detail::is_std_array_v<Type>) {
+                    return is_binary_encodable_v<typename Type::value_type>;
+                } else if constexpr (validate::is_tensor_v<Type>) {
+                    return true;
+                } else if constexpr (validate::is_map_v<Type>) {
+                    return is_binary_encodable_v<typename Type::key_type> && is_binary_encodable_v<typename Type::mapped_type>;
+                } else if constexpr (is_codec_struct_v<Type>) {
+                    return binary_encodable_fields<typename rfl::named_tuple_t<Type>::Fields>::value;
+                } else {
+                    return false;
+                }
+            }
+            static constexpr bool value = compute();
+        };
+
+        /**
+         * @brief FNV-1a hash over a layout description, usable in constant expressions.
+         */
+        struct LayoutHasher {
+            std::uint64_t value = 0xCBF29CE484222325ULL;
+
+            constexpr void add_char(const char c) {
+                value = (value ^ static_cast<unsigned char>(c)) * 0x100000001B3ULL;
+            }
+
+            constexpr void add_text(const std::string_view text) {
+                for (const char c : text) add_char(c);
+            }
+
+            constexpr void add_number(const std::uint64_t number) {
+                for (int shift = 0; shift < 64; shift += 8) add_char(static_cast<char>(number >> shift));
+            }
+        };
+
+        template <typename V>
+        constexpr void describe(LayoutHasher& out);
+
+        template <typename Fields, int... Is>
+        constexpr void describe_fields(LayoutHasher& out, std::integer_sequence<int, Is...>) {
+            ((out.add_text(rfl::tuple_element_t<Is, Fields>::name()), out.add_char(':'),
+              describe<typename rfl::tuple_element_t<Is, Fields>::Type>(out), out.add_char(',')), ...);
+        }
+
+        /**
+         * @brief Feeds the name, order, kind and width of every value of `V` into `out`.
+         */
+        template <typename V>
+        constexpr void describe(LayoutHasher& out) {
+            using Type = std::remove_cvref_t<V>;
+            if constexpr (std::is_same_v<Type, bool>) {
+                out.add_char('b');
+            } else if constexpr (std::is_integral_v<Type>) {
+                out.add_char(std::is_signed_v<Type> ? 'i' : 'u');
+                out.add_number(sizeof(Type));
+            } else if constexpr (std::is_floating_point_v<Type>) {
+                out.add_char('f');
+                out.add_number(sizeof(Type));
+            } else if constexpr (std::is_enum_v<Type>) {
+                out.add_char('e');
+                out.add_number(sizeof(Type));
+            } else if constexpr (validate::is_std_string_v<Type>) {
+                out.add_char('s');
+            } else if constexpr (validate::is_optional_v<Type>) {
+                out.add_char('?');
+                describe<typename Type::value_type>(out);
+            } else if constexpr (validate::is_vector_v<Type>) {
+                out.add_char('[');
+                describe<typename Type::value_type>(out);
+                out.add_char(']');
+            } else if constexpr (config::detail::is_std_array_v<Type>) {
+                out.add_char('[');
+                describe<typename Type::value_type>(out);
+                out.add_char(';');
+                out.add_number(std::tuple_size_v<Type>);
+                out.add_char(']');
+            } else if constexpr (validate::is_tensor_v<Type>) {
+                out.add_char('#');
+                describe<typename Type::value_type>(out);
+                out.add_char(';');
+                out.add_number(Type::rank);
+            } else if constexpr (validate::is_map_v<Type>) {
+                out.add_char('<');
+                describe<typename Type::key_type>(out);
+                out.add_char(':');
+                describe<typename Type::mapped_type>(out);
+                out.add_char('>');
+            } else {
+                using Fields = typename rfl::named_tuple_t<Type>::Fields;
+                out.add_char('{');
+                describe_fields<Fields>(out, std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+                out.add_char('}');
+            }
+        }
+    }
+
+    /**
+     * @brief Whether `T` can be encoded by `BinaryWriter` and decoded by `BinaryReader`.
+     * @tparam T The configuration schema type.
+     */
+    template <typename T>
+    constexpr bool is_binary_encodable_v = detail::is_codec_struct_v<T> && detail::is_binary_encodable_v<T>;
+
+    /**
+     * @brief A hash identifying the binary layout of `T`, computed at compile time.
+     *
+     * The hash covers field names, field order, and the kind and width of every value, so any
+     * schema change that would make old encoded data unreadable changes the fingerprint. Being a
+     * constant, it can be embedded in artifacts, used in `static_assert`s and compared in O(1)
+     * against the value another binary wrote, before any payload is decoded.
+     *
+     * @tparam T The configuration schema type; must satisfy `is_binary_encodable_v`.
+     */
+    template <typename T>
+        requires is_binary_encodable_v<T>
+    inline constexpr std::uint64_t schema_fingerprint_v = [] {
+        detail::LayoutHasher hasher;
+        detail::describe<T>(hasher);
+        return hasher.value;
+    }();
+
+    /**
+     * @brief Returns `schema_fingerprint_v<T>`.
+     * @tparam T The configuration schema type; must satisfy `is_binary_encodable_v`.
+     * @return The schema fingerprint.
+     */
+    template <typename T>
+    constexpr std::uint64_t schema_fingerprint() {
+        static_assert(is_binary_encodable_v<T>, "schema_fingerprint requires a binary-encodable schema.");
+        return schema_fingerprint_v<T>;
+    }
+
+    /**
+     * @brief Appends the binary encoding of values to a `std::string`.
+     */
+    class BinaryWriter {
+    public:
+        /**
+         * @brief Creates a writer appending to `out`.
+         * @param out The buffer to append to; must outlive the writer.
+         */
+        explicit BinaryWriter(std::string& out) : m_out(out) {}
+
+        /**
+         * @brief Appends the encoding of `value`.
+         * @param value The value to encode.
+         */
+        template <typename V>
+        void write(const V& value) {
+            using Type = std::remove_cvref_t<V>;
+            if constexpr (std::is_same_v<Type, bool>) {
+                put<std::uint8_t>(value ? 1 : 0);
+            } else if constexpr (std::is_arithmetic_v<Type> || std::is_enum_v<Type>) {
+                put(value);
+            } else if constexpr (validate::is_string_like_v<Type>) {
+                put<std::uint64_t>(value.size());
+                m_out.append(value);
+            } else if constexpr (validate::is_optional_v<Type>) {
+                put<std::uint8_t>(value.has_value() ? 1 : 0);
+                if (value.has_value()) write(*value);
+            } else if constexpr (validate::is_vector_v<Type> || config::detail::is_std_array_v<Type>) {
+                using Element = typename Type::value_type;
+                if constexpr (validate::is_vector_v<Type>) {
+                    put<std::uint64_t>(value.size());
+                }
+                if constexpr ((std::is_arithmetic_v<Element> || std::is_enum_v<Element>) && !std::is_same_v<Element, bool>) {
+                    m_out.append(reinterpret_cast<const char*>(value.data()), value.size() * sizeof(Element));
+                } else {
+                    for (const auto& element : value) write(element);
+                }
+            } else if constexpr (validate::is_tensor_v<Type>) {
+                for (const std::size_t extent : value.extents()) put<std::uint64_t>(extent);
+                m_out.append(reinterpret_cast<const char*>(value.data()), value.size() * sizeof(typename Type::value_type));
+            } else if constexpr (validate::is_map_v<Type>) {
+                put<std::uint64_t>(value.size());
+                for (const auto& [key, mapped] : value) {
+                    write(key);
+                    write(mapped);
+                }
+            } else {
+                const auto view = rfl::to_view(value);
+                [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                    (write(*rfl::get<Is>(view.values())), ...);
+                }(std::make_integer_sequence<int, rfl::tuple_size_v<std::remove_cvref_t<decltype(view.values())>>>{});
+            }
+        }
+
+    private:
+        template <typename P>
+        void put(const P value) {
+            m_out.append(reinterpret_cast<const char*>(&value), sizeof(P));
+        }
+
+        std::string& m_out;
+    };
+
+    /**
+     * @brief Decodes values from a buffer produced by `BinaryWriter`.
+     *
+     * Decoding is bounds-checked: truncated or corrupt input makes `read()` return false instead
+     * of reading past the end of the buffer or allocating unbounded memory.
+     */
+    class BinaryReader {
+    public:
+        /**
+         * @brief Creates a reader over `in`.
+         * @param in The encoded bytes; must outlive the reader.
+         */
+        explicit BinaryReader(const std::string_view in) : m_in(in) {}
+
+        /**
+         * @brief Decodes the next value into `value`.
+         * @param value The value to fill.
+         * @return False if the input is truncated or malformed; `value` is then unspecified.
+         */
+        template <typename V>
+        [[nodiscard]] bool read(V& value) {
+            using Type = std::remove_cvref_t<V>;
+            if constexpr (std::is_same_v<Type, bool>) {
+                std::uint8_t byte;
+                if (!get(byte) || byte > 1) return false;
+                value = byte == 1;
+                return true;
+            } else if constexpr (std::is_arithmetic_v<Type> || std::is_enum_v<Type>) {
+                return get(value);
+            } else if constexpr (validate::is_std_string_v<Type>) {
+                std::uint64_t size;
+                if (!get(size) || size > remaining()) return false;
+                value.assign(m_in.data() + m_pos, size);
+                m_pos += size;
+                return true;
+            } else if constexpr (validate::is_optional_v<Type>) {
+                std::uint8_t present;
+                if (!get(present) || present > 1) return false;
+                if (present == 0) {
+                    value.reset();
+                    return true;
+                }
+                value.emplace();
+                return read(*value);
+            } else if constexpr (validate::is_vector_v<Type> || config::detail::is_std_array_v<Type>) {
+                using Element = typename Type::value_type;
+                if constexpr (validate::is_vector_v<Type>) {
+                    std::uint64_t size;
+                    // Every element takes at least one byte, which bounds the allocation by the input size.
+                    if (!get(size) || size > remaining()) return false;
+                    value.resize(size);
+                }
+                if constexpr ((std::is_arithmetic_v<Element> || std::is_enum_v<Element>) && !std::is_same_v<Element, bool>) {
+                    const std::size_t bytes = value.size() * sizeof(Element);
+                    if (bytes > remaining()) return false;
+                    std::memcpy(value.data(), m_in.data() + m_pos, bytes);
+                    m_pos += bytes;
+                    return true;
+                } else if constexpr (std::is_same_v<Element, bool>) {
+                    // std::vector<bool> hands out proxies, so decode through a temporary.
+                    for (std::size_t i = 0; i < value.size(); ++i) {
+                        bool element;
+                        if (!read(element)) return false;
+                        value[i] = element;
+                    }
+                    return true;
+                } else {
+                    for (auto& element : value) {
+                        if (!read(element)) return false;
+                    }
+                    return true;
+                }
+            } else if constexpr (validate::is_tensor_v<Type>) {
+                typename Type::extents_type extents{};
+                std::size_t bytes = sizeof(typename Type::value_type);
+                for (std::size_t& extent : extents) {
+                    std::uint64_t size;
+                    // Bound the product by the input size so a corrupt shape cannot overflow it.
+                    if (!get(size) || (size != 0 && bytes > remaining() / size)) return false;
+                    extent = size;
+                    bytes *= extent;
+                }
+                if (bytes > remaining()) return false;
+                value.resize(extents);
+                std::memcpy(value.data(), m_in.data() + m_pos, value.size() * sizeof(typename Type::value_type));
+                m_pos += value.size() * sizeof(typename Type::value_type);
+                return true;
+            } else if constexpr (validate::is_map_v<Type>) {
+                std::uint64_t size;
+                if (!get(size) || size > remaining()) return false;
+                value.clear();
+                for (std::uint64_t i = 0; i < size; ++i) {
+                    typename Type::key_type key;
+                    typename Type::mapped_type mapped;
+                    if (!read(key) || !read(mapped)) return false;
+                    value.emplace(std::move(key), std::move(mapped));
+                }
+                return true;
+            } else {
+                auto view = rfl::to_view(value);
+                return [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                    return (read(*rfl::get<Is>(view.values())) && ...);
+                }(std::make_integer_sequence<int, rfl::tuple_size_v<std::remove_cvref_t<decltype(view.values())>>>{});
+            }
+        }
+
+        /**
+         * @brief Returns the number of bytes not yet consumed.
+         */
+        [[nodiscard]] std::size_t remaining() const noexcept { return m_in.size() - m_pos; }
+
+    private:
+        template <typename P>
+        bool get(P& value) {
+            if (sizeof(P) > remaining()) return false;
+            std::memcpy(&value, m_in.data() + m_pos, sizeof(P));
+            m_pos += sizeof(P);
+            return true;
+        }
+
+        std::string_view m_in;
+        std::size_t m_pos = 0;
+    };
+
+    /**
+     * @brief Appends a self-contained encoding of configuration content to `out`.
+     *
+     * Binary-encodable schemas use `BinaryWriter`; other schemas are written as compact JSON.
+     *
+     * @param out The buffer to append to.
+     * @param content The content to encode.
+     */
+    template <typename T>
+    void encode_content(std::string& out, const T& content) {
+        if constexpr (is_binary_encodable_v<T>) {
+            BinaryWriter(out).write(content);
+        } else {
+            out += rfl::json::write(content);
+        }
+    }
+
+    /**
+     * @brief Decodes content produced by `encode_content()`.
+     * @param in The encoded bytes, with nothing following the content.
+     * @param content The value to fill.
+     * @return False if the input is truncated, has trailing bytes, or is otherwise malformed.
+     */
+    template <typename T>
+    [[nodiscard]] bool decode_content(const std::string_view in, T& content) {
+        if constexpr (is_binary_encodable_v<T>) {
+            BinaryReader reader(in);
+            return reader.read(content) && reader.remaining() == 0;
+        } else {
+            auto result = rfl::json::read<T>(in);
+            if (!result) return false;
+            content = std::move(result).value();
+            return true;
+        }
+    }
+
+    /**
+     * @brief Returns a hash identifying the encoding `encode_content<T>()` produces.
+     *
+     * This is `schema_fingerprint<T>()` for binary-encodable schemas, and a hash of the JSON
+     * schema of `T` otherwise.
+     */
+    template <typename T>
+    std::uint64_t content_fingerprint() {
+        if constexpr (is_binary_encodable_v<T>) {
+            return schema_fingerprint_v<T>;
+        } else {
+            static const std::uint64_t fingerprint = hash_bytes(rfl::json::to_schema<T>());
+            return fingerprint;
+        }
+    }
+}
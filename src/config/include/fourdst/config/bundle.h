@@ -0,0 +1,137 @@
+/**
+ * @file bundle.h
+ * @brief Loading several `Config` objects, one per root table, from a single parse of one file.
+ *
+ * A deck may hold one root table per subsystem:
+ *
+ * @code{.toml}
+ * [main]
+ * ...
+ * [network]
+ * ...
+ * [eos]
+ * ...
+ * @endcode
+ *
+ * Loading each subsystem's `Config` on its own parses the whole file once per subsystem.
+ * `ConfigBundle` parses it once and hands each registered config its root table by name:
+ *
+ * @code
+ * fourdst::config::Config<MainSchema> main_cfg;
+ * fourdst::config::Config<NetworkSchema> network_cfg;
+ * fourdst::config::Config<EosSchema> eos_cfg;
+ *
+ * fourdst::config::ConfigBundle bundle;
+ * bundle.add(main_cfg).add(network_cfg, "network").add(eos_cfg, "eos");
+ * bundle.load("deck.toml");
+ * @endcode
+ */
+#pragma once
+
+#include <algorithm>
+#include <format>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/base.h"
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/fragments.h"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config {
+
+    /**
+     * @brief Dispatches the root tables of one TOML file to the `Config` objects registered for them.
+     *
+     * The bundle does not own the configs; they must outlive it. Each config is read by root name
+     * (its root name load policy is set to `KEEP_CURRENT`), with `Config::load_table()`, so the
+     * result is the same as a separate `load()` of the file. Root tables no config is registered
+     * for are ignored.
+     */
+    class ConfigBundle {
+    public:
+        /**
+         * @brief Registers `config` for the root table named by its current root name.
+         * @param config The config to load; must not have been loaded yet when `load()` is called.
+         * @return This bundle, for chaining.
+         * @throws exceptions::ConfigLoadError If another config is already registered for that root.
+         */
+        template <IsConfigSchema T>
+        ConfigBundle& add(Config<T>& config) {
+            std::string root(config.get_root_name());
+            if (std::ranges::any_of(m_entries, [&](const Entry& entry) { return entry.root == root; })) {
+                throw exceptions::ConfigLoadError(
+                    std::format("Cannot add config to bundle: a config is already registered for root table '{}'.", root));
+            }
+            config.set_root_name_load_policy(RootNameLoadPolicy::KEEP_CURRENT);
+            m_entries.push_back({std::move(root), [&config](toml::table& document, const std::string_view path, const bool verbose) {
+                config.load_table(document, path, verbose);
+            }});
+            return *this;
+        }
+
+        /**
+         * @brief Sets the root name of `config` to `root` and registers it for that root table.
+         * @param config The config to load; must not have been loaded yet when `load()` is called.
+         * @param root The name of the root table.
+         * @return This bundle, for chaining.
+         * @throws exceptions::ConfigLoadError If another config is already registered for `root`.
+         */
+        template <IsConfigSchema T>
+        ConfigBundle& add(Config<T>& config, const std::string_view root) {
+            config.set_root_name(root);
+            return add(config);
+        }
+
+        /**
+         * @brief Parses `path` once and loads every registered config from its root table.
+         *
+         * Before anything is loaded, the file is checked to contain a table for every registered
+         * root, so a missing root leaves all configs untouched. If a table does not match its
+         * schema, the configs registered before it remain loaded.
+         *
+         * @param path The file to read; `__include` directives are resolved.
+         * @param verbose If true, a tree of missing fields is printed to stderr when a root table does not match its schema.
+         * @throws exceptions::ConfigLoadError If the file doesn't exist, a registered root is missing, or a config is already loaded.
+         * @throws exceptions::ConfigParseError If the file is not valid TOML or a root table doesn't match its schema.
+         */
+        void load(const std::string_view path, const bool verbose = false) {
+            toml::table document = io::parse_document(path);
+
+            std::string missing;
+            for (const auto& entry : m_entries) {
+                if (!document.contains(entry.root)) {
+                    missing += std::format("{}'{}'", missing.empty() ? "" : ", ", entry.root);
+                }
+            }
+            if (!missing.empty()) {
+                throw exceptions::ConfigLoadError(
+                    std::format("Config file {} has no root table for {}.", path, missing));
+            }
+
+            for (const auto& entry : m_entries) {
+                entry.load(document, path, verbose);
+            }
+        }
+
+        /**
+         * @brief Gets the number of registered configs.
+         * @return The number of registered configs.
+         */
+        [[nodiscard]] std::size_t size() const {
+            return m_entries.size();
+        }
+
+    private:
+        struct Entry {
+            std::string root;
+            std::function<void(toml::table&, std::string_view, bool)> load;
+        };
+
+        std::vector<Entry> m_entries;
+    };
+}
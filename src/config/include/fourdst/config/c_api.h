@@ -0,0 +1,395 @@
+/**
+ * @file c_api.h
+ * @brief A C ABI for reading config values by path or by precomputed handle, for C and Fortran callers.
+ *
+ * The C++ side owns the `Config<T>` and hands a flat, type-erased view of it to C or Fortran code:
+ *
+ * @code
+ * // driver.cpp
+ * #include "fourdst/config/c_api.h"
+ * FOURDST_CONFIG_C_API();  // in exactly one translation unit
+ *
+ * fdc_config* view = fourdst::config::c_api::wrap(cfg);
+ * physics_init(view);       // Fortran, see fdc.f90
+ * ...
+ * fdc_free(view);
+ * @endcode
+ *
+ * @code{.f90}
+ * use fdc
+ * integer(c_int32_t) :: h_dt
+ * real(c_double), pointer :: radius(:)
+ * h_dt = fdc_handle(cfg, "physics.time_step")            ! once
+ * status = fdc_double_array(cfg, fdc_handle(cfg, "grid.radius"), radius)
+ * do i = 1, n
+ *     status = fdc_get_double_h(cfg, h_dt, dt)            ! O(1), no string lookup
+ * end do
+ * @endcode
+ *
+ * A handle is the index of a path in the schema's compile-time path table (see `path_table.h`),
+ * so it is the same for every config of one schema and never needs to be looked up again.
+ * Reads go to the snapshot the view pinned when it was made or last refreshed with
+ * `fdc_refresh()`; the pointers returned for arrays stay valid, and the values unchanged, until
+ * then. `Tunable` fields are the exception and always read their current value.
+ *
+ * Numbers, bools, strings and enums (by name) are readable, as are `std::vector`s, `std::array`s
+ * and `Tensor`s (flattened, row-major) of `double`, `std::int32_t` and `std::int64_t`.
+ * `fdc_get_double` also converts integer fields. Other paths, including nested structs, have kind
+ * `FDC_KIND_OTHER`.
+ *
+ * A view may be read from any number of threads, but `fdc_refresh()` and `fdc_load()` must not run
+ * while it is being read.
+ */
+#ifndef FOURDST_CONFIG_C_API_H
+#define FOURDST_CONFIG_C_API_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** A read-only view of a config; made by `fourdst::config::c_api::wrap()`, released by `fdc_free()`. */
+typedef struct fdc_config fdc_config;
+
+/** A precomputed path; negative for paths that do not name a field. */
+typedef int32_t fdc_handle;
+
+/** Status codes returned by the accessors. */
+enum {
+    FDC_OK = 0,
+    /** The path or handle does not name a field. */
+    FDC_UNKNOWN_PATH = 1,
+    /** The field is of another kind than the accessor reads. */
+    FDC_TYPE_MISMATCH = 2,
+    /** A string did not fit the buffer; the buffer holds its first `capacity` bytes. */
+    FDC_TRUNCATED = 3,
+    /** Loading failed; see `fdc_last_error()`. */
+    FDC_ERROR = 4
+};
+
+/** The kind of value at a path, as returned by `fdc_kind()`. */
+enum {
+    FDC_KIND_OTHER = 0,
+    FDC_KIND_DOUBLE = 1,
+    FDC_KIND_INT = 2,
+    FDC_KIND_BOOL = 3,
+    FDC_KIND_STRING = 4,
+    FDC_KIND_DOUBLE_ARRAY = 5,
+    FDC_KIND_INT32_ARRAY = 6,
+    FDC_KIND_INT64_ARRAY = 7
+};
+
+/** Releases a view; the config it was made from is not affected. */
+void fdc_free(fdc_config* cfg);
+
+/** Returns the handle of a dotted path, or a negative value if it does not name a field. */
+fdc_handle fdc_handle_of(const fdc_config* cfg, const char* path);
+
+/** Returns the `FDC_KIND_*` of the field at `handle`; `FDC_KIND_OTHER` for unknown handles. */
+int fdc_kind(const fdc_config* cfg, fdc_handle handle);
+
+/** Pins the latest published snapshot; pointers returned for arrays before the call become invalid. */
+void fdc_refresh(fdc_config* cfg);
+
+/** Loads `path` into the config, replacing what it was loaded from before, and pins the result; on failure the pinned snapshot is kept. */
+int fdc_load(fdc_config* cfg, const char* path);
+
+/** Returns the message of the last failed `fdc_load()`, or an empty string. */
+const char* fdc_last_error(const fdc_config* cfg);
+
+int fdc_get_double_h(const fdc_config* cfg, fdc_handle handle, double* out);
+int fdc_get_int_h(const fdc_config* cfg, fdc_handle handle, int64_t* out);
+/** Stores 1 for true and 0 for false. */
+int fdc_get_bool_h(const fdc_config* cfg, fdc_handle handle, int32_t* out);
+/**
+ * Copies at most `capacity` bytes of the string into `buffer`, without a terminating null, and
+ * stores its full length in `length`.
+ */
+int fdc_get_string_h(const fdc_config* cfg, fdc_handle handle, char* buffer, size_t capacity, size_t* length);
+int fdc_get_double_array_h(const fdc_config* cfg, fdc_handle handle, const double** data, size_t* length);
+int fdc_get_int32_array_h(const fdc_config* cfg, fdc_handle handle, const int32_t** data, size_t* length);
+int fdc_get_int64_array_h(const fdc_config* cfg, fdc_handle handle, const int64_t** data, size_t* length);
+
+/* The same accessors by path, at the cost of a lookup per call. */
+int fdc_get_double(const fdc_config* cfg, const char* path, double* out);
+int fdc_get_int(const fdc_config* cfg, const char* path, int64_t* out);
+int fdc_get_bool(const fdc_config* cfg, const char* path, int32_t* out);
+int fdc_get_string(const fdc_config* cfg, const char* path, char* buffer, size_t capacity, size_t* length);
+int fdc_get_double_array(const fdc_config* cfg, const char* path, const double** data, size_t* length);
+
+#ifdef __cplusplus
+}
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/base.h"
+#include "fourdst/config/path_table.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+
+/**
+ * @brief The type-erased view behind an `fdc_config*`; one table of readers per schema path.
+ */
+struct fdc_config {
+    struct Field {
+        int kind = FDC_KIND_OTHER;
+        double (*to_double)(const void*) = nullptr;
+        std::int64_t (*to_int)(const void*) = nullptr;
+        std::string (*to_string)(const void*) = nullptr;
+        const void* (*data)(const void*) = nullptr;
+        std::size_t (*length)(const void*) = nullptr;
+    };
+
+    /// Readers by handle.
+    std::vector<Field> fields;
+    /// Returns the handle of a path, or -1.
+    fdc_handle (*find)(std::string_view) = nullptr;
+    /// Returns the address of the field at a handle inside the pinned content.
+    const void* (*address)(const void*, std::size_t) = nullptr;
+    std::function<std::shared_ptr<const void>()> snapshot;
+    std::function<void(std::string_view)> load;
+    std::shared_ptr<const void> pinned;
+    std::string error;
+
+    [[nodiscard]] const Field* field(const fdc_handle handle) const {
+        if (handle < 0 || static_cast<std::size_t>(handle) >= fields.size()) return nullptr;
+        return &fields[static_cast<std::size_t>(handle)];
+    }
+
+    [[nodiscard]] const void* value(const fdc_handle handle) const {
+        return address(pinned.get(), static_cast<std::size_t>(handle));
+    }
+};
+
+namespace fourdst::config::c_api {
+
+    namespace detail {
+        /**
+         * @brief Returns the readers of a field of type `Type`.
+         */
+        template <typename Type>
+        fdc_config::Field make_field() {
+            fdc_config::Field field;
+            if constexpr (validate::is_tunable_v<Type>) {
+                using Value = typename Type::value_type;
+                field = make_field<Value>();
+                if constexpr (std::is_enum_v<Value>) {
+                    field.to_string = [](const void* p) -> std::string {
+                        return rfl::enum_to_string(static_cast<const Type*>(p)->get());
+                    };
+                } else {
+                    field.to_double = [](const void* p) { return static_cast<double>(static_cast<const Type*>(p)->get()); };
+                    field.to_int = [](const void* p) { return static_cast<std::int64_t>(static_cast<const Type*>(p)->get()); };
+                }
+            } else if constexpr (validate::is_quantity_v<Type>) {
+                field.kind = FDC_KIND_DOUBLE;
+                field.to_double = [](const void* p) { return static_cast<const Type*>(p)->value(); };
+            } else if constexpr (validate::is_stored_v<Type>) {
+                field = make_field<typename Type::parsed_type>();
+                field.to_double = [](const void* p) { return static_cast<double>(static_cast<const Type*>(p)->value()); };
+                field.to_int = [](const void* p) { return static_cast<std::int64_t>(static_cast<const Type*>(p)->value()); };
+            } else if constexpr (std::is_same_v<Type, bool>) {
+                field.kind = FDC_KIND_BOOL;
+                field.to_int = [](const void* p) { return static_cast<std::int64_t>(*static_cast<const bool*>(p)); };
+            } else if constexpr (std::is_floating_point_v<Type>) {
+                field.kind = FDC_KIND_DOUBLE;
+                field.to_double = [](const void* p) { return static_cast<double>(*static_cast<const Type*>(p)); };
+            } else if constexpr (std::is_integral_v<Type>) {
+                field.kind = FDC_KIND_INT;
+                field.to_int = [](const void* p) { return static_cast<std::int64_t>(*static_cast<const Type*>(p)); };
+                field.to_double = [](const void* p) { return static_cast<double>(*static_cast<const Type*>(p)); };
+            } else if constexpr (std::is_enum_v<Type>) {
+                field.kind = FDC_KIND_STRING;
+                field.to_string = [](const void* p) -> std::string {
+                    return rfl::enum_to_string(*static_cast<const Type*>(p));
+                };
+            } else if constexpr (validate::is_std_string_v<Type>) {
+                field.kind = FDC_KIND_STRING;
+                field.to_string = [](const void* p) -> std::string { return *static_cast<const Type*>(p); };
+            } else if constexpr (validate::is_vector_v<Type> || validate::is_std_array_v<Type> || validate::is_tensor_v<Type>) {
+                using Element = typename Type::value_type;
+                if constexpr (std::is_same_v<Element, double> || std::is_same_v<Element, std::int32_t> ||
+                              std::is_same_v<Element, std::int64_t>) {
+                    field.kind = std::is_same_v<Element, double>         ? FDC_KIND_DOUBLE_ARRAY
+                                 : std::is_same_v<Element, std::int32_t> ? FDC_KIND_INT32_ARRAY
+                                                                         : FDC_KIND_INT64_ARRAY;
+                    field.data = [](const void* p) -> const void* { return static_cast<const Type*>(p)->data(); };
+                    field.length = [](const void* p) -> std::size_t { return static_cast<const Type*>(p)->size(); };
+                }
+            }
+            return field;
+        }
+
+        template <typename T, typename V>
+        void collect_fields(std::vector<fdc_config::Field>& fields, std::string& path) {
+            using Fields = typename rfl::named_tuple_t<V>::Fields;
+            [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                ([&] {
+                    using Field = rfl::tuple_element_t<Is, Fields>;
+                    using FieldType = std::remove_cvref_t<typename Field::Type>;
+                    const std::size_t parent_length = path.size();
+                    if (!path.empty()) path += '.';
+                    path += Field::name();
+                    fields[config::detail::PathTable<T>::find(path)] = make_field<FieldType>();
+                    if constexpr (config::detail::is_path_struct_v<FieldType>) {
+                        collect_fields<T, FieldType>(fields, path);
+                    }
+                    path.resize(parent_length);
+                }(), ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>());
+        }
+    }
+
+    /**
+     * @brief Returns a C view of `config`, pinned to its current snapshot; release it with `fdc_free()`.
+     *
+     * `config` must outlive the view.
+     *
+     * @tparam T The configuration schema type.
+     */
+    template <IsConfigSchema T>
+    fdc_config* wrap(Config<T>& config) {
+        using Table = config::detail::PathTable<T>;
+        auto view = std::make_unique<fdc_config>();
+        view->fields.resize(Table::size());
+        std::string path;
+        detail::collect_fields<T, T>(view->fields, path);
+        view->find = [](const std::string_view p) -> fdc_handle {
+            const std::size_t index = Table::find(p);
+            return index == Table::npos ? -1 : static_cast<fdc_handle>(index);
+        };
+        view->address = [](const void* root, const std::size_t index) {
+            return Table::entry(index).address(*static_cast<const T*>(root));
+        };
+        view->snapshot = [&config]() -> std::shared_ptr<const void> { return config.snapshot(); };
+        // load() refuses a config that was already loaded, so later loads go through reload().
+        view->load = [&config](const std::string_view file) {
+            if (config.get_source_path().empty()) {
+                config.load(file);
+            } else {
+                config.reload(file);
+            }
+        };
+        view->pinned = view->snapshot();
+        return view.release();
+    }
+}
+
+namespace fourdst::config::c_api::detail {
+    inline int read_number(const fdc_config* cfg, const fdc_handle handle, const int kind, auto* out) {
+        const fdc_config::Field* field = cfg->field(handle);
+        if (field == nullptr) return FDC_UNKNOWN_PATH;
+        if (field->kind != kind && !(kind == FDC_KIND_DOUBLE && field->kind == FDC_KIND_INT)) return FDC_TYPE_MISMATCH;
+        if constexpr (std::is_same_v<std::remove_pointer_t<decltype(out)>, double>) {
+            *out = field->to_double(cfg->value(handle));
+        } else {
+            *out = static_cast<std::remove_pointer_t<decltype(out)>>(field->to_int(cfg->value(handle)));
+        }
+        return FDC_OK;
+    }
+
+    template <typename Element>
+    int read_array(const fdc_config* cfg, const fdc_handle handle, const int kind, const Element** data, std::size_t* length) {
+        const fdc_config::Field* field = cfg->field(handle);
+        if (field == nullptr) return FDC_UNKNOWN_PATH;
+        if (field->kind != kind) return FDC_TYPE_MISMATCH;
+        const void* value = cfg->value(handle);
+        *data = static_cast<const Element*>(field->data(value));
+        *length = field->length(value);
+        return FDC_OK;
+    }
+
+    inline int read_string(const fdc_config* cfg, const fdc_handle handle, char* buffer, const std::size_t capacity,
+                           std::size_t* length) {
+        const fdc_config::Field* field = cfg->field(handle);
+        if (field == nullptr) return FDC_UNKNOWN_PATH;
+        if (field->kind != FDC_KIND_STRING) return FDC_TYPE_MISMATCH;
+        const std::string text = field->to_string(cfg->value(handle));
+        std::memcpy(buffer, text.data(), std::min(capacity, text.size()));
+        *length = text.size();
+        return text.size() > capacity ? FDC_TRUNCATED : FDC_OK;
+    }
+}
+
+/**
+ * @brief Defines the `fdc_*` functions; use at namespace scope in exactly one translation unit.
+ */
+#define FOURDST_CONFIG_C_API() \
+    extern "C" { \
+    void fdc_free(fdc_config* cfg) { delete cfg; } \
+    fdc_handle fdc_handle_of(const fdc_config* cfg, const char* path) { \
+        return cfg->find(path); \
+    } \
+    int fdc_kind(const fdc_config* cfg, const fdc_handle handle) { \
+        const fdc_config::Field* field = cfg->field(handle); \
+        return field == nullptr ? FDC_KIND_OTHER : field->kind; \
+    } \
+    void fdc_refresh(fdc_config* cfg) { cfg->pinned = cfg->snapshot(); } \
+    int fdc_load(fdc_config* cfg, const char* path) { \
+        try { \
+            cfg->load(path); \
+        } catch (const std::exception& e) { \
+            cfg->error = e.what(); \
+            return FDC_ERROR; \
+        } \
+        cfg->error.clear(); \
+        cfg->pinned = cfg->snapshot(); \
+        return FDC_OK; \
+    } \
+    const char* fdc_last_error(const fdc_config* cfg) { return cfg->error.c_str(); } \
+    int fdc_get_double_h(const fdc_config* cfg, const fdc_handle handle, double* out) { \
+        return fourdst::config::c_api::detail::read_number(cfg, handle, FDC_KIND_DOUBLE, out); \
+    } \
+    int fdc_get_int_h(const fdc_config* cfg, const fdc_handle handle, int64_t* out) { \
+        return fourdst::config::c_api::detail::read_number(cfg, handle, FDC_KIND_INT, out); \
+    } \
+    int fdc_get_bool_h(const fdc_config* cfg, const fdc_handle handle, int32_t* out) { \
+        return fourdst::config::c_api::detail::read_number(cfg, handle, FDC_KIND_BOOL, out); \
+    } \
+    int fdc_get_string_h(const fdc_config* cfg, const fdc_handle handle, char* buffer, size_t capacity, size_t* length) { \
+        return fourdst::config::c_api::detail::read_string(cfg, handle, buffer, capacity, length); \
+    } \
+    int fdc_get_double_array_h(const fdc_config* cfg, const fdc_handle handle, const double** data, size_t* length) { \
+        return fourdst::config::c_api::detail::read_array(cfg, handle, FDC_KIND_DOUBLE_ARRAY, data, length); \
+    } \
+    int fdc_get_int32_array_h(const fdc_config* cfg, const fdc_handle handle, const int32_t** data, size_t* length) { \
+        return fourdst::config::c_api::detail::read_array(cfg, handle, FDC_KIND_INT32_ARRAY, data, length); \
+    } \
+    int fdc_get_int64_array_h(const fdc_config* cfg, const fdc_handle handle, const int64_t** data, size_t* length) { \
+        return fourdst::config::c_api::detail::read_array(cfg, handle, FDC_KIND_INT64_ARRAY, data, length); \
+    } \
+    int fdc_get_double(const fdc_config* cfg, const char* path, double* out) { \
+        return fdc_get_double_h(cfg, fdc_handle_of(cfg, path), out); \
+    } \
+    int fdc_get_int(const fdc_config* cfg, const char* path, int64_t* out) { \
+        return fdc_get_int_h(cfg, fdc_handle_of(cfg, path), out); \
+    } \
+    int fdc_get_bool(const fdc_config* cfg, const char* path, int32_t* out) { \
+        return fdc_get_bool_h(cfg, fdc_handle_of(cfg, path), out); \
+    } \
+    int fdc_get_string(const fdc_config* cfg, const char* path, char* buffer, size_t capacity, size_t* length) { \
+        return fdc_get_string_h(cfg, fdc_handle_of(cfg, path), buffer, capacity, length); \
+    } \
+    int fdc_get_double_array(const fdc_config* cfg, const char* path, const double** data, size_t* length) { \
+        return fdc_get_double_array_h(cfg, fdc_handle_of(cfg, path), data, length); \
+    } \
+    } \
+    static_assert(true, "")
+
+#endif /* __cplusplus */
+
+#endif /* FOURDST_CONFIG_C_API_H */
@@ -0,0 +1,261 @@
+/**
+ * @file cache.h
+ * @brief Binary sidecar cache that lets `Config::load` skip TOML parsing on warm starts.
+ *
+ * A cache file stores a parsed and validated config next to its TOML source, together with a
+ * hash of the source bytes and a fingerprint of the schema. On load, the source is hashed (much
+ * cheaper than parsing it) and, if the cache matches both, the content is decoded from the cache
+ * instead of being parsed.
+ *
+ * Only content that deserialized successfully is ever cached, so the pair (schema fingerprint,
+ * source hash) identifies a known-good source: a hit goes straight to decoding, with no parse
+ * and no validation pass (the validator only runs to explain a failed deserialization anyway).
+ *
+ * The payload is written with `encode_content()`: the flat binary encoding for plain schemas,
+ * compact JSON for the rest.
+ *
+ * File layout (native endianness):
+ * | magic "4DCFGBIN" | u32 version | u32 byte-order mark | u64 schema fingerprint |
+ * | u64 source hash | u8 root-was-first flag | u64 + bytes root name | payload ... |
+ *
+ * A `ConfigDaemon` (daemon.h) serves the same entries to every process of a node, so jobs that
+ * load the same deck share one parse without writing next to it.
+ *
+ * `FileStamp` uses the same hash to tell whether a source file changed since it was loaded, which
+ * lets `Config::reload()` return early for spurious triggers without parsing or even reading.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "fourdst/config/binary.h"
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/io.h"
+
+namespace fourdst::config::io {
+
+    /**
+     * @brief Content decoded from a cache file, with the root table it was read from.
+     * @tparam T The configuration schema type.
+     */
+    template <typename T>
+    struct CacheEntry {
+        /// The cached content.
+        T content;
+        /// Name of the root table the content was read from.
+        std::string root_name;
+        /// Whether that root table was the first root table of the source file.
+        bool root_was_first = false;
+    };
+
+    namespace detail {
+        inline constexpr std::string_view cache_magic = "4DCFGBIN";
+        inline constexpr std::uint32_t cache_version = 1;
+        inline constexpr std::uint32_t cache_byte_order_mark = 0x01020304;
+    }
+
+    /**
+     * @brief Returns the cache file path used for a config source file.
+     * @param source_path The TOML source path.
+     * @return `source_path` with `.cache` appended.
+     */
+    inline std::string cache_path_for(const std::string_view source_path) {
+        return std::string(source_path) + ".cache";
+    }
+
+    /**
+     * @brief Size, modification time and content hash of a source file when it was loaded.
+     */
+    struct FileStamp {
+        std::string path;
+        std::uintmax_t size = 0;
+        std::filesystem::file_time_type mtime{};
+        std::uint64_t hash = 0;
+        /// When the stamp was taken; a time this close to `mtime` cannot rule out a later write in the same tick.
+        std::filesystem::file_time_type stamped_at{};
+    };
+
+    /**
+     * @brief Stamps the file at `path`, hashing its bytes.
+     * @return The stamp, or nothing if the file cannot be inspected or read.
+     */
+    inline std::optional<FileStamp> stamp_file(const std::string& path) {
+        std::error_code size_ec;
+        std::error_code time_ec;
+        FileStamp stamp{path, std::filesystem::file_size(path, size_ec), std::filesystem::last_write_time(path, time_ec), 0,
+                        std::filesystem::file_time_type::clock::now()};
+        if (size_ec || time_ec) return std::nullopt;
+        try {
+            const MappedFile mapped{path};
+            stamp.hash = hash_bytes(mapped.view());
+        } catch (const exceptions::ConfigLoadError&) {
+            return std::nullopt;
+        }
+        return stamp;
+    }
+
+    /**
+     * @brief Returns whether the file of `stamp` still holds the bytes it was stamped from.
+     *
+     * The same size and modification time count as unchanged without reading the file. With the
+     * same size but another time (a `touch`, an rsync that rewrote identical bytes), the file is
+     * hashed; if the bytes match, `stamp` takes the new time so the next check is cheap again.
+     * A different size is a change. Since file times are only as fine as the kernel's clock tick,
+     * a file stamped within a second of its last write is always hashed, as git does for its index.
+     */
+    inline bool unchanged_since(FileStamp& stamp) {
+        std::error_code size_ec;
+        std::error_code time_ec;
+        const auto size = std::filesystem::file_size(stamp.path, size_ec);
+        const auto mtime = std::filesystem::last_write_time(stamp.path, time_ec);
+        if (size_ec || time_ec || size != stamp.size) return false;
+        if (mtime == stamp.mtime && stamp.mtime + std::chrono::seconds(1) < stamp.stamped_at) return true;
+        const std::optional<FileStamp> current = stamp_file(stamp.path);
+        if (!current || current->size != stamp.size || current->hash != stamp.hash) return false;
+        stamp.mtime = current->mtime;
+        stamp.stamped_at = current->stamped_at;
+        return true;
+    }
+
+    /**
+     * @brief Stamps every file in `paths`; empty if any of them cannot be stamped.
+     */
+    inline std::vector<FileStamp> stamp_files(const std::vector<std::string>& paths) {
+        std::vector<FileStamp> stamps;
+        stamps.reserve(paths.size());
+        for (const auto& path : paths) {
+            std::optional<FileStamp> stamp = stamp_file(path);
+            if (!stamp) return {};
+            stamps.push_back(std::move(*stamp));
+        }
+        return stamps;
+    }
+
+    /**
+     * @brief Returns whether `stamps` cover exactly `paths`, in order, and none of the files changed.
+     */
+    inline bool unchanged_since(std::vector<FileStamp>& stamps, const std::vector<std::string>& paths) {
+        if (stamps.empty() || stamps.size() != paths.size()) return false;
+        for (std::size_t i = 0; i < paths.size(); ++i) {
+            if (stamps[i].path != paths[i] || !unchanged_since(stamps[i])) return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Decodes the bytes of a cache entry if they match the given source hash and the schema of `T`.
+     *
+     * The bytes are those of a cache file, or of an entry served by a `ConfigDaemon` (see
+     * daemon.h), which holds the same encoding. Any mismatch or decoding problem (other schema,
+     * stale source, truncation, other byte order) is reported as a miss rather than an error.
+     *
+     * @tparam T The configuration schema type.
+     * @param data The encoded entry.
+     * @param source_hash `hash_bytes()` of the current source file contents.
+     * @return The cached entry, or `std::nullopt` on a miss.
+     */
+    template <typename T>
+    std::optional<CacheEntry<T>> decode_cache_entry(const std::string_view data, const std::uint64_t source_hash) {
+        if (!data.starts_with(detail::cache_magic)) {
+            return std::nullopt;
+        }
+
+        BinaryReader reader(data.substr(detail::cache_magic.size()));
+        std::uint32_t version = 0;
+        std::uint32_t byte_order = 0;
+        std::uint64_t fingerprint = 0;
+        std::uint64_t hash = 0;
+        CacheEntry<T> entry{};
+        if (!reader.read(version) || version != detail::cache_version ||
+            !reader.read(byte_order) || byte_order != detail::cache_byte_order_mark ||
+            !reader.read(fingerprint) || fingerprint != content_fingerprint<T>() ||
+            !reader.read(hash) || hash != source_hash ||
+            !reader.read(entry.root_was_first) || !reader.read(entry.root_name)) {
+            return std::nullopt;
+        }
+
+        if (!decode_content(data.substr(data.size() - reader.remaining()), entry.content)) {
+            return std::nullopt;
+        }
+        return entry;
+    }
+
+    /**
+     * @brief Encodes a cache entry for the given content; the inverse of `decode_cache_entry()`.
+     * @tparam T The configuration schema type.
+     * @param source_hash `hash_bytes()` of the source file the content was parsed from.
+     * @param root_name Name of the root table the content was read from.
+     * @param root_was_first Whether that root table was the first root table of the source file.
+     * @param content The content to store.
+     * @return The encoded entry.
+     */
+    template <typename T>
+    std::string encode_cache_entry(const std::uint64_t source_hash, const std::string_view root_name, const bool root_was_first,
+                                   const T& content) {
+        std::string buffer(detail::cache_magic);
+        BinaryWriter writer(buffer);
+        writer.write(detail::cache_version);
+        writer.write(detail::cache_byte_order_mark);
+        writer.write(content_fingerprint<T>());
+        writer.write(source_hash);
+        writer.write(root_was_first);
+        writer.write(root_name);
+        encode_content(buffer, content);
+        return buffer;
+    }
+
+    /**
+     * @brief Reads a cache file if it matches the given source hash and the schema of `T`.
+     *
+     * A missing or unreadable file is a miss, as is any mismatch `decode_cache_entry()` reports.
+     *
+     * @tparam T The configuration schema type.
+     * @param cache_path The cache file.
+     * @param source_hash `hash_bytes()` of the current source file contents.
+     * @return The cached entry, or `std::nullopt` on a miss.
+     */
+    template <typename T>
+    std::optional<CacheEntry<T>> read_cache(const std::string& cache_path, const std::uint64_t source_hash) {
+        std::error_code ec;
+        if (!std::filesystem::is_regular_file(cache_path, ec)) {
+            return std::nullopt;
+        }
+
+        std::optional<MappedFile> mapped;
+        try {
+            mapped.emplace(cache_path);
+        } catch (const exceptions::ConfigError&) {
+            return std::nullopt;
+        }
+        return decode_cache_entry<T>(mapped->view(), source_hash);
+    }
+
+    /**
+     * @brief Writes a cache file for the given content.
+     *
+     * The file is replaced atomically, so concurrent readers (for example other ranks of the
+     * same job) see either the old cache or the complete new one.
+     *
+     * @tparam T The configuration schema type.
+     * @param cache_path The cache file.
+     * @param source_hash `hash_bytes()` of the source file the content was parsed from.
+     * @param root_name Name of the root table the content was read from.
+     * @param root_was_first Whether that root table was the first root table of the source file.
+     * @param content The content to store.
+     * @throws exceptions::ConfigSaveError If the cache file cannot be written.
+     */
+    template <typename T>
+    void write_cache(const std::string& cache_path, const std::uint64_t source_hash,
+                     const std::string_view root_name, const bool root_was_first, const T& content) {
+        AtomicFileSink sink(cache_path, false);
+        sink.write(encode_cache_entry(source_hash, root_name, root_was_first, content));
+        sink.commit();
+    }
+}
@@ -0,0 +1,458 @@
+/**
+ * @file campaign.h
+ * @brief An indexed store of many configs of one schema, queried by field value without parsing TOML.
+ *
+ * Finding the runs of a campaign that used some setting would otherwise mean parsing every
+ * archived deck again. `CampaignStore<T>` ingests configs once and keys each by its content
+ * fingerprint (see `fingerprint.h`). The values of chosen leaf paths go into one column per path.
+ * Queries compare those columns, so they touch neither TOML nor the stored contents:
+ *
+ * @code
+ * fourdst::config::CampaignStore<RunSchema> store({"physics.diffusion", "simulation.time_step"});
+ * for (const auto& run : archived) store.add(run);
+ * store.save("campaign.store");
+ *
+ * const auto store = fourdst::config::CampaignStore<RunSchema>::open("campaign.store");
+ * using fourdst::config::QueryOp;
+ * for (const std::uint64_t key : store.query({{"physics.diffusion", QueryOp::EQ, true},
+ *                                             {"simulation.time_step", QueryOp::LT, 1e-3}})) {
+ *     const RunSchema run = *store.find(key);
+ * }
+ * @endcode
+ *
+ * Booleans, integers, floating-point numbers, strings and enums (by name) can be indexed,
+ * including the values inside `rfl::Validator` fields. Containers, optionals and tables cannot.
+ * `add_index()` indexes another path of the configs already stored. Contents are kept in the
+ * encoding `io::encode_content()` writes. The store file holds contents and columns in that
+ * native-endian encoding, under `io::content_fingerprint<T>()`, so one binary reads what another
+ * built only if both share the schema layout and the byte order.
+ */
+#pragma once
+
+#include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "fourdst/config/base.h"
+#include "fourdst/config/binary.h"
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/fingerprint.h"
+#include "fourdst/config/io.h"
+#include "fourdst/config/path_table.h"
+
+#include "rfl.hpp"
+
+namespace fourdst::config {
+
+    /**
+     * @brief A comparison in a `CampaignStore` query.
+     */
+    enum class QueryOp {
+        EQ,
+        NE,
+        LT,
+        LE,
+        GT,
+        GE
+    };
+
+    /**
+     * @brief The value a query compares an indexed field with.
+     */
+    using QueryValue = std::variant<bool, std::int64_t, double, std::string>;
+
+    /**
+     * @brief One condition of a query: the field at `path` compared with `value`.
+     *
+     * Numbers compare with numbers and booleans, strings with strings and enum names.
+     */
+    struct QueryTerm {
+        /// Dotted path of an indexed field.
+        std::string path;
+        /// The comparison.
+        QueryOp op = QueryOp::EQ;
+        /// The value to compare with.
+        QueryValue value;
+
+        QueryTerm(std::string path, const QueryOp op, QueryValue value) : path(std::move(path)), op(op), value(std::move(value)) {}
+
+        /// Lets integer literals of any width be used as values.
+        template <typename V>
+            requires(std::is_integral_v<V> && !std::is_same_v<V, bool>)
+        QueryTerm(std::string path, const QueryOp op, const V value)
+            : path(std::move(path)), op(op), value(static_cast<std::int64_t>(value)) {}
+
+        /// Lets string literals be used as values.
+        QueryTerm(std::string path, const QueryOp op, const char* value) : path(std::move(path)), op(op), value(std::string(value)) {}
+    };
+
+    namespace detail {
+        /**
+         * @brief What a store column holds.
+         */
+        enum class ColumnKind : std::uint8_t {
+            /// Booleans and integers, as `std::int64_t`.
+            INTEGER,
+            /// Floating-point numbers.
+            REAL,
+            /// Strings and enum names.
+            TEXT
+        };
+
+        /**
+         * @brief A leaf field a store can index, and how to read it from a `T`.
+         */
+        template <typename T>
+        struct ColumnField {
+            std::string path;
+            ColumnKind kind = ColumnKind::INTEGER;
+            /// Returns the field of a `T`, converted to the column's representation.
+            QueryValue (*read)(const T&) = nullptr;
+        };
+
+        /// The column kind of a field of type `V`, or nothing if `V` cannot be indexed.
+        template <typename V>
+        constexpr std::optional<ColumnKind> column_kind() {
+            using Type = std::remove_cvref_t<V>;
+            if constexpr (validate::is_rfl_validator_v<Type>) {
+                return column_kind<typename Type::ReflectionType>();
+            } else if constexpr (std::is_same_v<Type, bool> || std::is_integral_v<Type>) {
+                return ColumnKind::INTEGER;
+            } else if constexpr (std::is_floating_point_v<Type>) {
+                return ColumnKind::REAL;
+            } else if constexpr (std::is_same_v<Type, std::string> || std::is_enum_v<Type>) {
+                return ColumnKind::TEXT;
+            } else {
+                return std::nullopt;
+            }
+        }
+
+        /// Converts an indexable field value to its column representation.
+        template <typename V>
+        QueryValue column_value(const V& value) {
+            using Type = std::remove_cvref_t<V>;
+            if constexpr (validate::is_rfl_validator_v<Type>) {
+                return column_value(value.value());
+            } else if constexpr (std::is_same_v<Type, bool> || std::is_integral_v<Type>) {
+                return static_cast<std::int64_t>(value);
+            } else if constexpr (std::is_floating_point_v<Type>) {
+                return static_cast<double>(value);
+            } else if constexpr (std::is_enum_v<Type>) {
+                return rfl::enum_to_string(value);
+            } else {
+                return value;
+            }
+        }
+
+        template <typename T, typename V, typename Access>
+        void collect_column_fields(std::vector<ColumnField<T>>& fields, const std::string& prefix) {
+            using Fields = typename rfl::named_tuple_t<V>::Fields;
+            [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                ([&] {
+                    using Field = rfl::tuple_element_t<Is, Fields>;
+                    using Child = FieldAccess<T, Access, Is>;
+                    std::string path = prefix.empty() ? std::string(Field::name()) : std::format("{}.{}", prefix, Field::name());
+                    if constexpr (is_path_struct_v<typename Field::Type>) {
+                        collect_column_fields<T, typename Field::Type, Child>(fields, path);
+                    } else if constexpr (column_kind<typename Field::Type>().has_value()) {
+                        fields.push_back({std::move(path), *column_kind<typename Field::Type>(),
+                                          [](const T& root) { return column_value(*Child::address(root)); }});
+                    }
+                }(), ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        }
+
+        /**
+         * @brief Returns every leaf of `T` a store can index, in declaration order.
+         */
+        template <typename T>
+        const std::vector<ColumnField<T>>& column_fields() {
+            static const std::vector<ColumnField<T>> fields = [] {
+                std::vector<ColumnField<T>> collected;
+                collect_column_fields<T, T, RootAccess<T>>(collected, "");
+                return collected;
+            }();
+            return fields;
+        }
+
+        /// Whether `ordering` satisfies `op`.
+        template <typename Ordering>
+        bool query_matches(const Ordering ordering, const QueryOp op) {
+            switch (op) {
+                case QueryOp::EQ: return ordering == 0;
+                case QueryOp::NE: return ordering != 0;
+                case QueryOp::LT: return ordering < 0;
+                case QueryOp::LE: return ordering <= 0;
+                case QueryOp::GT: return ordering > 0;
+                case QueryOp::GE: return ordering >= 0;
+            }
+            return false;
+        }
+    }
+
+    /**
+     * @brief Configs of schema `T` keyed by content fingerprint, with columns of chosen leaf fields for queries.
+     *
+     * Adding a config whose content is already stored keeps one copy. Queries and lookups may run
+     * on several threads at once; adding configs or indexes may not run alongside them.
+     */
+    template <IsConfigSchema T>
+    class CampaignStore {
+    public:
+        /**
+         * @brief Creates an empty store that indexes the fields at `indexed_paths`.
+         * @throws exceptions::ConfigPathError If a path names no field, or a field that cannot be indexed.
+         */
+        explicit CampaignStore(const std::vector<std::string>& indexed_paths = {}) {
+            for (const std::string& path : indexed_paths) add_index(path);
+        }
+
+        /**
+         * @brief Stores the published content of `config`.
+         * @return The key of the content, its fingerprint.
+         */
+        std::uint64_t add(const Config<T>& config) { return add(*config.snapshot()); }
+
+        /**
+         * @brief Stores `content`.
+         * @return The key of the content, its fingerprint.
+         */
+        std::uint64_t add(const T& content) {
+            const std::uint64_t key = io::fingerprint_content(content);
+            if (m_rows.contains(key)) return key;
+            std::string encoded;
+            io::encode_content(encoded, content);
+            m_rows.emplace(key, m_keys.size());
+            m_keys.push_back(key);
+            m_contents.push_back(std::move(encoded));
+            for (Column& column : m_columns) column.append(column.field->read(content));
+            return key;
+        }
+
+        /**
+         * @brief Indexes the field at `path` as well, reading it from every config already stored.
+         * @throws exceptions::ConfigPathError If `path` names no field, or a field that cannot be indexed.
+         */
+        void add_index(const std::string_view path) {
+            if (find_column(path) != nullptr) return;
+            Column column{&column_field(path)};
+            T content{};
+            for (const std::string& encoded : m_contents) {
+                if (!io::decode_content(encoded, content)) {
+                    throw exceptions::ConfigLoadError("A config in the campaign store is corrupt.");
+                }
+                column.append(column.field->read(content));
+            }
+            m_columns.push_back(std::move(column));
+        }
+
+        /**
+         * @brief Returns the keys of the configs that satisfy every term, in the order they were added.
+         * @throws exceptions::ConfigPathError If a term names a path that is not indexed, or compares it with a value of another kind.
+         */
+        [[nodiscard]] std::vector<std::uint64_t> query(const std::vector<QueryTerm>& terms) const {
+            std::vector<std::size_t> rows(m_keys.size());
+            for (std::size_t i = 0; i < rows.size(); ++i) rows[i] = i;
+            for (const QueryTerm& term : terms) {
+                const Column* column = find_column(term.path);
+                if (column == nullptr) {
+                    throw exceptions::ConfigPathError(std::format("Field at path '{}' is not indexed by the campaign store.", term.path));
+                }
+                std::erase_if(rows, [&](const std::size_t row) { return !column->matches(row, term); });
+            }
+            std::vector<std::uint64_t> keys;
+            keys.reserve(rows.size());
+            for (const std::size_t row : rows) keys.push_back(m_keys[row]);
+            return keys;
+        }
+
+        /**
+         * @brief Returns the content stored under `key`, or nothing if there is none.
+         * @throws exceptions::ConfigLoadError If the stored content is corrupt.
+         */
+        [[nodiscard]] std::optional<T> find(const std::uint64_t key) const {
+            const auto it = m_rows.find(key);
+            if (it == m_rows.end()) return std::nullopt;
+            T content{};
+            if (!io::decode_content(m_contents[it->second], content)) {
+                throw exceptions::ConfigLoadError("A config in the campaign store is corrupt.");
+            }
+            return content;
+        }
+
+        /// Whether content with fingerprint `key` is stored.
+        [[nodiscard]] bool contains(const std::uint64_t key) const { return m_rows.contains(key); }
+
+        /// The number of distinct contents stored.
+        [[nodiscard]] std::size_t size() const { return m_keys.size(); }
+
+        /// The keys of the stored contents, in the order they were added.
+        [[nodiscard]] const std::vector<std::uint64_t>& keys() const { return m_keys; }
+
+        /// The indexed paths, in the order they were added.
+        [[nodiscard]] std::vector<std::string> indexed_paths() const {
+            std::vector<std::string> paths;
+            for (const Column& column : m_columns) paths.push_back(column.field->path);
+            return paths;
+        }
+
+        /**
+         * @brief Writes the store to `path`.
+         * @param path The file to write.
+         * @param policy How the file is written (IN_PLACE, ATOMIC or DURABLE).
+         * @throws exceptions::ConfigSaveError If the file cannot be written.
+         */
+        void save(const std::string_view path, const SavePolicy policy = SavePolicy::ATOMIC) const {
+            std::string buffer;
+            io::BinaryWriter writer(buffer);
+            writer.write(store_magic);
+            writer.write(io::content_fingerprint<T>());
+            writer.write(m_keys);
+            writer.write(m_contents);
+            writer.write(indexed_paths());
+            for (const Column& column : m_columns) {
+                writer.write(column.integers);
+                writer.write(column.reals);
+                writer.write(column.texts);
+            }
+            if (policy == SavePolicy::IN_PLACE) {
+                io::FileSink sink{std::string(path)};
+                sink.write(buffer);
+                sink.close();
+            } else {
+                io::AtomicFileSink sink{std::string(path), policy == SavePolicy::DURABLE};
+                sink.write(buffer);
+                sink.commit();
+            }
+        }
+
+        /**
+         * @brief Reads a store written by `save()`.
+         * @throws exceptions::ConfigLoadError If the file cannot be read, is not a campaign store, is corrupt,
+         *         or was written by a binary with a different layout of `T`.
+         */
+        [[nodiscard]] static CampaignStore open(const std::string_view path) {
+            const io::MappedFile mapped{std::string(path), io::ReadMode::READ};
+            io::BinaryReader reader(mapped.view());
+            std::uint32_t magic = 0;
+            std::uint64_t fingerprint = 0;
+            if (!reader.read(magic) || magic != store_magic || !reader.read(fingerprint)) {
+                throw exceptions::ConfigLoadError(std::format("Not a campaign store: {}", path));
+            }
+            if (fingerprint != io::content_fingerprint<T>()) {
+                throw exceptions::ConfigLoadError(std::format("The campaign store {} was written with a different layout of the schema.", path));
+            }
+            CampaignStore store;
+            std::vector<std::string> paths;
+            bool intact = reader.read(store.m_keys) && reader.read(store.m_contents) && reader.read(paths) &&
+                          store.m_keys.size() == store.m_contents.size();
+            for (std::size_t i = 0; intact && i < paths.size(); ++i) {
+                const detail::ColumnField<T>* field = find_column_field(paths[i]);
+                Column column{field};
+                intact = field != nullptr && reader.read(column.integers) && reader.read(column.reals) && reader.read(column.texts) &&
+                         column.size() == store.m_keys.size();
+                store.m_columns.push_back(std::move(column));
+            }
+            for (std::size_t i = 0; intact && i < store.m_keys.size(); ++i) {
+                intact = store.m_rows.emplace(store.m_keys[i], i).second;
+            }
+            if (!intact || reader.remaining() != 0) {
+                throw exceptions::ConfigLoadError(std::format("The campaign store {} is truncated or corrupt.", path));
+            }
+            return store;
+        }
+
+    private:
+        static constexpr std::uint32_t store_magic = 0x53434446;
+
+        /**
+         * @brief The values of one indexed field, one per stored config, in the vector its kind uses.
+         */
+        struct Column {
+            const detail::ColumnField<T>* field = nullptr;
+            std::vector<std::int64_t> integers;
+            std::vector<double> reals;
+            std::vector<std::string> texts;
+
+            void append(QueryValue value) {
+                if (auto* integer = std::get_if<std::int64_t>(&value)) {
+                    integers.push_back(*integer);
+                } else if (auto* real = std::get_if<double>(&value)) {
+                    reals.push_back(*real);
+                } else {
+                    texts.push_back(std::move(std::get<std::string>(value)));
+                }
+            }
+
+            [[nodiscard]] std::size_t size() const {
+                switch (field->kind) {
+                    case detail::ColumnKind::INTEGER: return integers.size();
+                    case detail::ColumnKind::REAL: return reals.size();
+                    case detail::ColumnKind::TEXT: return texts.size();
+                }
+                return 0;
+            }
+
+            [[nodiscard]] bool matches(const std::size_t row, const QueryTerm& term) const {
+                const bool text_term = std::holds_alternative<std::string>(term.value);
+                if (text_term != (field->kind == detail::ColumnKind::TEXT)) {
+                    throw exceptions::ConfigPathError(
+                        std::format("Field at path '{}' cannot be compared with a {}.", term.path, text_term ? "string" : "number"));
+                }
+                if (text_term) return detail::query_matches(texts[row].compare(std::get<std::string>(term.value)), term.op);
+                if (field->kind == detail::ColumnKind::INTEGER) {
+                    if (const auto* integer = std::get_if<std::int64_t>(&term.value)) {
+                        return detail::query_matches(integers[row] <=> *integer, term.op);
+                    }
+                    if (const auto* flag = std::get_if<bool>(&term.value)) {
+                        return detail::query_matches(integers[row] <=> std::int64_t{*flag}, term.op);
+                    }
+                    return detail::query_matches(static_cast<double>(integers[row]) <=> std::get<double>(term.value), term.op);
+                }
+                const double value = std::visit([](const auto& v) -> double {
+                    if constexpr (std::is_same_v<std::remove_cvref_t<decltype(v)>, std::string>) {
+                        return 0.0;
+                    } else {
+                        return static_cast<double>(v);
+                    }
+                }, term.value);
+                return detail::query_matches(reals[row] <=> value, term.op);
+            }
+        };
+
+        [[nodiscard]] static const detail::ColumnField<T>* find_column_field(const std::string_view path) {
+            const auto& fields = detail::column_fields<T>();
+            const auto it = std::ranges::find(fields, path, &detail::ColumnField<T>::path);
+            return it == fields.end() ? nullptr : &*it;
+        }
+
+        [[nodiscard]] static const detail::ColumnField<T>& column_field(const std::string_view path) {
+            if (const detail::ColumnField<T>* field = find_column_field(path)) return *field;
+            if (detail::PathTable<T>::find(path) == detail::PathTable<T>::npos) {
+                throw exceptions::ConfigPathError(std::format("No field at path '{}' in the configuration schema.", path));
+            }
+            throw exceptions::ConfigPathError(std::format(
+                "Field at path '{}' cannot be indexed: only booleans, numbers, strings and enums can.", path));
+        }
+
+        [[nodiscard]] const Column* find_column(const std::string_view path) const {
+            const auto it = std::ranges::find_if(m_columns, [path](const Column& column) { return column.field->path == path; });
+            return it == m_columns.end() ? nullptr : &*it;
+        }
+
+        std::vector<std::uint64_t> m_keys;
+        std::vector<std::string> m_contents;
+        std::unordered_map<std::uint64_t, std::size_t> m_rows;
+        std::vector<Column> m_columns;
+    };
+}
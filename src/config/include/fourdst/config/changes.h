@@ -0,0 +1,221 @@
+/**
+ * @file changes.h
+ * @brief Awaiting published snapshots from C++20 coroutines.
+ *
+ * `Config::changes()` returns a `ChangeStream`, an awaitable that suspends the calling coroutine
+ * until the config publishes a new snapshot and resumes it with that snapshot and its
+ * generation. Everything that publishes counts: `load()`, `reload()` (including the reloads of a
+ * `ConfigWatcher`), `mutate()`, `set()`, `apply_patch()`, `undo()` and `reset()`. Snapshots
+ * published faster than a consumer awaits them are coalesced: the consumer resumes once, with
+ * the newest one.
+ *
+ * @code
+ * task<void> follow(fourdst::config::Config<AppConfig>& cfg) {
+ *     auto changes = cfg.changes();
+ *     while (true) {
+ *         const auto [content, generation] = co_await changes;
+ *         if (!content) co_return;  // the config was destroyed
+ *         rebuild(*content);
+ *     }
+ * }
+ * @endcode
+ *
+ * A suspended coroutine is resumed on the stream's executor: the one passed to `changes()`, else
+ * the default executor (see executor.h) if one is installed, else inline on the thread that
+ * published, after the content lock has been released, like a `subscribe()` callback. Destroying
+ * a coroutine while it waits withdraws its wait. Nothing is tied to a particular coroutine
+ * library; the awaiter works with any task type.
+ */
+#pragma once
+
+#include <algorithm>
+#include <coroutine>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/executor.h"
+
+namespace fourdst::config {
+
+    namespace detail {
+        /**
+         * @brief The coroutines waiting for the snapshots of one config.
+         *
+         * `Snapshot` has a `generation` member. The config reports each publication with
+         * `publish()` after releasing its content lock, and `close()` when it is destroyed.
+         */
+        template <typename Snapshot>
+        class ChangeChannel {
+        public:
+            /**
+             * @brief One suspended wait, living in the frame of the waiting coroutine.
+             */
+            struct Waiter {
+                std::coroutine_handle<> handle;
+                AnyExecutor executor;
+                /// The last generation the coroutine has seen; it resumes on a newer one.
+                std::uint64_t after = 0;
+                Snapshot result{};
+            };
+
+            /**
+             * @param read Returns the current snapshot; called under the channel lock until `close()`.
+             */
+            explicit ChangeChannel(std::function<Snapshot()> read) : m_read(std::move(read)) {}
+
+            /**
+             * @brief Queues `waiter`, or fills its result and returns false if a newer snapshot is already published.
+             */
+            bool wait(Waiter* waiter) {
+                const std::lock_guard lock(m_mutex);
+                if (!m_read) {
+                    waiter->result = Snapshot{};
+                    return false;
+                }
+                if (m_generation > waiter->after) {
+                    waiter->result = m_read();
+                    return false;
+                }
+                m_waiters.push_back(waiter);
+                return true;
+            }
+
+            /**
+             * @brief Withdraws `waiter` if it is still queued.
+             */
+            void cancel(Waiter* waiter) {
+                const std::lock_guard lock(m_mutex);
+                std::erase(m_waiters, waiter);
+            }
+
+            /**
+             * @brief Records `latest` as published and resumes the waiters older than it.
+             */
+            void publish(const Snapshot& latest) {
+                std::vector<Waiter*> ready;
+                {
+                    const std::lock_guard lock(m_mutex);
+                    m_generation = std::max(m_generation, latest.generation);
+                    if (m_waiters.empty()) return;
+                    const auto stale = std::ranges::partition(m_waiters, [&](const Waiter* w) { return w->after >= latest.generation; });
+                    ready.assign(stale.begin(), stale.end());
+                    m_waiters.erase(stale.begin(), stale.end());
+                }
+                for (Waiter* waiter : ready) waiter->result = latest;
+                resume(ready);
+            }
+
+            /**
+             * @brief Resumes every waiter with an empty snapshot; later waits return one at once.
+             */
+            void close() {
+                std::vector<Waiter*> ready;
+                {
+                    const std::lock_guard lock(m_mutex);
+                    m_read = nullptr;
+                    ready.swap(m_waiters);
+                }
+                for (Waiter* waiter : ready) waiter->result = Snapshot{};
+                resume(ready);
+            }
+
+        private:
+            static void resume(const std::vector<Waiter*>& ready) {
+                for (Waiter* waiter : ready) {
+                    // The waiter belongs to the frame being resumed; nothing of it is touched afterwards.
+                    const std::coroutine_handle<> handle = waiter->handle;
+                    if (waiter->executor) {
+                        const AnyExecutor executor = std::move(waiter->executor);
+                        executor([handle] { handle.resume(); });
+                    } else {
+                        handle.resume();
+                    }
+                }
+            }
+
+            std::mutex m_mutex;
+            std::function<Snapshot()> m_read;
+            std::uint64_t m_generation = 0;
+            std::vector<Waiter*> m_waiters;
+        };
+    }
+
+    /**
+     * @brief An awaitable sequence of the snapshots a config publishes; see `Config::changes()`.
+     *
+     * Each `co_await` resumes with the first snapshot newer than the last one the stream returned
+     * (or than the generation current when the stream was created). A stream is awaited by one
+     * coroutine at a time; separate consumers take separate streams. It may outlive its config,
+     * in which case awaiting it returns an empty snapshot at once.
+     *
+     * @tparam Snapshot `Config<T>::VersionedSnapshot`.
+     */
+    template <typename Snapshot>
+    class ChangeStream {
+    public:
+        using Channel = detail::ChangeChannel<Snapshot>;
+
+        /**
+         * @brief The awaiter of one wait.
+         */
+        class Awaiter {
+        public:
+            explicit Awaiter(ChangeStream& stream) : m_stream(&stream) {
+                m_waiter.executor = stream.m_executor;
+                m_waiter.after = stream.m_seen;
+            }
+
+            Awaiter(const Awaiter&) = delete;
+            Awaiter& operator=(const Awaiter&) = delete;
+
+            ~Awaiter() {
+                if (m_queued) m_stream->m_channel->cancel(&m_waiter);
+            }
+
+            [[nodiscard]] bool await_ready() const noexcept { return false; }
+
+            bool await_suspend(const std::coroutine_handle<> handle) {
+                m_waiter.handle = handle;
+                // Set first: once queued, the coroutine may resume on another thread before wait() returns.
+                m_queued = true;
+                if (m_stream->m_channel->wait(&m_waiter)) return true;
+                m_queued = false;
+                return false;
+            }
+
+            Snapshot await_resume() {
+                m_queued = false;
+                if (m_waiter.result.content) m_stream->m_seen = m_waiter.result.generation;
+                return std::move(m_waiter.result);
+            }
+
+        private:
+            ChangeStream* m_stream;
+            typename Channel::Waiter m_waiter;
+            bool m_queued = false;
+        };
+
+        ChangeStream(std::shared_ptr<Channel> channel, const std::uint64_t seen, AnyExecutor executor)
+            : m_channel(std::move(channel)), m_seen(seen), m_executor(std::move(executor)) {}
+
+        /**
+         * @brief Waits for the next snapshot; `content` is null once the config has been destroyed.
+         */
+        [[nodiscard]] Awaiter next() { return Awaiter(*this); }
+
+        /// Same as `next()`, so the stream itself can be awaited.
+        Awaiter operator co_await() { return Awaiter(*this); }
+
+        /// The generation of the last snapshot the stream returned, or the one current at creation.
+        [[nodiscard]] std::uint64_t generation() const noexcept { return m_seen; }
+
+    private:
+        std::shared_ptr<Channel> m_channel;
+        std::uint64_t m_seen;
+        AnyExecutor m_executor;
+    };
+}
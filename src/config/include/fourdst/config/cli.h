@@ -3,32 +3,311 @@
  * @brief Integration layer between libconfig and CLI applications.
  *
  * This file contains utilities for automatically mapping C++ configuration structures
- * to command-line arguments, primarily supporting the CLI11 library.
+ * to command-line arguments, primarily supporting the CLI11 library, and for expanding
+ * `@file` response files on the command line before it is parsed.
  */
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <type_traits>
+#include <utility>
+#include <vector>
+
 #include "fourdst/config/base.h"
+#include "fourdst/config/enum_index.h"
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/path_table.h"
+#include "fourdst/config/provenance.h"
+#include "fourdst/config/validate.h"
+
 #include "rfl.hpp"
 
 namespace fourdst::config {
     template <typename T>
     struct InspectType;
 
+    /**
+     * @brief How `register_as_cli` lays out the options of nested structs.
+     */
+    enum class CliLayout {
+        /**
+         * @brief Every field is one option of the application, named by its dotted path (`--simulation.time_step`).
+         */
+        FLAT,
+        /**
+         * @brief Each nested struct is a subcommand, and its fields are options named by the field
+         *        (`simulation --time_step 0.5`). A subcommand's options are only registered when it
+         *        appears on the command line, so start-up and `--help` cost scale with the groups used.
+         */
+        SUBCOMMANDS
+    };
+
     /**
      * @brief Concept that defines the requirements for a CLI application class.
      *
-     * This concept ensures that the CLI application class `T` has an `add_option` member function
-     * compatible with the signature expected by `register_as_cli`. It is satisfied by `CLI::App` from CLI11.
+     * This concept ensures that the CLI application class `T` has an `add_option_function` member
+     * template compatible with the calls made by `register_as_cli`. It is satisfied by `CLI::App` from CLI11.
      *
      * @tparam T The type to check against the concept.
      */
     template <typename T>
     concept IsCLIApp = requires(T app, std::string name, std::string description)
     {
-        {app.add_option(name, std::declval<int&>(), description)};
+        {app.template add_option_function<int>(name, std::function<void(const int&)>{}, description)};
     };
 
+    namespace detail {
+        template <typename Type>
+        constexpr bool is_cli_scalar_v = std::is_arithmetic_v<Type> || std::is_same_v<Type, std::string>;
+
+        /// Field types that can be given on the command line.
+        template <typename Type>
+        constexpr bool is_cli_value_v = [] {
+            if constexpr (is_cli_scalar_v<Type> || std::is_enum_v<Type>) {
+                return true;
+            } else if constexpr (validate::is_optional_v<Type>) {
+                using Inner = typename Type::value_type;
+                return is_cli_scalar_v<Inner> || std::is_enum_v<Inner>;
+            } else if constexpr (validate::is_vector_v<Type> || validate::is_std_array_v<Type>) {
+                return is_cli_scalar_v<typename Type::value_type>;
+            } else {
+                return false;
+            }
+        }();
+
+        /// The type CLI11 parses for a field of type `Type`: enums by name, optionals by their value type.
+        template <typename Type>
+        struct cli_arg { using type = Type; };
+        template <typename Type>
+            requires std::is_enum_v<Type>
+        struct cli_arg<Type> { using type = std::string; };
+        template <typename Type>
+        struct cli_arg<std::optional<Type>> : cli_arg<Type> {};
+        template <typename Type>
+        using cli_arg_t = typename cli_arg<Type>::type;
+
+        template <typename Type>
+        Type from_cli(const std::string_view prefix, const std::string_view path, const cli_arg_t<Type>& arg) {
+            if constexpr (validate::is_optional_v<Type>) {
+                return Type(from_cli<typename Type::value_type>(prefix, path, arg));
+            } else if constexpr (std::is_enum_v<Type>) {
+                auto result = io::enum_from_string<Type>(arg);
+                if (!result) {
+                    throw exceptions::ConfigParseError(std::format("Invalid value '{}' for option {}{}{}: {}", arg, prefix,
+                                                                   prefix.empty() ? "" : ".", path, result.error().what()));
+                }
+                return result.value();
+            } else {
+                return arg;
+            }
+        }
+
+        /**
+         * @brief The option names and help texts of the fields of a schema, built at compile time.
+         *
+         * Entries follow the order of `PathTable<T>` (a pre-order walk over the fields), and each
+         * holds `"--"` followed by the dotted path, and `"Configuration option for "` followed by
+         * the path, in two static character arrays, so registering options concatenates nothing.
+         */
+        template <typename T>
+        class CliNames {
+            static constexpr std::string_view s_option_lead = "--";
+            static constexpr std::string_view s_description_lead = "Configuration option for ";
+
+            static constexpr PathTableSize s_size = [] {
+                PathTableSize size;
+                measure_paths<T>(size, 0);
+                return size;
+            }();
+
+            struct Span {
+                std::size_t begin = 0;
+                std::size_t length = 0;
+            };
+
+            struct Data {
+                std::array<char, s_size.chars + s_size.entries * s_option_lead.size()> options{};
+                std::array<char, s_size.chars + s_size.entries * s_description_lead.size()> descriptions{};
+                std::array<Span, s_size.entries> option_spans{};
+                std::array<Span, s_size.entries> description_spans{};
+            };
+
+            template <typename V>
+            static constexpr void collect(Data& data, std::size_t& next_entry, std::size_t& next_option, std::size_t& next_description,
+                                          const std::size_t parent_begin, const std::size_t parent_length) {
+                using Fields = typename rfl::named_tuple_t<V>::Fields;
+                [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                    ([&] {
+                        using Field = rfl::tuple_element_t<Is, Fields>;
+                        const std::size_t option_begin = next_option;
+                        for (const char c : s_option_lead) data.options[next_option++] = c;
+                        const std::size_t path_begin = next_option;
+                        for (std::size_t i = 0; i < parent_length; ++i) {
+                            data.options[next_option++] = data.options[parent_begin + i];
+                        }
+                        if (parent_length != 0) data.options[next_option++] = '.';
+                        for (const char c : Field::name()) data.options[next_option++] = c;
+                        const std::size_t path_length = next_option - path_begin;
+
+                        const std::size_t description_begin = next_description;
+                        for (const char c : s_description_lead) data.descriptions[next_description++] = c;
+                        for (std::size_t i = 0; i < path_length; ++i) {
+                            data.descriptions[next_description++] = data.options[path_begin + i];
+                        }
+
+                        data.option_spans[next_entry] = {option_begin, next_option - option_begin};
+                        data.description_spans[next_entry] = {description_begin, next_description - description_begin};
+                        ++next_entry;
+                        if constexpr (is_path_struct_v<typename Field::Type>) {
+                            collect<typename Field::Type>(data, next_entry, next_option, next_description, path_begin, path_length);
+                        }
+                    }(), ...);
+                }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+            }
+
+            static constexpr Data build() {
+                Data data;
+                std::size_t next_entry = 0;
+                std::size_t next_option = 0;
+                std::size_t next_description = 0;
+                collect<T>(data, next_entry, next_option, next_description, 0, 0);
+                return data;
+            }
+
+            static const Data s_data;
+
+        public:
+            /**
+             * @brief Returns the option name of the field at `index`, e.g. `"--simulation.time_step"`.
+             */
+            static constexpr std::string_view option(const std::size_t index) {
+                return {s_data.options.data() + s_data.option_spans[index].begin, s_data.option_spans[index].length};
+            }
+
+            /**
+             * @brief Returns the dotted path of the field at `index`.
+             */
+            static constexpr std::string_view path(const std::size_t index) { return option(index).substr(s_option_lead.size()); }
+
+            /**
+             * @brief Returns the help text of the field at `index`.
+             */
+            static constexpr std::string_view description(const std::size_t index) {
+                return {s_data.descriptions.data() + s_data.description_spans[index].begin, s_data.description_spans[index].length};
+            }
+        };
+
+        template <typename T>
+        constexpr typename CliNames<T>::Data CliNames<T>::s_data = CliNames<T>::build();
+
+        /**
+         * @brief Adds one option per CLI-expressible field of `content`, recursing into nested structs.
+         *
+         * `base` is the index in `CliNames<Root>` of the first field of `Struct`. Without a prefix,
+         * option names and help texts are taken from that table as they are. `make_apply(field, path)`
+         * returns the callable that receives the parsed field value; `path` points into static storage.
+         */
+        template <typename Root, typename Struct, typename CliApp, typename MakeApply>
+        void register_cli_fields(Struct& content, CliApp& app, const std::string& prefix, const std::size_t base,
+                                 const MakeApply& make_apply) {
+            using Names = CliNames<Root>;
+            auto view = rfl::to_view(content);
+            std::size_t index = base;
+            view.apply([&](auto f) {
+                auto* value = f.value();
+                using ValueType = std::remove_cvref_t<decltype(*value)>;
+
+                if constexpr (is_path_struct_v<ValueType>) {
+                    register_cli_fields<Root>(*value, app, prefix, index + 1, make_apply);
+                } else if constexpr (is_cli_value_v<ValueType>) {
+                    using Arg = cli_arg_t<ValueType>;
+                    const std::string_view path = Names::path(index);
+                    auto apply = make_apply(value, path);
+                    std::function<void(const Arg&)> callback([apply, prefix, path](const Arg& arg) {
+                        apply(from_cli<ValueType>(prefix, path, arg));
+                    });
+                    if (prefix.empty()) {
+                        app.template add_option_function<Arg>(std::string(Names::option(index)), std::move(callback),
+                                                              std::string(Names::description(index)));
+                    } else {
+                        app.template add_option_function<Arg>(std::format("--{}.{}", prefix, path), std::move(callback),
+                                                              std::format("Configuration option for {}.{}", prefix, path));
+                    }
+                }
+                index = PathTable<Root>::entry(index).end;
+            });
+        }
+
+        /**
+         * @brief Adds the leaf fields of `content` to `app` as options named by the field, and each
+         *        nested struct as a subcommand whose own options are added when it is first parsed.
+         *
+         * `base` and `make_apply` are as for `register_cli_fields`; `make_apply` is copied into the
+         * subcommands, so it must not refer to temporaries.
+         */
+        template <typename Root, typename Struct, typename CliApp, typename MakeApply>
+        void register_cli_groups(Struct& content, CliApp& app, const std::size_t base, const MakeApply& make_apply) {
+            using Names = CliNames<Root>;
+            auto view = rfl::to_view(content);
+            std::size_t index = base;
+            view.apply([&](auto f) {
+                auto* value = f.value();
+                using ValueType = std::remove_cvref_t<decltype(*value)>;
+
+                if constexpr (is_path_struct_v<ValueType>) {
+                    auto* group = app.add_subcommand(std::string(f.name()), std::string(Names::description(index)));
+                    // Runs when the subcommand is named on the command line, before its arguments are parsed.
+                    group->preparse_callback([group, value, index, make_apply, registered = false](std::size_t) mutable {
+                        if (registered) return;
+                        registered = true;
+                        register_cli_groups<Root>(*value, *group, index + 1, make_apply);
+                    });
+                } else if constexpr (is_cli_value_v<ValueType>) {
+                    using Arg = cli_arg_t<ValueType>;
+                    const std::string_view path = Names::path(index);
+                    auto apply = make_apply(value, path);
+                    std::function<void(const Arg&)> callback([apply, path](const Arg& arg) {
+                        apply(from_cli<ValueType>("", path, arg));
+                    });
+                    app.template add_option_function<Arg>(std::format("--{}", f.name()), std::move(callback),
+                                                          std::string(Names::description(index)));
+                }
+                index = PathTable<Root>::entry(index).end;
+            });
+        }
+
+        /**
+         * @brief Registers `content` in `app` flat or as subcommands; see `register_as_cli`.
+         */
+        template <typename Root, typename CliApp, typename MakeApply>
+        void register_cli(Root& content, CliApp& app, const std::string& prefix, const CliLayout layout, const MakeApply& make_apply) {
+            if (layout == CliLayout::FLAT) {
+                register_cli_fields<Root>(content, app, prefix, 0, make_apply);
+            } else if constexpr (requires { app.add_subcommand(prefix, prefix); }) {
+                if (prefix.empty()) {
+                    register_cli_groups<Root>(content, app, 0, make_apply);
+                } else {
+                    auto* group = app.add_subcommand(prefix, "Configuration options");
+                    group->preparse_callback([group, &content, make_apply, registered = false](std::size_t) mutable {
+                        if (registered) return;
+                        registered = true;
+                        register_cli_groups<Root>(content, *group, 0, make_apply);
+                    });
+                }
+            } else {
+                throw exceptions::ConfigError("CliLayout::SUBCOMMANDS needs a CLI application with add_subcommand().");
+            }
+        }
+    }
+
     /**
      * @brief Type trait to determine if a type is a Config wrapper.
      *
@@ -53,19 +332,32 @@ namespace fourdst::config {
      * @brief Registers configuration structure fields as CLI options.
      *
      * This function iterates over the members of the provided configuration object using reflection
-     * and registers each member as a command-line option in the provided CLI application.
+     * and registers each member as a typed command-line option in the provided CLI application.
+     * Scalars, strings, enums (by name), `std::optional`s of those, and `std::vector`/`std::array`
+     * of scalars and strings are supported; other fields (maps, arrays of tables, optional
+     * sub-tables) have no option.
      *
      * If the configuration object contains nested structures, field names are flattened using dot notation
-     * (e.g., `parent.child.field`).
+     * (e.g., `parent.child.field`). With `CliLayout::SUBCOMMANDS`, each nested structure is a
+     * subcommand instead, holding the options of its own fields; its options are registered only
+     * when it is named on the command line (through the CLI11 pre-parse callback), so schemas with
+     * thousands of fields start quickly and print short help screens.
      *
-     * If `T` is a `Config<U>` wrapper, it automatically unwraps the inner value and adds a footer note
-     * to the CLI application's help message indicating that options were auto-generated.
+     * If `T` is a `Config<U>` wrapper, each parsed value is applied with `Config::set_override()`,
+     * so it is published, recorded for `undo()` and reported to subscribers without serializing or
+     * reparsing the config, and it stays the final layer over anything loaded later
+     * (`load()`, `load_layers()`, `reload()`); a footer note is also added to the help message indicating that
+     * options were auto-generated. For a raw struct, values are written straight into its fields.
      *
      * @tparam T The type of the configuration object. Can be a raw struct or a `Config<Struct>` wrapper.
      * @tparam CliApp The type of the CLI application object. Must satisfy the `IsCLIApp` concept (e.g., `CLI::App`).
-     * @param config The configuration object to register.
+     * @param config The configuration object to register; must outlive parsing.
      * @param app The CLI application instance to add options to.
-     * @param prefix Optional prefix for option names. Used internally for recursion; usually omitted by the caller.
+     * @param layout Whether nested structures are flattened (the default) or become subcommands.
+     * @param prefix Optional prefix for option names (e.g. `"cfg"` gives `--cfg.simulation.time_step`);
+     *        with `CliLayout::SUBCOMMANDS`, the name of a subcommand that holds all the others.
+     * @throws exceptions::ConfigError If `layout` is `SUBCOMMANDS` and `CliApp` has no `add_subcommand()`.
+     * @throws exceptions::ConfigParseError From parsing, if an enum option is given an unknown name.
      *
      * @par Examples
      * Basic usage with CLI11:
@@ -108,37 +400,181 @@ namespace fourdst::config {
      * fourdst::config::Config<AppConfig> cfg;
      * // Registers: --server.port, --server.host, --dry_run
      * fourdst::config::register_as_cli(cfg, app);
+     *
+     * // Or: --dry_run, and a subcommand `server` with --port and --host, as in
+     * //   my_app --dry_run server --port 9000
+     * fourdst::config::register_as_cli(cfg, app, fourdst::config::CliLayout::SUBCOMMANDS);
      * @endcode
      */
     template <typename T, typename CliApp>
-    void register_as_cli(T& config, CliApp& app, const std::string& prefix="") {
+    void register_as_cli(T& config, CliApp& app, const CliLayout layout, const std::string& prefix = "") {
         if constexpr (is_config_wrapper<T>::value) {
             app.footer("\nNOTE:\n"
                 "Configuration options were automatically generated from the config schema.\n"
                 "Use the --help flag to see all available options."
             );
-            register_as_cli(*config, app, prefix);
+            detail::register_cli(*config, app, prefix, layout, [&config]<typename V>(V*, const std::string_view path) {
+                return [&config, path](V value) { config.set_override(path, std::move(value)); };
+            });
         } else {
-            auto view = rfl::to_view(config);
-            view.apply([&](auto f) {
-                auto& value = f.value();
-                using ValueType = std::remove_pointer_t<std::decay_t<decltype(value)>>;
+            detail::register_cli(config, app, prefix, layout, []<typename V>(V* field, const std::string_view) {
+                return [field](V value) { *field = std::move(value); };
+            });
+        }
+    }
+
+    /**
+     * @brief Registers configuration structure fields as flat CLI options; see `register_as_cli(config, app, layout, prefix)`.
+     */
+    template <typename T, typename CliApp>
+    void register_as_cli(T& config, CliApp& app, const std::string& prefix = "") {
+        register_as_cli(config, app, CliLayout::FLAT, prefix);
+    }
+
+    /**
+     * @brief A command line with its response files expanded, in the `argc`/`argv` form parsers take.
+     *
+     * The strings are owned by the object, which cannot be copied or moved, so `argv()` stays valid as long as it lives.
+     */
+    class CliArguments {
+    public:
+        explicit CliArguments(std::vector<std::string> args) : m_args(std::move(args)) {
+            m_pointers.reserve(m_args.size() + 1);
+            for (const auto& arg : m_args) m_pointers.push_back(arg.c_str());
+            m_pointers.push_back(nullptr);
+        }
 
-                const auto name = std::string(f.name());
-                std::string field_name = prefix.empty() ? name : prefix + "." + name;
+        CliArguments(const CliArguments&) = delete;
+        CliArguments& operator=(const CliArguments&) = delete;
 
-                if constexpr (IsConfigSchema<ValueType>) {
-                    register_as_cli(*value, app, field_name);
-                }
-                else {
-                    app.add_option(
-                        "--" + field_name,
-                        *value,
-                        "Configuration option for " + field_name
-                    );
+        /**
+         * @brief Returns the number of arguments, including the program name.
+         */
+        [[nodiscard]] int argc() const { return static_cast<int>(m_args.size()); }
+
+        /**
+         * @brief Returns the arguments, ending in a null pointer as `main()` receives them.
+         */
+        [[nodiscard]] const char* const* argv() const { return m_pointers.data(); }
+
+        /**
+         * @brief Returns the arguments as strings.
+         */
+        [[nodiscard]] const std::vector<std::string>& args() const { return m_args; }
+
+    private:
+        std::vector<std::string> m_args;
+        std::vector<const char*> m_pointers;
+    };
+
+    namespace detail {
+        /// How deeply response files may name further response files before a cycle is assumed.
+        inline constexpr int max_response_file_depth = 16;
+
+        /**
+         * @brief Splits the text of a response file into arguments and expands the `@file` arguments among them.
+         *
+         * Arguments are separated by whitespace. Single quotes keep everything up to the closing
+         * quote; double quotes group text in which a backslash escapes the next character, as it
+         * does outside quotes.
+         */
+        inline void expand_response_file(const std::string& path, const int depth, std::vector<std::string>& args);
+
+        inline void expand_argument(std::string arg, const int depth, std::vector<std::string>& args) {
+            if (arg.size() > 1 && arg.front() == '@') {
+                expand_response_file(arg.substr(1), depth + 1, args);
+            } else {
+                args.push_back(std::move(arg));
+            }
+        }
+
+        inline void expand_response_file(const std::string& path, const int depth, std::vector<std::string>& args) {
+            if (depth > max_response_file_depth) {
+                throw exceptions::ConfigLoadError(
+                    std::format("Response file {} is nested more than {} levels deep; do the files name each other?", path,
+                                max_response_file_depth));
+            }
+            std::ifstream in(path, std::ios::binary);
+            if (!in) {
+                throw exceptions::ConfigLoadError(std::format("Unable to open response file: {}", path));
+            }
+            const std::string text{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+
+            std::string current;
+            bool in_argument = false;
+            char quote = 0;
+            for (std::size_t i = 0; i < text.size(); ++i) {
+                const char c = text[i];
+                if (quote == '\'') {
+                    if (c == '\'') {
+                        quote = 0;
+                    } else {
+                        current += c;
+                    }
+                } else if (c == '\\' && i + 1 < text.size()) {
+                    current += text[++i];
+                    in_argument = true;
+                } else if (quote == '"') {
+                    if (c == '"') {
+                        quote = 0;
+                    } else {
+                        current += c;
+                    }
+                } else if (c == '\'' || c == '"') {
+                    quote = c;
+                    in_argument = true;
+                } else if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v') {
+                    if (in_argument) {
+                        expand_argument(std::move(current), depth, args);
+                        current.clear();
+                        in_argument = false;
+                    }
+                } else {
+                    current += c;
+                    in_argument = true;
                 }
+            }
+            if (quote != 0) {
+                throw exceptions::ConfigLoadError(std::format("Unterminated {} quote in response file: {}", quote, path));
+            }
+            if (in_argument) {
+                expand_argument(std::move(current), depth, args);
+            }
+        }
+    }
 
-            });
+    /**
+     * @brief Replaces every `@file` argument with the arguments listed in that file.
+     *
+     * Batch orchestrators can then hand a tool a long list of overrides as one file
+     * (`simulate @run.args`) instead of a command line the shell may truncate. Response files
+     * hold whitespace-separated arguments, with quoting as in a POSIX shell (single quotes, double
+     * quotes and backslash escapes), and may name further response files. Paths are relative to
+     * the working directory. The program name is never expanded, and a lone `@` is kept.
+     *
+     * CLI11 has no hook that rewrites the command line, so expand it before parsing, after
+     * `register_as_cli()`:
+     *
+     * @code
+     * const auto args = fourdst::config::expand_response_files(argc, argv);
+     * CLI11_PARSE(app, args.argc(), args.argv());
+     * @endcode
+     *
+     * @param argc The argument count passed to `main()`.
+     * @param argv The arguments passed to `main()`.
+     * @return The expanded command line.
+     * @throws exceptions::ConfigLoadError If a response file cannot be read, has an unterminated quote, or the files nest too deeply.
+     */
+    [[nodiscard]] inline CliArguments expand_response_files(const int argc, const char* const* argv) {
+        std::vector<std::string> args;
+        args.reserve(static_cast<std::size_t>(argc));
+        for (int i = 0; i < argc; ++i) {
+            if (i == 0) {
+                args.emplace_back(argv[i]);
+            } else {
+                detail::expand_argument(argv[i], 0, args);
+            }
         }
+        return CliArguments(std::move(args));
     }
-}
\ No newline at end of file
+}
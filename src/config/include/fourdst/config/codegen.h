@@ -0,0 +1,368 @@
+/**
+ * @file codegen.h
+ * @brief Generated TOML readers: straight-line code, written at build time, for loading one schema.
+ *
+ * `Config::load()` deserializes through reflect-cpp, whose parsers are instantiated for the whole
+ * schema in every unit that loads it and look each field up through a named tuple. For a schema
+ * that is fixed when a binary is built, `codegen_main<T>()` is the body of a small generator
+ * program that writes a header specializing `io::GeneratedReader` for `T` and each struct below it.
+ * Each specialization reads its fields one after another by name, with no reflection:
+ *
+ * @code
+ * // physics_codegen.cpp, built for the build machine
+ * #include "physics_schema.h"
+ * #include "fourdst/config/codegen.h"
+ * int main(int argc, char** argv) { return fourdst::config::codegen_main<PhysicsSchema>(argc, argv); }
+ * @endcode
+ *
+ * @code{.meson}
+ * physics_codegen = executable('physics_codegen', 'physics_codegen.cpp', dependencies: config_dep, native: true)
+ * physics_reader_h = custom_target('physics_reader',
+ *     output: 'physics_reader.h',
+ *     command: [physics_codegen, '@OUTPUT@', 'physics_schema.h'])
+ * @endcode
+ *
+ * A unit that includes the generated header before it loads a `Config<PhysicsSchema>` reads TOML
+ * through the generated code; saving, validation and error reports are unchanged. When a load
+ * fails, the validator runs over the document as before, so the messages are the same.
+ *
+ * Booleans, integers, floating-point numbers, `std::string`, `std::optional`, `std::vector`,
+ * `std::array`, string-keyed maps and nested structs are read by the generated code; other field
+ * types (enums, wrappers such as `Section` or `Quantity`) are read by their reflect-cpp parser, so
+ * only those fields instantiate one, as are `std::pmr` strings and vectors, which take the memory
+ * resource of the load, and arrays of tables while a parallel read is set. Fields are accessed by the names they have in TOML, so a
+ * schema with renamed fields does not compile against its generated header, and two generated
+ * headers that share a nested struct cannot be included in the same unit.
+ */
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <exception>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <set>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/aliases.h"
+#include "fourdst/config/fixed_array.h"
+#include "fourdst/config/io.h"
+#include "fourdst/config/parallel_read.h"
+#include "fourdst/config/path_table.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+#include "rfl/toml.hpp"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config::io {
+
+    /**
+     * @brief Reads `T` from a TOML table; specialized by the headers `codegen_main()` writes.
+     *
+     * A specialization provides `static bool read(toml::table& table, T& out, std::string& error)`,
+     * which reads every field of `out` from `table` and, on failure, sets `error` and returns false.
+     */
+    template <typename T>
+    struct GeneratedReader;
+
+    /**
+     * @brief Whether a generated reader for `T` has been declared in this unit.
+     */
+    template <typename T>
+    constexpr bool has_generated_reader_v = requires(toml::table& table, T& out, std::string& error) {
+        { GeneratedReader<T>::read(table, out, error) } -> std::same_as<bool>;
+    };
+
+    namespace codegen {
+        template <typename Type>
+        struct is_std_vector : std::false_type {};
+
+        template <typename E>
+        struct is_std_vector<std::vector<E>> : std::true_type {};
+
+        /// Containers whose elements can be default-constructed and then read in place.
+        template <typename Type>
+        constexpr bool has_default_element_v = [] {
+            if constexpr (requires { typename Type::value_type; }) {
+                return std::is_default_constructible_v<typename Type::value_type>;
+            } else {
+                return false;
+            }
+        }();
+
+        /// Vectors read by the generated code; reflect-cpp reads vectors of characters and bytes as strings.
+        template <typename Type>
+        constexpr bool is_element_vector_v = [] {
+            if constexpr (is_std_vector<Type>::value) {
+                using Element = typename Type::value_type;
+                return std::is_default_constructible_v<Element> && !std::is_same_v<Element, char> && !std::is_same_v<Element, std::byte>;
+            } else {
+                return false;
+            }
+        }();
+
+        /// String-keyed maps read by the generated code.
+        template <typename Type>
+        constexpr bool is_string_map_v = [] {
+            if constexpr (validate::is_map_v<Type>) {
+                return std::is_same_v<typename Type::key_type, std::string> &&
+                       std::is_default_constructible_v<typename Type::mapped_type>;
+            } else {
+                return false;
+            }
+        }();
+
+        /**
+         * @brief Reads `out` with its reflect-cpp parser, for field types the generated code does not handle.
+         */
+        template <typename F>
+        bool read_generic(toml::node& node, F& out, std::string& error) {
+            auto result = rfl::parsing::Parser<rfl::toml::Reader, rfl::toml::Writer, F, rfl::Processors<>>::read(rfl::toml::Reader{}, &node);
+            if (!result) {
+                error = result.error().what();
+                return false;
+            }
+            out = std::move(*result);
+            return true;
+        }
+
+        /**
+         * @brief Reads `out` from `node`, with the messages of the reflect-cpp parsers.
+         */
+        template <typename F>
+        bool read_value(toml::node& node, F& out, std::string& error) {
+            if constexpr (std::is_same_v<F, bool>) {
+                const auto* value = node.as_boolean();
+                if (value == nullptr) {
+                    error = "Could not cast the node to bool!";
+                    return false;
+                }
+                out = value->get();
+            } else if constexpr (std::is_floating_point_v<F>) {
+                const auto* value = node.as_floating_point();
+                if (value == nullptr) {
+                    error = "Could not cast the node to double!";
+                    return false;
+                }
+                out = static_cast<F>(value->get());
+            } else if constexpr (std::is_integral_v<F> && !std::is_same_v<F, char>) {
+                const auto* value = node.as_integer();
+                if (value == nullptr) {
+                    error = "Could not cast the node to int64_t!";
+                    return false;
+                }
+                out = static_cast<F>(value->get());
+            } else if constexpr (std::is_same_v<F, std::string>) {
+                const auto* value = node.as_string();
+                if (value == nullptr) {
+                    error = "Could not cast the node to std::string!";
+                    return false;
+                }
+                out = value->get();
+            } else if constexpr (validate::is_optional_v<F> && has_default_element_v<F>) {
+                return read_value(node, out.emplace(), error);
+            } else if constexpr (is_element_vector_v<F>) {
+                // Arrays of tables that a parallel read is installed for are read on its threads.
+                if constexpr (detail::reads_in_parallel_v<typename F::value_type>) {
+                    if (detail::parallel_read_slot() != nullptr) return read_generic(node, out, error);
+                }
+                toml::array* array = node.as_array();
+                if (array == nullptr) {
+                    error = "Could not cast to an array!";
+                    return false;
+                }
+                out.clear();
+                out.reserve(array->size());
+                for (std::size_t i = 0; i < array->size(); ++i) {
+                    typename F::value_type element{};
+                    if (!read_value(*array->get(i), element, error)) {
+                        error = std::format("Failed to parse element {}: {}", i, error);
+                        return false;
+                    }
+                    out.push_back(std::move(element));
+                }
+            } else if constexpr (validate::is_std_array_v<F> && has_default_element_v<F>) {
+                toml::array* array = node.as_array();
+                if (array == nullptr) {
+                    error = "Could not cast to an array!";
+                    return false;
+                }
+                if (array->size() != out.size()) {
+                    const ArraySizeMismatch mismatch{&node, out.size(), array->size()};
+                    last_array_size_mismatch() = mismatch;
+                    error = mismatch.message();
+                    return false;
+                }
+                for (std::size_t i = 0; i < out.size(); ++i) {
+                    if (!read_value(*array->get(i), out[i], error)) {
+                        error = std::format("Failed to parse element {}: {}", i, error);
+                        return false;
+                    }
+                }
+            } else if constexpr (is_string_map_v<F>) {
+                toml::table* table = node.as_table();
+                if (table == nullptr) {
+                    error = "Could not cast to a table!";
+                    return false;
+                }
+                out.clear();
+                if constexpr (requires { out.reserve(table->size()); }) out.reserve(table->size());
+                // The table yields its keys in order, so sorted maps append every entry.
+                for (auto& [key, child] : *table) {
+                    typename F::mapped_type value{};
+                    if (!read_value(child, value, error)) {
+                        error = std::format("Failed to parse field '{}': {}", key.str(), error);
+                        return false;
+                    }
+                    out.emplace(std::string(key.str()), std::move(value));
+                }
+            } else if constexpr (has_generated_reader_v<F>) {
+                toml::table* table = node.as_table();
+                if (table == nullptr) {
+                    error = "Could not cast to a table!";
+                    return false;
+                }
+                return GeneratedReader<F>::read(*table, out, error);
+            } else {
+                return read_generic(node, out, error);
+            }
+            return true;
+        }
+
+        /**
+         * @brief Reads the field `key` of `table` into `out`; a missing optional field is reset.
+         * @tparam Owner The struct of the field, if it declares old field names (see aliases.h); else `void`.
+         */
+        template <typename Owner = void, typename F>
+        bool read_field(toml::table& table, const std::string_view key, F& out, std::string& error) {
+            toml::node* node = nullptr;
+            if constexpr (std::is_void_v<Owner>) {
+                node = table.get(key);
+            } else {
+                node = config::detail::find_field_node<Owner>(table, key);
+            }
+            if (node == nullptr) {
+                if constexpr (validate::is_optional_v<F>) {
+                    out.reset();
+                    return true;
+                } else {
+                    error = std::format("Field named '{}' not found.", key);
+                    return false;
+                }
+            }
+            if (read_value(*node, out, error)) return true;
+            error = std::format("Failed to parse field '{}': {}", key, error);
+            return false;
+        }
+    }
+
+    namespace detail {
+        /**
+         * @brief Appends a `GeneratedReader` specialization for every struct reachable from a type, innermost first.
+         */
+        class ReaderGenerator {
+        public:
+            explicit ReaderGenerator(std::string& out) : m_out(out) {}
+
+            template <typename Type>
+            void visit() {
+                if constexpr (validate::is_optional_v<Type> || codegen::is_std_vector<Type>::value || validate::is_std_array_v<Type>) {
+                    visit<typename Type::value_type>();
+                } else if constexpr (codegen::is_string_map_v<Type>) {
+                    visit<typename Type::mapped_type>();
+                } else if constexpr (config::detail::is_path_struct_v<Type> && std::is_default_constructible_v<Type>) {
+                    emit<Type>();
+                }
+            }
+
+        private:
+            template <typename S>
+            void emit() {
+                const std::string name = rfl::internal::get_type_name<S>().str();
+                if (!m_emitted.insert(name).second) return;
+                using Fields = typename rfl::named_tuple_t<S>::Fields;
+                constexpr int count = rfl::tuple_size_v<Fields>;
+                [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                    (visit<std::remove_cvref_t<typename rfl::tuple_element_t<Is, Fields>::Type>>(), ...);
+                }(std::make_integer_sequence<int, count>{});
+
+                m_out += "    template <>\n    struct GeneratedReader<" + name + "> {\n";
+                if constexpr (count == 0) {
+                    m_out += "        static bool read(toml::table&, " + name + "&, std::string&) { return true; }\n";
+                } else {
+                    m_out += "        static bool read(toml::table& table, " + name + "& out, std::string& error) {\n";
+                    [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                        ((m_out += Is == 0 ? "            return " : " &&\n                   ",
+                          m_out += field_read(rfl::tuple_element_t<Is, Fields>::name(), config::detail::has_field_aliases_v<S> ? name : "")),
+                         ...);
+                    }(std::make_integer_sequence<int, count>{});
+                    m_out += ";\n        }\n";
+                }
+                m_out += "    };\n\n";
+            }
+
+            /// The call reading `field`; `owner` names the struct if its old field names must be looked up.
+            static std::string field_read(const std::string_view field, const std::string& owner) {
+                const std::string function = owner.empty() ? "codegen::read_field" : "codegen::read_field<" + owner + ">";
+                return function + "(table, \"" + std::string(field) + "\", out." + std::string(field) + ", error)";
+            }
+
+            std::string& m_out;
+            std::set<std::string> m_emitted;
+        };
+    }
+
+    /**
+     * @brief Returns a header specializing `GeneratedReader` for `T` and every struct below it.
+     * @param includes Headers to include first, typically the one defining the schema.
+     */
+    template <typename T>
+    std::string codegen_header(const std::span<const std::string> includes) {
+        static_assert(config::detail::is_path_struct_v<T>, "codegen_header needs a plain struct schema.");
+        std::string out = std::format("// Generated for {} by fourdst::config::codegen_main; do not edit.\n#pragma once\n\n",
+                                      rfl::internal::get_type_name<T>().str());
+        for (const auto& include : includes) out += std::format("#include \"{}\"\n", include);
+        out += "#include <string>\n\n#include \"fourdst/config/config.h\"\n\nnamespace fourdst::config::io {\n\n";
+        detail::ReaderGenerator(out).visit<T>();
+        out += "}\n";
+        return out;
+    }
+}
+
+namespace fourdst::config {
+
+    /**
+     * @brief Runs a reader generator: `<tool> <output header> [<include>...]`.
+     *
+     * Writes the header produced by `io::codegen_header()`. Errors are printed to standard error.
+     *
+     * @tparam T The configuration schema type.
+     * @return 0 on success, 1 if the header cannot be written, 2 on a usage error.
+     */
+    template <typename T>
+    int codegen_main(const int argc, char** argv) {
+        if (argc < 2) {
+            std::cerr << std::format("usage: {} <output header> [<include>...]\n", argc > 0 ? argv[0] : "codegen");
+            return 2;
+        }
+        try {
+            const std::vector<std::string> includes(argv + 2, argv + argc);
+            io::AtomicFileSink sink(argv[1], false);
+            sink.write(io::codegen_header<T>(includes));
+            sink.commit();
+        } catch (const std::exception& e) {
+            std::cerr << std::format("{}: {}\n", argv[1], e.what());
+            return 1;
+        }
+        return 0;
+    }
+}
@@ -0,0 +1,301 @@
+/**
+ * @file columnar.h
+ * @brief Arrays of tables stored as Arrow IPC files referenced from a TOML config.
+ *
+ * Only available when libconfig is built with Arrow support (`-Duse_arrow=enabled`, which
+ * defines `FOURDST_CONFIG_USE_ARROW`).
+ *
+ * With a columnar threshold set (see `Config::set_columnar_threshold()`), `save()` writes every
+ * `std::vector` of flat structs with at least that many rows to an Arrow IPC file next to the
+ * TOML file, one column per field, through reflect-cpp's tabular `ArrowWriter`, and leaves a
+ * reference in its place:
+ *
+ * @code
+ * [main]
+ * reactions = { __columnar = "run.toml.reactions.arrow", rows = 40000, checksum = "03b1c9d0e4f2a877" }
+ * @endcode
+ *
+ * On load, references are replaced by empty arrays before deserialization; each file is then
+ * memory-mapped, checked against its row count and checksum, and read column by column with
+ * `ArrowReader`. Analysis tools can open the files with any Arrow implementation (e.g.
+ * `pyarrow.ipc.open_file`).
+ *
+ * A row type qualifies if it is a plain struct whose fields are all booleans, fixed-width
+ * integers, floating-point numbers, strings, enums, or optionals of those. As with sidecars, only
+ * vectors reached through plain nested structs are written to columnar files.
+ */
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <arrow/io/memory.h>
+#include <arrow/ipc/reader.h>
+#include <arrow/ipc/writer.h>
+
+#include "fourdst/config/compare.h"
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/io.h"
+#include "fourdst/config/sidecar.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+#include "rfl/parsing/tabular/ArrowReader.hpp"
+#include "rfl/parsing/tabular/ArrowWriter.hpp"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config::io {
+
+    /// The reserved key marking a columnar reference.
+    inline constexpr std::string_view columnar_key = "__columnar";
+
+    namespace detail {
+        template <typename Type>
+        constexpr bool is_columnar_scalar_v = [] {
+            using Value = std::remove_cvref_t<Type>;
+            if constexpr (validate::is_optional_v<Value>) {
+                return is_columnar_scalar_v<typename Value::value_type>;
+            } else {
+                return std::is_same_v<Value, bool> || std::is_same_v<Value, std::int8_t> || std::is_same_v<Value, std::int16_t> ||
+                       std::is_same_v<Value, std::int32_t> || std::is_same_v<Value, std::int64_t> ||
+                       std::is_same_v<Value, std::uint8_t> || std::is_same_v<Value, std::uint16_t> ||
+                       std::is_same_v<Value, std::uint32_t> || std::is_same_v<Value, std::uint64_t> ||
+                       std::is_floating_point_v<Value> || std::is_same_v<Value, std::string> || std::is_enum_v<Value>;
+            }
+        }();
+
+        template <typename Fields>
+        struct columnar_fields;
+
+        template <typename... Fields>
+        struct columnar_fields<rfl::Tuple<Fields...>> : std::bool_constant<(is_columnar_scalar_v<typename Fields::Type> && ...)> {};
+
+        template <typename Row>
+        constexpr bool is_columnar_row_v = [] {
+            if constexpr (validate::is_reflectable_struct_v<Row> && !config::detail::is_std_array_v<Row> &&
+                          std::is_aggregate_v<std::remove_cvref_t<Row>>) {
+                return columnar_fields<typename rfl::named_tuple_t<std::remove_cvref_t<Row>>::Fields>::value;
+            } else {
+                return false;
+            }
+        }();
+
+        using ArrowSerialization = rfl::parsing::tabular::SerializationType;
+
+        template <typename Value>
+        Value arrow_value(arrow::Result<Value> result, const std::string_view what, const std::string_view path) {
+            if (!result.ok()) {
+                throw exceptions::ConfigParseError(std::format("Columnar file {}: cannot {}: {}", path, what, result.status().ToString()));
+            }
+            return std::move(result).ValueUnsafe();
+        }
+    }
+
+    /// Vectors that can be stored in a columnar file.
+    template <typename Type>
+    constexpr bool is_columnar_array_v = [] {
+        if constexpr (validate::is_vector_v<Type>) {
+            return detail::is_columnar_row_v<typename std::remove_cvref_t<Type>::value_type>;
+        } else {
+            return false;
+        }
+    }();
+
+    /**
+     * @brief Writes columnar files for one save and produces the references left in the TOML.
+     */
+    class ColumnarWriter {
+    public:
+        /**
+         * @brief Creates a writer for the columnar files of the TOML file `toml_path`.
+         * @param toml_path The TOML file being saved; columnar files are written next to it.
+         * @param threshold Minimum number of rows for an array of tables to get a columnar file.
+         * @param durable Whether to sync each file to storage before it replaces an older one.
+         */
+        ColumnarWriter(const std::string_view toml_path, const std::size_t threshold, const bool durable)
+            : m_directory(std::filesystem::path(toml_path).parent_path()),
+              m_stem(std::filesystem::path(toml_path).filename().string()),
+              m_threshold(threshold),
+              m_durable(durable) {}
+
+        /**
+         * @brief Whether an array of `rows` tables goes to a columnar file.
+         */
+        [[nodiscard]] bool wants(const std::size_t rows) const { return m_threshold != 0 && rows >= m_threshold; }
+
+        /**
+         * @brief Writes `rows` to the columnar file of `field_path`.
+         * @param field_path Dotted path of the field below the root table.
+         * @param rows The array of tables.
+         * @return The inline TOML table referencing the file.
+         * @throws exceptions::ConfigSaveError If the file cannot be encoded or written.
+         */
+        template <typename Row>
+        std::string write(const std::string_view field_path, const std::vector<Row>& rows) {
+            const std::string name = std::format("{}.{}.arrow", m_stem, field_path);
+            auto fail = [&](const arrow::Status& status) {
+                return exceptions::ConfigSaveError(std::format("Unable to encode columnar file {}: {}", name, status.ToString()));
+            };
+
+            std::shared_ptr<arrow::Table> table;
+            try {
+                table = rfl::parsing::tabular::ArrowWriter<std::vector<Row>, detail::ArrowSerialization::parquet>(0).to_table(rows);
+            } catch (const std::exception& e) {
+                throw exceptions::ConfigSaveError(std::format("Unable to encode columnar file {}: {}", name, e.what()));
+            }
+
+            auto stream = arrow::io::BufferOutputStream::Create();
+            if (!stream.ok()) throw fail(stream.status());
+            auto writer = arrow::ipc::MakeFileWriter(*stream, table->schema());
+            if (!writer.ok()) throw fail(writer.status());
+            if (const arrow::Status status = (*writer)->WriteTable(*table); !status.ok()) throw fail(status);
+            if (const arrow::Status status = (*writer)->Close(); !status.ok()) throw fail(status);
+            auto buffer = (*stream)->Finish();
+            if (!buffer.ok()) throw fail(buffer.status());
+            const std::string_view data(reinterpret_cast<const char*>((*buffer)->data()), static_cast<std::size_t>((*buffer)->size()));
+
+            AtomicFileSink sink((m_directory / name).string(), m_durable);
+            sink.write(data);
+            sink.commit();
+
+            return std::format("{{ {} = \"{}\", rows = {}, checksum = \"{:016x}\" }}", columnar_key, name, rows.size(), hash_bytes(data));
+        }
+
+    private:
+        std::filesystem::path m_directory;
+        std::string m_stem;
+        std::size_t m_threshold;
+        bool m_durable;
+    };
+
+    /**
+     * @brief A columnar reference found in a parsed config.
+     */
+    struct ColumnarReference {
+        /// Dotted path of the field below the root table.
+        std::string path;
+        /// The Arrow IPC file.
+        std::string file;
+        /// Number of rows.
+        std::uint64_t rows = 0;
+        /// `hash_bytes()` of the file.
+        std::uint64_t checksum = 0;
+    };
+
+    /**
+     * @brief Makes the columnar file names in `tbl` relative to `directory` instead of the file they appear in.
+     *
+     * Used before merging layers from different directories.
+     */
+    inline void anchor_columnar(toml::table& tbl, const std::filesystem::path& directory) {
+        for (auto&& [key, node] : tbl) {
+            toml::table* child = node.as_table();
+            if (child == nullptr) continue;
+            if (toml::node* file = child->get(columnar_key); file != nullptr && file->is_string()) {
+                *file->as_string() = (directory / file->as_string()->get()).string();
+            } else {
+                anchor_columnar(*child, directory);
+            }
+        }
+    }
+
+    /**
+     * @brief Collects the columnar references in a root table and replaces each by an empty array.
+     * @param tbl The root table (or a nested table when recursing).
+     * @param directory Directory that relative file names are resolved against.
+     * @param references Receives the references.
+     * @param prefix Dotted path of `tbl` below the root.
+     * @throws exceptions::ConfigParseError If a reference is malformed.
+     */
+    inline void collect_columnar(toml::table& tbl, const std::filesystem::path& directory,
+                                 std::vector<ColumnarReference>& references, const std::string& prefix = {}) {
+        for (auto&& [key, node] : tbl) {
+            toml::table* child = node.as_table();
+            if (child == nullptr) continue;
+            const std::string path = prefix.empty() ? std::string(key.str()) : std::format("{}.{}", prefix, key.str());
+            const toml::node* file = child->get(columnar_key);
+            if (file == nullptr) {
+                collect_columnar(*child, directory, references, path);
+                continue;
+            }
+
+            const toml::node* rows = child->get("rows");
+            const toml::node* checksum = child->get("checksum");
+            if (!file->is_string() || rows == nullptr || !rows->is_integer() || rows->as_integer()->get() < 0 ||
+                checksum == nullptr || !checksum->is_string()) {
+                throw exceptions::ConfigParseError(std::format(
+                    "Invalid columnar reference at '{}': expected {{ {} = \"<file>\", rows = <n>, checksum = \"<hex>\" }}.",
+                    path, columnar_key));
+            }
+            references.push_back({path, (directory / file->as_string()->get()).string(),
+                                  static_cast<std::uint64_t>(rows->as_integer()->get()),
+                                  detail::parse_checksum(checksum->as_string()->get())});
+            tbl.insert_or_assign(key.str(), toml::array{});
+        }
+    }
+
+    /**
+     * @brief Reads the columnar files of freshly deserialized content into their fields.
+     * @throws exceptions::ConfigLoadError If a columnar file is missing.
+     * @throws exceptions::ConfigParseError If a file does not match its field, row count or checksum.
+     */
+    template <typename T>
+    void load_columnar(T& content, const std::vector<ColumnarReference>& references) {
+        for (const auto& reference : references) {
+            const bool found = config::detail::visit_at(content, reference.path, [&](auto& field) {
+                using Field = std::remove_cvref_t<decltype(field)>;
+                if constexpr (is_columnar_array_v<Field>) {
+                    if (!std::filesystem::exists(reference.file)) {
+                        throw exceptions::ConfigLoadError(std::format("Columnar file does not exist: {}", reference.file));
+                    }
+                    {
+                        const MappedFile mapped(reference.file);
+                        if (hash_bytes(mapped.view()) != reference.checksum) {
+                            throw exceptions::ConfigParseError(std::format(
+                                "Columnar file {} does not match the checksum recorded for field '{}'.", reference.file, reference.path));
+                        }
+                    }
+
+                    const auto file = detail::arrow_value(arrow::io::MemoryMappedFile::Open(reference.file, arrow::io::FileMode::READ),
+                                                          "map the file", reference.file);
+                    const auto reader = detail::arrow_value(arrow::ipc::RecordBatchFileReader::Open(file), "open the IPC file", reference.file);
+                    std::vector<std::shared_ptr<arrow::RecordBatch>> batches;
+                    batches.reserve(static_cast<std::size_t>(reader->num_record_batches()));
+                    for (int i = 0; i < reader->num_record_batches(); ++i) {
+                        batches.push_back(detail::arrow_value(reader->ReadRecordBatch(i), "read a record batch", reference.file));
+                    }
+                    const auto table = detail::arrow_value(arrow::Table::FromRecordBatches(reader->schema(), batches),
+                                                           "assemble the table", reference.file);
+
+                    using Reader = rfl::parsing::tabular::ArrowReader<Field, detail::ArrowSerialization::parquet>;
+                    auto rows = Reader::make(table).and_then([](const auto& r) { return r.read(); });
+                    if (!rows) {
+                        throw exceptions::ConfigParseError(std::format(
+                            "Columnar file {} does not match field '{}'. Reason: {}", reference.file, reference.path, rows.error().what()));
+                    }
+                    if (rows->size() != reference.rows) {
+                        throw exceptions::ConfigParseError(std::format(
+                            "Columnar file {} has {} rows, but field '{}' references {}.", reference.file, rows->size(), reference.path, reference.rows));
+                    }
+                    field = std::move(*rows);
+                } else {
+                    throw exceptions::ConfigParseError(
+                        std::format("Field '{}' references a columnar file but is not an array of flat tables.", reference.path));
+                }
+            });
+            if (!found) {
+                throw exceptions::ConfigParseError(
+                    std::format("Columnar reference at '{}' does not name a field of the config schema.", reference.path));
+            }
+        }
+    }
+}
@@ -0,0 +1,147 @@
+/**
+ * @file compact.h
+ * @brief Compacting loaded content: trimming slack capacity and relocating `std::pmr` members into one arena.
+ *
+ * Deserialization grows vectors and strings as it reads, so loaded content carries capacity it
+ * will never use, and every string longer than the small-string buffer is an allocation of its
+ * own. With `Config::set_compaction()`, each load trims the capacity of every string and vector
+ * of the content (`shrink_to_fit`), and each published snapshot moves its `std::pmr::string`
+ * and `std::pmr::vector` members, in field order, into one `std::pmr::monotonic_buffer_resource`
+ * owned by the snapshot and sized to fit them. A read-mostly deck of many short strings
+ * then occupies one contiguous block instead of thousands of scattered ones.
+ *
+ * `std::string` and `std::vector` members cannot change allocator, so they are only trimmed;
+ * use the `std::pmr` types (see `pmr.h`) for members that should live in the arena. The walk
+ * covers nested structs, optionals, fixed-size arrays, vectors and the values of maps, and trims
+ * the entries of `FlatMap`s; map nodes and the contents of wrapper fields (`Lazy`, `Section`,
+ * `Sharded`, `SoA`, `Tensor`) are left as they are.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+#include "fourdst/config/path_table.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+
+namespace fourdst::config::detail {
+
+    template <typename Type>
+    concept PmrContainer = requires { typename Type::allocator_type; } &&
+                           std::is_same_v<typename Type::allocator_type, std::pmr::polymorphic_allocator<typename Type::value_type>>;
+
+    /// Strings and vectors allocating through a `std::pmr::polymorphic_allocator`.
+    template <typename Type>
+    constexpr bool is_pmr_container_v = PmrContainer<Type>;
+
+    /**
+     * @brief Returns the bytes the `std::pmr` members of `value` need in an arena, alignment padding included.
+     */
+    template <typename Type>
+    std::size_t arena_bytes(const Type& value) {
+        std::size_t bytes = 0;
+        if constexpr (validate::is_std_string_v<Type>) {
+            if constexpr (is_pmr_container_v<Type>) {
+                if (!value.empty()) bytes = value.size() + 1 + alignof(std::max_align_t);
+            }
+        } else if constexpr (validate::is_optional_v<Type>) {
+            if (value.has_value()) bytes = arena_bytes(*value);
+        } else if constexpr (validate::is_vector_v<Type>) {
+            using Element = typename Type::value_type;
+            if constexpr (is_pmr_container_v<Type> && !std::is_same_v<Element, bool>) {
+                if (!value.empty()) bytes = value.size() * sizeof(Element) + alignof(std::max_align_t);
+            }
+            if constexpr (!std::is_same_v<Element, bool>) {
+                for (const auto& element : value) bytes += arena_bytes(element);
+            }
+        } else if constexpr (validate::is_std_array_v<Type>) {
+            for (const auto& element : value) bytes += arena_bytes(element);
+        } else if constexpr (validate::is_map_v<Type>) {
+            for (const auto& entry : value) bytes += arena_bytes(entry.second);
+        } else if constexpr (is_path_struct_v<Type>) {
+            const auto view = rfl::to_view(value);
+            using Fields = typename rfl::named_tuple_t<Type>::Fields;
+            [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                ((bytes += arena_bytes(*rfl::get<Is>(view.values()))), ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        }
+        return bytes;
+    }
+
+    /**
+     * @brief Replaces `target` with `source`, taking over the allocator of `source`.
+     *
+     * Assignment keeps the allocator of the target, which would copy the contents straight back
+     * out of the arena.
+     */
+    template <typename Type>
+    void adopt(Type& target, Type&& source) {
+        std::destroy_at(&target);
+        std::construct_at(&target, std::move(source));
+    }
+
+    /**
+     * @brief Trims the capacity of the strings and vectors of `value` and, given an arena, moves its `std::pmr` members into it.
+     * @param arena The resource to relocate `std::pmr` members into, or null to only trim.
+     */
+    template <typename Type>
+    void compact(Type& value, std::pmr::memory_resource* arena = nullptr) {
+        if constexpr (validate::is_std_string_v<Type>) {
+            if constexpr (is_pmr_container_v<Type>) {
+                if (arena != nullptr && !value.empty() && value.get_allocator().resource() != arena) {
+                    adopt(value, Type(value, arena));
+                    return;
+                }
+            }
+            value.shrink_to_fit();
+        } else if constexpr (validate::is_optional_v<Type>) {
+            if (value.has_value()) compact(*value, arena);
+        } else if constexpr (validate::is_vector_v<Type>) {
+            using Element = typename Type::value_type;
+            if constexpr (is_pmr_container_v<Type>) {
+                if (arena != nullptr && !value.empty() && value.get_allocator().resource() != arena) {
+                    // Elements that are themselves pmr containers follow the arena by uses-allocator construction.
+                    adopt(value, Type(std::make_move_iterator(value.begin()), std::make_move_iterator(value.end()), arena));
+                }
+            }
+            if constexpr (!std::is_same_v<Element, bool>) {
+                for (auto& element : value) compact(element, arena);
+            }
+            value.shrink_to_fit();
+        } else if constexpr (validate::is_std_array_v<Type>) {
+            for (auto& element : value) compact(element, arena);
+        } else if constexpr (validate::is_map_v<Type>) {
+            for (auto& entry : value) compact(entry.second, arena);
+            if constexpr (validate::is_flat_map_v<Type>) value.shrink_to_fit();
+        } else if constexpr (is_path_struct_v<Type>) {
+            const auto view = rfl::to_view(value);
+            using Fields = typename rfl::named_tuple_t<Type>::Fields;
+            [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                (compact(*rfl::get<Is>(view.values()), arena), ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        }
+    }
+
+    /**
+     * @brief A snapshot that owns the arena its `std::pmr` members live in.
+     *
+     * The content is declared after the arena, so it is destroyed first.
+     */
+    template <typename T>
+    struct CompactedContent {
+        explicit CompactedContent(const T& source)
+            : arena(std::max(arena_bytes(source), alignof(std::max_align_t))), content(source) {
+            compact(content, &arena);
+        }
+
+        std::pmr::monotonic_buffer_resource arena;
+        T content;
+    };
+}
@@ -0,0 +1,247 @@
+/**
+ * @file compare.h
+ * @brief Reflection-based structural comparison of configuration structures.
+ *
+ * Configuration schemas are plain aggregates and usually do not define `operator==`. The helpers
+ * in this file walk two instances of the same schema with `reflect-cpp` field views and compare
+ * them leaf by leaf, recursing into nested structs, optionals, vectors, arrays and maps.
+ *
+ * Subtrees can be addressed by dotted field paths (e.g. `"physics.diffusion"`), which is what
+ * change notifications use to compare only the part of a config a subscriber depends on.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+
+namespace fourdst::config::detail {
+
+    using validate::is_std_array_v;
+
+    template <typename V>
+    bool equal(const V& lhs, const V& rhs);
+
+    /// Vectors and arrays whose elements can be compared as one block of bytes.
+    template <typename Type>
+    constexpr bool is_contiguous_arithmetic_v = [] {
+        if constexpr (validate::is_vector_v<Type> || is_std_array_v<Type>) {
+            using Element = typename std::remove_cvref_t<Type>::value_type;
+            return std::is_arithmetic_v<Element> && !(validate::is_vector_v<Type> && std::is_same_v<Element, bool>);
+        } else {
+            return false;
+        }
+    }();
+
+    /**
+     * @brief Compares two equally sized contiguous arithmetic ranges.
+     *
+     * Bitwise-identical data compares equal with a single `memcmp`. Integers differ exactly when
+     * their bytes do; floating-point data that is not bitwise identical is checked element by
+     * element, so `0.0 == -0.0` as with `operator==`.
+     */
+    template <typename Element>
+    bool equal_contiguous(const Element* lhs, const Element* rhs, const std::size_t count) {
+        if (count == 0 || std::memcmp(lhs, rhs, count * sizeof(Element)) == 0) return true;
+        if constexpr (std::is_integral_v<Element>) {
+            return false;
+        } else {
+            for (std::size_t i = 0; i < count; ++i) {
+                if (!(lhs[i] == rhs[i])) return false;
+            }
+            return true;
+        }
+    }
+
+    template <typename Tuple, int... Is>
+    bool equal_fields(const Tuple& lhs, const Tuple& rhs, std::integer_sequence<int, Is...>) {
+        // Short-circuits on the first differing field.
+        return (equal(*rfl::get<Is>(lhs), *rfl::get<Is>(rhs)) && ...);
+    }
+
+    /**
+     * @brief Compares two values of the same configuration type for structural equality.
+     *
+     * Leaves (arithmetic, enum and string types) are compared with `operator==`. Containers are
+     * compared by size and then element by element, except vectors and arrays of arithmetic
+     * types, which are compared as one block (see `equal_contiguous()`); reflectable structs are
+     * compared field by field in declaration order, and `Lazy` fields with `Lazy::equals()`, which does not
+     * deserialize them; `Section` fields by the file they name; `Sharded` fields as maps of their shards; `Tunable` fields by their current value; `SoA` fields are compared column by column and `Tensor` fields by shape and then as one block. Comparison stops at the first difference.
+     *
+     * @tparam V The type being compared.
+     * @param lhs The first value.
+     * @param rhs The second value.
+     * @return True if both values are structurally identical.
+     */
+    template <typename V>
+    bool equal(const V& lhs, const V& rhs) {
+        using Type = std::remove_cvref_t<V>;
+
+        if constexpr (std::is_arithmetic_v<Type> || std::is_enum_v<Type> || validate::is_string_like_v<Type>) {
+            return lhs == rhs;
+        } else if constexpr (validate::is_optional_v<Type>) {
+            if (lhs.has_value() != rhs.has_value()) return false;
+            return !lhs.has_value() || equal(*lhs, *rhs);
+        } else if constexpr (validate::is_lazy_v<Type>) {
+            return lhs.equals(rhs, [](const auto& a, const auto& b) { return equal(a, b); });
+        } else if constexpr (validate::is_section_v<Type>) {
+            return lhs == rhs;
+        } else if constexpr (validate::is_sharded_v<Type>) {
+            return lhs.is_partial() == rhs.is_partial() && equal(lhs.entries(), rhs.entries());
+        } else if constexpr (validate::is_tunable_v<Type>) {
+            return lhs.get() == rhs.get();
+        } else if constexpr (validate::is_quantity_v<Type>) {
+            return lhs.value() == rhs.value();
+        } else if constexpr (validate::is_stored_v<Type>) {
+            return lhs.value() == rhs.value();
+        } else if constexpr (validate::is_tagged_union_v<Type>) {
+            if (lhs.variant().index() != rhs.variant().index()) return false;
+            return rfl::visit(
+                [&](const auto& alternative) {
+                    return equal(alternative, *rfl::get_if<std::remove_cvref_t<decltype(alternative)>>(&rhs.variant()));
+                },
+                lhs.variant());
+        } else if constexpr (validate::is_soa_v<Type>) {
+            return lhs.equals(rhs, [](const auto& a, const auto& b) { return equal(a, b); });
+        } else if constexpr (validate::is_rfl_validator_v<Type>) {
+            return equal(lhs.value(), rhs.value());
+        } else if constexpr (validate::is_tensor_v<Type>) {
+            return lhs.extents() == rhs.extents() && equal_contiguous(lhs.data(), rhs.data(), lhs.size());
+        } else if constexpr (is_contiguous_arithmetic_v<Type>) {
+            return lhs.size() == rhs.size() && equal_contiguous(lhs.data(), rhs.data(), lhs.size());
+        } else if constexpr (validate::is_vector_v<Type> || is_std_array_v<Type>) {
+            if (lhs.size() != rhs.size()) return false;
+            for (std::size_t i = 0; i < lhs.size(); ++i) {
+                if (!equal(lhs[i], rhs[i])) return false;
+            }
+            return true;
+        } else if constexpr (validate::is_map_v<Type>) {
+            if (lhs.size() != rhs.size()) return false;
+            for (const auto& [key, value] : lhs) {
+                const auto it = rhs.find(key);
+                if (it == rhs.end() || !equal(value, it->second)) return false;
+            }
+            return true;
+        } else if constexpr (validate::is_reflectable_struct_v<Type>) {
+            const auto lhs_view = rfl::to_view(lhs);
+            const auto rhs_view = rfl::to_view(rhs);
+            using Values = std::remove_cvref_t<decltype(lhs_view.values())>;
+            return equal_fields(lhs_view.values(), rhs_view.values(),
+                                std::make_integer_sequence<int, rfl::tuple_size_v<Values>>{});
+        } else {
+            return lhs == rhs;
+        }
+    }
+
+    /**
+     * @brief Splits a dotted path into its first segment and the remainder.
+     * @param path The path, e.g. `"physics.diffusion"`.
+     * @return The head (`"physics"`) and tail (`"diffusion"`, or empty).
+     */
+    constexpr std::pair<std::string_view, std::string_view> split_path(const std::string_view path) {
+        const auto dot = path.find('.');
+        if (dot == std::string_view::npos) return {path, std::string_view{}};
+        return {path.substr(0, dot), path.substr(dot + 1)};
+    }
+
+    template <typename V>
+    std::optional<bool> equal_at(const V& lhs, const V& rhs, std::string_view path);
+
+    template <typename View, int... Is>
+    std::optional<bool> equal_at_fields(const View& lhs, const View& rhs, const std::string_view head,
+                                        const std::string_view tail, std::integer_sequence<int, Is...>) {
+        std::optional<bool> result;
+        ((rfl::tuple_element_t<Is, typename View::Fields>::name() == head
+              ? (result = equal_at(*rfl::get<Is>(lhs.values()), *rfl::get<Is>(rhs.values()), tail), true)
+              : false) || ...);
+        return result;
+    }
+
+    /**
+     * @brief Compares the subtree addressed by a dotted path in two values of the same type.
+     *
+     * @param lhs The first value.
+     * @param rhs The second value.
+     * @param path Dotted field path relative to `V`; an empty path compares the whole value.
+     * @return Whether the subtrees are equal, or `std::nullopt` if `path` does not name a field.
+     */
+    template <typename V>
+    std::optional<bool> equal_at(const V& lhs, const V& rhs, const std::string_view path) {
+        using Type = std::remove_cvref_t<V>;
+        if (path.empty()) return equal(lhs, rhs);
+
+        if constexpr (validate::is_reflectable_struct_v<Type> && !is_std_array_v<Type>) {
+            const auto [head, tail] = split_path(path);
+            const auto lhs_view = rfl::to_view(lhs);
+            const auto rhs_view = rfl::to_view(rhs);
+            using ViewType = std::remove_cvref_t<decltype(lhs_view)>;
+            return equal_at_fields(lhs_view, rhs_view, head, tail,
+                                   std::make_integer_sequence<int, rfl::tuple_size_v<typename ViewType::Fields>>{});
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    template <typename V>
+    constexpr bool has_path(std::string_view path);
+
+    template <typename Fields, int... Is>
+    constexpr bool has_path_fields(const std::string_view head, const std::string_view tail, std::integer_sequence<int, Is...>) {
+        return ((rfl::tuple_element_t<Is, Fields>::name() == head &&
+                 has_path<typename rfl::tuple_element_t<Is, Fields>::Type>(tail)) || ...);
+    }
+
+    /**
+     * @brief Checks whether a dotted path names a field (or nested subtree) of `V`.
+     * @param path Dotted field path relative to `V`; the empty path names `V` itself.
+     * @return True if the path resolves.
+     */
+    template <typename V>
+    constexpr bool has_path(const std::string_view path) {
+        using Type = std::remove_cvref_t<V>;
+        if (path.empty()) return true;
+
+        if constexpr (validate::is_reflectable_struct_v<Type> && !is_std_array_v<Type>) {
+            const auto [head, tail] = split_path(path);
+            using Fields = typename rfl::named_tuple_t<Type>::Fields;
+            return has_path_fields<Fields>(head, tail, std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        } else {
+            return false;
+        }
+    }
+
+    /**
+     * @brief Calls `fn` with the subtree addressed by a dotted path.
+     * @param value The value to descend into; the subtree is passed with the same constness.
+     * @param path Dotted field path relative to `V`; an empty path selects `value` itself.
+     * @param fn Callable invoked once as `fn(Subtree&)` if the path resolves.
+     * @return True if the path resolved and `fn` was called.
+     */
+    template <typename V, typename Fn>
+    bool visit_at(V& value, const std::string_view path, Fn&& fn) {
+        using Type = std::remove_cvref_t<V>;
+        if (path.empty()) {
+            fn(value);
+            return true;
+        }
+
+        if constexpr (validate::is_reflectable_struct_v<Type> && !is_std_array_v<Type>) {
+            const auto [head, tail] = split_path(path);
+            const auto view = rfl::to_view(value);
+            using Fields = typename std::remove_cvref_t<decltype(view)>::Fields;
+            return [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                return ((rfl::tuple_element_t<Is, Fields>::name() == head &&
+                         visit_at(*rfl::get<Is>(view.values()), tail, fn)) || ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        } else {
+            return false;
+        }
+    }
+}
@@ -0,0 +1,431 @@
+/**
+ * @file compress.h
+ * @brief Transparent zstd and gzip compression of configuration files.
+ *
+ * A config path ending in `.zst` (or `.zstd`) is read and written as a zstd stream, one ending
+ * in `.gz` as a gzip stream; the extension before it selects the format, so `run.toml.zst` is
+ * compressed TOML and `run.json.gz` compressed JSON. `Config::load()` decompresses the file in
+ * fixed-size chunks straight into the buffer the parser reads, sized up front from the frame
+ * header (zstd) or the size trailer (gzip), so the compressed bytes are never held in memory as
+ * a whole. `Config::save()` compresses the serialized output as it is produced, through
+ * `CompressingSink`, in front of the usual file sinks.
+ *
+ * zstd support needs libconfig built with `-Duse_zstd=enabled` (which defines
+ * `FOURDST_CONFIG_USE_ZSTD`), gzip support `-Duse_zlib=enabled` (`FOURDST_CONFIG_USE_ZLIB`).
+ * Without them, loading or saving a compressed path throws an error naming the missing option.
+ *
+ * @code
+ * cfg.set_compression_level(19);
+ * cfg.save("deck.toml.zst");
+ * other.load("deck.toml.zst");
+ * @endcode
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include "fourdst/config/exceptions/exceptions.h"
+
+#if FOURDST_CONFIG_USE_ZSTD
+#include <zstd.h>
+#endif
+
+#if FOURDST_CONFIG_USE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace fourdst::config::io {
+
+    /**
+     * @brief The compression of a config file, taken from its last extension.
+     */
+    enum class Compression {
+        /// A plain TOML or JSON file.
+        NONE,
+        /// A zstd stream (`.zst`, `.zstd`).
+        ZSTD,
+        /// A gzip stream (`.gz`).
+        GZIP
+    };
+
+    /// Bytes read from or handed to the compressor per call.
+    inline constexpr std::size_t compression_chunk = 128 * 1024;
+
+    /**
+     * @brief Returns the compression `path` names by its extension (case-insensitively).
+     */
+    inline Compression compression_for(const std::string_view path) {
+        const auto ends_with = [path](const std::string_view suffix) {
+            return path.size() >= suffix.size() &&
+                   std::ranges::equal(path.substr(path.size() - suffix.size()), suffix, [](const char a, const char b) {
+                       return (a >= 'A' && a <= 'Z' ? a - 'A' + 'a' : a) == b;
+                   });
+        };
+        if (ends_with(".zst") || ends_with(".zstd")) return Compression::ZSTD;
+        if (ends_with(".gz")) return Compression::GZIP;
+        return Compression::NONE;
+    }
+
+    /**
+     * @brief Returns `path` without its compression extension, e.g. `run.toml` for `run.toml.zst`.
+     */
+    inline std::string_view strip_compression_extension(const std::string_view path) {
+        if (compression_for(path) == Compression::NONE) return path;
+        return path.substr(0, path.rfind('.'));
+    }
+
+    /**
+     * @brief Returns whether this build can read and write `compression`.
+     */
+    constexpr bool compression_supported(const Compression compression) {
+        switch (compression) {
+            case Compression::ZSTD:
+#if FOURDST_CONFIG_USE_ZSTD
+                return true;
+#else
+                return false;
+#endif
+            case Compression::GZIP:
+#if FOURDST_CONFIG_USE_ZLIB
+                return true;
+#else
+                return false;
+#endif
+            default:
+                return true;
+        }
+    }
+
+    namespace detail {
+        /**
+         * @brief Returns the build option a compression needs, for error messages.
+         */
+        inline std::string_view compression_option(const Compression compression) {
+            return compression == Compression::ZSTD ? "use_zstd" : "use_zlib";
+        }
+
+        /**
+         * @brief Reads a file in chunks, for feeding a decompressor.
+         */
+        class ChunkReader {
+        public:
+            explicit ChunkReader(const std::string& path) : m_path(path), m_file(std::fopen(path.c_str(), "rb")) {
+                if (m_file == nullptr) {
+                    throw exceptions::ConfigLoadError(std::format("Failed to open config file: {}", path));
+                }
+            }
+
+            ChunkReader(const ChunkReader&) = delete;
+            ChunkReader& operator=(const ChunkReader&) = delete;
+
+            ~ChunkReader() { std::fclose(m_file); }
+
+            /**
+             * @brief Reads the next chunk; empty at the end of the file.
+             */
+            std::string_view next() {
+                const std::size_t got = std::fread(m_buffer->data(), 1, m_buffer->size(), m_file);
+                if (got < m_buffer->size() && std::ferror(m_file)) {
+                    throw exceptions::ConfigLoadError(std::format("Failed to read config file: {}", m_path));
+                }
+                return {m_buffer->data(), got};
+            }
+
+            /**
+             * @brief Returns the last `count` bytes of the file without moving the read position, or empty.
+             */
+            std::string tail(const std::size_t count) {
+                const long position = std::ftell(m_file);
+                std::string bytes(count, '\0');
+                if (std::fseek(m_file, -static_cast<long>(count), SEEK_END) != 0 ||
+                    std::fread(bytes.data(), 1, count, m_file) != count) {
+                    bytes.clear();
+                }
+                std::fseek(m_file, position, SEEK_SET);
+                return bytes;
+            }
+
+        private:
+            std::string m_path;
+            std::FILE* m_file;
+            std::unique_ptr<std::array<char, compression_chunk>> m_buffer = std::make_unique<std::array<char, compression_chunk>>();
+        };
+
+        /**
+         * @brief Output buffer of a decompressor: a string grown geometrically, trimmed at the end.
+         */
+        class GrowingOutput {
+        public:
+            explicit GrowingOutput(const std::size_t expected) { m_text.resize(std::max<std::size_t>(expected, compression_chunk)); }
+
+            /// Free space after the bytes produced so far, growing the string when it is full.
+            std::pair<char*, std::size_t> space() {
+                if (m_used == m_text.size()) m_text.resize(m_text.size() * 2);
+                return {m_text.data() + m_used, m_text.size() - m_used};
+            }
+
+            void produced(const std::size_t count) { m_used += count; }
+
+            std::string finish() && {
+                m_text.resize(m_used);
+                return std::move(m_text);
+            }
+
+        private:
+            std::string m_text;
+            std::size_t m_used = 0;
+        };
+    }
+
+    /**
+     * @brief Reads and decompresses the file at `path`.
+     *
+     * @param path The compressed file.
+     * @param compression Its compression; `NONE` is not accepted.
+     * @return The decompressed bytes.
+     * @throws exceptions::ConfigLoadError If the file cannot be read, is not a valid stream, or
+     *         support for `compression` was not built in.
+     */
+    inline std::string read_compressed(const std::string& path, const Compression compression) {
+#if FOURDST_CONFIG_USE_ZSTD
+        if (compression == Compression::ZSTD) {
+            detail::ChunkReader reader(path);
+            std::string_view chunk = reader.next();
+            const unsigned long long content_size = ZSTD_getFrameContentSize(chunk.data(), chunk.size());
+            const bool size_known = content_size != ZSTD_CONTENTSIZE_UNKNOWN && content_size != ZSTD_CONTENTSIZE_ERROR;
+            detail::GrowingOutput output(size_known ? static_cast<std::size_t>(content_size) + 1 : 4 * compression_chunk);
+
+            const std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> context(ZSTD_createDCtx(), &ZSTD_freeDCtx);
+            std::size_t pending = 0;
+            for (; !chunk.empty(); chunk = reader.next()) {
+                ZSTD_inBuffer in{chunk.data(), chunk.size(), 0};
+                while (in.pos < in.size) {
+                    const auto [data, capacity] = output.space();
+                    ZSTD_outBuffer out{data, capacity, 0};
+                    pending = ZSTD_decompressStream(context.get(), &out, &in);
+                    if (ZSTD_isError(pending)) {
+                        throw exceptions::ConfigLoadError(
+                            std::format("Failed to decompress config file {}: {}", path, ZSTD_getErrorName(pending)));
+                    }
+                    output.produced(out.pos);
+                }
+            }
+            // Flush what the decoder still holds once all input is consumed.
+            while (pending != 0) {
+                ZSTD_inBuffer in{nullptr, 0, 0};
+                const auto [data, capacity] = output.space();
+                ZSTD_outBuffer out{data, capacity, 0};
+                const std::size_t before = pending;
+                pending = ZSTD_decompressStream(context.get(), &out, &in);
+                if (ZSTD_isError(pending) || (out.pos == 0 && pending == before)) {
+                    throw exceptions::ConfigLoadError(std::format("Compressed config file is truncated: {}", path));
+                }
+                output.produced(out.pos);
+            }
+            return std::move(output).finish();
+        }
+#endif
+#if FOURDST_CONFIG_USE_ZLIB
+        if (compression == Compression::GZIP) {
+            detail::ChunkReader reader(path);
+            // ISIZE, the uncompressed size modulo 2^32, closes a single-member gzip file.
+            const std::string trailer = reader.tail(4);
+            std::size_t expected = 4 * compression_chunk;
+            if (trailer.size() == 4) {
+                expected = 0;
+                for (int i = 3; i >= 0; --i) expected = expected << 8 | static_cast<unsigned char>(trailer[i]);
+                // Deflate expands by at most ~1032x, which bounds the hint of a damaged trailer.
+                std::error_code ec;
+                expected = std::min<std::size_t>(expected + 1, std::filesystem::file_size(path, ec) * 1032);
+            }
+            detail::GrowingOutput output(expected);
+
+            z_stream stream{};
+            // 15 + 32: the largest window, with automatic zlib/gzip header detection.
+            if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+                throw exceptions::ConfigLoadError(std::format("Failed to start decompressing config file: {}", path));
+            }
+            const std::unique_ptr<z_stream, decltype(&inflateEnd)> guard(&stream, &inflateEnd);
+            int status = Z_OK;
+            for (std::string_view chunk = reader.next(); !chunk.empty(); chunk = reader.next()) {
+                stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(chunk.data()));
+                stream.avail_in = static_cast<uInt>(chunk.size());
+                while (stream.avail_in > 0) {
+                    if (status == Z_STREAM_END) {
+                        // Concatenated gzip members decompress to the concatenation of their contents.
+                        inflateReset(&stream);
+                    }
+                    const auto [data, capacity] = output.space();
+                    stream.next_out = reinterpret_cast<Bytef*>(data);
+                    stream.avail_out = static_cast<uInt>(std::min<std::size_t>(capacity, 1u << 30));
+                    const uInt before = stream.avail_out;
+                    status = inflate(&stream, Z_NO_FLUSH);
+                    if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR) {
+                        throw exceptions::ConfigLoadError(std::format("Failed to decompress config file {}: {}", path,
+                                                                      stream.msg != nullptr ? stream.msg : "invalid data"));
+                    }
+                    output.produced(before - stream.avail_out);
+                }
+            }
+            while (status == Z_OK) {
+                const auto [data, capacity] = output.space();
+                stream.next_out = reinterpret_cast<Bytef*>(data);
+                stream.avail_out = static_cast<uInt>(std::min<std::size_t>(capacity, 1u << 30));
+                const uInt before = stream.avail_out;
+                status = inflate(&stream, Z_FINISH);
+                output.produced(before - stream.avail_out);
+                if (before == stream.avail_out && status != Z_STREAM_END) break;
+            }
+            if (status != Z_STREAM_END) {
+                throw exceptions::ConfigLoadError(std::format("Compressed config file is truncated: {}", path));
+            }
+            return std::move(output).finish();
+        }
+#endif
+        throw exceptions::ConfigLoadError(std::format(
+            "Cannot read compressed config file {}: libconfig was built without -D{}=enabled",
+            path, detail::compression_option(compression)));
+    }
+
+    /**
+     * @brief Sink adapter that compresses everything written to it into another sink.
+     *
+     * Output is compressed as it arrives and handed to `sink` in chunks of at most
+     * `compression_chunk` bytes; `finish()` writes the end of the stream and must be called
+     * before the underlying sink is closed or committed.
+     *
+     * @par Examples
+     * @code
+     * fourdst::config::io::FileSink file("run.toml.zst");
+     * fourdst::config::io::CompressingSink compressed(file, fourdst::config::io::Compression::ZSTD, 19);
+     * compressed.write("[main]\n");
+     * compressed.finish();
+     * file.close();
+     * @endcode
+     */
+    template <typename Sink>
+    class CompressingSink {
+    public:
+        /**
+         * @brief Starts a compressed stream in front of `sink`.
+         * @param sink The sink receiving the compressed bytes; must outlive this one.
+         * @param compression The stream format; `NONE` is not accepted.
+         * @param level The compression level, or 0 for the library default (zstd 3, gzip 6).
+         * @throws exceptions::ConfigSaveError If support for `compression` was not built in.
+         */
+        CompressingSink(Sink& sink, const Compression compression, const int level)
+            : m_sink(sink), m_compression(compression) {
+#if FOURDST_CONFIG_USE_ZSTD
+            if (compression == Compression::ZSTD) {
+                m_zstd.reset(ZSTD_createCCtx());
+                ZSTD_CCtx_setParameter(m_zstd.get(), ZSTD_c_compressionLevel, level);
+                return;
+            }
+#endif
+#if FOURDST_CONFIG_USE_ZLIB
+            if (compression == Compression::GZIP) {
+                // 15 + 16: the largest window, with a gzip header and trailer.
+                if (deflateInit2(&m_zlib, level == 0 ? Z_DEFAULT_COMPRESSION : level, Z_DEFLATED, 15 + 16, 8,
+                                 Z_DEFAULT_STRATEGY) != Z_OK) {
+                    throw exceptions::ConfigSaveError(std::format("Invalid gzip compression level: {}", level));
+                }
+                m_zlib_open = true;
+                return;
+            }
+#endif
+            static_cast<void>(level);
+            throw exceptions::ConfigSaveError(std::format(
+                "Cannot write compressed config file: libconfig was built without -D{}=enabled",
+                detail::compression_option(compression)));
+        }
+
+        CompressingSink(const CompressingSink&) = delete;
+        CompressingSink& operator=(const CompressingSink&) = delete;
+
+        ~CompressingSink() {
+#if FOURDST_CONFIG_USE_ZLIB
+            if (m_zlib_open) deflateEnd(&m_zlib);
+#endif
+        }
+
+        /**
+         * @brief Compresses bytes into the underlying sink.
+         * @param data The bytes to write.
+         * @throws exceptions::ConfigSaveError If compressing or writing fails.
+         */
+        void write(const std::string_view data) { pump(data, false); }
+
+        /**
+         * @brief Writes the end of the compressed stream.
+         * @throws exceptions::ConfigSaveError If compressing or writing fails.
+         */
+        void finish() { pump({}, true); }
+
+    private:
+        void pump(std::string_view data, const bool end) {
+#if FOURDST_CONFIG_USE_ZSTD
+            if (m_compression == Compression::ZSTD) {
+                ZSTD_inBuffer in{data.data(), data.size(), 0};
+                std::size_t remaining = 0;
+                do {
+                    ZSTD_outBuffer out{m_buffer->data(), m_buffer->size(), 0};
+                    remaining = ZSTD_compressStream2(m_zstd.get(), &out, &in, end ? ZSTD_e_end : ZSTD_e_continue);
+                    if (ZSTD_isError(remaining)) {
+                        throw exceptions::ConfigSaveError(
+                            std::format("Failed to compress config: {}", ZSTD_getErrorName(remaining)));
+                    }
+                    if (out.pos > 0) m_sink.write(std::string_view(m_buffer->data(), out.pos));
+                } while (in.pos < in.size || (end && remaining != 0));
+                return;
+            }
+#endif
+#if FOURDST_CONFIG_USE_ZLIB
+            if (m_compression == Compression::GZIP) {
+                do {
+                    // avail_in is 32-bit, so very large writes go in slices.
+                    const std::size_t slice = std::min<std::size_t>(data.size(), 1u << 30);
+                    m_zlib.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+                    m_zlib.avail_in = static_cast<uInt>(slice);
+                    const bool last = end && slice == data.size();
+                    int status = Z_OK;
+                    do {
+                        m_zlib.next_out = reinterpret_cast<Bytef*>(m_buffer->data());
+                        m_zlib.avail_out = static_cast<uInt>(m_buffer->size());
+                        status = deflate(&m_zlib, last ? Z_FINISH : Z_NO_FLUSH);
+                        if (status == Z_STREAM_ERROR) {
+                            throw exceptions::ConfigSaveError("Failed to compress config: deflate failed");
+                        }
+                        const std::size_t produced = m_buffer->size() - m_zlib.avail_out;
+                        if (produced > 0) m_sink.write(std::string_view(m_buffer->data(), produced));
+                    } while (m_zlib.avail_out == 0 || (last && status != Z_STREAM_END));
+                    data.remove_prefix(slice);
+                } while (!data.empty());
+                return;
+            }
+#endif
+            static_cast<void>(data);
+            static_cast<void>(end);
+        }
+
+        Sink& m_sink;
+        Compression m_compression;
+        std::unique_ptr<std::array<char, compression_chunk>> m_buffer = std::make_unique<std::array<char, compression_chunk>>();
+#if FOURDST_CONFIG_USE_ZSTD
+        std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> m_zstd{nullptr, &ZSTD_freeCCtx};
+#endif
+#if FOURDST_CONFIG_USE_ZLIB
+        z_stream m_zlib{};
+        bool m_zlib_open = false;
+#endif
+    };
+}
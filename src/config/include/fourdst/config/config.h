@@ -29,8 +29,89 @@
  * @section features Features
  * - **Type-safe Configuration**: Define configs using standard C++ structs.
  * - **Serialization**: Built-in support for TOML loading and saving via `reflect-cpp`.
+ * - **Streaming Loads**: Read multi-gigabyte TOML decks in chunks straight into the schema, without a document (`FileReadPolicy::STREAMING`, `toml_stream.h`).
+ * - **Deterministic Output**: Saved TOML and JSON are byte-identical for equal configs, with unordered maps written in key order (`json_writer.h`).
  * - **Schema Generation**: Generate JSON schemas for editor autocompletion (VS Code, etc.).
+ * - **Deck Templates**: Write a commented TOML deck of every field with its default and type (`Config::save_template()`).
  * - **CLI Integration**: Seamlessly expose config fields as command-line arguments (supports CLI11).
+ * - **Asynchronous Loading**: Parse a config on a worker thread while other startup work runs (`Config::load_async()`).
+ * - **Namelist Input**: MESA inlists and other Fortran namelist files load like TOML decks, each group filling the schema field of its name (`FileFormat::NAMELIST`, `namelist.h`).
+ * - **Compressed Files**: Load and save `.toml.zst` / `.json.gz` transparently, with a configurable level (`compress.h`).
+ * - **Binary Messages**: Send a config between processes as a compact, fingerprinted binary message instead of TOML text (`Config::serialize_to()`, `Config::deserialize_from()`).
+ * - **Update Broadcast**: Push config changes to other nodes as binary deltas with generation numbers, over TCP (`UpdatePublisher`, `UpdateSubscriber`) or MPI (`CollectiveUpdates`).
+ * - **Admin Endpoint**: Off by default; serve a live config as JSON and apply patches to it over HTTP on a loopback port or Unix socket (`AdminEndpoint`, the `admin_endpoint` option).
+ * - **Load Daemon**: A node-local `ConfigDaemon` keeps parsed decks keyed by path, content hash and schema fingerprint; loads ask it over a Unix socket and map the entry it passes back instead of parsing (`Config::set_load_daemon()`, `FOURDST_CONFIG_DAEMON`, `daemon.h`).
+ * - **Remote Sources**: Load from HTTP servers and object stores through a revalidating local cache (`ConfigSource`, `CachedSource`).
+ * - **Schema Versions**: Upgrade old TOML decks on load with registered C++ migration steps (`register_migration()`).
+ * - **Field Aliases**: Old names of renamed fields, including values moved out of subtables, are read in the same pass and can be reported or rejected (`field_aliases`, `Config::set_deprecated_key_policy()`).
+ * - **Expressions**: Give numeric fields as `"100 * ${simulation.time_step}"`, evaluated once on load with cycle detection (`Config::set_expressions()`).
+ * - **Sparse Decks**: Save only the fields that differ from the defaults and fill them back in on load (`SaveMode::NON_DEFAULT_ONLY`).
+ * - **Format-Preserving Saves**: Saving back to the loaded TOML file rewrites only the text of the changed values, keeping comments and layout (`Config::set_format_preserving_saves()`).
+ * - **Parse Limits**: Bound file size, array length, nesting depth and estimated parse tree size, checked in one pass before the parser builds its tree (`Config::set_parse_limits()`).
+ * - **Executors**: Parallel validation, parallel reads, batch loads and saves and `load_async()` run on one injectable executor, such as a `ThreadPool` or `TbbExecutor`, instead of starting their own threads (`set_default_executor()`).
+ * - **Change Streams**: Coroutines `co_await` the next published snapshot after a load, reload, patch or mutation, resuming on the default executor (`Config::changes()`).
+ * - **Watch Service**: One thread and one inotify/kqueue descriptor watch the files of thousands of configs, with per-config debouncing and reloads dispatched to the executor (`WatchService`).
+ * - **Drop-in Directories**: Load every fragment of a `conf.d` directory, parsed in parallel and merged in file name order; reloads re-list the directory and parse only the fragments that changed (`Config::load_directory()`).
+ * - **Hot Reload**: Reload configs in place and watch their files for changes (inotify/kqueue).
+ * - **Environment Variables**: Set any field from `<PREFIX>SECTION__FIELD` variables, applied on top of every load from one pass over the environment (`Config::set_env_prefix()`, `env.h`).
+ * - **Recycled Reloads**: Reloads read into the content they replace and publish into retired snapshots no reader holds, keeping vector capacity (`Config::set_reload_recycling()`).
+ * - **Resident Snapshots**: Prefault, or `mlock`, the pages of every snapshot before it is published, so the first reads after a reload take no page faults (`Config::set_residency()`, `resident.h`).
+ * - **Compaction**: Trim slack capacity after each load and keep the `std::pmr` strings and vectors of each snapshot in one arena it owns (`Config::set_compaction()`, `compact.h`).
+ * - **Aligned Arrays**: `AlignedVector<V>` fields and the `AlignedResource` for `std::pmr` fields place large numeric tables on 64-byte boundaries and transparent huge pages (`aligned.h`).
+ * - **Autosave**: Keep a frequently mutated config on disk with coalesced background writes (`ConfigAutosaver`).
+ * - **Mutation Queue**: Many threads queue mutations without blocking; one applier publishes each batch as a single snapshot (`ConfigMutationQueue`).
+ * - **Asynchronous Saving**: Checkpoint a snapshot on a background writer thread without stalling the caller (`Config::save_async()`).
+ * - **Non-throwing API**: `try_load()`, `try_load_from()`, `try_save()` and `try_save_schema()` return `std::expected` for callers built without exception handlers.
+ * - **Bundles**: Load one `Config` per root table of a multi-root file from a single parse (`ConfigBundle`).
+ * - **Registry**: Reload the configs of all subsystems as one, all or none, and read them through one snapshot per registry generation (`ConfigRegistry`, `Config::stage_reload()`).
+ * - **Batch Loading**: Load thousands of member files of one schema on a thread pool, sharing a common base (`load_many()`), and save them back in parallel with bounded concurrent writes, optionally as one all-or-nothing commit (`save_many()`).
+ * - **Record Files**: Stream ensembles of configs through one JSON Lines or length-prefixed binary file, one record at a time into a reused buffer (`RecordWriter`, `RecordReader`).
+ * - **Campaign Store**: Keep thousands of archived configs keyed by fingerprint, with columns of chosen fields for value queries that never touch TOML (`CampaignStore`).
+ * - **Deck Linting**: Validate thousands of decks in parallel with the single-pass validator and print one aggregated report, or build a per-schema checker binary (`lint_files()`, `FOURDST_CONFIG_VALIDATOR_MAIN`).
+ * - **Parameter Sweeps**: Describe cartesian or zipped variants of a base config that share it until each is materialized or saved (`Sweep`).
+ * - **Compile-time Paths**: `cfg.get<"physics.diffusion">()` resolves a dotted path while compiling and returns a typed reference; unknown paths do not compile.
+ * - **Field Metadata Table**: One compile-time table per schema lists every field path with its depth, subtree, `sizeof` and a typed function per entry; diff, memory reports, CLI registration and subscriptions iterate it flat (`detail::PathTable`).
+ * - **Dynamic Schemas**: Read parameters defined at run time by dotted path with `DynamicConfig`.
+ * - **Lightweight Readers**: Hand `Config::reader()` to code that includes only `reader.h`, without any parser headers.
+ * - **Section Views**: Give a module `cfg.view<&Schema::physics>()`, a `ConfigRef` that reads its section inside the parent's snapshots without a copy and follows every reload.
+ * - **Node-shared Configs**: Load once per node into POSIX shared memory and map it read-only from the other processes (`SharedConfig`), with updates published to every process as new generations.
+ * - **Seqlock Copies**: Small trivially copyable schemas are copied out without allocation or reference counting (`Config::copy()`).
+ * - **Tunable Fields**: `Tunable<V>` knobs read lock-free in inner loops and stored in place by `Config::set()`, without publishing a new snapshot.
+ * - **Unit-aware Quantities**: `Quantity<Unit>` fields accept `"1.5 Msun"` or a bare number in TOML and hold a `double` in the canonical unit, converted once at load.
+ * - **Reduced-precision Storage**: `Stored<float>` fields read the doubles of a deck and hold floats, halving the memory of large tables; the schema records both precisions (`stored.h`).
+ * - **Mapped Views**: `ConfigView<T>::write()` stores a plain schema in an offset-based file that `ConfigView<T>::open()` maps and reads in place: strings as `std::string_view`, number arrays as spans, and only the pages of the fields used are read (`mapped_view.h`).
+ * - **Flat Maps**: `FlatMap<std::string, double>` fields hold small keyed tables as one sorted array, read with a single reservation and sort, for lookups that stay in cache (`flat_map.h`).
+ * - **Tagged Unions**: `rfl::TaggedUnion<"type", Newton, Picard>` fields select a solver by its tag in one hashed lookup; the validator checks only the selected alternative and names its tag (`tagged_union.h`).
+ * - **Hashed Enum Names**: Enum and `rfl::Literal` fields are parsed from TOML, the CLI and the environment by a perfect hash over their names instead of a scan (`io::enum_from_string()`, `enum_index.h`).
+ * - **Sharded Fields**: `Sharded<V>` tables of per-rank entries, saved to an indexed shard file of which each rank reads only its own byte ranges (`Config::set_shard_selector()`).
+ * - **Array Sinks**: `Sink<V>` array fields whose elements a load parses straight into memory the caller owns, such as pinned or device staging buffers, or hands to a callback in chunks (`Config::set_sink()`).
+ * - **Projected Loads**: Read only selected subtrees of a deck and leave the rest at their defaults, unvalidated (`Config::set_projection()`, `cfg.load(path, {"output"})`).
+ * - **Section Files**: `Section<U>` fields name another TOML file, read and validated only when first accessed and cached process-wide (`section.h`).
+ * - **Checked Mutations**: `mutate()` and `transaction()` re-check only the `rfl::Validator` fields they changed and roll back a violation before publishing (`Config::set_mutation_validation()`, `constraints.h`).
+ * - **Audit Log**: Every `mutate()`, `transaction()` and `set()` pushes its generation, time, thread and changed paths to a bounded lock-free ring, drained on demand (`Config::set_audit_log()`, `audit.h`).
+ * - **Generations**: Every published snapshot is numbered, so caches of derived data check staleness with one integer comparison (`Config::generation()`, `Config::versioned_snapshot()`).
+ * - **Pinned Snapshots**: Hold one consistent snapshot for a timestep and read fields from it with plain loads (`Config::pin()`, `ConfigPin`).
+ * - **Snapshot Retention**: Keep the last K snapshots by generation, so lagging consumers such as asynchronous output read exactly the config their data was produced under (`Config::set_retention()`, `Config::at_generation()`).
+ * - **Frozen Configs**: Freeze a config once startup is done into a read-only `FrozenConfig` with no mutex or atomics, whose reads are plain member accesses and which has no `mutate()` to call (`Config::freeze()`).
+ * - **Device Mirrors**: Copy the scalar fields into a flat, padding-free struct for GPU constant memory, refreshed only when the config changes (`Config::to_device_mirror()`, `device_mirror_t`).
+ * - **Hot Fields**: Name the scalars inner loops read in `hot_fields<T>` and read them from one cache-line-aligned block per snapshot (`Config::hot()`, `hot.h`).
+ * - **Equality and Hashing**: `equal()` and `hash()` generated from the schema, with `ContentHash` / `ContentEqual` functors for hash maps keyed by configs or snapshots (`hash.h`).
+ * - **Derived Values**: Memoize values computed from the config, recomputed only after a new snapshot is published or their input paths change (`Config::derived()`).
+ * - **NUMA Replication**: Keep one copy of each published snapshot per NUMA node for readers (`Config::set_numa_replication()`).
+ * - **Load Statistics**: Time the read, parse, deserialize and validate phases of a load, and count its allocations (`LoadStats`).
+ * - **Lock Statistics**: Count acquisitions, waits and hold times of the writer lock (`Config::set_lock_stats()`, `LockStats`).
+ * - **Prefetch and Staging**: Find the fragments, section files and sidecars of a job's decks without deserializing, copy them to node-local storage in parallel, and load the staged copies transparently (`prefetch()`, `prefetch.h`).
+ * - **Load Deadlines**: Give up a load or reload stuck on a stalled filesystem at a deadline or a `std::stop_token`, with a `ConfigLoadTimeout` to fall back on (`Config::load(path, deadline)`, `deadline.h`).
+ * - **Metrics**: Export load, reload and save durations, bytes read, validation failures, lock waits, generation and snapshot memory as OpenMetrics text for Prometheus, rendered without allocating (`Config::set_metrics()`, `metrics.h`).
+ * - **Tracing**: Begin/end zones around loads, saves, mutations and formatting for Perfetto, Tracy or ITT (`trace.h`).
+ * - **Access Counters**: In instrumented builds, count reads of each field and list the keys never read (`Config::get_unread_fields()`).
+ * - **Memory Reports**: Per-field `sizeof` and heap usage of a config, with unused capacity (`Config::memory_report()`).
+ * - **Synthetic Decks**: Generate random, schema-valid TOML of any size for benchmarks (`generate_toml()`).
+ * - **C and Fortran ABI**: Read values through `fdc_*` functions by precomputed handle, with arrays as pointer and length, and an `iso_c_binding` module (`c_api.h`, `fdc.f90`).
+ * - **Python Bindings**: nanobind classes generated from the schema, with numeric arrays and tensors as zero-copy NumPy views (`python.h`, `-Duse_nanobind=enabled`).
+ * - **WASM Profile**: `-Dwasm_profile=true` drops the schema generator and CLI integration, for browser modules loading decks from memory.
+ * - **Generated Readers**: Generate straight-line TOML readers for a schema at build time and load through them instead of the reflect-cpp parsers (`codegen_main()`, `codegen.h`).
+ * - **Explicit Instantiation**: Compile the I/O of large schemas once (`FOURDST_CONFIG_DECLARE` / `FOURDST_CONFIG_INSTANTIATE`).
  * - **Error Handling**: Comprehensive exception hierarchy for parsing and I/O errors.
  *
  * @par Examples
@@ -97,7 +178,34 @@
  */
 #pragma once
 
+#include "fourdst/config/autosave.h"
 #include "fourdst/config/base.h"
+#include "fourdst/config/batch.h"
+#include "fourdst/config/records.h"
+#include "fourdst/config/bundle.h"
+#include "fourdst/config/registry.h"
+#include "fourdst/config/campaign.h"
 #include "fourdst/config/exceptions/exceptions.h"
+#if !FOURDST_CONFIG_WASM_PROFILE
 #include "fourdst/config/cli.h"
+#endif
+#include "fourdst/config/diff.h"
+#include "fourdst/config/dynamic.h"
+#include "fourdst/config/generate.h"
+#include "fourdst/config/hash.h"
+#include "fourdst/config/instantiate.h"
+#if !FOURDST_CONFIG_WASM_PROFILE
+#include "fourdst/config/lint.h"
+#endif
+#include "fourdst/config/mutation_queue.h"
+#if !FOURDST_CONFIG_WASM_PROFILE
+#include "fourdst/config/shared.h"
+#endif
+#include "fourdst/config/sweep.h"
+#if !FOURDST_CONFIG_WASM_PROFILE
+#include "fourdst/config/updates.h"
+#include "fourdst/config/admin.h"
+#endif
+#include "fourdst/config/watch.h"
+#include "fourdst/config/watch_service.h"
 
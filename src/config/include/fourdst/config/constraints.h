@@ -0,0 +1,166 @@
+/**
+ * @file constraints.h
+ * @brief Re-checking the `rfl::Validator` constraints of the fields a mutation changed.
+ *
+ * An `rfl::Validator` field checks its constraint when it is constructed or assigned, but a
+ * mutator can still write through `value()`, or replace a vector of constrained structs
+ * wholesale. Validating the whole content after each `mutate()` would cost as much as a load.
+ * Instead, `Config::mutate()` and `Config::transaction()` compare the mutated content with the
+ * published snapshot along the constrained fields only. They then re-check the constraints of
+ * the fields that differ, before anything is published:
+ *
+ * @code
+ * struct Controller {
+ *     rfl::Validator<double, rfl::ExclusiveMinimum<0>> time_step = 0.5;
+ *     std::vector<double> history;   // never compared: holds no constraint
+ * };
+ *
+ * cfg.mutate([](Controller& c) { c.time_step.value() = -1.0; });  // throws ConfigValidationError
+ * @endcode
+ *
+ * Subtrees without constraints (`has_constraints_v` is false) are skipped at compile time, so
+ * a schema without any `rfl::Validator` pays nothing. Elsewhere the cost is one comparison per
+ * constrained leaf, plus one constraint check per changed one. Vectors and arrays of the same
+ * length are compared element by element, so only the changed elements are re-checked.
+ * Constraints inside wrapper fields (`Section`, `Lazy`, tagged unions) are not re-checked.
+ */
+#pragma once
+
+#include <cstddef>
+#include <format>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/compare.h"
+#include "fourdst/config/path_table.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+
+namespace fourdst::config::detail {
+
+    template <typename Type>
+    struct has_constraints;
+
+    /**
+     * @brief Whether `Type` holds an `rfl::Validator` field, directly or in a container or nested struct.
+     */
+    template <typename Type>
+    constexpr bool has_constraints_v = has_constraints<std::remove_cvref_t<Type>>::value;
+
+    template <typename Fields>
+    struct any_field_constrained;
+
+    template <typename... Fields>
+    struct any_field_constrained<rfl::Tuple<Fields...>> : std::bool_constant<(has_constraints_v<typename Fields::Type> || ...)> {};
+
+    template <typename Type>
+    struct has_constraints {
+        static constexpr bool compute() {
+            if constexpr (validate::is_rfl_validator_v<Type>) {
+                return true;
+            } else if constexpr (validate::is_optional_v<Type> || validate::is_vector_v<Type> || is_std_array_v<Type>) {
+                return has_constraints_v<typename Type::value_type>;
+            } else if constexpr (validate::is_map_v<Type>) {
+                return has_constraints_v<typename Type::mapped_type>;
+            } else if constexpr (is_path_struct_v<Type>) {
+                return any_field_constrained<typename rfl::named_tuple_t<Type>::Fields>::value;
+            } else {
+                return false;
+            }
+        }
+        static constexpr bool value = compute();
+    };
+
+    /**
+     * @brief Checks every constraint in `value`, appending a `CONSTRAINT_VIOLATION` for each that fails.
+     * @param path The dotted path of `value`, extended in place while descending and restored.
+     */
+    template <typename V>
+    void check_constraints(const V& value, std::string& path, std::vector<validate::ValidationIssue>& issues) {
+        using Type = std::remove_cvref_t<V>;
+        if constexpr (!has_constraints_v<Type>) {
+            return;
+        } else if constexpr (validate::is_rfl_validator_v<Type>) {
+            const auto result = Type::ValidationType::validate(value.value());
+            if (!result) issues.push_back({validate::IssueKind::CONSTRAINT_VIOLATION, path, result.error().what()});
+        } else if constexpr (validate::is_optional_v<Type>) {
+            if (value.has_value()) check_constraints(*value, path, issues);
+        } else if constexpr (validate::is_vector_v<Type> || is_std_array_v<Type>) {
+            const std::size_t length = path.size();
+            for (std::size_t i = 0; i < value.size(); ++i) {
+                path += std::format("[{}]", i);
+                check_constraints(value[i], path, issues);
+                path.resize(length);
+            }
+        } else if constexpr (validate::is_map_v<Type>) {
+            const std::size_t length = path.size();
+            for (const auto& [key, mapped] : value) {
+                path += std::format(".{}", key);
+                check_constraints(mapped, path, issues);
+                path.resize(length);
+            }
+        } else {
+            using Fields = typename rfl::named_tuple_t<Type>::Fields;
+            const auto view = rfl::to_view(value).values();
+            const std::size_t length = path.size();
+            [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                ([&] {
+                    if constexpr (has_constraints_v<typename rfl::tuple_element_t<Is, Fields>::Type>) {
+                        if (length != 0) path += '.';
+                        path += rfl::tuple_element_t<Is, Fields>::name();
+                        check_constraints(*rfl::get<Is>(view), path, issues);
+                        path.resize(length);
+                    }
+                }(), ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        }
+    }
+
+    /**
+     * @brief Checks the constraints of the parts of `after` that differ from `before`.
+     *
+     * Only constrained fields are compared. Structs are descended field by field, and vectors and
+     * arrays of the same length element by element; any other changed value has all of its
+     * constraints checked.
+     *
+     * @param path The dotted path of the values, empty for the root; extended in place and restored.
+     */
+    template <typename V>
+    void check_changed_constraints(const V& before, const V& after, std::string& path, std::vector<validate::ValidationIssue>& issues) {
+        using Type = std::remove_cvref_t<V>;
+        if constexpr (!has_constraints_v<Type>) {
+            return;
+        } else if constexpr (is_path_struct_v<Type>) {
+            using Fields = typename rfl::named_tuple_t<Type>::Fields;
+            const auto before_view = rfl::to_view(before).values();
+            const auto after_view = rfl::to_view(after).values();
+            const std::size_t length = path.size();
+            [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                ([&] {
+                    if constexpr (has_constraints_v<typename rfl::tuple_element_t<Is, Fields>::Type>) {
+                        if (length != 0) path += '.';
+                        path += rfl::tuple_element_t<Is, Fields>::name();
+                        check_changed_constraints(*rfl::get<Is>(before_view), *rfl::get<Is>(after_view), path, issues);
+                        path.resize(length);
+                    }
+                }(), ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        } else if constexpr (validate::is_vector_v<Type> || is_std_array_v<Type>) {
+            if (before.size() != after.size()) {
+                check_constraints(after, path, issues);
+                return;
+            }
+            const std::size_t length = path.size();
+            for (std::size_t i = 0; i < after.size(); ++i) {
+                path += std::format("[{}]", i);
+                check_changed_constraints(before[i], after[i], path, issues);
+                path.resize(length);
+            }
+        } else if (!equal(before, after)) {
+            check_constraints(after, path, issues);
+        }
+    }
+}
@@ -0,0 +1,156 @@
+/**
+ * @file container_read.h
+ * @brief Reading vectors and string-keyed maps from TOML into storage sized from the node.
+ *
+ * reflect-cpp's generic parsers append elements one at a time, so a vector read from a TOML array
+ * reallocates O(log n) times and moves its elements on each reallocation. A TOML array or table
+ * knows its size before anything is read, so the `Parser` specializations below reserve it up
+ * front and move each element into place:
+ *
+ * - `std::vector<T>` reserves `toml::array::size()` elements;
+ * - `std::unordered_map<std::string, V>` reserves `toml::table::size()` buckets;
+ * - `std::map<std::string, V>` inserts with an end hint, which is constant time because the
+ *   table yields its keys in order;
+ * - `FlatMap<std::string, V>` reserves `toml::table::size()` entries, appends them and sorts once.
+ *
+ * Results and error messages are those of the generic parsers. Vectors of structs that
+ * `parallel_read.h` reads on several threads use `ReservingVectorParser` for their serial reads.
+ */
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "fourdst/config/flat_map.h"
+#include "fourdst/config/toml_writer.h"
+
+#include "rfl.hpp"
+#include "rfl/toml.hpp"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config::io::detail {
+
+    /// Element types whose vectors `parallel_read.h` reads; their `Parser` is specialized there.
+    template <typename T>
+    constexpr bool reads_in_parallel_v = is_plain_struct_v<T> && std::is_default_constructible_v<T>;
+
+    /// Element types whose vectors reflect-cpp reads as bytes or characters.
+    template <typename T>
+    constexpr bool is_byte_element_v = std::is_same_v<T, char> || std::is_same_v<T, std::byte>;
+
+    /**
+     * @brief Reads a `std::vector` from a TOML array into storage reserved for every element.
+     */
+    template <class T, class ProcessorsType>
+    struct ReservingVectorParser
+        : public rfl::parsing::VectorParser<rfl::toml::Reader, rfl::toml::Writer, std::vector<T>, ProcessorsType> {
+        using InputVarType = typename rfl::toml::Reader::InputVarType;
+        using ElementParser = rfl::parsing::Parser<rfl::toml::Reader, rfl::toml::Writer, std::remove_cvref_t<T>, ProcessorsType>;
+
+        static rfl::Result<std::vector<T>> read(const rfl::toml::Reader& _r, const InputVarType& _var) noexcept {
+            ::toml::array* array = _var->as_array();
+            if (array == nullptr) return rfl::error("Could not cast to an array!");
+            rfl::Result<std::vector<T>> result = std::vector<T>{};
+            auto& values = result.value();
+            values.reserve(array->size());
+            for (auto& node : *array) {
+                auto element = ElementParser::read(_r, &node);
+                if (!element) return rfl::error(element.error().what());
+                values.emplace_back(std::move(*element));
+            }
+            return result;
+        }
+    };
+
+    /// The entries a `FlatMap` is read into before it is sorted; nothing for other maps.
+    template <typename MapType>
+    struct flat_entries {
+        using type = std::monostate;
+    };
+
+    template <typename K, typename V, typename Compare>
+    struct flat_entries<FlatMap<K, V, Compare>> {
+        using type = typename FlatMap<K, V, Compare>::container_type;
+    };
+
+    /**
+     * @brief Reads a string-keyed map from a TOML table, reserving or hinting every insertion.
+     */
+    template <class MapType, class ProcessorsType>
+    struct ReservingMapParser : public rfl::parsing::MapParser<rfl::toml::Reader, rfl::toml::Writer, MapType, ProcessorsType> {
+        using InputVarType = typename rfl::toml::Reader::InputVarType;
+        using ValueType = typename MapType::mapped_type;
+        using ValueParser = rfl::parsing::Parser<rfl::toml::Reader, rfl::toml::Writer, std::remove_cvref_t<ValueType>, ProcessorsType>;
+
+        static rfl::Result<MapType> read(const rfl::toml::Reader& _r, const InputVarType& _var) noexcept {
+            ::toml::table* table = _var->as_table();
+            if (table == nullptr) return rfl::error("Could not cast to a table!");
+            rfl::Result<MapType> result = MapType{};
+            auto& map = result.value();
+            typename flat_entries<MapType>::type entries;
+            if constexpr (validate::is_unordered_map_v<MapType>) map.reserve(table->size());
+            if constexpr (validate::is_flat_map_v<MapType>) entries.reserve(table->size());
+            // Every entry is read, so the message lists all failing keys, as reflect-cpp's does.
+            std::vector<rfl::Error> errors;
+            for (auto& [key, node] : *table) {
+                const std::string_view name = key.str();
+                auto value = ValueParser::read(_r, &node);
+                if (!value) {
+                    errors.emplace_back("Failed to parse field '" + std::string(name) + "': " + value.error().what());
+                    continue;
+                }
+                if constexpr (validate::is_unordered_map_v<MapType>) {
+                    map.emplace(std::string(name), std::move(*value));
+                } else if constexpr (validate::is_flat_map_v<MapType>) {
+                    entries.emplace_back(std::string(name), std::move(*value));
+                } else {
+                    map.emplace_hint(map.end(), std::string(name), std::move(*value));
+                }
+            }
+            if (!errors.empty()) return rfl::error(rfl::parsing::to_single_error_message(errors));
+            if constexpr (validate::is_flat_map_v<MapType>) map = MapType(std::move(entries));
+            return result;
+        }
+    };
+}
+
+namespace rfl::parsing {
+
+    /**
+     * @brief Reads `std::vector<T>` from TOML with its storage reserved from the array size.
+     */
+    template <class T, class ProcessorsType>
+        requires(!fourdst::config::io::detail::reads_in_parallel_v<T> && !fourdst::config::io::detail::is_byte_element_v<T>)
+    struct Parser<rfl::toml::Reader, rfl::toml::Writer, std::vector<T>, ProcessorsType>
+        : public fourdst::config::io::detail::ReservingVectorParser<T, ProcessorsType> {};
+
+    /**
+     * @brief Reads `std::map<std::string, V>` from TOML, appending each key at the end.
+     */
+    template <class V, class ProcessorsType>
+    struct Parser<rfl::toml::Reader, rfl::toml::Writer, std::map<std::string, V>, ProcessorsType>
+        : public fourdst::config::io::detail::ReservingMapParser<std::map<std::string, V>, ProcessorsType> {};
+
+    /**
+     * @brief Reads `std::unordered_map<std::string, V>` from TOML with its buckets reserved from the table size.
+     */
+    template <class V, class Hash, class KeyEqual, class Allocator, class ProcessorsType>
+    struct Parser<rfl::toml::Reader, rfl::toml::Writer, std::unordered_map<std::string, V, Hash, KeyEqual, Allocator>, ProcessorsType>
+        : public fourdst::config::io::detail::ReservingMapParser<std::unordered_map<std::string, V, Hash, KeyEqual, Allocator>,
+                                                                 ProcessorsType> {};
+
+    /**
+     * @brief Reads `FlatMap<std::string, V>` from TOML into entries reserved from the table size, sorted once.
+     */
+    template <class V, class Compare, class ProcessorsType>
+    struct Parser<rfl::toml::Reader, rfl::toml::Writer, fourdst::config::FlatMap<std::string, V, Compare>, ProcessorsType>
+        : public fourdst::config::io::detail::ReservingMapParser<fourdst::config::FlatMap<std::string, V, Compare>, ProcessorsType> {};
+}
@@ -0,0 +1,651 @@
+/**
+ * @file daemon.h
+ * @brief A node-local daemon that keeps parsed configs for every job on the node.
+ *
+ * Many short jobs on one node often load the same few large decks, and each parses them from
+ * scratch; `SharedConfig` only shares a parse between the processes of one job. A
+ * `ConfigDaemon` outlives the jobs: it keeps parsed content, in the encoding of the binary
+ * cache (see cache.h), keyed by the absolute path of the deck, the hash of its bytes and the
+ * fingerprint of the schema. Each entry lives in its own shared memory object.
+ *
+ * `Config::load()` asks the daemon first when `Config::set_load_daemon()` names its socket, or
+ * when the `FOURDST_CONFIG_DAEMON` environment variable does. A hit costs a round trip on the
+ * Unix socket, which passes the descriptor of the entry, one `mmap` and the decode; there is no
+ * parse. The descriptor cannot be used to change the entry: on Linux the entry is a memfd
+ * sealed against writes and resizing once it is filled, elsewhere clients get a descriptor of
+ * the shared memory object opened read-only. On a miss the job parses the deck as usual and hands the result to the daemon for the
+ * next one. A daemon that is not running, or does not answer within the timeout, is a miss.
+ *
+ * @code{.sh}
+ * # once per node, e.g. from the batch system prologue; built with FOURDST_CONFIG_DAEMON_MAIN()
+ * config_daemon --socket /tmp/fourdst-config.sock --max-bytes 4294967296 &
+ * export FOURDST_CONFIG_DAEMON=/tmp/fourdst-config.sock
+ * @endcode
+ *
+ * The daemon never parses anything and knows no schema; it stores what clients send and serves
+ * it back to clients that send the same key. Entries are used under the same conditions as the
+ * cache file: the deck is self-contained (no includes, sidecars, shards or columnar files) and
+ * the load records no provenance, uses no memory resource or shard selector and does not report
+ * renamed keys. Anyone who can connect to the socket can add entries, so the socket should be
+ * reachable only by the users whose jobs trust each other. The least recently used entries are
+ * dropped once the entries take more than `DaemonOptions::max_bytes`.
+ *
+ * Needs POSIX; elsewhere the client always misses and `ConfigDaemon` is not available.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define FOURDST_CONFIG_HAS_LOAD_DAEMON 1
+#else
+#define FOURDST_CONFIG_HAS_LOAD_DAEMON 0
+#endif
+
+#include "fourdst/config/exceptions/exceptions.h"
+
+namespace fourdst::config::io {
+
+    namespace detail {
+        /// Request codes; each request is the code, a 64-bit key length and the key.
+        inline constexpr char daemon_get = 'G';
+        inline constexpr char daemon_put = 'P';
+        /// Keys longer than this are rejected; a key is a path and two hashes.
+        inline constexpr std::uint64_t daemon_max_key = 64 * 1024;
+
+#if FOURDST_CONFIG_HAS_LOAD_DAEMON
+        inline void set_socket_timeouts(const int fd, const std::chrono::milliseconds timeout) {
+            timeval value{};
+            value.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+            value.tv_usec = static_cast<suseconds_t>(timeout.count() % 1000 * 1000);
+            ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &value, sizeof(value));
+            ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &value, sizeof(value));
+        }
+
+        inline bool send_all(const int fd, const void* data, std::size_t size) {
+#ifdef MSG_NOSIGNAL
+            constexpr int flags = MSG_NOSIGNAL;
+#else
+            constexpr int flags = 0;
+#endif
+            const auto* bytes = static_cast<const char*>(data);
+            while (size > 0) {
+                const ssize_t sent = ::send(fd, bytes, size, flags);
+                if (sent < 0 && errno == EINTR) continue;
+                if (sent <= 0) return false;
+                bytes += sent;
+                size -= static_cast<std::size_t>(sent);
+            }
+            return true;
+        }
+
+        inline bool receive_all(const int fd, void* data, std::size_t size) {
+            auto* bytes = static_cast<char*>(data);
+            while (size > 0) {
+                const ssize_t received = ::recv(fd, bytes, size, 0);
+                if (received < 0 && errno == EINTR) continue;
+                if (received <= 0) return false;
+                bytes += received;
+                size -= static_cast<std::size_t>(received);
+            }
+            return true;
+        }
+
+        /**
+         * @brief Sends one status byte, with the descriptor `passed` attached unless it is negative.
+         */
+        inline bool send_status(const int fd, std::uint8_t status, const int passed = -1) {
+            iovec data{&status, 1};
+            msghdr message{};
+            message.msg_iov = &data;
+            message.msg_iovlen = 1;
+            alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(int))> control{};
+            if (passed >= 0) {
+                message.msg_control = control.data();
+                message.msg_controllen = control.size();
+                cmsghdr* header = CMSG_FIRSTHDR(&message);
+                header->cmsg_level = SOL_SOCKET;
+                header->cmsg_type = SCM_RIGHTS;
+                header->cmsg_len = CMSG_LEN(sizeof(int));
+                std::memcpy(CMSG_DATA(header), &passed, sizeof(int));
+            }
+#ifdef MSG_NOSIGNAL
+            constexpr int flags = MSG_NOSIGNAL;
+#else
+            constexpr int flags = 0;
+#endif
+            ssize_t sent;
+            do {
+                sent = ::sendmsg(fd, &message, flags);
+            } while (sent < 0 && errno == EINTR);
+            return sent == 1;
+        }
+
+        /**
+         * @brief Receives one status byte and the descriptor attached to it, if any (else -1).
+         */
+        inline bool receive_status(const int fd, std::uint8_t& status, int& passed) {
+            passed = -1;
+            iovec data{&status, 1};
+            alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(int))> control{};
+            msghdr message{};
+            message.msg_iov = &data;
+            message.msg_iovlen = 1;
+            message.msg_control = control.data();
+            message.msg_controllen = control.size();
+            ssize_t received;
+            do {
+                received = ::recvmsg(fd, &message, 0);
+            } while (received < 0 && errno == EINTR);
+            for (cmsghdr* header = CMSG_FIRSTHDR(&message); received == 1 && header != nullptr; header = CMSG_NXTHDR(&message, header)) {
+                if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS) {
+                    std::memcpy(&passed, CMSG_DATA(header), sizeof(int));
+                }
+            }
+            return received == 1;
+        }
+
+        inline bool send_request(const int fd, const char code, const std::string_view key) {
+            const std::uint64_t length = key.size();
+            return send_all(fd, &code, 1) && send_all(fd, &length, sizeof(length)) && send_all(fd, key.data(), key.size());
+        }
+
+        /**
+         * @brief Connects to the daemon at `socket`; returns the descriptor, or -1 if it is not there.
+         */
+        inline int connect_daemon(const std::string& socket, const std::chrono::milliseconds timeout) {
+            sockaddr_un address{};
+            if (socket.empty() || socket.size() >= sizeof(address.sun_path)) return -1;
+            const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd < 0) return -1;
+            set_socket_timeouts(fd, timeout);
+            address.sun_family = AF_UNIX;
+            std::memcpy(address.sun_path, socket.c_str(), socket.size() + 1);
+            int connected;
+            do {
+                connected = ::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+            } while (connected != 0 && errno == EINTR);
+            if (connected != 0) {
+                ::close(fd);
+                return -1;
+            }
+            return fd;
+        }
+#endif
+    }
+
+    /**
+     * @brief The daemon socket named by the `FOURDST_CONFIG_DAEMON` environment variable, or empty.
+     *
+     * Read once per process; the default of `Config::set_load_daemon()`.
+     */
+    inline const std::string& default_daemon_socket() {
+        static const std::string socket = [] {
+            const char* value = std::getenv("FOURDST_CONFIG_DAEMON");
+            return value != nullptr ? std::string(value) : std::string();
+        }();
+        return socket;
+    }
+
+    /**
+     * @brief The key of the content of schema `fingerprint` read from `path` with bytes hashing to `source_hash`.
+     */
+    inline std::string daemon_key(const std::string_view path, const std::uint64_t fingerprint, const std::uint64_t source_hash) {
+        std::error_code ec;
+        std::filesystem::path absolute = std::filesystem::absolute(std::filesystem::path(path), ec);
+        if (ec) absolute = std::filesystem::path(path);
+        return std::format("{}\n{:016x}\n{:016x}", absolute.lexically_normal().string(), fingerprint, source_hash);
+    }
+
+    /**
+     * @brief Fetches entries from and stores entries in a `ConfigDaemon`; every failure is a miss.
+     */
+    class DaemonClient {
+    public:
+        /**
+         * @param socket The Unix socket of the daemon.
+         * @param timeout How long to wait for each step of a request before giving up.
+         */
+        explicit DaemonClient(std::string socket, const std::chrono::milliseconds timeout = std::chrono::milliseconds(1000))
+            : m_socket(std::move(socket)), m_timeout(timeout) {}
+
+        /**
+         * @brief Maps the entry stored under `key`, if any, and passes its bytes to `use`.
+         *
+         * The bytes are mapped read-only and unmapped when `use` returns.
+         *
+         * @param use Called with a `std::string_view` of the entry; returns whether it could use it.
+         * @return Whether there was an entry and `use` returned true.
+         */
+        template <typename Use>
+        bool fetch([[maybe_unused]] const std::string_view key, [[maybe_unused]] Use&& use) const {
+#if FOURDST_CONFIG_HAS_LOAD_DAEMON
+            const int fd = detail::connect_daemon(m_socket, m_timeout);
+            if (fd < 0) return false;
+            std::uint8_t found = 0;
+            int entry = -1;
+            std::uint64_t size = 0;
+            const bool answered = detail::send_request(fd, detail::daemon_get, key) && detail::receive_status(fd, found, entry) &&
+                                  (found == 0 || detail::receive_all(fd, &size, sizeof(size)));
+            ::close(fd);
+            if (!answered || found == 0 || entry < 0 || size == 0) {
+                if (entry >= 0) ::close(entry);
+                return false;
+            }
+            void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, entry, 0);
+            ::close(entry);
+            if (mapped == MAP_FAILED) return false;
+            struct Unmap {
+                void* address;
+                std::size_t size;
+                ~Unmap() { ::munmap(address, size); }
+            } unmap{mapped, size};
+            return use(std::string_view(static_cast<const char*>(mapped), size));
+#else
+            return false;
+#endif
+        }
+
+        /**
+         * @brief Stores `bytes` under `key`, replacing an entry of the same key.
+         * @return Whether the daemon kept the entry.
+         */
+        bool store([[maybe_unused]] const std::string_view key, [[maybe_unused]] const std::string_view bytes) const {
+#if FOURDST_CONFIG_HAS_LOAD_DAEMON
+            const int fd = detail::connect_daemon(m_socket, m_timeout);
+            if (fd < 0) return false;
+            const std::uint64_t size = bytes.size();
+            std::uint8_t stored = 0;
+            int ignored = -1;
+            const bool answered = detail::send_request(fd, detail::daemon_put, key) && detail::send_all(fd, &size, sizeof(size)) &&
+                                  detail::send_all(fd, bytes.data(), bytes.size()) && detail::receive_status(fd, stored, ignored);
+            ::close(fd);
+            if (ignored >= 0) ::close(ignored);
+            return answered && stored != 0;
+#else
+            return false;
+#endif
+        }
+
+    private:
+        std::string m_socket;
+        std::chrono::milliseconds m_timeout;
+    };
+}
+
+#if FOURDST_CONFIG_HAS_LOAD_DAEMON
+
+namespace fourdst::config {
+
+    /**
+     * @brief Where a `ConfigDaemon` listens and how much it keeps.
+     */
+    struct DaemonOptions {
+        /// The Unix socket to listen on; an existing socket file is replaced.
+        std::string socket;
+        /// The total size of the entries kept; the least recently used are dropped beyond it.
+        std::size_t max_bytes = std::size_t{1} << 30;
+        /// The largest entry accepted.
+        std::size_t max_entry = std::size_t{256} << 20;
+        /// How long a client may take to send its request before it is dropped.
+        std::chrono::milliseconds timeout{5000};
+    };
+
+    /**
+     * @brief Counters of a `ConfigDaemon`.
+     */
+    struct DaemonStats {
+        /// Entries held, and their total size in bytes.
+        std::size_t entries = 0;
+        std::size_t bytes = 0;
+        /// Lookups answered with an entry, and without one.
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        /// Entries stored, and entries dropped to stay within `DaemonOptions::max_bytes`.
+        std::size_t stores = 0;
+        std::size_t evictions = 0;
+    };
+
+    /**
+     * @brief Serves parsed configs to the processes of a node; see daemon.h.
+     *
+     * Requests are served one at a time on one background thread. Destroying the daemon stops
+     * it and drops its entries; mappings clients hold stay valid.
+     */
+    class ConfigDaemon {
+    public:
+        /**
+         * @brief Starts listening.
+         * @throws exceptions::ConfigError If the socket cannot be opened.
+         */
+        explicit ConfigDaemon(DaemonOptions options) : m_options(std::move(options)) {
+            sockaddr_un address{};
+            if (m_options.socket.empty() || m_options.socket.size() >= sizeof(address.sun_path)) {
+                throw exceptions::ConfigError(std::format("Invalid config daemon socket path: '{}'", m_options.socket));
+            }
+            m_listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (m_listener < 0) {
+                throw exceptions::ConfigError(std::format("Cannot open a socket for the config daemon: {}", std::strerror(errno)));
+            }
+            address.sun_family = AF_UNIX;
+            std::memcpy(address.sun_path, m_options.socket.c_str(), m_options.socket.size() + 1);
+            ::unlink(m_options.socket.c_str());
+            if (::bind(m_listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(m_listener, 64) != 0) {
+                const std::string reason = std::strerror(errno);
+                ::close(m_listener);
+                throw exceptions::ConfigError(std::format("Cannot listen for config daemon requests on {}: {}", m_options.socket, reason));
+            }
+            if (::pipe(m_wake_fds) != 0) {
+                const std::string reason = std::strerror(errno);
+                ::close(m_listener);
+                ::unlink(m_options.socket.c_str());
+                throw exceptions::ConfigError(std::format("Cannot create the wake pipe of the config daemon: {}", reason));
+            }
+            for (const int fd : {m_listener, m_wake_fds[0], m_wake_fds[1]}) {
+                ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+                ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+            }
+            m_server = std::thread([this] { serve(); });
+        }
+
+        ConfigDaemon(const ConfigDaemon&) = delete;
+        ConfigDaemon& operator=(const ConfigDaemon&) = delete;
+
+        ~ConfigDaemon() {
+            // shutdown() does not wake accept() on macOS/BSD, so the server thread polls a pipe too.
+            const char byte = 1;
+            [[maybe_unused]] const auto written = ::write(m_wake_fds[1], &byte, 1);
+            m_server.join();
+            for (const int fd : {m_listener, m_wake_fds[0], m_wake_fds[1]}) ::close(fd);
+            ::unlink(m_options.socket.c_str());
+            clear();
+        }
+
+        /**
+         * @brief Returns the socket the daemon listens on.
+         */
+        [[nodiscard]] const std::string& socket() const noexcept { return m_options.socket; }
+
+        /**
+         * @brief Returns the counters of the daemon.
+         */
+        [[nodiscard]] DaemonStats stats() const {
+            const std::lock_guard lock(m_mutex);
+            DaemonStats stats = m_stats;
+            stats.entries = m_entries.size();
+            stats.bytes = m_bytes;
+            return stats;
+        }
+
+        /**
+         * @brief Drops every entry, e.g. after the decks of a campaign were regenerated.
+         */
+        void clear() {
+            const std::lock_guard lock(m_mutex);
+            for (const auto& [key, entry] : m_entries) ::close(entry.fd);
+            m_entries.clear();
+            m_recency.clear();
+            m_bytes = 0;
+        }
+
+    private:
+        struct Entry {
+            int fd = -1;
+            std::size_t size = 0;
+            std::list<std::string>::iterator recency;
+        };
+
+        void serve() {
+            while (true) {
+                pollfd fds[2] = {{m_listener, POLLIN, 0}, {m_wake_fds[0], POLLIN, 0}};
+                if (::poll(fds, 2, -1) < 0) {
+                    if (errno == EINTR) continue;
+                    return;
+                }
+                if (fds[1].revents != 0) return;
+                const int client = ::accept(m_listener, nullptr, nullptr);
+                if (client < 0) {
+                    if (errno == EINTR || errno == ECONNABORTED || errno == EAGAIN || errno == EWOULDBLOCK) continue;
+                    return;
+                }
+                // The listener is non-blocking so a vanished connection cannot stall accept(); the client is not.
+                ::fcntl(client, F_SETFL, ::fcntl(client, F_GETFL) & ~O_NONBLOCK);
+                io::detail::set_socket_timeouts(client, m_options.timeout);
+                handle(client);
+                ::close(client);
+            }
+        }
+
+        void handle(const int client) {
+            char code = 0;
+            std::uint64_t length = 0;
+            if (!io::detail::receive_all(client, &code, 1) || !io::detail::receive_all(client, &length, sizeof(length)) ||
+                length > io::detail::daemon_max_key) {
+                return;
+            }
+            std::string key(length, '\0');
+            if (!io::detail::receive_all(client, key.data(), key.size())) return;
+            if (code == io::detail::daemon_get) {
+                get(client, key);
+            } else if (code == io::detail::daemon_put) {
+                put(client, std::move(key));
+            }
+        }
+
+        void get(const int client, const std::string& key) {
+            const std::lock_guard lock(m_mutex);
+            const auto it = m_entries.find(key);
+            if (it == m_entries.end()) {
+                ++m_stats.misses;
+                io::detail::send_status(client, 0);
+                return;
+            }
+            ++m_stats.hits;
+            m_recency.splice(m_recency.begin(), m_recency, it->second.recency);
+            const std::uint64_t size = it->second.size;
+            if (io::detail::send_status(client, 1, it->second.fd)) io::detail::send_all(client, &size, sizeof(size));
+        }
+
+        void put(const int client, std::string key) {
+            std::uint64_t size = 0;
+            if (!io::detail::receive_all(client, &size, sizeof(size))) return;
+            if (size == 0 || size > m_options.max_entry || size > m_options.max_bytes) {
+                io::detail::send_status(client, 0);
+                return;
+            }
+            // The entry is received straight into its shared memory object.
+            const Object object = create_object(static_cast<std::size_t>(size));
+            if (object.writable < 0) {
+                io::detail::send_status(client, 0);
+                return;
+            }
+            void* mapped = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, object.writable, 0);
+            const bool received = mapped != MAP_FAILED && io::detail::receive_all(client, mapped, size);
+            if (mapped != MAP_FAILED) ::munmap(mapped, size);
+            if (!received) {
+                close_object(object);
+                return;
+            }
+            const int fd = publish_object(object);
+            if (fd < 0) {
+                io::detail::send_status(client, 0);
+                return;
+            }
+            {
+                const std::lock_guard lock(m_mutex);
+                if (const auto it = m_entries.find(key); it != m_entries.end()) drop(it);
+                m_recency.push_front(key);
+                m_entries.emplace(std::move(key), Entry{fd, static_cast<std::size_t>(size), m_recency.begin()});
+                m_bytes += size;
+                ++m_stats.stores;
+                while (m_bytes > m_options.max_bytes) {
+                    drop(m_entries.find(m_recency.back()));
+                    ++m_stats.evictions;
+                }
+            }
+            io::detail::send_status(client, 1);
+        }
+
+        /// Removes an entry; call under the mutex.
+        void drop(const std::unordered_map<std::string, Entry>::iterator it) {
+            ::close(it->second.fd);
+            m_bytes -= it->second.size;
+            m_recency.erase(it->second.recency);
+            m_entries.erase(it);
+        }
+
+        /**
+         * @brief An unnamed shared memory object being filled: the daemon writes through `writable`,
+         * clients get `readable`. With a sealed memfd both are the same descriptor.
+         */
+        struct Object {
+            int writable = -1;
+            int readable = -1;
+        };
+
+        static void close_object(const Object& object) {
+            if (object.writable >= 0) ::close(object.writable);
+            if (object.readable >= 0 && object.readable != object.writable) ::close(object.readable);
+        }
+
+        /**
+         * @brief Creates an unnamed shared memory object of `size` bytes; `writable` is -1 on failure.
+         */
+        static Object create_object(const std::size_t size) {
+            Object object;
+#if defined(__linux__) && defined(MFD_ALLOW_SEALING)
+            object.writable = ::memfd_create("fourdst-cfgd", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+            object.readable = object.writable;
+#else
+            static std::atomic<std::uint64_t> counter{0};
+            const std::string name = std::format("/fourdst-cfgd.{}.{}", ::getpid(), counter.fetch_add(1, std::memory_order_relaxed));
+            object.writable = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+            if (object.writable < 0) return {};
+            object.readable = ::shm_open(name.c_str(), O_RDONLY, 0600);
+            // Clients get the descriptor over the socket, so the name is not needed.
+            ::shm_unlink(name.c_str());
+#endif
+            if (object.writable < 0 || object.readable < 0 || ::ftruncate(object.writable, static_cast<off_t>(size)) != 0) {
+                close_object(object);
+                return {};
+            }
+            return object;
+        }
+
+        /**
+         * @brief Makes a filled object read-only for clients; returns the descriptor to serve, or -1.
+         *
+         * The daemon's mapping must be gone: a memfd cannot be sealed against writes while it is mapped writable.
+         */
+        static int publish_object(const Object& object) {
+#if defined(__linux__) && defined(MFD_ALLOW_SEALING)
+            if (::fcntl(object.writable, F_ADD_SEALS, F_SEAL_WRITE | F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0) {
+                close_object(object);
+                return -1;
+            }
+#else
+            ::close(object.writable);
+#endif
+            return object.readable;
+        }
+
+        DaemonOptions m_options;
+        int m_listener = -1;
+        int m_wake_fds[2] = {-1, -1};
+        mutable std::mutex m_mutex;
+        std::unordered_map<std::string, Entry> m_entries;
+        /// Keys, most recently used first.
+        std::list<std::string> m_recency;
+        std::size_t m_bytes = 0;
+        DaemonStats m_stats;
+        std::thread m_server;
+    };
+
+    /**
+     * @brief Runs a `ConfigDaemon` until SIGINT or SIGTERM; the body of a daemon executable.
+     *
+     * Arguments: `--socket <path>` (default: `FOURDST_CONFIG_DAEMON`), `--max-bytes <n>` and
+     * `--max-entry <n>`.
+     *
+     * @return The exit status: 0 once stopped by a signal, 1 if the daemon cannot start, 2 for bad arguments.
+     */
+    inline int daemon_main(const int argc, char** argv) {
+        DaemonOptions options;
+        options.socket = io::default_daemon_socket();
+        const auto size_argument = [](const std::string_view text, std::size_t& value) {
+            const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+            return error == std::errc{} && end == text.data() + text.size() && value > 0;
+        };
+        for (int i = 1; i < argc; ++i) {
+            const std::string_view argument = argv[i];
+            const bool has_value = i + 1 < argc;
+            if (argument == "--socket" && has_value) {
+                options.socket = argv[++i];
+            } else if (argument == "--max-bytes" && has_value && size_argument(argv[i + 1], options.max_bytes)) {
+                ++i;
+            } else if (argument == "--max-entry" && has_value && size_argument(argv[i + 1], options.max_entry)) {
+                ++i;
+            } else {
+                std::cerr << std::format("usage: {} --socket <path> [--max-bytes <n>] [--max-entry <n>]\n", argv[0]);
+                return 2;
+            }
+        }
+
+        // Block the signals before the server thread starts, so only sigwait() receives them.
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+        try {
+            const ConfigDaemon daemon(std::move(options));
+            int signal = 0;
+            sigwait(&signals, &signal);
+        } catch (const exceptions::ConfigError& e) {
+            std::cerr << e.what() << '\n';
+            return 1;
+        }
+        return 0;
+    }
+}
+
+/**
+ * @brief Defines `main()` of a config daemon executable; see `daemon_main()`.
+ *
+ * Use once, at namespace scope, in the source file of the executable.
+ */
+#define FOURDST_CONFIG_DAEMON_MAIN() \
+    int main(int argc, char** argv) { return ::fourdst::config::daemon_main(argc, argv); }
+
+#endif
@@ -0,0 +1,206 @@
+/**
+ * @file deadline.h
+ * @brief Deadlines and cancellation for loads from filesystems that may stall.
+ *
+ * On a parallel filesystem under metadata contention, or an NFS mount whose server went away,
+ * `std::filesystem::exists()` and the first `read()` of a config file can block for minutes,
+ * and a plain `Config::load()` blocks with them. `Config::load(path, deadline)` and
+ * `Config::reload(path, deadline)` take a `LoadDeadline` instead, a point in time, a timeout, a
+ * `std::stop_token`, or a timeout and a token:
+ *
+ * @code
+ * try {
+ *     cfg.load("/lustre/run/physics.toml", std::chrono::seconds(5));
+ * } catch (const fourdst::config::exceptions::ConfigLoadTimeout&) {
+ *     cfg.deserialize_from(last_good);  // fall back to a serialize_to() message kept on local disk
+ * }
+ * @endcode
+ *
+ * A blocked system call cannot be interrupted from user space, so the file is opened, stamped
+ * and read on a helper thread, in chunks of `io::deadline_chunk` bytes, while the loading thread
+ * waits for it until the deadline passes or the token is stopped. Then the load throws
+ * `exceptions::ConfigLoadTimeout` (a `ConfigLoadError`) and leaves the config as it was; the
+ * helper is abandoned, stops between chunks, and exits once the call it is blocked in returns.
+ * Parsing starts only after the whole file is in memory, so a load that got its bytes in time
+ * is never cut off halfway. Fragments pulled in with `__include` are read by the parser as in
+ * `load()`, without the deadline.
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/binary.h"
+#include "fourdst/config/cache.h"
+#include "fourdst/config/compress.h"
+#include "fourdst/config/exceptions/exceptions.h"
+
+namespace fourdst::config {
+
+    /**
+     * @brief When a load gives up: at a point in time, when a stop is requested, or whichever comes first.
+     */
+    struct LoadDeadline {
+        using clock = std::chrono::steady_clock;
+
+        /// The load gives up at this time; `clock::time_point::max()` for never.
+        clock::time_point until = clock::time_point::max();
+        /// The load gives up once a stop is requested through this token.
+        std::stop_token stop;
+
+        /**
+         * @brief Gives up at `until`, or earlier if `stop` is stopped.
+         */
+        LoadDeadline(const clock::time_point until, std::stop_token stop = {})  // NOLINT(google-explicit-constructor)
+            : until(until), stop(std::move(stop)) {}
+
+        /**
+         * @brief Gives up only when `stop` is stopped.
+         */
+        LoadDeadline(std::stop_token stop) : stop(std::move(stop)) {}  // NOLINT(google-explicit-constructor)
+
+        /**
+         * @brief Gives up `timeout` from now, or earlier if `stop` is stopped.
+         */
+        template <typename Rep, typename Period>
+        LoadDeadline(const std::chrono::duration<Rep, Period> timeout, std::stop_token stop = {})  // NOLINT(google-explicit-constructor)
+            : until(clock::now() + std::chrono::ceil<clock::duration>(timeout)), stop(std::move(stop)) {}
+
+        /**
+         * @brief Whether the deadline has passed or a stop was requested.
+         */
+        [[nodiscard]] bool expired() const {
+            return stop.stop_requested() || clock::now() >= until;
+        }
+    };
+
+    namespace io {
+        /// How many bytes the helper thread of `read_within()` reads between checks for being abandoned.
+        inline constexpr std::size_t deadline_chunk = std::size_t{1} << 20;
+
+        /**
+         * @brief The bytes of a file read by `read_within()`, decompressed if need be, and its stamp.
+         */
+        struct DeadlineRead {
+            std::string text;
+            /// The stamp of the file, taken before its bytes were read; empty if it could not be inspected.
+            std::vector<FileStamp> stamps;
+        };
+
+        namespace detail {
+            /**
+             * @brief What the helper thread of `read_within()` shares with the waiting thread, which may leave first.
+             */
+            struct PendingRead {
+                std::mutex mutex;
+                std::condition_variable_any finished;
+                bool done = false;
+                std::atomic<bool> abandoned{false};
+                DeadlineRead result;
+                std::exception_ptr error;
+            };
+
+            /**
+             * @brief Reads `path` on the helper thread, stopping between chunks once `pending` is abandoned.
+             */
+            inline DeadlineRead read_pending(const std::string& path, const PendingRead& pending, const std::size_t chunk) {
+                if (!std::filesystem::exists(path)) {
+                    throw exceptions::ConfigLoadError(std::format("Config file does not exist: {}", path));
+                }
+                DeadlineRead read;
+                if (const Compression compression = compression_for(path); compression != Compression::NONE) {
+                    if (std::optional<FileStamp> stamp = stamp_file(path)) read.stamps.push_back(std::move(*stamp));
+                    read.text = read_compressed(path, compression);
+                    return read;
+                }
+
+                std::error_code time_ec;
+                // Stamped before reading, so a write racing the load shows up as a change on the next reload.
+                FileStamp stamp{path, 0, std::filesystem::last_write_time(path, time_ec), 0, std::filesystem::file_time_type::clock::now()};
+                std::ifstream in(path, std::ios::binary);
+                if (!in) {
+                    throw exceptions::ConfigLoadError(std::format("Could not open config file: {}", path));
+                }
+                std::string buffer(chunk == 0 ? deadline_chunk : chunk, '\0');
+                while (in && !pending.abandoned.load(std::memory_order_relaxed)) {
+                    in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                    read.text.append(buffer.data(), static_cast<std::size_t>(in.gcount()));
+                }
+                if (in.bad()) {
+                    throw exceptions::ConfigLoadError(std::format("Could not read config file: {}", path));
+                }
+                stamp.size = read.text.size();
+                stamp.hash = hash_bytes(read.text);
+                if (!time_ec) read.stamps.push_back(std::move(stamp));
+                return read;
+            }
+        }
+
+        /**
+         * @brief Reads the file at `path` on a helper thread, waiting for it no longer than `deadline` allows.
+         *
+         * Compressed files (see compress.h) are decompressed on the helper thread too, in one piece.
+         *
+         * @param path The file to read.
+         * @param deadline When to stop waiting.
+         * @param chunk How many bytes to read between checks for being abandoned.
+         * @return The bytes of the file and its stamp.
+         * @throws exceptions::ConfigLoadTimeout If the deadline passed or a stop was requested before the file was read.
+         * @throws exceptions::ConfigLoadError If the file does not exist or cannot be read.
+         */
+        inline DeadlineRead read_within(const std::string& path, const LoadDeadline& deadline, const std::size_t chunk = deadline_chunk) {
+            const auto timed_out = [&] {
+                return exceptions::ConfigLoadTimeout(
+                    deadline.stop.stop_requested()
+                        ? std::format("Reading config file {} was cancelled; nothing was loaded.", path)
+                        : std::format("Config file {} could not be read before the deadline; nothing was loaded.", path));
+            };
+            if (deadline.expired()) throw timed_out();
+
+            auto pending = std::make_shared<detail::PendingRead>();
+            std::thread([pending, path, chunk] {
+                DeadlineRead read;
+                std::exception_ptr error;
+                try {
+                    read = detail::read_pending(path, *pending, chunk);
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                {
+                    std::lock_guard lock(pending->mutex);
+                    pending->result = std::move(read);
+                    pending->error = std::move(error);
+                    pending->done = true;
+                }
+                pending->finished.notify_all();
+            }).detach();
+
+            std::unique_lock lock(pending->mutex);
+            const auto done = [&pending] { return pending->done; };
+            const bool finished = deadline.until == LoadDeadline::clock::time_point::max()
+                                      ? pending->finished.wait(lock, deadline.stop, done)
+                                      : pending->finished.wait_until(lock, deadline.stop, deadline.until, done);
+            if (!finished) {
+                pending->abandoned.store(true, std::memory_order_relaxed);
+                throw timed_out();
+            }
+            if (pending->error) std::rethrow_exception(pending->error);
+            return std::move(pending->result);
+        }
+    }
+}
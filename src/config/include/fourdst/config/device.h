@@ -0,0 +1,253 @@
+/**
+ * @file device.h
+ * @brief A flat, trivially copyable mirror of the scalar fields of a schema, for GPU constant memory.
+ *
+ * `DeviceMirror<T>` (also spelled `device_mirror_t<T>`) holds every field of `T`, nested
+ * structs included, whose value is a number, a bool, an enum or a `std::array` of those, in
+ * one aligned block of bytes. Strings, vectors, maps and optionals are left out. The layout is
+ * computed at compile time from the schema: leaves are ordered by decreasing alignment, so the
+ * block has no padding between them, and the mirror can be copied to the device as it is:
+ *
+ * @code
+ * __constant__ fourdst::config::device_mirror_t<Schema> c_config;
+ *
+ * __global__ void step(...) {
+ *     using Mirror = fourdst::config::device_mirror_t<Schema>;
+ *     const double dt = c_config.get<Mirror::index("simulation.time_step")>();
+ * }
+ *
+ * // on the host, before each launch:
+ * if (cfg.refresh_device_mirror(mirror)) {
+ *     cudaMemcpyToSymbol(c_config, &mirror.mirror, sizeof(mirror.mirror));
+ * }
+ * @endcode
+ *
+ * `Config::to_device_mirror()` fills a mirror from the published snapshot and tags it with the
+ * generation it was taken at; `Config::refresh_device_mirror()` refills it only when a newer
+ * snapshot was published, so the upload is skipped for unchanged configs. Stores into
+ * `Tunable` fields publish no snapshot, and `Tunable` fields are not mirrored.
+ *
+ * The packing itself, `PackedBlock` over a `detail::PackedLayout`, is shared with the hot
+ * blocks of `hot.h`.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "fourdst/config/path_table.h"
+#include "fourdst/config/provenance.h"
+
+#include "rfl.hpp"
+
+#if defined(__CUDACC__) || defined(__HIPCC__)
+#define FOURDST_CONFIG_HOST_DEVICE __host__ __device__
+#else
+/// Marks the mirror accessors callable from CUDA and HIP device code.
+#define FOURDST_CONFIG_HOST_DEVICE
+#endif
+
+namespace fourdst::config {
+
+    namespace detail {
+        template <typename Type>
+        struct is_device_leaf_impl : std::bool_constant<std::is_arithmetic_v<Type> || std::is_enum_v<Type>> {};
+        template <typename Element, std::size_t N>
+        struct is_device_leaf_impl<std::array<Element, N>> : is_device_leaf_impl<Element> {};
+        template <typename Storage, typename Parsed>
+        struct is_device_leaf_impl<Stored<Storage, Parsed>> : std::true_type {};
+
+        /// Fields copied into a `DeviceMirror`: numbers (`Stored` ones included), bools, enums and `std::array`s of those.
+        template <typename Type>
+        constexpr bool is_device_leaf_v = is_device_leaf_impl<std::remove_cvref_t<Type>>::value;
+
+        /**
+         * @brief One field of a packed block: its provenance ordinal (see `provenance.h`) and where it lives in the block.
+         */
+        struct PackedSlot {
+            std::size_t ordinal = 0;
+            std::size_t size = 0;
+            std::size_t alignment = 0;
+            std::size_t offset = 0;
+        };
+
+        /**
+         * @brief Assigns the offsets of `slots`: by decreasing alignment, ties in the given order.
+         *
+         * Every field then starts right after the previous one, so the block has no padding
+         * between fields.
+         */
+        template <std::size_t N>
+        constexpr std::array<PackedSlot, N> pack_slots(std::array<PackedSlot, N> slots) {
+            std::size_t offset = 0;
+            for (std::size_t alignment = alignof(std::max_align_t); alignment > 0; alignment /= 2) {
+                for (auto& slot : slots) {
+                    if (slot.alignment != alignment) continue;
+                    slot.offset = offset;
+                    offset += slot.size;
+                }
+            }
+            return slots;
+        }
+
+        /**
+         * @brief The compile-time layout of a packed block holding the fields of `Slots`.
+         */
+        template <auto Slots>
+        struct PackedLayout {
+            static constexpr std::size_t count = Slots.size();
+            static constexpr auto slots = Slots;
+
+            static constexpr std::size_t alignment = [] {
+                std::size_t largest = 1;
+                for (const auto& slot : slots) largest = slot.alignment > largest ? slot.alignment : largest;
+                return largest;
+            }();
+
+            static constexpr std::size_t size = [] {
+                std::size_t end = 0;
+                for (const auto& slot : slots) end = slot.offset + slot.size > end ? slot.offset + slot.size : end;
+                return (end + alignment - 1) / alignment * alignment;
+            }();
+
+            /// Returns the slot of the field at `ordinal`, or `count` if it is not in the block.
+            static constexpr std::size_t slot_of(const std::size_t ordinal) {
+                for (std::size_t i = 0; i < count; ++i) {
+                    if (slots[i].ordinal == ordinal) return i;
+                }
+                return count;
+            }
+        };
+
+        template <typename V>
+        constexpr void collect_device_slots(PackedSlot* slots, std::size_t& next, const std::size_t base) {
+            using Fields = typename rfl::named_tuple_t<V>::Fields;
+            constexpr auto ordinals = field_ordinals<V>();
+            [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                ([&] {
+                    using Type = typename rfl::tuple_element_t<Is, Fields>::Type;
+                    if constexpr (is_path_struct_v<Type>) {
+                        collect_device_slots<Type>(slots, next, base + ordinals[Is] + 1);
+                    } else if constexpr (is_device_leaf_v<Type>) {
+                        if (slots != nullptr) slots[next] = {base + ordinals[Is], sizeof(Type), alignof(Type), 0};
+                        ++next;
+                    }
+                }(), ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        }
+
+        template <typename T>
+        constexpr auto device_slots() {
+            constexpr std::size_t count = [] {
+                std::size_t next = 0;
+                collect_device_slots<T>(nullptr, next, 0);
+                return next;
+            }();
+            std::array<PackedSlot, count> slots{};
+            std::size_t next = 0;
+            collect_device_slots<T>(slots.data(), next, 0);
+            return pack_slots(slots);
+        }
+
+        /// The layout of `DeviceMirror<T>`; slots are kept in schema order.
+        template <typename T>
+        using DeviceLayout = PackedLayout<device_slots<T>()>;
+    }
+
+    /**
+     * @brief Fields of a `T` held flat in one aligned, trivially copyable block.
+     *
+     * Fields are addressed by slot index, obtained at compile time from a dotted path with
+     * `index()`; `get<K>()` returns the field in slot `K` by reference, typed as in the schema.
+     *
+     * @tparam T The configuration schema type.
+     * @tparam Layout The `detail::PackedLayout` of the block.
+     * @tparam MinAlignment The least alignment of the block.
+     */
+    template <typename T, typename Layout, std::size_t MinAlignment = 1>
+    struct alignas(Layout::alignment > MinAlignment ? Layout::alignment : MinAlignment) PackedBlock {
+        /// Sentinel returned by `index()` for paths that are not in the block.
+        static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+        /// The type of the field in slot `K`.
+        template <std::size_t K>
+        using field_type = typename decltype(detail::field_type_at<T, Layout::slots[K].ordinal>())::type;
+
+        /**
+         * @brief The number of fields in the block.
+         */
+        static constexpr std::size_t size() { return Layout::count; }
+
+        /**
+         * @brief Returns the slot of the field at the dotted `path`, or `npos` if it is not in the block.
+         */
+        static constexpr std::size_t index(const std::string_view path) {
+            const std::size_t ordinal = detail::PathTable<T>::find(path);
+            if (ordinal == detail::PathTable<T>::npos) return npos;
+            const std::size_t slot = Layout::slot_of(ordinal);
+            return slot == Layout::count ? npos : slot;
+        }
+
+        /**
+         * @brief Returns the field in slot `K`.
+         */
+        template <std::size_t K>
+        FOURDST_CONFIG_HOST_DEVICE const field_type<K>& get() const noexcept {
+            static_assert(K < Layout::count, "No field of the block has this slot; check the path given to index().");
+            // The bytes were written with memcpy, which implicitly created the field objects in them.
+            return *reinterpret_cast<const field_type<K>*>(bytes + Layout::slots[K].offset);
+        }
+
+        /**
+         * @brief Returns the field in slot `K`, for writing.
+         */
+        template <std::size_t K>
+        FOURDST_CONFIG_HOST_DEVICE field_type<K>& get() noexcept {
+            static_assert(K < Layout::count, "No field of the block has this slot; check the path given to index().");
+            return *reinterpret_cast<field_type<K>*>(bytes + Layout::slots[K].offset);
+        }
+
+        /// The fields, at the offsets of `Layout::slots`.
+        unsigned char bytes[Layout::size == 0 ? 1 : Layout::size];
+    };
+
+    /**
+     * @brief The numeric, boolean, enum and fixed-size array fields of a `T`, for GPU constant memory.
+     */
+    template <typename T>
+    using DeviceMirror = PackedBlock<T, detail::DeviceLayout<T>>;
+
+    /// The device mirror of schema `T`.
+    template <typename T>
+    using device_mirror_t = DeviceMirror<T>;
+
+    namespace detail {
+        /**
+         * @brief Copies the mirrored fields of `value`, whose first field has ordinal `Base`, into `mirror`.
+         */
+        template <typename T, typename V, std::size_t Base = 0>
+        void fill_device_mirror(const V& value, DeviceMirror<T>& mirror) {
+            using Fields = typename rfl::named_tuple_t<V>::Fields;
+            using Layout = DeviceLayout<T>;
+            constexpr auto ordinals = field_ordinals<V>();
+            const auto view = rfl::to_view(value).values();
+            [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                ([&] {
+                    using Type = typename rfl::tuple_element_t<Is, Fields>::Type;
+                    constexpr std::size_t ordinal = Base + ordinals[Is];
+                    if constexpr (is_path_struct_v<Type>) {
+                        fill_device_mirror<T, Type, ordinal + 1>(*rfl::get<Is>(view), mirror);
+                    } else if constexpr (is_device_leaf_v<Type>) {
+                        constexpr PackedSlot slot = Layout::slots[Layout::slot_of(ordinal)];
+                        std::memcpy(mirror.bytes + slot.offset, rfl::get<Is>(view), sizeof(Type));
+                    }
+                }(), ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        }
+    }
+}
@@ -0,0 +1,96 @@
+/**
+ * @file diff.h
+ * @brief Reflection-based structural diff of two configuration instances.
+ *
+ * `diff()` walks two instances of a schema along the flat entries of `detail::PathTable` and lists
+ * every field whose value differs, by the same dotted paths that `Config::get()` and
+ * `Config::subscribe()` use. Nested structs are compared first with `detail::equal()`, which
+ * stops at the first difference, so unchanged subtrees are skipped without visiting their leaves. Optionals,
+ * containers and maps are reported as a whole; vectors and arrays of arithmetic types are
+ * compared as one block of bytes.
+ */
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/base.h"
+#include "fourdst/config/compare.h"
+#include "fourdst/config/path_table.h"
+
+#include "rfl.hpp"
+#include "rfl/json.hpp"
+
+namespace fourdst::config {
+
+    /**
+     * @brief One field that differs between two configurations.
+     */
+    struct FieldChange {
+        /// Dotted path of the field, e.g. `"simulation.time_step"`.
+        std::string path;
+        /// The value in the first configuration, as compact JSON.
+        std::string old_value;
+        /// The value in the second configuration, as compact JSON.
+        std::string new_value;
+    };
+
+    namespace detail {
+        template <typename F>
+        struct DiffJson {
+            static std::string apply(const void* value) { return rfl::json::write(*static_cast<const F*>(value)); }
+        };
+    }
+
+    /**
+     * @brief Lists the fields that differ between two instances of a schema.
+     *
+     * @tparam T The configuration schema type.
+     * @param lhs The first (old) instance.
+     * @param rhs The second (new) instance.
+     * @return The changed fields in declaration order; empty if the instances are equal.
+     *
+     * @par Examples
+     * @code
+     * for (const auto& change : fourdst::config::diff(checkpoint, current)) {
+     *     std::println("{}: {} -> {}", change.path, change.old_value, change.new_value);
+     * }
+     * @endcode
+     */
+    template <IsConfigSchema T>
+    std::vector<FieldChange> diff(const T& lhs, const T& rhs) {
+        using Table = detail::PathTable<T>;
+        const auto& same = Table::template functions<bool(const void*, const void*), detail::FieldEqual>();
+        const auto& json = Table::template functions<std::string(const void*), detail::DiffJson>();
+        std::vector<FieldChange> changes;
+        for (std::size_t i = 0; i < Table::size();) {
+            const auto& entry = Table::entry(i);
+            const void* old_value = entry.address(lhs);
+            const void* new_value = entry.address(rhs);
+            if (same[i](old_value, new_value)) {
+                i = entry.end;
+                continue;
+            }
+            if (entry.leaf) changes.push_back({std::string(Table::path(i)), json[i](old_value), json[i](new_value)});
+            ++i;
+        }
+        return changes;
+    }
+
+    /**
+     * @brief Lists the fields that differ between the current snapshots of two configs.
+     *
+     * Both snapshots are taken once, so the result is consistent even if either config is
+     * mutated concurrently.
+     */
+    template <IsConfigSchema T>
+    std::vector<FieldChange> diff(const Config<T>& lhs, const Config<T>& rhs) {
+        const auto lhs_snapshot = lhs.snapshot();
+        const auto rhs_snapshot = rhs.snapshot();
+        return diff(*lhs_snapshot, *rhs_snapshot);
+    }
+}
@@ -0,0 +1,346 @@
+/**
+ * @file dynamic.h
+ * @brief Type-erased, read-only configuration for schemas that are only known at run time.
+ *
+ * Plugins loaded at run time define their own parameters, which cannot be expressed as an
+ * aggregate for `Config<T>`. `DynamicConfig` holds a parsed TOML document flattened into one
+ * immutable index: every table, value and array element is addressed by its dotted path from the
+ * top of the file (`"eos.opacity.table"`, `"species.2.mass"`), the paths are kept sorted, and
+ * values live in a single tagged array. `get<V>(path)` is a binary search over the paths and a
+ * checked conversion, with no parser or tree walk involved.
+ *
+ * The statically known parts of the same file can still be read by a `Config<T>`, from the same
+ * parse:
+ *
+ * @code
+ * fourdst::config::Config<CoreSchema> core;
+ * const auto deck = fourdst::config::DynamicConfig::load("run.toml", core);
+ * const double tolerance = deck.get<double>("plugin.solver.tolerance");
+ * const auto grid = deck.get_or<std::vector<double>>("plugin.solver.grid", {});
+ * @endcode
+ *
+ * Keys containing dots cannot be told apart from nested tables; such keys should be avoided in
+ * dynamically read sections. Dates and times are stored as their TOML text.
+ */
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/base.h"
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/fragments.h"
+#include "fourdst/config/validate.h"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config {
+
+    /**
+     * @brief The kind of a value held by a `DynamicConfig`.
+     */
+    enum class DynamicKind : std::uint8_t {
+        BOOLEAN,
+        INTEGER,
+        FLOATING,
+        STRING,
+        ARRAY,
+        TABLE
+    };
+
+    /**
+     * @brief An immutable, flattened configuration document with typed lookup by dotted path.
+     *
+     * Built once by `load()`, `parse()` or `from_table()`; afterwards it is never modified, so it
+     * can be read from any number of threads and copied freely (it holds offsets, not pointers).
+     */
+    class DynamicConfig {
+    public:
+        DynamicConfig() = default;
+
+        /**
+         * @brief Parses a TOML file and flattens it.
+         * @param path The file to read; `__include` directives are resolved.
+         * @return The flattened document.
+         * @throws exceptions::ConfigLoadError If the file doesn't exist or an include is missing.
+         * @throws exceptions::ConfigParseError If the file is not valid TOML.
+         */
+        [[nodiscard]] static DynamicConfig load(const std::string_view path) {
+            toml::table document = io::parse_document(path);
+            return from_table(document);
+        }
+
+        /**
+         * @brief Parses a TOML file once, loads `config` from its root table and flattens the whole file.
+         *
+         * `config` selects its root table as `Config::load()` would (see `Config::load_table()`);
+         * the returned document still contains that table, so its values are reachable both ways.
+         *
+         * @param path The file to read; `__include` directives are resolved.
+         * @param config The statically typed config to load; must not have been loaded yet.
+         * @param verbose If true, a tree of missing fields is printed to stderr when the root table does not match `T`.
+         * @return The flattened document.
+         * @throws exceptions::ConfigLoadError If the file doesn't exist, `config` is already loaded, or its root name mismatches.
+         * @throws exceptions::ConfigParseError If the file is not valid TOML or the root table doesn't match `T`.
+         */
+        template <IsConfigSchema T>
+        [[nodiscard]] static DynamicConfig load(const std::string_view path, Config<T>& config, const bool verbose = false) {
+            toml::table document = io::parse_document(path);
+            DynamicConfig flattened = from_table(document);
+            config.load_table(document, path, verbose);
+            return flattened;
+        }
+
+        /**
+         * @brief Parses a TOML document held in memory and flattens it.
+         * @param content The document.
+         * @return The flattened document.
+         * @throws exceptions::ConfigParseError If the content is not valid TOML.
+         */
+        [[nodiscard]] static DynamicConfig parse(const std::string_view content) {
+            toml::table document;
+            try {
+                document = toml::parse(content, std::string_view("<memory>"));
+            } catch (const toml::parse_error& e) {
+                throw io::syntax_error(e, "TOML config", "<memory>");
+            }
+            return from_table(document);
+        }
+
+        /**
+         * @brief Flattens an already parsed document.
+         * @param document The document; it is not modified.
+         * @return The flattened document.
+         */
+        [[nodiscard]] static DynamicConfig from_table(const toml::table& document) {
+            DynamicConfig flattened;
+            flattened.m_values.emplace_back();
+            std::string path;
+            flattened.add_node(document, 0, path);
+            std::ranges::sort(flattened.m_index, {}, [&](const Key& key) { return flattened.key_view(key); });
+            return flattened;
+        }
+
+        /**
+         * @brief Reads the value at a dotted path.
+         *
+         * `bool`, integers (range-checked), floating-point types (also from integers),
+         * `std::string`, `std::string_view` (pointing into this document) and `std::vector`s of
+         * those are supported.
+         *
+         * @tparam V The requested type.
+         * @param path Dotted path from the top of the document; array elements are addressed by index.
+         * @return The converted value.
+         * @throws exceptions::ConfigPathError If nothing is at `path`, or the value cannot be converted to `V`.
+         */
+        template <typename V>
+        [[nodiscard]] V get(const std::string_view path) const {
+            const Value* value = find(path);
+            if (value == nullptr) {
+                throw exceptions::ConfigPathError(
+                    std::format("No value at path '{}' in the dynamic config.", path));
+            }
+            return convert<V>(*value, path);
+        }
+
+        /**
+         * @brief Reads the value at a dotted path, or returns `fallback` if nothing is there.
+         * @throws exceptions::ConfigPathError If the value at `path` cannot be converted to `V`.
+         */
+        template <typename V>
+        [[nodiscard]] V get_or(const std::string_view path, V fallback) const {
+            const Value* value = find(path);
+            return value == nullptr ? std::move(fallback) : convert<V>(*value, path);
+        }
+
+        /**
+         * @brief Checks whether a table, value or array element exists at `path`.
+         */
+        [[nodiscard]] bool contains(const std::string_view path) const {
+            return find(path) != nullptr;
+        }
+
+        /**
+         * @brief Returns the kind of the value at `path`.
+         * @throws exceptions::ConfigPathError If nothing is at `path`.
+         */
+        [[nodiscard]] DynamicKind kind(const std::string_view path) const {
+            const Value* value = find(path);
+            if (value == nullptr) {
+                throw exceptions::ConfigPathError(
+                    std::format("No value at path '{}' in the dynamic config.", path));
+            }
+            return value->kind;
+        }
+
+        /**
+         * @brief Returns the number of keys of the table, or elements of the array, at `path`.
+         * @throws exceptions::ConfigPathError If nothing is at `path`, or it is not a table or an array.
+         */
+        [[nodiscard]] std::size_t size(const std::string_view path) const {
+            const Value* value = find(path);
+            if (value == nullptr || (value->kind != DynamicKind::TABLE && value->kind != DynamicKind::ARRAY)) {
+                throw exceptions::ConfigPathError(
+                    std::format("No table or array at path '{}' in the dynamic config.", path));
+            }
+            return value->count;
+        }
+
+        /**
+         * @brief Returns every path in the document, in sorted order.
+         */
+        [[nodiscard]] std::vector<std::string_view> paths() const {
+            std::vector<std::string_view> out;
+            out.reserve(m_index.size());
+            for (const Key& key : m_index) out.push_back(key_view(key));
+            return out;
+        }
+
+    private:
+        /**
+         * @brief One entry of the value array. `bits` holds the boolean, the integer or double
+         * representation, or the offset of the string text or of the first array element;
+         * `count` holds the string length, the array length or the number of table keys.
+         */
+        struct Value {
+            DynamicKind kind = DynamicKind::TABLE;
+            std::uint32_t count = 0;
+            std::uint64_t bits = 0;
+        };
+
+        /// A path, as an offset and length into `m_keys`, and the index of its value.
+        struct Key {
+            std::uint32_t offset;
+            std::uint32_t length;
+            std::uint32_t value;
+        };
+
+        [[nodiscard]] std::string_view key_view(const Key& key) const {
+            return std::string_view(m_keys).substr(key.offset, key.length);
+        }
+
+        [[nodiscard]] const Value* find(const std::string_view path) const {
+            const auto it = std::ranges::lower_bound(m_index, path, {}, [&](const Key& key) { return key_view(key); });
+            if (it == m_index.end() || key_view(*it) != path) return nullptr;
+            return &m_values[it->value];
+        }
+
+        /**
+         * @brief Fills the value at `slot` from `node`, registering `path` and recursing into children.
+         */
+        void add_node(const toml::node& node, const std::size_t slot, std::string& path) {
+            if (!path.empty()) {
+                m_index.push_back({static_cast<std::uint32_t>(m_keys.size()), static_cast<std::uint32_t>(path.size()),
+                                   static_cast<std::uint32_t>(slot)});
+                m_keys += path;
+            }
+            const std::size_t prefix = path.size();
+            if (const toml::table* table = node.as_table()) {
+                m_values[slot] = {DynamicKind::TABLE, static_cast<std::uint32_t>(table->size()), 0};
+                for (const auto& [key, child] : *table) {
+                    const std::size_t child_slot = m_values.size();
+                    m_values.emplace_back();
+                    if (prefix != 0) path += '.';
+                    path += key.str();
+                    add_node(child, child_slot, path);
+                    path.resize(prefix);
+                }
+            } else if (const toml::array* array = node.as_array()) {
+                // Elements occupy consecutive slots, so an array converts without any lookups.
+                const std::size_t first = m_values.size();
+                m_values.resize(first + array->size());
+                m_values[slot] = {DynamicKind::ARRAY, static_cast<std::uint32_t>(array->size()), first};
+                for (std::size_t i = 0; i < array->size(); ++i) {
+                    std::format_to(std::back_inserter(path), ".{}", i);
+                    add_node(*array->get(i), first + i, path);
+                    path.resize(prefix);
+                }
+            } else if (const auto* boolean = node.as_boolean()) {
+                m_values[slot] = {DynamicKind::BOOLEAN, 0, boolean->get() ? 1u : 0u};
+            } else if (const auto* integer = node.as_integer()) {
+                m_values[slot] = {DynamicKind::INTEGER, 0, std::bit_cast<std::uint64_t>(integer->get())};
+            } else if (const auto* floating = node.as_floating_point()) {
+                m_values[slot] = {DynamicKind::FLOATING, 0, std::bit_cast<std::uint64_t>(floating->get())};
+            } else if (const auto* string = node.as_string()) {
+                add_string(slot, string->get());
+            } else {
+                std::ostringstream text;
+                node.visit([&](const auto& concrete) { text << concrete; });
+                add_string(slot, text.str());
+            }
+        }
+
+        void add_string(const std::size_t slot, const std::string_view text) {
+            m_values[slot] = {DynamicKind::STRING, static_cast<std::uint32_t>(text.size()), m_text.size()};
+            m_text += text;
+        }
+
+        [[nodiscard]] static std::string_view describe_kind(const DynamicKind kind) {
+            switch (kind) {
+                case DynamicKind::BOOLEAN:
+                    return "boolean";
+                case DynamicKind::INTEGER:
+                    return "integer";
+                case DynamicKind::FLOATING:
+                    return "floating-point value";
+                case DynamicKind::STRING:
+                    return "string";
+                case DynamicKind::ARRAY:
+                    return "array";
+                case DynamicKind::TABLE:
+                    return "table";
+                default:
+                    return "unknown value";
+            }
+        }
+
+        template <typename V>
+        [[nodiscard]] V convert(const Value& value, const std::string_view path) const {
+            if constexpr (std::is_same_v<V, bool>) {
+                if (value.kind == DynamicKind::BOOLEAN) return value.bits != 0;
+            } else if constexpr (std::is_integral_v<V>) {
+                if (value.kind == DynamicKind::INTEGER) {
+                    const auto integer = std::bit_cast<std::int64_t>(value.bits);
+                    if (!std::in_range<V>(integer)) {
+                        throw exceptions::ConfigPathError(
+                            std::format("Value {} at path '{}' is out of range for the requested type.", integer, path));
+                    }
+                    return static_cast<V>(integer);
+                }
+            } else if constexpr (std::is_floating_point_v<V>) {
+                if (value.kind == DynamicKind::FLOATING) return static_cast<V>(std::bit_cast<double>(value.bits));
+                if (value.kind == DynamicKind::INTEGER) return static_cast<V>(std::bit_cast<std::int64_t>(value.bits));
+            } else if constexpr (std::is_same_v<V, std::string> || std::is_same_v<V, std::string_view>) {
+                if (value.kind == DynamicKind::STRING) return V(std::string_view(m_text).substr(value.bits, value.count));
+            } else if constexpr (validate::is_vector_v<V>) {
+                if (value.kind == DynamicKind::ARRAY) {
+                    V out;
+                    out.reserve(value.count);
+                    for (std::size_t i = 0; i < value.count; ++i) {
+                        out.push_back(convert<typename V::value_type>(m_values[value.bits + i], path));
+                    }
+                    return out;
+                }
+            } else {
+                static_assert(!sizeof(V), "DynamicConfig::get supports bool, integers, floating-point types, strings and vectors of those.");
+            }
+            throw exceptions::ConfigPathError(
+                std::format("Value at path '{}' is a {}, not the requested type.", path, describe_kind(value.kind)));
+        }
+
+        std::vector<Value> m_values;
+        std::vector<Key> m_index;
+        std::string m_keys;
+        std::string m_text;
+    };
+}
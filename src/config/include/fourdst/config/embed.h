@@ -0,0 +1,312 @@
+/**
+ * @file embed.h
+ * @brief Build-time embedding of a config file as a generated C++ initializer.
+ *
+ * A deck that is fixed when a binary is built does not need to be parsed every time the
+ * binary starts. `embed_main<T>()` is the body of a small generator program: it loads a config
+ * file against `T` (so schema errors fail the build) and writes a header defining a function
+ * that returns the loaded content as a `T` aggregate initializer. A `Config<T>` constructed
+ * from it holds the deck without parsing anything:
+ *
+ * @code
+ * // deck_embed.cpp, built for the build machine
+ * #include "physics_schema.h"
+ * #include "fourdst/config/embed.h"
+ * int main(int argc, char** argv) { return fourdst::config::embed_main<PhysicsSchema>(argc, argv); }
+ * @endcode
+ *
+ * @code{.meson}
+ * deck_embed = executable('deck_embed', 'deck_embed.cpp', dependencies: config_dep, native: true)
+ * default_deck_h = custom_target('default_deck',
+ *     input: 'default_deck.toml', output: 'default_deck.h',
+ *     command: [deck_embed, '@INPUT@', '@OUTPUT@', 'default_deck', 'physics_schema.h'])
+ * @endcode
+ *
+ * @code
+ * #include "default_deck.h"
+ * const fourdst::config::Config<PhysicsSchema> cfg(default_deck());
+ * @endcode
+ *
+ * The generated function is `inline` rather than `constexpr`, since most schemas hold strings
+ * and vectors. Enums are written as casts of their underlying value and nested types by their
+ * qualified names, so every type in the schema must be nameable from namespace scope.
+ */
+#pragma once
+
+#include <charconv>
+#include <cmath>
+#include <exception>
+#include <format>
+#include <iostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "fourdst/config/base.h"
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/io.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+
+namespace fourdst::config::io {
+
+    namespace detail {
+        template <typename Type>
+        struct embeddable;
+
+        template <typename Type>
+        constexpr bool is_embeddable_v = embeddable<std::remove_cvref_t<Type>>::value;
+
+        template <typename Fields>
+        struct embeddable_fields;
+
+        template <typename... Fields>
+        struct embeddable_fields<rfl::Tuple<Fields...>> : std::bool_constant<(is_embeddable_v<typename Fields::Type> && ...)> {};
+
+        template <typename Type>
+        struct embeddable {
+            static constexpr bool compute() {
+                if constexpr (std::is_arithmetic_v<Type> || std::is_enum_v<Type> || validate::is_string_like_v<Type> ||
+                              validate::is_tensor_v<Type>) {
+                    return true;
+                } else if constexpr (validate::is_optional_v<Type> || validate::is_vector_v<Type> ||
+                                     config::detail::is_std_array_v<Type> || validate::is_soa_v<Type>) {
+                    return is_embeddable_v<typename Type::value_type>;
+                } else if constexpr (validate::is_map_v<Type>) {
+                    return is_embeddable_v<typename Type::key_type> && is_embeddable_v<typename Type::mapped_type>;
+                } else if constexpr (config::detail::is_path_struct_v<Type>) {
+                    return embeddable_fields<typename rfl::named_tuple_t<Type>::Fields>::value;
+                } else {
+                    return false;
+                }
+            }
+            static constexpr bool value = compute();
+        };
+
+        template <typename Type>
+        std::string type_name() {
+            return rfl::internal::get_type_name<std::remove_cvref_t<Type>>().str();
+        }
+
+        /**
+         * @brief Appends C++ expressions that rebuild configuration values.
+         */
+        class InitializerWriter {
+        public:
+            explicit InitializerWriter(std::string& out) : m_out(out) {}
+
+            /**
+             * @brief Appends an expression for `value`.
+             * @param value The value.
+             * @param typed Whether a braced list must name its type, as it must where the list
+             *              initializes an `std::optional` rather than the container itself.
+             */
+            template <typename V>
+            void write(const V& value, const bool typed = false) {
+                using Type = std::remove_cvref_t<V>;
+                if constexpr (std::is_same_v<Type, bool>) {
+                    m_out += value ? "true" : "false";
+                } else if constexpr (std::is_integral_v<Type>) {
+                    write_integer(value);
+                } else if constexpr (std::is_floating_point_v<Type>) {
+                    write_float(value);
+                } else if constexpr (std::is_enum_v<Type>) {
+                    m_out += std::format("static_cast<{}>(", type_name<Type>());
+                    write_integer(static_cast<std::underlying_type_t<Type>>(value));
+                    m_out += ')';
+                } else if constexpr (validate::is_string_like_v<Type>) {
+                    write_string(value);
+                } else if constexpr (validate::is_optional_v<Type>) {
+                    if (value.has_value()) {
+                        write(*value, true);
+                    } else {
+                        m_out += "std::nullopt";
+                    }
+                } else if constexpr (validate::is_tensor_v<Type>) {
+                    m_out += std::format("fourdst::config::Tensor<{}, {}>({{", type_name<typename Type::value_type>(), Type::rank);
+                    write_list(value.extents());
+                    m_out += std::format("}}, std::vector<{}>{{", type_name<typename Type::value_type>());
+                    write_list(value.values());
+                    m_out += "})";
+                } else if constexpr (validate::is_soa_v<Type>) {
+                    m_out += type_name<Type>();
+                    m_out += '{';
+                    write_list(value);
+                    m_out += '}';
+                } else if constexpr (validate::is_vector_v<Type> || config::detail::is_std_array_v<Type>) {
+                    if (typed) m_out += type_name<Type>();
+                    m_out += '{';
+                    write_list(value);
+                    m_out += '}';
+                } else if constexpr (validate::is_map_v<Type>) {
+                    if (typed) m_out += type_name<Type>();
+                    m_out += '{';
+                    bool first = true;
+                    for (const auto& [key, mapped] : value) {
+                        m_out += first ? "{" : ", {";
+                        first = false;
+                        write(key);
+                        m_out += ", ";
+                        write(mapped);
+                        m_out += '}';
+                    }
+                    m_out += '}';
+                } else {
+                    using Fields = typename rfl::named_tuple_t<Type>::Fields;
+                    const auto view = rfl::to_view(value);
+                    m_out += type_name<Type>();
+                    m_out += '{';
+                    [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                        ((m_out += Is == 0 ? "." : ", .", m_out += rfl::tuple_element_t<Is, Fields>::name(), m_out += " = ",
+                          write(*rfl::get<Is>(view.values()))),
+                         ...);
+                    }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+                    m_out += '}';
+                }
+            }
+
+        private:
+            template <typename Range>
+            void write_list(const Range& values) {
+                bool first = true;
+                for (const auto& element : values) {
+                    if (!first) m_out += ", ";
+                    first = false;
+                    write(element);
+                }
+            }
+
+            template <typename I>
+            void write_integer(const I value) {
+                if constexpr (std::is_signed_v<I>) {
+                    // The most negative value has no literal: -9223372036854775808 negates an unsigned literal.
+                    if (value == std::numeric_limits<I>::min() && sizeof(I) >= sizeof(long long)) {
+                        m_out += std::format("({}LL - 1)", value + 1);
+                        return;
+                    }
+                }
+                char buffer[24];
+                const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+                m_out.append(buffer, result.ptr);
+                if constexpr (sizeof(I) >= sizeof(long long)) {
+                    m_out += std::is_signed_v<I> ? "LL" : "ULL";
+                } else if constexpr (std::is_unsigned_v<I>) {
+                    m_out += 'U';
+                }
+            }
+
+            template <typename F>
+            void write_float(const F value) {
+                if (std::isnan(value)) {
+                    m_out += std::format("std::numeric_limits<{}>::quiet_NaN()", type_name<F>());
+                    return;
+                }
+                if (std::isinf(value)) {
+                    m_out += std::format("{}std::numeric_limits<{}>::infinity()", value < 0 ? "-" : "", type_name<F>());
+                    return;
+                }
+                char buffer[64];
+                const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+                const std::string_view text(buffer, result.ptr);
+                m_out += text;
+                if (text.find_first_of(".en") == std::string_view::npos) m_out += ".0";
+                if constexpr (std::is_same_v<F, float>) {
+                    m_out += 'F';
+                } else if constexpr (std::is_same_v<F, long double>) {
+                    m_out += 'L';
+                }
+            }
+
+            void write_string(const std::string_view text) {
+                m_out += '"';
+                for (const char c : text) {
+                    const auto byte = static_cast<unsigned char>(c);
+                    if (c == '"' || c == '\\') {
+                        m_out += '\\';
+                        m_out += c;
+                    } else if (byte < 0x20 || byte >= 0x7f || c == '?') {
+                        // Three-digit octal escapes never absorb the next character, and `?` avoids trigraphs.
+                        m_out += std::format("\\{:03o}", byte);
+                    } else {
+                        m_out += c;
+                    }
+                }
+                m_out += '"';
+            }
+
+            std::string& m_out;
+        };
+    }
+
+    /**
+     * @brief Whether `T` can be written as a generated initializer by `embed_initializer()`.
+     * @tparam T The configuration schema type.
+     */
+    template <typename T>
+    constexpr bool is_embeddable_v = config::detail::is_path_struct_v<T> && detail::is_embeddable_v<T>;
+
+    /**
+     * @brief Returns a C++ expression that evaluates to `value`.
+     * @tparam T The configuration schema type; must satisfy `is_embeddable_v`.
+     */
+    template <typename T>
+    std::string embed_initializer(const T& value) {
+        static_assert(is_embeddable_v<T>, "embed_initializer cannot write this schema; check io::is_embeddable_v first.");
+        std::string out;
+        detail::InitializerWriter(out).write(value);
+        return out;
+    }
+
+    /**
+     * @brief Returns a header defining `T function_name()`, which returns `value`.
+     * @param value The content to embed.
+     * @param function_name The name of the generated function.
+     * @param includes Headers to include first, typically the one defining the schema.
+     * @param source The file the content was read from, named in the header comment.
+     */
+    template <typename T>
+    std::string embed_header(const T& value, const std::string_view function_name, const std::span<const std::string> includes,
+                             const std::string_view source) {
+        std::string out = std::format("// Generated from {} by fourdst::config::embed_main; do not edit.\n#pragma once\n\n", source);
+        for (const auto& include : includes) out += std::format("#include \"{}\"\n", include);
+        out += "#include <limits>\n#include <optional>\n#include <vector>\n\n#include \"fourdst/config/config.h\"\n\n";
+        out += std::format("inline {} {}() {{\n    return {};\n}}\n", detail::type_name<T>(), function_name, embed_initializer(value));
+        return out;
+    }
+}
+
+namespace fourdst::config {
+
+    /**
+     * @brief Runs a config embedding generator: `<tool> <config file> <output header> <function name> [<include>...]`.
+     *
+     * Loads the config file into a `Config<T>` exactly as `Config::load()` would and writes the
+     * header produced by `io::embed_header()`. Errors are printed to standard error.
+     *
+     * @tparam T The configuration schema type; must satisfy `io::is_embeddable_v`.
+     * @return 0 on success, 1 if the file cannot be loaded or the header written, 2 on a usage error.
+     */
+    template <IsConfigSchema T>
+    int embed_main(const int argc, char** argv) {
+        if (argc < 4) {
+            std::cerr << std::format("usage: {} <config file> <output header> <function name> [<include>...]\n",
+                                     argc > 0 ? argv[0] : "embed");
+            return 2;
+        }
+        try {
+            Config<T> cfg;
+            cfg.load(argv[1]);
+            const std::vector<std::string> includes(argv + 4, argv + argc);
+            io::AtomicFileSink sink(argv[2], false);
+            sink.write(io::embed_header(cfg.main(), argv[3], includes, argv[1]));
+            sink.commit();
+        } catch (const std::exception& e) {
+            std::cerr << std::format("{}: {}\n", argv[1], e.what());
+            return 1;
+        }
+        return 0;
+    }
+}
@@ -0,0 +1,170 @@
+/**
+ * @file enum_index.h
+ * @brief Constant-time parsing of enumerator and `rfl::Literal` names.
+ *
+ * reflect-cpp turns a string into an enum with `rfl::string_to_enum`, which compares it against
+ * every enumerator name in turn, and into an `rfl::Literal` by a fold over its names. Configs with
+ * many string-valued fields (species, reaction channels, solver kinds) pay that scan for every
+ * value. `io::enum_from_string()` and `io::literal_from_string()` instead resolve a name with a
+ * perfect hash over the names, built at compile time (see `config::detail::PerfectHash`),
+ * followed by one comparison, and take a `std::string_view`, so the caller's text is not copied.
+ *
+ * The `Parser` specializations below route TOML reads of enums and literals through them, and
+ * the CLI (`register_as_cli`), environment overrides (`env.h`), the validator and the streaming
+ * reader (`toml_stream.h`) call them directly. A string that is not a name falls back to
+ * reflect-cpp, so numeric enumerator values and error messages are exactly as before. Bit-flag
+ * enums, whose values combine names with `|`, and `rfl::UnderlyingEnums` are left to
+ * reflect-cpp.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "fourdst/config/perfect_hash.h"
+
+#include "rfl.hpp"
+#include "rfl/toml.hpp"
+
+namespace fourdst::config::io {
+
+    namespace detail {
+        /// The enumerator names of `E`, in enumerator order.
+        template <typename E>
+        inline constexpr auto enum_names = [] {
+            std::array<std::string_view, enchantum::count<E>> names{};
+            for (std::size_t i = 0; i < names.size(); ++i) names[i] = enchantum::entries<E>[i].second;
+            return names;
+        }();
+
+        /// The names of an `rfl::Literal`, in value order.
+        template <typename L>
+        inline constexpr std::array<std::string_view, 0> literal_names{};
+
+        template <rfl::internal::StringLiteral... fields_>
+        inline constexpr std::array<std::string_view, sizeof...(fields_)> literal_names<rfl::Literal<fields_...>> = {
+            fields_.string_view()...};
+
+        /**
+         * @brief The compile-time index of a fixed list of names.
+         * @tparam Names A constexpr array of the names.
+         */
+        template <const auto& Names>
+        class NameIndex {
+            static constexpr std::size_t s_size = Names.size();
+
+            static constexpr config::detail::PerfectHash<s_size> s_hash = [] {
+                std::array<std::uint64_t, s_size> hashes{};
+                for (std::size_t i = 0; i < s_size; ++i) hashes[i] = config::detail::path_hash(Names[i]);
+                return config::detail::PerfectHash<s_size>::build(hashes);
+            }();
+
+            static_assert(s_hash.perfect, "Unable to build a perfect hash for these names.");
+
+        public:
+            /// Sentinel returned by `find()` for strings that are not names.
+            static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+            /**
+             * @brief Returns the position of `name` in the list, or `npos`.
+             */
+            static constexpr std::size_t find(const std::string_view name) {
+                const std::size_t index = s_hash.candidate(config::detail::path_hash(name));
+                if (index == 0 || Names[index - 1] != name) return npos;
+                return index - 1;
+            }
+        };
+    }
+
+    /**
+     * @brief Parses an enumerator of `E` from its name; a drop-in for `rfl::string_to_enum`.
+     *
+     * Strings that are not enumerator names (numbers, typos) are passed to `rfl::string_to_enum`,
+     * which accepts the former and reports the latter.
+     */
+    template <typename E>
+        requires std::is_enum_v<E>
+    rfl::Result<E> enum_from_string(const std::string_view text) {
+        if constexpr (!enchantum::is_bitflag<E>) {
+            using Index = detail::NameIndex<detail::enum_names<E>>;
+            const std::size_t index = Index::find(text);
+            if (index != Index::npos) return enchantum::entries<E>[index].first;
+        }
+        return rfl::string_to_enum<E>(std::string(text));
+    }
+
+    /**
+     * @brief Parses an `rfl::Literal` from one of its names; a drop-in for `L::from_string`.
+     */
+    template <typename L>
+        requires rfl::internal::is_literal_v<L>
+    rfl::Result<L> literal_from_string(const std::string_view text) {
+        using Index = detail::NameIndex<detail::literal_names<L>>;
+        const std::size_t index = Index::find(text);
+        if (index != Index::npos) return L::from_value(static_cast<typename L::ValueType>(index));
+        return L::from_string(std::string(text));
+    }
+}
+
+namespace rfl::parsing {
+
+    /**
+     * @brief Reads an enum from a TOML string by perfect hash over its enumerator names.
+     */
+    template <class E, class ProcessorsType>
+        requires(std::is_enum_v<E> && !enchantum::is_bitflag<E> && !ProcessorsType::underlying_enums_ &&
+                 !internal::has_read_reflector<E> && !internal::has_write_reflector<E>)
+    struct Parser<rfl::toml::Reader, rfl::toml::Writer, E, ProcessorsType> {
+        using R = rfl::toml::Reader;
+        using W = rfl::toml::Writer;
+        using InputVarType = typename R::InputVarType;
+
+        static Result<E> read(const R&, const InputVarType& _var) noexcept {
+            const auto* text = _var->as_string();
+            if (text == nullptr) return error("Could not cast the node to std::string!");
+            return fourdst::config::io::enum_from_string<E>(text->get());
+        }
+
+        template <class P>
+        static void write(const W& _w, const E& _var, const P& _parent) {
+            Parent<W>::add_value(_w, rfl::enum_to_string(_var), _parent);
+        }
+
+        static schema::Type to_schema(std::map<std::string, schema::Type>* _definitions) {
+            using LiteralType = typename decltype(internal::enums::get_enum_names<E>())::Literal;
+            return Parser<R, W, LiteralType, ProcessorsType>::to_schema(_definitions);
+        }
+    };
+
+    /**
+     * @brief Reads an `rfl::Literal` from a TOML string by perfect hash over its names.
+     */
+    template <internal::StringLiteral... fields_, class ProcessorsType>
+    struct Parser<rfl::toml::Reader, rfl::toml::Writer, rfl::Literal<fields_...>, ProcessorsType> {
+        using R = rfl::toml::Reader;
+        using W = rfl::toml::Writer;
+        using InputVarType = typename R::InputVarType;
+        using LiteralType = rfl::Literal<fields_...>;
+
+        static Result<LiteralType> read(const R&, const InputVarType& _var) noexcept {
+            const auto* text = _var->as_string();
+            if (text == nullptr) return error("Could not cast the node to std::string!");
+            return fourdst::config::io::literal_from_string<LiteralType>(text->get());
+        }
+
+        template <class P>
+        static void write(const W& _w, const LiteralType& _var, const P& _parent) {
+            Parser<R, W, std::string, ProcessorsType>::write(_w, _var.str(), _parent);
+        }
+
+        static schema::Type to_schema(std::map<std::string, schema::Type>*) {
+            return schema::Type{schema::Type::Literal{.values_ = LiteralType::strings()}};
+        }
+    };
+}
@@ -0,0 +1,275 @@
+/**
+ * @file env.h
+ * @brief The environment-variable layer applied on top of loaded configuration content.
+ *
+ * With `Config::set_env_prefix()`, every field path of a schema can be set by the variable
+ * `<prefix><PATH>`, where `PATH` is the dotted path upper-cased with `.` replaced by `__`
+ * (`FOURDST_SIMULATION__TIME_STEP`). `EnvNames<T>` holds those names, without the prefix, in
+ * one static character array built at compile time, with a perfect hash over them. Applying
+ * the layer walks the process environment once: each variable that starts with the prefix is
+ * looked up by the rest of its name, so no name is assembled and `getenv` is never called per
+ * field.
+ *
+ * Matching values are converted straight into the field: strings verbatim, numbers with
+ * `std::from_chars`, booleans as `true`/`false`, enums by name. Only values the direct
+ * conversion does not take (arrays, inline tables, hexadecimal or `_`-separated numbers) are
+ * parsed as a TOML value and deserialized.
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/enum_index.h"
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/path_table.h"
+#include "fourdst/config/provenance.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+#include "rfl/toml.hpp"
+
+#include <toml++/toml.h>
+
+#if defined(_WIN32)
+#include <stdlib.h>
+#else
+extern char** environ;
+#endif
+
+namespace fourdst::config::detail {
+
+    /**
+     * @brief Converts `text` into `value` without TOML, if it is in a form the field type takes directly.
+     * @return False if `text` has to be parsed as a TOML value instead.
+     */
+    template <typename Type>
+    bool convert_env_value(const std::string_view text, Type& value) {
+        if constexpr (validate::is_optional_v<Type>) {
+            typename Type::value_type inner{};
+            if (!convert_env_value(text, inner)) return false;
+            value = std::move(inner);
+            return true;
+        } else if constexpr (validate::is_std_string_v<Type>) {
+            value.assign(text);
+            return true;
+        } else if constexpr (std::is_same_v<Type, bool>) {
+            if (text != "true" && text != "false") return false;
+            value = text == "true";
+            return true;
+        } else if constexpr (std::is_enum_v<Type>) {
+            auto result = io::enum_from_string<Type>(text);
+            if (!result) return false;
+            value = result.value();
+            return true;
+        } else if constexpr (std::is_arithmetic_v<Type>) {
+            // from_chars rejects a leading '+', which TOML allows; such values take the TOML path.
+            const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+            return error == std::errc{} && end == text.data() + text.size();
+        } else {
+            return false;
+        }
+    }
+
+    /**
+     * @brief Sets the field at `field` (of type `Type`) from the text of an environment variable.
+     * @throws exceptions::ConfigParseError If the text is not a value of the field type.
+     */
+    template <typename Type>
+    void set_env_field(void* field, const std::string_view text, const std::string_view variable) {
+        Type& value = *static_cast<Type*>(field);
+        if (convert_env_value(text, value)) return;
+        if constexpr (std::is_same_v<Type, std::string_view>) {
+            // A view would point into the environment, which setenv() may free.
+            throw exceptions::ConfigParseError(std::format("Environment variable {} names a std::string_view field, which cannot own its value.", variable));
+        }
+        std::string error;
+        try {
+            toml::table parsed = toml::parse(std::format("value = {}", text));
+            auto result = rfl::toml::read<Type>(parsed.get("value"));
+            if (result) {
+                value = std::move(result).value();
+                return;
+            }
+            error = result.error().what();
+        } catch (const toml::parse_error& e) {
+            error = e.description();
+        }
+        throw exceptions::ConfigParseError(std::format("Invalid value '{}' for environment variable {}: {}", text, variable, error));
+    }
+
+    /**
+     * @brief The environment variable names of the fields of a schema, built at compile time.
+     *
+     * Entries follow the order of `PathTable<T>` (a pre-order walk over the fields), so an entry
+     * index is also the provenance ordinal of the field. Names do not include the prefix.
+     */
+    template <typename T>
+    class EnvNames {
+        static constexpr PathTableSize s_size = [] {
+            PathTableSize size;
+            measure_paths<T>(size, 0);
+            return size;
+        }();
+
+        struct Entry {
+            std::size_t begin = 0;
+            std::size_t length = 0;
+            /// The number of ordinals the field covers: itself and, for a struct, its nested fields.
+            std::size_t count = 0;
+            void (*set)(void* field, std::string_view text, std::string_view variable) = nullptr;
+        };
+
+        struct Data {
+            // Each '.' of a path becomes "__", one character longer.
+            std::array<char, s_size.chars * 2> chars{};
+            std::array<Entry, s_size.entries> entries{};
+            PerfectHash<s_size.entries> hash{};
+        };
+
+        template <typename V>
+        static constexpr void collect(Data& data, std::size_t& next_entry, std::size_t& next_char,
+                                      const std::size_t parent_begin, const std::size_t parent_length) {
+            using Fields = typename rfl::named_tuple_t<V>::Fields;
+            [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                ([&] {
+                    using Field = rfl::tuple_element_t<Is, Fields>;
+                    using Type = typename Field::Type;
+                    const std::size_t begin = next_char;
+                    for (std::size_t i = 0; i < parent_length; ++i) {
+                        data.chars[next_char++] = data.chars[parent_begin + i];
+                    }
+                    if (parent_length != 0) {
+                        data.chars[next_char++] = '_';
+                        data.chars[next_char++] = '_';
+                    }
+                    for (const char c : Field::name()) {
+                        data.chars[next_char++] = c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c;
+                    }
+                    data.entries[next_entry++] = Entry{begin, next_char - begin, 1 + nested_count<Type>(), &set_env_field<Type>};
+                    if constexpr (is_path_struct_v<Type>) {
+                        collect<Type>(data, next_entry, next_char, begin, next_char - begin);
+                    }
+                }(), ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        }
+
+        static constexpr std::string_view key_of(const Data& data, const Entry& entry) {
+            return {data.chars.data() + entry.begin, entry.length};
+        }
+
+        static constexpr Data build() {
+            Data data;
+            std::size_t next_entry = 0;
+            std::size_t next_char = 0;
+            collect<T>(data, next_entry, next_char, 0, 0);
+
+            std::array<std::uint64_t, s_size.entries> hashes{};
+            for (std::size_t i = 0; i < s_size.entries; ++i) {
+                hashes[i] = path_hash(key_of(data, data.entries[i]));
+            }
+            data.hash = PerfectHash<s_size.entries>::build(hashes);
+            return data;
+        }
+
+        static const Data s_data;
+
+    public:
+        /// Sentinel returned by `find()` for names that are not field names.
+        static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+        /**
+         * @brief Returns the entry index of the field named `name` (without the prefix), or `npos`.
+         */
+        static constexpr std::size_t find(const std::string_view name) {
+            static_assert(s_data.hash.perfect, "Unable to build a perfect hash for the environment names of this schema.");
+            if constexpr (s_size.entries == 0) {
+                return npos;
+            } else {
+                const std::size_t index = s_data.hash.candidate(path_hash(name));
+                if (index == 0 || key_of(s_data, s_data.entries[index - 1]) != name) {
+                    return npos;
+                }
+                return index - 1;
+            }
+        }
+
+        /**
+         * @brief Returns the variable name of the field at `index`, without the prefix, e.g. `"SIMULATION__TIME_STEP"`.
+         */
+        static constexpr std::string_view name(const std::size_t index) { return key_of(s_data, s_data.entries[index]); }
+
+        /**
+         * @brief Returns the number of provenance ordinals the field at `index` covers.
+         */
+        static constexpr std::size_t count(const std::size_t index) { return s_data.entries[index].count; }
+
+        /**
+         * @brief Sets the field at `index` inside `content` from the text of `variable`.
+         * @throws exceptions::ConfigParseError If the text is not a value of the field type.
+         */
+        static void set(T& content, const std::size_t index, const std::string_view text, const std::string_view variable) {
+            void* field = const_cast<void*>(PathTable<T>::entry(index).address(content));
+            s_data.entries[index].set(field, text, variable);
+        }
+    };
+
+    template <typename T>
+    constexpr typename EnvNames<T>::Data EnvNames<T>::s_data = EnvNames<T>::build();
+
+    /**
+     * @brief Returns the environment block of the process: `NAME=value` strings ending in a null pointer.
+     */
+    inline char** environment_block() {
+#if defined(_WIN32)
+        return _environ;
+#else
+        return environ;
+#endif
+    }
+
+    /**
+     * @brief Sets the fields of `content` named by environment variables starting with `prefix`.
+     *
+     * The environment is walked once. Matches are applied in field order, so a variable naming a
+     * struct (as an inline table) is applied before the variables naming its fields.
+     *
+     * @param on_applied Called as `on_applied(index, count)` for every field set, with the entry
+     *        index and the number of provenance ordinals it covers.
+     * @throws exceptions::ConfigParseError If a value is not a value of its field type.
+     */
+    template <typename T, typename OnApplied>
+    void apply_environment(T& content, const std::string_view prefix, OnApplied&& on_applied) {
+        struct Match {
+            std::size_t index;
+            std::string_view variable;
+            std::string_view text;
+        };
+        std::vector<Match> matches;
+        for (char** entry = environment_block(); entry != nullptr && *entry != nullptr; ++entry) {
+            const std::string_view assignment(*entry);
+            if (!assignment.starts_with(prefix)) continue;
+            const std::size_t equals = assignment.find('=', prefix.size());
+            if (equals == std::string_view::npos) continue;
+            const std::size_t index = EnvNames<T>::find(assignment.substr(prefix.size(), equals - prefix.size()));
+            if (index == EnvNames<T>::npos) continue;
+            matches.push_back({index, assignment.substr(0, equals), assignment.substr(equals + 1)});
+        }
+        std::ranges::sort(matches, {}, &Match::index);
+        for (const Match& match : matches) {
+            EnvNames<T>::set(content, match.index, match.text, match.variable);
+            on_applied(match.index, EnvNames<T>::count(match.index));
+        }
+    }
+}
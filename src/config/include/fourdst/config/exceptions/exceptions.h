@@ -4,11 +4,16 @@
  *
  * This file defines the hierarchy of exceptions thrown by the `fourdst::config` library.
  * All exceptions inherit from `ConfigError`, which in turn inherits from `std::exception`.
+ * `ConfigErrorInfo` carries the same information as a value, for the non-throwing `try_` API.
  */
 #pragma once
 
+#include <cstddef>
+#include <exception>
+#include <optional>
 #include <stdexcept>
 #include <string>
+#include <utility>
 
 namespace fourdst::config::exceptions {
     /**
@@ -51,10 +56,19 @@ namespace fourdst::config::exceptions {
      * This can occur if the file does not exist, or if there are policy violations
      * (e.g., root name mismatch when `KEEP_CURRENT` is set).
      */
-    class ConfigLoadError final : public ConfigError {
+    class ConfigLoadError : public ConfigError {
         using ConfigError::ConfigError;
     };
 
+    /**
+     * @brief Thrown when a load given a deadline or a stop token did not finish reading in time.
+     *
+     * Nothing was loaded; the config keeps its previous content. See `LoadDeadline`.
+     */
+    class ConfigLoadTimeout final : public ConfigLoadError {
+        using ConfigLoadError::ConfigLoadError;
+    };
+
     /**
      * @brief Thrown when parsing the configuration file fails.
      *
@@ -62,7 +76,44 @@ namespace fourdst::config::exceptions {
      * data that does not match the expected schema type.
      */
     class ConfigParseError final : public ConfigError {
+    public:
+        /**
+         * @brief Where in a config file a parse error was found.
+         */
+        struct Location {
+            /// The file the problem is in (an included fragment, if it came from one).
+            std::string file;
+            /// 1-based line, 0 if unknown.
+            std::size_t line = 0;
+            /// 1-based column, 0 if unknown.
+            std::size_t column = 0;
+            /// Dotted schema path of the offending field; empty for TOML syntax errors.
+            std::string field;
+        };
+
         using ConfigError::ConfigError;
+
+        /**
+         * @brief Constructs a ConfigParseError for a problem at a known position.
+         * @param what The error message.
+         * @param location Where the problem is.
+         */
+        ConfigParseError(const std::string & what, Location location): ConfigError(what), m_location(std::move(location)) {}
+
+        /**
+         * @brief Returns where the problem is, if the error was raised for a specific position.
+         *
+         * Set for TOML syntax errors and for values that do not match the schema; for several
+         * mismatched values it names the first one the message lists.
+         *
+         * @return The location, or `std::nullopt`.
+         */
+        [[nodiscard]] const std::optional<Location>& location() const noexcept {
+            return m_location;
+        }
+
+    private:
+        std::optional<Location> m_location;
     };
 
     /**
@@ -74,5 +125,95 @@ namespace fourdst::config::exceptions {
         using ConfigError::ConfigError;
     };
 
+    /**
+     * @brief Thrown when a dotted field path does not name a field of the configuration schema.
+     *
+     * This indicates a typo in the path or a path that refers to a field removed from the schema.
+     */
+    class ConfigPathError final : public ConfigError {
+        using ConfigError::ConfigError;
+    };
+
+    /**
+     * @brief Thrown when a mutation leaves a field with a value its `rfl::Validator` constraint rejects.
+     *
+     * The mutation is rolled back before the exception is thrown; nothing is published.
+     */
+    class ConfigValidationError final : public ConfigError {
+        using ConfigError::ConfigError;
+    };
+
+    /**
+     * @brief Which `ConfigError` subclass a `ConfigErrorInfo` stands for.
+     */
+    enum class ConfigErrorKind {
+        LOAD,
+        LOAD_TIMEOUT,
+        PARSE,
+        SAVE,
+        SCHEMA_SAVE,
+        PATH,
+        VALIDATION,
+        /// A `ConfigError` of no more specific class, or another `std::exception`.
+        OTHER
+    };
+
+    /**
+     * @brief A `ConfigError` as a plain value, returned by the `try_` members of `Config`.
+     *
+     * Keeps what the typed exception carries (its class, message and, for parse errors, the
+     * location), so callers that do not use exceptions can inspect it, and callers that do can
+     * turn it back into the exception with `rethrow()`.
+     */
+    struct ConfigErrorInfo {
+        ConfigErrorKind kind = ConfigErrorKind::OTHER;
+        std::string message;
+        /// Set for parse errors that name a position; see `ConfigParseError::location()`.
+        std::optional<ConfigParseError::Location> location;
+
+        /**
+         * @brief Captures a caught exception.
+         */
+        static ConfigErrorInfo from(const std::exception& error) {
+            ConfigErrorInfo info{ConfigErrorKind::OTHER, error.what(), std::nullopt};
+            if (const auto* parse = dynamic_cast<const ConfigParseError*>(&error)) {
+                info.kind = ConfigErrorKind::PARSE;
+                info.location = parse->location();
+            } else if (dynamic_cast<const ConfigLoadTimeout*>(&error)) {
+                info.kind = ConfigErrorKind::LOAD_TIMEOUT;
+            } else if (dynamic_cast<const ConfigLoadError*>(&error)) {
+                info.kind = ConfigErrorKind::LOAD;
+            } else if (dynamic_cast<const ConfigSaveError*>(&error)) {
+                info.kind = ConfigErrorKind::SAVE;
+            } else if (dynamic_cast<const SchemaSaveError*>(&error)) {
+                info.kind = ConfigErrorKind::SCHEMA_SAVE;
+            } else if (dynamic_cast<const ConfigPathError*>(&error)) {
+                info.kind = ConfigErrorKind::PATH;
+            } else if (dynamic_cast<const ConfigValidationError*>(&error)) {
+                info.kind = ConfigErrorKind::VALIDATION;
+            }
+            return info;
+        }
+
+        /**
+         * @brief Throws the exception this value was captured from, with the same class and message.
+         */
+        [[noreturn]] void rethrow() const {
+            switch (kind) {
+                case ConfigErrorKind::LOAD: throw ConfigLoadError(message);
+                case ConfigErrorKind::LOAD_TIMEOUT: throw ConfigLoadTimeout(message);
+                case ConfigErrorKind::PARSE:
+                    if (location) throw ConfigParseError(message, *location);
+                    throw ConfigParseError(message);
+                case ConfigErrorKind::SAVE: throw ConfigSaveError(message);
+                case ConfigErrorKind::SCHEMA_SAVE: throw SchemaSaveError(message);
+                case ConfigErrorKind::PATH: throw ConfigPathError(message);
+                case ConfigErrorKind::VALIDATION: throw ConfigValidationError(message);
+                case ConfigErrorKind::OTHER: break;
+            }
+            throw ConfigError(message);
+        }
+    };
+
 
 }
\ No newline at end of file
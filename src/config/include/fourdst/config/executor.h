@@ -0,0 +1,371 @@
+/**
+ * @file executor.h
+ * @brief The executor every parallel path of the library runs its work on.
+ *
+ * Parallel validation, parallel deserialization, `load_many()`, `save_many()`, `lint_files()`
+ * and `Config::load_async()` do not start threads of their own once an executor is installed
+ * with `set_default_executor()`; they hand their work to it instead, so a process that already
+ * runs a TBB or thread pool keeps one set of workers instead of oversubscribing the machine.
+ *
+ * An executor is any callable that accepts a `std::function<void()>` and runs it eventually, on
+ * any thread (the `Executor` concept). It may also provide `bulk(count, work)`, which calls
+ * `work(i)` for every `i` below `count` and returns once all calls have finished (the
+ * `BulkExecutor` concept); without it, `bulk_execute()` submits one task per unit and the
+ * calling thread takes part in the work, so nested parallel calls on a saturated pool still
+ * finish. `ThreadPool` is a fixed pool of `std::thread`s; `TbbExecutor` (with
+ * `FOURDST_CONFIG_USE_TBB`, the `use_tbb` meson option) runs tasks in a `tbb::task_arena` and
+ * bulk work as a `tbb::parallel_for`.
+ *
+ * @code
+ * fourdst::config::ThreadPool pool(16);
+ * fourdst::config::set_default_executor(std::ref(pool));  // once, at startup
+ * @endcode
+ *
+ * Without a default executor, bulk work runs on new threads joined before the call returns, as
+ * before. The background threads of `save_async()`, `watch()`, autosaves and update streams are
+ * long-lived and ordered, and keep their own threads either way.
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if FOURDST_CONFIG_USE_TBB
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#endif
+
+namespace fourdst::config {
+
+    /**
+     * @brief A callable that runs a submitted task eventually, on any thread.
+     */
+    template <typename E>
+    concept Executor = std::invocable<E&, std::function<void()>>;
+
+    /**
+     * @brief An executor that also runs `work(i)` for every `i` below `count` and waits for all of them.
+     */
+    template <typename E>
+    concept BulkExecutor = Executor<E> && requires(E& executor, const std::size_t count, const std::function<void(std::size_t)>& work) {
+        executor.bulk(count, work);
+    };
+
+    namespace detail {
+        /**
+         * @brief The units of one bulk call, claimed in turn by the caller and the tasks it submitted.
+         *
+         * A task that starts after the caller has closed the call returns without touching `work`,
+         * so the caller only waits for tasks that are running, never for tasks still queued.
+         */
+        struct BulkState {
+            explicit BulkState(const std::size_t count, const std::function<void(std::size_t)>& work) : count(count), work(&work) {}
+
+            /// Runs units until none are left.
+            void drain() {
+                for (std::size_t i = next.fetch_add(1, std::memory_order_relaxed); i < count;
+                     i = next.fetch_add(1, std::memory_order_relaxed)) {
+                    (*work)(i);
+                }
+            }
+
+            /// Called from a submitted task.
+            void help() {
+                {
+                    const std::lock_guard lock(mutex);
+                    if (closed) return;
+                    ++active;
+                }
+                drain();
+                const std::lock_guard lock(mutex);
+                if (--active == 0) idle.notify_all();
+            }
+
+            /// Called by the caller once it has drained the units itself.
+            void close() {
+                std::unique_lock lock(mutex);
+                closed = true;
+                idle.wait(lock, [this] { return active == 0; });
+            }
+
+            const std::size_t count;
+            const std::function<void(std::size_t)>* work;
+            std::atomic<std::size_t> next{0};
+            std::mutex mutex;
+            std::condition_variable idle;
+            std::size_t active = 0;
+            bool closed = false;
+        };
+
+        /**
+         * @brief Runs the units of `work` on `count - 1` threads started for the call and on the caller.
+         *
+         * A thread that cannot be started leaves its units to the others.
+         */
+        inline void bulk_on_new_threads(const std::size_t count, const std::function<void(std::size_t)>& work) {
+            const auto state = std::make_shared<BulkState>(count, work);
+            {
+                std::vector<std::jthread> threads;
+                try {
+                    threads.reserve(count - 1);
+                    for (std::size_t t = 1; t < count; ++t) threads.emplace_back([state] { state->help(); });
+                } catch (const std::system_error&) {
+                }
+                state->drain();
+            }
+            state->close();
+        }
+
+        /**
+         * @brief Runs the units of `work` on `count - 1` tasks submitted to `executor` and on the caller.
+         */
+        template <Executor E>
+        void bulk_by_submit(E& executor, const std::size_t count, const std::function<void(std::size_t)>& work) {
+            const auto state = std::make_shared<BulkState>(count, work);
+            try {
+                for (std::size_t t = 1; t < count; ++t) std::invoke(executor, std::function<void()>([state] { state->help(); }));
+            } catch (...) {
+                // Units the caller drains below need no task; only running tasks are waited for.
+            }
+            state->drain();
+            state->close();
+        }
+    }
+
+    /**
+     * @brief Calls `work(i)` for every `i` below `count` on `executor` and returns when all calls have finished.
+     *
+     * Uses `executor.bulk()` if it has one. Otherwise the calling thread runs units too, so the
+     * call finishes even if no submitted task ever starts. `work` must not throw.
+     */
+    template <Executor E>
+    void bulk_execute(E& executor, const std::size_t count, const std::function<void(std::size_t)>& work) {
+        if (count == 0) return;
+        if (count == 1) {
+            work(0);
+        } else if constexpr (BulkExecutor<E>) {
+            executor.bulk(count, work);
+        } else {
+            detail::bulk_by_submit(executor, count, work);
+        }
+    }
+
+    /**
+     * @brief A copyable, type-erased executor; an empty one starts threads for its work.
+     */
+    class AnyExecutor {
+    public:
+        /// An empty executor: bulk work runs on new threads, and each task on a new detached thread.
+        AnyExecutor() = default;
+
+        /**
+         * @brief Wraps `executor`; wrap a pool that cannot be copied in `std::ref`.
+         */
+        template <Executor E>
+            requires(!std::same_as<std::remove_cvref_t<E>, AnyExecutor>)
+        AnyExecutor(E executor) : m_model(std::make_shared<Model<E>>(std::move(executor))) {}
+
+        /// True unless the executor is empty.
+        explicit operator bool() const { return m_model != nullptr; }
+
+        /**
+         * @brief Submits `task`.
+         */
+        void operator()(std::function<void()> task) const {
+            if (m_model != nullptr) {
+                m_model->submit(std::move(task));
+            } else {
+                std::thread(std::move(task)).detach();
+            }
+        }
+
+        /**
+         * @brief Calls `work(i)` for every `i` below `count` and waits for all calls; see `bulk_execute()`.
+         */
+        void bulk(const std::size_t count, const std::function<void(std::size_t)>& work) const {
+            if (m_model != nullptr) {
+                m_model->bulk(count, work);
+            } else {
+                detail::bulk_on_new_threads(count, work);
+            }
+        }
+
+    private:
+        struct Concept {
+            virtual ~Concept() = default;
+            virtual void submit(std::function<void()> task) = 0;
+            virtual void bulk(std::size_t count, const std::function<void(std::size_t)>& work) = 0;
+        };
+
+        template <typename E>
+        struct Model final : Concept {
+            explicit Model(E executor) : executor(std::move(executor)) {}
+            void submit(std::function<void()> task) override { std::invoke(executor, std::move(task)); }
+            void bulk(const std::size_t count, const std::function<void(std::size_t)>& work) override {
+                bulk_execute(executor, count, work);
+            }
+            E executor;
+        };
+
+        std::shared_ptr<Concept> m_model;
+    };
+
+    namespace detail {
+        struct ExecutorSlot {
+            std::mutex mutex;
+            AnyExecutor executor;
+        };
+
+        inline ExecutorSlot& executor_slot() {
+            static ExecutorSlot slot;
+            return slot;
+        }
+    }
+
+    /**
+     * @brief Installs the executor the library's parallel paths run on; an empty one restores new threads.
+     *
+     * Meant to be called once, at startup, before any parallel work. Work already running keeps
+     * the executor it started on; a wrapped pool must outlive it.
+     */
+    inline void set_default_executor(AnyExecutor executor) {
+        auto& slot = detail::executor_slot();
+        const std::lock_guard lock(slot.mutex);
+        slot.executor = std::move(executor);
+    }
+
+    /**
+     * @brief Returns the executor installed with `set_default_executor()`, empty if there is none.
+     */
+    [[nodiscard]] inline AnyExecutor default_executor() {
+        auto& slot = detail::executor_slot();
+        const std::lock_guard lock(slot.mutex);
+        return slot.executor;
+    }
+
+    /**
+     * @brief Calls `work(i)` for every `i` below `count` on the default executor and waits for all calls.
+     */
+    inline void bulk_execute(const std::size_t count, const std::function<void(std::size_t)>& work) {
+        AnyExecutor executor = default_executor();
+        bulk_execute(executor, count, work);
+    }
+
+    /**
+     * @brief A fixed pool of `std::thread`s that run submitted tasks in submission order.
+     *
+     * Not copyable; pass it as `std::ref(pool)` where an executor is copied. Tasks still queued
+     * when the pool is destroyed are run before its threads are joined.
+     */
+    class ThreadPool {
+    public:
+        /**
+         * @brief Starts `threads` workers; 0 uses `std::thread::hardware_concurrency()`.
+         * @throws std::system_error If a thread cannot be started.
+         */
+        explicit ThreadPool(const unsigned threads = 0) {
+            const unsigned count = threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+            m_threads.reserve(count);
+            try {
+                for (unsigned t = 0; t < count; ++t) m_threads.emplace_back([this] { run(); });
+            } catch (...) {
+                stop();
+                throw;
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool() { stop(); }
+
+        /**
+         * @brief Queues `task` to run on a worker.
+         */
+        void operator()(std::function<void()> task) {
+            {
+                const std::lock_guard lock(m_mutex);
+                m_tasks.push_back(std::move(task));
+            }
+            m_wake.notify_one();
+        }
+
+        /// Number of worker threads.
+        [[nodiscard]] std::size_t size() const { return m_threads.size(); }
+
+    private:
+        void run() {
+            std::unique_lock lock(m_mutex);
+            while (true) {
+                m_wake.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+                if (m_tasks.empty()) return;
+                std::function<void()> task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+                lock.unlock();
+                task();
+                lock.lock();
+            }
+        }
+
+        void stop() {
+            {
+                const std::lock_guard lock(m_mutex);
+                m_stopping = true;
+            }
+            m_wake.notify_all();
+            m_threads.clear();
+        }
+
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::deque<std::function<void()>> m_tasks;
+        bool m_stopping = false;
+        std::vector<std::jthread> m_threads;
+    };
+
+#if FOURDST_CONFIG_USE_TBB
+    /**
+     * @brief Runs tasks in a `tbb::task_arena` and bulk work as a `tbb::parallel_for` inside it.
+     *
+     * By default the executor owns an arena of TBB's default concurrency, which shares TBB's
+     * worker threads with the rest of the process; pass an arena to confine the work to it.
+     */
+    class TbbExecutor {
+    public:
+        TbbExecutor() : m_owned(std::make_shared<tbb::task_arena>()), m_arena(m_owned.get()) {}
+
+        /**
+         * @brief Runs the work in `arena`, which must outlive the executor and its copies.
+         */
+        explicit TbbExecutor(tbb::task_arena& arena) : m_arena(&arena) {}
+
+        /**
+         * @brief Enqueues `task` in the arena.
+         */
+        void operator()(std::function<void()> task) const { m_arena->enqueue(std::move(task)); }
+
+        /**
+         * @brief Runs `work(i)` for every `i` below `count` as a `tbb::parallel_for` and waits for it.
+         */
+        void bulk(const std::size_t count, const std::function<void(std::size_t)>& work) const {
+            m_arena->execute([&] { tbb::parallel_for(std::size_t{0}, count, [&](const std::size_t i) { work(i); }); });
+        }
+
+    private:
+        std::shared_ptr<tbb::task_arena> m_owned;
+        tbb::task_arena* m_arena;
+    };
+#endif
+}
@@ -0,0 +1,328 @@
+/**
+ * @file expression.h
+ * @brief `${path}` references and arithmetic in the TOML values of numeric fields, resolved on load.
+ *
+ * With expressions enabled (see `Config::set_expressions()`), a numeric field may be given as a
+ * string holding an arithmetic expression over numbers and references to other fields:
+ *
+ * @code
+ * [main.simulation]
+ * time_step = 0.01
+ * total_time = "100 * ${simulation.time_step}"
+ * output_frequency = "(${simulation.total_time} / ${simulation.time_step}) / 10"
+ * @endcode
+ *
+ * Expressions support `+`, `-`, `*`, `/`, unary signs and parentheses, and are evaluated in
+ * double precision. A reference names a field by its dotted path below the root table, with
+ * `[i]` for array elements, and must resolve to a number or to another expression; references
+ * are followed in dependency order, and cycles are reported. Integer fields accept only results
+ * that are whole numbers.
+ *
+ * Expressions are resolved in the parsed document, before it is deserialized, so the loaded
+ * content holds plain typed values and reading them costs nothing extra. For the same reason a
+ * config saved afterwards writes the resolved numbers, not the expressions. Expressions that do
+ * not parse, reference unknown or non-numeric fields, or take part in a cycle are reported as
+ * `IssueKind::BAD_EXPRESSION` together with the other problems of the load, as are expressions
+ * nested, or chains of references followed, more than 256 levels deep.
+ *
+ * Only fields whose schema type is numeric are considered, so string fields whose text happens
+ * to contain `${` are left untouched.
+ */
+#pragma once
+
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <format>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/path_table.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config::io {
+
+    namespace detail {
+        /// How deep parentheses and unary signs may nest in one expression, and references may chain.
+        inline constexpr std::size_t max_expression_depth = 256;
+
+        /**
+         * @brief Recursive-descent evaluator for one expression.
+         * @tparam Lookup Called with the path of each `${path}` reference; returns
+         *                `std::expected<double, std::string>`.
+         */
+        template <typename Lookup>
+        class ExpressionParser {
+        public:
+            ExpressionParser(const std::string_view text, Lookup& lookup) : m_text(text), m_lookup(lookup) {}
+
+            std::expected<double, std::string> evaluate() {
+                auto value = sum();
+                if (!value) return value;
+                skip_space();
+                if (m_pos != m_text.size()) return fail(std::format("unexpected '{}'", m_text[m_pos]));
+                return value;
+            }
+
+        private:
+            std::expected<double, std::string> sum() {
+                auto value = product();
+                while (value) {
+                    skip_space();
+                    if (m_pos == m_text.size() || (m_text[m_pos] != '+' && m_text[m_pos] != '-')) break;
+                    const char op = m_text[m_pos++];
+                    const auto rhs = product();
+                    if (!rhs) return rhs;
+                    *value = op == '+' ? *value + *rhs : *value - *rhs;
+                }
+                return value;
+            }
+
+            std::expected<double, std::string> product() {
+                auto value = factor();
+                while (value) {
+                    skip_space();
+                    if (m_pos == m_text.size() || (m_text[m_pos] != '*' && m_text[m_pos] != '/')) break;
+                    const char op = m_text[m_pos++];
+                    const auto rhs = factor();
+                    if (!rhs) return rhs;
+                    if (op == '/' && *rhs == 0.0) return fail("division by zero");
+                    *value = op == '*' ? *value * *rhs : *value / *rhs;
+                }
+                return value;
+            }
+
+            std::expected<double, std::string> factor() {
+                // Every level of parentheses or unary signs passes through here once.
+                if (m_depth == max_expression_depth) return fail("expression is nested too deeply");
+                ++m_depth;
+                auto value = nested_factor();
+                --m_depth;
+                return value;
+            }
+
+            std::expected<double, std::string> nested_factor() {
+                skip_space();
+                if (m_pos == m_text.size()) return fail("unexpected end of expression");
+                const char c = m_text[m_pos];
+                if (c == '+' || c == '-') {
+                    ++m_pos;
+                    auto value = factor();
+                    if (value && c == '-') *value = -*value;
+                    return value;
+                }
+                if (c == '(') {
+                    ++m_pos;
+                    auto value = sum();
+                    if (!value) return value;
+                    skip_space();
+                    if (m_pos == m_text.size() || m_text[m_pos] != ')') return fail("missing ')'");
+                    ++m_pos;
+                    return value;
+                }
+                if (m_text.substr(m_pos).starts_with("${")) {
+                    const std::size_t close = m_text.find('}', m_pos);
+                    if (close == std::string_view::npos) return fail("missing '}' after '${'");
+                    const std::string_view path = m_text.substr(m_pos + 2, close - m_pos - 2);
+                    m_pos = close + 1;
+                    return m_lookup(path);
+                }
+                double value = 0.0;
+                const auto [end, error] = std::from_chars(m_text.data() + m_pos, m_text.data() + m_text.size(), value);
+                if (error != std::errc{}) return fail(std::format("unexpected '{}'", c));
+                m_pos = static_cast<std::size_t>(end - m_text.data());
+                return value;
+            }
+
+            void skip_space() {
+                while (m_pos < m_text.size() && (m_text[m_pos] == ' ' || m_text[m_pos] == '\t')) ++m_pos;
+            }
+
+            static std::unexpected<std::string> fail(std::string message) { return std::unexpected(std::move(message)); }
+
+            std::string_view m_text;
+            Lookup& m_lookup;
+            std::size_t m_pos = 0;
+            std::size_t m_depth = 0;
+        };
+
+        /**
+         * @brief A string value of a numeric field, and where to write its result.
+         */
+        struct ExpressionSite {
+            enum class State { PENDING, RESOLVING, RESOLVED, FAILED };
+
+            /// Path for issues, starting at the root name, as the validator writes it.
+            std::string path;
+            toml::node* node = nullptr;
+            /// The table or array holding `node`, and its key or index there.
+            toml::node* parent = nullptr;
+            std::string key;
+            std::size_t index = 0;
+            bool integer = false;
+            State state = State::PENDING;
+            double value = 0.0;
+        };
+
+        template <typename Type>
+        constexpr bool is_expression_number_v = std::is_arithmetic_v<Type> && !std::is_same_v<Type, bool>;
+
+        /**
+         * @brief Records the string values that fields of type `Type` hold below `node`.
+         */
+        template <typename Type>
+        void collect_expressions(toml::node& node, toml::node& parent, const std::string_view key, const std::size_t index,
+                                 std::string& path, std::vector<ExpressionSite>& sites) {
+            if constexpr (validate::is_optional_v<Type> || validate::is_lazy_v<Type> || validate::is_tunable_v<Type>) {
+                collect_expressions<std::remove_cvref_t<typename Type::value_type>>(node, parent, key, index, path, sites);
+            } else if constexpr (validate::is_rfl_validator_v<Type>) {
+                collect_expressions<std::remove_cvref_t<typename Type::ReflectionType>>(node, parent, key, index, path, sites);
+            } else if constexpr (is_expression_number_v<Type>) {
+                if (node.is_string()) {
+                    sites.push_back({path, &node, &parent, std::string(key), index, std::is_integral_v<Type>});
+                }
+            } else if constexpr (validate::is_std_array_v<Type> || validate::is_vector_v<Type> || validate::is_soa_v<Type>) {
+                if (toml::array* arr = node.as_array()) {
+                    const std::size_t field_length = path.size();
+                    for (std::size_t i = 0; i < arr->size(); ++i) {
+                        path += std::format("[{}]", i);
+                        collect_expressions<std::remove_cvref_t<typename Type::value_type>>(*arr->get(i), node, {}, i, path, sites);
+                        path.resize(field_length);
+                    }
+                }
+            } else if constexpr (validate::is_map_v<Type>) {
+                if constexpr (validate::is_string_like_v<typename Type::key_type>) {
+                    if (toml::table* members = node.as_table()) {
+                        const std::size_t parent_length = path.size();
+                        for (auto&& [member_key, member] : *members) {
+                            path += '.';
+                            path += member_key.str();
+                            collect_expressions<std::remove_cvref_t<typename Type::mapped_type>>(member, node, member_key.str(), 0, path,
+                                                                                                 sites);
+                            path.resize(parent_length);
+                        }
+                    }
+                }
+            } else if constexpr (config::detail::is_path_struct_v<Type>) {
+                if (toml::table* tbl = node.as_table()) {
+                    using Fields = typename rfl::named_tuple_t<Type>::Fields;
+                    [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                        ([&] {
+                            using Field = rfl::tuple_element_t<Is, Fields>;
+                            if (toml::node* child = tbl->get(Field::name())) {
+                                const std::size_t parent_length = path.size();
+                                path += '.';
+                                path += Field::name();
+                                collect_expressions<std::remove_cvref_t<typename Field::Type>>(*child, node, Field::name(), 0, path, sites);
+                                path.resize(parent_length);
+                            }
+                        }(), ...);
+                    }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+                }
+            }
+        }
+
+        /**
+         * @brief Evaluates `sites[i]`, first evaluating the sites it references.
+         *
+         * `depth` counts the references followed to get here; a chain longer than
+         * `max_expression_depth` is reported rather than followed further.
+         */
+        inline void resolve_site(toml::table& root, std::vector<ExpressionSite>& sites,
+                                 const std::unordered_map<const toml::node*, std::size_t>& by_node, const std::size_t i,
+                                 std::vector<validate::ValidationIssue>& issues, const std::size_t depth = 0) {
+            ExpressionSite& site = sites[i];
+            if (site.state == ExpressionSite::State::RESOLVED || site.state == ExpressionSite::State::FAILED) return;
+            site.state = ExpressionSite::State::RESOLVING;
+
+            auto lookup = [&](const std::string_view reference) -> std::expected<double, std::string> {
+                const toml::node* target = root.at_path(reference).node();
+                if (target == nullptr) return std::unexpected(std::format("unknown reference '${{{}}}'", reference));
+                if (const auto* integer = target->as_integer()) return static_cast<double>(integer->get());
+                if (const auto* floating = target->as_floating_point()) return floating->get();
+                const auto found = by_node.find(target);
+                if (found == by_node.end()) return std::unexpected(std::format("'${{{}}}' is not a number", reference));
+                const ExpressionSite& dependency = sites[found->second];
+                if (dependency.state == ExpressionSite::State::RESOLVING) {
+                    return std::unexpected(std::format("circular reference through '${{{}}}'", reference));
+                }
+                if (dependency.state == ExpressionSite::State::PENDING && depth + 1 >= max_expression_depth) {
+                    return std::unexpected(std::format("references through '${{{}}}' are chained too deeply", reference));
+                }
+                resolve_site(root, sites, by_node, found->second, issues, depth + 1);
+                if (dependency.state == ExpressionSite::State::FAILED) {
+                    return std::unexpected(std::format("'${{{}}}' is not a valid expression", reference));
+                }
+                return dependency.value;
+            };
+
+            auto result = ExpressionParser(site.node->as_string()->get(), lookup).evaluate();
+            if (result && !std::isfinite(*result)) {
+                result = std::unexpected(std::string("result is not finite"));
+            }
+            if (result && site.integer &&
+                (*result != std::trunc(*result) || *result < -0x1p63 || *result >= 0x1p63)) {
+                result = std::unexpected(std::format("result {} is not an integer", *result));
+            }
+            if (!result) {
+                site.state = ExpressionSite::State::FAILED;
+                issues.push_back(validate::located(*site.node, {validate::IssueKind::BAD_EXPRESSION, site.path,
+                                                                std::format("invalid expression \"{}\": {}",
+                                                                            site.node->as_string()->get(), result.error())}));
+                return;
+            }
+            site.value = *result;
+            site.state = ExpressionSite::State::RESOLVED;
+        }
+    }
+
+    /**
+     * @brief Replaces the expressions in the numeric fields of `root` with their values.
+     *
+     * @param root The root table of the document, rewritten in place.
+     * @param root_name The name of the root table, the first segment of issue paths.
+     * @param issues Receives one `IssueKind::BAD_EXPRESSION` issue per expression that could not
+     *               be evaluated; such values are left as they are.
+     */
+    template <typename T>
+    void resolve_expressions(toml::table& root, const std::string_view root_name, std::vector<validate::ValidationIssue>& issues) {
+        std::vector<detail::ExpressionSite> sites;
+        std::string path(root_name);
+        detail::collect_expressions<T>(root, root, {}, 0, path, sites);
+        if (sites.empty()) return;
+
+        std::unordered_map<const toml::node*, std::size_t> by_node;
+        by_node.reserve(sites.size());
+        for (std::size_t i = 0; i < sites.size(); ++i) by_node.emplace(sites[i].node, i);
+        for (std::size_t i = 0; i < sites.size(); ++i) detail::resolve_site(root, sites, by_node, i, issues);
+
+        // Written back only once everything is evaluated: replacing a value destroys its node.
+        for (const auto& site : sites) {
+            if (site.state != detail::ExpressionSite::State::RESOLVED) continue;
+            auto write = [&](auto value) {
+                if (toml::table* table = site.parent->as_table()) {
+                    table->insert_or_assign(site.key, value);
+                } else {
+                    toml::array& array = *site.parent->as_array();
+                    array.replace(array.cbegin() + static_cast<std::ptrdiff_t>(site.index), value);
+                }
+            };
+            if (site.integer) {
+                write(static_cast<std::int64_t>(site.value));
+            } else {
+                write(site.value);
+            }
+        }
+    }
+}
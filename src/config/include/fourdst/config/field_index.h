@@ -0,0 +1,174 @@
+/**
+ * @file field_index.h
+ * @brief Constant-time matching of TOML keys to the fields of wide structs.
+ *
+ * reflect-cpp's `ViewReader` matches each key of a table against the field names one by one, so
+ * reading a struct costs O(fields × keys). For structs with at least `indexed_field_threshold`
+ * fields, the `ViewReader` specialization below for the TOML reader resolves each key with a
+ * perfect hash over the field names, built at compile time (see `config::detail::PerfectHash`),
+ * followed by one key comparison, and calls the field's reader through a table indexed by field.
+ *
+ * Narrower structs keep the generic reader, where a handful of comparisons is cheaper than a hash.
+ * Structs with `rfl::ExtraFields` are left to the generic reader as well. Errors, unknown keys
+ * under `rfl::NoExtraFields` and repeated keys are reported exactly as by the generic reader.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/path_table.h"
+
+#include "rfl.hpp"
+#include "rfl/toml.hpp"
+
+namespace fourdst::config::io {
+
+    /// Structs with at least this many fields have their TOML keys matched by perfect hash.
+    inline constexpr std::size_t indexed_field_threshold = 16;
+
+    namespace detail {
+        /**
+         * @brief The compile-time index of the field names of a named tuple (or view).
+         */
+        template <class NamedTupleType>
+        class FieldIndex {
+            static constexpr std::size_t s_size = NamedTupleType::size();
+
+            static constexpr std::array<std::string_view, s_size> s_names = [] {
+                std::array<std::string_view, s_size> names{};
+                [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                    ((names[Is] = rfl::tuple_element_t<Is, typename NamedTupleType::Fields>::name()), ...);
+                }(std::make_integer_sequence<int, static_cast<int>(s_size)>{});
+                return names;
+            }();
+
+            static constexpr config::detail::PerfectHash<s_size> s_hash = [] {
+                std::array<std::uint64_t, s_size> hashes{};
+                for (std::size_t i = 0; i < s_size; ++i) hashes[i] = config::detail::path_hash(s_names[i]);
+                return config::detail::PerfectHash<s_size>::build(hashes);
+            }();
+
+            static_assert(s_hash.perfect, "Unable to build a perfect hash for the field names of this struct.");
+
+        public:
+            /// Sentinel returned by `find()` for names that are not fields.
+            static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+            /**
+             * @brief Returns the position of the field called `name`, or `npos`.
+             */
+            static constexpr std::size_t find(const std::string_view name) {
+                const std::size_t index = s_hash.candidate(config::detail::path_hash(name));
+                if (index == 0 || s_names[index - 1] != name) return npos;
+                return index - 1;
+            }
+        };
+    }
+}
+
+namespace rfl::parsing {
+
+    /**
+     * @brief Reads the fields of a wide struct from a TOML table, finding each key's field by perfect hash.
+     */
+    template <class ViewType, class ProcessorsType>
+        requires(ViewType::size() >= fourdst::config::io::indexed_field_threshold && ViewType::pos_extra_fields() == -1)
+    class ViewReader<rfl::toml::Reader, rfl::toml::Writer, ViewType, ProcessorsType> {
+        using R = rfl::toml::Reader;
+        using W = rfl::toml::Writer;
+        using InputVarType = typename R::InputVarType;
+        using Index = fourdst::config::io::detail::FieldIndex<ViewType>;
+        static constexpr size_t size_ = ViewType::size();
+
+    public:
+        ViewReader(const R* _r, ViewType* _view, std::array<bool, size_>* _found, std::array<bool, size_>* _set,
+                   std::vector<Error>* _errors)
+            : r_(_r), view_(_view), found_(_found), set_(_set), errors_(_errors) {}
+
+        /// Assigns the parsed version of `_var` to the field named `_name`, if there is one.
+        void read(const std::string_view& _name, const InputVarType& _var) const {
+            const std::size_t index = Index::find(_name);
+            // A field that was read already is not read again, as in the generic reader.
+            if (index != Index::npos && !(*found_)[index]) {
+                s_assign[index](*r_, _var, view_, found_, set_, errors_);
+                return;
+            }
+            if constexpr (ProcessorsType::no_extra_fields_) {
+                std::stringstream stream;
+                stream << "Value named '" << _name
+                       << "' not used. Remove the rfl::NoExtraFields processor or add rfl::ExtraFields to avoid this error message.";
+                errors_->emplace_back(Error(stream.str()));
+            }
+        }
+
+        /// Assigns the parsed version of `_var` to the field at `_index`, if there is one.
+        void read(const int _index, const InputVarType& _var) const {
+            if (_index >= 0 && static_cast<size_t>(_index) < size_ && !(*found_)[static_cast<size_t>(_index)]) {
+                s_assign[static_cast<size_t>(_index)](*r_, _var, view_, found_, set_, errors_);
+            }
+        }
+
+    private:
+        using AssignFunction = void (*)(const R&, const InputVarType&, ViewType*, std::array<bool, size_>*, std::array<bool, size_>*,
+                                        std::vector<Error>*);
+
+        template <int i>
+        static void assign(const R& _r, const InputVarType& _var, ViewType* _view, std::array<bool, size_>* _found,
+                           std::array<bool, size_>* _set, std::vector<Error>* _errors) {
+            using FieldType = tuple_element_t<i, typename ViewType::Fields>;
+            using OriginalType = typename FieldType::Type;
+            using T = std::remove_cvref_t<std::remove_pointer_t<typename FieldType::Type>>;
+            std::get<i>(*_found) = true;
+            auto res = Parser<R, W, T, ProcessorsType>::read(_r, _var);
+            if (!res) {
+                std::stringstream stream;
+                stream << "Failed to parse field '" << std::string(FieldType::name()) << "': " << res.error().what();
+                _errors->emplace_back(Error(stream.str()));
+                return;
+            }
+            if constexpr (std::is_pointer_v<OriginalType>) {
+                move_to(rfl::get<i>(*_view), &(*res));
+            } else {
+                rfl::get<i>(*_view) = std::move(*res);
+            }
+            std::get<i>(*_set) = true;
+        }
+
+        static constexpr std::array<AssignFunction, size_> s_assign = []<int... is>(std::integer_sequence<int, is...>) {
+            return std::array<AssignFunction, size_>{&assign<is>...};
+        }(std::make_integer_sequence<int, static_cast<int>(size_)>{});
+
+        template <class Target, class Source>
+        static void move_to(Target* _t, Source* _s) {
+            if constexpr (std::is_const_v<Target>) {
+                return move_to(const_cast<std::remove_const_t<Target>*>(_t), _s);
+            } else if constexpr (!rfl::internal::is_array_v<Source> && !std::is_array_v<Target>) {
+                ::new (_t) Target(std::move(*_s));
+            } else if constexpr (rfl::internal::is_array_v<Source>) {
+                static_assert(std::is_array_v<Target>, "Expected target to be a c-array.");
+                for (size_t i = 0; i < _s->arr_.size(); ++i) {
+                    move_to(&((*_t)[i]), &(_s->arr_[i]));
+                }
+            } else {
+                for (size_t i = 0; i < _s->size(); ++i) {
+                    move_to(&((*_t)[i]), &((*_s)[i]));
+                }
+            }
+        }
+
+        const R* r_;
+        ViewType* view_;
+        std::array<bool, size_>* found_;
+        std::array<bool, size_>* set_;
+        std::vector<Error>* errors_;
+    };
+}
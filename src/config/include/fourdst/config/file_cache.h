@@ -0,0 +1,106 @@
+/**
+ * @file file_cache.h
+ * @brief A process-wide map from files to what was made of them, reused while the file is unchanged.
+ *
+ * `FragmentCache` (parsed `__include` fragments, fragments.h) and `SectionCache` (deserialized
+ * `Section` files, section.h) both keep one entry per file, keyed by its canonical path and
+ * checked against its modification time and size on every lookup. `StampedFileCache` is that
+ * bookkeeping, shared by both.
+ */
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <variant>
+
+#include "fourdst/config/exceptions/exceptions.h"
+
+namespace fourdst::config::io {
+
+    /**
+     * @brief Values made from files, keyed by canonical path and `Tag`, reused while the file's
+     *        modification time and size are unchanged.
+     *
+     * All member functions are thread-safe; values are made outside the lock, so two threads
+     * missing the same entry at once both make it and the later one is kept.
+     *
+     * @tparam Value The type made from a file; `void` for values of several types told apart by `Tag`.
+     * @tparam Tag Further distinguishes entries of one file, e.g. the type a file was read as.
+     */
+    template <typename Value, typename Tag = std::monostate>
+    class StampedFileCache {
+    public:
+        /**
+         * @param what Names the kind of file in errors, e.g. `"Included config fragment"`.
+         */
+        explicit StampedFileCache(std::string what) : m_what(std::move(what)) {}
+
+        /**
+         * @brief Returns the value cached for `path` and `tag`, calling `make(canonical_path)` if there
+         *        is none or the file has changed since.
+         * @param make Returns a `std::shared_ptr<const Value>`; what it throws is passed on.
+         * @throws exceptions::ConfigLoadError If the file does not exist.
+         */
+        template <typename Make>
+        std::shared_ptr<const Value> get(const std::filesystem::path& path, Make&& make, Tag tag = {}) {
+            std::error_code ec;
+            const std::filesystem::path canonical = std::filesystem::canonical(path, ec);
+            if (ec || !std::filesystem::is_regular_file(canonical, ec)) {
+                throw exceptions::ConfigLoadError(std::format("{} does not exist: {}", m_what, path.string()));
+            }
+            const auto mtime = std::filesystem::last_write_time(canonical, ec);
+            const auto size = std::filesystem::file_size(canonical, ec);
+            Key key{canonical.string(), std::move(tag)};
+
+            {
+                std::lock_guard lock(m_mutex);
+                const auto it = m_entries.find(key);
+                if (it != m_entries.end() && it->second.mtime == mtime && it->second.size == size) {
+                    return it->second.value;
+                }
+            }
+
+            std::shared_ptr<const Value> value = make(canonical);
+
+            std::lock_guard lock(m_mutex);
+            m_entries.insert_or_assign(std::move(key), Entry{mtime, size, value});
+            return value;
+        }
+
+        /**
+         * @brief Drops all entries; values handed out stay valid.
+         */
+        void clear() {
+            std::lock_guard lock(m_mutex);
+            m_entries.clear();
+        }
+
+        /**
+         * @brief Returns the number of entries.
+         */
+        [[nodiscard]] std::size_t size() const {
+            std::lock_guard lock(m_mutex);
+            return m_entries.size();
+        }
+
+    private:
+        using Key = std::pair<std::string, Tag>;
+
+        struct Entry {
+            std::filesystem::file_time_type mtime;
+            std::uintmax_t size = 0;
+            std::shared_ptr<const Value> value;
+        };
+
+        std::string m_what;
+        mutable std::mutex m_mutex;
+        std::map<Key, Entry> m_entries;
+    };
+}
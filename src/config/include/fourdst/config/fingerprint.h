@@ -0,0 +1,189 @@
+/**
+ * @file fingerprint.h
+ * @brief Stable 64-bit content hash of configuration structures.
+ *
+ * `fingerprint_content()` streams the field values of a schema through a 64-bit hash in
+ * declaration order, without serializing them first. The result depends only on the values:
+ * strings and arithmetic arrays are hashed as byte blocks, map entries are combined
+ * independently of iteration order, and `-0.0` hashes like `0.0` so structurally equal configs
+ * (see `detail::equal()`) get equal fingerprints. The hash uses native byte order and is meant
+ * for caches on one platform, not as a portable identifier.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+#include "fourdst/config/binary.h"
+#include "fourdst/config/provenance.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+
+namespace fourdst::config::io {
+
+    /**
+     * @brief Incremental 64-bit hash of a value tree.
+     */
+    class ContentHasher {
+    public:
+        /**
+         * @brief Mixes one 64-bit word into the state.
+         */
+        void add_word(const std::uint64_t word) {
+            m_state = (m_state ^ (word * 0x9E3779B97F4A7C15ULL)) * 0xBF58476D1CE4E5B9ULL;
+            m_state ^= m_state >> 31;
+        }
+
+        /**
+         * @brief Mixes a block of bytes (and its length) into the state.
+         */
+        void add_bytes(const std::string_view bytes) {
+            m_state = hash_bytes(bytes, m_state);
+        }
+
+        /**
+         * @brief Mixes a value into the state.
+         * @param value A leaf, optional, container, map or reflectable struct.
+         */
+        template <typename V>
+        void add(const V& value) {
+            using Type = std::remove_cvref_t<V>;
+            if constexpr (std::is_floating_point_v<Type>) {
+                add_word(float_word(value));
+            } else if constexpr (std::is_arithmetic_v<Type> || std::is_enum_v<Type>) {
+                add_word(static_cast<std::uint64_t>(value));
+            } else if constexpr (validate::is_string_like_v<Type>) {
+                add_bytes(value);
+            } else if constexpr (validate::is_tunable_v<Type>) {
+                add(value.get());
+            } else if constexpr (validate::is_sharded_v<Type>) {
+                add(value.entries());
+            } else if constexpr (validate::is_section_v<Type>) {
+                add(value.file().string());
+            } else if constexpr (validate::is_quantity_v<Type> || validate::is_stored_v<Type>) {
+                add(value.value());
+            } else if constexpr (validate::is_rfl_validator_v<Type>) {
+                add(value.value());
+            } else if constexpr (validate::is_tagged_union_v<Type>) {
+                add_word(value.variant().index());
+                rfl::visit([this](const auto& alternative) { add(alternative); }, value.variant());
+            } else if constexpr (validate::is_lazy_v<Type>) {
+                add(value.get());
+            } else if constexpr (validate::is_optional_v<Type>) {
+                add_word(value.has_value() ? 1 : 0);
+                if (value.has_value()) add(*value);
+            } else if constexpr (validate::is_vector_v<Type> || config::detail::is_std_array_v<Type>) {
+                using Element = typename Type::value_type;
+                if constexpr (std::is_integral_v<Element> && !std::is_same_v<Element, bool>) {
+                    add_bytes({reinterpret_cast<const char*>(value.data()), value.size() * sizeof(Element)});
+                } else {
+                    add_word(value.size());
+                    for (const auto& element : value) add(element);
+                }
+            } else if constexpr (validate::is_sink_v<Type>) {
+                // Elements streamed to a target belong to the caller; only the count is part of the content.
+                add_word(value.size());
+                for (const auto element : value.held()) add(element);
+            } else if constexpr (validate::is_tensor_v<Type>) {
+                for (const std::size_t extent : value.extents()) add_word(extent);
+                using Element = typename Type::value_type;
+                if constexpr (std::is_integral_v<Element>) {
+                    add_bytes({reinterpret_cast<const char*>(value.data()), value.size() * sizeof(Element)});
+                } else {
+                    for (const Element element : value.values()) add(element);
+                }
+            } else if constexpr (validate::is_soa_v<Type>) {
+                add_word(value.size());
+                std::apply([this](const auto&... column) { (add(column), ...); }, value.columns());
+            } else if constexpr (validate::is_map_v<Type>) {
+                // Sum per-entry hashes so the result does not depend on iteration order.
+                std::uint64_t entries = 0;
+                for (const auto& [key, mapped] : value) {
+                    ContentHasher entry;
+                    entry.add(key);
+                    entry.add(mapped);
+                    entries += entry.value();
+                }
+                add_word(value.size());
+                add_word(entries);
+            } else {
+                const auto view = rfl::to_view(value);
+                [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                    (add(*rfl::get<Is>(view.values())), ...);
+                }(std::make_integer_sequence<int, rfl::tuple_size_v<std::remove_cvref_t<decltype(view.values())>>>{});
+            }
+        }
+
+        /**
+         * @brief Returns the hash of everything added so far.
+         */
+        [[nodiscard]] std::uint64_t value() const {
+            std::uint64_t h = m_state;
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            return h;
+        }
+
+    private:
+        template <typename F>
+        static std::uint64_t float_word(F value) {
+            if (value == F(0)) value = F(0);
+            const double widened = static_cast<double>(value);
+            std::uint64_t word;
+            std::memcpy(&word, &widened, sizeof(word));
+            return word;
+        }
+
+        std::uint64_t m_state = 0x243F6A8885A308D3ULL;
+    };
+
+    namespace detail {
+        inline bool is_excluded(const std::span<const config::detail::FieldRange> excluded, const std::size_t ordinal) {
+            for (const auto& range : excluded) {
+                if (ordinal >= range.ordinal && ordinal < range.ordinal + range.count) return true;
+            }
+            return false;
+        }
+
+        template <typename V>
+        void add_fields(ContentHasher& hasher, const V& value, const std::size_t base,
+                        const std::span<const config::detail::FieldRange> excluded) {
+            using Fields = typename rfl::named_tuple_t<V>::Fields;
+            const auto values = rfl::to_view(value).values();
+            std::size_t ordinal = base;
+            [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                ([&] {
+                    using Type = typename rfl::tuple_element_t<Is, Fields>::Type;
+                    if (!is_excluded(excluded, ordinal)) {
+                        if constexpr (config::detail::is_path_struct_v<Type>) {
+                            add_fields(hasher, *rfl::get<Is>(values), ordinal + 1, excluded);
+                        } else {
+                            hasher.add(*rfl::get<Is>(values));
+                        }
+                    }
+                    ordinal += 1 + config::detail::nested_count<Type>();
+                }(), ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        }
+    }
+
+    /**
+     * @brief Hashes the field values of `content` in declaration order.
+     * @tparam T The configuration schema type.
+     * @param content The content to hash.
+     * @param excluded Ordinal ranges of fields to leave out (see `detail::find_field()`).
+     * @return The 64-bit fingerprint.
+     */
+    template <typename T>
+    std::uint64_t fingerprint_content(const T& content, const std::span<const config::detail::FieldRange> excluded = {}) {
+        ContentHasher hasher;
+        detail::add_fields(hasher, content, 0, excluded);
+        return hasher.value();
+    }
+}
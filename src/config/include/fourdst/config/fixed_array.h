@@ -0,0 +1,139 @@
+/**
+ * @file fixed_array.h
+ * @brief In-place reading of `std::array` fields from TOML, with the length checked up front.
+ *
+ * The `Parser` specialization below replaces reflect-cpp's generic `std::array` parser for the
+ * TOML reader. A TOML array knows its length, so the length is compared with `N` before any
+ * element is read, and the elements are then read straight into the result. A mismatch is
+ * recorded on the current thread (see `last_array_size_mismatch()`) along with the offending
+ * node, so `Config` can report it with its path without running the validator over the document.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <format>
+#include <map>
+#include <optional>
+#include <string>
+#include <type_traits>
+
+#include "rfl.hpp"
+#include "rfl/toml.hpp"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config::io {
+
+    /**
+     * @brief A fixed-size array whose TOML value has the wrong number of elements.
+     */
+    struct ArraySizeMismatch {
+        /// The TOML array that was read.
+        const toml::node* node = nullptr;
+        /// The length of the `std::array` field.
+        std::size_t expected = 0;
+        /// The number of elements in the file.
+        std::size_t found = 0;
+
+        /// The message reported for the field, matching the validator's.
+        [[nodiscard]] std::string message() const {
+            return std::format("expected {} elements, found {}", expected, found);
+        }
+    };
+
+    /**
+     * @brief Returns the last array size mismatch met while reading TOML on this thread.
+     *
+     * Reset it before a read; after a failed read it names the array that stopped it, if any.
+     */
+    inline std::optional<ArraySizeMismatch>& last_array_size_mismatch() {
+        thread_local std::optional<ArraySizeMismatch> mismatch;
+        return mismatch;
+    }
+
+    namespace detail {
+        inline bool find_node_path(const toml::node& current, const toml::node* target, std::string& path) {
+            if (&current == target) return true;
+            const std::size_t length = path.size();
+            if (const toml::table* table = current.as_table()) {
+                for (const auto& [key, child] : *table) {
+                    path += std::format(".{}", key.str());
+                    if (find_node_path(child, target, path)) return true;
+                    path.resize(length);
+                }
+            } else if (const toml::array* array = current.as_array()) {
+                for (std::size_t i = 0; i < array->size(); ++i) {
+                    path += std::format("[{}]", i);
+                    if (find_node_path(*array->get(i), target, path)) return true;
+                    path.resize(length);
+                }
+            }
+            return false;
+        }
+    }
+
+    /**
+     * @brief Returns the dotted path of `target` below `root`, in the validator's notation.
+     * @param root The root table.
+     * @param root_name The name of the root table, which starts the path.
+     * @param target The node to look for.
+     * @return The path (e.g. `main.species[0].charges`), or `std::nullopt` if `target` is not below `root`.
+     */
+    inline std::optional<std::string> find_node_path(const toml::table& root, const std::string_view root_name,
+                                                     const toml::node* target) {
+        std::string path(root_name);
+        if (detail::find_node_path(root, target, path)) return path;
+        return std::nullopt;
+    }
+}
+
+namespace rfl::parsing {
+
+    /**
+     * @brief Reads `std::array<T, N>` from TOML in place, rejecting a wrong length before reading any element.
+     */
+    template <class T, std::size_t N, class ProcessorsType>
+        requires std::is_default_constructible_v<T>
+    struct Parser<rfl::toml::Reader, rfl::toml::Writer, std::array<T, N>, ProcessorsType> {
+        using InputVarType = typename rfl::toml::Reader::InputVarType;
+        using ElementParser = Parser<rfl::toml::Reader, rfl::toml::Writer, std::remove_cvref_t<T>, ProcessorsType>;
+
+        static Result<std::array<T, N>> read(const rfl::toml::Reader& _r, const InputVarType& _var) noexcept {
+            ::toml::array* array = _var->as_array();
+            if (array == nullptr) return error("Could not cast to an array!");
+            if (array->size() != N) {
+                const fourdst::config::io::ArraySizeMismatch mismatch{_var, N, array->size()};
+                fourdst::config::io::last_array_size_mismatch() = mismatch;
+                return error(mismatch.message());
+            }
+
+            Result<std::array<T, N>> result = std::array<T, N>{};
+            auto& values = result.value();
+            for (std::size_t i = 0; i < N; ++i) {
+                auto element = ElementParser::read(_r, array->get(i));
+                if (!element) {
+                    return error(std::format("Failed to parse element {}: {}", i, element.error().what()));
+                }
+                values[i] = std::move(*element);
+            }
+            return result;
+        }
+
+        template <class P>
+        static void write(const rfl::toml::Writer& _w, const std::array<T, N>& _arr, const P& _parent) {
+            using ParentType = Parent<rfl::toml::Writer>;
+            auto arr = ParentType::add_array(_w, N, _parent);
+            const auto new_parent = typename ParentType::Array{&arr};
+            for (const auto& e : _arr) {
+                ElementParser::write(_w, e, new_parent);
+            }
+            _w.end_array(&arr);
+        }
+
+        static schema::Type to_schema(std::map<std::string, schema::Type>* _definitions) {
+            return schema::Type{schema::Type::FixedSizeTypedArray{
+                .size_ = N, .type_ = Ref<schema::Type>::make(ElementParser::to_schema(_definitions))}};
+        }
+    };
+}
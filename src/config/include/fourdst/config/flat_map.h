@@ -0,0 +1,218 @@
+/**
+ * @file flat_map.h
+ * @brief `FlatMap<K, V>` fields: small keyed tables held as one sorted array of entries.
+ *
+ * Per-species parameter tables of a few dozen entries are looked up in inner loops. A `std::map`
+ * chases a pointer per tree level and scatters its nodes over the heap; a `FlatMap` keeps its
+ * entries contiguous and sorted by key, so a lookup is a binary search over a few cache lines and
+ * iteration is a linear scan:
+ *
+ * @code
+ * struct NetworkConfig {
+ *     fourdst::config::FlatMap<std::string, double> binding_energy;  // [main.binding_energy] H1 = 0.0 ...
+ * };
+ *
+ * const double e = cfg->binding_energy.at("He4");
+ * @endcode
+ *
+ * A `FlatMap` reads, writes, validates and describes itself exactly like the `std::map` it
+ * replaces. Reading a TOML table reserves one entry per key and sorts once (the table usually
+ * yields its keys in order already, which is checked in linear time); the generic reader of other
+ * formats inserts one key at a time, which appends while keys arrive in order. Inserting out of
+ * order or erasing moves the entries after the position, so build large tables in one go.
+ *
+ * Entries are `std::pair<K, V>`; the key of an entry must not be changed through an iterator.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "rfl.hpp"
+
+namespace fourdst::config {
+
+    /**
+     * @brief A map from `K` to `V` stored as a vector of entries sorted by key.
+     *
+     * @tparam K The key type.
+     * @tparam V The mapped type.
+     * @tparam Compare Orders keys; the default `std::less<>` also finds `std::string` keys by `std::string_view`.
+     */
+    template <typename K, typename V, typename Compare = std::less<>>
+    class FlatMap {
+    public:
+        using key_type = K;
+        using mapped_type = V;
+        using value_type = std::pair<K, V>;
+        using key_compare = Compare;
+        using container_type = std::vector<value_type>;
+        using size_type = std::size_t;
+        using iterator = typename container_type::iterator;
+        using const_iterator = typename container_type::const_iterator;
+
+        FlatMap() = default;
+
+        /**
+         * @brief Takes over `entries` and sorts them by key; of entries with equal keys, the first is kept.
+         */
+        explicit FlatMap(container_type entries, const Compare& compare = Compare())
+            : m_compare(compare), m_entries(std::move(entries)) {
+            const auto by_key = [this](const value_type& a, const value_type& b) { return m_compare(a.first, b.first); };
+            if (!std::is_sorted(m_entries.begin(), m_entries.end(), by_key)) {
+                std::stable_sort(m_entries.begin(), m_entries.end(), by_key);
+            }
+            const auto same_key = [this](const value_type& a, const value_type& b) {
+                return !m_compare(a.first, b.first) && !m_compare(b.first, a.first);
+            };
+            m_entries.erase(std::unique(m_entries.begin(), m_entries.end(), same_key), m_entries.end());
+        }
+
+        FlatMap(const std::initializer_list<value_type> entries) : FlatMap(container_type(entries)) {}
+
+        [[nodiscard]] iterator begin() noexcept { return m_entries.begin(); }
+        [[nodiscard]] iterator end() noexcept { return m_entries.end(); }
+        [[nodiscard]] const_iterator begin() const noexcept { return m_entries.begin(); }
+        [[nodiscard]] const_iterator end() const noexcept { return m_entries.end(); }
+
+        [[nodiscard]] size_type size() const noexcept { return m_entries.size(); }
+        [[nodiscard]] bool empty() const noexcept { return m_entries.empty(); }
+        [[nodiscard]] size_type capacity() const noexcept { return m_entries.capacity(); }
+        void reserve(const size_type count) { m_entries.reserve(count); }
+        void shrink_to_fit() { m_entries.shrink_to_fit(); }
+        void clear() noexcept { m_entries.clear(); }
+
+        /**
+         * @brief Returns the entries, sorted by key.
+         */
+        [[nodiscard]] const container_type& entries() const noexcept { return m_entries; }
+
+        /**
+         * @brief Returns the entry with key `key`, or `end()`.
+         */
+        template <typename Key>
+        [[nodiscard]] iterator find(const Key& key) {
+            const auto it = lower_bound(key);
+            return it != end() && !m_compare(key, it->first) ? it : end();
+        }
+
+        template <typename Key>
+        [[nodiscard]] const_iterator find(const Key& key) const {
+            const auto it = lower_bound(key);
+            return it != end() && !m_compare(key, it->first) ? it : end();
+        }
+
+        template <typename Key>
+        [[nodiscard]] bool contains(const Key& key) const {
+            return find(key) != end();
+        }
+
+        template <typename Key>
+        [[nodiscard]] size_type count(const Key& key) const {
+            return contains(key) ? 1 : 0;
+        }
+
+        /**
+         * @brief Returns the value mapped to `key`.
+         * @throws std::out_of_range If there is no such key.
+         */
+        template <typename Key>
+        [[nodiscard]] V& at(const Key& key) {
+            const auto it = find(key);
+            if (it == end()) throw std::out_of_range("FlatMap::at: key not found");
+            return it->second;
+        }
+
+        template <typename Key>
+        [[nodiscard]] const V& at(const Key& key) const {
+            const auto it = find(key);
+            if (it == end()) throw std::out_of_range("FlatMap::at: key not found");
+            return it->second;
+        }
+
+        /**
+         * @brief Returns the value mapped to `key`, inserting a value-initialized one first if there is none.
+         */
+        V& operator[](const K& key) { return try_emplace(key).first->second; }
+        V& operator[](K&& key) { return try_emplace(std::move(key)).first->second; }
+
+        /**
+         * @brief Inserts `value` unless its key is present.
+         * @return The entry with that key, and whether it was inserted.
+         */
+        std::pair<iterator, bool> insert(value_type value) {
+            const auto it = lower_bound(value.first);
+            if (it != end() && !m_compare(value.first, it->first)) return {it, false};
+            return {m_entries.insert(it, std::move(value)), true};
+        }
+
+        /**
+         * @brief Inserts the entry constructed from `args` unless its key is present.
+         */
+        template <typename... Args>
+        std::pair<iterator, bool> emplace(Args&&... args) {
+            return insert(value_type(std::forward<Args>(args)...));
+        }
+
+        /**
+         * @brief Inserts `key` mapped to `V(args...)` unless `key` is present; `args` are not used otherwise.
+         */
+        template <typename Key, typename... Args>
+        std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args) {
+            const auto it = lower_bound(key);
+            if (it != end() && !m_compare(key, it->first)) return {it, false};
+            return {m_entries.emplace(it, std::piecewise_construct, std::forward_as_tuple(std::forward<Key>(key)),
+                                      std::forward_as_tuple(std::forward<Args>(args)...)),
+                    true};
+        }
+
+        /**
+         * @brief Removes the entry with key `key`.
+         * @return The number of entries removed, 0 or 1.
+         */
+        template <typename Key>
+        size_type erase(const Key& key) {
+            const auto it = find(key);
+            if (it == end()) return 0;
+            m_entries.erase(it);
+            return 1;
+        }
+
+        iterator erase(const const_iterator position) { return m_entries.erase(position); }
+
+        friend bool operator==(const FlatMap& lhs, const FlatMap& rhs) { return lhs.m_entries == rhs.m_entries; }
+
+    private:
+        /// The first entry whose key is not less than `key`; entries arriving in order land at `end()` without a search.
+        template <typename Key>
+        iterator lower_bound(const Key& key) {
+            if (m_entries.empty() || m_compare(m_entries.back().first, key)) return m_entries.end();
+            return std::partition_point(m_entries.begin(), m_entries.end(),
+                                        [&](const value_type& entry) { return m_compare(entry.first, key); });
+        }
+
+        template <typename Key>
+        const_iterator lower_bound(const Key& key) const {
+            return const_cast<FlatMap&>(*this).lower_bound(key);
+        }
+
+        [[no_unique_address]] Compare m_compare{};
+        container_type m_entries;
+    };
+}
+
+namespace rfl::parsing {
+
+    /**
+     * @brief Reads and writes `FlatMap` as an object of its entries, like `std::map`.
+     */
+    template <class R, class W, class K, class V, class Compare, class ProcessorsType>
+        requires AreReaderAndWriter<R, W, fourdst::config::FlatMap<K, V, Compare>>
+    struct Parser<R, W, fourdst::config::FlatMap<K, V, Compare>, ProcessorsType>
+        : public MapParser<R, W, fourdst::config::FlatMap<K, V, Compare>, ProcessorsType> {};
+}
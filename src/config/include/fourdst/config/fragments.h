@@ -0,0 +1,314 @@
+/**
+ * @file fragments.h
+ * @brief `__include` directives for sharing TOML fragments between config files.
+ *
+ * Any table of a TOML config may contain the reserved key `__include`, holding a path or an array
+ * of paths relative to the including file:
+ *
+ * @code
+ * [main.network]
+ * __include = ["common/network.toml", "common/rates.toml"]
+ * screening = "WEAK"   # keys of the including table override the fragments
+ * @endcode
+ *
+ * Each fragment is a TOML document whose top-level keys are merged into the including table.
+ * Fragments are merged in order (later ones override earlier ones), then the table's own keys are
+ * merged on top. Fragments may include further fragments; cycles are an error.
+ *
+ * Parsed fragments are kept in a process-wide `FragmentCache` keyed by canonical path,
+ * modification time and size, so loading many configs that share fragments parses each fragment
+ * once.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/compress.h"
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/file_cache.h"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config::io {
+
+    /// The reserved key holding include paths.
+    inline constexpr std::string_view include_key = "__include";
+
+    /**
+     * @brief Merges `overlay` into `base`: tables recursively, everything else by replacement.
+     *
+     * Nodes are moved out of `overlay`, which is left in a valid but unspecified state.
+     */
+    /**
+     * @brief Converts a toml++ syntax error into a `ConfigParseError` that names its file, line and column.
+     * @param error The toml++ error.
+     * @param what What was being parsed, for the message (e.g. `"TOML file"`).
+     * @param path The file that was parsed, used if the error does not name one.
+     * @return The exception to throw; `location()` is set.
+     */
+    inline exceptions::ConfigParseError syntax_error(const toml::parse_error& error, const std::string_view what, const std::string_view path) {
+        const toml::source_region& source = error.source();
+        exceptions::ConfigParseError::Location location{source.path ? *source.path : std::string(path),
+                                                        source.begin.line, source.begin.column, {}};
+        std::string message = std::format("Unable to parse {}: {}:{}:{}. Reason: {}",
+                                          what, location.file, location.line, location.column, error.description());
+        return {message, std::move(location)};
+    }
+
+    inline void merge_tables(toml::table& base, toml::table& overlay) {
+        for (auto&& [key, node] : overlay) {
+            toml::node* existing = base.get(key.str());
+            if (existing != nullptr && existing->is_table() && node.is_table()) {
+                merge_tables(*existing->as_table(), *node.as_table());
+            } else {
+                node.visit([&](auto& concrete) { base.insert_or_assign(key.str(), std::move(concrete)); });
+            }
+        }
+    }
+
+    /**
+     * @brief Like `merge_tables()`, but copies the values of `overlay`, which stays intact.
+     */
+    inline void merge_tables(toml::table& base, const toml::table& overlay) {
+        for (auto&& [key, node] : overlay) {
+            toml::node* existing = base.get(key.str());
+            if (existing != nullptr && existing->is_table() && node.is_table()) {
+                merge_tables(*existing->as_table(), *node.as_table());
+            } else {
+                node.visit([&](const auto& concrete) { base.insert_or_assign(key.str(), concrete); });
+            }
+        }
+    }
+
+    namespace detail {
+        /// Returns the table holding the last segment of the dotted `path` and that segment, or null if a parent is missing.
+        inline std::pair<toml::table*, std::string_view> subtree_parent(toml::table& root, std::string_view path, const bool create) {
+            toml::table* parent = &root;
+            for (std::size_t dot = path.find('.'); dot != std::string_view::npos; dot = path.find('.')) {
+                const std::string_view segment = path.substr(0, dot);
+                toml::node* node = parent->get(segment);
+                if (node == nullptr || !node->is_table()) {
+                    if (!create) return {nullptr, {}};
+                    node = &parent->insert_or_assign(segment, toml::table{}).first->second;
+                }
+                parent = node->as_table();
+                path.remove_prefix(dot + 1);
+            }
+            return {parent, path};
+        }
+    }
+
+    /**
+     * @brief Moves the value at the dotted `path` of `from` into `to`, creating its parent tables there.
+     *
+     * The value replaces whatever `to` holds at `path`. Nothing happens if `from` has no value there.
+     */
+    inline void move_subtree(toml::table& from, toml::table& to, const std::string_view path) {
+        const auto [source, key] = detail::subtree_parent(from, path, false);
+        toml::node* node = source != nullptr ? source->get(key) : nullptr;
+        if (node == nullptr) return;
+        toml::table* target = detail::subtree_parent(to, path, true).first;
+        node->visit([&](auto& concrete) { target->insert_or_assign(key, std::move(concrete)); });
+        source->erase(key);
+    }
+
+    /**
+     * @brief Removes the value at the dotted `path` of `root`, if there is one.
+     */
+    inline void erase_subtree(toml::table& root, const std::string_view path) {
+        const auto [parent, key] = detail::subtree_parent(root, path, false);
+        if (parent != nullptr) parent->erase(key);
+    }
+
+    /**
+     * @brief Lists the fragments of a drop-in directory (`conf.d`), sorted by file name.
+     *
+     * Regular files ending in `.toml`, `.toml.zst` or `.toml.gz` are taken; hidden files and
+     * subdirectories are not.
+     *
+     * @throws exceptions::ConfigLoadError If the directory cannot be listed.
+     */
+    inline std::vector<std::string> list_fragments(const std::string_view directory) {
+        std::vector<std::string> fragments;
+        std::error_code ec;
+        for (std::filesystem::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+            if (!it->is_regular_file(ec)) continue;
+            const std::string name = it->path().filename().string();
+            if (name.starts_with('.')) continue;
+            if (name.ends_with(".toml") || name.ends_with(".toml.zst") || name.ends_with(".toml.gz")) {
+                fragments.push_back(it->path().string());
+            }
+        }
+        if (ec) {
+            throw exceptions::ConfigLoadError(std::format("Unable to list the config fragments in {}: {}", directory, ec.message()));
+        }
+        std::ranges::sort(fragments);
+        return fragments;
+    }
+
+    /**
+     * @brief Process-wide cache of parsed TOML fragments.
+     *
+     * An entry is reused while the file's modification time and size are unchanged (see
+     * `StampedFileCache`). All member functions are thread-safe; parsing happens outside the lock.
+     */
+    class FragmentCache {
+    public:
+        /**
+         * @brief Returns the process-wide cache.
+         */
+        static FragmentCache& instance() {
+            static FragmentCache cache;
+            return cache;
+        }
+
+        /**
+         * @brief Returns the parsed fragment at `path`, parsing it if it is not cached or has changed.
+         * @param path The fragment file.
+         * @return The parsed fragment; shared and immutable.
+         * @throws exceptions::ConfigLoadError If the file does not exist.
+         * @throws exceptions::ConfigParseError If the file is not valid TOML.
+         */
+        std::shared_ptr<const toml::table> get(const std::filesystem::path& path) {
+            return m_files.get(path, [](const std::filesystem::path& canonical) {
+                const std::string file = canonical.string();
+                try {
+                    return std::make_shared<const toml::table>(toml::parse_file(file));
+                } catch (const toml::parse_error& e) {
+                    throw syntax_error(e, "included config fragment", file);
+                }
+            });
+        }
+
+        /**
+         * @brief Drops all cached fragments.
+         */
+        void clear() { m_files.clear(); }
+
+        /**
+         * @brief Returns the number of cached fragments.
+         */
+        [[nodiscard]] std::size_t size() const { return m_files.size(); }
+
+    private:
+        StampedFileCache<toml::table> m_files{"Included config fragment"};
+    };
+
+    namespace detail {
+        inline void resolve_includes(toml::table& tbl, const std::filesystem::path& dir, std::vector<std::string>& stack);
+
+        inline void resolve_children(toml::table& tbl, const std::filesystem::path& dir, std::vector<std::string>& stack) {
+            for (auto&& [key, node] : tbl) {
+                if (node.is_table()) {
+                    resolve_includes(*node.as_table(), dir, stack);
+                } else if (node.is_array()) {
+                    for (auto& element : *node.as_array()) {
+                        if (element.is_table()) {
+                            resolve_includes(*element.as_table(), dir, stack);
+                        }
+                    }
+                }
+            }
+        }
+
+        inline void resolve_includes(toml::table& tbl, const std::filesystem::path& dir, std::vector<std::string>& stack) {
+            resolve_children(tbl, dir, stack);
+
+            const toml::node* directive = tbl.get(include_key);
+            if (directive == nullptr) return;
+
+            std::vector<std::string> includes;
+            if (directive->is_string()) {
+                includes.push_back(directive->as_string()->get());
+            } else if (directive->is_array() && (directive->as_array()->empty() ||
+                                                  directive->as_array()->is_homogeneous(toml::node_type::string))) {
+                for (const auto& element : *directive->as_array()) {
+                    includes.push_back(element.as_string()->get());
+                }
+            } else {
+                throw exceptions::ConfigParseError(
+                    std::format("'{}' must be a string or an array of strings.", include_key));
+            }
+            tbl.erase(include_key);
+
+            toml::table combined;
+            for (const auto& include : includes) {
+                const std::filesystem::path fragment_path = dir / include;
+                std::shared_ptr<const toml::table> cached = FragmentCache::instance().get(fragment_path);
+
+                const std::string canonical = std::filesystem::canonical(fragment_path).string();
+                if (std::ranges::find(stack, canonical) != stack.end()) {
+                    throw exceptions::ConfigLoadError(
+                        std::format("Config fragment includes itself: {}", canonical));
+                }
+
+                toml::table fragment = *cached;
+                stack.push_back(canonical);
+                resolve_includes(fragment, std::filesystem::path(canonical).parent_path(), stack);
+                stack.pop_back();
+                merge_tables(combined, fragment);
+            }
+            merge_tables(combined, tbl);
+            tbl = std::move(combined);
+        }
+    }
+
+    /**
+     * @brief Replaces every `__include` directive in `tbl` by the contents of the named fragments.
+     * @param tbl A table parsed from `source_path`.
+     * @param source_path The file `tbl` was parsed from; include paths are relative to its directory.
+     * @throws exceptions::ConfigLoadError If a fragment does not exist or includes itself.
+     * @throws exceptions::ConfigParseError If a fragment is not valid TOML or a directive is malformed.
+     */
+    inline void resolve_includes(toml::table& tbl, const std::string_view source_path) {
+        std::vector<std::string> stack;
+        std::error_code ec;
+        const std::filesystem::path source = std::filesystem::canonical(std::filesystem::path(source_path), ec);
+        if (!ec) stack.push_back(source.string());
+        detail::resolve_includes(tbl, std::filesystem::path(source_path).parent_path(), stack);
+    }
+
+    /**
+     * @brief Parses a TOML file, decompressing it first if its path names a compression (see `compress.h`).
+     * @throws toml::parse_error If the content is not valid TOML.
+     * @throws exceptions::ConfigLoadError If a compressed file cannot be decompressed.
+     */
+    inline toml::table parse_toml_file(const std::string_view path) {
+        const Compression compression = compression_for(path);
+        if (compression == Compression::NONE) {
+            return toml::parse_file(std::string(path));
+        }
+        return toml::parse(read_compressed(std::string(path), compression), path);
+    }
+
+    /**
+     * @brief Parses a TOML file and resolves its `__include` directives.
+     * @param path The file to read; it may be compressed.
+     * @return The parsed document.
+     * @throws exceptions::ConfigLoadError If the file or a fragment does not exist.
+     * @throws exceptions::ConfigParseError If the file or a fragment is not valid TOML.
+     */
+    inline toml::table parse_document(const std::string_view path) {
+        if (!std::filesystem::exists(path)) {
+            throw exceptions::ConfigLoadError(
+                std::format("Config file does not exist: {}", path));
+        }
+        toml::table document;
+        try {
+            document = parse_toml_file(path);
+        } catch (const toml::parse_error& e) {
+            throw syntax_error(e, "TOML file", path);
+        }
+        resolve_includes(document, path);
+        return document;
+    }
+}
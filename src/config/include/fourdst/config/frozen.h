@@ -0,0 +1,147 @@
+/**
+ * @file frozen.h
+ * @brief Immutable configs for code that only reads them after startup.
+ *
+ * `Config<T>` is built for concurrent change: writers serialize on a mutex, readers take RCU
+ * snapshots (`snapshot()`, `ConfigReader`, `pin()`) or a seqlock copy. Most configs, though, stop
+ * changing once the run is set up, and then every one of those mechanisms is overhead.
+ * `Config::freeze()` turns a config into a `FrozenConfig<T>`: the content as a plain member, with
+ * no mutex, no atomics and no heap block beside it, so reads are ordinary member accesses and are
+ * safe from any number of threads because nothing can write:
+ *
+ * @code
+ * fourdst::config::Config<Schema> cfg;
+ * cfg.load("run.toml");
+ * const fourdst::config::FrozenConfig<Schema> frozen = std::move(cfg).freeze();
+ *
+ * #pragma omp parallel for
+ * for (std::size_t i = 0; i < n; ++i) step(i, frozen->simulation.time_step);
+ * @endcode
+ *
+ * A frozen config has no `mutate()`, `set()`, `load()` or `reload()`; calling one is a compile
+ * error, not a runtime check. `thaw()` returns a new `Config<T>` holding the content when a frozen
+ * config must change after all.
+ *
+ * The three threading models thus map to: `FrozenConfig` (no synchronization, read-only),
+ * `Config` with `mutate()` (writers behind a mutex) and `Config::snapshot()` or `ConfigReader`
+ * (lock-free RCU reads of a config that keeps changing).
+ */
+#pragma once
+
+#include <cstdint>
+#include <format>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/fwd.h"
+#include "fourdst/config/path_table.h"
+#include "fourdst/config/provenance.h"
+
+#include "rfl.hpp"
+
+namespace fourdst::config {
+
+    /**
+     * @brief The content of a config, frozen: read-only and free of synchronization.
+     *
+     * Obtained from `Config::freeze()`. Copyable and movable like the schema itself.
+     *
+     * @tparam T The configuration schema type.
+     */
+    template <IsConfigSchema T>
+    class FrozenConfig {
+    public:
+        /**
+         * @brief Freezes the default content of `T`.
+         */
+        FrozenConfig() = default;
+
+        /**
+         * @brief Freezes `content` under `root_name`.
+         * @param content The content.
+         * @param root_name The root table name the content is saved under after `thaw()`.
+         * @param generation The generation of the config the content was taken from; see `generation()`.
+         */
+        explicit FrozenConfig(T content, std::string root_name = "main", const std::uint64_t generation = 0)
+            : m_content(std::move(content)), m_root_name(std::move(root_name)), m_generation(generation) {}
+
+        /**
+         * @brief Access member of the frozen content.
+         */
+        const T* operator->() const noexcept { return &m_content; }
+
+        /**
+         * @brief Dereference operator to access the frozen content.
+         */
+        const T& operator*() const noexcept { return m_content; }
+
+        /**
+         * @brief Explicit accessor for the frozen content.
+         */
+        const T& main() const noexcept { return m_content; }
+
+        /**
+         * @brief Reads a field by a dotted path fixed at compile time; see `Config::get<Path>()`.
+         */
+        template <rfl::internal::StringLiteral Path>
+        [[nodiscard]] const auto& get() const noexcept {
+            constexpr detail::FieldRange field = detail::find_field<T>(Path.string_view());
+            static_assert(field.count != 0, "No field at this path in the configuration schema.");
+            return detail::field_at<field.ordinal>(m_content);
+        }
+
+        /**
+         * @brief Reads a field by its dotted path; see `Config::get()`.
+         * @throws exceptions::ConfigPathError If `path` does not name a field, or the field is not a `V`.
+         */
+        template <typename V>
+        [[nodiscard]] const V& get(const std::string_view path) const {
+            using Table = detail::PathTable<T>;
+            const std::size_t index = Table::find(path);
+            if (index == Table::npos) {
+                throw exceptions::ConfigPathError(std::format("No field at path '{}' in the configuration schema.", path));
+            }
+            if (Table::entry(index).type != detail::path_type_id<V>()) {
+                throw exceptions::ConfigPathError(std::format("Field at path '{}' is not of the requested type.", path));
+            }
+            return *static_cast<const V*>(Table::entry(index).address(m_content));
+        }
+
+        /**
+         * @brief Gets the root table name of the config the content was frozen from.
+         */
+        [[nodiscard]] std::string_view get_root_name() const noexcept { return m_root_name; }
+
+        /**
+         * @brief Gets the generation of the config when it was frozen (see `Config::generation()`).
+         */
+        [[nodiscard]] std::uint64_t generation() const noexcept { return m_generation; }
+
+        /**
+         * @brief Returns a new, mutable config holding the frozen content under the same root name.
+         *
+         * The content becomes the defaults of the new config, the baseline `reset()` returns to.
+         */
+        [[nodiscard]] Config<T> thaw() const& {
+            Config<T> config(m_content);
+            config.set_root_name(m_root_name);
+            return config;
+        }
+
+        /**
+         * @brief Returns a new, mutable config, moving the frozen content into it; see `thaw() const&`.
+         */
+        [[nodiscard]] Config<T> thaw() && {
+            Config<T> config(std::move(m_content));
+            config.set_root_name(m_root_name);
+            return config;
+        }
+
+    private:
+        T m_content{};
+        std::string m_root_name = "main";
+        std::uint64_t m_generation = 0;
+    };
+}
@@ -0,0 +1,228 @@
+/**
+ * @file fwd.h
+ * @brief Forward declarations of the configuration library, without any parser or serializer.
+ *
+ * Declares the `IsConfigSchema` concept, the policy enums and `Config<T>` itself, so headers that
+ * only pass configs around (or hold a `ConfigReader`, see `reader.h`) do not pull in reflect-cpp,
+ * toml++ or yyjson. The definition of `Config<T>` and its file I/O live in `base.h`.
+ */
+#pragma once
+
+#include <concepts>
+#include <string>
+#include <type_traits>
+
+namespace fourdst::config {
+
+    /**
+     * @brief Concept ensuring a type is suitable for configuration schema.
+     *
+     * A valid configuration schema must be:
+     * - A class or struct (`std::is_class_v`)
+     * - An aggregate type (`std::is_aggregate_v`), i.e., strict POD-like structure without user-declared constructors.
+     * - Not a `std::string`.
+     *
+     * @tparam T The type to check.
+     */
+    template <typename T>
+    concept IsConfigSchema =
+        std::is_class_v<std::decay_t<T>> &&          // Must be a class/struct
+        std::is_aggregate_v<std::decay_t<T>> &&      // Must be an aggregate (POD-like)
+        !std::same_as<std::decay_t<T>, std::string>; // Explicitly exclude strings
+
+    /**
+     * @brief Policies for handling the root name during configuration loading.
+     */
+    enum class RootNameLoadPolicy {
+        /**
+         * @brief Updates the internal root name to match what is found in the file.
+         */
+        FROM_FILE,
+        /**
+         * @brief Enforces the current internal root name; loading fails if the file's root name differs.
+         */
+        KEEP_CURRENT
+    };
+
+    /**
+     * @brief Policies for how configuration files are read from disk during loading.
+     */
+    enum class FileReadPolicy {
+        /**
+         * @brief Reads the file through toml++'s own buffered file input.
+         */
+        BUFFERED,
+        /**
+         * @brief Memory-maps the file and parses directly from the mapping, avoiding a buffer copy.
+         */
+        MEMORY_MAP,
+        /**
+         * @brief Sizes a buffer with `fstat` and reads the whole file in large reads, with sequential read-ahead hints.
+         */
+        SINGLE_READ,
+        /**
+         * @brief Like SINGLE_READ into a page-aligned buffer with `O_DIRECT`, bypassing the page cache where supported.
+         */
+        DIRECT,
+        /**
+         * @brief Parses TOML in chunks straight into the schema, without building a document (see `toml_stream.h`).
+         *
+         * Files this reader cannot handle alone are read as under MEMORY_MAP.
+         */
+        STREAMING
+    };
+
+    /**
+     * @brief Policies for using a binary cache file next to the TOML source during loading.
+     */
+    enum class CachePolicy {
+        /**
+         * @brief Always parses the TOML file; no cache is read or written.
+         */
+        DISABLED,
+        /**
+         * @brief Uses a matching cache if present, and writes a fresh one after parsing.
+         */
+        READ_WRITE,
+        /**
+         * @brief Uses a matching cache if present, but never writes one.
+         */
+        READ_ONLY
+    };
+
+    /**
+     * @brief File formats `Config::load()` and `Config::save()` can read and write.
+     */
+    enum class FileFormat {
+        /**
+         * @brief Chooses by file extension: `.json` (any case) is JSON, `.nml` and extensionless `inlist*` files are namelists, anything else is TOML.
+         */
+        AUTO,
+        /**
+         * @brief Always reads and writes TOML.
+         */
+        TOML,
+        /**
+         * @brief Always reads and writes JSON, with the same `{"<root>": {...}}` layout as TOML.
+         */
+        JSON,
+        /**
+         * @brief Reads Fortran namelist groups as the top-level fields of the schema (see namelist.h); cannot be saved.
+         */
+        NAMELIST
+    };
+
+    /**
+     * @brief Policies for how `Config::save()` writes the target file.
+     */
+    enum class SavePolicy {
+        /**
+         * @brief Truncates and rewrites the target file in place.
+         */
+        IN_PLACE,
+        /**
+         * @brief Writes a sibling temporary file and renames it over the target, so readers never see a partial file.
+         */
+        ATOMIC,
+        /**
+         * @brief Like ATOMIC, and also syncs the file and its directory to storage so the result survives a crash.
+         */
+        DURABLE
+    };
+
+    /**
+     * @brief Which fields `Config::save()` writes.
+     */
+    enum class SaveMode {
+        /**
+         * @brief Writes every field.
+         */
+        FULL,
+        /**
+         * @brief Writes only the fields that differ from a default-constructed schema (TOML only).
+         */
+        NON_DEFAULT_ONLY,
+        /**
+         * @brief Writes a merge patch of the fields changed since the last load; see `Config::save_patch()`.
+         */
+        CHANGES_SINCE_LOAD
+    };
+
+    /**
+     * @brief Policies for fields a loaded TOML file does not contain.
+     */
+    enum class MissingFieldPolicy {
+        /**
+         * @brief A missing required field fails the load.
+         */
+        REJECT,
+        /**
+         * @brief A missing field takes its value from a default-constructed schema.
+         */
+        USE_DEFAULTS
+    };
+
+    /**
+     * @brief Policies for keys of a loaded TOML file that name no field of the schema.
+     */
+    enum class UnknownKeyPolicy {
+        /**
+         * @brief Unknown keys are ignored when the rest of the file is valid.
+         */
+        ALLOW,
+        /**
+         * @brief Any unknown key fails the load; each is reported with the nearest field name.
+         */
+        REJECT
+    };
+
+    /**
+     * @brief Policies for keys of a loaded TOML file that are old names of renamed fields (see aliases.h).
+     */
+    enum class DeprecatedKeyPolicy {
+        /**
+         * @brief Old names are read silently; the keys are not walked.
+         */
+        ALLOW,
+        /**
+         * @brief Old names are read, and each is reported to stderr with its new path.
+         */
+        WARN,
+        /**
+         * @brief Any old name fails the load; each is reported with its new path.
+         */
+        REJECT
+    };
+
+    /**
+     * @brief Represents the current state of a Config object.
+     */
+    enum class ConfigState {
+        /**
+         * @brief Configuration contains default values and has not been loaded from a file.
+         */
+        DEFAULT,
+        /**
+         * @brief Configuration has been successfully populated from a file.
+         */
+        LOADED_FROM_FILE,
+
+        MODIFIED,
+        /**
+         * @brief A `load_async()` is in progress; snapshots still hold the previous content.
+         */
+        LOADING
+    };
+
+    template <IsConfigSchema T>
+    class Config;
+
+    template <IsConfigSchema T>
+    class ConfigReader;
+
+    template <IsConfigSchema T>
+    class FrozenConfig;
+
+    template <typename U>
+    class ConfigRef;
+}
@@ -0,0 +1,198 @@
+/**
+ * @file generate.h
+ * @brief Random, schema-valid configuration content for benchmarking and profiling at scale.
+ *
+ * `generate<T>()` walks the schema by reflection and fills every field with a random value of
+ * its type; `generate_toml<T>()` writes the result with the same writer `Config::save()` uses,
+ * so the text always loads back into `Config<T>`. The sizes of the generated deck are set by
+ * `GenerateOptions`: vectors of scalars get `array_length` elements, vectors of tables (and
+ * `SoA` fields) get `table_array_count` rows, strings get `string_length` characters.
+ *
+ * @code
+ * fourdst::config::GenerateOptions options;
+ * options.table_array_count = 100'000;
+ * std::ofstream("deck.toml") << fourdst::config::generate_toml<RunConfig>(options);
+ * @endcode
+ *
+ * Generation is deterministic for a given seed and schema. Fixed-size arrays keep their length,
+ * `std::string_view` fields keep their default (their storage belongs to a loaded config), and
+ * values are only constrained by their C++ type, not by any range a program checks after loading.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/base.h"
+#include "fourdst/config/lazy.h"
+#include "fourdst/config/path_table.h"
+#include "fourdst/config/soa.h"
+#include "fourdst/config/tensor.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+
+namespace fourdst::config {
+
+    /**
+     * @brief Size knobs and seed for `generate()`.
+     */
+    struct GenerateOptions {
+        /// Seed of the random engine; the same seed and schema give the same content.
+        std::uint64_t seed = 0x4d535441;
+        /// Elements of every vector of scalars or strings.
+        std::size_t array_length = 16;
+        /// Rows of every vector of tables and every `SoA` field.
+        std::size_t table_array_count = 8;
+        /// Characters of every string value, and of every map key.
+        std::size_t string_length = 12;
+        /// Entries of every map.
+        std::size_t map_size = 4;
+        /// Extent of every dimension of a `Tensor` field.
+        std::size_t tensor_extent = 4;
+        /// Probability that an optional field holds a value.
+        double optional_probability = 0.5;
+    };
+
+    namespace detail {
+        /**
+         * @brief Fills values of any schema type from one random engine.
+         */
+        class Generator {
+        public:
+            explicit Generator(const GenerateOptions& options) : m_options(options), m_engine(options.seed) {}
+
+            template <typename V>
+            V make() {
+                using Type = std::remove_cvref_t<V>;
+                if constexpr (std::is_same_v<Type, bool>) {
+                    return std::bernoulli_distribution(0.5)(m_engine);
+                } else if constexpr (std::is_integral_v<Type>) {
+                    // Stay within what a TOML integer (int64) holds and what a human would type.
+                    constexpr auto max = std::numeric_limits<Type>::max();
+                    constexpr long long upper = std::cmp_less(max, 1'000'000) ? static_cast<long long>(max) : 1'000'000;
+                    constexpr long long lower = std::is_signed_v<Type> ? -upper : 0;
+                    return static_cast<Type>(std::uniform_int_distribution<long long>(lower, upper)(m_engine));
+                } else if constexpr (std::is_floating_point_v<Type>) {
+                    return static_cast<Type>(std::uniform_real_distribution<double>(-1.0e3, 1.0e3)(m_engine));
+                } else if constexpr (std::is_enum_v<Type>) {
+                    constexpr auto enumerators = rfl::get_enumerator_array<Type>();
+                    std::uniform_int_distribution<std::size_t> pick(0, enumerators.size() - 1);
+                    return enumerators[pick(m_engine)].second;
+                } else if constexpr (validate::is_std_string_v<Type>) {
+                    return make_string<Type>();
+                } else if constexpr (std::is_same_v<Type, std::string_view>) {
+                    return Type{};
+                } else if constexpr (validate::is_optional_v<Type>) {
+                    if (!std::bernoulli_distribution(m_options.optional_probability)(m_engine)) return Type{};
+                    return Type(make<typename Type::value_type>());
+                } else if constexpr (validate::is_lazy_v<Type> || validate::is_tunable_v<Type>) {
+                    return Type(make<typename Type::value_type>());
+                } else if constexpr (validate::is_sharded_v<Type>) {
+                    return Type(make<typename Type::map_type>());
+                } else if constexpr (validate::is_section_v<Type>) {
+                    // A random path would name no file.
+                    return Type{};
+                } else if constexpr (validate::is_quantity_v<Type>) {
+                    return Type(make<double>());
+                } else if constexpr (validate::is_stored_v<Type>) {
+                    return Type(make<typename Type::value_type>());
+                } else if constexpr (validate::is_tagged_union_v<Type>) {
+                    // The first alternative, so the discriminator is always a known tag.
+                    using First = std::remove_cvref_t<decltype(rfl::get<0>(std::declval<const Type&>().variant()))>;
+                    return Type(make<First>());
+                } else if constexpr (validate::is_soa_v<Type>) {
+                    Type soa;
+                    for (std::size_t i = 0; i < m_options.table_array_count; ++i) soa.push_back(make<typename Type::value_type>());
+                    return soa;
+                } else if constexpr (validate::is_tensor_v<Type>) {
+                    typename Type::extents_type extents;
+                    extents.fill(m_options.tensor_extent);
+                    Type tensor(extents);
+                    for (std::size_t i = 0; i < tensor.size(); ++i) tensor.data()[i] = make<typename Type::value_type>();
+                    return tensor;
+                } else if constexpr (validate::is_vector_v<Type>) {
+                    using Element = typename Type::value_type;
+                    const std::size_t length = is_path_struct_v<Element> ? m_options.table_array_count : m_options.array_length;
+                    Type values;
+                    values.reserve(length);
+                    for (std::size_t i = 0; i < length; ++i) values.push_back(make<Element>());
+                    return values;
+                } else if constexpr (is_std_array_v<Type>) {
+                    Type values{};
+                    for (auto& element : values) element = make<typename Type::value_type>();
+                    return values;
+                } else if constexpr (validate::is_map_v<Type>) {
+                    using Key = typename Type::key_type;
+                    Type map;
+                    for (std::size_t i = 0; map.size() < m_options.map_size && i < 4 * m_options.map_size; ++i) {
+                        if constexpr (std::is_integral_v<Key>) {
+                            map.emplace(static_cast<Key>(i), make<typename Type::mapped_type>());
+                        } else {
+                            // Keys start with a letter so they stay bare keys in TOML.
+                            map.emplace(make_string<Key>(), make<typename Type::mapped_type>());
+                        }
+                    }
+                    return map;
+                } else if constexpr (validate::is_reflectable_struct_v<Type>) {
+                    Type value{};
+                    auto view = rfl::to_view(value);
+                    using Fields = typename rfl::named_tuple_t<Type>::Fields;
+                    [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                        ((*rfl::get<Is>(view.values()) = make<std::remove_cvref_t<decltype(*rfl::get<Is>(view.values()))>>()), ...);
+                    }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+                    return value;
+                } else {
+                    return Type{};
+                }
+            }
+
+        private:
+            template <typename S>
+            S make_string() {
+                static constexpr std::string_view alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
+                std::uniform_int_distribution<std::size_t> letter(0, 51);
+                std::uniform_int_distribution<std::size_t> any(0, alphabet.size() - 1);
+                S text;
+                text.reserve(m_options.string_length);
+                for (std::size_t i = 0; i < m_options.string_length; ++i) text.push_back(alphabet[i == 0 ? letter(m_engine) : any(m_engine)]);
+                return text;
+            }
+
+            const GenerateOptions& m_options;
+            std::mt19937_64 m_engine;
+        };
+    }
+
+    /**
+     * @brief Returns an instance of `T` with every field set to a random value.
+     * @param options Seed and sizes of the generated content.
+     */
+    template <typename T>
+    T generate(const GenerateOptions& options = {}) {
+        detail::Generator generator(options);
+        return generator.make<T>();
+    }
+
+    /**
+     * @brief Returns a random TOML configuration file for `T` that `Config<T>::load()` accepts.
+     * @param options Seed and sizes of the generated content.
+     * @param root_name The root table to write the content under.
+     */
+    template <IsConfigSchema T>
+    std::string generate_toml(const GenerateOptions& options = {}, const std::string_view root_name = "main") {
+        Config<T> cfg(generate<T>(options));
+        cfg.set_root_name(root_name);
+        cfg.set_file_format(FileFormat::TOML);
+        std::string text;
+        cfg.save_to(text);
+        return text;
+    }
+}
@@ -0,0 +1,93 @@
+/**
+ * @file hash.h
+ * @brief Reflection-generated equality and hashing of schema instances, and functors for hash maps.
+ *
+ * Schemas are plain aggregates and rarely define `operator==` or a `std::hash` specialization.
+ * `equal()` and `hash()` are generated from the schema instead, by the same walks that change
+ * notifications (`compare.h`) and cache fingerprints (`fingerprint.h`) use:
+ *
+ * - `equal()` stops at the first differing field, and compares vectors, arrays and tensors of
+ *   numbers as one block of memory;
+ * - `hash()` agrees with `equal()`: equal instances hash alike, including `0.0` and `-0.0`.
+ *
+ * `ContentHash<T>` and `ContentEqual<T>` wrap them as functors for `std::unordered_map` and
+ * `std::unordered_set`, keyed either by `T` or by snapshots (`std::shared_ptr<const T>`), and
+ * are transparent, so a map keyed by snapshots can be searched with a plain `T`:
+ *
+ * @code
+ * using Key = std::shared_ptr<const RunConfig>;
+ * std::unordered_map<Key, Result, ContentHash<RunConfig>, ContentEqual<RunConfig>> results;
+ * results.emplace(cfg.snapshot(), run(*cfg.snapshot()));
+ * if (const auto it = results.find(candidate); it != results.end()) reuse(it->second);
+ * @endcode
+ *
+ * The hash uses native byte order and is meant for in-process containers, not as a portable
+ * identifier.
+ */
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "fourdst/config/compare.h"
+#include "fourdst/config/fingerprint.h"
+#include "fourdst/config/fwd.h"
+
+namespace fourdst::config {
+
+    /**
+     * @brief Compares two instances of a schema field by field.
+     * @return True if every field is equal; see `detail::equal()` for how each type compares.
+     */
+    template <IsConfigSchema T>
+    bool equal(const T& lhs, const T& rhs) {
+        return detail::equal(lhs, rhs);
+    }
+
+    /**
+     * @brief Hashes the field values of an instance of a schema.
+     * @return A hash that is equal for instances that `equal()` finds equal.
+     */
+    template <IsConfigSchema T>
+    std::size_t hash(const T& content) {
+        io::ContentHasher hasher;
+        hasher.add(content);
+        return static_cast<std::size_t>(hasher.value());
+    }
+
+    /**
+     * @brief Hash functor over instances and snapshots of `T`, by content.
+     *
+     * A null snapshot hashes to 0.
+     */
+    template <IsConfigSchema T>
+    struct ContentHash {
+        using is_transparent = void;
+
+        std::size_t operator()(const T& content) const { return config::hash(content); }
+
+        std::size_t operator()(const std::shared_ptr<const T>& snapshot) const { return snapshot ? config::hash(*snapshot) : 0; }
+    };
+
+    /**
+     * @brief Equality functor over instances and snapshots of `T`, by content.
+     *
+     * Two snapshots of the same object compare equal without visiting any field; a null snapshot
+     * only equals another null snapshot.
+     */
+    template <IsConfigSchema T>
+    struct ContentEqual {
+        using is_transparent = void;
+
+        bool operator()(const T& lhs, const T& rhs) const { return &lhs == &rhs || config::equal(lhs, rhs); }
+
+        bool operator()(const std::shared_ptr<const T>& lhs, const std::shared_ptr<const T>& rhs) const {
+            if (lhs == rhs) return true;
+            return lhs && rhs && config::equal(*lhs, *rhs);
+        }
+
+        bool operator()(const std::shared_ptr<const T>& lhs, const T& rhs) const { return lhs && (*this)(*lhs, rhs); }
+
+        bool operator()(const T& lhs, const std::shared_ptr<const T>& rhs) const { return rhs && (*this)(lhs, *rhs); }
+    };
+}
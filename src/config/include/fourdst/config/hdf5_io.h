@@ -0,0 +1,382 @@
+/**
+ * @file hdf5_io.h
+ * @brief Native HDF5 group export and import of configuration structures.
+ *
+ * `write_hdf5_group()` writes a schema as a group hierarchy that mirrors its nesting:
+ *
+ * - nested structs become subgroups;
+ * - arithmetic values and enums (by name) become scalar attributes, strings become string
+ *   attributes;
+ * - `std::vector`s and `std::array`s of arithmetic values become one-dimensional datasets,
+ *   chunked and (when the deflate filter is available) shuffled and compressed;
+ * - optionals are written as their value when present and omitted otherwise;
+ * - any other value (maps, vectors of strings, structs or vectors, ...) becomes a string
+ *   attribute holding its JSON form.
+ *
+ * `read_hdf5_group()` reads such a group back; numeric values are converted by HDF5, so a field
+ * may be read from any numeric attribute or dataset type. Strings may be fixed-length or
+ * variable-length. Strings above `hdf5_attribute_limit` bytes are stored as scalar datasets,
+ * since object headers cannot hold large attributes.
+ *
+ * Only available when built with HDF5 support (the `use_hdf5` meson option).
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/compare.h"
+#include "fourdst/config/enum_index.h"
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/path_table.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+#include "rfl/json.hpp"
+
+#include <hdf5.h>
+
+namespace fourdst::config::io {
+
+    /**
+     * @brief Options for `write_hdf5_group()`.
+     */
+    struct Hdf5WriteOptions {
+        /// Deflate level (0-9) of array datasets; 0 disables compression.
+        unsigned compression = 4;
+        /// Maximum number of elements per dataset chunk.
+        hsize_t chunk_elements = 64 * 1024;
+    };
+
+    /// Strings longer than this many bytes are written as datasets instead of attributes.
+    constexpr std::size_t hdf5_attribute_limit = 32 * 1024;
+
+    namespace detail {
+        /**
+         * @brief Owns an HDF5 identifier and closes it with the matching `H5?close` function.
+         */
+        class H5Handle {
+        public:
+            H5Handle(const hid_t id, herr_t (*close)(hid_t)) : m_id(id), m_close(close) {}
+            H5Handle(const H5Handle&) = delete;
+            H5Handle& operator=(const H5Handle&) = delete;
+            ~H5Handle() {
+                if (m_id >= 0) m_close(m_id);
+            }
+
+            [[nodiscard]] hid_t get() const { return m_id; }
+            [[nodiscard]] bool valid() const { return m_id >= 0; }
+
+        private:
+            hid_t m_id;
+            herr_t (*m_close)(hid_t);
+        };
+
+        template <typename Type>
+        constexpr bool is_h5_array_v = [] {
+            if constexpr (validate::is_vector_v<Type> || config::detail::is_std_array_v<Type>) {
+                using Element = typename Type::value_type;
+                return std::is_arithmetic_v<Element> && !std::is_same_v<Element, bool>;
+            } else {
+                return false;
+            }
+        }();
+
+        template <typename E>
+        hid_t h5_native_type() {
+            if constexpr (std::is_same_v<E, bool>) {
+                return H5T_NATIVE_INT8;
+            } else if constexpr (std::is_same_v<E, float>) {
+                return H5T_NATIVE_FLOAT;
+            } else if constexpr (std::is_same_v<E, double>) {
+                return H5T_NATIVE_DOUBLE;
+            } else if constexpr (std::is_same_v<E, long double>) {
+                return H5T_NATIVE_LDOUBLE;
+            } else if constexpr (sizeof(E) == 1) {
+                return std::is_signed_v<E> ? H5T_NATIVE_INT8 : H5T_NATIVE_UINT8;
+            } else if constexpr (sizeof(E) == 2) {
+                return std::is_signed_v<E> ? H5T_NATIVE_INT16 : H5T_NATIVE_UINT16;
+            } else if constexpr (sizeof(E) == 4) {
+                return std::is_signed_v<E> ? H5T_NATIVE_INT32 : H5T_NATIVE_UINT32;
+            } else {
+                static_assert(sizeof(E) == 8, "Unsupported integer width for HDF5 export.");
+                return std::is_signed_v<E> ? H5T_NATIVE_INT64 : H5T_NATIVE_UINT64;
+            }
+        }
+
+        inline std::string h5_join(const std::string_view prefix, const std::string_view key) {
+            return prefix.empty() ? std::string(key) : std::format("{}/{}", prefix, key);
+        }
+
+        [[noreturn]] inline void throw_h5_write(const std::string_view path) {
+            throw exceptions::ConfigSaveError(std::format("Failed to write config field '{}' to HDF5.", path));
+        }
+
+        [[noreturn]] inline void throw_h5_read(const std::string_view path, const std::string_view reason) {
+            throw exceptions::ConfigParseError(std::format("Failed to read config field '{}' from HDF5. Reason: {}", path, reason));
+        }
+
+        /**
+         * @brief Whether `loc` has an attribute or a link called `name`.
+         */
+        inline bool h5_has(const hid_t loc, const std::string& name) {
+            return H5Aexists(loc, name.c_str()) > 0 || H5Lexists(loc, name.c_str(), H5P_DEFAULT) > 0;
+        }
+
+        template <typename E>
+        void write_h5_scalar(const hid_t loc, const std::string& name, const E& value, const std::string_view path) {
+            const H5Handle space(H5Screate(H5S_SCALAR), H5Sclose);
+            const H5Handle attr(H5Acreate2(loc, name.c_str(), h5_native_type<E>(), space.get(), H5P_DEFAULT, H5P_DEFAULT), H5Aclose);
+            if constexpr (std::is_same_v<E, bool>) {
+                const std::int8_t flag = value ? 1 : 0;
+                if (!attr.valid() || H5Awrite(attr.get(), h5_native_type<E>(), &flag) < 0) throw_h5_write(path);
+            } else {
+                if (!attr.valid() || H5Awrite(attr.get(), h5_native_type<E>(), &value) < 0) throw_h5_write(path);
+            }
+        }
+
+        inline void write_h5_string(const hid_t loc, const std::string& name, const std::string_view value, const std::string_view path) {
+            const H5Handle type(H5Tcopy(H5T_C_S1), H5Tclose);
+            H5Tset_size(type.get(), std::max<std::size_t>(value.size(), 1));
+            H5Tset_strpad(type.get(), H5T_STR_NULLPAD);
+            H5Tset_cset(type.get(), H5T_CSET_UTF8);
+            const std::string buffer(value.empty() ? std::string(1, '\0') : std::string(value));
+            const H5Handle space(H5Screate(H5S_SCALAR), H5Sclose);
+            if (value.size() <= hdf5_attribute_limit) {
+                const H5Handle attr(H5Acreate2(loc, name.c_str(), type.get(), space.get(), H5P_DEFAULT, H5P_DEFAULT), H5Aclose);
+                if (!attr.valid() || H5Awrite(attr.get(), type.get(), buffer.data()) < 0) throw_h5_write(path);
+            } else {
+                const H5Handle dataset(H5Dcreate2(loc, name.c_str(), type.get(), space.get(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT), H5Dclose);
+                if (!dataset.valid() || H5Dwrite(dataset.get(), type.get(), H5S_ALL, H5S_ALL, H5P_DEFAULT, buffer.data()) < 0) {
+                    throw_h5_write(path);
+                }
+            }
+        }
+
+        template <typename Array>
+        void write_h5_array(const hid_t loc, const std::string& name, const Array& values, const Hdf5WriteOptions& options,
+                            const std::string_view path) {
+            using Element = typename Array::value_type;
+            const hsize_t length = values.size();
+            const H5Handle space(H5Screate_simple(1, &length, nullptr), H5Sclose);
+            const H5Handle plist(H5Pcreate(H5P_DATASET_CREATE), H5Pclose);
+            if (length != 0) {
+                const hsize_t chunk = std::min(length, std::max<hsize_t>(options.chunk_elements, 1));
+                H5Pset_chunk(plist.get(), 1, &chunk);
+                if (options.compression != 0 && H5Zfilter_avail(H5Z_FILTER_DEFLATE) > 0) {
+                    H5Pset_shuffle(plist.get());
+                    H5Pset_deflate(plist.get(), std::min(options.compression, 9u));
+                }
+            }
+            const H5Handle dataset(H5Dcreate2(loc, name.c_str(), h5_native_type<Element>(), space.get(), H5P_DEFAULT, plist.get(), H5P_DEFAULT),
+                                   H5Dclose);
+            if (!dataset.valid()) throw_h5_write(path);
+            if (length != 0 && H5Dwrite(dataset.get(), h5_native_type<Element>(), H5S_ALL, H5S_ALL, H5P_DEFAULT, values.data()) < 0) {
+                throw_h5_write(path);
+            }
+        }
+
+        template <typename V>
+        void write_h5_fields(hid_t group, const V& value, std::string_view path, const Hdf5WriteOptions& options);
+
+        template <typename Type>
+        void write_h5_value(const hid_t loc, const std::string& name, const Type& value, const std::string_view path,
+                            const Hdf5WriteOptions& options) {
+            if constexpr (validate::is_optional_v<Type>) {
+                if (value.has_value()) write_h5_value(loc, name, *value, path, options);
+            } else if constexpr (std::is_enum_v<Type>) {
+                write_h5_string(loc, name, rfl::enum_to_string(value), path);
+            } else if constexpr (std::is_arithmetic_v<Type>) {
+                write_h5_scalar(loc, name, value, path);
+            } else if constexpr (validate::is_string_like_v<Type>) {
+                write_h5_string(loc, name, value, path);
+            } else if constexpr (is_h5_array_v<Type>) {
+                write_h5_array(loc, name, value, options, path);
+            } else if constexpr (config::detail::is_path_struct_v<Type>) {
+                const H5Handle group(H5Gcreate2(loc, name.c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT), H5Gclose);
+                if (!group.valid()) throw_h5_write(path);
+                write_h5_fields(group.get(), value, path, options);
+            } else {
+                write_h5_string(loc, name, rfl::json::write(value), path);
+            }
+        }
+
+        template <typename V>
+        void write_h5_fields(const hid_t group, const V& value, const std::string_view path, const Hdf5WriteOptions& options) {
+            using Fields = typename rfl::named_tuple_t<V>::Fields;
+            const auto values = rfl::to_view(value).values();
+            [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                ([&] {
+                    const std::string name(rfl::tuple_element_t<Is, Fields>::name());
+                    write_h5_value(group, name, *rfl::get<Is>(values), h5_join(path, name), options);
+                }(), ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        }
+
+        /**
+         * @brief Reads a string attribute or scalar string dataset.
+         */
+        inline std::string read_h5_string(const hid_t loc, const std::string& name, const std::string_view path) {
+            const bool is_attribute = H5Aexists(loc, name.c_str()) > 0;
+            const H5Handle object(is_attribute ? H5Aopen(loc, name.c_str(), H5P_DEFAULT) : H5Dopen2(loc, name.c_str(), H5P_DEFAULT),
+                                  is_attribute ? H5Aclose : H5Dclose);
+            if (!object.valid()) throw_h5_read(path, "cannot open the attribute or dataset");
+            const H5Handle type(is_attribute ? H5Aget_type(object.get()) : H5Dget_type(object.get()), H5Tclose);
+            if (H5Tget_class(type.get()) != H5T_STRING) throw_h5_read(path, "expected a string");
+
+            auto read = [&](const hid_t memory_type, void* buffer) {
+                const herr_t status = is_attribute ? H5Aread(object.get(), memory_type, buffer)
+                                                   : H5Dread(object.get(), memory_type, H5S_ALL, H5S_ALL, H5P_DEFAULT, buffer);
+                if (status < 0) throw_h5_read(path, "cannot read the string");
+            };
+            if (H5Tis_variable_str(type.get()) > 0) {
+                const H5Handle memory_type(H5Tcopy(H5T_C_S1), H5Tclose);
+                H5Tset_size(memory_type.get(), H5T_VARIABLE);
+                H5Tset_cset(memory_type.get(), H5Tget_cset(type.get()));
+                char* data = nullptr;
+                read(memory_type.get(), &data);
+                std::string result = data != nullptr ? std::string(data) : std::string{};
+                H5free_memory(data);
+                return result;
+            }
+            std::string result(H5Tget_size(type.get()), '\0');
+            read(type.get(), result.data());
+            result.resize(std::min(result.size(), result.find('\0')));
+            return result;
+        }
+
+        template <typename E>
+        void read_h5_scalar(const hid_t loc, const std::string& name, E& value, const std::string_view path) {
+            if (H5Aexists(loc, name.c_str()) <= 0) throw_h5_read(path, "expected a scalar attribute");
+            const H5Handle attr(H5Aopen(loc, name.c_str(), H5P_DEFAULT), H5Aclose);
+            if constexpr (std::is_same_v<E, bool>) {
+                std::int8_t flag = 0;
+                if (!attr.valid() || H5Aread(attr.get(), h5_native_type<E>(), &flag) < 0) throw_h5_read(path, "expected a number");
+                value = flag != 0;
+            } else {
+                if (!attr.valid() || H5Aread(attr.get(), h5_native_type<E>(), &value) < 0) throw_h5_read(path, "expected a number");
+            }
+        }
+
+        template <typename Array>
+        void read_h5_array(const hid_t loc, const std::string& name, Array& values, const std::string_view path) {
+            using Element = typename Array::value_type;
+            if (H5Lexists(loc, name.c_str(), H5P_DEFAULT) <= 0) throw_h5_read(path, "expected a dataset");
+            const H5Handle dataset(H5Dopen2(loc, name.c_str(), H5P_DEFAULT), H5Dclose);
+            if (!dataset.valid()) throw_h5_read(path, "expected a dataset");
+            const H5Handle space(H5Dget_space(dataset.get()), H5Sclose);
+            const hssize_t length = H5Sget_simple_extent_npoints(space.get());
+            if (length < 0) throw_h5_read(path, "cannot query the dataset size");
+            if constexpr (validate::is_vector_v<Array>) {
+                values.resize(static_cast<std::size_t>(length));
+            } else if (static_cast<std::size_t>(length) != values.size()) {
+                throw_h5_read(path, std::format("expected {} elements, found {}", values.size(), length));
+            }
+            if (length != 0 && H5Dread(dataset.get(), h5_native_type<Element>(), H5S_ALL, H5S_ALL, H5P_DEFAULT, values.data()) < 0) {
+                throw_h5_read(path, "cannot read the dataset");
+            }
+        }
+
+        template <typename V>
+        void read_h5_fields(hid_t group, V& value, std::string_view path);
+
+        template <typename Type>
+        void read_h5_value(const hid_t loc, const std::string& name, Type& value, const std::string_view path) {
+            if constexpr (validate::is_optional_v<Type>) {
+                if (!h5_has(loc, name)) {
+                    value.reset();
+                    return;
+                }
+                read_h5_value(loc, name, value.emplace(), path);
+                return;
+            } else {
+                if (!h5_has(loc, name)) throw_h5_read(path, "field is missing");
+            }
+            if constexpr (std::is_enum_v<Type>) {
+                const std::string text = read_h5_string(loc, name, path);
+                auto result = io::enum_from_string<Type>(text);
+                if (!result) throw_h5_read(path, std::format("'{}' is not a valid value", text));
+                value = result.value();
+            } else if constexpr (std::is_arithmetic_v<Type>) {
+                read_h5_scalar(loc, name, value, path);
+            } else if constexpr (validate::is_string_like_v<Type>) {
+                value.assign(read_h5_string(loc, name, path));
+            } else if constexpr (is_h5_array_v<Type>) {
+                read_h5_array(loc, name, value, path);
+            } else if constexpr (config::detail::is_path_struct_v<Type>) {
+                const H5Handle group(H5Gopen2(loc, name.c_str(), H5P_DEFAULT), H5Gclose);
+                if (!group.valid()) throw_h5_read(path, "expected a group");
+                read_h5_fields(group.get(), value, path);
+            } else {
+                auto result = rfl::json::read<Type>(read_h5_string(loc, name, path));
+                if (!result) throw_h5_read(path, result.error().what());
+                value = std::move(result).value();
+            }
+        }
+
+        template <typename V>
+        void read_h5_fields(const hid_t group, V& value, const std::string_view path) {
+            using Fields = typename rfl::named_tuple_t<V>::Fields;
+            auto values = rfl::to_view(value).values();
+            [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                ([&] {
+                    const std::string name(rfl::tuple_element_t<Is, Fields>::name());
+                    read_h5_value(group, name, *rfl::get<Is>(values), h5_join(path, name));
+                }(), ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        }
+    }
+
+    /**
+     * @brief Writes `content` as the HDF5 group `name` below `location`.
+     * @tparam T The configuration schema type.
+     * @param location An open file or group.
+     * @param name The name of the group to create; an existing object of that name is replaced.
+     * @param content The configuration content.
+     * @param options Chunking and compression of array datasets.
+     * @throws exceptions::ConfigSaveError If a group, attribute or dataset cannot be written.
+     */
+    template <typename T>
+    void write_hdf5_group(const hid_t location, const std::string_view name, const T& content, const Hdf5WriteOptions& options = {}) {
+        const std::string group_name(name);
+        if (H5Lexists(location, group_name.c_str(), H5P_DEFAULT) > 0 && H5Ldelete(location, group_name.c_str(), H5P_DEFAULT) < 0) {
+            throw exceptions::ConfigSaveError(std::format("Failed to replace the existing HDF5 object '{}'.", group_name));
+        }
+        const detail::H5Handle group(H5Gcreate2(location, group_name.c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT), H5Gclose);
+        if (!group.valid()) {
+            throw exceptions::ConfigSaveError(std::format("Failed to create the HDF5 group '{}'.", group_name));
+        }
+        detail::write_h5_fields(group.get(), content, group_name, options);
+    }
+
+    /**
+     * @brief Reads the HDF5 group `name` below `location`, as written by `write_hdf5_group()`.
+     * @tparam T The configuration schema type.
+     * @param location An open file or group.
+     * @param name The name of the group to read.
+     * @return The deserialized content.
+     * @throws exceptions::ConfigLoadError If the group does not exist.
+     * @throws exceptions::ConfigParseError If a field is missing or does not match the schema.
+     */
+    template <typename T>
+    T read_hdf5_group(const hid_t location, const std::string_view name) {
+        const std::string group_name(name);
+        if (H5Lexists(location, group_name.c_str(), H5P_DEFAULT) <= 0) {
+            throw exceptions::ConfigLoadError(std::format("HDF5 group does not exist: {}", group_name));
+        }
+        const detail::H5Handle group(H5Gopen2(location, group_name.c_str(), H5P_DEFAULT), H5Gclose);
+        if (!group.valid()) {
+            throw exceptions::ConfigLoadError(std::format("Failed to open the HDF5 group '{}'.", group_name));
+        }
+        T content{};
+        detail::read_h5_fields(group.get(), content, group_name);
+        return content;
+    }
+}
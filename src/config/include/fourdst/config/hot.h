@@ -0,0 +1,103 @@
+/**
+ * @file hot.h
+ * @brief Hot fields: the few scalars inner loops read, packed into one cache-line-aligned block per snapshot.
+ *
+ * A schema full of strings, vectors and tables spreads the handful of numbers a kernel reads
+ * over many cache lines. Specializing `hot_fields<T>` names those fields:
+ *
+ * @code
+ * template <>
+ * struct fourdst::config::hot_fields<SimulationOptions> {
+ *     static constexpr std::array paths = {std::string_view("simulation.time_step"),
+ *                                          std::string_view("physics.diffusion")};
+ * };
+ * @endcode
+ *
+ * and `Config<T>` then keeps a `HotBlock<T>` next to each published snapshot: the named fields,
+ * ordered by decreasing alignment and packed without padding into a block aligned to a cache
+ * line, behind a seqlock (see `seqlock.h`). `Config::hot()` copies it out without a lock or a
+ * reference count, and the fields are read from the copy with typed accessors:
+ *
+ * @code
+ * using Hot = fourdst::config::HotBlock<SimulationOptions>;
+ * const Hot hot = cfg.hot();
+ * const double dt = hot.get<Hot::index("simulation.time_step")>();
+ * @endcode
+ *
+ * Ten doubles take two cache lines whatever the size of the schema. The fields keep their plain
+ * types in the schema and are read, written and validated as before. Hot fields must be
+ * trivially copyable leaves (numbers, bools, enums, fixed-size arrays of those); `Tunable`
+ * fields are stored in place without a publication and cannot be hot.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "fourdst/config/device.h"
+#include "fourdst/config/path_table.h"
+
+namespace fourdst::config {
+
+    /**
+     * @brief Names the hot fields of schema `T`; specialize it with a `paths` array of dotted paths.
+     *
+     * The primary template names none, and configs of such schemas keep no hot block.
+     */
+    template <typename T>
+    struct hot_fields {
+        static constexpr std::array<std::string_view, 0> paths{};
+    };
+
+    namespace detail {
+        /// The alignment of a `HotBlock`.
+        inline constexpr std::size_t cache_line_bytes = 64;
+
+        /// Whether `Config<T>` keeps a hot block.
+        template <typename T>
+        constexpr bool has_hot_fields_v = hot_fields<T>::paths.size() != 0;
+
+        template <typename T>
+        constexpr auto hot_slots() {
+            constexpr std::size_t count = hot_fields<T>::paths.size();
+            std::array<PackedSlot, count> slots{};
+            [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+                ([&] {
+                    constexpr std::size_t ordinal = PathTable<T>::find(hot_fields<T>::paths[Is]);
+                    static_assert(ordinal != PathTable<T>::npos, "hot_fields names a path the schema does not have.");
+                    using Type = typename decltype(field_type_at<T, ordinal>())::type;
+                    static_assert(std::is_trivially_copyable_v<Type> && !is_path_struct_v<Type>,
+                                  "Hot fields must be trivially copyable leaves: numbers, bools, enums or fixed-size arrays of those.");
+                    slots[Is] = {ordinal, sizeof(Type), alignof(Type), 0};
+                }(), ...);
+            }(std::make_index_sequence<count>{});
+            return pack_slots(slots);
+        }
+
+        /// The layout of `HotBlock<T>`; slots are kept in the order of `hot_fields<T>::paths`.
+        template <typename T>
+        using HotLayout = PackedLayout<hot_slots<T>()>;
+    }
+
+    /**
+     * @brief The hot fields of a `T`, packed into a cache-line-aligned block; see `hot.h`.
+     */
+    template <typename T>
+    using HotBlock = PackedBlock<T, detail::HotLayout<T>, detail::cache_line_bytes>;
+
+    namespace detail {
+        /**
+         * @brief Copies the hot fields of `content` into `block`.
+         */
+        template <typename T>
+        void fill_hot_block(const T& content, HotBlock<T>& block) {
+            for (const PackedSlot& slot : HotLayout<T>::slots) {
+                std::memcpy(block.bytes + slot.offset, PathTable<T>::entry(slot.ordinal).address(content), slot.size);
+            }
+        }
+    }
+}
@@ -0,0 +1,89 @@
+/**
+ * @file instantiate.h
+ * @brief Explicit instantiation of the file I/O members of `Config<T>` in a single translation unit.
+ *
+ * Every translation unit that loads, saves or formats a `Config<T>` instantiates the reflect-cpp
+ * TOML and JSON readers and writers for the whole of `T`, which for large schemas dominates the
+ * compile time of the unit. `FOURDST_CONFIG_DECLARE(T)` declares those members as explicitly
+ * instantiated elsewhere (`extern template`), so units that see the declaration only emit calls;
+ * `FOURDST_CONFIG_INSTANTIATE(T)` instantiates them, and must appear in exactly one unit of the
+ * program.
+ *
+ * @code
+ * // physics_schema.h
+ * #include "fourdst/config/config.h"
+ * struct PhysicsSchema { ... };
+ * FOURDST_CONFIG_DECLARE(PhysicsSchema);
+ *
+ * // physics_schema.cpp
+ * #include "physics_schema.h"
+ * FOURDST_CONFIG_INSTANTIATE(PhysicsSchema);
+ * @endcode
+ *
+ * The members covered are `load()`, `load_layers()`, `load_table()`, `reload()`, `load_from()`, `save()`,
+ * `save_async()`, `save_to()`, `schema()`, `save_schema()`, `deck_template()`, `save_template()`, the
+ * `try_` variants of `load()`, `load_from()`, `save()` and `save_schema()`, and the `std::format` output of the
+ * `char` formatter; the schema members are left out under `-Dwasm_profile=true`.
+ * Other members (`apply_patch()`, `register_as_cli()`, ...) are still instantiated where they are
+ * used. The declaration must come before the first use of a covered member in a unit, and `T`
+ * must be named without a top-level comma (use an alias for template specializations).
+ */
+#pragma once
+
+#include <expected>
+#include <format>
+#include <future>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "fourdst/config/base.h"
+
+#if FOURDST_CONFIG_WASM_PROFILE
+#define FOURDST_CONFIG_SCHEMA_INSTANTIATION_(PREFIX, T)
+#else
+/// The JSON schema members, which builds with `-Dwasm_profile=true` leave out.
+#define FOURDST_CONFIG_SCHEMA_INSTANTIATION_(PREFIX, T) \
+    PREFIX template std::string_view fourdst::config::Config<T>::schema(); \
+    PREFIX template void fourdst::config::Config<T>::save_schema(const std::string&, int); \
+    PREFIX template std::expected<void, fourdst::config::exceptions::ConfigErrorInfo> \
+        fourdst::config::Config<T>::try_save_schema(const std::string&, int) noexcept;
+#endif
+
+/// Applies `PREFIX` (`extern` or nothing) to an explicit instantiation of each covered member of `Config<T>`.
+#define FOURDST_CONFIG_EXPLICIT_INSTANTIATION_(PREFIX, T) \
+    PREFIX template void fourdst::config::Config<T>::load(std::string_view, bool); \
+    PREFIX template void fourdst::config::Config<T>::load(std::shared_ptr<fourdst::config::ConfigSource>, bool); \
+    PREFIX template void fourdst::config::Config<T>::load_layers(const std::vector<std::string>&, bool); \
+    PREFIX template void fourdst::config::Config<T>::load_table(toml::table&, std::string_view, bool); \
+    PREFIX template bool fourdst::config::Config<T>::reload(std::string_view, bool); \
+    PREFIX template bool fourdst::config::Config<T>::load_from(std::string_view, bool); \
+    PREFIX template void fourdst::config::Config<T>::save(std::string_view, fourdst::config::SavePolicy) const; \
+    PREFIX template void fourdst::config::Config<T>::save(std::string_view, fourdst::config::SaveMode, fourdst::config::SavePolicy) const; \
+    PREFIX template std::future<void> fourdst::config::Config<T>::save_async(std::string, fourdst::config::SavePolicy) const; \
+    PREFIX template void fourdst::config::Config<T>::save_to(std::string&) const; \
+    PREFIX template void fourdst::config::Config<T>::save_to(std::ostream&) const; \
+    FOURDST_CONFIG_SCHEMA_INSTANTIATION_(PREFIX, T) \
+    PREFIX template std::string_view fourdst::config::Config<T>::deck_template(); \
+    PREFIX template std::expected<void, fourdst::config::exceptions::ConfigErrorInfo> \
+        fourdst::config::Config<T>::try_load(std::string_view, bool) noexcept; \
+    PREFIX template std::expected<void, fourdst::config::exceptions::ConfigErrorInfo> \
+        fourdst::config::Config<T>::try_load_from(std::string_view, bool) noexcept; \
+    PREFIX template std::expected<void, fourdst::config::exceptions::ConfigErrorInfo> \
+        fourdst::config::Config<T>::try_save(std::string_view, fourdst::config::SavePolicy) const noexcept; \
+    PREFIX template void fourdst::config::Config<T>::save_template(const std::string&); \
+    PREFIX template std::format_context::iterator \
+        std::formatter<fourdst::config::Config<T>, char>::write_config(const fourdst::config::Config<T>&, std::format_context::iterator) const
+
+/**
+ * @brief Declares that the file I/O members of `Config<T>` are instantiated in another translation unit.
+ *
+ * Use at namespace scope, typically in the header that defines `T`.
+ */
+#define FOURDST_CONFIG_DECLARE(T) FOURDST_CONFIG_EXPLICIT_INSTANTIATION_(extern, T)
+
+/**
+ * @brief Instantiates the file I/O members of `Config<T>`; use in exactly one translation unit.
+ */
+#define FOURDST_CONFIG_INSTANTIATE(T) FOURDST_CONFIG_EXPLICIT_INSTANTIATION_(, T)
@@ -0,0 +1,665 @@
+/**
+ * @file io.h
+ * @brief Low-level file input and output helpers used by the configuration loader and writer.
+ *
+ * This file provides `MappedFile`, a read-only memory mapping of a configuration file that
+ * exposes its bytes as a `std::string_view`. Handing that view to the TOML parser avoids
+ * copying the file into an intermediate `std::string`, and lets processes on the same node
+ * share the page-cache pages of a large, generated config.
+ *
+ * On platforms without POSIX `mmap` (Windows, Emscripten) the file is read into an owned
+ * buffer instead, so callers can use the same interface everywhere. The same buffer is used on
+ * request (`ReadMode::READ`, `ReadMode::DIRECT`): the size is taken from `fstat`, the buffer is
+ * allocated once, page-aligned, and the whole file is fetched with as few large `read` calls as
+ * the kernel allows, which on parallel file systems such as Lustre is one RPC stream instead of
+ * many small `std::ifstream` refills. `read_stdin()` reads a deck piped to the process.
+ *
+ * For output it provides sinks with a `write(std::string_view)` member: `FileSink`, a buffered
+ * file writer; `AtomicFileSink`, which writes a sibling temporary file and renames it over the
+ * target on commit; `StringSink`, which appends to a `std::string`; and `StreamSink`, which
+ * writes to a `std::ostream`.
+ *
+ * When built with `FOURDST_CONFIG_USE_MPI`, it also provides `broadcast_bytes()`, used by
+ * `Config::load_collective()`.
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <system_error>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "fourdst/config/exceptions/exceptions.h"
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#define FOURDST_CONFIG_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define FOURDST_CONFIG_HAS_MMAP 0
+#endif
+
+#if FOURDST_CONFIG_USE_MPI
+#include <mpi.h>
+#include <climits>
+#include <cstdint>
+#endif
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fourdst::config::io {
+
+    /**
+     * @brief How `MappedFile` obtains the bytes of a file.
+     */
+    enum class ReadMode {
+        /// Memory-map the file (an owned buffer on platforms without `mmap`).
+        MAP,
+        /// As `MAP`, advised for scattered access (`MADV_RANDOM`): only the pages touched are read.
+        MAP_RANDOM,
+        /// Read the whole file into a pre-sized buffer with large reads, after `posix_fadvise(SEQUENTIAL | WILLNEED)`.
+        READ,
+        /// As `READ`, with `O_DIRECT` to bypass the page cache where the file system supports it.
+        DIRECT
+    };
+
+    /// Alignment of owned read buffers; satisfies `O_DIRECT` on common block devices and file systems.
+    inline constexpr std::size_t read_alignment = 4096;
+
+    /**
+     * @brief Read-only view of a whole file backed by a memory mapping or by one owned buffer.
+     *
+     * The mapping lives as long as the `MappedFile` object; any `std::string_view` returned by
+     * `view()` is invalidated when the object is destroyed or moved from.
+     *
+     * @par Examples
+     * @code
+     * fourdst::config::io::MappedFile file("big_deck.toml");
+     * toml::table tbl = toml::parse(file.view(), "big_deck.toml");
+     * @endcode
+     */
+    class MappedFile {
+    public:
+        /**
+         * @brief Maps the file at `path` into memory, or reads it into a buffer.
+         * @param path The file to map.
+         * @param mode How to obtain the bytes; `DIRECT` falls back to `READ` where `O_DIRECT` is refused.
+         * @throws exceptions::ConfigLoadError If the file cannot be opened, inspected, mapped, or read.
+         */
+        explicit MappedFile(const std::string& path, const ReadMode mode = ReadMode::MAP) {
+#if FOURDST_CONFIG_HAS_MMAP
+            if (mode != ReadMode::MAP && mode != ReadMode::MAP_RANDOM) {
+                read_whole(path, mode == ReadMode::DIRECT);
+                return;
+            }
+            const int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw exceptions::ConfigLoadError(
+                    std::format("Unable to open config file for mapping: {}", path));
+            }
+
+            struct stat st{};
+            if (::fstat(fd, &st) != 0) {
+                ::close(fd);
+                throw exceptions::ConfigLoadError(
+                    std::format("Unable to stat config file: {}", path));
+            }
+
+            m_size = static_cast<std::size_t>(st.st_size);
+            if (m_size > 0) {
+                void* addr = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (addr == MAP_FAILED) {
+                    ::close(fd);
+                    throw exceptions::ConfigLoadError(
+                        std::format("Unable to memory-map config file: {}", path));
+                }
+                m_data = static_cast<const char*>(addr);
+#if defined(MADV_SEQUENTIAL) && defined(MADV_RANDOM)
+                ::madvise(addr, m_size, mode == ReadMode::MAP_RANDOM ? MADV_RANDOM : MADV_SEQUENTIAL);
+#endif
+            }
+            ::close(fd);
+#else
+            static_cast<void>(mode);
+            std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+            if (!ifs.is_open()) {
+                throw exceptions::ConfigLoadError(
+                    std::format("Unable to open config file: {}", path));
+            }
+            const auto size = static_cast<std::size_t>(ifs.tellg());
+            ifs.seekg(0);
+            allocate(size);
+            ifs.read(m_buffer.get(), static_cast<std::streamsize>(size));
+            m_data = m_buffer.get();
+            m_size = static_cast<std::size_t>(ifs.gcount());
+#endif
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept { swap(other); }
+
+        MappedFile& operator=(MappedFile&& other) noexcept {
+            if (this != &other) {
+                MappedFile tmp(std::move(other));
+                swap(tmp);
+            }
+            return *this;
+        }
+
+        ~MappedFile() {
+#if FOURDST_CONFIG_HAS_MMAP
+            if (m_data != nullptr && !m_buffer) {
+                ::munmap(const_cast<char*>(m_data), m_size);
+            }
+#endif
+        }
+
+        /**
+         * @brief Returns the file contents.
+         * @return A view over the mapped bytes; empty for an empty file.
+         */
+        [[nodiscard]] std::string_view view() const noexcept {
+            return m_data ? std::string_view(m_data, m_size) : std::string_view{};
+        }
+
+        /**
+         * @brief Returns the size of the mapped file in bytes.
+         */
+        [[nodiscard]] std::size_t size() const noexcept { return m_size; }
+
+    private:
+        struct AlignedFree {
+            void operator()(char* p) const noexcept { std::free(p); }
+        };
+
+        void swap(MappedFile& other) noexcept {
+            std::swap(m_data, other.m_data);
+            std::swap(m_size, other.m_size);
+            std::swap(m_buffer, other.m_buffer);
+            std::swap(m_capacity, other.m_capacity);
+        }
+
+        /// Allocates a buffer of more than `size` bytes, rounded up to whole aligned blocks.
+        void allocate(const std::size_t size) {
+            const std::size_t capacity = (size / read_alignment + 1) * read_alignment;
+#if FOURDST_CONFIG_HAS_MMAP
+            m_buffer.reset(static_cast<char*>(std::aligned_alloc(read_alignment, capacity)));
+#else
+            m_buffer.reset(static_cast<char*>(std::malloc(capacity)));
+#endif
+            if (!m_buffer) throw std::bad_alloc();
+            m_capacity = capacity;
+        }
+
+#if FOURDST_CONFIG_HAS_MMAP
+        void read_whole(const std::string& path, const bool direct) {
+            int flags = O_RDONLY;
+#ifdef O_DIRECT
+            if (direct) flags |= O_DIRECT;
+#endif
+            int fd = ::open(path.c_str(), flags);
+            if (fd < 0 && flags != O_RDONLY && errno == EINVAL) {
+                // The file system does not support O_DIRECT (tmpfs, some FUSE mounts).
+                flags = O_RDONLY;
+                fd = ::open(path.c_str(), flags);
+            }
+            if (fd < 0) {
+                throw exceptions::ConfigLoadError(
+                    std::format("Unable to open config file: {}", path));
+            }
+
+            struct stat st{};
+            if (::fstat(fd, &st) != 0) {
+                ::close(fd);
+                throw exceptions::ConfigLoadError(
+                    std::format("Unable to stat config file: {}", path));
+            }
+#if defined(POSIX_FADV_SEQUENTIAL) && defined(POSIX_FADV_WILLNEED)
+            if (flags == O_RDONLY) {
+                ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+                ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+            }
+#endif
+
+            // One block more than the size, so a file that grew meanwhile is noticed by the read
+            // that does not hit end-of-file; direct reads need whole blocks anyway.
+            allocate(static_cast<std::size_t>(st.st_size));
+            std::size_t done = 0;
+            while (done < m_capacity) {
+                const ssize_t got = ::read(fd, m_buffer.get() + done, m_capacity - done);
+                if (got > 0) {
+                    done += static_cast<std::size_t>(got);
+                    continue;
+                }
+                if (got == 0) break;
+                if (errno == EINTR) continue;
+#ifdef O_DIRECT
+                if (errno == EINVAL && (flags & O_DIRECT) != 0) {
+                    // A short direct read left the offset unaligned; finish through the page cache.
+                    flags &= ~O_DIRECT;
+                    ::fcntl(fd, F_SETFL, flags);
+                    continue;
+                }
+#endif
+                ::close(fd);
+                throw exceptions::ConfigLoadError(
+                    std::format("Unable to read config file: {}", path));
+            }
+            ::close(fd);
+            if (done == m_capacity) {
+                throw exceptions::ConfigLoadError(
+                    std::format("Config file changed size while being read: {}", path));
+            }
+            m_data = m_buffer.get();
+            m_size = done;
+        }
+#endif
+
+        const char* m_data = nullptr;
+        std::size_t m_size = 0;
+        std::unique_ptr<char, AlignedFree> m_buffer;
+        std::size_t m_capacity = 0;
+    };
+
+    /**
+     * @brief Reads standard input to its end, in large blocks.
+     *
+     * Used for the path `"-"` (see `Config::load()`), so a deck can be piped from a generator
+     * without a temporary file. On Windows the stream is switched to binary mode first, so line
+     * endings reach the parser unchanged.
+     *
+     * @return Everything read from standard input.
+     * @throws exceptions::ConfigLoadError If reading fails.
+     */
+    inline std::string read_stdin() {
+#if defined(_WIN32)
+        _setmode(_fileno(stdin), _O_BINARY);
+#endif
+        std::string content;
+        std::size_t block = 64 * 1024;
+        std::size_t done = 0;
+        while (true) {
+            content.resize(done + block);
+            const std::size_t got = std::fread(content.data() + done, 1, block, stdin);
+            done += got;
+            if (got < block) break;
+            // Doubling keeps the number of reads and reallocations logarithmic in the deck size.
+            block = std::min<std::size_t>(block * 2, 16 * 1024 * 1024);
+        }
+        if (std::ferror(stdin)) {
+            std::clearerr(stdin);
+            throw exceptions::ConfigLoadError("Unable to read config from standard input.");
+        }
+        content.resize(done);
+        return content;
+    }
+
+    /**
+     * @brief Buffered, write-only file sink.
+     *
+     * Output is collected in a fixed-size buffer and handed to the C stream in large blocks.
+     * Errors are reported as `exceptions::ConfigSaveError`.
+     */
+    class FileSink {
+    public:
+        /**
+         * @brief Opens (and truncates) the file at `path` for writing.
+         * @param path The file to write.
+         * @throws exceptions::ConfigSaveError If the file cannot be opened.
+         */
+        explicit FileSink(const std::string& path) : m_path(path), m_file(std::fopen(path.c_str(), "wb")) {
+            if (m_file == nullptr) {
+                throw exceptions::ConfigSaveError(
+                    std::format("Failed to open file for writing config: {}", path));
+            }
+            // The sink does its own buffering.
+            std::setvbuf(m_file, nullptr, _IONBF, 0);
+        }
+
+        FileSink(const FileSink&) = delete;
+        FileSink& operator=(const FileSink&) = delete;
+
+        /**
+         * @brief Closes the file, discarding errors. Call `close()` to observe them.
+         */
+        ~FileSink() {
+            if (m_file != nullptr) {
+                std::fclose(m_file);
+            }
+        }
+
+        /**
+         * @brief Appends bytes to the output.
+         * @param data The bytes to write.
+         * @throws exceptions::ConfigSaveError If flushing a full buffer fails.
+         */
+        void write(std::string_view data) {
+            if (data.size() >= m_buffer.size()) {
+                flush();
+                write_through(data);
+                return;
+            }
+            if (data.size() > m_buffer.size() - m_used) {
+                flush();
+            }
+            data.copy(m_buffer.data() + m_used, data.size());
+            m_used += data.size();
+        }
+
+        /**
+         * @brief Writes any buffered bytes to the file.
+         * @throws exceptions::ConfigSaveError If the write fails.
+         */
+        void flush() {
+            if (m_used > 0) {
+                write_through(std::string_view(m_buffer.data(), m_used));
+                m_used = 0;
+            }
+        }
+
+        /**
+         * @brief Flushes and closes the file.
+         * @throws exceptions::ConfigSaveError If flushing or closing fails.
+         */
+        void close() {
+            if (m_file == nullptr) return;
+            flush();
+            std::FILE* file = m_file;
+            m_file = nullptr;
+            if (std::fclose(file) != 0) {
+                throw exceptions::ConfigSaveError(
+                    std::format("Failed to finish writing config file: {}", m_path));
+            }
+        }
+
+        /**
+         * @brief Closes the file without flushing buffered bytes, ignoring errors.
+         */
+        void discard() noexcept {
+            if (m_file != nullptr) {
+                std::fclose(m_file);
+                m_file = nullptr;
+            }
+            m_used = 0;
+        }
+
+        /**
+         * @brief Flushes buffered bytes and asks the OS to commit the file contents to storage.
+         * @throws exceptions::ConfigSaveError If flushing or syncing fails.
+         */
+        void sync() {
+            flush();
+#if defined(_WIN32)
+            const int status = ::_commit(::_fileno(m_file));
+#else
+            const int status = ::fsync(::fileno(m_file));
+#endif
+            if (status != 0) {
+                throw exceptions::ConfigSaveError(
+                    std::format("Failed to sync config file to storage: {}", m_path));
+            }
+        }
+
+    private:
+        void write_through(const std::string_view data) {
+            if (std::fwrite(data.data(), 1, data.size(), m_file) != data.size()) {
+                throw exceptions::ConfigSaveError(
+                    std::format("Failed to write config file: {}", m_path));
+            }
+        }
+
+        std::string m_path;
+        std::FILE* m_file = nullptr;
+        std::array<char, 64 * 1024> m_buffer{};
+        std::size_t m_used = 0;
+    };
+
+    /**
+     * @brief File sink that replaces its target atomically.
+     *
+     * Output goes to a uniquely named temporary file next to the target. `commit()` closes it and
+     * renames it over the target, so readers (and file watchers) only ever see the old file or the
+     * complete new one, never a partial write. If the sink is destroyed without `commit()`, the
+     * temporary file is removed and the target is left untouched.
+     *
+     * With `durable` set, the file contents are synced to storage before the rename, and on POSIX
+     * the directory entry is synced after it, so the new file survives a crash or power loss.
+     *
+     * If the target is a symlink, the file it points to is replaced and the link is kept. The new
+     * file gets the permissions of the file it replaces; its owner is the writing process.
+     *
+     * @par Examples
+     * @code
+     * fourdst::config::io::AtomicFileSink sink("run.toml", true);
+     * sink.write("[main]\n");
+     * sink.commit();
+     * @endcode
+     */
+    class AtomicFileSink {
+    public:
+        /**
+         * @brief Creates the temporary file for `target`.
+         * @param target The file to replace on commit.
+         * @param durable Whether to sync file and directory to storage on commit.
+         * @throws exceptions::ConfigSaveError If the temporary file cannot be created.
+         */
+        AtomicFileSink(const std::string& target, const bool durable)
+            : m_target(resolve_symlinks(target)), m_temp(temp_path_for(m_target)), m_durable(durable), m_sink(m_temp) {
+            copy_permissions(m_target, m_temp);
+        }
+
+        AtomicFileSink(const AtomicFileSink&) = delete;
+        AtomicFileSink& operator=(const AtomicFileSink&) = delete;
+
+        /**
+         * @brief Removes the temporary file unless the sink was committed.
+         */
+        ~AtomicFileSink() {
+            if (!m_committed) {
+                m_sink.discard();
+                std::error_code ec;
+                std::filesystem::remove(m_temp, ec);
+            }
+        }
+
+        /**
+         * @brief Appends bytes to the temporary file.
+         * @param data The bytes to write.
+         */
+        void write(const std::string_view data) { m_sink.write(data); }
+
+        /**
+         * @brief Finishes the temporary file and renames it over the target.
+         * @throws exceptions::ConfigSaveError If writing, syncing or renaming fails.
+         */
+        void commit() {
+            if (m_durable) {
+                m_sink.sync();
+            }
+            m_sink.close();
+
+            std::error_code ec;
+            std::filesystem::rename(m_temp, m_target, ec);
+            if (ec) {
+                throw exceptions::ConfigSaveError(
+                    std::format("Failed to replace config file {}: {}", m_target, ec.message()));
+            }
+            m_committed = true;
+
+            if (m_durable) {
+                // Persist the rename itself.
+                sync_directory_of(m_target);
+            }
+        }
+
+        /**
+         * @brief Syncs the directory holding `target` to storage, so a rename into it survives a crash; a no-op on Windows.
+         */
+        static void sync_directory_of(const std::string& target) {
+#if !defined(_WIN32)
+            const std::filesystem::path parent = std::filesystem::path(target).parent_path();
+            const int dir_fd = ::open(parent.empty() ? "." : parent.c_str(), O_RDONLY);
+            if (dir_fd >= 0) {
+                ::fsync(dir_fd);
+                ::close(dir_fd);
+            }
+#else
+            (void)target;
+#endif
+        }
+
+        /**
+         * @brief Returns the file `target` names once symlinks are followed, even if it does not exist yet.
+         *
+         * Renaming over a symlink would replace the link itself with a regular file.
+         */
+        static std::string resolve_symlinks(const std::string& target) {
+            std::filesystem::path path(target);
+            std::error_code ec;
+            // Bounded like the kernel's own resolution, so a symlink loop ends.
+            for (int hops = 0; hops < 40 && std::filesystem::is_symlink(std::filesystem::symlink_status(path, ec)); ++hops) {
+                const std::filesystem::path link = std::filesystem::read_symlink(path, ec);
+                if (ec) break;
+                path = link.is_absolute() ? link : path.parent_path() / link;
+            }
+            return path.string();
+        }
+
+        /**
+         * @brief Gives `temp` the permissions of `target`, if it exists.
+         *
+         * Called before anything is written, so a private file is never readable through its replacement.
+         */
+        static void copy_permissions(const std::string& target, const std::string& temp) {
+            std::error_code ec;
+            const std::filesystem::file_status status = std::filesystem::status(target, ec);
+            if (!ec && std::filesystem::exists(status)) {
+                std::filesystem::permissions(temp, status.permissions(), std::filesystem::perm_options::replace, ec);
+            }
+        }
+
+        /**
+         * @brief Returns a new, unique name for a temporary file beside `target`.
+         */
+        static std::string temp_path_for(const std::string& target) {
+            static std::atomic<unsigned> counter{0};
+            const std::filesystem::path path(target);
+#if defined(_WIN32)
+            const auto pid = ::_getpid();
+#else
+            const auto pid = ::getpid();
+#endif
+            // A hidden sibling in the same directory, so the final rename never crosses filesystems.
+            const std::string name = std::format(".{}.{}.{}.tmp", path.filename().string(), pid, counter++);
+            return (path.parent_path() / name).string();
+        }
+
+    private:
+        std::string m_target;
+        std::string m_temp;
+        bool m_durable;
+        bool m_committed = false;
+        FileSink m_sink;
+    };
+
+    /**
+     * @brief Sink that appends to a `std::string`.
+     */
+    class StringSink {
+    public:
+        /**
+         * @brief Creates a sink appending to `out`.
+         * @param out The string to append to; must outlive the sink.
+         */
+        explicit StringSink(std::string& out) : m_out(out) {}
+
+        /**
+         * @brief Appends bytes to the string.
+         * @param data The bytes to append.
+         */
+        void write(const std::string_view data) { m_out.append(data); }
+
+    private:
+        std::string& m_out;
+    };
+
+    /**
+     * @brief Sink that writes to a `std::ostream`.
+     */
+    class StreamSink {
+    public:
+        /**
+         * @brief Creates a sink writing to `out`.
+         * @param out The stream to write to; must outlive the sink.
+         */
+        explicit StreamSink(std::ostream& out) : m_out(out) {}
+
+        /**
+         * @brief Writes bytes to the stream.
+         * @param data The bytes to write.
+         * @throws exceptions::ConfigSaveError If the stream is in a failed state after writing.
+         */
+        void write(const std::string_view data) {
+            m_out.write(data.data(), static_cast<std::streamsize>(data.size()));
+            if (!m_out) {
+                throw exceptions::ConfigSaveError("Failed to write config to output stream.");
+            }
+        }
+
+    private:
+        std::ostream& m_out;
+    };
+
+#if FOURDST_CONFIG_USE_MPI
+    /**
+     * @brief Broadcasts a byte buffer from `root` to every rank of `comm`.
+     *
+     * The size is broadcast first so receivers can allocate; buffers larger than `INT_MAX` bytes
+     * are sent in chunks. This is a collective call: every rank of `comm` must make it.
+     *
+     * @param comm The communicator.
+     * @param root The rank whose `buffer` is sent.
+     * @param buffer On `root`, the bytes to send; on other ranks, receives them.
+     * @throws exceptions::ConfigLoadError If an MPI call fails.
+     */
+    inline void broadcast_bytes(MPI_Comm comm, const int root, std::string& buffer) {
+        std::uint64_t size = buffer.size();
+        if (MPI_Bcast(&size, 1, MPI_UINT64_T, root, comm) != MPI_SUCCESS) {
+            throw exceptions::ConfigLoadError("Failed to broadcast config size.");
+        }
+        buffer.resize(size);
+        for (std::uint64_t offset = 0; offset < size;) {
+            const int chunk = static_cast<int>(std::min<std::uint64_t>(size - offset, INT_MAX));
+            if (MPI_Bcast(buffer.data() + offset, chunk, MPI_BYTE, root, comm) != MPI_SUCCESS) {
+                throw exceptions::ConfigLoadError("Failed to broadcast config content.");
+            }
+            offset += static_cast<std::uint64_t>(chunk);
+        }
+    }
+#endif
+}
@@ -0,0 +1,144 @@
+/**
+ * @file json_writer.h
+ * @brief JSON serialization of configuration structures with a stable member order.
+ *
+ * `rfl::json::write` emits struct fields in declaration order, but the members of a
+ * `std::unordered_map` in its iteration order, which depends on the hash, the bucket count and
+ * the insertion history. `write_json()` writes the same JSON with the members of every unordered
+ * map sorted by key, so equal configs give byte-identical text. Schemas without unordered maps
+ * are written by `rfl::json::write` unchanged, at no extra cost.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/path_table.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+#include "rfl/json.hpp"
+#include "yyjson.h"
+
+namespace fourdst::config::io {
+
+    namespace detail {
+        template <typename Type>
+        struct contains_unordered_map;
+
+        template <typename Fields>
+        struct fields_contain_unordered_map;
+
+        template <typename... Fields>
+        struct fields_contain_unordered_map<rfl::Tuple<Fields...>>
+            : std::bool_constant<(contains_unordered_map<std::remove_cvref_t<typename Fields::Type>>::value || ...)> {};
+
+        template <typename Type>
+        struct contains_unordered_map {
+            static constexpr bool compute() {
+                if constexpr (validate::is_unordered_map_v<Type>) {
+                    return true;
+                } else if constexpr (std::is_arithmetic_v<Type> || std::is_enum_v<Type> || validate::is_string_like_v<Type>) {
+                    return false;
+                } else if constexpr (validate::is_optional_v<Type> || validate::is_vector_v<Type> ||
+                                     config::detail::is_std_array_v<Type>) {
+                    return contains_unordered_map<std::remove_cvref_t<typename Type::value_type>>::value;
+                } else if constexpr (validate::is_map_v<Type>) {
+                    return contains_unordered_map<std::remove_cvref_t<typename Type::mapped_type>>::value;
+                } else if constexpr (config::detail::is_path_struct_v<Type>) {
+                    return fields_contain_unordered_map<typename rfl::named_tuple_t<Type>::Fields>::value;
+                } else {
+                    return false;
+                }
+            }
+            static constexpr bool value = compute();
+        };
+    }
+
+    /// Whether a schema has `std::unordered_map` fields, anywhere in its nesting.
+    template <typename Type>
+    constexpr bool contains_unordered_map_v = detail::contains_unordered_map<std::remove_cvref_t<Type>>::value;
+
+    namespace detail {
+        /**
+         * @brief Relinks the members of a JSON object in key order.
+         */
+        inline void sort_members(yyjson_mut_val* object) {
+            std::vector<std::pair<yyjson_mut_val*, yyjson_mut_val*>> members;
+            members.reserve(yyjson_mut_obj_size(object));
+            yyjson_mut_obj_iter iter = yyjson_mut_obj_iter_with(object);
+            while (yyjson_mut_val* key = yyjson_mut_obj_iter_next(&iter)) {
+                members.emplace_back(key, yyjson_mut_obj_iter_get_val(key));
+            }
+            std::ranges::sort(members, {}, [](const auto& member) {
+                return std::string_view(yyjson_mut_get_str(member.first), yyjson_mut_get_len(member.first));
+            });
+            yyjson_mut_obj_clear(object);
+            for (const auto& [key, value] : members) yyjson_mut_obj_add(object, key, value);
+        }
+
+        /**
+         * @brief Sorts the members of the objects written for unordered maps in the JSON `value` of a `Type`.
+         */
+        template <typename Type>
+        void sort_unordered_maps(yyjson_mut_val* value) {
+            if constexpr (contains_unordered_map<Type>::value) {
+                if (value == nullptr) return;
+                if constexpr (validate::is_optional_v<Type>) {
+                    sort_unordered_maps<std::remove_cvref_t<typename Type::value_type>>(value);
+                } else if constexpr (validate::is_vector_v<Type> || config::detail::is_std_array_v<Type>) {
+                    yyjson_mut_arr_iter iter = yyjson_mut_arr_iter_with(value);
+                    while (yyjson_mut_val* element = yyjson_mut_arr_iter_next(&iter)) {
+                        sort_unordered_maps<std::remove_cvref_t<typename Type::value_type>>(element);
+                    }
+                } else if constexpr (validate::is_map_v<Type>) {
+                    if (!yyjson_mut_is_obj(value)) return;
+                    if constexpr (validate::is_unordered_map_v<Type>) sort_members(value);
+                    yyjson_mut_obj_iter iter = yyjson_mut_obj_iter_with(value);
+                    while (yyjson_mut_val* key = yyjson_mut_obj_iter_next(&iter)) {
+                        sort_unordered_maps<std::remove_cvref_t<typename Type::mapped_type>>(yyjson_mut_obj_iter_get_val(key));
+                    }
+                } else {
+                    using Fields = typename rfl::named_tuple_t<Type>::Fields;
+                    [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                        ([&] {
+                            using Field = rfl::tuple_element_t<Is, Fields>;
+                            using FieldType = std::remove_cvref_t<typename Field::Type>;
+                            if constexpr (contains_unordered_map<FieldType>::value) {
+                                const std::string_view name = Field::name();
+                                sort_unordered_maps<FieldType>(yyjson_mut_obj_getn(value, name.data(), name.size()));
+                            }
+                        }(), ...);
+                    }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Writes `value` as compact JSON, with the members of unordered maps sorted by key.
+     * @return The JSON text; identical for values that compare equal.
+     */
+    template <typename V>
+    std::string write_json(const V& value) {
+        std::string text = rfl::json::write(value);
+        if constexpr (contains_unordered_map_v<V>) {
+            const std::unique_ptr<yyjson_doc, decltype(&yyjson_doc_free)> doc(yyjson_read(text.data(), text.size(), 0), &yyjson_doc_free);
+            if (!doc) return text;
+            const std::unique_ptr<yyjson_mut_doc, decltype(&yyjson_mut_doc_free)> copy(yyjson_doc_mut_copy(doc.get(), nullptr),
+                                                                                       &yyjson_mut_doc_free);
+            if (!copy) return text;
+            detail::sort_unordered_maps<std::remove_cvref_t<V>>(yyjson_mut_doc_get_root(copy.get()));
+            std::size_t length = 0;
+            const std::unique_ptr<char, decltype(&std::free)> sorted(yyjson_mut_write(copy.get(), 0, &length), &std::free);
+            if (sorted) text.assign(sorted.get(), length);
+        }
+        return text;
+    }
+}
@@ -0,0 +1,200 @@
+/**
+ * @file lazy.h
+ * @brief `Lazy<U>` fields, deserialized on first access.
+ *
+ * A `Lazy<U>` member keeps a copy of its TOML table when a file is loaded and reads `U` from it
+ * the first time `get()` is called, so large optional subsystems cost nothing at startup unless
+ * the run uses them:
+ *
+ * @code
+ * struct PhysicsConfig {
+ *     bool diffusion = true;
+ *     fourdst::config::Lazy<OpacityTables> alternate_opacities;
+ * };
+ *
+ * const OpacityTables& tables = cfg->alternate_opacities.get(); // parsed here, once
+ * @endcode
+ *
+ * The first read happens exactly once even if several threads call `get()` concurrently, and
+ * copies of a field (such as those in snapshots) share it. The table is kept after the first
+ * read, so unread fields can be compared without deserializing them. A table that does not deserialize
+ * into `U` throws `exceptions::ConfigParseError` from every `get()` rather than from the load;
+ * the validator run by a failed load checks the table as a `U`. Other formats (JSON, the
+ * binary cache, saving) read and write the field as a `U` directly.
+ */
+#pragma once
+
+#include <atomic>
+#include <concepts>
+#include <format>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+#include "rfl/toml.hpp"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config {
+
+    /**
+     * @brief A field holding a `U` that is deserialized from TOML on first access.
+     * @tparam U The value type, a struct read from a TOML table.
+     */
+    template <typename U>
+    class Lazy {
+    public:
+        using value_type = U;
+
+        /**
+         * @brief Holds a default-constructed `U`.
+         */
+        Lazy() : Lazy(U{}) {}
+
+        /**
+         * @brief Holds `value`, already deserialized.
+         */
+        Lazy(U value) : m_state(std::make_shared<State>()) {  // NOLINT(google-explicit-constructor)
+            m_state->value.emplace(std::move(value));
+            std::call_once(m_state->once, [this] { m_state->loaded.store(true, std::memory_order_release); });
+        }
+
+        /**
+         * @brief Holds a TOML table to deserialize on first access.
+         */
+        static Lazy deferred(toml::table raw) {
+            Lazy lazy(Deferred{});
+            lazy.m_state->raw = std::move(raw);
+            return lazy;
+        }
+
+        /**
+         * @brief Returns the value, deserializing it on the first call.
+         * @throws exceptions::ConfigParseError If the stored table does not deserialize into `U`.
+         */
+        const U& get() const {
+            std::call_once(m_state->once, [state = m_state.get()] {
+                rfl::Result<U> result = rfl::toml::read<U>(&state->raw);
+                if (result) {
+                    state->value.emplace(std::move(result).value());
+                } else {
+                    state->error = result.error().what();
+                }
+                state->loaded.store(true, std::memory_order_release);
+            });
+            if (!m_state->value) {
+                throw exceptions::ConfigParseError(std::format("Failed to load lazy field. Reason: {}", m_state->error));
+            }
+            return *m_state->value;
+        }
+
+        const U& operator*() const { return get(); }
+        const U* operator->() const { return &get(); }
+
+        /**
+         * @brief Whether the value has been deserialized (or failed to).
+         */
+        [[nodiscard]] bool is_loaded() const { return m_state->loaded.load(std::memory_order_acquire); }
+
+        /**
+         * @brief Replaces the value; copies made earlier keep the old one.
+         */
+        Lazy& operator=(U value) {
+            *this = Lazy(std::move(value));
+            return *this;
+        }
+
+        /**
+         * @brief Compares with `other` without deserializing either side.
+         *
+         * Two fields read from equal tables are equal, as are two deserialized fields whose values
+         * `equal_values` accepts. A field not yet deserialized never equals one that is, so a
+         * reload that replaces an unused field reports it as changed instead of parsing it.
+         */
+        template <typename EqualValues>
+        bool equals(const Lazy& other, EqualValues&& equal_values) const {
+            if (m_state == other.m_state) return true;
+            const bool loaded = is_loaded();
+            if (loaded != other.is_loaded()) return false;
+            if (!loaded) return m_state->raw == other.m_state->raw;
+            if (!m_state->value || !other.m_state->value) return false;
+            return equal_values(*m_state->value, *other.m_state->value);
+        }
+
+        friend bool operator==(const Lazy& lhs, const Lazy& rhs)
+            requires std::equality_comparable<U>
+        {
+            return lhs.equals(rhs, std::equal_to<U>{});
+        }
+
+    private:
+        struct Deferred {};
+
+        struct State {
+            std::once_flag once;
+            std::atomic<bool> loaded = false;
+            toml::table raw;
+            std::optional<U> value;
+            std::string error;
+        };
+
+        explicit Lazy(Deferred) : m_state(std::make_shared<State>()) {}
+
+        std::shared_ptr<State> m_state;
+    };
+}
+
+namespace rfl {
+
+    /**
+     * @brief Reads and writes `Lazy<U>` as a `U` in formats without a deferred reader.
+     */
+    template <typename U>
+    struct Reflector<fourdst::config::Lazy<U>> {
+        using ReflType = U;
+
+        static fourdst::config::Lazy<U> to(const ReflType& value) { return fourdst::config::Lazy<U>(value); }
+
+        static ReflType from(const fourdst::config::Lazy<U>& value) { return value.get(); }
+    };
+}
+
+namespace rfl::parsing {
+
+    /**
+     * @brief Reads `Lazy<U>` from TOML by copying its table; `U` is read on first access.
+     */
+    template <class U, class ProcessorsType>
+    struct Parser<rfl::toml::Reader, rfl::toml::Writer, fourdst::config::Lazy<U>, ProcessorsType> {
+        using InputVarType = typename rfl::toml::Reader::InputVarType;
+        using ValueParser = Parser<rfl::toml::Reader, rfl::toml::Writer, U, ProcessorsType>;
+
+        static Result<fourdst::config::Lazy<U>> read(const rfl::toml::Reader&, const InputVarType& _var) noexcept {
+            const ::toml::table* table = _var->as_table();
+            if (table == nullptr) return error("Could not cast to a table!");
+            try {
+                return fourdst::config::Lazy<U>::deferred(*table);
+            } catch (const std::exception& e) {
+                return error(e.what());
+            }
+        }
+
+        template <class P>
+        static void write(const rfl::toml::Writer& _w, const fourdst::config::Lazy<U>& _lazy, const P& _parent) {
+            ValueParser::write(_w, _lazy.get(), _parent);
+        }
+
+        static schema::Type to_schema(std::map<std::string, schema::Type>* _definitions) {
+            return ValueParser::to_schema(_definitions);
+        }
+    };
+}
@@ -0,0 +1,329 @@
+/**
+ * @file limits.h
+ * @brief Limits on the size and shape of the documents a load accepts.
+ *
+ * toml++ and yyjson build a tree of the whole document before a single field is read, so a
+ * malformed or hostile deck (a generated array of a hundred million elements, thousands of
+ * nested brackets) costs its full parse tree in memory before anything can reject it.
+ * `Config::set_parse_limits()` sets a `ParseLimits`; a load then checks the file size before
+ * reading and makes one pass over the text with `check_parse_limits()` before handing it to the
+ * parser. The pass keeps no tree and stops at the first value past a limit, so an oversized
+ * input fails with a `ConfigParseError` pointing at it, after reading only that far.
+ *
+ * Text that is not valid TOML or JSON is left to the parser to report. The tree size is an
+ * estimate: `parse_node_bytes` per table, array, key and value, plus the bytes of strings and keys.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <format>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "fourdst/config/exceptions/exceptions.h"
+
+namespace fourdst::config {
+
+    /**
+     * @brief Bounds on the documents a load accepts; 0 leaves a bound off.
+     */
+    struct ParseLimits {
+        /// Largest file, or decompressed or in-memory document, in bytes.
+        std::size_t max_file_bytes = 0;
+        /// Most elements of one array, or tables of one array of tables.
+        std::size_t max_array_length = 0;
+        /// Deepest nesting of tables and arrays around a value; `[a.b]` holds its keys at depth 2.
+        std::size_t max_depth = 0;
+        /// Largest estimated parse tree in bytes.
+        std::size_t max_tree_bytes = 0;
+
+        /// Whether any bound is set.
+        [[nodiscard]] bool any() const {
+            return max_file_bytes != 0 || max_array_length != 0 || max_depth != 0 || max_tree_bytes != 0;
+        }
+
+        /// Whether a bound needs a pass over the text.
+        [[nodiscard]] bool scans() const {
+            return max_array_length != 0 || max_depth != 0 || max_tree_bytes != 0;
+        }
+    };
+
+    namespace io {
+
+        /// Estimated parse tree bytes per table, array, key or value; toml++ nodes and their slots are about this size.
+        inline constexpr std::size_t parse_node_bytes = 96;
+
+        /**
+         * @brief Throws the `ConfigParseError` for a document past its limits.
+         * @param offset Byte offset of the offending value, located as a line and column.
+         */
+        [[noreturn]] inline void throw_past_limits(const std::string_view text, const std::size_t offset, const std::string_view path,
+                                                   const std::string_view reason) {
+            const std::string_view before = text.substr(0, offset);
+            const std::size_t line = static_cast<std::size_t>(std::ranges::count(before, '\n')) + 1;
+            const std::size_t column = offset - (before.rfind('\n') + 1) + 1;
+            throw exceptions::ConfigParseError(
+                std::format("Config file {} exceeds its parse limits at line {}, column {}: {}", path, line, column, reason),
+                exceptions::ConfigParseError::Location{std::string(path), line, column, {}});
+        }
+
+        /**
+         * @brief Throws if the size of a document, in bytes, is past `limits`.
+         */
+        inline void check_document_size(const std::size_t size, const ParseLimits& limits, const std::string_view path) {
+            if (limits.max_file_bytes != 0 && size > limits.max_file_bytes) {
+                throw exceptions::ConfigParseError(
+                    std::format("Config file {} exceeds its parse limits: it is {} bytes, more than the {} allowed", path, size,
+                                limits.max_file_bytes),
+                    exceptions::ConfigParseError::Location{std::string(path), 0, 0, {}});
+            }
+        }
+
+        namespace detail {
+            /**
+             * @brief One pass over a TOML or JSON document that counts what its parse tree would hold.
+             *
+             * Containers are tracked on an explicit stack, so deep nesting costs no recursion.
+             */
+            class LimitScanner {
+            public:
+                LimitScanner(const std::string_view text, const ParseLimits& limits, const std::string_view path)
+                    : m_text(text), m_limits(limits), m_path(path) {}
+
+                void scan_toml() {
+                    std::size_t i = m_text.starts_with("\xEF\xBB\xBF") ? 3 : 0;
+                    std::size_t header_depth = 0;
+                    while (true) {
+                        i = skip_space(i, true);
+                        if (i >= m_text.size()) return;
+                        if (m_text[i] == '[') {
+                            const bool array = i + 1 < m_text.size() && m_text[i + 1] == '[';
+                            const std::size_t begin = i + (array ? 2 : 1);
+                            std::size_t segments = 0;
+                            const std::size_t end = read_key(begin, ']', segments);
+                            if (end == npos) return;
+                            header_depth = segments;
+                            check_depth(i, header_depth);
+                            add_node(i, 0);
+                            if (array) {
+                                // Keyed by the header as written, so `[[a.b]]` and `[[ a.b ]]` count apart; an estimate.
+                                const std::size_t count = ++m_table_arrays[m_text.substr(begin, end - begin)];
+                                check_length(i, count);
+                            }
+                            i = skip_line(end + (array ? 2 : 1));
+                            continue;
+                        }
+                        std::size_t segments = 0;
+                        const std::size_t equals = read_key(i, '=', segments);
+                        if (equals == npos) return;
+                        check_depth(i, header_depth + segments - 1);
+                        add_node(i, equals - i);
+                        i = scan_value(skip_space(equals + 1, false), static_cast<std::ptrdiff_t>(header_depth + segments - 1), false);
+                        if (i == npos) return;
+                        i = skip_line(i);
+                    }
+                }
+
+                void scan_json() {
+                    const std::size_t i = skip_space(m_text.starts_with("\xEF\xBB\xBF") ? 3 : 0, true);
+                    // The outer object is the document itself, not a level of nesting.
+                    if (i < m_text.size()) scan_value(i, -1, true);
+                }
+
+            private:
+                static constexpr std::size_t npos = std::string_view::npos;
+
+                struct Container {
+                    char close;
+                    std::size_t elements;
+                };
+
+                void add_node(const std::size_t at, const std::size_t bytes) {
+                    m_tree_bytes += parse_node_bytes + bytes;
+                    if (m_limits.max_tree_bytes != 0 && m_tree_bytes > m_limits.max_tree_bytes) {
+                        throw_past_limits(m_text, at, m_path,
+                                          std::format("the parse tree would take more than the {} bytes allowed", m_limits.max_tree_bytes));
+                    }
+                }
+
+                void check_depth(const std::size_t at, const std::size_t depth) const {
+                    if (m_limits.max_depth != 0 && depth > m_limits.max_depth) {
+                        throw_past_limits(m_text, at, m_path, std::format("values are nested more than the {} levels allowed", m_limits.max_depth));
+                    }
+                }
+
+                void check_length(const std::size_t at, const std::size_t length) const {
+                    if (m_limits.max_array_length != 0 && length > m_limits.max_array_length) {
+                        throw_past_limits(m_text, at, m_path,
+                                          std::format("an array has more than the {} elements allowed", m_limits.max_array_length));
+                    }
+                }
+
+                /// Skips blanks, and with `lines` also line breaks and comments.
+                [[nodiscard]] std::size_t skip_space(std::size_t i, const bool lines) const {
+                    while (i < m_text.size()) {
+                        const char c = m_text[i];
+                        if (c == ' ' || c == '\t' || (lines && (c == '\r' || c == '\n'))) {
+                            ++i;
+                        } else if (lines && c == '#') {
+                            while (i < m_text.size() && m_text[i] != '\n') ++i;
+                        } else {
+                            break;
+                        }
+                    }
+                    return i;
+                }
+
+                [[nodiscard]] std::size_t skip_line(std::size_t i) const {
+                    while (i < m_text.size() && m_text[i] != '\n') ++i;
+                    return i;
+                }
+
+                /// Returns the offset of `stop` after a dotted key, counting its segments, or `npos` if the line has none.
+                [[nodiscard]] std::size_t read_key(std::size_t i, const char stop, std::size_t& segments) const {
+                    segments = 1;
+                    while (i < m_text.size() && m_text[i] != stop) {
+                        const char c = m_text[i];
+                        if (c == '"' || c == '\'') {
+                            i = skip_string(i);
+                            if (i == npos) return npos;
+                            continue;
+                        }
+                        if (c == '\n' || c == '#') return npos;
+                        if (c == '.') ++segments;
+                        ++i;
+                    }
+                    return i < m_text.size() ? i : npos;
+                }
+
+                [[nodiscard]] std::size_t skip_string(std::size_t i) const {
+                    const char quote = m_text[i];
+                    const std::string_view triple = quote == '"' ? "\"\"\"" : "'''";
+                    if (m_text.substr(i, 3) == triple) {
+                        for (i += 3; i < m_text.size(); ++i) {
+                            if (quote == '"' && m_text[i] == '\\') {
+                                ++i;
+                            } else if (m_text.substr(i, 3) == triple) {
+                                // Up to two quotes may directly precede the closing delimiter.
+                                i += 3;
+                                while (i < m_text.size() && m_text[i] == quote) ++i;
+                                return i;
+                            }
+                        }
+                        return npos;
+                    }
+                    for (++i; i < m_text.size() && m_text[i] != '\n'; ++i) {
+                        if (quote == '"' && m_text[i] == '\\') {
+                            ++i;
+                        } else if (m_text[i] == quote) {
+                            return i + 1;
+                        }
+                    }
+                    return npos;
+                }
+
+                /**
+                 * @brief Scans the value at `i`, whose containers nest below `base` levels; returns the offset past it.
+                 */
+                std::size_t scan_value(std::size_t i, const std::ptrdiff_t base, const bool json) {
+                    std::vector<Container> stack;
+                    while (true) {
+                        // At the start of a value.
+                        if (i >= m_text.size()) return npos;
+                        const char c = m_text[i];
+                        if (c == '"' || c == '\'') {
+                            const std::size_t end = skip_string(i);
+                            if (end == npos) return npos;
+                            add_node(i, end - i);
+                            i = end;
+                        } else if (c == '[' || c == '{') {
+                            add_node(i, 0);
+                            stack.push_back({c == '[' ? ']' : '}', 0});
+                            check_depth(i, static_cast<std::size_t>(std::max<std::ptrdiff_t>(base + static_cast<std::ptrdiff_t>(stack.size()), 0)));
+                            i = skip_space(i + 1, true);
+                            if (i < m_text.size() && m_text[i] == stack.back().close) {
+                                stack.pop_back();
+                                ++i;
+                            } else {
+                                i = open_element(i, stack.back(), json);
+                                if (i == npos) return npos;
+                                continue;
+                            }
+                        } else {
+                            const std::size_t begin = i;
+                            while (i < m_text.size() && std::string_view(",]}\r\n#").find(m_text[i]) == std::string_view::npos) ++i;
+                            if (i == begin) return npos;
+                            add_node(begin, 0);
+                        }
+
+                        // After a value: close containers until one has a next element.
+                        while (true) {
+                            if (stack.empty()) return i;
+                            i = skip_space(i, true);
+                            if (i >= m_text.size()) return npos;
+                            if (m_text[i] == ',') {
+                                i = skip_space(i + 1, true);
+                                // TOML allows a trailing comma in arrays.
+                                if (i < m_text.size() && m_text[i] == stack.back().close) {
+                                    stack.pop_back();
+                                    ++i;
+                                    continue;
+                                }
+                                i = open_element(i, stack.back(), json);
+                                if (i == npos) return npos;
+                                break;
+                            }
+                            if (m_text[i] != stack.back().close) return npos;
+                            stack.pop_back();
+                            ++i;
+                        }
+                    }
+                }
+
+                /// Counts the element of `container` at `i` and returns where its value starts.
+                std::size_t open_element(std::size_t i, Container& container, const bool json) {
+                    ++container.elements;
+                    if (container.close == ']') {
+                        check_length(i, container.elements);
+                        return i;
+                    }
+                    std::size_t segments = 0;
+                    const std::size_t separator = read_key(i, json ? ':' : '=', segments);
+                    if (separator == npos) return npos;
+                    add_node(i, separator - i);
+                    return skip_space(separator + 1, json);
+                }
+
+                std::string_view m_text;
+                const ParseLimits& m_limits;
+                std::string_view m_path;
+                std::size_t m_tree_bytes = 0;
+                std::unordered_map<std::string_view, std::size_t> m_table_arrays;
+            };
+        }
+
+        /**
+         * @brief Throws if the document `text` is past `limits`, without building its parse tree.
+         *
+         * @param text The document.
+         * @param limits The limits.
+         * @param path The file name for the message.
+         * @param json True for a JSON document, false for TOML.
+         * @throws exceptions::ConfigParseError Naming the first value past a limit and its line and column.
+         */
+        inline void check_parse_limits(const std::string_view text, const ParseLimits& limits, const std::string_view path,
+                                       const bool json = false) {
+            check_document_size(text.size(), limits, path);
+            if (!limits.scans()) return;
+            detail::LimitScanner scanner(text, limits, path);
+            if (json) {
+                scanner.scan_json();
+            } else {
+                scanner.scan_toml();
+            }
+        }
+    }
+}
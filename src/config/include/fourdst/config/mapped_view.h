@@ -0,0 +1,585 @@
+/**
+ * @file mapped_view.h
+ * @brief `ConfigView<T>`: reading a config straight out of a memory-mapped file, with no deserialization.
+ *
+ * The binary cache (`cache.h`) skips parsing but still decodes every field into a `T`. A view file
+ * stores `T` in an offset-based layout instead, so `ConfigView<T>::open()` only maps the file and
+ * checks its header; each access reads the bytes of that one field in place, and the kernel faults
+ * in only the pages of the fields a run actually uses:
+ *
+ * @code
+ * fourdst::config::ConfigView<Deck>::write(cfg.main(), "deck.view");   // once, after loading the TOML
+ *
+ * const auto deck = fourdst::config::ConfigView<Deck>::open("deck.view");
+ * const double tolerance = deck.get<"solver.tolerance">();
+ * const std::string_view name = deck.get<"name">();
+ * const std::span<const double> kappa = deck.get<"opacity.kappa">();   // no copy
+ * const auto species = deck.get<"species">();                          // MappedArray<Species>
+ * const double mass = species[3].get<"mass">();
+ * @endcode
+ *
+ * Values are returned as:
+ *
+ * | field type                                   | returned as                  |
+ * |----------------------------------------------|------------------------------|
+ * | number, `bool`, enum                         | the value                    |
+ * | string                                       | `std::string_view`           |
+ * | vector or `std::array` of numbers or enums   | `std::span<const E>`         |
+ * | other vector or `std::array`                 | `MappedArray<E>`             |
+ * | `std::optional<E>`                           | `std::optional` of the above |
+ * | string-keyed map                             | `MappedMap<V>`               |
+ * | nested struct                                | `MappedTable<S>`             |
+ *
+ * Layout (native endianness, every offset from the start of the file): a header
+ * | magic "4DCFGVEW" | u32 version | u32 byte-order mark | u64 schema fingerprint | u64 root | u64 file size |
+ * followed by blocks, each 8-byte aligned. A struct is a table of one 8-byte slot per field, in
+ * declaration order; a slot holds a number, `bool` or enum inline and the offset of a block for
+ * everything else (0 for an empty optional). A string is its length and bytes; a number array is
+ * its length and the offset of its elements, aligned to 64 bytes; any other array is its length
+ * and one slot per element; a map is its length and (key offset, value slot) pairs sorted by key,
+ * found by binary search.
+ *
+ * The schema must be plain (`io::is_binary_encodable_v`, with string keys and numbers of at most
+ * 8 bytes; see `is_viewable_v`). `open()` rejects files written for another schema or byte order;
+ * the offsets inside are trusted, so only open view files this library wrote.
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/binary.h"
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/io.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+
+namespace fourdst::config {
+
+    template <typename S>
+    class MappedTable;
+
+    template <typename E>
+    class MappedArray;
+
+    template <typename V>
+    class MappedMap;
+
+    namespace detail {
+        inline constexpr std::string_view view_magic = "4DCFGVEW";
+        inline constexpr std::uint32_t view_version = 1;
+        inline constexpr std::uint32_t view_byte_order_mark = 0x01020304;
+        inline constexpr std::size_t view_header_bytes = 40;
+        /// Alignment of the elements of number arrays, for aligned vector loads.
+        inline constexpr std::size_t view_array_alignment = 64;
+
+        template <typename Type>
+        constexpr bool is_view_scalar_v = (std::is_arithmetic_v<Type> || std::is_enum_v<Type>) && sizeof(Type) <= 8;
+
+        /// Element types whose arrays are stored contiguously and returned as spans.
+        template <typename Type>
+        constexpr bool is_view_span_element_v = is_view_scalar_v<Type> && !std::is_same_v<Type, bool>;
+
+        template <typename Type>
+        struct viewable;
+
+        template <typename Type>
+        constexpr bool is_viewable_v = viewable<std::remove_cvref_t<Type>>::value;
+
+        template <typename Fields>
+        struct viewable_fields;
+
+        template <typename... Fields>
+        struct viewable_fields<rfl::Tuple<Fields...>> : std::bool_constant<(is_viewable_v<typename Fields::Type> && ...)> {};
+
+        template <typename Type>
+        struct viewable {
+            static constexpr bool compute() {
+                if constexpr (is_view_scalar_v<Type> || validate::is_std_string_v<Type>) {
+                    return true;
+                } else if constexpr (validate::is_optional_v<Type> || validate::is_vector_v<Type> || validate::is_std_array_v<Type>) {
+                    return is_viewable_v<typename Type::value_type>;
+                } else if constexpr (validate::is_map_v<Type>) {
+                    return validate::is_std_string_v<typename Type::key_type> && is_viewable_v<typename Type::mapped_type>;
+                } else if constexpr (io::detail::is_codec_struct_v<Type>) {
+                    return viewable_fields<typename rfl::named_tuple_t<Type>::Fields>::value;
+                } else {
+                    return false;
+                }
+            }
+            static constexpr bool value = compute();
+        };
+
+        template <typename Type>
+        struct view_type {
+            using type = Type;
+        };
+
+        /// What reading a field of type `Type` from a view returns.
+        template <typename Type>
+        using view_t = typename view_type<std::remove_cvref_t<Type>>::type;
+
+        template <typename Type>
+            requires validate::is_std_string_v<Type>
+        struct view_type<Type> {
+            using type = std::string_view;
+        };
+
+        template <typename Type>
+            requires validate::is_optional_v<Type>
+        struct view_type<Type> {
+            using type = std::optional<view_t<typename Type::value_type>>;
+        };
+
+        template <typename Type>
+            requires validate::is_vector_v<Type>
+        struct view_type<Type> {
+            using Element = typename Type::value_type;
+            using type = std::conditional_t<is_view_span_element_v<Element>, std::span<const Element>, MappedArray<Element>>;
+        };
+
+        template <typename Type>
+            requires validate::is_std_array_v<Type>
+        struct view_type<Type> {
+            using Element = typename Type::value_type;
+            using type = std::conditional_t<is_view_span_element_v<Element>, std::span<const Element, std::tuple_size_v<Type>>,
+                                            MappedArray<Element>>;
+        };
+
+        template <typename Type>
+            requires validate::is_map_v<Type>
+        struct view_type<Type> {
+            using type = MappedMap<typename Type::mapped_type>;
+        };
+
+        template <typename Type>
+            requires io::detail::is_codec_struct_v<Type>
+        struct view_type<Type> {
+            using type = MappedTable<Type>;
+        };
+
+        /// Constructs tables, arrays and maps at an offset of a mapping.
+        struct ViewAccess {
+            template <typename Mapped>
+            static Mapped make(const std::byte* base, const std::uint64_t offset) noexcept {
+                return Mapped(base, offset);
+            }
+        };
+
+        inline std::uint64_t read_word(const std::byte* base, const std::uint64_t offset) noexcept {
+            std::uint64_t word;
+            std::memcpy(&word, base + offset, sizeof(word));
+            return word;
+        }
+
+        inline std::string_view read_string(const std::byte* base, const std::uint64_t offset) noexcept {
+            return {reinterpret_cast<const char*>(base + offset + 8), static_cast<std::size_t>(read_word(base, offset))};
+        }
+
+        /**
+         * @brief Reads the value of type `Type` whose slot holds `slot`.
+         */
+        template <typename Type>
+        view_t<Type> read_slot(const std::byte* base, const std::uint64_t slot) {
+            if constexpr (is_view_scalar_v<Type>) {
+                Type value;
+                std::memcpy(&value, &slot, sizeof(Type));
+                return value;
+            } else if constexpr (validate::is_std_string_v<Type>) {
+                return read_string(base, slot);
+            } else if constexpr (validate::is_optional_v<Type>) {
+                if (slot == 0) return std::nullopt;
+                return read_slot<typename Type::value_type>(base, read_word(base, slot));
+            } else if constexpr (validate::is_vector_v<Type> || validate::is_std_array_v<Type>) {
+                using Element = typename Type::value_type;
+                if constexpr (is_view_span_element_v<Element>) {
+                    const auto* data = reinterpret_cast<const Element*>(base + read_word(base, slot + 8));
+                    return view_t<Type>(data, static_cast<std::size_t>(read_word(base, slot)));
+                } else {
+                    return ViewAccess::make<MappedArray<Element>>(base, slot);
+                }
+            } else if constexpr (validate::is_map_v<Type>) {
+                return ViewAccess::make<MappedMap<typename Type::mapped_type>>(base, slot);
+            } else {
+                return ViewAccess::make<MappedTable<Type>>(base, slot);
+            }
+        }
+
+        /**
+         * @brief The index of the field named `name` of `S`, or -1.
+         */
+        template <typename S>
+        consteval int view_field_index(const std::string_view name) {
+            using Fields = typename rfl::named_tuple_t<S>::Fields;
+            return [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                int found = -1;
+                ((rfl::tuple_element_t<Is, Fields>::name() == name ? (found = Is) : 0), ...);
+                return found;
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        }
+
+        /**
+         * @brief Appends `T` to a buffer in the view layout.
+         *
+         * Blocks are written before the slots that point at them, so a table is reserved only
+         * once all of its fields have been placed.
+         */
+        class ViewWriter {
+        public:
+            explicit ViewWriter(std::string& out) : m_out(out) {}
+
+            template <typename Type>
+            std::uint64_t slot_of(const Type& value) {
+                if constexpr (is_view_scalar_v<Type>) {
+                    std::uint64_t slot = 0;
+                    std::memcpy(&slot, &value, sizeof(Type));
+                    return slot;
+                } else if constexpr (validate::is_std_string_v<Type>) {
+                    return place_string(value);
+                } else if constexpr (validate::is_optional_v<Type>) {
+                    if (!value.has_value()) return 0;
+                    const std::uint64_t inner = slot_of(*value);
+                    const std::uint64_t offset = begin_block();
+                    put(inner);
+                    return offset;
+                } else if constexpr (validate::is_vector_v<Type> || validate::is_std_array_v<Type>) {
+                    using Element = typename Type::value_type;
+                    if constexpr (is_view_span_element_v<Element>) {
+                        const std::uint64_t offset = begin_block();
+                        put(value.size());
+                        put(0);
+                        pad_to(view_array_alignment);
+                        const std::uint64_t data = m_out.size();
+                        m_out.append(reinterpret_cast<const char*>(value.data()), value.size() * sizeof(Element));
+                        std::memcpy(m_out.data() + offset + 8, &data, sizeof(data));
+                        return offset;
+                    } else {
+                        std::vector<std::uint64_t> slots;
+                        slots.reserve(value.size());
+                        for (const auto& element : value) slots.push_back(slot_of(static_cast<const Element&>(element)));
+                        const std::uint64_t offset = begin_block();
+                        put(slots.size());
+                        for (const std::uint64_t slot : slots) put(slot);
+                        return offset;
+                    }
+                } else if constexpr (validate::is_map_v<Type>) {
+                    std::vector<std::pair<std::string_view, std::uint64_t>> entries;
+                    entries.reserve(value.size());
+                    for (const auto& [key, mapped] : value) entries.emplace_back(key, slot_of(mapped));
+                    std::ranges::sort(entries, {}, &std::pair<std::string_view, std::uint64_t>::first);
+                    std::vector<std::uint64_t> keys;
+                    keys.reserve(entries.size());
+                    for (const auto& entry : entries) keys.push_back(place_string(entry.first));
+                    const std::uint64_t offset = begin_block();
+                    put(entries.size());
+                    for (std::size_t i = 0; i < entries.size(); ++i) {
+                        put(keys[i]);
+                        put(entries[i].second);
+                    }
+                    return offset;
+                } else {
+                    return place_table(value);
+                }
+            }
+
+        private:
+            template <typename S>
+            std::uint64_t place_table(const S& value) {
+                const auto view = rfl::to_view(value);
+                using Values = std::remove_cvref_t<decltype(view.values())>;
+                constexpr std::size_t count = rfl::tuple_size_v<Values>;
+                std::array<std::uint64_t, count> slots{};
+                [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                    ((slots[Is] = slot_of(*rfl::get<Is>(view.values()))), ...);
+                }(std::make_integer_sequence<int, static_cast<int>(count)>{});
+                const std::uint64_t offset = begin_block();
+                for (const std::uint64_t slot : slots) put(slot);
+                return offset;
+            }
+
+            std::uint64_t place_string(const std::string_view text) {
+                const std::uint64_t offset = begin_block();
+                put(text.size());
+                m_out.append(text);
+                m_out.push_back('\0');
+                return offset;
+            }
+
+            std::uint64_t begin_block() {
+                pad_to(8);
+                return m_out.size();
+            }
+
+            void pad_to(const std::size_t alignment) { m_out.append((alignment - m_out.size() % alignment) % alignment, '\0'); }
+
+            void put(const std::uint64_t word) { m_out.append(reinterpret_cast<const char*>(&word), sizeof(word)); }
+
+            std::string& m_out;
+        };
+    }
+
+    /**
+     * @brief Whether `T` can be written to and read from a view file.
+     * @tparam T The configuration schema type.
+     */
+    template <typename T>
+    constexpr bool is_viewable_v = io::detail::is_codec_struct_v<T> && detail::is_viewable_v<T>;
+
+    /**
+     * @brief A struct of type `S` inside a view file; `get<"name">()` reads one field.
+     */
+    template <typename S>
+    class MappedTable {
+    public:
+        /**
+         * @brief Reads the field at the dotted path `Path`, e.g. `"solver.tolerance"`; unknown paths do not compile.
+         */
+        template <rfl::internal::StringLiteral Path>
+        [[nodiscard]] auto get() const {
+            return resolve<S, Path, 0>(m_table);
+        }
+
+    private:
+        template <typename Table, rfl::internal::StringLiteral Path, std::size_t Begin>
+        auto resolve(const std::uint64_t table) const {
+            constexpr std::string_view rest = Path.string_view().substr(Begin);
+            constexpr std::size_t dot = rest.find('.');
+            constexpr int index = detail::view_field_index<Table>(rest.substr(0, dot));
+            static_assert(index >= 0, "No field with this name in the schema.");
+            using Field = std::remove_cvref_t<typename rfl::tuple_element_t<index, typename rfl::named_tuple_t<Table>::Fields>::Type>;
+            const std::uint64_t slot = detail::read_word(m_base, table + 8 * static_cast<std::uint64_t>(index));
+            if constexpr (dot == std::string_view::npos) {
+                return detail::read_slot<Field>(m_base, slot);
+            } else {
+                static_assert(io::detail::is_codec_struct_v<Field>, "Only struct fields have named members.");
+                return resolve<Field, Path, Begin + dot + 1>(slot);
+            }
+        }
+
+        MappedTable(const std::byte* base, const std::uint64_t table) noexcept : m_base(base), m_table(table) {}
+
+        friend struct detail::ViewAccess;
+
+        const std::byte* m_base;
+        std::uint64_t m_table;
+    };
+
+    /**
+     * @brief An array of `E` inside a view file, read one element at a time.
+     */
+    template <typename E>
+    class MappedArray {
+    public:
+        class iterator {
+        public:
+            using value_type = detail::view_t<E>;
+            using difference_type = std::ptrdiff_t;
+
+            iterator() = default;
+            iterator(const MappedArray* array, const std::size_t index) noexcept : m_array(array), m_index(index) {}
+
+            value_type operator*() const { return (*m_array)[m_index]; }
+            iterator& operator++() noexcept {
+                ++m_index;
+                return *this;
+            }
+            iterator operator++(int) noexcept {
+                iterator previous = *this;
+                ++m_index;
+                return previous;
+            }
+            bool operator==(const iterator& other) const noexcept { return m_index == other.m_index; }
+
+        private:
+            const MappedArray* m_array = nullptr;
+            std::size_t m_index = 0;
+        };
+
+        [[nodiscard]] std::size_t size() const noexcept { return static_cast<std::size_t>(detail::read_word(m_base, m_block)); }
+        [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+        /**
+         * @brief Reads element `i`; `i` must be less than `size()`.
+         */
+        [[nodiscard]] detail::view_t<E> operator[](const std::size_t i) const {
+            return detail::read_slot<E>(m_base, detail::read_word(m_base, m_block + 8 * (i + 1)));
+        }
+
+        [[nodiscard]] iterator begin() const noexcept { return {this, 0}; }
+        [[nodiscard]] iterator end() const noexcept { return {this, size()}; }
+
+    private:
+        MappedArray(const std::byte* base, const std::uint64_t block) noexcept : m_base(base), m_block(block) {}
+
+        friend struct detail::ViewAccess;
+
+        const std::byte* m_base;
+        std::uint64_t m_block;
+    };
+
+    /**
+     * @brief A string-keyed map inside a view file; keys are sorted, so `find()` is a binary search.
+     */
+    template <typename V>
+    class MappedMap {
+    public:
+        [[nodiscard]] std::size_t size() const noexcept { return static_cast<std::size_t>(detail::read_word(m_base, m_block)); }
+        [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+        /**
+         * @brief Returns the key of entry `i`, in ascending order; `i` must be less than `size()`.
+         */
+        [[nodiscard]] std::string_view key(const std::size_t i) const noexcept {
+            return detail::read_string(m_base, detail::read_word(m_base, m_block + 8 + 16 * i));
+        }
+
+        /**
+         * @brief Reads the value of entry `i`; `i` must be less than `size()`.
+         */
+        [[nodiscard]] detail::view_t<V> value(const std::size_t i) const {
+            return detail::read_slot<V>(m_base, detail::read_word(m_base, m_block + 16 + 16 * i));
+        }
+
+        /**
+         * @brief Reads the value mapped to `name`, or nothing.
+         */
+        [[nodiscard]] std::optional<detail::view_t<V>> find(const std::string_view name) const {
+            const std::size_t i = lower_bound(name);
+            if (i == size() || key(i) != name) return std::nullopt;
+            return value(i);
+        }
+
+        [[nodiscard]] bool contains(const std::string_view name) const noexcept {
+            const std::size_t i = lower_bound(name);
+            return i != size() && key(i) == name;
+        }
+
+    private:
+        MappedMap(const std::byte* base, const std::uint64_t block) noexcept : m_base(base), m_block(block) {}
+
+        std::size_t lower_bound(const std::string_view name) const noexcept {
+            std::size_t first = 0;
+            std::size_t count = size();
+            while (count > 0) {
+                const std::size_t half = count / 2;
+                if (key(first + half) < name) {
+                    first += half + 1;
+                    count -= half + 1;
+                } else {
+                    count = half;
+                }
+            }
+            return first;
+        }
+
+        friend struct detail::ViewAccess;
+
+        const std::byte* m_base;
+        std::uint64_t m_block;
+    };
+
+    /**
+     * @brief A read-only config of schema `T` in a memory-mapped view file.
+     *
+     * Tables, arrays, maps, spans and string views read from it point into the mapping and are
+     * valid while the `ConfigView` lives; moving it keeps them valid.
+     *
+     * @tparam T The configuration schema type; must satisfy `is_viewable_v`.
+     */
+    template <typename T>
+    class ConfigView {
+        static_assert(is_viewable_v<T>, "ConfigView needs a plain schema of numbers, strings, arrays, string-keyed maps and structs.");
+
+    public:
+        /**
+         * @brief Maps the view file at `path` and checks its header.
+         * @throws exceptions::ConfigLoadError If the file cannot be mapped, is not a view file, or was
+         *         written for another schema, format version or byte order.
+         */
+        [[nodiscard]] static ConfigView open(const std::string& path) {
+            io::MappedFile file(path, io::ReadMode::MAP_RANDOM);
+            const std::string_view data = file.view();
+            const auto* base = reinterpret_cast<const std::byte*>(data.data());
+            const auto fail = [&](const std::string_view reason) {
+                return exceptions::ConfigLoadError(std::format("Invalid config view file {}: {}", path, reason));
+            };
+            if (data.size() < detail::view_header_bytes || !data.starts_with(detail::view_magic)) throw fail("not a view file");
+            std::uint32_t version = 0;
+            std::uint32_t byte_order = 0;
+            std::memcpy(&version, base + 8, sizeof(version));
+            std::memcpy(&byte_order, base + 12, sizeof(byte_order));
+            if (version != detail::view_version) throw fail(std::format("format version {}, expected {}", version, detail::view_version));
+            if (byte_order != detail::view_byte_order_mark) throw fail("written with another byte order");
+            if (detail::read_word(base, 16) != io::schema_fingerprint_v<T>) throw fail("written for another schema");
+            const std::uint64_t root = detail::read_word(base, 24);
+            if (detail::read_word(base, 32) != data.size() || root < detail::view_header_bytes || root >= data.size()) {
+                throw fail("truncated");
+            }
+            return ConfigView(std::move(file), root);
+        }
+
+        /**
+         * @brief Writes `content` to `path` as a view file, atomically.
+         * @throws exceptions::ConfigSaveError If the file cannot be written.
+         */
+        static void write(const T& content, const std::string& path) {
+            const std::string bytes = encode(content);
+            io::AtomicFileSink sink(path, false);
+            sink.write(bytes);
+            sink.commit();
+        }
+
+        /**
+         * @brief Returns `content` in the view layout, header included.
+         */
+        [[nodiscard]] static std::string encode(const T& content) {
+            std::string out;
+            out.append(detail::view_magic);
+            const std::array<std::uint32_t, 2> marks{detail::view_version, detail::view_byte_order_mark};
+            out.append(reinterpret_cast<const char*>(marks.data()), sizeof(marks));
+            out.append(detail::view_header_bytes - out.size(), '\0');
+            const std::uint64_t root = detail::ViewWriter(out).slot_of(content);
+            const std::array<std::uint64_t, 3> words{io::schema_fingerprint_v<T>, root, out.size()};
+            std::memcpy(out.data() + 16, words.data(), sizeof(words));
+            return out;
+        }
+
+        /**
+         * @brief Returns the root table.
+         */
+        [[nodiscard]] MappedTable<T> root() const noexcept { return detail::ViewAccess::make<MappedTable<T>>(base(), m_root); }
+
+        /**
+         * @brief Reads the field at the dotted path `Path` of the root table.
+         */
+        template <rfl::internal::StringLiteral Path>
+        [[nodiscard]] auto get() const {
+            return root().template get<Path>();
+        }
+
+        /**
+         * @brief Returns the size of the mapped file in bytes.
+         */
+        [[nodiscard]] std::size_t size_bytes() const noexcept { return m_file.size(); }
+
+    private:
+        ConfigView(io::MappedFile file, const std::uint64_t root) : m_file(std::move(file)), m_root(root) {}
+
+        const std::byte* base() const noexcept { return reinterpret_cast<const std::byte*>(m_file.view().data()); }
+
+        io::MappedFile m_file;
+        std::uint64_t m_root;
+    };
+}
@@ -0,0 +1,264 @@
+/**
+ * @file memory.h
+ * @brief Per-field memory footprint of configuration content.
+ *
+ * `Config::memory_report()` walks the content of a config along the entries of `detail::PathTable`
+ * and, for every field path (the same paths `Config::get()` accepts), adds up the bytes the field occupies inside its parent
+ * (`sizeof`) and the heap memory it owns: string and vector capacity, map nodes, and recursively
+ * the heap of their elements. Capacity that was allocated but is not in use is reported
+ * separately, since `shrink_to_fit` would give it back.
+ *
+ * Heap sizes are computed from capacities and node sizes, not measured from the allocator, so
+ * allocator bookkeeping is not included and map nodes are estimated. `std::string_view` fields
+ * point into storage the config shares between snapshots and are counted as their `sizeof` only;
+ * a `Lazy` field that has not been read yet is counted without its stored table.
+ */
+#pragma once
+
+#include <cstddef>
+#include <format>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/lazy.h"
+#include "fourdst/config/path_table.h"
+#include "fourdst/config/soa.h"
+#include "fourdst/config/tensor.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+
+namespace fourdst::config {
+
+    /**
+     * @brief Memory held by one field, or by a whole subtree.
+     */
+    struct MemoryUsage {
+        /// Bytes occupied inside the parent object (`sizeof`).
+        std::size_t inline_bytes = 0;
+        /// Bytes of heap memory owned by the field, including unused capacity.
+        std::size_t heap_bytes = 0;
+        /// The part of `heap_bytes` that is reserved capacity not holding any element.
+        std::size_t unused_bytes = 0;
+
+        /// Inline plus heap bytes.
+        [[nodiscard]] std::size_t total() const { return inline_bytes + heap_bytes; }
+
+        MemoryUsage& operator+=(const MemoryUsage& other) {
+            inline_bytes += other.inline_bytes;
+            heap_bytes += other.heap_bytes;
+            unused_bytes += other.unused_bytes;
+            return *this;
+        }
+    };
+
+    /**
+     * @brief The memory footprint of a configuration, per field path.
+     */
+    struct MemoryReport {
+        struct Entry {
+            /// Dotted field path.
+            std::string path;
+            /// Nesting depth; 0 for fields of the root struct.
+            std::size_t depth = 0;
+            /// The memory of the field, including every field nested in it.
+            MemoryUsage usage;
+        };
+
+        /// The root name of the config, used as the title of the tree.
+        std::string root_name;
+        /// The whole content: `sizeof(T)` plus all heap memory.
+        MemoryUsage total;
+        /// Every field, in schema (pre-)order.
+        std::vector<Entry> entries;
+
+        /**
+         * @brief Returns the usage of the field at `path`, or null if there is no such field.
+         */
+        [[nodiscard]] const MemoryUsage* find(const std::string_view path) const {
+            for (const auto& entry : entries) {
+                if (entry.path == path) return &entry.usage;
+            }
+            return nullptr;
+        }
+
+        /**
+         * @brief Renders the report as a tree, in the style of `validate::report_all_missing_fields`.
+         *
+         * @code
+         * Configuration Memory [main]: 1.4 KiB (1.2 KiB heap, 96 B unused)
+         * ├── description: 32 B
+         * ├── species: 1.1 KiB (1.0 KiB heap, 96 B unused)
+         * └── simulation: 24 B
+         *     ├── time_step: 8 B
+         * ...
+         * @endcode
+         */
+        [[nodiscard]] std::string str() const {
+            std::string output = std::format("\nConfiguration Memory [{}]: {}\n", root_name, describe(total));
+            std::vector<bool> last_at_depth;
+            for (std::size_t i = 0; i < entries.size(); ++i) {
+                const Entry& entry = entries[i];
+                std::size_t next = i + 1;
+                while (next < entries.size() && entries[next].depth > entry.depth) ++next;
+                const bool is_last = next == entries.size() || entries[next].depth < entry.depth;
+
+                last_at_depth.resize(entry.depth + 1);
+                last_at_depth[entry.depth] = is_last;
+                std::string indent;
+                for (std::size_t d = 0; d < entry.depth; ++d) indent += last_at_depth[d] ? "    " : "│   ";
+
+                const std::size_t dot = entry.path.rfind('.');
+                const std::string_view name = dot == std::string::npos ? std::string_view(entry.path) : std::string_view(entry.path).substr(dot + 1);
+                output += std::format("{}{} {}: {}\n", indent, is_last ? "└──" : "├──", name, describe(entry.usage));
+            }
+            return output;
+        }
+
+    private:
+        static std::string bytes(const std::size_t count) {
+            if (count < 1024) return std::format("{} B", count);
+            if (count < 1024 * 1024) return std::format("{:.1f} KiB", static_cast<double>(count) / 1024.0);
+            return std::format("{:.1f} MiB", static_cast<double>(count) / (1024.0 * 1024.0));
+        }
+
+        static std::string describe(const MemoryUsage& usage) {
+            if (usage.heap_bytes == 0) return bytes(usage.total());
+            if (usage.unused_bytes == 0) return std::format("{} ({} heap)", bytes(usage.total()), bytes(usage.heap_bytes));
+            return std::format("{} ({} heap, {} unused)", bytes(usage.total()), bytes(usage.heap_bytes), bytes(usage.unused_bytes));
+        }
+    };
+
+    namespace detail {
+        /// Pointers a `std::map` node carries besides its value (three links and the color, padded).
+        inline constexpr std::size_t map_node_overhead = 4 * sizeof(void*);
+        /// Per-node overhead of a `std::unordered_map`: the next pointer and the cached hash.
+        inline constexpr std::size_t hash_node_overhead = sizeof(void*) + sizeof(std::size_t);
+
+        /**
+         * @brief Returns the heap memory owned by `value`, not counting `sizeof(value)` itself.
+         */
+        template <typename V>
+        MemoryUsage heap_usage(const V& value) {
+            using Type = std::remove_cvref_t<V>;
+            MemoryUsage usage;
+            if constexpr (validate::is_std_string_v<Type>) {
+                // Short strings live in the object itself.
+                const auto* begin = reinterpret_cast<const char*>(&value);
+                const bool inline_buffer = value.data() >= begin && value.data() < begin + sizeof(Type);
+                if (!inline_buffer) {
+                    usage.heap_bytes = value.capacity() + 1;
+                    usage.unused_bytes = value.capacity() - value.size();
+                }
+            } else if constexpr (validate::is_optional_v<Type>) {
+                if (value.has_value()) usage = heap_usage(*value);
+            } else if constexpr (validate::is_lazy_v<Type>) {
+                if (value.is_loaded()) {
+                    try {
+                        usage = heap_usage(value.get());
+                        usage.heap_bytes += sizeof(typename Type::value_type);
+                    } catch (const exceptions::ConfigParseError&) {
+                        // A field that failed to deserialize holds no value.
+                    }
+                }
+            } else if constexpr (validate::is_sharded_v<Type>) {
+                usage = heap_usage(value.entries());
+            } else if constexpr (validate::is_section_v<Type>) {
+                // The contents are owned by the section cache and shared between configs.
+                usage = heap_usage(value.path());
+            } else if constexpr (validate::is_tunable_v<Type>) {
+                usage.heap_bytes = sizeof(typename Type::value_type);
+            } else if constexpr (validate::is_quantity_v<Type> || validate::is_stored_v<Type>) {
+                // Held inline.
+            } else if constexpr (validate::is_tagged_union_v<Type>) {
+                rfl::visit([&](const auto& alternative) { usage = heap_usage(alternative); }, value.variant());
+            } else if constexpr (validate::is_soa_v<Type>) {
+                std::apply([&](const auto&... column) { ((usage += heap_usage(column)), ...); }, value.columns());
+            } else if constexpr (validate::is_tensor_v<Type>) {
+                usage.heap_bytes = value.size() * sizeof(typename Type::value_type);
+            } else if constexpr (validate::is_sink_v<Type>) {
+                // Elements streamed to a target are in the caller's memory.
+                usage.heap_bytes = value.held().size() * sizeof(typename Type::value_type);
+            } else if constexpr (validate::is_vector_v<Type>) {
+                using Element = typename Type::value_type;
+                if constexpr (std::is_same_v<Element, bool>) {
+                    usage.heap_bytes = (value.capacity() + 7) / 8;
+                    usage.unused_bytes = (value.capacity() - value.size()) / 8;
+                } else {
+                    usage.heap_bytes = value.capacity() * sizeof(Element);
+                    usage.unused_bytes = (value.capacity() - value.size()) * sizeof(Element);
+                    for (const auto& element : value) usage += heap_usage(element);
+                }
+            } else if constexpr (is_std_array_v<Type>) {
+                for (const auto& element : value) usage += heap_usage(element);
+            } else if constexpr (validate::is_map_v<Type>) {
+                using Node = typename Type::value_type;
+                if constexpr (validate::is_flat_map_v<Type>) {
+                    usage.heap_bytes = value.capacity() * sizeof(Node);
+                    usage.unused_bytes = (value.capacity() - value.size()) * sizeof(Node);
+                } else if constexpr (requires { value.bucket_count(); }) {
+                    usage.heap_bytes = value.size() * (sizeof(Node) + hash_node_overhead) + value.bucket_count() * sizeof(void*);
+                } else {
+                    usage.heap_bytes = value.size() * (sizeof(Node) + map_node_overhead);
+                }
+                for (const auto& [key, mapped] : value) {
+                    usage += heap_usage(key);
+                    usage += heap_usage(mapped);
+                }
+            } else if constexpr (validate::is_reflectable_struct_v<Type>) {
+                const auto view = rfl::to_view(value);
+                using Fields = typename rfl::named_tuple_t<Type>::Fields;
+                [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                    ((usage += heap_usage(*rfl::get<Is>(view.values()))), ...);
+                }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+            }
+            return usage;
+        }
+
+        template <typename F>
+        struct HeapUsage {
+            static MemoryUsage apply(const void* field) { return heap_usage(*static_cast<const F*>(field)); }
+        };
+    }
+
+    /**
+     * @brief Builds the memory report of `content`.
+     * @param content The configuration content.
+     * @param root_name The title of the report.
+     * @return The report.
+     */
+    template <typename T>
+    MemoryReport memory_report(const T& content, const std::string_view root_name) {
+        using Table = detail::PathTable<T>;
+        const auto& heap = Table::template functions<MemoryUsage(const void*), detail::HeapUsage>();
+        MemoryReport report;
+        report.root_name = root_name;
+        report.entries.resize(Table::size());
+        // Backwards, so the fields of a struct are summed before the struct itself.
+        for (std::size_t i = Table::size(); i-- > 0;) {
+            const auto& entry = Table::entry(i);
+            MemoryUsage usage;
+            if (entry.leaf) {
+                usage = heap[i](entry.address(content));
+            } else {
+                for (std::size_t child = i + 1; child < entry.end; child = Table::entry(child).end) {
+                    usage.heap_bytes += report.entries[child].usage.heap_bytes;
+                    usage.unused_bytes += report.entries[child].usage.unused_bytes;
+                }
+            }
+            usage.inline_bytes = entry.size;
+            report.entries[i] = {std::string(Table::path(i)), entry.depth, usage};
+        }
+        for (std::size_t i = 0; i < Table::size(); i = Table::entry(i).end) {
+            report.total.heap_bytes += report.entries[i].usage.heap_bytes;
+            report.total.unused_bytes += report.entries[i].usage.unused_bytes;
+        }
+        report.total.inline_bytes = sizeof(T);
+        return report;
+    }
+}
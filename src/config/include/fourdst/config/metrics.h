@@ -0,0 +1,379 @@
+/**
+ * @file metrics.h
+ * @brief Counters, gauges and histograms of a config for Prometheus, rendered as OpenMetrics text.
+ *
+ * A `ConfigMetrics` attached with `Config::set_metrics()` accumulates, for that config:
+ *
+ * - the duration of every `load()`, `reload()` and `save()`, as a histogram per operation, and
+ *   how many of them failed;
+ * - the bytes read by loads and reloads, and the time their phases took (see `LoadStats`);
+ * - the loads that failed validation, i.e. whose document did not match the schema;
+ * - the time writers waited for the content lock (see `LockStats`), as a histogram;
+ * - the current generation and the memory of the current snapshot (see `memory.h`), as gauges.
+ *
+ * `render_openmetrics()` writes them in the OpenMetrics text format into a buffer the caller
+ * owns, so a scrape handler can reuse one buffer and render without allocating:
+ *
+ * @code
+ * auto metrics = std::make_shared<fourdst::config::ConfigMetrics>("physics");
+ * cfg.set_metrics(metrics);
+ * ...
+ * // In the HTTP handler for /metrics:
+ * static thread_local std::array<char, 64 * 1024> buffer;
+ * if (const auto size = metrics->render(buffer)) respond(std::string_view(buffer.data(), *size));
+ * @endcode
+ *
+ * Recording costs a few relaxed atomic increments per operation. Each sample carries a `config`
+ * label with the name the metrics were created with, so the metrics of several configs can be
+ * rendered into one exposition with `render_openmetrics(buffer, {&a, &b})`. Histogram buckets
+ * are fixed, from 1 µs to 10 s (see `detail::duration_bucket_bounds`).
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "fourdst/config/stats.h"
+
+namespace fourdst::config {
+
+    /**
+     * @brief The metrics of one config; attach with `Config::set_metrics()`, render with `render()`.
+     *
+     * All members are thread-safe. A `ConfigMetrics` belongs to one config at a time.
+     */
+    class ConfigMetrics {
+    public:
+        /**
+         * @brief The operations whose durations and failures are recorded.
+         */
+        enum class Operation : std::uint8_t { LOAD, RELOAD, SAVE };
+
+        static constexpr std::size_t operation_count = 3;
+
+        /**
+         * @brief Creates empty metrics whose samples are labelled `config="<name>"`.
+         */
+        explicit ConfigMetrics(std::string name = "main") : m_name(std::move(name)) {}
+
+        ConfigMetrics(const ConfigMetrics&) = delete;
+        ConfigMetrics& operator=(const ConfigMetrics&) = delete;
+
+        /**
+         * @brief Gets the `config` label of the samples.
+         */
+        [[nodiscard]] std::string_view name() const noexcept { return m_name; }
+
+        /**
+         * @brief Records one operation that took `duration` and threw if `failed`.
+         */
+        void record(const Operation operation, const std::chrono::nanoseconds duration, const bool failed) noexcept {
+            const auto index = static_cast<std::size_t>(operation);
+            m_durations[index].observe(duration);
+            if (failed) m_failures[index].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Adds the bytes and phase times of one load or reload.
+         */
+        void record_load(const LoadStats& stats) noexcept {
+            m_bytes_read.fetch_add(stats.bytes_read, std::memory_order_relaxed);
+            const std::array<std::chrono::nanoseconds, phase_count> phases{stats.read_time, stats.parse_time, stats.deserialize_time,
+                                                                           stats.validate_time};
+            for (std::size_t i = 0; i < phase_count; ++i) m_phase_times[i].fetch_add(phases[i].count(), std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Records a document that did not match the schema.
+         */
+        void record_validation_failure() noexcept { m_validation_failures.fetch_add(1, std::memory_order_relaxed); }
+
+        /**
+         * @brief Records the snapshot published as generation `generation`, measured with `measure` when rendered.
+         *
+         * The snapshot is held until the next one is published, as a `ConfigReader` would hold it.
+         *
+         * @param snapshot The published content.
+         * @param generation Its generation (see `Config::generation()`).
+         * @param measure Returns the bytes of the content, inline and heap; called on each render.
+         */
+        void publish(std::shared_ptr<const void> snapshot, const std::uint64_t generation, std::size_t (*measure)(const void*)) noexcept {
+            m_measure.store(measure, std::memory_order_relaxed);
+            m_snapshot.store(std::move(snapshot), std::memory_order_release);
+            m_generation.store(generation, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Gets the histogram the content lock of the attached config counts waits into.
+         */
+        [[nodiscard]] detail::DurationHistogram& lock_waits() noexcept { return m_lock_waits; }
+
+        /**
+         * @brief Renders these metrics alone; see `render_openmetrics()`.
+         */
+        [[nodiscard]] std::optional<std::size_t> render(std::span<char> buffer) const;
+
+    private:
+        friend std::optional<std::size_t> render_openmetrics(std::span<char> buffer, std::span<const ConfigMetrics* const> metrics);
+
+        static constexpr std::size_t phase_count = 4;
+
+        std::string m_name;
+        std::array<detail::DurationHistogram, operation_count> m_durations;
+        std::array<std::atomic<std::uint64_t>, operation_count> m_failures{};
+        std::atomic<std::uint64_t> m_bytes_read{0};
+        std::array<std::atomic<std::int64_t>, phase_count> m_phase_times{};
+        std::atomic<std::uint64_t> m_validation_failures{0};
+        detail::DurationHistogram m_lock_waits;
+        std::atomic<std::uint64_t> m_generation{0};
+        std::atomic<std::shared_ptr<const void>> m_snapshot;
+        std::atomic<std::size_t (*)(const void*)> m_measure{nullptr};
+    };
+
+    namespace detail {
+        /// Label values of `ConfigMetrics::Operation` and of the `LoadStats` phases, in enumerator order.
+        inline constexpr std::array<std::string_view, ConfigMetrics::operation_count> operation_labels{"load", "reload", "save"};
+        inline constexpr std::array<std::string_view, 4> phase_labels{"read", "parse", "deserialize", "validate"};
+
+        /// `duration_bucket_bounds` in seconds, as the `le` labels of the buckets.
+        inline constexpr std::array<std::string_view, duration_bucket_bounds.size()> duration_bucket_labels{
+            "1e-06", "1e-05", "0.0001", "0.001", "0.005", "0.01", "0.05", "0.1", "0.5", "1.0", "5.0", "10.0"};
+
+        /**
+         * @brief Appends OpenMetrics text to a fixed buffer; once it is full, further text is dropped and `size()` is empty.
+         */
+        class MetricsWriter {
+        public:
+            explicit MetricsWriter(const std::span<char> buffer) : m_buffer(buffer) {}
+
+            MetricsWriter& operator<<(const std::string_view text) {
+                if (m_full || text.size() > m_buffer.size() - m_used) {
+                    m_full = true;
+                    return *this;
+                }
+                text.copy(m_buffer.data() + m_used, text.size());
+                m_used += text.size();
+                return *this;
+            }
+
+            MetricsWriter& operator<<(const std::uint64_t value) { return number(value); }
+
+            MetricsWriter& operator<<(const double value) { return number(value); }
+
+            /**
+             * @brief Writes `value` as a quoted label value, escaping backslashes, quotes and newlines.
+             */
+            MetricsWriter& quoted(const std::string_view value) {
+                *this << "\"";
+                for (const char c : value) {
+                    if (c == '\\') *this << "\\\\";
+                    else if (c == '"') *this << "\\\"";
+                    else if (c == '\n') *this << "\\n";
+                    else *this << std::string_view(&c, 1);
+                }
+                return *this << "\"";
+            }
+
+            /**
+             * @brief The bytes written, or `std::nullopt` if the buffer was too small.
+             */
+            [[nodiscard]] std::optional<std::size_t> size() const noexcept {
+                if (m_full) return std::nullopt;
+                return m_used;
+            }
+
+        private:
+            template <typename N>
+            MetricsWriter& number(const N value) {
+                std::array<char, 32> digits{};
+                const auto [end, error] = std::to_chars(digits.data(), digits.data() + digits.size(), value);
+                return *this << std::string_view(digits.data(), static_cast<std::size_t>(end - digits.data()));
+            }
+
+            std::span<char> m_buffer;
+            std::size_t m_used = 0;
+            bool m_full = false;
+        };
+
+        inline double seconds(const std::chrono::nanoseconds duration) {
+            return std::chrono::duration<double>(duration).count();
+        }
+
+        /// Writes the `# TYPE`, `# UNIT` and `# HELP` lines of a metric family.
+        inline void family(MetricsWriter& out, const std::string_view name, const std::string_view type, const std::string_view unit,
+                           const std::string_view help) {
+            out << "# TYPE " << name << " " << type << "\n";
+            if (!unit.empty()) out << "# UNIT " << name << " " << unit << "\n";
+            out << "# HELP " << name << " " << help << "\n";
+        }
+
+        /// Writes the name of a sample and its `config` label, leaving the label set open for more labels.
+        inline MetricsWriter& sample(MetricsWriter& out, const std::string_view name, const std::string_view suffix,
+                                     const ConfigMetrics& metrics) {
+            out << name << suffix << "{config=";
+            return out.quoted(metrics.name());
+        }
+
+        /// Writes the buckets, sum and count of `histogram`, labelled with `operation` too unless it is empty.
+        inline void histogram(MetricsWriter& out, const std::string_view name, const ConfigMetrics& metrics, const std::string_view operation,
+                              const DurationHistogram& histogram) {
+            const auto labels = [&](const std::string_view suffix) -> MetricsWriter& {
+                sample(out, name, suffix, metrics);
+                if (!operation.empty()) out << ",operation=\"" << operation << "\"";
+                return out;
+            };
+            std::uint64_t cumulative = 0;
+            for (std::size_t bucket = 0; bucket < DurationHistogram::bucket_count; ++bucket) {
+                cumulative += histogram.count(bucket);
+                labels("_bucket") << ",le=\"" << (bucket < duration_bucket_labels.size() ? duration_bucket_labels[bucket] : "+Inf") << "\"} "
+                                  << cumulative << "\n";
+            }
+            labels("_sum") << "} " << seconds(histogram.sum()) << "\n";
+            labels("_count") << "} " << cumulative << "\n";
+        }
+    }
+
+    /**
+     * @brief Renders `metrics` in the OpenMetrics text format into `buffer`, ending with `# EOF`.
+     *
+     * Allocates nothing: the text is written straight into `buffer`, and measuring a snapshot only
+     * walks it. The metrics are read with relaxed loads while they may be changing, so counts of
+     * one render can be off by the operations in flight.
+     *
+     * @param buffer Where to write; a few KiB per config is enough.
+     * @param metrics The metrics to render, each labelled with its name; nulls are skipped.
+     * @return The bytes written, or `std::nullopt` if `buffer` is too small (its contents are then unspecified).
+     */
+    inline std::optional<std::size_t> render_openmetrics(const std::span<char> buffer, const std::span<const ConfigMetrics* const> metrics) {
+        detail::MetricsWriter out(buffer);
+        const auto each = [&](auto&& write) {
+            for (const ConfigMetrics* m : metrics) {
+                if (m != nullptr) write(*m);
+            }
+        };
+
+        constexpr std::string_view durations = "fourdst_config_operation_duration_seconds";
+        detail::family(out, durations, "histogram", "seconds", "Duration of config loads, reloads and saves.");
+        each([&](const ConfigMetrics& m) {
+            for (std::size_t op = 0; op < ConfigMetrics::operation_count; ++op) {
+                detail::histogram(out, durations, m, detail::operation_labels[op], m.m_durations[op]);
+            }
+        });
+
+        constexpr std::string_view failures = "fourdst_config_operation_failures";
+        detail::family(out, failures, "counter", "", "Config loads, reloads and saves that threw.");
+        each([&](const ConfigMetrics& m) {
+            for (std::size_t op = 0; op < ConfigMetrics::operation_count; ++op) {
+                detail::sample(out, failures, "_total", m) << ",operation=\"" << detail::operation_labels[op] << "\"} "
+                                                           << m.m_failures[op].load(std::memory_order_relaxed) << "\n";
+            }
+        });
+
+        constexpr std::string_view validation = "fourdst_config_validation_failures";
+        detail::family(out, validation, "counter", "", "Loaded documents that did not match the schema.");
+        each([&](const ConfigMetrics& m) {
+            detail::sample(out, validation, "_total", m) << "} " << m.m_validation_failures.load(std::memory_order_relaxed) << "\n";
+        });
+
+        constexpr std::string_view bytes = "fourdst_config_read_bytes";
+        detail::family(out, bytes, "counter", "bytes", "Bytes of config files read by loads and reloads.");
+        each([&](const ConfigMetrics& m) {
+            detail::sample(out, bytes, "_total", m) << "} " << m.m_bytes_read.load(std::memory_order_relaxed) << "\n";
+        });
+
+        constexpr std::string_view phases = "fourdst_config_load_phase_seconds";
+        detail::family(out, phases, "counter", "seconds", "Time loads and reloads spent per phase.");
+        each([&](const ConfigMetrics& m) {
+            for (std::size_t phase = 0; phase < ConfigMetrics::phase_count; ++phase) {
+                const std::chrono::nanoseconds time(m.m_phase_times[phase].load(std::memory_order_relaxed));
+                detail::sample(out, phases, "_total", m) << ",phase=\"" << detail::phase_labels[phase] << "\"} " << detail::seconds(time)
+                                                         << "\n";
+            }
+        });
+
+        constexpr std::string_view waits = "fourdst_config_lock_wait_seconds";
+        detail::family(out, waits, "histogram", "seconds", "Time writers waited for the content lock.");
+        each([&](const ConfigMetrics& m) { detail::histogram(out, waits, m, "", m.m_lock_waits); });
+
+        constexpr std::string_view generation = "fourdst_config_generation";
+        detail::family(out, generation, "gauge", "", "Generation of the published snapshot.");
+        each([&](const ConfigMetrics& m) {
+            detail::sample(out, generation, "", m) << "} " << m.m_generation.load(std::memory_order_relaxed) << "\n";
+        });
+
+        constexpr std::string_view memory = "fourdst_config_snapshot_bytes";
+        detail::family(out, memory, "gauge", "bytes", "Memory of the published snapshot, inline and heap.");
+        each([&](const ConfigMetrics& m) {
+            const std::shared_ptr<const void> snapshot = m.m_snapshot.load(std::memory_order_acquire);
+            const auto measure = m.m_measure.load(std::memory_order_relaxed);
+            const std::uint64_t size = snapshot && measure != nullptr ? measure(snapshot.get()) : 0;
+            detail::sample(out, memory, "", m) << "} " << size << "\n";
+        });
+
+        out << "# EOF\n";
+        return out.size();
+    }
+
+    /**
+     * @brief Renders the metrics of several configs into one exposition; see the overload taking a span.
+     */
+    inline std::optional<std::size_t> render_openmetrics(const std::span<char> buffer, const std::initializer_list<const ConfigMetrics*> metrics) {
+        return render_openmetrics(buffer, std::span<const ConfigMetrics* const>(metrics.begin(), metrics.size()));
+    }
+
+    inline std::optional<std::size_t> ConfigMetrics::render(const std::span<char> buffer) const {
+        const ConfigMetrics* self = this;
+        return render_openmetrics(buffer, std::span<const ConfigMetrics* const>(&self, 1));
+    }
+
+    namespace detail {
+        /**
+         * @brief Times one operation into `metrics` for its lifetime, and the bytes and phases of a load; does nothing without metrics.
+         *
+         * A load without `LoadStats` of its own gets statistics installed for it, so the bytes and
+         * phases are known. An operation that ends by an exception counts as failed.
+         */
+        class MetricsScope {
+        public:
+            MetricsScope(std::shared_ptr<ConfigMetrics> metrics, const ConfigMetrics::Operation operation)
+                : m_metrics(std::move(metrics)), m_operation(operation) {
+                if (m_metrics == nullptr) return;
+                m_exceptions = std::uncaught_exceptions();
+                m_start = std::chrono::steady_clock::now();
+                if (operation == ConfigMetrics::Operation::SAVE) return;
+                if (io::current_load_stats() == nullptr) m_scope.emplace(m_own);
+                m_stats = io::current_load_stats();
+            }
+
+            MetricsScope(const MetricsScope&) = delete;
+            MetricsScope& operator=(const MetricsScope&) = delete;
+
+            ~MetricsScope() {
+                if (m_metrics == nullptr) return;
+                m_metrics->record(m_operation, std::chrono::steady_clock::now() - m_start, std::uncaught_exceptions() > m_exceptions);
+                if (m_stats != nullptr) m_metrics->record_load(*m_stats);
+            }
+
+        private:
+            std::shared_ptr<ConfigMetrics> m_metrics;
+            ConfigMetrics::Operation m_operation;
+            int m_exceptions = 0;
+            std::chrono::steady_clock::time_point m_start{};
+            LoadStats m_own;
+            std::optional<io::ScopedLoadStats> m_scope;
+            LoadStats* m_stats = nullptr;
+        };
+    }
+}
@@ -0,0 +1,155 @@
+/**
+ * @file migrate.h
+ * @brief Schema versions and the migration steps that upgrade old TOML documents on load.
+ *
+ * A schema opts into versioning with an integer field named `config_version` in its root struct,
+ * whose default is the current version:
+ *
+ * @code
+ * struct DeckSchema {
+ *     int config_version = 3;
+ *     PhysicsOptions physics;
+ * };
+ *
+ * // Version 2 renamed physics.dt to physics.time_step.
+ * fourdst::config::register_migration<DeckSchema>(2, [](toml::table& root) {
+ *     toml::table& physics = *root["physics"].as_table();
+ *     if (auto dt = physics.get("dt")) {
+ *         physics.insert_or_assign("time_step", *dt->as_floating_point());
+ *         physics.erase("dt");
+ *     }
+ * });
+ * @endcode
+ *
+ * When such a schema is loaded from TOML, the `config_version` of the root table is read (a file
+ * without one is version 0) and the migrations registered for each step up to the current
+ * version run on the parsed table, in order, before it is deserialized. Steps without a
+ * registered migration leave the table as it is. The table then carries the current version, so
+ * the loaded content and every later `save()` are current. Old decks load in the same pass as
+ * new ones, with no conversion step in between.
+ *
+ * Files newer than the schema are rejected. JSON documents are not migrated; one with another
+ * version is rejected.
+ */
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <exception>
+#include <format>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string_view>
+#include <utility>
+
+#include "fourdst/config/exceptions/exceptions.h"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config {
+
+    /// Schemas whose root struct carries a `config_version` field.
+    template <typename T>
+    concept IsVersionedSchema = requires(const T& content) {
+        { content.config_version } -> std::convertible_to<std::int64_t>;
+    };
+
+    /**
+     * @brief A migration step: rewrites the root table of a document from one version to the next, in place.
+     */
+    using Migration = std::function<void(toml::table& root)>;
+
+    namespace io {
+
+        /// The key of the root table holding the schema version.
+        inline constexpr std::string_view version_key = "config_version";
+
+        /**
+         * @brief The migration steps registered for the schema `T`, keyed by the version they upgrade from.
+         */
+        template <typename T>
+        class MigrationRegistry {
+        public:
+            static MigrationRegistry& instance() {
+                static MigrationRegistry registry;
+                return registry;
+            }
+
+            void add(const std::int64_t from_version, Migration step) {
+                std::lock_guard lock(m_mutex);
+                m_steps[from_version] = std::move(step);
+            }
+
+            [[nodiscard]] std::map<std::int64_t, Migration> steps() const {
+                std::lock_guard lock(m_mutex);
+                return m_steps;
+            }
+
+        private:
+            mutable std::mutex m_mutex;
+            std::map<std::int64_t, Migration> m_steps;
+        };
+
+        /**
+         * @brief Returns the current version of `T`: the default of its `config_version` field.
+         */
+        template <IsVersionedSchema T>
+        std::int64_t current_version() {
+            static const std::int64_t version = static_cast<std::int64_t>(T{}.config_version);
+            return version;
+        }
+
+        /**
+         * @brief Upgrades the root table of a document to the current version of `T`.
+         * @param root The root table; rewritten in place.
+         * @param path The file the table was read from, for error messages.
+         * @throws exceptions::ConfigParseError If `config_version` is not an integer, or a migration step throws.
+         * @throws exceptions::ConfigLoadError If the document is newer than the schema.
+         */
+        template <IsVersionedSchema T>
+        void migrate(toml::table& root, const std::string_view path) {
+            std::int64_t version = 0;
+            if (const toml::node* node = root.get(version_key)) {
+                if (!node->is_integer()) {
+                    throw exceptions::ConfigParseError(
+                        std::format("Failed to load config from file: {}. Reason: '{}' must be an integer.", path, version_key));
+                }
+                version = node->as_integer()->get();
+            }
+            const std::int64_t current = current_version<T>();
+            if (version == current) return;
+            if (version > current) {
+                throw exceptions::ConfigLoadError(
+                    std::format("Config file {} has schema version {}, but this program reads version {} or older.", path, version, current));
+            }
+
+            const std::map<std::int64_t, Migration> steps = MigrationRegistry<T>::instance().steps();
+            for (auto step = steps.lower_bound(version); step != steps.end() && step->first < current; ++step) {
+                try {
+                    step->second(root);
+                } catch (const exceptions::ConfigError&) {
+                    throw;
+                } catch (const std::exception& e) {
+                    throw exceptions::ConfigParseError(
+                        std::format("Failed to load config from file: {}. Reason: migration from schema version {} failed: {}",
+                                    path, step->first, e.what()));
+                }
+            }
+            root.insert_or_assign(version_key, current);
+        }
+    }
+
+    /**
+     * @brief Registers the step that upgrades documents of schema `T` from `from_version` to `from_version + 1`.
+     *
+     * Registering a step again replaces it. Thread-safe; typically called once at startup.
+     *
+     * @param from_version The version the step reads.
+     * @param step The migration, rewriting the root table in place.
+     */
+    template <IsVersionedSchema T>
+    void register_migration(const std::int64_t from_version, Migration step) {
+        io::MigrationRegistry<T>::instance().add(from_version, std::move(step));
+    }
+}
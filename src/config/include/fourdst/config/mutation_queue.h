@@ -0,0 +1,234 @@
+/**
+ * @file mutation_queue.h
+ * @brief Batched mutation of a config by many threads through one applier.
+ *
+ * This file defines `ConfigMutationQueue`. When several threads call `Config::mutate()` at a
+ * high rate, each waits for the content lock and each publishes (copies) the whole content.
+ * Through a mutation queue, `mutate()` only pushes the mutator onto a lock-free list and returns;
+ * a single background thread takes everything pending at once, applies it in enqueue order in one
+ * `Config::transaction()`, and publishes a single snapshot for the whole batch.
+ *
+ * @code
+ * fourdst::config::ConfigMutationQueue<Schema> queue(cfg);
+ * // on any number of controller threads:
+ * queue.mutate([gain](Schema& data) { data.controller.gain = gain; });
+ * // where a thread needs to read its own changes:
+ * queue.flush();
+ * @endcode
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/base.h"
+
+namespace fourdst::config {
+
+    /**
+     * @brief Applies the mutations of many threads to a `Config<T>` in batches, on one thread.
+     *
+     * Mutations queued by one thread are applied in the order it queued them; mutations of
+     * different threads are applied in the order their pushes completed. Each batch is one
+     * `transaction()`: one published snapshot, one `undo()` step, one notification of
+     * subscribers and one audit record. A mutation is not visible to readers until its batch is
+     * published; `flush()` waits for that.
+     *
+     * If a mutator throws, its batch is rolled back and its mutations are applied again one at a
+     * time with `mutate()`, so only the throwing mutators are dropped. Their exceptions are passed
+     * to the error callback or, without one, the first of them is rethrown by the next `flush()`.
+     * The config must outlive the queue.
+     *
+     * @tparam T The configuration schema type.
+     */
+    template <IsConfigSchema T>
+    class ConfigMutationQueue {
+    public:
+        /**
+         * @brief Callback invoked with the exception of a mutator that threw.
+         */
+        using ErrorCallback = std::function<void(std::exception_ptr error)>;
+
+        /**
+         * @brief Starts the applier thread for `config`.
+         * @param config The config to mutate.
+         */
+        explicit ConfigMutationQueue(Config<T>& config) : m_config(config) {
+            m_thread = std::thread([this] { run(); });
+        }
+
+        ConfigMutationQueue(const ConfigMutationQueue&) = delete;
+        ConfigMutationQueue& operator=(const ConfigMutationQueue&) = delete;
+
+        /**
+         * @brief Applies the mutations still queued and stops the applier thread.
+         *
+         * No thread may call `mutate()` once destruction has begun. Errors of the last batch go to
+         * the error callback only.
+         */
+        ~ConfigMutationQueue() {
+            m_stopping.store(true, std::memory_order_relaxed);
+            // An empty node wakes the applier, which returns once it has applied everything before it.
+            push(std::make_unique<Node>());
+            if (m_thread.joinable()) {
+                m_thread.join();
+            }
+        }
+
+        /**
+         * @brief Queues `mutator` to be invoked as `mutator(T&)` on the applier thread; never blocks.
+         * @param mutator The mutation; it must not call back into the config.
+         */
+        template <typename MutatorFunc>
+        void mutate(MutatorFunc&& mutator) {
+            auto node = std::make_unique<Node>();
+            node->apply = std::forward<MutatorFunc>(mutator);
+            push(std::move(node));
+        }
+
+        /**
+         * @brief Waits until every mutation queued before the call is published.
+         *
+         * Pending mutations are applied on the calling thread if the applier has not taken them yet.
+         *
+         * @throws The first exception thrown by a mutator since the last `flush()`, if no error callback is set.
+         */
+        void flush() {
+            const std::uint64_t target = m_queued.load(std::memory_order_acquire);
+            apply_pending();
+            std::uint64_t applied = m_applied.load(std::memory_order_acquire);
+            while (applied < target) {
+                m_applied.wait(applied, std::memory_order_acquire);
+                applied = m_applied.load(std::memory_order_acquire);
+            }
+            std::exception_ptr error;
+            {
+                std::lock_guard lock(m_apply_mutex);
+                error = std::exchange(m_error, nullptr);
+            }
+            if (error) std::rethrow_exception(error);
+        }
+
+        /**
+         * @brief Sets the callback run when a mutator throws.
+         * @param callback The callback; it runs on the thread applying the batch.
+         */
+        void on_error(ErrorCallback callback) {
+            std::lock_guard lock(m_apply_mutex);
+            m_on_error = std::move(callback);
+        }
+
+        /**
+         * @brief Returns the number of mutations applied (or dropped as failed) so far.
+         */
+        [[nodiscard]] std::uint64_t applied() const noexcept {
+            return m_applied.load(std::memory_order_acquire);
+        }
+
+        /**
+         * @brief Returns the number of batches applied so far, each published as one snapshot.
+         */
+        [[nodiscard]] std::uint64_t batches() const noexcept {
+            return m_batches.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Node {
+            std::function<void(T&)> apply;
+            Node* next = nullptr;
+        };
+
+        void push(std::unique_ptr<Node> owned) {
+            // Counted before it is linked, so a flush() that sees the count waits for the node.
+            m_queued.fetch_add(1, std::memory_order_release);
+            Node* node = owned.release();
+            Node* head = m_head.load(std::memory_order_relaxed);
+            do {
+                node->next = head;
+            } while (!m_head.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+            // Only the push onto an empty list can find the applier asleep.
+            if (head == nullptr) {
+                m_head.notify_one();
+            }
+        }
+
+        void run() {
+            while (true) {
+                m_head.wait(nullptr, std::memory_order_acquire);
+                apply_pending();
+                if (m_stopping.load(std::memory_order_relaxed) && m_head.load(std::memory_order_acquire) == nullptr) return;
+            }
+        }
+
+        /**
+         * @brief Takes every queued node and applies them as one batch.
+         */
+        void apply_pending() {
+            // Serializes appliers, so batches are published in the order they were taken.
+            std::lock_guard lock(m_apply_mutex);
+            Node* head = m_head.exchange(nullptr, std::memory_order_acquire);
+            if (head == nullptr) return;
+            std::vector<std::unique_ptr<Node>> batch;
+            while (head != nullptr) {
+                Node* next = head->next;
+                batch.emplace_back(head);
+                head = next;
+            }
+            // The list holds the newest node first.
+            std::ranges::reverse(batch);
+
+            // A batch holding only the stop marker publishes nothing.
+            if (std::ranges::any_of(batch, [](const auto& node) { return static_cast<bool>(node->apply); })) {
+                try {
+                    m_config.transaction([&batch](T& content) {
+                        for (const auto& node : batch) {
+                            if (node->apply) node->apply(content);
+                        }
+                    });
+                } catch (...) {
+                    for (const auto& node : batch) {
+                        if (!node->apply) continue;
+                        try {
+                            m_config.mutate(node->apply);
+                        } catch (...) {
+                            report(std::current_exception());
+                        }
+                    }
+                }
+                m_batches.fetch_add(1, std::memory_order_relaxed);
+            }
+            m_applied.fetch_add(batch.size(), std::memory_order_release);
+            m_applied.notify_all();
+        }
+
+        /**
+         * @brief Passes a mutator's exception to the callback, or keeps the first for `flush()`. Requires the apply lock.
+         */
+        void report(std::exception_ptr error) {
+            if (m_on_error) {
+                m_on_error(std::move(error));
+            } else if (!m_error) {
+                m_error = std::move(error);
+            }
+        }
+
+        Config<T>& m_config;
+        std::atomic<Node*> m_head{nullptr};
+        std::atomic<std::uint64_t> m_queued{0};
+        std::atomic<std::uint64_t> m_applied{0};
+        std::atomic<std::uint64_t> m_batches{0};
+        std::atomic<bool> m_stopping{false};
+        std::mutex m_apply_mutex;
+        ErrorCallback m_on_error;
+        std::exception_ptr m_error;
+        std::thread m_thread;
+    };
+}
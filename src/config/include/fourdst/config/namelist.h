@@ -0,0 +1,499 @@
+/**
+ * @file namelist.h
+ * @brief Reading Fortran namelist files (MESA inlists) into the TOML tables `Config::load()` deserializes.
+ *
+ * Stellar-evolution workflows configure runs with namelist groups:
+ *
+ * @code{.f90}
+ * &star_job
+ *     create_pre_main_sequence_model = .true.
+ *     new_net_name = 'pp_and_cno_extras.net'   ! comments run to the end of the line
+ * /
+ * &controls
+ *     initial_mass = 1, initial_z = 2d-2
+ *     x_ctrl(1) = 0.5, x_ctrl(2) = 3*1.0d0
+ *     mixing%alpha = 1.8
+ * /
+ * @endcode
+ *
+ * `parse_namelist()` reads such a file in one pass into a table with one subtable per group,
+ * which `Config` places under its root name; groups therefore map onto the top-level fields of
+ * the schema (`star_job`, `controls`) and keys onto their fields. From there the file is
+ * deserialized, validated and reported on exactly like a TOML deck.
+ *
+ * Supported: `&group ... /` (also `&end`, `$group ... $end`), `!` comments, separators of commas,
+ * blanks and newlines, logicals (`.true.`, `.f.`, `T`), integers, reals with `e` or `d`
+ * exponents, strings in `'` or `"` with doubled quotes, repeat counts (`3*0.0`), value lists,
+ * element and range designators (`x(2) = ...`, `x(1:3) = ...`), derived-type components
+ * (`a%b`) and arrays of them (`a(2)%b`). Names are case-insensitive in Fortran and are
+ * lowercased, so schema fields must be lowercase. Text outside groups is skipped, as Fortran
+ * does. Multi-dimensional designators and null values that leave a gap in an array are rejected.
+ *
+ * A namelist does not say whether `x = 1` is a scalar or a one-element array, nor whether `1`
+ * is an integer or a real. `conform_namelist<T>()` settles both from the schema: integers read
+ * into floating-point fields become reals, and single values read into vector and array fields
+ * become one-element arrays.
+ */
+#pragma once
+
+#include <cctype>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/path_table.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config::io {
+
+    namespace detail {
+        /**
+         * @brief Single-pass reader of the namelist groups of one file.
+         */
+        class NamelistParser {
+        public:
+            NamelistParser(const std::string_view text, const std::string_view path) : m_text(text), m_path(path) {}
+
+            toml::table parse() {
+                toml::table groups;
+                while (true) {
+                    skip_outside_groups();
+                    if (at_end()) break;
+                    advance();  // '&' or '$'
+                    const std::string name = read_name();
+                    if (name.empty() || name == "end") fail("expected a namelist group name after '&'");
+                    toml::node* existing = groups.get(name);
+                    if (existing == nullptr) existing = &groups.insert(name, toml::table{}).first->second;
+                    if (!existing->is_table()) fail(std::format("namelist group '{}' clashes with another value", name));
+                    parse_group(*existing->as_table());
+                }
+                return groups;
+            }
+
+        private:
+            /// One part of a designator such as `a(2)%b(1:3)`.
+            struct Component {
+                std::string name;
+                std::optional<std::size_t> index;
+            };
+
+            /// A parsed value, or a null value (`x = 1, , 3`) that only advances the index.
+            using Value = std::optional<std::variant<bool, std::int64_t, double, std::string>>;
+
+            void parse_group(toml::table& group) {
+                while (true) {
+                    skip_blanks(true);
+                    while (!at_end() && peek() == ',') {
+                        advance();
+                        skip_blanks(true);
+                    }
+                    if (at_end()) fail("namelist group is not terminated by '/'");
+                    const char c = peek();
+                    if (c == '/') {
+                        advance();
+                        return;
+                    }
+                    if (c == '&' || c == '$') {
+                        advance();
+                        if (read_name() != "end") fail("namelist group is not terminated by '/'");
+                        return;
+                    }
+                    parse_assignment(group);
+                }
+            }
+
+            void parse_assignment(toml::table& group) {
+                m_statement_line = m_line;
+                m_statement_column = m_column;
+                const std::vector<Component> designator = read_designator();
+                skip_blanks(false);
+                if (at_end() || peek() != '=') fail(std::format("expected '=' after '{}'", designator.back().name));
+                advance();
+
+                std::vector<Value> values;
+                while (true) {
+                    skip_blanks(true);
+                    if (at_end()) break;
+                    const char c = peek();
+                    if (c == '/' || c == '&' || c == '$') break;
+                    if (c == ',') {
+                        advance();
+                        // A comma that follows another separator stands for a null value.
+                        if (m_after_separator) values.emplace_back();
+                        m_after_separator = true;
+                        continue;
+                    }
+                    if (starts_designator()) break;
+                    read_values(values);
+                    m_after_separator = false;
+                }
+                m_after_separator = true;
+                if (values.empty()) fail_statement(std::format("no value given for '{}'", designator.back().name));
+                assign(group, designator, values);
+            }
+
+            /// Reads one value token, expanding a repeat count such as `3*0.0`.
+            void read_values(std::vector<Value>& values) {
+                std::size_t repeat = 1;
+                if (std::isdigit(static_cast<unsigned char>(peek()))) {
+                    const std::size_t start = m_pos;
+                    while (!at_end() && std::isdigit(static_cast<unsigned char>(peek()))) advance();
+                    if (!at_end() && peek() == '*') {
+                        std::from_chars(m_text.data() + start, m_text.data() + m_pos, repeat);
+                        advance();
+                        if (at_end() || is_separator(peek())) {
+                            values.insert(values.end(), repeat, Value{});
+                            return;
+                        }
+                    } else {
+                        rewind(start);
+                    }
+                }
+                const Value value = read_value();
+                values.insert(values.end(), repeat, value);
+            }
+
+            Value read_value() {
+                const char c = peek();
+                if (c == '\'' || c == '"') return read_string(c);
+                const std::size_t line = m_line;
+                const std::size_t column = m_column;
+                const std::size_t start = m_pos;
+                while (!at_end() && !is_separator(peek())) advance();
+                std::string token(m_text.substr(start, m_pos - start));
+                for (char& ch : token) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+
+                const std::string_view logical = std::string_view(token).substr(token.starts_with('.') ? 1 : 0);
+                if (logical.starts_with('t') && (token.starts_with('.') || token.size() == 1 || token == "true")) return true;
+                if (logical.starts_with('f') && (token.starts_with('.') || token.size() == 1 || token == "false")) return false;
+
+                std::int64_t integer = 0;
+                const char* first = token.data() + (token.starts_with('+') ? 1 : 0);
+                const char* last = token.data() + token.size();
+                if (const auto [ptr, ec] = std::from_chars(first, last, integer); ec == std::errc() && ptr == last) return integer;
+
+                for (char& ch : token) {
+                    if (ch == 'd' || ch == 'q') ch = 'e';
+                }
+                double real = 0.0;
+                first = token.data() + (token.starts_with('+') ? 1 : 0);
+                last = token.data() + token.size();
+                if (const auto [ptr, ec] = std::from_chars(first, last, real); ec == std::errc() && ptr == last) return real;
+
+                fail(std::format("invalid value '{}'", m_text.substr(start, m_pos - start)), line, column);
+            }
+
+            Value read_string(const char quote) {
+                const std::size_t line = m_line;
+                const std::size_t column = m_column;
+                advance();
+                std::string out;
+                while (true) {
+                    if (at_end()) fail("unterminated string", line, column);
+                    const char c = peek();
+                    advance();
+                    if (c == quote) {
+                        if (at_end() || peek() != quote) break;
+                        advance();
+                    }
+                    out += c;
+                }
+                return out;
+            }
+
+            std::vector<Component> read_designator() {
+                std::vector<Component> components;
+                while (true) {
+                    Component component{read_name(), std::nullopt};
+                    if (component.name.empty()) fail("expected a variable name");
+                    skip_blanks(false);
+                    if (!at_end() && peek() == '(') {
+                        advance();
+                        component.index = read_index();
+                        skip_blanks(false);
+                        if (!at_end() && peek() == ':') {
+                            advance();
+                            const std::size_t end = read_index();
+                            if (end < *component.index) fail(std::format("empty range in '{}'", component.name));
+                            skip_blanks(false);
+                        }
+                        if (!at_end() && peek() == ',') fail(std::format("multi-dimensional designators are not supported ('{}')", component.name));
+                        if (at_end() || peek() != ')') fail(std::format("expected ')' after the index of '{}'", component.name));
+                        advance();
+                        skip_blanks(false);
+                    }
+                    components.push_back(std::move(component));
+                    if (at_end() || peek() != '%') return components;
+                    advance();
+                    skip_blanks(false);
+                }
+            }
+
+            std::size_t read_index() {
+                skip_blanks(false);
+                const std::size_t start = m_pos;
+                while (!at_end() && std::isdigit(static_cast<unsigned char>(peek()))) advance();
+                std::size_t index = 0;
+                std::from_chars(m_text.data() + start, m_text.data() + m_pos, index);
+                if (index == 0) fail("array indices start at 1");
+                return index;
+            }
+
+            /// Whether the next token is a designator followed by `=`, which ends the current value list.
+            bool starts_designator() {
+                if (!std::isalpha(static_cast<unsigned char>(peek()))) return false;
+                const std::size_t pos = m_pos;
+                const std::size_t line = m_line;
+                const std::size_t column = m_column;
+                bool found = false;
+                while (!at_end()) {
+                    const char c = peek();
+                    if (c == '=') {
+                        found = true;
+                        break;
+                    }
+                    if (c == '\n' || c == ',' || c == '/' || c == '\'' || c == '"' || c == '!' || c == '*') break;
+                    advance();
+                }
+                m_pos = pos;
+                m_line = line;
+                m_column = column;
+                return found;
+            }
+
+            /// Stores `values` at the designated place, creating the tables and arrays it passes through.
+            void assign(toml::table& group, const std::vector<Component>& designator, const std::vector<Value>& values) {
+                toml::table* table = &group;
+                for (std::size_t i = 0; i + 1 < designator.size(); ++i) {
+                    const Component& part = designator[i];
+                    if (!part.index) {
+                        toml::node* child = table->get(part.name);
+                        if (child == nullptr) child = &table->insert(part.name, toml::table{}).first->second;
+                        if (!child->is_table()) fail_statement(std::format("'{}' is both a value and a derived type", part.name));
+                        table = child->as_table();
+                        continue;
+                    }
+                    toml::array& array = array_at(*table, part.name);
+                    const std::size_t slot = *part.index - 1;
+                    if (slot > array.size()) fail_statement(std::format("'{}({})' is set before '{}({})'", part.name, *part.index, part.name, array.size() + 1));
+                    if (slot == array.size()) array.push_back(toml::table{});
+                    if (!array.get(slot)->is_table()) fail_statement(std::format("'{}({})' is both a value and a derived type", part.name, *part.index));
+                    table = array.get(slot)->as_table();
+                }
+
+                const Component& last = designator.back();
+                if (!last.index && values.size() == 1) {
+                    if (!values.front()) fail_statement(std::format("no value given for '{}'", last.name));
+                    std::visit([&](const auto& value) { table->insert_or_assign(last.name, value); }, *values.front());
+                    return;
+                }
+                toml::array& array = array_at(*table, last.name);
+                std::size_t slot = last.index.value_or(1) - 1;
+                for (const Value& value : values) {
+                    if (value) {
+                        if (slot > array.size()) fail_statement(std::format("'{}({})' is set before '{}({})'", last.name, slot + 1, last.name, array.size() + 1));
+                        std::visit([&](const auto& v) {
+                            if (slot == array.size()) {
+                                array.push_back(v);
+                            } else {
+                                array.replace(array.cbegin() + static_cast<std::ptrdiff_t>(slot), v);
+                            }
+                        }, *value);
+                    }
+                    ++slot;
+                }
+            }
+
+            toml::array& array_at(toml::table& table, const std::string& name) {
+                toml::node* node = table.get(name);
+                if (node == nullptr) return *table.insert(name, toml::array{}).first->second.as_array();
+                if (!node->is_array()) {
+                    // A scalar assigned earlier is the first element of the array now being indexed.
+                    toml::array array;
+                    node->visit([&](const auto& value) { array.push_back(value); });
+                    table.insert_or_assign(name, std::move(array));
+                    node = table.get(name);
+                }
+                return *node->as_array();
+            }
+
+            std::string read_name() {
+                std::string name;
+                while (!at_end()) {
+                    const auto c = static_cast<unsigned char>(peek());
+                    if (!std::isalnum(c) && c != '_') break;
+                    name += static_cast<char>(std::tolower(c));
+                    advance();
+                }
+                return name;
+            }
+
+            /// Skips blanks and comments; newlines too if `newlines`.
+            void skip_blanks(const bool newlines) {
+                while (!at_end()) {
+                    const char c = peek();
+                    if (c == '!') {
+                        while (!at_end() && peek() != '\n') advance();
+                    } else if (c == ' ' || c == '\t' || c == '\r' || (newlines && c == '\n')) {
+                        advance();
+                    } else {
+                        return;
+                    }
+                }
+            }
+
+            /// Skips to the next `&` or `$` that starts a line (after blanks), ignoring everything else.
+            void skip_outside_groups() {
+                while (!at_end()) {
+                    skip_blanks(false);
+                    if (at_end()) return;
+                    if (peek() == '&' || peek() == '$') return;
+                    while (!at_end() && peek() != '\n') advance();
+                    if (!at_end()) advance();
+                }
+            }
+
+            static bool is_separator(const char c) {
+                return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == ',' || c == '/' || c == '!';
+            }
+
+            [[nodiscard]] bool at_end() const { return m_pos >= m_text.size(); }
+            [[nodiscard]] char peek() const { return m_text[m_pos]; }
+
+            void advance() {
+                if (m_text[m_pos] == '\n') {
+                    ++m_line;
+                    m_column = 1;
+                } else {
+                    ++m_column;
+                }
+                ++m_pos;
+            }
+
+            /// Moves back to `pos` on the current line.
+            void rewind(const std::size_t pos) {
+                m_column -= m_pos - pos;
+                m_pos = pos;
+            }
+
+            [[noreturn]] void fail(const std::string& message) const { fail(message, m_line, m_column); }
+
+            /// Fails at the start of the assignment being read.
+            [[noreturn]] void fail_statement(const std::string& message) const { fail(message, m_statement_line, m_statement_column); }
+
+            [[noreturn]] void fail(const std::string& message, const std::size_t line, const std::size_t column) const {
+                throw exceptions::ConfigParseError(
+                    std::format("Unable to parse namelist file: {}:{}:{}. Reason: {}", m_path, line, column, message),
+                    exceptions::ConfigParseError::Location{std::string(m_path), line, column, ""});
+            }
+
+            std::string_view m_text;
+            std::string_view m_path;
+            std::size_t m_pos = 0;
+            std::size_t m_line = 1;
+            std::size_t m_column = 1;
+            std::size_t m_statement_line = 1;
+            std::size_t m_statement_column = 1;
+            bool m_after_separator = true;
+        };
+
+        template <typename Type>
+        void conform_namelist_node(toml::node& node, const std::function<void(toml::node&&)>& replace);
+
+        /// Conforms the fields of the struct `Type` present in `table`.
+        template <typename Type>
+        void conform_namelist_table(toml::table& table) {
+            using Fields = typename rfl::named_tuple_t<Type>::Fields;
+            [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                ([&] {
+                    using Field = rfl::tuple_element_t<Is, Fields>;
+                    const std::string_view name = Field::name();
+                    if (toml::node* child = table.get(name)) {
+                        conform_namelist_node<std::remove_cvref_t<typename Field::Type>>(
+                            *child, [&](toml::node&& value) {
+                                value.visit([&](auto&& concrete) { table.insert_or_assign(name, std::move(concrete)); });
+                            });
+                    }
+                }(), ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        }
+
+        /**
+         * @brief Brings `node`, read for a field of type `Type`, into the shape that type reads.
+         * @param replace Puts a new node in the place of `node`.
+         */
+        template <typename Type>
+        void conform_namelist_node(toml::node& node, const std::function<void(toml::node&&)>& replace) {
+            if constexpr (validate::is_optional_v<Type>) {
+                conform_namelist_node<std::remove_cvref_t<typename Type::value_type>>(node, replace);
+            } else if constexpr (std::is_floating_point_v<Type>) {
+                if (const auto* integer = node.as_integer()) {
+                    toml::value<double> real(static_cast<double>(integer->get()));
+                    replace(std::move(real));
+                }
+            } else if constexpr (validate::is_vector_v<Type> || config::detail::is_std_array_v<Type>) {
+                using Element = std::remove_cvref_t<typename Type::value_type>;
+                if (!node.is_array()) {
+                    toml::array array;
+                    node.visit([&](const auto& value) { array.push_back(value); });
+                    conform_namelist_node<Type>(array, [&](toml::node&&) {});
+                    replace(std::move(array));
+                    return;
+                }
+                toml::array& array = *node.as_array();
+                for (std::size_t i = 0; i < array.size(); ++i) {
+                    conform_namelist_node<Element>(*array.get(i), [&](toml::node&& value) {
+                        value.visit([&](auto&& concrete) {
+                            array.replace(array.cbegin() + static_cast<std::ptrdiff_t>(i), std::move(concrete));
+                        });
+                    });
+                }
+            } else if constexpr (validate::is_map_v<Type>) {
+                if (toml::table* table = node.as_table()) {
+                    for (auto&& [key, child] : *table) {
+                        const std::string name(key.str());
+                        conform_namelist_node<std::remove_cvref_t<typename Type::mapped_type>>(child, [&](toml::node&& value) {
+                            value.visit([&](auto&& concrete) { table->insert_or_assign(name, std::move(concrete)); });
+                        });
+                    }
+                }
+            } else if constexpr (config::detail::is_path_struct_v<Type>) {
+                if (toml::table* table = node.as_table()) conform_namelist_table<Type>(*table);
+            }
+        }
+    }
+
+    /**
+     * @brief Parses the namelist groups of `text` into a table with one subtable per group.
+     * @param text The namelist file contents.
+     * @param path The file the text was read from, for error messages.
+     * @throws exceptions::ConfigParseError If the text is not a valid namelist, with the line and column.
+     */
+    inline toml::table parse_namelist(const std::string_view text, const std::string_view path) {
+        return detail::NamelistParser(text, path).parse();
+    }
+
+    /**
+     * @brief Converts the integers of floating-point fields to reals and wraps single values of array fields, as `T` reads them.
+     * @param groups The table `parse_namelist()` returned.
+     */
+    template <typename T>
+    void conform_namelist(toml::table& groups) {
+        detail::conform_namelist_table<T>(groups);
+    }
+}
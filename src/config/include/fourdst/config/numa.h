@@ -0,0 +1,165 @@
+/**
+ * @file numa.h
+ * @brief Minimal NUMA topology queries for replicating config snapshots per memory node.
+ *
+ * On a multi-socket machine every thread that reads the one published snapshot of a config pays
+ * for remote memory accesses if the snapshot lives on another node. `Config::set_numa_replication()`
+ * keeps one copy per node instead; the helpers here find the nodes, tell which node the calling
+ * thread runs on, and run the copy on a thread pinned to a node so that its pages are first
+ * touched (and therefore allocated) there.
+ *
+ * The topology is read once from `/sys/devices/system/node`, so no libnuma is needed. On systems
+ * without that directory (and on non-Linux platforms) there is a single node and replication is
+ * a no-op.
+ */
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace fourdst::config::numa {
+
+    /**
+     * @brief The NUMA nodes of the machine and the CPUs that belong to each.
+     */
+    struct Topology {
+        /// CPUs of each node, indexed by a dense node index (not the kernel's node id).
+        std::vector<std::vector<int>> node_cpus;
+        /// Dense node index of each CPU; CPUs not listed under any node map to node 0.
+        std::vector<std::size_t> cpu_node;
+    };
+
+    namespace detail {
+        /**
+         * @brief Parses a kernel CPU list such as `"0-15,32-47"`.
+         */
+        inline std::vector<int> parse_cpu_list(const std::string_view list) {
+            std::vector<int> cpus;
+            std::string_view rest = list;
+            while (!rest.empty()) {
+                const std::size_t comma = rest.find(',');
+                const std::string_view range = rest.substr(0, comma);
+                rest.remove_prefix(comma == std::string_view::npos ? rest.size() : comma + 1);
+
+                int first = 0;
+                int last = 0;
+                const auto [dash, ec] = std::from_chars(range.data(), range.data() + range.size(), first);
+                if (ec != std::errc{}) continue;
+                last = first;
+                if (dash != range.data() + range.size() && *dash == '-') {
+                    std::from_chars(dash + 1, range.data() + range.size(), last);
+                }
+                for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+            }
+            return cpus;
+        }
+
+        inline Topology read_topology() {
+            Topology topology;
+            std::error_code ec;
+            std::vector<std::filesystem::path> nodes;
+            for (const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/node", ec)) {
+                const std::string name = entry.path().filename().string();
+                if (name.starts_with("node") && name.size() > 4 && name.find_first_not_of("0123456789", 4) == std::string::npos) {
+                    nodes.push_back(entry.path());
+                }
+            }
+            std::ranges::sort(nodes, {}, [](const std::filesystem::path& path) { return std::stoi(path.filename().string().substr(4)); });
+
+            for (const auto& node : nodes) {
+                std::ifstream in(node / "cpulist");
+                std::string list;
+                std::getline(in, list);
+                std::vector<int> cpus = parse_cpu_list(list);
+                // Memory-only nodes have no CPUs to run readers on, so they get no replica.
+                if (!cpus.empty()) topology.node_cpus.push_back(std::move(cpus));
+            }
+            if (topology.node_cpus.empty()) topology.node_cpus.emplace_back();
+
+            for (std::size_t node = 0; node < topology.node_cpus.size(); ++node) {
+                for (const int cpu : topology.node_cpus[node]) {
+                    if (static_cast<std::size_t>(cpu) >= topology.cpu_node.size()) topology.cpu_node.resize(cpu + 1, 0);
+                    topology.cpu_node[cpu] = node;
+                }
+            }
+            return topology;
+        }
+    }
+
+    /**
+     * @brief Returns the machine's topology, read on first use.
+     */
+    inline const Topology& topology() {
+        static const Topology cached = detail::read_topology();
+        return cached;
+    }
+
+    /**
+     * @brief Returns the number of NUMA nodes with CPUs; 1 if the topology is unknown.
+     */
+    inline std::size_t node_count() {
+        return topology().node_cpus.size();
+    }
+
+    /**
+     * @brief Returns the dense index of the node the calling thread is currently running on.
+     *
+     * Uses `sched_getcpu()`, which is served from the vDSO and costs a few nanoseconds. The result
+     * can be stale as soon as it is returned if the thread migrates; it is a placement hint only.
+     */
+    inline std::size_t current_node() noexcept {
+#if defined(__linux__)
+        const int cpu = sched_getcpu();
+        const auto& cpu_node = topology().cpu_node;
+        if (cpu >= 0 && static_cast<std::size_t>(cpu) < cpu_node.size()) return cpu_node[cpu];
+#endif
+        return 0;
+    }
+
+    /**
+     * @brief Runs `work` on a thread pinned to the CPUs of `node` and waits for it.
+     *
+     * Memory the work allocates and first writes is placed on that node under the default
+     * (local) allocation policy. With a single node, `work` runs on the calling thread.
+     *
+     * @param node Dense node index, less than `node_count()`.
+     * @param work Callable invoked with no arguments; exceptions are rethrown on the calling thread.
+     */
+    template <typename Work>
+    void run_on_node(const std::size_t node, Work&& work) {
+        if (node_count() <= 1) {
+            work();
+            return;
+        }
+        std::exception_ptr error;
+        std::thread worker([&] {
+#if defined(__linux__)
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (const int cpu : topology().node_cpus[node]) CPU_SET(cpu, &set);
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+            try {
+                work();
+            } catch (...) {
+                error = std::current_exception();
+            }
+        });
+        worker.join();
+        if (error) std::rethrow_exception(error);
+    }
+}
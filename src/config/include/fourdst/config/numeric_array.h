@@ -0,0 +1,458 @@
+/**
+ * @file numeric_array.h
+ * @brief A fast path for large numeric arrays in TOML files.
+ *
+ * toml++ builds a DOM node per array element, which dominates load time for files carrying
+ * grids or tables of hundreds of thousands of numbers. Before a TOML document is parsed,
+ * `scan_numeric_arrays()` finds every flat array of at least `numeric_array_min_bytes`
+ * characters whose key names a numeric vector field of the schema. Those arrays are replaced
+ * by `[]` in a copy of the text handed to toml++, so the table deserializes as usual, and
+ * `fill_numeric_arrays()` then reads each one from the original text with `std::from_chars`
+ * straight into its (pre-reserved) field, or into the target of a `Sink` field (see sink.h).
+ *
+ * The scanner understands the TOML syntax that can hide an array (strings, comments, inline
+ * tables, nested arrays). Arrays under quoted keys or arrays of tables, and any element the
+ * fast path does not read exactly as toml++ would (underscores, hexadecimal integers, integers
+ * in a float array), are left to toml++; if a candidate fails to read, the caller parses the
+ * document as written.
+ */
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/compare.h"
+#include "fourdst/config/sidecar.h"
+#include "fourdst/config/sink.h"
+#include "fourdst/config/toml_writer.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+
+namespace fourdst::config::io {
+
+    /// Arrays shorter than this (in characters of source text) are left to toml++.
+    inline constexpr std::size_t numeric_array_min_bytes = 4096;
+
+    /**
+     * @brief A candidate array found in the source text.
+     */
+    struct NumericArraySpan {
+        /// Dotted path of the array, starting with its root table.
+        std::string path;
+        /// Offset of the opening bracket.
+        std::size_t begin = 0;
+        /// Offset one past the closing bracket.
+        std::size_t end = 0;
+    };
+
+    namespace detail {
+        template <typename Type>
+        constexpr bool is_numeric_array_field_v = [] {
+            if constexpr (validate::is_sink_v<Type>) {
+                return true;
+            } else if constexpr (validate::is_optional_v<Type>) {
+                return is_sidecar_array_v<typename std::remove_cvref_t<Type>::value_type>;
+            } else {
+                return is_sidecar_array_v<Type>;
+            }
+        }();
+
+        template <typename Type>
+        struct has_numeric_array_fields;
+
+        template <typename Fields>
+        struct fields_have_numeric_arrays;
+
+        template <typename... Fields>
+        struct fields_have_numeric_arrays<rfl::Tuple<Fields...>>
+            : std::bool_constant<(has_numeric_array_fields<std::remove_cvref_t<typename Fields::Type>>::value || ...)> {};
+
+        template <typename Type>
+        struct has_numeric_array_fields {
+            static constexpr bool compute() {
+                if constexpr (is_numeric_array_field_v<Type>) {
+                    return true;
+                } else if constexpr (is_plain_struct_v<Type>) {
+                    return fields_have_numeric_arrays<typename rfl::named_tuple_t<Type>::Fields>::value;
+                } else {
+                    return false;
+                }
+            }
+            static constexpr bool value = compute();
+        };
+
+        /**
+         * @brief Whether a dotted path below `Type` names a numeric vector field reached through plain structs.
+         */
+        template <typename Type>
+        bool names_numeric_array(const std::string_view path) {
+            if constexpr (is_numeric_array_field_v<Type>) {
+                return path.empty();
+            } else if constexpr (is_plain_struct_v<Type> && has_numeric_array_fields<Type>::value) {
+                if (path.empty()) return false;
+                const auto [head, tail] = config::detail::split_path(path);
+                using Fields = typename rfl::named_tuple_t<Type>::Fields;
+                return [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                    return ((rfl::tuple_element_t<Is, Fields>::name() == head &&
+                             names_numeric_array<std::remove_cvref_t<typename rfl::tuple_element_t<Is, Fields>::Type>>(tail)) || ...);
+                }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+            } else {
+                return false;
+            }
+        }
+
+        /**
+         * @brief Finds the large flat arrays of a TOML document without building a DOM.
+         *
+         * Every scanning step returns the offset after what it consumed, or `npos` on syntax it
+         * does not follow, in which case the whole scan is abandoned and toml++ gets the document.
+         */
+        class TomlArrayScanner {
+        public:
+            static constexpr std::size_t npos = std::string_view::npos;
+
+            TomlArrayScanner(const std::string_view text, const std::size_t min_bytes) : m_text(text), m_min_bytes(min_bytes) {}
+
+            /**
+             * @brief Scans the document, returning the candidate spans in source order.
+             */
+            std::vector<NumericArraySpan> scan() {
+                std::vector<NumericArraySpan> spans;
+                std::string table;
+                bool table_plain = true;
+                std::size_t i = 0;
+                while (i < m_text.size()) {
+                    i = skip_space(i, true);
+                    if (i >= m_text.size()) break;
+                    if (m_text[i] == '[') {
+                        const bool array_of_tables = i + 1 < m_text.size() && m_text[i + 1] == '[';
+                        std::string key;
+                        bool plain = true;
+                        i = read_key(skip_space(i + (array_of_tables ? 2 : 1), false), key, plain);
+                        if (i == npos || !consume(i, ']') || (array_of_tables && !consume(i, ']'))) return {};
+                        table = std::move(key);
+                        table_plain = plain && !array_of_tables;
+                        continue;
+                    }
+
+                    std::string key;
+                    bool plain = true;
+                    i = read_key(i, key, plain);
+                    if (i == npos) return {};
+                    i = skip_space(i, false);
+                    if (!consume(i, '=')) return {};
+                    i = skip_space(i, false);
+                    const std::size_t begin = i;
+                    i = skip_value(i);
+                    if (i == npos) return {};
+                    if (plain && table_plain && m_text[begin] == '[' && i - begin >= m_min_bytes && is_flat(begin, i)) {
+                        spans.push_back({table.empty() ? std::move(key) : table + "." + key, begin, i});
+                    }
+                }
+                return spans;
+            }
+
+        private:
+            static bool is_bare_key_char(const char c) {
+                return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_' || c == '-';
+            }
+
+            bool consume(std::size_t& i, const char c) const {
+                i = skip_space(i, false);
+                if (i >= m_text.size() || m_text[i] != c) return false;
+                ++i;
+                return true;
+            }
+
+            /// Skips blanks and comments, and line breaks too if `newlines` is set.
+            [[nodiscard]] std::size_t skip_space(std::size_t i, const bool newlines) const {
+                while (i < m_text.size()) {
+                    const char c = m_text[i];
+                    if (c == ' ' || c == '\t' || (newlines && (c == '\n' || c == '\r'))) {
+                        ++i;
+                    } else if (c == '#') {
+                        while (i < m_text.size() && m_text[i] != '\n') ++i;
+                    } else {
+                        break;
+                    }
+                }
+                return i;
+            }
+
+            /// Reads a dotted key; `plain` is cleared if any segment is quoted.
+            std::size_t read_key(std::size_t i, std::string& key, bool& plain) const {
+                while (true) {
+                    i = skip_space(i, false);
+                    if (i >= m_text.size()) return npos;
+                    if (m_text[i] == '"' || m_text[i] == '\'') {
+                        plain = false;
+                        i = skip_string(i);
+                        if (i == npos) return npos;
+                    } else {
+                        const std::size_t begin = i;
+                        while (i < m_text.size() && is_bare_key_char(m_text[i])) ++i;
+                        if (i == begin) return npos;
+                        if (!key.empty()) key += '.';
+                        key.append(m_text.substr(begin, i - begin));
+                    }
+                    i = skip_space(i, false);
+                    if (i >= m_text.size() || m_text[i] != '.') return i;
+                    ++i;
+                }
+            }
+
+            [[nodiscard]] std::size_t skip_string(std::size_t i) const {
+                const char quote = m_text[i];
+                const std::string close(3, quote);
+                if (m_text.substr(i, 3) == close) {
+                    i += 3;
+                    while (i < m_text.size()) {
+                        if (quote == '"' && m_text[i] == '\\') {
+                            i += 2;
+                        } else if (m_text.substr(i, 3) == close) {
+                            // Up to two quotes may directly precede the closing delimiter.
+                            i += 3;
+                            while (i < m_text.size() && m_text[i] == quote) ++i;
+                            return i;
+                        } else {
+                            ++i;
+                        }
+                    }
+                    return npos;
+                }
+                for (++i; i < m_text.size() && m_text[i] != '\n'; ++i) {
+                    if (quote == '"' && m_text[i] == '\\') {
+                        ++i;
+                    } else if (m_text[i] == quote) {
+                        return i + 1;
+                    }
+                }
+                return npos;
+            }
+
+            /// Values nested deeper than this are left to toml++, which rejects them, instead of exhausting the stack.
+            static constexpr std::size_t max_depth = 256;
+
+            [[nodiscard]] std::size_t skip_value(std::size_t i, const std::size_t depth = 0) const {
+                if (i >= m_text.size()) return npos;
+                switch (m_text[i]) {
+                    case '"':
+                    case '\'':
+                        return skip_string(i);
+                    case '[': {
+                        if (depth == max_depth) return npos;
+                        ++i;
+                        while (true) {
+                            i = skip_space(i, true);
+                            if (i >= m_text.size()) return npos;
+                            if (m_text[i] == ']') return i + 1;
+                            i = skip_value(i, depth + 1);
+                            if (i == npos) return npos;
+                            i = skip_space(i, true);
+                            if (i < m_text.size() && m_text[i] == ',') ++i;
+                            else if (i >= m_text.size() || m_text[i] != ']') return npos;
+                        }
+                    }
+                    case '{': {
+                        if (depth == max_depth) return npos;
+                        ++i;
+                        while (true) {
+                            i = skip_space(i, false);
+                            if (i >= m_text.size()) return npos;
+                            if (m_text[i] == '}') return i + 1;
+                            std::string key;
+                            bool plain = true;
+                            i = read_key(i, key, plain);
+                            if (i == npos || !consume(i, '=')) return npos;
+                            i = skip_value(skip_space(i, false), depth + 1);
+                            if (i == npos) return npos;
+                            i = skip_space(i, false);
+                            if (i < m_text.size() && m_text[i] == ',') ++i;
+                            else if (i >= m_text.size() || m_text[i] != '}') return npos;
+                        }
+                    }
+                    default: {
+                        // Numbers, booleans and dates; a date may contain a space before its time.
+                        const std::size_t begin = i;
+                        while (i < m_text.size() && m_text[i] != ',' && m_text[i] != ']' && m_text[i] != '}' &&
+                               m_text[i] != '\n' && m_text[i] != '\r' && m_text[i] != '#') {
+                            ++i;
+                        }
+                        return i == begin ? npos : i;
+                    }
+                }
+            }
+
+            /// Whether an array holds no strings, tables or nested arrays.
+            [[nodiscard]] bool is_flat(const std::size_t begin, const std::size_t end) const {
+                for (std::size_t i = begin + 1; i + 1 < end; ++i) {
+                    const char c = m_text[i];
+                    if (c == '#') {
+                        while (i + 1 < end && m_text[i] != '\n') ++i;
+                    } else if (c == '[' || c == '{' || c == '"' || c == '\'') {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            std::string_view m_text;
+            std::size_t m_min_bytes;
+        };
+
+        /**
+         * @brief Reads one array element as toml++ would for an `Element` field.
+         * @return The offset after the element, or `npos` if it is not a plain decimal literal of the right kind.
+         */
+        template <typename Element>
+        std::size_t read_element(const std::string_view text, std::size_t i, Element& out) {
+            constexpr std::size_t npos = std::string_view::npos;
+            const bool plus = text[i] == '+';
+            if (plus) ++i;
+            const char* first = text.data() + i;
+            const char* last = text.data() + text.size();
+            if (first == last || (plus && *first == '-')) return npos;
+            const std::size_t digits = *first == '-' ? i + 1 : i;
+            // TOML forbids leading zeros, which from_chars would accept.
+            if (digits + 1 < text.size() && text[digits] == '0' && text[digits + 1] >= '0' && text[digits + 1] <= '9') return npos;
+
+            const char* stop = nullptr;
+            if constexpr (std::is_floating_point_v<Element>) {
+                double value = 0.0;
+                const auto [ptr, ec] = std::from_chars(first, last, value);
+                if (ec != std::errc{}) return npos;
+                // toml++ does not read integers into floating-point fields.
+                if (std::find_first_of(first, ptr, "._eEin", "._eEin" + 6) == ptr) return npos;
+                out = static_cast<Element>(value);
+                stop = ptr;
+            } else {
+                std::int64_t value = 0;
+                const auto [ptr, ec] = std::from_chars(first, last, value);
+                if (ec != std::errc{}) return npos;
+                out = static_cast<Element>(value);
+                stop = ptr;
+            }
+            if (stop != last && *stop != ',' && *stop != ']' && *stop != ' ' && *stop != '\t' && *stop != '\n' &&
+                *stop != '\r' && *stop != '#') {
+                return npos;
+            }
+            return static_cast<std::size_t>(stop - text.data());
+        }
+
+        /**
+         * @brief Reads a flat TOML array into `values`, replacing its contents.
+         * @return False if an element is not one the fast path reads; `values` is then unspecified.
+         */
+        template <typename Vector>
+        bool read_numeric_array(const std::string_view text, Vector& values) {
+            using Element = typename Vector::value_type;
+            values.clear();
+            values.reserve(static_cast<std::size_t>(std::ranges::count(text, ',')) + 1);
+            std::size_t i = 1;
+            while (true) {
+                while (i < text.size()) {
+                    const char c = text[i];
+                    if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+                        ++i;
+                    } else if (c == '#') {
+                        while (i < text.size() && text[i] != '\n') ++i;
+                    } else {
+                        break;
+                    }
+                }
+                if (i >= text.size()) return false;
+                if (text[i] == ']') return true;
+                if (text[i] == ',') {
+                    // The scanner only passes arrays whose commas each follow an element.
+                    ++i;
+                    continue;
+                }
+                Element element{};
+                i = read_element(text, i, element);
+                if (i == std::string_view::npos) return false;
+                values.push_back(element);
+            }
+        }
+    }
+
+    /// Whether a schema has numeric vector fields the fast path can read.
+    template <typename T>
+    constexpr bool has_numeric_array_fields_v = detail::has_numeric_array_fields<std::remove_cvref_t<T>>::value;
+
+    /**
+     * @brief Finds the large numeric arrays of a TOML document that land in numeric vector fields of `T`.
+     * @param text The document.
+     * @param min_bytes Minimum length of an array's source text.
+     * @return The candidates in source order; empty if there are none or the scanner gave up.
+     */
+    template <typename T>
+    std::vector<NumericArraySpan> scan_numeric_arrays(const std::string_view text,
+                                                      const std::size_t min_bytes = numeric_array_min_bytes) {
+        std::vector<NumericArraySpan> spans = detail::TomlArrayScanner(text, min_bytes).scan();
+        std::erase_if(spans, [](const NumericArraySpan& span) {
+            return !detail::names_numeric_array<T>(config::detail::split_path(span.path).second);
+        });
+        return spans;
+    }
+
+    /**
+     * @brief Returns a copy of `text` with each candidate array replaced by `[]`.
+     *
+     * Line breaks inside the arrays are kept, so toml++ reports the same source positions.
+     */
+    inline std::string elide_numeric_arrays(const std::string_view text, const std::vector<NumericArraySpan>& spans) {
+        std::string elided;
+        elided.reserve(text.size());
+        std::size_t copied = 0;
+        for (const auto& span : spans) {
+            elided.append(text.substr(copied, span.begin - copied));
+            elided.append("[]");
+            elided.append(static_cast<std::size_t>(std::count(text.begin() + span.begin, text.begin() + span.end, '\n')), '\n');
+            copied = span.end;
+        }
+        elided.append(text.substr(copied));
+        return elided;
+    }
+
+    /**
+     * @brief Reads the candidate arrays under the loaded root table into their fields.
+     * @param content Content deserialized from the elided text.
+     * @param text The original document.
+     * @param spans The candidates returned by `scan_numeric_arrays<T>()` for `text`.
+     * @param root_name The root table `content` was read from.
+     * @return False if an array holds an element the fast path does not read.
+     */
+    template <typename T>
+    bool fill_numeric_arrays(T& content, const std::string_view text, const std::vector<NumericArraySpan>& spans,
+                             const std::string_view root_name) {
+        bool read = true;
+        for (const auto& span : spans) {
+            const auto [root, path] = config::detail::split_path(span.path);
+            if (root != root_name) continue;
+            const std::string_view array = text.substr(span.begin, span.end - span.begin);
+            config::detail::visit_at(content, path, [&](auto& field) {
+                using Field = std::remove_cvref_t<decltype(field)>;
+                if constexpr (is_sidecar_array_v<Field>) {
+                    read = read && detail::read_numeric_array(array, field);
+                } else if constexpr (validate::is_sink_v<Field>) {
+                    typename Field::Appender out(field);
+                    read = read && detail::read_numeric_array(array, out);
+                    if (read) out.finish();
+                } else if constexpr (detail::is_numeric_array_field_v<Field>) {
+                    read = read && detail::read_numeric_array(array, field.emplace());
+                }
+            });
+            if (!read) return false;
+        }
+        return true;
+    }
+}
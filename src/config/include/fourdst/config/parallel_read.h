@@ -0,0 +1,155 @@
+/**
+ * @file parallel_read.h
+ * @brief Deserializing large arrays of tables from TOML on several threads.
+ *
+ * The elements of an array of tables are independent once the DOM is built, so with parallel
+ * reading enabled (see `Config::set_parallel_read()`), the `Parser` specialization below splits
+ * a `std::vector` of structs with at least `ParallelReadOptions::parallel_threshold` elements
+ * into contiguous chunks, reads the chunks as units of work on the default executor (see
+ * executor.h) straight into a pre-sized vector,
+ * and reports the error of the first failing element, exactly as a serial read would.
+ *
+ * Arrays nested inside the elements are read serially by the thread that owns the element.
+ * Parallel reading is not used for schemas with `std::string_view` fields or with a memory
+ * resource set, since their storage is not synchronized.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "fourdst/config/container_read.h"
+#include "fourdst/config/executor.h"
+#include "fourdst/config/fixed_array.h"
+#include "fourdst/config/toml_writer.h"
+
+#include "rfl.hpp"
+#include "rfl/toml.hpp"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config::io {
+
+    /**
+     * @brief Tuning knobs for parallel deserialization.
+     */
+    struct ParallelReadOptions {
+        /// Arrays of tables with at least this many elements are read on several threads.
+        std::size_t parallel_threshold = 4096;
+        /// Maximum number of threads for one array; 0 uses `std::thread::hardware_concurrency()`.
+        unsigned max_threads = 0;
+    };
+
+    namespace detail {
+        inline const ParallelReadOptions*& parallel_read_slot() {
+            thread_local const ParallelReadOptions* options = nullptr;
+            return options;
+        }
+    }
+
+    /**
+     * @brief Enables parallel reading on the current thread for the lifetime of the guard.
+     */
+    class ScopedParallelRead {
+    public:
+        /**
+         * @brief Installs `options`; null disables parallel reading.
+         */
+        explicit ScopedParallelRead(const ParallelReadOptions* options) : m_previous(detail::parallel_read_slot()) {
+            detail::parallel_read_slot() = options;
+        }
+
+        ScopedParallelRead(const ScopedParallelRead&) = delete;
+        ScopedParallelRead& operator=(const ScopedParallelRead&) = delete;
+
+        ~ScopedParallelRead() { detail::parallel_read_slot() = m_previous; }
+
+    private:
+        const ParallelReadOptions* m_previous;
+    };
+
+    namespace detail {
+        /**
+         * @brief The first error met by one worker.
+         */
+        struct ChunkError {
+            rfl::Error error;
+            std::optional<ArraySizeMismatch> mismatch;
+        };
+
+        /**
+         * @brief Reads the elements of `array` into `values` as `workers` units of work on the default executor.
+         *
+         * The calling thread may run a unit, so each one disables parallel reading while it runs.
+         *
+         * @return The error of the first failing element, or `std::nullopt`.
+         */
+        template <class ElementParser, class Element>
+        std::optional<ChunkError> read_chunks(const rfl::toml::Reader& reader, toml::array& array, std::vector<Element>& values,
+                                              const std::size_t workers) {
+            const std::size_t chunk = (array.size() + workers - 1) / workers;
+            std::vector<std::optional<ChunkError>> errors(workers);
+            bulk_execute(workers, [&](const std::size_t w) {
+                const ScopedParallelRead serial(nullptr);
+                const std::size_t begin = w * chunk;
+                const std::size_t end = std::min(array.size(), begin + chunk);
+                for (std::size_t i = begin; i < end; ++i) {
+                    auto element = ElementParser::read(reader, array.get(i));
+                    if (!element) {
+                        errors[w] = ChunkError{element.error(), last_array_size_mismatch()};
+                        return;
+                    }
+                    values[i] = std::move(*element);
+                }
+            });
+            for (auto& error : errors) {
+                if (error) return std::move(error);
+            }
+            return std::nullopt;
+        }
+    }
+}
+
+namespace rfl::parsing {
+
+    /**
+     * @brief Reads a `std::vector` of structs from TOML, splitting large arrays across threads when enabled.
+     */
+    template <class T, class ProcessorsType>
+        requires fourdst::config::io::detail::reads_in_parallel_v<T>
+    struct Parser<rfl::toml::Reader, rfl::toml::Writer, std::vector<T>, ProcessorsType>
+        : public fourdst::config::io::detail::ReservingVectorParser<T, ProcessorsType> {
+        using Serial = fourdst::config::io::detail::ReservingVectorParser<T, ProcessorsType>;
+        using InputVarType = typename rfl::toml::Reader::InputVarType;
+        using ElementParser = Parser<rfl::toml::Reader, rfl::toml::Writer, T, ProcessorsType>;
+
+        static Result<std::vector<T>> read(const rfl::toml::Reader& _r, const InputVarType& _var) noexcept {
+            const fourdst::config::io::ParallelReadOptions* options = fourdst::config::io::detail::parallel_read_slot();
+            ::toml::array* array = _var->as_array();
+            if (options == nullptr || array == nullptr || array->size() < options->parallel_threshold) {
+                return Serial::read(_r, _var);
+            }
+            const unsigned threads = options->max_threads != 0 ? options->max_threads : std::thread::hardware_concurrency();
+            if (threads <= 1) return Serial::read(_r, _var);
+
+            // Workers read serially below this point: each chunk clears the per-thread slot while it runs.
+            try {
+                std::vector<T> values(array->size());
+                const auto failed = fourdst::config::io::detail::read_chunks<ElementParser>(
+                    _r, *array, values, std::min<std::size_t>(threads, array->size()));
+                if (failed) {
+                    fourdst::config::io::last_array_size_mismatch() = failed->mismatch;
+                    return error(failed->error.what());
+                }
+                return values;
+            } catch (const std::exception&) {
+                return Serial::read(_r, _var);
+            }
+        }
+    };
+}
@@ -0,0 +1,155 @@
+/**
+ * @file patch.h
+ * @brief Merge patches: apply a small TOML or JSON document to parts of a configuration.
+ *
+ * A patch mirrors the layout of the schema but names only the fields it changes:
+ *
+ * @code
+ * [simulation]
+ * time_step = 0.25
+ * @endcode
+ *
+ * Tables of the patch are merged into the matching nested structs; any other value replaces the
+ * field it names, and is deserialized on its own with `reflect-cpp`. Fields the patch does not
+ * mention are neither read nor written, so the cost is proportional to the patch, not the schema.
+ *
+ * `diff_toml_tables()` goes the other way and builds the patch between two versions of a document.
+ */
+#pragma once
+
+#include <format>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/path_table.h"
+
+#include "rfl.hpp"
+#include "rfl/json.hpp"
+#include "rfl/toml.hpp"
+#include "yyjson.h"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config::io {
+
+    namespace detail {
+        inline std::string join_path(const std::string_view prefix, const std::string_view key) {
+            return prefix.empty() ? std::string(key) : std::format("{}.{}", prefix, key);
+        }
+
+        [[noreturn]] inline void throw_unknown_patch_key(const std::string_view path) {
+            throw exceptions::ConfigPathError(
+                std::format("Cannot apply config patch: '{}' is not a field path of the config schema.", path));
+        }
+
+        template <typename Result>
+        void assign_patch_value(auto& field, Result result, const std::string_view path) {
+            if (!result) {
+                throw exceptions::ConfigParseError(
+                    std::format("Cannot apply config patch at '{}'. Reason: {}", path, result.error().what()));
+            }
+            field = std::move(result).value();
+        }
+    }
+
+    /**
+     * @brief Merges a TOML patch table into `target`.
+     * @tparam V The (nested) schema type of `target`.
+     * @param target The struct to patch in place; may be partially patched if this throws.
+     * @param patch The patch table; keys are field names of `V`.
+     * @param prefix Dotted path of `target`, for error messages.
+     * @throws exceptions::ConfigPathError If a key does not name a field.
+     * @throws exceptions::ConfigParseError If a value does not match its field.
+     */
+    template <typename V>
+    void apply_toml_patch(V& target, toml::table& patch, const std::string_view prefix = {}) {
+        using Fields = typename rfl::named_tuple_t<V>::Fields;
+        auto values = rfl::to_view(target).values();
+        for (auto&& [key, node] : patch) {
+            const std::string_view name = key.str();
+            const bool found = [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                return ([&] {
+                    using Field = rfl::tuple_element_t<Is, Fields>;
+                    if (Field::name() != name) return false;
+                    auto& field = *rfl::get<Is>(values);
+                    if constexpr (config::detail::is_path_struct_v<typename Field::Type>) {
+                        if (toml::table* child = node.as_table()) {
+                            apply_toml_patch(field, *child, detail::join_path(prefix, name));
+                            return true;
+                        }
+                    }
+                    detail::assign_patch_value(field, rfl::toml::read<typename Field::Type>(&node),
+                                               detail::join_path(prefix, name));
+                    return true;
+                }() || ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+            if (!found) {
+                detail::throw_unknown_patch_key(detail::join_path(prefix, name));
+            }
+        }
+    }
+
+    /**
+     * @brief Builds the TOML patch that turns `before` into `after`.
+     *
+     * Tables present in both are compared key by key, so the patch holds only the changed leaves
+     * and the tables leading to them; any other changed value (including an array of tables) is
+     * copied whole.
+     *
+     * @return The patch, empty if the tables are equal; nothing if `after` lacks a key of
+     *         `before`, since a merge patch cannot remove a field.
+     */
+    inline std::optional<toml::table> diff_toml_tables(const toml::table& before, const toml::table& after) {
+        for (auto&& [key, node] : before) {
+            if (!after.contains(key.str())) return std::nullopt;
+        }
+        toml::table patch;
+        for (auto&& [key, node] : after) {
+            const toml::node* previous = before.get(key.str());
+            if (previous != nullptr && previous->is_table() && node.is_table()) {
+                std::optional<toml::table> child = diff_toml_tables(*previous->as_table(), *node.as_table());
+                if (!child) return std::nullopt;
+                if (!child->empty()) patch.insert(key.str(), std::move(*child));
+            } else if (previous == nullptr || toml::node_view<const toml::node>(previous) != toml::node_view<const toml::node>(&node)) {
+                node.visit([&](const auto& concrete) { patch.insert(key.str(), concrete); });
+            }
+        }
+        return patch;
+    }
+
+    /**
+     * @brief Merges a JSON patch object into `target`; see `apply_toml_patch()`.
+     */
+    template <typename V>
+    void apply_json_patch(V& target, yyjson_val* patch, const std::string_view prefix = {}) {
+        using Fields = typename rfl::named_tuple_t<V>::Fields;
+        auto values = rfl::to_view(target).values();
+        yyjson_obj_iter iter = yyjson_obj_iter_with(patch);
+        while (yyjson_val* key = yyjson_obj_iter_next(&iter)) {
+            const std::string_view name(yyjson_get_str(key), yyjson_get_len(key));
+            yyjson_val* value = yyjson_obj_iter_get_val(key);
+            const bool found = [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                return ([&] {
+                    using Field = rfl::tuple_element_t<Is, Fields>;
+                    if (Field::name() != name) return false;
+                    auto& field = *rfl::get<Is>(values);
+                    if constexpr (config::detail::is_path_struct_v<typename Field::Type>) {
+                        if (yyjson_is_obj(value)) {
+                            apply_json_patch(field, value, detail::join_path(prefix, name));
+                            return true;
+                        }
+                    }
+                    detail::assign_patch_value(field, rfl::json::read<typename Field::Type>(rfl::json::InputVarType(value)),
+                                               detail::join_path(prefix, name));
+                    return true;
+                }() || ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+            if (!found) {
+                detail::throw_unknown_patch_key(detail::join_path(prefix, name));
+            }
+        }
+    }
+}
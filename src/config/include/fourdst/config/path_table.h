@@ -0,0 +1,282 @@
+/**
+ * @file path_table.h
+ * @brief Compile-time table of dotted field paths for keyed access to configuration structures.
+ *
+ * `PathTable<T>` lists every field of a schema by its dotted path (`"simulation.time_step"`),
+ * recursing into nested structs. For each path it stores a type tag and an accessor that resolves
+ * the field inside a `T`; the accessors are generated per field from `reflect-cpp` views and
+ * compile down to a constant pointer offset. Lookups go through a perfect hash built at compile
+ * time (hash and displace), so a lookup costs two hash computations, a key comparison and the
+ * accessor call.
+ *
+ * The table is also the field metadata every reflective feature shares: each entry records its
+ * depth, the end of its subtree, whether it is a leaf or an optional, and its `sizeof`, and
+ * `PathTable<T>::functions<F, Op>()` generates one typed function per entry. Diff, the memory
+ * report, the CLI and path lookup iterate the flat table instead of recursing over
+ * `rfl::to_view` and building paths at run time.
+ *
+ * Optionals, containers and maps are leaves: `"output"` names a `std::optional<Output>` as a whole,
+ * but `"output.directory"` is not a path.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "fourdst/config/compare.h"
+#include "fourdst/config/perfect_hash.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+
+namespace fourdst::config::detail {
+
+    template <typename V>
+    inline constexpr char path_type_tag = 0;
+
+    /**
+     * @brief Returns a unique identifier for the type `V`, usable in constant expressions.
+     */
+    template <typename V>
+    constexpr const void* path_type_id() {
+        return &path_type_tag<std::remove_cvref_t<V>>;
+    }
+
+    /// Structs whose fields get their own paths.
+    template <typename Type>
+    constexpr bool is_path_struct_v = validate::is_reflectable_struct_v<Type> &&
+                                      !is_std_array_v<Type> &&
+                                      std::is_aggregate_v<std::remove_cvref_t<Type>>;
+
+    template <typename T>
+    struct RootAccess {
+        static const T* address(const T& root) { return &root; }
+    };
+
+    template <typename T, typename ParentAccess, int I>
+    struct FieldAccess {
+        static auto address(const T& root) {
+            return rfl::get<I>(rfl::to_view(*ParentAccess::address(root)).values());
+        }
+        static const void* erased(const T& root) { return address(root); }
+    };
+
+    /**
+     * @brief One addressable field of a schema.
+     * @tparam T The schema type the accessor resolves against.
+     */
+    template <typename T>
+    struct PathEntry {
+        /// Offset of the path in the table's key storage.
+        std::size_t key_begin = 0;
+        /// Length of the path.
+        std::size_t key_length = 0;
+        /// `path_type_id()` of the field type.
+        const void* type = nullptr;
+        /// Returns the address of the field inside a `T`.
+        const void* (*address)(const T&) = nullptr;
+        /// Nesting depth; 0 for fields of `T` itself.
+        std::size_t depth = 0;
+        /// Index one past the last entry nested in this one; `index + 1` for leaves.
+        std::size_t end = 0;
+        /// `sizeof` the field.
+        std::size_t size = 0;
+        /// False for nested structs, whose fields have entries of their own.
+        bool leaf = true;
+        /// True for `std::optional` fields.
+        bool optional = false;
+    };
+
+    struct PathTableSize {
+        std::size_t entries = 0;
+        std::size_t chars = 0;
+    };
+
+    template <typename V>
+    constexpr void measure_paths(PathTableSize& size, const std::size_t prefix_length) {
+        using Fields = typename rfl::named_tuple_t<V>::Fields;
+        [&]<int... Is>(std::integer_sequence<int, Is...>) {
+            ([&] {
+                using Field = rfl::tuple_element_t<Is, Fields>;
+                const std::size_t length = prefix_length + (prefix_length != 0 ? 1 : 0) + Field::name().size();
+                ++size.entries;
+                size.chars += length;
+                if constexpr (is_path_struct_v<typename Field::Type>) {
+                    measure_paths<typename Field::Type>(size, length);
+                }
+            }(), ...);
+        }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+    }
+
+    /**
+     * @brief `PathTable::functions()` operation comparing two fields of type `F` with `equal()`.
+     */
+    template <typename F>
+    struct FieldEqual {
+        static bool apply(const void* lhs, const void* rhs) { return equal(*static_cast<const F*>(lhs), *static_cast<const F*>(rhs)); }
+    };
+
+    /**
+     * @brief The compile-time path table of a schema.
+     * @tparam T The configuration schema type.
+     */
+    template <typename T>
+    class PathTable {
+        static constexpr PathTableSize s_size = [] {
+            PathTableSize size;
+            measure_paths<T>(size, 0);
+            return size;
+        }();
+
+        static constexpr std::size_t s_entry_count = s_size.entries;
+
+        struct Data {
+            std::array<char, s_size.chars> chars{};
+            std::array<PathEntry<T>, s_entry_count> entries{};
+            PerfectHash<s_entry_count> hash{};
+        };
+
+        template <typename V, typename Access>
+        static constexpr void collect(Data& data, std::size_t& next_entry, std::size_t& next_char,
+                                      const std::size_t parent_begin, const std::size_t parent_length, const std::size_t depth) {
+            using Fields = typename rfl::named_tuple_t<V>::Fields;
+            [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                ([&] {
+                    using Field = rfl::tuple_element_t<Is, Fields>;
+                    using Child = FieldAccess<T, Access, Is>;
+                    const std::size_t begin = next_char;
+                    for (std::size_t i = 0; i < parent_length; ++i) {
+                        data.chars[next_char++] = data.chars[parent_begin + i];
+                    }
+                    if (parent_length != 0) data.chars[next_char++] = '.';
+                    for (const char c : Field::name()) data.chars[next_char++] = c;
+
+                    using Type = std::remove_cvref_t<typename Field::Type>;
+                    const std::size_t index = next_entry++;
+                    data.entries[index] = PathEntry<T>{begin, next_char - begin, path_type_id<Type>(), &Child::erased,
+                                                       depth, 0, sizeof(Type), !is_path_struct_v<Type>,
+                                                       validate::is_optional_v<Type>};
+                    if constexpr (is_path_struct_v<Type>) {
+                        collect<Type, Child>(data, next_entry, next_char, begin, next_char - begin, depth + 1);
+                    }
+                    data.entries[index].end = next_entry;
+                }(), ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        }
+
+        static constexpr std::string_view key_of(const Data& data, const PathEntry<T>& entry) {
+            return {data.chars.data() + entry.key_begin, entry.key_length};
+        }
+
+        static constexpr Data build() {
+            Data data;
+            std::size_t next_entry = 0;
+            std::size_t next_char = 0;
+            collect<T, RootAccess<T>>(data, next_entry, next_char, 0, 0, 0);
+
+            std::array<std::uint64_t, s_entry_count> hashes{};
+            for (std::size_t i = 0; i < s_entry_count; ++i) {
+                hashes[i] = path_hash(key_of(data, data.entries[i]));
+            }
+            data.hash = PerfectHash<s_entry_count>::build(hashes);
+            return data;
+        }
+
+        static const Data s_data;
+
+        template <typename V, typename Function, template <typename> class Op>
+        static constexpr void collect_functions(std::array<Function*, s_entry_count>& functions, std::size_t& next) {
+            using Fields = typename rfl::named_tuple_t<V>::Fields;
+            [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                ([&] {
+                    using Type = std::remove_cvref_t<typename rfl::tuple_element_t<Is, Fields>::Type>;
+                    functions[next++] = &Op<Type>::apply;
+                    if constexpr (is_path_struct_v<Type>) collect_functions<Type, Function, Op>(functions, next);
+                }(), ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        }
+
+        template <typename Function, template <typename> class Op>
+        static constexpr std::array<Function*, s_entry_count> s_functions = [] {
+            std::array<Function*, s_entry_count> functions{};
+            std::size_t next = 0;
+            collect_functions<T, Function, Op>(functions, next);
+            return functions;
+        }();
+
+    public:
+        /// Sentinel returned by `find()` for unknown paths.
+        static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+        /**
+         * @brief Returns the number of addressable paths in `T`.
+         */
+        static constexpr std::size_t size() { return s_entry_count; }
+
+        /**
+         * @brief Looks up a dotted path.
+         * @param path Dotted field path relative to `T`.
+         * @return The entry index, or `npos` if `path` does not name a field.
+         */
+        static constexpr std::size_t find(const std::string_view path) {
+            static_assert(s_data.hash.perfect, "Unable to build a perfect hash for the field paths of this schema.");
+            if constexpr (s_entry_count == 0) {
+                return npos;
+            } else {
+                const std::size_t index = s_data.hash.candidate(path_hash(path));
+                if (index == 0 || key_of(s_data, s_data.entries[index - 1]) != path) {
+                    return npos;
+                }
+                return index - 1;
+            }
+        }
+
+        /**
+         * @brief Returns the entry at `index` (as returned by `find()`).
+         */
+        static constexpr const PathEntry<T>& entry(const std::size_t index) { return s_data.entries[index]; }
+
+        /**
+         * @brief Returns the dotted path of the entry at `index`.
+         */
+        static constexpr std::string_view path(const std::size_t index) { return key_of(s_data, s_data.entries[index]); }
+
+        /**
+         * @brief Returns the name of the entry at `index`, the last component of its path.
+         */
+        static constexpr std::string_view name(const std::size_t index) {
+            const std::string_view key = path(index);
+            const std::size_t dot = key.rfind('.');
+            return dot == std::string_view::npos ? key : key.substr(dot + 1);
+        }
+
+        /**
+         * @brief Returns one function per entry, `&Op<F>::apply` for the entry's field type `F`.
+         *
+         * The table is built at compile time, once per `Op`. Every `Op<F>::apply` must have the
+         * type `Function`; it is typically a function over `const void*` that casts to `const F*`.
+         *
+         * @code
+         * template <typename F>
+         * struct Print { static std::string apply(const void* field) { return std::format("{}", *static_cast<const F*>(field)); } };
+         *
+         * const auto& print = PathTable<T>::functions<std::string(const void*), Print>();
+         * for (std::size_t i = 0; i < PathTable<T>::size(); ++i) {
+         *     if (PathTable<T>::entry(i).leaf) out << print[i](PathTable<T>::entry(i).address(content));
+         * }
+         * @endcode
+         */
+        template <typename Function, template <typename> class Op>
+        static constexpr const std::array<Function*, s_entry_count>& functions() {
+            return s_functions<Function, Op>;
+        }
+    };
+
+    template <typename T>
+    constexpr typename PathTable<T>::Data PathTable<T>::s_data = PathTable<T>::build();
+}
@@ -0,0 +1,122 @@
+/**
+ * @file perfect_hash.h
+ * @brief Minimal perfect hashing of a fixed set of names, built at compile time.
+ *
+ * Shared by every lookup of a name known at compile time: dotted paths (`PathTable`), TOML keys
+ * of wide structs (`field_index.h`), environment variables (`env.h`), union tags
+ * (`tagged_union.h`) and enumerator and literal names (`enum_index.h`).
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace fourdst::config::detail {
+
+    /**
+     * @brief Mixes a 64-bit value; used for the compile-time perfect hash.
+     */
+    constexpr std::uint64_t path_mix(std::uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    /**
+     * @brief FNV-1a hash of a path, finished with `path_mix`.
+     */
+    constexpr std::uint64_t path_hash(const std::string_view path) {
+        std::uint64_t h = 0xcbf29ce484222325ULL;
+        for (const char c : path) {
+            h ^= static_cast<unsigned char>(c);
+            h *= 0x100000001b3ULL;
+        }
+        return path_mix(h);
+    }
+
+    /**
+     * @brief A minimal perfect hash over `N` precomputed key hashes, built at compile time by hash
+     *        and displace.
+     *
+     * `candidate()` maps any hash to the one index that may hold it; the caller confirms the
+     * match by comparing keys.
+     */
+    template <std::size_t N>
+    struct PerfectHash {
+        static constexpr std::size_t bucket_count = N == 0 ? 1 : N;
+        static constexpr std::size_t slot_count = [] {
+            std::size_t slots = 1;
+            while (slots < N) slots <<= 1;
+            return slots;
+        }();
+
+        std::array<std::uint64_t, bucket_count> seeds{};
+        /// Key index + 1 per slot; 0 marks an empty slot.
+        std::array<std::size_t, slot_count> slots{};
+        bool perfect = true;
+
+        static constexpr std::size_t slot_for(const std::uint64_t hash, const std::uint64_t seed) {
+            return static_cast<std::size_t>(path_mix(hash ^ (seed * 0x9e3779b97f4a7c15ULL))) & (slot_count - 1);
+        }
+
+        /// Key index + 1 of the only key that may hash to `hash`, or 0 if there is none.
+        [[nodiscard]] constexpr std::size_t candidate(const std::uint64_t hash) const {
+            return slots[slot_for(hash, seeds[hash % bucket_count])];
+        }
+
+        static constexpr PerfectHash build(const std::array<std::uint64_t, N>& hashes) {
+            PerfectHash table;
+            // Place the largest buckets first, trying seeds until every key of the bucket lands in
+            // a distinct free slot. Buckets are laid out contiguously in `members` (a counting
+            // sort by bucket) so each attempt only touches its own keys.
+            std::array<std::size_t, bucket_count + 1> bucket_begin{};
+            for (std::size_t i = 0; i < N; ++i) {
+                ++bucket_begin[hashes[i] % bucket_count + 1];
+            }
+            std::size_t largest = 0;
+            for (std::size_t bucket = 0; bucket < bucket_count; ++bucket) {
+                largest = bucket_begin[bucket + 1] > largest ? bucket_begin[bucket + 1] : largest;
+                bucket_begin[bucket + 1] += bucket_begin[bucket];
+            }
+            std::array<std::size_t, N> members{};
+            std::array<std::size_t, bucket_count> fill{};
+            for (std::size_t i = 0; i < N; ++i) {
+                const std::size_t bucket = hashes[i] % bucket_count;
+                members[bucket_begin[bucket] + fill[bucket]++] = i;
+            }
+
+            for (std::size_t size = largest; size > 0; --size) {
+                for (std::size_t bucket = 0; bucket < bucket_count; ++bucket) {
+                    const std::size_t begin = bucket_begin[bucket];
+                    const std::size_t end = bucket_begin[bucket + 1];
+                    if (end - begin != size) continue;
+                    bool placed = false;
+                    for (std::uint64_t seed = 0; seed < (1u << 16) && !placed; ++seed) {
+                        std::size_t taken = begin;
+                        while (taken < end) {
+                            const std::size_t slot = slot_for(hashes[members[taken]], seed);
+                            if (table.slots[slot] != 0) break;
+                            table.slots[slot] = members[taken] + 1;
+                            ++taken;
+                        }
+                        placed = taken == end;
+                        if (placed) {
+                            table.seeds[bucket] = seed;
+                        } else {
+                            for (std::size_t k = begin; k < taken; ++k) {
+                                table.slots[slot_for(hashes[members[k]], seed)] = 0;
+                            }
+                        }
+                    }
+                    table.perfect = table.perfect && placed;
+                }
+            }
+            return table;
+        }
+    };
+}
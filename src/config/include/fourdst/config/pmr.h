@@ -0,0 +1,146 @@
+/**
+ * @file pmr.h
+ * @brief Polymorphic-allocator support: `std::pmr` containers in schemas and arena-backed parsing.
+ *
+ * Schemas may use `std::pmr::string` and `std::pmr::vector` members. reflect-cpp reads and
+ * writes them through the `rfl::Reflector` specializations below, which allocate from the
+ * resource installed by a `ScopedFieldResource` on the current thread (the default resource
+ * otherwise). `Config::set_memory_resource()` installs one around each load, so the fields of a
+ * loaded `T` live in a caller-provided arena.
+ *
+ * `ParseArena` adapts a `std::pmr::monotonic_buffer_resource` to yyjson's allocator interface,
+ * so a JSON document is built in an arena that is released in one step after deserialization.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <memory_resource>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rfl.hpp"
+#include "yyjson.h"
+
+namespace fourdst::config::io {
+
+    namespace detail {
+        inline std::pmr::memory_resource*& field_resource_slot() {
+            thread_local std::pmr::memory_resource* resource = nullptr;
+            return resource;
+        }
+    }
+
+    /**
+     * @brief Returns the resource `std::pmr` fields are allocated from while deserializing on this thread.
+     */
+    inline std::pmr::memory_resource* field_resource() {
+        std::pmr::memory_resource* resource = detail::field_resource_slot();
+        return resource != nullptr ? resource : std::pmr::get_default_resource();
+    }
+
+    /**
+     * @brief Installs a field resource on the current thread for the lifetime of the guard.
+     */
+    class ScopedFieldResource {
+    public:
+        /**
+         * @brief Installs `resource`; null keeps the current one.
+         */
+        explicit ScopedFieldResource(std::pmr::memory_resource* resource) : m_previous(detail::field_resource_slot()) {
+            if (resource != nullptr) detail::field_resource_slot() = resource;
+        }
+
+        ScopedFieldResource(const ScopedFieldResource&) = delete;
+        ScopedFieldResource& operator=(const ScopedFieldResource&) = delete;
+
+        ~ScopedFieldResource() { detail::field_resource_slot() = m_previous; }
+
+    private:
+        std::pmr::memory_resource* m_previous;
+    };
+
+    /**
+     * @brief A monotonic arena exposed as a yyjson allocator.
+     *
+     * Everything yyjson allocates through `allocator()` is released at once when the arena is
+     * destroyed; individual frees are no-ops.
+     */
+    class ParseArena {
+    public:
+        /**
+         * @brief Creates an arena drawing its blocks from `upstream`.
+         */
+        explicit ParseArena(std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+            : m_arena(upstream), m_allocator{&ParseArena::allocate, &ParseArena::reallocate, &ParseArena::release, this} {}
+
+        ParseArena(const ParseArena&) = delete;
+        ParseArena& operator=(const ParseArena&) = delete;
+
+        /**
+         * @brief Returns the allocator to pass to `yyjson_read_opts()`.
+         */
+        [[nodiscard]] const yyjson_alc* allocator() const { return &m_allocator; }
+
+    private:
+        static void* allocate(void* ctx, const std::size_t size) {
+            try {
+                return static_cast<ParseArena*>(ctx)->m_arena.allocate(size, alignof(std::max_align_t));
+            } catch (const std::bad_alloc&) {
+                return nullptr;
+            }
+        }
+
+        static void* reallocate(void* ctx, void* ptr, const std::size_t old_size, const std::size_t size) {
+            void* grown = allocate(ctx, size);
+            if (grown != nullptr && ptr != nullptr) std::memcpy(grown, ptr, old_size < size ? old_size : size);
+            return grown;
+        }
+
+        static void release(void*, void*) {}
+
+        std::pmr::monotonic_buffer_resource m_arena;
+        yyjson_alc m_allocator;
+    };
+}
+
+namespace rfl {
+
+    /**
+     * @brief Reads and writes `std::pmr::string` as a string, allocating from `io::field_resource()`.
+     */
+    template <>
+    struct Reflector<std::pmr::string> {
+        using ReflType = std::string;
+
+        static std::pmr::string to(const ReflType& value) {
+            return std::pmr::string(value, fourdst::config::io::field_resource());
+        }
+
+        static ReflType from(const std::pmr::string& value) { return ReflType(value); }
+    };
+
+    /**
+     * @brief Reads and writes `std::pmr::vector` as an array, allocating from `io::field_resource()`.
+     */
+    template <typename E>
+    struct Reflector<std::pmr::vector<E>> {
+        using ReflType = std::vector<E>;
+
+        static std::pmr::vector<E> to(const ReflType& value) {
+            std::pmr::vector<E> result(fourdst::config::io::field_resource());
+            result.assign(value.begin(), value.end());
+            return result;
+        }
+
+        static std::pmr::vector<E> to(ReflType&& value) {
+            std::pmr::vector<E> result(fourdst::config::io::field_resource());
+            result.reserve(value.size());
+            for (auto& element : value) result.push_back(std::move(element));
+            return result;
+        }
+
+        static ReflType from(const std::pmr::vector<E>& value) { return ReflType(value.begin(), value.end()); }
+    };
+}
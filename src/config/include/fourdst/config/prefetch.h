@@ -0,0 +1,437 @@
+/**
+ * @file prefetch.h
+ * @brief Staging the inputs of a job to node-local storage before its ranks load them.
+ *
+ * When every rank of a large job loads its deck at startup, the shared filesystem serves the
+ * same decks, fragments, section files and sidecars to thousands of clients at once. `prefetch()`
+ * takes a `PrefetchManifest` of decks, finds every file each deck depends on without
+ * deserializing anything, and copies them in parallel to a node-local directory, or only reads
+ * them once so the page cache holds them:
+ *
+ * @code
+ * const fourdst::config::PrefetchReport report = fourdst::config::prefetch({
+ *     .decks = {"/lustre/run/physics.toml"},
+ *     .files = {"/lustre/tables/opacity.h5"},
+ *     .stage_directory = "/local/scratch/stage",
+ * });
+ * cfg.load("/lustre/run/physics.toml");  // reads /local/scratch/stage/lustre/run/physics.toml
+ * @endcode
+ *
+ * The dependencies of a TOML deck are its `__include` fragments (see fragments.h), transitively;
+ * the `__sidecar` files of its arrays (see sidecar.h); and the files of its `Section` fields
+ * (see section.h). A section is a plain string in the deck, so without the schema every string
+ * naming an existing `.toml` file relative to the deck counts as one, and its own dependencies
+ * are followed. JSON and namelist decks have none. A directory in `decks` stands for its
+ * fragments, as read by `Config::load_directory()`.
+ *
+ * Staged copies keep the absolute path of their original below the stage directory, so the
+ * relative paths inside a staged deck lead to the staged fragments, sections and sidecars. Each
+ * staged file and directory is recorded in the process-wide `io::StagedFiles`, and
+ * `Config::load()`, `load_layers()`, `load_directory()` and `reload()` given a recorded path
+ * read the staged copy instead; `get_source_path()` then names the copy, and later reloads read
+ * it too. Paths are matched as written, made absolute and normalized, without touching the
+ * filesystem. Files an input names by absolute path are staged, but read from where they point.
+ *
+ * Ranks sharing a node may all call `prefetch()`: a staged copy at least as new as its original
+ * and of the same size is kept, and copies are written under a temporary name and renamed into
+ * place, so no rank reads a partial copy. Staging is a snapshot; call `prefetch()` again to pick
+ * up changes to the originals, or clear `io::StagedFiles` to read them directly again.
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/compress.h"
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/executor.h"
+#include "fourdst/config/fragments.h"
+#include "fourdst/config/sidecar.h"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config {
+
+    /**
+     * @brief The inputs `prefetch()` stages.
+     */
+    struct PrefetchManifest {
+        /// Decks to stage together with the files they depend on; a directory stands for its fragments.
+        std::vector<std::string> decks;
+        /// Other files to stage as they are, such as tables the application opens itself.
+        std::vector<std::string> files;
+        /// Node-local directory to copy the files into; if empty, they are only read, to fill the page cache.
+        std::string stage_directory;
+        /// Files staged at once; 0 for one per hardware thread.
+        std::size_t parallelism = 0;
+    };
+
+    /**
+     * @brief One file `prefetch()` staged.
+     */
+    struct PrefetchedFile {
+        /// The original, absolute and normalized.
+        std::string source;
+        /// The copy, or empty if the file was only read.
+        std::string staged;
+        std::uintmax_t bytes = 0;
+        /// Whether an up-to-date copy was already in place, so nothing was copied.
+        bool reused = false;
+    };
+
+    /**
+     * @brief What a `prefetch()` staged and where the time went.
+     */
+    struct PrefetchReport {
+        /// The decks first, each followed by its dependencies, then the other files.
+        std::vector<PrefetchedFile> files;
+        /// Bytes copied or read; reused copies are not counted.
+        std::uintmax_t bytes = 0;
+        /// Time spent finding the dependencies of the decks.
+        std::chrono::nanoseconds resolve_time{0};
+        /// Time spent copying or reading the files.
+        std::chrono::nanoseconds stage_time{0};
+    };
+
+    namespace io {
+        namespace detail {
+            /**
+             * @brief Returns `path` made absolute and normalized, without a trailing separator, or empty if it cannot be.
+             */
+            inline std::string absolute_key(const std::filesystem::path& path) {
+                std::error_code ec;
+                std::filesystem::path absolute = std::filesystem::absolute(path, ec).lexically_normal();
+                if (ec) return {};
+                if (!absolute.has_filename() && absolute.has_relative_path()) absolute = absolute.parent_path();
+                return absolute.string();
+            }
+        }
+
+        /**
+         * @brief Process-wide record of staged files and directories, consulted by `Config` before it reads a path.
+         *
+         * All member functions are thread-safe. While nothing is staged, `redirect()` returns at once.
+         */
+        class StagedFiles {
+        public:
+            /**
+             * @brief Returns the process-wide record.
+             */
+            static StagedFiles& instance() {
+                static StagedFiles staged;
+                return staged;
+            }
+
+            /**
+             * @brief Returns the staged copy of `path`, or `path` itself if it was not staged.
+             */
+            [[nodiscard]] std::string redirect(const std::string_view path) const {
+                if (!m_any.load(std::memory_order_acquire) || path.empty()) return std::string(path);
+                const std::string key = detail::absolute_key(path);
+                std::shared_lock lock(m_mutex);
+                const auto it = m_paths.find(key);
+                return it == m_paths.end() ? std::string(path) : it->second;
+            }
+
+            /**
+             * @brief Records that `source`, an absolute normalized path, is read from `staged` from now on.
+             */
+            void add(std::string source, std::string staged) {
+                std::unique_lock lock(m_mutex);
+                m_paths.insert_or_assign(std::move(source), std::move(staged));
+                m_any.store(true, std::memory_order_release);
+            }
+
+            /**
+             * @brief Forgets all staged files; the copies are left on disk.
+             */
+            void clear() {
+                std::unique_lock lock(m_mutex);
+                m_paths.clear();
+                m_any.store(false, std::memory_order_release);
+            }
+
+            /**
+             * @brief Returns the number of staged files and directories.
+             */
+            [[nodiscard]] std::size_t size() const {
+                std::shared_lock lock(m_mutex);
+                return m_paths.size();
+            }
+
+        private:
+            mutable std::shared_mutex m_mutex;
+            std::unordered_map<std::string, std::string> m_paths;
+            std::atomic<bool> m_any{false};
+        };
+
+        /**
+         * @brief Returns the staged copy of `path`, or `path` itself if it was not staged.
+         */
+        inline std::string staged_path(const std::string_view path) {
+            return StagedFiles::instance().redirect(path);
+        }
+
+        namespace detail {
+            /**
+             * @brief The files found so far by `deck_dependencies()`, each once, in the order found.
+             */
+            struct DependencyWalk {
+                std::vector<std::string> files;
+                std::unordered_set<std::string> seen;
+
+                /// Returns whether `path` was not found before.
+                bool add(const std::filesystem::path& path) {
+                    std::string key = absolute_key(path);
+                    if (key.empty() || !seen.insert(key).second) return false;
+                    files.push_back(std::move(key));
+                    return true;
+                }
+            };
+
+            /**
+             * @brief Whether `path`, without its compression extension, names a TOML file.
+             */
+            inline bool names_toml(const std::string_view path) {
+                return strip_compression_extension(path).ends_with(".toml");
+            }
+
+            /**
+             * @brief Whether a deck at `path` is read as TOML, as `Config` chooses its format by default.
+             */
+            inline bool deck_is_toml(const std::filesystem::path& path) {
+                const std::filesystem::path stripped(strip_compression_extension(path.string()));
+                std::string extension = stripped.extension().string();
+                std::ranges::transform(extension, extension.begin(), [](const unsigned char c) { return std::tolower(c); });
+                return extension != ".json" && extension != ".nml" && !(extension.empty() && stripped.filename().string().starts_with("inlist"));
+            }
+
+            inline void walk_document(const std::filesystem::path& file, const std::filesystem::path& anchor, DependencyWalk& walk);
+
+            /**
+             * @brief Finds the references below `node` of `file`; sidecars and sections are relative to `anchor`.
+             */
+            inline void walk_node(const toml::node& node, const std::filesystem::path& file, const std::filesystem::path& anchor,
+                                  DependencyWalk& walk) {
+                if (const toml::table* table = node.as_table()) {
+                    for (auto&& [key, child] : *table) {
+                        if (key.str() == include_key) {
+                            const auto include = [&](const toml::node& name) {
+                                if (!name.is_string()) return;
+                                const std::filesystem::path fragment = file.parent_path() / name.as_string()->get();
+                                std::error_code ec;
+                                if (!std::filesystem::is_regular_file(fragment, ec)) {
+                                    throw exceptions::ConfigLoadError(
+                                        std::format("Included config fragment does not exist: {}", fragment.string()));
+                                }
+                                if (walk.add(fragment)) walk_document(fragment, anchor, walk);
+                            };
+                            if (const toml::array* names = child.as_array()) {
+                                for (const toml::node& name : *names) include(name);
+                            } else {
+                                include(child);
+                            }
+                        } else if (key.str() == sidecar_key) {
+                            if (child.is_string()) walk.add(anchor / child.as_string()->get());
+                        } else {
+                            walk_node(child, file, anchor, walk);
+                        }
+                    }
+                } else if (const toml::array* array = node.as_array()) {
+                    for (const toml::node& element : *array) walk_node(element, file, anchor, walk);
+                } else if (node.is_string() && names_toml(node.as_string()->get())) {
+                    // How a Section field is written: a TOML file, relative to the deck, whose own paths are relative to it.
+                    const std::filesystem::path section = anchor / node.as_string()->get();
+                    std::error_code ec;
+                    if (std::filesystem::is_regular_file(section, ec) && walk.add(section)) {
+                        walk_document(section, section.parent_path(), walk);
+                    }
+                }
+            }
+
+            /**
+             * @brief Parses the TOML file `file` and finds its references; sidecars and sections are relative to `anchor`.
+             */
+            inline void walk_document(const std::filesystem::path& file, const std::filesystem::path& anchor, DependencyWalk& walk) {
+                toml::table document;
+                try {
+                    document = parse_toml_file(file.string());
+                } catch (const toml::parse_error& e) {
+                    throw syntax_error(e, "TOML file", file.string());
+                }
+                walk_node(document, file, anchor, walk);
+            }
+
+            /**
+             * @brief Adds the deck at `deck` and the files it depends on to `walk`.
+             */
+            inline void walk_deck(const std::filesystem::path& deck, DependencyWalk& walk) {
+                std::error_code ec;
+                if (!std::filesystem::is_regular_file(deck, ec)) {
+                    throw exceptions::ConfigLoadError(std::format("Config file does not exist: {}", deck.string()));
+                }
+                if (walk.add(deck) && deck_is_toml(deck)) walk_document(deck, deck.parent_path(), walk);
+            }
+
+            /**
+             * @brief Copies `source` to `staged` through a temporary file, unless an up-to-date copy is there.
+             * @return Whether an up-to-date copy was already there.
+             */
+            inline bool copy_to_stage(const std::string& source, const std::filesystem::path& staged, const std::uintmax_t size) {
+                std::error_code ec;
+                const auto source_time = std::filesystem::last_write_time(source, ec);
+                std::error_code staged_ec;
+                if (!ec && std::filesystem::file_size(staged, staged_ec) == size && !staged_ec &&
+                    std::filesystem::last_write_time(staged, staged_ec) >= source_time && !staged_ec) {
+                    return true;
+                }
+
+                std::filesystem::create_directories(staged.parent_path(), ec);
+                std::filesystem::path partial = staged;
+                partial += std::format(".{:x}.part", std::hash<std::thread::id>{}(std::this_thread::get_id()) ^
+                                                         static_cast<std::size_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+                if (!ec) std::filesystem::copy_file(source, partial, std::filesystem::copy_options::overwrite_existing, ec);
+                if (!ec) std::filesystem::rename(partial, staged, ec);
+                if (ec) {
+                    std::filesystem::remove(partial, staged_ec);
+                    throw exceptions::ConfigLoadError(std::format("Unable to stage {} into {}: {}", source, staged.string(), ec.message()));
+                }
+                return false;
+            }
+
+            /**
+             * @brief Reads `source` once, in large blocks, so the page cache holds it.
+             */
+            inline void warm(const std::string& source) {
+                std::ifstream in(source, std::ios::binary);
+                if (!in) {
+                    throw exceptions::ConfigLoadError(std::format("Unable to read {} to prefetch it.", source));
+                }
+                std::vector<char> buffer(std::size_t{1} << 20);
+                while (in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()))) {
+                }
+            }
+        }
+
+        /**
+         * @brief Returns `deck` and every file it depends on, as absolute normalized paths, without deserializing.
+         *
+         * See the file comment for what counts as a dependency.
+         *
+         * @param deck A deck, or a directory of fragments.
+         * @return The deck first, then its dependencies in the order they were found; each file once.
+         * @throws exceptions::ConfigLoadError If the deck or a fragment it includes does not exist.
+         * @throws exceptions::ConfigParseError If the deck, a fragment or a section file is not valid TOML.
+         */
+        inline std::vector<std::string> deck_dependencies(const std::string_view deck) {
+            detail::DependencyWalk walk;
+            std::error_code ec;
+            if (std::filesystem::is_directory(deck, ec)) {
+                for (const std::string& fragment : list_fragments(deck)) detail::walk_deck(fragment, walk);
+            } else {
+                detail::walk_deck(std::filesystem::path(deck), walk);
+            }
+            return std::move(walk.files);
+        }
+    }
+
+    /**
+     * @brief Stages the decks of `manifest`, the files they depend on, and its other files.
+     *
+     * The dependencies are found first, then the files are copied to `stage_directory`, or read
+     * if it is empty, on the default executor (see executor.h). Only if every file is staged are
+     * the copies recorded in `io::StagedFiles`, so a failed prefetch redirects nothing.
+     *
+     * @param manifest What to stage and where.
+     * @return The staged files, with the bytes and time spent.
+     * @throws exceptions::ConfigLoadError If an input does not exist or cannot be copied or read; the first one, in manifest order.
+     * @throws exceptions::ConfigParseError If a deck, fragment or section file is not valid TOML.
+     *
+     * @par Examples
+     * @code
+     * fourdst::config::prefetch({.decks = {"run.toml"}});  // fill the page cache only
+     * @endcode
+     */
+    inline PrefetchReport prefetch(const PrefetchManifest& manifest) {
+        PrefetchReport report;
+        const auto resolve_start = std::chrono::steady_clock::now();
+        io::detail::DependencyWalk walk;
+        std::vector<std::string> directories;
+        for (const std::string& deck : manifest.decks) {
+            std::error_code ec;
+            if (std::filesystem::is_directory(deck, ec)) {
+                directories.push_back(io::detail::absolute_key(deck));
+                for (const std::string& fragment : io::list_fragments(deck)) io::detail::walk_deck(fragment, walk);
+            } else {
+                io::detail::walk_deck(deck, walk);
+            }
+        }
+        for (const std::string& file : manifest.files) walk.add(file);
+        report.resolve_time = std::chrono::steady_clock::now() - resolve_start;
+
+        const std::filesystem::path stage = manifest.stage_directory;
+        const auto staged_name = [&stage](const std::string& source) { return (stage / std::filesystem::path(source).relative_path()).string(); };
+        report.files.resize(walk.files.size());
+        std::vector<std::exception_ptr> errors(walk.files.size());
+        std::atomic<std::size_t> next{0};
+        const std::size_t threads = manifest.parallelism != 0 ? manifest.parallelism : std::max(1u, std::thread::hardware_concurrency());
+        const auto stage_start = std::chrono::steady_clock::now();
+        bulk_execute(std::min(walk.files.size(), threads), [&](std::size_t) {
+            for (std::size_t i = next.fetch_add(1, std::memory_order_relaxed); i < walk.files.size();
+                 i = next.fetch_add(1, std::memory_order_relaxed)) {
+                PrefetchedFile& file = report.files[i];
+                file.source = walk.files[i];
+                try {
+                    std::error_code ec;
+                    file.bytes = std::filesystem::file_size(file.source, ec);
+                    if (ec) {
+                        throw exceptions::ConfigLoadError(std::format("Unable to prefetch {}: {}", file.source, ec.message()));
+                    }
+                    if (stage.empty()) {
+                        io::detail::warm(file.source);
+                    } else {
+                        file.staged = staged_name(file.source);
+                        file.reused = io::detail::copy_to_stage(file.source, file.staged, file.bytes);
+                    }
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            }
+        });
+        report.stage_time = std::chrono::steady_clock::now() - stage_start;
+        for (const std::exception_ptr& error : errors) {
+            if (error) std::rethrow_exception(error);
+        }
+
+        for (const PrefetchedFile& file : report.files) {
+            if (!file.reused) report.bytes += file.bytes;
+            if (!file.staged.empty()) io::StagedFiles::instance().add(file.source, file.staged);
+        }
+        if (!stage.empty()) {
+            for (std::string& directory : directories) {
+                std::string staged = staged_name(directory);
+                io::StagedFiles::instance().add(std::move(directory), std::move(staged));
+            }
+        }
+        return report;
+    }
+}
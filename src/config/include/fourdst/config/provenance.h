@@ -0,0 +1,342 @@
+/**
+ * @file provenance.h
+ * @brief Per-field record of which layer last set each field of a configuration.
+ *
+ * Fields are numbered by a compile-time ordinal: a pre-order walk over the fields of the schema
+ * as reported by `rfl::named_tuple_t`, recursing into nested structs. The numbering is the same as
+ * the entry order of `detail::PathTable<T>`, but computing it only instantiates one function per
+ * schema type rather than one accessor per path, so large schemas do not pay for it.
+ *
+ * A `ProvenanceRecord<T>` stores two bytes per ordinal in a fixed-size array.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "fourdst/config/compare.h"
+#include "fourdst/config/path_table.h"
+
+#include "rfl.hpp"
+#include "yyjson.h"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config {
+
+    /**
+     * @brief The layer a field value came from.
+     */
+    enum class FieldSource : std::uint8_t {
+        /**
+         * @brief The default member initializer of the schema.
+         */
+        DEFAULT,
+        /**
+         * @brief A config file (the layer index names which one).
+         */
+        FILE,
+        /**
+         * @brief An environment variable merged by `load_layers()`.
+         */
+        ENVIRONMENT,
+        /**
+         * @brief An override registered with `set_override()`, including bound CLI options.
+         */
+        OVERRIDE,
+        /**
+         * @brief `mutate()`, `set()` or `transaction()`.
+         */
+        MUTATE
+    };
+
+    /**
+     * @brief Where a field value came from.
+     */
+    struct FieldProvenance {
+        /// The kind of layer.
+        FieldSource source = FieldSource::DEFAULT;
+        /// For `FieldSource::FILE`, the index of the file among the loaded layers (0 for `load()`).
+        std::uint8_t layer = 0;
+
+        bool operator==(const FieldProvenance&) const = default;
+    };
+
+    namespace detail {
+        /**
+         * @brief Returns the number of field ordinals in `V`: its fields plus those of nested structs.
+         */
+        template <typename V>
+        constexpr std::size_t field_count() {
+            using Fields = typename rfl::named_tuple_t<V>::Fields;
+            return []<int... Is>(std::integer_sequence<int, Is...>) {
+                std::size_t count = 0;
+                ([&] {
+                    using Field = rfl::tuple_element_t<Is, Fields>;
+                    count += 1;
+                    if constexpr (is_path_struct_v<typename Field::Type>) {
+                        count += field_count<typename Field::Type>();
+                    }
+                }(), ...);
+                return count;
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        }
+
+        /**
+         * @brief Returns the number of ordinals nested below a field of type `V` (0 for leaves).
+         */
+        template <typename V>
+        constexpr std::size_t nested_count() {
+            if constexpr (is_path_struct_v<V>) {
+                return field_count<V>();
+            } else {
+                return 0;
+            }
+        }
+
+        /**
+         * @brief The ordinal range of one field: the field itself and the fields nested in it.
+         */
+        struct FieldRange {
+            std::size_t ordinal = 0;
+            std::size_t count = 0;
+            bool is_table = false;
+        };
+
+        /**
+         * @brief Resolves a dotted path to its ordinal range; `count` is 0 if `path` does not name a field.
+         */
+        template <typename V>
+        constexpr FieldRange find_field(const std::string_view path, const std::size_t base = 0) {
+            using Fields = typename rfl::named_tuple_t<V>::Fields;
+            const std::size_t dot = path.find('.');
+            const std::string_view head = path.substr(0, dot);
+            const std::string_view rest = dot == std::string_view::npos ? std::string_view{} : path.substr(dot + 1);
+            FieldRange found;
+            bool matched = false;
+            std::size_t ordinal = base;
+            [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                ([&] {
+                    using Field = rfl::tuple_element_t<Is, Fields>;
+                    using Type = typename Field::Type;
+                    constexpr std::size_t nested = nested_count<Type>();
+                    if (!matched && Field::name() == head) {
+                        matched = true;
+                        if (dot == std::string_view::npos) {
+                            found = {ordinal, 1 + nested, is_path_struct_v<Type>};
+                        } else if constexpr (is_path_struct_v<Type>) {
+                            found = find_field<Type>(rest, ordinal + 1);
+                        }
+                    }
+                    ordinal += 1 + nested;
+                }(), ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+            return found;
+        }
+
+        /**
+         * @brief Returns the ordinal of each field of `V`, relative to the first field of `V`.
+         */
+        template <typename V>
+        constexpr auto field_ordinals() {
+            using Fields = typename rfl::named_tuple_t<V>::Fields;
+            std::array<std::size_t, rfl::tuple_size_v<Fields>> ordinals{};
+            std::size_t next = 0;
+            [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                ((ordinals[Is] = next, next += 1 + nested_count<typename rfl::tuple_element_t<Is, Fields>::Type>()), ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+            return ordinals;
+        }
+
+        /**
+         * @brief The index of the field of `V` whose ordinal range holds `ordinal`.
+         */
+        template <std::size_t N>
+        constexpr std::size_t field_index_at(const std::array<std::size_t, N>& ordinals, const std::size_t ordinal) {
+            std::size_t index = 0;
+            while (index + 1 < N && ordinals[index + 1] <= ordinal) ++index;
+            return index;
+        }
+
+        /**
+         * @brief Returns `std::type_identity` of the type of the field at `Ordinal`, relative to the first field of `V`.
+         */
+        template <typename V, std::size_t Ordinal>
+        constexpr auto field_type_at() {
+            using Fields = typename rfl::named_tuple_t<V>::Fields;
+            constexpr auto ordinals = field_ordinals<V>();
+            constexpr std::size_t index = field_index_at(ordinals, Ordinal);
+            using Type = typename rfl::tuple_element_t<static_cast<int>(index), Fields>::Type;
+            if constexpr (ordinals[index] == Ordinal) {
+                return std::type_identity<Type>{};
+            } else {
+                return field_type_at<Type, Ordinal - ordinals[index] - 1>();
+            }
+        }
+
+        /**
+         * @brief Returns the field at `Ordinal` of `value`, relative to the first field of `V`.
+         *
+         * The field is reached through one `rfl::to_view()` per nesting level, which compiles down
+         * to a member access.
+         */
+        template <std::size_t Ordinal, typename V>
+        constexpr auto& field_at(V& value) {
+            using Fields = typename rfl::named_tuple_t<std::remove_const_t<V>>::Fields;
+            constexpr auto ordinals = field_ordinals<std::remove_const_t<V>>();
+            constexpr std::size_t index = field_index_at(ordinals, Ordinal);
+            auto& field = *rfl::get<static_cast<int>(index)>(rfl::to_view(value).values());
+            if constexpr (ordinals[index] == Ordinal) {
+                return field;
+            } else {
+                return field_at<Ordinal - ordinals[index] - 1>(field);
+            }
+        }
+
+        /**
+         * @brief Calls `fn(path, ordinal)` for every leaf field of `V`, in ordinal order.
+         */
+        template <typename V, typename Fn>
+        void for_each_leaf(const std::string& prefix, const std::size_t base, Fn& fn) {
+            using Fields = typename rfl::named_tuple_t<V>::Fields;
+            std::size_t ordinal = base;
+            [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                ([&] {
+                    using Field = rfl::tuple_element_t<Is, Fields>;
+                    using Type = typename Field::Type;
+                    std::string path = prefix.empty() ? std::string(Field::name()) : prefix + "." + std::string(Field::name());
+                    if constexpr (is_path_struct_v<Type>) {
+                        for_each_leaf<Type>(path, ordinal + 1, fn);
+                        ordinal += 1 + field_count<Type>();
+                    } else {
+                        fn(std::string_view(path), ordinal);
+                        ordinal += 1;
+                    }
+                }(), ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        }
+    }
+
+    /**
+     * @brief The provenance of every field of `T`, indexed by field ordinal.
+     * @tparam T The configuration schema type.
+     */
+    template <typename T>
+    class ProvenanceRecord {
+    public:
+        /**
+         * @brief Returns the number of field ordinals of `T`.
+         */
+        static constexpr std::size_t size() { return detail::field_count<T>(); }
+
+        /**
+         * @brief Returns the provenance stored for `ordinal`.
+         */
+        [[nodiscard]] FieldProvenance operator[](const std::size_t ordinal) const { return m_fields[ordinal]; }
+
+        /**
+         * @brief Marks `count` ordinals starting at `ordinal`.
+         */
+        void mark(const std::size_t ordinal, const std::size_t count, const FieldProvenance value) {
+            for (std::size_t i = ordinal; i < ordinal + count; ++i) m_fields[i] = value;
+        }
+
+        /**
+         * @brief Marks every field.
+         */
+        void mark_all(const FieldProvenance value) { m_fields.fill(value); }
+
+        /**
+         * @brief Marks the fields present in a TOML root table.
+         */
+        void mark_table(const toml::table& tbl, const FieldProvenance value) { mark_table<T>(tbl, 0, value); }
+
+        /**
+         * @brief Marks the fields present in a JSON root object.
+         */
+        void mark_object(yyjson_val* obj, const FieldProvenance value) { mark_object<T>(obj, 0, value); }
+
+        /**
+         * @brief Marks the leaf fields that differ between `before` and `after`.
+         */
+        void mark_changes(const T& before, const T& after, const FieldProvenance value) {
+            mark_changes<T>(before, after, 0, value);
+        }
+
+    private:
+        template <typename V>
+        void mark_table(const toml::table& tbl, const std::size_t base, const FieldProvenance value) {
+            using Fields = typename rfl::named_tuple_t<V>::Fields;
+            std::size_t ordinal = base;
+            [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                ([&] {
+                    using Field = rfl::tuple_element_t<Is, Fields>;
+                    using Type = typename Field::Type;
+                    if (const toml::node* node = tbl.get(Field::name())) {
+                        if constexpr (detail::is_path_struct_v<Type>) {
+                            if (const toml::table* child = node->as_table()) {
+                                mark_table<Type>(*child, ordinal + 1, value);
+                            }
+                        } else {
+                            m_fields[ordinal] = value;
+                        }
+                    }
+                    ordinal += 1 + detail::nested_count<Type>();
+                }(), ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        }
+
+        template <typename V>
+        void mark_object(yyjson_val* obj, const std::size_t base, const FieldProvenance value) {
+            using Fields = typename rfl::named_tuple_t<V>::Fields;
+            std::size_t ordinal = base;
+            [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                ([&] {
+                    using Field = rfl::tuple_element_t<Is, Fields>;
+                    using Type = typename Field::Type;
+                    constexpr std::string_view name = Field::name();
+                    if (yyjson_val* child = yyjson_obj_getn(obj, name.data(), name.size())) {
+                        if constexpr (detail::is_path_struct_v<Type>) {
+                            if (yyjson_is_obj(child)) {
+                                mark_object<Type>(child, ordinal + 1, value);
+                            }
+                        } else {
+                            m_fields[ordinal] = value;
+                        }
+                    }
+                    ordinal += 1 + detail::nested_count<Type>();
+                }(), ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        }
+
+        template <typename V>
+        void mark_changes(const V& before, const V& after, const std::size_t base, const FieldProvenance value) {
+            using Fields = typename rfl::named_tuple_t<V>::Fields;
+            const auto before_view = rfl::to_view(before).values();
+            const auto after_view = rfl::to_view(after).values();
+            std::size_t ordinal = base;
+            [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                ([&] {
+                    using Type = typename rfl::tuple_element_t<Is, Fields>::Type;
+                    const auto& lhs = *rfl::get<Is>(before_view);
+                    const auto& rhs = *rfl::get<Is>(after_view);
+                    if (!detail::equal(lhs, rhs)) {
+                        if constexpr (detail::is_path_struct_v<Type>) {
+                            mark_changes<Type>(lhs, rhs, ordinal + 1, value);
+                        } else {
+                            m_fields[ordinal] = value;
+                        }
+                    }
+                    ordinal += 1 + detail::nested_count<Type>();
+                }(), ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        }
+
+        std::array<FieldProvenance, size()> m_fields{};
+    };
+}
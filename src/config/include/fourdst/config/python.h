@@ -0,0 +1,199 @@
+/**
+ * @file python.h
+ * @brief nanobind bindings for `Config<T>`, generated from the schema, with numeric arrays as NumPy views.
+ *
+ * `bind_config<T>()` adds a Python class for `Config<T>` and one for each struct of the schema to
+ * an extension module:
+ *
+ * @code
+ * #include "fourdst/config/python.h"
+ *
+ * NB_MODULE(stellar_config, m) {
+ *     fourdst::config::python::bind_exceptions(m);
+ *     fourdst::config::python::bind_config<DeckSchema>(m, "DeckConfig");
+ * }
+ * @endcode
+ *
+ * @code{.py}
+ * cfg = stellar_config.DeckConfig()
+ * cfg.load("deck.toml")
+ * deck = cfg.snapshot()
+ * deck.grid.radius      # numpy.ndarray viewing the C++ vector, read-only
+ * deck.physics.solver   # "NEWTON"
+ * @endcode
+ *
+ * Fields of a snapshot are read-only attributes:
+ *
+ * - nested structs are objects of their own bound class;
+ * - `std::vector`s, `std::array`s and `Tensor`s of numbers (other than `bool`) are read-only
+ *   NumPy arrays over the C++ memory, with no copy; a tensor has its full shape, in row-major order;
+ * - numbers, bools and strings are Python values, enums their names, `Tunable` and `Quantity`
+ *   fields their current value, and `Lazy` fields their deserialized value;
+ * - anything else (maps, optionals, vectors of strings or structs, ...) is the Python object of
+ *   its JSON form.
+ *
+ * A snapshot keeps the content it was taken from alive, and every array keeps its snapshot alive;
+ * since published content is never modified, views stay valid and unchanged across later loads,
+ * which publish new content instead.
+ *
+ * Only available when built with nanobind (the `use_nanobind` meson option, which provides
+ * `config_python_dep`).
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "fourdst/config/base.h"
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/path_table.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+#include "rfl/json.hpp"
+
+#include <nanobind/nanobind.h>
+#include <nanobind/ndarray.h>
+#include <nanobind/stl/shared_ptr.h>
+#include <nanobind/stl/string.h>
+#include <nanobind/stl/string_view.h>
+
+namespace fourdst::config::python {
+
+    namespace nb = nanobind;
+
+    namespace detail {
+        template <typename Type>
+        constexpr bool is_view_element_v = std::is_arithmetic_v<Type> && !std::is_same_v<Type, bool>;
+
+        /// Field types exposed as NumPy views over their storage.
+        template <typename Type>
+        constexpr bool is_array_view_v = [] {
+            if constexpr (validate::is_vector_v<Type> || validate::is_std_array_v<Type> || validate::is_tensor_v<Type>) {
+                return is_view_element_v<typename Type::value_type>;
+            } else {
+                return false;
+            }
+        }();
+
+        /**
+         * @brief Returns the unqualified name of `Type`, e.g. `PhysicsConfig` for `ns::PhysicsConfig`.
+         */
+        template <typename Type>
+        std::string class_name() {
+            const std::string name = rfl::type_name_t<Type>().str();
+            const std::size_t scope = name.rfind("::");
+            return scope == std::string::npos ? name : name.substr(scope + 2);
+        }
+
+        /**
+         * @brief Returns a read-only NumPy array over `value`, keeping `owner` alive while it is used.
+         */
+        template <typename Type>
+        nb::object array_view(const Type& value, const nb::handle owner) {
+            using Element = typename Type::value_type;
+            using Array = nb::ndarray<nb::numpy, const Element>;
+            if constexpr (validate::is_tensor_v<Type>) {
+                constexpr std::size_t rank = std::tuple_size_v<typename Type::extents_type>;
+                std::array<std::size_t, rank> shape = value.extents();
+                return nb::cast(Array(value.data(), rank, shape.data(), owner), nb::rv_policy::reference);
+            } else {
+                const std::size_t shape[1] = {value.size()};
+                return nb::cast(Array(value.data(), 1, shape, owner), nb::rv_policy::reference);
+            }
+        }
+
+        /**
+         * @brief Returns the Python value of the field `value` of the struct object `owner`.
+         */
+        template <typename Type>
+        nb::object to_python(const Type& value, const nb::handle owner) {
+            if constexpr (config::detail::is_path_struct_v<Type>) {
+                return nb::cast(value, nb::rv_policy::reference_internal, owner);
+            } else if constexpr (is_array_view_v<Type>) {
+                return array_view(value, owner);
+            } else if constexpr (validate::is_lazy_v<Type> || validate::is_section_v<Type>) {
+                return to_python(value.get(), owner);
+            } else if constexpr (validate::is_tunable_v<Type>) {
+                return to_python(value.get(), owner);
+            } else if constexpr (validate::is_quantity_v<Type>) {
+                return nb::cast(value.value());
+            } else if constexpr (validate::is_stored_v<Type>) {
+                return nb::cast(value.value());
+            } else if constexpr (std::is_enum_v<Type>) {
+                return nb::cast(std::string(rfl::enum_to_string(value)));
+            } else if constexpr (std::is_arithmetic_v<Type> || validate::is_string_like_v<Type>) {
+                return nb::cast(value);
+            } else {
+                return nb::module_::import_("json").attr("loads")(rfl::json::write(value));
+            }
+        }
+
+        template <typename Type>
+        void bind_struct(nb::module_& m, const std::string& name) {
+            if (nb::type<Type>().is_valid()) return;
+            nb::class_<Type> cls(m, name.c_str());
+            using Fields = typename rfl::named_tuple_t<Type>::Fields;
+            [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                ([&] {
+                    using Field = rfl::tuple_element_t<Is, Fields>;
+                    using FieldType = std::remove_cvref_t<typename Field::Type>;
+                    if constexpr (config::detail::is_path_struct_v<FieldType>) {
+                        bind_struct<FieldType>(m, class_name<FieldType>());
+                    }
+                    cls.def_prop_ro(Field::name().data(), [](const Type& self) {
+                        const auto& field = *rfl::get<Is>(rfl::to_view(self).values());
+                        return to_python(field, nb::find(&self));
+                    });
+                }(), ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>());
+            cls.def("to_json", [](const Type& self) { return rfl::json::write(self); });
+        }
+    }
+
+    /**
+     * @brief Registers the exception hierarchy of `exceptions.h` as Python exceptions of `m`.
+     *
+     * Call once per module, before `bind_config()`. Errors not registered reach Python as `RuntimeError`.
+     */
+    inline void bind_exceptions(nb::module_& m) {
+        nb::exception<exceptions::ConfigError> config_error(m, "ConfigError");
+        nb::exception<exceptions::ConfigSaveError>(m, "ConfigSaveError", config_error);
+        nb::exception<exceptions::ConfigLoadError> load_error(m, "ConfigLoadError", config_error);
+        nb::exception<exceptions::ConfigLoadTimeout>(m, "ConfigLoadTimeout", load_error);
+        nb::exception<exceptions::ConfigParseError>(m, "ConfigParseError", config_error);
+        nb::exception<exceptions::ConfigPathError>(m, "ConfigPathError", config_error);
+        nb::exception<exceptions::SchemaSaveError>(m, "SchemaSaveError", config_error);
+    }
+
+    /**
+     * @brief Adds a Python class `name` for `Config<T>` to `m`, and a class for each struct of the schema.
+     *
+     * The class has `load(path)`, `load_from(text)`, `save(path)`, `snapshot()`, `root_name` and
+     * `fingerprint()`; a snapshot is an object of the bound `T` class (see the file comment).
+     *
+     * @tparam T The configuration schema type.
+     */
+    template <IsConfigSchema T>
+    nb::class_<Config<T>> bind_config(nb::module_& m, const char* name) {
+        detail::bind_struct<T>(m, detail::class_name<T>());
+        nb::class_<Config<T>> cls(m, name);
+        cls.def(nb::init<>())
+            .def("load", [](Config<T>& self, const std::string_view path) { self.load(path); }, nb::arg("path"),
+                 nb::call_guard<nb::gil_scoped_release>())
+            .def("load_from", [](Config<T>& self, const std::string_view text) { self.load_from(text); }, nb::arg("text"),
+                 nb::call_guard<nb::gil_scoped_release>())
+            .def("save", [](const Config<T>& self, const std::string_view path) { self.save(path); }, nb::arg("path"),
+                 nb::call_guard<nb::gil_scoped_release>())
+            .def("snapshot", [](const Config<T>& self) { return std::const_pointer_cast<T>(self.snapshot()); })
+            .def("fingerprint", &Config<T>::fingerprint)
+            .def_prop_rw("root_name", [](const Config<T>& self) { return std::string(self.get_root_name()); },
+                         [](Config<T>& self, const std::string_view root_name) { self.set_root_name(root_name); });
+        return cls;
+    }
+}
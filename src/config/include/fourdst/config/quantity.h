@@ -0,0 +1,215 @@
+/**
+ * @file quantity.h
+ * @brief `Quantity<Unit>` fields: numbers given with a unit in TOML, stored in a canonical unit.
+ *
+ * A `Quantity<Unit>` member holds a plain `double` in the canonical unit of `Unit`. In a TOML
+ * deck it may be written as a number, taken to be in the canonical unit, or as a string holding
+ * a number and one of the units `Unit` lists, converted once while the deck is deserialized:
+ *
+ * @code
+ * struct StarConfig {
+ *     fourdst::config::Quantity<fourdst::config::units::Mass> mass;  // grams
+ *     fourdst::config::Quantity<fourdst::config::units::Time> age;   // seconds
+ * };
+ *
+ * // [main]
+ * // mass = "1.5 Msun"
+ * // age = "3 Gyr"
+ *
+ * const double m = cfg->mass;  // 2.98e33, no conversion at the use site
+ * @endcode
+ *
+ * Saving writes the canonical number. JSON documents accept the same forms. The JSON schema and
+ * the deck template name the canonical unit and the accepted ones.
+ *
+ * A unit is a type with a `scales` array of `UnitScale`s whose first entry is the canonical unit,
+ * with a factor of 1; the built-in ones in `units` are CGS units.
+ * Units convert by a factor only, so temperatures in degrees Celsius are not supported.
+ */
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <format>
+#include <map>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+#include "rfl.hpp"
+
+namespace fourdst::config {
+
+    /**
+     * @brief One unit a `Quantity` accepts, and how many canonical units it is.
+     */
+    struct UnitScale {
+        std::string_view symbol;
+        double factor = 1.0;
+    };
+
+    /**
+     * @brief Types describing a unit: a `scales` array whose first entry is the canonical unit.
+     */
+    template <typename Unit>
+    concept IsUnit = requires {
+        { Unit::scales.size() } -> std::convertible_to<std::size_t>;
+        { Unit::scales[0] } -> std::convertible_to<UnitScale>;
+    };
+
+    /**
+     * @brief Built-in CGS units.
+     */
+    namespace units {
+        struct Time {
+            static constexpr std::array<UnitScale, 8> scales{{{"s", 1.0}, {"min", 60.0}, {"h", 3600.0}, {"d", 86400.0},
+                                                             {"yr", 3.15576e7}, {"kyr", 3.15576e10}, {"Myr", 3.15576e13},
+                                                             {"Gyr", 3.15576e16}}};
+        };
+
+        struct Length {
+            static constexpr std::array<UnitScale, 9> scales{{{"cm", 1.0}, {"m", 1.0e2}, {"km", 1.0e5}, {"Rsun", 6.957e10},
+                                                             {"AU", 1.495978707e13}, {"ly", 9.4607304725808e17},
+                                                             {"pc", 3.0856775814913673e18}, {"kpc", 3.0856775814913673e21},
+                                                             {"Mpc", 3.0856775814913673e24}}};
+        };
+
+        struct Mass {
+            static constexpr std::array<UnitScale, 5> scales{{{"g", 1.0}, {"kg", 1.0e3}, {"Mearth", 5.9722e27},
+                                                             {"Mjup", 1.89813e30}, {"Msun", 1.98847e33}}};
+        };
+
+        struct Energy {
+            static constexpr std::array<UnitScale, 5> scales{{{"erg", 1.0}, {"J", 1.0e7}, {"eV", 1.602176634e-12},
+                                                             {"keV", 1.602176634e-9}, {"MeV", 1.602176634e-6}}};
+        };
+
+        struct Temperature {
+            static constexpr std::array<UnitScale, 1> scales{{{"K", 1.0}}};
+        };
+    }
+
+    /**
+     * @brief A field holding a `double` in the canonical unit of `Unit`, read from TOML with or without a unit.
+     * @tparam Unit The unit, e.g. `units::Mass`; see `IsUnit`.
+     */
+    template <typename Unit>
+    class Quantity {
+        static_assert(IsUnit<Unit>, "Quantity needs a unit type with a `scales` array of UnitScale.");
+
+    public:
+        using unit_type = Unit;
+
+        /**
+         * @brief Holds zero.
+         */
+        constexpr Quantity() = default;
+
+        /**
+         * @brief Holds `value`, in the canonical unit.
+         */
+        constexpr Quantity(const double value) : m_value(value) {}  // NOLINT(google-explicit-constructor)
+
+        /**
+         * @brief Returns the value in the canonical unit.
+         */
+        [[nodiscard]] constexpr double value() const noexcept { return m_value; }
+
+        constexpr operator double() const noexcept { return m_value; }  // NOLINT(google-explicit-constructor)
+
+        constexpr Quantity& operator=(const double value) noexcept {
+            m_value = value;
+            return *this;
+        }
+
+        /**
+         * @brief Returns the symbol of the canonical unit.
+         */
+        [[nodiscard]] static constexpr std::string_view canonical_unit() { return Unit::scales[0].symbol; }
+
+        /**
+         * @brief Converts text such as `"1.5 Msun"` or `"2e33"` to the canonical unit.
+         * @return The value, or a message naming the problem.
+         */
+        [[nodiscard]] static std::expected<double, std::string> parse(const std::string_view text) {
+            const char* begin = text.data();
+            const char* end = text.data() + text.size();
+            while (begin != end && *begin == ' ') ++begin;
+            if (begin != end && *begin == '+') ++begin;
+            double number = 0.0;
+            const auto [rest, error] = std::from_chars(begin, end, number);
+            if (error != std::errc{}) {
+                return std::unexpected(std::format("'{}' does not start with a number", text));
+            }
+            std::string_view symbol(rest, static_cast<std::size_t>(end - rest));
+            while (!symbol.empty() && symbol.front() == ' ') symbol.remove_prefix(1);
+            while (!symbol.empty() && symbol.back() == ' ') symbol.remove_suffix(1);
+            if (symbol.empty()) return number;
+            for (const UnitScale& scale : Unit::scales) {
+                if (scale.symbol == symbol) return number * scale.factor;
+            }
+            return std::unexpected(std::format("unknown unit '{}' in '{}'; expected one of {}", symbol, text, accepted_units()));
+        }
+
+        /**
+         * @brief Returns the accepted unit symbols, comma-separated, the canonical one first.
+         */
+        [[nodiscard]] static std::string accepted_units() {
+            std::string out;
+            for (const UnitScale& scale : Unit::scales) {
+                if (!out.empty()) out += ", ";
+                out += scale.symbol;
+            }
+            return out;
+        }
+
+    private:
+        double m_value = 0.0;
+    };
+}
+
+namespace rfl::parsing {
+
+    /**
+     * @brief Reads `Quantity<Unit>` from a number in the canonical unit or a string with a unit, and
+     *        writes the canonical number; the schema accepts both and names the units.
+     */
+    template <class R, class W, class Unit, class ProcessorsType>
+        requires AreReaderAndWriter<R, W, fourdst::config::Quantity<Unit>>
+    struct Parser<R, W, fourdst::config::Quantity<Unit>, ProcessorsType> {
+        using InputVarType = typename R::InputVarType;
+        using ValueParser = Parser<R, W, double, ProcessorsType>;
+        using Quantity = fourdst::config::Quantity<Unit>;
+
+        static Result<Quantity> read(const R& _r, const InputVarType& _var) noexcept {
+            if (auto number = _r.template to_basic_type<double>(_var)) return Quantity(number.value());
+            if (auto number = _r.template to_basic_type<std::int64_t>(_var)) return Quantity(static_cast<double>(number.value()));
+            auto text = _r.template to_basic_type<std::string>(_var);
+            if (!text) return error("Could not cast the node to a number or a string with a unit!");
+            try {
+                const auto value = Quantity::parse(text.value());
+                if (!value) return error(value.error());
+                return Quantity(*value);
+            } catch (const std::exception& e) {
+                return error(e.what());
+            }
+        }
+
+        template <class P>
+        static void write(const W& _w, const Quantity& _quantity, const P& _parent) {
+            ValueParser::write(_w, _quantity.value(), _parent);
+        }
+
+        static schema::Type to_schema(std::map<std::string, schema::Type>* _definitions) {
+            using Type = schema::Type;
+            return Type{Type::Description{
+                .description_ = std::format("In {}, or a string with a unit: {}.", Quantity::canonical_unit(), Quantity::accepted_units()),
+                .type_ = Ref<Type>::make(Type{Type::AnyOf{{ValueParser::to_schema(_definitions), Type{Type::String{}}}}})}};
+        }
+    };
+}
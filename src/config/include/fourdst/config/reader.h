@@ -0,0 +1,388 @@
+/**
+ * @file reader.h
+ * @brief Read-only access to a `Config<T>` for translation units that never parse or write files.
+ *
+ * `base.h` pulls in reflect-cpp, toml++ and yyjson, which most consumers of a config do not need:
+ * they only read values. `ConfigReader<T>` is obtained from `Config<T>::reader()` where the config
+ * is loaded, and handed to such code, which includes only this header (and the schema):
+ *
+ * @code
+ * // solver.h -- no parser headers
+ * #include "fourdst/config/reader.h"
+ * #include "physics_schema.h"
+ * void solve(fourdst::config::ConfigReader<PhysicsSchema> cfg);
+ *
+ * // solver.cpp
+ * void solve(fourdst::config::ConfigReader<PhysicsSchema> cfg) {
+ *     const double dt = cfg->simulation.time_step;   // cached until the config publishes again
+ *     const auto held = cfg.snapshot();              // stable across later reloads
+ *     const auto step = cfg.pin();                   // one consistent view for a timestep
+ * }
+ *
+ * // main.cpp
+ * #include "fourdst/config/config.h"
+ * fourdst::config::Config<PhysicsSchema> cfg;
+ * cfg.load("physics.toml");
+ * solve(cfg.reader());
+ * @endcode
+ *
+ * Modules that only need one section take a `ConfigRef` to it, from `Config::view()` or
+ * `ConfigReader::view()`; it reads the section inside the parent's snapshots, without a copy:
+ *
+ * @code
+ * void advance(fourdst::config::ConfigRef<PhysicsOptions> physics);
+ * advance(cfg.view<&PhysicsSchema::physics>());
+ * @endcode
+ *
+ * Dotted-path access (`Config::get()`) needs the compile-time path table, and stays in `base.h`.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <type_traits>
+#include <vector>
+
+#include "fourdst/config/fwd.h"
+#include "fourdst/config/numa.h"
+#include "fourdst/config/seqlock.h"
+
+namespace fourdst::config {
+
+    namespace detail {
+        template <typename M>
+        struct member_pointer_traits {};
+
+        template <typename Owner, typename V>
+        struct member_pointer_traits<V Owner::*> {
+            using owner_type = Owner;
+            using value_type = V;
+        };
+
+        /// The type of the data member `Member` points to.
+        template <auto Member>
+        using member_value_t = typename member_pointer_traits<decltype(Member)>::value_type;
+
+        /// Data member pointers into `T`, as taken by `Config::view()`.
+        template <auto Member, typename T>
+        concept MemberOf = std::is_member_object_pointer_v<decltype(Member)> &&
+                           std::is_same_v<typename member_pointer_traits<decltype(Member)>::owner_type, T>;
+
+        /**
+         * @brief Loads the snapshot published in `source`, an `std::atomic<std::shared_ptr<const T>>`, and aliases it to its `Member`.
+         */
+        template <typename T, auto Member>
+        std::shared_ptr<const member_value_t<Member>> load_member(const void* source) noexcept {
+            const auto content = static_cast<const std::atomic<std::shared_ptr<const T>>*>(source)->load(std::memory_order_acquire);
+            return std::shared_ptr<const member_value_t<Member>>(content, &((*content).*Member));
+        }
+    }
+
+    /**
+     * @brief Holds one published snapshot of a `Config<T>` for a scope, such as one solver timestep.
+     *
+     * Obtained from `Config::pin()` or `ConfigReader::pin()`. Every read through the pin sees the
+     * same content, however many snapshots the config publishes meanwhile, and is a plain load
+     * through the held pointer: no lock, no atomic and no reference count per field. The snapshot
+     * is released when the pin is destroyed. A pin owns its snapshot and may outlive the config.
+     *
+     * @tparam T The configuration structure type.
+     *
+     * @par Examples
+     * @code
+     * for (int step = 0; step < steps; ++step) {
+     *     const auto pinned = cfg.pin();
+     *     advance(pinned->simulation.time_step, pinned->physics);   // one consistent step
+     * }
+     * @endcode
+     */
+    template <IsConfigSchema T>
+    class ConfigPin {
+    public:
+        ConfigPin(const ConfigPin&) = delete;
+        ConfigPin& operator=(const ConfigPin&) = delete;
+        ConfigPin(ConfigPin&&) noexcept = default;
+        ConfigPin& operator=(ConfigPin&&) noexcept = default;
+
+        /**
+         * @brief Returns the pinned content.
+         */
+        [[nodiscard]] const T& get() const noexcept { return *m_content; }
+
+        const T& operator*() const noexcept { return *m_content; }
+
+        const T* operator->() const noexcept { return m_content; }
+
+        /**
+         * @brief Returns the generation the pinned snapshot was published at; see `Config::generation()`.
+         */
+        [[nodiscard]] std::uint64_t generation() const noexcept { return m_generation; }
+
+        /**
+         * @brief Returns the pinned snapshot, to keep it beyond the pin's scope.
+         */
+        [[nodiscard]] const std::shared_ptr<const T>& snapshot() const noexcept { return m_snapshot; }
+
+    private:
+        friend class Config<T>;
+        friend class ConfigReader<T>;
+
+        ConfigPin(std::shared_ptr<const T> snapshot, const std::uint64_t generation) noexcept
+            : m_snapshot(std::move(snapshot)), m_content(m_snapshot.get()), m_generation(generation) {}
+
+        std::shared_ptr<const T> m_snapshot;
+        const T* m_content;
+        std::uint64_t m_generation;
+    };
+
+    /**
+     * @brief Holds a shared lock on the content of a `Config<T>` for a scope, and reads it in place.
+     *
+     * Obtained from `Config::read()`. While any guard is held, writers (`mutate()`, `set()`,
+     * `load()`, `reset()` and the others) wait, so the content read through the guard is the live
+     * content, not a copy, and cannot change under the reader. Any number of guards may be held at
+     * once on different threads. Keep the scope short, and do not mutate the config while holding
+     * one on the same thread: that deadlocks. Readers that must never delay writers should use
+     * `Config::pin()` or `Config::snapshot()` instead.
+     *
+     * @tparam T The configuration structure type.
+     *
+     * @par Examples
+     * @code
+     * {
+     *     const auto guard = cfg.read();
+     *     advance(guard->simulation.time_step, guard->physics);
+     * }
+     * @endcode
+     */
+    template <IsConfigSchema T>
+    class ConfigReadGuard {
+    public:
+        ConfigReadGuard(const ConfigReadGuard&) = delete;
+        ConfigReadGuard& operator=(const ConfigReadGuard&) = delete;
+        ConfigReadGuard(ConfigReadGuard&&) noexcept = default;
+        ConfigReadGuard& operator=(ConfigReadGuard&&) noexcept = default;
+
+        /**
+         * @brief Returns the content; valid until the guard is destroyed.
+         */
+        [[nodiscard]] const T& get() const noexcept { return *m_content; }
+
+        const T& operator*() const noexcept { return *m_content; }
+
+        const T* operator->() const noexcept { return m_content; }
+
+    private:
+        friend class Config<T>;
+
+        ConfigReadGuard(std::shared_mutex& mutex, const T& content) : m_lock(mutex), m_content(&content) {}
+
+        std::shared_lock<std::shared_mutex> m_lock;
+        const T* m_content;
+    };
+
+    /**
+     * @brief Non-owning, read-only handle to the published snapshots of a `Config<T>`.
+     *
+     * `snapshot()` is an atomic load of the current snapshot and is safe to call on a
+     * shared handle from any thread. `current()` and `operator->` additionally cache the snapshot
+     * in the handle together with the config's publish version: as long as nothing new has been
+     * published, a read is one relaxed load of the version and a compare, with no reference count
+     * traffic, so threads on many cores do not contend on the snapshot's control block. These are
+     * not const, and each thread should use its own copy of the handle (copies are cheap).
+     *
+     * With `Config::set_numa_replication()` enabled, `snapshot()` and `current()` return the copy of
+     * the snapshot on the NUMA node the calling thread runs on; `current()` picks the node when it
+     * refreshes its cache, so a handle keeps using its copy until the config publishes again.
+     *
+     * A cached handle keeps the snapshot it last read alive until it is next used or destroyed.
+     * The handle must not outlive the config it was taken from, but stays valid when that config
+     * is moved.
+     *
+     * @tparam T The configuration structure type.
+     *
+     * @par Examples
+     * @code
+     * #pragma omp parallel
+     * {
+     *     auto local = reader;   // one copy per thread
+     *     for (std::size_t zone = 0; zone < zones; ++zone) {
+     *         step(zone, local->simulation.time_step);
+     *     }
+     * }
+     * @endcode
+     */
+    template <IsConfigSchema T>
+    class ConfigReader {
+    public:
+        /**
+         * @brief Returns the most recently published immutable snapshot; see `Config::snapshot()`.
+         *
+         * With NUMA replication enabled, this is the replica on the calling thread's node, which
+         * holds the same values as `Config::snapshot()` but is a different object.
+         *
+         * @return Shared pointer to the constant configuration content.
+         */
+        [[nodiscard]] std::shared_ptr<const T> snapshot() const noexcept {
+            if (const auto replicas = m_replicas->load(std::memory_order_acquire)) {
+                return (*replicas)[numa::current_node() % replicas->size()];
+            }
+            return m_snapshot->load(std::memory_order_acquire);
+        }
+
+        /**
+         * @brief Returns the current content, re-acquiring the snapshot only if a newer one was published.
+         *
+         * The reference stays valid until the next call to `current()` or `operator->` on this handle.
+         *
+         * @return Reference to the constant configuration content.
+         */
+        const T& current() noexcept {
+            const std::uint64_t version = m_version->load(std::memory_order_relaxed);
+            if (version != m_cached_version || !m_cached) {
+                // The snapshot is loaded with acquire ordering; a stale version only delays the refresh.
+                m_cached = snapshot();
+                m_cached_version = version;
+            }
+            return *m_cached;
+        }
+
+        /**
+         * @brief Accesses a member of the current content; see `current()`.
+         * @return Pointer to the constant configuration content.
+         */
+        const T* operator->() noexcept { return &current(); }
+
+        /**
+         * @brief Pins the most recently published snapshot for the caller's scope; see `ConfigPin`.
+         *
+         * Safe to call on a shared handle from any thread. With NUMA replication enabled, the pin
+         * holds the copy on the calling thread's node.
+         *
+         * @return The pin.
+         */
+        [[nodiscard]] ConfigPin<T> pin() const noexcept {
+            // The generation is read first, so it is never newer than the snapshot it is paired with.
+            const std::uint64_t generation = m_generation->load(std::memory_order_acquire);
+            return ConfigPin<T>(snapshot(), generation);
+        }
+
+        /**
+         * @brief Returns a copy of the most recently published content; see `Config::copy()`.
+         *
+         * Safe to call on a shared handle from any thread. For small trivially copyable schemas
+         * this reads the config's seqlock and touches no reference count.
+         *
+         * @return The content.
+         */
+        [[nodiscard]] T copy() const noexcept(detail::is_seqlock_eligible_v<T>) {
+            if constexpr (detail::is_seqlock_eligible_v<T>) {
+                return m_inline_copy->load();
+            } else {
+                return *m_snapshot->load(std::memory_order_acquire);
+            }
+        }
+
+        /**
+         * @brief Returns a handle to the member `Member` of the published snapshots; see `Config::view()`.
+         */
+        template <auto Member>
+            requires detail::MemberOf<Member, T>
+        [[nodiscard]] ConfigRef<detail::member_value_t<Member>> view() const noexcept {
+            return ConfigRef<detail::member_value_t<Member>>(m_snapshot, &detail::load_member<T, Member>, *m_version, *m_generation);
+        }
+
+    private:
+        friend class Config<T>;
+
+        using Replicas = std::vector<std::shared_ptr<const T>>;
+
+        ConfigReader(const std::atomic<std::shared_ptr<const T>>& snapshot, const std::atomic<std::uint64_t>& version,
+                     const std::atomic<std::uint64_t>& generation, const std::atomic<std::shared_ptr<const Replicas>>& replicas,
+                     const detail::Seqlock<T>& inline_copy)
+            : m_snapshot(&snapshot), m_version(&version), m_generation(&generation), m_replicas(&replicas),
+              m_inline_copy(&inline_copy) {}
+
+        const std::atomic<std::shared_ptr<const T>>* m_snapshot;
+        const std::atomic<std::uint64_t>* m_version;
+        const std::atomic<std::uint64_t>* m_generation;
+        const std::atomic<std::shared_ptr<const Replicas>>* m_replicas;
+        const detail::Seqlock<T>* m_inline_copy;
+        std::shared_ptr<const T> m_cached;
+        std::uint64_t m_cached_version = 0;
+    };
+
+    /**
+     * @brief Read-only handle to one member of the published snapshots of a `Config`, such as a section.
+     *
+     * Obtained from `Config::view()` or `ConfigReader::view()`. The handle shares the parent's
+     * snapshots instead of copying the member out of them: `snapshot()` returns the member inside
+     * the parent's current snapshot, keeping the whole snapshot alive, and `current()` caches it
+     * until the parent publishes again, like `ConfigReader::current()`. Reloads, mutations and
+     * resets of the parent are therefore seen on the next read, and `generation()` is the parent's.
+     *
+     * Like `ConfigReader`, each thread should use its own copy, and the handle must not outlive
+     * the config it was taken from.
+     *
+     * @tparam U The type of the member.
+     *
+     * @par Examples
+     * @code
+     * auto physics = cfg.view<&Schema::physics>();
+     * if (physics->diffusion) diffuse();
+     * const auto held = physics.snapshot();   // this physics section, across later reloads
+     * @endcode
+     */
+    template <typename U>
+    class ConfigRef {
+    public:
+        /**
+         * @brief Returns the member inside the most recently published snapshot of the parent.
+         */
+        [[nodiscard]] std::shared_ptr<const U> snapshot() const noexcept { return m_load(m_source); }
+
+        /**
+         * @brief Returns the current member, re-acquiring the parent's snapshot only if a newer one was published.
+         *
+         * The reference stays valid until the next call to `current()`, `operator*` or `operator->` on this handle.
+         */
+        const U& current() noexcept {
+            const std::uint64_t version = m_version->load(std::memory_order_relaxed);
+            if (version != m_cached_version || !m_cached) {
+                m_cached = snapshot();
+                m_cached_version = version;
+            }
+            return *m_cached;
+        }
+
+        const U& operator*() noexcept { return current(); }
+
+        const U* operator->() noexcept { return &current(); }
+
+        /**
+         * @brief Returns the generation of the parent; see `Config::generation()`.
+         */
+        [[nodiscard]] std::uint64_t generation() const noexcept { return m_generation->load(std::memory_order_acquire); }
+
+    private:
+        template <IsConfigSchema>
+        friend class Config;
+        template <IsConfigSchema>
+        friend class ConfigReader;
+
+        using Loader = std::shared_ptr<const U> (*)(const void*) noexcept;
+
+        ConfigRef(const void* source, const Loader load, const std::atomic<std::uint64_t>& version,
+                  const std::atomic<std::uint64_t>& generation) noexcept
+            : m_source(source), m_load(load), m_version(&version), m_generation(&generation) {}
+
+        const void* m_source;
+        Loader m_load;
+        const std::atomic<std::uint64_t>* m_version;
+        const std::atomic<std::uint64_t>* m_generation;
+        std::shared_ptr<const U> m_cached;
+        std::uint64_t m_cached_version = 0;
+    };
+}
@@ -0,0 +1,318 @@
+/**
+ * @file records.h
+ * @brief Streaming many configs of one schema through a single file, one record at a time.
+ *
+ * Ensemble tools that exchange hundreds of thousands of member configs cannot afford one file
+ * per member on a shared filesystem. `RecordWriter` appends members to one file and
+ * `RecordReader` reads them back one record at a time into a content buffer it reuses, so memory
+ * stays constant however many records the file holds:
+ *
+ * @code
+ * fourdst::config::RecordWriter<MemberSchema> writer("ensemble.jsonl");
+ * for (const auto& member : members) writer.write(member);
+ * writer.close();
+ *
+ * for (const MemberSchema& member : fourdst::config::RecordReader<MemberSchema>("ensemble.jsonl")) {
+ *     run(member);  // valid until the next record is read
+ * }
+ * @endcode
+ *
+ * Two formats are supported:
+ *
+ * - `RecordFormat::JSON_LINES`: one compact JSON object per line, holding the fields of `T`
+ *   directly (no root table). Each line is parsed by yyjson into an arena the reader reuses and
+ *   applied to a copy of the defaults of `T`, so fields a record leaves out keep their defaults,
+ *   and the strings and vectors of the buffer keep their capacity from record to record. Blank
+ *   lines are skipped; other tools can write and read the files.
+ * - `RecordFormat::BINARY`: a header (`binary_records_magic` and `io::content_fingerprint<T>()`)
+ *   followed by records, each a native-endian 64-bit length and `io::encode_content()` bytes.
+ *   Faster and smaller, but tied to the schema and the machine; a reader of another schema
+ *   rejects the file by its fingerprint.
+ *
+ * `RecordReader` tells the formats apart by the header. Records are read as they are; schema
+ * validators that reflect-cpp runs while reading still apply, but `Config` validation rules and
+ * constraints do not; load a record into a `Config` (e.g. with `Config::mutate()`) to run them.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "fourdst/config/base.h"
+#include "fourdst/config/binary.h"
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/json_writer.h"
+#include "fourdst/config/patch.h"
+
+#include "yyjson.h"
+
+namespace fourdst::config {
+
+    /**
+     * @brief The layout of a record file; see records.h.
+     */
+    enum class RecordFormat : std::uint8_t {
+        /// One compact JSON object per line.
+        JSON_LINES,
+        /// Length-prefixed `io::encode_content()` records after a schema header.
+        BINARY,
+    };
+
+    /// The first bytes of a `RecordFormat::BINARY` file.
+    inline constexpr std::string_view binary_records_magic = "4DCFGREC";
+
+    /**
+     * @brief Appends configs of schema `T` to one record file.
+     * @tparam T The configuration schema type.
+     */
+    template <IsConfigSchema T>
+    class RecordWriter {
+    public:
+        /**
+         * @brief Creates (or truncates) `path` and, for `RecordFormat::BINARY`, writes the header.
+         * @throws exceptions::ConfigSaveError If the file cannot be opened.
+         */
+        explicit RecordWriter(std::string path, const RecordFormat format = RecordFormat::JSON_LINES)
+            : m_path(std::move(path)), m_format(format), m_out(m_path, std::ios::binary | std::ios::trunc) {
+            if (!m_out) {
+                throw exceptions::ConfigSaveError(std::format("Unable to open record file '{}' for writing.", m_path));
+            }
+            if (m_format == RecordFormat::BINARY) {
+                const std::uint64_t fingerprint = io::content_fingerprint<T>();
+                m_out.write(binary_records_magic.data(), static_cast<std::streamsize>(binary_records_magic.size()));
+                m_out.write(reinterpret_cast<const char*>(&fingerprint), sizeof(fingerprint));
+            }
+        }
+
+        RecordWriter(const RecordWriter&) = delete;
+        RecordWriter& operator=(const RecordWriter&) = delete;
+
+        /**
+         * @brief Appends one record.
+         * @throws exceptions::ConfigSaveError If the write fails.
+         */
+        void write(const T& content) {
+            m_buffer.clear();
+            if (m_format == RecordFormat::BINARY) {
+                io::encode_content(m_buffer, content);
+                const std::uint64_t length = m_buffer.size();
+                m_out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+            } else {
+                m_buffer = io::write_json(content);
+                m_buffer += '\n';
+            }
+            m_out.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+            if (!m_out) {
+                throw exceptions::ConfigSaveError(std::format("Unable to write record {} to '{}'.", m_count, m_path));
+            }
+            ++m_count;
+        }
+
+        /**
+         * @brief Appends the current snapshot of `config` as one record.
+         */
+        void write(const Config<T>& config) {
+            write(*config.snapshot());
+        }
+
+        /**
+         * @brief Flushes buffered records to the file.
+         * @throws exceptions::ConfigSaveError If the flush fails.
+         */
+        void flush() {
+            m_out.flush();
+            if (!m_out) throw exceptions::ConfigSaveError(std::format("Unable to flush record file '{}'.", m_path));
+        }
+
+        /**
+         * @brief Flushes and closes the file; further writes throw.
+         * @throws exceptions::ConfigSaveError If the flush fails.
+         */
+        void close() {
+            flush();
+            m_out.close();
+        }
+
+        /// The number of records written.
+        [[nodiscard]] std::size_t count() const noexcept { return m_count; }
+
+    private:
+        std::string m_path;
+        RecordFormat m_format;
+        std::ofstream m_out;
+        std::string m_buffer;
+        std::size_t m_count = 0;
+    };
+
+    /**
+     * @brief Reads the records of a record file one at a time into a reused content buffer.
+     *
+     * Iterating a reader (`begin()`, `end()`) is an input range over `const T&`; each reference
+     * is valid until the next record is read.
+     *
+     * @tparam T The configuration schema type.
+     */
+    template <IsConfigSchema T>
+    class RecordReader {
+    public:
+        /**
+         * @brief Input iterator over the records of a reader.
+         */
+        class iterator {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+
+            iterator() = default;
+
+            const T& operator*() const { return m_reader->current(); }
+            const T* operator->() const { return &m_reader->current(); }
+
+            iterator& operator++() {
+                if (!m_reader->next()) m_reader = nullptr;
+                return *this;
+            }
+
+            void operator++(int) { ++*this; }
+
+            friend bool operator==(const iterator& it, std::default_sentinel_t) { return it.m_reader == nullptr; }
+
+        private:
+            friend class RecordReader;
+            explicit iterator(RecordReader* reader) : m_reader(reader) {}
+
+            RecordReader* m_reader = nullptr;
+        };
+
+        /**
+         * @brief Opens `path` and reads its header, if it has one.
+         * @throws exceptions::ConfigLoadError If the file cannot be opened, or is a binary record file of another schema.
+         */
+        explicit RecordReader(std::string path) : m_path(std::move(path)), m_in(m_path, std::ios::binary) {
+            if (!m_in) {
+                throw exceptions::ConfigLoadError(std::format("Unable to open record file '{}'.", m_path));
+            }
+            std::array<char, binary_records_magic.size()> magic{};
+            m_in.read(magic.data(), magic.size());
+            if (m_in.gcount() == static_cast<std::streamsize>(magic.size()) &&
+                std::string_view(magic.data(), magic.size()) == binary_records_magic) {
+                m_format = RecordFormat::BINARY;
+                std::uint64_t fingerprint = 0;
+                if (!m_in.read(reinterpret_cast<char*>(&fingerprint), sizeof(fingerprint)) ||
+                    fingerprint != io::content_fingerprint<T>()) {
+                    throw exceptions::ConfigLoadError(
+                        std::format("Record file '{}' was written for another schema (fingerprint mismatch).", m_path));
+                }
+            } else {
+                m_in.clear();
+                m_in.seekg(0);
+            }
+        }
+
+        RecordReader(const RecordReader&) = delete;
+        RecordReader& operator=(const RecordReader&) = delete;
+
+        /**
+         * @brief Reads the next record into the buffer `current()` returns.
+         * @return False at the end of the file.
+         * @throws exceptions::ConfigParseError If the record is malformed or doesn't match the schema;
+         *         the location names the line (JSON Lines) or the record index (binary).
+         */
+        bool next() {
+            return m_format == RecordFormat::BINARY ? next_binary() : next_json();
+        }
+
+        /// The record read by the last successful `next()`.
+        [[nodiscard]] const T& current() const noexcept { return m_content; }
+
+        /// The 0-based index of the current record.
+        [[nodiscard]] std::size_t index() const noexcept { return m_count - 1; }
+
+        /// The format of the file, detected from its header.
+        [[nodiscard]] RecordFormat format() const noexcept { return m_format; }
+
+        /**
+         * @brief Reads the first record and returns an iterator to it, or `end()` if there is none.
+         */
+        iterator begin() {
+            iterator it(this);
+            ++it;
+            return it;
+        }
+
+        std::default_sentinel_t end() const noexcept { return {}; }
+
+    private:
+        bool next_json() {
+            while (std::getline(m_in, m_line)) {
+                ++m_line_number;
+                if (m_line.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+                const std::size_t needed = yyjson_read_max_memory_usage(m_line.size(), 0);
+                if (m_arena.size() < needed) m_arena.resize(needed);
+                yyjson_alc allocator;
+                yyjson_alc_pool_init(&allocator, m_arena.data(), m_arena.size());
+                yyjson_read_err err;
+                yyjson_doc* doc = yyjson_read_opts(m_line.data(), m_line.size(), 0, &allocator, &err);
+                if (doc == nullptr || !yyjson_is_obj(yyjson_doc_get_root(doc))) {
+                    throw exceptions::ConfigParseError(
+                        std::format("Unable to parse record on line {} of '{}'. Reason: {}", m_line_number, m_path,
+                                    doc == nullptr ? err.msg : "a record must be a JSON object"),
+                        exceptions::ConfigParseError::Location{m_path, m_line_number, doc == nullptr ? err.pos + 1 : 0, {}});
+                }
+                m_content = m_defaults;
+                try {
+                    io::apply_json_patch(m_content, yyjson_doc_get_root(doc));
+                } catch (const exceptions::ConfigError& e) {
+                    throw exceptions::ConfigParseError(
+                        std::format("Record on line {} of '{}' does not match the schema: {}", m_line_number, m_path, e.what()),
+                        exceptions::ConfigParseError::Location{m_path, m_line_number, 0, {}});
+                }
+                ++m_count;
+                return true;
+            }
+            return false;
+        }
+
+        bool next_binary() {
+            std::uint64_t length = 0;
+            if (!m_in.read(reinterpret_cast<char*>(&length), sizeof(length))) {
+                if (m_in.gcount() == 0) return false;
+                throw truncated();
+            }
+            m_line.resize(length);
+            if (!m_in.read(m_line.data(), static_cast<std::streamsize>(length))) throw truncated();
+            if (!io::decode_content(m_line, m_content)) {
+                throw exceptions::ConfigParseError(std::format("Record {} of '{}' is malformed.", m_count, m_path),
+                                                   exceptions::ConfigParseError::Location{m_path, 0, 0, {}});
+            }
+            ++m_count;
+            return true;
+        }
+
+        exceptions::ConfigParseError truncated() const {
+            return exceptions::ConfigParseError(std::format("Record {} of '{}' is truncated.", m_count, m_path),
+                                                exceptions::ConfigParseError::Location{m_path, 0, 0, {}});
+        }
+
+        std::string m_path;
+        std::ifstream m_in;
+        RecordFormat m_format = RecordFormat::JSON_LINES;
+        const T m_defaults{};
+        T m_content{};
+        std::string m_line;
+        std::vector<char> m_arena;
+        std::size_t m_line_number = 0;
+        std::size_t m_count = 0;
+    };
+}
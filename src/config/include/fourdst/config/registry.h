@@ -0,0 +1,322 @@
+/**
+ * @file registry.h
+ * @brief Reloading the configs of many subsystems together and reading them at one generation.
+ *
+ * Each subsystem owns a `Config` of its own schema. Reloading them one after the other lets a
+ * reader that consults several subsystems see some reloaded and some not. `ConfigRegistry`
+ * registers the configs by root name and reloads them as one:
+ *
+ * 1. every config is staged (`Config::stage_reload()`) in parallel on the default executor;
+ *    a file several configs were loaded from is parsed once and each takes its root table;
+ * 2. if any config fails to parse or validate, the error is rethrown and no config changes;
+ * 3. otherwise all staged contents are committed and the registry publishes one `Snapshot`
+ *    holding the new snapshot of every config under a new registry generation.
+ *
+ * @code
+ * fourdst::config::ConfigRegistry registry;
+ * registry.add(main_cfg).add(network_cfg, "network").add(eos_cfg, "eos");
+ *
+ * registry.reload();  // all three, or none
+ *
+ * const auto view = registry.snapshot();
+ * const auto network = view->get<NetworkSchema>("network");
+ * const auto eos = view->get<EosSchema>("eos");  // from the same reload as network
+ * @endcode
+ *
+ * A reader that takes its snapshots from one `registry.snapshot()` never mixes the contents of
+ * two reloads. `Config::snapshot()` of each config still works and is consistent on its own, but
+ * a reader that calls it for two configs during a reload may see one before and one after the
+ * commit. Subscribers of each config are notified by its commit, as by `reload()`.
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <format>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <typeindex>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/base.h"
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/executor.h"
+#include "fourdst/config/fragments.h"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config {
+
+    /**
+     * @brief Configs of different schemas, registered by root name and reloaded as one.
+     *
+     * The registry does not own the configs; they must outlive it. Registering a config sets its
+     * root name load policy to `KEEP_CURRENT`, as `ConfigBundle` does, so each config keeps
+     * reading its own root table from a shared file. All members are thread-safe.
+     */
+    class ConfigRegistry {
+    public:
+        /**
+         * @brief The snapshots of all registered configs, as published by one registry generation.
+         */
+        class Snapshot {
+        public:
+            /**
+             * @brief Returns the snapshot of the config registered for `root`.
+             * @throws exceptions::ConfigLoadError If no config is registered for `root`, or its schema is not `T`.
+             */
+            template <IsConfigSchema T>
+            [[nodiscard]] std::shared_ptr<const T> get(const std::string_view root) const {
+                const auto it = std::ranges::find(m_slots, root, &Slot::root);
+                if (it == m_slots.end()) {
+                    throw exceptions::ConfigLoadError(std::format("No config is registered for root table '{}'.", root));
+                }
+                if (it->type != std::type_index(typeid(T))) {
+                    throw exceptions::ConfigLoadError(
+                        std::format("The config registered for root table '{}' has another schema.", root));
+                }
+                return std::static_pointer_cast<const T>(it->content);
+            }
+
+            /// The registry generation this snapshot was published at.
+            [[nodiscard]] std::uint64_t generation() const noexcept { return m_generation; }
+
+        private:
+            friend class ConfigRegistry;
+
+            struct Slot {
+                std::string root;
+                std::type_index type;
+                std::shared_ptr<const void> content;
+            };
+
+            std::uint64_t m_generation = 0;
+            std::vector<Slot> m_slots;
+        };
+
+        ConfigRegistry() = default;
+        ConfigRegistry(const ConfigRegistry&) = delete;
+        ConfigRegistry& operator=(const ConfigRegistry&) = delete;
+
+        /**
+         * @brief Registers `config` for the root table named by its current root name.
+         * @return This registry, for chaining.
+         * @throws exceptions::ConfigLoadError If another config is already registered for that root.
+         */
+        template <IsConfigSchema T>
+        ConfigRegistry& add(Config<T>& config) {
+            {
+                const std::lock_guard lock(m_mutex);
+                std::string root(config.get_root_name());
+                if (std::ranges::any_of(m_entries, [&](const auto& entry) { return entry->root == root; })) {
+                    throw exceptions::ConfigLoadError(
+                        std::format("Cannot add config to registry: a config is already registered for root table '{}'.", root));
+                }
+                config.set_root_name_load_policy(RootNameLoadPolicy::KEEP_CURRENT);
+                m_entries.push_back(std::make_unique<EntryFor<T>>(std::move(root), config));
+                publish_locked();
+            }
+            return *this;
+        }
+
+        /**
+         * @brief Sets the root name of `config` to `root` and registers it for that root table.
+         * @return This registry, for chaining.
+         * @throws exceptions::ConfigLoadError If another config is already registered for `root`.
+         */
+        template <IsConfigSchema T>
+        ConfigRegistry& add(Config<T>& config, const std::string_view root) {
+            config.set_root_name(root);
+            return add(config);
+        }
+
+        /**
+         * @brief Returns the config registered for `root`.
+         * @throws exceptions::ConfigLoadError If no config is registered for `root`, or its schema is not `T`.
+         */
+        template <IsConfigSchema T>
+        [[nodiscard]] Config<T>& get(const std::string_view root) const {
+            const std::lock_guard lock(m_mutex);
+            const auto it = std::ranges::find_if(m_entries, [&](const auto& entry) { return entry->root == root; });
+            if (it == m_entries.end()) {
+                throw exceptions::ConfigLoadError(std::format("No config is registered for root table '{}'.", root));
+            }
+            auto* entry = dynamic_cast<EntryFor<T>*>(it->get());
+            if (entry == nullptr) {
+                throw exceptions::ConfigLoadError(std::format("The config registered for root table '{}' has another schema.", root));
+            }
+            return entry->config;
+        }
+
+        /**
+         * @brief Reloads every registered config from its files, all or none.
+         *
+         * Each config is staged as by `Config::stage_reload()`; files shared by several configs
+         * are parsed once. If every config stages, all of them are committed and one registry
+         * snapshot is published; otherwise the first error, in registration order, is rethrown
+         * and nothing changes.
+         *
+         * @param verbose If true, a tree of missing fields is printed to stderr when a file does not match its schema.
+         * @return True if the content of any config changed.
+         * @throws exceptions::ConfigLoadError If a config was not loaded from files, a file doesn't exist, or a root is missing.
+         * @throws exceptions::ConfigParseError If a file is invalid TOML or a root table doesn't match its schema.
+         */
+        bool reload(const bool verbose = false) {
+            const std::lock_guard lock(m_mutex);
+            Documents documents;
+            const auto read = [&documents](const std::string& path) -> const toml::table& { return documents.get(path); };
+
+            std::vector<std::exception_ptr> errors(m_entries.size());
+            std::atomic<std::size_t> next{0};
+            const std::size_t workers = std::min<std::size_t>(m_entries.size(), std::max(1u, std::thread::hardware_concurrency()));
+            bulk_execute(workers, [&](std::size_t) {
+                for (std::size_t i = next.fetch_add(1, std::memory_order_relaxed); i < m_entries.size();
+                     i = next.fetch_add(1, std::memory_order_relaxed)) {
+                    try {
+                        m_entries[i]->stage(verbose, read);
+                    } catch (...) {
+                        errors[i] = std::current_exception();
+                    }
+                }
+            });
+            for (const std::exception_ptr& error : errors) {
+                if (error) {
+                    for (const auto& entry : m_entries) entry->discard();
+                    std::rethrow_exception(error);
+                }
+            }
+
+            bool changed = false;
+            for (const auto& entry : m_entries) {
+                changed = entry->commit() || changed;
+            }
+            publish_locked();
+            return changed;
+        }
+
+        /**
+         * @brief Publishes the current snapshots of all configs as a new registry generation.
+         *
+         * `reload()` publishes by itself; call this after changing configs by other means, such
+         * as `Config::mutate()` or a `Config::reload()` of one of them, to expose the change
+         * through `snapshot()`.
+         */
+        void publish() {
+            const std::lock_guard lock(m_mutex);
+            publish_locked();
+        }
+
+        /**
+         * @brief Returns the snapshots of all configs as published by the last `reload()` or `publish()`.
+         */
+        [[nodiscard]] std::shared_ptr<const Snapshot> snapshot() const {
+            return m_snapshot.load(std::memory_order_acquire);
+        }
+
+        /// The number of registry snapshots published; each `add()`, `reload()` and `publish()` advances it.
+        [[nodiscard]] std::uint64_t generation() const {
+            return snapshot()->generation();
+        }
+
+        /**
+         * @brief Gets the number of registered configs.
+         */
+        [[nodiscard]] std::size_t size() const {
+            const std::lock_guard lock(m_mutex);
+            return m_entries.size();
+        }
+
+    private:
+        /**
+         * @brief The files parsed during one `reload()`, each parsed once by whichever config needs it first.
+         */
+        class Documents {
+        public:
+            const toml::table& get(const std::string& path) {
+                std::shared_ptr<Document> document;
+                {
+                    const std::lock_guard lock(m_mutex);
+                    auto& slot = m_documents[path];
+                    if (!slot) slot = std::make_shared<Document>();
+                    document = slot;
+                }
+                std::call_once(document->once, [&] {
+                    try {
+                        document->table = io::parse_document(path);
+                    } catch (...) {
+                        document->error = std::current_exception();
+                    }
+                });
+                if (document->error) std::rethrow_exception(document->error);
+                return document->table;
+            }
+
+        private:
+            struct Document {
+                std::once_flag once;
+                toml::table table;
+                std::exception_ptr error;
+            };
+
+            std::mutex m_mutex;
+            std::map<std::string, std::shared_ptr<Document>> m_documents;
+        };
+
+        struct Entry {
+            explicit Entry(std::string root) : root(std::move(root)) {}
+            virtual ~Entry() = default;
+            virtual void stage(bool verbose, const std::function<const toml::table&(const std::string&)>& read) = 0;
+            virtual bool commit() = 0;
+            virtual void discard() = 0;
+            [[nodiscard]] virtual Snapshot::Slot slot() const = 0;
+
+            std::string root;
+        };
+
+        template <IsConfigSchema T>
+        struct EntryFor final : Entry {
+            EntryFor(std::string root, Config<T>& config) : Entry(std::move(root)), config(config) {}
+
+            void stage(const bool verbose, const std::function<const toml::table&(const std::string&)>& read) override {
+                staged.emplace(config.stage_reload(verbose, read));
+            }
+
+            bool commit() override {
+                const bool changed = config.commit_reload(std::move(*staged));
+                staged.reset();
+                return changed;
+            }
+
+            void discard() override { staged.reset(); }
+
+            [[nodiscard]] Snapshot::Slot slot() const override {
+                return {root, std::type_index(typeid(T)), config.snapshot()};
+            }
+
+            Config<T>& config;
+            std::optional<typename Config<T>::StagedReload> staged;
+        };
+
+        void publish_locked() {
+            auto next = std::make_shared<Snapshot>();
+            next->m_generation = m_snapshot.load(std::memory_order_relaxed)->generation() + 1;
+            next->m_slots.reserve(m_entries.size());
+            for (const auto& entry : m_entries) next->m_slots.push_back(entry->slot());
+            m_snapshot.store(std::move(next), std::memory_order_release);
+        }
+
+        mutable std::mutex m_mutex;
+        std::vector<std::unique_ptr<Entry>> m_entries;
+        std::atomic<std::shared_ptr<const Snapshot>> m_snapshot{std::make_shared<const Snapshot>()};
+    };
+}
@@ -0,0 +1,246 @@
+/**
+ * @file resident.h
+ * @brief Keeping the memory of published snapshots resident: prefaulted, and optionally locked.
+ *
+ * A control loop that reads a config on every iteration should not pay for the first read of a
+ * new snapshot with page faults, nor for a later one because the kernel swapped or migrated a
+ * page of it. With `Config::set_residency()`, every snapshot is made resident before it is
+ * published, on the publishing thread, so readers never see it half faulted in:
+ *
+ * - `Residency::PREFAULT` touches every page the snapshot occupies: the object itself and the
+ *   heap buffers of its strings, vectors, maps and tensors;
+ * - `Residency::LOCKED` also `mlock`s those pages, so they stay resident until the snapshot is
+ *   released, when they are unlocked again.
+ *
+ * The buffers are gathered by reflection, rounded to whole pages and merged, so each run of
+ * adjacent pages costs one `mlock`. With `Config::set_compaction()` the `std::pmr` members of a
+ * snapshot share one arena, which makes their pages a single run.
+ *
+ * Locking counts against `RLIMIT_MEMLOCK`. A snapshot that cannot be locked is still prefaulted.
+ * Pages are locked per page, not per allocation: unlocking a released snapshot also unlocks any
+ * page it shared with a newer one, until the newer one is published again. Locking needs POSIX;
+ * elsewhere `LOCKED` prefaults only.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/flat_map.h"
+#include "fourdst/config/path_table.h"
+#include "fourdst/config/soa.h"
+#include "fourdst/config/tensor.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define FOURDST_CONFIG_HAS_MLOCK 1
+#else
+#define FOURDST_CONFIG_HAS_MLOCK 0
+#endif
+
+namespace fourdst::config {
+
+    /**
+     * @brief What is done to the memory of a snapshot before it is published; see `Config::set_residency()`.
+     */
+    enum class Residency : std::uint8_t {
+        /// Nothing; pages are faulted in by the first reader that touches them.
+        DEFAULT,
+        /// Every page of the snapshot is touched before it is published.
+        PREFAULT,
+        /// Every page is locked in memory (`mlock`) until the snapshot is released.
+        LOCKED,
+    };
+
+    namespace detail {
+        /**
+         * @brief Page-aligned address ranges, sorted and merged.
+         */
+        class PageRanges {
+        public:
+            /// Adds the pages overlapping `[data, data + bytes)`.
+            void add(const void* data, const std::size_t bytes) {
+                if (data == nullptr || bytes == 0) return;
+                const auto begin = reinterpret_cast<std::uintptr_t>(data);
+                m_ranges.emplace_back(begin & ~(page_size() - 1), (begin + bytes + page_size() - 1) & ~(page_size() - 1));
+            }
+
+            /// Sorts the ranges and merges those that touch.
+            void merge() {
+                std::ranges::sort(m_ranges);
+                std::vector<std::pair<std::uintptr_t, std::uintptr_t>> merged;
+                for (const auto& range : m_ranges) {
+                    if (!merged.empty() && range.first <= merged.back().second) {
+                        merged.back().second = std::max(merged.back().second, range.second);
+                    } else {
+                        merged.push_back(range);
+                    }
+                }
+                m_ranges = std::move(merged);
+            }
+
+            /// Reads one byte of every page.
+            void prefault() const {
+                for (const auto& [begin, end] : m_ranges) {
+                    for (std::uintptr_t page = begin; page < end; page += page_size()) {
+                        (void)*reinterpret_cast<const volatile unsigned char*>(page);
+                    }
+                }
+            }
+
+            /**
+             * @brief Locks every range; returns false, with nothing locked, if one cannot be.
+             */
+            bool lock() const {
+#if FOURDST_CONFIG_HAS_MLOCK
+                for (std::size_t i = 0; i < m_ranges.size(); ++i) {
+                    const auto& [begin, end] = m_ranges[i];
+                    if (::mlock(reinterpret_cast<const void*>(begin), end - begin) != 0) {
+                        for (std::size_t j = 0; j < i; ++j) unlock(m_ranges[j]);
+                        return false;
+                    }
+                }
+                return true;
+#else
+                return false;
+#endif
+            }
+
+            void unlock() const {
+                for (const auto& range : m_ranges) unlock(range);
+            }
+
+            /// Number of merged ranges, i.e. of `mlock` calls a lock takes.
+            [[nodiscard]] std::size_t size() const { return m_ranges.size(); }
+
+            /// Whether the page holding `address` is covered.
+            [[nodiscard]] bool contains(const void* address) const {
+                const auto at = reinterpret_cast<std::uintptr_t>(address);
+                return std::ranges::any_of(m_ranges, [at](const auto& range) { return range.first <= at && at < range.second; });
+            }
+
+            /// Number of bytes covered.
+            [[nodiscard]] std::size_t bytes() const {
+                std::size_t total = 0;
+                for (const auto& [begin, end] : m_ranges) total += end - begin;
+                return total;
+            }
+
+            static std::uintptr_t page_size() {
+#if FOURDST_CONFIG_HAS_MLOCK
+                static const auto size = static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE));
+                return size;
+#else
+                return 4096;
+#endif
+            }
+
+        private:
+            static void unlock([[maybe_unused]] const std::pair<std::uintptr_t, std::uintptr_t>& range) {
+#if FOURDST_CONFIG_HAS_MLOCK
+                ::munlock(reinterpret_cast<const void*>(range.first), range.second - range.first);
+#endif
+            }
+
+            std::vector<std::pair<std::uintptr_t, std::uintptr_t>> m_ranges;
+        };
+
+        /**
+         * @brief Adds the heap buffers owned by `value` to `ranges`, not counting `value` itself.
+         *
+         * Follows the same members as `heap_usage()`; fields whose contents are shared between
+         * snapshots or loaded on demand (`Lazy`, `Section`, `std::string_view`) are skipped.
+         */
+        template <typename V>
+        void collect_pages(const V& value, PageRanges& ranges) {
+            using Type = std::remove_cvref_t<V>;
+            if constexpr (validate::is_std_string_v<Type>) {
+                // Short strings live in the object itself.
+                const auto* begin = reinterpret_cast<const char*>(&value);
+                if (value.data() < begin || value.data() >= begin + sizeof(Type)) ranges.add(value.data(), value.capacity() + 1);
+            } else if constexpr (validate::is_optional_v<Type>) {
+                if (value.has_value()) collect_pages(*value, ranges);
+            } else if constexpr (validate::is_sharded_v<Type>) {
+                collect_pages(value.entries(), ranges);
+            } else if constexpr (validate::is_tagged_union_v<Type>) {
+                rfl::visit([&](const auto& alternative) { collect_pages(alternative, ranges); }, value.variant());
+            } else if constexpr (validate::is_soa_v<Type>) {
+                std::apply([&](const auto&... column) { (collect_pages(column, ranges), ...); }, value.columns());
+            } else if constexpr (validate::is_tensor_v<Type>) {
+                ranges.add(value.data(), value.size() * sizeof(typename Type::value_type));
+            } else if constexpr (validate::is_vector_v<Type>) {
+                using Element = typename Type::value_type;
+                if constexpr (!std::is_same_v<Element, bool>) {
+                    ranges.add(value.data(), value.capacity() * sizeof(Element));
+                    for (const auto& element : value) collect_pages(element, ranges);
+                }
+            } else if constexpr (validate::is_std_array_v<Type>) {
+                for (const auto& element : value) collect_pages(element, ranges);
+            } else if constexpr (validate::is_map_v<Type>) {
+                if constexpr (validate::is_flat_map_v<Type>) {
+                    collect_pages(value.entries(), ranges);
+                } else {
+                    for (const auto& node : value) {
+                        ranges.add(&node, sizeof(node));
+                        collect_pages(node.first, ranges);
+                        collect_pages(node.second, ranges);
+                    }
+                }
+            } else if constexpr (validate::is_reflectable_struct_v<Type>) {
+                const auto view = rfl::to_view(value);
+                using Fields = typename rfl::named_tuple_t<Type>::Fields;
+                [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                    (collect_pages(*rfl::get<Is>(view.values()), ranges), ...);
+                }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+            }
+        }
+
+        /**
+         * @brief Returns the pages `content` occupies, itself and its heap buffers, merged.
+         */
+        template <typename T>
+        PageRanges snapshot_pages(const T& content) {
+            PageRanges ranges;
+            ranges.add(&content, sizeof(T));
+            collect_pages(content, ranges);
+            ranges.merge();
+            return ranges;
+        }
+
+        /**
+         * @brief Makes `snapshot` resident as `residency` asks.
+         * @return `snapshot`, or under `LOCKED` a snapshot aliasing it that unlocks its pages on release.
+         */
+        template <typename T>
+        std::shared_ptr<const T> make_resident(std::shared_ptr<const T> snapshot, const Residency residency) {
+            if (residency == Residency::DEFAULT || !snapshot) return snapshot;
+            PageRanges pages = snapshot_pages(*snapshot);
+            if (residency == Residency::LOCKED && pages.lock()) {
+                struct Locked {
+                    Locked(std::shared_ptr<const T> snapshot, PageRanges pages) : snapshot(std::move(snapshot)), pages(std::move(pages)) {}
+                    Locked(const Locked&) = delete;
+                    Locked& operator=(const Locked&) = delete;
+                    ~Locked() { pages.unlock(); }
+
+                    std::shared_ptr<const T> snapshot;
+                    PageRanges pages;
+                };
+                const T* content = snapshot.get();
+                auto locked = std::make_shared<const Locked>(std::move(snapshot), std::move(pages));
+                return std::shared_ptr<const T>(locked, content);
+            }
+            pages.prefault();
+            return snapshot;
+        }
+    }
+}
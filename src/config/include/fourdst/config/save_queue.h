@@ -0,0 +1,146 @@
+/**
+ * @file save_queue.h
+ * @brief The background writer thread behind `Config::save_async()`.
+ *
+ * `SaveQueue` runs file writes one at a time, in submission order, on a single thread owned by
+ * the process, so checkpointing a config never runs serialization or I/O on the calling thread.
+ *
+ * Writes are double-buffered per file: while one write to a path is in progress, at most one
+ * more waits. A write submitted while another one to the same path is still waiting replaces it,
+ * and the futures of both become ready when the newer write finishes. A caller that saves faster
+ * than the file system keeps up therefore never builds a backlog of stale snapshots.
+ */
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace fourdst::config::io {
+
+    /**
+     * @brief A single background thread that writes files in submission order.
+     *
+     * The thread starts with the first submitted write. All member functions are thread-safe.
+     * Writes still waiting when the process exits are finished before the queue is destroyed.
+     */
+    class SaveQueue {
+    public:
+        /**
+         * @brief Returns the process-wide queue.
+         */
+        static SaveQueue& instance() {
+            static SaveQueue queue;
+            return queue;
+        }
+
+        SaveQueue() = default;
+        SaveQueue(const SaveQueue&) = delete;
+        SaveQueue& operator=(const SaveQueue&) = delete;
+
+        /**
+         * @brief Finishes the waiting writes and joins the thread.
+         */
+        ~SaveQueue() {
+            {
+                std::lock_guard lock(m_mutex);
+                m_stopping = true;
+            }
+            m_wake.notify_all();
+            if (m_thread.joinable()) {
+                m_thread.join();
+            }
+        }
+
+        /**
+         * @brief Queues `write` to produce the file at `path`.
+         *
+         * If a write to the same path is still waiting, `write` takes its place.
+         *
+         * @param path The file the write produces; only used to coalesce writes.
+         * @param write The write; runs on the queue thread and must not touch state the caller may change.
+         * @return A future that becomes ready when the file is written; `get()` rethrows what `write` threw.
+         */
+        std::future<void> submit(std::string path, std::function<void()> write) {
+            std::promise<void> promise;
+            std::future<void> future = promise.get_future();
+            {
+                std::lock_guard lock(m_mutex);
+                const auto waiting = std::ranges::find(m_waiting, path, &Job::path);
+                if (waiting != m_waiting.end()) {
+                    waiting->write = std::move(write);
+                    waiting->promises.push_back(std::move(promise));
+                } else {
+                    Job& job = m_waiting.emplace_back(Job{std::move(path), std::move(write), {}});
+                    job.promises.push_back(std::move(promise));
+                }
+                if (!m_thread.joinable()) {
+                    m_thread = std::thread([this] { run(); });
+                }
+            }
+            m_wake.notify_one();
+            return future;
+        }
+
+        /**
+         * @brief Blocks until every write submitted so far has finished.
+         */
+        void drain() {
+            std::unique_lock lock(m_mutex);
+            m_idle.wait(lock, [this] { return m_waiting.empty() && !m_writing; });
+        }
+
+    private:
+        struct Job {
+            std::string path;
+            std::function<void()> write;
+            std::vector<std::promise<void>> promises;
+        };
+
+        void run() {
+            std::unique_lock lock(m_mutex);
+            while (true) {
+                m_wake.wait(lock, [this] { return m_stopping || !m_waiting.empty(); });
+                if (m_waiting.empty()) break;
+                Job job = std::move(m_waiting.front());
+                m_waiting.pop_front();
+                m_writing = true;
+                lock.unlock();
+
+                std::exception_ptr error;
+                try {
+                    job.write();
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                for (auto& promise : job.promises) {
+                    if (error) {
+                        promise.set_exception(error);
+                    } else {
+                        promise.set_value();
+                    }
+                }
+
+                lock.lock();
+                m_writing = false;
+                m_idle.notify_all();
+            }
+        }
+
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_idle;
+        std::deque<Job> m_waiting;
+        bool m_writing = false;
+        bool m_stopping = false;
+        std::thread m_thread;
+    };
+}
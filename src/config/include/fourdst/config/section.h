@@ -0,0 +1,258 @@
+/**
+ * @file section.h
+ * @brief `Section<U>` fields, loaded from their own TOML file on first access.
+ *
+ * A `Section<U>` member is written in the deck as the path of another TOML file, relative to the
+ * deck's directory (the working directory for decks loaded from memory). Loading the deck only records the path; the file is parsed, deserialized into
+ * `U` and validated against its schema the first time `get()` is called:
+ *
+ * @code
+ * struct PhysicsConfig {
+ *     bool diffusion = true;
+ *     fourdst::config::Section<OpacityTables> opacities;
+ * };
+ * @endcode
+ * @code
+ * [main.physics]
+ * diffusion = true
+ * opacities = "tables/opacity.toml"   # the top-level keys of this file are the fields of OpacityTables
+ * @endcode
+ *
+ * Deserialized sections are kept in a process-wide `SectionCache` keyed by canonical path, type,
+ * modification time and size, so configs sharing a section file deserialize it once, and a field
+ * loaded after the file changes reads the new contents. The first read of a field happens exactly
+ * once even if several threads call `get()` concurrently, and copies of a field share its value.
+ *
+ * Section files may use `__include` directives and contain `Section` fields of their own, whose
+ * paths are relative to the section file. Saving, JSON and the binary cache write the path, not
+ * the contents; two fields are equal when they name the same file.
+ */
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/file_cache.h"
+#include "fourdst/config/fragments.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+#include "rfl/toml.hpp"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config::io {
+
+    namespace detail {
+        inline const std::filesystem::path*& section_directory_slot() {
+            thread_local const std::filesystem::path* directory = nullptr;
+            return directory;
+        }
+    }
+
+    /**
+     * @brief Resolves the paths of `Section` fields read on the current thread against `directory`
+     *        for the lifetime of the guard.
+     */
+    class ScopedSectionDirectory {
+    public:
+        explicit ScopedSectionDirectory(std::filesystem::path directory)
+            : m_directory(std::move(directory)), m_previous(detail::section_directory_slot()) {
+            detail::section_directory_slot() = &m_directory;
+        }
+
+        ScopedSectionDirectory(const ScopedSectionDirectory&) = delete;
+        ScopedSectionDirectory& operator=(const ScopedSectionDirectory&) = delete;
+
+        ~ScopedSectionDirectory() { detail::section_directory_slot() = m_previous; }
+
+    private:
+        std::filesystem::path m_directory;
+        const std::filesystem::path* m_previous;
+    };
+
+    /**
+     * @brief Returns `path` resolved against the directory installed by `ScopedSectionDirectory`, if any.
+     */
+    inline std::filesystem::path resolve_section_path(const std::string& path) {
+        const std::filesystem::path* directory = detail::section_directory_slot();
+        if (directory == nullptr || path.empty() || std::filesystem::path(path).is_absolute()) return path;
+        return *directory / path;
+    }
+
+    /**
+     * @brief Process-wide cache of deserialized section files.
+     *
+     * An entry is reused while the file's modification time and size are unchanged (see
+     * `StampedFileCache`). All member functions are thread-safe; parsing and deserialization
+     * happen outside the lock.
+     */
+    class SectionCache {
+    public:
+        /**
+         * @brief Returns the process-wide cache.
+         */
+        static SectionCache& instance() {
+            static SectionCache cache;
+            return cache;
+        }
+
+        /**
+         * @brief Returns the contents of the section file at `path` as a `U`, reading it if it is not
+         *        cached or has changed.
+         * @throws exceptions::ConfigLoadError If the file does not exist.
+         * @throws exceptions::ConfigParseError If the file is not valid TOML or does not match `U`.
+         */
+        template <typename U>
+        std::shared_ptr<const U> get(const std::filesystem::path& path) {
+            return std::static_pointer_cast<const U>(
+                m_files.get(path, [](const std::filesystem::path& canonical) { return read<U>(canonical); }, std::type_index(typeid(U))));
+        }
+
+        /**
+         * @brief Drops all cached sections; fields already loaded keep their values.
+         */
+        void clear() { m_files.clear(); }
+
+        /**
+         * @brief Returns the number of cached sections.
+         */
+        [[nodiscard]] std::size_t size() const { return m_files.size(); }
+
+    private:
+        template <typename U>
+        static std::shared_ptr<const U> read(const std::filesystem::path& path) {
+            const std::string file = path.string();
+            toml::table document = parse_document(file);
+
+            const ScopedSectionDirectory directory(path.parent_path());
+            rfl::Result<U> result = rfl::toml::read<U>(&document);
+            if (result) return std::make_shared<const U>(std::move(result).value());
+
+            std::vector<validate::ValidationIssue> issues;
+            validate::ConfigValidator<U>::validate(&document, "", issues);
+            if (issues.empty()) {
+                throw exceptions::ConfigParseError(
+                    std::format("Failed to load config section from file: {}. Reason: {}", file, result.error().what()));
+            }
+            const validate::ValidationIssue& first = issues.front();
+            throw exceptions::ConfigParseError(
+                std::format("Failed to load config section from file: {}. Found {} problem(s):{}",
+                            file,
+                            issues.size(),
+                            validate::summarize_issues(issues)),
+                {first.file.empty() ? file : first.file, first.line, first.column, first.path}
+            );
+        }
+
+        StampedFileCache<void, std::type_index> m_files{"Config section file"};
+    };
+}
+
+namespace fourdst::config {
+
+    /**
+     * @brief A field naming a TOML file that holds a `U`, read on first access.
+     * @tparam U The value type, a struct read from the top-level table of the file.
+     */
+    template <typename U>
+    class Section {
+    public:
+        using value_type = U;
+
+        /**
+         * @brief Names no file; `get()` throws until a path is assigned.
+         */
+        Section() : Section(std::string{}) {}
+
+        /**
+         * @brief Names the file at `path`, relative to the working directory unless a deck is being loaded.
+         */
+        Section(std::string path)  // NOLINT(google-explicit-constructor)
+            : m_path(std::move(path)), m_state(std::make_shared<State>()) {
+            m_state->file = io::resolve_section_path(m_path);
+        }
+
+        Section(const char* path) : Section(std::string(path)) {}  // NOLINT(google-explicit-constructor)
+
+        /**
+         * @brief The path as written in the deck.
+         */
+        [[nodiscard]] const std::string& path() const { return m_path; }
+
+        /**
+         * @brief The file the path resolves to.
+         */
+        [[nodiscard]] const std::filesystem::path& file() const { return m_state->file; }
+
+        /**
+         * @brief Returns the contents of the file, reading them on the first call.
+         * @throws exceptions::ConfigLoadError If the field names no file or the file does not exist.
+         * @throws exceptions::ConfigParseError If the file is not valid TOML or does not match `U`.
+         */
+        const U& get() const {
+            std::call_once(m_state->once, [state = m_state.get()] {
+                try {
+                    if (state->file.empty()) {
+                        throw exceptions::ConfigLoadError("Config section field names no file.");
+                    }
+                    state->value = io::SectionCache::instance().get<U>(state->file);
+                } catch (...) {
+                    state->error = std::current_exception();
+                }
+                state->loaded.store(true, std::memory_order_release);
+            });
+            if (m_state->error) std::rethrow_exception(m_state->error);
+            return *m_state->value;
+        }
+
+        const U& operator*() const { return get(); }
+        const U* operator->() const { return &get(); }
+
+        /**
+         * @brief Whether the file has been read (or failed to).
+         */
+        [[nodiscard]] bool is_loaded() const { return m_state->loaded.load(std::memory_order_acquire); }
+
+        friend bool operator==(const Section& lhs, const Section& rhs) {
+            return lhs.m_state == rhs.m_state || lhs.file() == rhs.file();
+        }
+
+    private:
+        struct State {
+            std::once_flag once;
+            std::atomic<bool> loaded = false;
+            std::filesystem::path file;
+            std::shared_ptr<const U> value;
+            std::exception_ptr error;
+        };
+
+        std::string m_path;
+        std::shared_ptr<State> m_state;
+    };
+}
+
+namespace rfl {
+
+    /**
+     * @brief Reads and writes `Section<U>` as its path in every format.
+     */
+    template <typename U>
+    struct Reflector<fourdst::config::Section<U>> {
+        using ReflType = std::string;
+
+        static fourdst::config::Section<U> to(const ReflType& path) { return fourdst::config::Section<U>(path); }
+
+        static ReflType from(const fourdst::config::Section<U>& section) { return section.path(); }
+    };
+}
@@ -0,0 +1,85 @@
+/**
+ * @file seqlock.h
+ * @brief An inline, seqlock-protected copy of the published content of small trivially copyable schemas.
+ *
+ * For a schema made only of numbers, bools, enums and fixed-size arrays, copying the whole
+ * content is cheaper than sharing it: `Config::copy()` and `ConfigReader::copy()` read a
+ * consistent `T` from a sequence-locked copy kept next to the published snapshot, with no
+ * allocation and no reference count, so readers on many cores never write to a shared cache line.
+ *
+ * The writer bumps the sequence to an odd value, stores the words of the content, then bumps it
+ * to the next even value. A reader copies the words between two loads of the sequence and
+ * retries if the sequence was odd or changed in between. The words are relaxed atomics, so a
+ * torn read is discarded rather than being a data race.
+ *
+ * Only schemas up to `seqlock_max_bytes` use it; larger ones would make readers retry more often
+ * than a snapshot load costs.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace fourdst::config::detail {
+
+    /// The largest schema kept in a seqlock, in bytes.
+    inline constexpr std::size_t seqlock_max_bytes = 256;
+
+    /// Whether `Config<T>` keeps a seqlock-protected copy of its content.
+    template <typename T>
+    constexpr bool is_seqlock_eligible_v = std::is_trivially_copyable_v<T> && sizeof(T) <= seqlock_max_bytes;
+
+    /**
+     * @brief A sequence-locked copy of a `T`; empty for schemas that are not eligible.
+     *
+     * `store()` must be called by one writer at a time; `load()` may run on any number of threads.
+     */
+    template <typename T, bool = is_seqlock_eligible_v<T>>
+    class Seqlock {
+    public:
+        void store(const T&) noexcept {}
+    };
+
+    template <typename T>
+    class Seqlock<T, true> {
+    public:
+        void store(const T& value) noexcept {
+            Words words{};
+            std::memcpy(words.data(), &value, sizeof(T));
+            const std::uint64_t sequence = m_sequence.load(std::memory_order_relaxed);
+            m_sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (std::size_t i = 0; i < word_count; ++i) {
+                m_words[i].store(words[i], std::memory_order_relaxed);
+            }
+            m_sequence.store(sequence + 2, std::memory_order_release);
+        }
+
+        [[nodiscard]] T load() const noexcept {
+            Words words;
+            while (true) {
+                const std::uint64_t before = m_sequence.load(std::memory_order_acquire);
+                if (before & 1) continue;
+                for (std::size_t i = 0; i < word_count; ++i) {
+                    words[i] = m_words[i].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (m_sequence.load(std::memory_order_relaxed) == before) break;
+            }
+            T value;
+            std::memcpy(&value, words.data(), sizeof(T));
+            return value;
+        }
+
+    private:
+        static constexpr std::size_t word_count = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+        using Words = std::array<std::uint64_t, word_count>;
+
+        std::atomic<std::uint64_t> m_sequence{0};
+        std::array<std::atomic<std::uint64_t>, word_count> m_words{};
+    };
+}
@@ -0,0 +1,374 @@
+/**
+ * @file shard.h
+ * @brief `Sharded<V>` fields, tables of per-rank (or per-key) entries of which a load reads only its own.
+ *
+ * A `Sharded<V>` member holds one `V` per string key, typically an MPI rank:
+ *
+ * @code
+ * struct DecompositionConfig {
+ *     fourdst::config::Sharded<std::vector<double>> boundaries;
+ * };
+ * @endcode
+ *
+ * In a hand-written deck it is an ordinary table, `[main.boundaries]` with one key per shard.
+ * `save()` writes it instead to a shard file next to the deck, one line per shard, and leaves a
+ * reference holding the byte range of every shard:
+ *
+ * @code
+ * [main]
+ * boundaries = { __shards = "run.toml.boundaries.shards.toml", index = { 0 = [0, 412], 1 = [412, 409] } }
+ * @endcode
+ *
+ * With a shard selector set (`Config::set_shard_selector()`), a load keeps only the selected
+ * keys: entries of a table are skipped before they are deserialized, and from a shard file only
+ * the selected byte ranges are read and parsed, so each rank's cost grows with its own data.
+ * A field loaded that way reports `is_partial()` and cannot be saved, which would drop the other
+ * shards. The shard file is itself a valid TOML document keyed the same way.
+ *
+ * Only fields reached through plain nested structs of streamable schemas get shard files; others
+ * are written as tables. JSON and the binary cache write every entry as a table.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/io.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+#include "rfl/toml.hpp"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config::io {
+
+    /// The reserved key marking a reference to a shard file.
+    inline constexpr std::string_view shards_key = "__shards";
+}
+
+namespace fourdst::config {
+
+    /**
+     * @brief A table of `V` values keyed by shard (e.g. rank), of which a load may read only some.
+     * @tparam V The value of one shard.
+     */
+    template <typename V>
+    class Sharded {
+    public:
+        using value_type = V;
+        using map_type = std::map<std::string, V>;
+
+        /// The reserved key of a reference to a shard file.
+        static constexpr std::string_view reference_key = io::shards_key;
+
+        Sharded() = default;
+
+        /**
+         * @brief Holds every shard in `entries`.
+         */
+        Sharded(map_type entries) : m_entries(std::move(entries)) {}  // NOLINT(google-explicit-constructor)
+
+        /**
+         * @brief Holds `entries`, the shards a load selected out of a larger set.
+         */
+        static Sharded selected(map_type entries) {
+            Sharded sharded(std::move(entries));
+            sharded.m_partial = true;
+            return sharded;
+        }
+
+        /**
+         * @brief Returns the shard `key`, or null if it is not held.
+         */
+        [[nodiscard]] const V* find(const std::string& key) const {
+            const auto it = m_entries.find(key);
+            return it == m_entries.end() ? nullptr : &it->second;
+        }
+
+        /**
+         * @brief Returns the shard `key`.
+         * @throws std::out_of_range If it is not held.
+         */
+        [[nodiscard]] const V& at(const std::string& key) const { return m_entries.at(key); }
+
+        [[nodiscard]] bool contains(const std::string& key) const { return m_entries.contains(key); }
+
+        /**
+         * @brief Returns the shard `key`, adding a default one if it is not held.
+         */
+        V& operator[](const std::string& key) { return m_entries[key]; }
+
+        [[nodiscard]] std::size_t size() const { return m_entries.size(); }
+
+        /**
+         * @brief The shards held, by key.
+         */
+        [[nodiscard]] const map_type& entries() const { return m_entries; }
+
+        /**
+         * @brief Whether the field was loaded with a shard selector and so holds only some shards.
+         */
+        [[nodiscard]] bool is_partial() const { return m_partial; }
+
+        friend bool operator==(const Sharded& lhs, const Sharded& rhs)
+            requires std::equality_comparable<V>
+        {
+            return lhs.m_partial == rhs.m_partial && lhs.m_entries == rhs.m_entries;
+        }
+
+    private:
+        map_type m_entries;
+        bool m_partial = false;
+    };
+}
+
+namespace fourdst::config::io {
+
+    /// The keys of the shards a load keeps.
+    using ShardSelector = std::vector<std::string>;
+
+    namespace detail {
+        struct ShardRead {
+            const ShardSelector* selector;
+            std::filesystem::path directory;
+        };
+
+        inline const ShardRead*& shard_read_slot() {
+            thread_local const ShardRead* read = nullptr;
+            return read;
+        }
+
+        inline bool shard_selected(const ShardRead* read, const std::string_view key) {
+            if (read == nullptr || read->selector == nullptr) return true;
+            return std::ranges::find(*read->selector, key) != read->selector->end();
+        }
+
+        /**
+         * @brief Throws if `value` holds only the shards a load selected.
+         */
+        template <typename V>
+        void require_all_shards(const Sharded<V>& value) {
+            if (value.is_partial()) {
+                throw exceptions::ConfigSaveError(
+                    "Cannot save a sharded field loaded with a shard selector; it holds only the selected shards.");
+            }
+        }
+    }
+
+    /**
+     * @brief Sets the shard selector and the directory of shard files for `Sharded` fields read on
+     *        the current thread, for the lifetime of the guard.
+     */
+    class ScopedShardRead {
+    public:
+        /**
+         * @brief Installs `selector` (null keeps every shard) and `directory`, which shard file names are relative to.
+         */
+        ScopedShardRead(const ShardSelector* selector, std::filesystem::path directory)
+            : m_read{selector, std::move(directory)}, m_previous(detail::shard_read_slot()) {
+            detail::shard_read_slot() = &m_read;
+        }
+
+        ScopedShardRead(const ScopedShardRead&) = delete;
+        ScopedShardRead& operator=(const ScopedShardRead&) = delete;
+
+        ~ScopedShardRead() { detail::shard_read_slot() = m_previous; }
+
+    private:
+        detail::ShardRead m_read;
+        const detail::ShardRead* m_previous;
+    };
+
+    /**
+     * @brief Writes shard files for one save and produces the references left in the TOML.
+     */
+    class ShardWriter {
+    public:
+        /**
+         * @brief One shard: its TOML key, quoted if needed, and the line `key = <value>` holding it.
+         */
+        struct Shard {
+            std::string key;
+            std::string text;
+        };
+
+        /**
+         * @brief Creates a writer for the shard files of the TOML file `toml_path`.
+         * @param toml_path The TOML file being saved; shard files are written next to it.
+         * @param durable Whether to sync each shard file to storage before it replaces an older one.
+         */
+        ShardWriter(const std::string_view toml_path, const bool durable)
+            : m_directory(std::filesystem::path(toml_path).parent_path()),
+              m_stem(std::filesystem::path(toml_path).filename().string()),
+              m_durable(durable) {}
+
+        /**
+         * @brief Writes `shards` to the shard file of `field_path`, in order.
+         * @param field_path Dotted path of the field below the root table.
+         * @param shards The shards.
+         * @return The inline TOML table referencing the file.
+         * @throws exceptions::ConfigSaveError If the file cannot be written.
+         */
+        std::string write(const std::string_view field_path, const std::vector<Shard>& shards) {
+            const std::string name = std::format("{}.{}.shards.toml", m_stem, field_path);
+            std::string reference = std::format("{{ {} = \"{}\", index = {{", shards_key, name);
+            AtomicFileSink sink((m_directory / name).string(), m_durable);
+            std::uint64_t offset = 0;
+            bool first = true;
+            for (const Shard& shard : shards) {
+                sink.write(shard.text);
+                reference += std::format("{}{} = [{}, {}]", first ? " " : ", ", shard.key, offset, shard.text.size());
+                first = false;
+                offset += shard.text.size();
+            }
+            sink.commit();
+            reference += shards.empty() ? "} }" : " } }";
+            return reference;
+        }
+
+    private:
+        std::filesystem::path m_directory;
+        std::string m_stem;
+        bool m_durable;
+    };
+}
+
+namespace rfl {
+
+    /**
+     * @brief Reads and writes `Sharded<V>` as a table of every shard in formats without shard files.
+     */
+    template <typename V>
+    struct Reflector<fourdst::config::Sharded<V>> {
+        using ReflType = typename fourdst::config::Sharded<V>::map_type;
+
+        static fourdst::config::Sharded<V> to(const ReflType& entries) { return fourdst::config::Sharded<V>(entries); }
+
+        static ReflType from(const fourdst::config::Sharded<V>& value) {
+            fourdst::config::io::detail::require_all_shards(value);
+            return value.entries();
+        }
+    };
+}
+
+namespace rfl::parsing {
+
+    /**
+     * @brief Reads `Sharded<V>` from a TOML table or shard file reference, keeping the selected shards.
+     */
+    template <class V, class ProcessorsType>
+    struct Parser<rfl::toml::Reader, rfl::toml::Writer, fourdst::config::Sharded<V>, ProcessorsType> {
+        using InputVarType = typename rfl::toml::Reader::InputVarType;
+        using ShardedType = fourdst::config::Sharded<V>;
+        using MapType = typename ShardedType::map_type;
+        using ValueParser = Parser<rfl::toml::Reader, rfl::toml::Writer, std::remove_cvref_t<V>, ProcessorsType>;
+        using MapParser = Parser<rfl::toml::Reader, rfl::toml::Writer, MapType, ProcessorsType>;
+
+        static Result<ShardedType> read(const rfl::toml::Reader& _r, const InputVarType& _var) noexcept {
+            ::toml::table* table = _var->as_table();
+            if (table == nullptr) return error("Could not cast to a table!");
+            const auto* shard_read = fourdst::config::io::detail::shard_read_slot();
+            try {
+                MapType entries;
+                std::vector<Error> errors;
+                if (table->contains(ShardedType::reference_key)) {
+                    read_file(_r, *table, shard_read, entries, errors);
+                } else {
+                    for (auto& [key, node] : *table) {
+                        if (!fourdst::config::io::detail::shard_selected(shard_read, key.str())) continue;
+                        add(_r, key.str(), node, entries, errors);
+                    }
+                }
+                if (!errors.empty()) return error(to_single_error_message(errors));
+                if (shard_read != nullptr && shard_read->selector != nullptr) return ShardedType::selected(std::move(entries));
+                return ShardedType(std::move(entries));
+            } catch (const std::exception& e) {
+                return error(e.what());
+            }
+        }
+
+        template <class P>
+        static void write(const rfl::toml::Writer& _w, const ShardedType& _sharded, const P& _parent) {
+            fourdst::config::io::detail::require_all_shards(_sharded);
+            MapParser::write(_w, _sharded.entries(), _parent);
+        }
+
+        static schema::Type to_schema(std::map<std::string, schema::Type>* _definitions) {
+            return MapParser::to_schema(_definitions);
+        }
+
+    private:
+        static void add(const rfl::toml::Reader& _r, const std::string_view key, ::toml::node& node, MapType& entries,
+                        std::vector<Error>& errors) {
+            auto value = ValueParser::read(_r, &node);
+            if (!value) {
+                errors.emplace_back("Failed to parse field '" + std::string(key) + "': " + value.error().what());
+                return;
+            }
+            entries.emplace_hint(entries.end(), std::string(key), std::move(*value));
+        }
+
+        /// Reads the selected byte ranges of the shard file `reference` names, parsing each on its own.
+        static void read_file(const rfl::toml::Reader& _r, const ::toml::table& reference, const fourdst::config::io::detail::ShardRead* shard_read,
+                              MapType& entries, std::vector<Error>& errors) {
+            const auto name = reference[ShardedType::reference_key].value<std::string>();
+            const ::toml::table* index = reference["index"].as_table();
+            if (!name || index == nullptr) {
+                errors.emplace_back(std::format("A shard file reference needs a string '{}' and an 'index' table.", ShardedType::reference_key));
+                return;
+            }
+            const std::filesystem::path path = shard_read != nullptr ? shard_read->directory / *name : std::filesystem::path(*name);
+            std::ifstream in(path, std::ios::binary);
+            if (!in) {
+                errors.emplace_back(std::format("Shard file does not exist: {}", path.string()));
+                return;
+            }
+            const std::uint64_t file_size = std::filesystem::file_size(path);
+
+            std::string slice;
+            for (const auto& [key, range] : *index) {
+                if (!fourdst::config::io::detail::shard_selected(shard_read, key.str())) continue;
+                const ::toml::array* bounds = range.as_array();
+                const auto offset = bounds != nullptr && bounds->size() == 2 ? (*bounds)[0].value<std::int64_t>() : std::nullopt;
+                const auto length = bounds != nullptr && bounds->size() == 2 ? (*bounds)[1].value<std::int64_t>() : std::nullopt;
+                if (!offset || !length || *offset < 0 || *length < 0 ||
+                    static_cast<std::uint64_t>(*offset) + static_cast<std::uint64_t>(*length) > file_size) {
+                    errors.emplace_back(std::format("Shard '{}' of {} has no valid [offset, length] range.", key.str(), path.string()));
+                    continue;
+                }
+                slice.resize(static_cast<std::size_t>(*length));
+                in.seekg(*offset);
+                in.read(slice.data(), *length);
+                if (!in) {
+                    errors.emplace_back(std::format("Failed to read shard '{}' of {}.", key.str(), path.string()));
+                    return;
+                }
+                ::toml::table shard;
+                try {
+                    shard = ::toml::parse(slice, path.string());
+                } catch (const ::toml::parse_error& e) {
+                    errors.emplace_back(std::format("Shard '{}' of {} is not valid TOML: {}", key.str(), path.string(), e.description()));
+                    continue;
+                }
+                ::toml::node* node = shard.get(key.str());
+                if (node == nullptr) {
+                    errors.emplace_back(std::format("Shard '{}' of {} does not hold its key.", key.str(), path.string()));
+                    continue;
+                }
+                add(_r, key.str(), *node, entries, errors);
+            }
+        }
+    };
+}
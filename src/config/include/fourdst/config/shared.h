@@ -0,0 +1,731 @@
+/**
+ * @file shared.h
+ * @brief One read-only copy of a config per node, in a POSIX shared memory segment.
+ *
+ * `SharedConfig<T>` lets every process on a node read the same copy of a large config. One
+ * process loads the file and copies the content into a shared memory segment; the others map
+ * the segment read-only instead of parsing the file themselves, so the node holds one copy and
+ * opening costs a few system calls.
+ *
+ * @code
+ * // On the first rank of each node:
+ * auto shared = fourdst::config::SharedConfig<RateTables>::create("/rates.job42", "rates.toml");
+ * // On the other ranks:
+ * auto shared = fourdst::config::SharedConfig<RateTables>::open("/rates.job42");
+ * use(shared->reactions);
+ * @endcode
+ *
+ * With MPI, `SharedConfig::load_node()` does both in one collective call.
+ *
+ * Heap-allocated fields must use `std::pmr::string` and `std::pmr::vector`, which the copy
+ * allocates from the segment (see `shm::is_shareable_v`). The containers keep plain pointers,
+ * so every process maps the segment at the address its creator did; the creator picks a
+ * currently unused address derived from the segment name. A process that already has something
+ * mapped there cannot open the segment.
+ *
+ * The shared content is read-only: the pages are mapped without write access, and the
+ * allocator of the containers refers to the creator's process. Copying a field out of the shared
+ * content is fine; the copy allocates from the default resource.
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/base.h"
+#include "fourdst/config/binary.h"
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define FOURDST_CONFIG_HAS_POSIX_SHM 1
+#else
+#define FOURDST_CONFIG_HAS_POSIX_SHM 0
+#endif
+
+#if FOURDST_CONFIG_USE_MPI
+#include <mpi.h>
+#endif
+
+namespace fourdst::config::shm {
+
+    namespace detail {
+        template <typename Type>
+        struct shareable;
+
+        template <typename Type>
+        constexpr bool is_shareable_v = shareable<std::remove_cvref_t<Type>>::value;
+
+        template <typename Fields>
+        struct shareable_fields;
+
+        template <typename... Fields>
+        struct shareable_fields<rfl::Tuple<Fields...>> : std::bool_constant<(is_shareable_v<typename Fields::Type> && ...)> {};
+
+        template <typename T> struct is_pmr_vector_impl : std::false_type {};
+        template <typename E> struct is_pmr_vector_impl<std::pmr::vector<E>> : std::true_type {};
+        template <typename Type> constexpr bool is_pmr_vector_v = is_pmr_vector_impl<std::remove_cvref_t<Type>>::value;
+
+        template <typename Type>
+        struct shareable {
+            static constexpr bool compute() {
+                if constexpr (std::is_arithmetic_v<Type> || std::is_enum_v<Type> || std::is_same_v<Type, std::pmr::string>) {
+                    return true;
+                } else if constexpr (is_pmr_vector_v<Type> || validate::is_optional_v<Type> || validate::is_std_array_v<Type>) {
+                    return is_shareable_v<typename Type::value_type>;
+                } else if constexpr (validate::is_reflectable_struct_v<Type> && std::is_aggregate_v<Type>) {
+                    return shareable_fields<typename rfl::named_tuple_t<Type>::Fields>::value;
+                } else {
+                    return false;
+                }
+            }
+            static constexpr bool value = compute();
+        };
+
+        /**
+         * @brief Returns a deep copy of `value` whose containers allocate from `resource`.
+         */
+        template <typename V>
+        V copy_into(const V& value, std::pmr::memory_resource* resource) {
+            if constexpr (std::is_trivially_copyable_v<V>) {
+                return value;
+            } else if constexpr (std::is_same_v<V, std::pmr::string>) {
+                return std::pmr::string(value, resource);
+            } else if constexpr (is_pmr_vector_v<V>) {
+                V copy(resource);
+                copy.reserve(value.size());
+                for (const auto& element : value) copy.push_back(copy_into(element, resource));
+                return copy;
+            } else if constexpr (validate::is_optional_v<V>) {
+                if (!value) return V{};
+                return V(std::in_place, copy_into(*value, resource));
+            } else if constexpr (validate::is_std_array_v<V>) {
+                return [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+                    return V{copy_into(value[Is], resource)...};
+                }(std::make_index_sequence<std::tuple_size_v<V>>{});
+            } else {
+                using Fields = typename rfl::named_tuple_t<V>::Fields;
+                const auto values = rfl::to_view(value).values();
+                return [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                    return V{copy_into(*rfl::get<Is>(values), resource)...};
+                }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+            }
+        }
+
+        /**
+         * @brief Forwards to the default resource and adds up an upper bound of what a monotonic arena would need.
+         */
+        class CountingResource final : public std::pmr::memory_resource {
+        public:
+            [[nodiscard]] std::size_t bytes() const noexcept { return m_bytes; }
+
+        private:
+            void* do_allocate(const std::size_t bytes, const std::size_t alignment) override {
+                m_bytes += bytes + alignment;
+                return std::pmr::get_default_resource()->allocate(bytes, alignment);
+            }
+
+            void do_deallocate(void* p, const std::size_t bytes, const std::size_t alignment) override {
+                std::pmr::get_default_resource()->deallocate(p, bytes, alignment);
+            }
+
+            [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+                return this == &other;
+            }
+
+            std::size_t m_bytes = 0;
+        };
+
+        /// Lifecycle of a segment, stored in its header.
+        enum SegmentState : std::uint32_t { BUILDING = 0, READY = 1, FAILED = 2 };
+
+        /**
+         * @brief The start of every segment; the content follows at `content_offset`.
+         */
+        struct SegmentHeader {
+            std::uint64_t magic;
+            std::uint64_t fingerprint;
+            std::uint64_t content_size;
+            std::uint64_t content_offset;
+            std::uint64_t size;
+            std::uint64_t address;
+            /// In the first segment, the latest published generation; in the others, their own.
+            std::atomic<std::uint64_t> generation;
+            std::atomic<std::uint32_t> state;
+        };
+
+        inline constexpr std::uint64_t segment_magic = 0x6D68732D67666334ULL;
+
+        /// First address tried for new segments, far from where heaps and shared libraries are placed.
+        inline constexpr std::uintptr_t segment_region = std::uintptr_t{0x200000000000};
+        inline constexpr std::uintptr_t segment_stride = std::uintptr_t{1} << 36;
+        inline constexpr int segment_attempts = 64;
+
+        inline std::string segment_name(const std::string_view name) {
+            return name.starts_with('/') ? std::string(name) : std::format("/{}", name);
+        }
+
+        inline std::size_t align_up(const std::size_t value, const std::size_t alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        inline std::size_t page_size() {
+#if FOURDST_CONFIG_HAS_POSIX_SHM
+            static const std::size_t size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+            return size;
+#else
+            return 4096;
+#endif
+        }
+
+        /// Name of the segment holding generation `generation` of the config shared as `name`.
+        inline std::string version_name(const std::string_view name, const std::uint64_t generation) {
+            return generation == 0 ? segment_name(name) : std::format("{}.{}", segment_name(name), generation);
+        }
+
+#if FOURDST_CONFIG_HAS_POSIX_SHM
+        /**
+         * @brief Maps `size` bytes of `fd` at exactly `address`, or returns null if that range is taken.
+         */
+        inline void* map_at(void* address, const std::size_t size, const int protection, const int fd) {
+#if defined(MAP_FIXED_NOREPLACE)
+            void* mapped = ::mmap(address, size, protection, MAP_SHARED | MAP_FIXED_NOREPLACE, fd, 0);
+#else
+            void* mapped = ::mmap(address, size, protection, MAP_SHARED, fd, 0);
+#endif
+            if (mapped == MAP_FAILED) return nullptr;
+            if (mapped != address) {
+                ::munmap(mapped, size);
+                return nullptr;
+            }
+            return mapped;
+        }
+#endif
+    }
+
+    /**
+     * @brief Whether every field of `T` can live in a shared segment.
+     *
+     * Arithmetic values, enums, `std::pmr::string`, and `std::pmr::vector`, `std::optional`,
+     * `std::array` and structs of such values qualify. `std::string`, `std::vector` and maps do
+     * not, since they allocate from the process heap.
+     */
+    template <typename T>
+    constexpr bool is_shareable_v = validate::is_reflectable_struct_v<T> && detail::is_shareable_v<T>;
+
+    /**
+     * @brief A mapped POSIX shared memory segment; unmapped on destruction, and unlinked by its creator.
+     */
+    class Segment {
+    public:
+        Segment() = default;
+
+        Segment(Segment&& other) noexcept
+            : m_name(std::move(other.m_name)),
+              m_address(std::exchange(other.m_address, nullptr)),
+              m_size(std::exchange(other.m_size, 0)),
+              m_owner(std::exchange(other.m_owner, false)) {}
+
+        Segment& operator=(Segment&& other) noexcept {
+            if (this != &other) {
+                reset();
+                m_name = std::move(other.m_name);
+                m_address = std::exchange(other.m_address, nullptr);
+                m_size = std::exchange(other.m_size, 0);
+                m_owner = std::exchange(other.m_owner, false);
+            }
+            return *this;
+        }
+
+        Segment(const Segment&) = delete;
+        Segment& operator=(const Segment&) = delete;
+
+        ~Segment() { reset(); }
+
+        /**
+         * @brief Creates the segment `name` with `size` writable bytes, replacing a stale one of the same name.
+         * @throws exceptions::ConfigLoadError If the segment cannot be created or mapped.
+         */
+        static Segment create(const std::string_view name, const std::size_t size) {
+            Segment segment;
+            segment.m_name = detail::segment_name(name);
+#if FOURDST_CONFIG_HAS_POSIX_SHM
+            int fd = ::shm_open(segment.m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+            if (fd < 0 && errno == EEXIST) {
+                // Left behind by a run that did not shut down cleanly.
+                ::shm_unlink(segment.m_name.c_str());
+                fd = ::shm_open(segment.m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+            }
+            if (fd < 0) {
+                throw exceptions::ConfigLoadError(
+                    std::format("Failed to create shared config segment {}: {}", segment.m_name, std::strerror(errno)));
+            }
+            segment.m_owner = true;
+            if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+                const int error = errno;
+                ::close(fd);
+                throw exceptions::ConfigLoadError(
+                    std::format("Failed to size shared config segment {} to {} bytes: {}", segment.m_name, size, std::strerror(error)));
+            }
+            const std::uintptr_t first_slot = io::hash_bytes(segment.m_name) % detail::segment_attempts;
+            for (int attempt = 0; attempt < detail::segment_attempts && segment.m_address == nullptr; ++attempt) {
+                const std::uintptr_t slot = (first_slot + attempt) % detail::segment_attempts;
+                void* address = reinterpret_cast<void*>(detail::segment_region + slot * detail::segment_stride);
+                segment.m_address = detail::map_at(address, size, PROT_READ | PROT_WRITE, fd);
+            }
+            ::close(fd);
+            if (segment.m_address == nullptr) {
+                throw exceptions::ConfigLoadError(
+                    std::format("Failed to map shared config segment {}: no free address range of {} bytes.", segment.m_name, size));
+            }
+            segment.m_size = size;
+            return segment;
+#else
+            (void)size;
+            throw exceptions::ConfigLoadError(
+                std::format("Cannot create shared config segment {}: POSIX shared memory is not available on this platform.", segment.m_name));
+#endif
+        }
+
+        /**
+         * @brief Maps the segment `name` read-only at the address its creator used, once it is ready.
+         * @param timeout How long to wait for the segment to appear and be filled.
+         * @throws exceptions::ConfigLoadError On timeout, if the creator failed, or if the address is taken here.
+         */
+        static Segment open(const std::string_view name, const std::chrono::milliseconds timeout) {
+            Segment segment;
+            segment.m_name = detail::segment_name(name);
+#if FOURDST_CONFIG_HAS_POSIX_SHM
+            const auto deadline = std::chrono::steady_clock::now() + timeout;
+            const auto wait_or_throw = [&](const std::string_view reason) {
+                if (std::chrono::steady_clock::now() >= deadline) {
+                    throw exceptions::ConfigLoadError(
+                        std::format("Timed out waiting for shared config segment {}: {}", segment.m_name, reason));
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            };
+
+            while (true) {
+                const int fd = ::shm_open(segment.m_name.c_str(), O_RDONLY, 0);
+                if (fd < 0) {
+                    wait_or_throw("it does not exist");
+                    continue;
+                }
+                struct stat status {};
+                if (::fstat(fd, &status) != 0 || static_cast<std::size_t>(status.st_size) < sizeof(detail::SegmentHeader)) {
+                    ::close(fd);
+                    wait_or_throw("it is still being created");
+                    continue;
+                }
+                void* peek = ::mmap(nullptr, sizeof(detail::SegmentHeader), PROT_READ, MAP_SHARED, fd, 0);
+                if (peek == MAP_FAILED) {
+                    const int error = errno;
+                    ::close(fd);
+                    throw exceptions::ConfigLoadError(
+                        std::format("Failed to map shared config segment {}: {}", segment.m_name, std::strerror(error)));
+                }
+                const auto* header = static_cast<const detail::SegmentHeader*>(peek);
+                const std::uint32_t state = header->state.load(std::memory_order_acquire);
+                const std::uint64_t address = header->address;
+                const std::uint64_t size = header->size;
+                ::munmap(peek, sizeof(detail::SegmentHeader));
+                if (state == detail::FAILED) {
+                    ::close(fd);
+                    throw exceptions::ConfigLoadError(
+                        std::format("The creator of shared config segment {} failed to fill it.", segment.m_name));
+                }
+                if (state != detail::READY) {
+                    ::close(fd);
+                    wait_or_throw("it is still being filled");
+                    continue;
+                }
+
+                segment.m_address = detail::map_at(reinterpret_cast<void*>(address), size, PROT_READ, fd);
+                ::close(fd);
+                if (segment.m_address == nullptr) {
+                    throw exceptions::ConfigLoadError(std::format(
+                        "Failed to map shared config segment {} at {:#x}: the address range is in use in this process.",
+                        segment.m_name, address));
+                }
+                segment.m_size = size;
+                return segment;
+            }
+#else
+            (void)timeout;
+            throw exceptions::ConfigLoadError(
+                std::format("Cannot open shared config segment {}: POSIX shared memory is not available on this platform.", segment.m_name));
+#endif
+        }
+
+        /**
+         * @brief Makes the pages of a created segment from `offset` (a multiple of the page size) on read-only.
+         */
+        void seal(const std::size_t offset) const noexcept {
+#if FOURDST_CONFIG_HAS_POSIX_SHM
+            if (m_address != nullptr && offset < m_size) ::mprotect(data() + offset, m_size - offset, PROT_READ);
+#else
+            (void)offset;
+#endif
+        }
+
+        [[nodiscard]] std::byte* data() const noexcept { return static_cast<std::byte*>(m_address); }
+        [[nodiscard]] std::size_t size() const noexcept { return m_size; }
+        [[nodiscard]] const std::string& name() const noexcept { return m_name; }
+        [[nodiscard]] bool owner() const noexcept { return m_owner; }
+
+    private:
+        void reset() noexcept {
+#if FOURDST_CONFIG_HAS_POSIX_SHM
+            if (m_address != nullptr) ::munmap(m_address, m_size);
+            if (m_owner) ::shm_unlink(m_name.c_str());
+#endif
+            m_address = nullptr;
+            m_size = 0;
+            m_owner = false;
+        }
+
+        std::string m_name;
+        void* m_address = nullptr;
+        std::size_t m_size = 0;
+        bool m_owner = false;
+    };
+}
+
+namespace fourdst::config {
+
+    /**
+     * @brief Read-only content of a `Config<T>` shared by all processes of a node.
+     *
+     * The process that calls `create()` owns the segment and removes its name when the
+     * `SharedConfig` is destroyed; processes that mapped it before then keep their mapping.
+     *
+     * The owner can `publish()` new content at any time, e.g. from a `Config::subscribe()`
+     * callback after a reload or `mutate()`. Each publication goes to a segment of its own and
+     * then increments a generation counter in the header of the first segment, which the other
+     * processes watch: `stale()` is a single atomic load, and `refresh()` maps the latest
+     * generation. Content obtained before a refresh stays valid as long as a `snapshot()` of it is
+     * held, so readers never see a half-written update and updates never wait for readers.
+     *
+     * A `SharedConfig` object is not synchronized: `refresh()` and `publish()` must not run
+     * concurrently with other uses of the same object. Give other threads a `snapshot()`.
+     *
+     * @tparam T The configuration schema type; must satisfy `shm::is_shareable_v`.
+     *
+     * @par Examples
+     * @code
+     * // Each step on every rank of the node:
+     * if (tuning.stale()) tuning.refresh();
+     * apply(tuning->controller);
+     * @endcode
+     */
+    template <IsConfigSchema T>
+    class SharedConfig {
+        static_assert(shm::is_shareable_v<T>,
+                      "SharedConfig<T> needs std::pmr::string and std::pmr::vector in place of std::string and std::vector, and no maps.");
+
+    public:
+        SharedConfig(SharedConfig&&) noexcept = default;
+        SharedConfig& operator=(SharedConfig&&) noexcept = default;
+
+        /**
+         * @brief Copies the current content of `config` into a new segment named `name`.
+         *
+         * The segment is sized exactly for the content and made read-only once it is filled.
+         *
+         * @param name The POSIX shared memory name; a leading `/` is added if missing.
+         * @param config The config whose content is shared.
+         * @throws exceptions::ConfigLoadError If the segment cannot be created.
+         */
+        static SharedConfig create(const std::string_view name, const Config<T>& config) {
+            SharedConfig shared;
+            shared.m_name = std::string(name);
+            shared.m_primary = build(shm::detail::version_name(name, 0), *config.snapshot(), 0);
+            shared.m_current = shared.m_primary;
+            return shared;
+        }
+
+        /**
+         * @brief Loads `path` and copies the content into a new segment named `name`; see `create(name, config)`.
+         * @throws exceptions::ConfigLoadError If the file or the segment cannot be created.
+         * @throws exceptions::ConfigParseError If the file content is invalid.
+         */
+        static SharedConfig create(const std::string_view name, const std::string_view path, const bool verbose = false) {
+            Config<T> config;
+            config.load(path, verbose);
+            return create(name, config);
+        }
+
+        /**
+         * @brief Maps the segment `name` read-only, waiting for its creator to fill it, and refreshes to the latest generation.
+         * @param name The name passed to `create()`.
+         * @param timeout How long to wait for the segment to appear and be filled.
+         * @throws exceptions::ConfigLoadError On timeout, or if the segment was built from a different layout of `T`.
+         */
+        static SharedConfig open(const std::string_view name, const std::chrono::milliseconds timeout = std::chrono::seconds(60)) {
+            SharedConfig shared;
+            shared.m_name = std::string(name);
+            shared.m_primary = map(shm::detail::version_name(name, 0), timeout);
+            shared.m_current = shared.m_primary;
+            shared.refresh();
+            return shared;
+        }
+
+#if FOURDST_CONFIG_USE_MPI
+        /**
+         * @brief Loads `path` once per node and maps the result on every rank of `comm`.
+         *
+         * Collective over `comm`. The first rank of each node (in `MPI_COMM_TYPE_SHARED` order)
+         * creates the segment, the others open it; every rank returns once all ranks on its node
+         * have mapped it. `name` must be unique among the jobs that may share a node, e.g. by
+         * containing the job id. The first rank of the node owns the result and may `publish()`.
+         *
+         * @throws exceptions::ConfigLoadError If any rank on the node fails to create or map the segment.
+         * @throws exceptions::ConfigParseError On the creating rank, if the file content is invalid.
+         *
+         * @par Examples
+         * @code
+         * auto rates = fourdst::config::SharedConfig<RateTables>::load_node(MPI_COMM_WORLD, "/rates.job42", "rates.toml");
+         * @endcode
+         */
+        static SharedConfig load_node(MPI_Comm comm, const std::string_view name, const std::string_view path, const bool verbose = false) {
+            MPI_Comm node = MPI_COMM_NULL;
+            MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &node);
+            int rank = 0;
+            MPI_Comm_rank(node, &rank);
+
+            std::optional<SharedConfig> shared;
+            int created = 1;
+            if (rank == 0) {
+                try {
+                    shared.emplace(create(name, path, verbose));
+                } catch (...) {
+                    created = 0;
+                    MPI_Bcast(&created, 1, MPI_INT, 0, node);
+                    MPI_Comm_free(&node);
+                    throw;
+                }
+            }
+            MPI_Bcast(&created, 1, MPI_INT, 0, node);
+            if (created == 0) {
+                MPI_Comm_free(&node);
+                throw exceptions::ConfigLoadError(
+                    std::format("The first rank on this node failed to create shared config segment {}.", name));
+            }
+
+            int mapped = 1;
+            std::string error;
+            if (rank != 0) {
+                try {
+                    shared.emplace(open(name));
+                } catch (const std::exception& e) {
+                    // Every rank must reach the reduction, whatever went wrong, or the node hangs.
+                    mapped = 0;
+                    error = e.what();
+                } catch (...) {
+                    mapped = 0;
+                }
+            }
+            // The creator must not remove the name before every rank on the node has mapped it.
+            MPI_Allreduce(MPI_IN_PLACE, &mapped, 1, MPI_INT, MPI_MIN, node);
+            MPI_Comm_free(&node);
+            if (mapped == 0) {
+                throw exceptions::ConfigLoadError(error.empty()
+                    ? std::format("A rank on this node failed to map shared config segment {}.", name)
+                    : error);
+            }
+            return std::move(*shared);
+        }
+#endif
+
+        /**
+         * @brief Shares the current content of `config` as the next generation.
+         *
+         * The content is copied into a new segment first; the generation counter is advanced only
+         * once that segment is complete. The segment of the generation before (unless it is the
+         * first) is removed, so processes that have not mapped it yet skip to the new one.
+         *
+         * @param config The config whose content is shared.
+         * @return The new generation.
+         * @throws exceptions::ConfigLoadError If this process is not the owner, or the segment cannot be created.
+         */
+        std::uint64_t publish(const Config<T>& config) {
+            if (!owner()) {
+                throw exceptions::ConfigLoadError(
+                    std::format("Cannot publish to shared config segment {}: only the process that created it can.", name()));
+            }
+            const std::uint64_t next = m_generation + 1;
+            // Built while the current generation is still mapped, so the two never share an address.
+            m_current = build(shm::detail::version_name(m_name, next), *config.snapshot(), next);
+            m_generation = next;
+            primary_header().generation.store(next, std::memory_order_release);
+            return next;
+        }
+
+        /**
+         * @brief Returns the latest generation published by the owner; one atomic load.
+         */
+        [[nodiscard]] std::uint64_t latest_generation() const noexcept {
+            return primary_header().generation.load(std::memory_order_acquire);
+        }
+
+        /**
+         * @brief Returns the generation this object currently reads.
+         */
+        [[nodiscard]] std::uint64_t generation() const noexcept { return m_generation; }
+
+        /**
+         * @brief Returns whether the owner has published a generation newer than the one read here.
+         */
+        [[nodiscard]] bool stale() const noexcept { return latest_generation() != m_generation; }
+
+        /**
+         * @brief Maps the latest generation if it is newer than the one read here.
+         *
+         * References obtained through `get()` before the call are invalidated when the
+         * generation changes; snapshots are not.
+         *
+         * @return True if a newer generation was mapped.
+         * @throws exceptions::ConfigLoadError If the latest generation cannot be mapped.
+         */
+        bool refresh() {
+            std::uint64_t latest = latest_generation();
+            while (latest != m_generation) {
+                try {
+                    m_current = latest == 0 ? m_primary : map(shm::detail::version_name(m_name, latest), std::chrono::milliseconds(0));
+                    m_generation = latest;
+                    return true;
+                } catch (const exceptions::ConfigLoadError&) {
+                    // The owner removes a generation once it publishes the next; retry with that one.
+                    const std::uint64_t newer = latest_generation();
+                    if (newer == latest) throw;
+                    latest = newer;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * @brief Returns the shared content of the current generation.
+         */
+        [[nodiscard]] const T& get() const noexcept { return *content(*m_current); }
+
+        [[nodiscard]] const T& operator*() const noexcept { return get(); }
+
+        [[nodiscard]] const T* operator->() const noexcept { return &get(); }
+
+        /**
+         * @brief Returns the content of the current generation, kept mapped as long as the pointer lives.
+         */
+        [[nodiscard]] std::shared_ptr<const T> snapshot() const {
+            return std::shared_ptr<const T>(m_current, content(*m_current));
+        }
+
+        /**
+         * @brief Returns whether this process created the segment.
+         */
+        [[nodiscard]] bool owner() const noexcept { return m_primary->owner(); }
+
+        /**
+         * @brief Returns the mapped size of the segment of the current generation in bytes.
+         */
+        [[nodiscard]] std::size_t segment_size() const noexcept { return m_current->size(); }
+
+        /**
+         * @brief Returns the POSIX shared memory name of the first segment.
+         */
+        [[nodiscard]] const std::string& name() const noexcept { return m_primary->name(); }
+
+    private:
+        SharedConfig() = default;
+
+        static std::uint64_t fingerprint() {
+            return io::content_fingerprint<T>();
+        }
+
+        static const shm::detail::SegmentHeader& header(const shm::Segment& segment) {
+            return *reinterpret_cast<const shm::detail::SegmentHeader*>(segment.data());
+        }
+
+        static const T* content(const shm::Segment& segment) {
+            return reinterpret_cast<const T*>(segment.data() + header(segment).content_offset);
+        }
+
+        /**
+         * @brief Creates the segment `segment_name` holding a copy of `content` as generation `generation`.
+         */
+        static std::shared_ptr<const shm::Segment> build(const std::string_view segment_name, const T& content,
+                                                         const std::uint64_t generation) {
+            shm::detail::CountingResource counter;
+            (void)shm::detail::copy_into(content, &counter);
+            // The content starts on its own page, so the header stays writable once the rest is sealed.
+            const std::size_t content_offset = shm::detail::align_up(sizeof(shm::detail::SegmentHeader),
+                                                                     std::max(alignof(T), shm::detail::page_size()));
+            const std::size_t arena_offset = shm::detail::align_up(content_offset + sizeof(T), alignof(std::max_align_t));
+            const std::size_t size = arena_offset + counter.bytes();
+
+            auto segment = std::make_shared<shm::Segment>(shm::Segment::create(segment_name, size));
+            auto* header = new (segment->data()) shm::detail::SegmentHeader{
+                shm::detail::segment_magic, fingerprint(), sizeof(T), content_offset, size,
+                reinterpret_cast<std::uintptr_t>(segment->data()), {generation}, {shm::detail::BUILDING}};
+            try {
+                std::pmr::monotonic_buffer_resource arena(segment->data() + arena_offset, size - arena_offset,
+                                                          std::pmr::null_memory_resource());
+                new (segment->data() + content_offset) T(shm::detail::copy_into(content, &arena));
+            } catch (const std::bad_alloc&) {
+                header->state.store(shm::detail::FAILED, std::memory_order_release);
+                throw exceptions::ConfigLoadError(
+                    std::format("Shared config segment {} is too small for the content.", segment->name()));
+            }
+            header->state.store(shm::detail::READY, std::memory_order_release);
+            segment->seal(content_offset);
+            return segment;
+        }
+
+        /**
+         * @brief Maps the segment `segment_name` and checks that it holds a `T` of this layout.
+         */
+        static std::shared_ptr<const shm::Segment> map(const std::string_view segment_name, const std::chrono::milliseconds timeout) {
+            auto segment = std::make_shared<const shm::Segment>(shm::Segment::open(segment_name, timeout));
+            const shm::detail::SegmentHeader& header = SharedConfig::header(*segment);
+            if (header.magic != shm::detail::segment_magic || header.fingerprint != fingerprint() ||
+                header.content_size != sizeof(T)) {
+                throw exceptions::ConfigLoadError(std::format(
+                    "Shared config segment {} was built with a different layout of the schema.", segment->name()));
+            }
+            return segment;
+        }
+
+        /// The header of the first segment, whose generation counter is written by the owner only.
+        shm::detail::SegmentHeader& primary_header() const noexcept {
+            return *reinterpret_cast<shm::detail::SegmentHeader*>(m_primary->data());
+        }
+
+        std::string m_name;
+        std::shared_ptr<const shm::Segment> m_primary;
+        std::shared_ptr<const shm::Segment> m_current;
+        std::uint64_t m_generation = 0;
+    };
+}
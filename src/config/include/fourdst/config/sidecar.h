@@ -0,0 +1,393 @@
+/**
+ * @file sidecar.h
+ * @brief Sidecar `.npy` files for large numeric arrays referenced from a TOML config.
+ *
+ * With a sidecar threshold set (see `Config::set_sidecar_threshold()`), `save()` writes every
+ * `std::vector` of arithmetic values with at least that many elements to its own NumPy `.npy`
+ * file next to the TOML file, and leaves a reference in its place:
+ *
+ * @code
+ * [main.grid]
+ * label = "fine"
+ * values = { __sidecar = "run.toml.grid.values.npy", length = 4000000, checksum = "9c1f0e4d2b7a6f35" }
+ * @endcode
+ *
+ * On load, references are replaced by empty arrays before deserialization, and each sidecar is
+ * then memory-mapped, checked against its element type, length and checksum, and copied into
+ * its field in one block. The files are ordinary `.npy` (version 1.0, native byte order), so
+ * NumPy and other tools can read them directly. Small fields stay in the TOML file.
+ *
+ * `Tensor` fields get sidecars the same way; their reference and file also record the shape:
+ * `table = { __sidecar = "run.toml.table.npy", length = 12, shape = [3, 4], checksum = "..." }`.
+ *
+ * Only vectors reached through plain nested structs have sidecars; vectors inside optionals,
+ * maps or arrays of tables are always written inline.
+ */
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "fourdst/config/binary.h"
+#include "fourdst/config/compare.h"
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/io.h"
+#include "fourdst/config/tensor.h"
+#include "fourdst/config/validate.h"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config::io {
+
+    /// The reserved key marking a sidecar reference.
+    inline constexpr std::string_view sidecar_key = "__sidecar";
+
+    /// Vectors that can be stored in a sidecar.
+    template <typename Type>
+    constexpr bool is_sidecar_array_v = [] {
+        if constexpr (validate::is_vector_v<Type>) {
+            using Element = typename std::remove_cvref_t<Type>::value_type;
+            return std::is_arithmetic_v<Element> && !std::is_same_v<Element, bool>;
+        } else {
+            return false;
+        }
+    }();
+
+    namespace detail {
+        inline constexpr std::string_view npy_magic = "\x93NUMPY";
+
+        /**
+         * @brief Returns the NumPy dtype descriptor of `Element` in native byte order, e.g. `<f8`.
+         */
+        template <typename Element>
+        std::string npy_descr() {
+            const char order = sizeof(Element) == 1 ? '|' : (std::endian::native == std::endian::little ? '<' : '>');
+            const char kind = std::is_floating_point_v<Element> ? 'f' : (std::is_signed_v<Element> ? 'i' : 'u');
+            return std::format("{}{}{}", order, kind, sizeof(Element));
+        }
+
+        /**
+         * @brief The parts of a `.npy` file needed to load an array.
+         */
+        struct NpyArray {
+            std::string_view descr;
+            /// The extent of each dimension.
+            std::vector<std::uint64_t> shape;
+            /// The number of elements, the product of `shape`.
+            std::uint64_t length = 0;
+            std::string_view data;
+        };
+
+        /**
+         * @brief Parses the header of a C-ordered `.npy` file.
+         * @throws exceptions::ConfigParseError If the file is not such an array.
+         */
+        inline NpyArray parse_npy(const std::string_view bytes, const std::string_view path) {
+            auto fail = [&](const std::string_view reason) {
+                return exceptions::ConfigParseError(std::format("Invalid sidecar array file: {}. Reason: {}", path, reason));
+            };
+            if (bytes.size() < 10 || !bytes.starts_with(npy_magic)) throw fail("not a .npy file");
+            const auto major = static_cast<unsigned char>(bytes[6]);
+            std::size_t header_length = 0;
+            std::size_t offset = 0;
+            if (major == 1) {
+                header_length = static_cast<unsigned char>(bytes[8]) | (static_cast<std::size_t>(static_cast<unsigned char>(bytes[9])) << 8);
+                offset = 10;
+            } else if (major == 2 || major == 3) {
+                if (bytes.size() < 12) throw fail("truncated header");
+                for (int i = 3; i >= 0; --i) header_length = (header_length << 8) | static_cast<unsigned char>(bytes[8 + i]);
+                offset = 12;
+            } else {
+                throw fail("unsupported .npy version");
+            }
+            if (bytes.size() < offset + header_length) throw fail("truncated header");
+            const std::string_view header = bytes.substr(offset, header_length);
+
+            auto value_of = [&](const std::string_view key) {
+                const std::size_t at = header.find(key);
+                if (at == std::string_view::npos) throw fail(std::format("header has no {}", key));
+                return header.substr(at + key.size());
+            };
+            NpyArray array;
+            std::string_view descr = value_of("'descr':");
+            descr.remove_prefix(std::min(descr.find('\''), descr.size()));
+            const std::size_t descr_end = descr.find('\'', 1);
+            if (descr_end == std::string_view::npos) throw fail("malformed descr");
+            array.descr = descr.substr(1, descr_end - 1);
+
+            if (!value_of("'fortran_order':").substr(0, 7).contains("False")) throw fail("Fortran-ordered arrays are not supported");
+
+            std::string_view shape = value_of("'shape':");
+            shape.remove_prefix(std::min(shape.find('('), shape.size()));
+            if (!shape.starts_with("(")) throw fail("malformed shape");
+            shape.remove_prefix(1);
+            array.length = 1;
+            while (!shape.starts_with(")")) {
+                std::uint64_t extent = 0;
+                const auto [end, ec] = std::from_chars(shape.data(), shape.data() + shape.size(), extent);
+                if (ec != std::errc{}) throw fail("malformed shape");
+                shape.remove_prefix(static_cast<std::size_t>(end - shape.data()));
+                if (shape.starts_with(",")) shape.remove_prefix(1);
+                while (shape.starts_with(" ")) shape.remove_prefix(1);
+                array.shape.push_back(extent);
+                array.length *= extent;
+            }
+            if (array.shape.empty()) throw fail("zero-dimensional arrays are not supported");
+            array.data = bytes.substr(offset + header_length);
+            return array;
+        }
+
+        inline std::uint64_t parse_checksum(const std::string_view text) {
+            std::uint64_t value = 0;
+            const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value, 16);
+            if (ec != std::errc{} || end != text.data() + text.size()) {
+                throw exceptions::ConfigParseError(std::format("Invalid sidecar checksum '{}'.", text));
+            }
+            return value;
+        }
+    }
+
+    /**
+     * @brief Writes sidecar files for one save and produces the references left in the TOML.
+     */
+    class SidecarWriter {
+    public:
+        /**
+         * @brief Creates a writer for the sidecars of the TOML file `toml_path`.
+         * @param toml_path The TOML file being saved; sidecars are written next to it.
+         * @param threshold Minimum number of elements for an array to get a sidecar.
+         * @param durable Whether to sync each sidecar to storage before it replaces an older one.
+         */
+        SidecarWriter(const std::string_view toml_path, const std::size_t threshold, const bool durable)
+            : m_directory(std::filesystem::path(toml_path).parent_path()),
+              m_stem(std::filesystem::path(toml_path).filename().string()),
+              m_threshold(threshold),
+              m_durable(durable) {}
+
+        /**
+         * @brief Whether an array of `length` elements goes to a sidecar.
+         */
+        [[nodiscard]] bool wants(const std::size_t length) const { return m_threshold != 0 && length >= m_threshold; }
+
+        /**
+         * @brief Writes `values` to the sidecar of `field_path`.
+         * @param field_path Dotted path of the field below the root table.
+         * @param values The array.
+         * @return The inline TOML table referencing the sidecar.
+         * @throws exceptions::ConfigSaveError If the sidecar cannot be written.
+         */
+        template <typename Element, typename Allocator>
+        std::string write(const std::string_view field_path, const std::vector<Element, Allocator>& values) {
+            const std::string name = std::format("{}.{}.npy", m_stem, field_path);
+            const std::string_view data(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(Element));
+            write_npy(name, detail::npy_descr<Element>(), std::format("({},)", values.size()), data);
+            return std::format("{{ {} = \"{}\", length = {}, checksum = \"{:016x}\" }}",
+                               sidecar_key, name, values.size(), hash_bytes(data));
+        }
+
+        /**
+         * @brief Writes `values` to the sidecar of `field_path` as an array of the same shape.
+         * @param field_path Dotted path of the field below the root table.
+         * @param values The tensor.
+         * @return The inline TOML table referencing the sidecar.
+         * @throws exceptions::ConfigSaveError If the sidecar cannot be written.
+         */
+        template <typename Element, std::size_t Rank>
+        std::string write(const std::string_view field_path, const Tensor<Element, Rank>& values) {
+            const std::string name = std::format("{}.{}.npy", m_stem, field_path);
+            const std::string_view data(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(Element));
+            std::string shape;
+            for (const std::size_t extent : values.extents()) {
+                shape += shape.empty() ? "" : ", ";
+                shape += std::to_string(extent);
+            }
+            write_npy(name, detail::npy_descr<Element>(), std::format("({}{})", shape, Rank == 1 ? "," : ""), data);
+            return std::format("{{ {} = \"{}\", length = {}, shape = [{}], checksum = \"{:016x}\" }}",
+                               sidecar_key, name, values.size(), shape, hash_bytes(data));
+        }
+
+    private:
+        void write_npy(const std::string& name, const std::string_view descr, const std::string_view shape, const std::string_view data) {
+            std::string header = std::format("{{'descr': '{}', 'fortran_order': False, 'shape': {}, }}", descr, shape);
+            // Pad so the data starts on a 64-byte boundary, as the format recommends.
+            const std::size_t unpadded = detail::npy_magic.size() + 4 + header.size() + 1;
+            header.append((64 - unpadded % 64) % 64, ' ');
+            header += '\n';
+            const std::uint16_t header_length = static_cast<std::uint16_t>(header.size());
+            const char preamble[4] = {1, 0, static_cast<char>(header_length & 0xff), static_cast<char>(header_length >> 8)};
+
+            AtomicFileSink sink((m_directory / name).string(), m_durable);
+            sink.write(detail::npy_magic);
+            sink.write(std::string_view(preamble, 4));
+            sink.write(header);
+            sink.write(data);
+            sink.commit();
+        }
+
+        std::filesystem::path m_directory;
+        std::string m_stem;
+        std::size_t m_threshold;
+        bool m_durable;
+    };
+
+    /**
+     * @brief A sidecar reference found in a parsed config.
+     */
+    struct SidecarReference {
+        /// Dotted path of the field below the root table.
+        std::string path;
+        /// The sidecar file.
+        std::string file;
+        /// Number of elements.
+        std::uint64_t length = 0;
+        /// `hash_bytes()` of the array data.
+        std::uint64_t checksum = 0;
+        /// The extent of each dimension, for tensors; empty for one-dimensional arrays.
+        std::vector<std::uint64_t> shape = {};
+    };
+
+    /**
+     * @brief Makes the sidecar file names in `tbl` relative to `directory` instead of the file they appear in.
+     *
+     * Used before merging layers from different directories.
+     */
+    inline void anchor_sidecars(toml::table& tbl, const std::filesystem::path& directory) {
+        for (auto&& [key, node] : tbl) {
+            toml::table* child = node.as_table();
+            if (child == nullptr) continue;
+            if (toml::node* file = child->get(sidecar_key); file != nullptr && file->is_string()) {
+                *file->as_string() = (directory / file->as_string()->get()).string();
+            } else {
+                anchor_sidecars(*child, directory);
+            }
+        }
+    }
+
+    /**
+     * @brief Collects the sidecar references in a root table and replaces each by an empty array.
+     * @param tbl The root table (or a nested table when recursing).
+     * @param directory Directory that relative sidecar file names are resolved against.
+     * @param references Receives the references.
+     * @param prefix Dotted path of `tbl` below the root.
+     * @throws exceptions::ConfigParseError If a reference is malformed.
+     */
+    inline void collect_sidecars(toml::table& tbl, const std::filesystem::path& directory,
+                                 std::vector<SidecarReference>& references, const std::string& prefix = {}) {
+        for (auto&& [key, node] : tbl) {
+            toml::table* child = node.as_table();
+            if (child == nullptr) continue;
+            const std::string path = prefix.empty() ? std::string(key.str()) : std::format("{}.{}", prefix, key.str());
+            const toml::node* file = child->get(sidecar_key);
+            if (file == nullptr) {
+                collect_sidecars(*child, directory, references, path);
+                continue;
+            }
+
+            const toml::node* length = child->get("length");
+            const toml::node* checksum = child->get("checksum");
+            if (!file->is_string() || length == nullptr || !length->is_integer() || length->as_integer()->get() < 0 ||
+                checksum == nullptr || !checksum->is_string()) {
+                throw exceptions::ConfigParseError(std::format(
+                    "Invalid sidecar reference at '{}': expected {{ {} = \"<file>\", length = <n>, checksum = \"<hex>\" }}.",
+                    path, sidecar_key));
+            }
+            std::vector<std::uint64_t> shape;
+            if (const toml::node* extents = child->get("shape"); extents != nullptr) {
+                const toml::array* array = extents->as_array();
+                if (array == nullptr || array->empty()) {
+                    throw exceptions::ConfigParseError(std::format("Invalid sidecar reference at '{}': shape must be a non-empty array.", path));
+                }
+                for (const toml::node& extent : *array) {
+                    if (!extent.is_integer() || extent.as_integer()->get() < 0) {
+                        throw exceptions::ConfigParseError(std::format("Invalid sidecar reference at '{}': shape must hold non-negative integers.", path));
+                    }
+                    shape.push_back(static_cast<std::uint64_t>(extent.as_integer()->get()));
+                }
+            }
+            references.push_back({path, (directory / file->as_string()->get()).string(),
+                                  static_cast<std::uint64_t>(length->as_integer()->get()),
+                                  detail::parse_checksum(checksum->as_string()->get()), std::move(shape)});
+            tbl.insert_or_assign(key.str(), toml::array{});
+        }
+    }
+
+    /**
+     * @brief Reads the sidecars of freshly deserialized content into their fields.
+     * @throws exceptions::ConfigLoadError If a sidecar file is missing.
+     * @throws exceptions::ConfigParseError If a sidecar does not match its field, length or checksum.
+     */
+    template <typename T>
+    void load_sidecars(T& content, const std::vector<SidecarReference>& references) {
+        for (const auto& reference : references) {
+            const bool found = config::detail::visit_at(content, reference.path, [&](auto& field) {
+                using Field = std::remove_cvref_t<decltype(field)>;
+                auto fill = [&](auto& values) {
+                    using Element = typename std::remove_cvref_t<decltype(values)>::value_type;
+                    if (!std::filesystem::exists(reference.file)) {
+                        throw exceptions::ConfigLoadError(std::format("Sidecar array file does not exist: {}", reference.file));
+                    }
+                    const MappedFile mapped(reference.file);
+                    const detail::NpyArray array = detail::parse_npy(mapped.view(), reference.file);
+                    using Values = std::remove_cvref_t<decltype(values)>;
+                    constexpr std::size_t rank = [] {
+                        if constexpr (validate::is_tensor_v<Values>) {
+                            return Values::rank;
+                        } else {
+                            return std::size_t{1};
+                        }
+                    }();
+                    if (array.shape.size() != rank || (!reference.shape.empty() && array.shape != reference.shape)) {
+                        throw exceptions::ConfigParseError(std::format(
+                            "Sidecar array file {} does not match the shape of field '{}' (expected {} dimension(s), found {}).",
+                            reference.file, reference.path, rank, array.shape.size()));
+                    }
+                    if (array.descr != detail::npy_descr<Element>() || array.length != reference.length ||
+                        array.data.size() < array.length * sizeof(Element)) {
+                        throw exceptions::ConfigParseError(std::format(
+                            "Sidecar array file {} does not match field '{}' (expected {} x {}, found {} x {}).",
+                            reference.file, reference.path, reference.length, detail::npy_descr<Element>(), array.length, array.descr));
+                    }
+                    const std::string_view data = array.data.substr(0, array.length * sizeof(Element));
+                    if (hash_bytes(data) != reference.checksum) {
+                        throw exceptions::ConfigParseError(std::format(
+                            "Sidecar array file {} does not match the checksum recorded for field '{}'.", reference.file, reference.path));
+                    }
+                    if constexpr (validate::is_tensor_v<Values>) {
+                        typename Values::extents_type extents{};
+                        std::copy(array.shape.begin(), array.shape.end(), extents.begin());
+                        values.resize(extents);
+                    } else {
+                        values.resize(array.length);
+                    }
+                    std::memcpy(values.data(), data.data(), data.size());
+                };
+                if constexpr (is_sidecar_array_v<Field> || validate::is_tensor_v<Field>) {
+                    fill(field);
+                } else if constexpr (validate::is_optional_v<Field>) {
+                    if constexpr (is_sidecar_array_v<typename Field::value_type> || validate::is_tensor_v<typename Field::value_type>) {
+                        fill(field.emplace());
+                    } else {
+                        throw exceptions::ConfigParseError(
+                            std::format("Field '{}' references a sidecar but is not a numeric array.", reference.path));
+                    }
+                } else {
+                    throw exceptions::ConfigParseError(
+                        std::format("Field '{}' references a sidecar but is not a numeric array.", reference.path));
+                }
+            });
+            if (!found) {
+                throw exceptions::ConfigParseError(
+                    std::format("Sidecar reference at '{}' does not name a field of the config schema.", reference.path));
+            }
+        }
+    }
+}
@@ -0,0 +1,253 @@
+/**
+ * @file sink.h
+ * @brief `Sink<V>` fields, numeric arrays streamed into memory the caller owns.
+ *
+ * The largest tabulated fields of a deck often belong in pinned host memory, a device staging
+ * buffer or an HDF5 dataset rather than in a `std::vector` inside the config. A `Sink<V>` member
+ * reads as an array of `V` like a vector, but a load hands its elements to a `SinkTarget<V>`
+ * registered with `Config::set_sink()` instead of keeping them:
+ *
+ * @code
+ * struct OpacityConfig {
+ *     fourdst::config::Sink<double> kappa;
+ * };
+ *
+ * double* pinned = allocate_pinned(n);
+ * cfg.set_sink<double>("kappa", fourdst::config::sink_into(std::span<double>(pinned, n)));
+ * cfg.load("opacity.toml");  // kappa = [...] is parsed straight into `pinned`
+ * const std::size_t count = cfg->kappa.size();
+ * @endcode
+ *
+ * Arrays long enough for the numeric array fast path (see numeric_array.h) are parsed from the
+ * source text directly into the spans the target hands out, with no vector in between; shorter
+ * arrays, and arrays read by toml++ or from JSON, are read into the field first and streamed to
+ * the target when the load binds it. `sink_chunks()` adapts a callback that takes the elements a
+ * chunk at a time, e.g. to write them to a dataset. If a load falls back from the fast path, the
+ * target receives the array again from offset 0.
+ *
+ * Values assigned other than by a load (`mutate()`, patches) are held by the field itself, as
+ * are the elements of a field no target is registered for. Saving writes the elements read back
+ * from the target (`SinkTarget::view`); a field whose target cannot be read back cannot be
+ * saved. Copies of a field share its target; two bound fields compare equal when they share a
+ * target and have the same size, since the elements themselves belong to the caller.
+ */
+#pragma once
+
+#include <cstddef>
+#include <format>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/exceptions/exceptions.h"
+
+#include "rfl.hpp"
+
+namespace fourdst::config {
+
+    /**
+     * @brief Where a load puts the elements of a `Sink<V>` field.
+     * @tparam V The element type.
+     */
+    template <typename V>
+    struct SinkTarget {
+        /// Returns memory for the elements from `offset` on, which are parsed straight into it; an empty span means the target is full.
+        std::function<std::span<V>(std::size_t offset)> acquire;
+        /// If set, called with each filled part of a span `acquire` returned, in order, with the offset of its first element.
+        std::function<void(std::span<const V> elements, std::size_t offset)> commit;
+        /// If set, returns the first `count` elements written, so the field can be saved.
+        std::function<std::span<const V>(std::size_t count)> view;
+    };
+
+    /**
+     * @brief A target that writes the elements into `buffer`; a longer array fails the load.
+     */
+    template <typename V>
+    SinkTarget<V> sink_into(const std::span<V> buffer) {
+        return {.acquire = [buffer](const std::size_t offset) { return offset < buffer.size() ? buffer.subspan(offset) : std::span<V>{}; },
+                .commit = {},
+                .view = [buffer](const std::size_t count) { return std::span<const V>(buffer.first(count)); }};
+    }
+
+    /**
+     * @brief A target that passes the elements to `consume` in chunks of up to `chunk` elements.
+     *
+     * The chunk buffer is reused, so `consume` must copy what it keeps. The elements cannot be read
+     * back, so a field with this target cannot be saved.
+     */
+    template <typename V>
+    SinkTarget<V> sink_chunks(std::function<void(std::span<const V> elements, std::size_t offset)> consume, const std::size_t chunk = 4096) {
+        auto buffer = std::make_shared<std::vector<V>>(chunk == 0 ? 1 : chunk);
+        return {.acquire = [buffer](std::size_t) { return std::span<V>(*buffer); }, .commit = std::move(consume), .view = {}};
+    }
+
+    /**
+     * @brief A numeric array field whose elements a load streams to a `SinkTarget`.
+     * @tparam V The element type, a number.
+     */
+    template <typename V>
+    class Sink {
+        static_assert(std::is_arithmetic_v<V> && !std::is_same_v<V, bool>, "Sink holds numbers.");
+
+    public:
+        using value_type = V;
+
+        /**
+         * @brief Appends elements to a field: to its target in the spans it hands out, or to the field if it has none.
+         *
+         * `clear()`, `reserve()` and `push_back()` let the array readers fill it like a vector.
+         */
+        class Appender {
+        public:
+            using value_type = V;
+
+            explicit Appender(Sink& sink) : m_sink(sink) { clear(); }
+
+            /// Starts over at offset 0.
+            void clear() {
+                m_sink.m_held.clear();
+                m_sink.m_size = 0;
+                m_offset = 0;
+                m_used = 0;
+                m_span = {};
+            }
+
+            void reserve(const std::size_t count) {
+                if (!m_sink.m_target) m_sink.m_held.reserve(count);
+            }
+
+            /**
+             * @throws exceptions::ConfigLoadError If the target is full.
+             */
+            void push_back(const V value) {
+                if (!m_sink.m_target) {
+                    m_sink.m_held.push_back(value);
+                    return;
+                }
+                if (m_used == m_span.size()) next();
+                m_span[m_used++] = value;
+            }
+
+            /// Hands the last elements to the target and records the size of the field.
+            void finish() {
+                flush();
+                m_sink.m_size = m_sink.m_target ? m_offset : m_sink.m_held.size();
+            }
+
+        private:
+            void flush() {
+                if (m_used != 0 && m_sink.m_target->commit) m_sink.m_target->commit(std::span<const V>(m_span.first(m_used)), m_offset);
+                m_offset += m_used;
+                m_used = 0;
+                m_span = {};
+            }
+
+            void next() {
+                flush();
+                m_span = m_sink.m_target->acquire(m_offset);
+                if (m_span.empty()) {
+                    throw exceptions::ConfigLoadError(std::format("Sink target is full after {} elements.", m_offset));
+                }
+            }
+
+            Sink& m_sink;
+            std::span<V> m_span;
+            std::size_t m_used = 0;
+            std::size_t m_offset = 0;
+        };
+
+        /**
+         * @brief Holds no elements.
+         */
+        Sink() = default;
+
+        /**
+         * @brief Holds `values` itself, until a target is bound.
+         */
+        Sink(std::vector<V> values) : m_held(std::move(values)), m_size(m_held.size()) {}  // NOLINT(google-explicit-constructor)
+
+        /**
+         * @brief Returns the number of elements, whether the field or its target holds them.
+         */
+        [[nodiscard]] std::size_t size() const noexcept { return m_size; }
+
+        [[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+
+        /**
+         * @brief Whether the elements were streamed to a target.
+         */
+        [[nodiscard]] bool is_bound() const noexcept { return m_target != nullptr; }
+
+        /**
+         * @brief Returns the elements the field holds itself: all of them if it is not bound, none once it is.
+         */
+        [[nodiscard]] std::span<const V> held() const noexcept { return m_held; }
+
+        /**
+         * @brief Returns the elements, held or read back from the target, or `std::nullopt` if the target cannot be read back.
+         */
+        [[nodiscard]] std::optional<std::span<const V>> elements() const {
+            if (!m_target) return std::span<const V>(m_held);
+            if (!m_target->view) return std::nullopt;
+            return m_target->view(m_size);
+        }
+
+        /**
+         * @brief Streams the held elements to `target`, which receives later loads of the field too.
+         * @throws exceptions::ConfigLoadError If the target is full.
+         */
+        void bind(std::shared_ptr<const SinkTarget<V>> target) {
+            std::vector<V> held = std::move(m_held);
+            m_target = std::move(target);
+            Appender out(*this);
+            for (const V value : held) out.push_back(value);
+            out.finish();
+        }
+
+        friend bool operator==(const Sink& lhs, const Sink& rhs) {
+            return lhs.m_target == rhs.m_target && lhs.m_size == rhs.m_size && lhs.m_held == rhs.m_held;
+        }
+
+    private:
+        std::vector<V> m_held;
+        std::size_t m_size = 0;
+        std::shared_ptr<const SinkTarget<V>> m_target;
+    };
+}
+
+namespace rfl::parsing {
+
+    /**
+     * @brief Reads and writes `Sink<V>` as an array of `V`; elements are held until the load binds the target.
+     */
+    template <class R, class W, class V, class ProcessorsType>
+        requires AreReaderAndWriter<R, W, fourdst::config::Sink<V>>
+    struct Parser<R, W, fourdst::config::Sink<V>, ProcessorsType> {
+        using InputVarType = typename R::InputVarType;
+        using VectorParser = Parser<R, W, std::vector<V>, ProcessorsType>;
+        using Sink = fourdst::config::Sink<V>;
+
+        static Result<Sink> read(const R& _r, const InputVarType& _var) noexcept {
+            return VectorParser::read(_r, _var).transform([](std::vector<V>&& values) { return Sink(std::move(values)); });
+        }
+
+        template <class P>
+        static void write(const W& _w, const Sink& _sink, const P& _parent) {
+            const auto elements = _sink.elements();
+            if (!elements) {
+                throw fourdst::config::exceptions::ConfigSaveError("Cannot write a Sink field whose target cannot be read back.");
+            }
+            VectorParser::write(_w, std::vector<V>(elements->begin(), elements->end()), _parent);
+        }
+
+        static schema::Type to_schema(std::map<std::string, schema::Type>* _definitions) {
+            return VectorParser::to_schema(_definitions);
+        }
+    };
+}
@@ -0,0 +1,290 @@
+/**
+ * @file soa.h
+ * @brief `SoA<std::vector<S>>` fields, stored as one contiguous column per member of `S`.
+ *
+ * Kernels that sweep an array of tables but only touch one or two members per pass waste most
+ * of each cache line on a `std::vector<S>`. A `SoA<std::vector<S>>` member holds the same rows
+ * as one `std::vector` per member of `S` and hands out spans over them:
+ *
+ * @code
+ * struct NetworkConfig {
+ *     fourdst::config::SoA<std::vector<ReactionRate>> rates;
+ * };
+ *
+ * std::span<const double> q = cfg->rates.column<"q_value">();
+ * @endcode
+ *
+ * In files the field is indistinguishable from a `std::vector<S>`: TOML arrays of tables are
+ * read row by row straight into the columns, and `save()`, `save_schema()` and the other
+ * formats write and describe it as an array of `S`. `bool` members are stored as
+ * `std::uint8_t`, since `std::vector<bool>` has no contiguous storage to view.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <initializer_list>
+#include <iterator>
+#include <map>
+#include <span>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+#include "rfl/toml.hpp"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config {
+
+    namespace detail {
+        template <typename Member>
+        using soa_element_t = std::conditional_t<std::is_same_v<Member, bool>, std::uint8_t, Member>;
+
+        template <typename Fields>
+        struct soa_columns;
+
+        template <typename... Fields>
+        struct soa_columns<rfl::Tuple<Fields...>> {
+            using type = std::tuple<std::vector<soa_element_t<typename Fields::Type>>...>;
+        };
+    }
+
+    /**
+     * @brief A sequence of structs stored column by column; only `SoA<std::vector<S>>` is defined.
+     */
+    template <typename Container>
+    class SoA;
+
+    /**
+     * @brief The rows of a `std::vector<S>`, stored as one contiguous column per member of `S`.
+     * @tparam S The row type, a default-constructible aggregate with at least one member.
+     */
+    template <typename S>
+    class SoA<std::vector<S>> {
+        using Fields = typename rfl::named_tuple_t<S>::Fields;
+        static constexpr int column_count = rfl::tuple_size_v<Fields>;
+
+        static_assert(std::is_aggregate_v<S> && std::is_default_constructible_v<S>,
+                      "SoA rows must be default-constructible aggregates.");
+        static_assert(column_count > 0, "SoA rows must have at least one member.");
+
+        template <rfl::internal::StringLiteral name>
+        static constexpr int index_of = rfl::internal::find_index<name, Fields>();
+
+    public:
+        using value_type = S;
+        using size_type = std::size_t;
+        /// One `std::vector` per member of `S`, in declaration order.
+        using Columns = typename detail::soa_columns<Fields>::type;
+        /// The element type of the column of member `name`.
+        template <rfl::internal::StringLiteral name>
+        using element_type = typename std::tuple_element_t<index_of<name>, Columns>::value_type;
+
+        /**
+         * @brief Iterates over the rows, assembling each one on dereference.
+         */
+        class const_iterator {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = S;
+            using difference_type = std::ptrdiff_t;
+            using reference = S;
+
+            const_iterator() = default;
+
+            S operator*() const { return m_owner->row(m_index); }
+
+            const_iterator& operator++() {
+                ++m_index;
+                return *this;
+            }
+
+            const_iterator operator++(int) {
+                const_iterator previous = *this;
+                ++m_index;
+                return previous;
+            }
+
+            bool operator==(const const_iterator& other) const { return m_index == other.m_index; }
+
+        private:
+            friend class SoA;
+
+            const_iterator(const SoA* owner, const std::size_t index) : m_owner(owner), m_index(index) {}
+
+            const SoA* m_owner = nullptr;
+            std::size_t m_index = 0;
+        };
+
+        SoA() = default;
+
+        /**
+         * @brief Splits `rows` into columns.
+         */
+        SoA(const std::vector<S>& rows) {  // NOLINT(google-explicit-constructor)
+            reserve(rows.size());
+            for (const S& row : rows) push_back(row);
+        }
+
+        SoA(const std::initializer_list<S> rows) {
+            reserve(rows.size());
+            for (const S& row : rows) push_back(row);
+        }
+
+        [[nodiscard]] std::size_t size() const { return std::get<0>(m_columns).size(); }
+        [[nodiscard]] bool empty() const { return size() == 0; }
+
+        void reserve(const std::size_t rows) {
+            std::apply([rows](auto&... column) { (column.reserve(rows), ...); }, m_columns);
+        }
+
+        void clear() {
+            std::apply([](auto&... column) { (column.clear(), ...); }, m_columns);
+        }
+
+        /**
+         * @brief Appends `row`, moving each member into its column.
+         */
+        void push_back(S row) {
+            auto view = rfl::to_view(row);
+            [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                (std::get<Is>(m_columns).push_back(std::move(*rfl::get<Is>(view.values()))), ...);
+            }(std::make_integer_sequence<int, column_count>{});
+        }
+
+        /**
+         * @brief Assembles row `index` from the columns.
+         */
+        [[nodiscard]] S row(const std::size_t index) const {
+            S result{};
+            auto view = rfl::to_view(result);
+            [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                ((*rfl::get<Is>(view.values()) =
+                      static_cast<std::remove_cvref_t<decltype(*rfl::get<Is>(view.values()))>>(std::get<Is>(m_columns)[index])),
+                 ...);
+            }(std::make_integer_sequence<int, column_count>{});
+            return result;
+        }
+
+        S operator[](const std::size_t index) const { return row(index); }
+
+        /**
+         * @brief Assembles all rows into a `std::vector<S>`.
+         */
+        [[nodiscard]] std::vector<S> to_vector() const {
+            std::vector<S> rows;
+            rows.reserve(size());
+            for (std::size_t i = 0; i < size(); ++i) rows.push_back(row(i));
+            return rows;
+        }
+
+        [[nodiscard]] const_iterator begin() const { return const_iterator(this, 0); }
+        [[nodiscard]] const_iterator end() const { return const_iterator(this, size()); }
+
+        /**
+         * @brief The values of member `name` in every row.
+         */
+        template <rfl::internal::StringLiteral name>
+        [[nodiscard]] std::span<const element_type<name>> column() const {
+            return std::get<index_of<name>>(m_columns);
+        }
+
+        /**
+         * @brief The values of member `name` in every row, writable in place.
+         */
+        template <rfl::internal::StringLiteral name>
+        [[nodiscard]] std::span<element_type<name>> column() {
+            return std::get<index_of<name>>(m_columns);
+        }
+
+        /**
+         * @brief All columns, in the declaration order of the members of `S`.
+         */
+        [[nodiscard]] const Columns& columns() const { return m_columns; }
+
+        /**
+         * @brief Whether every column of `other` matches the same column here under `equal_columns`.
+         */
+        template <typename EqualColumns>
+        bool equals(const SoA& other, EqualColumns&& equal_columns) const {
+            return [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                return (equal_columns(std::get<Is>(m_columns), std::get<Is>(other.m_columns)) && ...);
+            }(std::make_integer_sequence<int, column_count>{});
+        }
+
+        friend bool operator==(const SoA& lhs, const SoA& rhs) = default;
+
+    private:
+        Columns m_columns;
+    };
+}
+
+namespace rfl {
+
+    /**
+     * @brief Reads and writes `SoA<std::vector<S>>` as a `std::vector<S>` in formats without a columnar reader.
+     */
+    template <typename S>
+    struct Reflector<fourdst::config::SoA<std::vector<S>>> {
+        using ReflType = std::vector<S>;
+
+        static fourdst::config::SoA<std::vector<S>> to(const ReflType& value) { return value; }
+
+        static ReflType from(const fourdst::config::SoA<std::vector<S>>& value) { return value.to_vector(); }
+    };
+}
+
+namespace rfl::parsing {
+
+    /**
+     * @brief Reads `SoA<std::vector<S>>` from a TOML array of tables one row at a time, straight into its columns.
+     */
+    template <class S, class ProcessorsType>
+    struct Parser<rfl::toml::Reader, rfl::toml::Writer, fourdst::config::SoA<std::vector<S>>, ProcessorsType> {
+        using InputVarType = typename rfl::toml::Reader::InputVarType;
+        using ElementParser = Parser<rfl::toml::Reader, rfl::toml::Writer, S, ProcessorsType>;
+        using VectorType = Parser<rfl::toml::Reader, rfl::toml::Writer, std::vector<S>, ProcessorsType>;
+
+        static Result<fourdst::config::SoA<std::vector<S>>> read(const rfl::toml::Reader& _r, const InputVarType& _var) noexcept {
+            ::toml::array* array = _var->as_array();
+            if (array == nullptr) return error("Could not cast to an array!");
+            try {
+                Result<fourdst::config::SoA<std::vector<S>>> result = fourdst::config::SoA<std::vector<S>>{};
+                auto& rows = result.value();
+                rows.reserve(array->size());
+                for (std::size_t i = 0; i < array->size(); ++i) {
+                    auto element = ElementParser::read(_r, array->get(i));
+                    if (!element) {
+                        return error(std::format("Failed to parse element {}: {}", i, element.error().what()));
+                    }
+                    rows.push_back(std::move(*element));
+                }
+                return result;
+            } catch (const std::exception& e) {
+                return error(e.what());
+            }
+        }
+
+        template <class P>
+        static void write(const rfl::toml::Writer& _w, const fourdst::config::SoA<std::vector<S>>& _rows, const P& _parent) {
+            using ParentType = Parent<rfl::toml::Writer>;
+            auto arr = ParentType::add_array(_w, _rows.size(), _parent);
+            const auto new_parent = typename ParentType::Array{&arr};
+            for (std::size_t i = 0; i < _rows.size(); ++i) {
+                ElementParser::write(_w, _rows.row(i), new_parent);
+            }
+            _w.end_array(&arr);
+        }
+
+        static schema::Type to_schema(std::map<std::string, schema::Type>* _definitions) {
+            return VectorType::to_schema(_definitions);
+        }
+    };
+}
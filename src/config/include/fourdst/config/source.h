@@ -0,0 +1,391 @@
+/**
+ * @file source.h
+ * @brief Pluggable places a config document is fetched from: files, memory, HTTP and object stores.
+ *
+ * `Config::load(std::shared_ptr<ConfigSource>)` fetches the document from a `ConfigSource`
+ * instead of a path, and a later `reload()` without arguments fetches it again. Every fetch
+ * passes the `SourceValidator` of the content currently loaded; a source that can tell the
+ * document has not changed since (an HTTP `304 Not Modified`, an unchanged file size and mtime)
+ * answers `not_modified`, and the reload returns `false` without parsing anything.
+ *
+ * `CachedSource` keeps the last fetched copy of another source in a local directory together
+ * with its validator. A repeat job then revalidates instead of downloading, and reads the local
+ * copy like any file, so `Config::set_cache_policy()` also skips the parse when the document is
+ * unchanged. If the remote cannot be reached, the cached copy is served.
+ *
+ * @code
+ * auto remote = std::make_shared<fourdst::config::HttpSource>("https://configs.example.org/run/physics.toml");
+ * auto source = std::make_shared<fourdst::config::CachedSource>(remote, "/scratch/config-cache");
+ * cfg.set_cache_policy(fourdst::config::CachePolicy::READ_WRITE);
+ * cfg.load(source);
+ * ...
+ * if (cfg.reload()) rebuild(*cfg.snapshot());
+ * @endcode
+ *
+ * `HttpSource` needs libconfig built with `-Duse_curl=enabled` (which defines
+ * `FOURDST_CONFIG_USE_CURL`). Object stores are reached over their HTTP API: path-style URLs of
+ * S3-compatible stores (`HttpSource::object()`), with public buckets, pre-signed URLs, or
+ * credentials passed as extra headers. Requests are not signed by the library.
+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/binary.h"
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/io.h"
+
+#if FOURDST_CONFIG_USE_CURL
+#include <cctype>
+#include <mutex>
+#include <curl/curl.h>
+#endif
+
+namespace fourdst::config {
+
+    /**
+     * @brief Identifies one version of a source document, for conditional fetches.
+     *
+     * An empty validator matches nothing, so a fetch passing it always returns the document.
+     */
+    struct SourceValidator {
+        /// Entity tag of the version (an HTTP `ETag`, or a tag the source derives itself).
+        std::string etag;
+        /// Modification time of the version, as an HTTP date (`Last-Modified`).
+        std::string last_modified;
+
+        [[nodiscard]] bool empty() const { return etag.empty() && last_modified.empty(); }
+
+        bool operator==(const SourceValidator&) const = default;
+    };
+
+    /**
+     * @brief The answer of one `ConfigSource::fetch()`.
+     *
+     * Unless `not_modified` is set, exactly one of `local_path` and `content` holds the document.
+     */
+    struct SourceData {
+        /// The source confirmed that the version passed to `fetch()` is still current; nothing else is set.
+        bool not_modified = false;
+        /// A local file holding the document, read as `Config::load(path)` would read it.
+        std::string local_path;
+        /// The document itself, when there is no local file.
+        std::string content;
+        /// The validator of the returned version, passed back on the next fetch.
+        SourceValidator validator;
+    };
+
+    /**
+     * @brief A place a config document is fetched from; implement it for a new kind of store.
+     *
+     * `fetch()` is only called by one thread at a time for a given `Config`, but a source shared
+     * between configs may be called concurrently.
+     */
+    class ConfigSource {
+    public:
+        virtual ~ConfigSource() = default;
+
+        /**
+         * @brief Returns the name of the source (a path or URL), used in error messages and as `Config::get_source_path()`.
+         *
+         * The extension of the name (ignoring a query string) selects TOML or JSON for `content`.
+         */
+        [[nodiscard]] virtual std::string name() const = 0;
+
+        /**
+         * @brief Fetches the document, unless the version identified by `known` is still current.
+         * @param known The validator of the version the caller holds; empty on a first fetch.
+         * @return The document, or `not_modified`.
+         * @throws exceptions::ConfigLoadError If the document cannot be fetched.
+         */
+        virtual SourceData fetch(const SourceValidator& known) = 0;
+    };
+
+    namespace detail {
+        /**
+         * @brief Returns a source name without its query string or fragment, e.g. a pre-signed URL without its signature.
+         */
+        inline std::string_view strip_query(const std::string_view name) {
+            return name.substr(0, name.find_first_of("?#"));
+        }
+    }
+
+    /**
+     * @brief A local file; revalidates by size and modification time without reading the file.
+     */
+    class FileSource final : public ConfigSource {
+    public:
+        explicit FileSource(std::string path) : m_path(std::move(path)) {}
+
+        [[nodiscard]] std::string name() const override { return m_path; }
+
+        SourceData fetch(const SourceValidator& known) override {
+            std::error_code size_ec;
+            std::error_code time_ec;
+            const auto size = std::filesystem::file_size(m_path, size_ec);
+            const auto mtime = std::filesystem::last_write_time(m_path, time_ec);
+            if (size_ec || time_ec) {
+                throw exceptions::ConfigLoadError(std::format("Config file does not exist: {}", m_path));
+            }
+            SourceData data;
+            data.validator.etag = std::format("{}-{}", size, mtime.time_since_epoch().count());
+            if (data.validator == known) {
+                data.not_modified = true;
+            } else {
+                data.local_path = m_path;
+            }
+            return data;
+        }
+
+    private:
+        std::string m_path;
+    };
+
+    /**
+     * @brief A document held in memory, e.g. received from a message bus; revalidates by content hash.
+     */
+    class MemorySource final : public ConfigSource {
+    public:
+        /**
+         * @param content The document.
+         * @param name The name to report; its extension selects the format (`.json` for JSON).
+         */
+        explicit MemorySource(std::string content, std::string name = "<memory>.toml")
+            : m_content(std::move(content)), m_name(std::move(name)) {}
+
+        [[nodiscard]] std::string name() const override { return m_name; }
+
+        /**
+         * @brief Replaces the document returned by later fetches.
+         */
+        void set_content(std::string content) { m_content = std::move(content); }
+
+        SourceData fetch(const SourceValidator& known) override {
+            SourceData data;
+            data.validator.etag = std::format("{:016x}", io::hash_bytes(m_content));
+            if (data.validator == known) {
+                data.not_modified = true;
+            } else {
+                data.content = m_content;
+            }
+            return data;
+        }
+
+    private:
+        std::string m_content;
+        std::string m_name;
+    };
+
+    /**
+     * @brief Keeps the last fetched copy of another source, and its validator, in a local directory.
+     *
+     * Every fetch revalidates the cached copy against the inner source, so an unchanged document
+     * is not downloaded again, and is returned as a local file. The cache file is named after a
+     * hash of the inner source's name, keeping its extension (e.g. `3f9a0c1d2b4e5f60.toml`).
+     */
+    class CachedSource final : public ConfigSource {
+    public:
+        /**
+         * @param inner The source to cache.
+         * @param directory The cache directory; created on the first fetch.
+         * @param serve_stale Whether to return the cached copy when `inner` fails.
+         */
+        CachedSource(std::shared_ptr<ConfigSource> inner, std::string directory, const bool serve_stale = true)
+            : m_inner(std::move(inner)), m_directory(std::move(directory)), m_serve_stale(serve_stale) {
+            const std::string name = m_inner->name();
+            const std::string file = std::filesystem::path(detail::strip_query(name)).filename().string();
+            const std::size_t dot = file.find('.');
+            const std::string extension = dot == std::string::npos ? ".toml" : file.substr(dot);
+            m_path = (std::filesystem::path(m_directory) / std::format("{:016x}{}", io::hash_bytes(name), extension)).string();
+        }
+
+        [[nodiscard]] std::string name() const override { return m_inner->name(); }
+
+        /**
+         * @brief Returns the path of the cached copy.
+         */
+        [[nodiscard]] const std::string& cache_path() const { return m_path; }
+
+        SourceData fetch(const SourceValidator& known) override {
+            const std::string meta_path = m_path + ".meta";
+            SourceValidator cached;
+            const bool have_copy = std::filesystem::exists(m_path) && read_meta(meta_path, cached);
+
+            SourceData fresh;
+            try {
+                fresh = m_inner->fetch(have_copy ? cached : SourceValidator{});
+            } catch (const exceptions::ConfigLoadError&) {
+                if (!have_copy || !m_serve_stale) throw;
+                fresh.not_modified = true;
+            }
+
+            SourceData data;
+            if (fresh.not_modified && have_copy) {
+                data.validator = cached;
+            } else {
+                std::error_code ec;
+                std::filesystem::create_directories(m_directory, ec);
+                store(fresh);
+                write_meta(meta_path, fresh.validator);
+                data.validator = std::move(fresh.validator);
+            }
+            // A validator-less source cannot tell versions apart, so it is never reported unchanged.
+            if (!data.validator.empty() && data.validator == known) {
+                data.not_modified = true;
+            } else {
+                data.local_path = m_path;
+            }
+            return data;
+        }
+
+    private:
+        void store(const SourceData& fresh) const {
+            if (fresh.not_modified) {
+                throw exceptions::ConfigLoadError(
+                    std::format("Config source {} reported an unchanged document that is not cached", m_inner->name()));
+            }
+            io::AtomicFileSink sink{m_path, false};
+            if (fresh.local_path.empty()) {
+                sink.write(fresh.content);
+            } else {
+                std::ifstream in(fresh.local_path, std::ios::binary);
+                const std::string bytes{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+                sink.write(bytes);
+            }
+            sink.commit();
+        }
+
+        static bool read_meta(const std::string& path, SourceValidator& validator) {
+            std::ifstream in(path);
+            return static_cast<bool>(std::getline(in, validator.etag)) && static_cast<bool>(std::getline(in, validator.last_modified));
+        }
+
+        static void write_meta(const std::string& path, const SourceValidator& validator) {
+            io::AtomicFileSink sink{path, false};
+            sink.write(std::format("{}\n{}\n", validator.etag, validator.last_modified));
+            sink.commit();
+        }
+
+        std::shared_ptr<ConfigSource> m_inner;
+        std::string m_directory;
+        std::string m_path;
+        bool m_serve_stale;
+    };
+
+#if FOURDST_CONFIG_USE_CURL
+    /**
+     * @brief Request options of an `HttpSource`.
+     */
+    struct HttpOptions {
+        /// Extra request headers, e.g. `"Authorization: Bearer ..."`.
+        std::vector<std::string> headers;
+        /// Limit on the whole transfer.
+        std::chrono::milliseconds timeout{30'000};
+        /// Limit on establishing the connection.
+        std::chrono::milliseconds connect_timeout{10'000};
+    };
+
+    /**
+     * @brief A document served over HTTP(S); revalidates with `If-None-Match` / `If-Modified-Since`.
+     *
+     * Redirects are followed, and compressed transfer encodings are accepted and decoded.
+     */
+    class HttpSource final : public ConfigSource {
+    public:
+        explicit HttpSource(std::string url, HttpOptions options = {}) : m_url(std::move(url)), m_options(std::move(options)) {}
+
+        /**
+         * @brief Returns a source for an object of an S3-compatible store, addressed path-style (`endpoint/bucket/key`).
+         */
+        static HttpSource object(const std::string_view endpoint, const std::string_view bucket, const std::string_view key,
+                                 HttpOptions options = {}) {
+            const std::string_view base = endpoint.ends_with('/') ? endpoint.substr(0, endpoint.size() - 1) : endpoint;
+            return HttpSource(std::format("{}/{}/{}", base, bucket, key), std::move(options));
+        }
+
+        [[nodiscard]] std::string name() const override { return m_url; }
+
+        SourceData fetch(const SourceValidator& known) override {
+            static std::once_flag global_init;
+            std::call_once(global_init, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+
+            const std::unique_ptr<CURL, decltype(&curl_easy_cleanup)> curl(curl_easy_init(), &curl_easy_cleanup);
+            if (!curl) {
+                throw exceptions::ConfigLoadError(std::format("Failed to start fetching config from {}", m_url));
+            }
+            std::vector<std::string> lines = m_options.headers;
+            if (!known.etag.empty()) lines.push_back("If-None-Match: " + known.etag);
+            if (!known.last_modified.empty()) lines.push_back("If-Modified-Since: " + known.last_modified);
+            curl_slist* list = nullptr;
+            for (const auto& line : lines) list = curl_slist_append(list, line.c_str());
+            const std::unique_ptr<curl_slist, decltype(&curl_slist_free_all)> headers(list, &curl_slist_free_all);
+
+            SourceData data;
+            curl_easy_setopt(curl.get(), CURLOPT_URL, m_url.c_str());
+            curl_easy_setopt(curl.get(), CURLOPT_HTTPHEADER, headers.get());
+            curl_easy_setopt(curl.get(), CURLOPT_FOLLOWLOCATION, 1L);
+            curl_easy_setopt(curl.get(), CURLOPT_ACCEPT_ENCODING, "");
+            curl_easy_setopt(curl.get(), CURLOPT_NOSIGNAL, 1L);
+            curl_easy_setopt(curl.get(), CURLOPT_TIMEOUT_MS, static_cast<long>(m_options.timeout.count()));
+            curl_easy_setopt(curl.get(), CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(m_options.connect_timeout.count()));
+            curl_easy_setopt(curl.get(), CURLOPT_WRITEFUNCTION, &HttpSource::on_body);
+            curl_easy_setopt(curl.get(), CURLOPT_WRITEDATA, &data.content);
+            curl_easy_setopt(curl.get(), CURLOPT_HEADERFUNCTION, &HttpSource::on_header);
+            curl_easy_setopt(curl.get(), CURLOPT_HEADERDATA, &data.validator);
+
+            const CURLcode result = curl_easy_perform(curl.get());
+            if (result != CURLE_OK) {
+                throw exceptions::ConfigLoadError(
+                    std::format("Failed to fetch config from {}: {}", m_url, curl_easy_strerror(result)));
+            }
+            long status = 0;
+            curl_easy_getinfo(curl.get(), CURLINFO_RESPONSE_CODE, &status);
+            if (status == 304) {
+                data.not_modified = true;
+                data.content.clear();
+                data.validator = known;
+            } else if (status < 200 || status >= 300) {
+                throw exceptions::ConfigLoadError(std::format("Failed to fetch config from {}: HTTP {}", m_url, status));
+            }
+            return data;
+        }
+
+    private:
+        static std::size_t on_body(const char* bytes, const std::size_t size, const std::size_t count, void* out) {
+            static_cast<std::string*>(out)->append(bytes, size * count);
+            return size * count;
+        }
+
+        static std::size_t on_header(const char* bytes, const std::size_t size, const std::size_t count, void* out) {
+            auto& validator = *static_cast<SourceValidator*>(out);
+            const std::string_view line(bytes, size * count);
+            const std::size_t colon = line.find(':');
+            if (colon != std::string_view::npos) {
+                std::string key(line.substr(0, colon));
+                for (char& c : key) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+                std::string_view value = line.substr(colon + 1);
+                value.remove_prefix(std::min(value.find_first_not_of(" \t"), value.size()));
+                value = value.substr(0, value.find_last_not_of(" \t\r\n") + 1);
+                if (key == "etag") validator.etag = value;
+                if (key == "last-modified") validator.last_modified = value;
+            }
+            return size * count;
+        }
+
+        std::string m_url;
+        HttpOptions m_options;
+    };
+#endif
+}
@@ -0,0 +1,119 @@
+/**
+ * @file sparse.h
+ * @brief Sparse documents: only the fields that differ from a default-constructed schema.
+ *
+ * Most saved decks keep the majority of their fields at the schema defaults. `non_default_table()`
+ * drops those fields from the document `save()` would write, so `SaveMode::NON_DEFAULT_ONLY`
+ * produces a file holding only what the run changed. Loading such a file needs the dropped fields
+ * back, which `MissingFieldPolicy::USE_DEFAULTS` does by merging the file over `default_table()`
+ * before deserializing it.
+ *
+ * Both sides compare and merge at the level of TOML values: tables are descended into, while
+ * arrays (including arrays of tables) are kept or dropped as a whole.
+ *
+ * `content_patch()` builds the same kind of document between two instances of a schema, for
+ * `Config::save_patch()`: only what changed since the config was loaded.
+ */
+#pragma once
+
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "fourdst/config/compare.h"
+#include "fourdst/config/io.h"
+#include "fourdst/config/patch.h"
+#include "fourdst/config/path_table.h"
+#include "fourdst/config/toml_writer.h"
+
+#include "rfl.hpp"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config::io {
+
+    namespace detail {
+        /**
+         * @brief Returns the root table of the TOML document `write_toml_document()` produces for `content`.
+         */
+        template <typename T>
+        toml::table content_table(const T& content) {
+            std::string text;
+            StringSink sink{text};
+            write_toml_document(sink, "main", content);
+            toml::table document = toml::parse(text);
+            return std::move(*document["main"].as_table());
+        }
+
+        /**
+         * @brief Copies the fields of `after` that differ from `before` from `source` into `patch`.
+         * @param source The serialized fields of `after`.
+         * @return False if a changed field is absent from `source` (an optional that was cleared).
+         */
+        template <typename V>
+        bool collect_changes(const V& before, const V& after, const toml::table& source, toml::table& patch) {
+            using Fields = typename rfl::named_tuple_t<V>::Fields;
+            const auto before_values = rfl::to_view(before).values();
+            const auto after_values = rfl::to_view(after).values();
+            return [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                return ([&] {
+                    using Field = rfl::tuple_element_t<Is, Fields>;
+                    const auto& old_value = *rfl::get<Is>(before_values);
+                    const auto& new_value = *rfl::get<Is>(after_values);
+                    if (config::detail::equal(old_value, new_value)) return true;
+
+                    const toml::node* node = source.get(Field::name());
+                    if (node == nullptr) return false;
+                    if constexpr (config::detail::is_path_struct_v<typename Field::Type>) {
+                        toml::table child;
+                        if (!collect_changes(old_value, new_value, *node->as_table(), child)) return false;
+                        patch.insert(Field::name(), std::move(child));
+                    } else {
+                        node->visit([&](const auto& concrete) { patch.insert(Field::name(), concrete); });
+                    }
+                    return true;
+                }() && ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        }
+    }
+
+    /**
+     * @brief Returns the fields of a default-constructed `T` as a TOML table.
+     *
+     * Built on the first call and shared afterwards.
+     */
+    template <typename T>
+    const toml::table& default_table() {
+        static const toml::table table = detail::content_table(T{});
+        return table;
+    }
+
+    /**
+     * @brief Returns the fields of `content` that differ from a default-constructed `T`.
+     * @param content The content to write.
+     * @return The changed fields, empty if `content` is all defaults; nothing if `content` lacks a
+     *         field the defaults have (an optional or map entry cleared since), which a sparse
+     *         document cannot express.
+     */
+    template <typename T>
+    std::optional<toml::table> non_default_table(const T& content) {
+        return diff_toml_tables(default_table<T>(), detail::content_table(content));
+    }
+
+    /**
+     * @brief Returns the merge patch that turns `before` into `after`.
+     *
+     * Unlike `non_default_table()`, the comparison follows the schema: nested structs are
+     * descended into, and any other changed field (a map, a vector, an optional) is written whole,
+     * so applying the patch with `apply_toml_patch()` reproduces `after` exactly.
+     *
+     * @return The patch, empty if the contents are equal; nothing if an optional was cleared,
+     *         which a merge patch cannot express.
+     */
+    template <typename T>
+    std::optional<toml::table> content_patch(const T& before, const T& after) {
+        toml::table patch;
+        if (!detail::collect_changes(before, after, detail::content_table(after), patch)) return std::nullopt;
+        return patch;
+    }
+}
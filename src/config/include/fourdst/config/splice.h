@@ -0,0 +1,320 @@
+/**
+ * @file splice.h
+ * @brief Rewriting only the changed values of a TOML file, keeping the rest of its bytes.
+ *
+ * Saving a config serializes the whole content, so a one-value edit of a large generated deck
+ * costs a full write and drops its comments and layout. `Config::set_format_preserving_saves()`
+ * avoids both with the pieces below:
+ *
+ * - `value_spans()` records where the text of each value lies in the file, from the source
+ *   positions toml++ keeps while parsing;
+ * - `collect_value_edits()` compares the content as loaded with the current one field by field
+ *   and writes the new text of each changed value;
+ * - `splice_file()` replaces those spans. Text of the same length is overwritten in place; other
+ *   edits copy the file once with the new values spliced in.
+ *
+ * Only values that already have text in the file can be replaced: setting or clearing an
+ * optional, or changing a map or an array of tables, needs a full save.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <format>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/compare.h"
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/fwd.h"
+#include "fourdst/config/io.h"
+#include "fourdst/config/toml_writer.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config::io {
+
+    /**
+     * @brief Where the text of a value lies in a file.
+     */
+    struct ValueSpan {
+        /// Byte offset of the first character of the value.
+        std::size_t offset = 0;
+        /// Length of the value text in bytes, without trailing blanks or comments.
+        std::size_t length = 0;
+    };
+
+    /// The spans of the values of a document, by dotted path from the top of the file.
+    using ValueSpans = std::unordered_map<std::string, ValueSpan>;
+
+    /**
+     * @brief A changed value: its dotted path and its new TOML text.
+     */
+    struct ValueEdit {
+        std::string path;
+        std::string text;
+    };
+
+    /**
+     * @brief New text for one span of a file.
+     */
+    struct SpanEdit {
+        ValueSpan span;
+        std::string_view text;
+    };
+
+    namespace detail {
+        /// Returns the offset just past the string that starts at `pos`, or 0 if it is not closed.
+        inline std::size_t string_end(const std::string_view text, std::size_t pos) {
+            const char quote = text[pos];
+            const std::string_view triple = quote == '"' ? "\"\"\"" : "'''";
+            if (text.substr(pos, 3) == triple) {
+                for (pos += 3; pos < text.size(); ++pos) {
+                    if (quote == '"' && text[pos] == '\\') {
+                        ++pos;
+                    } else if (text.substr(pos, 3) == triple) {
+                        pos += 3;
+                        // Up to two quotes may end the content right before the delimiter.
+                        for (int extra = 0; extra < 2 && pos < text.size() && text[pos] == quote; ++extra) ++pos;
+                        return pos;
+                    }
+                }
+                return 0;
+            }
+            for (++pos; pos < text.size(); ++pos) {
+                if (quote == '"' && text[pos] == '\\') {
+                    ++pos;
+                } else if (text[pos] == quote) {
+                    return pos + 1;
+                } else if (text[pos] == '\n') {
+                    return 0;
+                }
+            }
+            return 0;
+        }
+
+        /// Returns the offset just past the value whose text starts at `begin`, or 0 if no value starts there.
+        inline std::size_t value_end(const std::string_view text, const std::size_t begin) {
+            if (begin >= text.size()) return 0;
+            const char first = text[begin];
+            if (first == '"' || first == '\'') return string_end(text, begin);
+            if (first == '[' || first == '{') {
+                std::size_t depth = 0;
+                for (std::size_t pos = begin; pos < text.size();) {
+                    const char c = text[pos];
+                    if (c == '"' || c == '\'') {
+                        pos = string_end(text, pos);
+                        if (pos == 0) return 0;
+                        continue;
+                    }
+                    if (c == '#') {
+                        pos = text.find('\n', pos);
+                        if (pos == std::string_view::npos) return 0;
+                        continue;
+                    }
+                    if (c == '[' || c == '{') {
+                        ++depth;
+                    } else if ((c == ']' || c == '}') && --depth == 0) {
+                        return pos + 1;
+                    }
+                    ++pos;
+                }
+                return 0;
+            }
+            if (!std::isalnum(static_cast<unsigned char>(first)) && first != '+' && first != '-') return 0;
+            // Numbers, booleans and dates run to the next delimiter; a date may hold a space.
+            std::size_t end = begin;
+            while (end < text.size() && std::string_view(",]}#\r\n").find(text[end]) == std::string_view::npos) ++end;
+            while (end > begin && (text[end - 1] == ' ' || text[end - 1] == '\t')) --end;
+            return end;
+        }
+
+        /// Returns the byte offset of a toml++ source position, whose columns count code points; `npos` if it is outside `text`.
+        inline std::size_t position_offset(const std::string_view text, const std::vector<std::size_t>& line_starts,
+                                           const toml::source_position& position) {
+            if (position.line == 0 || position.line > line_starts.size() || position.column == 0) return std::string_view::npos;
+            std::size_t offset = line_starts[position.line - 1];
+            for (toml::source_index column = 1; column < position.column; ++column) {
+                if (offset >= text.size() || text[offset] == '\n') return std::string_view::npos;
+                ++offset;
+                while (offset < text.size() && (static_cast<unsigned char>(text[offset]) & 0xC0) == 0x80) ++offset;
+            }
+            return offset;
+        }
+
+        struct SpanSource {
+            std::string_view text;
+            std::vector<std::size_t> line_starts;
+            std::string_view file;
+        };
+
+        inline void collect_spans(const toml::table& table, const SpanSource& source, std::string& path, ValueSpans& spans) {
+            for (const auto& [key, node] : table) {
+                const std::size_t length = path.size();
+                if (length != 0) path += '.';
+                path += key.str();
+                if (const toml::table* child = node.as_table()) {
+                    collect_spans(*child, source, path, spans);
+                } else if (const toml::array* array = node.as_array(); array == nullptr || !array->is_array_of_tables()) {
+                    // Values merged in from included files have no text in this one.
+                    const toml::source_region& region = node.source();
+                    if (region.path && *region.path == source.file) {
+                        const std::size_t begin = position_offset(source.text, source.line_starts, region.begin);
+                        const std::size_t end = begin == std::string_view::npos ? 0 : value_end(source.text, begin);
+                        if (end > begin) spans.insert_or_assign(path, ValueSpan{begin, end - begin});
+                    }
+                }
+                path.resize(length);
+            }
+        }
+    }
+
+    /**
+     * @brief Returns where the text of each value of `document` lies in `text`, the file it was parsed from.
+     *
+     * Tables, inline ones included, are descended; arrays are one value each, except arrays of
+     * tables, which get no span. Values whose text cannot be found are left out.
+     *
+     * @param document The document toml++ parsed from `text`.
+     * @param text The bytes of the file.
+     * @param file The source path the document was parsed with; values parsed from other files are left out.
+     */
+    inline ValueSpans value_spans(const toml::table& document, const std::string_view text, const std::string_view file) {
+        detail::SpanSource source{text, {}, file};
+        source.line_starts.push_back(text.starts_with("\xEF\xBB\xBF") ? 3 : 0);
+        for (std::size_t pos = text.find('\n'); pos != std::string_view::npos; pos = text.find('\n', pos + 1)) {
+            source.line_starts.push_back(pos + 1);
+        }
+        ValueSpans spans;
+        std::string path;
+        detail::collect_spans(document, source, path, spans);
+        return spans;
+    }
+
+    /**
+     * @brief Appends to `edits` the new text of every value that differs between `before` and `after`.
+     *
+     * Structs are compared field by field, and present optionals by their values; any other
+     * changed value gets its whole text rewritten, as `save()` would write it inline.
+     *
+     * @param path The dotted path of the values, extended in place while descending and restored.
+     * @return False if a change cannot be written as the replacement of one value's text.
+     */
+    template <typename V>
+    bool collect_value_edits(const V& before, const V& after, std::string& path, std::vector<ValueEdit>& edits) {
+        using Type = std::remove_cvref_t<V>;
+        if constexpr (detail::is_plain_struct_v<Type>) {
+            using Fields = typename rfl::named_tuple_t<Type>::Fields;
+            const auto before_view = rfl::to_view(before).values();
+            const auto after_view = rfl::to_view(after).values();
+            const std::size_t length = path.size();
+            return [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                return ([&] {
+                    if (length != 0) path += '.';
+                    path += rfl::tuple_element_t<Is, Fields>::name();
+                    const bool expressible = collect_value_edits(*rfl::get<Is>(before_view), *rfl::get<Is>(after_view), path, edits);
+                    path.resize(length);
+                    return expressible;
+                }() && ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        } else if constexpr (validate::is_optional_v<Type>) {
+            if (before.has_value() != after.has_value()) return false;
+            return !after.has_value() || collect_value_edits(*before, *after, path, edits);
+        } else {
+            if (config::detail::equal(before, after)) return true;
+            if constexpr (detail::is_table_v<Type> || detail::is_table_array_v<Type> || !detail::is_streamable_v<Type>) {
+                return false;
+            } else {
+                std::string text;
+                StringSink sink{text};
+                TomlWriter<StringSink> writer(sink);
+                writer.write_value(after);
+                edits.push_back({path, std::move(text)});
+                return true;
+            }
+        }
+    }
+
+    /**
+     * @brief Replaces the spans of the file at `path` with new text.
+     *
+     * Under `SavePolicy::IN_PLACE`, edits whose text has the length of its span are written over
+     * the old bytes, and nothing else is touched. Otherwise the file is copied once with the new
+     * text spliced in, through a temporary file under `ATOMIC` and `DURABLE`.
+     *
+     * @param path The file.
+     * @param edits The edits, by increasing offset; spans must not overlap.
+     * @param policy How the file is written.
+     * @throws exceptions::ConfigSaveError If the file cannot be written.
+     * @throws exceptions::ConfigLoadError If the file cannot be read.
+     */
+    inline void splice_file(const std::string& path, const std::vector<SpanEdit>& edits, const SavePolicy policy) {
+        const bool same_length = std::ranges::all_of(edits, [](const SpanEdit& edit) { return edit.text.size() == edit.span.length; });
+        if (policy == SavePolicy::IN_PLACE && same_length) {
+            std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+            for (const SpanEdit& edit : edits) {
+                file.seekp(static_cast<std::streamoff>(edit.span.offset));
+                file.write(edit.text.data(), static_cast<std::streamsize>(edit.text.size()));
+            }
+            file.flush();
+            if (!file) {
+                throw exceptions::ConfigSaveError(std::format("Failed to write config file: {}", path));
+            }
+            return;
+        }
+        // An in-place rewrite truncates the file first, so it needs its own copy of the old bytes.
+        const MappedFile original{path, policy == SavePolicy::IN_PLACE ? ReadMode::READ : ReadMode::MAP};
+        const std::string_view bytes = original.view();
+        const auto write_spliced = [&](auto& sink) {
+            std::size_t copied = 0;
+            for (const SpanEdit& edit : edits) {
+                sink.write(bytes.substr(copied, edit.span.offset - copied));
+                sink.write(edit.text);
+                copied = edit.span.offset + edit.span.length;
+            }
+            sink.write(bytes.substr(copied));
+        };
+        if (policy == SavePolicy::IN_PLACE) {
+            FileSink sink{path};
+            write_spliced(sink);
+            sink.close();
+        } else {
+            AtomicFileSink sink{path, policy == SavePolicy::DURABLE};
+            write_spliced(sink);
+            sink.commit();
+        }
+    }
+
+    /**
+     * @brief Moves `spans` to where `splice_file()` left their values after applying `edits`.
+     * @param edits The edits `splice_file()` applied, by increasing offset.
+     */
+    inline void shift_spans(ValueSpans& spans, const std::vector<SpanEdit>& edits) {
+        // shifts[k] is how far the first k edits moved the bytes after them.
+        std::vector<std::ptrdiff_t> shifts(edits.size() + 1, 0);
+        for (std::size_t k = 0; k < edits.size(); ++k) {
+            shifts[k + 1] = shifts[k] + static_cast<std::ptrdiff_t>(edits[k].text.size()) - static_cast<std::ptrdiff_t>(edits[k].span.length);
+        }
+        if (shifts.back() == 0 && std::ranges::all_of(edits, [](const SpanEdit& edit) { return edit.text.size() == edit.span.length; })) {
+            return;
+        }
+        for (auto& [path, span] : spans) {
+            const auto after = std::ranges::upper_bound(edits, span.offset, {}, [](const SpanEdit& edit) { return edit.span.offset; });
+            std::size_t before = static_cast<std::size_t>(after - edits.begin());
+            if (before != 0 && edits[before - 1].span.offset == span.offset) {
+                span.length = edits[before - 1].text.size();
+                --before;
+            }
+            span.offset = static_cast<std::size_t>(static_cast<std::ptrdiff_t>(span.offset) + shifts[before]);
+        }
+    }
+}
@@ -0,0 +1,360 @@
+/**
+ * @file stats.h
+ * @brief Per-phase timing and allocation counts of a `Config::load()`.
+ *
+ * Passing a `LoadStats` to `Config::load()` records how long the load spent reading the file,
+ * parsing it, deserializing the root table into `T` and validating it, together with the number
+ * of bytes read:
+ *
+ * @code
+ * fourdst::config::LoadStats stats;
+ * cfg.load("physics.toml", stats);
+ * std::println("{} bytes, parse {}, deserialize {}", stats.bytes_read, stats.parse_time, stats.deserialize_time);
+ * @endcode
+ *
+ * Allocations are counted only when a counting allocator reports them with
+ * `io::note_allocation()`. `FOURDST_CONFIG_COUNT_ALLOCATIONS()`, placed in one translation unit
+ * of the program, replaces the global `operator new` with one that does. Allocations are counted
+ * on the loading thread only; those of helper threads (parallel reads) are not included.
+ *
+ * `LockStats` reports how writers contend on a config's content lock, once enabled with
+ * `Config::set_lock_stats()`:
+ *
+ * @code
+ * cfg.set_lock_stats(true);
+ * ...
+ * const fourdst::config::LockStats locks = cfg.get_lock_stats();
+ * std::println("{} of {} acquisitions waited, up to {}", locks.contended, locks.acquisitions, locks.max_wait);
+ * @endcode
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <shared_mutex>
+
+namespace fourdst::config {
+
+    /**
+     * @brief What one `Config::load()` spent its time and memory on.
+     *
+     * Times are wall-clock and accumulate across the phases of a load; a load that falls back to
+     * a second parse (see `parse_content`) counts both. With a buffered TOML read, the file is
+     * read into memory before parsing so the two phases can be told apart. Validation only runs
+     * when deserialization fails, so `validate_time` is zero for a successful load. If the load
+     * throws, the phases completed so far are still recorded.
+     */
+    struct LoadStats {
+        /// Bytes of the config file read (or mapped); fragments pulled in with `__include` are not counted.
+        std::size_t bytes_read = 0;
+        /// Opening, reading or mapping the file, and hashing it for the binary cache.
+        std::chrono::nanoseconds read_time{0};
+        /// Parsing TOML or JSON text into a document.
+        std::chrono::nanoseconds parse_time{0};
+        /// Reading `T` from the document (or the binary cache), including sidecar and columnar files.
+        std::chrono::nanoseconds deserialize_time{0};
+        /// Running the validator over the document to report why deserialization failed.
+        std::chrono::nanoseconds validate_time{0};
+        /// The whole load, including installing the result and notifying subscribers.
+        std::chrono::nanoseconds total_time{0};
+        /// Heap allocations made by the load, if a counting allocator is installed.
+        std::optional<std::size_t> allocations;
+        /// Bytes requested by those allocations, if a counting allocator is installed.
+        std::optional<std::size_t> allocated_bytes;
+    };
+
+    /**
+     * @brief Contention on the content lock of one `Config`, taken by `mutate()`, `reset()`, `load()` and the setters.
+     *
+     * Readers never take the lock (they read published snapshots), so waits here are writers
+     * stalling writers, or a writer stalling a thread that loads, saves or reconfigures.
+     */
+    struct LockStats {
+        /// Times the lock was taken.
+        std::uint64_t acquisitions = 0;
+        /// Acquisitions that found the lock held and had to wait.
+        std::uint64_t contended = 0;
+        /// Time spent waiting for the lock, over all acquisitions.
+        std::chrono::nanoseconds total_wait{0};
+        /// Longest single wait.
+        std::chrono::nanoseconds max_wait{0};
+        /// Time the lock was held, including the user mutator of `mutate()`.
+        std::chrono::nanoseconds total_held{0};
+        /// Longest single hold.
+        std::chrono::nanoseconds max_held{0};
+    };
+
+    namespace detail {
+        /// Upper bounds of the buckets of `DurationHistogram`, in nanoseconds, from 1 µs to 10 s.
+        inline constexpr std::array<std::int64_t, 12> duration_bucket_bounds{
+            1'000, 10'000, 100'000, 1'000'000, 5'000'000, 10'000'000,
+            50'000'000, 100'000'000, 500'000'000, 1'000'000'000, 5'000'000'000, 10'000'000'000};
+
+        /**
+         * @brief Counts durations into the fixed buckets of `duration_bucket_bounds`, plus one for longer ones.
+         *
+         * Lock-free and relaxed, like `LockCounters`; a read may see an observation in the sum but not yet in its bucket.
+         */
+        class DurationHistogram {
+        public:
+            static constexpr std::size_t bucket_count = duration_bucket_bounds.size() + 1;
+
+            void observe(const std::chrono::nanoseconds duration) noexcept {
+                std::size_t bucket = 0;
+                while (bucket < duration_bucket_bounds.size() && duration.count() > duration_bucket_bounds[bucket]) ++bucket;
+                m_counts[bucket].fetch_add(1, std::memory_order_relaxed);
+                m_sum.fetch_add(duration.count(), std::memory_order_relaxed);
+            }
+
+            /// Observations in bucket `bucket` alone (not cumulative); the last bucket holds those above every bound.
+            [[nodiscard]] std::uint64_t count(const std::size_t bucket) const noexcept {
+                return m_counts[bucket].load(std::memory_order_relaxed);
+            }
+
+            [[nodiscard]] std::chrono::nanoseconds sum() const noexcept {
+                return std::chrono::nanoseconds(m_sum.load(std::memory_order_relaxed));
+            }
+
+        private:
+            std::array<std::atomic<std::uint64_t>, bucket_count> m_counts{};
+            std::atomic<std::int64_t> m_sum{0};
+        };
+
+        /**
+         * @brief Lock-free accumulators behind `LockStats`; relaxed, so a read may mix two updates.
+         */
+        class LockCounters {
+        public:
+            [[nodiscard]] bool enabled() const noexcept { return m_enabled.load(std::memory_order_relaxed); }
+            void enable(const bool on) noexcept { m_enabled.store(on, std::memory_order_relaxed); }
+
+            void record_wait(const std::chrono::nanoseconds wait, const bool contended) noexcept {
+                m_acquisitions.fetch_add(1, std::memory_order_relaxed);
+                if (contended) m_contended.fetch_add(1, std::memory_order_relaxed);
+                m_total_wait.fetch_add(wait.count(), std::memory_order_relaxed);
+                raise(m_max_wait, wait.count());
+                if (DurationHistogram* waits = m_waits.load(std::memory_order_relaxed)) waits->observe(wait);
+            }
+
+            /**
+             * @brief Also counts every wait into `waits`, or stops if null; see `Config::set_metrics()`.
+             *
+             * Waits are recorded with the lock held, so a histogram replaced while holding it is no longer written to.
+             */
+            void set_wait_histogram(DurationHistogram* waits) noexcept { m_waits.store(waits, std::memory_order_relaxed); }
+
+            void record_held(const std::chrono::nanoseconds held) noexcept {
+                m_total_held.fetch_add(held.count(), std::memory_order_relaxed);
+                raise(m_max_held, held.count());
+            }
+
+            [[nodiscard]] LockStats get() const noexcept {
+                LockStats stats;
+                stats.acquisitions = m_acquisitions.load(std::memory_order_relaxed);
+                stats.contended = m_contended.load(std::memory_order_relaxed);
+                stats.total_wait = std::chrono::nanoseconds(m_total_wait.load(std::memory_order_relaxed));
+                stats.max_wait = std::chrono::nanoseconds(m_max_wait.load(std::memory_order_relaxed));
+                stats.total_held = std::chrono::nanoseconds(m_total_held.load(std::memory_order_relaxed));
+                stats.max_held = std::chrono::nanoseconds(m_max_held.load(std::memory_order_relaxed));
+                return stats;
+            }
+
+            void reset() noexcept {
+                for (auto* counter : {&m_acquisitions, &m_contended}) counter->store(0, std::memory_order_relaxed);
+                for (auto* counter : {&m_total_wait, &m_max_wait, &m_total_held, &m_max_held}) counter->store(0, std::memory_order_relaxed);
+            }
+
+        private:
+            static void raise(std::atomic<std::int64_t>& maximum, const std::int64_t value) noexcept {
+                std::int64_t seen = maximum.load(std::memory_order_relaxed);
+                while (value > seen && !maximum.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+            }
+
+            std::atomic<bool> m_enabled{false};
+            std::atomic<std::uint64_t> m_acquisitions{0};
+            std::atomic<std::uint64_t> m_contended{0};
+            std::atomic<std::int64_t> m_total_wait{0};
+            std::atomic<std::int64_t> m_max_wait{0};
+            std::atomic<std::int64_t> m_total_held{0};
+            std::atomic<std::int64_t> m_max_held{0};
+            std::atomic<DurationHistogram*> m_waits{nullptr};
+        };
+
+        /**
+         * @brief Holds `mutex` exclusively for its lifetime, like `std::lock_guard`, and reports to `counters` if they are enabled.
+         *
+         * With counters disabled this is one relaxed load more than a `std::lock_guard`.
+         */
+        class CountedLock {
+        public:
+            CountedLock(std::shared_mutex& mutex, LockCounters& counters) : m_mutex(mutex) {
+                if (!counters.enabled()) {
+                    m_mutex.lock();
+                    return;
+                }
+                m_counters = &counters;
+                const auto start = std::chrono::steady_clock::now();
+                const bool contended = !m_mutex.try_lock();
+                if (contended) m_mutex.lock();
+                m_acquired = std::chrono::steady_clock::now();
+                m_counters->record_wait(m_acquired - start, contended);
+            }
+
+            CountedLock(const CountedLock&) = delete;
+            CountedLock& operator=(const CountedLock&) = delete;
+
+            ~CountedLock() {
+                if (m_counters != nullptr) m_counters->record_held(std::chrono::steady_clock::now() - m_acquired);
+                m_mutex.unlock();
+            }
+
+        private:
+            std::shared_mutex& m_mutex;
+            LockCounters* m_counters = nullptr;
+            std::chrono::steady_clock::time_point m_acquired{};
+        };
+    }
+
+    namespace io {
+        namespace detail {
+            inline LoadStats*& load_stats_slot() {
+                thread_local LoadStats* stats = nullptr;
+                return stats;
+            }
+
+            struct AllocationCounter {
+                std::size_t count = 0;
+                std::size_t bytes = 0;
+            };
+
+            inline AllocationCounter& allocation_counter() noexcept {
+                thread_local AllocationCounter counter;
+                return counter;
+            }
+
+            inline std::atomic<bool>& allocation_counting_installed() noexcept {
+                static std::atomic<bool> installed{false};
+                return installed;
+            }
+        }
+
+        /**
+         * @brief Records one heap allocation of `bytes` on the calling thread.
+         *
+         * Call from a counting allocator; the first call enables allocation counts in `LoadStats`.
+         */
+        inline void note_allocation(const std::size_t bytes) noexcept {
+            auto& counter = detail::allocation_counter();
+            ++counter.count;
+            counter.bytes += bytes;
+            if (!detail::allocation_counting_installed().load(std::memory_order_relaxed)) {
+                detail::allocation_counting_installed().store(true, std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * @brief Returns the statistics installed on the current thread, or null.
+         */
+        inline LoadStats* current_load_stats() { return detail::load_stats_slot(); }
+
+        /**
+         * @brief Installs `stats` on the current thread for the lifetime of the guard and records the total time and allocations.
+         */
+        class ScopedLoadStats {
+        public:
+            /**
+             * @brief Resets and installs `stats`.
+             */
+            explicit ScopedLoadStats(LoadStats& stats)
+                : m_stats(stats), m_previous(detail::load_stats_slot()), m_start(std::chrono::steady_clock::now()),
+                  m_allocations(detail::allocation_counter()) {
+                m_stats = LoadStats{};
+                detail::load_stats_slot() = &m_stats;
+            }
+
+            ScopedLoadStats(const ScopedLoadStats&) = delete;
+            ScopedLoadStats& operator=(const ScopedLoadStats&) = delete;
+
+            ~ScopedLoadStats() {
+                m_stats.total_time = std::chrono::steady_clock::now() - m_start;
+                if (detail::allocation_counting_installed().load(std::memory_order_relaxed)) {
+                    const auto& counter = detail::allocation_counter();
+                    m_stats.allocations = counter.count - m_allocations.count;
+                    m_stats.allocated_bytes = counter.bytes - m_allocations.bytes;
+                }
+                detail::load_stats_slot() = m_previous;
+            }
+
+        private:
+            LoadStats& m_stats;
+            LoadStats* m_previous;
+            std::chrono::steady_clock::time_point m_start;
+            detail::AllocationCounter m_allocations;
+        };
+
+        /**
+         * @brief Adds the lifetime of the guard to one phase of the installed statistics; does nothing if none are installed.
+         *
+         * @code
+         * const io::LoadPhase phase(&LoadStats::parse_time);
+         * @endcode
+         */
+        class LoadPhase {
+        public:
+            explicit LoadPhase(std::chrono::nanoseconds LoadStats::* phase) : m_stats(current_load_stats()), m_phase(phase) {
+                if (m_stats != nullptr) m_start = std::chrono::steady_clock::now();
+            }
+
+            LoadPhase(const LoadPhase&) = delete;
+            LoadPhase& operator=(const LoadPhase&) = delete;
+
+            ~LoadPhase() {
+                if (m_stats != nullptr) m_stats->*m_phase += std::chrono::steady_clock::now() - m_start;
+            }
+
+        private:
+            LoadStats* m_stats;
+            std::chrono::nanoseconds LoadStats::* m_phase;
+            std::chrono::steady_clock::time_point m_start{};
+        };
+
+        /**
+         * @brief Adds `bytes` to the bytes read of the installed statistics, if any.
+         */
+        inline void note_bytes_read(const std::size_t bytes) {
+            if (LoadStats* stats = current_load_stats()) stats->bytes_read += bytes;
+        }
+    }
+}
+
+/**
+ * @brief Replaces the global `operator new` and `operator delete` with versions that report to `io::note_allocation()`.
+ *
+ * Use at namespace scope in exactly one translation unit of the program. Memory comes from
+ * `std::malloc` / `std::aligned_alloc`; nothrow and sized forms forward to these.
+ */
+#define FOURDST_CONFIG_COUNT_ALLOCATIONS() \
+    void* operator new(std::size_t size) { \
+        fourdst::config::io::note_allocation(size); \
+        if (void* p = std::malloc(size == 0 ? 1 : size)) return p; \
+        throw std::bad_alloc(); \
+    } \
+    void* operator new[](std::size_t size) { return ::operator new(size); } \
+    void* operator new(std::size_t size, std::align_val_t align) { \
+        fourdst::config::io::note_allocation(size); \
+        const auto alignment = static_cast<std::size_t>(align); \
+        if (void* p = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)) return p; \
+        throw std::bad_alloc(); \
+    } \
+    void* operator new[](std::size_t size, std::align_val_t align) { return ::operator new(size, align); } \
+    void operator delete(void* p) noexcept { std::free(p); } \
+    void operator delete[](void* p) noexcept { std::free(p); } \
+    void operator delete(void* p, std::align_val_t) noexcept { std::free(p); } \
+    void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
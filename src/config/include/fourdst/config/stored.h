@@ -0,0 +1,189 @@
+/**
+ * @file stored.h
+ * @brief `Stored<Storage, Parsed>` fields: numbers read as `Parsed` and held in a narrower `Storage` type.
+ *
+ * Tables written in double precision are often only needed in single precision at run time. A
+ * `std::vector<Stored<float>>` member reads the doubles of the file, keeps each element as a
+ * `float`, and so takes half the memory and bandwidth of a `std::vector<double>`:
+ *
+ * @code
+ * struct OpacityConfig {
+ *     std::vector<fourdst::config::Stored<float>> kappa;  // doubles in the file, floats in memory
+ * };
+ *
+ * const float k = cfg->kappa[i];
+ * @endcode
+ *
+ * A value outside the range of `Storage` is a load error rather than an infinity; a value inside
+ * it is rounded to the nearest `Storage`. Saving TOML writes the stored number as the shortest text
+ * that reads back to the same `Storage` value, so a loaded deck saves unchanged; JSON gets the
+ * value widened to `Parsed`. The JSON schema and the deck template name both precisions.
+ *
+ * `Stored` is trivially copyable and has the size and alignment of `Storage`.
+ */
+#pragma once
+
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <expected>
+#include <format>
+#include <limits>
+#include <map>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "rfl.hpp"
+
+namespace fourdst::config {
+
+    namespace detail {
+        /// Numbers a `Stored` field may hold or be read as.
+        template <typename Type>
+        concept StoredNumber = std::is_arithmetic_v<Type> && !std::is_same_v<Type, bool>;
+
+        /**
+         * @brief Names the precision of `Type`, e.g. `float32` or `int16`.
+         */
+        template <StoredNumber Type>
+        consteval std::string_view precision_name() {
+            constexpr std::size_t bits = sizeof(Type) * 8;
+            if constexpr (std::is_floating_point_v<Type>) {
+                if constexpr (bits == 32) return "float32";
+                else if constexpr (bits == 64) return "float64";
+                else return "extended float";
+            } else if constexpr (std::is_signed_v<Type>) {
+                if constexpr (bits == 8) return "int8";
+                else if constexpr (bits == 16) return "int16";
+                else if constexpr (bits == 32) return "int32";
+                else return "int64";
+            } else {
+                if constexpr (bits == 8) return "uint8";
+                else if constexpr (bits == 16) return "uint16";
+                else if constexpr (bits == 32) return "uint32";
+                else return "uint64";
+            }
+        }
+    }
+
+    /**
+     * @brief A number read and written as `Parsed` and held as `Storage`.
+     * @tparam Storage The type the value is kept in, e.g. `float`.
+     * @tparam Parsed The type the value is read as, e.g. `double`.
+     */
+    template <typename Storage, typename Parsed = double>
+    class Stored {
+        static_assert(detail::StoredNumber<Storage> && detail::StoredNumber<Parsed>,
+                      "Stored needs arithmetic, non-bool storage and parsed types.");
+        static_assert(std::is_floating_point_v<Storage> == std::is_floating_point_v<Parsed>,
+                      "Stored cannot mix floating-point and integer types.");
+
+    public:
+        using value_type = Storage;
+        using parsed_type = Parsed;
+
+        /**
+         * @brief Holds zero.
+         */
+        constexpr Stored() = default;
+
+        /**
+         * @brief Holds `value`.
+         */
+        constexpr Stored(const Storage value) : m_value(value) {}  // NOLINT(google-explicit-constructor)
+
+        /**
+         * @brief Returns the stored value.
+         */
+        [[nodiscard]] constexpr Storage value() const noexcept { return m_value; }
+
+        /**
+         * @brief Returns the stored value, widened to `Parsed`.
+         */
+        [[nodiscard]] constexpr Parsed parsed() const noexcept { return static_cast<Parsed>(m_value); }
+
+        constexpr operator Storage() const noexcept { return m_value; }  // NOLINT(google-explicit-constructor)
+
+        constexpr Stored& operator=(const Storage value) noexcept {
+            m_value = value;
+            return *this;
+        }
+
+        /**
+         * @brief Narrows a value read as `Parsed` to `Storage`.
+         * @return The nearest `Storage` value, or a message if `value` is outside its range.
+         */
+        [[nodiscard]] static std::expected<Storage, std::string> narrow(const Parsed value) {
+            if constexpr (std::is_floating_point_v<Storage>) {
+                constexpr auto max = static_cast<Parsed>(std::numeric_limits<Storage>::max());
+                if (std::isfinite(value) && std::abs(value) > max) {
+                    return std::unexpected(std::format("{} is out of range for {} storage", value, precision()));
+                }
+            } else {
+                if (!std::in_range<Storage>(value)) {
+                    return std::unexpected(std::format("{} is out of range for {} storage", value, precision()));
+                }
+            }
+            return static_cast<Storage>(value);
+        }
+
+        /**
+         * @brief Names the precision the value is kept in, e.g. `float32`.
+         */
+        [[nodiscard]] static constexpr std::string_view precision() { return detail::precision_name<Storage>(); }
+
+        /**
+         * @brief Names the precision the value is read in, e.g. `float64`.
+         */
+        [[nodiscard]] static constexpr std::string_view parsed_precision() { return detail::precision_name<Parsed>(); }
+
+    private:
+        Storage m_value{};
+    };
+}
+
+namespace rfl::parsing {
+
+    /**
+     * @brief Reads `Stored<Storage, Parsed>` as a `Parsed` and writes the stored number; the schema names both precisions.
+     */
+    template <class R, class W, class Storage, class Parsed, class ProcessorsType>
+        requires AreReaderAndWriter<R, W, fourdst::config::Stored<Storage, Parsed>>
+    struct Parser<R, W, fourdst::config::Stored<Storage, Parsed>, ProcessorsType> {
+        using InputVarType = typename R::InputVarType;
+        using ValueParser = Parser<R, W, Parsed, ProcessorsType>;
+        using Stored = fourdst::config::Stored<Storage, Parsed>;
+
+        static Result<Stored> read(const R& _r, const InputVarType& _var) noexcept {
+            Parsed number{};
+            if (auto parsed = _r.template to_basic_type<Parsed>(_var)) {
+                number = parsed.value();
+            } else if (auto integer = _r.template to_basic_type<std::int64_t>(_var); integer && std::is_floating_point_v<Parsed>) {
+                number = static_cast<Parsed>(integer.value());
+            } else {
+                return error(std::format("Could not cast the node to a {} number!", Stored::parsed_precision()));
+            }
+            try {
+                const auto narrowed = Stored::narrow(number);
+                if (!narrowed) return error(narrowed.error());
+                return Stored(*narrowed);
+            } catch (const std::exception& e) {
+                return error(e.what());
+            }
+        }
+
+        template <class P>
+        static void write(const W& _w, const Stored& _stored, const P& _parent) {
+            Parser<R, W, Storage, ProcessorsType>::write(_w, _stored.value(), _parent);
+        }
+
+        static schema::Type to_schema(std::map<std::string, schema::Type>* _definitions) {
+            using Type = schema::Type;
+            return Type{Type::Description{
+                .description_ = std::format("Read as {}, stored as {}.", Stored::parsed_precision(), Stored::precision()),
+                .type_ = Ref<Type>::make(ValueParser::to_schema(_definitions))}};
+        }
+    };
+}
@@ -0,0 +1,242 @@
+/**
+ * @file string_store.h
+ * @brief Zero-copy `std::string_view` fields backed by storage a `Config` keeps alive.
+ *
+ * reflect-cpp refuses to read `std::string_view` members, since it has nowhere to put the
+ * characters. The `Parser` specializations below read them for the TOML and JSON readers by
+ * storing the characters in the `StringStore` installed on the current thread with a
+ * `ScopedStringStore`:
+ *
+ * - JSON documents are parsed in place (`YYJSON_READ_INSITU`) from a copy of the source owned
+ *   by the store, so string fields point straight into that copy and nothing is copied per string;
+ * - TOML strings are appended to a monotonic arena owned by the store, so each costs a bump
+ *   allocation rather than a heap allocation.
+ *
+ * `Config<T>` creates a store for every load of a schema that contains `std::string_view`
+ * fields, and every snapshot shares ownership of the store its views point into.
+ *
+ * With interning enabled (see `Config::set_string_interning()`), equal strings are stored once
+ * and every field holding one of them gets the same view, so the tens of thousands of repeated
+ * unit or species names in a large array of tables share one copy and compare equal by pointer.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_set>
+
+#include "fourdst/config/path_table.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+#include "rfl/json.hpp"
+#include "rfl/toml.hpp"
+#include "yyjson.h"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config::io {
+
+    /**
+     * @brief Owns the characters that `std::string_view` fields of loaded content point into.
+     *
+     * A store is filled by one load (and later patches) while the owning `Config` holds its
+     * lock, so it is not synchronized itself. Characters are never freed before the store is.
+     */
+    class StringStore {
+    public:
+        /**
+         * @brief Creates an empty store.
+         * @param interning Whether equal strings share one stored copy.
+         */
+        explicit StringStore(const bool interning = false) : m_interning(interning) {}
+
+        StringStore(const StringStore&) = delete;
+        StringStore& operator=(const StringStore&) = delete;
+
+        /**
+         * @brief Copies a source document into the store, padded for in-place JSON parsing.
+         * @return A mutable pointer to the copy; views into it are returned by `store()` unchanged.
+         */
+        char* retain_source(const std::string_view bytes) {
+            m_source.reserve(bytes.size() + YYJSON_PADDING_SIZE);
+            m_source.assign(bytes);
+            m_source.append(YYJSON_PADDING_SIZE, '\0');
+            return m_source.data();
+        }
+
+        /**
+         * @brief Returns a view of `text` that lives as long as the store.
+         *
+         * Views into the retained source are returned as they are; anything else is copied into
+         * the arena. With interning, a string equal to one stored before returns the earlier view.
+         */
+        std::string_view store(const std::string_view text) {
+            if (m_interning) {
+                if (const auto it = m_interned.find(text); it != m_interned.end()) return *it;
+                const std::string_view stored = place(text);
+                m_interned.insert(stored);
+                return stored;
+            }
+            return place(text);
+        }
+
+        /**
+         * @brief Whether equal strings share one stored copy.
+         */
+        [[nodiscard]] bool interning() const { return m_interning; }
+
+        /**
+         * @brief Returns the number of distinct strings stored with interning (0 without).
+         */
+        [[nodiscard]] std::size_t interned_count() const { return m_interned.size(); }
+
+    private:
+        std::string_view place(const std::string_view text) {
+            if (!m_source.empty() && text.data() >= m_source.data() && text.data() + text.size() <= m_source.data() + m_source.size()) {
+                return text;
+            }
+            if (text.empty()) return {};
+            char* data = static_cast<char*>(m_arena.allocate(text.size(), 1));
+            std::memcpy(data, text.data(), text.size());
+            return {data, text.size()};
+        }
+
+        std::string m_source;
+        std::pmr::monotonic_buffer_resource m_arena;
+        bool m_interning;
+        std::unordered_set<std::string_view> m_interned;
+    };
+
+    namespace detail {
+        inline StringStore*& string_store_slot() {
+            thread_local StringStore* store = nullptr;
+            return store;
+        }
+
+        template <typename Type>
+        struct contains_string_view;
+
+        template <typename Fields>
+        struct fields_contain_string_view;
+
+        template <typename... Fields>
+        struct fields_contain_string_view<rfl::Tuple<Fields...>>
+            : std::bool_constant<(contains_string_view<std::remove_cvref_t<typename Fields::Type>>::value || ...)> {};
+
+        template <typename Type>
+        struct contains_string_view {
+            static constexpr bool compute() {
+                if constexpr (std::is_same_v<Type, std::string_view>) {
+                    return true;
+                } else if constexpr (std::is_arithmetic_v<Type> || std::is_enum_v<Type> || validate::is_std_string_v<Type>) {
+                    return false;
+                } else if constexpr (validate::is_optional_v<Type> || validate::is_vector_v<Type> ||
+                                     config::detail::is_std_array_v<Type>) {
+                    return contains_string_view<std::remove_cvref_t<typename Type::value_type>>::value;
+                } else if constexpr (validate::is_map_v<Type>) {
+                    return contains_string_view<std::remove_cvref_t<typename Type::key_type>>::value ||
+                           contains_string_view<std::remove_cvref_t<typename Type::mapped_type>>::value;
+                } else if constexpr (config::detail::is_path_struct_v<Type>) {
+                    return fields_contain_string_view<typename rfl::named_tuple_t<Type>::Fields>::value;
+                } else {
+                    return false;
+                }
+            }
+            static constexpr bool value = compute();
+        };
+    }
+
+    /// Whether a schema has `std::string_view` fields, anywhere in its nesting.
+    template <typename Type>
+    constexpr bool contains_string_view_v = detail::contains_string_view<std::remove_cvref_t<Type>>::value;
+
+    /**
+     * @brief Returns the store installed on the current thread, or null.
+     */
+    inline StringStore* current_string_store() { return detail::string_store_slot(); }
+
+    /**
+     * @brief Installs a string store on the current thread for the lifetime of the guard.
+     */
+    class ScopedStringStore {
+    public:
+        /**
+         * @brief Installs `store`; null keeps the current one.
+         */
+        explicit ScopedStringStore(StringStore* store) : m_previous(detail::string_store_slot()) {
+            if (store != nullptr) detail::string_store_slot() = store;
+        }
+
+        ScopedStringStore(const ScopedStringStore&) = delete;
+        ScopedStringStore& operator=(const ScopedStringStore&) = delete;
+
+        ~ScopedStringStore() { detail::string_store_slot() = m_previous; }
+
+    private:
+        StringStore* m_previous;
+    };
+
+    namespace detail {
+        inline rfl::Result<std::string_view> store_string_view(const char* data, const std::size_t size) {
+            StringStore* store = current_string_store();
+            if (store == nullptr) {
+                return rfl::error("std::string_view fields can only be read by fourdst::config::Config, which owns their storage.");
+            }
+            return store->store({data, size});
+        }
+    }
+}
+
+namespace rfl::parsing {
+
+    /**
+     * @brief Reads `std::string_view` fields from TOML into the current `io::StringStore`.
+     */
+    template <class ProcessorsType>
+    struct Parser<rfl::toml::Reader, rfl::toml::Writer, std::string_view, ProcessorsType> {
+        using InputVarType = typename rfl::toml::Reader::InputVarType;
+
+        static Result<std::string_view> read(const rfl::toml::Reader&, const InputVarType& _var) noexcept {
+            const auto* value = _var->as<std::string>();
+            if (value == nullptr) return error("Could not cast to string.");
+            return fourdst::config::io::detail::store_string_view(value->get().data(), value->get().size());
+        }
+
+        template <class P>
+        static void write(const rfl::toml::Writer& _w, const std::string_view& _str, const P& _p) {
+            Parser<rfl::toml::Reader, rfl::toml::Writer, std::string, ProcessorsType>::write(_w, std::string(_str), _p);
+        }
+
+        static schema::Type to_schema(std::map<std::string, schema::Type>* _definitions) {
+            return Parser<rfl::toml::Reader, rfl::toml::Writer, std::string, ProcessorsType>::to_schema(_definitions);
+        }
+    };
+
+    /**
+     * @brief Reads `std::string_view` fields from JSON into the current `io::StringStore`.
+     */
+    template <class ProcessorsType>
+    struct Parser<rfl::json::Reader, rfl::json::Writer, std::string_view, ProcessorsType> {
+        using InputVarType = typename rfl::json::Reader::InputVarType;
+
+        static Result<std::string_view> read(const rfl::json::Reader&, const InputVarType& _var) noexcept {
+            if (!yyjson_is_str(_var.val_)) return error("Could not cast to string.");
+            return fourdst::config::io::detail::store_string_view(yyjson_get_str(_var.val_), yyjson_get_len(_var.val_));
+        }
+
+        template <class P>
+        static void write(const rfl::json::Writer& _w, const std::string_view& _str, const P& _p) {
+            Parser<rfl::json::Reader, rfl::json::Writer, std::string, ProcessorsType>::write(_w, std::string(_str), _p);
+        }
+
+        static schema::Type to_schema(std::map<std::string, schema::Type>* _definitions) {
+            return Parser<rfl::json::Reader, rfl::json::Writer, std::string, ProcessorsType>::to_schema(_definitions);
+        }
+    };
+}
@@ -0,0 +1,294 @@
+/**
+ * @file sweep.h
+ * @brief Parameter sweeps: variants of one base config that each override a few fields.
+ *
+ * A `Sweep<T>` takes a base snapshot and a list of axes, each a field path with the values it
+ * takes, and describes one variant per combination of axis values. The axes are combined as a
+ * cartesian product (every combination) or zipped (the i-th value of every axis together):
+ *
+ * @code
+ * fourdst::config::Sweep<DeckSchema> sweep(base_cfg);
+ * sweep.axis("physics.metallicity", {0.001, 0.01, 0.02})
+ *      .axis("physics.mixing_length", {1.6, 1.8, 2.0, 2.2});
+ *
+ * for (const auto& variant : sweep) {        // 12 variants
+ *     variant.save(std::format("decks/member_{}.toml", variant.index()));
+ * }
+ * @endcode
+ *
+ * Variants are lazy: every variant shares the base snapshot and the axis values, and holds only
+ * its position on each axis, so a campaign of thousands of members costs no more than its axes
+ * until a member is used. `materialize()` copies the base and assigns the overridden fields,
+ * `config()` wraps that copy in a `Config<T>`, and `save()` writes it.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <format>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/base.h"
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/path_table.h"
+
+namespace fourdst::config {
+
+    /**
+     * @brief How the axes of a `Sweep` are combined.
+     */
+    enum class SweepMode {
+        /// One variant per combination of axis values; the last axis varies fastest.
+        CARTESIAN,
+        /// One variant per position; every axis must have the same number of values.
+        ZIPPED
+    };
+
+    template <IsConfigSchema T>
+    class Sweep;
+
+    /**
+     * @brief One variant of a `Sweep`: the base config with one value of each axis assigned.
+     *
+     * Cheap to copy; holds the shared base and axes and its position on each axis.
+     */
+    template <IsConfigSchema T>
+    class SweepVariant {
+    public:
+        /**
+         * @brief Returns the position of the variant in its sweep.
+         */
+        [[nodiscard]] std::size_t index() const { return m_index; }
+
+        /**
+         * @brief Returns the base content the variant overrides.
+         */
+        [[nodiscard]] const T& base() const { return *m_plan->base; }
+
+        /**
+         * @brief Returns the fields the variant overrides, as `path=value` strings, in axis order.
+         */
+        [[nodiscard]] std::vector<std::string> overrides() const {
+            std::vector<std::string> out;
+            out.reserve(m_plan->axes.size());
+            for (std::size_t a = 0; a < m_plan->axes.size(); ++a) {
+                const auto& axis = m_plan->axes[a];
+                out.push_back(std::format("{}={}", axis.path, axis.format(m_coordinates[a])));
+            }
+            return out;
+        }
+
+        /**
+         * @brief Assigns the overridden fields of the variant in `content`.
+         */
+        void apply(T& content) const {
+            for (std::size_t a = 0; a < m_plan->axes.size(); ++a) {
+                m_plan->axes[a].assign(content, m_coordinates[a]);
+            }
+        }
+
+        /**
+         * @brief Returns a copy of the base content with the overridden fields assigned.
+         */
+        [[nodiscard]] T materialize() const {
+            T content = *m_plan->base;
+            apply(content);
+            return content;
+        }
+
+        /**
+         * @brief Returns a config holding the variant as its defaults (see `Config(T)`).
+         */
+        [[nodiscard]] Config<T> config() const { return Config<T>(materialize()); }
+
+        /**
+         * @brief Writes the variant to `path`, as `Config::save()` would.
+         * @throws exceptions::ConfigSaveError If the file cannot be written.
+         */
+        void save(const std::string_view path, const SaveMode mode = SaveMode::FULL,
+                  const SavePolicy policy = SavePolicy::IN_PLACE) const {
+            config().save(path, mode, policy);
+        }
+
+    private:
+        friend class Sweep<T>;
+
+        struct Axis {
+            std::string path;
+            std::size_t size = 0;
+            std::function<void(T&, std::size_t)> assign;
+            std::function<std::string(std::size_t)> format;
+        };
+
+        /// What every variant of a sweep shares.
+        struct Plan {
+            std::shared_ptr<const T> base;
+            std::vector<Axis> axes;
+        };
+
+        SweepVariant(std::shared_ptr<const Plan> plan, const std::size_t index, std::vector<std::size_t> coordinates)
+            : m_plan(std::move(plan)), m_index(index), m_coordinates(std::move(coordinates)) {}
+
+        std::shared_ptr<const Plan> m_plan;
+        std::size_t m_index = 0;
+        std::vector<std::size_t> m_coordinates;
+    };
+
+    /**
+     * @brief Variants of a base config over axes of field values.
+     * @tparam T The configuration schema type.
+     */
+    template <IsConfigSchema T>
+    class Sweep {
+        using Plan = typename SweepVariant<T>::Plan;
+        using Axis = typename SweepVariant<T>::Axis;
+
+    public:
+        /**
+         * @brief Sweeps around the currently published snapshot of `base`.
+         */
+        explicit Sweep(const Config<T>& base, const SweepMode mode = SweepMode::CARTESIAN) : Sweep(base.snapshot(), mode) {}
+
+        /**
+         * @brief Sweeps around `base`.
+         */
+        explicit Sweep(std::shared_ptr<const T> base, const SweepMode mode = SweepMode::CARTESIAN)
+            : m_plan(std::make_shared<const Plan>(Plan{std::move(base), {}})), m_mode(mode) {}
+
+        /**
+         * @brief Adds an axis assigning each of `values` to the field at `path`.
+         *
+         * String literals are accepted for `std::string` fields; other values must match the
+         * declared type exactly, as for `Config::set()`. Variants made before the call are not affected.
+         *
+         * @throws exceptions::ConfigPathError If `path` does not name a field, or the field is of another type.
+         * @throws exceptions::ConfigError If the sweep is zipped and `values` has another length than the earlier axes.
+         */
+        template <typename V>
+        Sweep& axis(const std::string_view path, std::vector<V> values) {
+            using Field = std::conditional_t<std::is_convertible_v<V, std::string_view> && !std::is_same_v<V, std::string_view>,
+                                             std::string, V>;
+            using Table = detail::PathTable<T>;
+            const std::size_t index = Table::find(path);
+            if (index == Table::npos) {
+                throw exceptions::ConfigPathError(std::format("No field at path '{}' in the configuration schema.", path));
+            }
+            const auto& entry = Table::entry(index);
+            if (entry.type != detail::path_type_id<Field>()) {
+                throw exceptions::ConfigPathError(std::format("Field at path '{}' is not of the requested type.", path));
+            }
+            if (m_mode == SweepMode::ZIPPED && !m_plan->axes.empty() && values.size() != m_plan->axes.front().size) {
+                throw exceptions::ConfigError(std::format("Zipped sweep axis '{}' has {} values, but the axes before it have {}.",
+                                                          path, values.size(), m_plan->axes.front().size));
+            }
+
+            auto shared = std::make_shared<const std::vector<Field>>(values.begin(), values.end());
+            Axis axis{std::string(path), shared->size(),
+                      [shared, address = entry.address](T& content, const std::size_t i) {
+                          *static_cast<Field*>(const_cast<void*>(address(content))) = (*shared)[i];
+                      },
+                      [shared](const std::size_t i) { return describe((*shared)[i]); }};
+
+            // Copy on write: variants already handed out keep the plan they were made from.
+            auto plan = std::make_shared<Plan>(*m_plan);
+            plan->axes.push_back(std::move(axis));
+            m_plan = std::move(plan);
+            return *this;
+        }
+
+        /**
+         * @brief Adds an axis from a braced list, e.g. `axis("physics.metallicity", {0.01, 0.02})`.
+         */
+        template <typename V>
+        Sweep& axis(const std::string_view path, const std::initializer_list<V> values) {
+            return axis(path, std::vector<V>(values));
+        }
+
+        /**
+         * @brief Returns the number of variants; 1 (the base) when there are no axes.
+         */
+        [[nodiscard]] std::size_t size() const {
+            if (m_plan->axes.empty()) return 1;
+            if (m_mode == SweepMode::ZIPPED) return m_plan->axes.front().size;
+            std::size_t count = 1;
+            for (const auto& axis : m_plan->axes) count *= axis.size;
+            return count;
+        }
+
+        /**
+         * @brief Returns variant `i`; requires `i < size()`.
+         */
+        [[nodiscard]] SweepVariant<T> operator[](const std::size_t i) const {
+            std::vector<std::size_t> coordinates(m_plan->axes.size());
+            if (m_mode == SweepMode::ZIPPED) {
+                std::fill(coordinates.begin(), coordinates.end(), i);
+            } else {
+                std::size_t remainder = i;
+                for (std::size_t a = coordinates.size(); a-- > 0;) {
+                    coordinates[a] = remainder % m_plan->axes[a].size;
+                    remainder /= m_plan->axes[a].size;
+                }
+            }
+            return SweepVariant<T>(m_plan, i, std::move(coordinates));
+        }
+
+        /**
+         * @brief Iterates over the variants in index order.
+         */
+        class Iterator {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = SweepVariant<T>;
+            using difference_type = std::ptrdiff_t;
+
+            Iterator() = default;
+            Iterator(const Sweep* sweep, const std::size_t index) : m_sweep(sweep), m_index(index) {}
+
+            value_type operator*() const { return (*m_sweep)[m_index]; }
+            Iterator& operator++() {
+                ++m_index;
+                return *this;
+            }
+            Iterator operator++(int) {
+                Iterator previous = *this;
+                ++m_index;
+                return previous;
+            }
+            bool operator==(const Iterator& other) const { return m_index == other.m_index; }
+
+        private:
+            const Sweep* m_sweep = nullptr;
+            std::size_t m_index = 0;
+        };
+
+        [[nodiscard]] Iterator begin() const { return Iterator(this, 0); }
+        [[nodiscard]] Iterator end() const { return Iterator(this, size()); }
+
+    private:
+        template <typename V>
+        static std::string describe(const V& value) {
+            if constexpr (std::is_same_v<V, bool>) {
+                return value ? "true" : "false";
+            } else if constexpr (std::is_arithmetic_v<V>) {
+                return std::format("{}", value);
+            } else if constexpr (std::is_enum_v<V>) {
+                return std::string(rfl::enum_to_string(value));
+            } else if constexpr (std::is_same_v<V, std::string>) {
+                return value;
+            } else {
+                return "<value>";
+            }
+        }
+
+        std::shared_ptr<const Plan> m_plan;
+        SweepMode m_mode;
+    };
+}
@@ -0,0 +1,210 @@
+/**
+ * @file tagged_union.h
+ * @brief `rfl::TaggedUnion` fields: one table whose discriminator key selects the alternative struct.
+ *
+ * Solvers, equations of state and other pluggable parts are configured with a table whose
+ * parameters depend on which implementation it names:
+ *
+ * @code
+ * struct Newton { double tolerance = 1e-8; int max_iterations = 50; };
+ * struct Picard { double relaxation = 0.5; };
+ * struct SolverConfig {
+ *     rfl::TaggedUnion<"type", Newton, Picard> solver = Newton{};
+ * };
+ *
+ * // [main.solver]
+ * // type = "Picard"
+ * // relaxation = 0.3
+ * @endcode
+ *
+ * The tags of an alternative are those rfl gives it: the values of its discriminator field when it
+ * has one (an `rfl::Literal`), its `Tag` type, or else its type name. `TagIndex` hashes every tag
+ * of a union at compile time, so reading or validating such a table looks up its discriminator
+ * once, in constant time, and reads or checks only the alternative it names; no alternative is
+ * tried and discarded. The validator reports the missing and unknown keys of that alternative,
+ * naming the tag, and an unknown tag with the accepted ones. The JSON schema lists each
+ * alternative with its discriminator, as reflect-cpp writes it.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <map>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "fourdst/config/path_table.h"
+
+#include "rfl.hpp"
+#include "rfl/toml.hpp"
+
+namespace fourdst::config::detail {
+
+    template <typename Literal>
+    struct literal_tags;
+
+    template <rfl::internal::StringLiteral... Names>
+    struct literal_tags<rfl::Literal<Names...>> {
+        static constexpr std::array<std::string_view, sizeof...(Names)> values{Names.string_view()...};
+    };
+
+    /// The tags rfl accepts for `Alternative` in a union discriminated by `Discriminator`.
+    template <rfl::internal::StringLiteral Discriminator, typename Alternative>
+    constexpr const auto& alternative_tags =
+        literal_tags<std::remove_cvref_t<rfl::internal::tag_t<Discriminator, Alternative>>>::values;
+
+    /**
+     * @brief The compile-time tag table of an `rfl::TaggedUnion`: every tag of every alternative, perfectly hashed.
+     */
+    template <rfl::internal::StringLiteral Discriminator, typename... Alternatives>
+    struct TagIndex<rfl::TaggedUnion<Discriminator, Alternatives...>> {
+        /// Sentinel returned by `find()` for unknown tags.
+        static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+        /// The key holding the tag.
+        static constexpr std::string_view discriminator = Discriminator.string_view();
+
+        static constexpr std::size_t tag_count = (alternative_tags<Discriminator, Alternatives>.size() + ...);
+
+    private:
+        struct Entry {
+            std::string_view tag;
+            std::size_t alternative = 0;
+        };
+
+        static constexpr std::array<Entry, tag_count> s_entries = [] {
+            std::array<Entry, tag_count> entries{};
+            std::size_t next = 0;
+            std::size_t alternative = 0;
+            ([&] {
+                for (const std::string_view tag : alternative_tags<Discriminator, Alternatives>) entries[next++] = {tag, alternative};
+                ++alternative;
+            }(), ...);
+            return entries;
+        }();
+
+        static constexpr PerfectHash<tag_count> s_hash = [] {
+            std::array<std::uint64_t, tag_count> hashes{};
+            for (std::size_t i = 0; i < tag_count; ++i) hashes[i] = path_hash(s_entries[i].tag);
+            return PerfectHash<tag_count>::build(hashes);
+        }();
+
+        static_assert(s_hash.perfect, "Unable to build a perfect hash for the tags of this tagged union.");
+
+    public:
+        /**
+         * @brief Returns the index of the alternative `tag` selects, or `npos`.
+         */
+        static constexpr std::size_t find(const std::string_view tag) {
+            const std::size_t slot = s_hash.candidate(path_hash(tag));
+            if (slot == 0 || s_entries[slot - 1].tag != tag) return npos;
+            return s_entries[slot - 1].alternative;
+        }
+
+        /**
+         * @brief Returns the accepted tags, comma-separated, in alternative order.
+         */
+        static std::string allowed() {
+            std::string out;
+            for (const Entry& entry : s_entries) {
+                if (!out.empty()) out += ", ";
+                out += entry.tag;
+            }
+            return out;
+        }
+
+        /**
+         * @brief Calls `fn(std::type_identity<Alternative>{})` for the alternative at `index`, through a table of function pointers.
+         * @return What `fn` returns; the same type for every alternative.
+         */
+        template <typename Fn>
+        static decltype(auto) dispatch(const std::size_t index, Fn&& fn) {
+            using First = std::variant_alternative_t<0, std::variant<Alternatives...>>;
+            using Result = decltype(fn(std::type_identity<First>{}));
+            static constexpr std::array<Result (*)(Fn&), sizeof...(Alternatives)> table{
+                +[](Fn& f) -> Result { return f(std::type_identity<Alternatives>{}); }...};
+            return table[index](fn);
+        }
+    };
+}
+
+namespace rfl::parsing {
+
+    /**
+     * @brief Reads `rfl::TaggedUnion` from TOML by one hashed lookup of its discriminator.
+     *
+     * reflect-cpp compares the discriminator with the tags of each alternative in turn; this
+     * specialization finds the alternative with `TagIndex` and reads only that one. Writing and
+     * the schema follow reflect-cpp: alternatives without a discriminator field get the tag added.
+     */
+    template <internal::StringLiteral Discriminator, class... Alternatives, class ProcessorsType>
+    struct Parser<rfl::toml::Reader, rfl::toml::Writer, TaggedUnion<Discriminator, Alternatives...>, ProcessorsType> {
+        using R = rfl::toml::Reader;
+        using W = rfl::toml::Writer;
+        using Union = TaggedUnion<Discriminator, Alternatives...>;
+        using Index = fourdst::config::detail::TagIndex<Union>;
+        using InputVarType = typename R::InputVarType;
+
+        static Result<Union> read(const R& _r, const InputVarType& _var) noexcept {
+            const ::toml::table* table = _var->as_table();
+            if (table == nullptr) return error("Could not parse tagged union: expected a table.");
+            const auto* tag = table->get_as<std::string>(Index::discriminator);
+            if (tag == nullptr) {
+                return error(std::format("Could not parse tagged union: Could not find field '{}' or type of field was not a string.",
+                                         Index::discriminator));
+            }
+            const std::string_view value = tag->get();
+            const std::size_t alternative = Index::find(value);
+            if (alternative == Index::npos) {
+                return error(std::format("Could not parse tagged union, could not match {} '{}'. The following tags are allowed: {}",
+                                         Index::discriminator, value, Index::allowed()));
+            }
+            return Index::dispatch(alternative, [&]<class Alternative>(std::type_identity<Alternative>) -> Result<Union> {
+                auto parsed = Parser<R, W, Alternative, ProcessorsType>::read(_r, _var);
+                if (!parsed) {
+                    return error(std::format("Could not parse tagged union with discrimininator {} '{}': {}", Index::discriminator,
+                                             value, parsed.error().what()));
+                }
+                return Union(std::move(*parsed));
+            });
+        }
+
+        template <class P>
+        static void write(const W& _w, const Union& _union, const P& _parent) {
+            rfl::visit(
+                [&](const auto& _value) {
+                    const auto wrapped = wrap(_value);
+                    Parser<R, W, std::remove_cvref_t<decltype(wrapped)>, ProcessorsType>::write(_w, wrapped, _parent);
+                },
+                _union.variant());
+        }
+
+        static schema::Type to_schema(std::map<std::string, schema::Type>* _definitions) {
+            using Wrapped = std::variant<std::remove_cvref_t<decltype(wrap(std::declval<const Alternatives&>()))>...>;
+            return Parser<R, W, Wrapped, ProcessorsType>::to_schema(_definitions);
+        }
+
+    private:
+        /// Adds the tag to alternatives that do not hold it as a field, as reflect-cpp does.
+        template <class Alternative>
+        static auto wrap(const Alternative& _value) {
+            if constexpr (named_tuple_t<Alternative>::Names::template contains<Discriminator>()) {
+                return _value;
+            } else {
+                const auto tag = internal::make_tag<Discriminator, Alternative>(_value);
+                using Tag = std::remove_cvref_t<decltype(tag)>;
+                if constexpr (internal::has_fields<Alternative>()) {
+                    return TaggedUnionWrapperWithFields<Alternative, Tag, Discriminator>{.tag = tag, .fields = &_value};
+                } else {
+                    return TaggedUnionWrapperNoFields<Alternative, Tag, Discriminator>{.tag = tag, .fields = &_value};
+                }
+            }
+        }
+    };
+}
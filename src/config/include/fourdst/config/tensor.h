@@ -0,0 +1,307 @@
+/**
+ * @file tensor.h
+ * @brief `Tensor<T, Rank>` fields: multidimensional numeric tables in one contiguous buffer.
+ *
+ * Opacity and EOS tables stored as `std::vector<std::vector<double>>` cost one allocation per
+ * row and cannot be swept as a single block. A `Tensor<double, 2>` holds the same table in
+ * row-major order in one `std::vector<double>` and is indexed with `operator()`, or viewed as a
+ * `std::mdspan` where the standard library provides one:
+ *
+ * @code
+ * struct OpacityConfig {
+ *     fourdst::config::Tensor<double, 2> log_kappa;
+ * };
+ *
+ * const double k = cfg->log_kappa(i_rho, i_T);
+ * @endcode
+ *
+ * In TOML the field is written as nested arrays, `[[1.0, 2.0], [3.0, 4.0]]`, and read back
+ * straight into the buffer; every nested array must have the length of the first one at its
+ * depth, so ragged input is rejected with the path of the offending array. With a sidecar
+ * threshold set, large tensors go to `.npy` files with their full shape (see `sidecar.h`), and
+ * other formats read and write the nested-array form.
+ */
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <format>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <version>
+#if defined(__cpp_lib_mdspan)
+#include <mdspan>
+#endif
+
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/fixed_array.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+#include "rfl/toml.hpp"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config {
+
+    namespace detail {
+        template <typename T, std::size_t Rank>
+        struct nested_vector {
+            using type = std::vector<typename nested_vector<T, Rank - 1>::type>;
+        };
+
+        template <typename T>
+        struct nested_vector<T, 1> {
+            using type = std::vector<T>;
+        };
+
+        /// `std::vector<std::vector<...<T>>>` with `Rank` levels, the form other formats use for tensors.
+        template <typename T, std::size_t Rank>
+        using nested_vector_t = typename nested_vector<T, Rank>::type;
+    }
+
+    /**
+     * @brief A `Rank`-dimensional array of `T` stored contiguously in row-major order.
+     * @tparam T An arithmetic element type other than `bool`.
+     * @tparam Rank The number of dimensions, at least 1.
+     */
+    template <typename T, std::size_t Rank>
+    class Tensor {
+        static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "Tensor elements must be numbers.");
+        static_assert(Rank >= 1, "Tensor needs at least one dimension.");
+
+    public:
+        using value_type = T;
+        using extents_type = std::array<std::size_t, Rank>;
+        static constexpr std::size_t rank = Rank;
+#if defined(__cpp_lib_mdspan)
+        using mdspan_type = std::mdspan<T, std::dextents<std::size_t, Rank>>;
+        using const_mdspan_type = std::mdspan<const T, std::dextents<std::size_t, Rank>>;
+#endif
+
+        /**
+         * @brief An empty tensor; every extent is 0.
+         */
+        Tensor() = default;
+
+        /**
+         * @brief A tensor of shape `extents` with every element set to `value`.
+         */
+        explicit Tensor(const extents_type& extents, const T value = T{}) : m_extents(extents), m_data(count(extents), value) {}
+
+        /**
+         * @brief A tensor of shape `extents` holding `values` in row-major order.
+         * @throws exceptions::ConfigError If `values` does not have one element per entry of the shape.
+         */
+        Tensor(const extents_type& extents, std::vector<T> values) : m_extents(extents), m_data(std::move(values)) {
+            if (m_data.size() != count(extents)) {
+                throw exceptions::ConfigError(std::format("Tensor of {} elements cannot hold {} values.", count(extents), m_data.size()));
+            }
+        }
+
+        /**
+         * @brief Builds a tensor from nested vectors.
+         * @throws exceptions::ConfigParseError If the nested vectors are not rectangular.
+         */
+        static Tensor from_nested(const detail::nested_vector_t<T, Rank>& nested) {
+            Tensor tensor;
+            nested_extents<0>(nested, tensor.m_extents);
+            tensor.m_data.reserve(count(tensor.m_extents));
+            tensor.flatten<0>(nested, "");
+            return tensor;
+        }
+
+        /**
+         * @brief Copies the tensor into nested vectors.
+         */
+        [[nodiscard]] detail::nested_vector_t<T, Rank> to_nested() const {
+            std::size_t offset = 0;
+            return nest<0>(offset);
+        }
+
+        [[nodiscard]] const extents_type& extents() const { return m_extents; }
+        [[nodiscard]] std::size_t extent(const std::size_t dimension) const { return m_extents[dimension]; }
+        /// The total number of elements.
+        [[nodiscard]] std::size_t size() const { return m_data.size(); }
+        [[nodiscard]] bool empty() const { return m_data.empty(); }
+
+        [[nodiscard]] T* data() { return m_data.data(); }
+        [[nodiscard]] const T* data() const { return m_data.data(); }
+
+        /// All elements in row-major order.
+        [[nodiscard]] std::span<T> values() { return m_data; }
+        [[nodiscard]] std::span<const T> values() const { return m_data; }
+
+        /**
+         * @brief Changes the shape to `extents`; the element values are unspecified afterwards.
+         */
+        void resize(const extents_type& extents) {
+            m_extents = extents;
+            m_data.resize(count(extents));
+        }
+
+        template <typename... Indices>
+            requires(sizeof...(Indices) == Rank && (std::convertible_to<Indices, std::size_t> && ...))
+        T& operator()(const Indices... indices) {
+            return m_data[offset_of(indices...)];
+        }
+
+        template <typename... Indices>
+            requires(sizeof...(Indices) == Rank && (std::convertible_to<Indices, std::size_t> && ...))
+        const T& operator()(const Indices... indices) const {
+            return m_data[offset_of(indices...)];
+        }
+
+#if defined(__cpp_lib_mdspan)
+        [[nodiscard]] mdspan_type view() { return mdspan_type(m_data.data(), m_extents); }
+        [[nodiscard]] const_mdspan_type view() const { return const_mdspan_type(m_data.data(), m_extents); }
+#endif
+
+        friend bool operator==(const Tensor& lhs, const Tensor& rhs) = default;
+
+    private:
+        static std::size_t count(const extents_type& extents) {
+            std::size_t total = 1;
+            for (const std::size_t extent : extents) total *= extent;
+            return total;
+        }
+
+        template <typename... Indices>
+        std::size_t offset_of(const Indices... indices) const {
+            const std::array<std::size_t, Rank> index{static_cast<std::size_t>(indices)...};
+            std::size_t offset = 0;
+            for (std::size_t d = 0; d < Rank; ++d) offset = offset * m_extents[d] + index[d];
+            return offset;
+        }
+
+        template <std::size_t D, typename Level>
+        static void nested_extents(const Level& level, extents_type& extents) {
+            extents[D] = level.size();
+            if constexpr (D + 1 < Rank) {
+                if (!level.empty()) nested_extents<D + 1>(level.front(), extents);
+            }
+        }
+
+        template <std::size_t D, typename Level>
+        void flatten(const Level& level, const std::string& where) {
+            if (level.size() != m_extents[D]) {
+                throw exceptions::ConfigParseError(std::format("Tensor is not rectangular: {} has {} elements, expected {}.",
+                                                               where.empty() ? "the outer array" : where, level.size(), m_extents[D]));
+            }
+            if constexpr (D + 1 == Rank) {
+                m_data.insert(m_data.end(), level.begin(), level.end());
+            } else {
+                for (std::size_t i = 0; i < level.size(); ++i) flatten<D + 1>(level[i], std::format("{}[{}]", where, i));
+            }
+        }
+
+        template <std::size_t D>
+        detail::nested_vector_t<T, Rank - D> nest(std::size_t& offset) const {
+            detail::nested_vector_t<T, Rank - D> level;
+            level.reserve(m_extents[D]);
+            for (std::size_t i = 0; i < m_extents[D]; ++i) {
+                if constexpr (D + 1 == Rank) {
+                    level.push_back(m_data[offset++]);
+                } else {
+                    level.push_back(nest<D + 1>(offset));
+                }
+            }
+            return level;
+        }
+
+        extents_type m_extents{};
+        std::vector<T> m_data;
+    };
+}
+
+namespace rfl {
+
+    /**
+     * @brief Reads and writes `Tensor<T, Rank>` as nested arrays in formats without a tensor reader.
+     */
+    template <typename T, std::size_t Rank>
+    struct Reflector<fourdst::config::Tensor<T, Rank>> {
+        using ReflType = fourdst::config::detail::nested_vector_t<T, Rank>;
+
+        static fourdst::config::Tensor<T, Rank> to(const ReflType& value) {
+            return fourdst::config::Tensor<T, Rank>::from_nested(value);
+        }
+
+        static ReflType from(const fourdst::config::Tensor<T, Rank>& value) { return value.to_nested(); }
+    };
+}
+
+namespace rfl::parsing {
+
+    /**
+     * @brief Reads `Tensor<T, Rank>` from nested TOML arrays straight into its buffer, rejecting ragged input.
+     *
+     * The shape is taken from the first array at each depth. An array of another length is
+     * recorded as an `io::ArraySizeMismatch`, so `Config` reports it with its path.
+     */
+    template <class T, std::size_t Rank, class ProcessorsType>
+    struct Parser<rfl::toml::Reader, rfl::toml::Writer, fourdst::config::Tensor<T, Rank>, ProcessorsType> {
+        using InputVarType = typename rfl::toml::Reader::InputVarType;
+        using ElementParser = Parser<rfl::toml::Reader, rfl::toml::Writer, T, ProcessorsType>;
+        using NestedParser = Parser<rfl::toml::Reader, rfl::toml::Writer, fourdst::config::detail::nested_vector_t<T, Rank>, ProcessorsType>;
+        using Tensor = fourdst::config::Tensor<T, Rank>;
+
+        static Result<Tensor> read(const rfl::toml::Reader& _r, const InputVarType& _var) noexcept {
+            typename Tensor::extents_type extents{};
+            ::toml::node* probe = _var;
+            for (std::size_t d = 0; d < Rank; ++d) {
+                ::toml::array* array = probe->as_array();
+                if (array == nullptr) return error("Could not cast to an array!");
+                extents[d] = array->size();
+                if (array->empty()) break;
+                probe = array->get(0);
+            }
+
+            try {
+                Result<Tensor> result = Tensor(extents);
+                T* out = result.value().data();
+                if (auto failed = fill(_r, _var, 0, extents, out)) return error(*failed);
+                return result;
+            } catch (const std::exception& e) {
+                return error(e.what());
+            }
+        }
+
+        template <class P>
+        static void write(const rfl::toml::Writer& _w, const Tensor& _tensor, const P& _parent) {
+            NestedParser::write(_w, _tensor.to_nested(), _parent);
+        }
+
+        static schema::Type to_schema(std::map<std::string, schema::Type>* _definitions) {
+            return NestedParser::to_schema(_definitions);
+        }
+
+    private:
+        static std::optional<std::string> fill(const rfl::toml::Reader& _r, ::toml::node* node, const std::size_t depth,
+                                               const typename Tensor::extents_type& extents, T*& out) {
+            ::toml::array* array = node->as_array();
+            if (array == nullptr) return std::string("Could not cast to an array!");
+            if (array->size() != extents[depth]) {
+                const fourdst::config::io::ArraySizeMismatch mismatch{node, extents[depth], array->size()};
+                fourdst::config::io::last_array_size_mismatch() = mismatch;
+                return mismatch.message();
+            }
+            for (std::size_t i = 0; i < array->size(); ++i) {
+                if (depth + 1 == Rank) {
+                    auto element = ElementParser::read(_r, array->get(i));
+                    if (!element) return std::format("Failed to parse element {}: {}", i, element.error().what());
+                    *out++ = *element;
+                } else if (auto failed = fill(_r, array->get(i), depth + 1, extents, out)) {
+                    return failed;
+                }
+            }
+            return std::nullopt;
+        }
+    };
+}
@@ -0,0 +1,1231 @@
+/**
+ * @file toml_stream.h
+ * @brief Event-driven TOML parsing, and reading a schema from the events without a document.
+ *
+ * `toml::parse` builds the whole document before anything is deserialized, which for a
+ * generated deck of several gigabytes needs a multiple of the file size in memory.
+ * `TomlEventParser` reads the input in fixed-size chunks instead and reports what it finds to a
+ * handler as it goes:
+ *
+ * - `on_table(path, array_element)` for a `[a.b]` header, or a `[[a.b]]` header when `array_element`;
+ * - `on_key(path)` for the (dotted) key of a key/value pair, relative to the current table or
+ *   inline table; exactly one value follows it;
+ * - `on_value(value)` for a string, integer, float, boolean or date-time;
+ * - `on_array_begin()` / `on_array_end()` around the values of an array;
+ * - `on_inline_table_begin()` / `on_inline_table_end()` around the pairs of an inline table.
+ *
+ * Key segments and string values are only valid during the call that receives them. The parser
+ * holds one chunk of input, the segments of one key and the text of one value at a time.
+ *
+ * `read_toml_stream<T>()` connects the parser to a handler that writes each value straight into
+ * its field of a `T`, found by reflection, so peak memory is the destination plus O(nesting
+ * depth). `Config::load()` uses it under `FileReadPolicy::STREAMING`:
+ *
+ * @code
+ * cfg.set_file_read_policy(fourdst::config::FileReadPolicy::STREAMING);
+ * cfg.load("generated_deck.toml");
+ * @endcode
+ *
+ * The reader supports structs, optionals, vectors, fixed-size arrays, string- or integer-keyed
+ * maps, numbers, booleans, strings, enums, `Tunable`, `Quantity` and `Stored` fields (`is_event_readable_v`),
+ * in structs without `field_aliases`.
+ * A later value of a key replaces an earlier one instead of being reported as a redefinition.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <istream>
+#include <limits>
+#include <map>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/enum_index.h"
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/path_table.h"
+#include "fourdst/config/provenance.h"
+#include "fourdst/config/quantity.h"
+#include "fourdst/config/stored.h"
+#include "fourdst/config/tunable.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+
+namespace fourdst::config::io {
+
+    /**
+     * @brief A scalar value reported by `TomlEventParser`.
+     */
+    struct TomlValue {
+        enum class Kind : std::uint8_t { STRING, INTEGER, FLOAT, BOOLEAN, DATETIME };
+
+        Kind kind = Kind::STRING;
+        /// The decoded string, or the text of a date-time; valid only during `on_value()`.
+        std::string_view text;
+        std::int64_t integer = 0;
+        double number = 0.0;
+        bool boolean = false;
+    };
+
+    /**
+     * @brief Receives the events of `TomlEventParser::parse()`; see the file comment.
+     */
+    template <typename Handler>
+    concept TomlEventHandler = requires(Handler& handler, const std::span<const std::string> path, const TomlValue& value) {
+        handler.on_table(path, true);
+        handler.on_key(path);
+        handler.on_value(value);
+        handler.on_array_begin();
+        handler.on_array_end();
+        handler.on_inline_table_begin();
+        handler.on_inline_table_end();
+    };
+
+    /**
+     * @brief Parses TOML from a stream in chunks, reporting tables, keys and values to a handler.
+     *
+     * Syntax errors throw `exceptions::ConfigParseError` with the line and column set. Exceptions
+     * thrown by the handler propagate unchanged; `line()` and `column()` then give the position
+     * of the key or value being reported.
+     */
+    class TomlEventParser {
+    public:
+        /**
+         * @brief Reads from `in`, which must outlive the parser.
+         * @param source The name of the input, for error messages.
+         * @param chunk_size Bytes read from `in` at a time.
+         */
+        explicit TomlEventParser(std::istream& in, std::string source = "<stream>", const std::size_t chunk_size = 1 << 16)
+            : m_in(in), m_source(std::move(source)), m_buffer(std::max<std::size_t>(chunk_size, 64)) {}
+
+        /**
+         * @brief Parses the whole input, calling `handler` for each event.
+         */
+        template <TomlEventHandler Handler>
+        void parse(Handler& handler) {
+            for (;;) {
+                skip_blank();
+                if (peek() == end) break;
+                mark();
+                if (peek() == '[') {
+                    get();
+                    const bool array_element = peek() == '[';
+                    if (array_element) get();
+                    skip_spaces();
+                    read_key();
+                    expect(']', "']' to close the table header");
+                    if (array_element) expect(']', "']]' to close the array of tables header");
+                    handler.on_table(key(), array_element);
+                } else {
+                    read_key();
+                    handler.on_key(key());
+                    expect('=', "'=' after the key");
+                    skip_spaces();
+                    read_value(handler, 0);
+                }
+                end_line();
+            }
+        }
+
+        /// 1-based line of the key or value last reported.
+        [[nodiscard]] std::size_t line() const { return m_mark_line; }
+
+        /// 1-based column of the key or value last reported.
+        [[nodiscard]] std::size_t column() const { return m_mark_column; }
+
+        [[nodiscard]] const std::string& source() const { return m_source; }
+
+    private:
+        static constexpr int end = -1;
+        static constexpr std::size_t max_depth = 256;
+
+        // Input
+
+        bool fill(const std::size_t count) {
+            while (m_end - m_pos < count && !m_eof) {
+                if (m_pos > 0) {
+                    std::copy(m_buffer.begin() + static_cast<std::ptrdiff_t>(m_pos), m_buffer.begin() + static_cast<std::ptrdiff_t>(m_end),
+                              m_buffer.begin());
+                    m_end -= m_pos;
+                    m_pos = 0;
+                }
+                if (m_end == m_buffer.size()) m_buffer.resize(m_buffer.size() * 2);
+                m_in.read(m_buffer.data() + m_end, static_cast<std::streamsize>(m_buffer.size() - m_end));
+                const auto read = static_cast<std::size_t>(m_in.gcount());
+                if (read == 0) m_eof = true;
+                m_end += read;
+            }
+            return m_end - m_pos >= count;
+        }
+
+        int peek(const std::size_t offset = 0) {
+            if (m_end - m_pos <= offset && !fill(offset + 1)) return end;
+            return static_cast<unsigned char>(m_buffer[m_pos + offset]);
+        }
+
+        int get() {
+            const int c = peek();
+            if (c == end) return end;
+            ++m_pos;
+            if (c == '\n') {
+                ++m_line;
+                m_column = 1;
+            } else {
+                ++m_column;
+            }
+            return c;
+        }
+
+        void mark() {
+            m_mark_line = m_line;
+            m_mark_column = m_column;
+        }
+
+        [[noreturn]] void fail(const std::string_view reason) const {
+            exceptions::ConfigParseError::Location location{m_source, m_line, m_column, {}};
+            throw exceptions::ConfigParseError(
+                std::format("Unable to parse TOML file: {}:{}:{}. Reason: {}", m_source, m_line, m_column, reason), std::move(location));
+        }
+
+        void expect(const char c, const std::string_view what) {
+            skip_spaces();
+            if (peek() != c) fail(std::format("expected {}", what));
+            get();
+        }
+
+        void skip_spaces() {
+            while (peek() == ' ' || peek() == '\t') get();
+        }
+
+        void skip_comment() {
+            while (peek() != '\n' && peek() != end) get();
+        }
+
+        /// Skips whitespace, newlines and comments.
+        void skip_blank() {
+            for (;;) {
+                const int c = peek();
+                if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+                    get();
+                } else if (c == '#') {
+                    skip_comment();
+                } else {
+                    return;
+                }
+            }
+        }
+
+        void end_line() {
+            skip_spaces();
+            if (peek() == '#') skip_comment();
+            if (peek() == '\r') get();
+            const int c = get();
+            if (c != '\n' && c != end) fail("expected a new line after the value");
+        }
+
+        // Keys
+
+        static bool is_bare_key_char(const int c) {
+            return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_' || c == '-';
+        }
+
+        [[nodiscard]] std::span<const std::string> key() const { return {m_key.data(), m_key_size}; }
+
+        void read_key() {
+            m_key_size = 0;
+            for (;;) {
+                skip_spaces();
+                if (m_key_size == m_key.size()) m_key.emplace_back();
+                std::string& segment = m_key[m_key_size++];
+                segment.clear();
+                const int c = peek();
+                if (c == '"') {
+                    read_basic_string(segment);
+                } else if (c == '\'') {
+                    read_literal_string(segment);
+                } else {
+                    while (is_bare_key_char(peek())) segment.push_back(static_cast<char>(get()));
+                    if (segment.empty()) fail("expected a key");
+                }
+                skip_spaces();
+                if (peek() != '.') return;
+                get();
+            }
+        }
+
+        // Values
+
+        template <typename Handler>
+        void read_value(Handler& handler, const std::size_t depth) {
+            if (depth > max_depth) fail("arrays and inline tables are nested too deeply");
+            mark();
+            const int c = peek();
+            if (c == '"' || c == '\'') {
+                m_text.clear();
+                if (peek(1) == c && peek(2) == c) {
+                    read_multiline_string(m_text, c == '"');
+                } else if (c == '"') {
+                    read_basic_string(m_text);
+                } else {
+                    read_literal_string(m_text);
+                }
+                handler.on_value(TomlValue{TomlValue::Kind::STRING, m_text});
+            } else if (c == '[') {
+                get();
+                handler.on_array_begin();
+                for (;;) {
+                    skip_blank();
+                    if (peek() == ']') {
+                        get();
+                        break;
+                    }
+                    read_value(handler, depth + 1);
+                    skip_blank();
+                    const int next = get();
+                    if (next == ']') break;
+                    if (next != ',') fail("expected ',' or ']' in the array");
+                }
+                handler.on_array_end();
+            } else if (c == '{') {
+                get();
+                handler.on_inline_table_begin();
+                skip_spaces();
+                if (peek() == '}') {
+                    get();
+                } else {
+                    for (;;) {
+                        mark();
+                        read_key();
+                        handler.on_key(key());
+                        expect('=', "'=' after the key");
+                        skip_spaces();
+                        read_value(handler, depth + 1);
+                        skip_spaces();
+                        const int next = get();
+                        if (next == '}') break;
+                        if (next != ',') fail("expected ',' or '}' in the inline table");
+                    }
+                }
+                handler.on_inline_table_end();
+            } else {
+                handler.on_value(read_scalar());
+            }
+        }
+
+        static bool is_value_end(const int c) {
+            return c == end || c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == ',' || c == ']' || c == '}' || c == '#';
+        }
+
+        static bool is_digit(const char c) { return c >= '0' && c <= '9'; }
+
+        TomlValue read_scalar() {
+            m_text.clear();
+            while (!is_value_end(peek())) m_text.push_back(static_cast<char>(get()));
+            // A date and a time may be separated by a space instead of 'T'.
+            if (m_text.size() == 10 && m_text[4] == '-' && m_text[7] == '-' && peek() == ' ' && peek(1) >= '0' && peek(1) <= '9' &&
+                peek(2) >= '0' && peek(2) <= '9' && peek(3) == ':') {
+                m_text.push_back(static_cast<char>(get()));
+                while (!is_value_end(peek())) m_text.push_back(static_cast<char>(get()));
+            }
+            const std::string_view text = m_text;
+            if (text.empty()) fail("expected a value");
+
+            TomlValue value;
+            if (text == "true" || text == "false") {
+                value.kind = TomlValue::Kind::BOOLEAN;
+                value.boolean = text == "true";
+                return value;
+            }
+            if (text == "inf" || text == "+inf" || text == "-inf" || text == "nan" || text == "+nan" || text == "-nan") {
+                value.kind = TomlValue::Kind::FLOAT;
+                value.number = text.back() == 'n' ? std::numeric_limits<double>::quiet_NaN() : std::numeric_limits<double>::infinity();
+                if (text.front() == '-') value.number = -value.number;
+                return value;
+            }
+            if ((text.size() >= 10 && is_digit(text[0]) && text[4] == '-') || (text.size() >= 8 && is_digit(text[0]) && text[2] == ':')) {
+                value.kind = TomlValue::Kind::DATETIME;
+                value.text = text;
+                return value;
+            }
+            return read_number(text);
+        }
+
+        TomlValue read_number(std::string_view text) {
+            // Underscores may only separate digits.
+            m_number.clear();
+            for (std::size_t i = 0; i < text.size(); ++i) {
+                if (text[i] == '_') {
+                    if (i == 0 || i + 1 == text.size() || !std::isxdigit(static_cast<unsigned char>(text[i - 1])) ||
+                        !std::isxdigit(static_cast<unsigned char>(text[i + 1]))) {
+                        fail(std::format("invalid number '{}'", text));
+                    }
+                } else {
+                    m_number.push_back(text[i]);
+                }
+            }
+            std::string_view digits = m_number;
+            TomlValue value;
+            int base = 10;
+            if (digits.size() > 2 && digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'o' || digits[1] == 'b')) {
+                base = digits[1] == 'x' ? 16 : digits[1] == 'o' ? 8 : 2;
+                digits.remove_prefix(2);
+            } else if (!digits.empty() && digits.front() == '+') {
+                digits.remove_prefix(1);
+            }
+            const char* first = digits.data();
+            const char* last = digits.data() + digits.size();
+            const bool floating = base == 10 && digits.find_first_of(".eE") != std::string_view::npos;
+            std::from_chars_result result{};
+            if (floating) {
+                value.kind = TomlValue::Kind::FLOAT;
+                result = std::from_chars(first, last, value.number);
+            } else {
+                value.kind = TomlValue::Kind::INTEGER;
+                result = std::from_chars(first, last, value.integer, base);
+                if (result.ec == std::errc::result_out_of_range) fail(std::format("integer '{}' does not fit in 64 bits", text));
+            }
+            if (digits.empty() || result.ec != std::errc() || result.ptr != last) fail(std::format("invalid value '{}'", text));
+            return value;
+        }
+
+        static void append_utf8(std::string& out, const std::uint32_t code) {
+            if (code < 0x80) {
+                out.push_back(static_cast<char>(code));
+            } else if (code < 0x800) {
+                out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+                out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+            } else if (code < 0x10000) {
+                out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+                out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+            } else {
+                out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+                out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+            }
+        }
+
+        void read_escape(std::string& out) {
+            const int c = get();
+            switch (c) {
+                case 'b': out.push_back('\b'); return;
+                case 't': out.push_back('\t'); return;
+                case 'n': out.push_back('\n'); return;
+                case 'f': out.push_back('\f'); return;
+                case 'r': out.push_back('\r'); return;
+                case '"': out.push_back('"'); return;
+                case '\\': out.push_back('\\'); return;
+                case 'u':
+                case 'U': {
+                    const int length = c == 'u' ? 4 : 8;
+                    std::uint32_t code = 0;
+                    for (int i = 0; i < length; ++i) {
+                        const int digit = get();
+                        if (digit == end || !std::isxdigit(digit)) fail("expected hexadecimal digits in the unicode escape");
+                        code = code * 16 + static_cast<std::uint32_t>(digit <= '9' ? digit - '0' : (digit | 0x20) - 'a' + 10);
+                    }
+                    if (code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF)) fail("the unicode escape is not a scalar value");
+                    append_utf8(out, code);
+                    return;
+                }
+                default:
+                    fail("invalid escape sequence in the string");
+            }
+        }
+
+        void read_basic_string(std::string& out) {
+            get();
+            for (;;) {
+                const int c = get();
+                if (c == end || c == '\n') fail("unterminated string");
+                if (c == '"') return;
+                if (c == '\\') {
+                    read_escape(out);
+                } else {
+                    out.push_back(static_cast<char>(c));
+                }
+            }
+        }
+
+        void read_literal_string(std::string& out) {
+            get();
+            for (;;) {
+                const int c = get();
+                if (c == end || c == '\n') fail("unterminated string");
+                if (c == '\'') return;
+                out.push_back(static_cast<char>(c));
+            }
+        }
+
+        void read_multiline_string(std::string& out, const bool basic) {
+            const int quote = get();
+            get();
+            get();
+            // A newline right after the opening delimiter is trimmed.
+            if (peek() == '\r' && peek(1) == '\n') get();
+            if (peek() == '\n') get();
+            for (;;) {
+                const int c = get();
+                if (c == end) fail("unterminated multi-line string");
+                if (c == quote && peek() == quote && peek(1) == quote) {
+                    get();
+                    get();
+                    // Up to two more quotes belong to the content.
+                    for (int extra = 0; extra < 2 && peek() == quote; ++extra) out.push_back(static_cast<char>(get()));
+                    return;
+                }
+                if (basic && c == '\\') {
+                    std::size_t offset = 0;
+                    while (peek(offset) == ' ' || peek(offset) == '\t') ++offset;
+                    if (peek(offset) == '\n' || (peek(offset) == '\r' && peek(offset + 1) == '\n')) {
+                        // A line-ending backslash trims the whitespace up to the next content.
+                        while (peek() == ' ' || peek() == '\t' || peek() == '\r' || peek() == '\n') get();
+                    } else {
+                        read_escape(out);
+                    }
+                } else {
+                    out.push_back(static_cast<char>(c));
+                }
+            }
+        }
+
+        std::istream& m_in;
+        std::string m_source;
+        std::vector<char> m_buffer;
+        std::size_t m_pos = 0;
+        std::size_t m_end = 0;
+        bool m_eof = false;
+        std::size_t m_line = 1;
+        std::size_t m_column = 1;
+        std::size_t m_mark_line = 1;
+        std::size_t m_mark_column = 1;
+        /// Segments of the current key; only the first `m_key_size` are in use.
+        std::vector<std::string> m_key;
+        std::size_t m_key_size = 0;
+        std::string m_text;
+        std::string m_number;
+    };
+
+    /**
+     * @brief Parses TOML from `in`, calling `handler` for each event.
+     * @param source The name of the input, for error messages.
+     * @throws exceptions::ConfigParseError On a syntax error.
+     */
+    template <TomlEventHandler Handler>
+    void parse_toml_events(std::istream& in, Handler& handler, const std::string_view source = "<stream>") {
+        TomlEventParser parser(in, std::string(source));
+        parser.parse(handler);
+    }
+
+    namespace detail {
+        template <typename Type>
+        struct event_readable;
+
+        template <typename Fields>
+        struct fields_event_readable;
+
+        template <typename... Fields>
+        struct fields_event_readable<rfl::Tuple<Fields...>>
+            : std::bool_constant<(event_readable<std::remove_cvref_t<typename Fields::Type>>::value && ...)> {};
+
+        template <typename Type>
+        struct event_readable {
+            static constexpr bool compute() {
+                if constexpr (std::is_arithmetic_v<Type> || std::is_enum_v<Type> || validate::is_std_string_v<Type> ||
+                              validate::is_quantity_v<Type> || validate::is_stored_v<Type>) {
+                    return true;
+                } else if constexpr (validate::is_optional_v<Type> || validate::is_vector_v<Type> ||
+                                     config::detail::is_std_array_v<Type> || validate::is_tunable_v<Type>) {
+                    return event_readable<std::remove_cvref_t<typename Type::value_type>>::value;
+                } else if constexpr (validate::is_flat_map_v<Type>) {
+                    // An insertion moves the entries after it, so a slot into a flat map would not stay valid.
+                    return false;
+                } else if constexpr (validate::is_map_v<Type>) {
+                    using Key = typename Type::key_type;
+                    return (validate::is_std_string_v<Key> || std::is_integral_v<Key>) &&
+                           event_readable<std::remove_cvref_t<typename Type::mapped_type>>::value;
+                } else if constexpr (config::detail::is_path_struct_v<Type>) {
+                    // Old field names (see aliases.h) are looked up in the whole table, which events never hold.
+                    return !config::detail::has_field_aliases_v<Type> &&
+                           fields_event_readable<typename rfl::named_tuple_t<Type>::Fields>::value;
+                } else {
+                    return false;
+                }
+            }
+            static constexpr bool value = compute();
+        };
+    }
+
+    /// Whether `read_toml_stream()` can read every field of `Type`.
+    template <typename Type>
+    constexpr bool is_event_readable_v = detail::event_readable<std::remove_cvref_t<Type>>::value;
+
+    /**
+     * @brief How `read_toml_stream()` selects the root table and treats missing and unknown keys.
+     */
+    struct StreamReadOptions {
+        /// The root table to read; see `keep_root_name`.
+        std::string root_name = "main";
+        /// Read only `[root_name]`; otherwise the first root table in the input is read.
+        bool keep_root_name = false;
+        /// Fail if a required (non-optional) field has no value in the input; otherwise it keeps its default.
+        bool reject_missing = false;
+        /// Fail on keys that name no field; otherwise they are skipped.
+        bool reject_unknown = false;
+    };
+
+    namespace detail {
+        /**
+         * @brief A value of the input that does not fit the field it was written to.
+         */
+        struct StreamError : std::runtime_error {
+            using std::runtime_error::runtime_error;
+        };
+
+        /**
+         * @brief Containers that were cleared when first written to, and the elements appended
+         *        to arrays of tables, keyed by the container's address.
+         */
+        struct EventContext {
+            std::map<const void*, std::size_t> touched;
+
+            bool first_touch(const void* container) { return touched.try_emplace(container, 0).second; }
+
+            /// Drops entries for objects in `[begin, end)`, storage a vector is about to release.
+            void forget(const void* begin, const void* end) {
+                touched.erase(touched.lower_bound(begin), touched.lower_bound(end));
+            }
+        };
+
+        enum class SlotKind : std::uint8_t { TABLE, MAP, ARRAY, SCALAR, IGNORED };
+
+        struct EventSlot;
+
+        /**
+         * @brief What the event reader can do with a field of one type; see `EventOps`.
+         */
+        struct EventSlotOps {
+            SlotKind kind;
+            /// What the field holds, for error messages (e.g. "an integer").
+            std::string_view expected;
+            /// The slot of a member of a table, with a null target if there is none.
+            EventSlot (*member)(void* target, std::string_view key, std::size_t children);
+            /// The slot of element `index` of an array, appending it to vectors.
+            EventSlot (*element)(void* target, std::size_t index, EventContext& context);
+            /// Stores a scalar element at `index` of an array.
+            void (*append_value)(void* target, std::size_t index, const TomlValue& value, EventContext& context);
+            /// The slot of element `index` of an array of tables that has been appended already.
+            EventSlot (*existing)(void* target, std::size_t index);
+            /// Empties a vector or map before it is filled from the input.
+            void (*clear)(void* target, EventContext& context);
+            /// Checks the element count when an array ends.
+            void (*finish_array)(void* target, std::size_t count);
+            /// Stores a scalar.
+            void (*value)(void* target, const TomlValue& value);
+        };
+
+        struct EventSlot {
+            static constexpr std::size_t untracked = static_cast<std::size_t>(-1);
+
+            void* target = nullptr;
+            const EventSlotOps* ops = nullptr;
+            /// The field's ordinal (see `find_field()`), for fields reached without passing an array or map.
+            std::size_t ordinal = untracked;
+            /// The ordinal of the first field nested in this one, for tracked structs.
+            std::size_t children = untracked;
+        };
+
+        inline std::string_view describe(const TomlValue& value) {
+            switch (value.kind) {
+                case TomlValue::Kind::STRING: return "a string";
+                case TomlValue::Kind::INTEGER: return "an integer";
+                case TomlValue::Kind::FLOAT: return "a float";
+                case TomlValue::Kind::BOOLEAN: return "a boolean";
+                case TomlValue::Kind::DATETIME: return "a date-time";
+            }
+            return "a value";
+        }
+
+        [[noreturn]] inline void mismatch(const std::string_view expected, const std::string_view found) {
+            throw StreamError(std::format("expected {}, found {}", expected, found));
+        }
+
+        template <typename V>
+        struct EventOps;
+
+        /// The operations every type rejects unless its `EventOps` says otherwise.
+        template <typename V>
+        struct EventOpsBase {
+            static EventSlot member(void*, std::string_view, std::size_t) { mismatch(EventOps<V>::expected, "a table"); }
+            static EventSlot element(void*, std::size_t, EventContext&) { mismatch(EventOps<V>::expected, "an array"); }
+            static void append_value(void*, std::size_t, const TomlValue&, EventContext&) { mismatch(EventOps<V>::expected, "an array"); }
+            static EventSlot existing(void*, std::size_t) { mismatch(EventOps<V>::expected, "an array of tables"); }
+            static void clear(void*, EventContext&) {}
+            static void finish_array(void*, std::size_t) {}
+            static void value(void*, const TomlValue& value) { mismatch(EventOps<V>::expected, describe(value)); }
+        };
+
+        template <typename V>
+        const EventSlotOps* event_ops() {
+            using Ops = EventOps<V>;
+            static constexpr EventSlotOps ops{Ops::kind, Ops::expected, &Ops::member, &Ops::element, &Ops::append_value,
+                                              &Ops::existing, &Ops::clear, &Ops::finish_array, &Ops::value};
+            return &ops;
+        }
+
+        template <typename V>
+        EventSlot slot_of(V& value, const std::size_t ordinal = EventSlot::untracked) {
+            const std::size_t children =
+                ordinal != EventSlot::untracked && config::detail::is_path_struct_v<V> ? ordinal + 1 : EventSlot::untracked;
+            return {&value, event_ops<V>(), ordinal, children};
+        }
+
+        /// Slots of keys that are skipped: every event is accepted and discarded.
+        struct IgnoredOps {
+            static EventSlot member(void*, std::string_view, std::size_t);
+            static EventSlot element(void*, std::size_t, EventContext&);
+            static void append_value(void*, std::size_t, const TomlValue&, EventContext&) {}
+            static EventSlot existing(void*, std::size_t);
+            static void clear(void*, EventContext&) {}
+            static void finish_array(void*, std::size_t) {}
+            static void value(void*, const TomlValue&) {}
+        };
+
+        inline constexpr EventSlotOps ignored_ops{SlotKind::IGNORED, "anything", &IgnoredOps::member, &IgnoredOps::element,
+                                                  &IgnoredOps::append_value, &IgnoredOps::existing, &IgnoredOps::clear,
+                                                  &IgnoredOps::finish_array, &IgnoredOps::value};
+
+        inline EventSlot ignored_slot() { return {nullptr, &ignored_ops}; }
+        inline EventSlot IgnoredOps::member(void*, std::string_view, std::size_t) { return ignored_slot(); }
+        inline EventSlot IgnoredOps::element(void*, std::size_t, EventContext&) { return ignored_slot(); }
+        inline EventSlot IgnoredOps::existing(void*, std::size_t) { return ignored_slot(); }
+
+        template <typename V>
+        struct EventOps : EventOpsBase<V> {
+            static constexpr SlotKind kind = SlotKind::SCALAR;
+            static constexpr std::string_view expected = [] {
+                if constexpr (std::is_same_v<V, bool>) {
+                    return std::string_view("a boolean");
+                } else if constexpr (std::is_integral_v<V>) {
+                    return std::string_view("an integer");
+                } else if constexpr (std::is_floating_point_v<V>) {
+                    return std::string_view("a number");
+                } else if constexpr (std::is_enum_v<V>) {
+                    return std::string_view("an enumerator name");
+                } else if constexpr (validate::is_quantity_v<V>) {
+                    return std::string_view("a number or a quantity with a unit");
+                } else if constexpr (validate::is_stored_v<V>) {
+                    return std::is_floating_point_v<typename V::parsed_type> ? std::string_view("a number") : std::string_view("an integer");
+                } else {
+                    return std::string_view("a string");
+                }
+            }();
+
+            static void value(void* target, const TomlValue& value) {
+                V& field = *static_cast<V*>(target);
+                if constexpr (std::is_same_v<V, bool>) {
+                    if (value.kind != TomlValue::Kind::BOOLEAN) mismatch(expected, describe(value));
+                    field = value.boolean;
+                } else if constexpr (std::is_integral_v<V>) {
+                    if (value.kind != TomlValue::Kind::INTEGER) mismatch(expected, describe(value));
+                    if (!std::in_range<V>(value.integer)) {
+                        throw StreamError(std::format("{} is out of range for the field", value.integer));
+                    }
+                    field = static_cast<V>(value.integer);
+                } else if constexpr (std::is_floating_point_v<V>) {
+                    if (value.kind == TomlValue::Kind::FLOAT) {
+                        field = static_cast<V>(value.number);
+                    } else if (value.kind == TomlValue::Kind::INTEGER) {
+                        field = static_cast<V>(value.integer);
+                    } else {
+                        mismatch(expected, describe(value));
+                    }
+                } else if constexpr (std::is_enum_v<V>) {
+                    if (value.kind != TomlValue::Kind::STRING) mismatch(expected, describe(value));
+                    const auto enumerator = io::enum_from_string<V>(value.text);
+                    if (!enumerator) throw StreamError(std::format("'{}' is not an enumerator of the field", value.text));
+                    field = *enumerator;
+                } else if constexpr (validate::is_quantity_v<V>) {
+                    if (value.kind == TomlValue::Kind::FLOAT) {
+                        field = value.number;
+                    } else if (value.kind == TomlValue::Kind::INTEGER) {
+                        field = static_cast<double>(value.integer);
+                    } else if (value.kind == TomlValue::Kind::STRING) {
+                        const auto parsed = V::parse(value.text);
+                        if (!parsed) throw StreamError(parsed.error());
+                        field = *parsed;
+                    } else {
+                        mismatch(expected, describe(value));
+                    }
+                } else if constexpr (validate::is_stored_v<V>) {
+                    using Parsed = typename V::parsed_type;
+                    Parsed number{};
+                    if (value.kind == TomlValue::Kind::FLOAT && std::is_floating_point_v<Parsed>) {
+                        number = static_cast<Parsed>(value.number);
+                    } else if (value.kind == TomlValue::Kind::INTEGER) {
+                        if constexpr (std::is_integral_v<Parsed>) {
+                            if (!std::in_range<Parsed>(value.integer)) {
+                                throw StreamError(std::format("{} is out of range for the field", value.integer));
+                            }
+                        }
+                        number = static_cast<Parsed>(value.integer);
+                    } else {
+                        mismatch(expected, describe(value));
+                    }
+                    const auto narrowed = V::narrow(number);
+                    if (!narrowed) throw StreamError(narrowed.error());
+                    field = *narrowed;
+                } else {
+                    if (value.kind != TomlValue::Kind::STRING && value.kind != TomlValue::Kind::DATETIME) {
+                        mismatch(expected, describe(value));
+                    }
+                    field.assign(value.text.data(), value.text.size());
+                }
+            }
+        };
+
+        template <typename V>
+        struct EventOps<Tunable<V>> : EventOpsBase<Tunable<V>> {
+            static constexpr SlotKind kind = SlotKind::SCALAR;
+            static constexpr std::string_view expected = EventOps<V>::expected;
+
+            static void value(void* target, const TomlValue& value) {
+                V read{};
+                EventOps<V>::value(&read, value);
+                *static_cast<Tunable<V>*>(target) = read;
+            }
+        };
+
+        /// Optionals take a value when first written to, then behave as their value type.
+        template <typename V>
+        struct EventOps<std::optional<V>> {
+            static constexpr SlotKind kind = EventOps<V>::kind;
+            static constexpr std::string_view expected = EventOps<V>::expected;
+
+            static V* engage(void* target) {
+                auto& optional = *static_cast<std::optional<V>*>(target);
+                if (!optional) optional.emplace();
+                return &*optional;
+            }
+            static EventSlot member(void* target, const std::string_view key, const std::size_t) {
+                return EventOps<V>::member(engage(target), key, EventSlot::untracked);
+            }
+            static EventSlot element(void* target, const std::size_t index, EventContext& context) {
+                return EventOps<V>::element(engage(target), index, context);
+            }
+            static void append_value(void* target, const std::size_t index, const TomlValue& value, EventContext& context) {
+                EventOps<V>::append_value(engage(target), index, value, context);
+            }
+            static EventSlot existing(void* target, const std::size_t index) { return EventOps<V>::existing(engage(target), index); }
+            static void clear(void* target, EventContext& context) { EventOps<V>::clear(engage(target), context); }
+            static void finish_array(void* target, const std::size_t count) { EventOps<V>::finish_array(engage(target), count); }
+            static void value(void* target, const TomlValue& value) { EventOps<V>::value(engage(target), value); }
+        };
+
+        template <typename V>
+            requires config::detail::is_path_struct_v<V>
+        struct EventOps<V> : EventOpsBase<V> {
+            static constexpr SlotKind kind = SlotKind::TABLE;
+            static constexpr std::string_view expected = "a table";
+
+            static EventSlot member(void* target, const std::string_view key, const std::size_t children) {
+                using Fields = typename rfl::named_tuple_t<V>::Fields;
+                const auto view = rfl::to_view(*static_cast<V*>(target));
+                EventSlot found;
+                std::size_t ordinal = children;
+                [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                    ([&] {
+                        using Field = rfl::tuple_element_t<Is, Fields>;
+                        if (found.ops == nullptr && Field::name() == key) {
+                            found = slot_of(*rfl::get<Is>(view.values()), ordinal);
+                        }
+                        if (ordinal != EventSlot::untracked) ordinal += 1 + config::detail::nested_count<typename Field::Type>();
+                    }(), ...);
+                }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+                return found;
+            }
+        };
+
+        template <typename V>
+            requires validate::is_map_v<V>
+        struct EventOps<V> : EventOpsBase<V> {
+            static constexpr SlotKind kind = SlotKind::MAP;
+            static constexpr std::string_view expected = "a table";
+
+            static EventSlot member(void* target, const std::string_view key, const std::size_t) {
+                using Key = typename V::key_type;
+                V& map = *static_cast<V*>(target);
+                if constexpr (std::is_integral_v<Key>) {
+                    Key parsed{};
+                    const auto result = std::from_chars(key.data(), key.data() + key.size(), parsed);
+                    if (result.ec != std::errc() || result.ptr != key.data() + key.size()) {
+                        throw StreamError(std::format("key '{}' is not an integer", key));
+                    }
+                    return slot_of(map[parsed]);
+                } else {
+                    return slot_of(map[Key(key)]);
+                }
+            }
+            static void clear(void* target, EventContext&) { static_cast<V*>(target)->clear(); }
+        };
+
+        template <typename V>
+            requires validate::is_vector_v<V>
+        struct EventOps<V> : EventOpsBase<V> {
+            using Element = typename V::value_type;
+            static constexpr SlotKind kind = SlotKind::ARRAY;
+            static constexpr std::string_view expected = "an array";
+
+            static void reserve_next(V& vector, EventContext& context) {
+                if (vector.size() == vector.capacity() && !vector.empty()) {
+                    context.forget(vector.data(), vector.data() + vector.size());
+                }
+            }
+            static EventSlot element(void* target, const std::size_t, EventContext& context) {
+                if constexpr (std::is_same_v<Element, bool>) {
+                    mismatch("a boolean", "an array or a table");
+                } else {
+                    V& vector = *static_cast<V*>(target);
+                    reserve_next(vector, context);
+                    return slot_of(vector.emplace_back());
+                }
+            }
+            static void append_value(void* target, const std::size_t, const TomlValue& value, EventContext& context) {
+                V& vector = *static_cast<V*>(target);
+                if constexpr (std::is_same_v<Element, bool>) {
+                    bool read = false;
+                    EventOps<bool>::value(&read, value);
+                    vector.push_back(read);
+                } else {
+                    reserve_next(vector, context);
+                    EventOps<Element>::value(&vector.emplace_back(), value);
+                }
+            }
+            static EventSlot existing(void* target, const std::size_t) {
+                V& vector = *static_cast<V*>(target);
+                if constexpr (std::is_same_v<Element, bool>) {
+                    mismatch("a boolean", "a table");
+                } else {
+                    if (vector.empty()) throw StreamError("the array of tables has no element yet");
+                    return slot_of(vector.back());
+                }
+            }
+            static void clear(void* target, EventContext& context) {
+                V& vector = *static_cast<V*>(target);
+                if constexpr (!std::is_same_v<Element, bool>) context.forget(vector.data(), vector.data() + vector.size());
+                vector.clear();
+            }
+        };
+
+        template <typename V>
+            requires config::detail::is_std_array_v<V>
+        struct EventOps<V> : EventOpsBase<V> {
+            static constexpr SlotKind kind = SlotKind::ARRAY;
+            static constexpr std::string_view expected = "an array";
+            static constexpr std::size_t size = std::tuple_size_v<V>;
+
+            static EventSlot element(void* target, const std::size_t index, EventContext&) {
+                if (index >= size) throw StreamError(std::format("expected an array of {} elements", size));
+                return slot_of((*static_cast<V*>(target))[index]);
+            }
+            static void append_value(void* target, const std::size_t index, const TomlValue& value, EventContext&) {
+                if (index >= size) throw StreamError(std::format("expected an array of {} elements", size));
+                EventOps<typename V::value_type>::value(&(*static_cast<V*>(target))[index], value);
+            }
+            static EventSlot existing(void* target, const std::size_t index) {
+                if (index >= size) throw StreamError("the array of tables has no element yet");
+                return slot_of((*static_cast<V*>(target))[index]);
+            }
+            static void finish_array(void*, const std::size_t count) {
+                if (count != size) throw StreamError(std::format("expected an array of {} elements, found {}", size, count));
+            }
+        };
+
+        /**
+         * @brief Writes the events of `TomlEventParser` into a `T`; see `read_toml_stream()`.
+         */
+        template <typename T>
+        class SchemaEventSink {
+        public:
+            SchemaEventSink(T& content, const StreamReadOptions& options)
+                : m_options(options), m_content(content), m_seen(config::detail::field_count<T>(), false) {}
+
+            void on_table(const std::span<const std::string> path, const bool array_element) {
+                set_path(path, {});
+                EventSlot slot = document_slot(path.front());
+                for (std::size_t i = 1; i < path.size(); ++i) {
+                    slot = member(slot, path[i]);
+                    const bool last = i + 1 == path.size();
+                    if (slot.ops->kind != SlotKind::ARRAY) continue;
+                    std::size_t& appended = appended_count(slot);
+                    if (last && array_element) {
+                        slot = slot.ops->element(slot.target, appended++, m_context);
+                    } else {
+                        if (appended == 0) throw StreamError("the array of tables has no element yet");
+                        slot = slot.ops->existing(slot.target, appended - 1);
+                    }
+                }
+                if (array_element && path.size() == 1) throw StreamError("the root table cannot be an array of tables");
+                require_table(slot);
+                m_table = slot;
+                m_in_table = true;
+            }
+
+            void on_key(const std::span<const std::string> key) {
+                EventSlot slot;
+                std::size_t first = 0;
+                if (!m_frames.empty()) {
+                    slot = m_frames.back().slot;
+                } else if (m_in_table) {
+                    slot = m_table;
+                    set_path(m_header, key);
+                } else {
+                    // A key before any header is a dotted key from the top of the document.
+                    set_path(key, {});
+                    slot = document_slot(key.front());
+                    first = 1;
+                }
+                for (std::size_t i = first; i < key.size(); ++i) {
+                    if (i > first) require_table(slot);
+                    slot = member(slot, key[i]);
+                }
+                m_pending = slot;
+            }
+
+            void on_value(const TomlValue& value) {
+                if (!m_frames.empty() && m_frames.back().array) {
+                    Frame& frame = m_frames.back();
+                    frame.slot.ops->append_value(frame.slot.target, frame.count++, value, m_context);
+                } else {
+                    m_pending.ops->value(m_pending.target, value);
+                }
+            }
+
+            void on_array_begin() {
+                const EventSlot slot = value_slot();
+                if (slot.ops->kind != SlotKind::ARRAY && slot.ops->kind != SlotKind::IGNORED) {
+                    mismatch(slot.ops->expected, "an array");
+                }
+                slot.ops->clear(slot.target, m_context);
+                m_frames.push_back({slot, 0, true});
+            }
+
+            void on_array_end() {
+                const Frame frame = m_frames.back();
+                m_frames.pop_back();
+                frame.slot.ops->finish_array(frame.slot.target, frame.count);
+            }
+
+            void on_inline_table_begin() {
+                const EventSlot slot = value_slot();
+                require_table(slot);
+                // An inline table is the whole value of a map, so it replaces the default entries.
+                if (slot.ops->kind == SlotKind::MAP) {
+                    slot.ops->clear(slot.target, m_context);
+                    m_context.first_touch(slot.target);
+                }
+                m_frames.push_back({slot, 0, false});
+            }
+
+            void on_inline_table_end() { m_frames.pop_back(); }
+
+            /**
+             * @brief Checks the root table was found and, if asked, that no required field is missing.
+             */
+            void finish(const std::string_view source) const {
+                if (!m_root_found) {
+                    if (m_options.keep_root_name && !m_other_root.empty()) {
+                        throw exceptions::ConfigLoadError(std::format(
+                            "Root name mismatch when loading config from file. Current root name is '{}', but file root name is '{}'. If you want to use the root name from the file, set the root name load policy to FROM_FILE using set_root_name_load_policy().",
+                            m_options.root_name, m_other_root));
+                    }
+                    throw exceptions::ConfigParseError(std::format(
+                        "Config file contains no root table: {}. Add at least an empty table (e.g., [{}]) to it.", source,
+                        m_options.root_name));
+                }
+                if (!m_options.reject_missing) return;
+                std::vector<std::string> missing;
+                collect_missing<T>(0, m_root_name, missing);
+                if (missing.empty()) return;
+                std::string list;
+                for (std::size_t i = 0; i < missing.size() && i < 10; ++i) list += std::format("\n  - {}", missing[i]);
+                if (missing.size() > 10) list += std::format("\n  ... and {} more", missing.size() - 10);
+                throw exceptions::ConfigParseError(
+                    std::format("Failed to load config from file: {}. Missing {} required field(s):{}", source, missing.size(), list),
+                    exceptions::ConfigParseError::Location{std::string(source), 0, 0, missing.front()});
+            }
+
+            [[nodiscard]] const std::string& root_name() const { return m_root_name; }
+
+            /// The dotted path of the key being read, from the root table, for error messages.
+            [[nodiscard]] const std::string& path() const { return m_path; }
+
+        private:
+            struct Frame {
+                EventSlot slot;
+                std::size_t count;
+                bool array;
+            };
+
+            EventSlot document_slot(const std::string& root) {
+                if (m_root_name.empty() && (!m_options.keep_root_name || root == m_options.root_name)) m_root_name = root;
+                if (root != m_root_name) {
+                    if (m_other_root.empty()) m_other_root = root;
+                    return ignored_slot();
+                }
+                m_root_found = true;
+                return {&m_content, event_ops<T>(), EventSlot::untracked, 0};
+            }
+
+            EventSlot member(const EventSlot& parent, const std::string& key) {
+                if (parent.ops->kind == SlotKind::MAP && m_context.first_touch(parent.target)) {
+                    // The first key of a map replaces its default entries.
+                    parent.ops->clear(parent.target, m_context);
+                }
+                EventSlot child = parent.ops->member(parent.target, key, parent.children);
+                if (child.ops == nullptr) {
+                    // Directives such as `__include` and `__sidecar` need the document.
+                    if (key.starts_with("__")) throw StreamError(std::format("'{}' is not supported by the streaming reader", key));
+                    if (m_options.reject_unknown) throw StreamError(std::format("unknown key '{}'", key));
+                    return ignored_slot();
+                }
+                if (child.ordinal != EventSlot::untracked) m_seen[child.ordinal] = true;
+                return child;
+            }
+
+            std::size_t& appended_count(const EventSlot& array) {
+                if (m_context.first_touch(array.target)) {
+                    // The first [[header]] of an array replaces its default elements.
+                    array.ops->clear(array.target, m_context);
+                    m_context.touched[array.target] = 0;
+                }
+                return m_context.touched[array.target];
+            }
+
+            EventSlot value_slot() {
+                if (!m_frames.empty() && m_frames.back().array) {
+                    Frame& frame = m_frames.back();
+                    return frame.slot.ops->element(frame.slot.target, frame.count++, m_context);
+                }
+                return m_pending;
+            }
+
+            static void require_table(const EventSlot& slot) {
+                if (slot.ops->kind != SlotKind::TABLE && slot.ops->kind != SlotKind::MAP && slot.ops->kind != SlotKind::IGNORED) {
+                    mismatch(slot.ops->expected, "a table");
+                }
+            }
+
+            void set_path(const std::span<const std::string> header, const std::span<const std::string> key) {
+                if (header.data() != m_header.data()) m_header.assign(header.begin(), header.end());
+                m_path.clear();
+                for (const std::string& segment : header) {
+                    if (!m_path.empty()) m_path += '.';
+                    m_path += segment;
+                }
+                for (const std::string& segment : key) {
+                    if (!m_path.empty()) m_path += '.';
+                    m_path += segment;
+                }
+            }
+
+            template <typename V>
+            void collect_missing(std::size_t ordinal, const std::string& prefix, std::vector<std::string>& missing) const {
+                using Fields = typename rfl::named_tuple_t<V>::Fields;
+                [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                    ([&] {
+                        using Field = rfl::tuple_element_t<Is, Fields>;
+                        using Type = std::remove_cvref_t<typename Field::Type>;
+                        const std::string path = prefix.empty() ? std::string(Field::name()) : prefix + "." + std::string(Field::name());
+                        if constexpr (config::detail::is_path_struct_v<Type>) {
+                            collect_missing<Type>(ordinal + 1, path, missing);
+                        } else if constexpr (!validate::is_optional_v<Type>) {
+                            if (!m_seen[ordinal]) missing.push_back(path);
+                        }
+                        ordinal += 1 + config::detail::nested_count<Type>();
+                    }(), ...);
+                }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+            }
+
+            const StreamReadOptions& m_options;
+            T& m_content;
+            std::string m_root_name;
+            std::string m_other_root;
+            bool m_root_found = false;
+            EventSlot m_table;
+            bool m_in_table = false;
+            std::vector<std::string> m_header;
+            EventSlot m_pending;
+            std::vector<Frame> m_frames;
+            EventContext m_context;
+            std::vector<bool> m_seen;
+            std::string m_path;
+        };
+    }
+
+    /**
+     * @brief Reads the root table of the TOML in `in` into `content`, without building a document.
+     *
+     * Like `read_toml_stream()`, except that fields the input leaves out keep the value `content`
+     * had, and that strings, vectors and maps given in the input are assigned in place: a vector
+     * is cleared and refilled within its capacity, so reading into storage that held a similar
+     * deck allocates next to nothing. Reset `content` to its defaults first to get the result of
+     * `read_toml_stream()`.
+     *
+     * @throws exceptions::ConfigParseError As `read_toml_stream()`; `content` is then partially written.
+     * @throws exceptions::ConfigLoadError As `read_toml_stream()`.
+     */
+    template <typename T>
+        requires is_event_readable_v<T>
+    void read_toml_stream_into(std::istream& in, T& content, std::string& root_name, const StreamReadOptions& options = {},
+                               const std::string_view source = "<stream>") {
+        TomlEventParser parser(in, std::string(source));
+        detail::SchemaEventSink<T> sink(content, options);
+        try {
+            parser.parse(sink);
+        } catch (const detail::StreamError& e) {
+            throw exceptions::ConfigParseError(
+                std::format("Failed to load config from file: {}. Reason: {}:{}:{}: '{}': {}", source, source, parser.line(), parser.column(),
+                            sink.path(), e.what()),
+                exceptions::ConfigParseError::Location{std::string(source), parser.line(), parser.column(), sink.path()});
+        }
+        sink.finish(source);
+        root_name = sink.root_name();
+    }
+
+    /**
+     * @brief Reads a `T` from the root table of the TOML in `in`, without building a document.
+     *
+     * Fields the input leaves out keep their defaults (or fail the read, see `StreamReadOptions`);
+     * arrays, and maps, given in the input replace their defaults.
+     *
+     * @param in The input, read in chunks.
+     * @param root_name Receives the name of the root table that was read.
+     * @param options Root table selection and missing and unknown key handling.
+     * @param source The name of the input, for error messages.
+     * @throws exceptions::ConfigParseError On a syntax error, a value that does not fit its field,
+     *         or a missing root table; `location()` is set where known.
+     * @throws exceptions::ConfigLoadError If `options.keep_root_name` is set and the input only
+     *         has other root tables.
+     */
+    template <typename T>
+        requires is_event_readable_v<T>
+    T read_toml_stream(std::istream& in, std::string& root_name, const StreamReadOptions& options = {},
+                       const std::string_view source = "<stream>") {
+        T content{};
+        read_toml_stream_into(in, content, root_name, options, source);
+        return content;
+    }
+}
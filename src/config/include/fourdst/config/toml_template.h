@@ -0,0 +1,153 @@
+/**
+ * @file toml_template.h
+ * @brief A commented TOML deck listing every field of a schema with its default.
+ *
+ * `toml_template<T>()` writes one line per field of `T{}` with its default value, preceded by a
+ * comment naming its TOML type and whether it is optional. Nested structs become their own
+ * `[root.path]` sections. Optional fields without a default are listed commented out. Values are
+ * taken from the same serialization `save()` uses, so the template loads back as `T{}`.
+ *
+ * @code
+ * # float
+ * time_step = 0.01
+ * # one of EULER, RK4
+ * integrator = "RK4"
+ * # integer, optional
+ * # max_steps =
+ * @endcode
+ *
+ * New decks can be started from the template and trimmed to the fields they change, instead of
+ * from an old deck whose leftover keys nobody remembers the reason for.
+ */
+#pragma once
+
+#include <format>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "fourdst/config/path_table.h"
+#include "fourdst/config/sparse.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+
+#include <toml++/toml.h>
+
+namespace fourdst::config::io {
+
+    namespace detail {
+        /**
+         * @brief Describes the TOML form of a field of type `Type`, e.g. `array of float`.
+         */
+        template <typename Type>
+        std::string describe_type() {
+            if constexpr (validate::is_optional_v<Type> || validate::is_lazy_v<Type> || validate::is_tunable_v<Type>) {
+                return describe_type<std::remove_cvref_t<typename Type::value_type>>();
+            } else if constexpr (validate::is_sharded_v<Type>) {
+                return std::format("table of {} by shard key", describe_type<std::remove_cvref_t<typename Type::value_type>>());
+            } else if constexpr (validate::is_section_v<Type>) {
+                return std::format("string, the path of a TOML file holding a {}", describe_type<std::remove_cvref_t<typename Type::value_type>>());
+            } else if constexpr (validate::is_quantity_v<Type>) {
+                return std::format("float in {}, or a string with a unit: {}", Type::canonical_unit(), Type::accepted_units());
+            } else if constexpr (validate::is_stored_v<Type>) {
+                return std::format("{}, stored as {}", describe_type<typename Type::parsed_type>(), Type::precision());
+            } else if constexpr (validate::is_rfl_validator_v<Type>) {
+                return std::format("{}, constrained", describe_type<std::remove_cvref_t<typename Type::ReflectionType>>());
+            } else if constexpr (validate::is_tagged_union_v<Type>) {
+                using Index = config::detail::TagIndex<Type>;
+                return std::format("table selected by {}: {}", Index::discriminator, Index::allowed());
+            } else if constexpr (std::is_same_v<Type, bool>) {
+                return "boolean";
+            } else if constexpr (std::is_integral_v<Type>) {
+                return "integer";
+            } else if constexpr (std::is_floating_point_v<Type>) {
+                return "float";
+            } else if constexpr (validate::is_string_like_v<Type>) {
+                return "string";
+            } else if constexpr (std::is_enum_v<Type>) {
+                std::string names;
+                for (const auto& [name, value] : rfl::get_enumerator_array<Type>()) {
+                    if (!names.empty()) names += ", ";
+                    names += name;
+                }
+                return std::format("one of {}", names);
+            } else if constexpr (validate::is_std_array_v<Type>) {
+                return std::format("array of {} {}", std::tuple_size_v<Type>, describe_type<std::remove_cvref_t<typename Type::value_type>>());
+            } else if constexpr (validate::is_tensor_v<Type>) {
+                return std::format("{}-dimensional array of {}", Type::rank, describe_type<std::remove_cvref_t<typename Type::value_type>>());
+            } else if constexpr (validate::is_vector_v<Type> || validate::is_soa_v<Type> || validate::is_sink_v<Type>) {
+                return std::format("array of {}", describe_type<std::remove_cvref_t<typename Type::value_type>>());
+            } else if constexpr (validate::is_map_v<Type>) {
+                return std::format("table of {}", describe_type<std::remove_cvref_t<typename Type::mapped_type>>());
+            } else if constexpr (validate::is_reflectable_struct_v<Type>) {
+                return "table";
+            } else {
+                return "value";
+            }
+        }
+
+        /**
+         * @brief Formats a TOML value as it appears after `key = `; tables are written inline.
+         */
+        inline std::string format_value(const toml::node& node) {
+            std::ostringstream text;
+            node.visit([&](const auto& value) {
+                if constexpr (std::is_same_v<std::remove_cvref_t<decltype(value)>, toml::table>) {
+                    toml::table inline_table = value;
+                    inline_table.is_inline(true);
+                    text << inline_table;
+                } else {
+                    text << value;
+                }
+            });
+            return std::move(text).str();
+        }
+
+        /**
+         * @brief Writes the section `[header]` for the struct `V`, then the sections of its nested structs.
+         * @param defaults The serialized fields of a default `V`.
+         */
+        template <typename V>
+        void write_template_table(std::string& out, const std::string& header, const toml::table& defaults) {
+            using Fields = typename rfl::named_tuple_t<V>::Fields;
+            out += std::format("[{}]\n", header);
+            [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                ([&] {
+                    using Field = rfl::tuple_element_t<Is, Fields>;
+                    using Type = std::remove_cvref_t<typename Field::Type>;
+                    if constexpr (!config::detail::is_path_struct_v<Type>) {
+                        out += std::format("# {}{}\n", describe_type<Type>(), validate::is_optional_v<Type> ? ", optional" : "");
+                        if (const toml::node* node = defaults.get(Field::name())) {
+                            out += std::format("{} = {}\n", Field::name(), format_value(*node));
+                        } else {
+                            out += std::format("# {} =\n", Field::name());
+                        }
+                    }
+                }(), ...);
+                ([&] {
+                    using Field = rfl::tuple_element_t<Is, Fields>;
+                    using Type = std::remove_cvref_t<typename Field::Type>;
+                    if constexpr (config::detail::is_path_struct_v<Type>) {
+                        static const toml::table empty;
+                        const toml::table* child = defaults.get_as<toml::table>(Field::name());
+                        out += '\n';
+                        write_template_table<Type>(out, std::format("{}.{}", header, Field::name()), child ? *child : empty);
+                    }
+                }(), ...);
+            }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+        }
+    }
+
+    /**
+     * @brief Returns the commented template of `T` under the root table `root_name`.
+     */
+    template <typename T>
+    std::string toml_template(const std::string_view root_name) {
+        std::string out = std::format("# Every field of the '{}' table with its default value.\n\n", root_name);
+        detail::write_template_table<T>(out, std::string(root_name), default_table<T>());
+        return out;
+    }
+}
@@ -0,0 +1,626 @@
+/**
+ * @file toml_writer.h
+ * @brief Streaming TOML serialization of configuration structures.
+ *
+ * This file defines `TomlWriter`, which walks a configuration struct with `reflect-cpp` field
+ * views and emits TOML text straight into a sink, without building a `toml::table` in between.
+ * Saving a config therefore holds the struct itself plus one fixed-size output buffer, instead
+ * of a copy of the struct, a TOML DOM, a string stream and its string.
+ *
+ * Any type with a `write(std::string_view)` member can be used as a sink; see `FileSink`,
+ * `AtomicFileSink` and `StringSink` in io.h.
+ *
+ * Output is deterministic: struct fields are written in declaration order, `std::map` members
+ * in key order, and the members of a `std::unordered_map` sorted by key, so equal configs always
+ * give byte-identical text.
+ *
+ * Schemas that use types the writer does not model (such as `rfl::Rename`, `rfl::Validator` or
+ * variants) are reported by `is_streamable_v` as not streamable; callers fall back to
+ * `rfl::toml::write` for those.
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <format>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "fourdst/config/compare.h"
+#include "fourdst/config/io.h"
+#include "fourdst/config/shard.h"
+#include "fourdst/config/sidecar.h"
+#include "fourdst/config/validate.h"
+#if FOURDST_CONFIG_USE_ARROW
+#include "fourdst/config/columnar.h"
+#endif
+
+#include "rfl.hpp"
+#include "rfl/toml.hpp"
+
+namespace fourdst::config::io {
+
+    class ColumnarWriter;
+
+    namespace detail {
+        /// Numbers that arrays are written for in blocks; `std::vector<bool>` has no contiguous storage.
+        template <typename Type>
+        constexpr bool is_number_v = std::is_arithmetic_v<Type> && !std::is_same_v<Type, bool>;
+
+        template <typename Type>
+        constexpr bool is_plain_struct_v = validate::is_reflectable_struct_v<Type> &&
+                                           !config::detail::is_std_array_v<Type> &&
+                                           std::is_aggregate_v<std::remove_cvref_t<Type>>;
+
+        template <typename Type, bool InArray = false>
+        struct streamable;
+
+        template <typename Type, bool InArray = false>
+        constexpr bool is_streamable_v = streamable<std::remove_cvref_t<Type>, InArray>::value;
+
+        template <typename Fields>
+        struct streamable_fields;
+
+        template <typename... Fields>
+        struct streamable_fields<rfl::Tuple<Fields...>>
+            : std::bool_constant<(is_streamable_v<typename Fields::Type> && ...)> {};
+
+        template <typename Type, bool InArray>
+        struct streamable {
+            static constexpr bool compute() {
+                if constexpr (std::is_arithmetic_v<Type> || std::is_enum_v<Type> || validate::is_string_like_v<Type> ||
+                              validate::is_tensor_v<Type> || validate::is_tunable_v<Type> || validate::is_quantity_v<Type> ||
+                              validate::is_stored_v<Type> ||
+                              validate::is_section_v<Type>) {
+                    return true;
+                } else if constexpr (validate::is_optional_v<Type>) {
+                    // TOML has no null, so a missing value can only be expressed by omitting a key.
+                    return !InArray && is_streamable_v<typename Type::value_type>;
+                } else if constexpr (validate::is_vector_v<Type> || config::detail::is_std_array_v<Type> ||
+                                     validate::is_soa_v<Type>) {
+                    return is_streamable_v<typename Type::value_type, true>;
+                } else if constexpr (validate::is_map_v<Type>) {
+                    return validate::is_string_like_v<typename Type::key_type> &&
+                           is_streamable_v<typename Type::mapped_type>;
+                } else if constexpr (validate::is_sharded_v<Type>) {
+                    return is_streamable_v<typename Type::value_type>;
+                } else if constexpr (is_plain_struct_v<Type>) {
+                    return streamable_fields<typename rfl::named_tuple_t<Type>::Fields>::value;
+                } else {
+                    return false;
+                }
+            }
+            static constexpr bool value = compute();
+        };
+
+        template <typename Type> struct unwrap_optional { using type = Type; };
+        template <typename Type> struct unwrap_optional<std::optional<Type>> : unwrap_optional<Type> {};
+        template <typename Type> using unwrap_optional_t = typename unwrap_optional<std::remove_cvref_t<Type>>::type;
+
+        /// Values written as `[section]` headers rather than `key = value` pairs.
+        template <typename Type>
+        constexpr bool is_table_v = is_plain_struct_v<unwrap_optional_t<Type>> || validate::is_map_v<unwrap_optional_t<Type>> ||
+                                    validate::is_sharded_v<unwrap_optional_t<Type>>;
+
+        /// Values written as `[[section]]` arrays of tables when non-empty.
+        template <typename Type>
+        constexpr bool is_table_array_v = [] {
+            using Inner = unwrap_optional_t<Type>;
+            if constexpr (validate::is_vector_v<Inner> || config::detail::is_std_array_v<Inner> || validate::is_soa_v<Inner>) {
+                return is_table_v<typename Inner::value_type> && !validate::is_optional_v<typename Inner::value_type>;
+            } else {
+                return false;
+            }
+        }();
+    }
+
+    /**
+     * @brief Whether `T` can be serialized by `TomlWriter`.
+     * @tparam T The configuration schema type.
+     */
+    template <typename T>
+    constexpr bool is_streamable_v = detail::is_plain_struct_v<T> && detail::is_streamable_v<T>;
+
+    /**
+     * @brief Serializes configuration structs as TOML directly into a sink.
+     *
+     * Within each table, plain `key = value` pairs are written first, in declaration order, and
+     * nested tables and arrays of tables follow as `[a.b]` / `[[a.b]]` sections, as TOML requires.
+     * Empty optionals are omitted. Tables and arrays nested inside arrays are written inline.
+     *
+     * @tparam Sink A type with a `write(std::string_view)` member.
+     *
+     * @par Examples
+     * @code
+     * fourdst::config::io::FileSink sink("run.toml");
+     * fourdst::config::io::TomlWriter writer(sink);
+     * writer.write_root("main", *cfg);
+     * sink.close();
+     * @endcode
+     */
+    template <typename Sink>
+    class TomlWriter {
+    public:
+        /**
+         * @brief Creates a writer emitting into `sink`.
+         * @param sink The output sink; must outlive the writer.
+         */
+        explicit TomlWriter(Sink& sink) : m_sink(sink) {}
+
+        /**
+         * @brief Moves large numeric arrays to sidecar files (see `sidecar.h`).
+         * @param sidecars The sidecar writer, or null to write every array inline; must outlive the writer.
+         */
+        void set_sidecars(SidecarWriter* sidecars) { m_sidecars = sidecars; }
+
+        /**
+         * @brief Moves large arrays of flat tables to Arrow IPC files (see `columnar.h`).
+         * @param columnar The columnar writer, or null to write every array of tables as sections; must outlive the writer.
+         */
+        void set_columnar(ColumnarWriter* columnar) { m_columnar = columnar; }
+
+        /**
+         * @brief Moves `Sharded` fields to shard files (see `shard.h`).
+         * @param shards The shard writer, or null to write every sharded field as a table; must outlive the writer.
+         */
+        void set_shards(ShardWriter* shards) { m_shards = shards; }
+
+        /**
+         * @brief Writes `value` as the table `[root_name]`.
+         * @param root_name The name of the root table.
+         * @param value The configuration content.
+         */
+        template <typename V>
+        void write_root(const std::string_view root_name, const V& value) {
+            static_assert(is_streamable_v<V>, "TomlWriter cannot serialize this schema; check io::is_streamable_v first.");
+            m_path.clear();
+            append_key(m_path, root_name);
+            m_field_path.clear();
+            m_field_path_valid = true;
+            write_table(value, false);
+        }
+
+        /**
+         * @brief Writes a nested table of the content as the section `[root_name.path]`.
+         * @param root_name The name of the root table.
+         * @param path Dotted path of the table below the root.
+         * @param value The table.
+         */
+        template <typename V>
+        void write_section(const std::string_view root_name, const std::string_view path, const V& value) {
+            m_path.clear();
+            append_key(m_path, root_name);
+            append_path(m_path, path);
+            m_field_path = path;
+            m_field_path_valid = true;
+            write_table(value, false);
+        }
+
+        /**
+         * @brief Writes `value` on one line as `root_name.path = <inline value>`.
+         *
+         * Tables are written as inline tables, so this also gives a single-line form of a whole
+         * config (with an empty `path`). Nothing is written for an empty optional.
+         *
+         * @param root_name The name of the root table.
+         * @param path Dotted path below the root; may be empty.
+         * @param value The value.
+         */
+        template <typename V>
+        void write_assignment(const std::string_view root_name, const std::string_view path, const V& value) {
+            const auto* inner = present(value);
+            if (inner == nullptr) return;
+            m_key.clear();
+            append_key(m_key, root_name);
+            append_path(m_key, path);
+            emit(m_key);
+            emit(" = ");
+            write_inline(*inner);
+            emit("\n");
+        }
+
+        /**
+         * @brief Writes `value` as the text that follows `=` in an assignment; tables are written inline.
+         * @param value The value.
+         */
+        template <typename V>
+        void write_value(const V& value) {
+            write_inline(value);
+        }
+
+    private:
+        template <typename V, typename Func>
+        static void for_each_member(const V& value, Func&& func) {
+            using Type = std::remove_cvref_t<V>;
+            if constexpr (validate::is_sharded_v<Type>) {
+                detail::require_all_shards(value);
+                for (const auto& [key, member] : value.entries()) {
+                    func(std::string_view(key), member);
+                }
+            } else if constexpr (validate::is_unordered_map_v<Type>) {
+                // Iteration order depends on the hash table's history; sort so equal maps write identically.
+                std::vector<const typename Type::value_type*> entries;
+                entries.reserve(value.size());
+                for (const auto& entry : value) entries.push_back(&entry);
+                std::ranges::sort(entries, [](const auto* lhs, const auto* rhs) {
+                    return std::string_view(lhs->first) < std::string_view(rhs->first);
+                });
+                for (const auto* entry : entries) {
+                    func(std::string_view(entry->first), entry->second);
+                }
+            } else if constexpr (validate::is_map_v<Type>) {
+                for (const auto& [key, member] : value) {
+                    func(std::string_view(key), member);
+                }
+            } else {
+                const auto view = rfl::to_view(value);
+                using Fields = typename std::remove_cvref_t<decltype(view)>::Fields;
+                [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                    (func(rfl::tuple_element_t<Is, Fields>::name(), *rfl::get<Is>(view.values())), ...);
+                }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>{});
+            }
+        }
+
+        template <typename V>
+        static const detail::unwrap_optional_t<V>* present(const V& value) {
+            if constexpr (validate::is_optional_v<V>) {
+                return value.has_value() ? present(*value) : nullptr;
+            } else {
+                return &value;
+            }
+        }
+
+        /// Whether a non-empty array of tables is written to a columnar file instead of as sections.
+        template <typename V>
+        [[nodiscard]] bool goes_to_columnar([[maybe_unused]] const V& rows) const {
+#if FOURDST_CONFIG_USE_ARROW
+            if constexpr (is_columnar_array_v<V>) {
+                return m_columnar != nullptr && m_field_path_valid && m_columnar->wants(rows.size());
+            }
+#endif
+            return false;
+        }
+
+        /// Whether a sharded field is written to a shard file instead of as a table.
+        template <typename V>
+        [[nodiscard]] bool goes_to_shard_file([[maybe_unused]] const V& value) const {
+            if constexpr (validate::is_sharded_v<V>) {
+                return m_shards != nullptr && m_field_path_valid;
+            }
+            return false;
+        }
+
+        /// Writes each shard of `value` as a `key = <value>` line of its shard file and returns the reference.
+        template <typename V>
+        std::string write_shard_file(const std::string_view key, const V& value) {
+            detail::require_all_shards(value);
+            std::vector<ShardWriter::Shard> shards;
+            shards.reserve(value.size());
+            for (const auto& [shard_key, entry] : value.entries()) {
+                ShardWriter::Shard& shard = shards.emplace_back();
+                append_key(shard.key, shard_key);
+                StringSink sink(shard.text);
+                TomlWriter<StringSink> writer(sink);
+                writer.write_assignment(shard_key, "", entry);
+            }
+            return m_shards->write(m_field_path.empty() ? std::string(key) : std::format("{}.{}", m_field_path, key), shards);
+        }
+
+        template <typename V>
+        void write_table(const V& value, const bool array_element) {
+            if (m_started) emit("\n");
+            m_started = true;
+            emit(array_element ? "[[" : "[");
+            emit(m_path);
+            emit(array_element ? "]]\n" : "]\n");
+
+            for_each_member(value, [this](const std::string_view key, const auto& member) {
+                using Member = std::remove_cvref_t<decltype(member)>;
+                const auto* inner = present(member);
+                if (inner == nullptr) return;
+                if constexpr (detail::is_table_v<Member>) {
+                    if (!goes_to_shard_file(*inner)) return;
+                } else if constexpr (detail::is_table_array_v<Member>) {
+                    if (inner->size() != 0 && !goes_to_columnar(*inner)) return;
+                }
+                write_key(key);
+                emit(" = ");
+                if constexpr (validate::is_sharded_v<std::remove_cvref_t<decltype(*inner)>>) {
+                    emit(write_shard_file(key, *inner));
+                    emit("\n");
+                    return;
+                }
+#if FOURDST_CONFIG_USE_ARROW
+                if constexpr (is_columnar_array_v<std::remove_cvref_t<decltype(*inner)>>) {
+                    if (goes_to_columnar(*inner)) {
+                        emit(m_columnar->write(m_field_path.empty() ? std::string(key) : std::format("{}.{}", m_field_path, key), *inner));
+                        emit("\n");
+                        return;
+                    }
+                }
+#endif
+                if constexpr (is_sidecar_array_v<std::remove_cvref_t<decltype(*inner)>> ||
+                              validate::is_tensor_v<decltype(*inner)>) {
+                    if (m_sidecars != nullptr && m_field_path_valid && m_sidecars->wants(inner->size())) {
+                        emit(m_sidecars->write(m_field_path.empty() ? std::string(key) : std::format("{}.{}", m_field_path, key), *inner));
+                        emit("\n");
+                        return;
+                    }
+                }
+                write_inline(*inner);
+                emit("\n");
+            });
+
+            for_each_member(value, [this](const std::string_view key, const auto& member) {
+                using Member = std::remove_cvref_t<decltype(member)>;
+                if constexpr (detail::is_table_v<Member> || detail::is_table_array_v<Member>) {
+                    const auto* inner = present(member);
+                    if (inner == nullptr) return;
+                    if constexpr (detail::is_table_array_v<Member>) {
+                        if (goes_to_columnar(*inner)) return;
+                    } else if (goes_to_shard_file(*inner)) {
+                        return;
+                    }
+                    const std::size_t parent_length = m_path.size();
+                    const std::size_t parent_field_length = m_field_path.size();
+                    const bool parent_field_path_valid = m_field_path_valid;
+                    m_path += '.';
+                    append_key(m_path, key);
+                    // Sidecar paths are field paths, which only continue through plain nested structs.
+                    if constexpr (detail::is_plain_struct_v<Member>) {
+                        if (!m_field_path.empty()) m_field_path += '.';
+                        m_field_path += key;
+                    } else {
+                        m_field_path_valid = false;
+                    }
+                    if constexpr (detail::is_table_v<Member>) {
+                        write_table(*inner, false);
+                    } else {
+                        for (const auto& element : *inner) {
+                            write_table(element, true);
+                        }
+                    }
+                    m_path.resize(parent_length);
+                    m_field_path.resize(parent_field_length);
+                    m_field_path_valid = parent_field_path_valid;
+                }
+            });
+        }
+
+        template <typename V>
+        void write_inline(const V& value) {
+            using Type = std::remove_cvref_t<V>;
+            if constexpr (std::is_same_v<Type, bool>) {
+                emit(value ? "true" : "false");
+            } else if constexpr (std::is_arithmetic_v<Type>) {
+                char buffer[max_number_length];
+                emit(std::string_view(buffer, format_number(value, buffer)));
+            } else if constexpr (std::is_enum_v<Type>) {
+                write_string(rfl::enum_to_string(value));
+            } else if constexpr (validate::is_string_like_v<Type>) {
+                write_string(value);
+            } else if constexpr (validate::is_tunable_v<Type>) {
+                write_inline(value.get());
+            } else if constexpr (validate::is_quantity_v<Type> || validate::is_stored_v<Type>) {
+                write_inline(value.value());
+            } else if constexpr (validate::is_section_v<Type>) {
+                write_string(value.path());
+            } else if constexpr (validate::is_tensor_v<Type>) {
+                std::size_t offset = 0;
+                write_tensor(value, 0, offset);
+            } else if constexpr ((validate::is_vector_v<Type> || config::detail::is_std_array_v<Type>) &&
+                                 detail::is_number_v<typename Type::value_type>) {
+                write_numbers(value.data(), value.size());
+            } else if constexpr (validate::is_vector_v<Type> || config::detail::is_std_array_v<Type> ||
+                                 validate::is_soa_v<Type>) {
+                emit("[");
+                bool first = true;
+                for (const auto& element : value) {
+                    if (!first) emit(", ");
+                    first = false;
+                    write_inline(element);
+                }
+                emit("]");
+            } else {
+                emit("{");
+                bool first = true;
+                for_each_member(value, [this, &first](const std::string_view key, const auto& member) {
+                    const auto* inner = present(member);
+                    if (inner == nullptr) return;
+                    emit(first ? " " : ", ");
+                    first = false;
+                    write_key(key);
+                    emit(" = ");
+                    write_inline(*inner);
+                });
+                emit(first ? "}" : " }");
+            }
+        }
+
+        /// Writes dimension `depth` of a tensor as nested arrays, consuming elements from `offset`.
+        template <typename V>
+        void write_tensor(const V& tensor, const std::size_t depth, std::size_t& offset) {
+            if constexpr (detail::is_number_v<typename V::value_type>) {
+                if (depth + 1 == V::rank) {
+                    write_numbers(tensor.data() + offset, tensor.extent(depth));
+                    offset += tensor.extent(depth);
+                    return;
+                }
+            }
+            emit("[");
+            for (std::size_t i = 0; i < tensor.extent(depth); ++i) {
+                if (i != 0) emit(", ");
+                if (depth + 1 == V::rank) {
+                    write_inline(tensor.data()[offset++]);
+                } else {
+                    write_tensor(tensor, depth + 1, offset);
+                }
+            }
+            emit("]");
+        }
+
+        /// Room for any number written by `format_number()`.
+        static constexpr std::size_t max_number_length = 48;
+
+        /**
+         * @brief Formats a number as TOML into `out`, which has room for `max_number_length` characters.
+         *
+         * Floats are written in the shortest form that reads back to the same value (`std::to_chars`
+         * without a precision), in their own type, so a `float` 0.1 is written as `0.1`.
+         *
+         * @return The number of characters written.
+         */
+        template <typename N>
+        static std::size_t format_number(const N value, char* out) {
+            if constexpr (std::is_same_v<N, bool>) {
+                const std::string_view text = value ? "true" : "false";
+                return static_cast<std::size_t>(text.copy(out, text.size()));
+            } else if constexpr (std::is_integral_v<N>) {
+                return static_cast<std::size_t>(std::to_chars(out, out + max_number_length, value).ptr - out);
+            } else {
+                if (std::isnan(value)) {
+                    return static_cast<std::size_t>(std::string_view("nan").copy(out, 3));
+                }
+                if (std::isinf(value)) {
+                    const std::string_view text = value < 0 ? "-inf" : "inf";
+                    return static_cast<std::size_t>(text.copy(out, text.size()));
+                }
+                // Wider types are read back as doubles, so they are written as doubles too.
+                using Written = std::conditional_t<std::is_same_v<N, float>, float, double>;
+                char* const end = std::to_chars(out, out + max_number_length - 2, static_cast<Written>(value)).ptr;
+                // TOML requires a fractional part or an exponent to read the value back as a float.
+                if (std::string_view(out, end).find_first_of(".e") != std::string_view::npos) {
+                    return static_cast<std::size_t>(end - out);
+                }
+                end[0] = '.';
+                end[1] = '0';
+                return static_cast<std::size_t>(end - out) + 2;
+            }
+        }
+
+        /**
+         * @brief Writes `count` numbers as an inline array, formatted into a local block that is
+         *        emitted whenever it fills, instead of emitting each element and separator.
+         */
+        template <typename N>
+        void write_numbers(const N* values, const std::size_t count) {
+            std::array<char, 4096> block;
+            std::size_t used = 0;
+            block[used++] = '[';
+            for (std::size_t i = 0; i < count; ++i) {
+                if (block.size() - used < max_number_length + 3) {
+                    emit(std::string_view(block.data(), used));
+                    used = 0;
+                }
+                if (i != 0) {
+                    block[used++] = ',';
+                    block[used++] = ' ';
+                }
+                used += format_number(values[i], block.data() + used);
+            }
+            block[used++] = ']';
+            emit(std::string_view(block.data(), used));
+        }
+
+        void write_key(const std::string_view key) {
+            m_key.clear();
+            append_key(m_key, key);
+            emit(m_key);
+        }
+
+        static void append_key(std::string& out, const std::string_view key) {
+            const bool bare = !key.empty() && key.find_first_not_of(
+                "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789_-") == std::string_view::npos;
+            if (bare) {
+                out += key;
+            } else {
+                append_quoted(out, key);
+            }
+        }
+
+        static void append_path(std::string& out, std::string_view path) {
+            while (!path.empty()) {
+                const std::size_t dot = path.find('.');
+                out += '.';
+                append_key(out, path.substr(0, dot));
+                path.remove_prefix(dot == std::string_view::npos ? path.size() : dot + 1);
+            }
+        }
+
+        void write_string(const std::string_view text) {
+            m_key.clear();
+            append_quoted(m_key, text);
+            emit(m_key);
+        }
+
+        static void append_quoted(std::string& out, const std::string_view text) {
+            out += '"';
+            for (const char c : text) {
+                switch (c) {
+                    case '"': out += "\\\""; break;
+                    case '\\': out += "\\\\"; break;
+                    case '\b': out += "\\b"; break;
+                    case '\t': out += "\\t"; break;
+                    case '\n': out += "\\n"; break;
+                    case '\f': out += "\\f"; break;
+                    case '\r': out += "\\r"; break;
+                    default:
+                        if (static_cast<unsigned char>(c) < 0x20 || c == '\x7f') {
+                            out += std::format("\\u{:04X}", static_cast<unsigned>(static_cast<unsigned char>(c)));
+                        } else {
+                            out += c;
+                        }
+                }
+            }
+            out += '"';
+        }
+
+        void emit(const std::string_view text) { m_sink.write(text); }
+
+        Sink& m_sink;
+        SidecarWriter* m_sidecars = nullptr;
+        ColumnarWriter* m_columnar = nullptr;
+        ShardWriter* m_shards = nullptr;
+        std::string m_path;
+        std::string m_field_path;
+        bool m_field_path_valid = true;
+        std::string m_key;
+        bool m_started = false;
+    };
+
+    /**
+     * @brief Writes `content` as the TOML document `[root_name]` into `sink`.
+     *
+     * Streamable schemas go through `TomlWriter`. Others are serialized with `rfl::toml::write`
+     * from a wrapper that refers to `content`, so `content` is never copied; toml++ then writes
+     * the keys of every table sorted, which is just as stable but not in declaration order.
+     *
+     * @param sink A sink with a `write(std::string_view)` member.
+     * @param root_name The name of the root table.
+     * @param content The configuration content.
+     * @param sidecars If not null, large numeric arrays of streamable schemas go to sidecar files.
+     * @param columnar If not null, large arrays of flat tables of streamable schemas go to columnar files.
+     * @param shards If not null, `Sharded` fields of streamable schemas go to shard files.
+     */
+    template <typename Sink, typename T>
+    void write_toml_document(Sink& sink, const std::string_view root_name, const T& content,
+                             SidecarWriter* sidecars = nullptr, ColumnarWriter* columnar = nullptr, ShardWriter* shards = nullptr) {
+        if constexpr (is_streamable_v<T>) {
+            TomlWriter writer(sink);
+            writer.set_sidecars(sidecars);
+            writer.set_columnar(columnar);
+            writer.set_shards(shards);
+            writer.write_root(root_name, content);
+        } else {
+            const std::map<std::string, std::reference_wrapper<const T>> wrapper{{std::string(root_name), std::cref(content)}};
+            sink.write(rfl::toml::write(wrapper));
+        }
+    }
+}
@@ -0,0 +1,152 @@
+/**
+ * @file trace.h
+ * @brief Begin/end trace zones around config operations, for Perfetto, Tracy, ITT or any other tracer.
+ *
+ * When built with `FOURDST_CONFIG_USE_TRACING` (the `tracing` meson option), `Config` opens a
+ * zone around `load()`, `save()`, `save_schema()`, `mutate()`, `reset()`, validation of a file
+ * that failed to load, and `std::format` output, and reports it to the `trace::Backend`
+ * installed with `trace::set_backend()`. Each zone carries the config's root name and, where
+ * there is one, a byte size (the file read or written, or the schema). Without the define the
+ * macros expand to nothing and their arguments are not evaluated.
+ *
+ * @code
+ * struct PerfettoBackend final : fourdst::config::trace::Backend {
+ *     void begin(const fourdst::config::trace::Zone& zone) override {
+ *         TRACE_EVENT_BEGIN("config", perfetto::DynamicString{std::string(zone.name())},
+ *                           "root", std::string(zone.root()));
+ *     }
+ *     void end(const fourdst::config::trace::Zone& zone) override {
+ *         TRACE_EVENT_END("config", "bytes", zone.bytes());
+ *     }
+ * };
+ * PerfettoBackend backend;
+ * fourdst::config::trace::set_backend(&backend);
+ * @endcode
+ *
+ * A build can also map zones straight onto a tracer's own scope macros by defining
+ * `FOURDST_CONFIG_TRACE_ZONE(var, name, root)` and `FOURDST_CONFIG_TRACE_BYTES(var, bytes)`
+ * before including any config header, e.g. to Tracy's `ZoneScopedN` and `ZoneValue`.
+ */
+#pragma once
+
+#if FOURDST_CONFIG_USE_TRACING
+
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace fourdst::config::trace {
+
+    class Zone;
+
+    /**
+     * @brief Receives the zones opened by config operations; implement it to forward them to a tracer.
+     *
+     * `begin()` and `end()` of one zone are called on the same thread, and zones nest.
+     */
+    class Backend {
+    public:
+        virtual ~Backend() = default;
+
+        /**
+         * @brief Called when a zone opens. `zone.bytes()` is usually not known yet.
+         */
+        virtual void begin(const Zone& zone) = 0;
+
+        /**
+         * @brief Called when a zone closes, normally or by an exception.
+         */
+        virtual void end(const Zone& zone) = 0;
+    };
+
+    namespace detail {
+        inline std::atomic<Backend*>& backend_slot() {
+            static std::atomic<Backend*> backend{nullptr};
+            return backend;
+        }
+    }
+
+    /**
+     * @brief Installs the backend zones are reported to; null stops tracing.
+     *
+     * The backend must outlive every zone opened while it is installed.
+     */
+    inline void set_backend(Backend* backend) {
+        detail::backend_slot().store(backend, std::memory_order_release);
+    }
+
+    /**
+     * @brief A trace zone, open for the lifetime of the object. Use through `FOURDST_CONFIG_TRACE_ZONE`.
+     */
+    class Zone {
+    public:
+        /**
+         * @brief Opens the zone if a backend is installed.
+         * @param name The operation, a string literal such as `"config.load"`.
+         * @param root The root name of the config; copied, since the operation may change it.
+         */
+        Zone(const std::string_view name, const std::string_view root)
+            : m_backend(detail::backend_slot().load(std::memory_order_acquire)), m_name(name) {
+            if (m_backend == nullptr) return;
+            m_root = root;
+            m_backend->begin(*this);
+        }
+
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+
+        ~Zone() {
+            if (m_backend != nullptr) m_backend->end(*this);
+        }
+
+        /// The operation.
+        [[nodiscard]] std::string_view name() const { return m_name; }
+        /// The root name of the config.
+        [[nodiscard]] std::string_view root() const { return m_root; }
+        /// Bytes read or written by the operation, 0 if not applicable or not known yet.
+        [[nodiscard]] std::size_t bytes() const { return m_bytes; }
+
+        /**
+         * @brief Sets the byte size reported when the zone closes.
+         */
+        void set_bytes(const std::size_t bytes) { m_bytes = bytes; }
+
+    private:
+        Backend* m_backend;
+        std::string_view m_name;
+        std::string m_root;
+        std::size_t m_bytes = 0;
+    };
+
+    /**
+     * @brief Returns the size of the file at `path`, or 0 if it cannot be read.
+     */
+    inline std::size_t file_bytes(const std::string_view path) {
+        std::error_code ec;
+        const auto size = std::filesystem::file_size(path, ec);
+        return ec ? 0 : static_cast<std::size_t>(size);
+    }
+}
+
+#ifndef FOURDST_CONFIG_TRACE_ZONE
+/// Opens a zone named `name` for the config root `root` until the end of the enclosing scope.
+#define FOURDST_CONFIG_TRACE_ZONE(var, name, root) ::fourdst::config::trace::Zone var(name, root)
+#endif
+#ifndef FOURDST_CONFIG_TRACE_BYTES
+/// Sets the byte size the zone `var` reports.
+#define FOURDST_CONFIG_TRACE_BYTES(var, bytes) (var).set_bytes(bytes)
+#endif
+
+#else
+
+#ifndef FOURDST_CONFIG_TRACE_ZONE
+#define FOURDST_CONFIG_TRACE_ZONE(var, name, root) static_cast<void>(0)
+#endif
+#ifndef FOURDST_CONFIG_TRACE_BYTES
+#define FOURDST_CONFIG_TRACE_BYTES(var, bytes) static_cast<void>(0)
+#endif
+
+#endif
@@ -0,0 +1,107 @@
+/**
+ * @file tunable.h
+ * @brief `Tunable<V>` fields, runtime knobs read lock-free in inner loops and updated in place.
+ *
+ * A `Tunable<V>` member holds a number, bool or enum in a relaxed atomic. Reading it is a plain
+ * load, and `Config::set()` stores a new value into it directly instead of copying the whole
+ * schema, publishing a snapshot and notifying subscribers as it does for other fields:
+ *
+ * @code
+ * struct SolverConfig {
+ *     int max_iterations = 100;
+ *     fourdst::config::Tunable<double> relaxation = 0.8;
+ * };
+ *
+ * const auto snapshot = cfg.snapshot();
+ * for (...) {
+ *     x += snapshot->relaxation.get() * dx; // sees later set() calls
+ * }
+ *
+ * cfg.set("relaxation", 0.6); // from a control thread
+ * @endcode
+ *
+ * Copies of a field, such as those in snapshots, share one value, so a store made through any of
+ * them is seen by all; this is what lets `set()` reach readers holding an older snapshot. Because
+ * they share it, stores through `set()` are not recorded for `undo()` and do not change the
+ * snapshot identity or the generation; they advance `Config::tunable_stores()` instead, and
+ * `fingerprint()` and the admin endpoint account for them. Assigning a `V` to the field itself, as `mutate()` and loads
+ * do, replaces the shared value instead, so copies made earlier keep the old one.
+ *
+ * Tunables read and write as a plain `V` in TOML, JSON and the schema.
+ */
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+
+#include "rfl.hpp"
+
+namespace fourdst::config {
+
+    /**
+     * @brief A field holding a `V` that can be stored to in place while it is being read.
+     * @tparam V An arithmetic or enum type whose `std::atomic` is always lock-free.
+     */
+    template <typename V>
+    class Tunable {
+        static_assert(std::is_arithmetic_v<V> || std::is_enum_v<V>, "Tunable holds numbers, bools and enums.");
+        static_assert(std::atomic<V>::is_always_lock_free, "Tunable requires a lock-free std::atomic<V>.");
+
+    public:
+        using value_type = V;
+
+        /**
+         * @brief Holds a value-initialized `V`.
+         */
+        Tunable() : Tunable(V{}) {}
+
+        /**
+         * @brief Holds `value`.
+         */
+        Tunable(const V value) : m_state(std::make_shared<State>(value)) {}  // NOLINT(google-explicit-constructor)
+
+        /**
+         * @brief Returns the current value.
+         */
+        [[nodiscard]] V get() const noexcept { return m_state->value.load(std::memory_order_relaxed); }
+
+        operator V() const noexcept { return get(); }  // NOLINT(google-explicit-constructor)
+
+        /**
+         * @brief Stores `value` into the value shared with every copy of this field.
+         */
+        void store(const V value) const noexcept { m_state->value.store(value, std::memory_order_relaxed); }
+
+        /**
+         * @brief Replaces the value; copies made earlier keep the old one.
+         */
+        Tunable& operator=(const V value) {
+            *this = Tunable(value);
+            return *this;
+        }
+
+    private:
+        struct State {
+            explicit State(const V initial) : value(initial) {}
+            std::atomic<V> value;
+        };
+
+        std::shared_ptr<State> m_state;
+    };
+}
+
+namespace rfl {
+
+    /**
+     * @brief Reads and writes `Tunable<V>` as a plain `V`.
+     */
+    template <typename V>
+    struct Reflector<fourdst::config::Tunable<V>> {
+        using ReflType = V;
+
+        static fourdst::config::Tunable<V> to(const ReflType& value) { return fourdst::config::Tunable<V>(value); }
+
+        static ReflType from(const fourdst::config::Tunable<V>& value) { return value.get(); }
+    };
+}
@@ -0,0 +1,779 @@
+/**
+ * @file updates.h
+ * @brief Pushing config changes to other processes as binary deltas, over TCP or MPI.
+ *
+ * An update frame holds the fields that changed between two snapshots, each encoded on its own
+ * with the codec of `binary.h` (compact JSON for fields it does not model), keyed by its index in
+ * the schema's path table, together with the content fingerprint and a generation number. The
+ * receiving side writes the fields into its config in one `transaction()`, so subscribers there
+ * see one published snapshot per update, and a frame that fails to decode changes nothing.
+ *
+ * `UpdatePublisher` listens on a TCP port and sends a frame to every connected subscriber each
+ * time its config publishes new content; a subscriber that connects first receives every field.
+ * `UpdateSubscriber` connects to a publisher and applies the frames on a background thread.
+ * A publisher listens on the loopback interface unless given another address, and then only
+ * with a token, which its subscribers must present:
+ *
+ * @code
+ * // Job controller
+ * fourdst::config::UpdatePublisher<RunConfig> publisher(cfg, {.bind_address = "::", .port = 7400, .token = secret});
+ * cfg.set("solver.tolerance", 1e-8);  // pushed to every worker
+ *
+ * // Worker
+ * fourdst::config::UpdateSubscriber<RunConfig> subscriber(cfg, "controller", 7400, secret);
+ * @endcode
+ *
+ * With MPI, `CollectiveUpdates::sync()` broadcasts the changes of one rank to the others instead.
+ *
+ * Generations increase with every frame a publisher sends; a receiver drops deltas whose
+ * generation is not newer than the last one it applied, so a late or repeated update never
+ * overwrites a newer one. Full frames are always applied. Both sides must be built with the same
+ * schema and byte order; a frame with another fingerprint is rejected.
+ *
+ * The TCP transport is available on POSIX systems.
+ */
+#pragma once
+
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/base.h"
+#include "fourdst/config/binary.h"
+#include "fourdst/config/compare.h"
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/path_table.h"
+#include "fourdst/config/validate.h"
+
+#include "rfl.hpp"
+#include "rfl/json.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#define FOURDST_CONFIG_HAS_POSIX_SOCKETS 1
+#else
+#define FOURDST_CONFIG_HAS_POSIX_SOCKETS 0
+#endif
+
+#if FOURDST_CONFIG_USE_MPI
+#include <mpi.h>
+#endif
+
+namespace fourdst::config {
+
+    namespace io {
+        /// Whether an update frame holds every field or only the changed ones.
+        enum class UpdateKind : std::uint8_t { FULL, DELTA };
+
+        namespace detail {
+            /// Leads every update frame ("FDCU" in little-endian order).
+            inline constexpr std::uint32_t update_magic = 0x55434446;
+
+            /**
+             * @brief How one path of `T` is compared, encoded and decoded in update frames.
+             */
+            struct UpdateField {
+                /// Whether the path is a nested struct, whose fields are sent instead of itself.
+                bool nested = false;
+                /// One past the last path below this one, in path table order.
+                std::size_t subtree_end = 0;
+                bool (*equal)(const void*, const void*) = nullptr;
+                void (*encode)(BinaryWriter&, const void*) = nullptr;
+                bool (*decode)(BinaryReader&, void*) = nullptr;
+            };
+
+            template <typename Type>
+            UpdateField make_update_field() {
+                UpdateField field;
+                field.nested = config::detail::is_path_struct_v<Type>;
+                field.equal = [](const void* a, const void* b) {
+                    return config::detail::equal(*static_cast<const Type*>(a), *static_cast<const Type*>(b));
+                };
+                if constexpr (io::detail::is_binary_encodable_v<Type>) {
+                    field.encode = [](BinaryWriter& writer, const void* value) { writer.write(*static_cast<const Type*>(value)); };
+                    field.decode = [](BinaryReader& reader, void* value) { return reader.read(*static_cast<Type*>(value)); };
+                } else {
+                    field.encode = [](BinaryWriter& writer, const void* value) {
+                        writer.write(rfl::json::write(*static_cast<const Type*>(value)));
+                    };
+                    field.decode = [](BinaryReader& reader, void* value) {
+                        std::string text;
+                        if (!reader.read(text)) return false;
+                        auto result = rfl::json::read<Type>(text);
+                        if (!result) return false;
+                        *static_cast<Type*>(value) = std::move(result).value();
+                        return true;
+                    };
+                }
+                return field;
+            }
+
+            template <typename T, typename V>
+            void collect_update_fields(std::vector<UpdateField>& fields, std::string& path) {
+                using Fields = typename rfl::named_tuple_t<V>::Fields;
+                [&]<int... Is>(std::integer_sequence<int, Is...>) {
+                    ([&] {
+                        using Field = rfl::tuple_element_t<Is, Fields>;
+                        using FieldType = std::remove_cvref_t<typename Field::Type>;
+                        const std::size_t parent_length = path.size();
+                        if (!path.empty()) path += '.';
+                        path += Field::name();
+                        fields[config::detail::PathTable<T>::find(path)] = make_update_field<FieldType>();
+                        if constexpr (config::detail::is_path_struct_v<FieldType>) {
+                            collect_update_fields<T, FieldType>(fields, path);
+                        }
+                        path.resize(parent_length);
+                    }(), ...);
+                }(std::make_integer_sequence<int, rfl::tuple_size_v<Fields>>());
+            }
+
+            /**
+             * @brief Returns the update codecs of every path of `T`, by path table index.
+             */
+            template <typename T>
+            const std::vector<UpdateField>& update_fields() {
+                static const std::vector<UpdateField> fields = [] {
+                    using Table = config::detail::PathTable<T>;
+                    std::vector<UpdateField> out(Table::size());
+                    std::string path;
+                    collect_update_fields<T, T>(out, path);
+                    // The table lists a struct's fields right after it, so its subtree is the run
+                    // of paths it prefixes.
+                    for (std::size_t i = 0; i < out.size(); ++i) {
+                        const std::string prefix = std::string(Table::path(i)) + '.';
+                        std::size_t end = i + 1;
+                        while (end < out.size() && Table::path(end).starts_with(prefix)) ++end;
+                        out[i].subtree_end = end;
+                    }
+                    return out;
+                }();
+                return fields;
+            }
+
+            template <typename T>
+            void* field_address(T& content, const std::size_t index) {
+                return const_cast<void*>(config::detail::PathTable<T>::entry(index).address(content));
+            }
+        }
+
+        /**
+         * @brief Appends an update frame to `out`.
+         *
+         * With `previous`, the frame is a delta holding the leaves of `current` that differ from
+         * it; subtrees that compare equal are skipped without visiting their leaves. Without it,
+         * the frame holds every top-level field of `current`.
+         *
+         * @return The number of fields in the frame.
+         */
+        template <IsConfigSchema T>
+        std::size_t encode_update(std::string& out, const std::uint64_t generation, const T* previous, const T& current) {
+            const auto& fields = detail::update_fields<T>();
+            std::string body;
+            BinaryWriter body_writer(body);
+            std::uint32_t count = 0;
+            for (std::size_t i = 0; i < fields.size();) {
+                const void* now = config::detail::PathTable<T>::entry(i).address(current);
+                if (previous != nullptr) {
+                    if (fields[i].equal(config::detail::PathTable<T>::entry(i).address(*previous), now)) {
+                        i = fields[i].subtree_end;
+                        continue;
+                    }
+                    if (fields[i].nested) {
+                        ++i;
+                        continue;
+                    }
+                }
+                body_writer.write(static_cast<std::uint32_t>(i));
+                fields[i].encode(body_writer, now);
+                ++count;
+                i = fields[i].subtree_end;
+            }
+
+            BinaryWriter writer(out);
+            writer.write(detail::update_magic);
+            writer.write(previous != nullptr ? UpdateKind::DELTA : UpdateKind::FULL);
+            writer.write(content_fingerprint<T>());
+            writer.write(generation);
+            writer.write(count);
+            out += body;
+            return count;
+        }
+    }
+
+    /**
+     * @brief Applies update frames to a config, dropping stale ones.
+     * @tparam T The configuration schema type.
+     */
+    template <IsConfigSchema T>
+    class UpdateReceiver {
+    public:
+        /**
+         * @brief Applies frames to `config`, which must outlive the receiver.
+         */
+        explicit UpdateReceiver(Config<T>& config) : m_config(config) {}
+
+        /**
+         * @brief Writes the fields of `frame` into the config in one `transaction()`.
+         *
+         * @return False if the frame holds no fields, or is a delta no newer than the last frame applied.
+         * @throws exceptions::ConfigLoadError If `frame` is not an update frame of this schema or is corrupt;
+         *         the config is then left unchanged.
+         */
+        bool apply(const std::string_view frame) {
+            io::BinaryReader reader(frame);
+            std::uint32_t magic = 0;
+            io::UpdateKind kind = io::UpdateKind::FULL;
+            std::uint64_t fingerprint = 0;
+            std::uint64_t generation = 0;
+            std::uint32_t count = 0;
+            if (!reader.read(magic) || magic != io::detail::update_magic || !reader.read(kind) ||
+                (kind != io::UpdateKind::FULL && kind != io::UpdateKind::DELTA) || !reader.read(fingerprint) ||
+                !reader.read(generation) || !reader.read(count)) {
+                throw exceptions::ConfigLoadError("Not a config update frame.");
+            }
+            if (fingerprint != io::content_fingerprint<T>()) {
+                throw exceptions::ConfigLoadError("The config update was sent with a different layout of the schema.");
+            }
+            if (kind == io::UpdateKind::DELTA && m_applied && generation <= m_generation) {
+                return false;
+            }
+            if (count == 0) {
+                m_generation = generation;
+                m_applied = true;
+                return false;
+            }
+
+            const auto& fields = io::detail::update_fields<T>();
+            m_config.transaction([&](T& content) {
+                for (std::uint32_t n = 0; n < count; ++n) {
+                    std::uint32_t index = 0;
+                    if (!reader.read(index) || index >= fields.size() || (fields[index].nested && kind == io::UpdateKind::DELTA) ||
+                        !fields[index].decode(reader, io::detail::field_address(content, index))) {
+                        throw exceptions::ConfigLoadError(std::format("The config update of generation {} is corrupt.", generation));
+                    }
+                }
+                if (reader.remaining() != 0) {
+                    throw exceptions::ConfigLoadError(std::format("The config update of generation {} is corrupt.", generation));
+                }
+            });
+            m_generation = generation;
+            m_applied = true;
+            return true;
+        }
+
+        /**
+         * @brief Returns the generation of the last frame applied; 0 before the first.
+         */
+        [[nodiscard]] std::uint64_t generation() const { return m_generation; }
+
+    private:
+        Config<T>& m_config;
+        std::uint64_t m_generation = 0;
+        bool m_applied = false;
+    };
+
+#if FOURDST_CONFIG_USE_MPI
+    /**
+     * @brief Propagates the changes made on one rank to the configs of the other ranks.
+     * @tparam T The configuration schema type.
+     */
+    template <IsConfigSchema T>
+    class CollectiveUpdates {
+    public:
+        /**
+         * @brief Synchronizes `config`, which must outlive this object.
+         */
+        explicit CollectiveUpdates(Config<T>& config) : m_config(config), m_receiver(config) {}
+
+        /**
+         * @brief Broadcasts the changes `root` made since the previous call and applies them on the other ranks.
+         *
+         * The first call sends every field. This is a collective call: every rank of `comm` must
+         * make it with the same `root`.
+         *
+         * @return True if any field was sent (on `root`) or applied (on the other ranks).
+         * @throws exceptions::ConfigLoadError If the broadcast fails or a rank was built with another layout of `T`.
+         */
+        bool sync(MPI_Comm comm, const int root = 0) {
+            int rank = 0;
+            MPI_Comm_rank(comm, &rank);
+            std::string frame;
+            bool sent = false;
+            if (rank == root) {
+                const std::shared_ptr<const T> current = m_config.snapshot();
+                sent = io::encode_update(frame, ++m_generation, m_sent.get(), *current) != 0;
+                m_sent = current;
+            }
+            io::broadcast_bytes(comm, root, frame);
+            if (rank != root) {
+                return m_receiver.apply(frame);
+            }
+            return sent;
+        }
+
+    private:
+        Config<T>& m_config;
+        UpdateReceiver<T> m_receiver;
+        std::shared_ptr<const T> m_sent;
+        std::uint64_t m_generation = 0;
+    };
+#endif
+
+#if FOURDST_CONFIG_HAS_POSIX_SOCKETS
+    namespace io::detail {
+        /// The longest token a publisher reads from a connecting subscriber.
+        inline constexpr std::uint64_t max_update_token = 4096;
+
+        inline bool send_all(const int fd, const char* data, std::size_t size) {
+#ifdef MSG_NOSIGNAL
+            constexpr int flags = MSG_NOSIGNAL;
+#else
+            constexpr int flags = 0;
+#endif
+            while (size > 0) {
+                const ssize_t sent = ::send(fd, data, size, flags);
+                if (sent < 0 && errno == EINTR) continue;
+                if (sent <= 0) return false;
+                data += sent;
+                size -= static_cast<std::size_t>(sent);
+            }
+            return true;
+        }
+
+        inline bool receive_all(const int fd, char* data, std::size_t size) {
+            while (size > 0) {
+                const ssize_t received = ::recv(fd, data, size, 0);
+                if (received < 0 && errno == EINTR) continue;
+                if (received <= 0) return false;
+                data += received;
+                size -= static_cast<std::size_t>(received);
+            }
+            return true;
+        }
+
+        /// Sends `frame` prefixed with its length.
+        inline bool send_frame(const int fd, const std::string_view frame) {
+            const std::uint64_t size = frame.size();
+            return send_all(fd, reinterpret_cast<const char*>(&size), sizeof(size)) && send_all(fd, frame.data(), frame.size());
+        }
+
+        /// Receives a frame sent by `send_frame()`; false if the connection ends or the frame is longer than `max_size`.
+        inline bool receive_frame(const int fd, std::string& frame, const std::uint64_t max_size) {
+            std::uint64_t size = 0;
+            if (!receive_all(fd, reinterpret_cast<char*>(&size), sizeof(size)) || size > max_size) return false;
+            frame.resize(static_cast<std::size_t>(size));
+            return receive_all(fd, frame.data(), frame.size());
+        }
+
+        inline void set_send_timeout(const int fd, const std::chrono::milliseconds timeout, const int option = SO_SNDTIMEO) {
+            timeval value{};
+            value.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+            value.tv_usec = static_cast<suseconds_t>(timeout.count() % 1000 * 1000);
+            ::setsockopt(fd, SOL_SOCKET, option, &value, sizeof(value));
+        }
+
+        /**
+         * @brief Compares in a time that depends only on the length of `expected`, so a token cannot be guessed byte by byte.
+         */
+        inline bool tokens_equal(const std::string_view given, const std::string_view expected) {
+            unsigned char difference = given.size() == expected.size() ? 0 : 1;
+            for (std::size_t i = 0; i < expected.size(); ++i) {
+                difference |= static_cast<unsigned char>(expected[i] ^ (i < given.size() ? given[i] : '\0'));
+            }
+            return difference == 0;
+        }
+
+        inline bool is_loopback(const sockaddr* address) {
+            if (address->sa_family == AF_INET) {
+                return (ntohl(reinterpret_cast<const sockaddr_in*>(address)->sin_addr.s_addr) >> 24) == 127;
+            }
+            if (address->sa_family == AF_INET6) {
+                const in6_addr& ip = reinterpret_cast<const sockaddr_in6*>(address)->sin6_addr;
+                return IN6_IS_ADDR_LOOPBACK(&ip) != 0 ||
+                       (IN6_IS_ADDR_V4MAPPED(&ip) != 0 && ip.s6_addr[12] == 127);
+            }
+            return false;
+        }
+    }
+
+    /**
+     * @brief Where an `UpdatePublisher` listens and whom it serves.
+     */
+    struct PublisherOptions {
+        /// The address to listen on; loopback by default. Any other address, e.g. `"::"` for every interface, needs a `token`.
+        std::string bind_address = "127.0.0.1";
+        /// The TCP port; 0 picks a free port (see `UpdatePublisher::port()`).
+        std::uint16_t port = 0;
+        /// If not empty, the secret a subscriber must present (see `UpdateSubscriber`) before it is sent anything.
+        std::string token;
+        /// How long a send to one subscriber, or its handshake, may take before the subscriber is dropped.
+        std::chrono::milliseconds timeout{2000};
+    };
+
+    /**
+     * @brief Sends the changes of a config to every connected `UpdateSubscriber`.
+     *
+     * The thread that publishes a change only encodes its frame and queues it; a sender thread of
+     * the publisher writes the queue to the subscribers, so a subscriber that stops reading never
+     * holds up the writers of the config. A subscriber whose connection fails, or that does not
+     * take a frame within `PublisherOptions::timeout`, is dropped. The publisher must not be
+     * destroyed while another thread is changing the config.
+     *
+     * Every subscriber sends a token when it connects; with `PublisherOptions::token` set, one
+     * that sends another token is disconnected before it is sent anything.
+     *
+     * @tparam T The configuration schema type.
+     */
+    template <IsConfigSchema T>
+    class UpdatePublisher {
+    public:
+        /**
+         * @brief Listens for subscribers on `options.bind_address`; `config` must outlive the publisher.
+         *
+         * @throws exceptions::ConfigError If the address cannot be opened, or is not a loopback address and no token is set.
+         */
+        explicit UpdatePublisher(Config<T>& config, PublisherOptions options = {}) : m_config(config), m_options(std::move(options)) {
+            listen();
+            m_sent = m_config.snapshot();
+            m_subscription = m_config.subscribe("", [this](const std::shared_ptr<const T>&) { publish(); });
+            m_sender = std::thread([this] { send_loop(); });
+            m_acceptor = std::thread([this] { accept_loop(); });
+        }
+
+        /**
+         * @brief Listens for subscribers on `port` of the loopback interface; 0 picks a free port.
+         */
+        UpdatePublisher(Config<T>& config, const std::uint16_t port) : UpdatePublisher(config, PublisherOptions{.port = port}) {}
+
+        UpdatePublisher(const UpdatePublisher&) = delete;
+        UpdatePublisher& operator=(const UpdatePublisher&) = delete;
+
+        ~UpdatePublisher() {
+            m_config.unsubscribe(m_subscription);
+            // shutdown() does not wake accept() on macOS/BSD, so the acceptor polls a pipe too.
+            const char byte = 1;
+            [[maybe_unused]] const auto written = ::write(m_wake_fds[1], &byte, 1);
+            m_acceptor.join();
+            {
+                const std::lock_guard lock(m_mutex);
+                m_stopping = true;
+            }
+            m_queued.notify_all();
+            m_sender.join();
+            for (const int fd : {m_listener, m_wake_fds[0], m_wake_fds[1]}) ::close(fd);
+            for (const int client : m_clients) ::close(client);
+            for (const Outgoing& outgoing : m_queue) {
+                if (outgoing.client >= 0) ::close(outgoing.client);
+            }
+        }
+
+        /**
+         * @brief Returns the port subscribers connect to.
+         */
+        [[nodiscard]] std::uint16_t port() const { return m_port; }
+
+        /**
+         * @brief Returns the generation of the last frame queued.
+         */
+        [[nodiscard]] std::uint64_t generation() const {
+            const std::lock_guard lock(m_mutex);
+            return m_generation;
+        }
+
+        /**
+         * @brief Returns the number of connected subscribers that were sent their first frame.
+         */
+        [[nodiscard]] std::size_t subscriber_count() const {
+            const std::lock_guard lock(m_mutex);
+            return m_clients.size();
+        }
+
+    private:
+        /// A frame waiting for the sender thread: to one new subscriber, or to all if `client` is -1.
+        struct Outgoing {
+            std::shared_ptr<const std::string> frame;
+            int client = -1;
+        };
+
+        void listen() {
+            addrinfo hints{};
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+            hints.ai_flags = AI_PASSIVE;
+            addrinfo* found = nullptr;
+            const std::string service = std::to_string(m_options.port);
+            const char* host = m_options.bind_address.empty() ? nullptr : m_options.bind_address.c_str();
+            if (const int error = ::getaddrinfo(host, service.c_str(), &hints, &found); error != 0) {
+                throw exceptions::ConfigError(
+                    std::format("Cannot resolve the config update address '{}': {}", m_options.bind_address, gai_strerror(error)));
+            }
+            if (m_options.token.empty() && !io::detail::is_loopback(found->ai_addr)) {
+                ::freeaddrinfo(found);
+                throw exceptions::ConfigError(std::format(
+                    "Refusing to publish config updates on '{}' without a token; set PublisherOptions::token or bind to loopback.",
+                    m_options.bind_address));
+            }
+            m_listener = ::socket(found->ai_family, found->ai_socktype, found->ai_protocol);
+            if (m_listener < 0) {
+                ::freeaddrinfo(found);
+                throw exceptions::ConfigError(std::format("Cannot open a socket for config updates: {}", std::strerror(errno)));
+            }
+            const int off = 0;
+            const int on = 1;
+            if (found->ai_family == AF_INET6) ::setsockopt(m_listener, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+            ::setsockopt(m_listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+            sockaddr_storage address{};
+            socklen_t length = sizeof(address);
+            const bool listening = ::bind(m_listener, found->ai_addr, found->ai_addrlen) == 0 && ::listen(m_listener, 16) == 0 &&
+                                   ::getsockname(m_listener, reinterpret_cast<sockaddr*>(&address), &length) == 0;
+            ::freeaddrinfo(found);
+            if (!listening || ::pipe(m_wake_fds) != 0) {
+                const std::string reason = std::strerror(errno);
+                ::close(m_listener);
+                throw exceptions::ConfigError(std::format("Cannot listen for config update subscribers on port {}: {}", m_options.port, reason));
+            }
+            m_port = ntohs(address.ss_family == AF_INET6 ? reinterpret_cast<const sockaddr_in6&>(address).sin6_port
+                                                         : reinterpret_cast<const sockaddr_in&>(address).sin_port);
+            for (const int fd : {m_listener, m_wake_fds[0], m_wake_fds[1]}) {
+                ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+                ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+            }
+        }
+
+        void accept_loop() {
+            while (true) {
+                pollfd fds[2] = {{m_listener, POLLIN, 0}, {m_wake_fds[0], POLLIN, 0}};
+                if (::poll(fds, 2, -1) < 0) {
+                    if (errno == EINTR) continue;
+                    return;
+                }
+                if (fds[1].revents != 0) return;
+                const int client = ::accept(m_listener, nullptr, nullptr);
+                if (client < 0) {
+                    if (errno == EINTR || errno == ECONNABORTED || errno == EAGAIN || errno == EWOULDBLOCK) continue;
+                    return;
+                }
+                ::fcntl(client, F_SETFL, ::fcntl(client, F_GETFL) & ~O_NONBLOCK);
+                const int on = 1;
+                ::setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+                io::detail::set_send_timeout(client, m_options.timeout);
+                io::detail::set_send_timeout(client, m_options.timeout, SO_RCVTIMEO);
+                std::string token;
+                if (!io::detail::receive_frame(client, token, io::detail::max_update_token) ||
+                    (!m_options.token.empty() && !io::detail::tokens_equal(token, m_options.token))) {
+                    ::close(client);
+                    continue;
+                }
+                const std::lock_guard lock(m_mutex);
+                auto frame = std::make_shared<std::string>();
+                io::encode_update(*frame, m_generation, static_cast<const T*>(nullptr), *m_sent);
+                m_queue.push_back({std::move(frame), client});
+                m_queued.notify_one();
+            }
+        }
+
+        void publish() {
+            const std::lock_guard lock(m_mutex);
+            // Callbacks of concurrent changes may run out of order, so the latest snapshot is sent.
+            const std::shared_ptr<const T> current = m_config.snapshot();
+            auto frame = std::make_shared<std::string>();
+            if (io::encode_update(*frame, m_generation + 1, m_sent.get(), *current) == 0) return;
+            ++m_generation;
+            m_sent = current;
+            m_queue.push_back({std::move(frame), -1});
+            m_queued.notify_one();
+        }
+
+        /**
+         * @brief Writes queued frames in order. A new subscriber joins once its full frame is sent, so
+         *        it gets exactly the deltas queued after that frame was encoded.
+         */
+        void send_loop() {
+            std::unique_lock lock(m_mutex);
+            while (true) {
+                m_queued.wait(lock, [&] { return m_stopping || !m_queue.empty(); });
+                if (m_stopping) return;
+                const Outgoing next = std::move(m_queue.front());
+                m_queue.pop_front();
+                std::vector<int> targets = next.client >= 0 ? std::vector<int>{next.client} : m_clients;
+                lock.unlock();
+                std::erase_if(targets, [&](const int client) { return io::detail::send_frame(client, *next.frame); });
+                lock.lock();
+                if (next.client >= 0 && targets.empty()) m_clients.push_back(next.client);
+                for (const int failed : targets) {
+                    std::erase(m_clients, failed);
+                    ::close(failed);
+                }
+            }
+        }
+
+        Config<T>& m_config;
+        PublisherOptions m_options;
+        int m_listener = -1;
+        int m_wake_fds[2] = {-1, -1};
+        std::uint16_t m_port = 0;
+        std::size_t m_subscription = 0;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_queued;
+        std::deque<Outgoing> m_queue;
+        bool m_stopping = false;
+        /// Only the sender thread changes the list, so it may send to them without the lock.
+        std::vector<int> m_clients;
+        std::shared_ptr<const T> m_sent;
+        std::uint64_t m_generation = 0;
+        std::thread m_sender;
+        std::thread m_acceptor;
+    };
+
+    /**
+     * @brief Applies the frames of an `UpdatePublisher` to a config, on a background thread.
+     * @tparam T The configuration schema type.
+     */
+    template <IsConfigSchema T>
+    class UpdateSubscriber {
+    public:
+        /// The longest frame accepted; a longer one ends the connection.
+        static constexpr std::uint64_t max_frame = std::uint64_t{1} << 30;
+
+        /**
+         * @brief Connects to the publisher at `host`:`port`; `config` must outlive the subscriber.
+         * @param token The token of the publisher, if it has one.
+         * @throws exceptions::ConfigError If the connection cannot be made.
+         */
+        UpdateSubscriber(Config<T>& config, const std::string& host, const std::uint16_t port, const std::string_view token = {})
+            : m_receiver(config) {
+            addrinfo hints{};
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+            addrinfo* found = nullptr;
+            const std::string service = std::to_string(port);
+            if (const int error = ::getaddrinfo(host.c_str(), service.c_str(), &hints, &found); error != 0) {
+                throw exceptions::ConfigError(std::format("Cannot resolve config update publisher '{}': {}", host, gai_strerror(error)));
+            }
+            for (const addrinfo* candidate = found; candidate != nullptr && m_socket < 0; candidate = candidate->ai_next) {
+                m_socket = ::socket(candidate->ai_family, candidate->ai_socktype, candidate->ai_protocol);
+                if (m_socket >= 0 && ::connect(m_socket, candidate->ai_addr, candidate->ai_addrlen) != 0) {
+                    ::close(m_socket);
+                    m_socket = -1;
+                }
+            }
+            ::freeaddrinfo(found);
+            if (m_socket < 0) {
+                throw exceptions::ConfigError(std::format("Cannot connect to config update publisher {}:{}.", host, port));
+            }
+            if (!io::detail::send_frame(m_socket, token)) {
+                ::close(m_socket);
+                throw exceptions::ConfigError(std::format("Cannot send the token to config update publisher {}:{}.", host, port));
+            }
+            m_reader = std::thread([this] { receive_loop(); });
+        }
+
+        UpdateSubscriber(const UpdateSubscriber&) = delete;
+        UpdateSubscriber& operator=(const UpdateSubscriber&) = delete;
+
+        ~UpdateSubscriber() {
+            ::shutdown(m_socket, SHUT_RDWR);
+            m_reader.join();
+            ::close(m_socket);
+        }
+
+        /**
+         * @brief Returns the generation of the last frame applied; 0 before the first.
+         */
+        [[nodiscard]] std::uint64_t generation() const {
+            const std::lock_guard lock(m_mutex);
+            return m_generation;
+        }
+
+        /**
+         * @brief Waits until a frame of at least `generation` has been applied, or the connection closed.
+         * @return True if the generation was reached within `timeout`.
+         */
+        bool wait_for(const std::uint64_t generation, const std::chrono::milliseconds timeout) const {
+            std::unique_lock lock(m_mutex);
+            m_applied.wait_for(lock, timeout, [&] { return (m_frames > 0 && m_generation >= generation) || m_closed; });
+            return m_frames > 0 && m_generation >= generation;
+        }
+
+        /**
+         * @brief Returns whether the publisher closed the connection.
+         */
+        [[nodiscard]] bool closed() const {
+            const std::lock_guard lock(m_mutex);
+            return m_closed;
+        }
+
+        /**
+         * @brief Returns the message of the last frame that could not be applied, or an empty string.
+         */
+        [[nodiscard]] std::string last_error() const {
+            const std::lock_guard lock(m_mutex);
+            return m_error;
+        }
+
+    private:
+        void receive_loop() {
+            std::string frame;
+            while (true) {
+                std::uint64_t size = 0;
+                if (!io::detail::receive_all(m_socket, reinterpret_cast<char*>(&size), sizeof(size))) break;
+                if (size > max_frame) {
+                    // The stream cannot be resynchronized past a frame that is not read.
+                    const std::lock_guard lock(m_mutex);
+                    m_error = std::format("A config update of {} bytes exceeds the limit of {} bytes; disconnected.", size, max_frame);
+                    break;
+                }
+                try {
+                    frame.resize(static_cast<std::size_t>(size));
+                    if (!io::detail::receive_all(m_socket, frame.data(), frame.size())) break;
+                    // Applied without the lock: subscribers of the config run inside and may query this object.
+                    m_receiver.apply(frame);
+                    const std::lock_guard lock(m_mutex);
+                    m_generation = m_receiver.generation();
+                    ++m_frames;
+                } catch (const std::exception& e) {
+                    const std::lock_guard lock(m_mutex);
+                    m_error = e.what();
+                }
+                m_applied.notify_all();
+            }
+            {
+                const std::lock_guard lock(m_mutex);
+                m_closed = true;
+            }
+            m_applied.notify_all();
+        }
+
+        UpdateReceiver<T> m_receiver;
+        int m_socket = -1;
+        mutable std::mutex m_mutex;
+        mutable std::condition_variable m_applied;
+        std::uint64_t m_generation = 0;
+        std::size_t m_frames = 0;
+        bool m_closed = false;
+        std::string m_error;
+        std::thread m_reader;
+    };
+#endif
+}
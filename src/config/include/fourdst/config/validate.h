@@ -1,6 +1,9 @@
 #pragma once
 
+#include "fourdst/config/aliases.h"
 #include "fourdst/config/ansi.h"
+#include "fourdst/config/enum_index.h"
+#include "fourdst/config/executor.h"
 
 #include <rfl.hpp>
 #include <toml++/toml.h>
@@ -14,6 +17,51 @@
 #include <map>
 #include <unordered_map>
 #include <sstream>
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace fourdst::config {
+    template <typename U>
+    class Lazy;
+
+    template <typename Container>
+    class SoA;
+
+    template <typename T, std::size_t Rank>
+    class Tensor;
+
+    template <typename V>
+    class Tunable;
+
+    template <typename Unit>
+    class Quantity;
+
+    template <typename Storage, typename Parsed>
+    class Stored;
+
+    template <typename K, typename V, typename Compare>
+    class FlatMap;
+
+    template <typename U>
+    class Section;
+
+    template <typename V>
+    class Sharded;
+
+    template <typename V>
+    class Sink;
+}
+
+namespace fourdst::config::detail {
+    template <typename Union>
+    struct TagIndex;
+}
 
 namespace fourdst::config::validate {
 
@@ -28,10 +76,84 @@ namespace fourdst::config::validate {
     template <typename T> struct is_map_impl : std::false_type {};
     template <typename K, typename V, typename C, typename A> struct is_map_impl<std::map<K, V, C, A>> : std::true_type {};
     template <typename K, typename V, typename H, typename E, typename A> struct is_map_impl<std::unordered_map<K, V, H, E, A>> : std::true_type {};
+    template <typename K, typename V, typename C> struct is_map_impl<FlatMap<K, V, C>> : std::true_type {};
     template <typename Type> constexpr bool is_map_v = is_map_impl<std::remove_cvref_t<Type>>::value;
 
+    template <typename T> struct is_unordered_map_impl : std::false_type {};
+    template <typename K, typename V, typename H, typename E, typename A> struct is_unordered_map_impl<std::unordered_map<K, V, H, E, A>> : std::true_type {};
+    template <typename Type> constexpr bool is_unordered_map_v = is_unordered_map_impl<std::remove_cvref_t<Type>>::value;
+
+    template <typename T> struct is_flat_map_impl : std::false_type {};
+    template <typename K, typename V, typename C> struct is_flat_map_impl<FlatMap<K, V, C>> : std::true_type {};
+    /// `fourdst::config::FlatMap` fields, maps held as a sorted vector of entries.
+    template <typename Type> constexpr bool is_flat_map_v = is_flat_map_impl<std::remove_cvref_t<Type>>::value;
+
+    template <typename T> struct is_std_array_impl : std::false_type {};
+    template <typename T, std::size_t N> struct is_std_array_impl<std::array<T, N>> : std::true_type {};
+    template <typename Type> constexpr bool is_std_array_v = is_std_array_impl<std::remove_cvref_t<Type>>::value;
+
+    template <typename T> struct is_std_string_impl : std::false_type {};
+    template <typename A> struct is_std_string_impl<std::basic_string<char, std::char_traits<char>, A>> : std::true_type {};
+    /// `std::string` and strings with other allocators, such as `std::pmr::string`.
+    template <typename Type> constexpr bool is_std_string_v = is_std_string_impl<std::remove_cvref_t<Type>>::value;
+
+    template <typename T> struct is_lazy_impl : std::false_type {};
+    template <typename U> struct is_lazy_impl<Lazy<U>> : std::true_type {};
+    /// `fourdst::config::Lazy` fields, which validate, compare and serialize as their `value_type`.
+    template <typename Type> constexpr bool is_lazy_v = is_lazy_impl<std::remove_cvref_t<Type>>::value;
+
+    template <typename T> struct is_section_impl : std::false_type {};
+    template <typename U> struct is_section_impl<Section<U>> : std::true_type {};
+    /// `fourdst::config::Section` fields, which validate and serialize as the path of their file.
+    template <typename Type> constexpr bool is_section_v = is_section_impl<std::remove_cvref_t<Type>>::value;
+
+    template <typename T> struct is_sharded_impl : std::false_type {};
+    template <typename V> struct is_sharded_impl<Sharded<V>> : std::true_type {};
+    /// `fourdst::config::Sharded` fields, which validate as a table of their `value_type` unless they reference a shard file.
+    template <typename Type> constexpr bool is_sharded_v = is_sharded_impl<std::remove_cvref_t<Type>>::value;
+
+    template <typename T> struct is_sink_impl : std::false_type {};
+    template <typename V> struct is_sink_impl<Sink<V>> : std::true_type {};
+    /// `fourdst::config::Sink` fields, which validate and serialize as an array of their `value_type`.
+    template <typename Type> constexpr bool is_sink_v = is_sink_impl<std::remove_cvref_t<Type>>::value;
+
+    template <typename T> struct is_tunable_impl : std::false_type {};
+    template <typename V> struct is_tunable_impl<Tunable<V>> : std::true_type {};
+    /// `fourdst::config::Tunable` fields, which validate, compare and serialize as their `value_type`.
+    template <typename Type> constexpr bool is_tunable_v = is_tunable_impl<std::remove_cvref_t<Type>>::value;
+
+    template <typename T> struct is_quantity_impl : std::false_type {};
+    template <typename Unit> struct is_quantity_impl<Quantity<Unit>> : std::true_type {};
+    /// `fourdst::config::Quantity` fields, numbers in a canonical unit that TOML may give with a unit.
+    template <typename Type> constexpr bool is_quantity_v = is_quantity_impl<std::remove_cvref_t<Type>>::value;
+
+    template <typename T> struct is_stored_impl : std::false_type {};
+    template <typename Storage, typename Parsed> struct is_stored_impl<Stored<Storage, Parsed>> : std::true_type {};
+    /// `fourdst::config::Stored` fields, numbers read in one precision and held in a narrower one.
+    template <typename Type> constexpr bool is_stored_v = is_stored_impl<std::remove_cvref_t<Type>>::value;
+
+    template <typename T> struct is_tagged_union_impl : std::false_type {};
+    template <rfl::internal::StringLiteral D, typename... Ts> struct is_tagged_union_impl<rfl::TaggedUnion<D, Ts...>> : std::true_type {};
+    /// `rfl::TaggedUnion` fields, tables whose discriminator key selects the alternative struct.
+    template <typename Type> constexpr bool is_tagged_union_v = is_tagged_union_impl<std::remove_cvref_t<Type>>::value;
+
+    template <typename T> struct is_soa_impl : std::false_type {};
+    template <typename S> struct is_soa_impl<SoA<std::vector<S>>> : std::true_type {};
+    /// `fourdst::config::SoA` fields, which validate and serialize as a vector of their `value_type`.
+    template <typename Type> constexpr bool is_soa_v = is_soa_impl<std::remove_cvref_t<Type>>::value;
+
+    template <typename T> struct is_tensor_impl : std::false_type {};
+    template <typename T, std::size_t Rank> struct is_tensor_impl<Tensor<T, Rank>> : std::true_type {};
+    /// `fourdst::config::Tensor` fields, written as nested arrays.
+    template <typename Type> constexpr bool is_tensor_v = is_tensor_impl<std::remove_cvref_t<Type>>::value;
+
+    template <typename T> struct is_rfl_validator_impl : std::false_type {};
+    template <typename T, typename V, typename... Vs> struct is_rfl_validator_impl<rfl::Validator<T, V, Vs...>> : std::true_type {};
+    /// `rfl::Validator` fields, which validate, compare and serialize as their `ReflectionType`.
+    template <typename Type> constexpr bool is_rfl_validator_v = is_rfl_validator_impl<std::remove_cvref_t<Type>>::value;
+
     template <typename Type>
-    constexpr bool is_string_like_v = std::is_same_v<std::remove_cvref_t<Type>, std::string> ||
+    constexpr bool is_string_like_v = is_std_string_v<Type> ||
                                       std::is_same_v<std::remove_cvref_t<Type>, std::string_view>;
 
     template <typename Type>
@@ -39,80 +161,697 @@ namespace fourdst::config::validate {
                                            !is_string_like_v<Type> &&
                                            !is_vector_v<Type> &&
                                            !is_optional_v<Type> &&
+                                           !is_lazy_v<Type> &&
+                                           !is_section_v<Type> &&
+                                           !is_sharded_v<Type> &&
+                                           !is_sink_v<Type> &&
+                                           !is_tunable_v<Type> &&
+                                           !is_quantity_v<Type> &&
+                                           !is_stored_v<Type> &&
+                                           !is_tagged_union_v<Type> &&
+                                           !is_soa_v<Type> &&
+                                           !is_tensor_v<Type> &&
+                                           !is_rfl_validator_v<Type> &&
                                            !is_map_v<Type>;
 
+    /**
+     * @brief Kinds of problems the validator reports.
+     */
+    enum class IssueKind {
+        /// A required (non-optional) field is absent.
+        MISSING_FIELD,
+        /// A value has the wrong TOML type, or does not fit the field (out of range, unknown enumerator).
+        TYPE_MISMATCH,
+        /// A fixed-size array field has the wrong number of elements.
+        ARRAY_SIZE_MISMATCH,
+        /// A key does not name any field of the schema.
+        UNKNOWN_KEY,
+        /// A value has the right type but fails the constraint of its `rfl::Validator` field.
+        CONSTRAINT_VIOLATION,
+        /// An expression in a numeric field does not evaluate (see `expression.h`).
+        BAD_EXPRESSION,
+        /// A key is the old name of a renamed field (see `aliases.h`); reported by `check_aliases()` only.
+        DEPRECATED_KEY
+    };
+
+    /**
+     * @brief One problem found while validating a TOML table against a schema.
+     */
+    struct ValidationIssue {
+        IssueKind kind;
+        /// Dotted path of the offending field or key, e.g. `main.species[3].mass`.
+        std::string path;
+        /// Human-readable description, e.g. `expected float, found string`.
+        std::string message;
+        /// The file the offending value (or, for a missing field, its table) was parsed from; empty if unknown.
+        std::string file;
+        /// 1-based line of that value in `file`, 0 if unknown.
+        std::size_t line = 0;
+        /// 1-based column of that value in `file`, 0 if unknown.
+        std::size_t column = 0;
+    };
+
+    /**
+     * @brief Returns `issue` with the position `node` was parsed from.
+     */
+    inline ValidationIssue located(const toml::node& node, ValidationIssue issue) {
+        const toml::source_region& source = node.source();
+        if (source.path) issue.file = *source.path;
+        issue.line = source.begin.line;
+        issue.column = source.begin.column;
+        return issue;
+    }
+
+    /**
+     * @brief Tuning knobs for `ConfigValidator::validate()`.
+     */
+    struct ValidationOptions {
+        /// Arrays of tables with at least this many elements are validated on several threads, run on the default executor.
+        std::size_t parallel_threshold = 4096;
+        /// Maximum number of threads for one array; 0 uses `std::thread::hardware_concurrency()`.
+        unsigned max_threads = 0;
+    };
+
+    inline std::string_view describe_node_type(const toml::node& node) {
+        if (node.is_table()) return "table";
+        if (node.is_array()) return "array";
+        if (node.is_string()) return "string";
+        if (node.is_integer()) return "integer";
+        if (node.is_floating_point()) return "float";
+        if (node.is_boolean()) return "boolean";
+        return "date/time";
+    }
+
+    /**
+     * @brief Returns the Levenshtein distance between two keys.
+     */
+    inline std::size_t edit_distance(const std::string_view a, const std::string_view b) {
+        std::vector<std::size_t> row(b.size() + 1);
+        for (std::size_t j = 0; j <= b.size(); ++j) row[j] = j;
+        for (std::size_t i = 1; i <= a.size(); ++i) {
+            std::size_t diagonal = row[0];
+            row[0] = i;
+            for (std::size_t j = 1; j <= b.size(); ++j) {
+                const std::size_t above = row[j];
+                row[j] = std::min({row[j] + 1, row[j - 1] + 1, diagonal + (a[i - 1] == b[j - 1] ? 0 : 1)});
+                diagonal = above;
+            }
+        }
+        return row[b.size()];
+    }
+
+    /**
+     * @brief The field names of a struct, sorted at compile time.
+     *
+     * Lookups are a binary search over string views and allocate nothing; the nearest name for a
+     * typo is only computed when a key is not found.
+     *
+     * @tparam Fields The `rfl::Field` types of the struct, as in `rfl::named_tuple_t<S>::Fields`.
+     */
+    template <typename... Fields>
+    struct KeyIndex {
+        static constexpr std::array<std::string_view, sizeof...(Fields)> keys = [] {
+            std::array<std::string_view, sizeof...(Fields)> names{Fields::name()...};
+            std::ranges::sort(names);
+            return names;
+        }();
+
+        static constexpr bool contains(const std::string_view key) {
+            return std::ranges::binary_search(keys, key);
+        }
+
+        /**
+         * @brief Returns the field name closest to `key`, or an empty view if none is close.
+         *
+         * A name is close if at most a third of its characters (and at least two) differ.
+         */
+        static std::string_view nearest(const std::string_view key) {
+            std::string_view best;
+            std::size_t best_distance = std::max<std::size_t>(2, key.size() / 3) + 1;
+            for (const std::string_view candidate : keys) {
+                // The distance is at least the difference in length, so a runaway key costs no table.
+                const std::size_t length_gap = key.size() > candidate.size() ? key.size() - candidate.size() : candidate.size() - key.size();
+                if (length_gap >= best_distance) continue;
+                const std::size_t distance = edit_distance(key, candidate);
+                if (distance < best_distance) {
+                    best = candidate;
+                    best_distance = distance;
+                }
+            }
+            return best;
+        }
+
+        /**
+         * @brief Returns the issue message for the unknown key `key`, with a suggestion if one is close.
+         */
+        static std::string unknown_key_message(const std::string_view key) {
+            const std::string_view suggestion = nearest(key);
+            return suggestion.empty() ? std::string("unknown key") : std::format("unknown key; did you mean '{}'?", suggestion);
+        }
+    };
+
+    /**
+     * @brief Checks TOML tables against a schema in a single pass.
+     *
+     * `validate()` walks the table and the schema together and records every missing required
+     * field, type mismatch, out-of-range integer, unknown enumerator, wrong fixed array length,
+     * unknown key and failed `rfl::Validator` constraint, so a failed load can report all problems
+     * at once. Unknown keys come with the nearest field name when one is close. A tagged union is
+     * checked against the alternative its discriminator names. Old field names declared with
+     * `field_aliases` are resolved as the reader resolves them. Value types the validator does not
+     * model (such as untagged variants) are not checked.
+     *
+     * @tparam StructType The schema (or sub-schema) the table must match.
+     */
     template <typename StructType>
     struct ConfigValidator {
         using NT = rfl::named_tuple_t<StructType>;
 
+        /**
+         * @brief Collects the paths of missing required fields only.
+         */
         static void check(const toml::table* tbl, const std::string& current_path, std::vector<std::string>& missing) {
             if (!tbl) return;
-            check_tuple<NT>(tbl, current_path, missing);
+            std::vector<ValidationIssue> issues;
+            validate(tbl, current_path, issues);
+            for (auto& issue : issues) {
+                if (issue.kind == IssueKind::MISSING_FIELD) {
+                    missing.push_back(std::move(issue.path));
+                }
+            }
+        }
+
+        /**
+         * @brief Collects every problem in `tbl`.
+         * @param tbl The table to check (may be null).
+         * @param current_path Dotted path of `tbl`, used as the prefix of reported paths.
+         * @param issues Receives the problems found, in traversal order.
+         * @param options Controls parallel validation of large arrays of tables.
+         */
+        static void validate(const toml::table* tbl, const std::string& current_path, std::vector<ValidationIssue>& issues,
+                             const ValidationOptions& options = {}) {
+            if (!tbl) return;
+            std::string path = current_path;
+            validate_into(*tbl, path, issues, options);
         }
+
+        /**
+         * @brief Checks `tbl`, using `path` as a scratch buffer holding the current field path.
+         *
+         * Each level appends its segment to the buffer and truncates it again on return, so
+         * walking the table allocates nothing beyond the buffer's growth; strings are only
+         * materialized for reported issues.
+         */
+        static void validate_into(const toml::table& tbl, std::string& path, std::vector<ValidationIssue>& issues,
+                                  const ValidationOptions& options) {
+            TupleChecker<NT>::check(tbl, path, issues, options);
+        }
+
+        /**
+         * @brief Reports keys of `tbl` and its nested tables that name no field of the schema.
+         *
+         * Only table keys are looked at, not values, so this is much cheaper than `validate()`.
+         * Each table's keys are looked up in the `KeyIndex` of its struct, so a document without
+         * unknown keys is checked without allocating, apart from the growth of `path`.
+         *
+         * @param tbl The table to check.
+         * @param path Dotted path of `tbl`; used as a scratch buffer and restored on return.
+         * @param issues Receives an `UNKNOWN_KEY` issue for every unknown key, in traversal order.
+         */
+        static void check_keys(const toml::table& tbl, std::string& path, std::vector<ValidationIssue>& issues) {
+            TupleChecker<NT>::template walk_keys<KeyCheck::UNKNOWN>(tbl, path, issues);
+        }
+
+        /**
+         * @brief Reports the old field names (see aliases.h) used in `tbl` and its nested tables.
+         *
+         * Walks the keys as `check_keys()` does. Schemas that declare no aliases pay one walk over the keys.
+         *
+         * @param tbl The table to check.
+         * @param path Dotted path of `tbl`; used as a scratch buffer and restored on return.
+         * @param issues Receives a `DEPRECATED_KEY` issue for every old name used, naming the new one.
+         */
+        static void check_aliases(const toml::table& tbl, std::string& path, std::vector<ValidationIssue>& issues) {
+            TupleChecker<NT>::template walk_keys<KeyCheck::ALIASES>(tbl, path, issues);
+        }
+
     private:
+        /// What a walk over the keys reports.
+        enum class KeyCheck { UNKNOWN, ALIASES };
+
         template <typename Tuple>
         struct TupleChecker;
 
         template <typename... Fields>
         struct TupleChecker<rfl::NamedTuple<Fields...>> {
-            static void check(const toml::table* tbl, const std::string& path, std::vector<std::string>& missing) {
-                (check_field<Fields>(tbl, path, missing), ...);
+            static void check(const toml::table& tbl, std::string& path, std::vector<ValidationIssue>& issues,
+                              const ValidationOptions& options) {
+                (check_field<Fields>(tbl, path, issues, options), ...);
+                report_unknown_keys(tbl, path, issues);
+            }
+
+            template <KeyCheck Check>
+            static void walk_keys(const toml::table& tbl, std::string& path, std::vector<ValidationIssue>& issues) {
+                if constexpr (Check == KeyCheck::UNKNOWN) {
+                    report_unknown_keys(tbl, path, issues);
+                } else {
+                    report_aliases(tbl, path, issues);
+                }
+                (check_field_keys<Fields, Check>(tbl, path, issues), ...);
+            }
+
+            static void report_unknown_keys(const toml::table& tbl, const std::string& path, std::vector<ValidationIssue>& issues) {
+                using Index = KeyIndex<Fields...>;
+                for (auto&& [key, node] : tbl) {
+                    const std::string_view name = key.str();
+                    if (!Index::contains(name) && !fourdst::config::detail::is_alias_head<StructType>(name)) {
+                        issues.push_back(located(node, {IssueKind::UNKNOWN_KEY, join(path, name), Index::unknown_key_message(name)}));
+                    }
+                }
+            }
+
+            static void report_aliases(const toml::table& tbl, const std::string& path, std::vector<ValidationIssue>& issues) {
+                for (const FieldAlias& alias : field_aliases<StructType>::aliases) {
+                    if (const toml::node* node = fourdst::config::detail::find_alias_node(tbl, alias)) {
+                        issues.push_back(located(*node, {IssueKind::DEPRECATED_KEY, join(path, alias.name),
+                                                         std::format("renamed to '{}'", join(path, alias.field))}));
+                    }
+                }
             }
         };
 
-        template <typename TupleType>
-        static void check_tuple(const toml::table* tbl, const std::string& path, std::vector<std::string>& missing) {
-            TupleChecker<TupleType>::check(tbl, path, missing);
+        template <typename Field, KeyCheck Check>
+        static void check_field_keys(const toml::table& tbl, std::string& path, std::vector<ValidationIssue>& issues) {
+            constexpr std::string_view name = Field::name();
+            if (const toml::node* node = fourdst::config::detail::find_field_node<StructType>(tbl, name)) {
+                const std::size_t parent_length = path.size();
+                push_segment(path, name);
+                check_value_keys<std::remove_cvref_t<typename Field::Type>, Check>(*node, path, issues);
+                path.resize(parent_length);
+            }
         }
 
-        template <typename Field>
-        static void check_field(const toml::table* tbl, const std::string& path, std::vector<std::string>& missing) {
-            std::string_view name_sv = Field::name();
-            std::string name(name_sv);
+        /// Walks the keys of `tbl`, a table of the struct `Type`.
+        template <typename Type, KeyCheck Check>
+        static void walk_struct_keys(const toml::table& tbl, std::string& path, std::vector<ValidationIssue>& issues) {
+            if constexpr (Check == KeyCheck::UNKNOWN) {
+                ConfigValidator<Type>::check_keys(tbl, path, issues);
+            } else {
+                ConfigValidator<Type>::check_aliases(tbl, path, issues);
+            }
+        }
 
-            using RawType = typename Field::Type;
-            using Type = std::remove_cvref_t<RawType>;
+        /// Descends into the tables a value of `Type` holds; values of the wrong type are skipped.
+        template <typename Type, KeyCheck Check>
+        static void check_value_keys(const toml::node& node, std::string& path, std::vector<ValidationIssue>& issues) {
+            if constexpr (is_optional_v<Type> || is_lazy_v<Type>) {
+                check_value_keys<std::remove_cvref_t<typename Type::value_type>, Check>(node, path, issues);
+            } else if constexpr (is_sharded_v<Type>) {
+                if (const toml::table* shards = node.as_table(); shards != nullptr && !shards->contains(Type::reference_key)) {
+                    check_value_keys<typename Type::map_type, Check>(node, path, issues);
+                }
+            } else if constexpr (is_std_array_v<Type> || is_vector_v<Type> || is_soa_v<Type>) {
+                using Element = std::remove_cvref_t<typename Type::value_type>;
+                if constexpr (is_reflectable_struct_v<Element> || is_optional_v<Element> || is_vector_v<Element> ||
+                              is_std_array_v<Element> || is_map_v<Element>) {
+                    if (const toml::array* arr = node.as_array()) {
+                        const std::size_t field_length = path.size();
+                        for (std::size_t i = 0; i < arr->size(); ++i) {
+                            push_index(path, i);
+                            check_value_keys<Element, Check>(*arr->get(i), path, issues);
+                            path.resize(field_length);
+                        }
+                    }
+                }
+            } else if constexpr (is_map_v<Type>) {
+                if constexpr (is_string_like_v<typename Type::key_type>) {
+                    if (const toml::table* members = node.as_table()) {
+                        const std::size_t parent_length = path.size();
+                        for (auto&& [key, member] : *members) {
+                            push_segment(path, key.str());
+                            check_value_keys<std::remove_cvref_t<typename Type::mapped_type>, Check>(member, path, issues);
+                            path.resize(parent_length);
+                        }
+                    }
+                }
+            } else if constexpr (is_tagged_union_v<Type>) {
+                using Index = fourdst::config::detail::TagIndex<Type>;
+                const toml::table* child = node.as_table();
+                const auto* tag = child != nullptr ? child->get_as<std::string>(Index::discriminator) : nullptr;
+                const std::size_t alternative = tag != nullptr ? Index::find(tag->get()) : Index::npos;
+                if (alternative == Index::npos) return;
+                const std::size_t before = issues.size();
+                Index::dispatch(alternative, [&]<typename Alternative>(std::type_identity<Alternative>) {
+                    walk_struct_keys<Alternative, Check>(*child, path, issues);
+                });
+                forgive_discriminator<Index>(path, issues, before);
+            } else if constexpr (is_reflectable_struct_v<Type> && std::is_aggregate_v<Type>) {
+                if (const toml::table* child = node.as_table()) {
+                    walk_struct_keys<Type, Check>(*child, path, issues);
+                }
+            }
+        }
+
+        /// Drops the `UNKNOWN_KEY` issue an alternative without a discriminator field reports for it.
+        template <typename Index>
+        static void forgive_discriminator(const std::string& path, std::vector<ValidationIssue>& issues, const std::size_t before) {
+            const std::string key = join(path, Index::discriminator);
+            std::erase_if(issues, [&, i = std::size_t{0}](const ValidationIssue& issue) mutable {
+                return i++ >= before && issue.kind == IssueKind::UNKNOWN_KEY && issue.path == key;
+            });
+        }
+
+        static std::string join(const std::string_view path, const std::string_view name) {
+            return path.empty() ? std::string(name) : std::format("{}.{}", path, name);
+        }
+
+        static void push_segment(std::string& path, const std::string_view name) {
+            if (!path.empty()) path += '.';
+            path += name;
+        }
+
+        static void push_index(std::string& path, const std::size_t i) {
+            char index[24];
+            const auto result = std::to_chars(index, index + sizeof(index), i);
+            path += '[';
+            path.append(index, result.ptr);
+            path += ']';
+        }
+
+        static void mismatch(const toml::node& node, const std::string& path, const std::string_view expected,
+                             std::vector<ValidationIssue>& issues) {
+            issues.push_back(located(node, {IssueKind::TYPE_MISMATCH, path,
+                                            std::format("expected {}, found {}", expected, describe_node_type(node))}));
+        }
 
-            std::string full_path = path.empty() ? name : path + "." + name;
-            const toml::node* node = tbl->get(name_sv);
+        template <typename Field>
+        static void check_field(const toml::table& tbl, std::string& path, std::vector<ValidationIssue>& issues,
+                                const ValidationOptions& options) {
+            constexpr std::string_view name = Field::name();
+            using Type = std::remove_cvref_t<typename Field::Type>;
 
+            const toml::node* node = fourdst::config::detail::find_field_node<StructType>(tbl, name);
             if (!node) {
                 if constexpr (!is_optional_v<Type>) {
-                    missing.push_back(full_path);
+                    issues.push_back(located(tbl, {IssueKind::MISSING_FIELD, join(path, name), "missing required field"}));
                 }
-            } else {
-                if constexpr (is_reflectable_struct_v<Type>) {
-                    if (node->is_table()) {
-                        ConfigValidator<Type>::check(node->as_table(), full_path, missing);
-                    }
-                } else if constexpr (is_vector_v<Type>) {
-                    using ElementType = std::remove_cvref_t<typename Type::value_type>;
-                    if constexpr (is_reflectable_struct_v<ElementType>) {
-                        if (node->is_array()) {
-                            const auto& arr = *node->as_array();
-                            for (size_t i = 0; i < arr.size(); ++i) {
-                                if (arr.get(i)->is_table()) {
-                                    ConfigValidator<ElementType>::check(
-                                        arr.get(i)->as_table(),
-                                        std::format("{}[{}]", full_path, i),
-                                        missing
-                                    );
-                                }
-                            }
-                        }
+                return;
+            }
+
+            const std::size_t parent_length = path.size();
+            push_segment(path, name);
+            check_value<Type>(*node, path, issues, options);
+            path.resize(parent_length);
+        }
+
+        template <typename Type>
+        static void check_value(const toml::node& node, std::string& path, std::vector<ValidationIssue>& issues,
+                                const ValidationOptions& options) {
+            if constexpr (is_optional_v<Type> || is_lazy_v<Type> || is_tunable_v<Type>) {
+                check_value<std::remove_cvref_t<typename Type::value_type>>(node, path, issues, options);
+            } else if constexpr (is_rfl_validator_v<Type>) {
+                check_constraint<Type>(node, path, issues, options);
+            } else if constexpr (is_quantity_v<Type>) {
+                if (const auto* text = node.as_string()) {
+                    if (const auto value = Type::parse(text->get()); !value) {
+                        issues.push_back(located(node, {IssueKind::TYPE_MISMATCH, path, value.error()}));
                     }
-                } else if constexpr (is_optional_v<Type>) {
-                    using InnerType = std::remove_cvref_t<typename Type::value_type>;
-                    if constexpr (is_reflectable_struct_v<InnerType>) {
-                        if (node->is_table()) {
-                            ConfigValidator<InnerType>::check(node->as_table(), full_path, missing);
-                        }
+                } else if (!node.is_floating_point() && !node.is_integer()) {
+                    mismatch(node, path, std::format("float or string with a unit ({})", Type::accepted_units()), issues);
+                }
+            } else if constexpr (is_stored_v<Type>) {
+                using Parsed = typename Type::parsed_type;
+                std::optional<Parsed> value;
+                if constexpr (std::is_floating_point_v<Parsed>) {
+                    if (const auto* number = node.as_floating_point()) value = static_cast<Parsed>(number->get());
+                    if (const auto* integer = node.as_integer()) value = static_cast<Parsed>(integer->get());
+                } else if (const auto* integer = node.as_integer(); integer != nullptr && std::in_range<Parsed>(integer->get())) {
+                    value = static_cast<Parsed>(integer->get());
+                }
+                if (!value) {
+                    mismatch(node, path, std::format("{} number", Type::parsed_precision()), issues);
+                } else if (const auto narrowed = Type::narrow(*value); !narrowed) {
+                    issues.push_back(located(node, {IssueKind::TYPE_MISMATCH, path, narrowed.error()}));
+                }
+            } else if constexpr (std::is_same_v<Type, bool>) {
+                if (!node.is_boolean()) mismatch(node, path, "boolean", issues);
+            } else if constexpr (std::is_integral_v<Type>) {
+                if (!node.is_integer()) {
+                    mismatch(node, path, "integer", issues);
+                    return;
+                }
+                const std::int64_t value = node.as_integer()->get();
+                if (!std::in_range<Type>(value)) {
+                    issues.push_back(located(node, {IssueKind::TYPE_MISMATCH, path,
+                                                    std::format("value {} is out of range [{}, {}]", value,
+                                                                std::numeric_limits<Type>::min(), std::numeric_limits<Type>::max())}));
+                }
+            } else if constexpr (std::is_floating_point_v<Type>) {
+                if (!node.is_floating_point() && !node.is_integer()) mismatch(node, path, "float", issues);
+            } else if constexpr (is_string_like_v<Type>) {
+                if (!node.is_string()) mismatch(node, path, "string", issues);
+            } else if constexpr (is_section_v<Type>) {
+                if (!node.is_string()) mismatch(node, path, "string (path to a section file)", issues);
+            } else if constexpr (is_sharded_v<Type>) {
+                // A reference to a shard file is checked when the file is read.
+                if (const toml::table* shards = node.as_table(); shards == nullptr || !shards->contains(Type::reference_key)) {
+                    check_value<typename Type::map_type>(node, path, issues, options);
+                }
+            } else if constexpr (std::is_enum_v<Type>) {
+                if (!node.is_string()) {
+                    mismatch(node, path, "string", issues);
+                } else if (!io::enum_from_string<Type>(node.as_string()->get())) {
+                    issues.push_back(located(node, {IssueKind::TYPE_MISMATCH, path,
+                                                    std::format("unknown enumerator '{}'", node.as_string()->get())}));
+                }
+            } else if constexpr (is_std_array_v<Type>) {
+                if (!node.is_array()) {
+                    mismatch(node, path, "array", issues);
+                    return;
+                }
+                const auto& arr = *node.as_array();
+                constexpr std::size_t expected = std::tuple_size_v<Type>;
+                if (arr.size() != expected) {
+                    issues.push_back(located(node, {IssueKind::ARRAY_SIZE_MISMATCH, path,
+                                                    std::format("expected {} elements, found {}", expected, arr.size())}));
+                }
+                check_elements<typename Type::value_type>(arr, path, issues, options);
+            } else if constexpr (is_tensor_v<Type>) {
+                check_tensor<Type>(node, path, issues, options);
+            } else if constexpr (is_vector_v<Type> || is_soa_v<Type> || is_sink_v<Type>) {
+                if (!node.is_array()) {
+                    mismatch(node, path, "array", issues);
+                    return;
+                }
+                check_elements<typename Type::value_type>(*node.as_array(), path, issues, options);
+            } else if constexpr (is_map_v<Type>) {
+                if (!node.is_table()) {
+                    mismatch(node, path, "table", issues);
+                    return;
+                }
+                if constexpr (is_string_like_v<typename Type::key_type>) {
+                    const std::size_t parent_length = path.size();
+                    for (auto&& [key, member] : *node.as_table()) {
+                        push_segment(path, key.str());
+                        check_value<std::remove_cvref_t<typename Type::mapped_type>>(member, path, issues, options);
+                        path.resize(parent_length);
                     }
                 }
+            } else if constexpr (is_tagged_union_v<Type>) {
+                check_tagged_union<Type>(node, path, issues, options);
+            } else if constexpr (is_reflectable_struct_v<Type> && std::is_aggregate_v<Type>) {
+                if (!node.is_table()) {
+                    mismatch(node, path, "table", issues);
+                    return;
+                }
+                ConfigValidator<Type>::validate_into(*node.as_table(), path, issues, options);
+            }
+        }
+
+        /**
+         * @brief Checks a tagged-union table against the alternative its discriminator names.
+         *
+         * The tag is found by one hashed lookup; missing fields of the alternative name the tag,
+         * e.g. `missing required field for type = "Picard"`.
+         */
+        template <typename Type>
+        static void check_tagged_union(const toml::node& node, std::string& path, std::vector<ValidationIssue>& issues,
+                                       const ValidationOptions& options) {
+            using Index = fourdst::config::detail::TagIndex<Type>;
+            if (!node.is_table()) {
+                mismatch(node, path, "table", issues);
+                return;
+            }
+            const toml::table& tbl = *node.as_table();
+            const auto* tag = tbl.get_as<std::string>(Index::discriminator);
+            if (tag == nullptr) {
+                if (const toml::node* other = tbl.get(Index::discriminator)) {
+                    mismatch(*other, join(path, Index::discriminator), "string", issues);
+                } else {
+                    issues.push_back(located(tbl, {IssueKind::MISSING_FIELD, join(path, Index::discriminator),
+                                                   std::format("missing required field (one of {})", Index::allowed())}));
+                }
+                return;
+            }
+            const std::string_view value = tag->get();
+            const std::size_t alternative = Index::find(value);
+            if (alternative == Index::npos) {
+                issues.push_back(located(*tag, {IssueKind::TYPE_MISMATCH, join(path, Index::discriminator),
+                                                std::format("unknown {} '{}'; expected one of {}", Index::discriminator, value,
+                                                            Index::allowed())}));
+                return;
+            }
+            const std::size_t before = issues.size();
+            Index::dispatch(alternative, [&]<typename Alternative>(std::type_identity<Alternative>) {
+                ConfigValidator<Alternative>::validate_into(tbl, path, issues, options);
+            });
+            forgive_discriminator<Index>(path, issues, before);
+            for (std::size_t i = before; i < issues.size(); ++i) {
+                if (issues[i].kind == IssueKind::MISSING_FIELD) {
+                    issues[i].message += std::format(" for {} = \"{}\"", Index::discriminator, value);
+                }
+            }
+        }
+
+        /**
+         * @brief Checks the underlying value of an `rfl::Validator` field, then its constraint.
+         *
+         * The constraint is only evaluated for scalar values of the right type; a mismatch is
+         * reported as such instead.
+         */
+        template <typename Type>
+        static void check_constraint(const toml::node& node, std::string& path, std::vector<ValidationIssue>& issues,
+                                     const ValidationOptions& options) {
+            using Value = std::remove_cvref_t<typename Type::ReflectionType>;
+            const std::size_t before = issues.size();
+            check_value<Value>(node, path, issues, options);
+            if (issues.size() != before) return;
+
+            std::optional<Value> value;
+            if constexpr (std::is_integral_v<Value> && !std::is_same_v<Value, bool>) {
+                value = static_cast<Value>(node.as_integer()->get());
+            } else if constexpr (std::is_floating_point_v<Value>) {
+                value = static_cast<Value>(*node.value<double>());
+            } else if constexpr (is_std_string_v<Value>) {
+                value = Value(node.as_string()->get());
+            }
+            if (!value) return;
+
+            const auto result = Type::from_value(*value);
+            if (!result) {
+                issues.push_back(located(node, {IssueKind::CONSTRAINT_VIOLATION, path, result.error().what()}));
+            }
+        }
+
+        /// Checks nested arrays against the shape given by the first array at each depth.
+        template <typename Type>
+        static void check_tensor(const toml::node& node, std::string& path, std::vector<ValidationIssue>& issues,
+                                 const ValidationOptions& options) {
+            std::array<std::size_t, Type::rank> extents{};
+            const toml::node* probe = &node;
+            for (std::size_t d = 0; d < Type::rank && probe->is_array(); ++d) {
+                extents[d] = probe->as_array()->size();
+                if (probe->as_array()->empty()) break;
+                probe = probe->as_array()->get(0);
+            }
+            check_tensor_level<Type>(node, 0, extents, path, issues, options);
+        }
+
+        template <typename Type>
+        static void check_tensor_level(const toml::node& node, const std::size_t depth, const std::array<std::size_t, Type::rank>& extents,
+                                       std::string& path, std::vector<ValidationIssue>& issues, const ValidationOptions& options) {
+            if (!node.is_array()) {
+                mismatch(node, path, "array", issues);
+                return;
+            }
+            const auto& arr = *node.as_array();
+            if (arr.size() != extents[depth]) {
+                issues.push_back(located(node, {IssueKind::ARRAY_SIZE_MISMATCH, path,
+                                                std::format("expected {} elements, found {}", extents[depth], arr.size())}));
+                return;
+            }
+            if (depth + 1 == Type::rank) {
+                check_elements<typename Type::value_type>(arr, path, issues, options);
+                return;
+            }
+            const std::size_t parent_length = path.size();
+            for (std::size_t i = 0; i < arr.size(); ++i) {
+                push_index(path, i);
+                check_tensor_level<Type>(*arr.get(i), depth + 1, extents, path, issues, options);
+                path.resize(parent_length);
+            }
+        }
+
+        template <typename Element>
+        static void check_elements(const toml::array& arr, std::string& path, std::vector<ValidationIssue>& issues,
+                                   const ValidationOptions& options) {
+            using Type = std::remove_cvref_t<Element>;
+            if constexpr (is_reflectable_struct_v<Type> && std::is_aggregate_v<Type>) {
+                const unsigned threads = options.max_threads != 0 ? options.max_threads : std::thread::hardware_concurrency();
+                if (arr.size() >= options.parallel_threshold && threads > 1) {
+                    check_elements_parallel<Type>(arr, path, issues, std::min<std::size_t>(threads, arr.size()));
+                    return;
+                }
+            }
+            check_element_range<Type>(arr, 0, arr.size(), path, issues, options);
+        }
+
+        template <typename Type>
+        static void check_element_range(const toml::array& arr, const std::size_t begin, const std::size_t end, std::string& path,
+                                        std::vector<ValidationIssue>& issues, const ValidationOptions& options) {
+            const std::size_t field_length = path.size();
+            for (std::size_t i = begin; i < end; ++i) {
+                push_index(path, i);
+                check_value<Type>(*arr.get(i), path, issues, options);
+                path.resize(field_length);
+            }
+        }
+
+        /**
+         * @brief Validates contiguous chunks of `arr` as `workers` units of work on the default executor.
+         *
+         * Each worker owns its path buffer and issue list; the lists are appended in chunk order,
+         * so the result matches a serial pass. Arrays nested inside the elements are validated
+         * serially by the worker that owns them.
+         */
+        template <typename Type>
+        static void check_elements_parallel(const toml::array& arr, const std::string& path,
+                                            std::vector<ValidationIssue>& issues, const std::size_t workers) {
+            const ValidationOptions nested{std::numeric_limits<std::size_t>::max(), 1};
+            const std::size_t chunk = (arr.size() + workers - 1) / workers;
+            std::vector<std::vector<ValidationIssue>> partial(workers);
+            std::vector<std::exception_ptr> errors(workers);
+            bulk_execute(workers, [&](const std::size_t w) {
+                try {
+                    std::string local_path = path;
+                    const std::size_t begin = w * chunk;
+                    const std::size_t end = std::min(arr.size(), begin + chunk);
+                    check_element_range<Type>(arr, begin, end, local_path, partial[w], nested);
+                } catch (...) {
+                    errors[w] = std::current_exception();
+                }
+            });
+            for (std::size_t w = 0; w < workers; ++w) {
+                if (errors[w]) std::rethrow_exception(errors[w]);
+                issues.insert(issues.end(), std::make_move_iterator(partial[w].begin()), std::make_move_iterator(partial[w].end()));
             }
         }
     };
 
+    /**
+     * @brief Formats issues as one `path: message (file:line:column)` line each.
+     * @param issues The issues to format.
+     * @return The listing, or an empty string if there are no issues.
+     */
+    inline std::string summarize_issues(const std::vector<ValidationIssue>& issues) {
+        std::string output;
+        for (const auto& issue : issues) {
+            output += std::format("\n  {}: {}", issue.path, issue.message);
+            if (issue.line != 0) output += std::format(" ({}:{}:{})", issue.file, issue.line, issue.column);
+        }
+        return output;
+    }
+
     struct MissingFieldTree {
         std::map<std::string, MissingFieldTree> children;
         bool is_missing = false;
@@ -137,11 +876,12 @@ namespace fourdst::config::validate {
 
         MissingFieldTree root;
         for (const auto& path : missing) {
-            std::stringstream ss(path);
-            std::string part;
             MissingFieldTree* current = &root;
-            while (std::getline(ss, part, '.')) {
-                current = &current->children[part];
+            std::string_view rest = path;
+            while (!rest.empty()) {
+                const std::size_t dot = rest.find('.');
+                current = &current->children[std::string(rest.substr(0, dot))];
+                rest = dot == std::string_view::npos ? std::string_view{} : rest.substr(dot + 1);
             }
             current->is_missing = true;
         }
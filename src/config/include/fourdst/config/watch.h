@@ -0,0 +1,384 @@
+/**
+ * @file watch.h
+ * @brief Background file watching and automatic reloading for Config objects.
+ *
+ * This file defines `ConfigWatcher`, which watches the file a `Config<T>` was loaded from and calls
+ * `Config<T>::reload()` on a single background thread when it changes. Bursts of write events
+ * (editors, rsync, generators writing in chunks) are debounced into one reload. Writers that use
+ * `Config::save()` with `SavePolicy::ATOMIC` replace the file by rename, so the watcher never
+ * observes a partially written file.
+ *
+ * The watcher uses inotify on Linux and kqueue on macOS/BSD. On other platforms it falls back to
+ * polling the file's modification time once per debounce interval.
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "fourdst/config/base.h"
+#include "fourdst/config/exceptions/exceptions.h"
+
+#if defined(__linux__)
+#define FOURDST_CONFIG_WATCH_INOTIFY 1
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+#define FOURDST_CONFIG_WATCH_KQUEUE 1
+#include <fcntl.h>
+#include <sys/event.h>
+#include <sys/time.h>
+#include <unistd.h>
+#else
+#include <condition_variable>
+#endif
+
+namespace fourdst::config {
+
+    /**
+     * @brief Watches the source file of a `Config<T>` and reloads it when it changes.
+     *
+     * The watcher is opt-in and owns one background thread between `start()` and `stop()`. Each
+     * debounced change triggers `Config<T>::reload()`. A reload that fails (for example because a
+     * writer left the file half-written) leaves the config untouched; the error is passed to the
+     * error callback, and the next change is picked up normally.
+     *
+     * The watched `Config<T>` must outlive the watcher.
+     *
+     * @tparam T The configuration schema type.
+     *
+     * @par Examples
+     * @code
+     * fourdst::config::Config<AppConfig> cfg;
+     * cfg.load("run.toml");
+     *
+     * fourdst::config::ConfigWatcher watcher(cfg, std::chrono::milliseconds(200));
+     * watcher.on_reload([](bool changed) {
+     *     if (changed) std::cout << "config updated\n";
+     * });
+     * watcher.start();
+     * @endcode
+     */
+    template <IsConfigSchema T>
+    class ConfigWatcher {
+    public:
+        /**
+         * @brief Callback invoked after each reload with whether the content changed.
+         */
+        using ReloadCallback = std::function<void(bool changed)>;
+
+        /**
+         * @brief Callback invoked when a triggered reload throws; exceptions other than
+         *        `ConfigError`s arrive wrapped in a `ConfigLoadError`.
+         */
+        using ErrorCallback = std::function<void(const exceptions::ConfigError& error)>;
+
+        /**
+         * @brief Creates a watcher for an already loaded config.
+         *
+         * @param config The config to reload. Must have been loaded from a file.
+         * @param debounce Quiet period that must follow the last file event before reloading.
+         * @throws exceptions::ConfigLoadError If `config` has not been loaded from a file.
+         */
+        explicit ConfigWatcher(Config<T>& config, const std::chrono::milliseconds debounce = std::chrono::milliseconds(100))
+            : m_config(config), m_path(config.get_source_path()), m_debounce(debounce) {
+            if (m_path.empty()) {
+                throw exceptions::ConfigLoadError(
+                    "Cannot watch config: it has not been loaded from a file.");
+            }
+        }
+
+        ConfigWatcher(const ConfigWatcher&) = delete;
+        ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+        /**
+         * @brief Stops the background thread if it is running.
+         */
+        ~ConfigWatcher() { stop(); }
+
+        /**
+         * @brief Sets the callback run on the watcher thread after each reload.
+         * @param callback The callback.
+         */
+        void on_reload(ReloadCallback callback) {
+            std::lock_guard lock(m_callback_mutex);
+            m_on_reload = std::move(callback);
+        }
+
+        /**
+         * @brief Sets the callback run on the watcher thread when a reload fails.
+         * @param callback The callback.
+         */
+        void on_error(ErrorCallback callback) {
+            std::lock_guard lock(m_callback_mutex);
+            m_on_error = std::move(callback);
+        }
+
+        /**
+         * @brief Starts watching on a background thread. Does nothing if already running.
+         * @throws exceptions::ConfigLoadError If the platform watch facility cannot be set up.
+         */
+        void start() {
+            if (m_running.exchange(true)) return;
+            try {
+                open_watch();
+            } catch (...) {
+                m_running = false;
+                throw;
+            }
+            m_thread = std::thread([this] { run(); });
+        }
+
+        /**
+         * @brief Stops watching and joins the background thread. Does nothing if not running.
+         */
+        void stop() {
+            if (!m_running.exchange(false)) return;
+            wake();
+            if (m_thread.joinable()) {
+                m_thread.join();
+            }
+            close_watch();
+        }
+
+        /**
+         * @brief Returns whether the background thread is running.
+         */
+        [[nodiscard]] bool running() const noexcept { return m_running.load(); }
+
+        /**
+         * @brief Returns the path being watched.
+         */
+        [[nodiscard]] const std::string& path() const noexcept { return m_path; }
+
+    private:
+        void trigger_reload() {
+            try {
+                const bool changed = m_config.reload(m_path);
+                std::lock_guard lock(m_callback_mutex);
+                if (m_on_reload) m_on_reload(changed);
+            } catch (const exceptions::ConfigError& error) {
+                std::lock_guard lock(m_callback_mutex);
+                if (m_on_error) m_on_error(error);
+            } catch (const std::exception& error) {
+                // A validator or subscriber may throw anything; escaping the watcher thread would terminate.
+                const exceptions::ConfigLoadError wrapped(std::format("Reloading config {} failed: {}", m_path, error.what()));
+                std::lock_guard lock(m_callback_mutex);
+                if (m_on_error) m_on_error(wrapped);
+            }
+        }
+
+#if defined(FOURDST_CONFIG_WATCH_INOTIFY)
+        void open_watch() {
+            const std::filesystem::path file(m_path);
+            const std::filesystem::path dir = file.has_parent_path() ? file.parent_path() : std::filesystem::path(".");
+            m_file_name = file.filename().string();
+
+            m_inotify_fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (m_inotify_fd < 0) {
+                throw exceptions::ConfigLoadError("Unable to initialize inotify for config watching.");
+            }
+            // Watch the directory rather than the file so atomic replace-by-rename is seen too.
+            if (::inotify_add_watch(m_inotify_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MODIFY) < 0) {
+                close_watch();
+                throw exceptions::ConfigLoadError(
+                    std::format("Unable to watch config directory: {}", dir.string()));
+            }
+            if (::pipe2(m_wake_fds, O_NONBLOCK | O_CLOEXEC) != 0) {
+                close_watch();
+                throw exceptions::ConfigLoadError("Unable to create wake pipe for config watching.");
+            }
+        }
+
+        void close_watch() {
+            for (int* fd : {&m_inotify_fd, &m_wake_fds[0], &m_wake_fds[1]}) {
+                if (*fd >= 0) {
+                    ::close(*fd);
+                    *fd = -1;
+                }
+            }
+        }
+
+        void wake() {
+            if (m_wake_fds[1] >= 0) {
+                const char byte = 1;
+                [[maybe_unused]] const auto written = ::write(m_wake_fds[1], &byte, 1);
+            }
+        }
+
+        void run() {
+            using clock = std::chrono::steady_clock;
+            alignas(inotify_event) char buffer[4096];
+            // When to reload: a debounce interval after the last event for the watched file. Events
+            // for other files in the directory wake the poll but do not move it.
+            std::optional<clock::time_point> deadline;
+            while (m_running.load()) {
+                pollfd fds[2] = {{m_inotify_fd, POLLIN, 0}, {m_wake_fds[0], POLLIN, 0}};
+                int timeout = -1;
+                if (deadline) {
+                    const auto left = std::chrono::ceil<std::chrono::milliseconds>(*deadline - clock::now());
+                    timeout = static_cast<int>(std::max<std::chrono::milliseconds::rep>(left.count(), 0));
+                }
+                const int ready = ::poll(fds, 2, timeout);
+                if (!m_running.load()) break;
+                if (ready < 0) continue;
+
+                if (ready > 0 && (fds[0].revents & POLLIN)) {
+                    ssize_t len;
+                    while ((len = ::read(m_inotify_fd, buffer, sizeof(buffer))) > 0) {
+                        for (char* ptr = buffer; ptr < buffer + len;) {
+                            const auto* event = reinterpret_cast<const inotify_event*>(ptr);
+                            if (event->len > 0 && m_file_name == event->name) {
+                                deadline = clock::now() + m_debounce;
+                            }
+                            ptr += sizeof(inotify_event) + event->len;
+                        }
+                    }
+                }
+
+                if (deadline && clock::now() >= *deadline) {
+                    // Quiet for a full debounce interval after the last event for the file.
+                    deadline.reset();
+                    trigger_reload();
+                }
+            }
+        }
+
+        std::string m_file_name;
+        int m_inotify_fd = -1;
+        int m_wake_fds[2] = {-1, -1};
+#elif defined(FOURDST_CONFIG_WATCH_KQUEUE)
+        void open_watch() {
+            m_kqueue_fd = ::kqueue();
+            if (m_kqueue_fd < 0) {
+                throw exceptions::ConfigLoadError("Unable to create kqueue for config watching.");
+            }
+            struct kevent wake_event;
+            EV_SET(&wake_event, 1, EVFILT_USER, EV_ADD | EV_CLEAR, 0, 0, nullptr);
+            ::kevent(m_kqueue_fd, &wake_event, 1, nullptr, 0, nullptr);
+            watch_file();
+        }
+
+        bool watch_file() {
+            if (m_file_fd >= 0) {
+                ::close(m_file_fd);
+            }
+#ifdef O_EVTONLY
+            m_file_fd = ::open(m_path.c_str(), O_EVTONLY);
+#else
+            m_file_fd = ::open(m_path.c_str(), O_RDONLY);
+#endif
+            if (m_file_fd < 0) return false;
+            struct kevent file_event;
+            EV_SET(&file_event, m_file_fd, EVFILT_VNODE, EV_ADD | EV_CLEAR,
+                   NOTE_WRITE | NOTE_EXTEND | NOTE_DELETE | NOTE_RENAME | NOTE_ATTRIB, 0, nullptr);
+            return ::kevent(m_kqueue_fd, &file_event, 1, nullptr, 0, nullptr) == 0;
+        }
+
+        void close_watch() {
+            for (int* fd : {&m_file_fd, &m_kqueue_fd}) {
+                if (*fd >= 0) {
+                    ::close(*fd);
+                    *fd = -1;
+                }
+            }
+        }
+
+        void wake() {
+            if (m_kqueue_fd >= 0) {
+                struct kevent wake_event;
+                EV_SET(&wake_event, 1, EVFILT_USER, 0, NOTE_TRIGGER, 0, nullptr);
+                ::kevent(m_kqueue_fd, &wake_event, 1, nullptr, 0, nullptr);
+            }
+        }
+
+        void run() {
+            bool pending = false;
+            bool replaced = false;
+            while (m_running.load()) {
+                struct kevent event;
+                timespec timeout{};
+                timeout.tv_sec = static_cast<time_t>(m_debounce.count() / 1000);
+                timeout.tv_nsec = static_cast<long>((m_debounce.count() % 1000) * 1000000);
+                const int ready = ::kevent(m_kqueue_fd, nullptr, 0, &event, 1, (pending || replaced) ? &timeout : nullptr);
+                if (!m_running.load()) break;
+                if (ready < 0) continue;
+
+                if (ready == 0) {
+                    // The file was replaced (rename or delete + create); re-arm on the new inode.
+                    if (replaced && watch_file()) {
+                        replaced = false;
+                        pending = true;
+                    }
+                    if (pending && !replaced) {
+                        pending = false;
+                        trigger_reload();
+                    }
+                    continue;
+                }
+
+                if (event.filter == EVFILT_VNODE) {
+                    if (event.fflags & (NOTE_DELETE | NOTE_RENAME)) {
+                        replaced = true;
+                    } else {
+                        pending = true;
+                    }
+                }
+            }
+        }
+
+        int m_kqueue_fd = -1;
+        int m_file_fd = -1;
+#else
+        void open_watch() {
+            std::error_code ec;
+            m_last_write = std::filesystem::last_write_time(m_path, ec);
+        }
+
+        void close_watch() {}
+
+        void wake() {
+            m_wake_cv.notify_all();
+        }
+
+        void run() {
+            std::unique_lock lock(m_wake_mutex);
+            while (m_running.load()) {
+                m_wake_cv.wait_for(lock, m_debounce, [this] { return !m_running.load(); });
+                if (!m_running.load()) break;
+                std::error_code ec;
+                const auto current = std::filesystem::last_write_time(m_path, ec);
+                if (!ec && current != m_last_write) {
+                    m_last_write = current;
+                    trigger_reload();
+                }
+            }
+        }
+
+        std::filesystem::file_time_type m_last_write{};
+        std::mutex m_wake_mutex;
+        std::condition_variable m_wake_cv;
+#endif
+
+        Config<T>& m_config;
+        std::string m_path;
+        std::chrono::milliseconds m_debounce;
+        std::atomic<bool> m_running{false};
+        std::thread m_thread;
+        std::mutex m_callback_mutex;
+        ReloadCallback m_on_reload;
+        ErrorCallback m_on_error;
+    };
+}
@@ -0,0 +1,588 @@
+/**
+ * @file watch_service.h
+ * @brief One watcher thread for any number of config files.
+ *
+ * `ConfigWatcher` owns a thread and a watch descriptor per config, which does not scale to an
+ * ensemble monitor following thousands of member decks. `WatchService` multiplexes every
+ * registered config onto a single inotify (Linux) or kqueue (macOS/BSD) descriptor, with an
+ * index from watched file to the configs loaded from it, on one background thread. On other
+ * platforms it polls the modification times of all files on that thread.
+ *
+ * Events are read in batches and each config is debounced on its own terms (`WatchOptions`):
+ * a reload is due once the file has been quiet for `debounce`, or at the latest `max_delay`
+ * after the first event of a burst. Due reloads are handed to the executor (the one given to
+ * the constructor, else the default executor of executor.h), so a burst touching many files
+ * reloads them in parallel; without an executor they run one after the other on the service
+ * thread. A config is never reloaded twice at the same time: events arriving during its reload
+ * schedule one more.
+ *
+ * @code
+ * fourdst::config::WatchService service;
+ * for (auto& member : ensemble) {
+ *     service.watch(member, {.debounce = std::chrono::milliseconds(250)});
+ * }
+ * service.start();
+ * @endcode
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "fourdst/config/base.h"
+#include "fourdst/config/exceptions/exceptions.h"
+#include "fourdst/config/executor.h"
+#include "fourdst/config/watch.h"
+
+namespace fourdst::config {
+
+    /**
+     * @brief How `WatchService` debounces and reports the reloads of one config.
+     */
+    struct WatchOptions {
+        /// Quiet period that must follow the last file event before reloading.
+        std::chrono::milliseconds debounce{100};
+        /// Upper bound on the wait after the first event of a burst, for files written continuously; 0 for none.
+        std::chrono::milliseconds max_delay{0};
+        /// Called after each reload with whether the content changed.
+        std::function<void(bool changed)> on_reload;
+        /// Called when a reload throws; the config is left untouched. Exceptions other than `ConfigError`s arrive wrapped in a `ConfigLoadError`.
+        std::function<void(const exceptions::ConfigError& error)> on_error;
+    };
+
+    /**
+     * @brief Watches the source files of many configs on one thread and reloads each when its file changes.
+     *
+     * All member functions are thread-safe. A watched config must stay alive until it is
+     * unwatched or the service is stopped.
+     */
+    class WatchService {
+    public:
+        /// Identifies one registration, for `unwatch()`.
+        using WatchId = std::uint64_t;
+
+        /**
+         * @brief Creates a stopped service whose reloads run on the default executor, or on its own thread without one.
+         */
+        WatchService() : WatchService(default_executor()) {}
+
+        /**
+         * @brief Creates a stopped service whose reloads run on `executor`; an empty one runs them on the service thread.
+         */
+        explicit WatchService(AnyExecutor executor) : m_executor(std::move(executor)) {}
+
+        WatchService(const WatchService&) = delete;
+        WatchService& operator=(const WatchService&) = delete;
+
+        /**
+         * @brief Stops the service, waiting for reloads in progress.
+         */
+        ~WatchService() {
+            stop();
+            close_watch();
+        }
+
+        /**
+         * @brief Starts reloading `config` when the file it was loaded from changes.
+         *
+         * @param config The config to reload. Must have been loaded from a file.
+         * @param options Debounce policy and callbacks, which run on the thread doing the reload.
+         * @return The registration, for `unwatch()`.
+         * @throws exceptions::ConfigLoadError If `config` has not been loaded from a file or its file cannot be watched.
+         */
+        template <IsConfigSchema T>
+        WatchId watch(Config<T>& config, WatchOptions options = {}) {
+            std::string path = config.get_source_path();
+            if (path.empty()) {
+                throw exceptions::ConfigLoadError("Cannot watch config: it has not been loaded from a file.");
+            }
+            return add(path, [&config, path] { return config.reload(path); }, std::move(options));
+        }
+
+        /**
+         * @brief Stops watching a registration, waiting for a reload of it in progress.
+         *
+         * Must not be called from a callback of the same registration.
+         *
+         * @return True if the registration existed.
+         */
+        bool unwatch(const WatchId id) {
+            std::shared_ptr<Entry> entry;
+            {
+                const std::lock_guard lock(m_mutex);
+                const auto found = m_entries.find(id);
+                if (found == m_entries.end()) return false;
+                entry = std::move(found->second);
+                m_entries.erase(found);
+                std::erase(m_pending, entry);
+                File& file = *entry->file;
+                std::erase(file.entries, entry);
+                if (file.entries.empty()) {
+                    remove_file(file);
+                    const std::string path = file.path;
+                    m_files.erase(path);
+                }
+            }
+            const std::lock_guard reload_lock(entry->reload_mutex);
+            entry->removed = true;
+            return true;
+        }
+
+        /// Number of registrations.
+        [[nodiscard]] std::size_t size() const {
+            const std::lock_guard lock(m_mutex);
+            return m_entries.size();
+        }
+
+        /**
+         * @brief Starts the service thread. Does nothing if already running.
+         * @throws exceptions::ConfigLoadError If the platform watch facility cannot be set up.
+         */
+        void start() {
+            if (m_running.exchange(true)) return;
+            try {
+                const std::lock_guard lock(m_mutex);
+                open_watch();
+            } catch (...) {
+                m_running = false;
+                throw;
+            }
+            m_thread = std::thread([this] { run(); });
+        }
+
+        /**
+         * @brief Stops the service thread and waits for the reloads it dispatched. Does nothing if not running.
+         */
+        void stop() {
+            if (!m_running.exchange(false)) return;
+            wake();
+            if (m_thread.joinable()) m_thread.join();
+            std::unique_lock lock(m_mutex);
+            m_idle.wait(lock, [this] { return m_in_flight == 0; });
+        }
+
+        /// True while the service thread runs.
+        [[nodiscard]] bool running() const noexcept { return m_running.load(); }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct File;
+
+        /**
+         * @brief One watched config. The scheduling fields are guarded by the service mutex.
+         */
+        struct Entry {
+            WatchId id = 0;
+            File* file = nullptr;
+            WatchOptions options;
+            std::function<bool()> reload;
+            /// Held while reloading; `removed` is set under it once the entry is unwatched.
+            std::mutex reload_mutex;
+            bool removed = false;
+            bool pending = false;
+            bool in_flight = false;
+            Clock::time_point first_event{};
+            Clock::time_point due{};
+        };
+
+        /**
+         * @brief One watched file and the configs loaded from it.
+         */
+        struct File {
+            std::string path;
+            std::vector<std::shared_ptr<Entry>> entries;
+#if defined(FOURDST_CONFIG_WATCH_INOTIFY)
+            /// The watch descriptor of the directory holding the file.
+            int wd = -1;
+            std::string name;
+#elif defined(FOURDST_CONFIG_WATCH_KQUEUE)
+            /// Open for `EVFILT_VNODE`; -1 while the file is replaced and not yet re-armed.
+            int fd = -1;
+#else
+            std::filesystem::file_time_type last_write{};
+#endif
+        };
+
+        WatchId add(const std::string& path, std::function<bool()> reload, WatchOptions options) {
+            auto entry = std::make_shared<Entry>();
+            entry->options = std::move(options);
+            entry->reload = std::move(reload);
+            const std::lock_guard lock(m_mutex);
+            open_watch();
+            auto& slot = m_files[path];
+            if (!slot) {
+                auto file = std::make_unique<File>();
+                file->path = path;
+                add_file(*file);
+                slot = std::move(file);
+            }
+            entry->id = ++m_last_id;
+            entry->file = slot.get();
+            slot->entries.push_back(entry);
+            m_entries.emplace(entry->id, entry);
+            return entry->id;
+        }
+
+        /**
+         * @brief Marks the entries of `file` pending, pushing their deadlines back. Requires the mutex.
+         */
+        void touch(const File& file, const Clock::time_point now) {
+            for (const auto& entry : file.entries) {
+                if (!entry->pending) {
+                    entry->pending = true;
+                    entry->first_event = now;
+                    m_pending.push_back(entry);
+                }
+                entry->due = now + entry->options.debounce;
+                if (entry->options.max_delay.count() > 0) {
+                    entry->due = std::min(entry->due, entry->first_event + entry->options.max_delay);
+                }
+            }
+        }
+
+        /**
+         * @brief Returns the pending entries that are due and not reloading, removing them from the pending list.
+         */
+        std::vector<std::shared_ptr<Entry>> take_due(const Clock::time_point now) {
+            std::vector<std::shared_ptr<Entry>> due;
+            const std::lock_guard lock(m_mutex);
+            std::erase_if(m_pending, [&](const std::shared_ptr<Entry>& entry) {
+                if (entry->due > now) return false;
+                if (entry->in_flight) {
+                    // Reloaded again once the reload in progress has finished.
+                    entry->due = now + entry->options.debounce;
+                    return false;
+                }
+                entry->pending = false;
+                entry->in_flight = true;
+                ++m_in_flight;
+                due.push_back(entry);
+                return true;
+            });
+            return due;
+        }
+
+        /**
+         * @brief Milliseconds until the earliest pending deadline, or -1 if nothing is pending.
+         */
+        int next_timeout(const Clock::time_point now) const {
+            const std::lock_guard lock(m_mutex);
+            if (m_pending.empty()) return -1;
+            Clock::time_point earliest = Clock::time_point::max();
+            for (const auto& entry : m_pending) earliest = std::min(earliest, entry->due);
+            if (earliest <= now) return 0;
+            return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(earliest - now).count());
+        }
+
+        void reload(const std::shared_ptr<Entry>& entry) {
+            {
+                const std::lock_guard reload_lock(entry->reload_mutex);
+                if (!entry->removed) {
+                    try {
+                        const bool changed = entry->reload();
+                        if (entry->options.on_reload) entry->options.on_reload(changed);
+                    } catch (const exceptions::ConfigError& error) {
+                        if (entry->options.on_error) entry->options.on_error(error);
+                    } catch (const std::exception& error) {
+                        // Must not escape: it would end the service thread and leave m_in_flight raised.
+                        if (entry->options.on_error) {
+                            entry->options.on_error(exceptions::ConfigLoadError(std::format("Reloading a watched config failed: {}", error.what())));
+                        }
+                    }
+                }
+            }
+            const std::lock_guard lock(m_mutex);
+            entry->in_flight = false;
+            if (--m_in_flight == 0) m_idle.notify_all();
+        }
+
+        void dispatch(const std::vector<std::shared_ptr<Entry>>& due) {
+            for (const auto& entry : due) {
+                if (m_executor) {
+                    m_executor([this, entry] { reload(entry); });
+                } else {
+                    reload(entry);
+                }
+            }
+        }
+
+        void run() {
+            while (m_running.load()) {
+                wait_events(next_timeout(Clock::now()));
+                if (!m_running.load()) break;
+                dispatch(take_due(Clock::now()));
+            }
+        }
+
+#if defined(FOURDST_CONFIG_WATCH_INOTIFY)
+        /// Requires the mutex.
+        void open_watch() {
+            if (m_inotify_fd >= 0) return;
+            m_inotify_fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (m_inotify_fd < 0) {
+                throw exceptions::ConfigLoadError("Unable to initialize inotify for config watching.");
+            }
+            if (::pipe2(m_wake_fds, O_NONBLOCK | O_CLOEXEC) != 0) {
+                close_watch();
+                throw exceptions::ConfigLoadError("Unable to create wake pipe for config watching.");
+            }
+        }
+
+        void close_watch() {
+            for (int* fd : {&m_inotify_fd, &m_wake_fds[0], &m_wake_fds[1]}) {
+                if (*fd >= 0) {
+                    ::close(*fd);
+                    *fd = -1;
+                }
+            }
+        }
+
+        void wake() {
+            if (m_wake_fds[1] >= 0) {
+                const char byte = 1;
+                [[maybe_unused]] const auto written = ::write(m_wake_fds[1], &byte, 1);
+            }
+        }
+
+        /// Requires the mutex.
+        void add_file(File& file) {
+            const std::filesystem::path path(file.path);
+            const std::filesystem::path dir = path.has_parent_path() ? path.parent_path() : std::filesystem::path(".");
+            // Watch the directory rather than the file so atomic replace-by-rename is seen too.
+            // Every file of one directory shares its watch descriptor.
+            const int wd = ::inotify_add_watch(m_inotify_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MODIFY);
+            if (wd < 0) {
+                throw exceptions::ConfigLoadError(std::format("Unable to watch config directory: {}", dir.string()));
+            }
+            file.wd = wd;
+            file.name = path.filename().string();
+            m_directories[wd].emplace(file.name, &file);
+        }
+
+        /// Requires the mutex.
+        void remove_file(const File& file) {
+            const auto directory = m_directories.find(file.wd);
+            if (directory == m_directories.end()) return;
+            directory->second.erase(file.name);
+            if (directory->second.empty()) {
+                ::inotify_rm_watch(m_inotify_fd, file.wd);
+                m_directories.erase(directory);
+            }
+        }
+
+        void wait_events(const int timeout) {
+            pollfd fds[2] = {{m_inotify_fd, POLLIN, 0}, {m_wake_fds[0], POLLIN, 0}};
+            const int ready = ::poll(fds, 2, timeout);
+            if (ready <= 0) return;
+            if (fds[1].revents & POLLIN) {
+                char drain[64];
+                while (::read(m_wake_fds[0], drain, sizeof(drain)) > 0) {
+                }
+            }
+            if (!(fds[0].revents & POLLIN)) return;
+            const auto now = Clock::now();
+            ssize_t len;
+            while ((len = ::read(m_inotify_fd, m_buffer.data(), m_buffer.size())) > 0) {
+                const std::lock_guard lock(m_mutex);
+                for (char* ptr = m_buffer.data(); ptr < m_buffer.data() + len;) {
+                    const auto* event = reinterpret_cast<const inotify_event*>(ptr);
+                    ptr += sizeof(inotify_event) + event->len;
+                    if (event->mask & IN_Q_OVERFLOW) {
+                        // Events were dropped: treat every file as changed.
+                        for (const auto& [path, file] : m_files) touch(*file, now);
+                        continue;
+                    }
+                    if (event->len == 0) continue;
+                    const auto directory = m_directories.find(event->wd);
+                    if (directory == m_directories.end()) continue;
+                    const auto file = directory->second.find(event->name);
+                    if (file != directory->second.end()) touch(*file->second, now);
+                }
+            }
+        }
+
+        int m_inotify_fd = -1;
+        int m_wake_fds[2] = {-1, -1};
+        /// Watched files by directory watch descriptor and file name.
+        std::unordered_map<int, std::unordered_map<std::string, File*>> m_directories;
+        struct alignas(inotify_event) EventBuffer {
+            char bytes[64 * 1024];
+            char* data() { return bytes; }
+            static constexpr std::size_t size() { return sizeof(bytes); }
+        } m_buffer;
+#elif defined(FOURDST_CONFIG_WATCH_KQUEUE)
+        /// Requires the mutex.
+        void open_watch() {
+            if (m_kqueue_fd >= 0) return;
+            m_kqueue_fd = ::kqueue();
+            if (m_kqueue_fd < 0) {
+                throw exceptions::ConfigLoadError("Unable to create kqueue for config watching.");
+            }
+            struct kevent wake_event;
+            EV_SET(&wake_event, 0, EVFILT_USER, EV_ADD | EV_CLEAR, 0, 0, nullptr);
+            ::kevent(m_kqueue_fd, &wake_event, 1, nullptr, 0, nullptr);
+        }
+
+        void close_watch() {
+            for (const auto& [path, file] : m_files) remove_file(*file);
+            if (m_kqueue_fd >= 0) {
+                ::close(m_kqueue_fd);
+                m_kqueue_fd = -1;
+            }
+        }
+
+        void wake() {
+            if (m_kqueue_fd >= 0) {
+                struct kevent wake_event;
+                EV_SET(&wake_event, 0, EVFILT_USER, 0, NOTE_TRIGGER, 0, nullptr);
+                ::kevent(m_kqueue_fd, &wake_event, 1, nullptr, 0, nullptr);
+            }
+        }
+
+        /// Opens and registers the current inode of `file`; false if it does not exist right now. Requires the mutex.
+        bool arm(File& file) {
+#ifdef O_EVTONLY
+            file.fd = ::open(file.path.c_str(), O_EVTONLY);
+#else
+            file.fd = ::open(file.path.c_str(), O_RDONLY);
+#endif
+            if (file.fd < 0) return false;
+            struct kevent file_event;
+            EV_SET(&file_event, file.fd, EVFILT_VNODE, EV_ADD | EV_CLEAR, NOTE_WRITE | NOTE_EXTEND | NOTE_DELETE | NOTE_RENAME | NOTE_ATTRIB,
+                   0, nullptr);
+            if (::kevent(m_kqueue_fd, &file_event, 1, nullptr, 0, nullptr) != 0) {
+                ::close(file.fd);
+                file.fd = -1;
+                return false;
+            }
+            m_by_fd[file.fd] = &file;
+            return true;
+        }
+
+        /// Requires the mutex.
+        void add_file(File& file) {
+            if (!arm(file)) {
+                throw exceptions::ConfigLoadError(std::format("Unable to watch config file: {}", file.path));
+            }
+        }
+
+        /// Requires the mutex. Closing the descriptor removes its event.
+        void remove_file(File& file) {
+            std::erase(m_replaced, &file);
+            if (file.fd >= 0) {
+                m_by_fd.erase(file.fd);
+                ::close(file.fd);
+            }
+            file.fd = -1;
+        }
+
+        void wait_events(int timeout) {
+            {
+                // Re-arm files replaced by rename or delete + create on their new inode.
+                const std::lock_guard lock(m_mutex);
+                const auto now = Clock::now();
+                std::erase_if(m_replaced, [&](File* file) {
+                    if (!arm(*file)) return false;
+                    touch(*file, now);
+                    return true;
+                });
+                if (!m_replaced.empty() && (timeout < 0 || timeout > replaced_retry_ms)) timeout = replaced_retry_ms;
+            }
+            timespec wait{};
+            wait.tv_sec = timeout / 1000;
+            wait.tv_nsec = static_cast<long>(timeout % 1000) * 1000000;
+            struct kevent events[256];
+            const int ready = ::kevent(m_kqueue_fd, nullptr, 0, events, 256, timeout < 0 ? nullptr : &wait);
+            if (ready <= 0) return;
+            const auto now = Clock::now();
+            const std::lock_guard lock(m_mutex);
+            for (int i = 0; i < ready; ++i) {
+                if (events[i].filter != EVFILT_VNODE) continue;
+                // Looked up by descriptor: a file unwatched since the wait started is no longer indexed.
+                const auto found = m_by_fd.find(static_cast<int>(events[i].ident));
+                if (found == m_by_fd.end()) continue;
+                File* file = found->second;
+                touch(*file, now);
+                if (events[i].fflags & (NOTE_DELETE | NOTE_RENAME)) {
+                    m_by_fd.erase(found);
+                    ::close(file->fd);
+                    file->fd = -1;
+                    m_replaced.push_back(file);
+                }
+            }
+        }
+
+        /// How often files being replaced are retried, in milliseconds.
+        static constexpr int replaced_retry_ms = 50;
+        int m_kqueue_fd = -1;
+        /// Watched files by open descriptor.
+        std::unordered_map<int, File*> m_by_fd;
+        std::vector<File*> m_replaced;
+#else
+        void open_watch() {}
+        void close_watch() {}
+
+        void wake() {
+            const std::lock_guard lock(m_mutex);
+            m_wake.notify_all();
+        }
+
+        /// Requires the mutex.
+        void add_file(File& file) {
+            std::error_code ec;
+            file.last_write = std::filesystem::last_write_time(file.path, ec);
+        }
+
+        void remove_file(File&) {}
+
+        void wait_events(int timeout) {
+            // Files are polled at the shortest debounce of any registration.
+            std::unique_lock lock(m_mutex);
+            std::chrono::milliseconds interval{100};
+            for (const auto& [id, entry] : m_entries) interval = std::min(interval, entry->options.debounce);
+            if (timeout < 0 || timeout > interval.count()) timeout = static_cast<int>(interval.count());
+            m_wake.wait_for(lock, std::chrono::milliseconds(timeout), [this] { return !m_running.load(); });
+            const auto now = Clock::now();
+            for (const auto& [path, file] : m_files) {
+                std::error_code ec;
+                const auto current = std::filesystem::last_write_time(file->path, ec);
+                if (!ec && current != file->last_write) {
+                    file->last_write = current;
+                    touch(*file, now);
+                }
+            }
+        }
+
+        std::condition_variable m_wake;
+#endif
+
+        AnyExecutor m_executor;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_idle;
+        /// Watched files by path; owns the `File` records the platform index points into.
+        std::unordered_map<std::string, std::unique_ptr<File>> m_files;
+        std::unordered_map<WatchId, std::shared_ptr<Entry>> m_entries;
+        /// Entries with a reload scheduled.
+        std::vector<std::shared_ptr<Entry>> m_pending;
+        std::size_t m_in_flight = 0;
+        WatchId m_last_id = 0;
+        std::atomic<bool> m_running{false};
+        std::thread m_thread;
+    };
+}
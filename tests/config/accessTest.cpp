@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifndef FOURDST_CONFIG_USE_ACCESS_COUNTERS
+#define FOURDST_CONFIG_USE_ACCESS_COUNTERS 1
+#endif
+#include "fourdst/config/config.h"
+#include "test_schema.h"
+
+/**
+ * @file accessTest.cpp
+ * @brief Tests for the per-field read counters of builds with FOURDST_CONFIG_USE_ACCESS_COUNTERS.
+ */
+
+class accessTest : public ::testing::Test {};
+
+TEST_F(accessTest, reads_through_get_are_counted_per_field) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    EXPECT_EQ(cfg.get_access_count("simulation.time_step"), 0u);
+
+    (void)cfg.get<double>("simulation.time_step");
+    (void)cfg.get<double>("simulation.time_step");
+    (void)cfg.get<OutputConfigOptions>("output");
+    EXPECT_EQ(cfg.get_access_count("simulation.time_step"), 2u);
+    EXPECT_EQ(cfg.get_access_count("simulation"), 0u);
+    EXPECT_EQ(cfg.get_access_count("output"), 1u);
+    EXPECT_EQ(cfg.get_access_count("output.format"), 1u);
+    EXPECT_THROW((void)cfg.get_access_count("simulation.nope"), exceptions::ConfigPathError);
+
+    const std::vector<std::string_view> unread = cfg.get_unread_fields();
+    EXPECT_EQ(std::ranges::count(unread, "simulation.time_step"), 0);
+    EXPECT_EQ(std::ranges::count(unread, "output.directory"), 0);
+    EXPECT_EQ(std::ranges::count(unread, "simulation.total_time"), 1);
+    EXPECT_EQ(std::ranges::count(unread, "description"), 1);
+    EXPECT_EQ(std::ranges::count(unread, "simulation"), 0);
+
+    cfg.reset_access_counts();
+    EXPECT_EQ(cfg.get_access_count("simulation.time_step"), 0u);
+}
+
+TEST_F(accessTest, concurrent_reads_are_all_counted) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&cfg] {
+            for (int i = 0; i < 1000; ++i) (void)cfg.get<int>("simulation.output_frequency");
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(cfg.get_access_count("simulation.output_frequency"), 4000u);
+}
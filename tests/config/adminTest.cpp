@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <string>
+
+#ifndef FOURDST_CONFIG_USE_ADMIN_ENDPOINT
+#define FOURDST_CONFIG_USE_ADMIN_ENDPOINT 1
+#endif
+#include "fourdst/config/config.h"
+#include "test_schema.h"
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @file adminTest.cpp
+ * @brief Tests for the embedded admin endpoint of builds with FOURDST_CONFIG_USE_ADMIN_ENDPOINT.
+ */
+
+namespace {
+    /// Sends `request` to the loopback `port` and returns the whole response.
+    std::string exchange(const std::uint16_t port, const std::string& request) {
+        const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(port);
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            ::close(fd);
+            return {};
+        }
+        ::send(fd, request.data(), request.size(), 0);
+        std::string response;
+        char buffer[4096];
+        for (ssize_t received; (received = ::recv(fd, buffer, sizeof(buffer), 0)) > 0;) response.append(buffer, static_cast<std::size_t>(received));
+        ::close(fd);
+        return response;
+    }
+
+    std::string patch_request(const std::string& body, const std::string& token) {
+        return std::format("PATCH /config HTTP/1.1\r\nAuthorization: Bearer {}\r\nContent-Length: {}\r\n\r\n{}", token, body.size(), body);
+    }
+}
+
+class adminTest : public ::testing::Test {};
+
+TEST_F(adminTest, serves_snapshots_and_applies_patches) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    cfg.mutate([](TestConfigSchema& c) { c.simulation.time_step = 0.5; });
+    AdminEndpoint<TestConfigSchema> admin(cfg, {.token = "secret"});
+    ASSERT_NE(admin.port(), 0);
+
+    const std::string get = "GET /config HTTP/1.1\r\nAuthorization: Bearer secret\r\n\r\n";
+    std::string response = exchange(admin.port(), get);
+    EXPECT_TRUE(response.starts_with("HTTP/1.1 200 OK\r\n"));
+    EXPECT_NE(response.find(std::format("ETag: \"{}\"", cfg.generation())), std::string::npos);
+    EXPECT_NE(response.find("\"time_step\":0.5"), std::string::npos);
+
+    response = exchange(admin.port(), patch_request("simulation.time_step = 0.25", "secret"));
+    EXPECT_TRUE(response.starts_with("HTTP/1.1 204 No Content\r\n"));
+    EXPECT_EQ(cfg->simulation.time_step, 0.25);
+    EXPECT_NE(exchange(admin.port(), get).find("\"time_step\":0.25"), std::string::npos);
+
+    // Rejected patches leave the config untouched.
+    EXPECT_TRUE(exchange(admin.port(), patch_request("simulation.nope = 1", "secret")).starts_with("HTTP/1.1 400 "));
+    EXPECT_TRUE(exchange(admin.port(), patch_request("simulation.time_step = 2.0", "wrong")).starts_with("HTTP/1.1 401 "));
+    EXPECT_TRUE(exchange(admin.port(), "GET /other HTTP/1.1\r\nAuthorization: Bearer secret\r\n\r\n").starts_with("HTTP/1.1 404 "));
+    EXPECT_EQ(cfg->simulation.time_step, 0.25);
+    EXPECT_EQ(admin.requests(), 6u);
+}
+
+TEST_F(adminTest, other_failures_get_500_and_the_endpoint_keeps_serving) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    cfg.subscribe("simulation", [](const auto&) { throw std::runtime_error("subscriber failed"); });
+    AdminEndpoint<TestConfigSchema> admin(cfg, {.token = "secret"});
+
+    const std::string response = exchange(admin.port(), patch_request("simulation.time_step = 0.25", "secret"));
+    EXPECT_TRUE(response.starts_with("HTTP/1.1 500 Internal Server Error\r\n"));
+    EXPECT_NE(response.find("subscriber failed"), std::string::npos);
+    EXPECT_TRUE(exchange(admin.port(), "GET /config HTTP/1.1\r\nAuthorization: Bearer secret\r\n\r\n").starts_with("HTTP/1.1 200 "));
+    // A token that is a prefix of the right one, or longer than it, is still wrong.
+    EXPECT_TRUE(exchange(admin.port(), patch_request("simulation.time_step = 2.0", "secre")).starts_with("HTTP/1.1 401 "));
+    EXPECT_TRUE(exchange(admin.port(), patch_request("simulation.time_step = 2.0", "secrets")).starts_with("HTTP/1.1 401 "));
+}
+
+TEST_F(adminTest, tcp_needs_a_token_and_unix_sockets_are_private) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    EXPECT_THROW(AdminEndpoint<TestConfigSchema>(cfg, {}), exceptions::ConfigError);
+
+    const std::string path = std::format("/tmp/fourdst-admin-test-{}.sock", ::getpid());
+    {
+        AdminEndpoint<TestConfigSchema> admin(cfg, {.unix_socket = path});
+        EXPECT_EQ(admin.port(), 0);
+        struct stat status{};
+        ASSERT_EQ(::stat(path.c_str(), &status), 0);
+        EXPECT_EQ(status.st_mode & 0777, 0600u);
+    }
+    struct stat status{};
+    EXPECT_NE(::stat(path.c_str(), &status), 0);
+}
+
+struct AdminTunableSchema {
+    fourdst::config::Tunable<double> relaxation = 0.8;
+};
+
+TEST_F(adminTest, stores_into_tunables_change_the_served_version) {
+    using namespace fourdst::config;
+    Config<AdminTunableSchema> cfg;
+    AdminEndpoint<AdminTunableSchema> admin(cfg, {.token = "secret"});
+
+    const std::string get = "GET /config HTTP/1.1\r\nAuthorization: Bearer secret\r\n\r\n";
+    std::string response = exchange(admin.port(), get);
+    EXPECT_NE(response.find(std::format("ETag: \"{}\"", cfg.generation())), std::string::npos);
+    EXPECT_NE(response.find("\"relaxation\":0.8"), std::string::npos);
+
+    cfg.set("relaxation", 0.5);
+    response = exchange(admin.port(), get);
+    EXPECT_NE(response.find(std::format("ETag: \"{}.1\"", cfg.generation())), std::string::npos);
+    EXPECT_NE(response.find("\"relaxation\":0.5"), std::string::npos);
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <format>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "fourdst/config/config.h"
+#include "test_schema.h"
+
+/**
+ * @file adversarialTest.cpp
+ * @brief Timing checks that the parser and validator stay linear on hostile decks.
+ *
+ * Each test times the same work at `n` and `8 * n`, up to 10^6 elements, so the suite takes a
+ * while and is sensitive to a loaded machine. It runs in its own meson suite, apart from the
+ * functional adversarial_* checks in configTest.cpp:
+ *
+ * @code{.sh}
+ * meson test -C build --suite adversarial
+ * @endcode
+ */
+
+namespace {
+    /// Returns the fastest of three runs of `work`, in seconds; the minimum is the least noisy estimate.
+    template <typename Work>
+    double fastest_run(Work&& work) {
+        double fastest = std::numeric_limits<double>::max();
+        for (int run = 0; run < 3; ++run) {
+            const auto start = std::chrono::steady_clock::now();
+            work();
+            fastest = std::min(fastest, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return fastest;
+    }
+
+    /**
+     * @brief Expects `work(8 * n)` to take at most 24 times as long as `work(n)`.
+     *
+     * Linear work takes about 8 times as long and quadratic work 64 times, so the bound leaves
+     * room for noise and cache effects while still catching an accidental quadratic path.
+     */
+    template <typename Work>
+    void expect_linear(const std::size_t n, Work&& work) {
+        const double small = std::max(fastest_run([&] { work(n); }), 1e-4);
+        const double large = fastest_run([&] { work(8 * n); });
+        EXPECT_LT(large / small, 24.0) << "n = " << n << ": " << small << " s, 8n: " << large << " s";
+    }
+}
+
+class adversarialTest : public ::testing::Test {};
+
+TEST_F(adversarialTest, missing_field_report_is_linear) {
+    using namespace fourdst::config;
+    // 8 * 125000 = 10^6 missing fields, spread over a thousand tables.
+    expect_linear(125'000, [](const std::size_t n) {
+        std::vector<std::string> missing;
+        missing.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) missing.push_back(std::format("main.table{}.field{}", i % 1000, i));
+        const std::string report = validate::report_all_missing_fields(missing);
+        EXPECT_NE(report.find(std::format("field{}", n - 1)), std::string::npos);
+    });
+}
+
+TEST_F(adversarialTest, long_keys_are_checked_in_linear_time) {
+    using namespace fourdst::config;
+    expect_linear(1 << 17, [](const std::size_t length) {
+        toml::table main;
+        main.insert("description", "x");
+        main.insert(std::string(length, 'k'), 1);
+        main.insert(std::string(length, 'a') + "uthor", 1);
+        std::vector<validate::ValidationIssue> issues;
+        validate::ConfigValidator<TestConfigSchema>::validate(&main, "main", issues);
+        EXPECT_EQ(std::ranges::count(issues, validate::IssueKind::UNKNOWN_KEY, &validate::ValidationIssue::kind), 2);
+    });
+}
+
+TEST_F(adversarialTest, huge_arrays_load_in_linear_time) {
+    using namespace fourdst::config;
+    expect_linear(1 << 15, [](const std::size_t n) {
+        std::string deck = "[main]\ngrid = [[";
+        for (std::size_t i = 0; i < n; ++i) deck += "1.5, ";
+        deck += "]]\n";
+        Config<RichConfigSchema> cfg;
+        cfg.set_missing_field_policy(MissingFieldPolicy::USE_DEFAULTS);
+        cfg.load_from(deck);
+        EXPECT_EQ(cfg->grid.front().size(), n);
+    });
+
+    // A wrong-length fixed array is reported once, however long it is.
+    expect_linear(1 << 16, [](const std::size_t n) {
+        toml::table main;
+        toml::array flags;
+        for (std::size_t i = 0; i < n; ++i) flags.push_back(1);
+        toml::table physics;
+        physics.insert("diffusion", true);
+        physics.insert("flags", std::move(flags));
+        main.insert("physics", std::move(physics));
+        std::vector<validate::ValidationIssue> issues;
+        validate::ConfigValidator<TestConfigSchema>::validate(&main, "main", issues);
+        EXPECT_EQ(std::ranges::count(issues, std::string("main.physics.flags"), &validate::ValidationIssue::path), 1);
+    });
+}
+
+TEST_F(adversarialTest, deep_nesting_is_scanned_in_linear_time) {
+    using namespace fourdst::config;
+    expect_linear(1 << 17, [](const std::size_t n) {
+        std::string deck = "[main.physics]\nflags = [";
+        for (std::size_t i = 0; i < n; ++i) deck += "[1], ";
+        deck += "]\n";
+        io::check_parse_limits(deck, {.max_array_length = 1 << 24, .max_depth = 64}, "<deck>");
+    });
+}
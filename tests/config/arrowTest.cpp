@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "fourdst/config/config.h"
+
+/**
+ * @file arrowTest.cpp
+ * @brief Tests for Arrow IPC columnar files holding large arrays of tables.
+ */
+
+enum class ReactionKind { CAPTURE, DECAY };
+
+struct ReactionRow {
+    std::string label = "";
+    ReactionKind kind = ReactionKind::CAPTURE;
+    double rate = 0.0;
+    std::int32_t chapter = 0;
+    std::optional<double> q_value = std::nullopt;
+};
+
+struct NuclearNetwork {
+    std::string name = "network";
+    std::vector<ReactionRow> reactions = {};
+};
+
+struct ColumnarSchema {
+    NuclearNetwork network;
+};
+
+class arrowTest : public ::testing::Test {};
+
+TEST_F(arrowTest, large_arrays_of_tables_round_trip_through_columnar_files) {
+    using namespace fourdst::config;
+    static_assert(io::is_columnar_array_v<std::vector<ReactionRow>>);
+
+    Config<ColumnarSchema> writer;
+    writer.mutate([](ColumnarSchema& c) {
+        for (int i = 0; i < 5000; ++i) {
+            c.network.reactions.push_back({std::format("r{}", i), i % 2 == 0 ? ReactionKind::CAPTURE : ReactionKind::DECAY,
+                                           i * 1.5, i % 11, i % 3 == 0 ? std::optional<double>(i * 0.1) : std::nullopt});
+        }
+    });
+    writer.set_columnar_threshold(1000);
+    EXPECT_EQ(writer.get_columnar_threshold(), 1000);
+    writer.save("ColumnarSchema.toml", SavePolicy::ATOMIC);
+
+    ASSERT_TRUE(std::filesystem::exists("ColumnarSchema.toml.network.reactions.arrow"));
+    std::ifstream in("ColumnarSchema.toml");
+    const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    EXPECT_NE(text.find("reactions = { __columnar = \"ColumnarSchema.toml.network.reactions.arrow\", rows = 5000"), std::string::npos) << text;
+    EXPECT_EQ(text.find("[[main.network.reactions]]"), std::string::npos);
+
+    Config<ColumnarSchema> reader;
+    reader.load("ColumnarSchema.toml");
+    EXPECT_TRUE(detail::equal(reader.main(), writer.main()));
+
+    // Below the threshold the rows stay in the TOML file.
+    Config<ColumnarSchema> small;
+    small.mutate([](ColumnarSchema& c) { c.network.reactions.resize(3); });
+    small.set_columnar_threshold(1000);
+    small.save("ColumnarSchema.small.toml");
+    std::ifstream small_in("ColumnarSchema.small.toml");
+    const std::string small_text((std::istreambuf_iterator<char>(small_in)), std::istreambuf_iterator<char>());
+    EXPECT_NE(small_text.find("[[main.network.reactions]]"), std::string::npos);
+
+    // A file that no longer matches its reference is rejected.
+    {
+        std::ofstream out("ColumnarSchema.stale.toml");
+        std::string stale_text = text;
+        stale_text.replace(stale_text.find("checksum = \"") + 12, 4, "0000");
+        out << stale_text;
+    }
+    Config<ColumnarSchema> stale;
+    EXPECT_THROW(stale.load("ColumnarSchema.stale.toml"), exceptions::ConfigParseError);
+}
@@ -0,0 +1,38 @@
+#include "fourdst/config/c_api.h"
+
+#include <string.h>
+
+/**
+ * @file capiConsumer.c
+ * @brief A C translation unit that reads config values through the fdc_* ABI only, for capiTest.
+ */
+
+/* Sums `simulation.time_step` over `steps` reads by handle, as a hot loop would. */
+double sum_time_steps(const fdc_config* cfg, const int steps) {
+    const fdc_handle handle = fdc_handle_of(cfg, "simulation.time_step");
+    double sum = 0.0;
+    for (int i = 0; i < steps; ++i) {
+        double value = 0.0;
+        if (fdc_get_double_h(cfg, handle, &value) != FDC_OK) return -1.0;
+        sum += value;
+    }
+    return sum;
+}
+
+/* Returns the sum of `physics.flags`, or -1 if it cannot be read as an int32 array. */
+int sum_flags(const fdc_config* cfg) {
+    const int32_t* flags = NULL;
+    size_t length = 0;
+    if (fdc_get_int32_array_h(cfg, fdc_handle_of(cfg, "physics.flags"), &flags, &length) != FDC_OK) return -1;
+    int sum = 0;
+    for (size_t i = 0; i < length; ++i) sum += flags[i];
+    return sum;
+}
+
+/* Returns whether `output.format` equals `expected`. */
+int format_is(const fdc_config* cfg, const char* expected) {
+    char buffer[32];
+    size_t length = 0;
+    if (fdc_get_string(cfg, "output.format", buffer, sizeof buffer, &length) != FDC_OK) return 0;
+    return length == strlen(expected) && memcmp(buffer, expected, length) == 0;
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <string>
+
+#include "fourdst/config/c_api.h"
+#include "fourdst/config/config.h"
+#include "test_schema.h"
+
+/**
+ * @file capiTest.cpp
+ * @brief Tests for the C ABI of c_api.h, read from a C translation unit (capiConsumer.c).
+ */
+
+FOURDST_CONFIG_C_API();
+
+extern "C" {
+double sum_time_steps(const fdc_config* cfg, int steps);
+int sum_flags(const fdc_config* cfg);
+int format_is(const fdc_config* cfg, const char* expected);
+}
+
+class capiTest : public ::testing::Test {};
+
+TEST_F(capiTest, c_callers_read_the_pinned_snapshot_by_handle) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    cfg.mutate([](TestConfigSchema& c) { c.physics.flags = {1, 2, 3}; });
+    fdc_config* view = c_api::wrap(cfg);
+
+    EXPECT_EQ(sum_time_steps(view, 4), 4.0);
+    EXPECT_EQ(sum_flags(view), 6);
+    EXPECT_TRUE(format_is(view, "hdf5"));
+
+    cfg.mutate([](TestConfigSchema& c) { c.simulation.time_step = 0.5; });
+    EXPECT_EQ(sum_time_steps(view, 4), 4.0);
+    fdc_refresh(view);
+    EXPECT_EQ(sum_time_steps(view, 4), 2.0);
+
+    EXPECT_LT(fdc_handle_of(view, "simulation.missing"), 0);
+    EXPECT_EQ(fdc_kind(view, fdc_handle_of(view, "simulation")), FDC_KIND_OTHER);
+    EXPECT_EQ(fdc_kind(view, fdc_handle_of(view, "simulation.output_frequency")), FDC_KIND_INT);
+    std::int64_t frequency = 0;
+    EXPECT_EQ(fdc_get_int(view, "simulation.output_frequency", &frequency), FDC_OK);
+    EXPECT_EQ(frequency, 1);
+    EXPECT_EQ(fdc_get_int(view, "simulation.time_step", &frequency), FDC_TYPE_MISMATCH);
+    double unknown = 0.0;
+    EXPECT_EQ(fdc_get_double(view, "simulation.missing", &unknown), FDC_UNKNOWN_PATH);
+
+    char buffer[2];
+    std::size_t length = 0;
+    EXPECT_EQ(fdc_get_string(view, "output.format", buffer, sizeof buffer, &length), FDC_TRUNCATED);
+    EXPECT_EQ(length, 4u);
+    EXPECT_EQ(std::string(buffer, 2), "hd");
+
+    EXPECT_EQ(fdc_load(view, "no/such/file.toml"), FDC_ERROR);
+    EXPECT_NE(std::string(fdc_last_error(view)), "");
+    EXPECT_EQ(sum_time_steps(view, 2), 1.0);
+    fdc_free(view);
+}
+
+TEST_F(capiTest, fdc_load_reads_a_file_and_then_reloads) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> writer;
+    writer.mutate([](TestConfigSchema& c) { c.simulation.time_step = 0.25; });
+    writer.save("TestConfigSchema.capi.first.toml");
+    writer.mutate([](TestConfigSchema& c) { c.simulation.time_step = 2.0; });
+    writer.save("TestConfigSchema.capi.second.toml");
+
+    // A config that was never loaded is loaded...
+    Config<TestConfigSchema> cfg;
+    fdc_config* view = c_api::wrap(cfg);
+    EXPECT_EQ(fdc_load(view, "TestConfigSchema.capi.first.toml"), FDC_OK);
+    EXPECT_EQ(std::string(fdc_last_error(view)), "");
+    EXPECT_EQ(sum_time_steps(view, 4), 1.0);
+
+    // ...and one that has a source is reloaded from the new path.
+    EXPECT_EQ(fdc_load(view, "TestConfigSchema.capi.second.toml"), FDC_OK);
+    EXPECT_EQ(sum_time_steps(view, 4), 8.0);
+    EXPECT_EQ(cfg.get_source_path(), "TestConfigSchema.capi.second.toml");
+    fdc_free(view);
+
+    // The same holds for a config loaded before wrap().
+    Config<TestConfigSchema> loaded;
+    loaded.load("TestConfigSchema.capi.first.toml");
+    fdc_config* late = c_api::wrap(loaded);
+    EXPECT_EQ(fdc_load(late, "TestConfigSchema.capi.second.toml"), FDC_OK);
+    EXPECT_EQ(sum_time_steps(late, 2), 4.0);
+    fdc_free(late);
+}
@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "fourdst/config/config.h"
+
+#include "rich_reader.h"
+
+/**
+ * @file codegenTest.cpp
+ * @brief Tests for loads through readers generated at build time.
+ */
+
+class codegenTest : public ::testing::Test {};
+
+static_assert(fourdst::config::io::has_generated_reader_v<RichConfigSchema>);
+static_assert(fourdst::config::io::has_generated_reader_v<Species>);
+static_assert(!fourdst::config::io::has_generated_reader_v<TestConfigSchema>);
+
+TEST_F(codegenTest, generated_reader_matches_reflect_cpp) {
+    using namespace fourdst::config;
+    const std::string path = std::string(getenv("MESON_SOURCE_ROOT")) + "/tests/config/example_config_files/example.embed.toml";
+    Config<RichConfigSchema> cfg;
+    cfg.load(path);
+
+    toml::table root = toml::parse_file(path);
+    toml::node* main = root.get("main");
+    const auto expected = rfl::toml::read<RichConfigSchema>(main);
+    ASSERT_TRUE(expected);
+    EXPECT_TRUE(detail::equal(cfg.main(), *expected));
+    EXPECT_EQ(cfg->solver, Solver::EXPLICIT);
+    EXPECT_EQ(cfg->grid.size(), 3);
+    EXPECT_EQ(cfg->species.at(0).charges, (std::vector<int>{0, 6}));
+    EXPECT_FALSE(cfg->output->save_plots.has_value());
+}
+
+TEST_F(codegenTest, generated_reader_failures_are_reported_by_the_validator) {
+    using namespace fourdst::config;
+    const std::string path = (std::filesystem::temp_directory_path() / "codegen_test.toml").string();
+    {
+        std::ofstream out(path);
+        out << "[main]\ntitle = \"t\"\nwhole = \"not a number\"\n";
+    }
+    Config<RichConfigSchema> cfg;
+    try {
+        cfg.load(path);
+        FAIL() << "expected a ConfigParseError";
+    } catch (const exceptions::ConfigParseError& e) {
+        EXPECT_NE(std::string(e.what()).find("main.whole"), std::string::npos) << e.what();
+    }
+    std::filesystem::remove(path);
+}
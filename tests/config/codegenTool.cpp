@@ -0,0 +1,12 @@
+#include "fourdst/config/codegen.h"
+
+#include "test_schema.h"
+
+/**
+ * @file codegenTool.cpp
+ * @brief Build-time generator for the reader used by codegenTest.
+ */
+
+int main(int argc, char** argv) {
+    return fourdst::config::codegen_main<RichConfigSchema>(argc, argv);
+}
@@ -5,10 +5,33 @@
 #include <set>
 #include <sstream>
 #include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <cstdio>
+#include <cstdint>
+#include <unordered_map>
 
 #include "fourdst/config/config.h"
+#include "fourdst/config/embed.h"
 #include "test_schema.h"
 
+#if defined(__unix__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 
 std::string get_good_example_file() {
     const char* source_root = getenv("MESON_SOURCE_ROOT");
@@ -31,7 +54,8 @@ enum class BAD_FILES {
     UNKNOWN_KEY,
     INVALID_TYPE,
     INCORRECT_ARRAY_SIZE,
-    MISSING_NONDEFAULT_KEY
+    MISSING_NONDEFAULT_KEY,
+    MALFORMED
 };
 
 std::string get_bad_example_file(BAD_FILES type) {
@@ -48,6 +72,8 @@ std::string get_bad_example_file(BAD_FILES type) {
             return std::string(source_root) + "/tests/config/example_config_files/example.incorrectarraysize.toml";
         case BAD_FILES::MISSING_NONDEFAULT_KEY:
             return std::string(source_root) + "/tests/config/example_config_files/example.missing.nondefault.field.toml";
+        case BAD_FILES::MALFORMED:
+            return std::string(source_root) + "/tests/config/example_config_files/example.malformed.toml";
     }
     throw std::runtime_error("Invalid BAD_FILES type.");
 }
@@ -95,6 +121,99 @@ TEST_F(configTest, load_incorrect_array_size_file) {
     EXPECT_THROW(cfg.load(get_bad_example_file(BAD_FILES::INCORRECT_ARRAY_SIZE)), exceptions::ConfigParseError);
 }
 
+TEST_F(configTest, load_malformed_file) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    EXPECT_THROW(cfg.load(get_bad_example_file(BAD_FILES::MALFORMED)), exceptions::ConfigParseError);
+    EXPECT_EQ(cfg.get_state(), ConfigState::DEFAULT);
+}
+
+TEST_F(configTest, load_memory_mapped) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    cfg.set_file_read_policy(FileReadPolicy::MEMORY_MAP);
+    EXPECT_EQ(cfg.describe_file_read_policy(), "MEMORY_MAP");
+    EXPECT_NO_THROW(cfg.load(get_good_example_file()));
+    EXPECT_EQ(cfg->author, "Example Author");
+    EXPECT_EQ(cfg->simulation.time_step, 0.01);
+}
+
+TEST_F(configTest, load_with_single_and_direct_reads) {
+    using namespace fourdst::config;
+    std::ifstream in(get_good_example_file(), std::ios::binary);
+    const std::string expected{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    for (const auto mode : {io::ReadMode::MAP, io::ReadMode::READ, io::ReadMode::DIRECT}) {
+        const io::MappedFile file(get_good_example_file(), mode);
+        EXPECT_EQ(file.view(), expected);
+    }
+
+    for (const auto policy : {FileReadPolicy::SINGLE_READ, FileReadPolicy::DIRECT}) {
+        Config<TestConfigSchema> cfg;
+        cfg.set_file_read_policy(policy);
+        EXPECT_NO_THROW(cfg.load(get_good_example_file()));
+        EXPECT_EQ(cfg->author, "Example Author");
+        EXPECT_EQ(cfg->simulation.time_step, 0.01);
+    }
+    Config<TestConfigSchema> direct;
+    direct.set_file_read_policy(FileReadPolicy::DIRECT);
+    EXPECT_EQ(direct.describe_file_read_policy(), "DIRECT");
+    EXPECT_THROW(direct.load(get_bad_example_file(BAD_FILES::MALFORMED)), exceptions::ConfigParseError);
+}
+
+TEST_F(configTest, streaming_load_matches_a_document_load) {
+    using namespace fourdst::config;
+    static_assert(io::is_event_readable_v<RichConfigSchema>);
+    Config<RichConfigSchema> writer;
+    writer.mutate([](RichConfigSchema& c) {
+        c.unset = 7;
+        c.species.push_back({"C-12", 12.0, {0, 6}});
+        c.abundances["Fe"] = 1e-4;
+    });
+    writer.save("RichConfigSchema.streaming.toml");
+
+    Config<RichConfigSchema> document;
+    document.load("RichConfigSchema.streaming.toml");
+    Config<RichConfigSchema> streamed;
+    streamed.set_file_read_policy(FileReadPolicy::STREAMING);
+    EXPECT_EQ(streamed.describe_file_read_policy(), "STREAMING");
+    streamed.load("RichConfigSchema.streaming.toml");
+    EXPECT_TRUE(equal(streamed.main(), document.main()));
+    EXPECT_EQ(streamed->species.back().name, "C-12");
+    EXPECT_EQ(streamed->title, writer->title);
+
+    // Fields the input leaves out keep their defaults.
+    std::istringstream in("[main]\ntitle = \"a \\u00e9 b\"\ngrid = [\n  [1, 2.5], # row\n  [3e2],\n]\n[[main.species]]\nname = 'X'\n");
+    std::string root;
+    const RichConfigSchema small = io::read_toml_stream<RichConfigSchema>(in, root);
+    EXPECT_EQ(root, "main");
+    EXPECT_EQ(small.title, "a \xc3\xa9 b");
+    EXPECT_EQ(small.grid, (std::vector<std::vector<double>>{{1.0, 2.5}, {300.0}}));
+    ASSERT_EQ(small.species.size(), 1u);
+    EXPECT_EQ(small.species[0].name, "X");
+    EXPECT_EQ(small.abundances, RichConfigSchema{}.abundances);
+
+    Config<TestConfigSchema> good;
+    good.set_file_read_policy(FileReadPolicy::STREAMING);
+    EXPECT_NO_THROW(good.load(get_good_example_file()));
+    EXPECT_EQ(good->author, "Example Author");
+    EXPECT_EQ(good->simulation.time_step, 0.01);
+
+    Config<TestConfigSchema> mistyped;
+    mistyped.set_file_read_policy(FileReadPolicy::STREAMING);
+    try {
+        mistyped.load(get_bad_example_file(BAD_FILES::INVALID_TYPE));
+        FAIL() << "expected a parse error";
+    } catch (const exceptions::ConfigParseError& e) {
+        ASSERT_TRUE(e.location().has_value());
+        EXPECT_EQ(e.location()->field, "main.physics.diffusion");
+        EXPECT_EQ(e.location()->line, 6u);
+        EXPECT_EQ(e.location()->column, 13u);
+    }
+    Config<TestConfigSchema> malformed;
+    malformed.set_file_read_policy(FileReadPolicy::STREAMING);
+    EXPECT_THROW(malformed.load(get_bad_example_file(BAD_FILES::MALFORMED)), exceptions::ConfigParseError);
+}
+
 TEST_F(configTest, check_value) {
     using namespace fourdst::config;
     Config<TestConfigSchema> cfg;
@@ -141,6 +260,12 @@ TEST_F(configTest, save_schema) {
     using namespace fourdst::config;
     Config<TestConfigSchema> cfg;
     EXPECT_NO_THROW(cfg.save_schema("TestConfigSchema.schema.json"));
+
+    const std::string_view schema = Config<TestConfigSchema>::schema();
+    EXPECT_EQ(schema.data(), Config<TestConfigSchema>::schema().data());
+    std::ifstream ifs("TestConfigSchema.schema.json");
+    const std::string saved((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(saved, schema);
 }
 
 TEST_F(configTest, missing_default_keys) {
@@ -155,6 +280,23 @@ TEST_F(configTest, missing_nondefault_keys) {
     EXPECT_THROW(cfg.load(get_bad_example_file(BAD_FILES::MISSING_NONDEFAULT_KEY)), exceptions::ConfigParseError);
 }
 
+TEST_F(configTest, root_name_policy) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> writer;
+    writer.set_root_name("other");
+    writer.mutate([](auto& data) { data.author = "Other Author"; });
+    writer.save("TestConfigSchema.other_root.toml");
+
+    Config<TestConfigSchema> keep;
+    EXPECT_THROW(keep.load("TestConfigSchema.other_root.toml"), exceptions::ConfigLoadError);
+
+    Config<TestConfigSchema> from_file;
+    from_file.set_root_name_load_policy(RootNameLoadPolicy::FROM_FILE);
+    EXPECT_NO_THROW(from_file.load("TestConfigSchema.other_root.toml"));
+    EXPECT_EQ(from_file.get_root_name(), "other");
+    EXPECT_EQ(from_file->author, "Other Author");
+}
+
 TEST_F(configTest, mutate_and_reset) {
     using namespace fourdst::config;
     Config<TestConfigSchema> cfg;
@@ -174,4 +316,5104 @@ TEST_F(configTest, mutate_and_reset) {
     EXPECT_TRUE(cfg->physics.diffusion);
     EXPECT_EQ(cfg.get_state(), ConfigState::LOADED_FROM_FILE);
 
-}
\ No newline at end of file
+}
+
+TEST_F(configTest, snapshot_is_immutable) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    EXPECT_NO_THROW(cfg.load(get_good_example_file()));
+
+    const auto before = cfg.snapshot();
+    ASSERT_NE(before, nullptr);
+    EXPECT_EQ(before->author, "Example Author");
+
+    cfg.mutate([](auto& data) { data.author = "Someone Else"; });
+    const auto after = cfg.snapshot();
+
+    EXPECT_EQ(before->author, "Example Author");
+    EXPECT_EQ(after->author, "Someone Else");
+
+    cfg.reset();
+    EXPECT_EQ(cfg.snapshot()->author, "Example Author");
+}
+
+TEST_F(configTest, snapshot_concurrent_readers) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    cfg.mutate([](auto& data) {
+        data.simulation.output_frequency = 0;
+        data.simulation.total_time = 0;
+    });
+
+    std::atomic<bool> done{false};
+    std::atomic<int> inconsistent{0};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&] {
+            while (!done.load()) {
+                const auto snap = cfg.snapshot();
+                if (static_cast<double>(snap->simulation.output_frequency) != snap->simulation.total_time) {
+                    ++inconsistent;
+                }
+            }
+        });
+    }
+
+    for (int i = 1; i <= 200; ++i) {
+        cfg.mutate([i](auto& data) {
+            data.simulation.output_frequency = i;
+            data.simulation.total_time = i;
+        });
+    }
+    done = true;
+    for (auto& t : readers) t.join();
+
+    EXPECT_EQ(inconsistent.load(), 0);
+    EXPECT_EQ(cfg.snapshot()->simulation.output_frequency, 200);
+}
+
+TEST_F(configTest, reload_reports_changes) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> writer;
+    EXPECT_NO_THROW(writer.load(get_good_example_file()));
+    writer.save("TestConfigSchema.reload.toml");
+
+    Config<TestConfigSchema> cfg;
+    EXPECT_THROW(cfg.reload(), exceptions::ConfigLoadError);
+    EXPECT_NO_THROW(cfg.load("TestConfigSchema.reload.toml"));
+    EXPECT_THROW(cfg.load("TestConfigSchema.reload.toml"), exceptions::ConfigLoadError);
+
+    EXPECT_FALSE(cfg.reload());
+
+    writer.mutate([](auto& data) { data.simulation.time_step = 0.5; });
+    writer.save("TestConfigSchema.reload.toml");
+
+    const auto before = cfg.snapshot();
+    EXPECT_TRUE(cfg.reload());
+    EXPECT_EQ(cfg->simulation.time_step, 0.5);
+    EXPECT_EQ(cfg.snapshot()->simulation.time_step, 0.5);
+    EXPECT_EQ(before->simulation.time_step, 0.01);
+    EXPECT_EQ(cfg.get_state(), ConfigState::LOADED_FROM_FILE);
+}
+
+TEST_F(configTest, reload_failure_keeps_content) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    EXPECT_NO_THROW(cfg.load(get_good_example_file()));
+    EXPECT_THROW(cfg.reload(get_bad_example_file(BAD_FILES::INVALID_TYPE)), exceptions::ConfigParseError);
+    EXPECT_EQ(cfg->author, "Example Author");
+    EXPECT_EQ(cfg.get_source_path(), get_good_example_file());
+}
+
+TEST_F(configTest, watcher_reloads_on_change) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> writer;
+    EXPECT_NO_THROW(writer.load(get_good_example_file()));
+    writer.save("TestConfigSchema.watch.toml");
+
+    Config<TestConfigSchema> cfg;
+    EXPECT_NO_THROW(cfg.load("TestConfigSchema.watch.toml"));
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool reloaded = false;
+
+    ConfigWatcher watcher(cfg, std::chrono::milliseconds(50));
+    watcher.on_reload([&](bool changed) {
+        std::lock_guard lock(mtx);
+        reloaded = reloaded || changed;
+        cv.notify_all();
+    });
+    watcher.start();
+    EXPECT_TRUE(watcher.running());
+
+    writer.mutate([](auto& data) { data.simulation.output_frequency = 42; });
+    writer.save("TestConfigSchema.watch.toml");
+
+    {
+        std::unique_lock lock(mtx);
+        cv.wait_for(lock, std::chrono::seconds(5), [&] { return reloaded; });
+    }
+    watcher.stop();
+
+    EXPECT_TRUE(reloaded);
+    EXPECT_EQ(cfg.snapshot()->simulation.output_frequency, 42);
+}
+
+TEST_F(configTest, watcher_reports_any_exception_of_a_reload) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> writer;
+    EXPECT_NO_THROW(writer.load(get_good_example_file()));
+    writer.save("TestConfigSchema.watch_throw.toml");
+
+    Config<TestConfigSchema> cfg;
+    EXPECT_NO_THROW(cfg.load("TestConfigSchema.watch_throw.toml"));
+    cfg.subscribe("simulation", [](const auto&) { throw std::runtime_error("subscriber failed"); });
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::string error;
+    ConfigWatcher watcher(cfg, std::chrono::milliseconds(50));
+    watcher.on_error([&](const exceptions::ConfigError& e) {
+        std::lock_guard lock(mtx);
+        error = e.what();
+        cv.notify_all();
+    });
+    watcher.start();
+
+    writer.mutate([](auto& data) { data.simulation.output_frequency = 44; });
+    writer.save("TestConfigSchema.watch_throw.toml");
+    {
+        std::unique_lock lock(mtx);
+        cv.wait_for(lock, std::chrono::seconds(5), [&] { return !error.empty(); });
+    }
+    EXPECT_TRUE(watcher.running());
+    watcher.stop();
+    EXPECT_NE(error.find("subscriber failed"), std::string::npos);
+}
+
+TEST_F(configTest, watcher_reloads_while_other_files_in_the_directory_keep_changing) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> writer;
+    EXPECT_NO_THROW(writer.load(get_good_example_file()));
+    writer.save("TestConfigSchema.watch_noise.toml");
+
+    Config<TestConfigSchema> cfg;
+    EXPECT_NO_THROW(cfg.load("TestConfigSchema.watch_noise.toml"));
+
+    std::atomic<bool> reloaded{false};
+    ConfigWatcher watcher(cfg, std::chrono::milliseconds(100));
+    watcher.on_reload([&](bool changed) { reloaded = reloaded || changed; });
+    watcher.start();
+
+    writer.mutate([](auto& data) { data.simulation.output_frequency = 43; });
+    writer.save("TestConfigSchema.watch_noise.toml");
+
+    // Another file of the directory is written more often than the debounce interval; the reload must not wait for it to stop.
+    const auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    for (int i = 0; !reloaded && std::chrono::steady_clock::now() < give_up; ++i) {
+        std::ofstream("TestConfigSchema.watch_noise.other") << i;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    watcher.stop();
+
+    EXPECT_TRUE(reloaded);
+    EXPECT_EQ(cfg.snapshot()->simulation.output_frequency, 43);
+}
+
+TEST_F(configTest, watch_service_reloads_many_configs_on_one_thread) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> writer;
+    writer.load(get_good_example_file());
+    constexpr int members = 8;
+    std::vector<Config<TestConfigSchema>> configs(members);
+    for (int i = 0; i < members; ++i) {
+        const std::string path = std::format("TestConfigSchema.watched_{}.toml", i);
+        writer.save(path);
+        configs[i].load(path);
+    }
+
+    ThreadPool pool(2);
+    WatchService service(std::ref(pool));
+    std::mutex mtx;
+    std::condition_variable cv;
+    int changed = 0;
+    std::vector<WatchService::WatchId> ids;
+    for (auto& cfg : configs) {
+        WatchOptions options;
+        options.debounce = std::chrono::milliseconds(20);
+        options.max_delay = std::chrono::milliseconds(500);
+        options.on_reload = [&](const bool content_changed) {
+            std::lock_guard lock(mtx);
+            changed += content_changed ? 1 : 0;
+            cv.notify_all();
+        };
+        ids.push_back(service.watch(cfg, options));
+    }
+    EXPECT_EQ(service.size(), static_cast<std::size_t>(members));
+    service.start();
+    EXPECT_TRUE(service.running());
+
+    for (int i = 0; i < members; ++i) {
+        writer.mutate([i](auto& data) { data.simulation.output_frequency = 100 + i; });
+        writer.save(std::format("TestConfigSchema.watched_{}.toml", i));
+    }
+    {
+        std::unique_lock lock(mtx);
+        cv.wait_for(lock, std::chrono::seconds(10), [&] { return changed == members; });
+    }
+    for (int i = 0; i < members; ++i) {
+        EXPECT_EQ(configs[i]->simulation.output_frequency, 100 + i);
+    }
+
+    EXPECT_TRUE(service.unwatch(ids[0]));
+    EXPECT_FALSE(service.unwatch(ids[0]));
+    service.stop();
+    EXPECT_FALSE(service.running());
+    for (int i = 0; i < members; ++i) std::filesystem::remove(std::format("TestConfigSchema.watched_{}.toml", i));
+}
+
+TEST_F(configTest, watch_service_reports_any_exception_of_a_reload) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> writer;
+    writer.load(get_good_example_file());
+    writer.save("TestConfigSchema.watched_throw.toml");
+    Config<TestConfigSchema> cfg;
+    cfg.load("TestConfigSchema.watched_throw.toml");
+    cfg.subscribe("simulation", [](const auto&) { throw std::runtime_error("subscriber failed"); });
+
+    WatchService service;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::string error;
+    WatchOptions options;
+    options.debounce = std::chrono::milliseconds(20);
+    options.on_error = [&](const exceptions::ConfigError& e) {
+        std::lock_guard lock(mtx);
+        error = e.what();
+        cv.notify_all();
+    };
+    service.watch(cfg, options);
+    service.start();
+
+    writer.mutate([](auto& data) { data.simulation.output_frequency = 45; });
+    writer.save("TestConfigSchema.watched_throw.toml");
+    {
+        std::unique_lock lock(mtx);
+        cv.wait_for(lock, std::chrono::seconds(5), [&] { return !error.empty(); });
+    }
+    EXPECT_TRUE(service.running());
+    service.stop();
+    EXPECT_NE(error.find("subscriber failed"), std::string::npos);
+    std::filesystem::remove("TestConfigSchema.watched_throw.toml");
+}
+
+TEST_F(configTest, subscribe_fires_on_subtree_change) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+
+    int simulation_calls = 0;
+    int time_step_calls = 0;
+    int any_calls = 0;
+    EXPECT_THROW(cfg.subscribe("simulation.no_such_field", [](const auto&) {}), exceptions::ConfigPathError);
+    EXPECT_THROW(cfg.subscribe("author.name", [](const auto&) {}), exceptions::ConfigPathError);
+
+    cfg.subscribe("simulation", [&](const auto&) { ++simulation_calls; });
+    const auto id = cfg.subscribe("simulation.time_step", [&](const auto& snapshot) {
+        ++time_step_calls;
+        EXPECT_EQ(snapshot->simulation.time_step, 0.25);
+    });
+    cfg.subscribe("", [&](const auto&) { ++any_calls; });
+
+    cfg.mutate([](auto& data) { data.output.directory = "/tmp/out"; });
+    EXPECT_EQ(simulation_calls, 0);
+    EXPECT_EQ(time_step_calls, 0);
+    EXPECT_EQ(any_calls, 1);
+
+    cfg.mutate([](auto& data) { data.simulation.output_frequency = 7; });
+    EXPECT_EQ(simulation_calls, 1);
+    EXPECT_EQ(time_step_calls, 0);
+
+    cfg.mutate([](auto& data) { data.simulation.time_step = 0.25; });
+    EXPECT_EQ(simulation_calls, 2);
+    EXPECT_EQ(time_step_calls, 1);
+
+    EXPECT_TRUE(cfg.unsubscribe(id));
+    EXPECT_FALSE(cfg.unsubscribe(id));
+    cfg.reset();
+    EXPECT_EQ(simulation_calls, 3);
+    EXPECT_EQ(time_step_calls, 1);
+    EXPECT_EQ(any_calls, 4);
+}
+
+namespace {
+    /// A coroutine that starts at once and is never awaited, enough to drive `Config::changes()`.
+    struct Detached {
+        struct promise_type {
+            Detached get_return_object() { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+
+    Detached follow_time_steps(fourdst::config::Config<TestConfigSchema>& cfg, std::vector<double>& steps, bool& finished) {
+        auto changes = cfg.changes({});
+        while (true) {
+            const auto [content, generation] = co_await changes;
+            if (!content) break;
+            EXPECT_EQ(generation, changes.generation());
+            steps.push_back(content->simulation.time_step);
+        }
+        finished = true;
+    }
+
+    Detached await_next_change(fourdst::config::Config<TestConfigSchema>& cfg, fourdst::config::ThreadPool& pool,
+                               std::promise<std::thread::id>& resumed) {
+        const auto change = co_await cfg.changes(std::ref(pool));
+        EXPECT_EQ(change.content->simulation.time_step, 4.0);
+        resumed.set_value(std::this_thread::get_id());
+    }
+}
+
+TEST_F(configTest, changes_resume_coroutines_with_each_new_snapshot) {
+    using namespace fourdst::config;
+    std::vector<double> steps;
+    bool finished = false;
+    {
+        Config<TestConfigSchema> cfg;
+        follow_time_steps(cfg, steps, finished);
+        EXPECT_TRUE(steps.empty());
+        cfg.mutate([](auto& data) { data.simulation.time_step = 0.5; });
+        cfg.mutate([](auto& data) { data.simulation.time_step = 2.0; });
+        cfg.reset();
+        EXPECT_EQ(steps, (std::vector<double>{0.5, 2.0, TestConfigSchema{}.simulation.time_step}));
+
+        ThreadPool pool(1);
+        std::promise<std::thread::id> resumed;
+        await_next_change(cfg, pool, resumed);
+        cfg.mutate([](auto& data) { data.simulation.time_step = 4.0; });
+        auto resumed_on = resumed.get_future();
+        ASSERT_EQ(resumed_on.wait_for(std::chrono::seconds(30)), std::future_status::ready);
+        EXPECT_NE(resumed_on.get(), std::this_thread::get_id());
+        EXPECT_FALSE(finished);
+    }
+    // Destroying the config ends the stream.
+    EXPECT_TRUE(finished);
+    EXPECT_EQ(steps.size(), 4u);
+}
+
+TEST_F(configTest, reset_reverts_all_mutations) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    EXPECT_NO_THROW(cfg.load(get_good_example_file()));
+    const auto loaded = cfg.snapshot();
+
+    cfg.mutate([](auto& data) { data.author = "Someone Else"; });
+    cfg.mutate([](auto& data) { data.simulation.output_frequency = 99; });
+    EXPECT_EQ(cfg->author, "Someone Else");
+
+    cfg.reset();
+    EXPECT_EQ(cfg->author, "Example Author");
+    EXPECT_EQ(cfg->simulation.output_frequency, loaded->simulation.output_frequency);
+    EXPECT_EQ(cfg.snapshot(), loaded);
+}
+
+TEST_F(configTest, transaction_commit_and_rollback) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    EXPECT_NO_THROW(cfg.load(get_good_example_file()));
+    const auto loaded = cfg.snapshot();
+
+    EXPECT_FALSE(cfg.transaction([](auto& data) {
+        data.author = "Rolled Back";
+        data.simulation.output_frequency = 123;
+        return false;
+    }));
+    EXPECT_EQ(cfg->author, "Example Author");
+    EXPECT_EQ(cfg.snapshot(), loaded);
+    EXPECT_EQ(cfg.get_state(), ConfigState::LOADED_FROM_FILE);
+
+    EXPECT_THROW(cfg.transaction([](auto& data) {
+        data.author = "Thrown Away";
+        throw std::runtime_error("abort");
+    }), std::runtime_error);
+    EXPECT_EQ(cfg->author, "Example Author");
+    EXPECT_EQ(cfg.snapshot(), loaded);
+
+    EXPECT_TRUE(cfg.transaction([](auto& data) {
+        data.author = "Committed";
+        data.simulation.output_frequency = 123;
+    }));
+    EXPECT_EQ(cfg.snapshot()->author, "Committed");
+    EXPECT_EQ(cfg.snapshot()->simulation.output_frequency, 123);
+    EXPECT_EQ(cfg.get_state(), ConfigState::MODIFIED);
+}
+
+TEST_F(configTest, undo_history_is_bounded) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    EXPECT_FALSE(cfg.undo());
+
+    cfg.set_history_limit(2);
+    for (int i = 1; i <= 3; ++i) {
+        cfg.mutate([i](auto& data) { data.simulation.output_frequency = i; });
+    }
+    EXPECT_EQ(cfg.history_size(), 2u);
+
+    EXPECT_TRUE(cfg.undo());
+    EXPECT_EQ(cfg->simulation.output_frequency, 2);
+    EXPECT_TRUE(cfg.undo());
+    EXPECT_EQ(cfg->simulation.output_frequency, 1);
+    EXPECT_EQ(cfg.get_state(), ConfigState::MODIFIED);
+    EXPECT_FALSE(cfg.undo());
+
+    cfg.reset();
+    EXPECT_EQ(cfg.get_state(), ConfigState::DEFAULT);
+    EXPECT_EQ(cfg->simulation.output_frequency, 1);
+}
+
+TEST_F(configTest, streaming_save_round_trip) {
+    using namespace fourdst::config;
+    static_assert(io::is_streamable_v<RichConfigSchema>);
+
+    Config<RichConfigSchema> writer;
+    writer.mutate([](auto& data) { data.output->directory = "/scratch/run 1"; });
+    EXPECT_NO_THROW(writer.save("RichConfigSchema.toml"));
+
+    Config<RichConfigSchema> reader;
+    reader.mutate([](auto& data) {
+        data.species.clear();
+        data.abundances.clear();
+    });
+    EXPECT_NO_THROW(reader.load("RichConfigSchema.toml"));
+    EXPECT_TRUE(detail::equal(reader.main(), writer.main()));
+    EXPECT_EQ(reader->species.size(), 2u);
+    EXPECT_EQ(reader->species[1].charges.size(), 3u);
+    EXPECT_EQ(reader->output->directory, "/scratch/run 1");
+
+    std::ifstream ifs("RichConfigSchema.toml");
+    const std::string saved((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(std::format("{}", writer), saved);
+    EXPECT_NE(saved.find("[[main.species]]"), std::string::npos);
+    EXPECT_NE(saved.find("whole = 100.0"), std::string::npos);
+}
+
+TEST_F(configTest, atomic_save_replaces_file) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> writer;
+    EXPECT_NO_THROW(writer.load(get_good_example_file()));
+    writer.save("TestConfigSchema.atomic.toml");
+
+    writer.mutate([](auto& data) { data.author = "Atomic Author"; });
+    EXPECT_NO_THROW(writer.save("TestConfigSchema.atomic.toml", SavePolicy::ATOMIC));
+    EXPECT_NO_THROW(writer.save("TestConfigSchema.durable.toml", SavePolicy::DURABLE));
+
+    for (const auto& entry : std::filesystem::directory_iterator(".")) {
+        EXPECT_NE(entry.path().extension(), ".tmp") << "leftover temporary file " << entry.path();
+    }
+
+    Config<TestConfigSchema> atomic;
+    EXPECT_NO_THROW(atomic.load("TestConfigSchema.atomic.toml"));
+    EXPECT_EQ(atomic->author, "Atomic Author");
+    Config<TestConfigSchema> durable;
+    EXPECT_NO_THROW(durable.load("TestConfigSchema.durable.toml"));
+    EXPECT_EQ(durable->author, "Atomic Author");
+
+    EXPECT_THROW(writer.save("no_such_directory/TestConfigSchema.toml", SavePolicy::ATOMIC), exceptions::ConfigSaveError);
+}
+
+TEST_F(configTest, atomic_save_keeps_symlinks_and_permissions) {
+    using namespace fourdst::config;
+    namespace fs = std::filesystem;
+    Config<TestConfigSchema> writer;
+    writer.save("TestConfigSchema.atomic_real.toml");
+    fs::permissions("TestConfigSchema.atomic_real.toml", fs::perms::owner_read | fs::perms::owner_write, fs::perm_options::replace);
+    fs::remove("TestConfigSchema.atomic_link.toml");
+    fs::create_symlink("TestConfigSchema.atomic_real.toml", "TestConfigSchema.atomic_link.toml");
+
+    writer.mutate([](auto& data) { data.author = "Through the link"; });
+    EXPECT_NO_THROW(writer.save("TestConfigSchema.atomic_link.toml", SavePolicy::ATOMIC));
+
+    EXPECT_TRUE(fs::is_symlink(fs::symlink_status("TestConfigSchema.atomic_link.toml")));
+    EXPECT_EQ(fs::status("TestConfigSchema.atomic_real.toml").permissions() & fs::perms::all,
+              fs::perms::owner_read | fs::perms::owner_write);
+    Config<TestConfigSchema> reader;
+    EXPECT_NO_THROW(reader.load("TestConfigSchema.atomic_real.toml"));
+    EXPECT_EQ(reader->author, "Through the link");
+    fs::remove("TestConfigSchema.atomic_link.toml");
+    fs::remove("TestConfigSchema.atomic_real.toml");
+}
+
+TEST_F(configTest, binary_cache_round_trip) {
+    using namespace fourdst::config;
+    static_assert(io::is_binary_encodable_v<RichConfigSchema>);
+
+    Config<RichConfigSchema> writer;
+    writer.mutate([](auto& data) { data.unset = 3; });
+    writer.save("RichConfigSchema.cached.toml");
+    std::filesystem::remove(io::cache_path_for("RichConfigSchema.cached.toml"));
+
+    Config<RichConfigSchema> cold;
+    cold.set_cache_policy(CachePolicy::READ_WRITE);
+    EXPECT_EQ(cold.describe_cache_policy(), "READ_WRITE");
+    EXPECT_NO_THROW(cold.load("RichConfigSchema.cached.toml"));
+    EXPECT_TRUE(std::filesystem::exists(io::cache_path_for("RichConfigSchema.cached.toml")));
+
+    Config<RichConfigSchema> warm;
+    warm.set_cache_policy(CachePolicy::READ_ONLY);
+    EXPECT_NO_THROW(warm.load("RichConfigSchema.cached.toml"));
+    EXPECT_TRUE(detail::equal(warm.main(), cold.main()));
+    EXPECT_EQ(warm->unset, 3);
+}
+
+TEST_F(configTest, mapped_views_read_fields_in_place) {
+    using namespace fourdst::config;
+    static_assert(is_viewable_v<RichConfigSchema>);
+    RichConfigSchema content;
+    content.unset = 3;
+    ConfigView<RichConfigSchema>::write(content, "RichConfigSchema.view");
+
+    const auto view = ConfigView<RichConfigSchema>::open("RichConfigSchema.view");
+    EXPECT_EQ(view.get<"title">(), content.title);
+    EXPECT_EQ(view.get<"solver">(), Solver::IMPLICIT);
+    EXPECT_EQ(view.get<"huge">(), 1e300);
+    EXPECT_EQ(view.get<"unset">(), std::optional<int>(3));
+    EXPECT_EQ(view.get<"output.directory">(), "./output");
+
+    const auto grid = view.get<"grid">();
+    ASSERT_EQ(grid.size(), 2u);
+    const std::span<const double> row = grid[0];
+    EXPECT_EQ(std::vector<double>(row.begin(), row.end()), content.grid[0]);
+
+    const auto species = view.get<"species">();
+    ASSERT_EQ(species.size(), 2u);
+    EXPECT_EQ(species[1].get<"name">(), "He");
+    EXPECT_EQ(species[1].get<"charges">().size(), 3u);
+    EXPECT_TRUE(view.get<"no_species">().empty());
+
+    const auto abundances = view.get<"abundances">();
+    EXPECT_EQ(abundances.find("He-4"), std::optional<double>(0.28));
+    EXPECT_FALSE(abundances.contains("Li"));
+
+    ConfigView<TestConfigSchema>::write(TestConfigSchema{}, "TestConfigSchema.view");
+    EXPECT_THROW(static_cast<void>(ConfigView<RichConfigSchema>::open("TestConfigSchema.view")), exceptions::ConfigLoadError);
+    EXPECT_THROW(static_cast<void>(ConfigView<RichConfigSchema>::open("missing.view")), exceptions::ConfigLoadError);
+}
+
+TEST_F(configTest, binary_cache_is_keyed_by_source) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> writer;
+    EXPECT_NO_THROW(writer.load(get_good_example_file()));
+    writer.save("TestConfigSchema.cached.toml");
+
+    // A cache entry for the current source bytes is trusted, even if it holds different content.
+    std::ifstream ifs("TestConfigSchema.cached.toml", std::ios::binary);
+    const std::string source((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    TestConfigSchema cached = writer.main();
+    cached.author = "From Cache";
+    io::write_cache("TestConfigSchema.cached.toml.cache", io::hash_bytes(source), "main", true, cached);
+
+    Config<TestConfigSchema> hit;
+    hit.set_cache_policy(CachePolicy::READ_ONLY);
+    EXPECT_NO_THROW(hit.load("TestConfigSchema.cached.toml"));
+    EXPECT_EQ(hit->author, "From Cache");
+
+    // Editing the source invalidates the cache.
+    writer.mutate([](auto& data) { data.author = "Edited"; });
+    writer.save("TestConfigSchema.cached.toml");
+    Config<TestConfigSchema> stale;
+    stale.set_cache_policy(CachePolicy::READ_WRITE);
+    EXPECT_NO_THROW(stale.load("TestConfigSchema.cached.toml"));
+    EXPECT_EQ(stale->author, "Edited");
+
+    // A corrupt cache is ignored.
+    std::filesystem::resize_file("TestConfigSchema.cached.toml.cache", 20);
+    Config<TestConfigSchema> corrupt;
+    corrupt.set_cache_policy(CachePolicy::READ_ONLY);
+    EXPECT_NO_THROW(corrupt.load("TestConfigSchema.cached.toml"));
+    EXPECT_EQ(corrupt->author, "Edited");
+}
+
+TEST_F(configTest, hash_bytes_accepts_empty_views) {
+    using namespace fourdst::config;
+    // A default-constructed view has a null data(); run under -Db_sanitize=undefined to catch a memcpy from it.
+    EXPECT_EQ(io::hash_bytes(std::string_view{}), io::hash_bytes(""));
+    EXPECT_NE(io::hash_bytes(std::string_view{}, 1), io::hash_bytes(std::string_view{}));
+    EXPECT_NE(io::hash_bytes("abcdefgh"), io::hash_bytes(std::string_view("abcdefgh\0", 9)));
+}
+
+#if FOURDST_CONFIG_HAS_LOAD_DAEMON
+TEST_F(configTest, load_daemon_shares_parsed_decks_between_loads) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> writer;
+    EXPECT_NO_THROW(writer.load(get_good_example_file()));
+    writer.save("TestConfigSchema.daemon.toml");
+
+    ConfigDaemon daemon({.socket = "TestConfigSchema.daemon.sock"});
+    Config<TestConfigSchema> first;
+    first.set_load_daemon(daemon.socket());
+    EXPECT_NO_THROW(first.load("TestConfigSchema.daemon.toml"));
+    EXPECT_EQ(daemon.stats().misses, 1u);
+    EXPECT_EQ(daemon.stats().stores, 1u);
+
+    // Another job loading the same bytes maps the entry instead of parsing.
+    Config<TestConfigSchema> second;
+    second.set_load_daemon(daemon.socket());
+    EXPECT_NO_THROW(second.load("TestConfigSchema.daemon.toml"));
+    EXPECT_EQ(daemon.stats().hits, 1u);
+    EXPECT_TRUE(detail::equal(second.main(), first.main()));
+
+    // Editing the deck changes the key; other schemas never share an entry.
+    writer.mutate([](auto& data) { data.author = "Edited"; });
+    writer.save("TestConfigSchema.daemon.toml");
+    Config<TestConfigSchema> edited;
+    edited.set_load_daemon(daemon.socket());
+    EXPECT_NO_THROW(edited.load("TestConfigSchema.daemon.toml"));
+    EXPECT_EQ(edited->author, "Edited");
+    EXPECT_EQ(daemon.stats().entries, 2u);
+    EXPECT_NE(io::daemon_key("TestConfigSchema.daemon.toml", io::content_fingerprint<TestConfigSchema>(), 1),
+              io::daemon_key("TestConfigSchema.daemon.toml", io::content_fingerprint<RichConfigSchema>(), 1));
+
+    // Without a daemon, loads parse as usual.
+    Config<TestConfigSchema> alone;
+    alone.set_load_daemon("TestConfigSchema.missing.sock");
+    EXPECT_NO_THROW(alone.load("TestConfigSchema.daemon.toml"));
+    EXPECT_EQ(alone->author, "Edited");
+
+    // The least recently used entries are dropped beyond the budget.
+    ConfigDaemon small({.socket = "TestConfigSchema.small.sock", .max_bytes = 64});
+    const io::DaemonClient client(small.socket());
+    EXPECT_TRUE(client.store("a", std::string(40, 'a')));
+    EXPECT_TRUE(client.store("b", std::string(40, 'b')));
+    EXPECT_FALSE(client.store("c", std::string(100, 'c')));
+    EXPECT_FALSE(client.fetch("a", [](std::string_view) { return true; }));
+    std::string fetched;
+    EXPECT_TRUE(client.fetch("b", [&](const std::string_view bytes) {
+        fetched = bytes;
+        return true;
+    }));
+    EXPECT_EQ(fetched, std::string(40, 'b'));
+    EXPECT_EQ(small.stats().evictions, 1u);
+
+    // Clients get a descriptor they can map only for reading, so no job can corrupt an entry.
+    const int connection = io::detail::connect_daemon(small.socket(), std::chrono::milliseconds(1000));
+    ASSERT_GE(connection, 0);
+    ASSERT_TRUE(io::detail::send_request(connection, io::detail::daemon_get, "b"));
+    std::uint8_t found = 0;
+    int entry = -1;
+    std::uint64_t size = 0;
+    ASSERT_TRUE(io::detail::receive_status(connection, found, entry));
+    ASSERT_EQ(found, 1u);
+    ASSERT_GE(entry, 0);
+    ASSERT_TRUE(io::detail::receive_all(connection, &size, sizeof(size)));
+    EXPECT_EQ(::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, entry, 0), MAP_FAILED);
+    void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, entry, 0);
+    ASSERT_NE(mapped, MAP_FAILED);
+    EXPECT_EQ(std::string_view(static_cast<const char*>(mapped), size), std::string(40, 'b'));
+    ::munmap(mapped, size);
+    ::close(entry);
+    ::close(connection);
+}
+#endif
+
+TEST_F(configTest, json_round_trip) {
+    using namespace fourdst::config;
+    Config<RichConfigSchema> writer;
+    writer.set_root_name("deck");
+    writer.mutate([](auto& data) { data.output->directory = "/scratch/run 1"; });
+    EXPECT_NO_THROW(writer.save("RichConfigSchema.JSON"));
+
+    std::ifstream ifs("RichConfigSchema.JSON");
+    const std::string saved((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    EXPECT_TRUE(saved.starts_with("{\"deck\":{"));
+
+    Config<RichConfigSchema> reader;
+    reader.set_root_name_load_policy(RootNameLoadPolicy::FROM_FILE);
+    EXPECT_NO_THROW(reader.load("RichConfigSchema.JSON"));
+    EXPECT_EQ(reader.get_root_name(), "deck");
+    EXPECT_TRUE(detail::equal(reader.main(), writer.main()));
+
+    Config<RichConfigSchema> mismatched;
+    EXPECT_THROW(mismatched.load("RichConfigSchema.JSON"), exceptions::ConfigLoadError);
+}
+
+TEST_F(configTest, file_format_overrides_extension) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> writer;
+    EXPECT_NO_THROW(writer.load(get_good_example_file()));
+    writer.set_file_format(FileFormat::JSON);
+    EXPECT_EQ(writer.describe_file_format(), "JSON");
+    writer.save("TestConfigSchema.deck");
+
+    Config<TestConfigSchema> as_toml;
+    EXPECT_THROW(as_toml.load("TestConfigSchema.deck"), exceptions::ConfigParseError);
+
+    Config<TestConfigSchema> as_json;
+    as_json.set_file_format(FileFormat::JSON);
+    as_json.set_cache_policy(CachePolicy::READ_WRITE);
+    EXPECT_NO_THROW(as_json.load("TestConfigSchema.deck"));
+    EXPECT_TRUE(detail::equal(as_json.main(), writer.main()));
+
+    Config<TestConfigSchema> cached;
+    cached.set_file_format(FileFormat::JSON);
+    cached.set_cache_policy(CachePolicy::READ_ONLY);
+    EXPECT_NO_THROW(cached.load("TestConfigSchema.deck"));
+    EXPECT_TRUE(detail::equal(cached.main(), writer.main()));
+}
+
+struct InlistStarJob {
+    bool create_pre_main_sequence_model = false;
+    std::string new_net_name;
+};
+
+struct InlistMixing {
+    double alpha = 2.0;
+};
+
+struct InlistControls {
+    double initial_mass = 1.0;
+    double initial_z = 0.02;
+    int max_model_number = -1;
+    std::vector<double> x_ctrl;
+    std::vector<int> photo_steps;
+    InlistMixing mixing;
+};
+
+struct InlistSchema {
+    InlistStarJob star_job;
+    InlistControls controls;
+};
+
+TEST_F(configTest, namelist_groups_fill_the_schema) {
+    using namespace fourdst::config;
+    {
+        std::ofstream ofs("inlist_project");
+        ofs << R"(Text before the first group is ignored.
+&star_job
+    create_pre_main_sequence_model = .TRUE.
+    new_net_name = 'pp_and_cno_extras.net'  ! a comment
+/ ! end of star_job
+
+&CONTROLS
+    Initial_Mass = 15, initial_z = 2d-2
+    max_model_number = 500
+    x_ctrl(1) = 0.5, x_ctrl(2:4) = 3*1.0d0
+    photo_steps = 50
+    mixing%alpha = 1.8
+/
+)";
+    }
+    Config<InlistSchema> cfg;
+    EXPECT_NO_THROW(cfg.load("inlist_project"));
+    EXPECT_TRUE(cfg->star_job.create_pre_main_sequence_model);
+    EXPECT_EQ(cfg->star_job.new_net_name, "pp_and_cno_extras.net");
+    EXPECT_EQ(cfg->controls.initial_mass, 15.0);
+    EXPECT_EQ(cfg->controls.initial_z, 0.02);
+    EXPECT_EQ(cfg->controls.max_model_number, 500);
+    EXPECT_EQ(cfg->controls.x_ctrl, (std::vector<double>{0.5, 1.0, 1.0, 1.0}));
+    EXPECT_EQ(cfg->controls.photo_steps, (std::vector<int>{50}));
+    EXPECT_EQ(cfg->controls.mixing.alpha, 1.8);
+    EXPECT_THROW(cfg.save("inlist_project"), exceptions::ConfigSaveError);
+
+    try {
+        cfg.load_from("&star_job\n  new_net_name = 'basic.net'\n/\n&controls\n  initial_mass = 1\n/\n");
+        FAIL() << "expected a ConfigParseError";
+    } catch (const exceptions::ConfigParseError& e) {
+        EXPECT_NE(std::string(e.what()).find("create_pre_main_sequence_model"), std::string::npos);
+    }
+    EXPECT_EQ(cfg->controls.initial_mass, 15.0);
+
+    cfg.set_missing_field_policy(MissingFieldPolicy::USE_DEFAULTS);
+    EXPECT_TRUE(cfg.load_from("&controls\n  initial_mass = 1\n/\n"));
+    EXPECT_EQ(cfg->controls.initial_mass, 1.0);
+    EXPECT_EQ(cfg->controls.mixing.alpha, 2.0);
+
+    try {
+        cfg.load_from("&controls\n  initial_mass = 1\n  x_ctrl(3) = 2.0\n/\n");
+        FAIL() << "expected a ConfigParseError";
+    } catch (const exceptions::ConfigParseError& e) {
+        ASSERT_TRUE(e.location().has_value());
+        EXPECT_EQ(e.location()->line, 3u);
+    }
+}
+
+TEST_F(configTest, get_and_set_by_path) {
+    using namespace fourdst::config;
+    static_assert(detail::PathTable<TestConfigSchema>::find("simulation.time_step") != detail::PathTable<TestConfigSchema>::npos);
+    static_assert(detail::PathTable<TestConfigSchema>::find("simulation.nope") == detail::PathTable<TestConfigSchema>::npos);
+    static_assert(detail::PathTable<RichConfigSchema>::find("output") != detail::PathTable<RichConfigSchema>::npos);
+    static_assert(detail::PathTable<RichConfigSchema>::find("output.directory") == detail::PathTable<RichConfigSchema>::npos);
+
+    Config<TestConfigSchema> cfg;
+    EXPECT_NO_THROW(cfg.load(get_good_example_file()));
+    EXPECT_EQ(cfg.get<double>("simulation.time_step"), cfg->simulation.time_step);
+    EXPECT_EQ(cfg.get<std::string>("output.directory"), cfg->output.directory);
+
+    int notified = 0;
+    cfg.subscribe("simulation", [&](const auto&) { ++notified; });
+    cfg.set("simulation.time_step", 0.25);
+    cfg.set("output.directory", "/scratch/run");
+    EXPECT_EQ(cfg->simulation.time_step, 0.25);
+    EXPECT_EQ(cfg->output.directory, "/scratch/run");
+    EXPECT_EQ(cfg.get<double>("simulation.time_step"), 0.25);
+    EXPECT_EQ(notified, 1);
+    EXPECT_EQ(cfg.get_state(), ConfigState::MODIFIED);
+
+    EXPECT_THROW((void)cfg.get<double>("simulation.nope"), exceptions::ConfigPathError);
+    EXPECT_THROW((void)cfg.get<int>("simulation.time_step"), exceptions::ConfigPathError);
+    EXPECT_THROW(cfg.set("simulation", 1), exceptions::ConfigPathError);
+}
+
+TEST_F(configTest, path_table_describes_every_field_for_flat_iteration) {
+    using namespace fourdst::config;
+    using Table = detail::PathTable<TestConfigSchema>;
+    constexpr std::size_t physics = Table::find("physics");
+    static_assert(!Table::entry(physics).leaf && Table::entry(physics).depth == 0);
+    static_assert(Table::entry(physics).end == Table::find("simulation"));
+    static_assert(Table::entry(Table::find("physics.convection")).optional && Table::entry(Table::find("physics.convection")).leaf);
+    static_assert(Table::entry(Table::find("physics.flags")).depth == 1);
+    static_assert(Table::entry(Table::find("physics.flags")).size == sizeof(std::array<int, 3>));
+    static_assert(Table::name(Table::find("output.format")) == "format");
+
+    const TestConfigSchema lhs{};
+    TestConfigSchema rhs = lhs;
+    rhs.output.format = "csv";
+    const auto& same = Table::functions<bool(const void*, const void*), detail::FieldEqual>();
+    std::vector<std::string_view> differing;
+    for (std::size_t i = 0; i < Table::size(); ++i) {
+        if (!same[i](Table::entry(i).address(lhs), Table::entry(i).address(rhs))) differing.push_back(Table::path(i));
+    }
+    EXPECT_EQ(differing, (std::vector<std::string_view>{"output", "output.format"}));
+
+    const auto changes = diff(lhs, rhs);
+    ASSERT_EQ(changes.size(), 1u);
+    EXPECT_EQ(changes[0].path, "output.format");
+
+    // Sums of nested fields match the recursive report this table replaced.
+    rhs.description = std::string(100, 'x');
+    const MemoryReport report = memory_report(rhs, "main");
+    ASSERT_EQ(report.entries.size(), Table::size());
+    EXPECT_EQ(report.entries[physics].usage.inline_bytes, sizeof(PhysicsConfigOptions));
+    EXPECT_EQ(report.find("output")->heap_bytes, report.find("output.directory")->heap_bytes +
+                                                     report.find("output.format")->heap_bytes +
+                                                     report.find("output.save_plots")->heap_bytes);
+    EXPECT_GE(report.total.heap_bytes, 101u);
+    EXPECT_EQ(report.total.inline_bytes, sizeof(TestConfigSchema));
+}
+
+TEST_F(configTest, section_views_share_the_parent_snapshots) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    EXPECT_NO_THROW(cfg.load(get_good_example_file()));
+    ConfigRef<SimulationConfigOptions> simulation = cfg.view<&TestConfigSchema::simulation>();
+    auto output = cfg.reader().view<&TestConfigSchema::output>();
+    EXPECT_EQ(simulation->time_step, cfg->simulation.time_step);
+    EXPECT_EQ(simulation.snapshot().get(), &cfg.snapshot()->simulation);
+    EXPECT_EQ(output->directory, cfg->output.directory);
+
+    const std::shared_ptr<const SimulationConfigOptions> held = simulation.snapshot();
+    const double before = held->time_step;
+    const std::uint64_t generation = simulation.generation();
+    cfg.set("simulation.time_step", before + 0.5);
+    cfg.set("output.directory", "/scratch/run");
+    EXPECT_EQ(simulation->time_step, before + 0.5);
+    EXPECT_EQ((*output).directory, "/scratch/run");
+    EXPECT_GT(simulation.generation(), generation);
+    EXPECT_EQ(held->time_step, before);
+
+    cfg.reset();
+    EXPECT_EQ(simulation->time_step, SimulationConfigOptions{}.time_step);
+}
+
+TEST_F(configTest, compile_time_paths_resolve_to_member_references) {
+    using namespace fourdst::config;
+    static_assert(detail::find_field<TestConfigSchema>("simulation.time_step").count == 1);
+    static_assert(detail::find_field<TestConfigSchema>("simulation.nope").count == 0);
+
+    Config<TestConfigSchema> cfg;
+    EXPECT_NO_THROW(cfg.load(get_good_example_file()));
+    static_assert(std::is_same_v<decltype(cfg.get<"physics.diffusion">()), const bool&>);
+    static_assert(std::is_same_v<decltype(cfg.get<"simulation">()), const SimulationConfigOptions&>);
+    EXPECT_EQ(&cfg.get<"simulation.time_step">(), &cfg->simulation.time_step);
+    EXPECT_EQ(&cfg.get<"output.directory">(), &cfg->output.directory);
+    EXPECT_EQ(cfg.get<"physics.flags">(), cfg->physics.flags);
+    EXPECT_EQ(&cfg.get<"simulation">(), &cfg->simulation);
+
+    cfg.set("simulation.output_frequency", 7);
+    EXPECT_EQ(cfg.get<"simulation.output_frequency">(), 7);
+}
+
+TEST_F(configTest, validator_reports_nested_paths) {
+    using namespace fourdst::config;
+    toml::table tbl = toml::parse(R"(
+[main]
+title = "t"
+
+[[main.species]]
+name = "H"
+mass = 1.008
+charges = [0, 1]
+
+[[main.species]]
+name = "He"
+)");
+    std::vector<std::string> missing;
+    validate::ConfigValidator<RichConfigSchema>::check(tbl.get("main")->as_table(), "main", missing);
+    EXPECT_NE(std::ranges::find(missing, "main.species[1].mass"), missing.end());
+    EXPECT_NE(std::ranges::find(missing, "main.species[1].charges"), missing.end());
+    EXPECT_EQ(std::ranges::find(missing, "main.species[0].mass"), missing.end());
+    EXPECT_NE(std::ranges::find(missing, "main.solver"), missing.end());
+    EXPECT_EQ(std::ranges::find(missing, "main.output"), missing.end());
+}
+
+TEST_F(configTest, validator_reports_all_problems) {
+    using namespace fourdst::config;
+    toml::table tbl = toml::parse(R"(
+[main]
+title = 3
+solver = "SEMI_IMPLICIT"
+autor = "typo"
+
+[main.output]
+directory = "/tmp"
+format = "hdf5"
+
+[[main.species]]
+name = "H"
+mass = "light"
+charges = [0, 1.5]
+)");
+    std::vector<validate::ValidationIssue> issues;
+    validate::ConfigValidator<RichConfigSchema>::validate(tbl.get("main")->as_table(), "main", issues);
+
+    const auto has = [&](validate::IssueKind kind, std::string_view path) {
+        return std::ranges::any_of(issues, [&](const auto& issue) { return issue.kind == kind && issue.path == path; });
+    };
+    EXPECT_TRUE(has(validate::IssueKind::TYPE_MISMATCH, "main.title"));
+    EXPECT_TRUE(has(validate::IssueKind::TYPE_MISMATCH, "main.solver"));
+    EXPECT_TRUE(has(validate::IssueKind::UNKNOWN_KEY, "main.autor"));
+    EXPECT_TRUE(has(validate::IssueKind::TYPE_MISMATCH, "main.species[0].mass"));
+    EXPECT_TRUE(has(validate::IssueKind::TYPE_MISMATCH, "main.species[0].charges[1]"));
+    EXPECT_FALSE(has(validate::IssueKind::TYPE_MISMATCH, "main.species[0].charges[0]"));
+
+    Config<TestConfigSchema> cfg;
+    try {
+        cfg.load(get_bad_example_file(BAD_FILES::INCORRECT_ARRAY_SIZE));
+        FAIL() << "expected ConfigParseError";
+    } catch (const exceptions::ConfigParseError& e) {
+        EXPECT_NE(std::string_view(e.what()).find("main.physics.flags: expected 3 elements, found 4"), std::string_view::npos) << e.what();
+    }
+    try {
+        cfg.load(get_bad_example_file(BAD_FILES::UNKNOWN_KEY));
+        FAIL() << "expected ConfigParseError";
+    } catch (const exceptions::ConfigParseError& e) {
+        EXPECT_NE(std::string_view(e.what()).find("main.autor: unknown key"), std::string_view::npos) << e.what();
+        EXPECT_NE(std::string_view(e.what()).find("main.author: missing required field"), std::string_view::npos) << e.what();
+    }
+}
+
+TEST_F(configTest, parallel_validation_matches_serial) {
+    using namespace fourdst::config;
+    std::string text = "[main]\ntitle = \"t\"\n";
+    for (int i = 0; i < 1000; ++i) {
+        text += i % 7 == 0 ? "\n[[main.species]]\nname = \"X\"\n"
+                           : "\n[[main.species]]\nname = \"H\"\nmass = 1.0\ncharges = [0]\n";
+    }
+    toml::table tbl = toml::parse(text);
+
+    std::vector<validate::ValidationIssue> serial;
+    validate::ConfigValidator<RichConfigSchema>::validate(tbl.get("main")->as_table(), "main", serial,
+                                                          {.parallel_threshold = 1u << 30});
+    std::vector<validate::ValidationIssue> parallel;
+    validate::ConfigValidator<RichConfigSchema>::validate(tbl.get("main")->as_table(), "main", parallel,
+                                                          {.parallel_threshold = 16, .max_threads = 4});
+
+    ASSERT_EQ(serial.size(), parallel.size());
+    for (std::size_t i = 0; i < serial.size(); ++i) {
+        EXPECT_EQ(serial[i].path, parallel[i].path);
+    }
+    EXPECT_EQ(std::ranges::count(parallel, std::string("main.species[994].mass"), &validate::ValidationIssue::path), 1);
+}
+
+namespace {
+    /// Minimal stand-in for CLI::App: records option callbacks and invokes them on "parse".
+    struct FakeCliApp {
+        std::map<std::string, std::function<void(const std::string&)>> options;
+
+        template <typename Arg>
+        int add_option_function(const std::string& name, std::function<void(const Arg&)> func, const std::string&) {
+            options[name] = [func](const std::string& text) {
+                if constexpr (std::is_same_v<Arg, std::string>) {
+                    func(text);
+                } else if constexpr (std::is_same_v<Arg, bool>) {
+                    func(text == "true");
+                } else if constexpr (std::is_arithmetic_v<Arg>) {
+                    func(static_cast<Arg>(std::stod(text)));
+                }
+            };
+            return 0;
+        }
+        void footer(const std::string&) {}
+
+        std::map<std::string, std::unique_ptr<FakeCliApp>> subcommands;
+        std::function<void(std::size_t)> preparse;
+
+        FakeCliApp* add_subcommand(const std::string& name, const std::string&) {
+            return (subcommands[name] = std::make_unique<FakeCliApp>()).get();
+        }
+        void preparse_callback(std::function<void(std::size_t)> callback) { preparse = std::move(callback); }
+        /// Stands in for naming the subcommand on the command line.
+        FakeCliApp& use(const std::string& name) {
+            FakeCliApp& sub = *subcommands.at(name);
+            if (sub.preparse) sub.preparse(0);
+            return sub;
+        }
+    };
+}
+
+TEST_F(configTest, cli_options_apply_through_config) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    FakeCliApp app;
+    register_as_cli(cfg, app, "cfg");
+    ASSERT_TRUE(app.options.contains("--cfg.simulation.time_step"));
+    ASSERT_TRUE(app.options.contains("--cfg.physics.flags"));
+    ASSERT_TRUE(app.options.contains("--cfg.physics.convection"));
+
+    int notified = 0;
+    cfg.subscribe("simulation.time_step", [&](const auto&) { ++notified; });
+    app.options.at("--cfg.simulation.time_step")("0.125");
+    app.options.at("--cfg.physics.convection")("true");
+    app.options.at("--cfg.output.directory")("/scratch");
+
+    EXPECT_EQ(cfg->simulation.time_step, 0.125);
+    EXPECT_EQ(cfg.snapshot()->simulation.time_step, 0.125);
+    EXPECT_EQ(cfg->physics.convection, std::optional<bool>(true));
+    EXPECT_EQ(cfg->output.directory, "/scratch");
+    EXPECT_EQ(notified, 1);
+
+    // Option names and help texts without a prefix come from a table built at compile time.
+    static_assert(detail::CliNames<TestConfigSchema>::option(0) == "--description");
+    static_assert(detail::CliNames<TestConfigSchema>::description(3) == "Configuration option for physics.diffusion");
+
+    Config<RichConfigSchema> rich;
+    FakeCliApp rich_app;
+    register_as_cli(rich, rich_app);
+    EXPECT_TRUE(rich_app.options.contains("--solver"));
+    EXPECT_FALSE(rich_app.options.contains("--species"));
+    EXPECT_THROW(rich_app.options.at("--solver")("SIDEWAYS"), exceptions::ConfigParseError);
+    rich_app.options.at("--solver")("EXPLICIT");
+    EXPECT_EQ(rich->solver, Solver::EXPLICIT);
+}
+
+TEST_F(configTest, cli_subcommands_register_their_options_on_first_use) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    FakeCliApp app;
+    register_as_cli(cfg, app, CliLayout::SUBCOMMANDS);
+    EXPECT_TRUE(app.options.contains("--author"));
+    EXPECT_FALSE(app.options.contains("--simulation.time_step"));
+    ASSERT_TRUE(app.subcommands.contains("simulation"));
+    EXPECT_TRUE(app.subcommands.at("simulation")->options.empty());
+    EXPECT_TRUE(app.subcommands.at("output")->options.empty());
+
+    FakeCliApp& simulation = app.use("simulation");
+    ASSERT_TRUE(simulation.options.contains("--time_step"));
+    simulation.options.at("--time_step")("0.25");
+    EXPECT_EQ(cfg->simulation.time_step, 0.25);
+    EXPECT_TRUE(app.subcommands.at("output")->options.empty());
+    // A second parse does not register the options again.
+    const std::size_t registered = simulation.options.size();
+    app.use("simulation");
+    EXPECT_EQ(simulation.options.size(), registered);
+
+    TestConfigSchema raw;
+    FakeCliApp raw_app;
+    register_as_cli(raw, raw_app, CliLayout::SUBCOMMANDS, "cfg");
+    EXPECT_TRUE(raw_app.options.empty());
+    raw_app.use("cfg").use("output").options.at("--directory")("/scratch");
+    EXPECT_EQ(raw.output.directory, "/scratch");
+}
+
+TEST_F(configTest, response_files_expand_before_parsing) {
+    using namespace fourdst::config;
+    {
+        std::ofstream outer("TestConfigSchema.outer.args");
+        outer << "--simulation.time_step 0.5\n--author 'Piped Author' @TestConfigSchema.inner.args\n";
+        std::ofstream inner("TestConfigSchema.inner.args");
+        inner << "--output.directory \"/scratch/run 1\"";
+    }
+    const char* argv[] = {"simulate", "@TestConfigSchema.outer.args", "--description", "@"};
+    const auto args = expand_response_files(4, argv);
+    EXPECT_EQ(args.args(), (std::vector<std::string>{"simulate", "--simulation.time_step", "0.5", "--author", "Piped Author",
+                                                     "--output.directory", "/scratch/run 1", "--description", "@"}));
+    EXPECT_EQ(args.argc(), 9);
+    EXPECT_STREQ(args.argv()[4], "Piped Author");
+    EXPECT_EQ(args.argv()[9], nullptr);
+
+    const char* missing[] = {"simulate", "@TestConfigSchema.missing.args"};
+    EXPECT_THROW((void)expand_response_files(2, missing), exceptions::ConfigLoadError);
+}
+
+TEST_F(configTest, load_reads_standard_input_for_dash) {
+    using namespace fourdst::config;
+    ASSERT_NE(std::freopen(get_good_example_file().c_str(), "rb", stdin), nullptr);
+    Config<TestConfigSchema> cfg;
+    cfg.load("-");
+    EXPECT_EQ(cfg->author, "Example Author");
+    EXPECT_EQ(cfg.get_source_path(), "-");
+    EXPECT_THROW(cfg.reload(), exceptions::ConfigLoadError);
+
+    Config<TestConfigSchema> writer;
+    writer.set("simulation.time_step", 0.125);
+    writer.set_file_format(FileFormat::JSON);
+    {
+        std::ofstream piped("TestConfigSchema.piped.json");
+        writer.save_to(piped);
+    }
+    ASSERT_NE(std::freopen("TestConfigSchema.piped.json", "rb", stdin), nullptr);
+    Config<TestConfigSchema> json;
+    json.load("-");
+    EXPECT_EQ(json->simulation.time_step, 0.125);
+    ASSERT_NE(std::freopen(get_good_example_file().c_str(), "rb", stdin), nullptr);
+    EXPECT_TRUE(json.reload("-"));
+    EXPECT_EQ(json->simulation.time_step, 0.01);
+}
+
+TEST_F(configTest, load_layers_merges_files_env_and_overrides) {
+    using namespace fourdst::config;
+    {
+        std::ofstream site("TestConfigSchema.site.toml");
+        site << "[main]\nauthor = \"Site\"\n\n[main.simulation]\ntime_step = 0.5\n\n[main.physics]\nflags = [4, 5, 6]\n";
+        std::ofstream run("TestConfigSchema.run.toml");
+        run << "[main.simulation]\ntotal_time = 42.0\n";
+    }
+    setenv("LAYERTEST_SIMULATION__OUTPUT_FREQUENCY", "7", 1);
+    setenv("LAYERTEST_OUTPUT__DIRECTORY", "from env", 1);
+
+    Config<TestConfigSchema> cfg;
+    cfg.set_env_prefix("LAYERTEST_");
+    cfg.set_override("description", "from cli");
+    EXPECT_NO_THROW(cfg.load_layers({get_good_example_file(), "TestConfigSchema.site.toml", "TestConfigSchema.run.toml"}));
+
+    EXPECT_EQ(cfg->author, "Site");
+    EXPECT_EQ(cfg->simulation.time_step, 0.5);
+    EXPECT_EQ(cfg->simulation.total_time, 42.0);
+    EXPECT_EQ(cfg->physics.flags, (std::array<int, 3>{4, 5, 6}));
+    EXPECT_EQ(cfg->simulation.output_frequency, 7);
+    EXPECT_EQ(cfg->output.directory, "from env");
+    EXPECT_EQ(cfg->description, "from cli");
+    EXPECT_EQ(cfg.get_source_path(), "TestConfigSchema.run.toml");
+
+    {
+        std::ofstream run("TestConfigSchema.run.toml");
+        run << "[main.simulation]\ntotal_time = 43.0\n";
+    }
+    EXPECT_TRUE(cfg.reload());
+    EXPECT_EQ(cfg->simulation.total_time, 43.0);
+    EXPECT_EQ(cfg->author, "Site");
+    EXPECT_EQ(cfg->description, "from cli");
+
+    unsetenv("LAYERTEST_SIMULATION__OUTPUT_FREQUENCY");
+    unsetenv("LAYERTEST_OUTPUT__DIRECTORY");
+}
+
+TEST_F(configTest, load_directory_merges_fragments_in_name_order) {
+    using namespace fourdst::config;
+    const std::filesystem::path dir = "TestConfigSchema.conf.d";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir / "nested");
+    std::filesystem::copy_file(get_good_example_file(), dir / "10-base.toml");
+    {
+        std::ofstream site(dir / "50-site.toml");
+        site << "[main]\nauthor = \"Site\"\n\n[main.simulation]\ntime_step = 0.5\n";
+        std::ofstream run(dir / "90-run.toml");
+        run << "[main]\nauthor = \"Run\"\n";
+        std::ofstream hidden(dir / ".99-editor.toml");
+        hidden << "[main]\nauthor = \"Hidden\"\n";
+        std::ofstream nested(dir / "nested" / "99-nested.toml");
+        nested << "[main]\nauthor = \"Nested\"\n";
+        std::ofstream notes(dir / "README");
+        notes << "not a fragment\n";
+    }
+
+    Config<TestConfigSchema> cfg;
+    ASSERT_NO_THROW(cfg.load_directory(dir.string()));
+    EXPECT_EQ(cfg->author, "Run");
+    EXPECT_EQ(cfg->simulation.time_step, 0.5);
+    EXPECT_EQ(cfg.get_source_path(), (dir / "90-run.toml").string());
+
+    EXPECT_FALSE(cfg.reload());
+    {
+        std::ofstream site(dir / "50-site.toml");
+        site << "[main.simulation]\ntime_step = 0.25\n";
+        std::ofstream local(dir / "95-local.toml");
+        local << "[main]\nauthor = \"Local\"\n";
+    }
+    EXPECT_TRUE(cfg.reload());
+    EXPECT_EQ(cfg->author, "Local");
+    EXPECT_EQ(cfg->simulation.time_step, 0.25);
+    EXPECT_EQ(cfg.get_source_path(), (dir / "95-local.toml").string());
+
+    std::filesystem::remove(dir / "95-local.toml");
+    EXPECT_TRUE(cfg.reload());
+    EXPECT_EQ(cfg->author, "Run");
+
+    Config<TestConfigSchema> empty;
+    EXPECT_THROW(empty.load_directory((dir / "nested" / "missing").string()), exceptions::ConfigLoadError);
+    std::filesystem::remove_all(dir);
+}
+
+TEST_F(configTest, environment_layer_applies_typed_values_on_every_load) {
+    using namespace fourdst::config;
+    static_assert(detail::EnvNames<TestConfigSchema>::find("SIMULATION__TIME_STEP") ==
+                  detail::PathTable<TestConfigSchema>::find("simulation.time_step"));
+    static_assert(detail::EnvNames<TestConfigSchema>::name(detail::PathTable<TestConfigSchema>::find("physics.flags")) == "PHYSICS__FLAGS");
+    static_assert(detail::EnvNames<TestConfigSchema>::find("simulation__time_step") == detail::EnvNames<TestConfigSchema>::npos);
+
+    setenv("ENVTEST_SIMULATION__TIME_STEP", "0.25", 1);
+    setenv("ENVTEST_PHYSICS__CONVECTION", "true", 1);
+    setenv("ENVTEST_PHYSICS__FLAGS", "[7, 8, 9]", 1);
+    setenv("ENVTEST_OUTPUT__FORMAT", "csv", 1);
+    setenv("ENVTEST_OUTPUT__NOPE", "ignored", 1);
+
+    Config<TestConfigSchema> cfg;
+    cfg.set_provenance_tracking(true);
+    cfg.set_env_prefix("ENVTEST_");
+    cfg.set_override("output.format", "from cli");
+    cfg.load(get_good_example_file());
+
+    EXPECT_EQ(cfg->simulation.time_step, 0.25);
+    EXPECT_EQ(cfg->physics.convection, std::optional<bool>(true));
+    EXPECT_EQ(cfg->physics.flags, (std::array<int, 3>{7, 8, 9}));
+    EXPECT_EQ(cfg->output.format, "from cli");
+    EXPECT_EQ(cfg.get_provenance("simulation.time_step").source, FieldSource::ENVIRONMENT);
+    EXPECT_EQ(cfg.get_provenance("physics.flags").source, FieldSource::ENVIRONMENT);
+    EXPECT_EQ(cfg.get_provenance("output.format").source, FieldSource::OVERRIDE);
+    EXPECT_EQ(cfg.get_provenance("simulation.total_time").source, FieldSource::FILE);
+
+    // The files did not change, but the environment did.
+    setenv("ENVTEST_SIMULATION__TIME_STEP", "0.5", 1);
+    EXPECT_TRUE(cfg.reload());
+    EXPECT_EQ(cfg->simulation.time_step, 0.5);
+
+    setenv("ENVTEST_SIMULATION__OUTPUT_FREQUENCY", "often", 1);
+    Config<TestConfigSchema> invalid;
+    invalid.set_env_prefix("ENVTEST_");
+    EXPECT_THROW(invalid.load(get_good_example_file()), exceptions::ConfigParseError);
+
+    unsetenv("ENVTEST_SIMULATION__TIME_STEP");
+    unsetenv("ENVTEST_PHYSICS__CONVECTION");
+    unsetenv("ENVTEST_PHYSICS__FLAGS");
+    unsetenv("ENVTEST_OUTPUT__FORMAT");
+    unsetenv("ENVTEST_OUTPUT__NOPE");
+    unsetenv("ENVTEST_SIMULATION__OUTPUT_FREQUENCY");
+}
+
+TEST_F(configTest, include_directive_merges_cached_fragments) {
+    using namespace fourdst::config;
+    std::filesystem::create_directories("fragments/common");
+    {
+        std::ofstream physics("fragments/common/physics.toml");
+        physics << "diffusion = true\nflags = [7, 8, 9]\n";
+        std::ofstream output("fragments/common/output.toml");
+        output << "__include = \"output_base.toml\"\nformat = \"csv\"\n";
+        std::ofstream output_base("fragments/common/output_base.toml");
+        output_base << "directory = \"/shared\"\nformat = \"hdf5\"\n";
+        std::ofstream run("fragments/run.toml");
+        run << "[main]\ndescription = \"run\"\nauthor = \"me\"\n\n"
+               "[main.physics]\n__include = [\"common/physics.toml\"]\ndiffusion = false\n\n"
+               "[main.simulation]\ntime_step = 1.0\ntotal_time = 2.0\noutput_frequency = 1\n\n"
+               "[main.output]\n__include = \"common/output.toml\"\n";
+    }
+
+    io::FragmentCache::instance().clear();
+    Config<TestConfigSchema> first;
+    EXPECT_NO_THROW(first.load("fragments/run.toml"));
+    EXPECT_FALSE(first->physics.diffusion);
+    EXPECT_EQ(first->physics.flags, (std::array<int, 3>{7, 8, 9}));
+    EXPECT_EQ(first->output.directory, "/shared");
+    EXPECT_EQ(first->output.format, "csv");
+    EXPECT_EQ(io::FragmentCache::instance().size(), 3u);
+
+    const auto cached = io::FragmentCache::instance().get("fragments/common/physics.toml");
+    Config<TestConfigSchema> second;
+    EXPECT_NO_THROW(second.load("fragments/run.toml"));
+    EXPECT_EQ(io::FragmentCache::instance().get("fragments/common/physics.toml"), cached);
+    EXPECT_TRUE(detail::equal(first.main(), second.main()));
+
+    {
+        std::ofstream loop("fragments/common/output_base.toml");
+        loop << "__include = \"output.toml\"\n";
+    }
+    std::filesystem::last_write_time("fragments/common/output_base.toml",
+                                     std::filesystem::last_write_time("fragments/common/output_base.toml") + std::chrono::seconds(1));
+    Config<TestConfigSchema> cyclic;
+    EXPECT_THROW(cyclic.load("fragments/run.toml"), exceptions::ConfigLoadError);
+}
+
+TEST_F(configTest, prefetch_stages_deck_and_fragments_and_redirects_loads) {
+    using namespace fourdst::config;
+    std::filesystem::create_directories("prefetch/common");
+    {
+        std::ofstream physics("prefetch/common/physics.toml");
+        physics << "diffusion = true\nflags = [4, 5, 6]\n";
+        std::ofstream run("prefetch/run.toml");
+        run << "[main]\ndescription = \"staged\"\nauthor = \"me\"\n\n"
+               "[main.physics]\n__include = \"common/physics.toml\"\n\n"
+               "[main.simulation]\ntime_step = 1.0\ntotal_time = 2.0\noutput_frequency = 1\n";
+    }
+    const std::vector<std::string> dependencies = io::deck_dependencies("prefetch/run.toml");
+    ASSERT_EQ(dependencies.size(), 2u);
+    EXPECT_TRUE(dependencies[1].ends_with("physics.toml"));
+
+    const std::filesystem::path stage = std::filesystem::temp_directory_path() / "fourdst_config_stage";
+    std::filesystem::remove_all(stage);
+    const PrefetchReport report = prefetch({.decks = {"prefetch/run.toml"}, .files = {}, .stage_directory = stage.string(), .parallelism = 2});
+    ASSERT_EQ(report.files.size(), 2u);
+    EXPECT_GT(report.bytes, 0u);
+    const std::string staged = report.files[0].staged;
+    EXPECT_TRUE(staged.starts_with(stage.string()));
+    EXPECT_TRUE(std::filesystem::exists(report.files[1].staged));
+    EXPECT_EQ(io::staged_path("prefetch/run.toml"), staged);
+
+    Config<TestConfigSchema> cfg;
+    cfg.load("prefetch/run.toml");
+    EXPECT_EQ(cfg.get_source_path(), staged);
+    EXPECT_EQ(cfg->description, "staged");
+    EXPECT_EQ(cfg->physics.flags, (std::array<int, 3>{4, 5, 6}));
+    EXPECT_FALSE(cfg.reload());
+
+    const PrefetchReport again = prefetch({.decks = {"prefetch/run.toml"}, .files = {}, .stage_directory = stage.string(), .parallelism = 0});
+    EXPECT_TRUE(std::ranges::all_of(again.files, [](const PrefetchedFile& file) { return file.reused; }));
+    EXPECT_EQ(again.bytes, 0u);
+    EXPECT_THROW(prefetch({.decks = {"prefetch/missing.toml"}, .files = {}, .stage_directory = {}, .parallelism = 0}), exceptions::ConfigLoadError);
+
+    io::StagedFiles::instance().clear();
+    EXPECT_EQ(io::staged_path("prefetch/run.toml"), "prefetch/run.toml");
+    std::filesystem::remove_all(stage);
+}
+
+TEST_F(configTest, provenance_tracks_each_layer) {
+    using namespace fourdst::config;
+    {
+        std::ofstream site("TestConfigSchema.prov.toml");
+        site << "[main]\nauthor = \"Site\"\n\n[main.simulation]\ntime_step = 0.5\n";
+    }
+    setenv("PROVTEST_SIMULATION__TOTAL_TIME", "3.0", 1);
+
+    Config<TestConfigSchema> cfg;
+    EXPECT_FALSE(cfg.get_provenance_tracking());
+    EXPECT_THROW((void)cfg.get_provenance("author"), exceptions::ConfigPathError);
+    cfg.set_provenance_tracking(true);
+    cfg.set_history_limit(4);
+    cfg.set_env_prefix("PROVTEST_");
+    cfg.set_override("description", "from cli");
+    cfg.load_layers({get_good_example_file(), "TestConfigSchema.prov.toml"});
+
+    EXPECT_EQ(cfg.get_provenance("simulation.output_frequency"), (FieldProvenance{FieldSource::FILE, 0}));
+    EXPECT_EQ(cfg.get_provenance("author"), (FieldProvenance{FieldSource::FILE, 1}));
+    EXPECT_EQ(cfg.get_provenance("simulation.time_step"), (FieldProvenance{FieldSource::FILE, 1}));
+    EXPECT_EQ(cfg.get_provenance("simulation.total_time").source, FieldSource::ENVIRONMENT);
+    EXPECT_EQ(cfg.get_provenance("description").source, FieldSource::OVERRIDE);
+    EXPECT_THROW((void)cfg.get_provenance("simulation"), exceptions::ConfigPathError);
+    EXPECT_THROW((void)cfg.get_provenance("simulation.nope"), exceptions::ConfigPathError);
+
+    cfg.mutate([](auto& data) { data.physics.diffusion = !data.physics.diffusion; });
+    EXPECT_EQ(cfg.get_provenance("physics.diffusion").source, FieldSource::MUTATE);
+    EXPECT_EQ(cfg.get_provenance("physics.flags").source, FieldSource::FILE);
+    EXPECT_TRUE(cfg.undo());
+    EXPECT_EQ(cfg.get_provenance("physics.diffusion").source, FieldSource::FILE);
+
+    cfg.set("output.format", "csv");
+    EXPECT_EQ(cfg.get_provenance("output.format").source, FieldSource::MUTATE);
+    cfg.reset();
+    EXPECT_EQ(cfg.get_provenance("output.format").source, FieldSource::FILE);
+
+    const std::string listing = cfg.describe_provenance();
+    EXPECT_NE(listing.find("author = file TestConfigSchema.prov.toml\n"), std::string::npos);
+    EXPECT_NE(listing.find("simulation.total_time = env PROVTEST_SIMULATION__TOTAL_TIME\n"), std::string::npos);
+    const std::string formatted = std::format("{:p}", cfg);
+    EXPECT_TRUE(formatted.starts_with(std::format("{}", cfg)));
+    EXPECT_NE(formatted.find("# description = override\n"), std::string::npos);
+
+    unsetenv("PROVTEST_SIMULATION__TOTAL_TIME");
+}
+
+TEST_F(configTest, diff_lists_changed_paths) {
+    using namespace fourdst::config;
+    RichConfigSchema before;
+    RichConfigSchema after = before;
+    EXPECT_TRUE(diff(before, after).empty());
+
+    after.species[1].charges.push_back(3);
+    after.output->directory = "/scratch";
+    after.tiny = -0.0 * before.tiny;
+    const auto changes = diff(before, after);
+    ASSERT_EQ(changes.size(), 3u);
+    EXPECT_EQ(changes[0].path, "tiny");
+    EXPECT_EQ(changes[1].path, "species");
+    EXPECT_EQ(changes[2].path, "output");
+    EXPECT_NE(changes[2].new_value.find("\"/scratch\""), std::string::npos);
+
+    Config<TestConfigSchema> lhs;
+    Config<TestConfigSchema> rhs;
+    rhs.set("simulation.time_step", 0.25);
+    rhs.set("physics.flags", std::array<int, 3>{1, 2, 3});
+    const auto config_changes = diff(lhs, rhs);
+    ASSERT_EQ(config_changes.size(), 2u);
+    EXPECT_EQ(config_changes[0].path, "physics.flags");
+    EXPECT_EQ(config_changes[0].new_value, "[1,2,3]");
+    EXPECT_EQ(config_changes[1].path, "simulation.time_step");
+    EXPECT_EQ(config_changes[1].old_value, rfl::json::write(TestConfigSchema{}.simulation.time_step));
+    EXPECT_EQ(config_changes[1].new_value, "0.25");
+
+    const std::vector<double> values{0.0, 1.5, 2.5};
+    std::vector<double> signed_zero = values;
+    signed_zero[0] = -0.0;
+    EXPECT_TRUE(detail::equal(values, signed_zero));
+    signed_zero[2] = 3.5;
+    EXPECT_FALSE(detail::equal(values, signed_zero));
+}
+
+TEST_F(configTest, apply_patch_updates_named_fields) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    cfg.set_history_limit(4);
+    std::atomic<int> notified{0};
+    cfg.subscribe("simulation", [&](const auto&) { ++notified; });
+
+    cfg.apply_patch("simulation.time_step = 0.25\n\n[output]\nformat = \"csv\"\n");
+    EXPECT_EQ(cfg->simulation.time_step, 0.25);
+    EXPECT_EQ(cfg->output.format, "csv");
+    EXPECT_EQ(cfg->output.directory, "./output");
+    EXPECT_EQ(notified, 1);
+    EXPECT_EQ(cfg.history_size(), 1u);
+
+    cfg.apply_patch("[main.physics]\nflags = [1, 2, 3]\n");
+    EXPECT_EQ(cfg->physics.flags, (std::array<int, 3>{1, 2, 3}));
+
+    cfg.apply_patch(R"({"simulation": {"output_frequency": 9}, "author": "controller"})");
+    EXPECT_EQ(cfg->simulation.output_frequency, 9);
+    EXPECT_EQ(cfg->author, "controller");
+    EXPECT_EQ(cfg.snapshot()->author, "controller");
+
+    EXPECT_THROW(cfg.apply_patch("simulation.time_step = 0.5\nsimulation.nope = 1\n"), exceptions::ConfigPathError);
+    EXPECT_THROW(cfg.apply_patch("simulation.time_step = \"fast\""), exceptions::ConfigParseError);
+    EXPECT_THROW(cfg.apply_patch("{\"simulation\": "), exceptions::ConfigParseError);
+    EXPECT_EQ(cfg->simulation.time_step, 0.25);
+}
+
+TEST_F(configTest, fingerprint_tracks_content_and_exclusions) {
+    using namespace fourdst::config;
+    Config<RichConfigSchema> lhs;
+    Config<RichConfigSchema> rhs;
+    rhs.set_history_limit(1);
+    const std::uint64_t initial = lhs.fingerprint();
+    EXPECT_EQ(initial, lhs.fingerprint());
+    EXPECT_EQ(initial, rhs.fingerprint());
+
+    rhs.mutate([](auto& data) { data.abundances["He-4"] = 0.3; });
+    EXPECT_NE(rhs.fingerprint(), initial);
+    EXPECT_TRUE(rhs.undo());
+    EXPECT_EQ(rhs.fingerprint(), initial);
+
+    rhs.mutate([](auto& data) { data.title = "run 2"; });
+    EXPECT_NE(rhs.fingerprint(), lhs.fingerprint());
+    rhs.set_fingerprint_exclusions({"title"});
+    lhs.set_fingerprint_exclusions({"title"});
+    EXPECT_EQ(rhs.fingerprint(), lhs.fingerprint());
+    EXPECT_THROW(rhs.set_fingerprint_exclusions({"output.directory"}), exceptions::ConfigPathError);
+
+    Config<TestConfigSchema> zero;
+    Config<TestConfigSchema> negative_zero;
+    zero.set("simulation.time_step", 0.0);
+    negative_zero.set("simulation.time_step", -0.0);
+    EXPECT_EQ(zero.fingerprint(), negative_zero.fingerprint());
+    negative_zero.set("output.directory", "/scratch");
+    EXPECT_NE(zero.fingerprint(), negative_zero.fingerprint());
+    negative_zero.set_fingerprint_exclusions({"output"});
+    zero.set_fingerprint_exclusions({"output.directory"});
+    EXPECT_NE(zero.fingerprint(), negative_zero.fingerprint());
+    negative_zero.set_fingerprint_exclusions({"output.directory"});
+    EXPECT_EQ(zero.fingerprint(), negative_zero.fingerprint());
+}
+
+struct RenamedSchema {
+    rfl::Rename<"time-step", double> time_step = 0.5;
+    std::string label = "renamed";
+};
+
+TEST_F(configTest, formatter_handles_non_streamable_schemas) {
+    using namespace fourdst::config;
+    static_assert(!io::is_streamable_v<RenamedSchema>);
+    Config<RenamedSchema> cfg;
+    const std::string formatted = std::format("{}", cfg);
+    EXPECT_NE(formatted.find("[main]"), std::string::npos);
+    EXPECT_NE(formatted.find("time-step = 0.5"), std::string::npos);
+    EXPECT_NE(formatted.find("label = \"renamed\""), std::string::npos);
+    EXPECT_THROW((void)std::vformat("{:x}", std::make_format_args(cfg)), std::format_error);
+}
+
+TEST_F(configTest, format_spec_selects_json_compact_and_subtrees) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    cfg.set("simulation.time_step", 0.25);
+
+    EXPECT_EQ(std::format("{:json}", cfg), std::format("{{\"main\":{}}}", rfl::json::write(cfg.main())));
+    EXPECT_EQ(std::format("{:json,simulation.time_step}", cfg), "{\"main\":{\"simulation\":{\"time_step\":0.25}}}");
+    EXPECT_EQ(std::format("{:simulation.time_step}", cfg), "main.simulation.time_step = 0.25\n");
+
+    const std::string section = std::format("{:simulation}", cfg);
+    EXPECT_TRUE(section.starts_with("[main.simulation]\ntime_step = 0.25\n"));
+    EXPECT_EQ(section.find("[main.output]"), std::string::npos);
+
+    const std::string compact = std::format("{:compact}", cfg);
+    EXPECT_TRUE(compact.starts_with("main = { "));
+    EXPECT_EQ(compact.find('\n'), compact.size() - 1);
+    EXPECT_TRUE(std::format("{:compact,output}", cfg).starts_with("main.output = { directory = \"./output\""));
+
+    // Subtree output is a valid patch.
+    Config<TestConfigSchema> other;
+    other.apply_patch(section);
+    EXPECT_EQ(other->simulation.time_step, 0.25);
+    other.apply_patch(std::format("{:json,output}", cfg));
+
+    EXPECT_THROW((void)std::vformat("{:physics.nope}", std::make_format_args(cfg)), std::format_error);
+    EXPECT_THROW((void)std::vformat("{:json,p}", std::make_format_args(cfg)), std::format_error);
+}
+
+struct SampledGrid {
+    std::vector<double> samples = {};
+    std::vector<std::int32_t> cells = {};
+    std::vector<double> bounds = {0.0, 1.0};
+};
+
+struct SidecarSchema {
+    std::string label = "grid";
+    SampledGrid grid;
+};
+
+TEST_F(configTest, sidecars_store_large_arrays) {
+    using namespace fourdst::config;
+    Config<SidecarSchema> writer;
+    writer.mutate([](SidecarSchema& c) {
+        for (int i = 0; i < 1000; ++i) c.grid.samples.push_back(i * 0.5);
+        c.grid.cells = {3, 1, 4, 1, 5};
+    });
+    writer.set_sidecar_threshold(4);
+    EXPECT_EQ(writer.get_sidecar_threshold(), 4);
+    writer.save("SidecarSchema.toml", SavePolicy::ATOMIC);
+
+    ASSERT_TRUE(std::filesystem::exists("SidecarSchema.toml.grid.samples.npy"));
+    ASSERT_TRUE(std::filesystem::exists("SidecarSchema.toml.grid.cells.npy"));
+    EXPECT_FALSE(std::filesystem::exists("SidecarSchema.toml.grid.bounds.npy"));
+    std::ifstream in("SidecarSchema.toml");
+    const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    EXPECT_NE(text.find("samples = { __sidecar = \"SidecarSchema.toml.grid.samples.npy\", length = 1000"), std::string::npos);
+    EXPECT_NE(text.find("bounds = [0.0, 1.0]"), std::string::npos);
+
+    Config<SidecarSchema> reader;
+    reader.load("SidecarSchema.toml");
+    EXPECT_EQ(reader->grid.samples, writer->grid.samples);
+    EXPECT_EQ(reader->grid.cells, writer->grid.cells);
+    EXPECT_EQ(reader->grid.bounds, writer->grid.bounds);
+
+    // A sidecar that no longer matches its reference is rejected.
+    Config<SidecarSchema> stale;
+    {
+        std::ofstream out("SidecarSchema.stale.toml");
+        std::string stale_text = text;
+        const std::size_t file = stale_text.find("SidecarSchema.toml.grid.cells.npy");
+        stale_text.replace(stale_text.find("checksum = \"", file) + 12, 4, "0000");
+        out << stale_text;
+    }
+    EXPECT_THROW(stale.load("SidecarSchema.stale.toml"), exceptions::ConfigParseError);
+}
+
+TEST_F(configTest, load_from_and_save_to_memory) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> writer;
+    writer.set("simulation.time_step", 0.125);
+    writer.set("output.directory", "/scratch/memory");
+
+    std::string blob;
+    writer.save_to(blob);
+    EXPECT_TRUE(blob.starts_with("[main]"));
+
+    Config<TestConfigSchema> reader;
+    EXPECT_TRUE(reader.load_from(blob));
+    EXPECT_TRUE(detail::equal(reader.main(), writer.main()));
+    EXPECT_EQ(reader.get_source_path(), "<memory>");
+    EXPECT_EQ(reader.get_state(), ConfigState::LOADED_FROM_FILE);
+    EXPECT_FALSE(reader.load_from(blob));
+    EXPECT_THROW(reader.reload(), exceptions::ConfigLoadError);
+
+    std::stringstream json;
+    writer.set_file_format(FileFormat::JSON);
+    writer.set("simulation.time_step", 0.5);
+    writer.save_to(json);
+    EXPECT_TRUE(reader.load_from(json));
+    EXPECT_EQ(reader->simulation.time_step, 0.5);
+
+    EXPECT_THROW(reader.load_from("[main]\nsimulation = 3\n"), exceptions::ConfigParseError);
+    EXPECT_EQ(reader->simulation.time_step, 0.5);
+}
+
+struct PmrGrid {
+    std::pmr::vector<double> samples{1.0, 2.0};
+};
+
+struct PmrSchema {
+    std::pmr::string label = "default";
+    std::pmr::vector<std::pmr::string> species{"H", "He"};
+    PmrGrid grid;
+};
+
+TEST_F(configTest, pmr_fields_load_into_the_memory_resource) {
+    using namespace fourdst::config;
+    Config<PmrSchema> writer;
+    writer.mutate([](PmrSchema& c) {
+        c.label = "a label that is long enough to allocate";
+        c.species.emplace_back("a species name that is long enough to allocate");
+        c.grid.samples.assign(64, 0.5);
+    });
+    writer.save("PmrSchema.toml");
+    std::string json;
+    writer.set_file_format(FileFormat::JSON);
+    writer.save_to(json);
+
+    std::pmr::monotonic_buffer_resource arena;
+    for (const std::string_view path : {std::string_view("PmrSchema.toml"), std::string_view{}}) {
+        Config<PmrSchema> reader;
+        reader.set_memory_resource(&arena);
+        EXPECT_EQ(reader.get_memory_resource(), &arena);
+        if (path.empty()) {
+            reader.load_from(json);
+        } else {
+            reader.load(path);
+        }
+        EXPECT_TRUE(detail::equal(reader.main(), writer.main()));
+        EXPECT_EQ(reader->label.get_allocator().resource(), &arena);
+        EXPECT_EQ(reader->species.get_allocator().resource(), &arena);
+        EXPECT_EQ(reader->species.back().get_allocator().resource(), &arena);
+        EXPECT_EQ(reader->grid.samples.get_allocator().resource(), &arena);
+        EXPECT_EQ(reader.fingerprint(), writer.fingerprint());
+    }
+    EXPECT_EQ(io::field_resource(), std::pmr::get_default_resource());
+}
+
+TEST_F(configTest, compaction_trims_content_and_moves_pmr_members_into_the_snapshot_arena) {
+    using namespace fourdst::config;
+    Config<PmrSchema> writer;
+    writer.mutate([](PmrSchema& c) {
+        c.label = "a label that is long enough to allocate";
+        for (int i = 0; i < 32; ++i) c.species.emplace_back(std::format("a species name long enough to allocate #{}", i));
+        c.grid.samples.assign(100, 0.5);
+    });
+    writer.save("PmrSchema.compact.toml");
+
+    Config<PmrSchema> cfg;
+    cfg.set_compaction(true);
+    EXPECT_TRUE(cfg.get_compaction());
+    cfg.load("PmrSchema.compact.toml");
+    EXPECT_EQ(cfg->species.capacity(), cfg->species.size());
+    EXPECT_EQ(cfg->grid.samples.capacity(), cfg->grid.samples.size());
+
+    const auto snapshot = cfg.snapshot();
+    EXPECT_TRUE(detail::equal(*snapshot, writer.main()));
+    // Every pmr member of the snapshot shares one resource, which is neither the default one nor the content's.
+    std::pmr::memory_resource* arena = snapshot->label.get_allocator().resource();
+    EXPECT_NE(arena, std::pmr::get_default_resource());
+    EXPECT_EQ(snapshot->species.get_allocator().resource(), arena);
+    for (const auto& name : snapshot->species) EXPECT_EQ(name.get_allocator().resource(), arena);
+    EXPECT_EQ(snapshot->grid.samples.get_allocator().resource(), arena);
+    EXPECT_EQ(cfg->label.get_allocator().resource(), std::pmr::get_default_resource());
+
+    cfg.mutate([](PmrSchema& c) { c.label = "another label that is long enough to allocate"; });
+    EXPECT_NE(cfg.snapshot()->label.get_allocator().resource(), arena);
+    EXPECT_EQ(snapshot->species.back(), writer->species.back());
+    std::filesystem::remove("PmrSchema.compact.toml");
+}
+
+TEST_F(configTest, residency_covers_every_buffer_of_published_snapshots) {
+    using namespace fourdst::config;
+    Config<PmrSchema> cfg;
+    EXPECT_EQ(cfg.get_residency(), Residency::DEFAULT);
+    cfg.set_residency(Residency::PREFAULT);
+    cfg.set_compaction(true);
+    cfg.mutate([](PmrSchema& c) {
+        c.label = "a label that is long enough to allocate";
+        for (int i = 0; i < 256; ++i) c.species.emplace_back(std::format("a species name long enough to allocate #{}", i));
+        c.grid.samples.assign(10000, 0.5);
+    });
+
+    const auto snapshot = cfg.snapshot();
+    const detail::PageRanges pages = detail::snapshot_pages(*snapshot);
+    EXPECT_TRUE(pages.contains(snapshot.get()));
+    EXPECT_TRUE(pages.contains(snapshot->label.data()));
+    EXPECT_TRUE(pages.contains(snapshot->species.front().data()));
+    EXPECT_TRUE(pages.contains(snapshot->species.back().data()));
+    EXPECT_TRUE(pages.contains(&snapshot->grid.samples.back()));
+    // The compacted members share one arena, so they merge into a few runs of pages.
+    EXPECT_LE(pages.size(), 3u);
+
+    try {
+        cfg.set_residency(Residency::LOCKED);
+    } catch (const exceptions::ConfigError&) {
+        GTEST_SKIP() << "RLIMIT_MEMLOCK is too low to lock snapshots";
+    }
+    EXPECT_EQ(cfg.get_residency(), Residency::LOCKED);
+    cfg.mutate([](PmrSchema& c) { c.label = "another label that is long enough to allocate"; });
+    const auto locked = cfg.snapshot();
+    EXPECT_EQ(locked->label, "another label that is long enough to allocate");
+    cfg.mutate([](PmrSchema& c) { c.grid.samples.assign(10, 1.0); });
+    EXPECT_EQ(locked->grid.samples.size(), 10000u);
+    EXPECT_EQ(cfg->grid.samples.size(), 10u);
+}
+
+struct AlignedSchema {
+    fourdst::config::AlignedVector<double> kappa;
+    fourdst::config::AlignedVector<double, 4096> eos;
+    std::vector<int> plain = {1, 2};
+};
+
+TEST_F(configTest, aligned_vectors_load_onto_cache_lines_and_huge_pages) {
+    using namespace fourdst::config;
+    const auto address = [](const void* pointer) { return reinterpret_cast<std::uintptr_t>(pointer); };
+    Config<AlignedSchema> writer;
+    writer.mutate([](AlignedSchema& c) {
+        c.kappa.assign(100, 0.25);
+        c.eos.assign(1000, 1.5);
+    });
+    std::string text;
+    writer.save_to(text);
+
+    Config<AlignedSchema> cfg;
+    cfg.load_from(text);
+    EXPECT_EQ(cfg->kappa, writer->kappa);
+    EXPECT_EQ(cfg->eos.size(), 1000u);
+    EXPECT_EQ(address(cfg->kappa.data()) % simd_alignment, 0u);
+    EXPECT_EQ(address(cfg.snapshot()->kappa.data()) % simd_alignment, 0u);
+    // 8000 bytes is past the 4096-byte threshold of this field, so it starts on a huge page.
+    EXPECT_EQ(address(cfg->eos.data()) % huge_page_bytes, 0u);
+
+    AlignedResource resource;
+    Config<PmrSchema> pmr;
+    pmr.set_memory_resource(&resource);
+    pmr.load_from("[main]\nlabel = \"x\"\nspecies = [\"H\"]\n[main.grid]\nsamples = [1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0]\n");
+    EXPECT_EQ(pmr->grid.samples.get_allocator().resource(), &resource);
+    EXPECT_EQ(address(pmr->grid.samples.data()) % simd_alignment, 0u);
+}
+
+struct StoredSchema {
+    std::vector<fourdst::config::Stored<float>> kappa{0.5f};
+    fourdst::config::Stored<std::int16_t, std::int64_t> level = 3;
+};
+
+TEST_F(configTest, stored_fields_read_doubles_and_hold_floats) {
+    using namespace fourdst::config;
+    static_assert(sizeof(Stored<float>) == sizeof(float) && std::is_trivially_copyable_v<Stored<float>>);
+    Config<StoredSchema> cfg;
+    cfg.load_from("[main]\nkappa = [0.1, 2.5, 3]\nlevel = 7\n");
+    ASSERT_EQ(cfg->kappa.size(), 3u);
+    EXPECT_EQ(cfg->kappa[0], 0.1f);
+    EXPECT_EQ(cfg->kappa[2], 3.0f);
+    EXPECT_EQ(cfg->level, 7);
+
+    std::string text;
+    cfg.save_to(text);
+    EXPECT_NE(text.find("0.1"), std::string::npos);
+    EXPECT_EQ(text.find("0.100000001"), std::string::npos);
+    Config<StoredSchema> copy;
+    copy.load_from(text);
+    EXPECT_TRUE(detail::equal(copy.main(), cfg.main()));
+
+    EXPECT_THROW(cfg.load_from("[main]\nkappa = [1e300]\n"), exceptions::ConfigParseError);
+    EXPECT_THROW(cfg.load_from("[main]\nlevel = 70000\n"), exceptions::ConfigParseError);
+    EXPECT_EQ(cfg->level, 7);
+
+    const std::string_view schema = Config<StoredSchema>::schema();
+    EXPECT_NE(schema.find("Read as float64, stored as float32."), std::string_view::npos);
+    EXPECT_NE(schema.find("Read as int64, stored as int16."), std::string_view::npos);
+}
+
+struct NewtonSolver {
+    double tolerance = 1e-8;
+    int max_iterations = 50;
+};
+
+struct PicardSolver {
+    double relaxation = 0.5;
+};
+
+struct SolverSchema {
+    rfl::TaggedUnion<"type", NewtonSolver, PicardSolver> solver = NewtonSolver{};
+};
+
+TEST_F(configTest, tagged_unions_read_the_alternative_their_tag_names) {
+    using namespace fourdst::config;
+    Config<SolverSchema> cfg;
+    cfg.load_from("[main.solver]\ntype = \"PicardSolver\"\nrelaxation = 0.3\n");
+    const auto* picard = rfl::get_if<PicardSolver>(&cfg->solver.variant());
+    ASSERT_NE(picard, nullptr);
+    EXPECT_DOUBLE_EQ(picard->relaxation, 0.3);
+
+    std::string text;
+    cfg.save_to(text);
+    EXPECT_NE(text.find("PicardSolver"), std::string::npos);
+    Config<SolverSchema> copy;
+    copy.load_from(text);
+    EXPECT_TRUE(detail::equal(copy.main(), cfg.main()));
+
+    EXPECT_THROW(cfg.load_from("[main.solver]\ntype = \"Jacobi\"\n"), exceptions::ConfigParseError);
+
+    toml::table tbl = toml::parse("[main.solver]\ntype = \"NewtonSolver\"\ntolerance = 1e-6\n");
+    std::vector<validate::ValidationIssue> issues;
+    validate::ConfigValidator<SolverSchema>::validate(tbl.get("main")->as_table(), "main", issues);
+    ASSERT_EQ(issues.size(), 1u);
+    EXPECT_EQ(issues[0].kind, validate::IssueKind::MISSING_FIELD);
+    EXPECT_EQ(issues[0].path, "main.solver.max_iterations");
+    EXPECT_NE(issues[0].message.find("type = \"NewtonSolver\""), std::string::npos);
+
+    const std::string_view schema = Config<SolverSchema>::schema();
+    EXPECT_NE(schema.find("relaxation"), std::string_view::npos);
+    EXPECT_NE(schema.find("max_iterations"), std::string_view::npos);
+}
+
+enum class ReactionChannel {
+    PP_I, PP_II, PP_III, CNO_I, CNO_II, CNO_III, TRIPLE_ALPHA, CARBON_ALPHA, OXYGEN_ALPHA, NEON_ALPHA,
+    CARBON_BURNING, OXYGEN_BURNING, SILICON_BURNING, ELECTRON_CAPTURE, PHOTODISINTEGRATION, URCA,
+};
+
+struct ChannelSchema {
+    ReactionChannel channel = ReactionChannel::PP_I;
+    rfl::Literal<"hydrogen", "helium", "carbon", "oxygen"> fuel = rfl::Literal<"hydrogen", "helium", "carbon", "oxygen">::make<"hydrogen">();
+};
+
+TEST_F(configTest, enum_and_literal_names_are_parsed_by_perfect_hash) {
+    using namespace fourdst::config;
+    using Fuel = decltype(ChannelSchema::fuel);
+
+    EXPECT_EQ(io::enum_from_string<ReactionChannel>("URCA").value(), ReactionChannel::URCA);
+    EXPECT_EQ(io::enum_from_string<ReactionChannel>("PP_I").value(), ReactionChannel::PP_I);
+    EXPECT_EQ(io::enum_from_string<ReactionChannel>("CNO_II").value(), ReactionChannel::CNO_II);
+    EXPECT_FALSE(io::enum_from_string<ReactionChannel>("CNO_IV"));
+    EXPECT_FALSE(io::enum_from_string<ReactionChannel>("PP_"));
+    // Numbers are not names and go to reflect-cpp, which accepts them as before.
+    EXPECT_EQ(io::enum_from_string<ReactionChannel>("6").value(), ReactionChannel::TRIPLE_ALPHA);
+    EXPECT_EQ(io::literal_from_string<Fuel>("carbon").value().name(), "carbon");
+    const auto unknown = io::literal_from_string<Fuel>("neon");
+    ASSERT_FALSE(unknown);
+    EXPECT_NE(std::string(unknown.error().what()).find("hydrogen"), std::string::npos);
+
+    Config<ChannelSchema> cfg;
+    cfg.load_from("[main]\nchannel = \"SILICON_BURNING\"\nfuel = \"oxygen\"\n");
+    EXPECT_EQ(cfg->channel, ReactionChannel::SILICON_BURNING);
+    EXPECT_EQ(cfg->fuel.name(), "oxygen");
+
+    std::string text;
+    cfg.save_to(text);
+    Config<ChannelSchema> copy;
+    copy.load_from(text);
+    EXPECT_EQ(copy->channel, ReactionChannel::SILICON_BURNING);
+    EXPECT_EQ(copy->fuel.name(), "oxygen");
+
+    EXPECT_THROW(cfg.load_from("[main]\nchannel = \"CNO_IV\"\n"), exceptions::ConfigParseError);
+    EXPECT_THROW(cfg.load_from("[main]\nfuel = \"neon\"\n"), exceptions::ConfigParseError);
+    EXPECT_THROW(cfg.load_from("[main]\nchannel = 3\n"), exceptions::ConfigParseError);
+
+    const std::string_view schema = Config<ChannelSchema>::schema();
+    EXPECT_NE(schema.find("PHOTODISINTEGRATION"), std::string_view::npos);
+    EXPECT_NE(schema.find("helium"), std::string_view::npos);
+}
+
+struct FlatMapSchema {
+    fourdst::config::FlatMap<std::string, double> binding_energy;
+};
+
+TEST_F(configTest, flat_map_fields_hold_sorted_entries) {
+    using namespace fourdst::config;
+    Config<FlatMapSchema> cfg;
+    cfg.load_from("[main.binding_energy]\nO16 = 127.6\nHe4 = 28.3\nC12 = 92.2\n");
+    const auto& energies = cfg->binding_energy;
+    ASSERT_EQ(energies.size(), 3u);
+    EXPECT_TRUE(std::ranges::is_sorted(energies, {}, [](const auto& entry) { return entry.first; }));
+    EXPECT_DOUBLE_EQ(energies.at(std::string_view("He4")), 28.3);
+    EXPECT_FALSE(energies.contains("Fe56"));
+
+    std::string text;
+    cfg.save_to(text);
+    Config<FlatMapSchema> copy;
+    copy.load_from(text);
+    EXPECT_EQ(copy->binding_energy, energies);
+
+    EXPECT_THROW(cfg.load_from("[main.binding_energy]\nHe4 = \"heavy\"\n"), exceptions::ConfigParseError);
+    EXPECT_NE(Config<FlatMapSchema>::schema().find("additionalProperties"), std::string_view::npos);
+}
+
+struct SpeciesView {
+    std::string_view name;
+    double mass = 1.0;
+};
+
+struct ViewSchema {
+    std::string_view label = "default";
+    std::vector<std::string_view> units = {"cm", "g"};
+    std::vector<SpeciesView> species;
+};
+
+TEST_F(configTest, string_view_fields_point_into_retained_storage) {
+    using namespace fourdst::config;
+    static_assert(io::contains_string_view_v<ViewSchema>);
+    static_assert(!io::contains_string_view_v<TestConfigSchema>);
+
+    std::shared_ptr<const ViewSchema> snapshot;
+    {
+        Config<ViewSchema> cfg;
+        std::string json = R"({"main": {"label": "esc\"aped", "units": ["erg", "s"], "species": [{"name": "He-4", "mass": 4.0}]}})";
+        cfg.load_from(json);
+        json.assign(json.size(), 'x');
+        EXPECT_EQ(cfg->label, "esc\"aped");
+        EXPECT_EQ(cfg->units, (std::vector<std::string_view>{"erg", "s"}));
+        EXPECT_EQ(cfg->species.at(0).name, "He-4");
+
+        std::string toml = "[main]\nlabel = \"toml\"\nunits = [\"K\"]\n[[main.species]]\nname = \"H\"\nmass = 1.0\n";
+        cfg.load_from(toml);
+        toml.assign(toml.size(), 'x');
+        cfg.apply_patch("label = \"patched\"");
+        snapshot = cfg.snapshot();
+    }
+    // The snapshot keeps the strings alive after the Config is gone.
+    EXPECT_EQ(snapshot->label, "patched");
+    EXPECT_EQ(snapshot->units.at(0), "K");
+    EXPECT_EQ(snapshot->species.at(0).name, "H");
+}
+
+struct ReactionView {
+    std::string_view kind;
+    std::string_view unit;
+};
+
+struct NetworkSchema {
+    std::vector<ReactionView> reactions;
+};
+
+TEST_F(configTest, string_interning_shares_repeated_values) {
+    using namespace fourdst::config;
+    std::string toml = "[main]\n";
+    for (int i = 0; i < 100; ++i) {
+        toml += std::format("[[main.reactions]]\nkind = \"{}\"\nunit = \"erg/g/s\"\n", i % 2 == 0 ? "capture" : "decay");
+    }
+
+    Config<NetworkSchema> plain;
+    EXPECT_FALSE(plain.get_string_interning());
+    plain.load_from(toml);
+    EXPECT_NE(plain->reactions[0].unit.data(), plain->reactions[1].unit.data());
+
+    for (const bool json : {false, true}) {
+        Config<NetworkSchema> interned;
+        interned.set_string_interning(true);
+        EXPECT_TRUE(interned.get_string_interning());
+        if (json) {
+            std::string blob;
+            plain.set_file_format(FileFormat::JSON);
+            plain.save_to(blob);
+            interned.load_from(blob);
+        } else {
+            interned.load_from(toml);
+        }
+        ASSERT_EQ(interned->reactions.size(), 100);
+        EXPECT_TRUE(detail::equal(interned.main(), plain.main()));
+        EXPECT_EQ(interned->reactions[0].unit.data(), interned->reactions[99].unit.data());
+        EXPECT_EQ(interned->reactions[0].kind.data(), interned->reactions[2].kind.data());
+        EXPECT_NE(interned->reactions[0].kind.data(), interned->reactions[1].kind.data());
+    }
+}
+
+TEST_F(configTest, large_numeric_arrays_bypass_the_toml_dom) {
+    using namespace fourdst::config;
+    std::string samples;
+    std::vector<double> expected;
+    for (int i = 0; i < 2000; ++i) {
+        expected.push_back(i * 0.25 - 100.0);
+        samples += std::format("{:.2f},{}", expected.back(), i % 10 == 9 ? " # ten more\n  " : " ");
+    }
+    std::string cells;
+    for (int i = 0; i < 2000; ++i) cells += std::format("{}, ", i - 1000);
+
+    // The label hides text that looks like the array; the scanner must skip it as a string.
+    const std::string toml = std::format(
+        "[main]\nlabel = \"\"\"\n[main.grid]\nsamples = [1.0]\n\"\"\"\n[main.grid]\nsamples = [\n  {}\n]\ncells = [{}]\nbounds = [0.0, 1.0]\n",
+        samples, cells);
+
+    const auto spans = io::scan_numeric_arrays<SidecarSchema>(toml);
+    ASSERT_EQ(spans.size(), 2);
+    EXPECT_EQ(spans[0].path, "main.grid.samples");
+    EXPECT_EQ(spans[1].path, "main.grid.cells");
+    EXPECT_TRUE(io::scan_numeric_arrays<TestConfigSchema>(toml).empty());
+    SidecarSchema direct;
+    ASSERT_TRUE(io::fill_numeric_arrays(direct, toml, spans, "main"));
+    EXPECT_EQ(direct.grid.samples, expected);
+
+    Config<SidecarSchema> cfg;
+    cfg.load_from(toml);
+    EXPECT_EQ(cfg->label, "[main.grid]\nsamples = [1.0]\n");
+    EXPECT_EQ(cfg->grid.samples, expected);
+    ASSERT_EQ(cfg->grid.cells.size(), 2000);
+    EXPECT_EQ(cfg->grid.cells.front(), -1000);
+    EXPECT_EQ(cfg->grid.cells.back(), 999);
+    EXPECT_EQ(cfg->grid.bounds, (std::vector<double>{0.0, 1.0}));
+
+    // Elements the fast path does not read fall back to toml++, with its results.
+    Config<SidecarSchema> underscored;
+    underscored.load_from(std::format("[main]\nlabel = \"u\"\n[main.grid]\nsamples = []\ncells = [1_000, {}]\nbounds = []\n", cells));
+    EXPECT_EQ(underscored->grid.cells.front(), 1000);
+    EXPECT_EQ(underscored->grid.cells.size(), 2001);
+
+    Config<SidecarSchema> integral;
+    EXPECT_THROW(integral.load_from(std::format("[main]\nlabel = \"i\"\n[main.grid]\nsamples = [1, {}]\ncells = []\nbounds = []\n", samples)), exceptions::ConfigParseError);
+}
+
+struct OpacitySinkSchema {
+    std::string label = "opacity";
+    fourdst::config::Sink<double> kappa;
+};
+
+TEST_F(configTest, sink_fields_stream_arrays_into_caller_buffers) {
+    using namespace fourdst::config;
+    std::string kappa;
+    for (int i = 0; i < 2000; ++i) kappa += std::format("{}.5, ", i);
+    const std::string deck = std::format("[main]\nlabel = \"big\"\nkappa = [{}]\n", kappa);
+
+    // Without a target the field holds its elements like a vector.
+    Config<OpacitySinkSchema> held;
+    held.load_from("[main]\nlabel = \"small\"\nkappa = [1.0, 2.0, 3.0]\n");
+    EXPECT_FALSE(held->kappa.is_bound());
+    EXPECT_EQ(held->kappa.size(), 3u);
+    EXPECT_EQ(std::vector<double>(held->kappa.held().begin(), held->kappa.held().end()), (std::vector<double>{1.0, 2.0, 3.0}));
+
+    // The fast path parses a large array straight into the buffer.
+    std::vector<double> buffer(2000);
+    Config<OpacitySinkSchema> cfg;
+    EXPECT_THROW(cfg.set_sink<double>("label", sink_into(std::span<double>(buffer))), exceptions::ConfigPathError);
+    EXPECT_THROW(cfg.set_sink<float>("kappa", sink_into(std::span<float>())), exceptions::ConfigPathError);
+    cfg.set_sink<double>("kappa", sink_into(std::span<double>(buffer)));
+    cfg.load_from(deck);
+    EXPECT_TRUE(cfg->kappa.is_bound());
+    EXPECT_TRUE(cfg->kappa.held().empty());
+    ASSERT_EQ(cfg->kappa.size(), 2000u);
+    EXPECT_EQ(buffer.front(), 0.5);
+    EXPECT_EQ(buffer.back(), 1999.5);
+
+    // Saving reads the elements back from the buffer.
+    cfg.save("OpacitySinkSchema.toml");
+    Config<OpacitySinkSchema> reloaded;
+    reloaded.load("OpacitySinkSchema.toml");
+    ASSERT_EQ(reloaded->kappa.size(), 2000u);
+    EXPECT_EQ(reloaded->kappa.held().back(), 1999.5);
+
+    // A short array is streamed when the load binds the target; chunks arrive in order.
+    std::vector<std::size_t> offsets;
+    double sum = 0.0;
+    Config<OpacitySinkSchema> chunked;
+    chunked.set_sink<double>("kappa", sink_chunks<double>([&](const std::span<const double> elements, const std::size_t offset) {
+        offsets.push_back(offset);
+        for (const double element : elements) sum += element;
+    }, 2));
+    chunked.load_from("[main]\nlabel = \"small\"\nkappa = [1.0, 2.0, 3.0, 4.0, 5.0]\n");
+    EXPECT_EQ(chunked->kappa.size(), 5u);
+    EXPECT_EQ(offsets, (std::vector<std::size_t>{0, 2, 4}));
+    EXPECT_EQ(sum, 15.0);
+    EXPECT_THROW(chunked.save("OpacitySinkSchema.chunked.toml"), exceptions::ConfigSaveError);
+
+    // More elements than the buffer holds fail the load.
+    std::vector<double> small(2);
+    Config<OpacitySinkSchema> overflow;
+    overflow.set_sink<double>("kappa", sink_into(std::span<double>(small)));
+    EXPECT_THROW(overflow.load_from("[main]\nlabel = \"small\"\nkappa = [1.0, 2.0, 3.0]\n"), exceptions::ConfigLoadError);
+}
+
+struct MeshCell {
+    std::array<int, 2> corner = {0, 0};
+};
+
+struct MeshSchema {
+    std::vector<MeshCell> cells = {};
+};
+
+TEST_F(configTest, fixed_arrays_report_their_length_while_reading) {
+    using namespace fourdst::config;
+    Config<MeshSchema> cfg;
+    cfg.load_from("[[main.cells]]\ncorner = [1, 2]\n[[main.cells]]\ncorner = [3, 4]\n");
+    ASSERT_EQ(cfg->cells.size(), 2);
+    EXPECT_EQ(cfg->cells[1].corner, (std::array<int, 2>{3, 4}));
+
+    try {
+        cfg.load_from("[[main.cells]]\ncorner = [1, 2]\n[[main.cells]]\ncorner = [3, 4, 5]\n");
+        FAIL() << "expected ConfigParseError";
+    } catch (const exceptions::ConfigParseError& e) {
+        EXPECT_NE(std::string_view(e.what()).find("main.cells[1].corner: expected 2 elements, found 3"), std::string_view::npos) << e.what();
+    }
+    ASSERT_TRUE(io::last_array_size_mismatch().has_value());
+    EXPECT_EQ(io::last_array_size_mismatch()->expected, 2);
+    EXPECT_EQ(io::last_array_size_mismatch()->found, 3);
+}
+
+struct RateEntry {
+    std::string label = "";
+    double rate = 0.0;
+    std::array<int, 2> ids = {0, 0};
+};
+
+struct RateDeckSchema {
+    std::vector<RateEntry> rates = {};
+};
+
+TEST_F(configTest, parallel_read_matches_a_serial_read) {
+    using namespace fourdst::config;
+    std::string toml = "[main]\n";
+    for (int i = 0; i < 5000; ++i) {
+        toml += std::format("[[main.rates]]\nlabel = \"r{}\"\nrate = {}.5\nids = [{}, {}]\n", i, i, i, i + 1);
+    }
+
+    Config<RateDeckSchema> serial;
+    EXPECT_FALSE(serial.get_parallel_read().has_value());
+    serial.load_from(toml);
+
+    Config<RateDeckSchema> parallel;
+    parallel.set_parallel_read(io::ParallelReadOptions{100, 4});
+    ASSERT_TRUE(parallel.get_parallel_read().has_value());
+    EXPECT_EQ(parallel.get_parallel_read()->max_threads, 4);
+    parallel.load_from(toml);
+    ASSERT_EQ(parallel->rates.size(), 5000);
+    EXPECT_EQ(parallel->rates[4999].label, "r4999");
+    EXPECT_TRUE(detail::equal(parallel.main(), serial.main()));
+
+    // The first failing element is reported, with its path, as in a serial read.
+    std::string broken = toml;
+    broken.replace(broken.find("ids = [3000, 3001]"), 18, "ids = [3000, 3001, 3002]");
+    broken.replace(broken.find("ids = [4000, 4001]"), 18, "ids = [4000]");
+    try {
+        parallel.load_from(broken);
+        FAIL() << "expected ConfigParseError";
+    } catch (const exceptions::ConfigParseError& e) {
+        EXPECT_NE(std::string_view(e.what()).find("main.rates[3000].ids: expected 2 elements, found 3"), std::string_view::npos) << e.what();
+    }
+}
+
+struct CatalogSchema {
+    std::vector<std::string> labels;
+    std::vector<std::vector<int>> ids;
+    std::map<std::string, RateEntry> rates;
+    std::unordered_map<std::string, int> counts;
+};
+
+TEST_F(configTest, containers_read_from_toml_keep_every_element_in_order) {
+    using namespace fourdst::config;
+    std::string toml = "[main]\nlabels = [";
+    for (int i = 0; i < 3000; ++i) toml += std::format("\"l{}\", ", i);
+    toml += "]\nids = [[1, 2], [], [3]]\n[main.counts]\n";
+    for (int i = 0; i < 500; ++i) toml += std::format("c{} = {}\n", i, i);
+    for (int i = 0; i < 500; ++i) toml += std::format("[main.rates.r{:03}]\nlabel = \"r{}\"\nrate = {}.5\n", i, i, i);
+
+    Config<CatalogSchema> cfg;
+    cfg.load_from(toml);
+    ASSERT_EQ(cfg->labels.size(), 3000u);
+    EXPECT_EQ(cfg->labels[2999], "l2999");
+    EXPECT_EQ(cfg->ids, (std::vector<std::vector<int>>{{1, 2}, {}, {3}}));
+    ASSERT_EQ(cfg->rates.size(), 500u);
+    EXPECT_EQ(cfg->rates.begin()->first, "r000");
+    EXPECT_EQ(cfg->rates.at("r499").rate, 499.5);
+    ASSERT_EQ(cfg->counts.size(), 500u);
+    EXPECT_EQ(cfg->counts.at("c250"), 250);
+
+    std::string broken = toml;
+    broken.replace(broken.find("c7 = 7"), 6, "c7 = \"seven\"");
+    try {
+        cfg.load_from(broken);
+        FAIL() << "expected ConfigParseError";
+    } catch (const exceptions::ConfigParseError& e) {
+        EXPECT_NE(std::string_view(e.what()).find("c7"), std::string_view::npos) << e.what();
+    }
+}
+
+struct WideSchema {
+    double c0 = 0; double c1 = 0; double c2 = 0; double c3 = 0; double c4 = 0; double c5 = 0;
+    double c6 = 0; double c7 = 0; double c8 = 0; double c9 = 0; double c10 = 0; double c11 = 0;
+    double c12 = 0; double c13 = 0; double c14 = 0; double c15 = 0; double c16 = 0; double c17 = 0;
+    std::string label = "none";
+    std::optional<int> seed;
+    OutputConfigOptions output;
+};
+
+TEST_F(configTest, wide_structs_match_keys_to_fields_in_any_order) {
+    using namespace fourdst::config;
+    static_assert(rfl::named_tuple_t<WideSchema>::size() >= io::indexed_field_threshold);
+    static_assert(io::detail::FieldIndex<rfl::named_tuple_t<WideSchema>>::find("c17") == 17);
+    static_assert(io::detail::FieldIndex<rfl::named_tuple_t<WideSchema>>::find("c18") ==
+                  io::detail::FieldIndex<rfl::named_tuple_t<WideSchema>>::npos);
+
+    std::string toml = "[main]\nlabel = \"wide\"\n";
+    for (int i = 17; i >= 0; --i) toml += std::format("c{} = {}.5\n", i, i);
+    toml += "[main.output]\ndirectory = \"out\"\n";
+    Config<WideSchema> cfg;
+    cfg.set_missing_field_policy(MissingFieldPolicy::USE_DEFAULTS);
+    cfg.load_from(toml);
+    EXPECT_EQ(cfg->c0, 0.5);
+    EXPECT_EQ(cfg->c17, 17.5);
+    EXPECT_EQ(cfg->label, "wide");
+    EXPECT_FALSE(cfg->seed.has_value());
+    EXPECT_EQ(cfg->output.directory, "out");
+    EXPECT_EQ(cfg->output.format, "hdf5");
+
+    std::string mistyped = toml;
+    mistyped.replace(mistyped.find("c9 = 9.5"), 8, "c9 = \"nine\"");
+    try {
+        cfg.load_from(mistyped);
+        FAIL() << "expected ConfigParseError";
+    } catch (const exceptions::ConfigParseError& e) {
+        EXPECT_NE(std::string_view(e.what()).find("c9"), std::string_view::npos) << e.what();
+    }
+}
+
+struct OpacityTables {
+    std::string source = "OPAL";
+    std::vector<double> log_kappa = {};
+};
+
+struct LazyDeckSchema {
+    bool diffusion = true;
+    fourdst::config::Lazy<OpacityTables> alternate_opacities;
+};
+
+TEST_F(configTest, lazy_fields_deserialize_on_first_access) {
+    using namespace fourdst::config;
+    Config<LazyDeckSchema> cfg;
+    cfg.load_from("[main]\ndiffusion = false\n[main.alternate_opacities]\nsource = \"OP\"\nlog_kappa = [0.5, 1.5]\n");
+    EXPECT_FALSE(cfg->diffusion);
+    EXPECT_FALSE(cfg->alternate_opacities.is_loaded());
+
+    const auto snapshot = cfg.snapshot();
+    EXPECT_EQ(cfg->alternate_opacities->source, "OP");
+    EXPECT_TRUE(cfg->alternate_opacities.is_loaded());
+    // Copies share the deserialized value.
+    EXPECT_TRUE(snapshot->alternate_opacities.is_loaded());
+    EXPECT_EQ(snapshot->alternate_opacities.get().log_kappa, (std::vector<double>{0.5, 1.5}));
+
+    std::string saved;
+    cfg.save_to(saved);
+    EXPECT_NE(saved.find("source = \"OP\""), std::string::npos) << saved;
+    cfg.save("LazyDeckSchema.toml");
+    for (int pass = 0; pass < 2; ++pass) {
+        Config<LazyDeckSchema> cached;
+        cached.set_cache_policy(CachePolicy::READ_WRITE);
+        cached.load("LazyDeckSchema.toml");
+        EXPECT_EQ(cached->alternate_opacities->source, "OP");
+    }
+
+    // A malformed table is only reported when the field is used.
+    Config<LazyDeckSchema> broken;
+    broken.load_from("[main]\ndiffusion = true\n[main.alternate_opacities]\nsource = 3\nlog_kappa = []\n");
+    EXPECT_THROW((void)broken->alternate_opacities.get(), exceptions::ConfigParseError);
+
+    // A failed load validates the table as an OpacityTables.
+    try {
+        broken.load_from("[main]\n[main.alternate_opacities]\nsource = 3\nlog_kappa = []\n");
+        FAIL() << "expected ConfigParseError";
+    } catch (const exceptions::ConfigParseError& e) {
+        EXPECT_NE(std::string_view(e.what()).find("main.alternate_opacities.source: expected string"), std::string_view::npos) << e.what();
+    }
+
+    const std::string schema = rfl::json::to_schema<LazyDeckSchema>();
+    EXPECT_NE(schema.find("log_kappa"), std::string::npos);
+}
+
+struct SectionDeckSchema {
+    bool diffusion = true;
+    fourdst::config::Section<OpacityTables> opacities;
+};
+
+TEST_F(configTest, section_fields_load_their_file_on_first_access) {
+    using namespace fourdst::config;
+    std::filesystem::create_directories("sections/tables");
+    {
+        std::ofstream tables("sections/tables/opacity.toml");
+        tables << "source = \"OP\"\nlog_kappa = [0.5, 1.5]\n";
+        std::ofstream deck("sections/run.toml");
+        deck << "[main]\ndiffusion = false\nopacities = \"tables/opacity.toml\"\n";
+    }
+
+    io::SectionCache::instance().clear();
+    Config<SectionDeckSchema> cfg;
+    cfg.load("sections/run.toml");
+    EXPECT_FALSE(cfg->diffusion);
+    EXPECT_FALSE(cfg->opacities.is_loaded());
+    EXPECT_EQ(io::SectionCache::instance().size(), 0u);
+
+    // The path is relative to the deck, and the file is read once for every config naming it.
+    EXPECT_EQ(cfg->opacities->source, "OP");
+    EXPECT_EQ(cfg->opacities.get().log_kappa, (std::vector<double>{0.5, 1.5}));
+    Config<SectionDeckSchema> other;
+    other.load("sections/run.toml");
+    EXPECT_EQ(&other->opacities.get(), &cfg->opacities.get());
+    EXPECT_EQ(io::SectionCache::instance().size(), 1u);
+
+    // Saving keeps the reference, not the contents.
+    std::string saved;
+    cfg.save_to(saved);
+    EXPECT_NE(saved.find("opacities = \"tables/opacity.toml\""), std::string::npos) << saved;
+    EXPECT_EQ(saved.find("OP"), std::string::npos) << saved;
+
+    // A section file that does not match its schema is reported, with its own path, when the field is used.
+    {
+        std::ofstream tables("sections/tables/broken.toml");
+        tables << "source = 3\nlog_kappa = []\n";
+    }
+    Config<SectionDeckSchema> broken;
+    broken.load_from("[main]\nopacities = \"sections/tables/broken.toml\"\n");
+    try {
+        (void)broken->opacities.get();
+        FAIL() << "expected ConfigParseError";
+    } catch (const exceptions::ConfigParseError& e) {
+        EXPECT_NE(std::string_view(e.what()).find("source: expected string"), std::string_view::npos) << e.what();
+        ASSERT_TRUE(e.location().has_value());
+        EXPECT_NE(e.location()->file.find("broken.toml"), std::string::npos);
+    }
+
+    Config<SectionDeckSchema> missing;
+    missing.load_from("[main]\nopacities = \"sections/tables/absent.toml\"\n");
+    EXPECT_THROW((void)missing->opacities.get(), exceptions::ConfigLoadError);
+    EXPECT_THROW(missing.load_from("[main]\nopacities = 3\n"), exceptions::ConfigParseError);
+}
+
+struct DomainPatch {
+    double x0 = 0.0;
+    std::vector<double> boundaries = {};
+};
+
+struct ShardedDeckSchema {
+    std::string label = "run";
+    fourdst::config::Sharded<DomainPatch> domains;
+};
+
+TEST_F(configTest, sharded_fields_load_only_the_selected_shards) {
+    using namespace fourdst::config;
+    const std::string deck =
+        "[main]\nlabel = \"decomposed\"\n"
+        "[main.domains.0]\nx0 = 0.0\nboundaries = [0.0, 1.0]\n"
+        "[main.domains.1]\nx0 = 1.0\nboundaries = [1.0, 2.5]\n"
+        "[main.domains.2]\nx0 = 2.5\nboundaries = [2.5, 4.0]\n";
+    Config<ShardedDeckSchema> full;
+    full.load_from(deck);
+    ASSERT_EQ(full->domains.size(), 3u);
+    EXPECT_FALSE(full->domains.is_partial());
+
+    // A table keeps only the selected entries.
+    Config<ShardedDeckSchema> local;
+    local.set_shard_selector(io::ShardSelector{"1"});
+    local.load_from(deck);
+    ASSERT_EQ(local->domains.size(), 1u);
+    EXPECT_TRUE(local->domains.is_partial());
+    EXPECT_EQ(local->domains.at("1").boundaries, (std::vector<double>{1.0, 2.5}));
+    EXPECT_THROW(local.save("ShardedDeckSchema.partial.toml"), exceptions::ConfigSaveError);
+
+    // save() moves the entries to a shard file and leaves their byte ranges in the deck.
+    full.save("ShardedDeckSchema.toml");
+    std::stringstream saved_deck;
+    saved_deck << std::ifstream("ShardedDeckSchema.toml").rdbuf();
+    const std::string saved = saved_deck.str();
+    EXPECT_NE(saved.find("__shards = \"ShardedDeckSchema.toml.domains.shards.toml\""), std::string::npos) << saved;
+    EXPECT_EQ(saved.find("boundaries"), std::string::npos) << saved;
+
+    Config<ShardedDeckSchema> reloaded;
+    reloaded.load("ShardedDeckSchema.toml");
+    EXPECT_TRUE(equal(reloaded.main(), full.main()));
+
+    for (const std::string rank : {"0", "2"}) {
+        Config<ShardedDeckSchema> shard;
+        shard.set_shard_selector(io::ShardSelector{rank});
+        shard.load("ShardedDeckSchema.toml");
+        EXPECT_EQ(shard->label, "decomposed");
+        ASSERT_EQ(shard->domains.size(), 1u);
+        EXPECT_EQ(shard->domains.at(rank).x0, full->domains.at(rank).x0);
+        EXPECT_EQ(shard->domains.at(rank).boundaries, full->domains.at(rank).boundaries);
+    }
+
+    // A range outside the shard file is reported.
+    {
+        std::ofstream corrupt("ShardedDeckSchema.corrupt.toml");
+        corrupt << "[main]\ndomains = { __shards = \"ShardedDeckSchema.toml.domains.shards.toml\", index = { 0 = [0, 100000] } }\n";
+    }
+    Config<ShardedDeckSchema> corrupt;
+    EXPECT_THROW(corrupt.load("ShardedDeckSchema.corrupt.toml"), exceptions::ConfigParseError);
+}
+
+TEST_F(configTest, projected_loads_read_only_the_selected_subtrees) {
+    using namespace fourdst::config;
+    const std::string deck =
+        "[main]\ndescription = \"full run\"\nauthor = \"someone\"\n"
+        "[main.physics]\ndiffusion = \"not a bool\"\nflags = [1]\nunknown = 3\n"
+        "[main.simulation]\ntime_step = 0.5\ntotal_time = 20.0\noutput_frequency = 5\n"
+        "[main.output]\ndirectory = \"/scratch/run\"\nformat = \"csv\"\nsave_plots = true\n";
+
+    Config<TestConfigSchema> cfg;
+    EXPECT_TRUE(cfg.get_projection().empty());
+    EXPECT_THROW(cfg.set_projection({"output.nope"}), exceptions::ConfigPathError);
+    cfg.set_projection({"simulation.time_step", "output", "simulation"});
+    EXPECT_EQ(cfg.get_projection(), (std::vector<std::string>{"output", "simulation"}));
+
+    // The broken physics table and the unknown key outside the projection are never read.
+    cfg.set_projection({"output", "simulation.time_step"});
+    cfg.set_unknown_key_policy(UnknownKeyPolicy::REJECT);
+    cfg.load_from(deck);
+    EXPECT_EQ(cfg->output.directory, "/scratch/run");
+    EXPECT_EQ(cfg->output.format, "csv");
+    EXPECT_EQ(cfg->simulation.time_step, 0.5);
+    EXPECT_EQ(cfg->simulation.total_time, 10.0);
+    EXPECT_EQ(cfg->author, "");
+    EXPECT_FALSE(cfg->physics.diffusion);
+
+    // A projected subtree is read whole, under the missing field policy.
+    Config<TestConfigSchema> incomplete;
+    incomplete.set_projection({"output"});
+    EXPECT_THROW(incomplete.load_from("[main]\n[main.output]\ndirectory = \"out\"\n"), exceptions::ConfigParseError);
+    Config<TestConfigSchema> filled;
+    filled.set_projection({"output"});
+    filled.set_missing_field_policy(MissingFieldPolicy::USE_DEFAULTS);
+    filled.load_from("[main]\n[main.output]\ndirectory = \"out\"\n");
+    EXPECT_EQ(filled->output.directory, "out");
+    EXPECT_EQ(filled->output.format, "hdf5");
+
+    // Large numeric arrays outside the projection are skipped unparsed.
+    std::string samples;
+    for (int i = 0; i < 2000; ++i) samples += std::format("{}.5, ", i);
+    std::string cells;
+    for (int i = 0; i < 2000; ++i) cells += std::format("{}, ", i);
+    const std::string grid_deck = std::format("[main]\nlabel = \"big\"\n[main.grid]\nsamples = [{}]\ncells = [{}]\n", samples, cells);
+    {
+        std::ofstream out("ProjectedGrid.toml");
+        out << grid_deck;
+    }
+    Config<SidecarSchema> grid;
+    grid.load("ProjectedGrid.toml", {"grid.cells"});
+    EXPECT_EQ(grid->label, "grid");
+    EXPECT_TRUE(grid->grid.samples.empty());
+    ASSERT_EQ(grid->grid.cells.size(), 2000);
+    EXPECT_EQ(grid->grid.cells.back(), 1999);
+    EXPECT_EQ(grid->grid.bounds, (std::vector<double>{0.0, 1.0}));
+}
+
+struct ReactionRate {
+    std::string label = "";
+    double q_value = 0.0;
+    bool reverse = false;
+    int chapter = 1;
+};
+
+struct SoANetworkSchema {
+    std::string name = "pp";
+    fourdst::config::SoA<std::vector<ReactionRate>> rates = {{"p(p,e+)d", 1.442, false, 3}};
+};
+
+TEST_F(configTest, soa_fields_store_one_column_per_member) {
+    using namespace fourdst::config;
+    static_assert(io::is_streamable_v<SoANetworkSchema>);
+
+    Config<SoANetworkSchema> defaults;
+    ASSERT_EQ(defaults->rates.size(), 1);
+    EXPECT_EQ(defaults->rates[0].label, "p(p,e+)d");
+
+    Config<SoANetworkSchema> cfg;
+    cfg.load_from("[main]\nname = \"cno\"\n"
+                  "[[main.rates]]\nlabel = \"c12(p,g)n13\"\nq_value = 1.944\nreverse = false\nchapter = 4\n"
+                  "[[main.rates]]\nlabel = \"n13(,e+)c13\"\nq_value = 2.22\nreverse = true\nchapter = 1\n");
+    ASSERT_EQ(cfg->rates.size(), 2);
+    const std::span<const double> q = cfg->rates.column<"q_value">();
+    EXPECT_EQ(std::vector<double>(q.begin(), q.end()), (std::vector<double>{1.944, 2.22}));
+    EXPECT_EQ(cfg->rates.column<"reverse">()[1], 1);
+    EXPECT_EQ(cfg->rates.column<"label">()[0], "c12(p,g)n13");
+    EXPECT_TRUE(cfg->rates[1].reverse);
+
+    cfg.mutate([](SoANetworkSchema& c) {
+        for (double& value : c.rates.column<"q_value">()) value *= 2.0;
+        c.rates.push_back({"c13(p,g)n14", 7.551, false, 4});
+    });
+    EXPECT_EQ(cfg->rates.to_vector().back().label, "c13(p,g)n14");
+
+    // Saved as an ordinary array of tables, which reads back into the same columns.
+    std::string saved;
+    cfg.save_to(saved);
+    EXPECT_NE(saved.find("[[main.rates]]\nlabel = \"c13(p,g)n14\""), std::string::npos) << saved;
+    Config<SoANetworkSchema> reloaded;
+    reloaded.load_from(saved);
+    EXPECT_TRUE(detail::equal(reloaded.main(), cfg.main()));
+    EXPECT_EQ(reloaded->rates, cfg->rates);
+
+    cfg.save("SoANetworkSchema.json");
+    Config<SoANetworkSchema> from_json;
+    from_json.load("SoANetworkSchema.json");
+    EXPECT_EQ(from_json->rates.column<"chapter">()[2], 4);
+
+    // Rows are validated like those of a std::vector<ReactionRate>.
+    try {
+        reloaded.load_from("[main]\n[[main.rates]]\nlabel = \"a\"\nq_value = 1.0\nreverse = false\nchapter = 1\n[[main.rates]]\nlabel = \"b\"\nq_value = \"x\"\nreverse = false\nchapter = 1\n");
+        FAIL() << "expected ConfigParseError";
+    } catch (const exceptions::ConfigParseError& e) {
+        EXPECT_NE(std::string_view(e.what()).find("main.rates[1].q_value: expected float"), std::string_view::npos) << e.what();
+    }
+
+    const std::string schema = rfl::json::to_schema<SoANetworkSchema>();
+    EXPECT_NE(schema.find("q_value"), std::string::npos);
+}
+
+struct EosTables {
+    std::string name = "helm";
+    fourdst::config::Tensor<double, 2> log_pressure;
+    fourdst::config::Tensor<std::int32_t, 3> phase = fourdst::config::Tensor<std::int32_t, 3>({1, 2, 2}, 7);
+};
+
+struct TensorSchema {
+    EosTables eos;
+};
+
+TEST_F(configTest, tensor_fields_are_read_into_one_contiguous_buffer) {
+    using namespace fourdst::config;
+    static_assert(io::is_streamable_v<TensorSchema>);
+    static_assert(io::is_binary_encodable_v<TensorSchema>);
+
+    Config<TensorSchema> cfg;
+    cfg.load_from("[main.eos]\nname = \"opal\"\nlog_pressure = [[1.0, 2.0, 3.0], [4.0, 5.0, 6.0]]\n"
+                  "phase = [[[1, 2], [3, 4]], [[5, 6], [7, 8]]]\n");
+    EXPECT_EQ(cfg->eos.log_pressure.extents(), (std::array<std::size_t, 2>{2, 3}));
+    EXPECT_EQ(cfg->eos.log_pressure(1, 0), 4.0);
+    EXPECT_EQ(cfg->eos.phase(1, 1, 0), 7);
+    const std::span<const double> values = cfg->eos.log_pressure.values();
+    EXPECT_EQ(std::vector<double>(values.begin(), values.end()), (std::vector<double>{1, 2, 3, 4, 5, 6}));
+
+    // Written back in the same shape.
+    std::string saved;
+    cfg.save_to(saved);
+    EXPECT_NE(saved.find("log_pressure = [[1.0, 2.0, 3.0], [4.0, 5.0, 6.0]]"), std::string::npos) << saved;
+    Config<TensorSchema> reloaded;
+    reloaded.load_from(saved);
+    EXPECT_TRUE(detail::equal(reloaded.main(), cfg.main()));
+
+    cfg.save("TensorSchema.json");
+    Config<TensorSchema> from_json;
+    from_json.load("TensorSchema.json");
+    EXPECT_EQ(from_json->eos.phase, cfg->eos.phase);
+
+    // Large tensors go to sidecars that keep their shape.
+    cfg.set_sidecar_threshold(4);
+    cfg.save("TensorSchema.toml");
+    ASSERT_TRUE(std::filesystem::exists("TensorSchema.toml.eos.log_pressure.npy"));
+    Config<TensorSchema> from_sidecar;
+    from_sidecar.load("TensorSchema.toml");
+    EXPECT_TRUE(detail::equal(from_sidecar.main(), cfg.main()));
+    for (int pass = 0; pass < 2; ++pass) {
+        Config<TensorSchema> cached;
+        cached.set_cache_policy(CachePolicy::READ_WRITE);
+        cached.load_from(saved);
+        EXPECT_EQ(cached->eos.log_pressure, cfg->eos.log_pressure);
+    }
+
+    // Ragged input is rejected with the path of the short row.
+    try {
+        reloaded.load_from("[main.eos]\nname = \"opal\"\nlog_pressure = [[1.0, 2.0], [3.0]]\nphase = [[[1]]]\n");
+        FAIL() << "expected ConfigParseError";
+    } catch (const exceptions::ConfigParseError& e) {
+        EXPECT_NE(std::string_view(e.what()).find("main.eos.log_pressure[1]: expected 2 elements, found 1"), std::string_view::npos) << e.what();
+    }
+    const std::vector<std::vector<double>> ragged = {{1.0, 2.0}, {3.0}};
+    EXPECT_THROW((void)(Tensor<double, 2>::from_nested(ragged)), exceptions::ConfigParseError);
+
+    const std::string schema = rfl::json::to_schema<TensorSchema>();
+    EXPECT_NE(schema.find("log_pressure"), std::string::npos);
+}
+
+TEST_F(configTest, embed_initializer_rebuilds_the_content) {
+    using namespace fourdst::config;
+    static_assert(io::is_embeddable_v<TestConfigSchema>);
+    static_assert(!io::is_embeddable_v<LazyDeckSchema>);
+
+    Config<TestConfigSchema> loaded;
+    loaded.load(std::string(getenv("MESON_SOURCE_ROOT")) + "/tests/config/example_config_files/example.good.toml");
+    const std::string initializer = io::embed_initializer(loaded.main());
+    EXPECT_NE(initializer.find(".simulation = SimulationConfigOptions{.time_step = 0.01, .total_time = 100.0, .output_frequency = 10}"),
+              std::string::npos) << initializer;
+    EXPECT_NE(initializer.find(".flags = {1, 0, 1}"), std::string::npos) << initializer;
+
+    // A config built from content holds it as its defaults.
+    Config<TestConfigSchema> embedded(loaded.main());
+    EXPECT_EQ(embedded.get_state(), ConfigState::DEFAULT);
+    embedded.mutate([](TestConfigSchema& c) { c.simulation.output_frequency = 1; });
+    embedded.reset();
+    EXPECT_TRUE(detail::equal(embedded.main(), loaded.main()));
+}
+
+TEST_F(configTest, dynamic_config_reads_the_same_parse_as_a_static_config) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    const DynamicConfig deck = DynamicConfig::load(get_good_example_file(), cfg);
+    EXPECT_EQ(cfg.get_state(), ConfigState::LOADED_FROM_FILE);
+    EXPECT_EQ(cfg->simulation.time_step, deck.get<double>("main.simulation.time_step"));
+
+    EXPECT_EQ(deck.get<int>("main.simulation.output_frequency"), 10);
+    EXPECT_EQ(deck.get<double>("main.simulation.output_frequency"), 10.0);
+    EXPECT_EQ(deck.get<std::string_view>("main.output.format"), "csv");
+    EXPECT_EQ(deck.get<std::vector<int>>("main.physics.flags"), (std::vector<int>{1, 0, 1}));
+    EXPECT_EQ(deck.get<int>("main.physics.flags.2"), 1);
+    EXPECT_EQ(deck.kind("main.physics"), DynamicKind::TABLE);
+    EXPECT_EQ(deck.size("main.physics"), 4);
+    EXPECT_EQ(deck.get_or<double>("plugin.tolerance", 1e-8), 1e-8);
+    EXPECT_FALSE(deck.contains("main.physics.viscosity"));
+    EXPECT_THROW((void)deck.get<bool>("main.output.format"), exceptions::ConfigPathError);
+    EXPECT_THROW((void)deck.get<double>("main.missing"), exceptions::ConfigPathError);
+    EXPECT_TRUE(std::ranges::is_sorted(deck.paths()));
+
+    const DynamicConfig plugin = DynamicConfig::parse("[plugin]\nlimits = [{ lo = -1, hi = 300 }]\n");
+    EXPECT_THROW((void)plugin.get<std::uint8_t>("plugin.limits.0.hi"), exceptions::ConfigPathError);
+    EXPECT_EQ(plugin.get<std::int8_t>("plugin.limits.0.lo"), -1);
+}
+
+TEST_F(configTest, bundle_loads_each_root_table_from_one_parse) {
+    using namespace fourdst::config;
+    const std::string path = std::string(getenv("MESON_SOURCE_ROOT")) + "/tests/config/example_config_files/example.bundle.toml";
+    Config<TestConfigSchema> main_cfg;
+    Config<RichConfigSchema> network_cfg;
+    Config<TestConfigSchema> eos_cfg;
+
+    ConfigBundle bundle;
+    bundle.add(main_cfg).add(network_cfg, "network").add(eos_cfg, "eos");
+    EXPECT_THROW(bundle.add(eos_cfg), exceptions::ConfigLoadError);
+    EXPECT_EQ(bundle.size(), 3);
+    bundle.load(path);
+
+    EXPECT_EQ(main_cfg->simulation.time_step, 0.5);
+    EXPECT_EQ(network_cfg->solver, Solver::EXPLICIT);
+    EXPECT_EQ(network_cfg.get_root_name(), "network");
+    EXPECT_EQ(eos_cfg->simulation.total_time, 42.0);
+    EXPECT_EQ(eos_cfg.get_source_path(), path);
+
+    Config<TestConfigSchema> separate;
+    separate.set_root_name("eos");
+    separate.load(path);
+    EXPECT_TRUE(detail::equal(separate.main(), eos_cfg.main()));
+
+    // A missing root is reported before any config is loaded.
+    Config<TestConfigSchema> first;
+    Config<TestConfigSchema> absent;
+    ConfigBundle partial;
+    partial.add(first).add(absent, "opacity");
+    EXPECT_THROW(partial.load(path), exceptions::ConfigLoadError);
+    EXPECT_EQ(first.get_state(), ConfigState::DEFAULT);
+}
+
+TEST_F(configTest, registry_reloads_all_configs_or_none) {
+    using namespace fourdst::config;
+    std::string deck;
+    {
+        std::ifstream in(std::string(getenv("MESON_SOURCE_ROOT")) + "/tests/config/example_config_files/example.bundle.toml");
+        deck.assign(std::istreambuf_iterator<char>(in), {});
+    }
+    const auto write_deck = [&](const std::string& text) { std::ofstream("TestConfigSchema.registry.toml") << text; };
+    const auto replaced = [&](std::string text, const std::string& from, const std::string& to) {
+        text.replace(text.find(from), from.size(), to);
+        return text;
+    };
+    write_deck(deck);
+    Config<TestConfigSchema> main_cfg;
+    Config<RichConfigSchema> network_cfg;
+    Config<TestConfigSchema> eos_cfg;
+    ConfigBundle bundle;
+    bundle.add(main_cfg).add(network_cfg, "network").add(eos_cfg, "eos");
+    bundle.load("TestConfigSchema.registry.toml");
+
+    ConfigRegistry registry;
+    registry.add(main_cfg).add(network_cfg, "network").add(eos_cfg, "eos");
+    EXPECT_THROW(registry.add(eos_cfg), exceptions::ConfigLoadError);
+    EXPECT_EQ(registry.size(), 3u);
+    EXPECT_EQ(&registry.get<RichConfigSchema>("network"), &network_cfg);
+    EXPECT_THROW((void)registry.get<TestConfigSchema>("network"), exceptions::ConfigLoadError);
+    EXPECT_FALSE(registry.reload());
+
+    const auto before = registry.snapshot();
+    write_deck(replaced(replaced(deck, "time_step = 0.5", "time_step = 0.25"), "total_time = 42.0", "total_time = 43.0"));
+    EXPECT_TRUE(registry.reload());
+    const auto after = registry.snapshot();
+    EXPECT_GT(after->generation(), before->generation());
+    EXPECT_EQ(before->get<TestConfigSchema>("main")->simulation.time_step, 0.5);
+    EXPECT_EQ(after->get<TestConfigSchema>("main")->simulation.time_step, 0.25);
+    EXPECT_EQ(after->get<TestConfigSchema>("eos")->simulation.total_time, 43.0);
+    EXPECT_EQ(eos_cfg->simulation.total_time, 43.0);
+
+    // A root that no longer validates fails the whole reload; the other roots keep their content.
+    write_deck(replaced(replaced(deck, "time_step = 0.5", "time_step = 0.125"), "solver = \"EXPLICIT\"", "solver = \"NONE\""));
+    EXPECT_THROW(registry.reload(), exceptions::ConfigParseError);
+    EXPECT_EQ(main_cfg->simulation.time_step, 0.25);
+    EXPECT_EQ(registry.snapshot()->generation(), after->generation());
+    std::filesystem::remove("TestConfigSchema.registry.toml");
+}
+
+TEST_F(configTest, configs_can_be_moved_and_stored_in_containers) {
+    using namespace fourdst::config;
+    std::vector<Config<TestConfigSchema>> zones;
+    zones.emplace_back();
+    zones.front().load(get_good_example_file());
+    zones.front().set_history_limit(2);
+    zones.front().mutate([](TestConfigSchema& c) { c.simulation.time_step = 0.5; });
+    ConfigReader<TestConfigSchema> reader = zones.front().reader();
+
+    // Reallocation moves every config; state, history and readers survive.
+    for (int i = 0; i < 16; ++i) zones.emplace_back();
+    EXPECT_EQ(zones.front()->simulation.time_step, 0.5);
+    EXPECT_EQ(zones.front().get_state(), ConfigState::MODIFIED);
+    EXPECT_EQ(reader->simulation.time_step, 0.5);
+    EXPECT_TRUE(zones.front().undo());
+    EXPECT_EQ(reader->simulation.time_step, 0.01);
+
+    Config<TestConfigSchema> moved = std::move(zones.front());
+    zones.front() = std::move(zones.back());
+    zones.pop_back();
+    EXPECT_EQ(moved.get_source_path(), get_good_example_file());
+    EXPECT_EQ(zones.front().get_state(), ConfigState::DEFAULT);
+    moved.mutate([](TestConfigSchema& c) { c.simulation.time_step = 2.0; });
+    EXPECT_EQ(reader.snapshot(), moved.snapshot());
+}
+
+TEST_F(configTest, load_reports_phase_timings) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    LoadStats stats;
+    stats.bytes_read = 1;
+    cfg.load(get_good_example_file(), stats);
+    EXPECT_EQ(stats.bytes_read, std::filesystem::file_size(get_good_example_file()));
+    EXPECT_GT(stats.parse_time.count(), 0);
+    EXPECT_GT(stats.deserialize_time.count(), 0);
+    EXPECT_EQ(stats.validate_time.count(), 0);
+    EXPECT_GE(stats.total_time, stats.read_time + stats.parse_time + stats.deserialize_time);
+    EXPECT_EQ(cfg->simulation.time_step, 0.01);
+
+    Config<TestConfigSchema> broken;
+    EXPECT_THROW(broken.load(get_bad_example_file(BAD_FILES::INVALID_TYPE), stats), exceptions::ConfigParseError);
+    EXPECT_GT(stats.validate_time.count(), 0);
+
+    {
+        const io::ScopedLoadStats scope(stats);
+        io::note_allocation(64);
+        io::note_allocation(16);
+    }
+    ASSERT_TRUE(stats.allocations.has_value());
+    EXPECT_EQ(*stats.allocations, 2u);
+    EXPECT_EQ(*stats.allocated_bytes, 80u);
+}
+
+TEST_F(configTest, memory_report_sums_heap_per_field) {
+    using namespace fourdst::config;
+    Config<RichConfigSchema> cfg;
+    cfg.mutate([](RichConfigSchema& c) {
+        c.grid.reserve(64);
+        c.title.assign(200, 'x');
+    });
+
+    const MemoryReport report = cfg.memory_report();
+    EXPECT_EQ(report.root_name, "main");
+    EXPECT_EQ(report.total.inline_bytes, sizeof(RichConfigSchema));
+
+    const MemoryUsage* grid = report.find("grid");
+    ASSERT_NE(grid, nullptr);
+    EXPECT_EQ(grid->inline_bytes, sizeof(std::vector<std::vector<double>>));
+    EXPECT_GE(grid->heap_bytes, 64 * sizeof(std::vector<double>) + 3 * sizeof(double));
+    EXPECT_GE(grid->unused_bytes, 62 * sizeof(std::vector<double>));
+
+    const MemoryUsage* title = report.find("title");
+    ASSERT_NE(title, nullptr);
+    EXPECT_GE(title->heap_bytes, 201u);
+    EXPECT_EQ(report.find("whole")->heap_bytes, 0u);
+    EXPECT_EQ(report.find("nope"), nullptr);
+
+    std::size_t heap = 0;
+    for (const auto& entry : report.entries) {
+        if (entry.depth == 0) heap += entry.usage.heap_bytes;
+    }
+    EXPECT_EQ(heap, report.total.heap_bytes);
+
+    const std::string tree = report.str();
+    EXPECT_NE(tree.find("Configuration Memory [main]"), std::string::npos);
+    EXPECT_NE(tree.find("├── grid: "), std::string::npos);
+    EXPECT_NE(tree.find("└── output: "), std::string::npos);
+}
+
+TEST_F(configTest, parse_errors_carry_their_location) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> malformed;
+    try {
+        malformed.load(get_bad_example_file(BAD_FILES::MALFORMED));
+        FAIL() << "expected a parse error";
+    } catch (const exceptions::ConfigParseError& e) {
+        ASSERT_TRUE(e.location().has_value());
+        EXPECT_EQ(e.location()->file, get_bad_example_file(BAD_FILES::MALFORMED));
+        EXPECT_EQ(e.location()->line, 1u);
+        EXPECT_GT(e.location()->column, 0u);
+        EXPECT_TRUE(e.location()->field.empty());
+        EXPECT_NE(std::string(e.what()).find("example.malformed.toml:1:"), std::string::npos);
+    }
+
+    Config<TestConfigSchema> mistyped;
+    try {
+        mistyped.load(get_bad_example_file(BAD_FILES::INVALID_TYPE));
+        FAIL() << "expected a parse error";
+    } catch (const exceptions::ConfigParseError& e) {
+        ASSERT_TRUE(e.location().has_value());
+        EXPECT_EQ(e.location()->field, "main.physics.diffusion");
+        EXPECT_EQ(e.location()->line, 6u);
+        EXPECT_EQ(e.location()->column, 13u);
+        EXPECT_NE(std::string(e.what()).find("example.invalidtype.toml:6:13"), std::string::npos);
+    }
+
+    Config<TestConfigSchema> json;
+    json.set_file_format(FileFormat::JSON);
+    try {
+        json.load_from("{\"main\": {\n  \"description\": ]\n}}");
+        FAIL() << "expected a parse error";
+    } catch (const exceptions::ConfigParseError& e) {
+        ASSERT_TRUE(e.location().has_value());
+        EXPECT_EQ(e.location()->line, 2u);
+    }
+}
+
+TEST_F(configTest, generated_decks_load_back) {
+    using namespace fourdst::config;
+    GenerateOptions options;
+    options.array_length = 5;
+    options.table_array_count = 7;
+    options.string_length = 20;
+    options.map_size = 3;
+
+    const RichConfigSchema expected = generate<RichConfigSchema>(options);
+    EXPECT_EQ(expected.species.size(), 7u);
+    EXPECT_EQ(expected.no_species.size(), 7u);
+    EXPECT_EQ(expected.grid.size(), 5u);
+    EXPECT_EQ(expected.species[0].charges.size(), 5u);
+    EXPECT_EQ(expected.species[0].name.size(), 20u);
+    EXPECT_EQ(expected.abundances.size(), 3u);
+
+    Config<RichConfigSchema> cfg;
+    EXPECT_TRUE(cfg.load_from(generate_toml<RichConfigSchema>(options)));
+    EXPECT_TRUE(detail::equal(cfg.main(), expected));
+
+    EXPECT_EQ(generate_toml<RichConfigSchema>(options), generate_toml<RichConfigSchema>(options));
+    GenerateOptions reseeded = options;
+    reseeded.seed += 1;
+    EXPECT_NE(generate_toml<RichConfigSchema>(options), generate_toml<RichConfigSchema>(reseeded));
+}
+
+TEST_F(configTest, lock_stats_count_writer_contention) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    cfg.mutate([](auto& data) { data.simulation.time_step = 0.25; });
+    EXPECT_EQ(cfg.get_lock_stats().acquisitions, 0u);
+
+    cfg.set_lock_stats(true);
+    EXPECT_THROW(cfg.mutate([](auto& data) {
+        data.simulation.time_step = 8.0;
+        throw std::runtime_error("mutator failed");
+    }), std::runtime_error);
+    EXPECT_EQ(cfg->simulation.time_step, 0.25);
+    EXPECT_EQ(cfg.snapshot()->simulation.time_step, 0.25);
+
+    std::atomic<bool> holding{false};
+    std::thread writer([&] {
+        cfg.mutate([&](auto& data) {
+            holding = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            data.simulation.total_time = 50;
+        });
+    });
+    while (!holding) std::this_thread::yield();
+    cfg.mutate([](auto& data) { data.simulation.output_frequency = 3; });
+    writer.join();
+
+    const LockStats stats = cfg.get_lock_stats();
+    EXPECT_EQ(stats.acquisitions, 3u);
+    EXPECT_EQ(stats.contended, 1u);
+    EXPECT_GE(stats.max_wait, std::chrono::milliseconds(5));
+    EXPECT_GE(stats.max_held, std::chrono::milliseconds(20));
+    EXPECT_GE(stats.total_held, stats.max_held);
+    EXPECT_EQ(cfg->simulation.total_time, 50);
+    EXPECT_EQ(cfg->simulation.output_frequency, 3);
+
+    cfg.reset_lock_stats();
+    EXPECT_EQ(cfg.get_lock_stats().acquisitions, 0u);
+    EXPECT_EQ(cfg.get_lock_stats().max_held, std::chrono::nanoseconds(0));
+}
+
+TEST_F(configTest, metrics_render_operations_and_gauges_as_openmetrics) {
+    using namespace fourdst::config;
+    auto metrics = std::make_shared<ConfigMetrics>("physics");
+    Config<TestConfigSchema> cfg;
+    cfg.set_metrics(metrics);
+    EXPECT_EQ(cfg.get_metrics(), metrics);
+
+    cfg.load(get_good_example_file());
+    cfg.mutate([](auto& data) { data.simulation.time_step = 0.5; });
+    cfg.save("TestConfigSchema.metrics.toml");
+    EXPECT_NO_THROW(cfg.reload("TestConfigSchema.metrics.toml"));
+    EXPECT_GT(cfg.get_lock_stats().acquisitions, 0u);
+    cfg.set_metrics(nullptr);
+    EXPECT_EQ(cfg.get_metrics(), nullptr);
+
+    Config<TestConfigSchema> broken;
+    broken.set_metrics(metrics);
+    EXPECT_THROW(broken.load(get_bad_example_file(BAD_FILES::INVALID_TYPE)), exceptions::ConfigParseError);
+
+    std::array<char, 32 * 1024> buffer{};
+    const std::optional<std::size_t> size = metrics->render(buffer);
+    ASSERT_TRUE(size.has_value());
+    const std::string_view text(buffer.data(), *size);
+    EXPECT_TRUE(text.contains("# TYPE fourdst_config_operation_duration_seconds histogram\n"));
+    EXPECT_TRUE(text.contains("fourdst_config_operation_duration_seconds_count{config=\"physics\",operation=\"load\"} 2\n"));
+    EXPECT_TRUE(text.contains("fourdst_config_operation_duration_seconds_bucket{config=\"physics\",operation=\"reload\",le=\"+Inf\"} 1\n"));
+    EXPECT_TRUE(text.contains("fourdst_config_operation_duration_seconds_count{config=\"physics\",operation=\"save\"} 1\n"));
+    EXPECT_TRUE(text.contains("fourdst_config_operation_failures_total{config=\"physics\",operation=\"load\"} 1\n"));
+    EXPECT_TRUE(text.contains("fourdst_config_validation_failures_total{config=\"physics\"} 1\n"));
+    EXPECT_TRUE(text.contains("fourdst_config_read_bytes_total{config=\"physics\"} "));
+    EXPECT_FALSE(text.contains("fourdst_config_read_bytes_total{config=\"physics\"} 0\n"));
+    EXPECT_TRUE(text.contains(std::format("fourdst_config_generation{{config=\"physics\"}} {}\n", broken.generation())));
+    EXPECT_TRUE(text.contains("fourdst_config_lock_wait_seconds_count{config=\"physics\"} "));
+    EXPECT_TRUE(text.ends_with("# EOF\n"));
+
+    const auto snapshot_line = std::format("fourdst_config_snapshot_bytes{{config=\"physics\"}} {}\n",
+                                           sizeof(TestConfigSchema) + memory_report(*broken.snapshot(), "main").total.heap_bytes);
+    EXPECT_TRUE(text.contains(snapshot_line));
+
+    std::array<char, 64> small{};
+    EXPECT_FALSE(metrics->render(small).has_value());
+    ConfigMetrics other("other");
+    const auto both = render_openmetrics(buffer, {metrics.get(), &other});
+    ASSERT_TRUE(both.has_value());
+    EXPECT_TRUE(std::string_view(buffer.data(), *both).contains("fourdst_config_generation{config=\"other\"} 0\n"));
+}
+
+TEST_F(configTest, load_async_overlaps_and_reports_state) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> expected;
+    expected.load(get_good_example_file());
+
+    Config<TestConfigSchema> cfg;
+    auto loading = cfg.load_async(get_good_example_file());
+    const ConfigState during = cfg.get_state();
+    EXPECT_TRUE(during == ConfigState::LOADING || during == ConfigState::LOADED_FROM_FILE);
+    EXPECT_THROW(static_cast<void>(cfg.load_async(get_good_example_file())), exceptions::ConfigLoadError);
+
+    std::thread waiter([&] {
+        cfg.wait_loaded();
+        EXPECT_EQ(cfg.get_state(), ConfigState::LOADED_FROM_FILE);
+        EXPECT_TRUE(detail::equal(*cfg.snapshot(), expected.main()));
+    });
+    loading.get();
+    waiter.join();
+    EXPECT_EQ(cfg.get_state(), ConfigState::LOADED_FROM_FILE);
+    EXPECT_EQ(cfg.describe_state(), "LOADED_FROM_FILE");
+    EXPECT_THROW(static_cast<void>(cfg.load_async(get_good_example_file())), exceptions::ConfigLoadError);
+
+    Config<TestConfigSchema> broken;
+    auto failing = broken.load_async(get_bad_example_file(BAD_FILES::MALFORMED));
+    EXPECT_THROW(failing.get(), exceptions::ConfigParseError);
+    EXPECT_EQ(broken.get_state(), ConfigState::DEFAULT);
+}
+
+TEST_F(configTest, load_with_deadline_gives_up_and_keeps_content) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> expected;
+    expected.load(get_good_example_file());
+
+    Config<TestConfigSchema> cfg;
+    EXPECT_THROW(cfg.load(get_good_example_file(), LoadDeadline::clock::now()), exceptions::ConfigLoadTimeout);
+    std::stop_source cancel;
+    cancel.request_stop();
+    EXPECT_THROW(cfg.load(get_good_example_file(), cancel.get_token()), exceptions::ConfigLoadTimeout);
+    EXPECT_EQ(cfg.get_state(), ConfigState::DEFAULT);
+
+    std::stop_source shutdown;
+    cfg.load(get_good_example_file(), {std::chrono::seconds(30), shutdown.get_token()});
+    EXPECT_TRUE(detail::equal(*cfg.snapshot(), expected.main()));
+    EXPECT_FALSE(cfg.reload({}, std::chrono::seconds(30)));
+    EXPECT_THROW(cfg.reload({}, cancel.get_token()), exceptions::ConfigLoadTimeout);
+    EXPECT_TRUE(detail::equal(*cfg.snapshot(), expected.main()));
+    EXPECT_EQ(exceptions::ConfigErrorInfo::from(exceptions::ConfigLoadTimeout("late")).kind, exceptions::ConfigErrorKind::LOAD_TIMEOUT);
+
+#if defined(__unix__)
+    // A FIFO nobody writes to blocks open() as a stalled mount would.
+    const std::filesystem::path fifo = std::filesystem::temp_directory_path() / "fourdst_config_deadline.toml";
+    std::filesystem::remove(fifo);
+    ASSERT_EQ(mkfifo(fifo.c_str(), 0600), 0);
+    Config<TestConfigSchema> stalled;
+    EXPECT_THROW(stalled.load(fifo.string(), std::chrono::milliseconds(50)), exceptions::ConfigLoadTimeout);
+    EXPECT_EQ(stalled.get_state(), ConfigState::DEFAULT);
+    std::ofstream(fifo) << "";  // Releases the abandoned reader.
+    std::filesystem::remove(fifo);
+#endif
+}
+
+TEST_F(configTest, load_many_loads_members_concurrently) {
+    using namespace fourdst::config;
+    {
+        std::ofstream member("TestConfigSchema.member.toml");
+        member << "[main.simulation]\ntime_step = 0.5\n";
+    }
+    const std::vector<std::string> paths = {get_good_example_file(), get_bad_example_file(BAD_FILES::MALFORMED),
+                                            get_good_example_file(), "does_not_exist.toml"};
+    Config<TestConfigSchema> expected;
+    expected.load(get_good_example_file());
+
+    LoadManyOptions options;
+    options.max_threads = 2;
+    const auto batch = load_many<TestConfigSchema>(paths, options);
+    ASSERT_EQ(batch.configs.size(), 4u);
+    EXPECT_FALSE(batch.ok());
+    ASSERT_EQ(batch.failures.size(), 2u);
+    EXPECT_EQ(batch.failures[0].index, 1u);
+    EXPECT_EQ(batch.failures[1].index, 3u);
+    EXPECT_EQ(batch.failures[1].path, "does_not_exist.toml");
+    EXPECT_THROW(std::rethrow_exception(batch.failures[0].error), exceptions::ConfigParseError);
+    EXPECT_TRUE(detail::equal(batch.configs[0].main(), expected.main()));
+    EXPECT_TRUE(detail::equal(batch.configs[2].main(), expected.main()));
+    EXPECT_EQ(batch.configs[1].get_state(), ConfigState::DEFAULT);
+
+    std::vector<std::thread> pool;
+    options.base = get_good_example_file();
+    const std::vector<std::string> members(5, "TestConfigSchema.member.toml");
+    const auto layered = load_many<TestConfigSchema>(members, [&](std::function<void()> task) { pool.emplace_back(std::move(task)); }, options);
+    for (auto& thread : pool) thread.join();
+    EXPECT_TRUE(layered.ok());
+    // The calling thread is one of the two workers.
+    EXPECT_EQ(pool.size(), 1u);
+    for (const auto& member : layered.configs) {
+        EXPECT_EQ(member->simulation.time_step, 0.5);
+        EXPECT_EQ(member->author, expected->author);
+        EXPECT_EQ(member.get_source_path(), "TestConfigSchema.member.toml");
+    }
+}
+
+TEST_F(configTest, save_many_writes_members_with_bounded_writers) {
+    using namespace fourdst::config;
+    std::filesystem::remove_all("TestConfigSchema.saved");
+    std::filesystem::create_directories("TestConfigSchema.saved");
+    std::vector<Config<TestConfigSchema>> members(6);
+    for (std::size_t i = 0; i < members.size(); ++i) {
+        members[i].mutate([i](TestConfigSchema& c) { c.simulation.time_step = 0.25 * static_cast<double>(i + 1); });
+    }
+    const auto member_path = [](const std::size_t i) { return std::format("TestConfigSchema.saved/member_{}.toml", i); };
+
+    SaveManyOptions options;
+    options.max_threads = 3;
+    options.max_writers = 1;
+    const auto saved = save_many(members, member_path, options);
+    EXPECT_TRUE(saved.ok());
+    for (std::size_t i = 0; i < members.size(); ++i) {
+        Config<TestConfigSchema> loaded;
+        loaded.load(member_path(i));
+        EXPECT_EQ(loaded->simulation.time_step, members[i]->simulation.time_step);
+    }
+
+    // One member cannot be written, so under all_or_nothing none of the targets change.
+    members[0].mutate([](TestConfigSchema& c) { c.simulation.time_step = 9.0; });
+    options.all_or_nothing = true;
+    const auto partial = save_many(members, [&](const std::size_t i) {
+        return i == 4 ? std::string("TestConfigSchema.missing_dir/member.toml") : member_path(i);
+    }, options);
+    ASSERT_EQ(partial.failures.size(), 1u);
+    EXPECT_EQ(partial.failures[0].index, 4u);
+    EXPECT_THROW(std::rethrow_exception(partial.failures[0].error), exceptions::ConfigSaveError);
+    Config<TestConfigSchema> untouched;
+    untouched.load(member_path(0));
+    EXPECT_EQ(untouched->simulation.time_step, 0.25);
+    EXPECT_EQ(std::distance(std::filesystem::directory_iterator("TestConfigSchema.saved"), std::filesystem::directory_iterator{}), 6);
+
+    EXPECT_TRUE(save_many(members, member_path, options).ok());
+    Config<TestConfigSchema> committed;
+    committed.load(member_path(0));
+    EXPECT_EQ(committed->simulation.time_step, 9.0);
+
+    options.policy = SavePolicy::IN_PLACE;
+    EXPECT_THROW(static_cast<void>(save_many(members, member_path, options)), exceptions::ConfigSaveError);
+    std::filesystem::remove_all("TestConfigSchema.saved");
+}
+
+TEST_F(configTest, record_files_stream_members_through_one_file) {
+    using namespace fourdst::config;
+    const auto member = [](const int i) {
+        TestConfigSchema content{};
+        content.description = std::format("member {} with a name long enough to live on the heap", i);
+        content.simulation.output_frequency = i;
+        content.physics.flags = {i, i + 1, i + 2};
+        return content;
+    };
+
+    for (const RecordFormat format : {RecordFormat::JSON_LINES, RecordFormat::BINARY}) {
+        {
+            RecordWriter<TestConfigSchema> writer("TestConfigSchema.records", format);
+            for (int i = 0; i < 100; ++i) writer.write(member(i));
+            Config<TestConfigSchema> cfg;
+            cfg.mutate([&](TestConfigSchema& c) { c = member(100); });
+            writer.write(cfg);
+            EXPECT_EQ(writer.count(), 101u);
+        }
+
+        RecordReader<TestConfigSchema> reader("TestConfigSchema.records");
+        EXPECT_EQ(reader.format(), format);
+        int count = 0;
+        const void* buffer = nullptr;
+        for (const TestConfigSchema& content : reader) {
+            EXPECT_TRUE(equal(content, member(count)));
+            // Every record is read into the same buffer.
+            if (buffer == nullptr) buffer = &content;
+            EXPECT_EQ(&content, buffer);
+            EXPECT_EQ(reader.index(), static_cast<std::size_t>(count));
+            ++count;
+        }
+        EXPECT_EQ(count, 101);
+    }
+
+    // JSON Lines records written by other tools: blank lines are skipped, left-out fields keep their defaults.
+    std::ofstream("TestConfigSchema.records") << R"({"simulation": {"time_step": 0.5}})" << "\n\n"
+                                              << R"({"author": "tool"})" << "\n"
+                                              << R"({"simulation": {"time_step": "fast"}})" << "\n";
+    RecordReader<TestConfigSchema> reader("TestConfigSchema.records");
+    ASSERT_TRUE(reader.next());
+    EXPECT_EQ(reader.current().simulation.time_step, 0.5);
+    ASSERT_TRUE(reader.next());
+    EXPECT_EQ(reader.current().author, "tool");
+    EXPECT_EQ(reader.current().simulation.time_step, SimulationConfigOptions{}.time_step);
+    try {
+        reader.next();
+        FAIL() << "expected a ConfigParseError";
+    } catch (const exceptions::ConfigParseError& e) {
+        ASSERT_TRUE(e.location().has_value());
+        EXPECT_EQ(e.location()->line, 4u);
+    }
+
+    // A binary record file of another schema is rejected by its fingerprint.
+    RecordWriter<RichConfigSchema>("TestConfigSchema.records", RecordFormat::BINARY).close();
+    EXPECT_THROW(RecordReader<TestConfigSchema>("TestConfigSchema.records"), exceptions::ConfigLoadError);
+    std::filesystem::remove("TestConfigSchema.records");
+}
+
+TEST_F(configTest, default_executor_runs_all_parallel_work) {
+    using namespace fourdst::config;
+    ThreadPool pool(1);
+    std::atomic<int> submitted{0};
+    set_default_executor([&](std::function<void()> task) {
+        ++submitted;
+        pool(std::move(task));
+    });
+    struct Restore {
+        ~Restore() { set_default_executor({}); }
+    } restore;
+
+    LoadManyOptions options;
+    options.max_threads = 4;
+    const std::vector<std::string> paths(4, get_good_example_file());
+    EXPECT_TRUE(load_many<TestConfigSchema>(paths, options).ok());
+    EXPECT_EQ(submitted.load(), 3);
+
+    // A batch started from the pool's only thread finishes even though its tasks queue behind it.
+    std::promise<bool> nested;
+    pool([&] { nested.set_value(load_many<TestConfigSchema>(paths, options).ok()); });
+    auto nested_done = nested.get_future();
+    ASSERT_EQ(nested_done.wait_for(std::chrono::seconds(30)), std::future_status::ready);
+    EXPECT_TRUE(nested_done.get());
+
+    std::string text = "[main]\ntitle = \"t\"\n";
+    for (int i = 0; i < 100; ++i) text += i % 7 == 0 ? "\n[[main.species]]\nname = \"X\"\n" : "\n[[main.species]]\nname = \"H\"\nmass = 1.0\ncharges = [0]\n";
+    const toml::table tbl = toml::parse(text);
+    std::vector<validate::ValidationIssue> issues;
+    const int before_validation = submitted.load();
+    validate::ConfigValidator<RichConfigSchema>::validate(tbl.get("main")->as_table(), "main", issues,
+                                                          {.parallel_threshold = 16, .max_threads = 4});
+    EXPECT_EQ(submitted.load() - before_validation, 3);
+    EXPECT_EQ(std::ranges::count(issues, std::string("main.species[98].mass"), &validate::ValidationIssue::path), 1);
+
+    Config<TestConfigSchema> cfg;
+    const int before_load = submitted.load();
+    cfg.load_async(get_good_example_file()).get();
+    EXPECT_EQ(submitted.load() - before_load, 1);
+    EXPECT_EQ(cfg.get_state(), ConfigState::LOADED_FROM_FILE);
+}
+
+TEST_F(configTest, campaign_store_answers_field_queries) {
+    using namespace fourdst::config;
+    CampaignStore<TestConfigSchema> store({"physics.diffusion", "simulation.time_step"});
+    for (int i = 0; i < 8; ++i) {
+        TestConfigSchema run;
+        run.author = std::format("run {}", i);
+        run.physics.diffusion = i % 2 == 1;
+        run.simulation.time_step = 1e-4 * i;
+        store.add(run);
+        store.add(run);
+    }
+    Config<TestConfigSchema> loaded;
+    loaded.load(get_good_example_file());
+    const std::uint64_t loaded_key = store.add(loaded);
+    EXPECT_EQ(store.size(), 9u);
+    EXPECT_TRUE(store.contains(loaded_key));
+
+    const auto fast_diffusive = store.query({{"physics.diffusion", QueryOp::EQ, true}, {"simulation.time_step", QueryOp::LT, 5e-4}});
+    ASSERT_EQ(fast_diffusive.size(), 2u);
+    EXPECT_EQ(store.find(fast_diffusive[0])->author, "run 1");
+    EXPECT_EQ(store.find(fast_diffusive[1])->author, "run 3");
+
+    store.add_index("author");
+    EXPECT_EQ(store.query({{"author", QueryOp::EQ, loaded->author}}), std::vector<std::uint64_t>{loaded_key});
+    EXPECT_THROW(static_cast<void>(store.query({{"author", QueryOp::LT, 1}})), exceptions::ConfigPathError);
+    EXPECT_THROW(static_cast<void>(store.query({{"simulation.total_time", QueryOp::LT, 1.0}})), exceptions::ConfigPathError);
+    EXPECT_THROW(store.add_index("physics.flags"), exceptions::ConfigPathError);
+    EXPECT_THROW(store.add_index("physics.difusion"), exceptions::ConfigPathError);
+
+    store.save("TestConfigSchema.campaign.store");
+    const auto reopened = CampaignStore<TestConfigSchema>::open("TestConfigSchema.campaign.store");
+    EXPECT_EQ(reopened.keys(), store.keys());
+    EXPECT_EQ(reopened.indexed_paths(), store.indexed_paths());
+    EXPECT_EQ(reopened.query({{"simulation.time_step", QueryOp::GE, 5.5e-4}}).size(), 3u);
+    EXPECT_TRUE(detail::equal(*reopened.find(loaded_key), loaded.main()));
+    EXPECT_THROW(static_cast<void>(CampaignStore<TestConfigSchema>::open(get_good_example_file())), exceptions::ConfigLoadError);
+    std::filesystem::remove("TestConfigSchema.campaign.store");
+}
+
+TEST_F(configTest, lint_files_reports_every_problem_of_every_deck) {
+    using namespace fourdst::config;
+    std::filesystem::remove_all("TestConfigSchema.campaign");
+    std::filesystem::create_directories("TestConfigSchema.campaign/batch");
+    std::filesystem::copy_file(get_good_example_file(), "TestConfigSchema.campaign/good.toml");
+    {
+        std::ofstream bad("TestConfigSchema.campaign/batch/bad.toml");
+        bad << "[main]\ndescription = \"d\"\nauthor = 3\noutptu = 1\n\n"
+               "[main.physics]\ndiffusion = true\nflags = [1, 2]\n\n[main.simulation]\n[main.output]\n";
+        std::ofstream notes("TestConfigSchema.campaign/notes.txt");
+        notes << "not a deck";
+    }
+
+    const std::vector<std::string> decks = collect_decks({"TestConfigSchema.campaign", "does_not_exist.toml"});
+    ASSERT_EQ(decks.size(), 3u);
+    EXPECT_TRUE(decks[0].ends_with("bad.toml"));
+    EXPECT_TRUE(decks[1].ends_with("good.toml"));
+
+    LintOptions options;
+    options.max_threads = 2;
+    const LintSummary summary = lint_files<TestConfigSchema>(decks, options);
+    ASSERT_EQ(summary.reports.size(), 3u);
+    EXPECT_EQ(summary.failed(), 2u);
+    EXPECT_TRUE(summary.reports[1].ok());
+    EXPECT_FALSE(summary.reports[2].error.empty());
+    const auto& issues = summary.reports[0].issues;
+    EXPECT_EQ(summary.issue_count(), issues.size());
+    const auto has = [&](const validate::IssueKind kind, const std::string& path) {
+        return std::ranges::any_of(issues, [&](const auto& issue) { return issue.kind == kind && issue.path == path; });
+    };
+    EXPECT_TRUE(has(validate::IssueKind::TYPE_MISMATCH, "main.author"));
+    EXPECT_TRUE(has(validate::IssueKind::ARRAY_SIZE_MISMATCH, "main.physics.flags"));
+    EXPECT_TRUE(has(validate::IssueKind::UNKNOWN_KEY, "main.outptu"));
+
+    options.unknown_keys = UnknownKeyPolicy::ALLOW;
+    EXPECT_EQ(lint_file<TestConfigSchema>(decks[0], options).issues.size(), issues.size() - 1);
+
+    std::ostringstream out;
+    std::ostringstream err;
+    const char* valid_argv[] = {"deck_lint", "-j", "2", "TestConfigSchema.campaign/good.toml"};
+    EXPECT_EQ(validator_main<TestConfigSchema>(4, valid_argv, out, err), 0);
+    EXPECT_NE(out.str().find("1 file(s) checked in"), std::string::npos);
+    EXPECT_NE(out.str().find("1 valid, 0 invalid"), std::string::npos);
+
+    out.str("");
+    const char* campaign_argv[] = {"deck_lint", "TestConfigSchema.campaign"};
+    EXPECT_EQ(validator_main<TestConfigSchema>(2, campaign_argv, out, err), 1);
+    EXPECT_NE(out.str().find("bad.toml: "), std::string::npos);
+    EXPECT_NE(out.str().find("main.outptu: unknown key; did you mean 'output'?"), std::string::npos);
+
+    const char* usage_argv[] = {"deck_lint", "--frobnicate"};
+    EXPECT_EQ(validator_main<TestConfigSchema>(2, usage_argv, out, err), 2);
+    EXPECT_NE(err.str().find("unknown option --frobnicate"), std::string::npos);
+    std::filesystem::remove_all("TestConfigSchema.campaign");
+}
+
+TEST_F(configTest, compressed_files_round_trip) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> original;
+    original.load(get_good_example_file());
+    EXPECT_EQ(io::compression_for("deck.TOML.ZST"), io::Compression::ZSTD);
+    EXPECT_EQ(io::strip_compression_extension("deck.json.gz"), "deck.json");
+
+    const auto round_trip = [&](const std::string& path, const bool supported) {
+        SCOPED_TRACE(path);
+        if (!supported) {
+            EXPECT_THROW(original.save(path), exceptions::ConfigSaveError);
+            EXPECT_THROW(Config<TestConfigSchema>::save_schema(path + ".schema.gz"), exceptions::SchemaSaveError);
+            return;
+        }
+        original.set_compression_level(9);
+        original.save(path, SavePolicy::ATOMIC);
+        Config<TestConfigSchema> loaded;
+        loaded.load(path);
+        EXPECT_TRUE(detail::equal(loaded.main(), original.main()));
+
+        // The binary cache is keyed by the decompressed bytes.
+        Config<TestConfigSchema> cached;
+        cached.set_cache_policy(CachePolicy::READ_WRITE);
+        cached.load(path);
+        EXPECT_TRUE(detail::equal(cached.main(), original.main()));
+    };
+#if FOURDST_CONFIG_USE_ZSTD
+    round_trip("TestConfigSchema.compressed.toml.zst", true);
+#else
+    round_trip("TestConfigSchema.compressed.toml.zst", false);
+#endif
+#if FOURDST_CONFIG_USE_ZLIB
+    round_trip("TestConfigSchema.compressed.json.gz", true);
+    {
+        std::ofstream truncated("TestConfigSchema.truncated.toml.gz", std::ios::binary);
+        truncated << "\x1f\x8b\x08";
+    }
+    Config<TestConfigSchema> cfg;
+    EXPECT_THROW(cfg.load("TestConfigSchema.truncated.toml.gz"), exceptions::ConfigLoadError);
+#else
+    round_trip("TestConfigSchema.compressed.json.gz", false);
+#endif
+}
+
+namespace {
+    /**
+     * @brief A remote-like source that answers conditional fetches and counts full downloads.
+     */
+    class ScriptedSource final : public fourdst::config::ConfigSource {
+    public:
+        std::string content;
+        std::string etag = "\"v1\"";
+        bool offline = false;
+        int downloads = 0;
+
+        [[nodiscard]] std::string name() const override { return "https://configs.example.org/run.toml?X-Signature=abc"; }
+
+        fourdst::config::SourceData fetch(const fourdst::config::SourceValidator& known) override {
+            if (offline) throw fourdst::config::exceptions::ConfigLoadError("network is unreachable");
+            fourdst::config::SourceData data;
+            data.validator.etag = etag;
+            if (known.etag == etag) {
+                data.not_modified = true;
+                return data;
+            }
+            ++downloads;
+            data.content = content;
+            return data;
+        }
+    };
+}
+
+TEST_F(configTest, sources_revalidate_and_cache_remote_documents) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> expected;
+    expected.load(get_good_example_file());
+
+    Config<TestConfigSchema> from_file;
+    from_file.load(std::make_shared<FileSource>(get_good_example_file()));
+    EXPECT_TRUE(detail::equal(from_file.main(), expected.main()));
+    EXPECT_EQ(from_file.get_source_path(), get_good_example_file());
+    EXPECT_FALSE(from_file.reload());
+
+    std::ifstream in(get_good_example_file());
+    const std::string text{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    auto remote = std::make_shared<ScriptedSource>();
+    remote->content = text;
+    const std::string directory = "TestConfigSchema.source_cache";
+    std::filesystem::remove_all(directory);
+    auto cached = std::make_shared<CachedSource>(remote, directory);
+    EXPECT_TRUE(cached->cache_path().ends_with(".toml"));
+
+    Config<TestConfigSchema> first;
+    first.load(cached);
+    EXPECT_EQ(remote->downloads, 1);
+    EXPECT_TRUE(detail::equal(first.main(), expected.main()));
+    EXPECT_FALSE(first.reload());
+    EXPECT_EQ(remote->downloads, 1);
+
+    // A second job revalidates the cached copy instead of downloading it.
+    Config<TestConfigSchema> second;
+    second.load(cached);
+    EXPECT_EQ(remote->downloads, 1);
+    EXPECT_TRUE(detail::equal(second.main(), expected.main()));
+
+    remote->content = text + "\n[main.simulation]\ntime_step = 0.25\n";
+    remote->etag = "\"v2\"";
+    EXPECT_THROW(first.reload(), exceptions::ConfigParseError);
+    remote->content = text;
+    remote->content.replace(remote->content.find("time_step = 0.01"), 16, "time_step = 0.25");
+    remote->etag = "\"v3\"";
+    EXPECT_TRUE(first.reload());
+    EXPECT_EQ(first->simulation.time_step, 0.25);
+    EXPECT_EQ(remote->downloads, 3);
+
+    remote->offline = true;
+    Config<TestConfigSchema> stale;
+    stale.load(cached);
+    EXPECT_EQ(stale->simulation.time_step, 0.25);
+    EXPECT_THROW(Config<TestConfigSchema>().load(std::make_shared<CachedSource>(remote, directory, false)),
+                 exceptions::ConfigLoadError);
+
+    auto memory = std::make_shared<MemorySource>(text);
+    Config<TestConfigSchema> from_memory;
+    from_memory.load(memory);
+    EXPECT_FALSE(from_memory.reload());
+    memory->set_content(remote->content);
+    EXPECT_TRUE(from_memory.reload());
+    EXPECT_TRUE(from_memory.reload(get_good_example_file()));
+    EXPECT_FALSE(from_memory.reload());  // re-reads the file now, not the source
+}
+
+TEST_F(configTest, reload_skips_files_whose_bytes_did_not_change) {
+    using namespace fourdst::config;
+    const std::string path = "TestConfigSchema.stamped.toml";
+    std::ifstream in(get_good_example_file());
+    std::string text{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    std::ofstream(path) << text;
+
+    Config<TestConfigSchema> cfg;
+    cfg.load(path);
+    const auto loaded = cfg.snapshot();
+
+    // A touch changes only the time; the bytes are hashed and found equal.
+    const auto stamped = std::filesystem::last_write_time(path);
+    std::filesystem::last_write_time(path, stamped + std::chrono::seconds(10));
+    EXPECT_FALSE(cfg.reload());
+    EXPECT_EQ(cfg.snapshot(), loaded);
+
+    // Same size and time, new bytes: a file written in the tick it was stamped in is hashed, not trusted.
+    text.replace(text.find("time_step = 0.01"), 16, "time_step = 0.02");
+    std::ofstream(path) << text;
+    std::filesystem::last_write_time(path, stamped + std::chrono::seconds(10));
+    EXPECT_TRUE(cfg.reload());
+    EXPECT_EQ(cfg->simulation.time_step, 0.02);
+
+    // Unsaved mutations are still discarded by a reload of an unchanged file.
+    cfg.mutate([](auto& data) { data.simulation.time_step = 1.0; });
+    EXPECT_TRUE(cfg.reload());
+    EXPECT_EQ(cfg->simulation.time_step, 0.02);
+
+    // So are the values of overrides dropped since the last read.
+    cfg.set_override("simulation.time_step", 3.0);
+    EXPECT_FALSE(cfg.reload());
+    cfg.clear_overrides();
+    EXPECT_TRUE(cfg.reload());
+    EXPECT_EQ(cfg->simulation.time_step, 0.02);
+}
+
+TEST_F(configTest, incremental_reload_patches_changed_tables) {
+    using namespace fourdst::config;
+    const std::string path = "TestConfigSchema.incremental.toml";
+    std::ifstream in(get_good_example_file());
+    std::string text{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    std::ofstream(path) << text;
+
+    Config<TestConfigSchema> cfg;
+    cfg.set_incremental_reload(true);
+    cfg.load(path);
+    const std::string directory = cfg->output.directory;
+
+    int simulation_calls = 0;
+    int output_calls = 0;
+    cfg.subscribe("simulation", [&](const auto&) { ++simulation_calls; });
+    cfg.subscribe("output", [&](const auto&) { ++output_calls; });
+
+    text.replace(text.find("time_step = 0.01"), 16, "time_step = 0.05");
+    std::ofstream(path) << text;
+    EXPECT_TRUE(cfg.reload());
+    EXPECT_EQ(cfg->simulation.time_step, 0.05);
+    EXPECT_EQ(cfg->output.directory, directory);
+    EXPECT_EQ(simulation_calls, 1);
+    EXPECT_EQ(output_calls, 0);
+
+    // A value that does not match its field falls back to a full read, which reports it.
+    text.replace(text.find("time_step = 0.05"), 16, "time_step = \"x\"");
+    std::ofstream(path) << text;
+    EXPECT_THROW(cfg.reload(), exceptions::ConfigParseError);
+    EXPECT_EQ(cfg->simulation.time_step, 0.05);
+
+    // The patched content matches a full load of the same file.
+    text.replace(text.find("time_step = \"x\""), 15, "time_step = 0.5");
+    std::ofstream(path) << text;
+    EXPECT_TRUE(cfg.reload());
+    Config<TestConfigSchema> full;
+    full.load(path);
+    EXPECT_TRUE(detail::equal(*cfg.snapshot(), *full.snapshot()));
+    EXPECT_EQ(output_calls, 0);
+}
+
+TEST_F(configTest, format_preserving_saves_rewrite_only_changed_values) {
+    using namespace fourdst::config;
+    const std::string path = "TestConfigSchema.splice.toml";
+    std::ifstream in(get_good_example_file());
+    std::string text{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    text.insert(text.find("[main.simulation]"), "# Tuned by hand; keep.\n");
+    text.replace(text.find("time_step = 0.01"), 16, "time_step = 0.01   # CFL-limited");
+    std::ofstream(path) << text;
+
+    Config<TestConfigSchema> cfg;
+    cfg.set_format_preserving_saves(true);
+    cfg.load(path);
+    const auto file_text = [&path] {
+        std::ifstream file(path);
+        return std::string{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    };
+
+    // Same-length text is overwritten where it is; the rest of the file keeps its bytes.
+    cfg.mutate([](TestConfigSchema& c) { c.simulation.time_step = 0.25; });
+    cfg.save(path);
+    text.replace(text.find("time_step = 0.01"), 16, "time_step = 0.25");
+    EXPECT_EQ(file_text(), text);
+
+    // Longer and shorter text moves the values after it, which later saves still find.
+    cfg.mutate([](TestConfigSchema& c) { c.author = "Ada"; });
+    cfg.save(path, SavePolicy::ATOMIC);
+    text.replace(text.find("\"Example Author\""), 16, "\"Ada\"");
+    EXPECT_EQ(file_text(), text);
+    cfg.mutate([](TestConfigSchema& c) {
+        c.description = "A much longer description of this example configuration.";
+        c.simulation.output_frequency = 25;
+    });
+    cfg.save(path);
+    text.replace(text.find("\"This is an example configuration file.\""), 40,
+                 "\"A much longer description of this example configuration.\"");
+    text.replace(text.find("output_frequency = 10"), 21, "output_frequency = 25");
+    EXPECT_EQ(file_text(), text);
+
+    Config<TestConfigSchema> reloaded;
+    reloaded.load(path);
+    EXPECT_TRUE(detail::equal(*cfg.snapshot(), *reloaded.snapshot()));
+
+    // Clearing an optional has no text to replace, so the file is written in full.
+    cfg.mutate([](TestConfigSchema& c) { c.physics.convection.reset(); });
+    cfg.save(path);
+    EXPECT_EQ(file_text().find("# Tuned by hand"), std::string::npos);
+    Config<TestConfigSchema> full;
+    full.load(path);
+    EXPECT_FALSE(full->physics.convection.has_value());
+    EXPECT_EQ(full->simulation.time_step, 0.25);
+}
+
+TEST_F(configTest, parse_limits_reject_oversized_documents) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    cfg.set_parse_limits({.max_array_length = 2});
+    try {
+        cfg.load(get_good_example_file());
+        FAIL() << "An array longer than the limit should fail the load.";
+    } catch (const exceptions::ConfigParseError& e) {
+        ASSERT_TRUE(e.location().has_value());
+        EXPECT_EQ(e.location()->line, 9u);
+        EXPECT_NE(std::string(e.what()).find("more than the 2 elements"), std::string::npos);
+    }
+
+    cfg.set_parse_limits({.max_file_bytes = 64});
+    EXPECT_THROW(cfg.load(get_good_example_file()), exceptions::ConfigParseError);
+
+    std::string deep = "[main.physics]\nflags = " + std::string(10000, '[') + std::string(10000, ']') + "\n";
+    cfg.set_parse_limits({.max_depth = 8});
+    EXPECT_THROW(cfg.load_from(deep), exceptions::ConfigParseError);
+    cfg.set_parse_limits({.max_tree_bytes = 1024});
+    EXPECT_THROW(cfg.load_from(R"({"main": {"physics": {"flags": [1, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1]}}})"), exceptions::ConfigParseError);
+
+    // Within its limits the deck loads as before.
+    cfg.set_parse_limits({.max_file_bytes = 4096, .max_array_length = 3, .max_depth = 3, .max_tree_bytes = 1 << 16});
+    cfg.load(get_good_example_file());
+    EXPECT_EQ(cfg->simulation.time_step, 0.01);
+}
+
+TEST_F(configTest, adversarial_missing_field_report_lists_every_field) {
+    using namespace fourdst::config;
+    // Timing over up to 10^6 fields is in adversarialTest.cpp (the "adversarial" suite).
+    std::vector<std::string> missing;
+    for (std::size_t i = 0; i < 1000; ++i) missing.push_back(std::format("main.table{}.field{}", i % 10, i));
+    const std::string report = validate::report_all_missing_fields(missing);
+    EXPECT_NE(report.find("field0"), std::string::npos);
+    EXPECT_NE(report.find("field999"), std::string::npos);
+}
+
+TEST_F(configTest, adversarial_long_keys_are_reported_as_unknown) {
+    using namespace fourdst::config;
+    toml::table main;
+    main.insert("description", "x");
+    main.insert(std::string(4096, 'k'), 1);
+    main.insert(std::string(4096, 'a') + "uthor", 1);
+    std::vector<validate::ValidationIssue> issues;
+    validate::ConfigValidator<TestConfigSchema>::validate(&main, "main", issues);
+    EXPECT_EQ(std::ranges::count(issues, validate::IssueKind::UNKNOWN_KEY, &validate::ValidationIssue::kind), 2);
+}
+
+TEST_F(configTest, adversarial_huge_arrays_load_and_are_reported_once) {
+    using namespace fourdst::config;
+    std::string deck = "[main]\ngrid = [[";
+    for (std::size_t i = 0; i < 4096; ++i) deck += "1.5, ";
+    deck += "]]\n";
+    Config<RichConfigSchema> cfg;
+    cfg.set_missing_field_policy(MissingFieldPolicy::USE_DEFAULTS);
+    cfg.load_from(deck);
+    EXPECT_EQ(cfg->grid.front().size(), 4096u);
+
+    // A wrong-length fixed array is reported once, however long it is.
+    toml::table main;
+    toml::array flags;
+    for (std::size_t i = 0; i < 4096; ++i) flags.push_back(1);
+    toml::table physics;
+    physics.insert("diffusion", true);
+    physics.insert("flags", std::move(flags));
+    main.insert("physics", std::move(physics));
+    std::vector<validate::ValidationIssue> issues;
+    validate::ConfigValidator<TestConfigSchema>::validate(&main, "main", issues);
+    EXPECT_EQ(std::ranges::count(issues, std::string("main.physics.flags"), &validate::ValidationIssue::path), 1);
+}
+
+TEST_F(configTest, adversarial_deep_nesting_fails_fast) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    // toml++ bounds the nesting of arrays and inline tables on its own.
+    EXPECT_THROW(cfg.load_from("[main]\nflags = " + std::string(10'000, '[') + std::string(10'000, ']') + "\n"),
+                 exceptions::ConfigParseError);
+    // So does the pre-scan for large numeric arrays, which hands such documents to toml++ rather than recursing.
+    Config<InlistSchema> inlist;
+    EXPECT_THROW(inlist.load_from("[main.controls]\nx_ctrl = " + std::string(10'000, '[') + std::string(10'000, ']') + "\n"),
+                 exceptions::ConfigParseError);
+
+    // Table headers nest without bound in toml++; the parse limits stop them before a table is built.
+    cfg.set_parse_limits({.max_depth = 64});
+    std::string header = "[main";
+    for (int i = 0; i < 10'000; ++i) header += ".x";
+    EXPECT_THROW(cfg.load_from(header + "]\nkey = 1\n"), exceptions::ConfigParseError);
+}
+
+TEST_F(configTest, mutation_queue_batches_mutations_of_many_threads) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    const std::uint64_t generation = cfg.generation();
+    {
+        ConfigMutationQueue<TestConfigSchema> queue(cfg);
+        std::vector<std::thread> producers;
+        for (int t = 0; t < 4; ++t) {
+            producers.emplace_back([&queue] {
+                for (int i = 0; i < 1000; ++i) {
+                    queue.mutate([](TestConfigSchema& c) { c.simulation.output_frequency += 1; });
+                }
+            });
+        }
+        for (auto& producer : producers) producer.join();
+        queue.flush();
+        EXPECT_EQ(cfg->simulation.output_frequency, 4001);
+        EXPECT_EQ(queue.applied(), 4000u);
+        EXPECT_EQ(cfg.generation() - generation, queue.batches());
+        EXPECT_LE(queue.batches(), 4000u);
+
+        // A throwing mutator is dropped alone; the rest of its batch still applies, in order.
+        queue.mutate([](TestConfigSchema& c) { c.author = "first"; });
+        queue.mutate([](TestConfigSchema&) { throw std::runtime_error("rejected"); });
+        queue.mutate([](TestConfigSchema& c) { c.author += " second"; });
+        EXPECT_THROW(queue.flush(), std::runtime_error);
+        EXPECT_EQ(cfg->author, "first second");
+        EXPECT_NO_THROW(queue.flush());
+
+        queue.mutate([](TestConfigSchema& c) { c.author = "on destruction"; });
+    }
+    EXPECT_EQ(cfg->author, "on destruction");
+}
+
+TEST_F(configTest, autosaver_coalesces_mutations_into_few_writes) {
+    using namespace fourdst::config;
+    const std::string path = "TestConfigSchema.autosave.toml";
+    std::filesystem::remove(path);
+
+    Config<TestConfigSchema> cfg;
+    cfg.load(get_good_example_file());
+    {
+        ConfigAutosaver autosave(cfg, path, std::chrono::hours(1));
+        EXPECT_FALSE(autosave.dirty());
+        EXPECT_FALSE(autosave.flush());
+
+        for (int i = 1; i <= 100; ++i) {
+            cfg.mutate([i](auto& data) { data.simulation.output_frequency = i; });
+        }
+        // The first change is written at once; the rest wait for the interval.
+        EXPECT_LE(autosave.writes(), 1u);
+        EXPECT_TRUE(autosave.flush());
+        EXPECT_FALSE(autosave.dirty());
+        EXPECT_LE(autosave.writes(), 2u);
+
+        Config<TestConfigSchema> saved;
+        saved.load(path);
+        EXPECT_EQ(saved->simulation.output_frequency, 100);
+
+        cfg.mutate([](auto& data) { data.simulation.output_frequency = 7; });
+    }
+
+    // Destruction writes the pending change.
+    Config<TestConfigSchema> saved;
+    saved.load(path);
+    EXPECT_EQ(saved->simulation.output_frequency, 7);
+    std::filesystem::remove(path);
+}
+
+TEST_F(configTest, save_async_writes_the_snapshot_taken_at_the_call) {
+    using namespace fourdst::config;
+    const std::string path = "TestConfigSchema.async.toml";
+
+    Config<TestConfigSchema> cfg;
+    cfg.load(get_good_example_file());
+    cfg.mutate([](auto& data) { data.simulation.output_frequency = 11; });
+    auto checkpoint = cfg.save_async(path);
+    cfg.mutate([](auto& data) { data.simulation.output_frequency = 12; });
+    checkpoint.get();
+
+    Config<TestConfigSchema> saved;
+    saved.load(path);
+    EXPECT_EQ(saved->simulation.output_frequency, 11);
+    std::filesystem::remove(path);
+
+    auto failed = cfg.save_async("no_such_directory/TestConfigSchema.async.toml");
+    EXPECT_THROW(failed.get(), exceptions::ConfigSaveError);
+}
+
+TEST_F(configTest, cache_hit_skips_parsing_and_validation) {
+    using namespace fourdst::config;
+    const std::string path = "TestConfigSchema.validated.toml";
+    std::filesystem::copy_file(get_good_example_file(), path, std::filesystem::copy_options::overwrite_existing);
+    std::filesystem::remove(io::cache_path_for(path));
+
+    Config<TestConfigSchema> cold;
+    cold.set_cache_policy(CachePolicy::READ_WRITE);
+    LoadStats cold_stats;
+    cold.load(path, cold_stats);
+    EXPECT_GT(cold_stats.parse_time.count(), 0);
+    EXPECT_EQ(cold_stats.validate_time.count(), 0);
+
+    Config<TestConfigSchema> warm;
+    warm.set_cache_policy(CachePolicy::READ_ONLY);
+    LoadStats warm_stats;
+    warm.load(path, warm_stats);
+    EXPECT_EQ(warm_stats.parse_time.count(), 0);
+    EXPECT_EQ(warm_stats.validate_time.count(), 0);
+    EXPECT_TRUE(detail::equal(warm.main(), cold.main()));
+
+    std::filesystem::remove(io::cache_path_for(path));
+    std::filesystem::remove(path);
+}
+
+struct VersionedSchema {
+    int config_version = 3;
+    double time_step = 0.1;
+    int substeps = 1;
+};
+
+TEST_F(configTest, versioned_schemas_migrate_old_documents_on_load) {
+    using namespace fourdst::config;
+    // Version 1 called the step "dt"; version 2 had no format change; version 3 added substeps.
+    register_migration<VersionedSchema>(1, [](toml::table& root) {
+        if (const toml::node* dt = root.get("dt")) {
+            root.insert_or_assign("time_step", dt->value_or(0.0));
+            root.erase("dt");
+        }
+    });
+    register_migration<VersionedSchema>(2, [](toml::table& root) { root.insert_or_assign("substeps", 4); });
+
+    const std::string path = "VersionedSchema.toml";
+    std::ofstream(path) << "[main]\nconfig_version = 1\ndt = 0.5\n";
+    Config<VersionedSchema> old_deck;
+    old_deck.load(path);
+    EXPECT_EQ(old_deck->config_version, 3);
+    EXPECT_EQ(old_deck->time_step, 0.5);
+    EXPECT_EQ(old_deck->substeps, 4);
+
+    // The saved file is current and loads without migrating.
+    old_deck.save(path);
+    Config<VersionedSchema> current;
+    current.load(path);
+    EXPECT_TRUE(detail::equal(current.main(), old_deck.main()));
+
+    std::ofstream(path) << "[main]\nconfig_version = 4\ntime_step = 0.5\nsubsteps = 1\n";
+    Config<VersionedSchema> newer;
+    EXPECT_THROW(newer.load(path), exceptions::ConfigLoadError);
+    std::filesystem::remove(path);
+}
+
+struct RenamedPhysics {
+    double time_step = 0.1;
+    double diffusion = 1.0;
+    int substeps = 1;
+};
+
+struct AliasedSchema {
+    RenamedPhysics physics;
+    std::string integrator = "rk4";
+};
+
+template <>
+struct fourdst::config::field_aliases<RenamedPhysics> {
+    static constexpr std::array aliases = {FieldAlias{"time_step", "dt"}, FieldAlias{"diffusion", "transport.diffusion"}};
+};
+
+TEST_F(configTest, field_aliases_read_old_keys_in_the_same_pass) {
+    using namespace fourdst::config;
+    const std::string path = "AliasedSchema.toml";
+    std::ofstream(path) << "[main]\nintegrator = \"euler\"\n[main.physics]\ndt = 0.5\nsubsteps = 3\n"
+                           "[main.physics.transport]\ndiffusion = 2.5\n";
+    Config<AliasedSchema> cfg;
+    cfg.set_unknown_key_policy(UnknownKeyPolicy::REJECT);
+    ASSERT_NO_THROW(cfg.load(path));
+    EXPECT_EQ(cfg->physics.time_step, 0.5);
+    EXPECT_EQ(cfg->physics.diffusion, 2.5);
+    EXPECT_EQ(cfg->physics.substeps, 3);
+
+    // Defaults merged in under the new names do not shadow the old ones.
+    std::ofstream(path) << "[main.physics]\ndt = 0.25\n";
+    Config<AliasedSchema> sparse;
+    sparse.set_missing_field_policy(MissingFieldPolicy::USE_DEFAULTS);
+    ASSERT_NO_THROW(sparse.load(path));
+    EXPECT_EQ(sparse->physics.time_step, 0.25);
+    EXPECT_EQ(sparse->physics.diffusion, 1.0);
+
+    std::ofstream(path) << "[main]\nintegrator = \"euler\"\n[main.physics]\ndt = \"fast\"\n";
+    try {
+        Config<AliasedSchema> broken;
+        broken.load(path);
+        FAIL() << "expected a ConfigParseError";
+    } catch (const exceptions::ConfigParseError& e) {
+        const std::string message = e.what();
+        EXPECT_NE(message.find("main.physics.time_step: expected float, found string"), std::string::npos);
+        EXPECT_NE(message.find("main.physics.diffusion: missing required field"), std::string::npos);
+    }
+
+    std::ofstream(path) << "[main]\nintegrator = \"euler\"\n[main.physics]\ndt = 0.5\ndiffusion = 1.5\nsubsteps = 2\n";
+    const toml::table document = toml::parse_file(path);
+    std::vector<validate::ValidationIssue> issues;
+    std::string key_path = "main";
+    validate::ConfigValidator<AliasedSchema>::check_aliases(*document["main"].as_table(), key_path, issues);
+    ASSERT_EQ(issues.size(), 1u);
+    EXPECT_EQ(issues[0].kind, validate::IssueKind::DEPRECATED_KEY);
+    EXPECT_EQ(issues[0].path, "main.physics.dt");
+    EXPECT_EQ(issues[0].message, "renamed to 'main.physics.time_step'");
+
+    Config<AliasedSchema> strict;
+    strict.set_deprecated_key_policy(DeprecatedKeyPolicy::REJECT);
+    EXPECT_THROW(strict.load(path), exceptions::ConfigParseError);
+    std::filesystem::remove(path);
+}
+
+struct ConstrainedSchema {
+    rfl::Validator<double, rfl::ExclusiveMinimum<0>> time_step = 0.5;
+    rfl::Validator<int, rfl::Minimum<1>> substeps = 1;
+    std::string integrator = "rk4";
+};
+
+TEST_F(configTest, validator_constraints_are_reported_with_other_issues) {
+    using namespace fourdst::config;
+    const std::string path = "ConstrainedSchema.toml";
+    std::ofstream(path) << "[main]\ntime_step = -0.1\nsubsteps = 2\n";
+    Config<ConstrainedSchema> cfg;
+    try {
+        cfg.load(path);
+        FAIL() << "expected a ConfigParseError";
+    } catch (const exceptions::ConfigParseError& e) {
+        const std::string message = e.what();
+        EXPECT_NE(message.find("main.time_step"), std::string::npos) << message;
+        EXPECT_NE(message.find("main.integrator"), std::string::npos) << message;
+        EXPECT_EQ(message.find("main.substeps"), std::string::npos) << message;
+    }
+
+    std::ofstream(path) << "[main]\ntime_step = 0.25\nsubsteps = 2\nintegrator = \"euler\"\n";
+    cfg.load(path);
+    EXPECT_EQ(cfg->time_step.value(), 0.25);
+    EXPECT_EQ(cfg->substeps.value(), 2);
+    EXPECT_NE(Config<ConstrainedSchema>::schema().find("exclusiveMinimum"), std::string::npos);
+    std::filesystem::remove(path);
+}
+
+TEST_F(configTest, mutations_that_break_a_constraint_are_rolled_back) {
+    using namespace fourdst::config;
+    Config<ConstrainedSchema> cfg;
+    const std::uint64_t generation = cfg.generation();
+    try {
+        cfg.mutate([](ConstrainedSchema& c) {
+            c.time_step.value() = -1.0;
+            c.integrator = "euler";
+        });
+        FAIL() << "expected a ConfigValidationError";
+    } catch (const exceptions::ConfigValidationError& e) {
+        const std::string message = e.what();
+        EXPECT_NE(message.find("time_step"), std::string::npos) << message;
+        EXPECT_EQ(message.find("substeps"), std::string::npos) << message;
+    }
+    EXPECT_EQ(cfg.generation(), generation);
+    EXPECT_EQ(cfg->time_step.value(), 0.5);
+    EXPECT_EQ(cfg->integrator, "rk4");
+
+    EXPECT_THROW(cfg.transaction([](ConstrainedSchema& c) { c.substeps.value() = 0; }), exceptions::ConfigValidationError);
+    EXPECT_EQ(cfg->substeps.value(), 1);
+
+    cfg.mutate([](ConstrainedSchema& c) { c.time_step.value() = 0.25; });
+    EXPECT_EQ(cfg->time_step.value(), 0.25);
+
+    cfg.set_mutation_validation(false);
+    cfg.mutate([](ConstrainedSchema& c) { c.substeps.value() = 0; });
+    EXPECT_EQ(cfg->substeps.value(), 0);
+}
+
+struct SparseSolver {
+    double tolerance = 1e-8;
+    int max_iterations = 100;
+};
+
+struct SparseSchema {
+    SparseSolver solver;
+    std::string name = "run";
+    std::vector<double> weights = {1.0, 2.0};
+};
+
+TEST_F(configTest, sparse_save_writes_only_non_default_fields) {
+    using namespace fourdst::config;
+    const std::string path = "SparseSchema.toml";
+    Config<SparseSchema> cfg;
+    cfg.mutate([](SparseSchema& data) { data.solver.max_iterations = 250; });
+    cfg.save(path, SaveMode::NON_DEFAULT_ONLY);
+
+    const toml::table written = toml::parse_file(path);
+    EXPECT_EQ(written["main"]["solver"]["max_iterations"].value<int>(), 250);
+    EXPECT_FALSE(written["main"]["solver"]["tolerance"]);
+    EXPECT_FALSE(written["main"]["name"]);
+    EXPECT_FALSE(written["main"]["weights"]);
+
+    Config<SparseSchema> strict;
+    EXPECT_THROW(strict.load(path), exceptions::ConfigParseError);
+
+    Config<SparseSchema> restored;
+    restored.set_missing_field_policy(MissingFieldPolicy::USE_DEFAULTS);
+    restored.load(path);
+    EXPECT_TRUE(detail::equal(restored.main(), cfg.main()));
+    std::filesystem::remove(path);
+}
+
+TEST_F(configTest, save_patch_writes_only_fields_changed_since_load) {
+    using namespace fourdst::config;
+    const std::string base_path = "SparseSchema.base.toml";
+    const std::string patch_path = "SparseSchema.patch.toml";
+    Config<SparseSchema> base;
+    base.mutate([](SparseSchema& data) { data.name = "base"; });
+    base.save(base_path);
+
+    Config<SparseSchema> cfg;
+    cfg.load(base_path);
+    cfg.mutate([](SparseSchema& data) {
+        data.solver.tolerance = 1e-10;
+        data.weights.push_back(3.0);
+    });
+    cfg.save_patch(patch_path);
+
+    const toml::table written = toml::parse_file(patch_path);
+    EXPECT_EQ(written["main"]["solver"]["tolerance"].value<double>(), 1e-10);
+    EXPECT_FALSE(written["main"]["solver"]["max_iterations"]);
+    EXPECT_FALSE(written["main"]["name"]);
+    EXPECT_EQ(written["main"]["weights"].as_array()->size(), 3u);
+
+    Config<SparseSchema> resumed;
+    resumed.load(base_path);
+    std::ifstream in(patch_path);
+    resumed.apply_patch(std::string(std::istreambuf_iterator<char>(in), {}));
+    EXPECT_TRUE(detail::equal(resumed.main(), cfg.main()));
+    std::filesystem::remove(base_path);
+    std::filesystem::remove(patch_path);
+}
+
+TEST_F(configTest, strict_unknown_keys_are_rejected_with_suggestions) {
+    using namespace fourdst::config;
+    const std::string path = "SparseSchema.strict.toml";
+    std::ofstream(path) << "[main]\nname = \"run\"\nweights = [1.0]\nwieghts = [2.0]\n\n"
+                           "[main.solver]\ntolerance = 1e-6\nmax_iterations = 10\ntolerence = 1e-7\n";
+    Config<SparseSchema> lenient;
+    EXPECT_NO_THROW(lenient.load(path));
+
+    Config<SparseSchema> strict;
+    strict.set_unknown_key_policy(UnknownKeyPolicy::REJECT);
+    try {
+        strict.load(path);
+        FAIL() << "expected ConfigParseError";
+    } catch (const exceptions::ConfigParseError& e) {
+        const std::string_view message = e.what();
+        EXPECT_NE(message.find("main.wieghts: unknown key; did you mean 'weights'?"), std::string_view::npos) << message;
+        EXPECT_NE(message.find("main.solver.tolerence: unknown key; did you mean 'tolerance'?"), std::string_view::npos) << message;
+        ASSERT_TRUE(e.location());
+        EXPECT_EQ(e.location()->line, 4u);
+    }
+
+    std::ofstream(path) << "[main]\nname = \"run\"\nweights = [1.0]\n\n[main.solver]\ntolerance = 1e-6\nmax_iterations = 10\n";
+    EXPECT_NO_THROW(strict.load(path));
+    std::filesystem::remove(path);
+}
+
+struct TemplateSchema {
+    SparseSolver solver;
+    std::string name = "run";
+    std::vector<double> weights = {1.0, 2.0};
+    std::optional<int> max_steps;
+};
+
+TEST_F(configTest, deck_template_lists_every_field_with_its_default) {
+    using namespace fourdst::config;
+    const std::string_view text = Config<TemplateSchema>::deck_template();
+    EXPECT_EQ(text.data(), Config<TemplateSchema>::deck_template().data());
+    EXPECT_NE(text.find("# string\nname = \"run\"\n"), std::string_view::npos) << text;
+    EXPECT_NE(text.find("# array of float\nweights = "), std::string_view::npos) << text;
+    EXPECT_NE(text.find("# integer, optional\n# max_steps =\n"), std::string_view::npos) << text;
+    EXPECT_NE(text.find("[main.solver]\n# float\ntolerance = "), std::string_view::npos) << text;
+    EXPECT_NE(text.find("# integer\nmax_iterations = 100\n"), std::string_view::npos) << text;
+
+    const std::string path = "TemplateSchema.template.toml";
+    Config<TemplateSchema>::save_template(path);
+    Config<TemplateSchema> cfg;
+    cfg.set_unknown_key_policy(UnknownKeyPolicy::REJECT);
+    cfg.load(path);
+    EXPECT_TRUE(detail::equal(cfg.main(), TemplateSchema{}));
+    std::filesystem::remove(path);
+}
+
+struct LayoutV1 {
+    double time_step = 0.1;
+    int substeps = 1;
+};
+
+struct LayoutV2 {
+    double time_step = 0.1;
+    long substeps = 1;
+};
+
+struct LayoutReordered {
+    int substeps = 1;
+    double time_step = 0.1;
+};
+
+TEST_F(configTest, schema_fingerprint_is_a_compile_time_layout_hash) {
+    using namespace fourdst::config;
+    constexpr std::uint64_t fingerprint = io::schema_fingerprint_v<LayoutV1>;
+    static_assert(fingerprint == io::schema_fingerprint<LayoutV1>());
+    static_assert(fingerprint != io::schema_fingerprint_v<LayoutV2>);
+    static_assert(fingerprint != io::schema_fingerprint_v<LayoutReordered>);
+    EXPECT_EQ(io::content_fingerprint<LayoutV1>(), fingerprint);
+}
+
+TEST_F(configTest, try_api_returns_errors_as_values) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    const auto missing = cfg.try_load("does_not_exist.toml");
+    ASSERT_FALSE(missing);
+    EXPECT_EQ(missing.error().kind, exceptions::ConfigErrorKind::LOAD);
+    EXPECT_THROW(missing.error().rethrow(), exceptions::ConfigLoadError);
+
+    const auto invalid = cfg.try_load(get_bad_example_file(BAD_FILES::INVALID_TYPE));
+    ASSERT_FALSE(invalid);
+    EXPECT_EQ(invalid.error().kind, exceptions::ConfigErrorKind::PARSE);
+    EXPECT_TRUE(invalid.error().location);
+    EXPECT_THROW(invalid.error().rethrow(), exceptions::ConfigParseError);
+
+    EXPECT_TRUE(cfg.try_load(get_good_example_file()));
+    EXPECT_TRUE(cfg.try_save("TestConfigSchema.try.toml"));
+    const auto unwritable = cfg.try_save("no_such_directory/TestConfigSchema.toml");
+    ASSERT_FALSE(unwritable);
+    EXPECT_EQ(unwritable.error().kind, exceptions::ConfigErrorKind::SAVE);
+    std::filesystem::remove("TestConfigSchema.try.toml");
+}
+
+TEST_F(configTest, try_load_from_parses_a_borrowed_buffer) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> writer;
+    writer.set("simulation.time_step", 0.25);
+    std::string blob;
+    writer.save_to(blob);
+
+    // A buffer that is not null-terminated, as a WASM module receives from a JS Uint8Array.
+    const std::vector<char> bytes(blob.begin(), blob.end());
+    Config<TestConfigSchema> reader;
+    EXPECT_TRUE(reader.try_load_from(std::string_view(bytes.data(), bytes.size())));
+    EXPECT_EQ(reader->simulation.time_step, 0.25);
+
+    const auto invalid = reader.try_load_from("[main]\nsimulation = 3\n");
+    ASSERT_FALSE(invalid);
+    EXPECT_EQ(invalid.error().kind, exceptions::ConfigErrorKind::PARSE);
+    EXPECT_EQ(reader->simulation.time_step, 0.25);
+}
+
+struct SeqlockSchema {
+    double time_step = 10.0;
+    double end_time = 10.0;
+    int steps = 10;
+    bool adaptive = true;
+};
+
+TEST_F(configTest, copy_reads_small_trivial_schemas_through_a_seqlock) {
+    using namespace fourdst::config;
+    static_assert(detail::is_seqlock_eligible_v<SeqlockSchema>);
+    static_assert(!detail::is_seqlock_eligible_v<TestConfigSchema>);
+    static_assert(noexcept(std::declval<const Config<SeqlockSchema>&>().copy()));
+
+    Config<SeqlockSchema> cfg;
+    cfg.set_history_limit(1);
+    EXPECT_EQ(cfg.copy().steps, 10);
+    const auto reader = cfg.reader();
+
+    std::atomic<bool> done{false};
+    std::atomic<int> torn{0};
+    std::thread copier([&] {
+        while (!done.load()) {
+            const SeqlockSchema seen = reader.copy();
+            if (seen.time_step != seen.end_time || seen.steps != static_cast<int>(seen.time_step)) ++torn;
+        }
+    });
+    for (int step = 1; step <= 1000; ++step) {
+        cfg.mutate([step](SeqlockSchema& c) {
+            c.time_step = step;
+            c.end_time = step;
+            c.steps = step;
+        });
+    }
+    done = true;
+    copier.join();
+    EXPECT_EQ(torn.load(), 0);
+    EXPECT_EQ(cfg.copy().steps, 1000);
+    EXPECT_TRUE(cfg.undo());
+    EXPECT_EQ(reader.copy().steps, 999);
+
+    Config<TestConfigSchema> other;
+    EXPECT_TRUE(detail::equal(other.copy(), other.main()));
+}
+
+struct TunableSchema {
+    int max_iterations = 100;
+    fourdst::config::Tunable<double> relaxation = 0.8;
+    fourdst::config::Tunable<Solver> solver = Solver::EXPLICIT;
+};
+
+TEST_F(configTest, set_stores_tunable_fields_in_place) {
+    using namespace fourdst::config;
+    Config<TunableSchema> cfg;
+    cfg.set_history_limit(4);
+    const auto before = cfg.snapshot();
+    const auto [fingerprint, generation] = std::pair(cfg.fingerprint(), cfg.generation());
+
+    cfg.set("relaxation", 0.5);
+    cfg.set("solver", Solver::IMPLICIT);
+    EXPECT_EQ(cfg.snapshot(), before);
+    EXPECT_EQ(cfg.generation(), generation);
+    EXPECT_EQ(cfg.tunable_stores(), 2u);
+    EXPECT_NE(cfg.fingerprint(), fingerprint);
+    EXPECT_EQ(before->relaxation.get(), 0.5);
+    EXPECT_EQ(before->solver.get(), Solver::IMPLICIT);
+    EXPECT_FALSE(cfg.undo());
+    EXPECT_THROW(cfg.set("relaxation", 1), exceptions::ConfigPathError);
+
+    // Assigning the field replaces the shared value, so the old snapshot keeps its own.
+    cfg.mutate([](TunableSchema& c) { c.relaxation = 0.25; });
+    EXPECT_EQ(cfg->relaxation.get(), 0.25);
+    EXPECT_EQ(before->relaxation.get(), 0.5);
+
+    std::string text;
+    cfg.save_to(text);
+    EXPECT_NE(text.find("relaxation = 0.25"), std::string::npos);
+    Config<TunableSchema> loaded;
+    loaded.load_from(text);
+    EXPECT_EQ(loaded->relaxation.get(), 0.25);
+    EXPECT_EQ(loaded->solver.get(), Solver::IMPLICIT);
+}
+
+struct StepCountKey;
+struct OutputLabelKey;
+
+TEST_F(configTest, every_published_snapshot_advances_the_generation) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    const auto [initial, start] = cfg.versioned_snapshot();
+    EXPECT_EQ(initial, cfg.snapshot());
+    EXPECT_EQ(start, cfg.generation());
+
+    cfg.set_missing_field_policy(MissingFieldPolicy::USE_DEFAULTS);
+    cfg.load_from("[main]\nauthor = \"loaded\"\n");
+    EXPECT_EQ(cfg.generation(), start + 1);
+    cfg.mutate([](TestConfigSchema& c) { c.author = "mutated"; });
+    EXPECT_EQ(cfg.generation(), start + 2);
+    cfg.apply_patch("simulation.time_step = 0.25");
+    EXPECT_EQ(cfg.generation(), start + 3);
+    cfg.reset();
+    EXPECT_EQ(cfg.generation(), start + 4);
+    cfg.reset();
+    EXPECT_EQ(cfg.generation(), start + 4);
+
+    const auto [content, generation] = cfg.versioned_snapshot();
+    EXPECT_EQ(generation, start + 4);
+    EXPECT_EQ(content, cfg.snapshot());
+    EXPECT_EQ(content->author, "loaded");
+}
+
+TEST_F(configTest, retained_snapshots_are_read_back_by_generation) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    EXPECT_EQ(cfg.get_retention(), 0u);
+    EXPECT_EQ(cfg.at_generation(cfg.generation()), nullptr);
+
+    cfg.set_retention(3);
+    const std::uint64_t start = cfg.generation();
+    EXPECT_EQ(cfg.at_generation(start), cfg.snapshot());
+
+    std::vector<std::shared_ptr<const TestConfigSchema>> published;
+    for (int step = 1; step <= 4; ++step) {
+        cfg.mutate([step](TestConfigSchema& c) { c.author = std::format("step {}", step); });
+        published.push_back(cfg.snapshot());
+    }
+    EXPECT_EQ(cfg.generation(), start + 4);
+    EXPECT_EQ(cfg.at_generation(start), nullptr);
+    EXPECT_EQ(cfg.at_generation(start + 1), nullptr);
+    for (int step = 2; step <= 4; ++step) {
+        const auto content = cfg.at_generation(start + step);
+        ASSERT_NE(content, nullptr);
+        EXPECT_EQ(content, published[step - 1]);
+        EXPECT_EQ(content->author, std::format("step {}", step));
+    }
+    EXPECT_EQ(cfg.at_generation(start + 5), nullptr);
+
+    cfg.set_retention(1);
+    EXPECT_EQ(cfg.at_generation(start + 3), nullptr);
+    EXPECT_EQ(cfg.at_generation(start + 4), cfg.snapshot());
+    cfg.set_retention(0);
+    EXPECT_EQ(cfg.at_generation(start + 4), nullptr);
+}
+
+TEST_F(configTest, device_mirror_packs_scalar_fields_and_tracks_generations) {
+    using namespace fourdst::config;
+    using Mirror = device_mirror_t<TestConfigSchema>;
+    static_assert(std::is_trivially_copyable_v<Mirror>);
+    static_assert(Mirror::size() == 5);
+    static_assert(Mirror::index("author") == Mirror::npos);
+    static_assert(Mirror::index("physics.convection") == Mirror::npos);
+    static_assert(Mirror::index("simulation") == Mirror::npos);
+    // Two doubles, four ints and a bool, with no padding between them.
+    static_assert(sizeof(Mirror) == 32);
+
+    Config<TestConfigSchema> cfg;
+    cfg.mutate([](TestConfigSchema& c) {
+        c.physics.diffusion = true;
+        c.physics.flags = {1, 2, 3};
+        c.simulation.time_step = 0.5;
+        c.simulation.output_frequency = 4;
+    });
+    auto mirror = cfg.to_device_mirror();
+    EXPECT_EQ(mirror.generation, cfg.generation());
+    EXPECT_EQ(mirror.mirror.get<Mirror::index("simulation.time_step")>(), 0.5);
+    EXPECT_EQ(mirror.mirror.get<Mirror::index("simulation.total_time")>(), 10.0);
+    EXPECT_EQ(mirror.mirror.get<Mirror::index("simulation.output_frequency")>(), 4);
+    EXPECT_TRUE(mirror.mirror.get<Mirror::index("physics.diffusion")>());
+    EXPECT_EQ(mirror.mirror.get<Mirror::index("physics.flags")>()[2], 3);
+
+    EXPECT_FALSE(cfg.refresh_device_mirror(mirror));
+    cfg.mutate([](TestConfigSchema& c) { c.simulation.time_step = 0.125; });
+    EXPECT_TRUE(cfg.refresh_device_mirror(mirror));
+    EXPECT_EQ(mirror.generation, cfg.generation());
+    EXPECT_EQ(mirror.mirror.get<Mirror::index("simulation.time_step")>(), 0.125);
+}
+
+struct HotSchema {
+    std::string title = "run";
+    std::vector<double> opacity = std::vector<double>(256, 1.0);
+    SimulationConfigOptions simulation;
+    std::map<std::string, std::string> metadata;
+    bool diffusion = false;
+};
+
+template <>
+struct fourdst::config::hot_fields<HotSchema> {
+    static constexpr std::array paths = {std::string_view("diffusion"), std::string_view("simulation.time_step"),
+                                         std::string_view("simulation.output_frequency")};
+};
+
+TEST_F(configTest, hot_fields_are_packed_into_one_cache_line_per_snapshot) {
+    using namespace fourdst::config;
+    using Hot = HotBlock<HotSchema>;
+    static_assert(alignof(Hot) == 64 && sizeof(Hot) == 64);
+    static_assert(Hot::size() == 3);
+    static_assert(Hot::index("title") == Hot::npos);
+    static_assert(std::is_same_v<Hot::field_type<Hot::index("simulation.output_frequency")>, int>);
+
+    Config<HotSchema> cfg;
+    EXPECT_EQ(cfg.hot().get<Hot::index("simulation.time_step")>(), 1.0);
+    EXPECT_FALSE(cfg.hot().get<Hot::index("diffusion")>());
+
+    cfg.mutate([](HotSchema& c) {
+        c.diffusion = true;
+        c.simulation.time_step = 0.25;
+        c.simulation.output_frequency = 8;
+    });
+    const Hot hot = cfg.hot();
+    EXPECT_TRUE(hot.get<Hot::index("diffusion")>());
+    EXPECT_EQ(hot.get<Hot::index("simulation.time_step")>(), 0.25);
+    EXPECT_EQ(hot.get<Hot::index("simulation.output_frequency")>(), 8);
+
+    cfg.reset();
+    EXPECT_EQ(cfg.hot().get<Hot::index("simulation.time_step")>(), 1.0);
+}
+
+TEST_F(configTest, reload_recycling_reuses_content_and_snapshot_storage) {
+    using namespace fourdst::config;
+    const std::string path = "HotSchema.recycled.toml";
+    const auto write_deck = [&](const std::string& title, const double value) {
+        std::ofstream out(path);
+        out << "[main]\ntitle = \"" << title << "\"\nopacity = [";
+        for (int i = 0; i < 256; ++i) out << (i == 0 ? "" : ", ") << value;
+        out << "]\n";
+    };
+
+    Config<HotSchema> cfg;
+    cfg.set_file_read_policy(FileReadPolicy::STREAMING);
+    cfg.set_missing_field_policy(MissingFieldPolicy::USE_DEFAULTS);
+    cfg.set_reload_recycling(true);
+    EXPECT_TRUE(cfg.get_reload_recycling());
+    write_deck("a", 1.0);
+    cfg.load(path);
+    const HotSchema* first_snapshot = cfg.snapshot().get();
+    const double* first_snapshot_data = cfg.snapshot()->opacity.data();
+    const double* first_content_data = cfg->opacity.data();
+
+    // The first reload retires the loaded content and snapshot; the second reads into and publishes over them.
+    write_deck("bb", 2.0);
+    ASSERT_TRUE(cfg.reload());
+    write_deck("ccc", 3.0);
+    ASSERT_TRUE(cfg.reload());
+    EXPECT_EQ(cfg->opacity.data(), first_content_data);
+    EXPECT_EQ(cfg.snapshot().get(), first_snapshot);
+    EXPECT_EQ(cfg.snapshot()->opacity.data(), first_snapshot_data);
+    EXPECT_EQ(cfg->title, "ccc");
+    EXPECT_EQ(cfg.snapshot()->opacity, std::vector<double>(256, 3.0));
+    EXPECT_EQ(cfg->simulation.time_step, 1.0);
+
+    // A snapshot a reader still holds is never written to.
+    const auto held = cfg.snapshot();
+    write_deck("dddd", 4.0);
+    ASSERT_TRUE(cfg.reload());
+    write_deck("eeeee", 5.0);
+    ASSERT_TRUE(cfg.reload());
+    EXPECT_NE(cfg.snapshot().get(), held.get());
+    EXPECT_EQ(held->title, "ccc");
+    EXPECT_EQ(held->opacity.front(), 3.0);
+    std::filesystem::remove(path);
+}
+
+TEST_F(configTest, read_guards_exclude_writers_but_not_each_other) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    std::atomic<bool> stop{false};
+    std::thread writer([&] {
+        for (int i = 1; !stop.load(); ++i) {
+            cfg.mutate([i](TestConfigSchema& c) {
+                c.simulation.output_frequency = i;
+                c.simulation.total_time = i;
+            });
+        }
+    });
+    std::vector<std::thread> readers;
+    std::atomic<int> torn{0};
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&] {
+            for (int i = 0; i < 2000; ++i) {
+                const auto guard = cfg.read();
+                if (guard->simulation.total_time != guard->simulation.output_frequency) ++torn;
+            }
+        });
+    }
+    for (auto& reader : readers) reader.join();
+    stop = true;
+    writer.join();
+    EXPECT_EQ(torn.load(), 0);
+
+    const std::uint64_t generation = cfg.generation();
+    std::thread blocked;
+    {
+        const auto guard = cfg.read();
+        const auto second = cfg.read();
+        blocked = std::thread([&cfg] { cfg.set("author", "after the guards"); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        EXPECT_EQ(cfg.generation(), generation);
+        EXPECT_EQ(second->author, "");
+    }
+    blocked.join();
+    EXPECT_EQ(cfg.read()->author, "after the guards");
+}
+
+TEST_F(configTest, pinned_snapshots_stay_consistent_across_publishes) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    const auto pinned = cfg.pin();
+    EXPECT_EQ(pinned.snapshot(), cfg.snapshot());
+    EXPECT_EQ(pinned.generation(), cfg.generation());
+
+    cfg.set("simulation.time_step", 0.5);
+    cfg.set("simulation.total_time", 20.0);
+    EXPECT_EQ(pinned->simulation.time_step, 1.0);
+    EXPECT_EQ(pinned->simulation.total_time, 10.0);
+    EXPECT_LT(pinned.generation(), cfg.generation());
+
+    auto reader = cfg.reader();
+    const auto repinned = reader.pin();
+    EXPECT_EQ((*repinned).simulation.time_step, 0.5);
+    EXPECT_EQ(repinned.get().simulation.total_time, 20.0);
+    EXPECT_EQ(repinned.generation(), cfg.generation());
+}
+
+namespace {
+    template <typename C>
+    concept Mutable = requires(C& config) {
+        config.mutate([](TestConfigSchema&) {});
+        config.set("simulation.time_step", 1.0);
+    };
+}
+
+TEST_F(configTest, frozen_configs_read_without_synchronization_and_cannot_be_mutated) {
+    using namespace fourdst::config;
+    static_assert(Mutable<Config<TestConfigSchema>>);
+    static_assert(!Mutable<FrozenConfig<TestConfigSchema>>);
+    static_assert(std::is_copy_constructible_v<FrozenConfig<TestConfigSchema>>);
+    static_assert(sizeof(FrozenConfig<TestConfigSchema>) == sizeof(TestConfigSchema) + sizeof(std::string) + sizeof(std::uint64_t));
+
+    Config<TestConfigSchema> cfg;
+    cfg.set_root_name("star");
+    cfg.mutate([](TestConfigSchema& c) { c.simulation.time_step = 0.5; });
+    const FrozenConfig<TestConfigSchema> frozen = cfg.freeze();
+    EXPECT_EQ(frozen->simulation.time_step, 0.5);
+    EXPECT_EQ(frozen.get<"simulation.time_step">(), 0.5);
+    EXPECT_EQ(frozen.get<double>("simulation.time_step"), 0.5);
+    EXPECT_THROW((void)frozen.get<int>("simulation.time_step"), exceptions::ConfigPathError);
+    EXPECT_EQ(frozen.get_root_name(), "star");
+    EXPECT_EQ(frozen.generation(), cfg.generation());
+
+    // Later changes to the config do not reach the frozen copy.
+    cfg.mutate([](TestConfigSchema& c) { c.simulation.time_step = 0.75; });
+    EXPECT_EQ(frozen->simulation.time_step, 0.5);
+
+    Config<TestConfigSchema> thawed = frozen.thaw();
+    EXPECT_EQ(thawed->simulation.time_step, 0.5);
+    EXPECT_EQ(thawed.get_root_name(), "star");
+    thawed.mutate([](TestConfigSchema& c) { c.simulation.time_step = 2.0; });
+    thawed.reset();
+    EXPECT_EQ(thawed->simulation.time_step, 0.5);
+
+    const FrozenConfig<TestConfigSchema> moved = std::move(cfg).freeze();
+    EXPECT_EQ(moved->simulation.time_step, 0.75);
+    EXPECT_EQ(moved.get_root_name(), "star");
+}
+
+TEST_F(configTest, schemas_compare_and_hash_by_content) {
+    using namespace fourdst::config;
+    RichConfigSchema a;
+    RichConfigSchema b;
+    EXPECT_TRUE(fourdst::config::equal(a, b));
+    EXPECT_EQ(fourdst::config::hash(a), fourdst::config::hash(b));
+
+    b.grid[0][0] = 1.5;
+    EXPECT_FALSE(fourdst::config::equal(a, b));
+    EXPECT_NE(fourdst::config::hash(a), fourdst::config::hash(b));
+    b.grid[0][0] = 1.0;
+    b.abundances["metals z"] = -0.0;
+    a.abundances["metals z"] = 0.0;
+    EXPECT_TRUE(fourdst::config::equal(a, b));
+    EXPECT_EQ(fourdst::config::hash(a), fourdst::config::hash(b));
+
+    using Snapshot = std::shared_ptr<const RichConfigSchema>;
+    std::unordered_map<Snapshot, int, ContentHash<RichConfigSchema>, ContentEqual<RichConfigSchema>> runs;
+    runs.emplace(std::make_shared<const RichConfigSchema>(a), 1);
+    EXPECT_FALSE(runs.emplace(std::make_shared<const RichConfigSchema>(b), 2).second);
+    ASSERT_NE(runs.find(b), runs.end());
+    EXPECT_EQ(runs.find(b)->second, 1);
+    b.solver = Solver::EXPLICIT;
+    EXPECT_EQ(runs.find(b), runs.end());
+    EXPECT_TRUE(ContentEqual<RichConfigSchema>{}(Snapshot{}, Snapshot{}));
+    EXPECT_FALSE(ContentEqual<RichConfigSchema>{}(Snapshot{}, a));
+}
+
+struct NetworkAbundances {
+    std::unordered_map<std::string, double> mass_fractions;
+    std::vector<std::unordered_map<std::string, int>> shells;
+};
+
+struct AbundanceSchema {
+    std::string network = "pp";
+    NetworkAbundances initial;
+};
+
+TEST_F(configTest, equal_configs_save_byte_identical_files) {
+    using namespace fourdst::config;
+    const std::vector<std::string> species = {"h1", "he4", "c12", "n14", "o16", "ne20", "mg24", "si28", "fe56"};
+    Config<AbundanceSchema> forward;
+    forward.mutate([&](AbundanceSchema& c) {
+        for (std::size_t i = 0; i < species.size(); ++i) c.initial.mass_fractions[species[i]] = 0.1 * static_cast<double>(i);
+        c.initial.shells.push_back({{"inner", 1}, {"outer", 2}, {"core", 0}});
+    });
+    Config<AbundanceSchema> backward;
+    backward.mutate([&](AbundanceSchema& c) {
+        c.initial.mass_fractions.reserve(1024);
+        for (std::size_t i = species.size(); i-- > 0;) c.initial.mass_fractions[species[i]] = 0.1 * static_cast<double>(i);
+        c.initial.shells.emplace_back();
+        c.initial.shells.back().rehash(64);
+        c.initial.shells.back()["core"] = 0;
+        c.initial.shells.back()["outer"] = 2;
+        c.initial.shells.back()["inner"] = 1;
+    });
+
+    for (const FileFormat format : {FileFormat::TOML, FileFormat::JSON}) {
+        forward.set_file_format(format);
+        backward.set_file_format(format);
+        std::string lhs;
+        std::string rhs;
+        forward.save_to(lhs);
+        backward.save_to(rhs);
+        EXPECT_EQ(lhs, rhs);
+        EXPECT_LT(lhs.find("c12"), lhs.find("he4"));
+        EXPECT_LT(lhs.find("network"), lhs.find("mass_fractions"));
+    }
+    EXPECT_EQ(std::format("{:json}", forward), std::format("{:json}", backward));
+}
+
+struct PrecisionSchema {
+    float ratio = 0.1f;
+    double sum = 0.1 + 0.2;
+    std::vector<double> samples;
+    std::array<float, 3> weights = {1.0f / 3.0f, 2.5f, 1e-30f};
+};
+
+TEST_F(configTest, saved_floats_are_shortest_and_reload_bit_identically) {
+    using namespace fourdst::config;
+    Config<PrecisionSchema> writer;
+    writer.mutate([](PrecisionSchema& c) {
+        c.samples = {-0.0, 5e-324, std::numeric_limits<double>::max(), 1e21, 100.0};
+        for (int i = 0; i < 5000; ++i) c.samples.push_back(std::sin(static_cast<double>(i)) * 1e-3);
+    });
+    std::string text;
+    writer.save_to(text);
+    EXPECT_NE(text.find("ratio = 0.1\n"), std::string::npos) << text.substr(0, 200);
+    EXPECT_NE(text.find("sum = 0.30000000000000004\n"), std::string::npos);
+    EXPECT_NE(text.find("samples = [-0.0, 5e-324, 1.7976931348623157e+308, 1e+21, 100.0, "), std::string::npos);
+
+    Config<PrecisionSchema> reader;
+    reader.load_from(text);
+    EXPECT_EQ(std::bit_cast<std::uint32_t>(reader->ratio), std::bit_cast<std::uint32_t>(writer->ratio));
+    ASSERT_EQ(reader->samples.size(), writer->samples.size());
+    for (std::size_t i = 0; i < writer->samples.size(); ++i) {
+        ASSERT_EQ(std::bit_cast<std::uint64_t>(reader->samples[i]), std::bit_cast<std::uint64_t>(writer->samples[i])) << i;
+    }
+    for (std::size_t i = 0; i < writer->weights.size(); ++i) {
+        EXPECT_EQ(std::bit_cast<std::uint32_t>(reader->weights[i]), std::bit_cast<std::uint32_t>(writer->weights[i]));
+    }
+}
+
+TEST_F(configTest, derived_values_are_recomputed_after_a_publish) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    int step_computations = 0;
+    int label_computations = 0;
+    const auto steps = [&](const TestConfigSchema& c) {
+        ++step_computations;
+        return static_cast<int>(c.simulation.total_time / c.simulation.time_step);
+    };
+    const auto label = [&](const TestConfigSchema& c) {
+        ++label_computations;
+        return c.output.directory + "/" + c.output.format;
+    };
+
+    const auto first = cfg.derived<StepCountKey>(steps);
+    EXPECT_EQ(*first, 10);
+    EXPECT_EQ(cfg.derived<StepCountKey>(steps), first);
+    EXPECT_EQ(*cfg.derived<OutputLabelKey>({"output"}, label), "./output/hdf5");
+    EXPECT_EQ(step_computations, 1);
+    EXPECT_EQ(label_computations, 1);
+
+    cfg.set("simulation.time_step", 0.5);
+    EXPECT_EQ(*cfg.derived<StepCountKey>(steps), 20);
+    EXPECT_EQ(*first, 10);
+    EXPECT_EQ(*cfg.derived<OutputLabelKey>({"output"}, label), "./output/hdf5");
+    EXPECT_EQ(step_computations, 2);
+    EXPECT_EQ(label_computations, 1);
+
+    cfg.set("output.format", "csv");
+    EXPECT_EQ(*cfg.derived<OutputLabelKey>({"output"}, label), "./output/csv");
+    EXPECT_EQ(label_computations, 2);
+
+    cfg.reset();
+    EXPECT_EQ(*cfg.derived<StepCountKey>(steps), 10);
+    EXPECT_EQ(step_computations, 3);
+    EXPECT_THROW(cfg.derived<OutputLabelKey>({"output.missing"}, label), exceptions::ConfigPathError);
+}
+
+TEST_F(configTest, sweep_variants_share_the_base_until_materialized) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> base;
+    base.set("author", "base");
+
+    Sweep<TestConfigSchema> grid(base);
+    grid.axis("simulation.time_step", {0.1, 0.2, 0.5}).axis("output.format", {"csv", "hdf5"});
+    ASSERT_EQ(grid.size(), 6u);
+    const auto variant = grid[4];
+    EXPECT_EQ(&variant.base(), base.snapshot().get());
+    EXPECT_EQ(variant.overrides(), (std::vector<std::string>{"simulation.time_step=0.5", "output.format=csv"}));
+    const TestConfigSchema content = variant.materialize();
+    EXPECT_EQ(content.simulation.time_step, 0.5);
+    EXPECT_EQ(content.output.format, "csv");
+    EXPECT_EQ(content.author, "base");
+
+    std::size_t count = 0;
+    for (const auto& member : grid) {
+        EXPECT_EQ(member.index(), count++);
+    }
+    EXPECT_EQ(count, 6u);
+
+    Sweep<TestConfigSchema> zipped(base, SweepMode::ZIPPED);
+    zipped.axis("simulation.time_step", {0.1, 0.2}).axis("simulation.output_frequency", {10, 20});
+    EXPECT_EQ(zipped.size(), 2u);
+    EXPECT_EQ(zipped[1].materialize().simulation.output_frequency, 20);
+    EXPECT_THROW(zipped.axis("simulation.total_time", {1.0}), exceptions::ConfigError);
+    EXPECT_THROW(zipped.axis("simulation.total_time", {1, 2}), exceptions::ConfigPathError);
+
+    variant.save("TestConfigSchema.sweep.toml");
+    Config<TestConfigSchema> loaded;
+    loaded.load("TestConfigSchema.sweep.toml");
+    EXPECT_EQ(loaded->simulation.time_step, 0.5);
+}
+
+TEST_F(configTest, expressions_in_numeric_fields_are_resolved_on_load) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    cfg.set_missing_field_policy(MissingFieldPolicy::USE_DEFAULTS);
+    cfg.set_expressions(true);
+    cfg.load_from(R"(
+[main]
+description = "${not.an.expression}"
+
+[main.simulation]
+output_frequency = "${simulation.total_time} / ${simulation.time_step} / 10"
+total_time = "100 * ${simulation.time_step}"
+time_step = 0.25
+)");
+    EXPECT_EQ(cfg->simulation.total_time, 25.0);
+    EXPECT_EQ(cfg->simulation.output_frequency, 10);
+    EXPECT_EQ(cfg->description, "${not.an.expression}");
+
+    try {
+        cfg.load_from(R"(
+[main.simulation]
+time_step = "2 * ${simulation.total_time}"
+total_time = "${simulation.time_step} + 1"
+output_frequency = "${simulation.missing} * (3"
+)");
+        FAIL() << "expected a ConfigParseError";
+    } catch (const exceptions::ConfigParseError& e) {
+        const std::string message = e.what();
+        EXPECT_NE(message.find("main.simulation.time_step: invalid expression"), std::string::npos);
+        EXPECT_NE(message.find("circular reference"), std::string::npos);
+        EXPECT_NE(message.find("unknown reference '${simulation.missing}'"), std::string::npos);
+        EXPECT_EQ(message.find("expected float"), std::string::npos);
+    }
+    EXPECT_EQ(cfg->simulation.total_time, 25.0);
+
+    Config<TestConfigSchema> plain;
+    plain.set_missing_field_policy(MissingFieldPolicy::USE_DEFAULTS);
+    EXPECT_THROW(plain.load_from("[main.simulation]\ntotal_time = \"100 * 2\"\n"), exceptions::ConfigParseError);
+
+    // Deep nesting and long chains of references are reported instead of overflowing the stack.
+    const auto bad_expression = [&](const std::string& deck) {
+        try {
+            cfg.load_from(deck);
+        } catch (const exceptions::ConfigParseError& e) {
+            return std::string(e.what());
+        }
+        return std::string();
+    };
+    EXPECT_NE(bad_expression(std::format("[main.simulation]\ntotal_time = \"{}1{}\"\n", std::string(100'000, '('), std::string(100'000, ')')))
+                  .find("nested too deeply"),
+              std::string::npos);
+    EXPECT_NE(bad_expression(std::format("[main.simulation]\ntotal_time = \"{}1\"\n", std::string(100'000, '-'))).find("nested too deeply"),
+              std::string::npos);
+    EXPECT_EQ(cfg->simulation.total_time, 25.0);
+
+    Config<RichConfigSchema> chained;
+    chained.set_missing_field_policy(MissingFieldPolicy::USE_DEFAULTS);
+    chained.set_expressions(true);
+    std::string grid = "[main]\ngrid = [[";
+    for (int i = 0; i < 1000; ++i) grid += std::format("\"${{grid[0][{}]}} + 1\", ", i + 1);
+    grid += "0.0]]\n";
+    try {
+        chained.load_from(grid);
+        FAIL() << "expected a ConfigParseError";
+    } catch (const exceptions::ConfigParseError& e) {
+        EXPECT_NE(std::string(e.what()).find("chained too deeply"), std::string::npos);
+    }
+}
+
+TEST_F(configTest, serialized_configs_round_trip_through_bytes) {
+    using namespace fourdst::config;
+    static_assert(io::is_binary_encodable_v<TestConfigSchema>);
+    Config<TestConfigSchema> sender;
+    sender.set_root_name("worker");
+    sender.mutate([](TestConfigSchema& c) {
+        c.author = "controller";
+        c.simulation.time_step = 0.125;
+        c.physics.convection = true;
+    });
+    std::string message;
+    sender.serialize_to(message);
+    std::string text;
+    sender.save_to(text);
+    EXPECT_LT(message.size(), text.size());
+
+    Config<TestConfigSchema> receiver;
+    EXPECT_TRUE(receiver.deserialize_from(message));
+    EXPECT_EQ(receiver.get_root_name(), "worker");
+    EXPECT_EQ(receiver->author, "controller");
+    EXPECT_EQ(receiver->simulation.time_step, 0.125);
+    EXPECT_TRUE(detail::equal(*receiver.snapshot(), *sender.snapshot()));
+    EXPECT_FALSE(receiver.deserialize_from(std::as_bytes(std::span(message.data(), message.size()))));
+
+    EXPECT_THROW(receiver.deserialize_from(std::string_view(message).substr(0, message.size() - 1)),
+                 exceptions::ConfigLoadError);
+    EXPECT_THROW(receiver.deserialize_from(text), exceptions::ConfigLoadError);
+    Config<RichConfigSchema> other;
+    EXPECT_THROW(other.deserialize_from(message), exceptions::ConfigLoadError);
+    EXPECT_EQ(receiver->simulation.time_step, 0.125);
+}
+
+TEST_F(configTest, audit_log_records_mutations_and_changed_paths) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    auto log = std::make_shared<AuditLog>(2);
+    EXPECT_EQ(log->capacity(), 2u);
+    cfg.mutate([](TestConfigSchema& c) { c.author = "unaudited"; });
+    cfg.set_audit_log(log);
+
+    cfg.mutate([](TestConfigSchema& c) {
+        c.author = "auditor";
+        c.simulation.time_step = 0.25;
+    });
+    cfg.set("simulation.output_frequency", 7);
+    cfg.mutate([](TestConfigSchema& c) { c.physics.diffusion = !c.physics.diffusion; });
+    EXPECT_EQ(log->dropped(), 1u);
+
+    const std::vector<MutationRecord> records = log->dump();
+    ASSERT_EQ(records.size(), 2u);
+    EXPECT_EQ(records[0].generation + 1, records[1].generation);
+    EXPECT_EQ(records[1].generation, cfg.generation() - 1);
+    EXPECT_EQ(records[0].thread, std::this_thread::get_id());
+    EXPECT_EQ(records[0].paths, (std::vector<std::string_view>{"author", "simulation.time_step"}));
+    EXPECT_EQ(records[1].paths, (std::vector<std::string_view>{"simulation.output_frequency"}));
+    EXPECT_FALSE(log->pop());
+
+    std::thread worker([&cfg] { cfg.mutate([](TestConfigSchema& c) { c.author = "worker"; }); });
+    worker.join();
+    std::size_t drained = 0;
+    log->drain([&](const MutationRecord& record) {
+        EXPECT_NE(record.thread, std::this_thread::get_id());
+        EXPECT_EQ(record.generation, cfg.generation());
+        ++drained;
+    });
+    EXPECT_EQ(drained, 1u);
+
+    cfg.set_audit_log(nullptr);
+    cfg.mutate([](TestConfigSchema& c) { c.author = "unaudited again"; });
+    EXPECT_FALSE(log->pop());
+}
+
+TEST_F(configTest, unchanged_saves_are_skipped) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    cfg.set_skip_unchanged_saves(true);
+    cfg.mutate([](TestConfigSchema& c) { c.author = "checkpointer"; });
+    const std::string path = "skip_unchanged_test.toml";
+    const std::string alias = "skip_unchanged_test.alias.toml";
+    std::filesystem::remove(alias);
+
+    // An atomic save replaces the file, which breaks its hard link to the alias.
+    cfg.save(path, SavePolicy::ATOMIC);
+    std::filesystem::create_hard_link(path, alias);
+    cfg.save(path, SavePolicy::ATOMIC);
+    EXPECT_EQ(std::filesystem::hard_link_count(path), 2u);
+
+    cfg.set_root_name("renamed");
+    cfg.save(path, SavePolicy::ATOMIC);
+    EXPECT_EQ(std::filesystem::hard_link_count(path), 1u);
+
+    std::filesystem::remove(alias);
+    std::filesystem::create_hard_link(path, alias);
+    cfg.mutate([](TestConfigSchema& c) { c.author = "checkpointer 2"; });
+    cfg.save(path, SavePolicy::ATOMIC);
+    EXPECT_EQ(std::filesystem::hard_link_count(path), 1u);
+
+    std::filesystem::resize_file(path, 0);
+    cfg.save(path, SavePolicy::ATOMIC);
+    Config<TestConfigSchema> reloaded;
+    reloaded.set_root_name("renamed");
+    reloaded.load(path);
+    EXPECT_EQ(reloaded->author, "checkpointer 2");
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(alias);
+}
+
+TEST_F(configTest, checkpoint_restores_state_history_and_baseline) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> running;
+    running.set_root_name("run");
+    running.set_missing_field_policy(MissingFieldPolicy::USE_DEFAULTS);
+    running.set_history_limit(4);
+    for (int i = 1; i <= 3; ++i) {
+        running.mutate([i](TestConfigSchema& c) { c.simulation.output_frequency = i; });
+    }
+    const std::string path = "checkpoint_test.ckpt";
+    running.save_checkpoint(path, SavePolicy::DURABLE);
+
+    Config<TestConfigSchema> restarted;
+    restarted.restore_checkpoint(path);
+    EXPECT_EQ(restarted.get_root_name(), "run");
+    EXPECT_EQ(restarted.get_missing_field_policy(), MissingFieldPolicy::USE_DEFAULTS);
+    EXPECT_EQ(restarted.get_state(), ConfigState::MODIFIED);
+    EXPECT_EQ(restarted->simulation.output_frequency, 3);
+    EXPECT_EQ(restarted.history_size(), 3u);
+    EXPECT_TRUE(restarted.undo());
+    EXPECT_EQ(restarted->simulation.output_frequency, 2);
+    restarted.reset();
+    EXPECT_EQ(restarted.get_state(), ConfigState::DEFAULT);
+    EXPECT_TRUE(detail::equal(*restarted.snapshot(), TestConfigSchema{}));
+
+    std::string bytes;
+    running.checkpoint(bytes);
+    EXPECT_THROW(restarted.restore(std::string_view(bytes).substr(0, bytes.size() - 1)), exceptions::ConfigLoadError);
+    Config<RichConfigSchema> other;
+    EXPECT_THROW(other.restore(bytes), exceptions::ConfigLoadError);
+    EXPECT_EQ(restarted.get_state(), ConfigState::DEFAULT);
+    std::filesystem::remove(path);
+}
+
+struct StarSchema {
+    fourdst::config::Quantity<fourdst::config::units::Mass> mass = 1.0;
+    fourdst::config::Quantity<fourdst::config::units::Time> age;
+};
+
+TEST_F(configTest, quantities_are_converted_to_the_canonical_unit_on_load) {
+    using namespace fourdst::config;
+    Config<StarSchema> cfg;
+    cfg.load_from(R"(
+[main]
+mass = "1.5 Msun"
+age = 3
+)");
+    EXPECT_DOUBLE_EQ(cfg->mass, 1.5 * 1.98847e33);
+    EXPECT_EQ(cfg->age.value(), 3.0);
+
+    cfg.load_from("[main]\nmass = 2e33\nage = \"4.6 Gyr\"\n");
+    EXPECT_EQ(cfg->mass.value(), 2e33);
+    EXPECT_DOUBLE_EQ(cfg->age, 4.6 * 3.15576e16);
+
+    try {
+        cfg.load_from("[main]\nmass = \"1 Mmoon\"\nage = 0\n");
+        FAIL() << "expected a ConfigParseError";
+    } catch (const exceptions::ConfigParseError& e) {
+        EXPECT_NE(std::string(e.what()).find("unknown unit 'Mmoon'"), std::string::npos);
+    }
+    EXPECT_DOUBLE_EQ(cfg->age, 4.6 * 3.15576e16);
+
+    cfg.save("StarSchema.quantity.toml");
+    Config<StarSchema> loaded;
+    loaded.load("StarSchema.quantity.toml");
+    EXPECT_EQ(loaded->mass.value(), cfg->mass.value());
+    EXPECT_EQ(loaded->age.value(), cfg->age.value());
+}
+
+TEST_F(configTest, update_frames_carry_changed_fields_and_drop_stale_generations) {
+    using namespace fourdst::config;
+    const TestConfigSchema before{};
+    TestConfigSchema after = before;
+    after.simulation.time_step = 0.5;
+    after.output.format = "csv";
+
+    std::string delta;
+    EXPECT_EQ(io::encode_update(delta, 2, &before, after), 2u);
+    std::string stale;
+    TestConfigSchema older = before;
+    older.simulation.time_step = 0.75;
+    io::encode_update(stale, 1, &before, older);
+    std::string full;
+    EXPECT_EQ(io::encode_update(full, 0, static_cast<const TestConfigSchema*>(nullptr), after), 5u);
+    std::string empty;
+    EXPECT_EQ(io::encode_update(empty, 3, &after, after), 0u);
+
+    Config<TestConfigSchema> cfg;
+    UpdateReceiver<TestConfigSchema> receiver(cfg);
+    EXPECT_TRUE(receiver.apply(delta));
+    EXPECT_EQ(cfg->simulation.time_step, 0.5);
+    EXPECT_EQ(cfg->output.format, "csv");
+    EXPECT_EQ(receiver.generation(), 2u);
+    EXPECT_FALSE(receiver.apply(stale));
+    EXPECT_EQ(cfg->simulation.time_step, 0.5);
+    const auto snapshot = cfg.snapshot();
+    EXPECT_FALSE(receiver.apply(empty));
+    EXPECT_EQ(cfg.snapshot(), snapshot);
+
+    cfg.mutate([](TestConfigSchema& c) { c.author = "local"; });
+    EXPECT_TRUE(receiver.apply(full));
+    EXPECT_EQ(cfg->author, "");
+    EXPECT_EQ(cfg->output.format, "csv");
+
+    EXPECT_THROW(receiver.apply(std::string_view(full).substr(0, full.size() - 1)), exceptions::ConfigLoadError);
+    EXPECT_EQ(cfg->output.format, "csv");
+    Config<RichConfigSchema> other;
+    UpdateReceiver<RichConfigSchema> mismatched(other);
+    EXPECT_THROW(mismatched.apply(delta), exceptions::ConfigLoadError);
+}
+
+#if defined(__unix__)
+TEST_F(configTest, shared_config_is_mapped_by_other_processes) {
+    using namespace fourdst::config;
+    static_assert(shm::is_shareable_v<PmrSchema>);
+    static_assert(!shm::is_shareable_v<TestConfigSchema>);
+    const std::string name = std::format("/fourdst_config_test.{}", ::getpid());
+
+    // Forked before the segment exists, so the child does not inherit the creator's mapping.
+    const pid_t child = ::fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        int status = 1;
+        try {
+            const auto shared = SharedConfig<PmrSchema>::open(name, std::chrono::seconds(10));
+            const bool matches = !shared.owner() && shared->label == "a label that is long enough to allocate" &&
+                                 shared->species.size() == 3 && shared->grid.samples == std::pmr::vector<double>{1.0, 2.0};
+            status = matches ? 0 : 1;
+        } catch (...) {
+            status = 2;
+        }
+        ::_exit(status);
+    }
+
+    Config<PmrSchema> cfg;
+    cfg.mutate([](PmrSchema& c) {
+        c.label = "a label that is long enough to allocate";
+        c.species.emplace_back("a species name that is long enough to allocate");
+    });
+    const auto shared = SharedConfig<PmrSchema>::create(name, cfg);
+    EXPECT_TRUE(shared.owner());
+    EXPECT_EQ(shared->species.back(), "a species name that is long enough to allocate");
+
+    int status = 0;
+    ASSERT_EQ(::waitpid(child, &status, 0), child);
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+
+    // The creator's own mapping occupies the address the segment must be mapped at.
+    EXPECT_THROW(SharedConfig<PmrSchema>::open(name, std::chrono::milliseconds(10)), exceptions::ConfigLoadError);
+    EXPECT_THROW(SharedConfig<PmrSchema>::open("/fourdst_config_test.missing", std::chrono::milliseconds(10)),
+                 exceptions::ConfigLoadError);
+}
+
+TEST_F(configTest, shared_config_readers_follow_published_generations) {
+    using namespace fourdst::config;
+    const std::string name = std::format("/fourdst_config_gen_test.{}", ::getpid());
+
+    const pid_t child = ::fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        int status = 1;
+        try {
+            auto shared = SharedConfig<PmrSchema>::open(name, std::chrono::seconds(10));
+            const auto first = shared.snapshot();
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            while (shared.generation() < 2 && std::chrono::steady_clock::now() < deadline) {
+                if (shared.stale()) shared.refresh();
+            }
+            const bool matches = shared.generation() == 2 && shared->label == "second update" && first->label == "default";
+            status = matches ? 0 : 1;
+        } catch (...) {
+            status = 2;
+        }
+        ::_exit(status);
+    }
+
+    Config<PmrSchema> cfg;
+    auto shared = SharedConfig<PmrSchema>::create(name, cfg);
+    EXPECT_EQ(shared.generation(), 0u);
+    EXPECT_FALSE(shared.stale());
+    cfg.mutate([](PmrSchema& c) { c.label = "first update"; });
+    EXPECT_EQ(shared.publish(cfg), 1u);
+    cfg.mutate([](PmrSchema& c) { c.label = "second update"; });
+    EXPECT_EQ(shared.publish(cfg), 2u);
+    EXPECT_EQ(shared.latest_generation(), 2u);
+    EXPECT_EQ(shared->label, "second update");
+
+    int status = 0;
+    ASSERT_EQ(::waitpid(child, &status, 0), child);
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+}
+
+TEST_F(configTest, update_subscribers_follow_a_publisher_over_tcp) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> controller;
+    controller.mutate([](TestConfigSchema& c) { c.author = "controller"; });
+    UpdatePublisher<TestConfigSchema> publisher(controller);
+
+    Config<TestConfigSchema> worker;
+    UpdateSubscriber<TestConfigSchema> subscriber(worker, "localhost", publisher.port());
+    ASSERT_TRUE(subscriber.wait_for(0, std::chrono::seconds(5)));
+    EXPECT_EQ(worker->author, "controller");
+
+    controller.set("simulation.time_step", 0.125);
+    EXPECT_EQ(publisher.generation(), 1u);
+    ASSERT_TRUE(subscriber.wait_for(1, std::chrono::seconds(5)));
+    EXPECT_EQ(worker->simulation.time_step, 0.125);
+    EXPECT_EQ(subscriber.last_error(), "");
+    EXPECT_EQ(publisher.subscriber_count(), 1u);
+}
+
+TEST_F(configTest, update_publishers_guard_their_subscribers_and_writers) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> controller;
+    controller.mutate([](TestConfigSchema& c) { c.author = "controller"; });
+
+    // Anything but loopback needs a token, which subscribers must present.
+    EXPECT_THROW(UpdatePublisher<TestConfigSchema>(controller, {.bind_address = "::"}), exceptions::ConfigError);
+    UpdatePublisher<TestConfigSchema> publisher(controller, {.bind_address = "::", .token = "s3cret", .timeout = std::chrono::milliseconds(500)});
+    Config<TestConfigSchema> intruder;
+    UpdateSubscriber<TestConfigSchema> refused(intruder, "localhost", publisher.port(), "guess");
+    EXPECT_FALSE(refused.wait_for(0, std::chrono::seconds(2)));
+    EXPECT_TRUE(refused.closed());
+    EXPECT_EQ(intruder->author, "");
+
+    Config<TestConfigSchema> worker;
+    UpdateSubscriber<TestConfigSchema> subscriber(worker, "localhost", publisher.port(), "s3cret");
+    ASSERT_TRUE(subscriber.wait_for(0, std::chrono::seconds(5)));
+
+    // A subscriber that stops reading is dropped by the sender thread; writers never wait for it.
+    const int stalled = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(publisher.port());
+    ASSERT_EQ(::connect(stalled, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+    ASSERT_TRUE(io::detail::send_frame(stalled, "s3cret"));
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 40; ++i) {
+        controller.mutate([i](TestConfigSchema& c) { c.description = std::string(1 << 20, static_cast<char>('a' + i % 26)); });
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+    ASSERT_TRUE(subscriber.wait_for(40, std::chrono::seconds(20)));
+    EXPECT_EQ(worker->description, std::string(1 << 20, 'a' + 39 % 26));
+    EXPECT_EQ(publisher.subscriber_count(), 1u);
+    ::close(stalled);
+
+    // A frame longer than the limit ends the connection instead of the process.
+    const int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    address.sin_port = 0;
+    socklen_t length = sizeof(address);
+    ASSERT_EQ(::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+    ASSERT_EQ(::listen(listener, 1), 0);
+    ASSERT_EQ(::getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length), 0);
+    std::thread hostile([listener] {
+        const int client = ::accept(listener, nullptr, nullptr);
+        std::string token;
+        io::detail::receive_frame(client, token, io::detail::max_update_token);
+        const std::uint64_t huge = ~std::uint64_t{0};
+        io::detail::send_all(client, reinterpret_cast<const char*>(&huge), sizeof(huge));
+        ::close(client);
+    });
+    Config<TestConfigSchema> victim;
+    UpdateSubscriber<TestConfigSchema> attacked(victim, "127.0.0.1", ntohs(address.sin_port));
+    hostile.join();
+    EXPECT_FALSE(attacked.wait_for(0, std::chrono::seconds(2)));
+    EXPECT_TRUE(attacked.closed());
+    EXPECT_NE(attacked.last_error().find("exceeds the limit"), std::string::npos);
+    ::close(listener);
+}
+#endif
@@ -0,0 +1,28 @@
+#include <gtest/gtest.h>
+#include <string>
+
+#include "fourdst/config/config.h"
+
+#include "embedded_deck.h"
+
+/**
+ * @file embedTest.cpp
+ * @brief Tests for configs embedded at build time as generated initializers.
+ */
+
+class embedTest : public ::testing::Test {};
+
+TEST_F(embedTest, embedded_deck_matches_the_loaded_file) {
+    using namespace fourdst::config;
+    const std::string path = std::string(getenv("MESON_SOURCE_ROOT")) + "/tests/config/example_config_files/example.embed.toml";
+    Config<RichConfigSchema> loaded;
+    loaded.load(path);
+
+    const Config<RichConfigSchema> embedded(embedded_deck());
+    EXPECT_EQ(embedded.get_state(), ConfigState::DEFAULT);
+    EXPECT_TRUE(detail::equal(embedded.main(), loaded.main()));
+    EXPECT_EQ(embedded->solver, Solver::EXPLICIT);
+    EXPECT_EQ(embedded->grid.size(), 3);
+    EXPECT_EQ(embedded->title, "embedded \"deck\"\n\tsecond line ?");
+    EXPECT_FALSE(embedded->output->save_plots.has_value());
+}
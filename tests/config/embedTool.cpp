@@ -0,0 +1,12 @@
+#include "fourdst/config/embed.h"
+
+#include "test_schema.h"
+
+/**
+ * @file embedTool.cpp
+ * @brief Build-time generator for the embedded deck used by embedTest.
+ */
+
+int main(int argc, char** argv) {
+    return fourdst::config::embed_main<RichConfigSchema>(argc, argv);
+}
@@ -0,0 +1,67 @@
+! Reads a config view through the fdc module only, for fortranTest.
+module fortran_consumer
+    use, intrinsic :: iso_c_binding
+    use fdc
+    implicit none
+    private
+    public :: fdc_smoke_check
+
+contains
+
+    !> Reads the view fortranTest.cpp made, loads the deck it saved, and reads again.
+    !> Returns 0 if every value matches, else the number of the first failed check.
+    function fdc_smoke_check(cfg) bind(C, name="fdc_smoke_check") result(failed)
+        type(c_ptr), value :: cfg
+        integer(c_int) :: failed
+        integer(c_int32_t) :: h_dt
+        real(c_double) :: dt
+        integer(c_int64_t) :: frequency
+        integer(c_int32_t), pointer :: flags(:)
+        character(len=8) :: format
+
+        failed = 0
+        h_dt = fdc_handle(cfg, "simulation.time_step")
+        if (h_dt < 0) then
+            failed = 1
+            return
+        end if
+        if (fdc_get_double_h(cfg, h_dt, dt) /= FDC_OK .or. dt /= 1.0_c_double) then
+            failed = 2
+            return
+        end if
+        if (fdc_get_int_h(cfg, fdc_handle(cfg, "simulation.output_frequency"), frequency) /= FDC_OK &
+            .or. frequency /= 1_c_int64_t) then
+            failed = 3
+            return
+        end if
+        if (fdc_int32_array(cfg, fdc_handle(cfg, "physics.flags"), flags) /= FDC_OK) then
+            failed = 4
+            return
+        end if
+        if (size(flags) /= 3 .or. sum(flags) /= 6) then
+            failed = 5
+            return
+        end if
+        if (fdc_get_string_h(cfg, fdc_handle(cfg, "output.format"), format) /= FDC_OK .or. format /= "hdf5") then
+            failed = 6
+            return
+        end if
+        if (fdc_get_double_h(cfg, fdc_handle(cfg, "simulation.missing"), dt) /= FDC_UNKNOWN_PATH) then
+            failed = 7
+            return
+        end if
+
+        if (fdc_load(cfg, "no/such/file.toml") /= FDC_ERROR) then
+            failed = 8
+            return
+        end if
+        if (fdc_load(cfg, "TestConfigSchema.fortran.toml") /= FDC_OK) then
+            failed = 9
+            return
+        end if
+        if (fdc_get_double_h(cfg, h_dt, dt) /= FDC_OK .or. dt /= 0.5_c_double) then
+            failed = 10
+            return
+        end if
+    end function
+end module fortran_consumer
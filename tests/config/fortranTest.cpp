@@ -0,0 +1,33 @@
+#include <gtest/gtest.h>
+
+#include "fourdst/config/c_api.h"
+#include "fourdst/config/config.h"
+#include "test_schema.h"
+
+/**
+ * @file fortranTest.cpp
+ * @brief Smoke test of the Fortran module fdc.f90, read from a Fortran translation unit (fortranConsumer.f90).
+ */
+
+FOURDST_CONFIG_C_API();
+
+extern "C" int fdc_smoke_check(fdc_config* cfg);
+
+class fortranTest : public ::testing::Test {};
+
+TEST_F(fortranTest, fortran_callers_read_and_load_through_fdc) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> writer;
+    writer.mutate([](TestConfigSchema& c) {
+        c.physics.flags = {1, 2, 3};
+        c.simulation.time_step = 0.5;
+    });
+    writer.save("TestConfigSchema.fortran.toml");
+
+    Config<TestConfigSchema> cfg;
+    cfg.mutate([](TestConfigSchema& c) { c.physics.flags = {1, 2, 3}; });
+    fdc_config* view = c_api::wrap(cfg);
+    EXPECT_EQ(fdc_smoke_check(view), 0);
+    EXPECT_EQ(cfg->simulation.time_step, 0.5);
+    fdc_free(view);
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include <hdf5.h>
+#include <string>
+#include <vector>
+
+#include "fourdst/config/config.h"
+#include "test_schema.h"
+
+/**
+ * @file hdf5Test.cpp
+ * @brief Tests for native HDF5 export and import.
+ */
+
+struct GridOptions {
+    std::vector<double> samples;
+    std::array<float, 3> origin = {0.0f, 0.5f, 1.0f};
+};
+
+struct Hdf5Schema {
+    RichConfigSchema run;
+    GridOptions grid;
+};
+
+class hdf5Test : public ::testing::Test {};
+
+TEST_F(hdf5Test, group_round_trips_and_keeps_arrays_binary) {
+    using namespace fourdst::config;
+    Config<Hdf5Schema> writer;
+    writer.mutate([](Hdf5Schema& c) {
+        for (int i = 0; i < 100000; ++i) c.grid.samples.push_back(i * 0.25);
+        c.run.output->save_plots = std::nullopt;
+        c.run.unset = 3;
+    });
+
+    hid_t file = H5Fcreate("Hdf5Schema.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+    ASSERT_GE(file, 0);
+    EXPECT_NO_THROW(writer.save_hdf5(file));
+    EXPECT_NO_THROW(writer.save_hdf5(file)); // replaces the group
+    H5Fclose(file);
+
+    file = H5Fopen("Hdf5Schema.h5", H5F_ACC_RDONLY, H5P_DEFAULT);
+    ASSERT_GE(file, 0);
+    EXPECT_GT(H5Aexists_by_name(file, "main/run", "whole", H5P_DEFAULT), 0);
+    EXPECT_GT(H5Aexists_by_name(file, "main/run/output", "directory", H5P_DEFAULT), 0);
+    EXPECT_EQ(H5Aexists_by_name(file, "main/run/output", "save_plots", H5P_DEFAULT), 0);
+    hid_t samples = H5Dopen2(file, "main/grid/samples", H5P_DEFAULT);
+    ASSERT_GE(samples, 0);
+    hid_t plist = H5Dget_create_plist(samples);
+    EXPECT_EQ(H5Pget_layout(plist), H5D_CHUNKED);
+    H5Pclose(plist);
+    H5Dclose(samples);
+
+    Config<Hdf5Schema> reader;
+    EXPECT_NO_THROW(reader.load_hdf5(file));
+    EXPECT_TRUE(detail::equal(reader.main(), writer.main()));
+    EXPECT_EQ(reader.get_state(), ConfigState::LOADED_FROM_FILE);
+    EXPECT_EQ(reader.get_source_path(), "Hdf5Schema.h5:main");
+
+    Config<Hdf5Schema> missing;
+    EXPECT_THROW(missing.load_hdf5(file, "other"), exceptions::ConfigLoadError);
+    Config<TestConfigSchema> mismatched;
+    EXPECT_THROW(mismatched.load_hdf5(file), exceptions::ConfigParseError);
+    H5Fclose(file);
+}
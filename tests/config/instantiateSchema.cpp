@@ -0,0 +1,10 @@
+#include "fourdst/config/config.h"
+
+#include "test_schema.h"
+
+/**
+ * @file instantiateSchema.cpp
+ * @brief The one translation unit that instantiates the I/O of Config<RichConfigSchema> for instantiateTest.
+ */
+
+FOURDST_CONFIG_INSTANTIATE(RichConfigSchema);
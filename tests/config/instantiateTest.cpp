@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <format>
+#include <sstream>
+#include <string>
+
+#include "fourdst/config/config.h"
+#include "test_schema.h"
+
+/**
+ * @file instantiateTest.cpp
+ * @brief Tests for configs whose I/O is instantiated in another translation unit (instantiateSchema.cpp).
+ */
+
+FOURDST_CONFIG_DECLARE(RichConfigSchema);
+
+class instantiateTest : public ::testing::Test {};
+
+TEST_F(instantiateTest, declared_members_link_against_the_instantiating_unit) {
+    using namespace fourdst::config;
+    const std::string path = (std::filesystem::temp_directory_path() / "instantiate_test.toml").string();
+    Config<RichConfigSchema> saved;
+    saved.mutate([](RichConfigSchema& c) { c.whole = 42.0; });
+    saved.save(path);
+
+    Config<RichConfigSchema> loaded;
+    loaded.load(path);
+    EXPECT_TRUE(detail::equal(loaded.main(), saved.main()));
+    EXPECT_FALSE(loaded.reload());
+
+    std::string text;
+    saved.save_to(text);
+    std::ostringstream stream;
+    saved.save_to(stream);
+    EXPECT_EQ(stream.str(), text);
+    EXPECT_EQ(std::format("{}", saved), text);
+
+    Config<RichConfigSchema> from_memory;
+    EXPECT_TRUE(from_memory.load_from(text));
+    EXPECT_EQ(from_memory->whole, 42.0);
+    EXPECT_NE(Config<RichConfigSchema>::schema().find("abundances"), std::string::npos);
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+#include <mpi.h>
+#include <string>
+
+#include "fourdst/config/config.h"
+#include "test_schema.h"
+
+/**
+ * @file mpiTest.cpp
+ * @brief Tests for collective loading with MPI. Run with several ranks.
+ */
+
+std::string get_example_file(const std::string& name) {
+    const char* source_root = getenv("MESON_SOURCE_ROOT");
+    if (source_root == nullptr) {
+        throw std::runtime_error("MESON_SOURCE_ROOT environment variable is not set.");
+    }
+    return std::string(source_root) + "/tests/config/example_config_files/" + name;
+}
+
+class mpiTest : public ::testing::Test {};
+
+TEST_F(mpiTest, load_collective_matches_load) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> local;
+    EXPECT_NO_THROW(local.load(get_example_file("example.good.toml")));
+
+    Config<TestConfigSchema> collective;
+    EXPECT_NO_THROW(collective.load_collective(MPI_COMM_WORLD, get_example_file("example.good.toml")));
+    EXPECT_TRUE(detail::equal(collective.main(), local.main()));
+    EXPECT_EQ(collective.get_state(), ConfigState::LOADED_FROM_FILE);
+    EXPECT_EQ(collective.get_root_name(), "main");
+}
+
+TEST_F(mpiTest, load_collective_errors_on_every_rank) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> missing;
+    EXPECT_THROW(missing.load_collective(MPI_COMM_WORLD, get_example_file("does.not.exist.toml")), exceptions::ConfigLoadError);
+    EXPECT_EQ(missing.get_state(), ConfigState::DEFAULT);
+
+    Config<TestConfigSchema> invalid;
+    EXPECT_THROW(invalid.load_collective(MPI_COMM_WORLD, get_example_file("example.invalidtype.toml")), exceptions::ConfigParseError);
+}
+
+int main(int argc, char** argv) {
+    MPI_Init(&argc, &argv);
+    ::testing::InitGoogleTest(&argc, argv);
+    int rank = 0;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (rank != 0) {
+        // Only rank 0 reports; failures on other ranks still fail the exit code.
+        delete ::testing::UnitTest::GetInstance()->listeners().Release(
+            ::testing::UnitTest::GetInstance()->listeners().default_result_printer());
+    }
+    const int result = RUN_ALL_TESTS();
+    int worst = result;
+    MPI_Allreduce(&result, &worst, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    MPI_Finalize();
+    return worst;
+}
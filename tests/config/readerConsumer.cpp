@@ -0,0 +1,16 @@
+#include "fourdst/config/reader.h"
+
+#include "test_schema.h"
+
+/**
+ * @file readerConsumer.cpp
+ * @brief A translation unit that reads config values through reader.h only, for readerTest.
+ */
+
+#if defined(RFL_RFL_HPP_) || defined(TOML_LIB_MAJOR) || defined(YYJSON_H)
+#error "reader.h must not pull in reflect-cpp, toml++ or yyjson"
+#endif
+
+double read_time_step(fourdst::config::ConfigReader<TestConfigSchema> reader) {
+    return reader->simulation.time_step;
+}
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "fourdst/config/config.h"
+#include "test_schema.h"
+
+/**
+ * @file readerTest.cpp
+ * @brief Tests for ConfigReader, read from a translation unit without parser headers (readerConsumer.cpp).
+ */
+
+double read_time_step(fourdst::config::ConfigReader<TestConfigSchema> reader);
+
+class readerTest : public ::testing::Test {};
+
+TEST_F(readerTest, reader_follows_published_snapshots) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    const ConfigReader<TestConfigSchema> reader = cfg.reader();
+    EXPECT_EQ(read_time_step(reader), 1.0);
+
+    const std::shared_ptr<const TestConfigSchema> held = reader.snapshot();
+    cfg.mutate([](TestConfigSchema& c) { c.simulation.time_step = 0.25; });
+    EXPECT_EQ(read_time_step(reader), 0.25);
+    EXPECT_EQ(held->simulation.time_step, 1.0);
+
+    cfg.reset();
+    EXPECT_EQ(reader.snapshot(), cfg.snapshot());
+}
+
+TEST_F(readerTest, cached_reads_refresh_only_after_a_publish) {
+    using namespace fourdst::config;
+    Config<TestConfigSchema> cfg;
+    ConfigReader<TestConfigSchema> reader = cfg.reader();
+
+    const TestConfigSchema* first = &reader.current();
+    EXPECT_EQ(&reader.current(), first);
+
+    cfg.mutate([](TestConfigSchema& c) { c.simulation.output_frequency = 7; });
+    EXPECT_EQ(reader->simulation.output_frequency, 7);
+    EXPECT_NE(&reader.current(), first);
+    EXPECT_EQ(&reader.current(), cfg.snapshot().get());
+
+    cfg.reset();
+    EXPECT_EQ(reader->simulation.output_frequency, 1);
+
+    std::vector<std::thread> threads;
+    std::atomic<int> matches = 0;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([local = reader, &matches]() mutable {
+            if (local->simulation.output_frequency == 1) ++matches;
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(matches, 4);
+}
+
+TEST_F(readerTest, numa_replicas_follow_published_snapshots) {
+    using namespace fourdst::config;
+    EXPECT_EQ(numa::detail::parse_cpu_list("0-3,8,10-11"), (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    ASSERT_GE(numa::node_count(), 1u);
+    EXPECT_LT(numa::current_node(), numa::node_count());
+
+    Config<TestConfigSchema> cfg;
+    ConfigReader<TestConfigSchema> reader = cfg.reader();
+    cfg.set_numa_replication(true);
+    EXPECT_TRUE(cfg.get_numa_replication());
+    EXPECT_EQ(reader->simulation.time_step, 1.0);
+
+    cfg.mutate([](TestConfigSchema& c) { c.simulation.time_step = 0.5; });
+    EXPECT_EQ(reader->simulation.time_step, 0.5);
+    EXPECT_EQ(reader.snapshot()->simulation.time_step, 0.5);
+    if (numa::node_count() == 1) {
+        EXPECT_EQ(reader.snapshot(), cfg.snapshot());
+    }
+
+    cfg.reset();
+    EXPECT_EQ(reader->simulation.time_step, 1.0);
+
+    cfg.set_numa_replication(false);
+    EXPECT_EQ(reader.snapshot(), cfg.snapshot());
+}
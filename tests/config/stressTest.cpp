@@ -0,0 +1,227 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fourdst/config/config.h"
+#include "test_schema.h"
+
+/**
+ * @file stressTest.cpp
+ * @brief Concurrency stress tests for snapshots, readers, mutation, reload, watching and saving.
+ *
+ * Every writer keeps one invariant across several fields (`stamp()`), so a reader that ever sees
+ * the fields of two versions mixed fails `consistent()`. Readers also check that generations
+ * never go back and, at the end, that no snapshot outlives its last reader.
+ *
+ * The suite is meant to run under the sanitizers as well as in plain builds:
+ *
+ * @code{.sh}
+ * meson setup build-tsan -Db_sanitize=thread && meson test -C build-tsan stressTest
+ * meson setup build-asan -Db_sanitize=address,undefined && meson test -C build-asan stressTest
+ * @endcode
+ *
+ * `FOURDST_STRESS_SCALE` multiplies the number of operations (default 1).
+ */
+
+namespace {
+    using fourdst::config::Config;
+
+    int scale() {
+        const char* value = std::getenv("FOURDST_STRESS_SCALE");
+        const int parsed = value != nullptr ? std::atoi(value) : 1;
+        return parsed > 0 ? parsed : 1;
+    }
+
+    /// Writes version `k` into every field the invariant covers.
+    void stamp(TestConfigSchema& content, const int k) {
+        content.simulation.time_step = k;
+        content.simulation.total_time = 2.0 * k;
+        content.simulation.output_frequency = k;
+        content.description = std::format("version {} of a description long enough to live on the heap", k);
+    }
+
+    bool consistent(const TestConfigSchema& content) {
+        const int k = content.simulation.output_frequency;
+        return content.simulation.time_step == k && content.simulation.total_time == 2.0 * k &&
+               content.description == std::format("version {} of a description long enough to live on the heap", k);
+    }
+
+    /// A deck holding version `k`.
+    std::string deck(const int k) {
+        Config<TestConfigSchema> writer;
+        writer.mutate([k](TestConfigSchema& content) { stamp(content, k); });
+        std::string text;
+        writer.save_to(text);
+        return text;
+    }
+
+    /// Replaces `path` with version `k` in one rename, as an editor or deploy tool would.
+    void publish_deck(const std::filesystem::path& path, const int k) {
+        const std::filesystem::path staging = path.string() + ".staging";
+        std::ofstream(staging) << deck(k);
+        std::filesystem::rename(staging, path);
+    }
+
+    struct Options {
+        bool recycling = false;
+        bool compaction = false;
+        bool watcher = false;
+    };
+
+    /**
+     * @brief Runs readers against mutators, reloads, patches, resets and saves of one config.
+     */
+    void hammer(const std::string& name, const Options options) {
+        const std::filesystem::path path = std::format("TestConfigSchema.{}.toml", name);
+        const std::filesystem::path saved = std::format("TestConfigSchema.{}.saved.toml", name);
+        publish_deck(path, 1);
+
+        Config<TestConfigSchema> cfg;
+        cfg.set_reload_recycling(options.recycling);
+        cfg.set_compaction(options.compaction);
+        cfg.load(path.string());
+        std::unique_ptr<fourdst::config::ConfigWatcher<TestConfigSchema>> watcher;
+        if (options.watcher) {
+            watcher = std::make_unique<fourdst::config::ConfigWatcher<TestConfigSchema>>(cfg, std::chrono::milliseconds(1));
+            watcher->start();
+        }
+
+        const int operations = 400 * scale();
+        std::atomic<int> writers_left{4};
+        std::atomic<int> failures{0};
+        std::atomic<int> next_version{2};
+        const auto fail = [&] { failures.fetch_add(1, std::memory_order_relaxed); };
+        const auto writer = [&](auto&& operation) {
+            return std::jthread([&, operation] {
+                for (int i = 0; i < operations; ++i) {
+                    try {
+                        operation(next_version.fetch_add(1, std::memory_order_relaxed));
+                    } catch (const fourdst::config::exceptions::ConfigError&) {
+                        // A reload may race with a rename and find the file missing; that is not a consistency failure.
+                    }
+                }
+                writers_left.fetch_sub(1, std::memory_order_release);
+            });
+        };
+
+        std::vector<std::weak_ptr<const TestConfigSchema>> witnessed;
+        std::mutex witnessed_mutex;
+        std::vector<std::jthread> readers;
+        const unsigned reader_count = std::max(2u, std::thread::hardware_concurrency() / 2);
+        for (unsigned r = 0; r < reader_count; ++r) {
+            readers.emplace_back([&, r] {
+                auto reader = cfg.reader();
+                std::uint64_t last_generation = 0;
+                std::uint64_t reads = 0;
+                while (writers_left.load(std::memory_order_acquire) > 0) {
+                    const auto [content, generation] = cfg.versioned_snapshot();
+                    if (!consistent(*content) || generation < last_generation) fail();
+                    last_generation = generation;
+                    if (!consistent(reader.current())) fail();
+                    const auto pin = reader.pin();
+                    if (!consistent(*pin) || pin.generation() < last_generation) fail();
+                    if (++reads % 1024 == r) {
+                        const std::lock_guard lock(witnessed_mutex);
+                        witnessed.push_back(content);
+                    }
+                }
+            });
+        }
+
+        {
+            std::vector<std::jthread> writers;
+            writers.push_back(writer([&](const int k) { cfg.mutate([k](TestConfigSchema& content) { stamp(content, k); }); }));
+            writers.push_back(writer([&](const int k) {
+                if (k % 8 == 0) {
+                    cfg.reset();
+                } else {
+                    cfg.apply_patch(std::format(
+                        "simulation.time_step = {0}.0\nsimulation.total_time = {1}.0\nsimulation.output_frequency = {0}\n"
+                        "description = \"version {0} of a description long enough to live on the heap\"",
+                        k, 2 * k));
+                }
+            }));
+            writers.push_back(writer([&](const int k) {
+                publish_deck(path, k);
+                if (!options.watcher) cfg.reload();
+            }));
+            writers.push_back(writer([&](const int) {
+                cfg.save(saved.string(), fourdst::config::SavePolicy::ATOMIC);
+                Config<TestConfigSchema> copy;
+                copy.load(saved.string());
+                if (!consistent(copy.main())) fail();
+            }));
+        }
+        readers.clear();
+        if (watcher) watcher->stop();
+
+        EXPECT_EQ(failures.load(), 0);
+        EXPECT_TRUE(consistent(cfg.main()));
+        EXPECT_TRUE(consistent(*cfg.snapshot()));
+
+        // Once its readers are gone, a snapshot is freed by the next publication at the latest;
+        // turning recycling off drops the one a recycling config keeps for reuse.
+        cfg.set_reload_recycling(false);
+        cfg.mutate([](TestConfigSchema& content) { stamp(content, 0); });
+        for (const auto& snapshot : witnessed) EXPECT_TRUE(snapshot.expired());
+
+        std::filesystem::remove(path);
+        std::filesystem::remove(saved);
+    }
+}
+
+class stressTest : public ::testing::Test {};
+
+TEST_F(stressTest, readers_never_see_mixed_versions_while_writers_mutate_reload_and_save) {
+    hammer("stress", {});
+}
+
+TEST_F(stressTest, recycled_snapshots_stay_consistent) {
+    hammer("stress-recycled", {.recycling = true});
+}
+
+TEST_F(stressTest, watcher_reloads_race_with_mutations_of_compacted_snapshots) {
+    hammer("stress-watched", {.compaction = true, .watcher = true});
+}
+
+TEST_F(stressTest, every_publication_advances_the_generation_and_notifies_with_a_consistent_snapshot) {
+    Config<TestConfigSchema> cfg;
+    const std::uint64_t initial = cfg.generation();
+    std::atomic<int> notifications{0};
+    std::atomic<int> failures{0};
+    const std::size_t id = cfg.subscribe("", [&](const std::shared_ptr<const TestConfigSchema>& content) {
+        if (!consistent(*content)) failures.fetch_add(1);
+        notifications.fetch_add(1);
+    });
+    const int per_writer = 200 * scale();
+    {
+        std::vector<std::jthread> writers;
+        for (int w = 0; w < 4; ++w) {
+            writers.emplace_back([&, w] {
+                std::uint64_t last = 0;
+                for (int i = 1; i <= per_writer; ++i) {
+                    cfg.mutate([k = w * 1000000 + i](TestConfigSchema& content) { stamp(content, k); });
+                    // Other writers may publish in between, but never take the generation back.
+                    const std::uint64_t generation = cfg.generation();
+                    if (generation <= last) failures.fetch_add(1);
+                    last = generation;
+                }
+            });
+        }
+    }
+    cfg.unsubscribe(id);
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_EQ(notifications.load(), 4 * per_writer);
+    EXPECT_EQ(cfg.generation(), initial + 4 * per_writer);
+}
@@ -1,6 +1,9 @@
 #pragma once
 #include <array>
+#include <map>
+#include <optional>
 #include <string>
+#include <vector>
 
 struct PhysicsConfigOptions {
     bool diffusion;
@@ -29,3 +32,28 @@ struct TestConfigSchema {
     SimulationConfigOptions simulation;
     OutputConfigOptions output;
 };
+
+enum class Solver {
+    EXPLICIT,
+    IMPLICIT
+};
+
+struct Species {
+    std::string name;
+    double mass = 1.0;
+    std::vector<int> charges;
+};
+
+struct RichConfigSchema {
+    std::string title = "quote \" backslash \\ tab \t";
+    Solver solver = Solver::IMPLICIT;
+    double whole = 100.0;
+    double tiny = 1e-30;
+    double huge = 1e300;
+    std::optional<int> unset;
+    std::vector<std::vector<double>> grid = {{1.0, 2.5}, {3.0}};
+    std::vector<Species> species = {{"H", 1.008, {0, 1}}, {"He", 4.0026, {0, 1, 2}}};
+    std::vector<Species> no_species;
+    std::map<std::string, double> abundances = {{"H", 0.7}, {"He-4", 0.28}, {"metals z", 0.02}};
+    std::optional<OutputConfigOptions> output = OutputConfigOptions{};
+};
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef FOURDST_CONFIG_USE_TRACING
+#define FOURDST_CONFIG_USE_TRACING 1
+#endif
+#include "fourdst/config/config.h"
+#include "test_schema.h"
+
+/**
+ * @file traceTest.cpp
+ * @brief Tests for the trace zones config operations report when built with FOURDST_CONFIG_USE_TRACING.
+ */
+
+namespace {
+    struct RecordingBackend final : fourdst::config::trace::Backend {
+        struct Event {
+            bool begin;
+            std::string name;
+            std::string root;
+            std::size_t bytes;
+        };
+        std::vector<Event> events;
+
+        void begin(const fourdst::config::trace::Zone& zone) override {
+            events.push_back({true, std::string(zone.name()), std::string(zone.root()), zone.bytes()});
+        }
+        void end(const fourdst::config::trace::Zone& zone) override {
+            events.push_back({false, std::string(zone.name()), std::string(zone.root()), zone.bytes()});
+        }
+
+        [[nodiscard]] const Event* closed(const std::string_view name) const {
+            for (const auto& event : events) {
+                if (!event.begin && event.name == name) return &event;
+            }
+            return nullptr;
+        }
+    };
+}
+
+class traceTest : public ::testing::Test {
+protected:
+    void SetUp() override { fourdst::config::trace::set_backend(&backend); }
+    void TearDown() override { fourdst::config::trace::set_backend(nullptr); }
+
+    RecordingBackend backend;
+};
+
+TEST_F(traceTest, operations_open_and_close_zones) {
+    using namespace fourdst::config;
+    const std::string path = (std::filesystem::temp_directory_path() / "trace_test.toml").string();
+    Config<TestConfigSchema> saved;
+    saved.set_root_name("physics");
+    saved.mutate([](TestConfigSchema& c) { c.simulation.time_step = 0.5; });
+    saved.reset();
+    saved.save(path);
+    (void)std::format("{}", saved);
+
+    Config<TestConfigSchema> loaded;
+    loaded.set_root_name("physics");
+    loaded.load(path);
+
+    for (const auto name : {"config.mutate", "config.reset", "config.save", "config.format", "config.load"}) {
+        const auto* event = backend.closed(name);
+        ASSERT_NE(event, nullptr) << name;
+        EXPECT_EQ(event->root, "physics") << name;
+    }
+    EXPECT_EQ(backend.closed("config.save")->bytes, std::filesystem::file_size(path));
+    EXPECT_EQ(backend.closed("config.load")->bytes, std::filesystem::file_size(path));
+
+    std::size_t open = 0;
+    for (const auto& event : backend.events) {
+        open += event.begin ? 1 : 0;
+        ASSERT_TRUE(event.begin || open-- > 0);
+    }
+    EXPECT_EQ(open, 0u);
+    std::filesystem::remove(path);
+}
+
+TEST_F(traceTest, schema_and_validation_zones_carry_sizes) {
+    using namespace fourdst::config;
+    const std::string path = (std::filesystem::temp_directory_path() / "trace_test.schema.json").string();
+    Config<TestConfigSchema>::save_schema(path);
+    ASSERT_NE(backend.closed("config.save_schema"), nullptr);
+    EXPECT_EQ(backend.closed("config.save_schema")->bytes, Config<TestConfigSchema>::schema().size());
+    std::filesystem::remove(path);
+
+    const std::string bad = (std::filesystem::temp_directory_path() / "trace_test.bad.toml").string();
+    {
+        std::ofstream out(bad);
+        out << "[main.simulation]\ntime_step = \"fast\"\n";
+    }
+    Config<TestConfigSchema> cfg;
+    EXPECT_THROW(cfg.load(bad), exceptions::ConfigParseError);
+    ASSERT_NE(backend.closed("config.validate"), nullptr);
+    EXPECT_EQ(backend.closed("config.validate")->root, "main");
+    std::filesystem::remove(bad);
+}